@@ -40,6 +40,27 @@
 #include "svn_mergeinfo.h"
 #include "private/svn_wc_private.h"
 
+/**
+ * Return the class @a name, which is looked up only once and then kept
+ * alive by a global reference in @a *cache.  Used for the classes
+ * created once per item of a status walk or a directory listing.
+ */
+static jclass
+findCachedClass(JNIEnv *env, jclass *cache, const char *name)
+{
+  if (*cache == NULL)
+    {
+      jclass clazz = env->FindClass(name);
+      if (JNIUtil::isJavaExceptionThrown())
+        return NULL;
+
+      *cache = static_cast<jclass>(env->NewGlobalRef(clazz));
+      env->DeleteLocalRef(clazz);
+    }
+
+  return *cache;
+}
+
 jobject
 CreateJ::ConflictDescriptor(const svn_wc_conflict_description2_t *desc)
 {
@@ -273,7 +294,9 @@ CreateJ::DirEntry(const char *path, const char *absPath,
   if (JNIUtil::isJavaExceptionThrown())
     return SVN_NO_ERROR;
 
-  jclass clazz = env->FindClass(JAVAHL_CLASS("/types/DirEntry"));
+  static jclass cachedClazz = NULL;
+  jclass clazz = findCachedClass(env, &cachedClazz,
+                                 JAVAHL_CLASS("/types/DirEntry"));
   if (JNIUtil::isJavaExceptionThrown())
     POP_AND_RETURN_NULL;
 
@@ -473,7 +496,9 @@ CreateJ::Lock(const svn_lock_t *lock)
   if (JNIUtil::isJavaExceptionThrown())
     return NULL;
 
-  jclass clazz = env->FindClass(JAVAHL_CLASS("/types/Lock"));
+  static jclass cachedClazz = NULL;
+  jclass clazz = findCachedClass(env, &cachedClazz,
+                                 JAVAHL_CLASS("/types/Lock"));
   if (JNIUtil::isJavaExceptionThrown())
     POP_AND_RETURN_NULL;
 
@@ -649,7 +674,9 @@ CreateJ::Status(svn_wc_context_t *wc_ctx,
   if (JNIUtil::isJavaExceptionThrown())
     return NULL;
 
-  jclass clazz = env->FindClass(JAVAHL_CLASS("/types/Status"));
+  static jclass cachedClazz = NULL;
+  jclass clazz = findCachedClass(env, &cachedClazz,
+                                 JAVAHL_CLASS("/types/Status"));
   if (JNIUtil::isJavaExceptionThrown())
     POP_AND_RETURN_NULL;
 
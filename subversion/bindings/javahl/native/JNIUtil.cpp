@@ -860,6 +860,48 @@ jstring JNIUtil::makeJString(const char *txt)
   return env->NewStringUTF(txt);
 }
 
+/**
+ * Take over a batch of Java objects.
+ * @param array         a global reference to the array holding the batch;
+ *                      it will be deleted and set to NULL
+ * @param count         the number of objects in the batch
+ * @param elementClass  the class of the array elements
+ * @return a local reference to an array with the first @a count elements
+ *         of @a array, which is @a array itself if it has no more elements
+ */
+jobjectArray JNIUtil::takeObjectArray(jobjectArray &array, jsize count,
+                                      const char *elementClass)
+{
+  JNIEnv *env = getEnv();
+  jobjectArray batch = static_cast<jobjectArray>(env->NewLocalRef(array));
+  env->DeleteGlobalRef(array);
+  array = NULL;
+
+  if (count == env->GetArrayLength(batch))
+    return batch;
+
+  jclass clazz = env->FindClass(elementClass);
+  if (isJavaExceptionThrown())
+    return NULL;
+
+  jobjectArray shrunk = env->NewObjectArray(count, clazz, NULL);
+  if (isJavaExceptionThrown())
+    return NULL;
+
+  for (jsize i = 0; i < count; ++i)
+    {
+      jobject item = env->GetObjectArrayElement(batch, i);
+      env->SetObjectArrayElement(shrunk, i, item);
+      env->DeleteLocalRef(item);
+      if (isJavaExceptionThrown())
+        return NULL;
+    }
+
+  env->DeleteLocalRef(batch);
+  env->DeleteLocalRef(clazz);
+  return shrunk;
+}
+
 /**
  * Initialite the log file.
  * @param level the log level
@@ -90,6 +90,8 @@ class JNIUtil
   static int getLogLevel();
   static void initLogFile(int level, jstring path);
   static jstring makeJString(const char *txt);
+  static jobjectArray takeObjectArray(jobjectArray &array, jsize count,
+                                      const char *elementClass);
   static JNIEnv *getEnv();
 
   /**
@@ -30,6 +30,12 @@
 #include "JNIUtil.h"
 #include "svn_time.h"
 
+/**
+ * The number of directory entries delivered per call of a
+ * ListBatchCallback.
+ */
+#define LIST_BATCH_SIZE 256
+
 /**
  * Create a ListCallback object
  * @param jcallback the Java callback object.
@@ -37,6 +43,21 @@
 ListCallback::ListCallback(jobject jcallback)
 {
   m_callback = jcallback;
+  m_batched = false;
+  m_dirents = NULL;
+  m_locks = NULL;
+  m_count = 0;
+
+  if (jcallback == NULL)
+    return;
+
+  JNIEnv *env = JNIUtil::getEnv();
+  jclass clazz = env->FindClass(JAVAHL_CLASS("/callback/ListBatchCallback"));
+  if (JNIUtil::isJavaExceptionThrown())
+    return;
+
+  m_batched = env->IsInstanceOf(jcallback, clazz) ? true : false;
+  env->DeleteLocalRef(clazz);
 }
 
 /**
@@ -46,6 +67,11 @@ ListCallback::~ListCallback()
 {
   // The m_callback does not need to be destroyed, because it is the passed
   // in parameter to the Java SVNClient.list method.
+  JNIEnv *env = JNIUtil::getEnv();
+  if (m_dirents)
+    env->DeleteGlobalRef(m_dirents);
+  if (m_locks)
+    env->DeleteGlobalRef(m_locks);
 }
 
 svn_error_t *
@@ -111,12 +137,99 @@ ListCallback::doList(const char *path,
         POP_AND_RETURN(SVN_NO_ERROR);
     }
 
+  if (m_batched)
+    {
+      if (m_dirents == NULL)
+        {
+          jclass clazz = env->FindClass(JAVAHL_CLASS("/types/DirEntry"));
+          if (JNIUtil::isJavaExceptionThrown())
+            POP_AND_RETURN(SVN_NO_ERROR);
+
+          jobjectArray jdirents = env->NewObjectArray(LIST_BATCH_SIZE,
+                                                      clazz, NULL);
+          if (JNIUtil::isJavaExceptionThrown())
+            POP_AND_RETURN(SVN_NO_ERROR);
+
+          clazz = env->FindClass(JAVAHL_CLASS("/types/Lock"));
+          if (JNIUtil::isJavaExceptionThrown())
+            POP_AND_RETURN(SVN_NO_ERROR);
+
+          jobjectArray jlocks = env->NewObjectArray(LIST_BATCH_SIZE,
+                                                    clazz, NULL);
+          if (JNIUtil::isJavaExceptionThrown())
+            POP_AND_RETURN(SVN_NO_ERROR);
+
+          m_dirents = static_cast<jobjectArray>(env->NewGlobalRef(jdirents));
+          m_locks = static_cast<jobjectArray>(env->NewGlobalRef(jlocks));
+        }
+
+      // The arrays keep the new objects alive after we pop the frame.
+      env->SetObjectArrayElement(m_dirents, m_count, jdirentry);
+      env->SetObjectArrayElement(m_locks, m_count, jlock);
+      if (JNIUtil::isJavaExceptionThrown())
+        POP_AND_RETURN(SVN_NO_ERROR);
+
+      env->PopLocalFrame(NULL);
+      if (++m_count < LIST_BATCH_SIZE)
+        return SVN_NO_ERROR;
+
+      return flush();
+    }
+
   // call the Java method
   env->CallVoidMethod(m_callback, mid, jdirentry, jlock);
 
   POP_AND_RETURN_EXCEPTION_AS_SVNERROR();
 }
 
+svn_error_t *
+ListCallback::flush()
+{
+  if (m_count == 0)
+    return SVN_NO_ERROR;
+
+  JNIEnv *env = JNIUtil::getEnv();
+
+  // Create a local frame for our references
+  env->PushLocalFrame(LOCAL_FRAME_SIZE);
+  if (JNIUtil::isJavaExceptionThrown())
+    return SVN_NO_ERROR;
+
+  static jmethodID mid = 0;
+  if (mid == 0)
+    {
+      jclass clazz =
+        env->FindClass(JAVAHL_CLASS("/callback/ListBatchCallback"));
+      if (JNIUtil::isJavaExceptionThrown())
+        POP_AND_RETURN(SVN_NO_ERROR);
+
+      mid = env->GetMethodID(clazz, "doEntryBatch",
+                             "([" JAVAHL_ARG("/types/DirEntry;")
+                             "[" JAVAHL_ARG("/types/Lock;") ")V");
+      if (JNIUtil::isJavaExceptionThrown() || mid == 0)
+        POP_AND_RETURN(SVN_NO_ERROR);
+    }
+
+  jsize count = m_count;
+  m_count = 0;
+
+  // The callee may hold on to the arrays, so a new batch gets new ones.
+  jobjectArray jdirents =
+    JNIUtil::takeObjectArray(m_dirents, count,
+                             JAVAHL_CLASS("/types/DirEntry"));
+  if (JNIUtil::isJavaExceptionThrown())
+    POP_AND_RETURN(SVN_NO_ERROR);
+
+  jobjectArray jlocks =
+    JNIUtil::takeObjectArray(m_locks, count, JAVAHL_CLASS("/types/Lock"));
+  if (JNIUtil::isJavaExceptionThrown())
+    POP_AND_RETURN(SVN_NO_ERROR);
+
+  env->CallVoidMethod(m_callback, mid, jdirents, jlocks);
+
+  POP_AND_RETURN_EXCEPTION_AS_SVNERROR();
+}
+
 /**
  * Create a DirEntry Java object from the svn_dirent_t structure.
  */
@@ -49,6 +49,11 @@ public:
                                const char *external_target,
                                apr_pool_t *scratch_pool);
 
+  /**
+   * Deliver the directory entries still buffered for a batch callback.
+   */
+  svn_error_t *flush();
+
 protected:
   svn_error_t *doList(const char *path,
                       const svn_dirent_t *dirent,
@@ -62,6 +67,23 @@ private:
    */
   jobject m_callback;
 
+  /**
+   * Whether m_callback is a ListBatchCallback.
+   */
+  bool m_batched;
+
+  /**
+   * Global references to the arrays of the batch being filled,
+   * or NULL if there is none.
+   */
+  jobjectArray m_dirents;
+  jobjectArray m_locks;
+
+  /**
+   * The number of entries in the current batch.
+   */
+  jsize m_count;
+
   jobject createJavaDirEntry(const char *path,
                              const char *absPath,
                              const svn_dirent_t *dirent);
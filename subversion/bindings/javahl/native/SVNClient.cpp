@@ -191,6 +191,8 @@ void SVNClient::list(const char *url, Revision &revision,
                                  ListCallback::callback,
                                  callback,
                                  ctx, subPool.getPool()), );
+
+    SVN_JNI_ERR(callback->flush(), );
 }
 
 void
@@ -223,6 +225,8 @@ SVNClient::status(const char *path, svn_depth_t depth,
                                    changelists.array(subPool),
                                    StatusCallback::callback, callback,
                                    subPool.getPool()), );
+
+    SVN_JNI_ERR(callback->flush(), );
 }
 
 /* Convert a vector of revision ranges to an APR array of same. */
@@ -313,13 +317,14 @@ jlong SVNClient::checkout(const char *moduleName, const char *destPath,
     if (ctx == NULL)
         return -1;
 
-    SVN_JNI_ERR(svn_client_checkout3(&rev, url.c_str(),
+    SVN_JNI_ERR(svn_client_checkout4(&rev, url.c_str(),
                                      path.c_str(),
                                      pegRevision.revision(),
                                      revision.revision(),
                                      depth,
                                      ignoreExternals,
                                      allowUnverObstructions,
+                                     FALSE /* lazy_files */,
                                      ctx,
                                      subPool.getPool()),
                 -1);
@@ -667,7 +667,7 @@ void SVNRepos::pack(File &path, ReposNotifyCallback *notifyCallback)
                               path.getInternalStyle(requestPool), NULL,
                               requestPool.getPool(), requestPool.getPool()), );
 
-  SVN_JNI_ERR(svn_repos_fs_pack2(repos,
+  SVN_JNI_ERR(svn_repos_fs_pack3(repos, 1,
                                  notifyCallback != NULL
                                     ? ReposNotifyCallback::notify
                                     : NULL,
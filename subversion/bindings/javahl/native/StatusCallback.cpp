@@ -30,6 +30,12 @@
 #include "JNIUtil.h"
 #include "svn_time.h"
 
+/**
+ * The number of status items delivered per call of a
+ * StatusBatchCallback.
+ */
+#define STATUS_BATCH_SIZE 256
+
 /**
  * Create a StatusCallback object
  * @param jcallback the Java callback object.
@@ -37,6 +43,22 @@
 StatusCallback::StatusCallback(jobject jcallback)
 {
   m_callback = jcallback;
+  wc_ctx = NULL;
+  m_batched = false;
+  m_paths = NULL;
+  m_statuses = NULL;
+  m_count = 0;
+
+  if (jcallback == NULL)
+    return;
+
+  JNIEnv *env = JNIUtil::getEnv();
+  jclass clazz = env->FindClass(JAVAHL_CLASS("/callback/StatusBatchCallback"));
+  if (JNIUtil::isJavaExceptionThrown())
+    return;
+
+  m_batched = env->IsInstanceOf(jcallback, clazz) ? true : false;
+  env->DeleteLocalRef(clazz);
 }
 
 /**
@@ -46,6 +68,11 @@ StatusCallback::~StatusCallback()
 {
   // the m_callback does not need to be destroyed, because it is the passed
   // in parameter to the Java SVNClient.status method.
+  JNIEnv *env = JNIUtil::getEnv();
+  if (m_paths)
+    env->DeleteGlobalRef(m_paths);
+  if (m_statuses)
+    env->DeleteGlobalRef(m_statuses);
 }
 
 svn_error_t *
@@ -100,11 +127,99 @@ StatusCallback::doStatus(const char *local_abspath,
   if (JNIUtil::isJavaExceptionThrown())
     POP_AND_RETURN(SVN_NO_ERROR);
 
+  if (m_batched)
+    {
+      if (m_paths == NULL)
+        {
+          jclass clazz = env->FindClass("java/lang/String");
+          if (JNIUtil::isJavaExceptionThrown())
+            POP_AND_RETURN(SVN_NO_ERROR);
+
+          jobjectArray jpaths = env->NewObjectArray(STATUS_BATCH_SIZE,
+                                                    clazz, NULL);
+          if (JNIUtil::isJavaExceptionThrown())
+            POP_AND_RETURN(SVN_NO_ERROR);
+
+          clazz = env->FindClass(JAVAHL_CLASS("/types/Status"));
+          if (JNIUtil::isJavaExceptionThrown())
+            POP_AND_RETURN(SVN_NO_ERROR);
+
+          jobjectArray jstatuses = env->NewObjectArray(STATUS_BATCH_SIZE,
+                                                       clazz, NULL);
+          if (JNIUtil::isJavaExceptionThrown())
+            POP_AND_RETURN(SVN_NO_ERROR);
+
+          m_paths = static_cast<jobjectArray>(env->NewGlobalRef(jpaths));
+          m_statuses =
+            static_cast<jobjectArray>(env->NewGlobalRef(jstatuses));
+        }
+
+      // The arrays keep the new objects alive after we pop the frame.
+      env->SetObjectArrayElement(m_paths, m_count, jPath);
+      env->SetObjectArrayElement(m_statuses, m_count, jStatus);
+      if (JNIUtil::isJavaExceptionThrown())
+        POP_AND_RETURN(SVN_NO_ERROR);
+
+      env->PopLocalFrame(NULL);
+      if (++m_count < STATUS_BATCH_SIZE)
+        return SVN_NO_ERROR;
+
+      return flush();
+    }
+
   env->CallVoidMethod(m_callback, mid, jPath, jStatus);
 
   POP_AND_RETURN_EXCEPTION_AS_SVNERROR();
 }
 
+svn_error_t *
+StatusCallback::flush()
+{
+  if (m_count == 0)
+    return SVN_NO_ERROR;
+
+  JNIEnv *env = JNIUtil::getEnv();
+
+  // Create a local frame for our references
+  env->PushLocalFrame(LOCAL_FRAME_SIZE);
+  if (JNIUtil::isJavaExceptionThrown())
+    return SVN_NO_ERROR;
+
+  static jmethodID mid = 0;
+  if (mid == 0)
+    {
+      jclass clazz =
+        env->FindClass(JAVAHL_CLASS("/callback/StatusBatchCallback"));
+      if (JNIUtil::isJavaExceptionThrown())
+        POP_AND_RETURN(SVN_NO_ERROR);
+
+      mid = env->GetMethodID(clazz, "doStatusBatch",
+                             "([Ljava/lang/String;"
+                             "[" JAVAHL_ARG("/types/Status;") ")V");
+      if (JNIUtil::isJavaExceptionThrown() || mid == 0)
+        POP_AND_RETURN(SVN_NO_ERROR);
+    }
+
+  jsize count = m_count;
+  m_count = 0;
+
+  // The callee may hold on to the arrays, so a new batch gets new ones.
+  jobjectArray jpaths = JNIUtil::takeObjectArray(m_paths, count,
+                                                 "java/lang/String");
+  if (JNIUtil::isJavaExceptionThrown())
+    POP_AND_RETURN(SVN_NO_ERROR);
+
+  jobjectArray jstatuses =
+    JNIUtil::takeObjectArray(m_statuses, count,
+                             JAVAHL_CLASS("/types/Status"));
+  if (JNIUtil::isJavaExceptionThrown())
+    POP_AND_RETURN(SVN_NO_ERROR);
+
+  env->CallVoidMethod(m_callback, mid, jpaths, jstatuses);
+
+  POP_AND_RETURN_EXCEPTION_AS_SVNERROR();
+}
+
 void
 StatusCallback::setWcCtx(svn_wc_context_t *wc_ctx_in)
 {
@@ -47,6 +47,11 @@ class StatusCallback
                                const svn_client_status_t *status,
                                apr_pool_t *pool);
 
+  /**
+   * Deliver the status items still buffered for a batch callback.
+   */
+  svn_error_t *flush();
+
  protected:
   svn_error_t *doStatus(const char *local_abspath,
                         const svn_client_status_t *status,
@@ -59,6 +64,23 @@ class StatusCallback
   jobject m_callback;
 
   svn_wc_context_t *wc_ctx;
+
+  /**
+   * Whether m_callback is a StatusBatchCallback.
+   */
+  bool m_batched;
+
+  /**
+   * Global references to the arrays of the batch being filled,
+   * or NULL if there is none.
+   */
+  jobjectArray m_paths;
+  jobjectArray m_statuses;
+
+  /**
+   * The number of items in the current batch.
+   */
+  jsize m_count;
 };
 
 #endif // STATUSCALLBACK_H
@@ -0,0 +1,46 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ */
+
+package org.apache.subversion.javahl.callback;
+
+import org.apache.subversion.javahl.ISVNClient;
+import org.apache.subversion.javahl.types.Status;
+
+/**
+ * A {@link StatusCallback} that receives the status items of the
+ * {@link ISVNClient#status} call in batches, which saves most of the
+ * cost of crossing the JNI boundary on large working copies.
+ * {@link StatusCallback#doStatus} is not called for callbacks that
+ * implement this interface.
+ * @since 1.10
+ */
+public interface StatusBatchCallback extends StatusCallback
+{
+    /**
+     * This method will be called for each batch of status items.
+     * @param paths     the paths of the objects
+     * @param statuses  the status objects, in the same order as
+     *                  <code>paths</code>
+     */
+    public void doStatusBatch(String[] paths, Status[] statuses);
+}
@@ -346,6 +346,49 @@ public class BasicTests extends SVNTests
             fail("File foo.c should return exactly one empty status.");
     }
 
+    /**
+     * Test that a {@link StatusBatchCallback} receives the same status
+     * items as a plain {@link StatusCallback}.
+     * @throws Throwable
+     */
+    public void testBatchedStatus() throws Throwable
+    {
+        // build the test setup
+        OneTest thisTest = new OneTest();
+
+        MyStatusCallback statusCallback = new MyStatusCallback();
+        client.status(thisTest.getWCPath(), Depth.infinity,
+                      false, true, true, false, false, false,
+                      null, statusCallback);
+
+        final List<String> paths = new ArrayList<String>();
+        final List<Status> statuses = new ArrayList<Status>();
+        client.status(thisTest.getWCPath(), Depth.infinity,
+                      false, true, true, false, false, false,
+                      null, new StatusBatchCallback() {
+                          public void doStatus(String path, Status status)
+                          {
+                              fail("doStatus called for a batch callback");
+                          }
+                          public void doStatusBatch(String[] batchPaths,
+                                                    Status[] batchStatuses)
+                          {
+                              assertEquals(batchPaths.length,
+                                           batchStatuses.length);
+                              paths.addAll(Arrays.asList(batchPaths));
+                              statuses.addAll(Arrays.asList(batchStatuses));
+                          }
+                      });
+
+        Status[] expected = statusCallback.getStatusArray();
+        assertEquals(expected.length, statuses.size());
+        for (int i = 0; i < expected.length; i++)
+        {
+            assertEquals(expected[i].getPath(), statuses.get(i).getPath());
+            assertEquals(expected[i].getPath(), paths.get(i));
+        }
+    }
+
     /**
      * Test the "out of date" info from {@link
      * org.apache.subversion.javahl.SVNClient#status()}.
@@ -2424,6 +2424,231 @@ void svn_swig_py_make_parse_fns3(const svn_repos_parse_fns3_t **parse_fns3,
 }
 
 
+/*** Bulk Results ***/
+
+/* The functions below return whole listings as Python lists of tuples
+   instead of wrapping each item in a proxy object or calling back into
+   Python for it.  Like any other wrapped function, they are entered
+   without the GIL, so they run the Subversion operation first and take
+   the GIL only once to build the result. */
+
+/* Raise ERR as a SubversionException, clear it and return NULL.
+   Must be called without the GIL. */
+static PyObject *
+bulk_result_error(svn_error_t *err)
+{
+  svn_swig_py_acquire_py_lock();
+  svn_swig_py_svn_exception(err);
+  svn_swig_py_release_py_lock();
+  svn_error_clear(err);
+  return NULL;
+}
+
+PyObject *svn_swig_py_fs_dir_entries_list(svn_fs_root_t *root,
+                                          const char *path,
+                                          apr_pool_t *pool)
+{
+  apr_hash_t *entries;
+  apr_hash_index_t *hi;
+  PyObject *list;
+  svn_error_t *err;
+  int i = 0;
+
+  err = svn_fs_dir_entries(&entries, root, path, pool);
+  if (err)
+    return bulk_result_error(err);
+
+  svn_swig_py_acquire_py_lock();
+
+  list = PyList_New(apr_hash_count(entries));
+  for (hi = apr_hash_first(pool, entries); list && hi; hi = apr_hash_next(hi))
+    {
+      const svn_fs_dirent_t *dirent = apr_hash_this_val(hi);
+      PyObject *ob = Py_BuildValue((char *)"(si)", dirent->name,
+                                   (int)dirent->kind);
+      if (ob == NULL)
+        {
+          Py_DECREF(list);
+          list = NULL;
+          break;
+        }
+      PyList_SET_ITEM(list, i++, ob);
+    }
+
+  svn_swig_py_release_py_lock();
+  return list;
+}
+
+PyObject *svn_swig_py_fs_paths_changed_list(svn_fs_root_t *root,
+                                            apr_pool_t *pool)
+{
+  svn_fs_path_change_iterator_t *iterator;
+  svn_fs_path_change3_t *change;
+  apr_array_header_t *changes = apr_array_make(pool, 16, sizeof(change));
+  PyObject *list;
+  svn_error_t *err;
+  int i;
+
+  err = svn_fs_paths_changed3(&iterator, root, pool, pool);
+  while (!err)
+    {
+      err = svn_fs_path_change_get(&change, iterator);
+      if (err || change == NULL)
+        break;
+
+      /* CHANGE is only valid until the next call. */
+      APR_ARRAY_PUSH(changes, svn_fs_path_change3_t *)
+        = svn_fs_path_change3_dup(change, pool);
+    }
+  if (err)
+    return bulk_result_error(err);
+
+  svn_swig_py_acquire_py_lock();
+
+  list = PyList_New(changes->nelts);
+  for (i = 0; list && i < changes->nelts; ++i)
+    {
+      PyObject *ob;
+
+      change = APR_ARRAY_IDX(changes, i, svn_fs_path_change3_t *);
+      ob = Py_BuildValue((char *)"(siiiizl)",
+                         change->path.data,
+                         (int)change->change_kind,
+                         (int)change->node_kind,
+                         (int)change->text_mod,
+                         (int)change->prop_mod,
+                         change->copyfrom_known ? change->copyfrom_path
+                                                : NULL,
+                         change->copyfrom_known ? change->copyfrom_rev
+                                                : SVN_INVALID_REVNUM);
+      if (ob == NULL)
+        {
+          Py_DECREF(list);
+          list = NULL;
+          break;
+        }
+      PyList_SET_ITEM(list, i, ob);
+    }
+
+  svn_swig_py_release_py_lock();
+  return list;
+}
+
+/* Implements svn_log_entry_receiver_t.  Append a copy of LOG_ENTRY
+   to BATON, an array of svn_log_entry_t *. */
+static svn_error_t *
+collect_log_entry(void *baton,
+                  svn_log_entry_t *log_entry,
+                  apr_pool_t *pool)
+{
+  apr_array_header_t *entries = baton;
+
+  APR_ARRAY_PUSH(entries, svn_log_entry_t *)
+    = svn_log_entry_dup(log_entry, entries->pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return a dict mapping the paths in CHANGED_PATHS, a hash of
+   svn_log_changed_path2_t *, to (ACTION, COPYFROM_PATH, COPYFROM_REV)
+   tuples, or None if CHANGED_PATHS is NULL. */
+static PyObject *
+changed_paths_to_tuple_dict(apr_hash_t *changed_paths,
+                            apr_pool_t *pool)
+{
+  apr_hash_index_t *hi;
+  PyObject *dict;
+
+  if (changed_paths == NULL)
+    Py_RETURN_NONE;
+
+  if ((dict = PyDict_New()) == NULL)
+    return NULL;
+
+  for (hi = apr_hash_first(pool, changed_paths); hi; hi = apr_hash_next(hi))
+    {
+      const svn_log_changed_path2_t *change = apr_hash_this_val(hi);
+      PyObject *value = Py_BuildValue((char *)"(czl)", change->action,
+                                      change->copyfrom_path,
+                                      change->copyfrom_rev);
+      if (value == NULL
+          || PyDict_SetItemString(dict, apr_hash_this_key(hi), value) == -1)
+        {
+          Py_XDECREF(value);
+          Py_DECREF(dict);
+          return NULL;
+        }
+      Py_DECREF(value);
+    }
+
+  return dict;
+}
+
+PyObject *svn_swig_py_repos_log_list(svn_repos_t *repos,
+                                     apr_array_header_t *paths,
+                                     svn_revnum_t start,
+                                     svn_revnum_t end,
+                                     int limit,
+                                     svn_boolean_t discover_changed_paths,
+                                     apr_pool_t *pool)
+{
+  apr_array_header_t *entries = apr_array_make(pool, 16,
+                                               sizeof(svn_log_entry_t *));
+  apr_array_header_t *revprops = apr_array_make(pool, 3,
+                                                sizeof(const char *));
+  PyObject *list;
+  svn_error_t *err;
+  int i;
+
+  APR_ARRAY_PUSH(revprops, const char *) = SVN_PROP_REVISION_AUTHOR;
+  APR_ARRAY_PUSH(revprops, const char *) = SVN_PROP_REVISION_DATE;
+  APR_ARRAY_PUSH(revprops, const char *) = SVN_PROP_REVISION_LOG;
+
+  err = svn_repos_get_logs4(repos, paths, start, end, limit,
+                            discover_changed_paths, FALSE, FALSE, revprops,
+                            NULL, NULL, collect_log_entry, entries, pool);
+  if (err)
+    return bulk_result_error(err);
+
+  svn_swig_py_acquire_py_lock();
+
+  list = PyList_New(entries->nelts);
+  for (i = 0; list && i < entries->nelts; ++i)
+    {
+      const svn_log_entry_t *entry
+        = APR_ARRAY_IDX(entries, i, svn_log_entry_t *);
+      const svn_string_t *author = NULL, *date = NULL, *message = NULL;
+      PyObject *py_changed_paths, *ob = NULL;
+
+      if (entry->revprops)
+        {
+          author = svn_hash_gets(entry->revprops, SVN_PROP_REVISION_AUTHOR);
+          date = svn_hash_gets(entry->revprops, SVN_PROP_REVISION_DATE);
+          message = svn_hash_gets(entry->revprops, SVN_PROP_REVISION_LOG);
+        }
+
+      py_changed_paths = changed_paths_to_tuple_dict(entry->changed_paths2,
+                                                     pool);
+      if (py_changed_paths)
+        ob = Py_BuildValue((char *)"(lzzzN)", entry->revision,
+                           author ? author->data : NULL,
+                           date ? date->data : NULL,
+                           message ? message->data : NULL,
+                           py_changed_paths);
+      if (ob == NULL)
+        {
+          Py_DECREF(list);
+          list = NULL;
+          break;
+        }
+      PyList_SET_ITEM(list, i, ob);
+    }
+
+  svn_swig_py_release_py_lock();
+  return list;
+}
+
+
 /*** Other Wrappers for SVN Functions ***/
 
 
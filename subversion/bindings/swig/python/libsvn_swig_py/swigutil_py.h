@@ -258,6 +258,30 @@ void svn_swig_py_make_parse_fns3(const svn_repos_parse_fns3_t **parse_fns3,
                                  PyObject *py_parse_fns3,
                                  apr_pool_t *pool);
 
+/* Return the entries of directory PATH in ROOT as a list of
+   (NAME, KIND) tuples, in no particular order. */
+PyObject *svn_swig_py_fs_dir_entries_list(svn_fs_root_t *root,
+                                          const char *path,
+                                          apr_pool_t *pool);
+
+/* Return the changes made in ROOT as a list of (PATH, CHANGE_KIND,
+   NODE_KIND, TEXT_MOD, PROP_MOD, COPYFROM_PATH, COPYFROM_REV) tuples. */
+PyObject *svn_swig_py_fs_paths_changed_list(svn_fs_root_t *root,
+                                            apr_pool_t *pool);
+
+/* Like svn_repos_get_logs4() without authz checks and with the author,
+   date and log message revprops only, but return the log entries as a
+   list of (REVISION, AUTHOR, DATE, MESSAGE, CHANGED_PATHS) tuples.
+   CHANGED_PATHS maps paths to (ACTION, COPYFROM_PATH, COPYFROM_REV)
+   tuples or is None. */
+PyObject *svn_swig_py_repos_log_list(svn_repos_t *repos,
+                                     apr_array_header_t *paths,
+                                     svn_revnum_t start,
+                                     svn_revnum_t end,
+                                     int limit,
+                                     svn_boolean_t discover_changed_paths,
+                                     apr_pool_t *pool);
+
 apr_file_t *svn_swig_py_make_file(PyObject *py_file,
                                   apr_pool_t *pool);
 
@@ -49,6 +49,16 @@ def entries(root, path, pool=None):
     e[name] = dirent_t_id_get(entry)
   return e
 
+def dir_entries_list(root, path, pool=None):
+  """Return the entries of directory PATH in ROOT as a list of
+  (name, kind) tuples, without creating a dirent object per entry."""
+  return svn_swig_py_fs_dir_entries_list(root, path, pool)
+
+def paths_changed_list(root, pool=None):
+  """Return the changes made in ROOT as a list of (path, change_kind,
+  node_kind, text_mod, prop_mod, copyfrom_path, copyfrom_rev) tuples."""
+  return svn_swig_py_fs_paths_changed_list(root, pool)
+
 
 class FileDiff:
   def __init__(self, root1, path1, root2, path2, pool=None, diffoptions=[]):
@@ -338,3 +338,13 @@ class ParseFns3:
 
 def make_parse_fns3(parse_fns3, pool=None):
     return svn_swig_py_make_parse_fns3(parse_fns3, pool)
+
+def log_list(repos, paths, start, end, limit=0,
+             discover_changed_paths=False, pool=None):
+    """Return the log of PATHS in REPOS from START to END as a list of
+    (revision, author, date, message, changed_paths) tuples.  Unless
+    DISCOVER_CHANGED_PATHS is set, changed_paths is None; otherwise it
+    maps each changed path to an (action, copyfrom_path, copyfrom_rev)
+    tuple.  Unlike get_logs4(), this makes no call back into Python."""
+    return svn_swig_py_repos_log_list(repos, paths, start, end, limit,
+                                      discover_changed_paths, pool)
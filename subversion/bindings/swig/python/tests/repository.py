@@ -252,6 +252,36 @@ class SubversionRepositoryTestCase(unittest.TestCase):
     self.assertEqual(len(logs), 12)
     self.assertEqual(change_count, 19)
 
+  def test_log_list(self):
+    """Test the bulk log_list against get_logs"""
+    logs = {}
+    def addLog(paths, revision, author, date, message, pool):
+      if paths:
+        logs[revision] = dict((path, (change.action, change.copyfrom_path,
+                                      change.copyfrom_rev))
+                              for path, change in paths.items())
+
+    repos.get_logs(self.repos, ['/'], self.rev, 0, True, 0, addLog)
+    entries = repos.log_list(self.repos, ['/'], self.rev, 0, 0, True)
+
+    self.assertEqual(entries[0][0], self.rev)
+    self.assertEqual(logs,
+                     dict((entry[0], entry[4]) for entry in entries
+                          if entry[4]))
+
+  def test_paths_changed_list(self):
+    """Test the bulk dir_entries_list and paths_changed_list"""
+    root = fs.revision_root(self.fs, self.rev)
+    entries = fs.dir_entries(root, '')
+    self.assertEqual(sorted(fs.dir_entries_list(root, '')),
+                     sorted((name, fs.dirent_t_kind_get(dirent))
+                            for name, dirent in entries.items()))
+
+    changes = fs.paths_changed2(root)
+    self.assertEqual(sorted(change[0] for change
+                            in fs.paths_changed_list(root)),
+                     sorted(changes.keys()))
+
   def test_dir_delta(self):
     """Test scope of dir_delta callbacks"""
     # Run dir_delta
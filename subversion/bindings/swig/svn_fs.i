@@ -135,6 +135,17 @@ svn_fs_root_fs_wrapper(svn_fs_root_t *root, apr_pool_t *pool)
 %}
 #endif
 
+/* ----------------------------------------------------------------------- */
+#ifdef SWIGPYTHON
+/* Bulk variants of svn_fs_dir_entries() and svn_fs_paths_changed3() that
+   return plain lists of tuples. */
+PyObject *svn_swig_py_fs_dir_entries_list(svn_fs_root_t *root,
+                                          const char *path,
+                                          apr_pool_t *pool);
+PyObject *svn_swig_py_fs_paths_changed_list(svn_fs_root_t *root,
+                                            apr_pool_t *pool);
+#endif
+
 /* ----------------------------------------------------------------------- */
 
 %{
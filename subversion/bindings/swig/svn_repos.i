@@ -154,6 +154,16 @@ void svn_swig_py_make_parse_fns3(const svn_repos_parse_fns3_t **parse_fns3,
                                  void **parse_baton,
                                  PyObject *py_parse_fns3,
                                  apr_pool_t *pool);
+
+/* A bulk variant of svn_repos_get_logs4() that returns a plain list of
+   tuples. */
+PyObject *svn_swig_py_repos_log_list(svn_repos_t *repos,
+                                     apr_array_header_t *paths,
+                                     svn_revnum_t start,
+                                     svn_revnum_t end,
+                                     int limit,
+                                     svn_boolean_t discover_changed_paths,
+                                     apr_pool_t *pool);
 #endif
 
 %include svn_repos_h.swg
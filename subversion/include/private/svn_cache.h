@@ -174,6 +174,14 @@ typedef struct svn_cache__info_t
    */
   apr_uint64_t total_entries;
 
+  /** Number of items that have been admitted to resp. rejected from the
+   * main (L2) storage area.  The ratio depends on the admission policy,
+   * see svn_cache__membuffer_enable_admission_filter().
+   * May be 0 if that information is not available.
+   */
+  apr_uint64_t l2_admissions;
+  apr_uint64_t l2_rejections;
+
   /** Number of index buckets with the given number of entries.
    * Bucket sizes larger than the array will saturate into the
    * highest array index.
@@ -181,6 +189,47 @@ typedef struct svn_cache__info_t
   apr_uint64_t histogram[32];
 } svn_cache__info_t;
 
+/**
+ * Usage statistics of a membuffer cache, restricted to the entries and
+ * accesses of all cache instances that use a given key prefix.  See
+ * svn_cache__membuffer_get_prefix_info().
+ */
+typedef struct svn_cache__prefix_info_t
+{
+  /** The key prefix passed to svn_cache__create_membuffer_cache(). */
+  const char *prefix;
+
+  /* Access counters.  They cover the lifetime of the current process. */
+
+  /** Number of getter calls (svn_cache__get() or
+   * svn_cache__get_partial()).
+   */
+  apr_uint64_t gets;
+
+  /** Number of getter calls that return data.
+   */
+  apr_uint64_t hits;
+
+  /** Number of function calls that may have changed the cache.
+   */
+  apr_uint64_t sets;
+
+  /** Number of entries that got removed to make room for others.
+   * Not available for caches shared between processes.
+   */
+  apr_uint64_t evictions;
+
+  /* Size info */
+
+  /** Number of cached entries with this prefix.
+   */
+  apr_uint64_t used_entries;
+
+  /** Number of bytes used by those entries, including their keys.
+   */
+  apr_uint64_t used_size;
+} svn_cache__prefix_info_t;
+
 /**
  * Creates a new cache in @a *cache_p.  This cache will use @a pool
  * for all of its storage needs.  The elements in the cache will be
@@ -299,6 +348,11 @@ svn_cache__make_memcache_from_config(svn_memcache_t **memcache_p,
  * (no data being written to the cache) if some reader or another writer
  * currently holds the segment lock.
  *
+ * Where supported by the platform, thread-safe caches will serve lookups
+ * without taking the segment lock at all, retrying only if a concurrent
+ * write to the same segment has been detected.  See
+ * svn_cache__membuffer_set_optimistic_reads().
+ *
  * Allocations will be made in @a result_pool, in particular the data buffers.
  */
 svn_error_t *
@@ -310,6 +364,126 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
                                   svn_boolean_t allow_blocking_writes,
                                   apr_pool_t *result_pool);
 
+/**
+ * Like svn_cache__membuffer_cache_create() but allocate all cache segments
+ * and their data buffers in an anonymous shared memory region.  Processes
+ * forked after this call will share the cache contents with the creating
+ * process and with each other.  Each child process should call
+ * svn_cache__membuffer_child_init() before accessing the cache.
+ *
+ * Access to the cache is serialized across processes with one global
+ * mutex per segment, independent of @a thread_safe.  The latter only
+ * controls whether process-local management structures will be
+ * protected against concurrent access by multiple threads.  Where
+ * available, the mutexes use fcntl() locks, which are released when a
+ * process holding one dies.  See svn_cache__membuffer_get_global_locks().
+ *
+ * Key prefixes cannot be shared between processes.  Hence, all cache
+ * entries will carry their full key, adding to the memory overhead.
+ *
+ * Returns #SVN_ERR_UNSUPPORTED_FEATURE on platforms without support for
+ * fork() and shared memory.
+ */
+svn_error_t *
+svn_cache__membuffer_cache_create_shared(svn_membuffer_t **cache,
+                                         apr_size_t total_size,
+                                         apr_size_t directory_size,
+                                         apr_size_t segment_count,
+                                         svn_boolean_t thread_safe,
+                                         svn_boolean_t allow_blocking_writes,
+                                         apr_pool_t *result_pool);
+
+/**
+ * Re-initialize the process-local parts of the membuffer @a cache in a
+ * child process that has been forked after the cache had been created
+ * with svn_cache__membuffer_cache_create_shared().  This is a no-op for
+ * process-local caches.  Allocations will be made in @a result_pool.
+ */
+svn_error_t *
+svn_cache__membuffer_child_init(svn_membuffer_t *cache,
+                                apr_pool_t *result_pool);
+
+/**
+ * Return the cross-process mutexes of the membuffer @a cache, as an
+ * array of apr_global_mutex_t *, allocated in @a result_pool.  The array
+ * is empty for process-local caches.
+ *
+ * Servers that drop privileges after creating a shared cache should
+ * make these mutexes accessible to the unprivileged user, e.g. with
+ * httpd's ap_unixd_set_global_mutex_perms(), before forking.  That is
+ * necessary for mechanisms like System V semaphores only, which are
+ * used where fcntl() locks are not available.
+ */
+apr_array_header_t *
+svn_cache__membuffer_get_global_locks(svn_membuffer_t *cache,
+                                      apr_pool_t *result_pool);
+
+/**
+ * Control whether lookups in the thread-safe membuffer @a cache may
+ * bypass the segment locks and validate their results against the
+ * segment's write version instead.  If @a enabled is @c FALSE, all reads
+ * will acquire the read lock.  This is a no-op for caches that have not
+ * been created as thread-safe and on platforms that don't support
+ * lock-free reads.
+ *
+ * Returns @c TRUE if lock-free reads are now in effect.
+ *
+ * The setting may be changed at any time, even with other threads
+ * accessing @a cache concurrently.
+ */
+svn_boolean_t
+svn_cache__membuffer_set_optimistic_reads(svn_membuffer_t *cache,
+                                          svn_boolean_t enabled);
+
+/**
+ * Enable the TinyLFU admission filter for @a cache.  By default, items
+ * evicted from the first cache level will be admitted to the second level
+ * based on their hit counts, which start at 0 for every new item.  With
+ * the filter, the access frequencies of all keys that have been looked up
+ * recently are estimated using a compact count-min sketch and an item gets
+ * only admitted if it is expected to be hit more often than the items it
+ * would replace.  This protects frequently used entries from being flushed
+ * out by one-off scans.
+ *
+ * The sketch uses about 4 bytes for each entry in the cache directory and
+ * will be allocated in @a result_pool.  This must be called before @a cache
+ * is accessed concurrently.  Shared memory caches do not support this.
+ */
+svn_error_t *
+svn_cache__membuffer_enable_admission_filter(svn_membuffer_t *cache,
+                                             apr_pool_t *result_pool);
+
+/**
+ * Change the capacity of the membuffer @a cache to about @a total_size
+ * bytes, as if it had been created with that size.  The cache cannot grow
+ * beyond the size it has been created with.  Create it with the largest
+ * size that it may ever need, e.g. at startup; untouched parts of the data
+ * buffers will usually not consume physical memory.
+ *
+ * All segments whose size changes will be emptied.  May be called at any
+ * time, even with other threads accessing @a cache concurrently.
+ */
+svn_error_t *
+svn_cache__membuffer_resize(svn_membuffer_t *cache,
+                            apr_uint64_t total_size);
+
+/**
+ * Limit the data that any single key prefix, as passed to
+ * svn_cache__create_membuffer_cache(), may keep in @a cache to about
+ * @a quota bytes.  Once a prefix reaches its quota, new items for it will
+ * not be cached until some of its old items got evicted.  This keeps e.g.
+ * a single busy repository from flushing the data of all other
+ * repositories out of the cache.  A @a quota of 0 removes the limit.
+ *
+ * The first call allocates about 8 bytes per cache segment for each
+ * prefix that may be tracked in @a result_pool.  Later calls may change
+ * the quota at any time.  Shared memory caches do not support quotas.
+ */
+svn_error_t *
+svn_cache__membuffer_set_prefix_quota(svn_membuffer_t *cache,
+                                      apr_uint64_t quota,
+                                      apr_pool_t *result_pool);
+
 /**
  * @defgroup Standard priority classes for #svn_cache__create_membuffer_cache.
  * @{
@@ -391,6 +565,40 @@ svn_cache__create_null(svn_cache__t **cache_p,
                        const char *id,
                        apr_pool_t *result_pool);
 
+/**
+ * Creates a new cache in @a *cache_p, allocated in @a result_pool, that
+ * adds a persistent second tier in the local directory @a directory
+ * below the cache @a first.  This is meant for fast local storage like
+ * SSDs and for data that is expensive to reconstruct.
+ *
+ * Lookups that miss in @a first will be tried in @a directory and hits
+ * will be copied into @a first.  New items get stored in both tiers.
+ * The elements are indexed by keys of length @a klen, which may be
+ * APR_HASH_KEY_STRING if they are strings, and are serialized using
+ * @a serialize_func and @a deserialize_func.  Both may be NULL if the
+ * values are svn_stringbuf_t.  Items get stored under the hash of @a prefix
+ * and their key, i.e. a cache with the same @a prefix will find them
+ * again after a restart.
+ *
+ * All caches in this process using the same @a directory share it and
+ * the least recently used items will be removed once its contents exceed
+ * @a max_size bytes.  The first cache created for @a directory determines
+ * that limit.  @a directory will be created if it does not exist.
+ *
+ * I/O errors in the second tier are not reported; they simply make the
+ * affected items cache misses.
+ */
+svn_error_t *
+svn_cache__create_disk_tier(svn_cache__t **cache_p,
+                            svn_cache__t *first,
+                            const char *directory,
+                            apr_uint64_t max_size,
+                            svn_cache__serialize_func_t serialize_func,
+                            svn_cache__deserialize_func_t deserialize_func,
+                            apr_ssize_t klen,
+                            const char *prefix,
+                            apr_pool_t *result_pool);
+
 /**
  * Sets @a handler to be @a cache's error handling routine.  If any
  * error is returned from a call to svn_cache__get or svn_cache__set, @a
@@ -522,6 +730,39 @@ svn_cache__set_partial(svn_cache__t *cache,
                        void *baton,
                        apr_pool_t *scratch_pool);
 
+/**
+ * Look up all @a count entries indexed by @a keys in @a cache at once.
+ * For each index i, set @a found[i] to TRUE and return a copy of the
+ * respective value in @a values[i] if the entry has been found, or set
+ * @a found[i] to FALSE and @a values[i] to NULL otherwise.  The caller
+ * must provide both arrays with at least @a count elements.  Individual
+ * keys may be NULL in which case nothing will be found for them.  The
+ * copies will be allocated in @a result_pool.
+ *
+ * This is equivalent to calling svn_cache__get() for each key but allows
+ * cache implementations with a high per-request latency, like memcached,
+ * to fetch all entries in a single round-trip.
+ */
+svn_error_t *
+svn_cache__get_multi(void **values,
+                     svn_boolean_t *found,
+                     svn_cache__t *cache,
+                     const void *const *keys,
+                     int count,
+                     apr_pool_t *result_pool);
+
+/**
+ * Store all @a count values @a values under the respective @a keys in
+ * @a cache, equivalent to calling svn_cache__set() for each key.  NULL
+ * keys will be ignored.  Uses @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_cache__set_multi(svn_cache__t *cache,
+                     const void *const *keys,
+                     void *const *values,
+                     int count,
+                     apr_pool_t *scratch_pool);
+
 /**
  * Collect all available usage statistics on the cache instance @a cache
  * and write the data into @a info. If @a reset has been set, access
@@ -554,6 +795,66 @@ svn_cache__format_info(const svn_cache__info_t *info,
 struct svn_membuffer_t *
 svn_cache__get_global_membuffer_cache(void);
 
+/**
+ * Allocate the process-global membuffer cache right away, using the
+ * current cache config, and place it in shared memory such that all
+ * processes forked afterwards will share it.  See
+ * svn_cache__membuffer_cache_create_shared() for details.  This must be
+ * called before the first call to svn_cache__get_global_membuffer_cache()
+ * and before forking any worker processes.  It is a no-op if the
+ * configured cache size is 0.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_cache__create_shared_global_membuffer_cache(apr_pool_t *scratch_pool);
+
+/**
+ * Select whether the process-global membuffer cache shall use the
+ * admission filter described in
+ * svn_cache__membuffer_enable_admission_filter(), depending on @a enabled.
+ * This must be called before the global cache gets created and has no
+ * effect for caches in shared memory.
+ */
+void
+svn_cache__set_global_membuffer_admission_filter(svn_boolean_t enabled);
+
+/**
+ * Allocate the process-global membuffer cache with a capacity of at least
+ * @a max_size bytes, such that later calls to svn_cache_config_set() may
+ * grow the cache up to that size without a restart.  The configured cache
+ * size will be used initially.  This must be called before the global
+ * cache gets created.  See svn_cache__membuffer_resize().
+ */
+void
+svn_cache__set_global_membuffer_max_size(apr_uint64_t max_size);
+
+/**
+ * Limit the data per key prefix in the process-global membuffer cache to
+ * @a quota bytes, 0 meaning "unlimited".  Takes effect immediately if the
+ * cache already exists and has no effect for caches in shared memory.
+ * See svn_cache__membuffer_set_prefix_quota().
+ */
+void
+svn_cache__set_global_membuffer_prefix_quota(apr_uint64_t quota);
+
+/**
+ * To be called in every child process forked after
+ * svn_cache__create_shared_global_membuffer_cache().  Allocations will be
+ * made in @a result_pool which must live as long as the process itself.
+ */
+svn_error_t *
+svn_cache__global_membuffer_child_init(apr_pool_t *result_pool);
+
+/**
+ * Return the cross-process mutexes of the process-global membuffer cache
+ * as described for svn_cache__membuffer_get_global_locks(), allocated in
+ * @a result_pool.  The array is empty if there is no such cache or if it
+ * is not shared.
+ */
+apr_array_header_t *
+svn_cache__get_global_membuffer_locks(apr_pool_t *result_pool);
+
 /**
  * Return total access and size stats over all membuffer caches as they
  * share the underlying data buffer.  The result will be allocated in POOL.
@@ -561,6 +862,33 @@ svn_cache__get_global_membuffer_cache(void);
 svn_cache__info_t *
 svn_cache__membuffer_get_global_info(apr_pool_t *pool);
 
+/**
+ * Set @a *info to an array of <tt>svn_cache__prefix_info_t *</tt>, one
+ * element for each key prefix that has been used with @a cache, either
+ * by a cache instance created in this process or by any of the current
+ * entries.  The array is sorted by prefix.
+ *
+ * This scans all cache entries and is therefore expensive for large
+ * caches.  Allocate the result in @a result_pool and use @a scratch_pool
+ * for temporary allocations.
+ */
+svn_error_t *
+svn_cache__membuffer_get_prefix_info(apr_array_header_t **info,
+                                     svn_membuffer_t *cache,
+                                     apr_pool_t *result_pool,
+                                     apr_pool_t *scratch_pool);
+
+/**
+ * Return the statistics @a info returned by
+ * svn_cache__membuffer_get_prefix_info() as tab-separated values, i.e.
+ * one line per prefix preceded by a line of column names.  Tabs, newlines
+ * and backslashes in prefixes are escaped with a backslash.  Allocations
+ * take place in @a result_pool.
+ */
+svn_string_t *
+svn_cache__format_prefix_info(const apr_array_header_t *info,
+                              apr_pool_t *result_pool);
+
 /**
  * Remove all current contents from CACHE.
  *
@@ -570,6 +898,55 @@ svn_cache__membuffer_get_global_info(apr_pool_t *pool);
 svn_error_t *
 svn_cache__membuffer_clear(svn_membuffer_t *cache);
 
+/**
+ * Write the current contents of @a cache to the file at @a path, replacing
+ * any previous file there.  The snapshot can be fed into a new cache using
+ * svn_cache__membuffer_load() to quickly get back to a warm cache after a
+ * server restart.  Use @a scratch_pool for temporary allocations.
+ *
+ * The file is written to a temporary location first and moved into place
+ * once complete.  Cache contents may change while the snapshot is being
+ * taken; each segment will be consistent in itself, though.
+ *
+ * @note Since all entries carry their full cache key prefix, e.g. the
+ * repository UUID, instance ID and path for FSFS, and revision-dependent
+ * keys, there will be no hits on entries of other or replaced
+ * repositories.  However, restoring a repository from an older backup
+ * in place requires the snapshot file to be deleted as well.
+ */
+svn_error_t *
+svn_cache__membuffer_save(svn_membuffer_t *cache,
+                          const char *path,
+                          apr_pool_t *scratch_pool);
+
+/**
+ * Add all entries found in the snapshot file at @a path, written by
+ * svn_cache__membuffer_save(), to @a cache.  Entries may get evicted
+ * again if the snapshot is larger than @a cache.  A missing file, as well
+ * as a snapshot written by a different Subversion version or platform,
+ * are silently ignored.  Use @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_cache__membuffer_load(svn_membuffer_t *cache,
+                          const char *path,
+                          apr_pool_t *scratch_pool);
+
+/**
+ * Call svn_cache__membuffer_save() for the global membuffer cache
+ * with @a path and @a scratch_pool.  No-op if there is no such cache.
+ */
+svn_error_t *
+svn_cache__save_global_membuffer_cache(const char *path,
+                                       apr_pool_t *scratch_pool);
+
+/**
+ * Call svn_cache__membuffer_load() for the global membuffer cache
+ * with @a path and @a scratch_pool.  No-op if there is no such cache.
+ */
+svn_error_t *
+svn_cache__load_global_membuffer_cache(const char *path,
+                                       apr_pool_t *scratch_pool);
+
 /** @} */
 
 
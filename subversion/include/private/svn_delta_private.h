@@ -101,6 +101,26 @@ svn_delta__delta_from_editor(const svn_delta_editor_t **deditor,
                              struct svn_delta__extra_baton *exb,
                              apr_pool_t *pool);
 
+/** Parse the complete svndiff stream of @a len bytes at @a data and send
+ * the windows to @a handler / @a handler_baton, followed by the final
+ * @c NULL window.  This is equivalent to writing @a data to a stream
+ * returned by svn_txdelta_parse_svndiff() with @a error_on_early_close
+ * set and closing it, but the windows are decoded in-place:  For
+ * svndiff0 data, the @c new_data of each window points directly into
+ * @a data and is not NUL-terminated.  The windows are only valid
+ * during the respective @a handler call.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_txdelta__parse_svndiff_buffer(const char *data,
+                                  apr_size_t len,
+                                  svn_txdelta_window_handler_t handler,
+                                  void *handler_baton,
+                                  apr_pool_t *scratch_pool);
+
 /** Read the txdelta window header from @a stream and return the total
     length of the unparsed window data in @a *window_len. */
 svn_error_t *
@@ -108,6 +128,102 @@ svn_txdelta__read_raw_window_len(apr_size_t *window_len,
                                  svn_stream_t *stream,
                                  apr_pool_t *pool);
 
+/** Read the txdelta window header from @a stream and return the length
+    of the window's target view in @a *tview_len as well as the total
+    length of the unparsed window data in @a *window_len. */
+svn_error_t *
+svn_txdelta__read_raw_window_sizes(apr_size_t *tview_len,
+                                   apr_size_t *window_len,
+                                   svn_stream_t *stream,
+                                   apr_pool_t *pool);
+
+/** Set the maximum number of worker threads that handlers returned by
+ * svn_txdelta_to_svndiff3() may use to compress svndiff windows
+ * concurrently to @a threads.  0 disables the parallel encoding.
+ *
+ * The handlers always write their windows in order.  Parallel encoding
+ * only applies to compressed svndiff versions and deltas with more than
+ * one window.  It requires APR thread support.
+ *
+ * This setting is process-global and should be made before any deltas
+ * get encoded.  The default is 4.
+ */
+void
+svn_delta__set_encoder_threads(int threads);
+
+/** Set the maximum number of worker threads that delta streams created
+ * by svn_txdelta2() and svn_txdelta_run() may use to compute delta windows
+ * concurrently to @a threads.  0 disables the parallel computation.
+ *
+ * Windows are always returned resp. sent in order.  All stream reads and
+ * handler calls happen in the caller's thread.  Parallel computation
+ * only starts with the second window of a delta.  It requires APR thread
+ * support.
+ *
+ * This setting is process-global and should be made before any deltas
+ * get computed.  The default is 4.
+ */
+void
+svn_delta__set_delta_threads(int threads);
+
+/** Like svn_txdelta2() but choose the delta window boundaries by content
+ * instead of at fixed offsets.
+ *
+ * Target windows end where a rolling hash over the preceding bytes hits
+ * a given pattern.  Each window's source view begins at the position in
+ * @a source where the same boundary occurs, if there is one within reach.
+ * Otherwise, it follows the previous window's matches.  Windows thus
+ * resynchronize after data has been inserted into or removed from the
+ * middle of large files, e.g. VM images or archives, where fixed windows
+ * would lose most matches.
+ *
+ * The deltas are plain svndiff windows that any client can apply.  They
+ * are computed serially and the source may be read up to 1 MB ahead of
+ * the data actually referenced by the windows.
+ */
+void
+svn_txdelta__cdc(svn_txdelta_stream_t **stream,
+                 svn_stream_t *source,
+                 svn_stream_t *target,
+                 svn_boolean_t calculate_checksum,
+                 apr_pool_t *pool);
+
+/** Like svn_txdelta_target_push() but with content-defined window
+ * boundaries as described for svn_txdelta__cdc().
+ */
+svn_stream_t *
+svn_txdelta__target_push_cdc(svn_txdelta_window_handler_t handler,
+                             void *handler_baton,
+                             svn_stream_t *source,
+                             apr_pool_t *pool);
+
+/** Reusable state for svn_txdelta__compose_windows(). */
+typedef struct svn_txdelta__compose_ctx_t svn_txdelta__compose_ctx_t;
+
+/** Return a new, empty window composition context allocated in @a pool.
+ * All buffers of the context will be allocated from @a pool as well.
+ */
+svn_txdelta__compose_ctx_t *
+svn_txdelta__compose_ctx_create(apr_pool_t *pool);
+
+/** Like svn_txdelta_compose_windows() but use the buffers in @a ctx for
+ * all intermediate data.  They are reset rather than freed between calls
+ * and only grow when a composition needs more space than any before.
+ * Once they are large enough, composing further windows through the same
+ * @a ctx only allocates the result window in @a pool.
+ */
+svn_txdelta_window_t *
+svn_txdelta__compose_windows(svn_txdelta__compose_ctx_t *ctx,
+                             const svn_txdelta_window_t *window_A,
+                             const svn_txdelta_window_t *window_B,
+                             apr_pool_t *pool);
+
+/** Return the number of times that @a ctx had to allocate or grow one
+ * of its buffers so far.
+ */
+apr_size_t
+svn_txdelta__compose_ctx_allocations(const svn_txdelta__compose_ctx_t *ctx);
+
 /* Return a debug editor that wraps @a wrapped_editor.
  *
  * The debug editor simply prints an indication of what callbacks are being
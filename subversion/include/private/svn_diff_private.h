@@ -148,6 +148,21 @@ svn_diff_hunk__create_deletes_single_line(svn_diff_hunk_t **hunk,
 svn_linenum_t
 svn_diff_hunk__get_fuzz_penalty(const svn_diff_hunk_t *hunk);
 
+/** Set the maximum number of datasources that the file diff functions,
+ * e.g. svn_diff_file_diff3_2(), may read and tokenize concurrently to
+ * @a threads.  Values below 2 disable the concurrent tokenization.
+ *
+ * Files are only tokenized concurrently if the data between their
+ * identical prefix and suffix is large enough to make up for the extra
+ * threads.  That data is then kept in memory until the diff is complete.
+ * This requires APR thread support.
+ *
+ * This setting is process-global and should be made before any files
+ * get diffed.  The default is 4.
+ */
+void
+svn_diff__set_tokenize_threads(int threads);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
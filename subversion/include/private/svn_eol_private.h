@@ -62,6 +62,23 @@ extern "C" {
 char *
 svn_eol__find_eol_start(char *buf, apr_size_t len);
 
+/* Look for the first byte in the array pointed to by @a buf , of length
+ * @a len, that equals @a c1, @a c2 or @a c3.  The same value may be given
+ * more than once to search for fewer than three different bytes.
+ * If such a byte is found, return the pointer to it, else return NULL.
+ *
+ * This is the vectorized scanning kernel used by svn_eol__find_eol_start()
+ * and the keyword / EOL translation code.
+ *
+ * @since New in 1.10
+ */
+const char *
+svn_eol__find_first_of3(const char *buf,
+                        apr_size_t len,
+                        char c1,
+                        char c2,
+                        char c3);
+
 /* Return the first eol marker found in buffer @a buf as a NUL-terminated
  * string, or NULL if no eol marker is found. Do not examine more than
  * @a len bytes in @a buf.
@@ -259,11 +259,19 @@ typedef struct svn_fs_fs__stats_t
 /* Scan all contents of the repository FS and return statistics in *STATS,
  * allocated in RESULT_POOL.  Report progress through PROGRESS_FUNC with
  * PROGRESS_BATON, if PROGRESS_FUNC is not NULL.
+ *
+ * The repository gets read in batches of one pack file or one shard of
+ * non-packed revisions each.  Up to JOBS batches will be read concurrently
+ * and their results get merged in revision order.  Per-representation
+ * data is only kept until its batch has been merged, except for reps that
+ * are referenced more than once.
+ *
  * Use SCRATCH_POOL for temporary allocations.
  */
 svn_error_t *
 svn_fs_fs__get_stats(svn_fs_fs__stats_t **stats,
                      svn_fs_t *fs,
+                     int jobs,
                      svn_fs_progress_notify_func_t progress_func,
                      void *progress_baton,
                      svn_cancel_func_t cancel_func,
@@ -353,6 +361,41 @@ svn_fs_fs__load_index(svn_fs_t *fs,
                       apr_array_header_t *entries,
                       apr_pool_t *scratch_pool);
 
+/* Callback function type receiving a single representation that has been
+ * found to exceed the delta chain length limit.  The representation has
+ * been created in REVISION for PATH and contains its properties if
+ * IS_PROPS is set or its contents otherwise.  CHAIN_LENGTH is the number
+ * of deltas that need to be combined to reconstruct it (including itself).
+ * BATON is provided by the user.  Use SCRATCH_POOL for temporaries.
+ */
+typedef svn_error_t *
+(*svn_fs_fs__long_chain_func_t)(void *baton,
+                                svn_revnum_t revision,
+                                const char *path,
+                                svn_boolean_t is_props,
+                                int chain_length,
+                                apr_pool_t *scratch_pool);
+
+/* For all representations created in revisions START to END in FS,
+ * determine the length of their delta chains and invoke CALLBACK_FUNC
+ * with CALLBACK_BATON for every one longer than MAX_CHAIN_LENGTH.  If
+ * MAX_CHAIN_LENGTH is 0, use the limit that FS applies when selecting
+ * delta bases for new commits.  Since the work is done per revision,
+ * callers may process a repository incrementally, e.g. one shard at a
+ * time.  If not NULL, call CANCEL_FUNC with CANCEL_BATON from time to
+ * time.  Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs_fs__find_long_delta_chains(svn_fs_t *fs,
+                                  svn_revnum_t start,
+                                  svn_revnum_t end,
+                                  int max_chain_length,
+                                  svn_fs_fs__long_chain_func_t callback_func,
+                                  void *callback_baton,
+                                  svn_cancel_func_t cancel_func,
+                                  void *cancel_baton,
+                                  apr_pool_t *scratch_pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -212,6 +212,71 @@ svn_fs__get_deleted_node(svn_fs_root_t **node_root,
                          apr_pool_t *scratch_pool);
 
 
+/** Set @a *revisions to the revisions between @a start and @a end
+ * (inclusive, @a start <= @a end) in which @a path, any of its parents
+ * or any of its descendants appear in the changed paths list of @a fs.
+ * The revisions are sorted in ascending order.  @a path must be a
+ * canonical fspath.
+ *
+ * The result may contain revisions in which the node at @a path did not
+ * actually change but it never misses a revision that contains a change
+ * relevant to the history of @a path.  If the backend cannot provide
+ * that information for the whole range, set @a *revisions to NULL.
+ *
+ * Allocate @a *revisions in @a result_pool and use @a scratch_pool for
+ * temporaries.
+ */
+svn_error_t *
+svn_fs__get_changed_revisions(apr_array_header_t **revisions,
+                              svn_fs_t *fs,
+                              const char *path,
+                              svn_revnum_t start,
+                              svn_revnum_t end,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool);
+
+/** Set @a *files to the absolute paths (const char *) of all files that
+ * store revision @a rev of @a fs, including its revision properties.
+ * Those files may store other revisions as well.  Set @a *start_rev and
+ * @a *end_rev to the first and the last revision stored in them.  As long
+ * as the files don't change, neither do these revisions.  If the backend
+ * cannot provide that information, set @a *files to NULL.
+ *
+ * Allocate @a *files in @a result_pool and use @a scratch_pool for
+ * temporaries.
+ */
+svn_error_t *
+svn_fs__get_revision_files(apr_array_header_t **files,
+                           svn_revnum_t *start_rev,
+                           svn_revnum_t *end_rev,
+                           svn_fs_t *fs,
+                           svn_revnum_t rev,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool);
+
+/** Find out whether the contents of the file at @a path in @a root are
+ * stored verbatim in a single file of the repository's storage.  If so,
+ * set @a *file_path to that file's path and @a *offset and @a *length to
+ * the byte range occupied by the contents.  Otherwise, e.g. if the
+ * contents are stored as a delta or compressed, set @a *file_path to NULL.
+ *
+ * This allows servers to send the contents directly from disk.  Callers
+ * must be prepared for the file to disappear, e.g. when revisions get
+ * packed, and fall back to svn_fs_file_contents() in that case.
+ *
+ * Allocate @a *file_path in @a result_pool and use @a scratch_pool for
+ * temporaries.
+ */
+svn_error_t *
+svn_fs__file_contents_location(const char **file_path,
+                               apr_off_t *offset,
+                               svn_filesize_t *length,
+                               svn_fs_root_t *root,
+                               const char *path,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool);
+
+
 /** @} */
 
 
@@ -28,6 +28,7 @@
 #define SVN_IO_PRIVATE_H
 
 #include <apr.h>
+#include <apr_time.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -85,12 +86,45 @@ svn_io__file_lock_autocreate(const char *lock_file,
                              apr_pool_t *pool);
 
 
+/** Return the oldest modification time that a file in the filesystem
+ * containing @a path, an existing file or directory, may have if it was
+ * written just now.  If @a path is NULL or we can't determine the
+ * timestamp resolution, assume a resolution of one second.
+ *
+ * Files last modified at or after this time may be modified again without
+ * changing their timestamp; svn_io_sleep_for_timestamps() waits until that
+ * is no longer possible.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ */
+apr_time_t
+svn_io__racy_timestamp_limit(const char *path,
+                             apr_pool_t *scratch_pool);
+
+
 /** Return the underlying file, if any, associated with the stream, or
  * NULL if not available.  Accessing the file bypasses the stream.
  */
 apr_file_t *
 svn_stream__aprfile(svn_stream_t *stream);
 
+/* Set *STREAM to a stream returning the contents of SOURCE.  A separate
+   thread reads SOURCE ahead of the stream user in chunks of BLOCK_SIZE
+   bytes, keeping up to BLOCK_COUNT of them buffered.  Errors from SOURCE
+   are returned after all data read before them.  Closing *STREAM closes
+   SOURCE.
+
+   SOURCE must not be accessed by anyone else until *STREAM got closed
+   or RESULT_POOL got cleaned up.  Without thread support, *STREAM will
+   simply be SOURCE.  Allocate the buffers in RESULT_POOL.
+ */
+svn_error_t *
+svn_stream__read_ahead(svn_stream_t **stream,
+                       svn_stream_t *source,
+                       apr_size_t block_size,
+                       int block_count,
+                       apr_pool_t *result_pool);
+
 /* Creates as *INSTALL_STREAM a stream that once completed can be installed
    using Windows checkouts much slower than Unix.
 
@@ -104,6 +104,73 @@ do {                                                    \
   SVN_ERR(svn_mutex__unlock(svn_mutex__m, (expr)));     \
 } while (0)
 
+/** Record lock statistics for @a mutex under @a name, which must remain
+ * valid for the lifetime of @a mutex.  Mutexes with the same name share
+ * a single statistics entry.  No-op if @a mutex is NULL.
+ *
+ * Statistics will only be collected after svn_mutex__enable_stats().
+ */
+void
+svn_mutex__set_name(svn_mutex__t *mutex,
+                    const char *name);
+
+/** Lock contention statistics, aggregated over all locks of the same
+ * name.  All times are in microseconds.
+ */
+typedef struct svn_mutex__stats_t
+{
+  /** Name of the lock(s). */
+  const char *name;
+
+  /** Number of times the lock got acquired, total and longest time spent
+   * waiting for it. */
+  apr_uint64_t acquisitions;
+  apr_interval_time_t total_wait;
+  apr_interval_time_t max_wait;
+
+  /** Number of times the lock got released, total and longest time it
+   * had been held.  May differ from the acquisition numbers where only
+   * wait times can be determined, e.g. for shared locks. */
+  apr_uint64_t releases;
+  apr_interval_time_t total_hold;
+  apr_interval_time_t max_hold;
+} svn_mutex__stats_t;
+
+/** Start collecting lock statistics in this process.  There is some
+ * overhead for every named lock from then on.  This cannot be undone.
+ * Use @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_mutex__enable_stats(apr_pool_t *scratch_pool);
+
+/** Return TRUE, if lock statistics are being collected.
+ */
+svn_boolean_t
+svn_mutex__stats_enabled(void);
+
+/** Record that the lock @a name has been waited for @a wait microseconds
+ * before it got acquired.  Use this for locks other than #svn_mutex__t.
+ * No-op unless lock statistics are being collected.
+ */
+void
+svn_mutex__stats_add_wait(const char *name,
+                          apr_interval_time_t wait);
+
+/** Record that the lock @a name has been held for @a hold microseconds.
+ * No-op unless lock statistics are being collected.
+ */
+void
+svn_mutex__stats_add_hold(const char *name,
+                          apr_interval_time_t hold);
+
+/** Set @a *stats to an array of #svn_mutex__stats_t with the statistics
+ * of all locks that have been recorded so far, sorted by name.  Allocate
+ * the result in @a result_pool.
+ */
+svn_error_t *
+svn_mutex__get_stats(apr_array_header_t **stats,
+                     apr_pool_t *result_pool);
+
 #if APR_HAS_THREADS
 
 /** Return the APR mutex encapsulated in @a mutex.
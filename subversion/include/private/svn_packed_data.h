@@ -26,6 +26,8 @@
 #include "svn_string.h"
 #include "svn_io.h"
 
+#include "private/svn_subr_private.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -63,8 +65,9 @@ extern "C" {
  * When all data has been added to the stream, it can be written to an
  * ordinary svn_stream_t.  First, we write a description of the stream
  * structure (types, sub-streams, sizes and configurations) followed by
- * zlib compressed stream content.  For each top-level stream, all sub-
- * stream data will be concatenated and then compressed as a single block.
+ * zlib (or zstd, see svn_packed__compression_t) compressed stream
+ * content.  For each top-level stream, all sub-stream data will be
+ * concatenated and then compressed as a single block.
  * To maximize the effect of this, make sure all data in that stream
  * hierarchy has a similar value distribution.
  *
@@ -175,6 +178,36 @@ svn_packed__data_write(svn_stream_t *stream,
                        svn_packed__data_root_t *root,
                        apr_pool_t *scratch_pool);
 
+/* Optional compression settings for svn_packed__data_write2 and
+ * svn_packed__data_read2.
+ */
+typedef struct svn_packed__compression_t
+{
+  /* If not NULL, compress streams with zstd using this dictionary.
+   * Otherwise, use zlib. */
+  const svn__compress_dict_t *dict;
+
+  /* If not NULL, the writer appends a copy of every uncompressed stream,
+   * allocated in the array's pool, as svn_stringbuf_t * to this array.
+   * Use that to train a dictionary with svn__compress_dict_train(). */
+  apr_array_header_t *samples;
+
+  /* Total size of all SAMPLES.  Updated by the writer. */
+  apr_size_t *samples_size;
+
+  /* Stop adding to SAMPLES once *SAMPLES_SIZE exceeds this. */
+  apr_size_t max_samples_size;
+} svn_packed__compression_t;
+
+/* Like svn_packed__data_write but use the settings in COMPRESSION.
+ * COMPRESSION may be NULL.
+ */
+svn_error_t *
+svn_packed__data_write2(svn_stream_t *stream,
+                        svn_packed__data_root_t *root,
+                        const svn_packed__compression_t *compression,
+                        apr_pool_t *scratch_pool);
+
 
 /* Reading data. */
 
@@ -253,6 +286,17 @@ svn_packed__data_read(svn_packed__data_root_t **root_p,
                       apr_pool_t *result_pool,
                       apr_pool_t *scratch_pool);
 
+/* Like svn_packed__data_read but also read data that has been written
+ * with a zstd dictionary.  COMPRESSION must provide the same dictionary
+ * then and may be NULL otherwise.
+ */
+svn_error_t *
+svn_packed__data_read2(svn_packed__data_root_t **root_p,
+                       svn_stream_t *stream,
+                       const svn_packed__compression_t *compression,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,70 @@
+/* svn_probes.h : statically defined tracing probes
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_PROBES_H
+#define SVN_PROBES_H
+
+#include "svn_private_config.h"
+
+/* Statically defined tracing (USDT) probes for the "svn" provider.
+ *
+ * When configured with --enable-sdt-probes, every SVN_PROBE* invocation
+ * places a probe point into the binary that tools like bpftrace, perf,
+ * SystemTap and DTrace can attach to at run-time, e.g.
+ *
+ *    bpftrace -e 'usdt:/usr/lib/libsvn_fs_fs-1.so:svn:fsfs__block_read__start
+ *                 { @start[tid] = nsecs; } ...'
+ *
+ * An unused probe is a single NOP instruction.  Otherwise, the macros
+ * expand to nothing and their arguments will not be evaluated; they must
+ * therefore not have side effects.
+ *
+ * Probes come in pairs named "<area>__<operation>__start" and
+ * "<area>__<operation>__done" where latencies are of interest.  Arguments
+ * should be integers or pointers; strings must be NUL-terminated.
+ */
+#ifdef SVN_HAVE_SDT_PROBES
+
+#include <sys/sdt.h>
+
+#define SVN_PROBE0(name) \
+  DTRACE_PROBE(svn, name)
+#define SVN_PROBE1(name, a1) \
+  DTRACE_PROBE1(svn, name, a1)
+#define SVN_PROBE2(name, a1, a2) \
+  DTRACE_PROBE2(svn, name, a1, a2)
+#define SVN_PROBE3(name, a1, a2, a3) \
+  DTRACE_PROBE3(svn, name, a1, a2, a3)
+#define SVN_PROBE4(name, a1, a2, a3, a4) \
+  DTRACE_PROBE4(svn, name, a1, a2, a3, a4)
+
+#else
+
+#define SVN_PROBE0(name) ((void)0)
+#define SVN_PROBE1(name, a1) ((void)0)
+#define SVN_PROBE2(name, a1, a2) ((void)0)
+#define SVN_PROBE3(name, a1, a2, a3) ((void)0)
+#define SVN_PROBE4(name, a1, a2, a3, a4) ((void)0)
+
+#endif /* SVN_HAVE_SDT_PROBES */
+
+#endif /* SVN_PROBES_H */
@@ -83,7 +83,47 @@ svn_ra__assert_capable_server(svn_ra_session_t *ra_session,
                               const char *path_or_url,
                               apr_pool_t *pool);
 
+/* Return TRUE if an operation on SESSION that streams its response,
+   such as svn_ra_get_log2() or driving the reporter of
+   svn_ra_do_update3(), failed or was cancelled.  Such a session may be in
+   the middle of a response and must not be used for other operations. */
+svn_boolean_t
+svn_ra__session_failed(svn_ra_session_t *session);
+
 
+/*** History Cache ***/
+
+/* Return TRUE if SESSION keeps the parts of the repository history that
+   can't change in a history cache (see the [miscellany]
+   history-cache-directory option). */
+svn_boolean_t
+svn_ra__has_history_cache(svn_ra_session_t *session);
+
+/* Set *CONTENTS_P to the entry of the history cache of SESSION for the
+   query KIND with PARAMS about the session URL of SESSION, allocated in
+   RESULT_POOL.  Set *CONTENTS_P to NULL if there is no such entry, if
+   SESSION has no history cache or if the cache doesn't work. */
+svn_error_t *
+svn_ra__get_cached_history(svn_stringbuf_t **contents_p,
+                           svn_ra_session_t *session,
+                           const char *kind,
+                           const char *params,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool);
+
+/* Store CONTENTS as the entry of the history cache of SESSION for the
+   query KIND with PARAMS about the session URL of SESSION, replacing any
+   earlier entry.  The answer must not depend on anything that can change
+   in the repository, such as revision properties.  Do nothing if SESSION
+   has no history cache, and ignore problems with the cache. */
+svn_error_t *
+svn_ra__set_cached_history(svn_ra_session_t *session,
+                           const char *kind,
+                           const char *params,
+                           const svn_stringbuf_t *contents,
+                           apr_pool_t *scratch_pool);
+
+
 /*** Operational Locks ***/
 
 /** This is a function type which allows svn_ra__get_operational_lock()
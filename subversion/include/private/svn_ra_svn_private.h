@@ -129,11 +129,41 @@ svn_ra_svn__set_capabilities(svn_ra_svn_conn_t *conn,
 
 
 /**
- * Set the shim callbacks to be used by @a conn to @a shim_callbacks.
+ * If @a enable is set, let @a conn pick the svndiff version and
+ * compression level based on the throughput measured while sending data.
+ * The configured compression level remains the default until the first
+ * measurement is available.  Level 0 always disables compression.
  */
-svn_error_t *
-svn_ra_svn__set_shim_callbacks(svn_ra_svn_conn_t *conn,
-                               svn_delta_shim_callbacks_t *shim_callbacks);
+void
+svn_ra_svn__set_adaptive_compression(svn_ra_svn_conn_t *conn,
+                                     svn_boolean_t enable);
+
+/**
+ * Return the compression level to use when sending deltas over @a conn.
+ * Unless adaptive compression is enabled, that is the level @a conn has
+ * been created with.
+ */
+int
+svn_ra_svn__compression_level(svn_ra_svn_conn_t *conn);
+
+/**
+ * Return the svndiff version to use when sending deltas over @a conn.
+ * That is 2 (LZ4) if this build supports it and the other side announced
+ * #SVN_RA_SVN_CAP_SVNDIFF2_ACCEPTED, 1 (zlib) if it announced
+ * #SVN_RA_SVN_CAP_SVNDIFF1 and 0 otherwise.  Compression level 0 always
+ * selects version 0.  With adaptive compression, zlib is preferred over
+ * LZ4 on links slow enough to keep up with it.
+ */
+int
+svn_ra_svn__svndiff_version(svn_ra_svn_conn_t *conn);
+
+/**
+ * Return #SVN_RA_SVN_CAP_SVNDIFF2_ACCEPTED if this build can decode
+ * svndiff2, NULL otherwise.  Meant to be passed as an optional word
+ * to the capability list.
+ */
+const char *
+svn_ra_svn__svndiff2_capability(void);
 
 /**
  * Return the memory pool used to allocate @a conn.
@@ -360,6 +390,19 @@ svn_ra_svn__has_command(svn_boolean_t *has_command,
                         svn_ra_svn_conn_t *conn,
                         apr_pool_t *pool);
 
+/** Set @a *cmdname to the name of the last command that
+ * svn_ra_svn__handle_command() accepted on @a conn, or to @c NULL if it
+ * was not found in the command table.  Set @a *started to the time its
+ * handler was called.  Set @a *bytes_in and @a *bytes_out to the number
+ * of bytes received and sent on @a conn since the command was read.
+ */
+void
+svn_ra_svn__get_command_info(const char **cmdname,
+                             apr_time_t *started,
+                             apr_uint64_t *bytes_in,
+                             apr_uint64_t *bytes_out,
+                             svn_ra_svn_conn_t *conn);
+
 /** Accept a single command from @a conn and handle them according
  * to @a cmd_hash.  Command handlers will be passed @a conn, @a pool,
  * the parameters of the command, and @a baton.  @a *terminate will be
@@ -396,6 +439,21 @@ svn_ra_svn__handle_commands2(svn_ra_svn_conn_t *conn,
                              void *baton,
                              svn_boolean_t error_on_disconnect);
 
+/** Handle the commands of a "batch" command received over @a conn, with
+ * @a params being the parameters of that command.  Run them in order
+ * according to @a commands, passing @a baton to the handlers, and write
+ * exactly one response per command.  Commands that are not found in
+ * @a commands and errors wrapped in SVN_RA_SVN_CMD_ERR are reported as
+ * failure responses; any other kind of error is passed through to the
+ * caller.  Use @a pool for temporary allocations.
+ */
+svn_error_t *
+svn_ra_svn__handle_batch(svn_ra_svn_conn_t *conn,
+                         apr_pool_t *pool,
+                         svn_ra_svn__list_t *params,
+                         const svn_ra_svn__cmd_entry_t *commands,
+                         void *baton);
+
 /** Write a successful command response over the network, using the
  * same format string notation as svn_ra_svn_write_tuple().  Do not use
  * partial tuples with this function; if you need to use partial
@@ -847,6 +905,23 @@ svn_ra_svn__write_cmd_stat(svn_ra_svn_conn_t *conn,
                            const char *path,
                            svn_revnum_t rev);
 
+/** Start a "batch" command over connection @a conn.  The commands
+ * written until svn_ra_svn__write_cmd_batch_end() is called become part
+ * of the batch; the server sends one response for each of them, in order.
+ * Use @a pool for allocations.
+ */
+svn_error_t *
+svn_ra_svn__write_cmd_batch_start(svn_ra_svn_conn_t *conn,
+                                  apr_pool_t *pool);
+
+/** Finish a "batch" command started with
+ * svn_ra_svn__write_cmd_batch_start() over connection @a conn.
+ * Use @a pool for allocations.
+ */
+svn_error_t *
+svn_ra_svn__write_cmd_batch_end(svn_ra_svn_conn_t *conn,
+                                apr_pool_t *pool);
+
 /** Send a "get-file-revs" command over connection @a conn.
  * Use @a pool for allocations.
  *
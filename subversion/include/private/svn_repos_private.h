@@ -96,6 +96,43 @@ const char *
 svn_repos__post_commit_error_str(svn_error_t *err,
                                  apr_pool_t *pool);
 
+/* Callback reporting the failure ERR of an asynchronously executed hook.
+ * It gets called from the hook worker threads and must be thread-safe.
+ * ERR will be cleared by the caller.
+ */
+typedef void (*svn_repos__hook_error_func_t)(void *baton,
+                                             svn_error_t *err);
+
+/* Make the post-commit, post-revprop-change, post-lock and post-unlock
+ * hooks of all repositories opened by this process run asynchronously.
+ *
+ * Instead of waiting for such a hook to finish, queue it for one of
+ * THREAD_COUNT worker threads and return immediately.  Once
+ * MAX_QUEUE_DEPTH hooks are waiting for a worker, further hook
+ * invocations block until a queue slot becomes available.  Failures of
+ * queued hooks are not reported to the caller that triggered them but
+ * to ERROR_FUNC with ERROR_BATON instead.
+ *
+ * The workers will run until POOL gets cleaned up, at which point all
+ * hooks still queued are being executed before the cleanup returns.
+ * This function must be called at most once per process and before any
+ * hook gets triggered.  Without APR thread support, return
+ * SVN_ERR_UNSUPPORTED_FEATURE.
+ */
+svn_error_t *
+svn_repos__hooks_async_init(int thread_count,
+                            apr_size_t max_queue_depth,
+                            svn_repos__hook_error_func_t error_func,
+                            void *error_baton,
+                            apr_pool_t *pool);
+
+/* Set *DEPTH to the number of asynchronous hook invocations that are
+ * waiting for a worker thread.  Set it to 0 if hooks are being run
+ * synchronously.
+ */
+svn_error_t *
+svn_repos__hooks_async_queue_depth(apr_size_t *depth);
+
 /* A repos version of svn_fs_type */
 svn_error_t *
 svn_repos__fs_type(const char **fs_type,
@@ -127,6 +164,84 @@ svn_repos__replay_ev2(svn_fs_root_t *root,
                       void *authz_read_baton,
                       apr_pool_t *scratch_pool);
 
+/* Like svn_repos_replay2(), but stream the editor drive for ROOT, a
+ * revision root of REPOS, from an on-disk cache in REPOS when possible.
+ *
+ * Only replays of the whole tree, i.e. with an empty BASE_DIR and no
+ * LOW_WATER_MARK above 0, are cached.  The first such replay of a
+ * revision records the unfiltered editor drive together with the paths
+ * whose readability it depends on.  Later replays check these paths with
+ * AUTHZ_READ_FUNC and AUTHZ_READ_BATON and play back the recorded drive
+ * if all of them are readable.  Otherwise, and whenever the cache cannot
+ * be used, fall back to svn_repos_replay2().
+ */
+svn_error_t *
+svn_repos__replay_cached(svn_repos_t *repos,
+                         svn_fs_root_t *root,
+                         const char *base_dir,
+                         svn_revnum_t low_water_mark,
+                         svn_boolean_t send_deltas,
+                         const svn_delta_editor_t *editor,
+                         void *edit_baton,
+                         svn_repos_authz_func_t authz_read_func,
+                         void *authz_read_baton,
+                         apr_pool_t *pool);
+
+/* Like svn_repos_node_location_segments(), but take the segments older
+ * than the youngest copy of PATH@PEG_REVISION from an on-disk cache in
+ * REPOS.  The cache gets filled on demand.  The result is the same,
+ * including the effect of AUTHZ_READ_FUNC and AUTHZ_READ_BATON.
+ */
+svn_error_t *
+svn_repos__node_location_segments_cached(
+                               svn_repos_t *repos,
+                               const char *path,
+                               svn_revnum_t peg_revision,
+                               svn_revnum_t start_rev,
+                               svn_revnum_t end_rev,
+                               svn_location_segment_receiver_t receiver,
+                               void *receiver_baton,
+                               svn_repos_authz_func_t authz_read_func,
+                               void *authz_read_baton,
+                               apr_pool_t *pool);
+
+/* Let the report baton REPORT_BATON, returned by svn_repos_begin_report3(),
+ * compute the text deltas of up to COUNT files ahead of the editor drive
+ * on a few worker threads.  The deltas are buffered in memory until the
+ * editor gets to the respective file.  This allows the editor to send
+ * data while the next deltas are being computed.  A COUNT of 0 disables
+ * the feature, which is also the default.  Only has an effect on reports
+ * with text deltas and if threads are supported.
+ */
+void
+svn_repos__report_prefetch_deltas(void *report_baton,
+                                  int count);
+
+/* Let the report baton REPORT_BATON, returned by svn_repos_begin_report3(),
+ * send the contents of added files as plain fulltext windows if
+ * SEND_FULLTEXTS is set.  This saves computing self-deltas when the
+ * editor applies the windows right away instead of sending them over
+ * the wire, e.g. for file:// URLs.  The default is not to send fulltexts.
+ * Only has an effect on reports with text deltas.
+ */
+void
+svn_repos__report_send_fulltexts(void *report_baton,
+                                 svn_boolean_t send_fulltexts);
+
+/* Like svn_repos_fs_commit_txn() but also return the total time spent
+ * running the pre-commit and post-commit hooks in *HOOKS_TIME and the
+ * time spent in svn_fs_commit_txn() in *FS_TIME.  Either may be NULL.
+ * The times are set even if an error is returned.
+ */
+svn_error_t *
+svn_repos__fs_commit_txn_timed(const char **conflict_p,
+                               svn_repos_t *repos,
+                               svn_revnum_t *new_rev,
+                               svn_fs_txn_t *txn,
+                               apr_interval_time_t *hooks_time,
+                               apr_interval_time_t *fs_time,
+                               apr_pool_t *pool);
+
 /* Given a PATH which might be a relative repo URL (^/), an absolute
  * local repo URL (file://), an absolute path outside of the repo
  * or a location in the Windows registry.
@@ -258,7 +373,10 @@ svn_repos__authz_pool_create(svn_repos__authz_pool_t **authz_pool,
  * authorization specified by PATH and GROUPS_PATH.  If these are URLs,
  * we read the data from a local repository (see #svn_repos_authz_read2).
  * AUTHZ_POOL will store the authz data and make further callers use the
- * same instance if the content matches.
+ * same instance if the content matches.  The rules compiled per user get
+ * stored in the global membuffer cache, so other authz pools reading the
+ * same contents - in other processes as well, if that cache has been put
+ * into shared memory - don't need to compile them again.
  *
  * If MUST_EXIST is TRUE, a missing config file is also an error, *AUTHZ_P
  * is otherwise simply NULL.
@@ -283,6 +401,55 @@ svn_repos__authz_pool_get(svn_authz_t **authz_p,
 
 /** @} */
 
+/**
+ * @defgroup svn_authz_batch Batched authz callbacks
+ * @{
+ */
+
+/* Batched form of svn_repos_authz_func_t: set ALLOWED[i] to TRUE if the
+ * i-th element of PATHS, an array of const char * fspaths in ROOT, is
+ * readable according to BATON.  PATHS will be sorted by
+ * svn_path_compare_paths().  Use POOL for temporary allocations only.
+ */
+typedef svn_error_t *(*svn_repos__authz_batch_func_t)(
+  svn_boolean_t *allowed,
+  svn_fs_root_t *root,
+  const apr_array_header_t *paths,
+  void *baton,
+  apr_pool_t *pool);
+
+/* Set *AUTHZ_FUNC and *AUTHZ_BATON to a read authorization callback that
+ * checks single paths with AUTHZ_READ_FUNC and BATON but lets functions
+ * in this library that check many paths at once, like svn_repos_replay2
+ * and the log functions, use BATCH_FUNC with BATON instead.  Both
+ * callbacks must give the same answers.  If AUTHZ_READ_FUNC is NULL, set
+ * *AUTHZ_FUNC to NULL as well.  Allocate the result in RESULT_POOL.
+ */
+void
+svn_repos__authz_batch_wrap(svn_repos_authz_func_t *authz_func,
+                            void **authz_baton,
+                            svn_repos_authz_func_t authz_read_func,
+                            svn_repos__authz_batch_func_t batch_func,
+                            void *baton,
+                            apr_pool_t *result_pool);
+
+/* Set ALLOWED[i] to TRUE if the i-th element of PATHS, an array of
+ * const char * fspaths in ROOT, is readable according to AUTHZ_READ_FUNC
+ * and AUTHZ_READ_BATON.  If these have been created by
+ * svn_repos__authz_batch_wrap, check all paths with a single call to the
+ * batch callback.  AUTHZ_READ_FUNC must not be NULL.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_repos__authz_read_paths(svn_boolean_t *allowed,
+                            svn_fs_root_t *root,
+                            const apr_array_header_t *paths,
+                            svn_repos_authz_func_t authz_read_func,
+                            void *authz_read_baton,
+                            apr_pool_t *scratch_pool);
+
+/** @} */
+
 /* Adjust mergeinfo paths and revisions in ways that are useful when loading
  * a dump stream.
  *
@@ -96,6 +96,16 @@ svn_sqlite__insert(apr_int64_t *row_id, svn_sqlite__stmt_t *stmt);
 svn_error_t *
 svn_sqlite__update(int *affected_rows, svn_sqlite__stmt_t *stmt);
 
+/* Return the number of rows inserted, updated or deleted through DB since
+   it has been opened, including rows changed by triggers and changes
+   that have been rolled back. */
+int
+svn_sqlite__total_changes(svn_sqlite__db_t *db);
+
+/* Return TRUE if a transaction or savepoint is in progress on DB. */
+svn_boolean_t
+svn_sqlite__in_transaction(svn_sqlite__db_t *db);
+
 /* Return in *VERSION the version of the schema in DB. Use SCRATCH_POOL
    for temporary allocations.  */
 svn_error_t *
@@ -129,6 +139,25 @@ svn_sqlite__open(svn_sqlite__db_t **db, const char *path,
                  apr_int32_t timeout,
                  apr_pool_t *result_pool, apr_pool_t *scratch_pool);
 
+/* Adjust the settings of the connection in DB.  Set the page cache of
+   the connection to CACHE_SIZE kibibytes and the maximum number of bytes
+   of the database file that may be accessed using memory mapped I/O to
+   MMAP_SIZE.  Negative values keep the SQLite defaults.
+
+   If WAL is TRUE, switch the database to write-ahead logging, which lets
+   readers proceed while a writer is active but requires that all users of
+   the database are on the same host.  Otherwise switch it back to the
+   rollback journal used by svn_sqlite__open().  The journal mode is
+   persistent; it is left unchanged if SQLite can't switch it.
+
+   Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_sqlite__tune(svn_sqlite__db_t *db,
+                 apr_int64_t cache_size,
+                 apr_int64_t mmap_size,
+                 svn_boolean_t wal,
+                 apr_pool_t *scratch_pool);
+
 /* Explicitly close the connection in DB. */
 svn_error_t *
 svn_sqlite__close(svn_sqlite__db_t *db);
@@ -316,6 +316,40 @@ svn__fnv1a_32(const void *input, apr_size_t len);
 apr_uint32_t
 svn__fnv1a_32x4(const void *input, apr_size_t len);
 
+/**
+ * Opaque context for calculating MD5 and SHA-1 checksums over the same
+ * data in a single pass.
+ */
+typedef struct svn_checksum__md5_sha1_ctx_t svn_checksum__md5_sha1_ctx_t;
+
+/**
+ * Return a new context for calculating both, MD5 and SHA-1 checksums.
+ * Allocate it in @a pool.
+ */
+svn_checksum__md5_sha1_ctx_t *
+svn_checksum__md5_sha1_ctx_create(apr_pool_t *pool);
+
+/**
+ * Feed the first @a len bytes of @a data into @a ctx.  This is faster
+ * than feeding the same data into separate MD5 and SHA-1 contexts as
+ * it reads @a data from memory only once.
+ */
+svn_error_t *
+svn_checksum__md5_sha1_update(svn_checksum__md5_sha1_ctx_t *ctx,
+                              const void *data,
+                              apr_size_t len);
+
+/**
+ * Finalize the checksums in @a ctx and return them in @a *md5 and
+ * @a *sha1, allocated in @a pool.  Either may be NULL if the respective
+ * checksum is not needed.
+ */
+svn_error_t *
+svn_checksum__md5_sha1_final(svn_checksum_t **md5,
+                             svn_checksum_t **sha1,
+                             const svn_checksum__md5_sha1_ctx_t *ctx,
+                             apr_pool_t *pool);
+
 /** @} */
 
 
@@ -428,6 +462,26 @@ svn_hash__read_entry(svn_hash__entry_t *entry,
                      svn_boolean_t incremental,
                      apr_pool_t *pool);
 
+/** Parse the serialized hash in @a data of @a len bytes, as written by
+ * svn_hash_write2() with @a terminator, and add its entries to @a hash.
+ * If @a terminator is #NULL, the hash ends with the buffer.  Data after
+ * the terminator line is ignored.
+ *
+ * This is equivalent to svn_hash_read2() on a stream over @a data but
+ * parses the buffer in place:  The keys and #svn_string_t values put into
+ * @a hash point into @a data, which gets modified and must remain valid
+ * for as long as @a hash is being used.  @a pool is used only for the
+ * value structs and for the hash entries.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_hash__parse(apr_hash_t *hash,
+                char *data,
+                apr_size_t len,
+                const char *terminator,
+                apr_pool_t *pool);
+
 /** @} */
 
 /** @} */
@@ -505,6 +559,9 @@ svn_version__at_least(svn_version_t *version,
 /* Slowest, best compression method & level provided by zlib. */
 #define SVN__COMPRESSION_ZLIB_MAX     9
 
+/* Default compression level for svn__compress_zstd. */
+#define SVN__COMPRESSION_ZSTD_DEFAULT 3
+
 /* Encode VAL into the buffer P using the variable-length 7b/8b unsigned
    integer format.  Return the incremented value of P after the
    encoded bytes have been written.  P must point to a buffer of size
@@ -573,6 +630,87 @@ svn__decompress(const void *data, apr_size_t len,
                 svn_stringbuf_t *out,
                 apr_size_t limit);
 
+/* Compress the data from DATA with length LEN using LZ4 and write the
+ * result to OUT.  The framing is the same as for svn__compress: the
+ * original length followed by either the compressed or, if that would
+ * not be shorter, the verbatim data.
+ *
+ * Return SVN_ERR_BAD_COMPRESSION_METHOD if this build has no LZ4 support.
+ * Use svn_lz4__compiled_version() to check for that beforehand.
+ */
+svn_error_t *
+svn__compress_lz4(const void *data, apr_size_t len,
+                  svn_stringbuf_t *out);
+
+/* Decompress the LZ4 compressed data from DATA with length LEN and write
+ * the result to OUT.  Return an error if the decompressed size is larger
+ * than LIMIT or if this build has no LZ4 support.
+ */
+svn_error_t *
+svn__decompress_lz4(const void *data, apr_size_t len,
+                    svn_stringbuf_t *out,
+                    apr_size_t limit);
+
+/* Opaque zstd compression dictionary.  Once created, it may be used by
+ * multiple threads concurrently.
+ */
+typedef struct svn__compress_dict_t svn__compress_dict_t;
+
+/* Create a compression dictionary from the LEN bytes at DATA, e.g. as
+ * returned by svn__compress_dict_train(), and return it in *DICT_P.
+ * Data compressed with it will use COMPRESSION_LEVEL.  All data and
+ * zstd structures are owned by RESULT_POOL.
+ *
+ * Return SVN_ERR_BAD_COMPRESSION_METHOD if this build has no zstd support.
+ * Use svn_zstd__compiled_version() to check for that beforehand.
+ */
+svn_error_t *
+svn__compress_dict_create(svn__compress_dict_t **dict_p,
+                          const void *data,
+                          apr_size_t len,
+                          int compression_level,
+                          apr_pool_t *result_pool);
+
+/* Train a zstd dictionary of at most MAX_SIZE bytes from SAMPLES, an
+ * array of svn_stringbuf_t *, and return it in *DICT_DATA, allocated in
+ * RESULT_POOL.  Set *DICT_DATA to NULL, if SAMPLES are not sufficient to
+ * train a dictionary.  Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn__compress_dict_train(svn_stringbuf_t **dict_data,
+                         const apr_array_header_t *samples,
+                         apr_size_t max_size,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool);
+
+/* Return the raw contents of DICT. */
+const svn_string_t *
+svn__compress_dict_data(const svn__compress_dict_t *dict);
+
+/* Compress the data from DATA with length LEN using zstd and write the
+ * result to OUT, framed like svn__compress does.  If DICT is not NULL,
+ * compress with that dictionary and its compression level; otherwise
+ * use COMPRESSION_LEVEL.
+ *
+ * Decompress the result with svn__decompress2 and the same DICT.
+ * Return SVN_ERR_BAD_COMPRESSION_METHOD if this build has no zstd support.
+ */
+svn_error_t *
+svn__compress_zstd(const void *data, apr_size_t len,
+                   svn_stringbuf_t *out,
+                   int compression_level,
+                   const svn__compress_dict_t *dict);
+
+/* Like svn__decompress but also accept data written by svn__compress_zstd.
+ * DICT must be the same dictionary used during compression or NULL if
+ * none was used.
+ */
+svn_error_t *
+svn__decompress2(const void *data, apr_size_t len,
+                 svn_stringbuf_t *out,
+                 apr_size_t limit,
+                 const svn__compress_dict_t *dict);
+
 /** @} */
 
 /**
@@ -588,13 +726,50 @@ svn__decompress(const void *data, apr_size_t len,
  */
 typedef struct svn_root_pools__t svn_root_pools__t;
 
+/* Usage statistics of a root pools container.
+ */
+typedef struct svn_root_pools__info_t
+{
+  /* Number of root pools created and number of acquisitions, of which
+   * THREAD_HITS were served from the acquiring thread's pool cache. */
+  apr_uint64_t created;
+  apr_uint64_t acquired;
+  apr_uint64_t thread_hits;
+
+  /* Number of pools currently acquired and the maximum of that. */
+  apr_uint64_t in_use;
+  apr_uint64_t max_in_use;
+
+  /* Sum and maximum of the times between acquisition and release. */
+  apr_interval_time_t total_lifetime;
+  apr_interval_time_t max_lifetime;
+
+  /* Largest amount of memory used by any released pool.  Only available
+   * with APR pool debugging; 0 otherwise. */
+  apr_size_t max_size;
+} svn_root_pools__info_t;
+
 /* Create a new root pools container and return it in *POOLS.
  */
 svn_error_t *
 svn_root_pools__create(svn_root_pools__t **pools);
 
+/* Start collecting usage statistics in POOLS.  This adds a bit of
+ * overhead to every pool acquisition and release.
+ */
+void
+svn_root_pools__enable_profiling(svn_root_pools__t *pools);
+
+/* Return the usage statistics collected for POOLS in *INFO.  All values
+ * will be 0 unless svn_root_pools__enable_profiling() has been called.
+ */
+svn_error_t *
+svn_root_pools__get_info(svn_root_pools__info_t *info,
+                         svn_root_pools__t *pools);
+
 /* Return a currently unused pool from POOLS.  If POOLS is empty, create a
  * new root pool and return that.  The pool returned is not thread-safe.
+ * Pools released by the calling thread are preferred.
  */
 apr_pool_t *
 svn_root_pools__acquire_pool(svn_root_pools__t *pools);
@@ -720,6 +895,22 @@ const char *svn_zlib__compiled_version(void);
 /* Return the zlib version we run against. */
 const char *svn_zlib__runtime_version(void);
 
+/* Return the LZ4 version we compiled against or NULL if this build
+   does not support LZ4. */
+const char *svn_lz4__compiled_version(void);
+
+/* Return the LZ4 version we run against or NULL if this build
+   does not support LZ4. */
+const char *svn_lz4__runtime_version(void);
+
+/* Return the zstd version we compiled against or NULL if this build
+   does not support zstd. */
+const char *svn_zstd__compiled_version(void);
+
+/* Return the zstd version we run against or NULL if this build
+   does not support zstd. */
+const char *svn_zstd__runtime_version(void);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
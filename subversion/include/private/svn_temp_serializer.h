@@ -212,6 +212,11 @@ svn_temp_deserializer__resolve(const void *buffer, void **ptr);
  * Similar to svn_temp_deserializer__resolve() but instead of modifying
  * the buffer content, the resulting pointer is passed back to the caller
  * as the return value.
+ *
+ * Because all pointers are stored as offsets, the serialized data is
+ * position-independent.  Using this function, partial getters can read
+ * the structures in place, e.g. inside the cache's own memory, without
+ * copying the buffer and without a fixup pass.
  */
 const void *
 svn_temp_deserializer__ptr(const void *buffer, const void *const *ptr);
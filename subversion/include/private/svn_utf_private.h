@@ -73,6 +73,12 @@ svn_utf__last_valid(const char *src, apr_size_t len);
 const char *
 svn_utf__last_valid2(const char *src, apr_size_t len);
 
+/* Return a short name of the vectorized UTF-8 validator used by
+   svn_utf__is_valid() and svn_utf__last_valid() on the current CPU, or
+   "scalar" if there is none, e.g. for diagnostic output. */
+const char *
+svn_utf__validator_implementation(void);
+
 /* Copy LENGTH bytes of SRC, converting characters as follows:
     - Pass characters from the ASCII subset to the result
     - Strip all combining marks from the string
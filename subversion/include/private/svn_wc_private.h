@@ -338,6 +338,27 @@ svn_wc__is_wcroot(svn_boolean_t *is_wcroot,
                   apr_pool_t *scratch_pool);
 
 
+/** Make sure that later modifications of the files at or below @a path,
+ * which lives in a working copy, will be detected even if they leave the
+ * size and timestamp of a file unchanged.
+ *
+ * The timestamps recorded for files written so recently that a change
+ * can still go unnoticed in the timestamp resolution of the filesystem
+ * get forgotten, so that these files get compared by content once.  This
+ * includes the working copies of directory externals below @a path.
+ * If that is not possible, e.g. because @a path is NULL or not part of a
+ * working copy, fall back to svn_io_sleep_for_timestamps().
+ *
+ * Call this instead of svn_io_sleep_for_timestamps() after writing files
+ * and recording their timestamps.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ */
+void
+svn_wc__settle_timestamps(svn_wc_context_t *wc_ctx,
+                          const char *path,
+                          apr_pool_t *scratch_pool);
+
 /** Set @a *wcroot_abspath to the local abspath of the root of the
  * working copy in which @a local_abspath resides.
  */
@@ -999,6 +1020,51 @@ svn_wc__get_pristine_contents_by_checksum(svn_stream_t **contents,
                                           apr_pool_t *result_pool,
                                           apr_pool_t *scratch_pool);
 
+/* The text delta of a file to commit, computed ahead of its transmission
+   by svn_wc__compute_text_delta(). */
+typedef struct svn_wc__text_delta_t svn_wc__text_delta_t;
+
+/* Start the work of svn_wc_transmit_text_deltas3() for the file at
+   LOCAL_ABSPATH and FULLTEXT by opening what svn_wc__compute_text_delta()
+   reads, and return the state in *DELTA, allocated in RESULT_POOL.  This
+   is the only step that accesses the working copy database.
+ */
+svn_error_t *
+svn_wc__prepare_text_delta(svn_wc__text_delta_t **delta,
+                           svn_wc_context_t *wc_ctx,
+                           const char *local_abspath,
+                           svn_boolean_t fulltext,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool);
+
+/* Translate the working file of DELTA to normal form, checksum it, copy it
+   to a new pristine and compute its text delta against the pristine text,
+   spooling the delta to a temporary file.  Verify the checksum of the
+   pristine text as well.
+
+   This doesn't use the working copy context DELTA was prepared with, so
+   it may run in another thread than the one owning that context, as long
+   as no other thread uses the pool DELTA was allocated in meanwhile.
+ */
+svn_error_t *
+svn_wc__compute_text_delta(svn_wc__text_delta_t *delta,
+                           apr_pool_t *scratch_pool);
+
+/* Finish the work of svn_wc_transmit_text_deltas3() for DELTA, which was
+   computed by svn_wc__compute_text_delta(), by sending it to EDITOR and
+   closing FILE_BATON.  Install the new pristine text and set
+   *NEW_TEXT_BASE_MD5_CHECKSUM and *NEW_TEXT_BASE_SHA1_CHECKSUM as that
+   function does.
+ */
+svn_error_t *
+svn_wc__send_text_delta(const svn_checksum_t **new_text_base_md5_checksum,
+                        const svn_checksum_t **new_text_base_sha1_checksum,
+                        svn_wc__text_delta_t *delta,
+                        const svn_delta_editor_t *editor,
+                        void *file_baton,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool);
+
 /* Gets an array of const char *repos_relpaths of descendants of LOCAL_ABSPATH,
  * which must be the op root of an addition, copy or move. The descendants
  * returned are at the same op_depth, but are to be deleted by the commit
@@ -1447,6 +1513,12 @@ svn_wc__get_status_editor(const svn_delta_editor_t **editor,
  * empty directory, and so bypass a number of conflict checks that are
  * unnecessary in this case.
  *
+ * If @a lazy_files is TRUE, files that are added by the edit and have no
+ * local node or obstruction are not installed; they are recorded as
+ * excluded (#svn_depth_exclude) BASE nodes instead.  Their content can be
+ * brought in later by updating them with a sticky depth of
+ * #svn_depth_infinity.  Directories are added as usual.
+ *
  * If @a fetch_dirents_func is not NULL, the update editor may call this
  * callback, when asked to perform a depth restricted update. It will do this
  * before returning the editor to allow using the primary ra session for this.
@@ -1468,6 +1540,7 @@ svn_wc__get_update_editor(const svn_delta_editor_t **editor,
                           svn_boolean_t adds_as_modification,
                           svn_boolean_t server_performs_filtering,
                           svn_boolean_t clean_checkout,
+                          svn_boolean_t lazy_files,
                           const char *diff3_cmd,
                           const apr_array_header_t *preserved_exts,
                           svn_wc_dirents_func_t fetch_dirents_func,
@@ -529,6 +529,10 @@ typedef svn_error_t *(*svn_auth_plaintext_passphrase_prompt_func_t)(
  * and intentionally ordered.  These pointers will be stored within @a
  * *auth_baton, grouped by credential type, and searched in this exact
  * order.
+ *
+ * Asking for, saving and forgetting credentials is serialized for
+ * @a *auth_baton and the per-session batons made from it, so several
+ * threads may use them at the same time.  (Since 1.10.)
  */
 void
 svn_auth_open(svn_auth_baton_t **auth_baton,
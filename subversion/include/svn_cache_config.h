@@ -73,7 +73,9 @@ svn_cache_config_get(void);
 
 /** Set the cache configuration. Please note that it may not change
    the actual configuration *in use*. Therefore, call it before reading
-   data from any repo and call it only once.
+   data from any repo and call it only once.  Only the cache size may
+   be changed later, and only within the capacity that has been reserved
+   for the cache upon its creation.
 
    This function is not thread-safe. Therefore, it should be called
    from the processes' initialization code only.
@@ -1045,6 +1045,17 @@ typedef struct svn_client_ctx_t
    * @since New in 1.9.
    */
   void *tunnel_baton;
+
+  /** An identifier passed to the server by RA sessions opened for this
+   * context, see svn_ra_callbacks2_t.trace_id.  Initialized to a new
+   * UUID by svn_client_create_context2(); clients that run several
+   * operations on one context may set a new one for each of them.
+   * Sessions the context keeps for reuse are only reused by operations
+   * with the same trace id, since the server learns it when a session
+   * is opened.
+   * @since New in 1.10.
+   */
+  const char *trace_id;
 } svn_client_ctx_t;
 
 /** Initialize a client context.
@@ -1202,6 +1213,11 @@ svn_client_args_to_target_array(apr_array_header_t **targets_p,
  *              set equal to the base properties. <br>
  *              If @c FALSE, then abort if there are any unversioned
  *              obstructing items.
+ * @param[in] lazy_files  If @c TRUE, create all directories of the
+ *              checkout, but register its files as excluded nodes without
+ *              fetching their content.  A file is installed by updating it
+ *              with @a depth #svn_depth_infinity and @a depth_is_sticky set,
+ *              e.g. 'svn update --set-depth infinity FILE'.
  * @param[in] ctx   The standard client context, used for authentication and
  *              notification.
  * @param[in] pool  Used for any temporary allocation.
@@ -1216,12 +1232,34 @@ svn_client_args_to_target_array(apr_array_header_t **targets_p,
  *         #svn_opt_revision_date. <br>
  *         If no error occurred, return #SVN_NO_ERROR.
  *
- * @since New in 1.5.
+ * @since New in 1.10.
  *
  * @see #svn_depth_t <br> #svn_client_ctx_t <br> @ref clnt_revisions for
  *      a discussion of operative and peg revisions.
  */
 svn_error_t *
+svn_client_checkout4(svn_revnum_t *result_rev,
+                     const char *URL,
+                     const char *path,
+                     const svn_opt_revision_t *peg_revision,
+                     const svn_opt_revision_t *revision,
+                     svn_depth_t depth,
+                     svn_boolean_t ignore_externals,
+                     svn_boolean_t allow_unver_obstructions,
+                     svn_boolean_t lazy_files,
+                     svn_client_ctx_t *ctx,
+                     apr_pool_t *pool);
+
+
+/**
+ * Similar to svn_client_checkout4() but with @a lazy_files always set
+ * to FALSE.
+ *
+ * @since New in 1.5.
+ * @deprecated Provided for backward compatibility with the 1.9 API.
+ */
+SVN_DEPRECATED
+svn_error_t *
 svn_client_checkout3(svn_revnum_t *result_rev,
                      const char *URL,
                      const char *path,
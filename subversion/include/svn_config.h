@@ -112,6 +112,12 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_OPTION_HTTP_MAX_CONNECTIONS      "http-max-connections"
 /** @since New in 1.9. */
 #define SVN_CONFIG_OPTION_HTTP_CHUNKED_REQUESTS     "http-chunked-requests"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_HTTP_HTTP2                "http-http2"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_HTTP_CACHE_DIRECTORY      "http-cache-directory"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_HTTP_CACHE_SIZE           "http-cache-size"
 
 /** @since New in 1.9. */
 #define SVN_CONFIG_OPTION_SERF_LOG_COMPONENTS       "serf-log-components"
@@ -161,6 +167,24 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_OPTION_MEMORY_CACHE_SIZE         "memory-cache-size"
 /** @since New in 1.9. */
 #define SVN_CONFIG_OPTION_DIFF_IGNORE_CONTENT_TYPE  "diff-ignore-content-type"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_EXTERNALS_JOBS            "externals-jobs"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_MERGE_JOBS                "merge-jobs"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_EXPORT_JOBS               "export-jobs"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_DIFF_JOBS                 "diff-jobs"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_COMMIT_JOBS               "commit-jobs"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_IMPORT_JOBS               "import-jobs"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_HISTORY_CACHE_DIRECTORY   "history-cache-directory"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_HISTORY_CACHE_SIZE        "history-cache-size"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_LOG_CACHE                 "log-cache"
 #define SVN_CONFIG_SECTION_TUNNELS              "tunnels"
 #define SVN_CONFIG_SECTION_AUTO_PROPS           "auto-props"
 /** @since New in 1.8. */
@@ -171,6 +195,18 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_OPTION_SQLITE_EXCLUSIVE_CLIENTS  "exclusive-locking-clients"
 /** @since New in 1.9. */
 #define SVN_CONFIG_OPTION_SQLITE_BUSY_TIMEOUT       "busy-timeout"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_NODE_CACHE                "node-cache"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_FSMONITOR_COMMAND         "fsmonitor-command"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_COMPRESS_PRISTINES        "compress-pristines"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_SQLITE_CACHE_SIZE         "sqlite-cache-size"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_SQLITE_MMAP_SIZE          "sqlite-mmap-size"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_SQLITE_WAL                "sqlite-wal"
 /** @} */
 
 /** @name Repository conf directory configuration files strings
@@ -191,6 +227,12 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_OPTION_FORCE_USERNAME_CASE       "force-username-case"
 /** @since New in 1.8. */
 #define SVN_CONFIG_OPTION_HOOKS_ENV                 "hooks-env"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_REPLAY_CACHE              "replay-cache"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_SEGMENTS_CACHE            "location-segments-cache"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_LIST_JOBS                 "list-jobs"
 /** @since New in 1.5. */
 #define SVN_CONFIG_SECTION_SASL                 "sasl"
 /** @since New in 1.5. */
@@ -235,6 +277,10 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_DEFAULT_OPTION_STORE_SSL_CLIENT_CERT_PP_PLAINTEXT \
                                                              SVN_CONFIG_ASK
 #define SVN_CONFIG_DEFAULT_OPTION_HTTP_MAX_CONNECTIONS       4
+/** @since New in 1.10. */
+#define SVN_CONFIG_DEFAULT_OPTION_HTTP_CACHE_SIZE            256
+/** @since New in 1.10. */
+#define SVN_CONFIG_DEFAULT_OPTION_HISTORY_CACHE_SIZE         64
 
 /** Read configuration information from the standard sources and merge it
  * into the hash @a *cfg_hash.  If @a config_dir is not NULL it specifies a
@@ -192,6 +192,12 @@ extern "C" {
  * @since New in 1.8.   */
 #define SVN_DAV_SUPPORTED_POSTS_HEADER "SVN-Supported-Posts"
 
+/** This header is sent by the client with every request to identify the
+ * client operation the request belongs to.  mod_dav_svn makes it
+ * available for logging as the SVN-TRACE-ID environment variable.
+ * @since New in 1.10.  */
+#define SVN_DAV_TRACE_ID_HEADER "SVN-Trace-Id"
+
 /** This header is used in the OPTIONS response to indicate if the server
  * wants bulk update requests (Prefer) or only accepts skelta requests (Off).
  * If this value is On both options are allowed.
@@ -395,6 +401,15 @@ extern "C" {
 #define SVN_DAV_NS_DAV_SVN_SVNDIFF1\
             SVN_DAV_PROP_NS_DAV "svn/svndiff1"
 
+/** Presence of this in a DAV header in an OPTIONS response indicates
+ * that the transmitter (in this case, the server) knows how to handle
+ * svndiff2 format encoding, i.e. svndiff compressed with LZ4.
+ *
+ * @since New in 1.10.
+ */
+#define SVN_DAV_NS_DAV_SVN_SVNDIFF2\
+            SVN_DAV_PROP_NS_DAV "svn/svndiff2"
+
 
 /** @} */
 
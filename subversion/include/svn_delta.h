@@ -507,6 +507,9 @@ svn_txdelta_apply(svn_stream_t *source,
  * the value to pass as the @a baton argument to @a *handler. The svndiff
  * version is @a svndiff_version. @a compression_level is the zlib
  * compression level from 0 (no compression) and 9 (maximum compression).
+ * Svndiff version 2 always compresses with LZ4 and ignores
+ * @a compression_level; it is only available if Subversion has been
+ * built with LZ4 support.
  *
  * @since New in 1.7.
  */
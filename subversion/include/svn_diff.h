@@ -455,6 +455,24 @@ typedef enum svn_diff_file_ignore_space_t
   svn_diff_file_ignore_space_all
 } svn_diff_file_ignore_space_t;
 
+/** The algorithm used to find the differences between two token sequences.
+ *
+ * @since New in 1.10.
+ */
+typedef enum svn_diff_algorithm_t
+{
+  /** Produce a minimal diff using the O(NP) algorithm by Wu, Manber and
+   * Myers.  Its runtime grows with the number of differences and may get
+   * very large for big files with many changes. */
+  svn_diff_algorithm_lcs,
+
+  /** Anchor the diff on the least frequent lines that both sides have in
+   * common and recurse into the sections between them.  The result may not
+   * be minimal but tends to follow the structure of the text more closely,
+   * and the runtime is bounded by a small multiple of the input size. */
+  svn_diff_algorithm_histogram
+} svn_diff_algorithm_t;
+
 /** Options to control the behaviour of the file diff routines.
  *
  * @since New in 1.4.
@@ -487,6 +505,12 @@ typedef struct svn_diff_file_options_t
    *
    * @since New in 1.9 */
   int context_size;
+
+  /** The algorithm used to compare the lines.  The default is
+   * @c svn_diff_algorithm_lcs.
+   *
+   * @since New in 1.10 */
+  svn_diff_algorithm_t algorithm;
 } svn_diff_file_options_t;
 
 /** Allocate a @c svn_diff_file_options_t structure in @a pool, initializing
@@ -510,6 +534,7 @@ svn_diff_file_options_create(apr_pool_t *pool);
  * - --ignore-eol-style
  * - --show-c-function, -p @since New in 1.5.
  * - --context, -U ARG @since New in 1.9.
+ * - --histogram @since New in 1.10.
  * - --unified, -u (for compatibility, does nothing).
  */
 svn_error_t *
@@ -140,12 +140,55 @@ typedef struct svn_fs_t svn_fs_t;
  */
 #define SVN_FS_CONFIG_FSFS_CACHE_NODEPROPS      "fsfs-cache-nodeprops"
 
+/** Local directory to use as a persistent second cache tier for FSFS
+ * fulltexts and combined delta windows.  This should be on fast local
+ * storage such as an SSD.  The cache is not used if this is not set.
+ *
+ * @since New in 1.10.
+ */
+#define SVN_FS_CONFIG_FSFS_CACHE_DISK_PATH      "fsfs-cache-disk-path"
+
+/** String with a decimal representation of the maximum size in bytes
+ * of the #SVN_FS_CONFIG_FSFS_CACHE_DISK_PATH cache directory.  Defaults
+ * to 16 GB.
+ *
+ * @since New in 1.10.
+ */
+#define SVN_FS_CONFIG_FSFS_CACHE_DISK_SIZE      "fsfs-cache-disk-size"
+
 /** Enable / disable the FSFS format 7 "block read" feature.
  *
  * @since New in 1.9.
  */
 #define SVN_FS_CONFIG_FSFS_BLOCK_READ           "fsfs-block-read"
 
+/** Enable / disable reading ahead in a background thread with the FSFS
+ * format 7 "block read" feature.  After each block read from disk, the
+ * following blocks of the same rev / pack file get read and put into the
+ * cache while the caller processes the current one.  This helps sequential
+ * consumers like dump or export on high-latency storage.
+ *
+ * This option only takes effect if block read is enabled as well, APR has
+ * thread support and the global membuffer cache is enabled and has been
+ * configured to be thread-safe.
+ *
+ * @since New in 1.10.
+ */
+#define SVN_FS_CONFIG_FSFS_READ_AHEAD           "fsfs-read-ahead"
+
+/** Path of an access profile to use when packing a FSFS repository.
+ *
+ * The profile lists the items read by a typical workload in the order
+ * they have been read, one "REVISION ITEM_INDEX" pair per line, e.g. as
+ * collected from the fsfs__get_contents tracing probe.  Pack will place
+ * these items in that order in front of all other items of a pack file,
+ * so that items that are read together share the same blocks.  This only
+ * applies to repositories using logical addressing.
+ *
+ * @since New in 1.10.
+ */
+#define SVN_FS_CONFIG_FSFS_PACK_ACCESS_PROFILE  "fsfs-pack-access-profile"
+
 /** String with a decimal representation of the FSFS format shard size.
  * Zero ("0") means that a repository with linear layout should be created.
  *
@@ -2293,6 +2336,24 @@ svn_fs_dir_entries(apr_hash_t **entries_p,
                    const char *path,
                    apr_pool_t *pool);
 
+/** Like svn_fs_dir_entries() but set @a *entries_p to an APR array of
+ * pointers to #svn_fs_dirent_t, sorted lexically by entry name as
+ * svn_sort__hash() with svn_sort_compare_items_lexically() would.
+ *
+ * Back-ends that keep their directories sorted return them without
+ * building and sorting a hash first, which is much cheaper for large
+ * directories.  Allocate the array and its contents in @a result_pool
+ * and use @a scratch_pool for temporaries.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_fs_dir_entries_sorted(apr_array_header_t **entries_p,
+                          svn_fs_root_t *root,
+                          const char *path,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool);
+
 /** Take the #svn_fs_dirent_t structures in @a entries as returned by
  * #svn_fs_dir_entries for @a root and determine an optimized ordering
  * in which data access would most likely be efficient.  Set @a *ordered_p
@@ -2462,6 +2523,11 @@ svn_fs_file_md5_checksum(unsigned char digest[],
  * svn_fs_file_contents().  In that case, the result of reading from
  * @a *contents is undefined.
  *
+ * Use svn_stream_skip() on @a *contents to read only a part of the file.
+ * Depending on the backend, this may be much cheaper than reading and
+ * discarding the leading part of the file.  Note that the backend may not
+ * be able to verify the checksum of the contents in that case.
+ *
  * ### @todo kff: I am worried about lifetime issues with this pool vs
  * the trail created farther down the call stack.  Trace this function
  * to investigate...
@@ -2521,6 +2587,28 @@ svn_fs_make_file(svn_fs_root_t *root,
                  const char *path,
                  apr_pool_t *pool);
 
+/** Like svn_fs_make_file() but create a new, empty file for each of the
+ * @a paths (const char *) in @a root.
+ *
+ * Adding many files one at a time updates their parent directory once
+ * per file.  Back-ends may instead update each directory only once per
+ * batch.  Sort @a paths, e.g. with svn_path_compare_paths(), so that
+ * files in the same directory are adjacent; non-adjacent siblings will
+ * still be added, just less efficiently.
+ *
+ * If any of the @a paths already exists or appears twice, return
+ * #SVN_ERR_FS_ALREADY_EXISTS.  The files up to the directory containing
+ * the offending path may have been created already in that case.
+ *
+ * Do any necessary temporary allocation in @a scratch_pool.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_fs_make_files(svn_fs_root_t *root,
+                  const apr_array_header_t *paths,
+                  apr_pool_t *scratch_pool);
+
 
 /** Apply a text delta to the file @a path in @a root.  @a root must be the
  * root of a transaction, not a revision.
@@ -3274,8 +3362,40 @@ typedef svn_error_t *(*svn_fs_pack_notify_t)(void *baton,
  * Possibly update the filesystem located in the directory @a path
  * to use disk space more efficiently.
  *
+ * Backends that support it pack up to @a jobs shards concurrently.
+ * Shards still get published and reported through @a notify_func in
+ * order and all callbacks are invoked in the caller's thread.  Each
+ * concurrent job needs its own memory for reordering the shard contents
+ * and uses the caches concurrently, i.e. those must have been
+ * configured to be thread-safe.  Values of @a jobs below 2 pack one
+ * shard after the other.
+ *
+ * @a fs_config is passed to the filesystem as if it was opened with
+ * svn_fs_open2() and may be @c NULL.
+ *
+ * If given, call @a notify_func with @a notify_baton to report progress.
+ * Use optional @a cancel_func and @a cancel_baton for cancellation support.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_fs_pack2(const char *db_path,
+             int jobs,
+             apr_hash_t *fs_config,
+             svn_fs_pack_notify_t notify_func,
+             void *notify_baton,
+             svn_cancel_func_t cancel_func,
+             void *cancel_baton,
+             apr_pool_t *pool);
+
+/**
+ * Like svn_fs_pack2(), but with @a jobs set to 1 and @a fs_config set
+ * to @c NULL.
+ *
  * @since New in 1.6.
+ * @deprecated Provided for backward compatibility with the 1.9 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_fs_pack(const char *db_path,
             svn_fs_pack_notify_t notify_func,
@@ -3284,6 +3404,37 @@ svn_fs_pack(const char *db_path,
             void *cancel_baton,
             apr_pool_t *pool);
 
+/**
+ * Add the file contents and property representations added in revisions
+ * @a start_rev to @a end_rev of @a fs to its representation cache, so
+ * that future commits can share them.  This is useful for repositories
+ * that were loaded or upgraded while representation sharing was disabled.
+ *
+ * Backends that support it read up to @a jobs revision ranges
+ * concurrently.  The cache is always written and @a progress_func is
+ * always invoked in the caller's thread.  Values of @a jobs below 2
+ * process one revision range after the other.
+ *
+ * If given, call @a progress_func with @a progress_baton for each
+ * revision after its representations have been added to the cache.
+ * Use optional @a cancel_func and @a cancel_baton for cancellation support.
+ *
+ * Return #SVN_ERR_UNSUPPORTED_FEATURE if the backend has no representation
+ * cache or representation sharing has been disabled for @a fs.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_fs_build_rep_cache(svn_fs_t *fs,
+                       svn_revnum_t start_rev,
+                       svn_revnum_t end_rev,
+                       int jobs,
+                       svn_fs_progress_notify_func_t progress_func,
+                       void *progress_baton,
+                       svn_cancel_func_t cancel_func,
+                       void *cancel_baton,
+                       apr_pool_t *pool);
+
 
 /**
  * Perform backend-specific data consistency and correctness validations
@@ -37,6 +37,7 @@
 #include "svn_types.h"
 #include "svn_string.h"
 #include "svn_delta.h"
+#include "svn_diff.h"
 #include "svn_auth.h"
 #include "svn_mergeinfo.h"
 
@@ -621,6 +622,13 @@ typedef struct svn_ra_callbacks2_t
    * @since New in 1.9.
    */
   void *tunnel_baton;
+
+  /** An identifier of the client operation, or @c NULL.  If set, the RA
+   * layer passes it to the server with every request, so that the
+   * server logs can be matched up with the client operation.
+   * @since New in 1.10.
+   */
+  const char *trace_id;
 } svn_ra_callbacks2_t;
 
 /** Similar to svn_ra_callbacks2_t, except that the progress
@@ -1188,6 +1196,51 @@ svn_ra_list(svn_ra_session_t *session,
             void *receiver_baton,
             apr_pool_t *scratch_pool);
 
+/**
+ * Callback type for use with svn_ra_blame().  The parameters have the
+ * same meaning as those of #svn_repos_blame_receiver_t.
+ *
+ * @since New in 1.10.
+ */
+typedef svn_error_t *(*svn_ra_blame_receiver_t)(void *baton,
+                                                apr_int64_t start_line,
+                                                svn_revnum_t revision,
+                                                apr_hash_t *rev_props,
+                                                apr_pool_t *scratch_pool);
+
+/**
+ * Let the server determine for each line of the file at @a path in
+ * @a end the revision that last changed it within the inclusive revision
+ * range from @a start to @a end, comparing revisions according to
+ * @a diff_options.  Report the result as ranges of lines to @a receiver
+ * with @a receiver_baton.  See svn_repos_blame() for details.
+ *
+ * This produces the same attribution as svn_ra_get_file_revs2() with
+ * @a start - 1 and @a end and without merged revisions, but without
+ * transferring all revisions of the file.  The contents of the file can
+ * be retrieved from @a end.
+ *
+ * @a path is relative to the @a session's URL.  @a start must not be
+ * greater than @a end.
+ *
+ * If the server doesn't implement it, an #SVN_ERR_RA_NOT_IMPLEMENTED or
+ * #SVN_ERR_UNSUPPORTED_FEATURE error is returned, and the caller should
+ * fall back to svn_ra_get_file_revs2().
+ *
+ * Use @a scratch_pool for temporary memory allocation.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_ra_blame(svn_ra_session_t *session,
+             const char *path,
+             svn_revnum_t start,
+             svn_revnum_t end,
+             const svn_diff_file_options_t *diff_options,
+             svn_ra_blame_receiver_t receiver,
+             void *receiver_baton,
+             apr_pool_t *scratch_pool);
+
 /**
  * Set @a *catalog to a mergeinfo catalog for the paths in @a paths.
  * If no mergeinfo is available, set @a *catalog to @c NULL.  The
@@ -1723,6 +1776,26 @@ svn_ra_stat(svn_ra_session_t *session,
             svn_dirent_t **dirent,
             apr_pool_t *pool);
 
+/**
+ * Like svn_ra_stat(), but for all the <tt>const char *</tt> paths in
+ * @a paths.  Set @a *dirents to a hash mapping each path that exists in
+ * @a revision to its @c svn_dirent_t.  Paths that don't exist are not
+ * included.
+ *
+ * Some RA layers fetch the dirents in fewer round trips than separate
+ * calls to svn_ra_stat() would take.
+ *
+ * Use @a pool for memory allocation.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_ra_stat_many(svn_ra_session_t *session,
+                 const apr_array_header_t *paths,
+                 svn_revnum_t revision,
+                 apr_hash_t **dirents,
+                 apr_pool_t *pool);
+
 
 /**
  * Set @a *uuid to the repository's UUID, allocated in @a pool.
@@ -2241,6 +2314,14 @@ svn_ra_has_capability(svn_ra_session_t *session,
  */
 #define SVN_RA_CAPABILITY_LIST "list"
 
+/**
+ * The capability of a server to calculate line attribution itself,
+ * see svn_ra_blame().
+ *
+ * @since New in 1.10.
+ */
+#define SVN_RA_CAPABILITY_BLAME "blame"
+
 
 /*       *** PLEASE READ THIS IF YOU ADD A NEW CAPABILITY ***
  *
@@ -35,6 +35,7 @@
 #include "svn_types.h"
 #include "svn_string.h"
 #include "svn_delta.h"
+#include "svn_diff.h"
 #include "svn_fs.h"
 #include "svn_io.h"
 #include "svn_mergeinfo.h"
@@ -250,7 +251,11 @@ typedef enum svn_repos_notify_action_t
   svn_repos_notify_pack_noop,
 
   /** The revision properties got set. @since New in 1.10. */
-  svn_repos_notify_load_revprop_set
+  svn_repos_notify_load_revprop_set,
+
+  /** A revision range did not change since its last successful
+   * verification and was not verified again. @since New in 1.10. */
+  svn_repos_notify_verify_rev_range_unchanged
 } svn_repos_notify_action_t;
 
 /** The type of warning occurring.
@@ -353,11 +358,15 @@ typedef struct svn_repos_notify_t
 
   /** For #svn_repos_notify_hotcopy_rev_range, the start of the copied
       revision range.
+      For #svn_repos_notify_verify_rev_range_unchanged, the start of the
+      unchanged revision range (since 1.10).
       @since New in 1.9. */
   svn_revnum_t start_revision;
 
   /** For #svn_repos_notify_hotcopy_rev_range, the end of the copied
       revision range (might be the same as @a start_revision).
+      For #svn_repos_notify_verify_rev_range_unchanged, the end of the
+      unchanged revision range (since 1.10).
       @since New in 1.9. */
   svn_revnum_t end_revision;
 
@@ -710,10 +719,27 @@ svn_repos_hotcopy(const char *src_path,
 
 /**
  * Possibly update the repository, @a repos, to use a more efficient
- * filesystem representation.  Use @a pool for allocations.
+ * filesystem representation.  Pack up to @a jobs shards concurrently
+ * as described for svn_fs_pack2().  Use @a pool for allocations.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_repos_fs_pack3(svn_repos_t *repos,
+                   int jobs,
+                   svn_repos_notify_func_t notify_func,
+                   void *notify_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *pool);
+
+/**
+ * Like svn_repos_fs_pack3(), but with @a jobs set to 1.
  *
  * @since New in 1.7.
+ * @deprecated Provided for backward compatibility with the 1.9 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_repos_fs_pack2(svn_repos_t *repos,
                    svn_repos_notify_func_t notify_func,
@@ -723,8 +749,8 @@ svn_repos_fs_pack2(svn_repos_t *repos,
                    apr_pool_t *pool);
 
 /**
- * Similar to svn_repos_fs_pack2(), but with a #svn_fs_pack_notify_t instead
- * of a #svn_repos_notify_t.
+ * Similar to svn_repos_fs_pack3(), but with a #svn_fs_pack_notify_t instead
+ * of a #svn_repos_notify_t and with @a jobs set to 1.
  *
  * @since New in 1.6.
  * @deprecated Provided for backward compatibility with the 1.6 API.
@@ -1389,17 +1415,48 @@ svn_repos_abort_report(void *report_baton,
  * proportional to the greatest depth of the tree under @a tgt_root, not
  * the total size of the delta.
  *
- * ### svn_repos_dir_delta2 is mostly superseded by the reporter
+ * If @a jobs is larger than 1 and both @a src_root and @a tgt_root are
+ * revision roots, up to @a jobs worker threads check sibling nodes for
+ * property and content changes while the editor is being driven.  All
+ * @a editor and @a authz_read_func calls are still made from the calling
+ * thread and in the same order as with @a jobs being 1.  Without thread
+ * support, @a jobs is ignored.
+ *
+ * ### svn_repos_dir_delta3 is mostly superseded by the reporter
  * ### functionality (svn_repos_begin_report3 and friends).
- * ### svn_repos_dir_delta2 does allow the roots to be transaction
+ * ### svn_repos_dir_delta3 does allow the roots to be transaction
  * ### roots rather than just revision roots, and it has the
  * ### entry_props flag.  Almost all of Subversion's own code uses the
  * ### reporter instead; there are some stray references to the
  * ### svn_repos_dir_delta[2] in comments which should probably
  * ### actually refer to the reporter.
  *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_repos_dir_delta3(svn_fs_root_t *src_root,
+                     const char *src_parent_dir,
+                     const char *src_entry,
+                     svn_fs_root_t *tgt_root,
+                     const char *tgt_path,
+                     const svn_delta_editor_t *editor,
+                     void *edit_baton,
+                     svn_repos_authz_func_t authz_read_func,
+                     void *authz_read_baton,
+                     svn_boolean_t text_deltas,
+                     svn_depth_t depth,
+                     svn_boolean_t entry_props,
+                     svn_boolean_t ignore_ancestry,
+                     int jobs,
+                     apr_pool_t *pool);
+
+/**
+ * Similar to svn_repos_dir_delta3(), but with @a jobs set to 1.
+ *
  * @since New in 1.5.
+ * @deprecated Provided for backward compatibility with the 1.9 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_repos_dir_delta2(svn_fs_root_t *src_root,
                      const char *src_parent_dir,
@@ -1745,6 +1802,17 @@ typedef svn_error_t *(* svn_repos_dirent_receiver_t)(const char *path,
  * If @a authz_read_func is not @c NULL, this function will neither report
  * entries nor recurse into directories that the user has no access to.
  *
+ * If @a jobs is greater than 1, @a depth is #svn_depth_infinity and
+ * @a root is a revision root, up to @a jobs threads, each opening the
+ * filesystem on its own, will read sub-directories ahead of the
+ * reporting.  @a receiver and @a authz_read_func are still being called
+ * in the caller's thread only.  If @a unordered is also set, directories
+ * will be reported in the order in which they have been read; entries
+ * within a directory are still being reported in order and every
+ * directory before its contents.  Requires APR thread support;
+ * otherwise, @a jobs and @a unordered are ignored.  This should only be
+ * used if caches are configured thread-safe, see svn_cache_config_set().
+ *
  * Cancellation support is provided in the usual way through the optional
  * @a cancel_func and @a cancel_baton.
  *
@@ -1761,6 +1829,8 @@ svn_repos_list(svn_fs_root_t *root,
                apr_array_header_t *patterns,
                svn_depth_t depth,
                svn_boolean_t path_info_only,
+               int jobs,
+               svn_boolean_t unordered,
                svn_repos_authz_func_t authz_read_func,
                void *authz_read_baton,
                svn_repos_dirent_receiver_t receiver,
@@ -2360,6 +2430,75 @@ svn_repos_get_file_revs(svn_repos_t *repos,
                         void *handler_baton,
                         apr_pool_t *pool);
 
+/**
+ * Callback type for use with svn_repos_blame().  @a start_line is the
+ * 0-based number of the first line of a range of consecutive lines that
+ * were last changed in @a revision.  The range extends up to the
+ * @a start_line of the next call or, for the last call, to the end of
+ * the file.  @a rev_props are the readable revision properties of
+ * @a revision.
+ *
+ * If the lines were last changed before the start of the requested
+ * revision range, @a revision will be #SVN_INVALID_REVNUM and
+ * @a rev_props will be @c NULL.
+ *
+ * @a baton is the receiver baton passed to svn_repos_blame().
+ * @a scratch_pool may be used for temporary allocations.
+ *
+ * @since New in 1.10.
+ */
+typedef svn_error_t *(*svn_repos_blame_receiver_t)(void *baton,
+                                                   apr_int64_t start_line,
+                                                   svn_revnum_t revision,
+                                                   apr_hash_t *rev_props,
+                                                   apr_pool_t *scratch_pool);
+
+/**
+ * Determine for each line of the file @a path in @a repos as seen in
+ * revision @a end the revision that last changed it, and report the
+ * result to @a receiver with @a receiver_baton as ranges of lines in
+ * ascending order.  Only changes in the inclusive revision range from
+ * @a start to @a end are attributed to their revisions.  If @a end is
+ * #SVN_INVALID_REVNUM, the youngest revision is used.  If @a start is
+ * #SVN_INVALID_REVNUM, 0 is used.  @a start must not be greater than
+ * @a end.
+ *
+ * This is the line attribution that a client would calculate from the
+ * data sent by svn_repos_get_file_revs2() with @a include_merged_revisions
+ * set to @c FALSE, using @a diff_options to compare the contents of
+ * consecutive revisions.  If @a diff_options is @c NULL, default options
+ * are used.  The contents of the file can be retrieved from @a end.
+ *
+ * If optional @a authz_read_func is non-NULL, then use this function
+ * (along with optional @a authz_read_baton) to check the readability
+ * of the rev-path in each interesting revision encountered, like
+ * svn_repos_get_file_revs2() does.  If @a path is not readable in @a end,
+ * return #SVN_ERR_AUTHZ_UNREADABLE.
+ *
+ * Results are cached, so that blaming the same file for the same revision
+ * range and diff options again will not need to compare its revisions.
+ *
+ * Cancellation support is provided in the usual way through the optional
+ * @a cancel_func and @a cancel_baton.
+ *
+ * Use @a scratch_pool for temporary memory allocation.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_repos_blame(svn_repos_t *repos,
+                const char *path,
+                svn_revnum_t start,
+                svn_revnum_t end,
+                const svn_diff_file_options_t *diff_options,
+                svn_repos_authz_func_t authz_read_func,
+                void *authz_read_baton,
+                svn_repos_blame_receiver_t receiver,
+                void *receiver_baton,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *scratch_pool);
+
 
 /* ---------------------------------------------------------------*/
 
@@ -3034,10 +3173,10 @@ enum svn_repos_load_uuid
   svn_repos_load_uuid_force
 };
 
-/** Callback type for use with svn_repos_verify_fs3().  @a revision
+/** Callback type for use with svn_repos_verify_fs4().  @a revision
  * and @a verify_err are the details of a single verification failure
- * that occurred during the svn_repos_verify_fs3() call.  @a baton is
- * the same baton given to svn_repos_verify_fs3().  @a scratch_pool is
+ * that occurred during the svn_repos_verify_fs4() call.  @a baton is
+ * the same baton given to svn_repos_verify_fs4().  @a scratch_pool is
  * provided for the convenience of the implementor, who should not
  * expect it to live longer than a single callback call.
  *
@@ -3047,7 +3186,7 @@ enum svn_repos_load_uuid
  * should also call svn_error_dup() for @a verify_err.  Implementors of this
  * callback are forbidden to call svn_error_clear() for @a verify_err.
  *
- * @see svn_repos_verify_fs3
+ * @see svn_repos_verify_fs4
  *
  * @since New in 1.9.
  */
@@ -3110,12 +3249,35 @@ typedef svn_error_t *(*svn_repos_verify_callback_t)(void *baton,
  *      @c action = #svn_repos_notify_verify_rev_end
  *      @c revision = the revision
  *
+ *   For each revision range skipped by an incremental verification:
+ *      @c action = #svn_repos_notify_verify_rev_range_unchanged
+ *      @c start_revision = the first revision of the range
+ *      @c end_revision = the last revision of the range
+ *
  *   At the end:
  *      @c action = svn_repos_notify_verify_end
  *        ### Do we really need a callback to tell us the function we
  *            called has reached its end and is about to return?
  *        ### Not sent, currently, if a FS structure error is found.
  *
+ * If @a jobs is greater than 1, verify up to @a jobs revisions at the
+ * same time, each in a separate thread that opens the repository on its
+ * own.  Notifications, @a verify_callback invocations and errors still
+ * happen in the caller's thread and in the same order as for a serial
+ * verification.  The global metadata verification is not affected by
+ * @a jobs.  Requires APR thread support; otherwise, @a jobs is ignored.
+ * Multi-threaded verification should only be used if caches are
+ * configured thread-safe, see svn_cache_config_set().
+ *
+ * If @a incremental is @c TRUE, consult the verification journal in the
+ * repository and skip all revisions that have been verified successfully
+ * before by the same version of this library while being stored in the
+ * very same files.  To tell, the files get checksummed, which is much
+ * cheaper than a full verification but still reads them completely.
+ * Record the successfully verified revisions in the journal afterwards.
+ * Backends that can't report the files storing a revision get fully
+ * verified.  If @a metadata_only is set, @a incremental is ignored.
+ *
  * If @a cancel_func is not @c NULL, call it periodically with @a
  * cancel_baton as argument to see if the caller wishes to cancel the
  * verification.
@@ -3124,8 +3286,32 @@ typedef svn_error_t *(*svn_repos_verify_callback_t)(void *baton,
  *
  * @see svn_repos_verify_callback_t
  *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_repos_verify_fs4(svn_repos_t *repos,
+                     svn_revnum_t start_rev,
+                     svn_revnum_t end_rev,
+                     svn_boolean_t check_normalization,
+                     svn_boolean_t metadata_only,
+                     svn_boolean_t incremental,
+                     int jobs,
+                     svn_repos_notify_func_t notify_func,
+                     void *notify_baton,
+                     svn_repos_verify_callback_t verify_callback,
+                     void *verify_baton,
+                     svn_cancel_func_t cancel,
+                     void *cancel_baton,
+                     apr_pool_t *scratch_pool);
+
+/**
+ * Like svn_repos_verify_fs4(), but with @a incremental set to @c FALSE
+ * and @a jobs set to 1.
+ *
  * @since New in 1.9.
+ * @deprecated Provided for backward compatibility with the 1.9 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_repos_verify_fs3(svn_repos_t *repos,
                      svn_revnum_t start_rev,
@@ -3183,7 +3369,7 @@ svn_repos_verify_fs(svn_repos_t *repos,
  * Dump the contents of the filesystem within already-open @a repos into
  * writable @a dumpstream.  If @a dumpstream is
  * @c NULL, this is effectively a primitive verify.  It is not complete,
- * however; see instead svn_repos_verify_fs3().
+ * however; see instead svn_repos_verify_fs4().
  *
  * Begin at revision @a start_rev, and dump every revision up through
  * @a end_rev.  If @a start_rev is #SVN_INVALID_REVNUM, start at revision
@@ -3254,6 +3440,67 @@ svn_repos_dump_fs4(svn_repos_t *repos,
                    void *cancel_baton,
                    apr_pool_t *pool);
 
+/**
+ * Like svn_repos_dump_fs4(), but split the dump of revisions @a start_rev
+ * through @a end_rev into @a streams->nelts consecutive segments and
+ * write each segment as a complete dumpfile into the respective element
+ * of @a streams (of type <tt>svn_stream_t *</tt>).  Use
+ * svn_repos_dump_segment_range() to find the revisions covered by each
+ * segment.  Segments that cover no revisions only get the dumpfile header.
+ *
+ * There is no @c NULL stream shortcut; all @a streams must be writable.
+ *
+ * Concatenating the segments in order gives a dumpfile that loads exactly
+ * like the one produced by svn_repos_dump_fs4() with the same parameters.
+ * In particular, @a incremental only applies to the first revision of the
+ * first segment and all later segments start with an incremental
+ * revision, as do copy source and mergeinfo checks relative to
+ * @a start_rev.
+ *
+ * If @a jobs is greater than 1, dump up to @a jobs segments concurrently
+ * in separate threads, each with its own filesystem object.  Each stream
+ * will then be written to by an arbitrary thread, so @a streams must not
+ * share any state.  Notifications are still sent from the calling thread
+ * and in the same order as a serial dump of the segments would send them;
+ * those of a segment are sent once it is complete.  Requires APR thread
+ * support; otherwise, @a jobs is ignored.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_repos_dump_fs_segments(svn_repos_t *repos,
+                           const apr_array_header_t *streams,
+                           svn_revnum_t start_rev,
+                           svn_revnum_t end_rev,
+                           svn_boolean_t incremental,
+                           svn_boolean_t use_deltas,
+                           svn_boolean_t include_revprops,
+                           svn_boolean_t include_changes,
+                           int jobs,
+                           svn_repos_notify_func_t notify_func,
+                           void *notify_baton,
+                           svn_cancel_func_t cancel_func,
+                           void *cancel_baton,
+                           apr_pool_t *scratch_pool);
+
+/**
+ * Set @a *segment_start and @a *segment_end to the first and last revision
+ * of the dump segment with index @a segment out of @a segment_count into
+ * which svn_repos_dump_fs_segments() splits the range @a start_rev to
+ * @a end_rev.  Both must be valid revisions.  All segments cover about
+ * the same number of revisions.  @a *segment_start will be larger than
+ * @a *segment_end for empty segments.
+ *
+ * @since New in 1.10.
+ */
+void
+svn_repos_dump_segment_range(svn_revnum_t *segment_start,
+                             svn_revnum_t *segment_end,
+                             svn_revnum_t start_rev,
+                             svn_revnum_t end_rev,
+                             int segment,
+                             int segment_count);
+
 /**
  * Similar to svn_repos_dump_fs4(), but with @a include_revprops and 
  * @a include_changes both set to @c TRUE.
@@ -4029,6 +4276,28 @@ svn_repos_authz_check_access(svn_authz_t *authz,
                              svn_boolean_t *access_granted,
                              apr_pool_t *pool);
 
+/**
+ * Like svn_repos_authz_check_access() but check @a user's access to all
+ * paths in @a paths, an array of <tt>const char *</tt> repository fspaths,
+ * at once.  Set @a access_granted[i] to indicate whether the
+ * @a required_access is granted for the @a i-th element of @a paths.
+ * The caller must provide at least @a paths->nelts elements in
+ * @a access_granted.
+ *
+ * This is more efficient than individual calls when many paths share
+ * parent directories, in particular if @a paths is sorted.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_repos_authz_check_access_batch(svn_authz_t *authz,
+                                   const char *repos_name,
+                                   const apr_array_header_t *paths,
+                                   const char *user,
+                                   svn_repos_authz_access_t required_access,
+                                   svn_boolean_t *access_granted,
+                                   apr_pool_t *pool);
+
 
 
 /** Revision Access Levels
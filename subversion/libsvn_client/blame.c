@@ -22,9 +22,12 @@
  */
 
 #include <apr_pools.h>
+#include <apr_thread_proc.h>
+#include <apr_thread_cond.h>
 
 #include "client.h"
 
+#include "svn_checksum.h"
 #include "svn_client.h"
 #include "svn_subst.h"
 #include "svn_string.h"
@@ -37,6 +40,8 @@
 #include "svn_hash.h"
 #include "svn_sorts.h"
 
+#include "private/svn_mutex.h"
+#include "private/svn_ra_private.h"
 #include "private/svn_wc_private.h"
 
 #include "svn_private_config.h"
@@ -74,6 +79,45 @@ struct diff_baton {
   const struct rev *rev;
 };
 
+/* The line diffs to do for one revision of the file. */
+struct diff_task {
+  /* Add the blame for the diff between LAST_FILE and CUR_FILE to CHAIN. */
+  const char *last_file;
+  const char *cur_file;
+  struct blame_chain *chain;
+  /* If not NULL, also add the blame for the diff between
+     LAST_ORIGINAL_FILE and CUR_FILE to ORIGINAL_CHAIN. */
+  const char *last_original_file;
+  struct blame_chain *original_chain;
+  /* The revision to blame for the differences. */
+  struct rev *rev;
+};
+
+#if APR_HAS_THREADS
+/* A thread doing the line diffs of one revision while the main thread
+   receives the next one. */
+struct diff_worker {
+  /* The task to do, if HAVE_TASK, and the error of the last one.
+     Protected by MUTEX, which COND signals changes of. */
+  struct diff_task task;
+  svn_boolean_t have_task;
+  svn_error_t *err;
+  /* Set when the thread should exit. */
+  svn_boolean_t exiting;
+  svn_mutex__t *mutex;
+  apr_thread_cond_t *cond;
+  apr_thread_t *thread;
+
+  const svn_diff_file_options_t *diff_options;
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+
+  /* Root pool of the thread.  The blame chains are allocated in it, too,
+     since the main thread keeps allocating in its own pools. */
+  apr_pool_t *pool;
+};
+#endif
+
 /* The baton used for a file revision. Lives the entire operation */
 struct file_rev_baton {
   svn_revnum_t start_rev, end_rev;
@@ -89,6 +133,8 @@ struct file_rev_baton {
   apr_pool_t *mainpool;  /* lives during the whole sequence of calls */
   apr_pool_t *lastpool;  /* pool used during previous call */
   apr_pool_t *currpool;  /* pool used during this call */
+  apr_pool_t *olderpool; /* pool used during the call before the previous
+                            one, whose file may still be diffed against */
 
   /* These are used for tracking merged revisions. */
   svn_boolean_t include_merged_revisions;
@@ -98,6 +144,7 @@ struct file_rev_baton {
   /* pools for files which may need to persist for more than one rev. */
   apr_pool_t *filepool;
   apr_pool_t *prevfilepool;
+  apr_pool_t *oldfilepool;
 
   svn_boolean_t check_mime_type;
 
@@ -106,6 +153,17 @@ struct file_rev_baton {
      happens when we move to the previous revision */
   svn_revnum_t last_revnum;
   apr_hash_t *last_props;
+
+  /* If not NULL, CHAIN was loaded from the cache and already describes
+     the first revision we receive, which must have this checksum.  If it
+     doesn't, RESUME_FAILED gets set and we ignore all revisions. */
+  svn_checksum_t *resume_checksum;
+  svn_boolean_t resume_failed;
+
+#if APR_HAS_THREADS
+  /* The thread doing the line diffs, or NULL if we do them ourselves. */
+  struct diff_worker *worker;
+#endif
 };
 
 /* The baton used by the txdelta window handler. Allocated per revision */
@@ -318,6 +376,258 @@ add_file_blame(const char *last_file,
   return SVN_NO_ERROR;
 }
 
+/* Do the line diffs of TASK. */
+static svn_error_t *
+run_diff_task(const struct diff_task *task,
+              const svn_diff_file_options_t *diff_options,
+              svn_cancel_func_t cancel_func,
+              void *cancel_baton,
+              apr_pool_t *scratch_pool)
+{
+  SVN_ERR(add_file_blame(task->last_file, task->cur_file, task->chain,
+                         task->rev, diff_options,
+                         cancel_func, cancel_baton, scratch_pool));
+
+  if (task->original_chain)
+    SVN_ERR(add_file_blame(task->last_original_file, task->cur_file,
+                           task->original_chain, task->rev, diff_options,
+                           cancel_func, cancel_baton, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS
+
+/* Wait for COND of WORKER, whose mutex must be locked by the caller. */
+static svn_error_t *
+wait_diff_worker(struct diff_worker *worker)
+{
+  apr_status_t status = apr_thread_cond_wait(worker->cond,
+                                             svn_mutex__get(worker->mutex));
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't wait for condition variable"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Wait until WORKER has a task for us and copy it to *TASK.  Set *FOUND
+   to FALSE instead if the worker should exit. */
+static svn_error_t *
+take_diff_task(struct diff_task *task,
+               svn_boolean_t *found,
+               struct diff_worker *worker)
+{
+  svn_error_t *err;
+
+  SVN_ERR(svn_mutex__lock(worker->mutex));
+
+  err = SVN_NO_ERROR;
+  while (!err && !worker->have_task && !worker->exiting)
+    err = wait_diff_worker(worker);
+
+  *found = worker->have_task;
+  if (*found)
+    *task = worker->task;
+
+  return svn_error_trace(svn_mutex__unlock(worker->mutex, err));
+}
+
+/* Record that WORKER is done with its task, which returned ERR. */
+static svn_error_t *
+finish_diff_task(struct diff_worker *worker,
+                 svn_error_t *err)
+{
+  svn_error_t *lock_err = svn_mutex__lock(worker->mutex);
+
+  if (lock_err)
+    {
+      svn_error_clear(err);
+      return svn_error_trace(lock_err);
+    }
+
+  worker->err = err;
+  worker->have_task = FALSE;
+  apr_thread_cond_broadcast(worker->cond);
+
+  return svn_error_trace(svn_mutex__unlock(worker->mutex, SVN_NO_ERROR));
+}
+
+/* Thread function.  Do the tasks given to the diff_worker DATA until it
+   is told to exit. */
+static void * APR_THREAD_FUNC
+diff_worker_thread(apr_thread_t *tid,
+                   void *data)
+{
+  struct diff_worker *worker = data;
+  apr_pool_t *iterpool = svn_pool_create(worker->pool);
+  svn_error_t *err;
+
+  while (TRUE)
+    {
+      struct diff_task task;
+      svn_boolean_t found;
+
+      svn_pool_clear(iterpool);
+
+      err = take_diff_task(&task, &found, worker);
+      if (err || !found)
+        break;
+
+      err = finish_diff_task(worker,
+                             run_diff_task(&task, worker->diff_options,
+                                           worker->cancel_func,
+                                           worker->cancel_baton,
+                                           iterpool));
+      if (err)
+        break;
+    }
+
+  svn_error_clear(err);
+  svn_pool_destroy(iterpool);
+
+  return NULL;
+}
+
+/* Wait until WORKER is done with its task and return the error of that
+   task. */
+static svn_error_t *
+wait_diff_task(struct diff_worker *worker)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+  svn_error_t *task_err;
+
+  SVN_ERR(svn_mutex__lock(worker->mutex));
+
+  while (!err && worker->have_task)
+    err = wait_diff_worker(worker);
+
+  task_err = worker->err;
+  worker->err = SVN_NO_ERROR;
+
+  SVN_ERR(svn_mutex__unlock(worker->mutex, err));
+
+  return svn_error_trace(task_err);
+}
+
+/* Give TASK to WORKER, which must be done with its previous task. */
+static svn_error_t *
+start_diff_task(struct diff_worker *worker,
+                const struct diff_task *task)
+{
+  SVN_ERR(svn_mutex__lock(worker->mutex));
+
+  worker->task = *task;
+  worker->have_task = TRUE;
+  apr_thread_cond_broadcast(worker->cond);
+
+  return svn_error_trace(svn_mutex__unlock(worker->mutex, SVN_NO_ERROR));
+}
+
+/* Pool cleanup function.  Stop the diff_worker DATA, dropping the result
+   of any task it is still doing, and release its resources. */
+static apr_status_t
+stop_diff_worker(void *data)
+{
+  struct diff_worker *worker = data;
+  apr_status_t retval;
+  svn_error_t *err = svn_mutex__lock(worker->mutex);
+
+  worker->exiting = TRUE;
+  apr_thread_cond_broadcast(worker->cond);
+  if (!err)
+    err = svn_mutex__unlock(worker->mutex, SVN_NO_ERROR);
+  svn_error_clear(err);
+
+  apr_thread_join(&retval, worker->thread);
+
+  svn_error_clear(worker->err);
+  svn_pool_destroy(worker->pool);
+
+  return APR_SUCCESS;
+}
+
+/* Start a thread for the line diffs of svn_client_blame5() in *WORKER_P,
+   which lives until POOL is cleared.  Set *WORKER_P to NULL if we can't
+   start one. */
+static svn_error_t *
+start_diff_worker(struct diff_worker **worker_p,
+                  const svn_diff_file_options_t *diff_options,
+                  svn_client_ctx_t *ctx,
+                  apr_pool_t *pool)
+{
+  apr_pool_t *worker_pool = svn_pool_create(NULL);
+  struct diff_worker *worker = apr_pcalloc(worker_pool, sizeof(*worker));
+  svn_error_t *err;
+  apr_status_t status;
+
+  *worker_p = NULL;
+
+  worker->pool = worker_pool;
+  worker->diff_options = diff_options;
+  worker->cancel_func = ctx->cancel_func;
+  worker->cancel_baton = ctx->cancel_baton;
+
+  err = svn_mutex__init(&worker->mutex, TRUE, worker_pool);
+  if (err)
+    {
+      svn_pool_destroy(worker_pool);
+      return svn_error_trace(err);
+    }
+
+  status = apr_thread_cond_create(&worker->cond, worker_pool);
+  if (!status)
+    status = apr_thread_create(&worker->thread, NULL, diff_worker_thread,
+                               worker, worker_pool);
+  if (status)
+    {
+      /* Just do the diffs on this thread. */
+      svn_pool_destroy(worker_pool);
+      return SVN_NO_ERROR;
+    }
+
+  /* Stop the thread before the subpools of POOL, which hold the files
+     it diffs, go away. */
+  apr_pool_pre_cleanup_register(pool, worker, stop_diff_worker);
+
+  *worker_p = worker;
+
+  return SVN_NO_ERROR;
+}
+
+#endif /* APR_HAS_THREADS */
+
+/* Do TASK for FRB, on the worker thread if there is one.  In that case,
+   wait for the previous task and return its error first. */
+static svn_error_t *
+queue_diff_task(struct file_rev_baton *frb,
+                const struct diff_task *task)
+{
+#if APR_HAS_THREADS
+  if (frb->worker)
+    {
+      SVN_ERR(wait_diff_task(frb->worker));
+      return svn_error_trace(start_diff_task(frb->worker, task));
+    }
+#endif
+
+  return svn_error_trace(run_diff_task(task, frb->diff_options,
+                                       frb->ctx->cancel_func,
+                                       frb->ctx->cancel_baton,
+                                       frb->currpool));
+}
+
+/* Wait until all tasks given to queue_diff_task() for FRB are done. */
+static svn_error_t *
+finish_diff_tasks(struct file_rev_baton *frb)
+{
+#if APR_HAS_THREADS
+  if (frb->worker)
+    SVN_ERR(wait_diff_task(frb->worker));
+#endif
+
+  return SVN_NO_ERROR;
+}
+
 /* Record the blame information for the revision in BATON->file_rev_baton.
  */
 static svn_error_t *
@@ -325,7 +635,6 @@ update_blame(void *baton)
 {
   struct delta_baton *dbaton = baton;
   struct file_rev_baton *frb = dbaton->file_rev_baton;
-  struct blame_chain *chain;
 
   /* Close the source file used for the delta.
      It is important to do this early, since otherwise, they will be deleted
@@ -334,42 +643,67 @@ update_blame(void *baton)
   if (dbaton->source_stream)
     SVN_ERR(svn_stream_close(dbaton->source_stream));
 
-  /* If we are including merged revisions, we need to add each rev to the
-     merged chain. */
-  if (frb->include_merged_revisions)
-    chain = frb->merged_chain;
+  if (frb->resume_checksum)
+    {
+      svn_checksum_t *checksum;
+
+      /* The chain loaded from the cache describes this revision already,
+         if the file is what it was made for.  If it isn't, our caller
+         starts over without it. */
+      SVN_ERR(svn_io_file_checksum2(&checksum, dbaton->filename,
+                                    svn_checksum_sha1, frb->currpool));
+      frb->resume_failed = !svn_checksum_match(checksum,
+                                               frb->resume_checksum);
+      frb->resume_checksum = NULL;
+    }
   else
-    chain = frb->chain;
+    {
+      struct diff_task task;
 
-  /* Process this file. */
-  SVN_ERR(add_file_blame(frb->last_filename,
-                         dbaton->filename, chain, dbaton->rev,
-                         frb->diff_options,
-                         frb->ctx->cancel_func, frb->ctx->cancel_baton,
-                         frb->currpool));
+      task.last_file = frb->last_filename;
+      task.cur_file = dbaton->filename;
+      task.rev = dbaton->rev;
 
-  /* If we are including merged revisions, and the current revision is not a
-     merged one, we need to add its blame info to the chain for the original
-     line of history. */
-  if (frb->include_merged_revisions && ! dbaton->is_merged_revision)
-    {
-      apr_pool_t *tmppool;
+      /* If we are including merged revisions, we need to add each rev to
+         the merged chain. */
+      if (frb->include_merged_revisions)
+        task.chain = frb->merged_chain;
+      else
+        task.chain = frb->chain;
 
-      SVN_ERR(add_file_blame(frb->last_original_filename,
-                             dbaton->filename, frb->chain, dbaton->rev,
-                             frb->diff_options,
-                             frb->ctx->cancel_func, frb->ctx->cancel_baton,
-                             frb->currpool));
+      /* If we are including merged revisions, and the current revision is
+         not a merged one, we need to add its blame info to the chain for
+         the original line of history. */
+      if (frb->include_merged_revisions && ! dbaton->is_merged_revision)
+        {
+          task.last_original_file = frb->last_original_filename;
+          task.original_chain = frb->chain;
+        }
+      else
+        {
+          task.last_original_file = NULL;
+          task.original_chain = NULL;
+        }
 
-      /* This filename could be around for a while, potentially, so
-         use the longer lifetime pool, and switch it with the previous one*/
-      svn_pool_clear(frb->prevfilepool);
-      tmppool = frb->filepool;
-      frb->filepool = frb->prevfilepool;
-      frb->prevfilepool = tmppool;
+      /* Process this file, possibly while we receive the next one. */
+      SVN_ERR(queue_diff_task(frb, &task));
 
-      frb->last_original_filename = apr_pstrdup(frb->filepool,
-                                                dbaton->filename);
+      if (task.original_chain)
+        {
+          apr_pool_t *tmppool;
+
+          /* This filename could be around for a while, potentially, so
+             use the longer lifetime pools.  The previous original file may
+             still be diffed against, so release the one before it. */
+          svn_pool_clear(frb->oldfilepool);
+          tmppool = frb->oldfilepool;
+          frb->oldfilepool = frb->prevfilepool;
+          frb->prevfilepool = frb->filepool;
+          frb->filepool = tmppool;
+
+          frb->last_original_filename = apr_pstrdup(frb->filepool,
+                                                    dbaton->filename);
+        }
     }
 
   /* Prepare for next revision. */
@@ -377,9 +711,11 @@ update_blame(void *baton)
   /* Remember the file name so we can diff it with the next revision. */
   frb->last_filename = dbaton->filename;
 
-  /* Switch pools. */
+  /* Rotate pools.  The next call clears the pool of the revision before
+     the previous one, whose diffs are done by then. */
   {
-    apr_pool_t *tmp_pool = frb->lastpool;
+    apr_pool_t *tmp_pool = frb->olderpool;
+    frb->olderpool = frb->lastpool;
     frb->lastpool = frb->currpool;
     frb->currpool = tmp_pool;
   }
@@ -441,6 +777,11 @@ file_rev_handler(void *baton, const char *path, svn_revnum_t revnum,
   /* Clear the current pool. */
   svn_pool_clear(frb->currpool);
 
+  /* Let the server finish sending revisions we can't use, so that the
+     session remains usable. */
+  if (frb->resume_failed)
+    return SVN_NO_ERROR;
+
   if (frb->check_mime_type)
     {
       apr_hash_t *props = svn_prop_array_to_hash(prop_diffs, frb->currpool);
@@ -488,6 +829,7 @@ file_rev_handler(void *baton, const char *path, svn_revnum_t revnum,
      since the tempfile will be removed by the pool and we need the tempfile
      from the last revision with content changes. */
   if (!content_delta_handler
+      && !frb->resume_checksum
       && (!frb->include_merged_revisions || merged_revision))
     return SVN_NO_ERROR;
 
@@ -655,6 +997,335 @@ normalize_blames(struct blame_chain *chain,
     }
 }
 
+/* One range of lines as reported by svn_ra_blame(). */
+struct server_chunk
+{
+  apr_int64_t start;
+  struct rev rev;
+};
+
+/* Implements svn_ra_blame_receiver_t, collecting the chunks in BATON,
+ * an array of struct server_chunk.  Allocate them in the array's pool. */
+static svn_error_t *
+server_chunk_receiver(void *baton,
+                      apr_int64_t start_line,
+                      svn_revnum_t revision,
+                      apr_hash_t *rev_props,
+                      apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *chunks = baton;
+  struct server_chunk *chunk = apr_array_push(chunks);
+
+  chunk->start = start_line;
+  chunk->rev.revision = revision;
+  chunk->rev.rev_props = rev_props ? svn_prop_hash_dup(rev_props,
+                                                       chunks->pool)
+                                   : NULL;
+  chunk->rev.path = NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Let the server of RA_SESSION calculate the blame for the session URL
+ * from START_REVNUM to END_REVNUM with DIFF_OPTIONS and report each line
+ * of the file in END_REVNUM to RECEIVER with RECEIVER_BATON, like
+ * svn_client_blame5() does without merged revisions.  Return
+ * SVN_ERR_RA_NOT_IMPLEMENTED or SVN_ERR_UNSUPPORTED_FEATURE before calling
+ * RECEIVER if the server can't do this.  Use POOL for allocations.
+ */
+static svn_error_t *
+blame_on_server(svn_ra_session_t *ra_session,
+                svn_revnum_t start_revnum,
+                svn_revnum_t end_revnum,
+                const svn_diff_file_options_t *diff_options,
+                svn_client_blame_receiver3_t receiver,
+                void *receiver_baton,
+                svn_client_ctx_t *ctx,
+                apr_pool_t *pool)
+{
+  apr_array_header_t *chunks = apr_array_make(pool, 16,
+                                              sizeof(struct server_chunk));
+  apr_pool_t *iterpool;
+  svn_stream_t *file;
+  svn_stream_t *stream;
+  const char *filename;
+  apr_int64_t line_no;
+  int i;
+
+  SVN_ERR(svn_ra_blame(ra_session, "", start_revnum, end_revnum,
+                       diff_options, server_chunk_receiver, chunks, pool));
+
+  /* Only the attribution comes from the server, fetch the lines. */
+  SVN_ERR(svn_stream_open_unique(&file, &filename, NULL,
+                                 svn_io_file_del_on_pool_cleanup,
+                                 pool, pool));
+  SVN_ERR(svn_ra_get_file(ra_session, "", end_revnum, file, NULL, NULL,
+                          pool));
+  SVN_ERR(svn_stream_close(file));
+
+  SVN_ERR(svn_stream_open_readonly(&file, filename, pool, pool));
+  stream = svn_subst_stream_translated(file, "\n", TRUE, NULL, FALSE, pool);
+
+  iterpool = svn_pool_create(pool);
+  for (i = 0; i < chunks->nelts; ++i)
+    {
+      const struct server_chunk *chunk
+        = &APR_ARRAY_IDX(chunks, i, struct server_chunk);
+      const struct server_chunk *next
+        = (i + 1 < chunks->nelts)
+        ? &APR_ARRAY_IDX(chunks, i + 1, struct server_chunk)
+        : NULL;
+      svn_boolean_t eof = FALSE;
+
+      for (line_no = chunk->start;
+           !next || line_no < next->start;
+           ++line_no)
+        {
+          svn_stringbuf_t *sb;
+
+          svn_pool_clear(iterpool);
+          SVN_ERR(svn_stream_readline(stream, &sb, "\n", &eof, iterpool));
+          if (ctx->cancel_func)
+            SVN_ERR(ctx->cancel_func(ctx->cancel_baton));
+          if (!eof || sb->len)
+            SVN_ERR(receiver(receiver_baton, start_revnum, end_revnum,
+                             line_no, chunk->rev.revision,
+                             chunk->rev.rev_props, SVN_INVALID_REVNUM,
+                             NULL, NULL, sb->data, FALSE, iterpool));
+          if (eof) break;
+        }
+
+      if (eof)
+        break;
+    }
+
+  SVN_ERR(svn_stream_close(stream));
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Kind of the history cache entries holding the blame of a file. */
+#define BLAME_CACHE_KIND "blame"
+
+/* Return the parameters of the history cache entry for the blame from
+ * START_REVNUM with DIFF_OPTIONS, allocated in POOL.
+ */
+static const char *
+blame_cache_params(svn_revnum_t start_revnum,
+                   const svn_diff_file_options_t *diff_options,
+                   apr_pool_t *pool)
+{
+  return apr_psprintf(pool, "%ld %d %d %d", start_revnum,
+                      diff_options->ignore_space,
+                      diff_options->ignore_eol_style,
+                      diff_options->algorithm);
+}
+
+/* Baton for revprops_receiver(). */
+struct revprops_baton
+{
+  /* The struct rev * to fill, keyed by revision number. */
+  apr_hash_t *revs;
+  apr_pool_t *pool;
+};
+
+/* Implements svn_log_entry_receiver_t.  Fill in the revision properties
+ * of the struct rev of LOG_ENTRY in the struct revprops_baton BATON. */
+static svn_error_t *
+revprops_receiver(void *baton,
+                  svn_log_entry_t *log_entry,
+                  apr_pool_t *scratch_pool)
+{
+  struct revprops_baton *rb = baton;
+  struct rev *rev = apr_hash_get(rb->revs, &log_entry->revision,
+                                 sizeof(log_entry->revision));
+
+  if (rev && log_entry->revprops)
+    rev->rev_props = svn_prop_hash_dup(log_entry->revprops, rb->pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Look for a blame of the session URL of RA_SESSION from START_REVNUM
+ * with DIFF_OPTIONS up to a revision no younger than END_REVNUM in the
+ * history cache.  If there is one, load it into CHAIN and set
+ * *CACHED_REVNUM to the revision it was made for and *CHECKSUM to the
+ * SHA1 checksum of the file in that revision.  Otherwise set
+ * *CACHED_REVNUM to SVN_INVALID_REVNUM.  Allocate the revisions in
+ * POOL.
+ *
+ * The cache only holds which revision changed which lines; the revision
+ * properties, which may have changed since, are fetched from the
+ * repository.
+ */
+static svn_error_t *
+load_cached_blame(svn_revnum_t *cached_revnum,
+                  svn_checksum_t **checksum,
+                  struct blame_chain *chain,
+                  svn_ra_session_t *ra_session,
+                  svn_revnum_t start_revnum,
+                  svn_revnum_t end_revnum,
+                  const svn_diff_file_options_t *diff_options,
+                  apr_pool_t *pool)
+{
+  svn_stringbuf_t *contents;
+  apr_array_header_t *lines;
+  apr_array_header_t *fields;
+  struct revprops_baton rb;
+  struct blame *last = NULL;
+  apr_int64_t revnum;
+  svn_error_t *err;
+  int i;
+
+  *cached_revnum = SVN_INVALID_REVNUM;
+
+  SVN_ERR(svn_ra__get_cached_history(&contents, ra_session,
+                                     BLAME_CACHE_KIND,
+                                     blame_cache_params(start_revnum,
+                                                        diff_options,
+                                                        pool),
+                                     pool, pool));
+  if (!contents)
+    return SVN_NO_ERROR;
+
+  /* The first line holds the revision and the checksum of the file, each
+     following line the starting line and revision of a chunk. */
+  lines = svn_cstring_split(contents->data, "\n", FALSE, pool);
+  if (lines->nelts < 2)
+    return SVN_NO_ERROR;
+
+  fields = svn_cstring_split(APR_ARRAY_IDX(lines, 0, const char *), " ",
+                             FALSE, pool);
+  if (fields->nelts != 2)
+    return SVN_NO_ERROR;
+
+  err = svn_cstring_atoi64(&revnum, APR_ARRAY_IDX(fields, 0, const char *));
+  if (!err)
+    err = svn_checksum_parse_hex(checksum, svn_checksum_sha1,
+                                 APR_ARRAY_IDX(fields, 1, const char *),
+                                 pool);
+  if (err || *checksum == NULL
+      || revnum < start_revnum || revnum > end_revnum)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  rb.revs = apr_hash_make(pool);
+  rb.pool = pool;
+  chain->blame = NULL;
+  for (i = 1; i < lines->nelts; i++)
+    {
+      struct blame *blame;
+      struct rev *rev;
+      apr_int64_t start;
+      apr_int64_t chunk_revnum;
+      svn_revnum_t rev_number;
+
+      fields = svn_cstring_split(APR_ARRAY_IDX(lines, i, const char *), " ",
+                                 FALSE, pool);
+      err = (fields->nelts == 2)
+            ? svn_cstring_atoi64(&start,
+                                 APR_ARRAY_IDX(fields, 0, const char *))
+            : svn_error_create(SVN_ERR_MALFORMED_FILE, NULL, NULL);
+      if (!err)
+        err = svn_cstring_atoi64(&chunk_revnum,
+                                 APR_ARRAY_IDX(fields, 1, const char *));
+      if (!err && (last ? start <= last->start : start != 0))
+        err = svn_error_create(SVN_ERR_MALFORMED_FILE, NULL, NULL);
+      if (err)
+        {
+          svn_error_clear(err);
+          chain->blame = NULL;
+          return SVN_NO_ERROR;
+        }
+
+      rev_number = (chunk_revnum < 0) ? SVN_INVALID_REVNUM
+                                      : (svn_revnum_t)chunk_revnum;
+
+      rev = apr_hash_get(rb.revs, &rev_number, sizeof(rev_number));
+      if (!rev)
+        {
+          rev = apr_pcalloc(pool, sizeof(*rev));
+          rev->revision = rev_number;
+          if (SVN_IS_VALID_REVNUM(rev->revision))
+            {
+              rev->rev_props = apr_hash_make(pool);
+              apr_hash_set(rb.revs, &rev->revision, sizeof(rev->revision),
+                           rev);
+            }
+        }
+
+      blame = blame_create(chain, rev, (apr_off_t)start);
+      if (last)
+        last->next = blame;
+      else
+        chain->blame = blame;
+      last = blame;
+    }
+
+  /* Each of these revisions changed the file, so its log lists them. */
+  if (apr_hash_count(rb.revs))
+    {
+      apr_array_header_t *paths = apr_array_make(pool, 1,
+                                                 sizeof(const char *));
+
+      APR_ARRAY_PUSH(paths, const char *) = "";
+      err = svn_ra_get_log2(ra_session, paths, (svn_revnum_t)revnum,
+                            start_revnum, 0, FALSE, FALSE, FALSE, NULL,
+                            revprops_receiver, &rb, pool);
+      if (err)
+        {
+          /* E.g. the file was replaced since; don't bother. */
+          svn_error_clear(err);
+          chain->blame = NULL;
+          return SVN_NO_ERROR;
+        }
+    }
+
+  *cached_revnum = (svn_revnum_t)revnum;
+
+  return SVN_NO_ERROR;
+}
+
+/* Store the blame CHAIN of the session URL of RA_SESSION from
+ * START_REVNUM with DIFF_OPTIONS for END_REVNUM, where the file has the
+ * contents of FILENAME, in the history cache.
+ */
+static svn_error_t *
+store_cached_blame(svn_ra_session_t *ra_session,
+                   const struct blame_chain *chain,
+                   const char *filename,
+                   svn_revnum_t start_revnum,
+                   svn_revnum_t end_revnum,
+                   const svn_diff_file_options_t *diff_options,
+                   apr_pool_t *pool)
+{
+  svn_stringbuf_t *contents;
+  svn_checksum_t *checksum;
+  const struct blame *walk;
+
+  SVN_ERR(svn_io_file_checksum2(&checksum, filename, svn_checksum_sha1,
+                                pool));
+
+  contents = svn_stringbuf_createf(pool, "%ld %s\n", end_revnum,
+                                   svn_checksum_to_cstring_display(checksum,
+                                                                   pool));
+  for (walk = chain->blame; walk; walk = walk->next)
+    svn_stringbuf_appendcstr(contents,
+                             apr_psprintf(pool, "%" APR_OFF_T_FMT " %ld\n",
+                                          walk->start,
+                                          walk->rev->revision));
+
+  return svn_error_trace(
+           svn_ra__set_cached_history(ra_session, BLAME_CACHE_KIND,
+                                      blame_cache_params(start_revnum,
+                                                         diff_options,
+                                                         pool),
+                                      contents, pool));
+}
+
 svn_error_t *
 svn_client_blame5(const char *target,
                   const svn_opt_revision_t *peg_revision,
@@ -669,6 +1340,9 @@ svn_client_blame5(const char *target,
                   apr_pool_t *pool)
 {
   struct file_rev_baton frb;
+  apr_pool_t *chain_pool;
+  svn_boolean_t use_cache;
+  svn_revnum_t cached_revnum = SVN_INVALID_REVNUM;
   svn_ra_session_t *ra_session;
   svn_revnum_t start_revnum, end_revnum;
   struct blame *walk, *walk_merged = NULL;
@@ -767,6 +1441,25 @@ svn_client_blame5(const char *target,
         }
     }
 
+  /* Forward blames of repository revisions without merge tracking can be
+     calculated by the server, which is much cheaper than transferring
+     every revision of the file. */
+  if (start_revnum <= end_revnum
+      && !include_merged_revisions
+      && end->kind != svn_opt_revision_working)
+    {
+      svn_error_t *err = blame_on_server(ra_session, start_revnum,
+                                         end_revnum, diff_options,
+                                         receiver, receiver_baton,
+                                         ctx, pool);
+
+      if (   svn_error_find_cause(err, SVN_ERR_UNSUPPORTED_FEATURE)
+          || svn_error_find_cause(err, SVN_ERR_RA_NOT_IMPLEMENTED))
+        svn_error_clear(err);
+      else
+        return svn_error_trace(err);
+    }
+
   frb.start_rev = start_revnum;
   frb.end_rev = end_revnum;
   frb.target = target;
@@ -776,46 +1469,95 @@ svn_client_blame5(const char *target,
   frb.last_filename = NULL;
   frb.last_rev = NULL;
   frb.last_original_filename = NULL;
+
+  /* Do the line diffs on another thread, so that they overlap with
+     receiving and applying the deltas of the following revisions. */
+  chain_pool = pool;
+#if APR_HAS_THREADS
+  SVN_ERR(start_diff_worker(&frb.worker, diff_options, ctx, pool));
+  if (frb.worker)
+    chain_pool = frb.worker->pool;
+#endif
+
   frb.chain = apr_palloc(pool, sizeof(*frb.chain));
   frb.chain->blame = NULL;
   frb.chain->avail = NULL;
-  frb.chain->pool = pool;
+  frb.chain->pool = chain_pool;
   if (include_merged_revisions)
     {
       frb.merged_chain = apr_palloc(pool, sizeof(*frb.merged_chain));
       frb.merged_chain->blame = NULL;
       frb.merged_chain->avail = NULL;
-      frb.merged_chain->pool = pool;
+      frb.merged_chain->pool = chain_pool;
     }
   frb.backwards = (frb.start_rev > frb.end_rev);
   frb.last_revnum = SVN_INVALID_REVNUM;
   frb.last_props = NULL;
+  frb.resume_checksum = NULL;
+  frb.resume_failed = FALSE;
   frb.check_mime_type = (frb.backwards && !ignore_mime_type);
 
   SVN_ERR(svn_ra_get_repos_root2(ra_session, &frb.repos_root_url, pool));
 
   frb.mainpool = pool;
-  /* The callback will flip the following two pools, because it needs
-     information from the previous call.  Obviously, it can't rely on
+  /* The callback will rotate the following three pools, because it needs
+     information from the previous calls.  Obviously, it can't rely on
      the lifetime of the pool provided by get_file_revs. */
   frb.lastpool = svn_pool_create(pool);
   frb.currpool = svn_pool_create(pool);
+  frb.olderpool = svn_pool_create(pool);
   if (include_merged_revisions)
     {
       frb.filepool = svn_pool_create(pool);
       frb.prevfilepool = svn_pool_create(pool);
+      frb.oldfilepool = svn_pool_create(pool);
+    }
+
+  /* A forward blame we made for an older revision only needs to be
+     extended by the revisions since. */
+  use_cache = (!frb.backwards && !include_merged_revisions
+               && svn_ra__has_history_cache(ra_session));
+  if (use_cache)
+    SVN_ERR(load_cached_blame(&cached_revnum, &frb.resume_checksum,
+                              frb.chain, ra_session, start_revnum,
+                              end_revnum, diff_options, pool));
+
+  if (SVN_IS_VALID_REVNUM(cached_revnum))
+    {
+      SVN_ERR(svn_ra_get_file_revs2(ra_session, "", cached_revnum,
+                                    end_revnum, FALSE,
+                                    file_rev_handler, &frb, pool));
+      SVN_ERR(finish_diff_tasks(&frb));
+
+      if (frb.resume_failed || frb.resume_checksum)
+        {
+          /* The file isn't what the cached blame was made for. */
+          frb.chain->blame = NULL;
+          frb.last_filename = NULL;
+          frb.last_rev = NULL;
+          frb.resume_checksum = NULL;
+          frb.resume_failed = FALSE;
+          cached_revnum = SVN_INVALID_REVNUM;
+        }
     }
 
   /* Collect all blame information.
      We need to ensure that we get one revision before the start_rev,
      if available so that we can know what was actually changed in the start
      revision. */
-  SVN_ERR(svn_ra_get_file_revs2(ra_session, "",
-                                frb.backwards ? start_revnum
-                                              : MAX(0, start_revnum-1),
-                                end_revnum,
-                                include_merged_revisions,
-                                file_rev_handler, &frb, pool));
+  if (!SVN_IS_VALID_REVNUM(cached_revnum))
+    SVN_ERR(svn_ra_get_file_revs2(ra_session, "",
+                                  frb.backwards ? start_revnum
+                                                : MAX(0, start_revnum-1),
+                                  end_revnum,
+                                  include_merged_revisions,
+                                  file_rev_handler, &frb, pool));
+  SVN_ERR(finish_diff_tasks(&frb));
+
+  if (use_cache && frb.last_filename && cached_revnum != end_revnum)
+    SVN_ERR(store_cached_blame(ra_session, frb.chain, frb.last_filename,
+                               start_revnum, end_revnum, diff_options,
+                               pool));
 
   if (end->kind == svn_opt_revision_working)
     {
@@ -965,12 +1707,19 @@ svn_client_blame5(const char *target,
 
   svn_pool_destroy(frb.lastpool);
   svn_pool_destroy(frb.currpool);
+  svn_pool_destroy(frb.olderpool);
   if (include_merged_revisions)
     {
       svn_pool_destroy(frb.filepool);
       svn_pool_destroy(frb.prevfilepool);
+      svn_pool_destroy(frb.oldfilepool);
     }
   svn_pool_destroy(iterpool);
 
+#if APR_HAS_THREADS
+  if (frb.worker)
+    apr_pool_cleanup_run(pool, frb.worker, stop_diff_worker);
+#endif
+
   return SVN_NO_ERROR;
 }
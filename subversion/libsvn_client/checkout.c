@@ -75,6 +75,7 @@ svn_client__checkout_internal(svn_revnum_t *result_rev,
                               svn_depth_t depth,
                               svn_boolean_t ignore_externals,
                               svn_boolean_t allow_unver_obstructions,
+                              svn_boolean_t lazy_files,
                               svn_ra_session_t *ra_session,
                               svn_client_ctx_t *ctx,
                               apr_pool_t *scratch_pool)
@@ -189,6 +190,7 @@ svn_client__checkout_internal(svn_revnum_t *result_rev,
                                       ignore_externals,
                                       allow_unver_obstructions,
                                       TRUE /* adds_as_modification */,
+                                      lazy_files,
                                       FALSE, FALSE, ra_session,
                                       ctx, scratch_pool));
 
@@ -196,7 +198,7 @@ svn_client__checkout_internal(svn_revnum_t *result_rev,
 }
 
 svn_error_t *
-svn_client_checkout3(svn_revnum_t *result_rev,
+svn_client_checkout4(svn_revnum_t *result_rev,
                      const char *URL,
                      const char *path,
                      const svn_opt_revision_t *peg_revision,
@@ -204,6 +206,7 @@ svn_client_checkout3(svn_revnum_t *result_rev,
                      svn_depth_t depth,
                      svn_boolean_t ignore_externals,
                      svn_boolean_t allow_unver_obstructions,
+                     svn_boolean_t lazy_files,
                      svn_client_ctx_t *ctx,
                      apr_pool_t *pool)
 {
@@ -218,10 +221,11 @@ svn_client_checkout3(svn_revnum_t *result_rev,
                                       peg_revision, revision, depth,
                                       ignore_externals,
                                       allow_unver_obstructions,
+                                      lazy_files,
                                       NULL /* ra_session */,
                                       ctx, pool);
   if (sleep_here)
-    svn_io_sleep_for_timestamps(local_abspath, pool);
+    svn_wc__settle_timestamps(ctx->wc_ctx, local_abspath, pool);
 
   return svn_error_trace(err);
 }
@@ -63,6 +63,14 @@ typedef struct svn_client__private_ctx_t
   /* Total number of bytes transferred over network across all RA sessions. */
   apr_off_t total_progress;
 
+  /* Pool the context was allocated in. */
+  apr_pool_t *pool;
+
+  /* Array of pooled_ra_session_t * (see ra.c) that are not used by any
+     operation and may be reused by later ones; most recently used last.
+     Created on demand. */
+  apr_array_header_t *idle_ra_sessions;
+
   /* The public context. */
   svn_client_ctx_t public_ctx;
 } svn_client__private_ctx_t;
@@ -489,6 +497,10 @@ svn_client__make_local_parents(const char *local_abspath,
    If ADDS_AS_MODIFICATION is TRUE, local additions are handled as
    modifications on added nodes.
 
+   If LAZY_FILES is TRUE, files added by the update are recorded as
+   excluded nodes instead of being installed, and no file content is
+   requested from the server.
+
    If INNERUPDATE is true, no anchor check is performed on the update target.
 
    If MAKE_PARENTS is true, allow the update to calculate and checkout
@@ -510,6 +522,7 @@ svn_client__update_internal(svn_revnum_t *result_rev,
                             svn_boolean_t ignore_externals,
                             svn_boolean_t allow_unver_obstructions,
                             svn_boolean_t adds_as_modification,
+                            svn_boolean_t lazy_files,
                             svn_boolean_t make_parents,
                             svn_boolean_t innerupdate,
                             svn_ra_session_t *ra_session,
@@ -539,6 +552,9 @@ svn_client__update_internal(svn_revnum_t *result_rev,
    the repos are tolerated; if FALSE, these obstructions cause the checkout
    to fail.
 
+   If LAZY_FILES is TRUE, only register the files of the checkout as
+   excluded nodes; see svn_client_checkout4().
+
    If RA_SESSION is NOT NULL, it may be used to avoid creating a new
    session. The session may point to a different URL after returning.
    */
@@ -552,6 +568,7 @@ svn_client__checkout_internal(svn_revnum_t *result_rev,
                               svn_depth_t depth,
                               svn_boolean_t ignore_externals,
                               svn_boolean_t allow_unver_obstructions,
+                              svn_boolean_t lazy_files,
                               svn_ra_session_t *ra_session,
                               svn_client_ctx_t *ctx,
                               apr_pool_t *pool);
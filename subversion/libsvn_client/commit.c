@@ -955,7 +955,7 @@ svn_client_commit6(const apr_array_header_t *targets,
           sleep_abspath = base_abspath;
         }
 
-      svn_io_sleep_for_timestamps(sleep_abspath, pool);
+      svn_wc__settle_timestamps(ctx->wc_ctx, sleep_abspath, pool);
     }
 
   /* Abort the commit if it is still in progress. */
@@ -29,6 +29,8 @@
 #include <apr_pools.h>
 #include <apr_hash.h>
 #include <apr_md5.h>
+#include <apr_thread_cond.h>
+#include <apr_thread_proc.h>
 
 #include "client.h"
 #include "svn_dirent_uri.h"
@@ -38,6 +40,8 @@
 #include "svn_props.h"
 #include "svn_iter.h"
 #include "svn_hash.h"
+#include "svn_config.h"
+#include "svn_sorts.h"
 
 #include <assert.h>
 
@@ -45,6 +49,7 @@
 #include "private/svn_wc_private.h"
 #include "private/svn_client_private.h"
 #include "private/svn_sorts_private.h"
+#include "private/svn_mutex.h"
 
 /*** Uncomment this to turn on commit driver debugging. ***/
 /*
@@ -1834,6 +1839,402 @@ fixup_error:
                                             err, ctx, pool));
 }
 
+/* Send a svn_wc_notify_commit_postfix_txdelta notification for the file
+   ITEM to CTX, if it wants notifications. */
+static void
+notify_postfix_txdelta(const svn_client_commit_item3_t *item,
+                       const char *notify_path_prefix,
+                       svn_client_ctx_t *ctx,
+                       apr_pool_t *scratch_pool)
+{
+  if (ctx->notify_func2)
+    {
+      svn_wc_notify_t *notify;
+      notify = svn_wc_create_notify(item->path,
+                                    svn_wc_notify_commit_postfix_txdelta,
+                                    scratch_pool);
+      notify->kind = svn_node_file;
+      notify->path_prefix = notify_path_prefix;
+      ctx->notify_func2(ctx->notify_baton2, notify, scratch_pool);
+    }
+}
+
+/* Return whether the text of the file ITEM must be sent as a fulltext. */
+static svn_boolean_t
+needs_fulltext(const svn_client_commit_item3_t *item)
+{
+  /* If the node has no history, transmit full text */
+  return ((item->state_flags & SVN_CLIENT_COMMIT_ITEM_ADD)
+          && ! (item->state_flags & SVN_CLIENT_COMMIT_ITEM_IS_COPY));
+}
+
+/* Default value of SVN_CONFIG_OPTION_COMMIT_JOBS. */
+#define COMMIT_JOBS_DEFAULT 4
+
+/* Upper limit for SVN_CONFIG_OPTION_COMMIT_JOBS. */
+#define COMMIT_JOBS_MAX 32
+
+/* Return the number of threads CTX allows a commit to compute text
+   deltas with. */
+static int
+get_commit_jobs(svn_client_ctx_t *ctx)
+{
+#if APR_HAS_THREADS
+  svn_config_t *cfg = ctx->config
+                      ? svn_hash_gets(ctx->config, SVN_CONFIG_CATEGORY_CONFIG)
+                      : NULL;
+  apr_int64_t jobs;
+  svn_error_t *err;
+
+  err = svn_config_get_int64(cfg, &jobs, SVN_CONFIG_SECTION_MISCELLANY,
+                             SVN_CONFIG_OPTION_COMMIT_JOBS,
+                             COMMIT_JOBS_DEFAULT);
+  if (err)
+    {
+      svn_error_clear(err);
+      return 1;
+    }
+
+  if (jobs < 1)
+    return 1;
+  if (jobs > COMMIT_JOBS_MAX)
+    return COMMIT_JOBS_MAX;
+
+  return (int)jobs;
+#else
+  return 1;
+#endif
+}
+
+#if APR_HAS_THREADS
+
+/* The text delta of a file to commit, for transmit_text_deltas_parallel().
+ */
+typedef struct delta_job_t
+{
+  struct file_mod_t *mod;
+
+  /* The delta, once it is prepared, and the error of computing it. */
+  svn_wc__text_delta_t *delta;
+  svn_error_t *err;
+
+  /* Whether the delta is computed. */
+  svn_boolean_t done;
+
+  /* Pool for the delta.  It is created and destroyed by the thread driving
+     the commit. */
+  apr_pool_t *pool;
+} delta_job_t;
+
+/* The state shared by the workers of transmit_text_deltas_parallel(). */
+typedef struct delta_batch_t
+{
+  /* The delta_job_t * in the order their deltas are sent, the number of
+     them that are prepared, the index of the first one nobody computes
+     yet, and whether to stop computing.  These and the DONE and ERR
+     members of the jobs are protected by MUTEX, and COND is signaled when
+     any of them changes. */
+  apr_array_header_t *jobs;
+  int prepared;
+  int next_job;
+  svn_boolean_t stop;
+  svn_mutex__t *mutex;
+  apr_thread_cond_t *cond;
+} delta_batch_t;
+
+/* A thread computing the deltas of a delta_batch_t. */
+typedef struct delta_worker_t
+{
+  delta_batch_t *batch;
+
+  /* Root pool for everything the worker does. */
+  apr_pool_t *pool;
+  apr_thread_t *thread;
+} delta_worker_t;
+
+/* Wait for COND of BATCH, whose mutex the caller must hold. */
+static svn_error_t *
+wait_for_delta_batch(delta_batch_t *batch)
+{
+  apr_status_t status = apr_thread_cond_wait(batch->cond,
+                                             svn_mutex__get(batch->mutex));
+
+  if (status)
+    return svn_error_wrap_apr(status,
+                              _("Can't wait for condition variable"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread function.  Compute the prepared deltas of the batch of the
+   delta_worker_t DATA until all of them are computed or the batch is
+   stopped. */
+static void * APR_THREAD_FUNC
+delta_worker_thread(apr_thread_t *tid,
+                    void *data)
+{
+  delta_worker_t *worker = data;
+  delta_batch_t *batch = worker->batch;
+  apr_pool_t *iterpool = svn_pool_create(worker->pool);
+
+  while (TRUE)
+    {
+      delta_job_t *job = NULL;
+      svn_error_t *job_err;
+      svn_error_t *err = svn_mutex__lock(batch->mutex);
+
+      while (!err && !batch->stop && batch->next_job >= batch->prepared
+             && batch->next_job < batch->jobs->nelts)
+        err = wait_for_delta_batch(batch);
+
+      if (!err && !batch->stop && batch->next_job < batch->prepared)
+        job = APR_ARRAY_IDX(batch->jobs, batch->next_job++, delta_job_t *);
+      err = svn_mutex__unlock(batch->mutex, err);
+      if (err || !job)
+        {
+          svn_error_clear(err);
+          break;
+        }
+
+      svn_pool_clear(iterpool);
+      job_err = svn_wc__compute_text_delta(job->delta, iterpool);
+
+      err = svn_mutex__lock(batch->mutex);
+      job->err = job_err;
+      job->done = TRUE;
+      if (!err)
+        apr_thread_cond_broadcast(batch->cond);
+      svn_error_clear(svn_mutex__unlock(batch->mutex, err));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return NULL;
+}
+
+/* Helper for transmit_text_deltas_parallel().  Prepare the delta of the
+   next job of BATCH that isn't prepared yet, using CTX. */
+static svn_error_t *
+prepare_next_delta(delta_batch_t *batch,
+                   svn_client_ctx_t *ctx,
+                   apr_pool_t *scratch_pool)
+{
+  delta_job_t *job = APR_ARRAY_IDX(batch->jobs, batch->prepared,
+                                   delta_job_t *);
+  const svn_client_commit_item3_t *item = job->mod->item;
+
+  job->pool = svn_pool_create(NULL);
+  SVN_ERR(svn_wc__prepare_text_delta(&job->delta, ctx->wc_ctx, item->path,
+                                     needs_fulltext(item),
+                                     job->pool, scratch_pool));
+
+  SVN_ERR(svn_mutex__lock(batch->mutex));
+  batch->prepared++;
+  apr_thread_cond_broadcast(batch->cond);
+  return svn_error_trace(svn_mutex__unlock(batch->mutex, SVN_NO_ERROR));
+}
+
+#endif /* APR_HAS_THREADS */
+
+/* Helper for svn_client__do_commit().
+
+   Transmit the text deltas of the struct file_mod_t * in FILE_MODS to
+   EDITOR like svn_client__do_commit() does, but compute the deltas of the
+   files that come next on up to SVN_CONFIG_OPTION_COMMIT_JOBS threads
+   while sending the current one.  The working copy is only accessed by
+   this thread, which prepares the deltas of up to twice as many files as
+   there are threads ahead of time.  Add the SHA-1 checksums of the new
+   texts to SHA1_CHECKSUMS, unless it is NULL.
+
+   Set *TRANSMITTED to FALSE, without doing anything, if the deltas should
+   be computed and sent one after the other instead. */
+static svn_error_t *
+transmit_text_deltas_parallel(svn_boolean_t *transmitted,
+                              apr_hash_t *file_mods,
+                              const char *base_url,
+                              const char *notify_path_prefix,
+                              apr_hash_t *sha1_checksums,
+                              const svn_delta_editor_t *editor,
+                              svn_client_ctx_t *ctx,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool)
+{
+#if APR_HAS_THREADS
+  int max_jobs = get_commit_jobs(ctx);
+  delta_batch_t batch = { 0 };
+  apr_array_header_t *workers;
+  apr_pool_t *iterpool;
+  apr_hash_index_t *hi;
+  apr_status_t status;
+  svn_error_t *err = SVN_NO_ERROR;
+  svn_error_t *lock_err;
+  int i;
+
+  *transmitted = FALSE;
+
+  if (max_jobs < 2 || apr_hash_count(file_mods) < 2)
+    return SVN_NO_ERROR;
+
+  batch.jobs = apr_array_make(scratch_pool, apr_hash_count(file_mods),
+                              sizeof(delta_job_t *));
+  for (hi = apr_hash_first(scratch_pool, file_mods);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      delta_job_t *job = apr_pcalloc(scratch_pool, sizeof(*job));
+
+      job->mod = apr_hash_this_val(hi);
+      APR_ARRAY_PUSH(batch.jobs, delta_job_t *) = job;
+    }
+
+  SVN_ERR(svn_mutex__init(&batch.mutex, TRUE, scratch_pool));
+  status = apr_thread_cond_create(&batch.cond, scratch_pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create condition variable"));
+
+  /* If we can't start as many workers as we'd like, the ones we have do
+     all the work. */
+  max_jobs = MIN(max_jobs, batch.jobs->nelts);
+  workers = apr_array_make(scratch_pool, max_jobs, sizeof(delta_worker_t *));
+  for (i = 0; i < max_jobs; i++)
+    {
+      delta_worker_t *worker = apr_pcalloc(scratch_pool, sizeof(*worker));
+
+      worker->batch = &batch;
+      worker->pool = svn_pool_create(NULL);
+
+      status = apr_thread_create(&worker->thread, NULL, delta_worker_thread,
+                                 worker, worker->pool);
+      if (status)
+        {
+          svn_pool_destroy(worker->pool);
+          break;
+        }
+
+      APR_ARRAY_PUSH(workers, delta_worker_t *) = worker;
+    }
+
+  if (workers->nelts == 0)
+    return SVN_NO_ERROR;
+
+  *transmitted = TRUE;
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < batch.jobs->nelts; i++)
+    {
+      delta_job_t *job = APR_ARRAY_IDX(batch.jobs, i, delta_job_t *);
+      const svn_client_commit_item3_t *item = job->mod->item;
+      const svn_checksum_t *new_text_base_md5_checksum;
+      const svn_checksum_t *new_text_base_sha1_checksum;
+
+      svn_pool_clear(iterpool);
+
+      /* Keep the workers busy. */
+      while (batch.prepared < batch.jobs->nelts
+             && batch.prepared < i + 2 * workers->nelts)
+        {
+          const svn_client_commit_item3_t *next_item
+            = APR_ARRAY_IDX(batch.jobs, batch.prepared,
+                            delta_job_t *)->mod->item;
+
+          err = prepare_next_delta(&batch, ctx, iterpool);
+          if (err)
+            {
+              err = fixup_commit_error(next_item->path, base_url,
+                                       next_item->session_relpath,
+                                       svn_node_file, err, ctx,
+                                       scratch_pool);
+              break;
+            }
+        }
+      if (err)
+        break;
+
+      /* Transmit the entry. */
+      if (ctx->cancel_func)
+        {
+          err = ctx->cancel_func(ctx->cancel_baton);
+          if (err)
+            break;
+        }
+
+      notify_postfix_txdelta(item, notify_path_prefix, ctx, iterpool);
+
+      err = svn_mutex__lock(batch.mutex);
+      while (!err && !job->done)
+        err = wait_for_delta_batch(&batch);
+      err = svn_mutex__unlock(batch.mutex, err);
+      if (err)
+        break;
+
+      err = job->err;
+      job->err = SVN_NO_ERROR;
+
+      if (!err)
+        err = svn_wc__send_text_delta(&new_text_base_md5_checksum,
+                                      &new_text_base_sha1_checksum,
+                                      job->delta, editor,
+                                      job->mod->file_baton,
+                                      result_pool, iterpool);
+      if (err)
+        {
+          err = fixup_commit_error(item->path, base_url,
+                                   item->session_relpath, svn_node_file,
+                                   err, ctx, scratch_pool);
+          break;
+        }
+
+      if (sha1_checksums)
+        svn_hash_sets(sha1_checksums, item->path,
+                      new_text_base_sha1_checksum);
+
+      /* Close the temporary files. */
+      svn_pool_destroy(job->pool);
+      job->pool = NULL;
+      svn_pool_destroy(job->mod->file_pool);
+    }
+  svn_pool_destroy(iterpool);
+
+  /* Let the workers finish what they are doing, but nothing more. */
+  lock_err = svn_mutex__lock(batch.mutex);
+  batch.stop = TRUE;
+  if (!lock_err)
+    {
+      apr_thread_cond_broadcast(batch.cond);
+      lock_err = svn_mutex__unlock(batch.mutex, SVN_NO_ERROR);
+    }
+  err = svn_error_compose_create(err, lock_err);
+
+  for (i = 0; i < workers->nelts; i++)
+    {
+      delta_worker_t *worker = APR_ARRAY_IDX(workers, i, delta_worker_t *);
+      apr_status_t retval;
+
+      /* The thread doesn't use its pool after it is done, so there is
+         nothing to do if this fails. */
+      apr_thread_join(&retval, worker->thread);
+    }
+
+  for (i = 0; i < batch.jobs->nelts; i++)
+    {
+      delta_job_t *job = APR_ARRAY_IDX(batch.jobs, i, delta_job_t *);
+
+      svn_error_clear(job->err);
+      if (job->pool)
+        svn_pool_destroy(job->pool);
+    }
+
+  for (i = 0; i < workers->nelts; i++)
+    svn_pool_destroy(APR_ARRAY_IDX(workers, i, delta_worker_t *)->pool);
+
+  return svn_error_trace(err);
+#else
+  *transmitted = FALSE;
+
+  return SVN_NO_ERROR;
+#endif
+}
+
 svn_error_t *
 svn_client__do_commit(const char *base_url,
                       const apr_array_header_t *commit_items,
@@ -1851,6 +2252,7 @@ svn_client__do_commit(const char *base_url,
   apr_hash_index_t *hi;
   int i;
   struct item_commit_baton cb_baton;
+  svn_boolean_t transmitted;
   apr_array_header_t *paths =
     apr_array_make(scratch_pool, commit_items->nelts, sizeof(const char *));
 
@@ -1884,7 +2286,14 @@ svn_client__do_commit(const char *base_url,
                                  do_item_commit, &cb_baton, scratch_pool));
 
   /* Transmit outstanding text deltas. */
-  for (hi = apr_hash_first(scratch_pool, file_mods);
+  SVN_ERR(transmit_text_deltas_parallel(&transmitted, file_mods, base_url,
+                                        notify_path_prefix,
+                                        sha1_checksums ? *sha1_checksums
+                                                       : NULL,
+                                        editor, ctx,
+                                        result_pool, scratch_pool));
+
+  for (hi = transmitted ? NULL : apr_hash_first(scratch_pool, file_mods);
        hi;
        hi = apr_hash_next(hi))
     {
@@ -1892,7 +2301,6 @@ svn_client__do_commit(const char *base_url,
       const svn_client_commit_item3_t *item = mod->item;
       const svn_checksum_t *new_text_base_md5_checksum;
       const svn_checksum_t *new_text_base_sha1_checksum;
-      svn_boolean_t fulltext = FALSE;
       svn_error_t *err;
 
       svn_pool_clear(iterpool);
@@ -1901,26 +2309,13 @@ svn_client__do_commit(const char *base_url,
       if (ctx->cancel_func)
         SVN_ERR(ctx->cancel_func(ctx->cancel_baton));
 
-      if (ctx->notify_func2)
-        {
-          svn_wc_notify_t *notify;
-          notify = svn_wc_create_notify(item->path,
-                                        svn_wc_notify_commit_postfix_txdelta,
-                                        iterpool);
-          notify->kind = svn_node_file;
-          notify->path_prefix = notify_path_prefix;
-          ctx->notify_func2(ctx->notify_baton2, notify, iterpool);
-        }
-
-      /* If the node has no history, transmit full text */
-      if ((item->state_flags & SVN_CLIENT_COMMIT_ITEM_ADD)
-          && ! (item->state_flags & SVN_CLIENT_COMMIT_ITEM_IS_COPY))
-        fulltext = TRUE;
+      notify_postfix_txdelta(item, notify_path_prefix, ctx, iterpool);
 
       err = svn_wc_transmit_text_deltas3(&new_text_base_md5_checksum,
                                          &new_text_base_sha1_checksum,
                                          ctx->wc_ctx, item->path,
-                                         fulltext, editor, mod->file_baton,
+                                         needs_fulltext(item),
+                                         editor, mod->file_baton,
                                          result_pool, iterpool);
 
       if (err)
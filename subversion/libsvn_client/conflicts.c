@@ -4795,7 +4795,7 @@ resolve_text_conflict(svn_client_conflict_option_t *option,
   err = svn_error_compose_create(err, svn_wc__release_write_lock(ctx->wc_ctx,
                                                                  lock_abspath,
                                                                  scratch_pool));
-  svn_io_sleep_for_timestamps(local_abspath, scratch_pool);
+  svn_wc__settle_timestamps(ctx->wc_ctx, local_abspath, scratch_pool);
   SVN_ERR(err);
 
   conflict->resolution_text = option_id;
@@ -4839,7 +4839,7 @@ resolve_prop_conflict(svn_client_conflict_option_t *option,
   err = svn_error_compose_create(err, svn_wc__release_write_lock(ctx->wc_ctx,
                                                                  lock_abspath,
                                                                  scratch_pool));
-  svn_io_sleep_for_timestamps(local_abspath, scratch_pool);
+  svn_wc__settle_timestamps(ctx->wc_ctx, local_abspath, scratch_pool);
   SVN_ERR(err);
 
   if (propname[0] == '\0')
@@ -5020,7 +5020,7 @@ resolve_update_moved_away_node(svn_client_conflict_option_t *option,
   err = svn_error_compose_create(err, svn_wc__release_write_lock(ctx->wc_ctx,
                                                                  lock_abspath,
                                                                  scratch_pool));
-  svn_io_sleep_for_timestamps(local_abspath, scratch_pool);
+  svn_wc__settle_timestamps(ctx->wc_ctx, local_abspath, scratch_pool);
   SVN_ERR(err);
 
   conflict->resolution_tree = svn_client_conflict_option_get_id(option);
@@ -5344,7 +5344,7 @@ resolve_merge_incoming_added_file_text_merge(
   err = svn_error_compose_create(err, svn_wc__release_write_lock(ctx->wc_ctx,
                                                                  lock_abspath,
                                                                  scratch_pool));
-  svn_io_sleep_for_timestamps(local_abspath, scratch_pool);
+  svn_wc__settle_timestamps(ctx->wc_ctx, local_abspath, scratch_pool);
   SVN_ERR(err);
 
   if (ctx->notify_func2)
@@ -5556,7 +5556,7 @@ unlock_wc:
   err = svn_error_compose_create(err, svn_wc__release_write_lock(ctx->wc_ctx,
                                                                  lock_abspath,
                                                                  scratch_pool));
-  svn_io_sleep_for_timestamps(local_abspath, scratch_pool);
+  svn_wc__settle_timestamps(ctx->wc_ctx, local_abspath, scratch_pool);
   SVN_ERR(err);
 
   SVN_ERR(svn_stream_close(incoming_new_stream));
@@ -6144,7 +6144,7 @@ resolve_merge_incoming_added_dir_merge(svn_client_conflict_option_t *option,
   err = svn_error_compose_create(err, svn_wc__release_write_lock(ctx->wc_ctx,
                                                                  lock_abspath,
                                                                  scratch_pool));
-  svn_io_sleep_for_timestamps(local_abspath, scratch_pool);
+  svn_wc__settle_timestamps(ctx->wc_ctx, local_abspath, scratch_pool);
   SVN_ERR(err);
 
   if (ctx->notify_func2)
@@ -6267,6 +6267,7 @@ merge_incoming_added_dir_replace(svn_client_conflict_option_t *option,
                                       svn_depth_infinity,
                                       TRUE, /* we want to ignore externals */
                                       FALSE, /* we don't allow obstructions */
+                                      FALSE, /* we want the file content */
                                       ra_session, ctx, scratch_pool);
 
   ctx->notify_func2 = old_notify_func2;
@@ -6394,7 +6395,7 @@ unlock_wc:
   err = svn_error_compose_create(err, svn_wc__release_write_lock(ctx->wc_ctx,
                                                                  lock_abspath,
                                                                  scratch_pool));
-  svn_io_sleep_for_timestamps(local_abspath, scratch_pool);
+  svn_wc__settle_timestamps(ctx->wc_ctx, local_abspath, scratch_pool);
   SVN_ERR(err);
 
   if (ctx->notify_func2)
@@ -6907,7 +6908,7 @@ resolve_incoming_move_file_text_merge(svn_client_conflict_option_t *option,
                       NULL, NULL, /* conflict func/baton */
                       NULL, NULL, /* don't allow user to cancel here */
                       scratch_pool);
-  svn_io_sleep_for_timestamps(moved_to_abspath, scratch_pool);
+  svn_wc__settle_timestamps(ctx->wc_ctx, moved_to_abspath, scratch_pool);
   if (err)
     goto unlock_wc;
 
@@ -7317,7 +7318,8 @@ resolve_local_move_file_merge(svn_client_conflict_option_t *option,
                       NULL, NULL, /* conflict func/baton */
                       NULL, NULL, /* don't allow user to cancel here */
                       scratch_pool);
-  svn_io_sleep_for_timestamps(details->moved_to_abspath, scratch_pool);
+  svn_wc__settle_timestamps(ctx->wc_ctx, details->moved_to_abspath,
+                            scratch_pool);
   if (err)
     return svn_error_compose_create(err,
                                     svn_wc__release_write_lock(ctx->wc_ctx,
@@ -2405,6 +2405,7 @@ repos_to_wc_copy_single(svn_boolean_t *timestamp_sleep,
                                                 &pair->src_op_revision,
                                                 svn_depth_infinity,
                                                 ignore_externals, FALSE,
+                                                FALSE /* lazy_files */,
                                                 ra_session, ctx, pool);
 
             ctx->notify_func2 = old_notify_func2;
@@ -3180,7 +3181,7 @@ svn_client_copy7(const apr_array_header_t *sources,
 
   /* Sleep if required.  DST_PATH is not a URL in these cases. */
   if (timestamp_sleep)
-    svn_io_sleep_for_timestamps(dst_path, subpool);
+    svn_wc__settle_timestamps(ctx->wc_ctx, dst_path, subpool);
 
   svn_pool_destroy(subpool);
   return svn_error_trace(err);
@@ -3278,7 +3279,7 @@ svn_client_move7(const apr_array_header_t *src_paths,
 
   /* Sleep if required.  DST_PATH is not a URL in these cases. */
   if (timestamp_sleep)
-    svn_io_sleep_for_timestamps(dst_path, subpool);
+    svn_wc__settle_timestamps(ctx->wc_ctx, dst_path, subpool);
 
   svn_pool_destroy(subpool);
   return svn_error_trace(err);
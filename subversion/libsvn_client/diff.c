@@ -30,6 +30,8 @@
 #include <apr_strings.h>
 #include <apr_pools.h>
 #include <apr_hash.h>
+#include <apr_thread_cond.h>
+#include <apr_thread_proc.h>
 #include "svn_types.h"
 #include "svn_hash.h"
 #include "svn_wc.h"
@@ -46,6 +48,7 @@
 #include "svn_config.h"
 #include "svn_props.h"
 #include "svn_subst.h"
+#include "svn_sorts.h"
 #include "client.h"
 
 #include "private/svn_wc_private.h"
@@ -53,6 +56,8 @@
 #include "private/svn_subr_private.h"
 #include "private/svn_io_private.h"
 #include "private/svn_ra_private.h"
+#include "private/svn_mutex.h"
+#include "private/svn_sorts_private.h"
 
 #include "svn_private_config.h"
 
@@ -1397,6 +1402,27 @@ diff_dir_deleted(const char *relpath,
   return SVN_NO_ERROR;
 }
 
+/* Return a diff tree processor, allocated in RESULT_POOL, that writes the
+   differences it is told about as described by DWI. */
+static const svn_diff_tree_processor_t *
+create_diff_writer_processor(diff_writer_info_t *dwi,
+                             apr_pool_t *result_pool)
+{
+  svn_diff_tree_processor_t *processor;
+
+  processor = svn_diff__tree_processor_create(dwi, result_pool);
+
+  processor->dir_added = diff_dir_added;
+  processor->dir_changed = diff_dir_changed;
+  processor->dir_deleted = diff_dir_deleted;
+
+  processor->file_added = diff_file_added;
+  processor->file_changed = diff_file_changed;
+  processor->file_deleted = diff_file_deleted;
+
+  return processor;
+}
+
 /*-----------------------------------------------------------------*/
 
 /** The logic behind 'svn diff' and 'svn merge'.  */
@@ -1850,6 +1876,531 @@ diff_wc_wc(const char **root_relpath,
   return SVN_NO_ERROR;
 }
 
+/* Default value of SVN_CONFIG_OPTION_DIFF_JOBS. */
+#define DIFF_JOBS_DEFAULT 4
+
+/* Upper limit for SVN_CONFIG_OPTION_DIFF_JOBS. */
+#define DIFF_JOBS_MAX 32
+
+/* Return the number of RA sessions CTX allows a diff between two
+   repository directories to use at the same time. */
+static int
+get_diff_jobs(svn_client_ctx_t *ctx)
+{
+#if APR_HAS_THREADS
+  svn_config_t *cfg = ctx->config
+                      ? svn_hash_gets(ctx->config, SVN_CONFIG_CATEGORY_CONFIG)
+                      : NULL;
+  apr_int64_t jobs;
+  svn_error_t *err;
+
+  err = svn_config_get_int64(cfg, &jobs, SVN_CONFIG_SECTION_MISCELLANY,
+                             SVN_CONFIG_OPTION_DIFF_JOBS,
+                             DIFF_JOBS_DEFAULT);
+  if (err)
+    {
+      svn_error_clear(err);
+      return 1;
+    }
+
+  if (jobs < 1)
+    return 1;
+  if (jobs > DIFF_JOBS_MAX)
+    return DIFF_JOBS_MAX;
+
+  return (int)jobs;
+#else
+  return 1;
+#endif
+}
+
+#if APR_HAS_THREADS
+
+/* A part of a diff done by diff_repos_repos_parallel(). */
+typedef struct diff_job_t
+{
+  /* The name of the subdirectory to compare, or "" for the comparison of
+     everything but those subdirectories. */
+  const char *name;
+
+  /* The files the output and the error output of the comparison are
+     spooled to, the latter only if the writer has an error stream, and
+     the error of the comparison. */
+  const char *out_path;
+  const char *err_path;
+  svn_error_t *err;
+
+  /* Whether the comparison is finished. */
+  svn_boolean_t done;
+
+  /* Pool for everything the comparison does, including the spool files.
+     It is created and destroyed by the thread that owns the batch. */
+  apr_pool_t *pool;
+} diff_job_t;
+
+/* The state shared by the workers of diff_repos_repos_parallel(). */
+typedef struct diff_batch_t
+{
+  /* The writer of the caller, which the jobs copy. */
+  const diff_writer_info_t *dwi;
+
+  /* The two sides of the diff. */
+  const char *url1;
+  const char *url2;
+  svn_revnum_t rev1;
+  svn_revnum_t rev2;
+  svn_boolean_t text_deltas;
+
+  /* The client context of the caller, which the workers may only use
+     while holding CALLBACK_MUTEX. */
+  svn_client_ctx_t *ctx;
+  svn_mutex__t *callback_mutex;
+
+  /* The diff_job_t * to do, in output order, the index of the first job
+     nobody works on yet, and whether to stop taking jobs.  These and the
+     DONE and ERR members of the jobs are protected by MUTEX, and COND is
+     signaled when a job is done. */
+  apr_array_header_t *jobs;
+  int next_job;
+  svn_boolean_t stop;
+  svn_mutex__t *mutex;
+  apr_thread_cond_t *cond;
+} diff_batch_t;
+
+/* A thread running the jobs of a diff_batch_t over its own RA sessions. */
+typedef struct diff_worker_t
+{
+  diff_batch_t *batch;
+  svn_client_ctx_t *ctx;
+
+  /* The session that reports the differences and the one that the diff
+     editor fetches the files with, both at the URL1 of the batch. */
+  svn_ra_session_t *ra_session;
+  svn_ra_session_t *extra_ra_session;
+
+  /* Root pool for the sessions. */
+  apr_pool_t *pool;
+  apr_thread_t *thread;
+} diff_worker_t;
+
+/* Implements svn_ra_progress_notify_func_t.  Pass the progress on to the
+   client context of the diff_batch_t BATON, one thread at a time. */
+static void
+serialized_diff_progress_func(apr_off_t progress,
+                              apr_off_t total,
+                              void *baton,
+                              apr_pool_t *pool)
+{
+  diff_batch_t *batch = baton;
+  svn_error_t *err = svn_mutex__lock(batch->callback_mutex);
+
+  if (err)
+    {
+      svn_error_clear(err);
+      return;
+    }
+
+  batch->ctx->progress_func(progress, total, batch->ctx->progress_baton,
+                            pool);
+  svn_error_clear(svn_mutex__unlock(batch->callback_mutex, SVN_NO_ERROR));
+}
+
+/* Create a client context for WORKER in WORKER->CTX, which notifies
+   nothing and passes its progress on to the context of its batch.  It
+   shares the auth baton of that context, which serializes asking for
+   credentials between the workers. */
+static svn_error_t *
+create_diff_worker_ctx(diff_worker_t *worker)
+{
+  diff_batch_t *batch = worker->batch;
+  svn_client_ctx_t *ctx;
+  svn_wc_context_t *wc_ctx;
+
+  SVN_ERR(svn_client_create_context2(&ctx, batch->ctx->config,
+                                     worker->pool));
+
+  wc_ctx = ctx->wc_ctx;
+  *ctx = *batch->ctx;
+  ctx->wc_ctx = wc_ctx;
+
+  ctx->notify_func = NULL;
+  ctx->notify_baton = NULL;
+  ctx->notify_func2 = NULL;
+  ctx->notify_baton2 = NULL;
+
+  if (ctx->progress_func)
+    {
+      ctx->progress_func = serialized_diff_progress_func;
+      ctx->progress_baton = batch;
+    }
+
+  worker->ctx = ctx;
+
+  return SVN_NO_ERROR;
+}
+
+/* Do JOB of the batch of WORKER, spooling its output to files in
+   JOB->POOL through a copy of the writer of the batch. */
+static svn_error_t *
+run_diff_job(diff_worker_t *worker,
+             diff_job_t *job)
+{
+  diff_batch_t *batch = worker->batch;
+  diff_writer_info_t dwi = *batch->dwi;
+  const svn_delta_editor_t *diff_editor;
+  void *diff_edit_baton;
+  const svn_ra_reporter3_t *reporter;
+  void *reporter_baton;
+  apr_pool_t *pool = job->pool;
+  int i;
+
+  SVN_ERR(svn_stream_open_unique(&dwi.outstream, &job->out_path, NULL,
+                                 svn_io_file_del_on_pool_cleanup,
+                                 pool, pool));
+  if (dwi.errstream)
+    SVN_ERR(svn_stream_open_unique(&dwi.errstream, &job->err_path, NULL,
+                                   svn_io_file_del_on_pool_cleanup,
+                                   pool, pool));
+  dwi.pool = pool;
+  dwi.empty_file = NULL;
+
+  SVN_ERR(svn_client__get_diff_editor2(
+                &diff_editor, &diff_edit_baton,
+                worker->extra_ra_session, svn_depth_infinity,
+                batch->rev1,
+                batch->text_deltas,
+                create_diff_writer_processor(&dwi, pool),
+                worker->ctx->cancel_func, worker->ctx->cancel_baton,
+                pool));
+
+  SVN_ERR(svn_ra_do_diff3(worker->ra_session, &reporter, &reporter_baton,
+                          batch->rev2, job->name,
+                          svn_depth_infinity, TRUE /* ignore_ancestry */,
+                          batch->text_deltas,
+                          svn_path_url_add_component2(batch->url2,
+                                                      job->name, pool),
+                          diff_editor, diff_edit_baton, pool));
+
+  SVN_ERR(reporter->set_path(reporter_baton, "", batch->rev1,
+                             svn_depth_infinity,
+                             FALSE, NULL,
+                             pool));
+
+  /* The comparison of the directory itself leaves out the subdirectories
+     that other jobs compare. */
+  if (*job->name == '\0')
+    for (i = 1; i < batch->jobs->nelts; i++)
+      {
+        const diff_job_t *other = APR_ARRAY_IDX(batch->jobs, i,
+                                                const diff_job_t *);
+
+        SVN_ERR(reporter->set_path(reporter_baton, other->name, batch->rev1,
+                                   svn_depth_exclude,
+                                   FALSE, NULL,
+                                   pool));
+      }
+
+  SVN_ERR(reporter->finish_report(reporter_baton, pool));
+
+  SVN_ERR(svn_stream_close(dwi.outstream));
+  if (dwi.errstream)
+    SVN_ERR(svn_stream_close(dwi.errstream));
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread function.  Run the jobs of the batch of the diff_worker_t DATA
+   until all of them are taken or the batch is stopped. */
+static void * APR_THREAD_FUNC
+diff_worker_thread(apr_thread_t *tid,
+                   void *data)
+{
+  diff_worker_t *worker = data;
+  diff_batch_t *batch = worker->batch;
+
+  while (TRUE)
+    {
+      diff_job_t *job = NULL;
+      svn_error_t *job_err;
+      svn_error_t *err = svn_mutex__lock(batch->mutex);
+
+      if (!err && !batch->stop && batch->next_job < batch->jobs->nelts)
+        job = APR_ARRAY_IDX(batch->jobs, batch->next_job++, diff_job_t *);
+      err = svn_mutex__unlock(batch->mutex, err);
+      if (err || !job)
+        {
+          svn_error_clear(err);
+          break;
+        }
+
+      job_err = run_diff_job(worker, job);
+
+      err = svn_mutex__lock(batch->mutex);
+      job->err = job_err;
+      job->done = TRUE;
+      if (!err)
+        apr_thread_cond_broadcast(batch->cond);
+      svn_error_clear(svn_mutex__unlock(batch->mutex, err));
+    }
+
+  return NULL;
+}
+
+/* Wait until JOB of BATCH is done.  The caller must hold the mutex of
+   BATCH. */
+static svn_error_t *
+wait_for_diff_job(diff_batch_t *batch,
+                  diff_job_t *job)
+{
+  while (!job->done)
+    {
+      apr_status_t status = apr_thread_cond_wait(batch->cond,
+                                                 svn_mutex__get(batch->mutex));
+
+      if (status)
+        return svn_error_wrap_apr(status,
+                                  _("Can't wait for condition variable"));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+#endif /* APR_HAS_THREADS */
+
+/* Helper for diff_repos_repos().
+
+   Diff URL1@REV1 against URL2@REV2, two directories, with infinite depth
+   while ignoring ancestry, writing the output as described by DWI.  Do
+   that by comparing every subdirectory the two share, and the rest of
+   them, over up to SVN_CONFIG_OPTION_DIFF_JOBS pairs of RA sessions at
+   the same time, each used by a thread that also produces the output of
+   its part.  The output of each part is spooled and then written in the
+   order of the names of the subdirectories, after the rest.
+
+   RA_SESSION is a session to the same repository, which is left at its
+   URL.  Set *DIFFED to FALSE, without doing anything, if the diff should
+   be done over a single session instead. */
+static svn_error_t *
+diff_repos_repos_parallel(svn_boolean_t *diffed,
+                          const diff_writer_info_t *dwi,
+                          svn_ra_session_t *ra_session,
+                          const char *url1,
+                          const char *url2,
+                          svn_revnum_t rev1,
+                          svn_revnum_t rev2,
+                          svn_boolean_t text_deltas,
+                          svn_client_ctx_t *ctx,
+                          apr_pool_t *scratch_pool)
+{
+#if APR_HAS_THREADS
+  int max_jobs = get_diff_jobs(ctx);
+  diff_batch_t batch = { 0 };
+  const char *session_url;
+  apr_hash_t *dirents1;
+  apr_hash_t *dirents2;
+  apr_array_header_t *sorted;
+  apr_array_header_t *workers;
+  diff_job_t *job;
+  apr_status_t status;
+  svn_error_t *err = SVN_NO_ERROR;
+  svn_error_t *lock_err;
+  int i;
+
+  *diffed = FALSE;
+
+  if (max_jobs < 2)
+    return SVN_NO_ERROR;
+
+  /* Find the subdirectories to compare on their own. */
+  SVN_ERR(svn_ra_get_session_url(ra_session, &session_url, scratch_pool));
+  SVN_ERR(svn_ra_reparent(ra_session, url1, scratch_pool));
+  SVN_ERR(svn_ra_get_dir2(ra_session, &dirents1, NULL, NULL, "", rev1,
+                          SVN_DIRENT_KIND, scratch_pool));
+  SVN_ERR(svn_ra_reparent(ra_session, url2, scratch_pool));
+  SVN_ERR(svn_ra_get_dir2(ra_session, &dirents2, NULL, NULL, "", rev2,
+                          SVN_DIRENT_KIND, scratch_pool));
+  SVN_ERR(svn_ra_reparent(ra_session, session_url, scratch_pool));
+
+  batch.jobs = apr_array_make(scratch_pool, 0, sizeof(diff_job_t *));
+  job = apr_pcalloc(scratch_pool, sizeof(*job));
+  job->name = "";
+  APR_ARRAY_PUSH(batch.jobs, diff_job_t *) = job;
+
+  sorted = svn_sort__hash(dirents1, svn_sort_compare_items_lexically,
+                          scratch_pool);
+  for (i = 0; i < sorted->nelts; i++)
+    {
+      const svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i,
+                                                    svn_sort__item_t);
+      const svn_dirent_t *dirent1 = item->value;
+      const svn_dirent_t *dirent2 = svn_hash_gets(dirents2, item->key);
+
+      if (dirent1->kind == svn_node_dir
+          && dirent2 && dirent2->kind == svn_node_dir)
+        {
+          job = apr_pcalloc(scratch_pool, sizeof(*job));
+          job->name = item->key;
+          APR_ARRAY_PUSH(batch.jobs, diff_job_t *) = job;
+        }
+    }
+
+  if (batch.jobs->nelts < 3)
+    return SVN_NO_ERROR;
+
+  batch.dwi = dwi;
+  batch.url1 = url1;
+  batch.url2 = url2;
+  batch.rev1 = rev1;
+  batch.rev2 = rev2;
+  batch.text_deltas = text_deltas;
+  batch.ctx = ctx;
+  SVN_ERR(svn_mutex__init(&batch.mutex, TRUE, scratch_pool));
+  SVN_ERR(svn_mutex__init(&batch.callback_mutex, TRUE, scratch_pool));
+  status = apr_thread_cond_create(&batch.cond, scratch_pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create condition variable"));
+
+  /* Open the sessions on this thread, which owns CTX.  If we can't start
+     as many workers as we'd like, the ones we have do all the work. */
+  max_jobs = MIN(max_jobs, batch.jobs->nelts);
+  workers = apr_array_make(scratch_pool, max_jobs, sizeof(diff_worker_t *));
+  for (i = 0; i < max_jobs; i++)
+    {
+      diff_worker_t *worker = apr_pcalloc(scratch_pool, sizeof(*worker));
+
+      worker->batch = &batch;
+      worker->pool = svn_pool_create(NULL);
+
+      err = create_diff_worker_ctx(worker);
+      if (!err)
+        err = svn_client_open_ra_session2(&worker->ra_session, url1,
+                                          NULL, worker->ctx,
+                                          worker->pool, worker->pool);
+      if (!err)
+        err = svn_client_open_ra_session2(&worker->extra_ra_session, url1,
+                                          NULL, worker->ctx,
+                                          worker->pool, worker->pool);
+      if (err)
+        {
+          svn_error_clear(err);
+          err = SVN_NO_ERROR;
+          svn_pool_destroy(worker->pool);
+          break;
+        }
+
+      APR_ARRAY_PUSH(workers, diff_worker_t *) = worker;
+    }
+
+  if (workers->nelts < 2)
+    {
+      for (i = 0; i < workers->nelts; i++)
+        svn_pool_destroy(APR_ARRAY_IDX(workers, i, diff_worker_t *)->pool);
+
+      return SVN_NO_ERROR;
+    }
+
+  for (i = 0; i < batch.jobs->nelts; i++)
+    APR_ARRAY_IDX(batch.jobs, i, diff_job_t *)->pool = svn_pool_create(NULL);
+
+  for (i = 0; i < workers->nelts; i++)
+    {
+      diff_worker_t *worker = APR_ARRAY_IDX(workers, i, diff_worker_t *);
+
+      status = apr_thread_create(&worker->thread, NULL, diff_worker_thread,
+                                 worker, worker->pool);
+      if (status)
+        {
+          worker->thread = NULL;
+          break;
+        }
+    }
+
+  /* Write the output of the jobs as they finish, in order.  Without any
+     worker, the caller does the diff by itself. */
+  if (APR_ARRAY_IDX(workers, 0, diff_worker_t *)->thread)
+    {
+      svn_stream_t *outstream = svn_stream_disown(dwi->outstream,
+                                                  scratch_pool);
+      svn_stream_t *errstream = dwi->errstream
+                                ? svn_stream_disown(dwi->errstream,
+                                                    scratch_pool)
+                                : NULL;
+
+      *diffed = TRUE;
+
+      for (i = 0; !err && i < batch.jobs->nelts; i++)
+        {
+          svn_stream_t *stream;
+
+          job = APR_ARRAY_IDX(batch.jobs, i, diff_job_t *);
+
+          err = svn_mutex__lock(batch.mutex);
+          if (err)
+            break;
+          err = svn_mutex__unlock(batch.mutex,
+                                  wait_for_diff_job(&batch, job));
+          if (err)
+            break;
+
+          err = job->err;
+          job->err = SVN_NO_ERROR;
+
+          if (!err)
+            err = svn_stream_open_readonly(&stream, job->out_path,
+                                           job->pool, job->pool);
+          if (!err)
+            err = svn_stream_copy3(stream, outstream, ctx->cancel_func,
+                                   ctx->cancel_baton, job->pool);
+          if (!err && errstream)
+            {
+              err = svn_stream_open_readonly(&stream, job->err_path,
+                                             job->pool, job->pool);
+              if (!err)
+                err = svn_stream_copy3(stream, errstream, ctx->cancel_func,
+                                       ctx->cancel_baton, job->pool);
+            }
+        }
+    }
+
+  /* Let the workers finish what they are doing, but nothing more. */
+  lock_err = svn_mutex__lock(batch.mutex);
+  batch.stop = TRUE;
+  if (!lock_err)
+    lock_err = svn_mutex__unlock(batch.mutex, SVN_NO_ERROR);
+  err = svn_error_compose_create(err, lock_err);
+
+  for (i = 0; i < workers->nelts; i++)
+    {
+      diff_worker_t *worker = APR_ARRAY_IDX(workers, i, diff_worker_t *);
+
+      if (worker->thread)
+        {
+          apr_status_t retval;
+
+          /* The thread doesn't use its pool after it is done, so there
+             is nothing to do if this fails. */
+          apr_thread_join(&retval, worker->thread);
+        }
+    }
+
+  for (i = 0; i < batch.jobs->nelts; i++)
+    {
+      job = APR_ARRAY_IDX(batch.jobs, i, diff_job_t *);
+      svn_error_clear(job->err);
+      svn_pool_destroy(job->pool);
+    }
+
+  for (i = 0; i < workers->nelts; i++)
+    svn_pool_destroy(APR_ARRAY_IDX(workers, i, diff_worker_t *)->pool);
+
+  return svn_error_trace(err);
+#else
+  *diffed = FALSE;
+
+  return SVN_NO_ERROR;
+#endif
+}
+
 /* Perform a diff between two repository paths.
 
    PATH_OR_URL1 and PATH_OR_URL2 may be either URLs or the working copy paths.
@@ -1858,11 +2409,16 @@ diff_wc_wc(const char **root_relpath,
    and the actual two paths compared are determined by following copy
    history from PATH_OR_URL2.
 
+   If DWI is not NULL, DIFF_PROCESSOR writes the output as described by
+   DWI, whose driver info is DDI, and the diff may be split up over several
+   threads, each using a copy of DWI.
+
    All other options are the same as those passed to svn_client_diff6(). */
 static svn_error_t *
 diff_repos_repos(const char **root_relpath,
                  svn_boolean_t *root_is_dir,
                  struct diff_driver_info_t *ddi,
+                 const diff_writer_info_t *dwi,
                  const char *path_or_url1,
                  const char *path_or_url2,
                  const svn_opt_revision_t *revision1,
@@ -1969,12 +2525,6 @@ diff_repos_repos(const char **root_relpath,
                                         diff_processor, target1, scratch_pool);
     }
 
-  /* Now, we open an extra RA session to the correct anchor
-     location for URL1.  This is used during the editor calls to fetch file
-     contents.  */
-  SVN_ERR(svn_ra__dup_session(&extra_ra_session, ra_session, anchor1,
-                              scratch_pool, scratch_pool));
-
   if (ddi)
     {
       const char *repos_root_url;
@@ -1990,6 +2540,27 @@ diff_repos_repos(const char **root_relpath,
                                                     result_pool);
     }
 
+  /* Diffs between two directories of the repository that don't involve
+     the working copy can be split up by subdirectory. */
+  if (dwi && !ddi->anchor && ignore_ancestry
+      && kind1 == svn_node_dir && kind2 == svn_node_dir
+      && (depth == svn_depth_infinity || depth == svn_depth_unknown))
+    {
+      svn_boolean_t diffed;
+
+      SVN_ERR(diff_repos_repos_parallel(&diffed, dwi, ra_session,
+                                        url1, url2, rev1, rev2,
+                                        text_deltas, ctx, scratch_pool));
+      if (diffed)
+        return SVN_NO_ERROR;
+    }
+
+  /* Now, we open an extra RA session to the correct anchor
+     location for URL1.  This is used during the editor calls to fetch file
+     contents.  */
+  SVN_ERR(svn_ra__dup_session(&extra_ra_session, ra_session, anchor1,
+                              scratch_pool, scratch_pool));
+
   SVN_ERR(svn_client__get_diff_editor2(
                 &diff_editor, &diff_edit_baton,
                 extra_ra_session, depth,
@@ -2292,11 +2863,14 @@ diff_repos_wc(const char **root_relpath,
 }
 
 
-/* This is basically just the guts of svn_client_diff[_summarize][_peg]6(). */
+/* This is basically just the guts of svn_client_diff[_summarize][_peg]6().
+   DWI is NULL unless DIFF_PROCESSOR writes the output as described by it,
+   in which case DDI is its driver info. */
 static svn_error_t *
 do_diff(const char **root_relpath,
         svn_boolean_t *root_is_dir,
         diff_driver_info_t *ddi,
+        const diff_writer_info_t *dwi,
         const char *path_or_url1,
         const char *path_or_url2,
         const svn_opt_revision_t *revision1,
@@ -2325,7 +2899,7 @@ do_diff(const char **root_relpath,
         {
           /* Ignores changelists. */
           SVN_ERR(diff_repos_repos(root_relpath, root_is_dir,
-                                   ddi,
+                                   ddi, dwi,
                                    path_or_url1, path_or_url2,
                                    revision1, revision2,
                                    peg_revision, depth, ignore_ancestry,
@@ -2524,7 +3098,6 @@ svn_client_diff6(const apr_array_header_t *options,
   diff_writer_info_t dwi = { 0 };
   svn_opt_revision_t peg_revision;
   const svn_diff_tree_processor_t *diff_processor;
-  svn_diff_tree_processor_t *processor;
 
   if (ignore_properties && properties_only)
     return svn_error_create(SVN_ERR_INCORRECT_PARAMS, NULL,
@@ -2561,23 +3134,13 @@ svn_client_diff6(const apr_array_header_t *options,
   dwi.ddi.session_relpath = NULL;
   dwi.ddi.anchor = NULL;
 
-  processor = svn_diff__tree_processor_create(&dwi, pool);
-
-  processor->dir_added = diff_dir_added;
-  processor->dir_changed = diff_dir_changed;
-  processor->dir_deleted = diff_dir_deleted;
-
-  processor->file_added = diff_file_added;
-  processor->file_changed = diff_file_changed;
-  processor->file_deleted = diff_file_deleted;
-
-  diff_processor = processor;
+  diff_processor = create_diff_writer_processor(&dwi, pool);
 
   /* --show-copies-as-adds and --git imply --notice-ancestry */
   if (show_copies_as_adds || use_git_diff_format)
     ignore_ancestry = FALSE;
 
-  return svn_error_trace(do_diff(NULL, NULL, &dwi.ddi,
+  return svn_error_trace(do_diff(NULL, NULL, &dwi.ddi, &dwi,
                                  path_or_url1, path_or_url2,
                                  revision1, revision2,
                                  &peg_revision, TRUE /* no_peg_revision */,
@@ -2611,7 +3174,6 @@ svn_client_diff_peg6(const apr_array_header_t *options,
 {
   diff_writer_info_t dwi = { 0 };
   const svn_diff_tree_processor_t *diff_processor;
-  svn_diff_tree_processor_t *processor;
 
   if (ignore_properties && properties_only)
     return svn_error_create(SVN_ERR_INCORRECT_PARAMS, NULL,
@@ -2645,23 +3207,13 @@ svn_client_diff_peg6(const apr_array_header_t *options,
   dwi.ddi.session_relpath = NULL;
   dwi.ddi.anchor = NULL;
 
-  processor = svn_diff__tree_processor_create(&dwi, pool);
-
-  processor->dir_added = diff_dir_added;
-  processor->dir_changed = diff_dir_changed;
-  processor->dir_deleted = diff_dir_deleted;
-
-  processor->file_added = diff_file_added;
-  processor->file_changed = diff_file_changed;
-  processor->file_deleted = diff_file_deleted;
-
-  diff_processor = processor;
+  diff_processor = create_diff_writer_processor(&dwi, pool);
 
   /* --show-copies-as-adds and --git imply --notice-ancestry */
   if (show_copies_as_adds || use_git_diff_format)
     ignore_ancestry = FALSE;
 
-  return svn_error_trace(do_diff(NULL, NULL, &dwi.ddi,
+  return svn_error_trace(do_diff(NULL, NULL, &dwi.ddi, &dwi,
                                  path_or_url, path_or_url,
                                  start_revision, end_revision,
                                  peg_revision, FALSE /* no_peg_revision */,
@@ -2695,7 +3247,7 @@ svn_client_diff_summarize2(const char *path_or_url1,
                      summarize_func, summarize_baton,
                      path_or_url1, pool, pool));
 
-  return svn_error_trace(do_diff(p_root_relpath, NULL, NULL,
+  return svn_error_trace(do_diff(p_root_relpath, NULL, NULL, NULL,
                                  path_or_url1, path_or_url2,
                                  revision1, revision2,
                                  &peg_revision, TRUE /* no_peg_revision */,
@@ -2725,7 +3277,7 @@ svn_client_diff_summarize_peg2(const char *path_or_url,
                      summarize_func, summarize_baton,
                      path_or_url, pool, pool));
 
-  return svn_error_trace(do_diff(p_root_relpath, NULL, NULL,
+  return svn_error_trace(do_diff(p_root_relpath, NULL, NULL, NULL,
                                  path_or_url, path_or_url,
                                  start_revision, end_revision,
                                  peg_revision, FALSE /* no_peg_revision */,
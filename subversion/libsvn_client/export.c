@@ -29,8 +29,11 @@
 
 #include <apr_file_io.h>
 #include <apr_md5.h>
+#include <apr_thread_cond.h>
+#include <apr_thread_proc.h>
 #include "svn_types.h"
 #include "svn_client.h"
+#include "svn_config.h"
 #include "svn_string.h"
 #include "svn_error.h"
 #include "svn_dirent_uri.h"
@@ -45,6 +48,7 @@
 #include "svn_private_config.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_delta_private.h"
+#include "private/svn_mutex.h"
 #include "private/svn_wc_private.h"
 
 #ifndef ENABLE_EV2_IMPL
@@ -1287,6 +1291,533 @@ export_file(const char *from_path_or_url,
   return SVN_NO_ERROR;
 }
 
+/* Default value of SVN_CONFIG_OPTION_EXPORT_JOBS. */
+#define EXPORT_JOBS_DEFAULT 4
+
+/* Upper limit for SVN_CONFIG_OPTION_EXPORT_JOBS. */
+#define EXPORT_JOBS_MAX 32
+
+/* Return the number of RA sessions CTX allows a repository export to
+   use at the same time. */
+static int
+get_export_jobs(svn_client_ctx_t *ctx)
+{
+#if APR_HAS_THREADS
+  svn_config_t *cfg = ctx->config
+                      ? svn_hash_gets(ctx->config, SVN_CONFIG_CATEGORY_CONFIG)
+                      : NULL;
+  apr_int64_t jobs;
+  svn_error_t *err;
+
+  err = svn_config_get_int64(cfg, &jobs, SVN_CONFIG_SECTION_MISCELLANY,
+                             SVN_CONFIG_OPTION_EXPORT_JOBS,
+                             EXPORT_JOBS_DEFAULT);
+  if (err)
+    {
+      svn_error_clear(err);
+      return 1;
+    }
+
+  if (jobs < 1)
+    return 1;
+  if (jobs > EXPORT_JOBS_MAX)
+    return EXPORT_JOBS_MAX;
+
+  return (int)jobs;
+#else
+  return 1;
+#endif
+}
+
+#if APR_HAS_THREADS
+
+/* A node to be exported by export_directory_parallel(). */
+typedef struct export_job_t
+{
+  /* The path of the node relative to the root of the export. */
+  const char *relpath;
+  svn_node_kind_t kind;
+
+  /* For directories, how much of their contents to export. */
+  svn_depth_t depth;
+
+  struct export_job_t *next;
+} export_job_t;
+
+/* The state shared by the workers of export_directory_parallel(). */
+typedef struct export_batch_t
+{
+  /* The edit baton the workers use.  It is a copy of the caller's, except
+     that it notifies through serialized_export_notify(). */
+  struct edit_baton eb;
+
+  /* The baton of the root directory of the export, for EB. */
+  struct dir_baton root_db;
+
+  /* The revision to export. */
+  svn_revnum_t revision;
+
+  /* The client context of the caller and the notification callback of its
+     edit baton, which the workers may only use while holding
+     CALLBACK_MUTEX. */
+  svn_client_ctx_t *ctx;
+  svn_wc_notify_func2_t notify_func;
+  void *notify_baton;
+  svn_mutex__t *callback_mutex;
+
+  /* The jobs nobody works on yet, the number of jobs that are queued or
+     running, and the first error of any job.  These, EB.EXTERNALS and
+     POOL are protected by MUTEX, and COND is signaled when PENDING
+     drops or jobs get queued. */
+  export_job_t *queue;
+  int pending;
+  svn_error_t *err;
+  svn_mutex__t *mutex;
+  apr_thread_cond_t *cond;
+
+  /* Pool for the jobs. */
+  apr_pool_t *pool;
+} export_batch_t;
+
+/* A thread running the jobs of an export_batch_t over its own RA
+   session. */
+typedef struct export_worker_t
+{
+  export_batch_t *batch;
+  svn_client_ctx_t *ctx;
+  svn_ra_session_t *ra_session;
+
+  /* Root pool for everything the worker does. */
+  apr_pool_t *pool;
+  apr_thread_t *thread;
+} export_worker_t;
+
+/* Implements svn_wc_notify_func2_t.  Pass the notification on to the
+   caller of the export_batch_t BATON, one thread at a time. */
+static void
+serialized_export_notify(void *baton,
+                         const svn_wc_notify_t *notify,
+                         apr_pool_t *pool)
+{
+  export_batch_t *batch = baton;
+  svn_error_t *err = svn_mutex__lock(batch->callback_mutex);
+
+  if (err)
+    {
+      svn_error_clear(err);
+      return;
+    }
+
+  batch->notify_func(batch->notify_baton, notify, pool);
+  svn_error_clear(svn_mutex__unlock(batch->callback_mutex, SVN_NO_ERROR));
+}
+
+/* Implements svn_ra_progress_notify_func_t.  Pass the progress on to the
+   client context of the export_batch_t BATON, one thread at a time. */
+static void
+serialized_export_progress_func(apr_off_t progress,
+                                apr_off_t total,
+                                void *baton,
+                                apr_pool_t *pool)
+{
+  export_batch_t *batch = baton;
+  svn_error_t *err = svn_mutex__lock(batch->callback_mutex);
+
+  if (err)
+    {
+      svn_error_clear(err);
+      return;
+    }
+
+  batch->ctx->progress_func(progress, total, batch->ctx->progress_baton,
+                            pool);
+  svn_error_clear(svn_mutex__unlock(batch->callback_mutex, SVN_NO_ERROR));
+}
+
+/* Create a client context for WORKER in WORKER->CTX, which notifies
+   nothing and passes its progress on to the context of its batch.  It
+   shares the auth baton of that context, which serializes asking for
+   credentials between the workers. */
+static svn_error_t *
+create_export_worker_ctx(export_worker_t *worker)
+{
+  export_batch_t *batch = worker->batch;
+  svn_client_ctx_t *ctx;
+  svn_wc_context_t *wc_ctx;
+
+  SVN_ERR(svn_client_create_context2(&ctx, batch->ctx->config,
+                                     worker->pool));
+
+  wc_ctx = ctx->wc_ctx;
+  *ctx = *batch->ctx;
+  ctx->wc_ctx = wc_ctx;
+
+  ctx->notify_func = NULL;
+  ctx->notify_baton = NULL;
+  ctx->notify_func2 = NULL;
+  ctx->notify_baton2 = NULL;
+
+  if (ctx->progress_func)
+    {
+      ctx->progress_func = serialized_export_progress_func;
+      ctx->progress_baton = batch;
+    }
+
+  worker->ctx = ctx;
+
+  return SVN_NO_ERROR;
+}
+
+/* Queue a new job for the node RELPATH of kind KIND in BATCH, whose
+   mutex must be held by the caller. */
+static void
+queue_export_job(export_batch_t *batch,
+                 const char *relpath,
+                 svn_node_kind_t kind,
+                 svn_depth_t depth)
+{
+  export_job_t *job = apr_pcalloc(batch->pool, sizeof(*job));
+
+  job->relpath = apr_pstrdup(batch->pool, relpath);
+  job->kind = kind;
+  job->depth = depth;
+  job->next = batch->queue;
+
+  batch->queue = job;
+  batch->pending++;
+}
+
+/* Queue a job in BATCH for each of the DIRENTS of the directory
+   DIR_RELPATH, which is exported with DEPTH, and record its svn:externals
+   property EXTERNALS_VAL, if not NULL, through its baton DB.  The caller
+   must hold the mutex of BATCH. */
+static svn_error_t *
+queue_export_children(export_batch_t *batch,
+                      struct dir_baton *db,
+                      const char *dir_relpath,
+                      svn_depth_t depth,
+                      apr_hash_t *dirents,
+                      const svn_string_t *externals_val,
+                      apr_pool_t *scratch_pool)
+{
+  apr_hash_index_t *hi;
+
+  if (externals_val)
+    SVN_ERR(change_dir_prop(db, SVN_PROP_EXTERNALS, externals_val,
+                            scratch_pool));
+
+  for (hi = apr_hash_first(scratch_pool, dirents); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = apr_hash_this_key(hi);
+      const svn_dirent_t *dirent = apr_hash_this_val(hi);
+      const char *relpath = svn_relpath_join(dir_relpath, name,
+                                             scratch_pool);
+
+      if (dirent->kind == svn_node_file)
+        queue_export_job(batch, relpath, svn_node_file, svn_depth_unknown);
+      else if (dirent->kind == svn_node_dir && depth >= svn_depth_immediates)
+        queue_export_job(batch, relpath, svn_node_dir,
+                         depth == svn_depth_infinity ? svn_depth_infinity
+                                                     : svn_depth_empty);
+    }
+
+  if (batch->queue)
+    apr_thread_cond_broadcast(batch->cond);
+
+  return SVN_NO_ERROR;
+}
+
+/* Export the node of JOB, the way the export editor would, over the RA
+   session of WORKER. */
+static svn_error_t *
+run_export_job(export_worker_t *worker,
+               const export_job_t *job,
+               apr_pool_t *scratch_pool)
+{
+  export_batch_t *batch = worker->batch;
+
+  if (batch->eb.cancel_func)
+    SVN_ERR(batch->eb.cancel_func(batch->eb.cancel_baton));
+
+  if (job->kind == svn_node_dir)
+    {
+      struct dir_baton *db = &batch->root_db;
+      apr_hash_t *dirents;
+      apr_hash_t *props;
+
+      /* The caller created the root directory. */
+      if (*job->relpath)
+        SVN_ERR(add_directory(job->relpath, &batch->root_db, NULL,
+                              SVN_INVALID_REVNUM, scratch_pool,
+                              (void **)&db));
+
+      if (job->depth == svn_depth_empty)
+        return SVN_NO_ERROR;
+
+      SVN_ERR(svn_ra_get_dir2(worker->ra_session, &dirents, NULL, &props,
+                              job->relpath, batch->revision, SVN_DIRENT_KIND,
+                              scratch_pool));
+
+      SVN_MUTEX__WITH_LOCK(batch->mutex,
+                           queue_export_children(batch, db, job->relpath,
+                                                 job->depth, dirents,
+                                                 svn_hash_gets(
+                                                   props,
+                                                   SVN_PROP_EXTERNALS),
+                                                 scratch_pool));
+    }
+  else
+    {
+      struct file_baton *fb;
+      apr_hash_t *props;
+      apr_hash_index_t *hi;
+      svn_error_t *err;
+
+      SVN_ERR(add_file(job->relpath, &batch->root_db, NULL,
+                       SVN_INVALID_REVNUM, scratch_pool, (void **)&fb));
+
+      /* This is what export_file() does for a single file. */
+      SVN_ERR(svn_stream_open_unique(&fb->tmp_stream, &fb->tmppath,
+                                     svn_dirent_dirname(fb->path,
+                                                        scratch_pool),
+                                     svn_io_file_del_none,
+                                     fb->pool, fb->pool));
+
+      err = svn_ra_get_file(worker->ra_session, job->relpath,
+                            batch->revision, fb->tmp_stream, NULL, &props,
+                            scratch_pool);
+      if (err)
+        {
+          err = svn_error_compose_create(err,
+                                         svn_stream_close(fb->tmp_stream));
+          return svn_error_compose_create(
+                   err, svn_io_remove_file2(fb->tmppath, TRUE,
+                                            scratch_pool));
+        }
+
+      for (hi = apr_hash_first(scratch_pool, props);
+           hi;
+           hi = apr_hash_next(hi))
+        SVN_ERR(change_file_prop(fb, apr_hash_this_key(hi),
+                                 apr_hash_this_val(hi), scratch_pool));
+
+      SVN_ERR(close_file(fb, NULL, scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread function.  Run the jobs of the batch of the export_worker_t
+   DATA until all of them are done or one of them failed. */
+static void * APR_THREAD_FUNC
+export_worker_thread(apr_thread_t *tid,
+                     void *data)
+{
+  export_worker_t *worker = data;
+  export_batch_t *batch = worker->batch;
+  apr_pool_t *iterpool = svn_pool_create(worker->pool);
+
+  while (TRUE)
+    {
+      export_job_t *job = NULL;
+      svn_error_t *job_err;
+      svn_error_t *err = svn_mutex__lock(batch->mutex);
+
+      /* Other jobs may still queue more jobs. */
+      while (!err && !batch->err && !batch->queue && batch->pending > 0)
+        {
+          apr_status_t status
+            = apr_thread_cond_wait(batch->cond,
+                                   svn_mutex__get(batch->mutex));
+
+          if (status)
+            err = svn_error_wrap_apr(status,
+                                     _("Can't wait for condition "
+                                       "variable"));
+        }
+
+      if (!err && !batch->err && batch->queue)
+        {
+          job = batch->queue;
+          batch->queue = job->next;
+        }
+      else if (err && !batch->err)
+        {
+          batch->err = err;
+          err = SVN_NO_ERROR;
+        }
+      err = svn_mutex__unlock(batch->mutex, err);
+      if (err || !job)
+        {
+          svn_error_clear(err);
+          break;
+        }
+
+      svn_pool_clear(iterpool);
+      job_err = run_export_job(worker, job, iterpool);
+
+      err = svn_mutex__lock(batch->mutex);
+      if (!err)
+        {
+          if (job_err && !batch->err)
+            batch->err = job_err;
+          else
+            svn_error_clear(job_err);
+
+          batch->pending--;
+          apr_thread_cond_broadcast(batch->cond);
+        }
+      else
+        svn_error_clear(job_err);
+      svn_error_clear(svn_mutex__unlock(batch->mutex, err));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return NULL;
+}
+
+#endif /* APR_HAS_THREADS */
+
+/* Helper for export_directory().
+
+   Export the directory of EB at LOC with DEPTH by fetching its files over
+   up to SVN_CONFIG_OPTION_EXPORT_JOBS RA sessions at the same time, each
+   used by a thread that also writes the files it fetched.  The directory
+   listings are spread over the same threads.
+
+   Set *EXPORTED to FALSE, without doing anything, if the export should be
+   done by driving the export editor over a single session instead. */
+static svn_error_t *
+export_directory_parallel(svn_boolean_t *exported,
+                          struct edit_baton *eb,
+                          svn_client__pathrev_t *loc,
+                          svn_depth_t depth,
+                          svn_client_ctx_t *ctx,
+                          apr_pool_t *scratch_pool)
+{
+#if APR_HAS_THREADS
+  int max_jobs = get_export_jobs(ctx);
+  export_batch_t batch = { { 0 } };
+  apr_array_header_t *workers;
+  apr_status_t status;
+  svn_error_t *err;
+  int i;
+
+  *exported = FALSE;
+
+  if (max_jobs < 2 || depth == svn_depth_empty)
+    return SVN_NO_ERROR;
+
+  batch.eb = *eb;
+  batch.root_db.edit_baton = &batch.eb;
+  batch.root_db.path = eb->root_path;
+  batch.revision = loc->rev;
+  batch.ctx = ctx;
+  if (eb->notify_func)
+    {
+      batch.notify_func = eb->notify_func;
+      batch.notify_baton = eb->notify_baton;
+      batch.eb.notify_func = serialized_export_notify;
+      batch.eb.notify_baton = &batch;
+    }
+  SVN_ERR(svn_mutex__init(&batch.mutex, TRUE, scratch_pool));
+  SVN_ERR(svn_mutex__init(&batch.callback_mutex, TRUE, scratch_pool));
+  status = apr_thread_cond_create(&batch.cond, scratch_pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create condition variable"));
+
+  /* Open the sessions on this thread, which owns CTX.  If we can't start
+     as many workers as we'd like, the ones we have do all the work. */
+  workers = apr_array_make(scratch_pool, max_jobs,
+                           sizeof(export_worker_t *));
+  for (i = 0; i < max_jobs; i++)
+    {
+      export_worker_t *worker = apr_pcalloc(scratch_pool, sizeof(*worker));
+
+      worker->batch = &batch;
+      worker->pool = svn_pool_create(NULL);
+
+      err = create_export_worker_ctx(worker);
+      if (!err)
+        err = svn_client_open_ra_session2(&worker->ra_session, loc->url,
+                                          NULL, worker->ctx,
+                                          worker->pool, worker->pool);
+      if (err)
+        {
+          svn_error_clear(err);
+          svn_pool_destroy(worker->pool);
+          break;
+        }
+
+      APR_ARRAY_PUSH(workers, export_worker_t *) = worker;
+    }
+
+  if (workers->nelts < 2)
+    {
+      for (i = 0; i < workers->nelts; i++)
+        svn_pool_destroy(APR_ARRAY_IDX(workers, i, export_worker_t *)->pool);
+
+      return SVN_NO_ERROR;
+    }
+
+  *exported = TRUE;
+  *eb->target_revision = loc->rev;
+
+  /* This is what open_root() does. */
+  err = open_root_internal(eb->root_path, eb->force, eb->notify_func,
+                           eb->notify_baton, scratch_pool);
+
+  if (!err)
+    {
+      batch.pool = svn_pool_create(scratch_pool);
+      queue_export_job(&batch, "", svn_node_dir, depth);
+
+      for (i = 0; i < workers->nelts; i++)
+        {
+          export_worker_t *worker = APR_ARRAY_IDX(workers, i,
+                                                  export_worker_t *);
+
+          status = apr_thread_create(&worker->thread, NULL,
+                                     export_worker_thread, worker,
+                                     worker->pool);
+          if (status)
+            {
+              worker->thread = NULL;
+              if (i == 0)
+                err = svn_error_wrap_apr(status,
+                                         _("Can't create export thread"));
+              break;
+            }
+        }
+    }
+
+  for (i = 0; i < workers->nelts; i++)
+    {
+      export_worker_t *worker = APR_ARRAY_IDX(workers, i,
+                                              export_worker_t *);
+
+      if (worker->thread)
+        {
+          apr_status_t retval;
+
+          /* The thread doesn't use its pool after it is done, so there
+             is nothing to do if this fails. */
+          apr_thread_join(&retval, worker->thread);
+        }
+    }
+
+  for (i = 0; i < workers->nelts; i++)
+    svn_pool_destroy(APR_ARRAY_IDX(workers, i, export_worker_t *)->pool);
+
+  return svn_error_compose_create(err, batch.err);
+#else
+  *exported = FALSE;
+
+  return SVN_NO_ERROR;
+#endif
+}
+
 static svn_error_t *
 export_directory(const char *from_path_or_url,
                  const char *to_path,
@@ -1306,33 +1837,43 @@ export_directory(const char *from_path_or_url,
   const svn_ra_reporter3_t *reporter;
   void *report_baton;
   svn_node_kind_t kind;
+  svn_boolean_t exported = FALSE;
 
   if (!ENABLE_EV2_IMPL)
-    SVN_ERR(get_editor_ev1(&export_editor, &edit_baton, eb, ctx,
-                           scratch_pool, scratch_pool));
-  else
-    SVN_ERR(get_editor_ev2(&export_editor, &edit_baton, eb, ctx,
-                           scratch_pool, scratch_pool));
-
-  /* Manufacture a basic 'report' to the update reporter. */
-  SVN_ERR(svn_ra_do_update3(ra_session,
-                            &reporter, &report_baton,
-                            loc->rev,
-                            "", /* no sub-target */
-                            depth,
-                            FALSE, /* don't want copyfrom-args */
-                            FALSE, /* don't want ignore_ancestry */
-                            export_editor, edit_baton,
-                            scratch_pool, scratch_pool));
-
-  SVN_ERR(reporter->set_path(report_baton, "", loc->rev,
-                             /* Depth is irrelevant, as we're
-                                passing start_empty=TRUE anyway. */
-                             svn_depth_infinity,
-                             TRUE, /* "help, my dir is empty!" */
-                             NULL, scratch_pool));
-
-  SVN_ERR(reporter->finish_report(report_baton, scratch_pool));
+    SVN_ERR(export_directory_parallel(&exported, eb, loc,
+                                      depth == svn_depth_unknown
+                                        ? svn_depth_infinity : depth,
+                                      ctx, scratch_pool));
+
+  if (!exported)
+    {
+      if (!ENABLE_EV2_IMPL)
+        SVN_ERR(get_editor_ev1(&export_editor, &edit_baton, eb, ctx,
+                               scratch_pool, scratch_pool));
+      else
+        SVN_ERR(get_editor_ev2(&export_editor, &edit_baton, eb, ctx,
+                               scratch_pool, scratch_pool));
+
+      /* Manufacture a basic 'report' to the update reporter. */
+      SVN_ERR(svn_ra_do_update3(ra_session,
+                                &reporter, &report_baton,
+                                loc->rev,
+                                "", /* no sub-target */
+                                depth,
+                                FALSE, /* don't want copyfrom-args */
+                                FALSE, /* don't want ignore_ancestry */
+                                export_editor, edit_baton,
+                                scratch_pool, scratch_pool));
+
+      SVN_ERR(reporter->set_path(report_baton, "", loc->rev,
+                                 /* Depth is irrelevant, as we're
+                                    passing start_empty=TRUE anyway. */
+                                 svn_depth_infinity,
+                                 TRUE, /* "help, my dir is empty!" */
+                                 NULL, scratch_pool));
+
+      SVN_ERR(reporter->finish_report(report_baton, scratch_pool));
+    }
 
   /* Special case: Due to our sly export/checkout method of updating an
    * empty directory, no target will have been created if the exported
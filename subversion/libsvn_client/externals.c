@@ -28,6 +28,8 @@
 /*** Includes. ***/
 
 #include <apr_uri.h>
+#include <apr_thread_proc.h>
+#include <apr_thread_cond.h>
 #include "svn_hash.h"
 #include "svn_wc.h"
 #include "svn_pools.h"
@@ -42,6 +44,7 @@
 
 #include "svn_private_config.h"
 #include "private/svn_wc_private.h"
+#include "private/svn_mutex.h"
 
 
 /* Remove the directory at LOCAL_ABSPATH from revision control, and do the
@@ -276,6 +279,7 @@ switch_dir_external(const char *local_abspath,
                                                   local_abspath,
                                                   revision, svn_depth_unknown,
                                                   FALSE, FALSE, FALSE, TRUE,
+                                                  FALSE /* lazy_files */,
                                                   FALSE, TRUE,
                                                   ra_session, ctx, subpool));
 
@@ -412,6 +416,7 @@ switch_dir_external(const char *local_abspath,
                                         url, local_abspath, peg_revision,
                                         revision, svn_depth_infinity,
                                         FALSE, FALSE,
+                                        FALSE /* lazy_files */,
                                         ra_session,
                                         ctx, pool));
 
@@ -745,17 +750,22 @@ handle_external_item_removal(const svn_client_ctx_t *ctx,
   return svn_error_trace(err);
 }
 
+/* Find out where the external NEW_ITEM defined on the directory at
+   PARENT_DIR_URL points to and set *NEW_URL, *NEW_LOC and *EXT_KIND
+   accordingly.  Set *RA_SESSION_P to a session opened to *NEW_LOC, which
+   is RA_SESSION, reparented, if that is possible, or a new session.
+   Allocate the results in RESULT_POOL. */
 static svn_error_t *
-handle_external_item_change(svn_client_ctx_t *ctx,
-                            const char *repos_root_url,
-                            const char *parent_dir_abspath,
-                            const char *parent_dir_url,
-                            const char *local_abspath,
-                            const char *old_defining_abspath,
-                            const svn_wc_external_item2_t *new_item,
-                            svn_ra_session_t *ra_session,
-                            svn_boolean_t *timestamp_sleep,
-                            apr_pool_t *scratch_pool)
+resolve_external_item(const char **new_url_p,
+                      svn_client__pathrev_t **new_loc_p,
+                      svn_node_kind_t *ext_kind_p,
+                      svn_ra_session_t **ra_session_p,
+                      svn_client_ctx_t *ctx,
+                      const char *repos_root_url,
+                      const char *parent_dir_url,
+                      const svn_wc_external_item2_t *new_item,
+                      svn_ra_session_t *ra_session,
+                      apr_pool_t *result_pool)
 {
   svn_client__pathrev_t *new_loc;
   const char *new_url;
@@ -774,13 +784,13 @@ handle_external_item_change(svn_client_ctx_t *ctx,
   SVN_ERR(svn_wc__resolve_relative_external_url(&new_url,
                                                 new_item, repos_root_url,
                                                 parent_dir_url,
-                                                scratch_pool, scratch_pool));
+                                                result_pool, result_pool));
 
   /* Determine if the external is a file or directory. */
   /* Get the RA connection, if needed. */
   if (ra_session)
     {
-      svn_error_t *err = svn_ra_reparent(ra_session, new_url, scratch_pool);
+      svn_error_t *err = svn_ra_reparent(ra_session, new_url, result_pool);
 
       if (err)
         {
@@ -798,9 +808,9 @@ handle_external_item_change(svn_client_ctx_t *ctx,
                                                   ra_session, new_url,
                                                   &(new_item->peg_revision),
                                                   &(new_item->revision), ctx,
-                                                  scratch_pool));
+                                                  result_pool));
 
-          SVN_ERR(svn_ra_reparent(ra_session, new_loc->url, scratch_pool));
+          SVN_ERR(svn_ra_reparent(ra_session, new_loc->url, result_pool));
         }
     }
 
@@ -809,10 +819,10 @@ handle_external_item_change(svn_client_ctx_t *ctx,
                                               new_url, NULL,
                                               &(new_item->peg_revision),
                                               &(new_item->revision), ctx,
-                                              scratch_pool));
+                                              result_pool));
 
   SVN_ERR(svn_ra_check_path(ra_session, "", new_loc->rev, &ext_kind,
-                            scratch_pool));
+                            result_pool));
 
   if (svn_node_none == ext_kind)
     return svn_error_createf(SVN_ERR_RA_ILLEGAL_URL, NULL,
@@ -825,7 +835,31 @@ handle_external_item_change(svn_client_ctx_t *ctx,
                                "or a directory"),
                              new_loc->url, new_loc->rev);
 
+  *new_url_p = new_url;
+  *new_loc_p = new_loc;
+  *ext_kind_p = ext_kind;
+  *ra_session_p = ra_session;
+
+  return SVN_NO_ERROR;
+}
 
+/* Check out, update or switch the external NEW_ITEM at LOCAL_ABSPATH,
+   defined on PARENT_DIR_ABSPATH, to NEW_LOC as found by
+   resolve_external_item(). */
+static svn_error_t *
+apply_external_item_change(svn_client_ctx_t *ctx,
+                           const char *repos_root_url,
+                           const char *parent_dir_abspath,
+                           const char *local_abspath,
+                           const char *old_defining_abspath,
+                           const svn_wc_external_item2_t *new_item,
+                           const char *new_url,
+                           svn_client__pathrev_t *new_loc,
+                           svn_node_kind_t ext_kind,
+                           svn_ra_session_t *ra_session,
+                           svn_boolean_t *timestamp_sleep,
+                           apr_pool_t *scratch_pool)
+{
   /* Not protecting against recursive externals.  Detecting them in
      the global case is hard, and it should be pretty obvious to a
      user when it happens.  Worst case: your disk fills up :-). */
@@ -934,6 +968,35 @@ handle_external_item_change(svn_client_ctx_t *ctx,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+handle_external_item_change(svn_client_ctx_t *ctx,
+                            const char *repos_root_url,
+                            const char *parent_dir_abspath,
+                            const char *parent_dir_url,
+                            const char *local_abspath,
+                            const char *old_defining_abspath,
+                            const svn_wc_external_item2_t *new_item,
+                            svn_ra_session_t *ra_session,
+                            svn_boolean_t *timestamp_sleep,
+                            apr_pool_t *scratch_pool)
+{
+  svn_client__pathrev_t *new_loc;
+  const char *new_url;
+  svn_node_kind_t ext_kind;
+
+  SVN_ERR(resolve_external_item(&new_url, &new_loc, &ext_kind, &ra_session,
+                                ctx, repos_root_url, parent_dir_url,
+                                new_item, ra_session, scratch_pool));
+
+  return svn_error_trace(
+           apply_external_item_change(ctx, repos_root_url,
+                                      parent_dir_abspath, local_abspath,
+                                      old_defining_abspath, new_item,
+                                      new_url, new_loc, ext_kind,
+                                      ra_session, timestamp_sleep,
+                                      scratch_pool));
+}
+
 static svn_error_t *
 wrap_external_error(const svn_client_ctx_t *ctx,
                     const char *target_abspath,
@@ -958,6 +1021,546 @@ wrap_external_error(const svn_client_ctx_t *ctx,
   return err;
 }
 
+/* An external to check out or update, possibly on another thread. */
+typedef struct external_job_t
+{
+  /* The external NEW_ITEM at LOCAL_ABSPATH, defined on the directory
+     PARENT_DIR_ABSPATH at PARENT_DIR_URL in REPOS_ROOT_URL, and registered
+     as defined by OLD_DEFINING_ABSPATH before, if not NULL. */
+  const char *repos_root_url;
+  const char *local_abspath;
+  const char *parent_dir_abspath;
+  const char *parent_dir_url;
+  const char *old_defining_abspath;
+  const svn_wc_external_item2_t *new_item;
+
+  /* The batch this job belongs to. */
+  struct externals_batch_t *batch;
+
+  /* Where the external points to, as found by resolve_external_item(). */
+  const char *new_url;
+  svn_client__pathrev_t *new_loc;
+  svn_node_kind_t ext_kind;
+  svn_ra_session_t *ra_session;
+
+  /* Pool for RA_SESSION, which needs to be destroyed by the thread that
+     created it because the session may come from the pool of idle
+     sessions of the client context. */
+  apr_pool_t *session_pool;
+
+  /* Pool for everything else the job does, and the notifications it
+     sends, as svn_wc_notify_t *, to be passed on in order. */
+  apr_pool_t *pool;
+  apr_array_header_t *notifications;
+
+  /* The client context of a directory external handled on another
+     thread, set up by the thread that owns the context of the batch.
+     Destroying CTX_POOL closes its working copy databases. */
+  svn_client_ctx_t *ctx;
+  apr_pool_t *ctx_pool;
+
+  /* The results. */
+  svn_boolean_t timestamp_sleep;
+  svn_error_t *err;
+
+  /* Whether the job has been started on a thread and whether it is done.
+     Protected by the mutex of the batch while the thread runs. */
+  svn_boolean_t started;
+  svn_boolean_t done;
+  apr_thread_t *thread;
+} external_job_t;
+
+/* The externals to check out or update, in the order they are reported. */
+typedef struct externals_batch_t
+{
+  /* Array of external_job_t *. */
+  apr_array_header_t *jobs;
+
+#if APR_HAS_THREADS
+  /* The client context of the caller, whose callbacks the job threads
+     may use only while holding CALLBACK_MUTEX. */
+  svn_client_ctx_t *ctx;
+  svn_mutex__t *callback_mutex;
+
+  /* Signalled whenever a job is done. */
+  svn_mutex__t *mutex;
+  apr_thread_cond_t *cond;
+
+  /* Number of jobs currently running on other threads. */
+  int running;
+#endif
+} externals_batch_t;
+
+/* Default value of SVN_CONFIG_OPTION_EXTERNALS_JOBS. */
+#define EXTERNALS_JOBS_DEFAULT 4
+
+/* Upper limit for SVN_CONFIG_OPTION_EXTERNALS_JOBS. */
+#define EXTERNALS_JOBS_MAX 32
+
+/* Return the number of externals CTX allows to be handled at the same
+   time. */
+static int
+get_externals_jobs(svn_client_ctx_t *ctx)
+{
+#if APR_HAS_THREADS
+  svn_config_t *cfg = ctx->config
+                      ? svn_hash_gets(ctx->config, SVN_CONFIG_CATEGORY_CONFIG)
+                      : NULL;
+  apr_int64_t jobs;
+  svn_error_t *err;
+
+  err = svn_config_get_int64(cfg, &jobs, SVN_CONFIG_SECTION_MISCELLANY,
+                             SVN_CONFIG_OPTION_EXTERNALS_JOBS,
+                             EXTERNALS_JOBS_DEFAULT);
+  if (err)
+    {
+      svn_error_clear(err);
+      return 1;
+    }
+
+  if (jobs < 1)
+    return 1;
+  if (jobs > EXTERNALS_JOBS_MAX)
+    return EXTERNALS_JOBS_MAX;
+
+  return (int)jobs;
+#else
+  return 1;
+#endif
+}
+
+#if APR_HAS_THREADS
+
+/* Implements svn_wc_notify_func2_t.  Remember the notification for the
+   external_job_t BATON. */
+static void
+queue_notification(void *baton,
+                   const svn_wc_notify_t *notify,
+                   apr_pool_t *scratch_pool)
+{
+  external_job_t *job = baton;
+
+  APR_ARRAY_PUSH(job->notifications, svn_wc_notify_t *)
+    = svn_wc_dup_notify(notify, job->pool);
+}
+
+/* Implements svn_wc_conflict_resolver_func2_t.  Pass the conflict on to
+   the client context of the externals_batch_t BATON, one thread at a
+   time. */
+static svn_error_t *
+serialized_conflict_func(svn_wc_conflict_result_t **result,
+                         const svn_wc_conflict_description2_t *description,
+                         void *baton,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  externals_batch_t *batch = baton;
+
+  SVN_MUTEX__WITH_LOCK(batch->callback_mutex,
+                       batch->ctx->conflict_func2(result, description,
+                                                  batch->ctx->conflict_baton2,
+                                                  result_pool,
+                                                  scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_ra_progress_notify_func_t.  Pass the progress on to the
+   client context of the externals_batch_t BATON, one thread at a time. */
+static void
+serialized_progress_func(apr_off_t progress,
+                         apr_off_t total,
+                         void *baton,
+                         apr_pool_t *pool)
+{
+  externals_batch_t *batch = baton;
+  svn_error_t *err = svn_mutex__lock(batch->callback_mutex);
+
+  if (err)
+    {
+      svn_error_clear(err);
+      return;
+    }
+
+  batch->ctx->progress_func(progress, total, batch->ctx->progress_baton,
+                            pool);
+  svn_error_clear(svn_mutex__unlock(batch->callback_mutex, SVN_NO_ERROR));
+}
+
+/* Create a client context for running JOB on another thread in
+   *CTX_P, allocated in RESULT_POOL.  It has its own working copy
+   context and copy of the configuration, and queues its notifications
+   in JOB.  It shares the auth baton of the context of the batch, which
+   serializes asking for credentials.
+
+   This must be called by the thread that owns the context of the batch
+   because reading the configuration is not thread-safe. */
+static svn_error_t *
+create_job_ctx(svn_client_ctx_t **ctx_p,
+               external_job_t *job,
+               apr_pool_t *result_pool)
+{
+  externals_batch_t *batch = job->batch;
+  svn_client_ctx_t *ctx;
+  svn_wc_context_t *wc_ctx;
+  apr_hash_t *config = NULL;
+
+  if (batch->ctx->config)
+    SVN_ERR(svn_config_copy_config(&config, batch->ctx->config,
+                                   result_pool));
+
+  SVN_ERR(svn_client_create_context2(&ctx, config, result_pool));
+
+  wc_ctx = ctx->wc_ctx;
+  *ctx = *batch->ctx;
+  ctx->wc_ctx = wc_ctx;
+  ctx->config = config;
+
+  ctx->notify_func = NULL;
+  ctx->notify_baton = NULL;
+  ctx->notify_func2 = queue_notification;
+  ctx->notify_baton2 = job;
+
+  if (ctx->conflict_func2)
+    {
+      ctx->conflict_func2 = serialized_conflict_func;
+      ctx->conflict_baton2 = batch;
+    }
+  ctx->conflict_func = NULL;
+  ctx->conflict_baton = NULL;
+
+  if (ctx->progress_func)
+    {
+      ctx->progress_func = serialized_progress_func;
+      ctx->progress_baton = batch;
+    }
+
+  *ctx_p = ctx;
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread function.  Check out or update the external of the
+   external_job_t DATA. */
+static void * APR_THREAD_FUNC
+external_job_thread(apr_thread_t *tid,
+                    void *data)
+{
+  external_job_t *job = data;
+  externals_batch_t *batch = job->batch;
+  svn_error_t *err;
+
+  err = apply_external_item_change(job->ctx, job->repos_root_url,
+                                   job->parent_dir_abspath,
+                                   job->local_abspath,
+                                   job->old_defining_abspath,
+                                   job->new_item, job->new_url,
+                                   job->new_loc, job->ext_kind,
+                                   job->ra_session, &job->timestamp_sleep,
+                                   job->ctx_pool);
+
+  /* Close the working copy databases of this thread. */
+  svn_pool_destroy(job->ctx_pool);
+  job->ctx_pool = NULL;
+  job->ctx = NULL;
+
+  job->err = err;
+
+  err = svn_mutex__lock(batch->mutex);
+  if (!err)
+    {
+      job->done = TRUE;
+      batch->running--;
+      apr_thread_cond_broadcast(batch->cond);
+    }
+  svn_error_clear(svn_mutex__unlock(batch->mutex, err));
+
+  return NULL;
+}
+
+/* Wait for COND of BATCH, whose mutex must be locked by the caller. */
+static svn_error_t *
+wait_externals_batch(externals_batch_t *batch)
+{
+  apr_status_t status = apr_thread_cond_wait(batch->cond,
+                                             svn_mutex__get(batch->mutex));
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't wait for condition variable"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Pass on the notifications and the error of JOB, which is done, to CTX
+   and release its resources. */
+static svn_error_t *
+report_external_job(external_job_t *job,
+                    svn_client_ctx_t *ctx,
+                    svn_boolean_t *timestamp_sleep,
+                    apr_pool_t *scratch_pool)
+{
+  svn_error_t *err = job->err;
+  int i;
+
+  job->err = SVN_NO_ERROR;
+
+  if (job->thread)
+    {
+      apr_status_t retval;
+      apr_status_t status = apr_thread_join(&retval, job->thread);
+
+      job->thread = NULL;
+      if (status)
+        err = svn_error_compose_create(
+                err, svn_error_wrap_apr(status,
+                                        _("Can't join externals thread")));
+    }
+
+  if (job->session_pool)
+    {
+      svn_pool_destroy(job->session_pool);
+      job->session_pool = NULL;
+    }
+
+  if (job->timestamp_sleep)
+    *timestamp_sleep = TRUE;
+
+  for (i = 0; ctx->notify_func2 && i < job->notifications->nelts; i++)
+    ctx->notify_func2(ctx->notify_baton2,
+                      APR_ARRAY_IDX(job->notifications, i,
+                                    svn_wc_notify_t *),
+                      scratch_pool);
+
+  svn_pool_destroy(job->pool);
+  job->pool = NULL;
+
+  return svn_error_trace(wrap_external_error(ctx, job->local_abspath, err,
+                                             scratch_pool));
+}
+
+/* Return TRUE if the externals JOB1 and JOB2 can't be handled at the same
+   time because one is inside the other. */
+static svn_boolean_t
+external_jobs_overlap(const external_job_t *job1,
+                      const external_job_t *job2)
+{
+  return (svn_dirent_is_ancestor(job1->local_abspath, job2->local_abspath)
+          || svn_dirent_is_ancestor(job2->local_abspath, job1->local_abspath));
+}
+
+/* Report the jobs of BATCH from *REPORTED up to UNTIL, in order, as soon
+   as they are done, and update *REPORTED.  Return when NEXT_JOB may be
+   started, i.e. when fewer than MAX_RUNNING jobs are running and none of
+   the jobs before it that it overlaps with are running, or when all jobs
+   before UNTIL have been reported if NEXT_JOB is NULL. */
+static svn_error_t *
+wait_external_jobs(int *reported,
+                   externals_batch_t *batch,
+                   int until,
+                   const external_job_t *next_job,
+                   int max_running,
+                   svn_boolean_t *timestamp_sleep,
+                   apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  while (TRUE)
+    {
+      external_job_t *job = NULL;
+      svn_boolean_t busy;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_mutex__lock(batch->mutex));
+
+      if (*reported < until)
+        {
+          job = APR_ARRAY_IDX(batch->jobs, *reported, external_job_t *);
+          if (!job->done)
+            job = NULL;
+        }
+
+      if (job)
+        busy = FALSE;
+      else if (!next_job)
+        busy = (*reported < until);
+      else
+        {
+          int i;
+
+          busy = (batch->running >= max_running);
+          for (i = *reported; !busy && i < until; i++)
+            {
+              const external_job_t *other
+                = APR_ARRAY_IDX(batch->jobs, i, external_job_t *);
+
+              busy = (other->started && !other->done
+                      && external_jobs_overlap(other, next_job));
+            }
+        }
+
+      if (busy)
+        SVN_ERR(svn_mutex__unlock(batch->mutex,
+                                  wait_externals_batch(batch)));
+      else
+        SVN_ERR(svn_mutex__unlock(batch->mutex, SVN_NO_ERROR));
+
+      if (job)
+        {
+          (*reported)++;
+          SVN_ERR(report_external_job(job, batch->ctx, timestamp_sleep,
+                                      iterpool));
+        }
+      else if (!busy)
+        break;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Check out or update the externals of BATCH, handling up to MAX_JOBS
+   directory externals on other threads at the same time.  Each of them
+   gets its own RA session and working copy context.  Everything the jobs
+   report is passed on to CTX in the order of the jobs. */
+static svn_error_t *
+run_externals_batch(externals_batch_t *batch,
+                    int max_jobs,
+                    svn_boolean_t *timestamp_sleep,
+                    svn_client_ctx_t *ctx,
+                    apr_pool_t *scratch_pool)
+{
+  int reported = 0;
+  svn_error_t *err = SVN_NO_ERROR;
+  apr_status_t status;
+  int i;
+
+  batch->ctx = ctx;
+  SVN_ERR(svn_mutex__init(&batch->mutex, TRUE, scratch_pool));
+  SVN_ERR(svn_mutex__init(&batch->callback_mutex, TRUE, scratch_pool));
+  status = apr_thread_cond_create(&batch->cond, scratch_pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create condition variable"));
+
+  for (i = 0; !err && i < batch->jobs->nelts; i++)
+    {
+      external_job_t *job = APR_ARRAY_IDX(batch->jobs, i, external_job_t *);
+
+      if (ctx->cancel_func)
+        {
+          err = ctx->cancel_func(ctx->cancel_baton);
+          if (err)
+            break;
+        }
+
+      err = wait_external_jobs(&reported, batch, i, job, max_jobs,
+                               timestamp_sleep, scratch_pool);
+      if (err)
+        break;
+
+      /* Find out what the external is on this thread, which owns the
+         client context, including its RA session pool. */
+      job->pool = svn_pool_create(NULL);
+      job->session_pool = svn_pool_create(NULL);
+      job->notifications = apr_array_make(job->pool, 16,
+                                          sizeof(svn_wc_notify_t *));
+      job->err = resolve_external_item(&job->new_url, &job->new_loc,
+                                       &job->ext_kind, &job->ra_session,
+                                       ctx, job->repos_root_url,
+                                       job->parent_dir_url, job->new_item,
+                                       NULL, job->session_pool);
+
+      if (!job->err && job->ext_kind == svn_node_dir)
+        {
+          job->ctx_pool = svn_pool_create(job->pool);
+          job->err = create_job_ctx(&job->ctx, job, job->ctx_pool);
+        }
+
+      if (!job->err && job->ext_kind == svn_node_dir)
+        {
+          err = svn_mutex__lock(batch->mutex);
+          if (err)
+            break;
+          job->started = TRUE;
+          batch->running++;
+          err = svn_mutex__unlock(batch->mutex, SVN_NO_ERROR);
+          if (err)
+            break;
+
+          status = apr_thread_create(&job->thread, NULL, external_job_thread,
+                                     job, job->pool);
+          if (status)
+            {
+              /* Just do it on this thread. */
+              job->thread = NULL;
+              external_job_thread(NULL, job);
+            }
+
+          continue;
+        }
+
+      if (!job->err)
+        {
+          /* File externals live in the working copy that defines them,
+             so handle them on this thread once everything before them is
+             done. */
+          err = wait_external_jobs(&reported, batch, i, NULL, max_jobs,
+                                   timestamp_sleep, scratch_pool);
+          if (err)
+            break;
+
+          job->err = apply_external_item_change(ctx, job->repos_root_url,
+                                                job->parent_dir_abspath,
+                                                job->local_abspath,
+                                                job->old_defining_abspath,
+                                                job->new_item, job->new_url,
+                                                job->new_loc, job->ext_kind,
+                                                job->ra_session,
+                                                timestamp_sleep,
+                                                job->pool);
+        }
+
+      job->done = TRUE;
+    }
+
+  if (!err)
+    err = wait_external_jobs(&reported, batch, batch->jobs->nelts, NULL,
+                             max_jobs, timestamp_sleep, scratch_pool);
+
+  if (err)
+    {
+      /* Wait for the running jobs and drop their results. */
+      svn_error_t *err2 = svn_mutex__lock(batch->mutex);
+
+      while (!err2 && batch->running > 0)
+        err2 = wait_externals_batch(batch);
+      err = svn_error_compose_create(err,
+                                     svn_mutex__unlock(batch->mutex, err2));
+
+      for (i = reported; i < batch->jobs->nelts; i++)
+        {
+          external_job_t *job = APR_ARRAY_IDX(batch->jobs, i,
+                                              external_job_t *);
+
+          if (job->pool)
+            {
+              job->notifications->nelts = 0;
+              svn_error_clear(job->err);
+              job->err = SVN_NO_ERROR;
+              svn_error_clear(report_external_job(job, ctx, timestamp_sleep,
+                                                  scratch_pool));
+            }
+        }
+    }
+
+  return svn_error_trace(err);
+}
+
+#endif /* APR_HAS_THREADS */
+
+/* Handle the externals NEW_DESC_TEXT defined on LOCAL_ABSPATH and remove
+   the ones handled from OLD_EXTERNALS.  If BATCH is not NULL, just add
+   them to BATCH, allocated in the pool of its array, instead. */
 static svn_error_t *
 handle_externals_change(svn_client_ctx_t *ctx,
                         const char *repos_root_url,
@@ -968,6 +1571,7 @@ handle_externals_change(svn_client_ctx_t *ctx,
                         svn_depth_t ambient_depth,
                         svn_depth_t requested_depth,
                         svn_ra_session_t *ra_session,
+                        externals_batch_t *batch,
                         apr_pool_t *scratch_pool)
 {
   apr_array_header_t *new_desc;
@@ -986,6 +1590,12 @@ handle_externals_change(svn_client_ctx_t *ctx,
           && requested_depth < svn_depth_infinity))
     return SVN_NO_ERROR;
 
+  if (batch)
+    {
+      local_abspath = apr_pstrdup(batch->jobs->pool, local_abspath);
+      scratch_pool = batch->jobs->pool;
+    }
+
   if (new_desc_text)
     SVN_ERR(svn_wc_parse_externals_description3(&new_desc, local_abspath,
                                                 new_desc_text,
@@ -1029,6 +1639,25 @@ handle_externals_change(svn_client_ctx_t *ctx,
 
       old_defining_abspath = svn_hash_gets(old_externals, target_abspath);
 
+      if (batch)
+        {
+          external_job_t *job = apr_pcalloc(batch->jobs->pool, sizeof(*job));
+
+          job->repos_root_url = repos_root_url;
+          job->local_abspath = apr_pstrdup(batch->jobs->pool, target_abspath);
+          job->parent_dir_abspath = local_abspath;
+          job->parent_dir_url = url;
+          job->old_defining_abspath = old_defining_abspath;
+          job->new_item = new_item;
+          job->batch = batch;
+          APR_ARRAY_PUSH(batch->jobs, external_job_t *) = job;
+
+          if (old_defining_abspath)
+            svn_hash_sets(old_externals, target_abspath, NULL);
+
+          continue;
+        }
+
       SVN_ERR(wrap_external_error(
                       ctx, target_abspath,
                       handle_external_item_change(ctx,
@@ -1066,11 +1695,22 @@ svn_client__handle_externals(apr_hash_t *externals_new,
   apr_hash_t *old_external_defs;
   apr_hash_index_t *hi;
   apr_pool_t *iterpool;
+  externals_batch_t *batch = NULL;
+  int max_jobs = get_externals_jobs(ctx);
 
   SVN_ERR_ASSERT(repos_root_url);
 
   iterpool = svn_pool_create(scratch_pool);
 
+  /* Collect the externals first if we may handle several of them at the
+     same time. */
+  if (max_jobs > 1)
+    {
+      batch = apr_pcalloc(scratch_pool, sizeof(*batch));
+      batch->jobs = apr_array_make(scratch_pool, 16,
+                                   sizeof(external_job_t *));
+    }
+
   SVN_ERR(svn_wc__externals_defined_below(&old_external_defs,
                                           ctx->wc_ctx, target_abspath,
                                           scratch_pool, iterpool));
@@ -1109,9 +1749,15 @@ svn_client__handle_externals(apr_hash_t *externals_new,
                                       local_abspath,
                                       desc_text, old_external_defs,
                                       ambient_depth, requested_depth,
-                                      ra_session, iterpool));
+                                      ra_session, batch, iterpool));
     }
 
+#if APR_HAS_THREADS
+  if (batch)
+    SVN_ERR(run_externals_batch(batch, max_jobs, timestamp_sleep, ctx,
+                                scratch_pool));
+#endif
+
   /* Remove the remaining externals */
   for (hi = apr_hash_first(scratch_pool, old_external_defs);
        hi;
@@ -31,6 +31,8 @@
 #include <apr_strings.h>
 #include <apr_hash.h>
 #include <apr_md5.h>
+#include <apr_thread_cond.h>
+#include <apr_thread_proc.h>
 
 #include "svn_hash.h"
 #include "svn_ra.h"
@@ -45,12 +47,14 @@
 #include "svn_io.h"
 #include "svn_sorts.h"
 #include "svn_props.h"
+#include "svn_config.h"
 
 #include "client.h"
 #include "private/svn_ra_private.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_magic.h"
+#include "private/svn_mutex.h"
 
 #include "svn_private_config.h"
 
@@ -74,26 +78,15 @@ typedef struct import_ctx_t
 } import_ctx_t;
 
 
-/* Apply LOCAL_ABSPATH's contents (as a delta against the empty string) to
-   FILE_BATON in EDITOR.  Use POOL for any temporary allocation.
-   PROPERTIES is the set of node properties set on this file.
-
-   Fill DIGEST with the md5 checksum of the sent file; DIGEST must be
-   at least APR_MD5_DIGESTSIZE bytes long. */
-
-/* ### how does this compare against svn_wc_transmit_text_deltas2() ??? */
-
+/* Set *CONTENTS to a stream of LOCAL_ABSPATH's contents in repository
+   normal form.  PROPERTIES is the set of node properties set on this file.
+   Use POOL for all allocations. */
 static svn_error_t *
-send_file_contents(const char *local_abspath,
-                   void *file_baton,
-                   const svn_delta_editor_t *editor,
+open_file_contents(svn_stream_t **contents,
+                   const char *local_abspath,
                    apr_hash_t *properties,
-                   unsigned char *digest,
                    apr_pool_t *pool)
 {
-  svn_stream_t *contents;
-  svn_txdelta_window_handler_t handler;
-  void *handler_baton;
   const svn_string_t *eol_style_val = NULL, *keywords_val = NULL;
   svn_boolean_t special = FALSE;
   svn_subst_eol_style_t eol_style;
@@ -111,10 +104,6 @@ send_file_contents(const char *local_abspath,
         special = TRUE;
     }
 
-  /* Get an editor func that wants to consume the delta stream. */
-  SVN_ERR(editor->apply_textdelta(file_baton, NULL, pool,
-                                  &handler, &handler_baton));
-
   if (eol_style_val)
     svn_subst_eol_style_from_value(&eol_style, &eol, eol_style_val->data);
   else
@@ -132,13 +121,13 @@ send_file_contents(const char *local_abspath,
 
   if (special)
     {
-      SVN_ERR(svn_subst_read_specialfile(&contents, local_abspath,
+      SVN_ERR(svn_subst_read_specialfile(contents, local_abspath,
                                          pool, pool));
     }
   else
     {
       /* Open the working copy file. */
-      SVN_ERR(svn_stream_open_readonly(&contents, local_abspath, pool, pool));
+      SVN_ERR(svn_stream_open_readonly(contents, local_abspath, pool, pool));
 
       /* If we have EOL styles or keywords, then detranslate the file. */
       if (svn_subst_translation_required(eol_style, eol, keywords,
@@ -159,15 +148,45 @@ send_file_contents(const char *local_abspath,
             eol = SVN_SUBST_NATIVE_EOL_STR;
 
           /* Wrap the working copy stream with a filter to detranslate it. */
-          contents = svn_subst_stream_translated(contents,
-                                                 eol,
-                                                 TRUE /* repair */,
-                                                 keywords,
-                                                 FALSE /* expand */,
-                                                 pool);
+          *contents = svn_subst_stream_translated(*contents,
+                                                  eol,
+                                                  TRUE /* repair */,
+                                                  keywords,
+                                                  FALSE /* expand */,
+                                                  pool);
         }
     }
 
+  return SVN_NO_ERROR;
+}
+
+/* Apply LOCAL_ABSPATH's contents (as a delta against the empty string) to
+   FILE_BATON in EDITOR.  Use POOL for any temporary allocation.
+   PROPERTIES is the set of node properties set on this file.
+
+   Fill DIGEST with the md5 checksum of the sent file; DIGEST must be
+   at least APR_MD5_DIGESTSIZE bytes long. */
+
+/* ### how does this compare against svn_wc_transmit_text_deltas2() ??? */
+
+static svn_error_t *
+send_file_contents(const char *local_abspath,
+                   void *file_baton,
+                   const svn_delta_editor_t *editor,
+                   apr_hash_t *properties,
+                   unsigned char *digest,
+                   apr_pool_t *pool)
+{
+  svn_stream_t *contents;
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+
+  SVN_ERR(open_file_contents(&contents, local_abspath, properties, pool));
+
+  /* Get an editor func that wants to consume the delta stream. */
+  SVN_ERR(editor->apply_textdelta(file_baton, NULL, pool,
+                                  &handler, &handler_baton));
+
   /* Send the file's contents to the delta-window handler. */
   return svn_error_trace(svn_txdelta_send_stream(contents, handler,
                                                  handler_baton, digest,
@@ -175,55 +194,77 @@ send_file_contents(const char *local_abspath,
 }
 
 
-/* Import file PATH as EDIT_PATH in the repository directory indicated
- * by DIR_BATON in EDITOR.
+/* Set *PROPERTIES and *MIMETYPE to the properties and the mime-type, if
+ * any, that the file LOCAL_ABSPATH with DIRENT gets when it is imported.
+ * Use MAGIC_COOKIE and AUTOPROPS as in import_ctx_t.
  *
- * Accumulate file paths and their batons in FILES, which must be
- * non-null.  (These are used to send postfix textdeltas later).
+ * Allocate the results in RESULT_POOL and use SCRATCH_POOL for temporary
+ * allocations.
+ */
+static svn_error_t *
+get_file_props(apr_hash_t **properties,
+               const char **mimetype,
+               const char *local_abspath,
+               const svn_io_dirent2_t *dirent,
+               svn_magic__cookie_t *magic_cookie,
+               apr_hash_t *autoprops,
+               svn_client_ctx_t *ctx,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  *mimetype = NULL;
+
+  /* If this is a special file, we need to set the svn:special
+     property and create a temporary detranslated version in order to
+     send to the server. */
+  if (dirent->special)
+    {
+      *properties = apr_hash_make(result_pool);
+      svn_hash_sets(*properties, SVN_PROP_SPECIAL,
+                    svn_string_create(SVN_PROP_BOOLEAN_TRUE, result_pool));
+      return SVN_NO_ERROR;
+    }
+
+  /* add automatic properties */
+  return svn_error_trace(svn_client__get_paths_auto_props(properties,
+                                                          mimetype,
+                                                          local_abspath,
+                                                          magic_cookie,
+                                                          autoprops,
+                                                          ctx, result_pool,
+                                                          scratch_pool));
+}
+
+/* Add LOCAL_ABSPATH as EDIT_PATH with PROPERTIES to the repository
+ * directory indicated by DIR_BATON in EDITOR and return the new file's
+ * baton in *FILE_BATON.  MIMETYPE is the mime-type to notify.
  *
  * If CTX->NOTIFY_FUNC is non-null, invoke it with CTX->NOTIFY_BATON
- * for each file.
+ * for the file.
  *
  * Use POOL for any temporary allocation.
  */
 static svn_error_t *
-import_file(const svn_delta_editor_t *editor,
-            void *dir_baton,
-            const char *local_abspath,
-            const char *edit_path,
-            const svn_io_dirent2_t *dirent,
-            import_ctx_t *import_ctx,
-            svn_client_ctx_t *ctx,
-            apr_pool_t *pool)
+add_file(void **file_baton,
+         const svn_delta_editor_t *editor,
+         void *dir_baton,
+         const char *local_abspath,
+         const char *edit_path,
+         apr_hash_t *properties,
+         const char *mimetype,
+         import_ctx_t *import_ctx,
+         svn_client_ctx_t *ctx,
+         apr_pool_t *pool)
 {
-  void *file_baton;
-  const char *mimetype = NULL;
-  unsigned char digest[APR_MD5_DIGESTSIZE];
-  const char *text_checksum;
-  apr_hash_t* properties;
   apr_hash_index_t *hi;
 
-  SVN_ERR(svn_path_check_valid(local_abspath, pool));
-
   /* Add the file, using the pool from the FILES hash. */
   SVN_ERR(editor->add_file(edit_path, dir_baton, NULL, SVN_INVALID_REVNUM,
-                           pool, &file_baton));
+                           pool, file_baton));
 
   /* Remember that the repository was modified */
   import_ctx->repos_changed = TRUE;
 
-  if (! dirent->special)
-    {
-      /* add automatic properties */
-      SVN_ERR(svn_client__get_paths_auto_props(&properties, &mimetype,
-                                               local_abspath,
-                                               import_ctx->magic_cookie,
-                                               import_ctx->autoprops,
-                                               ctx, pool, pool));
-    }
-  else
-    properties = apr_hash_make(pool);
-
   if (properties)
     {
       for (hi = apr_hash_first(pool, properties); hi; hi = apr_hash_next(hi))
@@ -231,7 +272,7 @@ import_file(const svn_delta_editor_t *editor,
           const char *pname = apr_hash_this_key(hi);
           const svn_string_t *pval = apr_hash_this_val(hi);
 
-          SVN_ERR(editor->change_file_prop(file_baton, pname, pval, pool));
+          SVN_ERR(editor->change_file_prop(*file_baton, pname, pval, pool));
         }
     }
 
@@ -248,18 +289,40 @@ import_file(const svn_delta_editor_t *editor,
       ctx->notify_func2(ctx->notify_baton2, notify, pool);
     }
 
-  /* If this is a special file, we need to set the svn:special
-     property and create a temporary detranslated version in order to
-     send to the server. */
-  if (dirent->special)
-    {
-      svn_hash_sets(properties, SVN_PROP_SPECIAL,
-                    svn_string_create(SVN_PROP_BOOLEAN_TRUE, pool));
-      SVN_ERR(editor->change_file_prop(file_baton, SVN_PROP_SPECIAL,
-                                       svn_hash_gets(properties,
-                                                     SVN_PROP_SPECIAL),
-                                       pool));
-    }
+  return SVN_NO_ERROR;
+}
+
+/* Import file PATH as EDIT_PATH in the repository directory indicated
+ * by DIR_BATON in EDITOR.
+ *
+ * If CTX->NOTIFY_FUNC is non-null, invoke it with CTX->NOTIFY_BATON
+ * for each file.
+ *
+ * Use POOL for any temporary allocation.
+ */
+static svn_error_t *
+import_file(const svn_delta_editor_t *editor,
+            void *dir_baton,
+            const char *local_abspath,
+            const char *edit_path,
+            const svn_io_dirent2_t *dirent,
+            import_ctx_t *import_ctx,
+            svn_client_ctx_t *ctx,
+            apr_pool_t *pool)
+{
+  void *file_baton;
+  const char *mimetype;
+  unsigned char digest[APR_MD5_DIGESTSIZE];
+  const char *text_checksum;
+  apr_hash_t* properties;
+
+  SVN_ERR(svn_path_check_valid(local_abspath, pool));
+
+  SVN_ERR(get_file_props(&properties, &mimetype, local_abspath, dirent,
+                         import_ctx->magic_cookie, import_ctx->autoprops,
+                         ctx, pool, pool));
+  SVN_ERR(add_file(&file_baton, editor, dir_baton, local_abspath, edit_path,
+                   properties, mimetype, import_ctx, ctx, pool));
 
   /* Now, transmit the file contents. */
   SVN_ERR(send_file_contents(local_abspath, file_baton, editor,
@@ -577,6 +640,612 @@ import_dir(const svn_delta_editor_t *editor,
 }
 
 
+#if APR_HAS_THREADS
+
+/* Default value of SVN_CONFIG_OPTION_IMPORT_JOBS. */
+#define IMPORT_JOBS_DEFAULT 4
+
+/* Upper limit for SVN_CONFIG_OPTION_IMPORT_JOBS. */
+#define IMPORT_JOBS_MAX 32
+
+/* Number of bytes of a prefetched file to keep in memory.  The rest goes
+   to a temporary file. */
+#define IMPORT_PREFETCH_MEMORY (1024 * 1024)
+
+/* Return the number of threads CTX allows an import to prepare files
+   with. */
+static int
+get_import_jobs(svn_client_ctx_t *ctx)
+{
+  svn_config_t *cfg = ctx->config
+                      ? svn_hash_gets(ctx->config, SVN_CONFIG_CATEGORY_CONFIG)
+                      : NULL;
+  apr_int64_t jobs;
+  svn_error_t *err;
+
+  err = svn_config_get_int64(cfg, &jobs, SVN_CONFIG_SECTION_MISCELLANY,
+                             SVN_CONFIG_OPTION_IMPORT_JOBS,
+                             IMPORT_JOBS_DEFAULT);
+  if (err)
+    {
+      svn_error_clear(err);
+      return 1;
+    }
+
+  if (jobs < 1)
+    return 1;
+  if (jobs > IMPORT_JOBS_MAX)
+    return IMPORT_JOBS_MAX;
+
+  return (int)jobs;
+}
+
+/* A file to import, prepared ahead of the editor drive by
+   import_children_parallel(). */
+typedef struct file_job_t
+{
+  const char *local_abspath;
+  const svn_io_dirent2_t *dirent;
+
+  /* The properties, mime-type, normal form contents and MD5 checksum of
+     the file, once it is prepared, and the error of preparing it. */
+  apr_hash_t *properties;
+  const char *mimetype;
+  svn_spillbuf_t *contents;
+  svn_checksum_t *md5_checksum;
+  svn_error_t *err;
+
+  /* Whether the file is prepared. */
+  svn_boolean_t done;
+
+  /* Pool for the results.  It is created and destroyed by the thread
+     driving the editor. */
+  apr_pool_t *pool;
+} file_job_t;
+
+/* What import_children_parallel() does at a step of the editor drive. */
+typedef enum import_action_t
+{
+  import_action_add_dir,
+  import_action_close_dir,
+  import_action_add_file,
+  import_action_skip
+} import_action_t;
+
+/* A step of the editor drive of import_children_parallel(). */
+typedef struct import_step_t
+{
+  import_action_t action;
+  const char *local_abspath;
+  const char *edit_path;
+
+  /* The file to add with IMPORT_ACTION_ADD_FILE. */
+  file_job_t *job;
+} import_step_t;
+
+/* Read the properties, the mime-type and the contents of the file of JOB
+   in normal form and compute their checksum, as import_file() would.
+   Use MAGIC_COOKIE and AUTOPROPS as in import_ctx_t.  Only read from CTX,
+   so that this may run in any thread. */
+static svn_error_t *
+prepare_file(file_job_t *job,
+             svn_magic__cookie_t *magic_cookie,
+             apr_hash_t *autoprops,
+             svn_client_ctx_t *ctx,
+             apr_pool_t *scratch_pool)
+{
+  svn_stream_t *contents;
+
+  SVN_ERR(svn_path_check_valid(job->local_abspath, scratch_pool));
+  SVN_ERR(get_file_props(&job->properties, &job->mimetype,
+                         job->local_abspath, job->dirent, magic_cookie,
+                         autoprops, ctx, job->pool, scratch_pool));
+
+  SVN_ERR(open_file_contents(&contents, job->local_abspath, job->properties,
+                             scratch_pool));
+  contents = svn_stream_checksummed2(contents, &job->md5_checksum, NULL,
+                                     svn_checksum_md5, TRUE, job->pool);
+
+  job->contents = svn_spillbuf__create(SVN__STREAM_CHUNK_SIZE,
+                                       IMPORT_PREFETCH_MEMORY, job->pool);
+  return svn_error_trace(svn_stream_copy3(
+                           contents,
+                           svn_stream__from_spillbuf(job->contents,
+                                                     scratch_pool),
+                           NULL, NULL, scratch_pool));
+}
+
+/* Add the file prepared in JOB as EDIT_PATH to the repository directory
+   indicated by DIR_BATON in EDITOR, like import_file() does. */
+static svn_error_t *
+import_prepared_file(const svn_delta_editor_t *editor,
+                     void *dir_baton,
+                     const char *edit_path,
+                     file_job_t *job,
+                     import_ctx_t *import_ctx,
+                     svn_client_ctx_t *ctx,
+                     apr_pool_t *pool)
+{
+  void *file_baton;
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+
+  SVN_ERR(add_file(&file_baton, editor, dir_baton, job->local_abspath,
+                   edit_path, job->properties, job->mimetype, import_ctx,
+                   ctx, pool));
+
+  SVN_ERR(editor->apply_textdelta(file_baton, NULL, pool,
+                                  &handler, &handler_baton));
+  SVN_ERR(svn_txdelta_send_stream(svn_stream__from_spillbuf(job->contents,
+                                                            pool),
+                                  handler, handler_baton, NULL, pool));
+
+  return svn_error_trace(editor->close_file(
+                           file_baton,
+                           svn_checksum_to_cstring(job->md5_checksum, pool),
+                           pool));
+}
+
+/* Append the steps of importing the children DIRENTS of DIR_ABSPATH as
+   EDIT_PATH to STEPS, an array of import_step_t, and their files to
+   JOBS, an array of file_job_t *, in the order import_children() would
+   visit them.  Filter and notify skipped children like import_children()
+   does, with the other arguments similar to import_dir().  Allocate the
+   steps and jobs in RESULT_POOL. */
+static svn_error_t *
+collect_import_steps(apr_array_header_t *steps,
+                     apr_array_header_t *jobs,
+                     const char *dir_abspath,
+                     const char *edit_path,
+                     apr_hash_t *dirents,
+                     svn_depth_t depth,
+                     apr_hash_t *excludes,
+                     apr_array_header_t *global_ignores,
+                     svn_boolean_t ignore_unknown_node_types,
+                     svn_client_import_filter_func_t filter_callback,
+                     void *filter_baton,
+                     svn_client_ctx_t *ctx,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *sorted_dirents;
+  int i;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  sorted_dirents = svn_sort__hash(dirents, svn_sort_compare_items_lexically,
+                                  scratch_pool);
+  for (i = 0; i < sorted_dirents->nelts; i++)
+    {
+      svn_sort__item_t item = APR_ARRAY_IDX(sorted_dirents, i,
+                                            svn_sort__item_t);
+      const char *filename = item.key;
+      const svn_io_dirent2_t *dirent = item.value;
+      import_step_t *step;
+
+      svn_pool_clear(iterpool);
+
+      if (ctx->cancel_func)
+        SVN_ERR(ctx->cancel_func(ctx->cancel_baton));
+
+      step = apr_array_push(steps);
+      step->local_abspath = svn_dirent_join(dir_abspath, filename,
+                                            result_pool);
+      step->edit_path = svn_relpath_join(edit_path, filename, result_pool);
+      step->job = NULL;
+
+      if (dirent->kind == svn_node_dir && depth >= svn_depth_immediates)
+        {
+          svn_depth_t depth_below_here = depth;
+          apr_hash_t *child_dirents;
+          const char *local_abspath = step->local_abspath;
+          const char *this_edit_path = step->edit_path;
+
+          if (depth == svn_depth_immediates)
+            depth_below_here = svn_depth_empty;
+
+          SVN_ERR(svn_path_check_valid(local_abspath, iterpool));
+          SVN_ERR(get_filtered_children(&child_dirents, local_abspath,
+                                        excludes, NULL, global_ignores,
+                                        filter_callback, filter_baton, ctx,
+                                        iterpool, iterpool));
+
+          step->action = import_action_add_dir;
+          SVN_ERR(collect_import_steps(steps, jobs, local_abspath,
+                                       this_edit_path, child_dirents,
+                                       depth_below_here, excludes,
+                                       global_ignores,
+                                       ignore_unknown_node_types,
+                                       filter_callback, filter_baton, ctx,
+                                       result_pool, iterpool));
+
+          step = apr_array_push(steps);
+          step->action = import_action_close_dir;
+          step->local_abspath = local_abspath;
+          step->edit_path = this_edit_path;
+          step->job = NULL;
+        }
+      else if (dirent->kind == svn_node_file && depth >= svn_depth_files)
+        {
+          step->action = import_action_add_file;
+          step->job = apr_pcalloc(result_pool, sizeof(*step->job));
+          step->job->local_abspath = step->local_abspath;
+          step->job->dirent = svn_io_dirent2_dup(dirent, result_pool);
+          APR_ARRAY_PUSH(jobs, file_job_t *) = step->job;
+        }
+      else if (dirent->kind != svn_node_dir && dirent->kind != svn_node_file)
+        {
+          if (ignore_unknown_node_types)
+            step->action = import_action_skip;
+          else
+            return svn_error_createf
+              (SVN_ERR_NODE_UNKNOWN_KIND, NULL,
+               _("Unknown or unversionable type for '%s'"),
+               svn_dirent_local_style(step->local_abspath, iterpool));
+        }
+      else
+        {
+          /* Excluded by DEPTH. */
+          apr_array_pop(steps);
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* The state shared by the workers of import_children_parallel(). */
+typedef struct file_batch_t
+{
+  /* The file_job_t * in the order their files are added, the number of
+     them that may be prepared, the index of the first one nobody prepares
+     yet, and whether to stop preparing.  These and the DONE and ERR
+     members of the jobs are protected by MUTEX, and COND is signaled when
+     any of them changes. */
+  apr_array_header_t *jobs;
+  int released;
+  int next_job;
+  svn_boolean_t stop;
+  svn_mutex__t *mutex;
+  apr_thread_cond_t *cond;
+
+  /* Read-only parameters of prepare_file(). */
+  apr_hash_t *autoprops;
+  svn_client_ctx_t *ctx;
+} file_batch_t;
+
+/* A thread preparing the files of a file_batch_t. */
+typedef struct file_worker_t
+{
+  file_batch_t *batch;
+
+  /* libmagic cookies must not be shared between threads. */
+  svn_magic__cookie_t *magic_cookie;
+
+  /* Root pool for everything the worker does. */
+  apr_pool_t *pool;
+  apr_thread_t *thread;
+} file_worker_t;
+
+/* Wait for COND of BATCH, whose mutex the caller must hold. */
+static svn_error_t *
+wait_for_file_batch(file_batch_t *batch)
+{
+  apr_status_t status = apr_thread_cond_wait(batch->cond,
+                                             svn_mutex__get(batch->mutex));
+
+  if (status)
+    return svn_error_wrap_apr(status,
+                              _("Can't wait for condition variable"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread function.  Prepare the released files of the batch of the
+   file_worker_t DATA until all of them are prepared or the batch is
+   stopped. */
+static void * APR_THREAD_FUNC
+file_worker_thread(apr_thread_t *tid,
+                   void *data)
+{
+  file_worker_t *worker = data;
+  file_batch_t *batch = worker->batch;
+  apr_pool_t *iterpool = svn_pool_create(worker->pool);
+
+  while (TRUE)
+    {
+      file_job_t *job = NULL;
+      svn_error_t *job_err;
+      svn_error_t *err = svn_mutex__lock(batch->mutex);
+
+      while (!err && !batch->stop && batch->next_job >= batch->released
+             && batch->next_job < batch->jobs->nelts)
+        err = wait_for_file_batch(batch);
+
+      if (!err && !batch->stop && batch->next_job < batch->released)
+        job = APR_ARRAY_IDX(batch->jobs, batch->next_job++, file_job_t *);
+      err = svn_mutex__unlock(batch->mutex, err);
+      if (err || !job)
+        {
+          svn_error_clear(err);
+          break;
+        }
+
+      svn_pool_clear(iterpool);
+      job_err = prepare_file(job, worker->magic_cookie, batch->autoprops,
+                             batch->ctx, iterpool);
+
+      err = svn_mutex__lock(batch->mutex);
+      job->err = job_err;
+      job->done = TRUE;
+      if (!err)
+        apr_thread_cond_broadcast(batch->cond);
+      svn_error_clear(svn_mutex__unlock(batch->mutex, err));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return NULL;
+}
+
+#endif /* APR_HAS_THREADS */
+
+/* Import the children DIRENTS of DIR_ABSPATH like import_children()
+ * does, but walk the whole tree first and prepare the files that come
+ * next on up to SVN_CONFIG_OPTION_IMPORT_JOBS threads while the editor
+ * receives the current one.  The threads detect the mime-types, evaluate
+ * the autoprops and read the files in normal form into memory or, if
+ * they are large, into temporary files.  The editor is driven by this
+ * thread only, in the same order as import_children() does, and this
+ * thread releases up to twice as many files as there are threads ahead
+ * of time.
+ *
+ * Set *IMPORTED to FALSE, without doing anything, if the children should
+ * be imported one after the other instead.
+ */
+static svn_error_t *
+import_children_parallel(svn_boolean_t *imported,
+                         const char *dir_abspath,
+                         const char *edit_path,
+                         apr_hash_t *dirents,
+                         const svn_delta_editor_t *editor,
+                         void *dir_baton,
+                         svn_depth_t depth,
+                         apr_hash_t *excludes,
+                         apr_array_header_t *global_ignores,
+                         svn_boolean_t ignore_unknown_node_types,
+                         svn_client_import_filter_func_t filter_callback,
+                         void *filter_baton,
+                         import_ctx_t *import_ctx,
+                         svn_client_ctx_t *ctx,
+                         apr_pool_t *scratch_pool)
+{
+#if APR_HAS_THREADS
+  int max_jobs = get_import_jobs(ctx);
+  file_batch_t batch = { 0 };
+  apr_array_header_t *steps;
+  apr_array_header_t *workers;
+  apr_array_header_t *dir_batons;
+  apr_pool_t *iterpool;
+  apr_status_t status;
+  svn_error_t *err = SVN_NO_ERROR;
+  svn_error_t *lock_err;
+  int i, file_index;
+
+  *imported = FALSE;
+
+  if (max_jobs < 2)
+    return SVN_NO_ERROR;
+
+  steps = apr_array_make(scratch_pool, 16, sizeof(import_step_t));
+  batch.jobs = apr_array_make(scratch_pool, 16, sizeof(file_job_t *));
+  SVN_ERR(collect_import_steps(steps, batch.jobs, dir_abspath, edit_path,
+                               dirents, depth, excludes, global_ignores,
+                               ignore_unknown_node_types, filter_callback,
+                               filter_baton, ctx, scratch_pool,
+                               scratch_pool));
+
+  /* All of the work is done by the editor. */
+  if (batch.jobs->nelts < 2)
+    return SVN_NO_ERROR;
+
+  batch.autoprops = import_ctx->autoprops;
+  batch.ctx = ctx;
+  SVN_ERR(svn_mutex__init(&batch.mutex, TRUE, scratch_pool));
+  status = apr_thread_cond_create(&batch.cond, scratch_pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create condition variable"));
+
+  /* If we can't start as many workers as we'd like, the ones we have do
+     all the work. */
+  max_jobs = MIN(max_jobs, batch.jobs->nelts);
+  workers = apr_array_make(scratch_pool, max_jobs, sizeof(file_worker_t *));
+  for (i = 0; i < max_jobs; i++)
+    {
+      file_worker_t *worker = apr_pcalloc(scratch_pool, sizeof(*worker));
+
+      worker->batch = &batch;
+      worker->pool = svn_pool_create(NULL);
+
+      err = svn_magic__init(&worker->magic_cookie, ctx->config,
+                            worker->pool);
+      if (err)
+        {
+          svn_error_clear(err);
+          err = SVN_NO_ERROR;
+          svn_pool_destroy(worker->pool);
+          break;
+        }
+
+      status = apr_thread_create(&worker->thread, NULL, file_worker_thread,
+                                 worker, worker->pool);
+      if (status)
+        {
+          svn_pool_destroy(worker->pool);
+          break;
+        }
+
+      APR_ARRAY_PUSH(workers, file_worker_t *) = worker;
+    }
+
+  if (workers->nelts == 0)
+    return SVN_NO_ERROR;
+
+  *imported = TRUE;
+
+  dir_batons = apr_array_make(scratch_pool, 8, sizeof(void *));
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0, file_index = 0; i < steps->nelts; i++)
+    {
+      const import_step_t *step = &APR_ARRAY_IDX(steps, i, import_step_t);
+      file_job_t *job = step->job;
+
+      svn_pool_clear(iterpool);
+
+      if (ctx->cancel_func)
+        {
+          err = ctx->cancel_func(ctx->cancel_baton);
+          if (err)
+            break;
+        }
+
+      if (step->action == import_action_add_dir)
+        {
+          void *this_dir_baton;
+
+          err = editor->add_directory(step->edit_path, dir_baton, NULL,
+                                      SVN_INVALID_REVNUM, scratch_pool,
+                                      &this_dir_baton);
+          if (err)
+            break;
+
+          /* Remember that the repository was modified */
+          import_ctx->repos_changed = TRUE;
+
+          if (ctx->notify_func2)
+            {
+              svn_wc_notify_t *notify
+                = svn_wc_create_notify(step->local_abspath,
+                                       svn_wc_notify_commit_added,
+                                       iterpool);
+              notify->kind = svn_node_dir;
+              notify->content_state = notify->prop_state
+                = svn_wc_notify_state_inapplicable;
+              notify->lock_state = svn_wc_notify_lock_state_inapplicable;
+              ctx->notify_func2(ctx->notify_baton2, notify, iterpool);
+            }
+
+          APR_ARRAY_PUSH(dir_batons, void *) = dir_baton;
+          dir_baton = this_dir_baton;
+        }
+      else if (step->action == import_action_close_dir)
+        {
+          err = editor->close_directory(dir_baton, iterpool);
+          if (err)
+            break;
+
+          dir_baton = *(void **)apr_array_pop(dir_batons);
+        }
+      else if (step->action == import_action_skip)
+        {
+          if (ctx->notify_func2)
+            {
+              svn_wc_notify_t *notify
+                = svn_wc_create_notify(step->local_abspath,
+                                       svn_wc_notify_skip, iterpool);
+              notify->kind = svn_node_dir;
+              notify->content_state = notify->prop_state
+                = svn_wc_notify_state_inapplicable;
+              notify->lock_state = svn_wc_notify_lock_state_inapplicable;
+              ctx->notify_func2(ctx->notify_baton2, notify, iterpool);
+            }
+        }
+      else
+        {
+          int released = MIN(batch.jobs->nelts,
+                             file_index + 1 + 2 * workers->nelts);
+
+          /* Keep the workers busy. */
+          if (batch.released < released)
+            {
+              int k;
+
+              for (k = batch.released; k < released; k++)
+                APR_ARRAY_IDX(batch.jobs, k, file_job_t *)->pool
+                  = svn_pool_create(NULL);
+
+              err = svn_mutex__lock(batch.mutex);
+              batch.released = released;
+              if (!err)
+                apr_thread_cond_broadcast(batch.cond);
+              err = svn_mutex__unlock(batch.mutex, err);
+              if (err)
+                break;
+            }
+
+          err = svn_mutex__lock(batch.mutex);
+          while (!err && !job->done)
+            err = wait_for_file_batch(&batch);
+          err = svn_mutex__unlock(batch.mutex, err);
+          if (err)
+            break;
+
+          err = job->err;
+          job->err = SVN_NO_ERROR;
+          if (!err)
+            err = import_prepared_file(editor, dir_baton, step->edit_path,
+                                       job, import_ctx, ctx, iterpool);
+          if (err)
+            break;
+
+          /* Release the memory and the temporary file. */
+          svn_pool_destroy(job->pool);
+          job->pool = NULL;
+          file_index++;
+        }
+    }
+  svn_pool_destroy(iterpool);
+
+  /* Let the workers finish what they are doing, but nothing more. */
+  lock_err = svn_mutex__lock(batch.mutex);
+  batch.stop = TRUE;
+  if (!lock_err)
+    {
+      apr_thread_cond_broadcast(batch.cond);
+      lock_err = svn_mutex__unlock(batch.mutex, SVN_NO_ERROR);
+    }
+  err = svn_error_compose_create(err, lock_err);
+
+  for (i = 0; i < workers->nelts; i++)
+    {
+      file_worker_t *worker = APR_ARRAY_IDX(workers, i, file_worker_t *);
+      apr_status_t retval;
+
+      /* The thread doesn't use its pool after it is done, so there is
+         nothing to do if this fails. */
+      apr_thread_join(&retval, worker->thread);
+    }
+
+  for (i = 0; i < batch.jobs->nelts; i++)
+    {
+      file_job_t *job = APR_ARRAY_IDX(batch.jobs, i, file_job_t *);
+
+      svn_error_clear(job->err);
+      if (job->pool)
+        svn_pool_destroy(job->pool);
+    }
+
+  for (i = 0; i < workers->nelts; i++)
+    svn_pool_destroy(APR_ARRAY_IDX(workers, i, file_worker_t *)->pool);
+
+  return svn_error_trace(err);
+#else
+  *imported = FALSE;
+
+  return SVN_NO_ERROR;
+#endif
+}
+
+
 /* Recursively import PATH to a repository using EDITOR and
  * EDIT_BATON.  PATH can be a file or directory.
  *
@@ -732,6 +1401,7 @@ import(svn_boolean_t *updated_repository,
   else if (dirent->kind == svn_node_dir)
     {
       apr_hash_t *dirents;
+      svn_boolean_t imported;
 
       /* If we are creating a new repository directory path to import to,
          then we disregard any svn:ignore property. */
@@ -743,11 +1413,18 @@ import(svn_boolean_t *updated_repository,
                                     filter_callback, filter_baton, ctx,
                                     pool, pool));
 
-      SVN_ERR(import_children(local_abspath, edit_path, dirents, editor,
-                              root_baton, depth, excludes, global_ignores,
-                              no_ignore, no_autoprops,
-                              ignore_unknown_node_types, filter_callback,
-                              filter_baton, &import_ctx, ctx, pool));
+      SVN_ERR(import_children_parallel(&imported, local_abspath, edit_path,
+                                       dirents, editor, root_baton, depth,
+                                       excludes, global_ignores,
+                                       ignore_unknown_node_types,
+                                       filter_callback, filter_baton,
+                                       &import_ctx, ctx, pool));
+      if (!imported)
+        SVN_ERR(import_children(local_abspath, edit_path, dirents, editor,
+                                root_baton, depth, excludes, global_ignores,
+                                no_ignore, no_autoprops,
+                                ignore_unknown_node_types, filter_callback,
+                                filter_baton, &import_ctx, ctx, pool));
 
     }
   else if (dirent->kind == svn_node_none
@@ -31,6 +31,7 @@
 #include <apr_strings.h>
 #include <apr_tables.h>
 #include <apr_hash.h>
+#include <apr_thread_proc.h>
 #include "svn_types.h"
 #include "svn_hash.h"
 #include "svn_wc.h"
@@ -55,6 +56,7 @@
 #include "mergeinfo.h"
 
 #include "private/svn_fspath.h"
+#include "private/svn_mutex.h"
 #include "private/svn_mergeinfo_private.h"
 #include "private/svn_client_private.h"
 #include "private/svn_sorts_private.h"
@@ -4969,6 +4971,328 @@ find_gaps_in_merge_source_history(svn_revnum_t *gap_start,
   return SVN_NO_ERROR;
 }
 
+/* Default value of SVN_CONFIG_OPTION_MERGE_JOBS. */
+#define MERGE_JOBS_DEFAULT 4
+
+/* Upper limit for SVN_CONFIG_OPTION_MERGE_JOBS. */
+#define MERGE_JOBS_MAX 32
+
+/* Return the number of connections to the repository CTX allows a merge
+   to use at the same time. */
+static int
+get_merge_jobs(svn_client_ctx_t *ctx)
+{
+#if APR_HAS_THREADS
+  svn_config_t *cfg = ctx->config
+                      ? svn_hash_gets(ctx->config, SVN_CONFIG_CATEGORY_CONFIG)
+                      : NULL;
+  apr_int64_t jobs;
+  svn_error_t *err;
+
+  err = svn_config_get_int64(cfg, &jobs, SVN_CONFIG_SECTION_MISCELLANY,
+                             SVN_CONFIG_OPTION_MERGE_JOBS,
+                             MERGE_JOBS_DEFAULT);
+  if (err)
+    {
+      svn_error_clear(err);
+      return 1;
+    }
+
+  if (jobs < 1)
+    return 1;
+  if (jobs > MERGE_JOBS_MAX)
+    return MERGE_JOBS_MAX;
+
+  return (int)jobs;
+#else
+  return 1;
+#endif
+}
+
+#if APR_HAS_THREADS
+
+/* The natural history of a merge path, to be fetched on another thread. */
+typedef struct history_job_t
+{
+  /* The merge path that gets this history as its IMPLICIT_MERGEINFO. */
+  svn_client__merge_path_t *child;
+
+  /* What to ask for, as for svn_client__get_history_as_mergeinfo(). */
+  svn_client__pathrev_t *pathrev;
+  svn_revnum_t range_youngest;
+  svn_revnum_t range_oldest;
+
+  /* The answer, allocated in the pool of the worker that fetched it, or
+     NULL if that failed. */
+  svn_mergeinfo_t mergeinfo;
+} history_job_t;
+
+/* The natural histories to fetch for populate_remaining_ranges(). */
+typedef struct history_batch_t
+{
+  /* Array of history_job_t *. */
+  apr_array_header_t *jobs;
+
+  /* Index of the next job nobody works on yet, protected by MUTEX. */
+  int next;
+  svn_mutex__t *mutex;
+
+  /* The client context of the caller, whose progress callback the
+     workers may use only while holding CALLBACK_MUTEX. */
+  svn_client_ctx_t *ctx;
+  svn_mutex__t *callback_mutex;
+} history_batch_t;
+
+/* A thread fetching the jobs of a history_batch_t over its own RA
+   session. */
+typedef struct history_worker_t
+{
+  history_batch_t *batch;
+  svn_client_ctx_t *ctx;
+  svn_ra_session_t *ra_session;
+
+  /* Root pool for everything the worker does, including its results. */
+  apr_pool_t *pool;
+  apr_thread_t *thread;
+} history_worker_t;
+
+/* Implements svn_ra_progress_notify_func_t.  Pass the progress on to the
+   client context of the history_batch_t BATON, one thread at a time. */
+static void
+serialized_history_progress_func(apr_off_t progress,
+                                 apr_off_t total,
+                                 void *baton,
+                                 apr_pool_t *pool)
+{
+  history_batch_t *batch = baton;
+  svn_error_t *err = svn_mutex__lock(batch->callback_mutex);
+
+  if (err)
+    {
+      svn_error_clear(err);
+      return;
+    }
+
+  batch->ctx->progress_func(progress, total, batch->ctx->progress_baton,
+                            pool);
+  svn_error_clear(svn_mutex__unlock(batch->callback_mutex, SVN_NO_ERROR));
+}
+
+/* Create a client context for WORKER in WORKER->CTX, which notifies
+   nothing and passes its progress on to the context of its batch.  It
+   shares the auth baton of that context, which serializes asking for
+   credentials between the workers. */
+static svn_error_t *
+create_history_worker_ctx(history_worker_t *worker)
+{
+  history_batch_t *batch = worker->batch;
+  svn_client_ctx_t *ctx;
+  svn_wc_context_t *wc_ctx;
+
+  SVN_ERR(svn_client_create_context2(&ctx, batch->ctx->config,
+                                     worker->pool));
+
+  wc_ctx = ctx->wc_ctx;
+  *ctx = *batch->ctx;
+  ctx->wc_ctx = wc_ctx;
+
+  ctx->notify_func = NULL;
+  ctx->notify_baton = NULL;
+  ctx->notify_func2 = NULL;
+  ctx->notify_baton2 = NULL;
+
+  if (ctx->progress_func)
+    {
+      ctx->progress_func = serialized_history_progress_func;
+      ctx->progress_baton = batch;
+    }
+
+  worker->ctx = ctx;
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread function.  Fetch the jobs of the batch of the history_worker_t
+   DATA until there are none left. */
+static void * APR_THREAD_FUNC
+history_worker_thread(apr_thread_t *tid,
+                      void *data)
+{
+  history_worker_t *worker = data;
+  history_batch_t *batch = worker->batch;
+
+  while (TRUE)
+    {
+      history_job_t *job = NULL;
+      svn_error_t *err = svn_mutex__lock(batch->mutex);
+
+      if (!err && batch->next < batch->jobs->nelts)
+        job = APR_ARRAY_IDX(batch->jobs, batch->next++, history_job_t *);
+      err = svn_mutex__unlock(batch->mutex, err);
+      if (err || !job)
+        {
+          svn_error_clear(err);
+          break;
+        }
+
+      err = svn_client__get_history_as_mergeinfo(&job->mergeinfo, NULL,
+                                                 job->pathrev,
+                                                 job->range_youngest,
+                                                 job->range_oldest,
+                                                 worker->ra_session,
+                                                 worker->ctx, worker->pool);
+      if (err)
+        {
+          /* The caller asks again and reports the error where it would
+             have reported it without us. */
+          job->mergeinfo = NULL;
+          if (err->apr_err == SVN_ERR_CANCELLED)
+            {
+              svn_error_clear(err);
+              break;
+            }
+          svn_error_clear(err);
+        }
+    }
+
+  return NULL;
+}
+
+#endif /* APR_HAS_THREADS */
+
+/* Helper for populate_remaining_ranges().
+
+   Fetch the implicit mergeinfo (natural history) between SOURCE->rev1 and
+   SOURCE->rev2 of the merge target and of the switched subtrees in
+   CHILDREN_WITH_MERGEINFO, which populate_remaining_ranges() would
+   otherwise fetch one after the other, over up to
+   SVN_CONFIG_OPTION_MERGE_JOBS RA sessions at the same time.  Store it
+   as each child's implicit_mergeinfo, allocated in RESULT_POOL.
+
+   Children whose history can't be fetched here are left alone, so that
+   the caller fetches it as before and reports any error in order. */
+static svn_error_t *
+prefetch_implicit_mergeinfo(apr_array_header_t *children_with_mergeinfo,
+                            const merge_source_t *source,
+                            svn_client_ctx_t *ctx,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool)
+{
+#if APR_HAS_THREADS
+  int max_jobs = get_merge_jobs(ctx);
+  svn_revnum_t youngest = MAX(source->loc1->rev, source->loc2->rev);
+  svn_revnum_t oldest = MIN(source->loc1->rev, source->loc2->rev);
+  history_batch_t batch = { 0 };
+  apr_array_header_t *workers;
+  int i;
+
+  if (max_jobs < 2 || youngest == oldest)
+    return SVN_NO_ERROR;
+
+  batch.jobs = apr_array_make(scratch_pool, 4, sizeof(history_job_t *));
+  for (i = 0; i < children_with_mergeinfo->nelts; i++)
+    {
+      svn_client__merge_path_t *child =
+        APR_ARRAY_IDX(children_with_mergeinfo, i, svn_client__merge_path_t *);
+      svn_client__pathrev_t *origin;
+      history_job_t *job;
+
+      /* All other subtrees inherit their parent's implicit mergeinfo,
+         see ensure_implicit_mergeinfo(). */
+      if (child->absent || child->implicit_mergeinfo
+          || (i > 0 && !child->switched))
+        continue;
+
+      /* As in get_full_mergeinfo(), locally added nodes and nodes outside
+         the range have no history to ask for. */
+      SVN_ERR(svn_client__wc_node_get_origin(&origin, child->abspath, ctx,
+                                             scratch_pool, scratch_pool));
+      if (!origin || origin->rev <= oldest)
+        continue;
+
+      job = apr_pcalloc(scratch_pool, sizeof(*job));
+      job->child = child;
+      job->pathrev = origin;
+      job->range_youngest = MIN(youngest, origin->rev);
+      job->range_oldest = oldest;
+      APR_ARRAY_PUSH(batch.jobs, history_job_t *) = job;
+    }
+
+  /* A single request doesn't gain anything from another thread. */
+  if (batch.jobs->nelts < 2)
+    return SVN_NO_ERROR;
+
+  batch.ctx = ctx;
+  SVN_ERR(svn_mutex__init(&batch.mutex, TRUE, scratch_pool));
+  SVN_ERR(svn_mutex__init(&batch.callback_mutex, TRUE, scratch_pool));
+
+  /* Open the sessions on this thread, which owns CTX.  If we can't start
+     as many workers as we'd like, the ones we have do all the work. */
+  workers = apr_array_make(scratch_pool, max_jobs,
+                           sizeof(history_worker_t *));
+  for (i = 0; i < MIN(max_jobs, batch.jobs->nelts); i++)
+    {
+      history_worker_t *worker = apr_pcalloc(scratch_pool, sizeof(*worker));
+      svn_error_t *err;
+      apr_status_t status;
+
+      worker->batch = &batch;
+      worker->pool = svn_pool_create(NULL);
+      APR_ARRAY_PUSH(workers, history_worker_t *) = worker;
+
+      err = create_history_worker_ctx(worker);
+      if (!err)
+        err = svn_client_open_ra_session2(&worker->ra_session,
+                                          source->loc1->repos_root_url,
+                                          NULL, worker->ctx,
+                                          worker->pool, worker->pool);
+      if (err)
+        {
+          svn_error_clear(err);
+          break;
+        }
+
+      status = apr_thread_create(&worker->thread, NULL,
+                                 history_worker_thread, worker,
+                                 worker->pool);
+      if (status)
+        {
+          worker->thread = NULL;
+          break;
+        }
+    }
+
+  for (i = 0; i < workers->nelts; i++)
+    {
+      history_worker_t *worker = APR_ARRAY_IDX(workers, i,
+                                               history_worker_t *);
+
+      if (worker->thread)
+        {
+          apr_status_t retval;
+
+          /* The thread doesn't use its pool after it is done, so there
+             is nothing to do if this fails. */
+          apr_thread_join(&retval, worker->thread);
+        }
+    }
+
+  for (i = 0; i < batch.jobs->nelts; i++)
+    {
+      history_job_t *job = APR_ARRAY_IDX(batch.jobs, i, history_job_t *);
+
+      if (job->mergeinfo)
+        job->child->implicit_mergeinfo = svn_mergeinfo_dup(job->mergeinfo,
+                                                           result_pool);
+    }
+
+  for (i = 0; i < workers->nelts; i++)
+    svn_pool_destroy(APR_ARRAY_IDX(workers, i, history_worker_t *)->pool);
+#endif
+
+  return SVN_NO_ERROR;
+}
+
 /* Helper for do_directory_merge().
 
    For each (svn_client__merge_path_t *) child in CHILDREN_WITH_MERGEINFO,
@@ -5012,6 +5336,10 @@ populate_remaining_ranges(apr_array_header_t *children_with_mergeinfo,
      ranges for all children. */
   if (! HONOR_MERGEINFO(merge_b) || merge_b->record_only)
     {
+      SVN_ERR(prefetch_implicit_mergeinfo(children_with_mergeinfo, source,
+                                          merge_b->ctx, result_pool,
+                                          iterpool));
+
       for (i = 0; i < children_with_mergeinfo->nelts; i++)
         {
           svn_client__merge_path_t *child =
@@ -5026,17 +5354,16 @@ populate_remaining_ranges(apr_array_header_t *children_with_mergeinfo,
              mergeinfo -- see filter_natural_history_from_mergeinfo(). */
           if (i == 0) /* First item is always the merge target. */
             {
-              SVN_ERR(get_full_mergeinfo(NULL, /* child->pre_merge_mergeinfo */
-                                         &(child->implicit_mergeinfo),
-                                         NULL, /* child->inherited_mergeinfo */
-                                         svn_mergeinfo_inherited, ra_session,
-                                         child->abspath,
-                                         MAX(source->loc1->rev,
-                                             source->loc2->rev),
-                                         MIN(source->loc1->rev,
-                                             source->loc2->rev),
-                                         merge_b->ctx, result_pool,
-                                         iterpool));
+              if (! child->implicit_mergeinfo)
+                SVN_ERR(get_full_mergeinfo(
+                          NULL, /* child->pre_merge_mergeinfo */
+                          &(child->implicit_mergeinfo),
+                          NULL, /* child->inherited_mergeinfo */
+                          svn_mergeinfo_inherited, ra_session,
+                          child->abspath,
+                          MAX(source->loc1->rev, source->loc2->rev),
+                          MIN(source->loc1->rev, source->loc2->rev),
+                          merge_b->ctx, result_pool, iterpool));
             }
           else
             {
@@ -5087,6 +5414,11 @@ populate_remaining_ranges(apr_array_header_t *children_with_mergeinfo,
                                             ra_session, merge_b->ctx,
                                             iterpool));
 
+  /* Ask for the natural history of all paths that can't inherit it from
+     their parent at once, rather than one by one in the loop below. */
+  SVN_ERR(prefetch_implicit_mergeinfo(children_with_mergeinfo, source,
+                                      merge_b->ctx, result_pool, iterpool));
+
   /* Stash any gap in the merge command baton, we'll need it later when
      recording mergeinfo describing this merge. */
   if (SVN_IS_VALID_REVNUM(gap_start) && SVN_IS_VALID_REVNUM(gap_end))
@@ -5131,8 +5463,9 @@ populate_remaining_ranges(apr_array_header_t *children_with_mergeinfo,
          expensive round trip communication with the server. */
       SVN_ERR(get_full_mergeinfo(
         child->pre_merge_mergeinfo ? NULL : &(child->pre_merge_mergeinfo),
-        /* Get implicit only for merge target. */
-        (i == 0) ? &(child->implicit_mergeinfo) : NULL,
+        /* Get implicit only for merge target, unless we already have it. */
+        (i == 0 && !child->implicit_mergeinfo)
+          ? &(child->implicit_mergeinfo) : NULL,
         &(child->inherited_mergeinfo),
         svn_mergeinfo_inherited, ra_session,
         child->abspath,
@@ -10572,7 +10905,8 @@ svn_client__merge_locked(svn_client__conflict_report_t **conflict_report,
           svn_pool_destroy(sesspool);
 
           if (use_sleep)
-            svn_io_sleep_for_timestamps(target->abspath, scratch_pool);
+            svn_wc__settle_timestamps(ctx->wc_ctx, target->abspath,
+                                      scratch_pool);
 
           SVN_ERR(err);
           return SVN_NO_ERROR;
@@ -10597,7 +10931,7 @@ svn_client__merge_locked(svn_client__conflict_report_t **conflict_report,
   svn_pool_destroy(sesspool);
 
   if (use_sleep)
-    svn_io_sleep_for_timestamps(target->abspath, scratch_pool);
+    svn_wc__settle_timestamps(ctx->wc_ctx, target->abspath, scratch_pool);
 
   SVN_ERR(err);
   return SVN_NO_ERROR;
@@ -11768,7 +12102,7 @@ merge_reintegrate_locked(svn_client__conflict_report_t **conflict_report,
                                                result_pool, scratch_pool);
 
   if (use_sleep)
-    svn_io_sleep_for_timestamps(target_abspath, scratch_pool);
+    svn_wc__settle_timestamps(ctx->wc_ctx, target_abspath, scratch_pool);
 
   SVN_ERR(err);
   return SVN_NO_ERROR;
@@ -11892,7 +12226,7 @@ merge_peg_locked(svn_client__conflict_report_t **conflict_report,
   svn_pool_destroy(sesspool);
 
   if (use_sleep)
-    svn_io_sleep_for_timestamps(target_abspath, scratch_pool);
+    svn_wc__settle_timestamps(ctx->wc_ctx, target_abspath, scratch_pool);
 
   SVN_ERR(err);
   return SVN_NO_ERROR;
@@ -12815,7 +13149,7 @@ do_automatic_merge_locked(svn_client__conflict_report_t **conflict_report,
     }
 
   if (use_sleep)
-    svn_io_sleep_for_timestamps(target_abspath, scratch_pool);
+    svn_wc__settle_timestamps(ctx->wc_ctx, target_abspath, scratch_pool);
 
   SVN_ERR(err);
 
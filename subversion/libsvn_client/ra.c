@@ -42,6 +42,7 @@
 #include "svn_private_config.h"
 #include "private/svn_wc_private.h"
 #include "private/svn_client_private.h"
+#include "private/svn_ra_private.h"
 #include "private/svn_sorts_private.h"
 
 
@@ -73,6 +74,9 @@ typedef struct callback_baton_t
 
   /* Last progress reported by progress callback. */
   apr_off_t last_progress;
+
+  /* Whether an operation on the session got cancelled. */
+  svn_boolean_t cancelled;
 } callback_baton_t;
 
 
@@ -276,7 +280,12 @@ static svn_error_t *
 cancel_callback(void *baton)
 {
   callback_baton_t *b = baton;
-  return svn_error_trace((b->ctx->cancel_func)(b->ctx->cancel_baton));
+  svn_error_t *err = (b->ctx->cancel_func)(b->ctx->cancel_baton);
+
+  if (err)
+    b->cancelled = TRUE;
+
+  return svn_error_trace(err);
 }
 
 
@@ -316,6 +325,138 @@ progress_func(apr_off_t progress,
     }
 }
 
+/* Maximum number of idle RA sessions kept in a client context. */
+#define MAX_IDLE_RA_SESSIONS 8
+
+/* An RA session that gets reused by later operations of the same client
+   context once the operation that opened it is done with it. */
+typedef struct pooled_ra_session_t
+{
+  /* The session and the pool it lives in, a sub-pool of CTX->POOL. */
+  svn_ra_session_t *session;
+  apr_pool_t *pool;
+
+  /* Root URL of the session's repository. */
+  const char *repos_root_url;
+
+  /* The callback baton of the session. */
+  callback_baton_t *cb;
+
+  /* The trace id the session was opened with, or NULL. */
+  const char *trace_id;
+
+  svn_client__private_ctx_t *ctx;
+} pooled_ra_session_t;
+
+/* Pool cleanup function making the pooled_ra_session_t DATA available
+   to later operations, unless an operation on it failed or got
+   cancelled. */
+static apr_status_t
+release_ra_session(void *data)
+{
+  pooled_ra_session_t *pooled = data;
+  apr_array_header_t *idle_sessions = pooled->ctx->idle_ra_sessions;
+
+  /* The context is being destroyed together with all sessions. */
+  if (idle_sessions == NULL)
+    return APR_SUCCESS;
+
+  /* The connection may still be busy with a response nobody is going to
+     read.  Destroying the session closes it. */
+  if (pooled->cb->cancelled || svn_ra__session_failed(pooled->session))
+    {
+      svn_pool_destroy(pooled->pool);
+      return APR_SUCCESS;
+    }
+
+  if (idle_sessions->nelts >= MAX_IDLE_RA_SESSIONS)
+    {
+      svn_pool_destroy(APR_ARRAY_IDX(idle_sessions, 0,
+                                     pooled_ra_session_t *)->pool);
+      svn_sort__array_delete(idle_sessions, 0, 1);
+    }
+
+  APR_ARRAY_PUSH(idle_sessions, pooled_ra_session_t *) = pooled;
+
+  return APR_SUCCESS;
+}
+
+/* Pool pre-cleanup function for the svn_client__private_ctx_t DATA.
+   It runs before the sessions' pools get destroyed and keeps
+   release_ra_session from touching them. */
+static apr_status_t
+forget_idle_ra_sessions(void *data)
+{
+  svn_client__private_ctx_t *ctx = data;
+  ctx->idle_ra_sessions = NULL;
+
+  return APR_SUCCESS;
+}
+
+/* Hand POOLED out to an operation using RESULT_POOL.  It returns to the
+   idle sessions when RESULT_POOL gets cleared. */
+static void
+acquire_ra_session(pooled_ra_session_t *pooled,
+                   apr_pool_t *result_pool)
+{
+  apr_pool_cleanup_register(result_pool, pooled, release_ra_session,
+                            apr_pool_cleanup_null);
+}
+
+/* Set *RA_SESSION to an idle session in CTX that can be reparented to
+   BASE_URL, handing it out to RESULT_POOL.  Set *RA_SESSION to NULL if
+   there is none.  Sessions that were opened with another trace id than
+   the current one of CTX get destroyed, because the server only learns
+   the trace id when the session is opened.  Use SCRATCH_POOL for
+   temporary allocations. */
+static void
+reuse_ra_session(svn_ra_session_t **ra_session,
+                 const char *base_url,
+                 svn_client__private_ctx_t *ctx,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *idle_sessions = ctx->idle_ra_sessions;
+  int i;
+
+  *ra_session = NULL;
+  for (i = idle_sessions->nelts - 1; i >= 0; --i)
+    {
+      pooled_ra_session_t *pooled
+        = APR_ARRAY_IDX(idle_sessions, i, pooled_ra_session_t *);
+      svn_error_t *err;
+
+      if (pooled->trace_id != ctx->public_ctx.trace_id
+          && (!pooled->trace_id || !ctx->public_ctx.trace_id
+              || strcmp(pooled->trace_id, ctx->public_ctx.trace_id)))
+        {
+          svn_sort__array_delete(idle_sessions, i, 1);
+          svn_pool_destroy(pooled->pool);
+          continue;
+        }
+
+      if (!svn_uri__is_ancestor(pooled->repos_root_url, base_url))
+        continue;
+
+      svn_sort__array_delete(idle_sessions, i, 1);
+
+      /* This is also the first use of the connection in a while.  If the
+         server closed it or a previous operation left it in an undefined
+         state, the reparent fails and we drop the session. */
+      err = svn_ra_reparent(pooled->session, base_url, scratch_pool);
+      if (err)
+        {
+          svn_error_clear(err);
+          svn_pool_destroy(pooled->pool);
+          continue;
+        }
+
+      acquire_ra_session(pooled, result_pool);
+      *ra_session = pooled->session;
+      return;
+    }
+}
+
 #define SVN_CLIENT__MAX_REDIRECT_ATTEMPTS 3 /* ### TODO:  Make configurable. */
 
 svn_error_t *
@@ -330,16 +471,53 @@ svn_client__open_ra_session_internal(svn_ra_session_t **ra_session,
                                      apr_pool_t *result_pool,
                                      apr_pool_t *scratch_pool)
 {
+  svn_client__private_ctx_t *private_ctx = svn_client__get_private_ctx(ctx);
   svn_ra_callbacks2_t *cbtable;
-  callback_baton_t *cb = apr_pcalloc(result_pool, sizeof(*cb));
+  callback_baton_t *cb;
   const char *uuid = NULL;
+  pooled_ra_session_t *pooled = NULL;
+  apr_pool_t *session_pool = result_pool;
+  svn_error_t *err = SVN_NO_ERROR;
 
   SVN_ERR_ASSERT(!write_dav_props || read_dav_props);
   SVN_ERR_ASSERT(!read_dav_props || base_dir_abspath != NULL);
   SVN_ERR_ASSERT(base_dir_abspath == NULL
                         || svn_dirent_is_absolute(base_dir_abspath));
 
-  SVN_ERR(svn_ra_create_callbacks(&cbtable, result_pool));
+  /* Sessions without working copy callbacks only depend on CTX and the
+     repository, so later operations may reuse them.  Since the session
+     then lives in the context's pool, make sure that RESULT_POOL doesn't
+     outlive it. */
+  if (base_dir_abspath == NULL && commit_items == NULL
+      && apr_pool_is_ancestor(private_ctx->pool, result_pool))
+    {
+      if (private_ctx->idle_ra_sessions == NULL)
+        {
+          private_ctx->idle_ra_sessions
+            = apr_array_make(private_ctx->pool, MAX_IDLE_RA_SESSIONS,
+                             sizeof(pooled_ra_session_t *));
+          apr_pool_pre_cleanup_register(private_ctx->pool, private_ctx,
+                                        forget_idle_ra_sessions);
+        }
+
+      reuse_ra_session(ra_session, base_url, private_ctx, result_pool,
+                       scratch_pool);
+      if (*ra_session)
+        {
+          if (corrected_url)
+            *corrected_url = NULL;
+
+          return SVN_NO_ERROR;
+        }
+
+      session_pool = svn_pool_create(private_ctx->pool);
+      pooled = apr_pcalloc(session_pool, sizeof(*pooled));
+      pooled->pool = session_pool;
+      pooled->ctx = private_ctx;
+    }
+
+  cb = apr_pcalloc(session_pool, sizeof(*cb));
+  SVN_ERR(svn_ra_create_callbacks(&cbtable, session_pool));
   cbtable->open_tmp_file = open_tmp_file;
   cbtable->get_wc_prop = read_dav_props ? get_wc_prop : NULL;
   cbtable->set_wc_prop = (write_dav_props && read_dav_props)
@@ -357,17 +535,21 @@ svn_client__open_ra_session_internal(svn_ra_session_t **ra_session,
   cbtable->check_tunnel_func = ctx->check_tunnel_func;
   cbtable->open_tunnel_func = ctx->open_tunnel_func;
   cbtable->tunnel_baton = ctx->tunnel_baton;
+  cbtable->trace_id = ctx->trace_id;
 
   cb->commit_items = commit_items;
   cb->ctx = ctx;
+  if (pooled)
+    {
+      pooled->cb = cb;
+      pooled->trace_id = apr_pstrdup(session_pool, ctx->trace_id);
+    }
 
   if (base_dir_abspath && (read_dav_props || write_dav_props))
     {
-      svn_error_t *err = svn_wc__node_get_repos_info(NULL, NULL, NULL, &uuid,
-                                                     ctx->wc_ctx,
-                                                     base_dir_abspath,
-                                                     result_pool,
-                                                     scratch_pool);
+      err = svn_wc__node_get_repos_info(NULL, NULL, NULL, &uuid,
+                                        ctx->wc_ctx, base_dir_abspath,
+                                        result_pool, scratch_pool);
 
       if (err && (err->apr_err == SVN_ERR_WC_NOT_WORKING_COPY
                   || err->apr_err == SVN_ERR_WC_PATH_NOT_FOUND
@@ -386,9 +568,9 @@ svn_client__open_ra_session_internal(svn_ra_session_t **ra_session,
 
   if (base_dir_abspath)
     {
-      svn_error_t *err = svn_wc__get_wcroot(&cb->wcroot_abspath,
-                                            ctx->wc_ctx, base_dir_abspath,
-                                            result_pool, scratch_pool);
+      err = svn_wc__get_wcroot(&cb->wcroot_abspath,
+                               ctx->wc_ctx, base_dir_abspath,
+                               result_pool, scratch_pool);
 
       if (err)
         {
@@ -418,10 +600,12 @@ svn_client__open_ra_session_internal(svn_ra_session_t **ra_session,
 
           /* Try to open the RA session.  If this is our last attempt,
              don't accept corrected URLs from the RA provider. */
-          SVN_ERR(svn_ra_open4(ra_session,
-                               attempts_left == 0 ? NULL : &corrected,
-                               base_url, uuid, cbtable, cb, ctx->config,
-                               result_pool));
+          err = svn_ra_open4(ra_session,
+                             attempts_left == 0 ? NULL : &corrected,
+                             base_url, uuid, cbtable, cb, ctx->config,
+                             session_pool);
+          if (err)
+            break;
 
           /* No error and no corrected URL?  We're done here. */
           if (! corrected)
@@ -442,9 +626,13 @@ svn_client__open_ra_session_internal(svn_ra_session_t **ra_session,
 
           /* Make sure we've not attempted this URL before. */
           if (svn_hash_gets(attempted, corrected))
-            return svn_error_createf(SVN_ERR_CLIENT_CYCLE_DETECTED, NULL,
-                                     _("Redirect cycle detected for URL '%s'"),
-                                     corrected);
+            {
+              err = svn_error_createf(SVN_ERR_CLIENT_CYCLE_DETECTED, NULL,
+                                      _("Redirect cycle detected for URL "
+                                        "'%s'"),
+                                      corrected);
+              break;
+            }
 
           /* Remember this CORRECTED_URL so we don't wind up in a loop. */
           svn_hash_sets(attempted, corrected, (void *)1);
@@ -453,11 +641,29 @@ svn_client__open_ra_session_internal(svn_ra_session_t **ra_session,
     }
   else
     {
-      SVN_ERR(svn_ra_open4(ra_session, NULL, base_url,
-                           uuid, cbtable, cb, ctx->config, result_pool));
+      err = svn_ra_open4(ra_session, NULL, base_url,
+                         uuid, cbtable, cb, ctx->config, session_pool);
     }
 
-  return SVN_NO_ERROR;
+  if (pooled)
+    {
+      if (!err)
+        {
+          pooled->session = *ra_session;
+          err = svn_ra_get_repos_root2(*ra_session, &pooled->repos_root_url,
+                                       session_pool);
+        }
+
+      if (err)
+        {
+          svn_pool_destroy(session_pool);
+          return svn_error_trace(err);
+        }
+
+      acquire_ra_session(pooled, result_pool);
+    }
+
+  return svn_error_trace(err);
 }
 #undef SVN_CLIENT__MAX_REDIRECT_ATTEMPTS
 
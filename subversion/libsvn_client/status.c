@@ -28,6 +28,7 @@
 /*** Includes. ***/
 #include <apr_strings.h>
 #include <apr_pools.h>
+#include <apr_thread_proc.h>
 
 #include "svn_private_config.h"
 #include "svn_pools.h"
@@ -112,19 +113,183 @@ tweak_status(void *baton,
                               scratch_pool);
 }
 
+#if APR_HAS_THREADS
+/* The repository locks below the anchor URL of a status operation,
+   fetched on a thread of their own while the working copy is crawled. */
+typedef struct lock_fetch_t {
+  /* Session to the anchor URL, used only by the thread. */
+  svn_ra_session_t *ra_session;
+  svn_depth_t depth;
+
+  /* The results, valid once the thread has been joined. */
+  apr_hash_t *locks;
+  const char *repos_root;
+  svn_error_t *err;
+
+  /* The thread, or NULL once it has been joined. */
+  apr_thread_t *thread;
+
+  /* Root pool of everything above. */
+  apr_pool_t *pool;
+} lock_fetch_t;
+#endif
+
 /* A baton for our reporter that is used to collect locks. */
 typedef struct report_baton_t {
   const svn_ra_reporter3_t* wrapped_reporter;
   void *wrapped_report_baton;
   /* The common ancestor URL of all paths included in the report. */
   char *ancestor;
+  /* The URL of the anchor, where ANCESTOR started. */
+  const char *url;
   void *set_locks_baton;
   svn_depth_t depth;
   svn_client_ctx_t *ctx;
+#if APR_HAS_THREADS
+  /* The locks fetched in advance for URL and DEPTH, or NULL. */
+  lock_fetch_t *lock_fetch;
+#endif
   /* Pool to store locks in. */
   apr_pool_t *pool;
 } report_baton_t;
 
+/* Set *LOCKS to the locks below the session URL of RA_SESSION at DEPTH
+   and *REPOS_ROOT to the repository root URL, allocated in RESULT_POOL.
+   Note that if the server doesn't support lock discovery, *LOCKS will
+   be empty. */
+static svn_error_t *
+fetch_locks(apr_hash_t **locks,
+            const char **repos_root,
+            svn_ra_session_t *ra_session,
+            svn_depth_t depth,
+            apr_pool_t *result_pool)
+{
+  svn_error_t *err = svn_ra_get_locks2(ra_session, locks, "", depth,
+                                       result_pool);
+
+  if (err && err->apr_err == SVN_ERR_RA_NOT_IMPLEMENTED)
+    {
+      svn_error_clear(err);
+      *locks = apr_hash_make(result_pool);
+    }
+  else
+    SVN_ERR(err);
+
+  return svn_error_trace(svn_ra_get_repos_root2(ra_session, repos_root,
+                                                result_pool));
+}
+
+#if APR_HAS_THREADS
+/* Thread function.  Fetch the locks of the lock_fetch_t DATA. */
+static void * APR_THREAD_FUNC
+lock_fetch_thread(apr_thread_t *tid,
+                  void *data)
+{
+  lock_fetch_t *lf = data;
+
+  lf->err = fetch_locks(&lf->locks, &lf->repos_root, lf->ra_session,
+                        lf->depth, lf->pool);
+
+  return NULL;
+}
+
+/* Wait for the thread of LF, if it is still running, and return its
+   error. */
+static svn_error_t *
+wait_lock_fetch(lock_fetch_t *lf)
+{
+  svn_error_t *err;
+
+  if (lf->thread)
+    {
+      apr_status_t retval;
+      apr_status_t status = apr_thread_join(&retval, lf->thread);
+
+      lf->thread = NULL;
+      if (status)
+        lf->err = svn_error_compose_create(
+                    lf->err,
+                    svn_error_wrap_apr(status, _("Can't join thread")));
+    }
+
+  err = lf->err;
+  lf->err = SVN_NO_ERROR;
+
+  return svn_error_trace(err);
+}
+
+/* Pool cleanup handler.  Stop the lock_fetch_t DATA and release its
+   resources. */
+static apr_status_t
+cleanup_lock_fetch(void *data)
+{
+  lock_fetch_t *lf = data;
+
+  svn_error_clear(wait_lock_fetch(lf));
+  svn_pool_destroy(lf->pool);
+
+  return APR_SUCCESS;
+}
+
+/* Start fetching the locks below URL at DEPTH on another thread, so that
+   they are known by the time the working copy has been crawled.  Set *LF_P
+   to the fetch, which lives as long as RESULT_POOL, or to NULL if we
+   can't do this.  In that case the locks are fetched when the report is
+   finished, which also reports any problems with the session. */
+static void
+start_lock_fetch(lock_fetch_t **lf_p,
+                 const char *url,
+                 svn_depth_t depth,
+                 svn_client_ctx_t *ctx,
+                 apr_pool_t *result_pool)
+{
+  apr_pool_t *pool = svn_pool_create(NULL);
+  lock_fetch_t *lf = apr_pcalloc(pool, sizeof(*lf));
+  svn_client_ctx_t *lock_ctx;
+  svn_wc_context_t *wc_ctx;
+  svn_error_t *err;
+  apr_status_t status;
+
+  *lf_p = NULL;
+  lf->pool = pool;
+  lf->depth = depth;
+
+  /* The thread must not call back into CTX while we use it, so give
+     its session a context without notifications. */
+  err = svn_client_create_context2(&lock_ctx, ctx->config, pool);
+  if (!err)
+    {
+      wc_ctx = lock_ctx->wc_ctx;
+      *lock_ctx = *ctx;
+      lock_ctx->wc_ctx = wc_ctx;
+      lock_ctx->notify_func = NULL;
+      lock_ctx->notify_func2 = NULL;
+      lock_ctx->progress_func = NULL;
+
+      err = svn_client_open_ra_session2(&lf->ra_session, url, NULL,
+                                        lock_ctx, pool, pool);
+    }
+  if (err)
+    {
+      svn_error_clear(err);
+      svn_pool_destroy(pool);
+      return;
+    }
+
+  status = apr_thread_create(&lf->thread, NULL, lock_fetch_thread, lf,
+                             pool);
+  if (status)
+    {
+      svn_pool_destroy(pool);
+      return;
+    }
+
+  apr_pool_cleanup_register(result_pool, lf, cleanup_lock_fetch,
+                            apr_pool_cleanup_null);
+  *lf_p = lf;
+}
+#endif
+
 /* Implements svn_ra_reporter3_t->set_path. */
 static svn_error_t *
 reporter_set_path(void *report_baton, const char *path,
@@ -182,33 +347,39 @@ static svn_error_t *
 reporter_finish_report(void *report_baton, apr_pool_t *pool)
 {
   report_baton_t *rb = report_baton;
-  svn_ra_session_t *ras;
-  apr_hash_t *locks;
-  const char *repos_root;
-  apr_pool_t *subpool = svn_pool_create(pool);
-  svn_error_t *err = SVN_NO_ERROR;
-
-  /* Open an RA session to our common ancestor and grab the locks under it.
-   */
-  SVN_ERR(svn_client_open_ra_session2(&ras, rb->ancestor, NULL,
-                                      rb->ctx, subpool, subpool));
-
-  /* The locks need to live throughout the edit.  Note that if the
-     server doesn't support lock discovery, we'll just not do locky
-     stuff. */
-  err = svn_ra_get_locks2(ras, &locks, "", rb->depth, rb->pool);
-  if (err && err->apr_err == SVN_ERR_RA_NOT_IMPLEMENTED)
+  apr_hash_t *locks = NULL;
+  const char *repos_root = NULL;
+
+#if APR_HAS_THREADS
+  /* The locks fetched in advance are only of use if the report didn't
+     link in paths from outside of the anchor URL. */
+  if (rb->lock_fetch)
     {
+      svn_error_t *err = wait_lock_fetch(rb->lock_fetch);
+
+      if (!err && strcmp(rb->ancestor, rb->url) == 0)
+        {
+          locks = rb->lock_fetch->locks;
+          repos_root = rb->lock_fetch->repos_root;
+        }
       svn_error_clear(err);
-      err = SVN_NO_ERROR;
-      locks = apr_hash_make(rb->pool);
     }
-  SVN_ERR(err);
+#endif
 
-  SVN_ERR(svn_ra_get_repos_root2(ras, &repos_root, rb->pool));
+  if (!locks)
+    {
+      svn_ra_session_t *ras;
+      apr_pool_t *subpool = svn_pool_create(pool);
+
+      /* Open an RA session to our common ancestor and grab the locks
+         under it.  The locks need to live throughout the edit. */
+      SVN_ERR(svn_client_open_ra_session2(&ras, rb->ancestor, NULL,
+                                          rb->ctx, subpool, subpool));
+      SVN_ERR(fetch_locks(&locks, &repos_root, ras, rb->depth, rb->pool));
 
-  /* Close the RA session. */
-  svn_pool_destroy(subpool);
+      /* Close the RA session. */
+      svn_pool_destroy(subpool);
+    }
 
   SVN_ERR(svn_wc_status_set_repos_locks(rb->set_locks_baton, locks,
                                         repos_root, rb->pool));
@@ -547,6 +718,7 @@ svn_client_status6(svn_revnum_t *result_rev,
 
           /* Init the report baton. */
           rb.ancestor = apr_pstrdup(pool, URL); /* Edited later */
+          rb.url = URL;
           rb.set_locks_baton = set_locks_baton;
           rb.ctx = ctx;
           rb.pool = pool;
@@ -556,6 +728,11 @@ svn_client_status6(svn_revnum_t *result_rev,
           else
             rb.depth = depth;
 
+#if APR_HAS_THREADS
+          /* Let the server look up the locks while we crawl. */
+          start_lock_fetch(&rb.lock_fetch, URL, rb.depth, ctx, pool);
+#endif
+
           /* Drive the reporter structure, describing the revisions
              within PATH.  When we call reporter->finish_report,
              EDITOR will be driven to describe differences between our
@@ -479,7 +479,7 @@ svn_client_switch3(svn_revnum_t *result_rev,
   /* Sleep to ensure timestamp integrity (we do this regardless of
      errors in the actual switch operation(s)). */
   if (sleep_here)
-    svn_io_sleep_for_timestamps(path, pool);
+    svn_wc__settle_timestamps(ctx->wc_ctx, path, pool);
 
   return svn_error_trace(err);
 }
@@ -190,6 +190,10 @@ record_conflict(svn_wc_conflict_result_t **result,
    This is typically either the same as LOCAL_ABSPATH, or the
    immediate parent of LOCAL_ABSPATH.
 
+   If LAZY_FILES is set, drive the update editor from a report that
+   carries no text deltas; the editor records added files as excluded
+   nodes, so no file content is transferred.
+
    If NOTIFY_SUMMARY is set (and there's a notification handler in
    CTX), transmit the final update summary upon successful
    completion of the update.
@@ -214,6 +218,7 @@ update_internal(svn_revnum_t *result_rev,
                 svn_boolean_t ignore_externals,
                 svn_boolean_t allow_unver_obstructions,
                 svn_boolean_t adds_as_modification,
+                svn_boolean_t lazy_files,
                 svn_boolean_t notify_summary,
                 svn_client_ctx_t *ctx,
                 apr_pool_t *result_pool,
@@ -470,6 +475,7 @@ update_internal(svn_revnum_t *result_rev,
                                     adds_as_modification,
                                     server_supports_depth,
                                     clean_checkout,
+                                    lazy_files,
                                     diff3_cmd, preserved_exts,
                                     svn_client__dirent_fetcher, &dfb,
                                     conflicted_paths ? record_conflict : NULL,
@@ -481,15 +487,32 @@ update_internal(svn_revnum_t *result_rev,
 
   /* Tell RA to do an update of URL+TARGET to REVISION; if we pass an
      invalid revnum, that means RA will use the latest revision.  */
-  SVN_ERR(svn_ra_do_update3(ra_session, &reporter, &report_baton,
-                            revnum, target,
-                            (!server_supports_depth || depth_is_sticky
-                             ? depth
-                             : svn_depth_unknown),
-                            FALSE /* send_copyfrom_args */,
-                            FALSE /* ignore_ancestry */,
-                            update_editor, update_edit_baton,
-                            scratch_pool, scratch_pool));
+  if (lazy_files)
+    {
+      /* A diff against the target itself describes the same edit as an
+         update, but allows us to leave out the text deltas. */
+      SVN_ERR(svn_ra_do_diff3(ra_session, &reporter, &report_baton,
+                              revnum, target,
+                              (!server_supports_depth || depth_is_sticky
+                               ? depth
+                               : svn_depth_unknown),
+                              FALSE /* ignore_ancestry */,
+                              FALSE /* text_deltas */,
+                              svn_path_url_add_component2(anchor_url, target,
+                                                          scratch_pool),
+                              update_editor, update_edit_baton,
+                              scratch_pool));
+    }
+  else
+    SVN_ERR(svn_ra_do_update3(ra_session, &reporter, &report_baton,
+                              revnum, target,
+                              (!server_supports_depth || depth_is_sticky
+                               ? depth
+                               : svn_depth_unknown),
+                              FALSE /* send_copyfrom_args */,
+                              FALSE /* ignore_ancestry */,
+                              update_editor, update_edit_baton,
+                              scratch_pool, scratch_pool));
 
   /* Past this point, we assume the WC is going to be modified so we will
    * need to sleep for timestamps. */
@@ -559,6 +582,7 @@ svn_client__update_internal(svn_revnum_t *result_rev,
                             svn_boolean_t ignore_externals,
                             svn_boolean_t allow_unver_obstructions,
                             svn_boolean_t adds_as_modification,
+                            svn_boolean_t lazy_files,
                             svn_boolean_t make_parents,
                             svn_boolean_t innerupdate,
                             svn_ra_session_t *ra_session,
@@ -623,7 +647,7 @@ svn_client__update_internal(svn_revnum_t *result_rev,
                                 anchor_abspath, &peg_revision, svn_depth_empty,
                                 FALSE, ignore_externals,
                                 allow_unver_obstructions, adds_as_modification,
-                                FALSE, ctx, pool, iterpool);
+                                FALSE, FALSE, ctx, pool, iterpool);
           if (err)
             goto cleanup;
           anchor_abspath = missing_parent;
@@ -650,7 +674,7 @@ svn_client__update_internal(svn_revnum_t *result_rev,
                         local_abspath, anchor_abspath,
                         &peg_revision, depth, depth_is_sticky,
                         ignore_externals, allow_unver_obstructions,
-                        adds_as_modification,
+                        adds_as_modification, lazy_files,
                         TRUE, ctx, pool, pool);
 
   /* Give the conflict resolver callback the opportunity to
@@ -724,6 +748,7 @@ svn_client_update4(apr_array_header_t **result_revs,
                                         ignore_externals,
                                         allow_unver_obstructions,
                                         adds_as_modification,
+                                        FALSE /* lazy_files */,
                                         make_parents,
                                         FALSE, NULL, ctx,
                                         iterpool);
@@ -776,7 +801,7 @@ svn_client_update4(apr_array_header_t **result_revs,
       else
         wcroot_abspath = NULL;
 
-      svn_io_sleep_for_timestamps(wcroot_abspath, pool);
+      svn_wc__settle_timestamps(ctx->wc_ctx, wcroot_abspath, pool);
     }
 
   return svn_error_trace(err);
@@ -28,12 +28,18 @@
 
 #include "svn_delta.h"
 #include "svn_pools.h"
+
+#include "private/svn_delta_private.h"
+
 #include "delta.h"
 
-/* Define a MIN macro if this platform doesn't already have one. */
+/* Define MIN and MAX macros if this platform doesn't already have them. */
 #ifndef MIN
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 #endif
+#ifndef MAX
+#define MAX(a, b) ((a) < (b) ? (b) : (a))
+#endif
 
 
 /* ==================================================================== */
@@ -100,29 +106,99 @@ union alloc_block_t
 };
 
 
+/* Blocks are carved out of chunks that survive between compositions.
+   Resetting the arena makes all of them available again, so composing
+   many windows with the same arena stops allocating once the chunks
+   are large enough. */
+typedef struct block_chunk_t block_chunk_t;
+struct block_chunk_t
+{
+  /* Next larger chunk, if already allocated. */
+  block_chunk_t *next;
+
+  /* Number of blocks in this chunk. */
+  apr_size_t size;
+  alloc_block_t *blocks;
+};
+
+typedef struct block_arena_t
+{
+  /* The list of chunks and the one we currently allocate from. */
+  block_chunk_t *first;
+  block_chunk_t *current;
+
+  /* Number of blocks used in CURRENT. */
+  apr_size_t used;
+
+  /* Blocks that have been returned. */
+  alloc_block_t *free_list;
+
+  /* Chunks get allocated from here. */
+  apr_pool_t *pool;
+
+  /* Number of chunks allocated from POOL so far. */
+  apr_size_t allocations;
+} block_arena_t;
+
+/* Number of blocks in the first chunk of an arena. */
+#define FIRST_CHUNK_SIZE 64
+
+/* Make all blocks in ARENA available again. */
+static void
+reset_block_arena(block_arena_t *arena)
+{
+  arena->current = arena->first;
+  arena->used = 0;
+  arena->free_list = NULL;
+}
+
 /* Allocate a block. */
 static APR_INLINE void *
-alloc_block(apr_pool_t *pool, alloc_block_t **free_list)
+alloc_block(block_arena_t *arena)
 {
   alloc_block_t *block;
-  if (*free_list == NULL)
-    block = apr_palloc(pool, sizeof(*block));
-  else
+  if (arena->free_list != NULL)
     {
-      block = *free_list;
-      *free_list = block->next_free;
+      block = arena->free_list;
+      arena->free_list = block->next_free;
+      return block;
     }
-  return block;
+
+  if (arena->current == NULL || arena->used == arena->current->size)
+    {
+      /* Move on to the next chunk, allocating it if necessary. */
+      if (arena->current == NULL || arena->current->next == NULL)
+        {
+          apr_size_t size = arena->current ? 2 * arena->current->size
+                                           : FIRST_CHUNK_SIZE;
+          block_chunk_t *chunk = apr_palloc(arena->pool, sizeof(*chunk));
+          chunk->next = NULL;
+          chunk->size = size;
+          chunk->blocks = apr_palloc(arena->pool,
+                                     size * sizeof(*chunk->blocks));
+          arena->allocations++;
+
+          if (arena->current)
+            arena->current->next = chunk;
+          else
+            arena->first = chunk;
+        }
+
+      arena->current = arena->current ? arena->current->next : arena->first;
+      arena->used = 0;
+    }
+
+  return &arena->current->blocks[arena->used++];
 }
 
 /* Return the block back to the free list. */
 static APR_INLINE void
-free_block(void *ptr, alloc_block_t **free_list)
+free_block(void *ptr, block_arena_t *arena)
 {
   /* Wrapper functions take care of type safety. */
   alloc_block_t *const block = ptr;
-  block->next_free = *free_list;
-  *free_list = block;
+  block->next_free = arena->free_list;
+  arena->free_list = block;
 }
 
 
@@ -134,20 +210,32 @@ typedef struct offset_index_t
 {
   int length;
   apr_size_t *offs;
+
+  /* Number of elements allocated in OFFS. */
+  int size;
 } offset_index_t;
 
-/* Create an index mapping target stream offsets to delta ops in
-   WINDOW. Allocate from POOL. */
+/* Fill NDX with an index mapping target stream offsets to delta ops in
+   WINDOW.  Reuse the existing index array, if it is large enough, and
+   allocate a new one from POOL otherwise.  Return TRUE if we allocated
+   a new array. */
 
-static offset_index_t *
-create_offset_index(const svn_txdelta_window_t *window, apr_pool_t *pool)
+static svn_boolean_t
+fill_offset_index(offset_index_t *ndx,
+                  const svn_txdelta_window_t *window,
+                  apr_pool_t *pool)
 {
-  offset_index_t *ndx = apr_palloc(pool, sizeof(*ndx));
+  svn_boolean_t allocated = FALSE;
   apr_size_t offset = 0;
   int i;
 
   ndx->length = window->num_ops;
-  ndx->offs = apr_palloc(pool, (ndx->length + 1) * sizeof(*ndx->offs));
+  if (ndx->length + 1 > ndx->size)
+    {
+      ndx->size = MAX(2 * ndx->size, ndx->length + 1);
+      ndx->offs = apr_palloc(pool, ndx->size * sizeof(*ndx->offs));
+      allocated = TRUE;
+    }
 
   for (i = 0; i < ndx->length; ++i)
     {
@@ -156,7 +244,7 @@ create_offset_index(const svn_txdelta_window_t *window, apr_pool_t *pool)
     }
   ndx->offs[ndx->length] = offset;
 
-  return ndx;
+  return allocated;
 }
 
 /* Find the index of the delta op thet defines that data at OFFSET in
@@ -216,8 +304,7 @@ search_offset_index(const offset_index_t *ndx,
 typedef struct range_index_t
 {
   range_index_node_t *tree;
-  alloc_block_t *free_list;
-  apr_pool_t *pool;
+  block_arena_t *arena;
 } range_index_t;
 
 /* Create a range index tree. Allocate from POOL. */
@@ -226,8 +313,8 @@ create_range_index(apr_pool_t *pool)
 {
   range_index_t *ndx = apr_palloc(pool, sizeof(*ndx));
   ndx->tree = NULL;
-  ndx->pool = pool;
-  ndx->free_list = NULL;
+  ndx->arena = apr_pcalloc(pool, sizeof(*ndx->arena));
+  ndx->arena->pool = pool;
   return ndx;
 }
 
@@ -238,7 +325,7 @@ alloc_range_index_node(range_index_t *ndx,
                        apr_size_t limit,
                        apr_size_t target_offset)
 {
-  range_index_node_t *const node = alloc_block(ndx->pool, &ndx->free_list);
+  range_index_node_t *const node = alloc_block(ndx->arena);
   node->offset = offset;
   node->limit = limit;
   node->target_offset = target_offset;
@@ -255,7 +342,7 @@ free_range_index_node(range_index_t *ndx, range_index_node_t *node)
     node->next->prev = node->prev;
   if (node->prev)
     node->prev->next = node->next;
-  free_block(node, &ndx->free_list);
+  free_block(node, ndx->arena);
 }
 
 
@@ -526,7 +613,7 @@ alloc_range_list(range_list_node_t **list,
                  apr_size_t limit,
                  apr_size_t target_offset)
 {
-  range_list_node_t *const node = alloc_block(ndx->pool, &ndx->free_list);
+  range_list_node_t *const node = alloc_block(ndx->arena);
   node->kind = kind;
   node->offset = offset;
   node->limit = limit;
@@ -554,7 +641,7 @@ free_range_list(range_list_node_t *list, range_index_t *ndx)
     {
       range_list_node_t *const node = list;
       list = node->next;
-      free_block(node, &ndx->free_list);
+      free_block(node, ndx->arena);
     }
 }
 
@@ -760,23 +847,78 @@ copy_source_ops(apr_size_t offset, apr_size_t limit,
 /* Bringing it all together. */
 
 
+/* Reusable state for composing delta windows. */
+struct svn_txdelta__compose_ctx_t
+{
+  /* All buffers get allocated from here. */
+  apr_pool_t *pool;
+
+  /* Nodes of the range index and range lists. */
+  block_arena_t arena;
+
+  /* Index into the ops of the first window. */
+  offset_index_t offset_index;
+
+  /* Source ranges already covered by the composite. */
+  range_index_t range_index;
+
+  /* The composite ops and new data.  Copied to the result pool at the
+     end of each composition. */
+  svn_txdelta__ops_baton_t build_baton;
+
+  /* Number of times the offset index or the composite buffers had to be
+     allocated or grown.  The arena counts its chunks separately. */
+  apr_size_t allocations;
+};
+
+svn_txdelta__compose_ctx_t *
+svn_txdelta__compose_ctx_create(apr_pool_t *pool)
+{
+  svn_txdelta__compose_ctx_t *ctx = apr_pcalloc(pool, sizeof(*ctx));
+
+  ctx->pool = pool;
+  ctx->arena.pool = pool;
+  ctx->range_index.arena = &ctx->arena;
+  ctx->build_baton.new_data = svn_stringbuf_create_empty(pool);
+
+  return ctx;
+}
+
+apr_size_t
+svn_txdelta__compose_ctx_allocations(const svn_txdelta__compose_ctx_t *ctx)
+{
+  return ctx->allocations + ctx->arena.allocations;
+}
+
 svn_txdelta_window_t *
-svn_txdelta_compose_windows(const svn_txdelta_window_t *window_A,
-                            const svn_txdelta_window_t *window_B,
-                            apr_pool_t *pool)
+svn_txdelta__compose_windows(svn_txdelta__compose_ctx_t *ctx,
+                             const svn_txdelta_window_t *window_A,
+                             const svn_txdelta_window_t *window_B,
+                             apr_pool_t *pool)
 {
-  svn_txdelta__ops_baton_t build_baton = { 0 };
-  svn_txdelta_window_t *composite;
-  apr_pool_t *subpool = svn_pool_create(pool);
-  offset_index_t *offset_index = create_offset_index(window_A, subpool);
-  range_index_t *range_index = create_range_index(subpool);
+  svn_txdelta__ops_baton_t *build_baton = &ctx->build_baton;
+  range_index_t *range_index = &ctx->range_index;
+  const int ops_size = build_baton->ops_size;
+  const apr_size_t data_size = build_baton->new_data->blocksize;
+  svn_txdelta_window_t composite;
+  svn_string_t new_data;
+  svn_txdelta_window_t *result;
   apr_size_t target_offset = 0;
   int i;
 
+  /* Start from empty buffers and an empty range index. */
+  build_baton->num_ops = 0;
+  build_baton->src_ops = 0;
+  svn_stringbuf_setempty(build_baton->new_data);
+  reset_block_arena(&ctx->arena);
+  range_index->tree = NULL;
+
+  if (fill_offset_index(&ctx->offset_index, window_A, ctx->pool))
+    ctx->allocations++;
+
   /* Read the description of the delta composition algorithm in
      notes/fs-improvements.txt before going any further.
      You have been warned. */
-  build_baton.new_data = svn_stringbuf_create_empty(pool);
   for (i = 0; i < window_B->num_ops; ++i)
     {
       const svn_txdelta_op_t *const op = &window_B->ops[i];
@@ -788,9 +930,9 @@ svn_txdelta_compose_windows(const svn_txdelta_window_t *window_A,
             (op->action_code == svn_txdelta_new
              ? window_B->new_data->data + op->offset
              : NULL);
-          svn_txdelta__insert_op(&build_baton, op->action_code,
+          svn_txdelta__insert_op(build_baton, op->action_code,
                                  op->offset, op->length,
-                                 new_data, pool);
+                                 new_data, ctx->pool);
         }
       else
         {
@@ -808,14 +950,14 @@ svn_txdelta_compose_windows(const svn_txdelta_window_t *window_A,
           for (range = range_list; range; range = range->next)
             {
               if (range->kind == range_from_target)
-                svn_txdelta__insert_op(&build_baton, svn_txdelta_target,
+                svn_txdelta__insert_op(build_baton, svn_txdelta_target,
                                        range->target_offset,
                                        range->limit - range->offset,
-                                       NULL, pool);
+                                       NULL, ctx->pool);
               else
                 copy_source_ops(range->offset, range->limit, tgt_off, 0,
-                                &build_baton, window_A, offset_index,
-                                pool);
+                                build_baton, window_A, &ctx->offset_index,
+                                ctx->pool);
 
               tgt_off += range->limit - range->offset;
             }
@@ -829,11 +971,36 @@ svn_txdelta_compose_windows(const svn_txdelta_window_t *window_A,
       target_offset += op->length;
     }
 
-  svn_pool_destroy(subpool);
+  if (build_baton->ops_size != ops_size)
+    ctx->allocations++;
+  if (build_baton->new_data->blocksize != data_size)
+    ctx->allocations++;
+
+  /* Copy the composite out of our reusable buffers. */
+  new_data.data = build_baton->new_data->data;
+  new_data.len = build_baton->new_data->len;
+  composite.num_ops = build_baton->num_ops;
+  composite.src_ops = build_baton->src_ops;
+  composite.ops = build_baton->ops;
+  composite.new_data = &new_data;
+
+  result = svn_txdelta_window_dup(&composite, pool);
+  result->sview_offset = window_A->sview_offset;
+  result->sview_len = window_A->sview_len;
+  result->tview_len = window_B->tview_len;
+  return result;
+}
 
-  composite = svn_txdelta__make_window(&build_baton, pool);
-  composite->sview_offset = window_A->sview_offset;
-  composite->sview_len = window_A->sview_len;
-  composite->tview_len = window_B->tview_len;
+svn_txdelta_window_t *
+svn_txdelta_compose_windows(const svn_txdelta_window_t *window_A,
+                            const svn_txdelta_window_t *window_B,
+                            apr_pool_t *pool)
+{
+  apr_pool_t *subpool = svn_pool_create(pool);
+  svn_txdelta_window_t *composite
+    = svn_txdelta__compose_windows(svn_txdelta__compose_ctx_create(subpool),
+                                   window_A, window_B, pool);
+
+  svn_pool_destroy(subpool);
   return composite;
 }
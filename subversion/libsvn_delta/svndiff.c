@@ -30,14 +30,22 @@
 #include "svn_pools.h"
 #include "svn_private_config.h"
 
+#if APR_HAS_THREADS
+#include <apr_thread_pool.h>
+#include <apr_thread_cond.h>
+#endif
+
 #include "private/svn_error_private.h"
 #include "private/svn_delta_private.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_string_private.h"
 #include "private/svn_dep_compat.h"
+#include "private/svn_atomic.h"
+#include "private/svn_mutex.h"
 
 static const char SVNDIFF_V0[] = { 'S', 'V', 'N', 0 };
 static const char SVNDIFF_V1[] = { 'S', 'V', 'N', 1 };
+static const char SVNDIFF_V2[] = { 'S', 'V', 'N', 2 };
 
 #define SVNDIFF_HEADER_SIZE (sizeof(SVNDIFF_V0))
 
@@ -46,12 +54,86 @@ get_svndiff_header(int version)
 {
   if (version == 1)
     return SVNDIFF_V1;
+  else if (version == 2)
+    return SVNDIFF_V2;
   else
     return SVNDIFF_V0;
 }
 
 /* ----- Text delta to svndiff ----- */
 
+/* Default for the maximum number of worker threads compressing svndiff
+   windows concurrently. */
+#define DEFAULT_ENCODER_THREADS 4
+
+/* Maximum number of worker threads, see svn_delta__set_encoder_threads().
+   0 disables the parallel encoder. */
+static int encoder_threads = DEFAULT_ENCODER_THREADS;
+
+#if APR_HAS_THREADS
+
+/* Number of microseconds that an unused encoder thread remains in the
+   pool before being terminated. */
+#define THREADPOOL_THREAD_IDLE_LIMIT 1000000
+
+/* Thread pool shared by all parallel encoders.  NULL if it could not
+   be created. */
+static apr_thread_pool_t *encoder_thread_pool = NULL;
+
+/* Initialization state of ENCODER_THREAD_POOL. */
+static volatile svn_atomic_t encoder_thread_pool_state = 0;
+
+struct parallel_encoder_t;
+
+/* A single window to be encoded by a worker thread. */
+typedef struct encode_job_t
+{
+  /* Private copy of the window to encode. */
+  svn_txdelta_window_t *window;
+
+  /* Encoder parameters, see encode_window(). */
+  int version;
+  int compression_level;
+
+  /* Encoder results, valid once DONE has been set. */
+  svn_stringbuf_t *instructions;
+  svn_stringbuf_t *header;
+  const svn_string_t *newdata;
+  svn_error_t *err;
+
+  /* Set under ENCODER->MUTEX when the worker finished. */
+  svn_boolean_t done;
+
+  /* The encoder that this job belongs to. */
+  struct parallel_encoder_t *encoder;
+
+  /* Pool used exclusively for this job.  Destroyed after the result
+     has been written. */
+  apr_pool_t *pool;
+} encode_job_t;
+
+/* State of the encoder pipeline.  Jobs get queued in window order and
+   their results are written strictly in that order, too. */
+typedef struct parallel_encoder_t
+{
+  /* Protects all DONE flags and is used with COND. */
+  svn_mutex__t *mutex;
+
+  /* Signaled whenever a job completes. */
+  apr_thread_cond_t *cond;
+
+  /* Ring buffer of MAX_JOBS pending jobs, the oldest at index FIRST. */
+  encode_job_t **jobs;
+  int max_jobs;
+  int first;
+  int count;
+
+  /* Thread-safe root pool that all job pools are created in. */
+  apr_pool_t *jobs_pool;
+} parallel_encoder_t;
+
+#endif
+
 /* We make one of these and get it passed back to us in calls to the
    window handler.  We only use it to record the write function and
    baton passed to svn_txdelta_to_svndiff3().  */
@@ -62,8 +144,22 @@ struct encoder_baton {
   int compression_level;
   /* Pool for temporary allocations, will be cleared periodically. */
   apr_pool_t *scratch_pool;
+  /* Pool that this baton has been allocated in. */
+  apr_pool_t *pool;
+  /* Number of windows received so far. */
+  apr_uint64_t window_count;
+#if APR_HAS_THREADS
+  /* Window pipeline; created upon the second window if applicable. */
+  parallel_encoder_t *parallel;
+#endif
 };
 
+void
+svn_delta__set_encoder_threads(int threads)
+{
+  encoder_threads = threads > 0 ? threads : 0;
+}
+
 /* This is at least as big as the largest size for a single instruction. */
 #define MAX_INSTRUCTION_LEN (2*SVN__MAX_ENCODED_UINT_LEN+1)
 /* This is at least as big as the largest possible instructions
@@ -149,7 +245,7 @@ send_simple_insertion_window(svn_txdelta_window_t *window,
 
 /* Encodes delta window WINDOW to svndiff-format.
    The svndiff version is VERSION. COMPRESSION_LEVEL is the zlib
-   compression level to use.
+   compression level to use with version 1.  Version 2 always uses LZ4.
    Returned values will be allocated in POOL or refer to *WINDOW
    fields. */
 static svn_error_t *
@@ -203,6 +299,14 @@ encode_window(svn_stringbuf_t **instructions_p,
                             compressed_instructions, compression_level));
       instructions = compressed_instructions;
     }
+  else if (version == 2)
+    {
+      svn_stringbuf_t *compressed_instructions;
+      compressed_instructions = svn_stringbuf_create_empty(pool);
+      SVN_ERR(svn__compress_lz4(instructions->data, instructions->len,
+                                compressed_instructions));
+      instructions = compressed_instructions;
+    }
   append_encoded_int(header, instructions->len);
   if (version == 1)
     {
@@ -212,6 +316,14 @@ encode_window(svn_stringbuf_t **instructions_p,
                             compressed, compression_level));
       newdata = svn_stringbuf__morph_into_string(compressed);
     }
+  else if (version == 2)
+    {
+      svn_stringbuf_t *compressed = svn_stringbuf_create_empty(pool);
+
+      SVN_ERR(svn__compress_lz4(window->new_data->data, window->new_data->len,
+                                compressed));
+      newdata = svn_stringbuf__morph_into_string(compressed);
+    }
   else
     newdata = window->new_data;
 
@@ -224,6 +336,281 @@ encode_window(svn_stringbuf_t **instructions_p,
   return SVN_NO_ERROR;
 }
 
+/* Write the encoded svndiff window given by HEADER, INSTRUCTIONS and
+   NEWDATA to EB->OUTPUT. */
+static svn_error_t *
+write_encoded_window(struct encoder_baton *eb,
+                     const svn_stringbuf_t *header,
+                     const svn_stringbuf_t *instructions,
+                     const svn_string_t *newdata)
+{
+  apr_size_t len;
+
+  len = header->len;
+  SVN_ERR(svn_stream_write(eb->output, header->data, &len));
+  if (instructions->len > 0)
+    {
+      len = instructions->len;
+      SVN_ERR(svn_stream_write(eb->output, instructions->data, &len));
+    }
+  if (newdata->len > 0)
+    {
+      len = newdata->len;
+      SVN_ERR(svn_stream_write(eb->output, newdata->data, &len));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS
+
+/* Implements svn_atomic__str_init_func_t.
+   Create ENCODER_THREAD_POOL. */
+static const char *
+init_encoder_thread_pool(void *baton)
+{
+  /* The thread-pool must be allocated from a thread-safe pool that lives
+     as long as the process. */
+  apr_pool_t *pool = svn_pool_create(NULL);
+  apr_status_t status;
+
+  status = apr_thread_pool_create(&encoder_thread_pool, 0, encoder_threads,
+                                  pool);
+  if (status)
+    {
+      encoder_thread_pool = NULL;
+      svn_pool_destroy(pool);
+      return "Can't create svndiff encoder thread pool";
+    }
+
+  /* Let idle threads linger for a while; the next delta is often not
+     far away. */
+  apr_thread_pool_idle_wait_set(encoder_thread_pool,
+                                THREADPOOL_THREAD_IDLE_LIMIT);
+
+  return NULL;
+}
+
+/* Lock ENCODER->MUTEX and wait until JOB has been completed. */
+static svn_error_t *
+wait_for_job(parallel_encoder_t *encoder,
+             encode_job_t *job)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+
+  SVN_ERR(svn_mutex__lock(encoder->mutex));
+
+  /* This loop implicitly handles spurious wake-ups. */
+  while (!job->done)
+    {
+      apr_status_t status = apr_thread_cond_wait(encoder->cond,
+                                                 svn_mutex__get(encoder->mutex));
+      if (status)
+        {
+          err = svn_error_wrap_apr(status,
+                                   _("Can't wait for condition variable"));
+          break;
+        }
+    }
+
+  return svn_error_trace(svn_mutex__unlock(encoder->mutex, err));
+}
+
+/* Return TRUE in *DONE if JOB has been completed. */
+static svn_error_t *
+is_job_done(svn_boolean_t *done,
+            parallel_encoder_t *encoder,
+            encode_job_t *job)
+{
+  SVN_ERR(svn_mutex__lock(encoder->mutex));
+  *done = job->done;
+  return svn_error_trace(svn_mutex__unlock(encoder->mutex, SVN_NO_ERROR));
+}
+
+/* Thread-pool task.  Encode the encode_job_t given by DATA. */
+static void * APR_THREAD_FUNC
+encode_task(apr_thread_t *tid,
+            void *data)
+{
+  encode_job_t *job = data;
+  parallel_encoder_t *encoder = job->encoder;
+
+  job->err = encode_window(&job->instructions, &job->header, &job->newdata,
+                           job->window, job->version,
+                           job->compression_level, job->pool);
+
+  /* The main thread will wait forever if we could not signal it.  There
+     is no way to tell it about errors here, so at least make sure the
+     flag gets set. */
+  if (svn_mutex__lock(encoder->mutex))
+    {
+      job->done = TRUE;
+      return NULL;
+    }
+
+  job->done = TRUE;
+  apr_thread_cond_broadcast(encoder->cond);
+  svn_error_clear(svn_mutex__unlock(encoder->mutex, SVN_NO_ERROR));
+
+  return NULL;
+}
+
+/* Wait for the oldest pending job in EB's pipeline, write its result
+   to the output stream and release it. */
+static svn_error_t *
+flush_oldest_job(struct encoder_baton *eb)
+{
+  parallel_encoder_t *encoder = eb->parallel;
+  encode_job_t *job = encoder->jobs[encoder->first];
+  svn_error_t *err;
+
+  SVN_ERR(wait_for_job(encoder, job));
+
+  encoder->jobs[encoder->first] = NULL;
+  encoder->first = (encoder->first + 1) % encoder->max_jobs;
+  encoder->count--;
+
+  err = job->err;
+  if (!err)
+    err = write_encoded_window(eb, job->header, job->instructions,
+                               job->newdata);
+
+  svn_pool_destroy(job->pool);
+
+  return svn_error_trace(err);
+}
+
+/* Write out the results of all jobs at the head of EB's pipeline that
+   have been completed.  If WAIT_FOR_ALL is set, wait for all pending
+   jobs and write them out, too. */
+static svn_error_t *
+flush_jobs(struct encoder_baton *eb,
+           svn_boolean_t wait_for_all)
+{
+  parallel_encoder_t *encoder = eb->parallel;
+
+  while (encoder->count)
+    {
+      if (!wait_for_all)
+        {
+          svn_boolean_t done;
+          SVN_ERR(is_job_done(&done, encoder,
+                              encoder->jobs[encoder->first]));
+          if (!done)
+            break;
+        }
+
+      SVN_ERR(flush_oldest_job(eb));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Pool pre-cleanup function for the encoder_baton given by DATA.
+   Worker threads may still process windows for an encoder that never
+   got to see the final NULL window, e.g. due to some error.  Wait for
+   them before their data gets released. */
+static apr_status_t
+parallel_encoder_cleanup(void *data)
+{
+  struct encoder_baton *eb = data;
+  parallel_encoder_t *encoder = eb->parallel;
+
+  if (encoder && encoder->jobs_pool)
+    {
+      while (encoder->count)
+        {
+          encode_job_t *job = encoder->jobs[encoder->first];
+          svn_error_clear(wait_for_job(encoder, job));
+          svn_error_clear(job->err);
+
+          encoder->first = (encoder->first + 1) % encoder->max_jobs;
+          encoder->count--;
+        }
+
+      svn_pool_destroy(encoder->jobs_pool);
+      encoder->jobs_pool = NULL;
+    }
+
+  return APR_SUCCESS;
+}
+
+/* Set EB->PARALLEL to a new, empty window pipeline.  Leave it as NULL if
+   the environment does not support parallel encoding. */
+static svn_error_t *
+create_parallel_encoder(struct encoder_baton *eb)
+{
+  parallel_encoder_t *encoder;
+  apr_status_t status;
+
+  if (svn_atomic__init_once_no_error(&encoder_thread_pool_state,
+                                     init_encoder_thread_pool, NULL))
+    return SVN_NO_ERROR;
+
+  encoder = apr_pcalloc(eb->pool, sizeof(*encoder));
+  SVN_ERR(svn_mutex__init(&encoder->mutex, TRUE, eb->pool));
+  status = apr_thread_cond_create(&encoder->cond, eb->pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create condition variable"));
+
+  /* Keep all workers busy while the results of the previous batch get
+     written. */
+  encoder->max_jobs = 2 * encoder_threads;
+  encoder->jobs = apr_pcalloc(eb->pool,
+                              encoder->max_jobs * sizeof(*encoder->jobs));
+  encoder->jobs_pool = svn_pool_create_ex(NULL,
+                                          svn_pool_create_allocator(TRUE));
+
+  /* Must run before the mutex & condition variable get destroyed. */
+  apr_pool_pre_cleanup_register(eb->pool, eb, parallel_encoder_cleanup);
+  eb->parallel = encoder;
+
+  return SVN_NO_ERROR;
+}
+
+/* Queue WINDOW for encoding in EB's window pipeline.  Write all completed
+   windows at the head of the pipeline to the output stream. */
+static svn_error_t *
+push_window(struct encoder_baton *eb,
+            svn_txdelta_window_t *window)
+{
+  parallel_encoder_t *encoder = eb->parallel;
+  apr_pool_t *pool;
+  encode_job_t *job;
+  apr_status_t status;
+
+  /* Make room for the new job. */
+  if (encoder->count == encoder->max_jobs)
+    SVN_ERR(flush_oldest_job(eb));
+
+  /* WINDOW will be invalid once we return. */
+  pool = svn_pool_create(encoder->jobs_pool);
+  job = apr_pcalloc(pool, sizeof(*job));
+  job->window = svn_txdelta_window_dup(window, pool);
+  job->version = eb->version;
+  job->compression_level = eb->compression_level;
+  job->encoder = encoder;
+  job->pool = pool;
+
+  encoder->jobs[(encoder->first + encoder->count) % encoder->max_jobs] = job;
+  encoder->count++;
+
+  status = apr_thread_pool_push(encoder_thread_pool, encode_task, job,
+                                0, encoder);
+  if (status)
+    {
+      /* Do it ourselves then. */
+      job->err = encode_window(&job->instructions, &job->header,
+                               &job->newdata, job->window, job->version,
+                               job->compression_level, job->pool);
+      job->done = TRUE;
+    }
+
+  return svn_error_trace(flush_jobs(eb, FALSE));
+}
+
+#endif
+
 static svn_error_t *
 window_handler(svn_txdelta_window_t *window, void *baton)
 {
@@ -248,6 +635,16 @@ window_handler(svn_txdelta_window_t *window, void *baton)
 
   if (window == NULL)
     {
+#if APR_HAS_THREADS
+      /* Write out all windows still in the pipeline. */
+      if (eb->parallel)
+        {
+          SVN_ERR(flush_jobs(eb, TRUE));
+          svn_pool_destroy(eb->parallel->jobs_pool);
+          eb->parallel->jobs_pool = NULL;
+        }
+#endif
+
       /* We're done; clean up. */
       SVN_ERR(svn_stream_close(eb->output));
 
@@ -256,6 +653,24 @@ window_handler(svn_txdelta_window_t *window, void *baton)
       return SVN_NO_ERROR;
     }
 
+#if APR_HAS_THREADS
+  /* Only compression is expensive enough to be worth the overhead of
+     the pipeline.  Deltas with a single window are common and would see
+     no benefit, either.  So, encode the first window directly. */
+  if (   eb->window_count++
+      && eb->version > 0
+      && (   eb->version == 2
+          || eb->compression_level != SVN_DELTA_COMPRESSION_LEVEL_NONE)
+      && encoder_threads > 0)
+    {
+      if (!eb->parallel)
+        SVN_ERR(create_parallel_encoder(eb));
+
+      if (eb->parallel)
+        return svn_error_trace(push_window(eb, window));
+    }
+#endif
+
   svn_pool_clear(eb->scratch_pool);
 
   SVN_ERR(encode_window(&instructions, &header, &newdata, window,
@@ -263,20 +678,8 @@ window_handler(svn_txdelta_window_t *window, void *baton)
                         eb->scratch_pool));
 
   /* Write out the window.  */
-  len = header->len;
-  SVN_ERR(svn_stream_write(eb->output, header->data, &len));
-  if (instructions->len > 0)
-    {
-      len = instructions->len;
-      SVN_ERR(svn_stream_write(eb->output, instructions->data, &len));
-    }
-  if (newdata->len > 0)
-    {
-      len = newdata->len;
-      SVN_ERR(svn_stream_write(eb->output, newdata->data, &len));
-    }
-
-  return SVN_NO_ERROR;
+  return svn_error_trace(write_encoded_window(eb, header, instructions,
+                                              newdata));
 }
 
 void
@@ -295,6 +698,11 @@ svn_txdelta_to_svndiff3(svn_txdelta_window_handler_t *handler,
   eb->scratch_pool = svn_pool_create(pool);
   eb->version = svndiff_version;
   eb->compression_level = compression_level;
+  eb->pool = pool;
+  eb->window_count = 0;
+#if APR_HAS_THREADS
+  eb->parallel = NULL;
+#endif
 
   *handler = window_handler;
   *handler_baton = eb;
@@ -521,14 +929,15 @@ count_and_verify_instructions(int *ninst,
 
 /* Given the five integer fields of a window header and a pointer to
    the remainder of the window contents, fill in a delta window
-   structure *WINDOW.  New allocations will be performed in POOL;
-   the new_data field of *WINDOW will refer directly to memory pointed
-   to by DATA. */
+   structure *WINDOW.  New allocations will be performed in POOL.
+   For svndiff0 data, the new_data field of *WINDOW will refer directly
+   to the memory pointed to by DATA if ZERO_COPY is set; the resulting
+   string is then not NUL-terminated.  Otherwise, it will be a copy. */
 static svn_error_t *
 decode_window(svn_txdelta_window_t *window, svn_filesize_t sview_offset,
               apr_size_t sview_len, apr_size_t tview_len, apr_size_t inslen,
               apr_size_t newlen, const unsigned char *data, apr_pool_t *pool,
-              unsigned int version)
+              unsigned int version, svn_boolean_t zero_copy)
 {
   const unsigned char *insend;
   int ninst;
@@ -558,6 +967,28 @@ decode_window(svn_txdelta_window_t *window, svn_filesize_t sview_offset,
 
       new_data = svn_stringbuf__morph_into_string(ndout);
     }
+  else if (version == 2)
+    {
+      svn_stringbuf_t *instout = svn_stringbuf_create_empty(pool);
+      svn_stringbuf_t *ndout = svn_stringbuf_create_empty(pool);
+
+      SVN_ERR(svn__decompress_lz4(insend, newlen, ndout,
+                                  SVN_DELTA_WINDOW_SIZE));
+      SVN_ERR(svn__decompress_lz4(data, insend - data, instout,
+                                  MAX_INSTRUCTION_SECTION_LEN));
+
+      newlen = ndout->len;
+      data = (unsigned char *)instout->data;
+      insend = (unsigned char *)instout->data + instout->len;
+
+      new_data = svn_stringbuf__morph_into_string(ndout);
+    }
+  else if (zero_copy)
+    {
+      new_data = apr_palloc(pool, sizeof(*new_data));
+      new_data->data = (const char *)insend;
+      new_data->len = newlen;
+    }
   else
     {
       /* Copy the data because an svn_string_t must have the invariant
@@ -593,56 +1024,22 @@ decode_window(svn_txdelta_window_t *window, svn_filesize_t sview_offset,
   return SVN_NO_ERROR;
 }
 
+/* Decode all complete windows in the svndiff data [*DATA..END-1] and
+   send them to DB's consumer.  Advance *DATA to the first byte that
+   does not belong to a complete window.  If ZERO_COPY is set, windows
+   may refer to the data directly; see decode_window(). */
 static svn_error_t *
-write_handler(void *baton,
-              const char *buffer,
-              apr_size_t *len)
+decode_windows(struct decode_baton *db,
+               const unsigned char **data,
+               const unsigned char *end,
+               svn_boolean_t zero_copy)
 {
-  struct decode_baton *db = (struct decode_baton *) baton;
-  const unsigned char *p, *end;
-  apr_size_t buflen = *len;
-
-  /* Chew up four bytes at the beginning for the header.  */
-  if (db->header_bytes < SVNDIFF_HEADER_SIZE)
-    {
-      apr_size_t nheader = SVNDIFF_HEADER_SIZE - db->header_bytes;
-      if (nheader > buflen)
-        nheader = buflen;
-      if (memcmp(buffer, SVNDIFF_V0 + db->header_bytes, nheader) == 0)
-        db->version = 0;
-      else if (memcmp(buffer, SVNDIFF_V1 + db->header_bytes, nheader) == 0)
-        db->version = 1;
-      else
-        return svn_error_create(SVN_ERR_SVNDIFF_INVALID_HEADER, NULL,
-                                _("Svndiff has invalid header"));
-      buflen -= nheader;
-      buffer += nheader;
-      db->header_bytes += nheader;
-    }
-
-  /* Concatenate the old with the new.  */
-  svn_stringbuf_appendbytes(db->buffer, buffer, buflen);
-
-  /* We have a buffer of svndiff data that might be good for:
-
-     a) an integral number of windows' worth of data - this is a
-        trivial case.  Make windows from our data and ship them off.
-
-     b) a non-integral number of windows' worth of data - we shall
-        consume the integral portion of the window data, and then
-        somewhere in the following loop the decoding of the svndiff
-        data will run out of stuff to decode, and will simply return
-        SVN_NO_ERROR, anxiously awaiting more data.
-  */
+  const unsigned char *p = *data;
 
   while (1)
     {
       svn_txdelta_window_t window;
 
-      /* Read the header, if we have enough bytes for that.  */
-      p = (const unsigned char *) db->buffer->data;
-      end = (const unsigned char *) db->buffer->data + db->buffer->len;
-
       if (db->window_header_len == 0)
         {
           svn_filesize_t sview_offset;
@@ -671,7 +1068,7 @@ write_handler(void *baton,
 
           if (tview_len > SVN_DELTA_WINDOW_SIZE ||
               sview_len > SVN_DELTA_WINDOW_SIZE ||
-              /* for svndiff1, newlen includes the original length */
+              /* for svndiff1 and 2, newlen includes the original length */
               newlen > SVN_DELTA_WINDOW_SIZE + SVN__MAX_ENCODED_UINT_LEN ||
               inslen > MAX_INSTRUCTION_SECTION_LEN)
             return svn_error_create(
@@ -712,18 +1109,16 @@ write_handler(void *baton,
       /* Wait for more data if we don't have enough bytes for the
          whole window. */
       if ((apr_size_t) (end - p) < db->inslen + db->newlen)
-        return SVN_NO_ERROR;
+        break;
 
       /* Decode the window and send it off. */
       SVN_ERR(decode_window(&window, db->sview_offset, db->sview_len,
                             db->tview_len, db->inslen, db->newlen, p,
-                            db->subpool, db->version));
+                            db->subpool, db->version, zero_copy));
       SVN_ERR(db->consumer_func(&window, db->consumer_baton));
 
       p += db->inslen + db->newlen;
-
-      /* Remove processed data from the buffer.  */
-      svn_stringbuf_remove(db->buffer, 0, db->buffer->len - (end - p));
+      *data = p;
 
       /* Reset window header length. */
       db->window_header_len = 0;
@@ -736,17 +1131,108 @@ write_handler(void *baton,
       svn_pool_clear(db->subpool);
     }
 
-  /* At this point we processed all integral windows and DB->BUFFER is empty
-     or contains partially read window header.
-     Check that unprocessed data is not larger than theoretical maximum
-     window header size. */
-  if (db->buffer->len > 5 * SVN__MAX_ENCODED_UINT_LEN)
+  return SVN_NO_ERROR;
+}
+
+/* Check that the unprocessed data of LEN bytes left behind by
+   decode_windows() for DB is not larger than the theoretical maximum
+   window header size. */
+static svn_error_t *
+check_unprocessed_len(struct decode_baton *db,
+                      apr_size_t len)
+{
+  if (db->window_header_len == 0 && len > 5 * SVN__MAX_ENCODED_UINT_LEN)
     return svn_error_create(SVN_ERR_SVNDIFF_CORRUPT_WINDOW, NULL,
                             _("Svndiff contains a too-large window header"));
 
   return SVN_NO_ERROR;
 }
 
+/* Parse the svndiff header at the start of the LEN bytes at BUFFER for
+   DB.  Return the number of header bytes consumed in *HEADER_LEN. */
+static svn_error_t *
+decode_header(struct decode_baton *db,
+              apr_size_t *header_len,
+              const char *buffer,
+              apr_size_t len)
+{
+  apr_size_t nheader = SVNDIFF_HEADER_SIZE - db->header_bytes;
+  if (nheader > len)
+    nheader = len;
+  if (memcmp(buffer, SVNDIFF_V0 + db->header_bytes, nheader) == 0)
+    db->version = 0;
+  else if (memcmp(buffer, SVNDIFF_V1 + db->header_bytes, nheader) == 0)
+    db->version = 1;
+  else if (memcmp(buffer, SVNDIFF_V2 + db->header_bytes, nheader) == 0)
+    db->version = 2;
+  else
+    return svn_error_create(SVN_ERR_SVNDIFF_INVALID_HEADER, NULL,
+                            _("Svndiff has invalid header"));
+
+  db->header_bytes += nheader;
+  *header_len = nheader;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+write_handler(void *baton,
+              const char *buffer,
+              apr_size_t *len)
+{
+  struct decode_baton *db = (struct decode_baton *) baton;
+  const unsigned char *p, *end;
+  apr_size_t buflen = *len;
+
+  /* Chew up four bytes at the beginning for the header.  */
+  if (db->header_bytes < SVNDIFF_HEADER_SIZE)
+    {
+      apr_size_t nheader;
+
+      SVN_ERR(decode_header(db, &nheader, buffer, buflen));
+      buflen -= nheader;
+      buffer += nheader;
+    }
+
+  /* We have a chunk of svndiff data that might be good for:
+
+     a) an integral number of windows' worth of data - this is a
+        trivial case.  Make windows from our data and ship them off.
+
+     b) a non-integral number of windows' worth of data - we shall
+        consume the integral portion of the window data, and then
+        the decoding of the svndiff data will run out of stuff to
+        decode, and we keep the rest, anxiously awaiting more data.
+
+     If nothing is left over from previous calls, decode straight from
+     the caller's BUFFER and only keep the tail. */
+  if (db->buffer->len == 0)
+    {
+      p = (const unsigned char *) buffer;
+      end = (const unsigned char *) buffer + buflen;
+
+      SVN_ERR(decode_windows(db, &p, end, FALSE));
+      svn_stringbuf_appendbytes(db->buffer, (const char *) p, end - p);
+    }
+  else
+    {
+      /* Concatenate the old with the new.  */
+      svn_stringbuf_appendbytes(db->buffer, buffer, buflen);
+
+      p = (const unsigned char *) db->buffer->data;
+      end = (const unsigned char *) db->buffer->data + db->buffer->len;
+
+      SVN_ERR(decode_windows(db, &p, end, FALSE));
+
+      /* Remove processed data from the buffer.  */
+      svn_stringbuf_remove(db->buffer, 0, db->buffer->len - (end - p));
+    }
+
+  /* At this point we processed all integral windows and DB->BUFFER is
+     empty or contains a partially read window. */
+  return svn_error_trace(check_unprocessed_len(db, db->buffer->len));
+}
+
 /* Minimal svn_stream_t write handler, doing nothing */
 static svn_error_t *
 noop_write_handler(void *baton,
@@ -815,6 +1301,45 @@ svn_txdelta_parse_svndiff(svn_txdelta_window_handler_t handler,
 }
 
 
+svn_error_t *
+svn_txdelta__parse_svndiff_buffer(const char *data,
+                                  apr_size_t len,
+                                  svn_txdelta_window_handler_t handler,
+                                  void *handler_baton,
+                                  apr_pool_t *scratch_pool)
+{
+  struct decode_baton db = { 0 };
+  const unsigned char *p, *end;
+  apr_size_t nheader;
+
+  if (len < SVNDIFF_HEADER_SIZE)
+    return svn_error_create(SVN_ERR_SVNDIFF_UNEXPECTED_END, NULL,
+                            _("Unexpected end of svndiff input"));
+
+  SVN_ERR(decode_header(&db, &nheader, data, len));
+
+  db.consumer_func = handler;
+  db.consumer_baton = handler_baton;
+  db.subpool = svn_pool_create(scratch_pool);
+
+  p = (const unsigned char *) data + nheader;
+  end = (const unsigned char *) data + len;
+  SVN_ERR(decode_windows(&db, &p, end, TRUE));
+
+  if (p != end)
+    {
+      SVN_ERR(check_unprocessed_len(&db, end - p));
+      return svn_error_create(SVN_ERR_SVNDIFF_UNEXPECTED_END, NULL,
+                              _("Unexpected end of svndiff input"));
+    }
+
+  svn_pool_destroy(db.subpool);
+
+  /* Tell the window consumer that we're done. */
+  return svn_error_trace(handler(NULL, handler_baton));
+}
+
+
 /* Routines for reading one svndiff window at a time. */
 
 /* Read one byte from STREAM into *BYTE. */
@@ -911,14 +1436,19 @@ svn_txdelta_read_svndiff_window(svn_txdelta_window_t **window,
   SVN_ERR(read_window_header(stream, &sview_offset, &sview_len, &tview_len,
                              &inslen, &newlen, &header_len));
   len = inslen + newlen;
-  buf = apr_palloc(pool, len);
+
+  /* The new data section comes last.  Terminate it, so that the window
+     can use it in-place. */
+  buf = apr_palloc(pool, len + 1);
   SVN_ERR(svn_stream_read_full(stream, (char*)buf, &len));
   if (len < inslen + newlen)
     return svn_error_create(SVN_ERR_SVNDIFF_UNEXPECTED_END, NULL,
                             _("Unexpected end of svndiff input"));
+  buf[len] = '\0';
+
   *window = apr_palloc(pool, sizeof(**window));
   return decode_window(*window, sview_offset, sview_len, tview_len, inslen,
-                       newlen, buf, pool, svndiff_version);
+                       newlen, buf, pool, svndiff_version, TRUE);
 }
 
 
@@ -954,3 +1484,19 @@ svn_txdelta__read_raw_window_len(apr_size_t *window_len,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_txdelta__read_raw_window_sizes(apr_size_t *tview_len,
+                                   apr_size_t *window_len,
+                                   svn_stream_t *stream,
+                                   apr_pool_t *pool)
+{
+  svn_filesize_t sview_offset;
+  apr_size_t sview_len, inslen, newlen, header_len;
+
+  SVN_ERR(read_window_header(stream, &sview_offset, &sview_len, tview_len,
+                             &inslen, &newlen, &header_len));
+
+  *window_len = inslen + newlen + header_len;
+  return SVN_NO_ERROR;
+}
+
@@ -28,13 +28,96 @@
 #include <apr_general.h>        /* for APR_INLINE */
 #include <apr_md5.h>            /* for, um...MD5 stuff */
 
+#if APR_HAS_THREADS
+#include <apr_thread_pool.h>
+#include <apr_thread_cond.h>
+#endif
+
 #include "svn_delta.h"
 #include "svn_io.h"
 #include "svn_pools.h"
 #include "svn_checksum.h"
+#include "svn_sorts.h"
+#include "svn_private_config.h"
+
+#include "private/svn_delta_private.h"
+#include "private/svn_atomic.h"
+#include "private/svn_mutex.h"
 
 #include "delta.h"
 
+
+/* Default for the maximum number of worker threads computing delta
+   windows concurrently. */
+#define DEFAULT_DELTA_THREADS 4
+
+/* Maximum number of worker threads, see svn_delta__set_delta_threads().
+   0 disables the parallel delta computation. */
+static int delta_threads = DEFAULT_DELTA_THREADS;
+
+#if APR_HAS_THREADS
+
+/* Number of microseconds that an unused delta thread remains in the
+   pool before being terminated. */
+#define THREADPOOL_THREAD_IDLE_LIMIT 1000000
+
+/* Thread pool shared by all parallel delta streams.  NULL if it could not
+   be created. */
+static apr_thread_pool_t *delta_thread_pool = NULL;
+
+/* Initialization state of DELTA_THREAD_POOL. */
+static volatile svn_atomic_t delta_thread_pool_state = 0;
+
+struct parallel_delta_t;
+
+/* A single delta window to be computed by a worker thread. */
+typedef struct delta_job_t
+{
+  /* SOURCE_LEN bytes of source data followed by TARGET_LEN bytes of
+     target data.  The source data starts at SOURCE_OFFSET. */
+  char *data;
+  apr_size_t source_len;
+  apr_size_t target_len;
+  svn_filesize_t source_offset;
+
+  /* The resulting delta window, valid once DONE has been set. */
+  svn_txdelta_window_t *window;
+
+  /* Set under PIPELINE->MUTEX when the worker finished. */
+  svn_boolean_t done;
+
+  /* The pipeline that this job belongs to. */
+  struct parallel_delta_t *pipeline;
+
+  /* Pool used exclusively for this job.  Destroyed after the window
+     has been handed out. */
+  apr_pool_t *pool;
+} delta_job_t;
+
+/* State of the delta window pipeline.  Jobs get queued in window order
+   and the windows are returned strictly in that order, too. */
+typedef struct parallel_delta_t
+{
+  /* Protects all DONE flags and is used with COND. */
+  svn_mutex__t *mutex;
+
+  /* Signaled whenever a job completes. */
+  apr_thread_cond_t *cond;
+
+  /* Ring buffer of MAX_JOBS pending jobs, the oldest at index FIRST. */
+  delta_job_t **jobs;
+  int max_jobs;
+  int first;
+  int count;
+
+  /* TRUE once the end of the target stream has been reached. */
+  svn_boolean_t target_done;
+
+  /* Thread-safe root pool that all job pools are created in. */
+  apr_pool_t *jobs_pool;
+} parallel_delta_t;
+
+#endif
 
 /* Text delta stream descriptor. */
 
@@ -62,6 +145,12 @@ struct txdelta_baton {
   svn_checksum_t *checksum;     /* If non-NULL, the checksum of TARGET. */
 
   apr_pool_t *result_pool;      /* For results (e.g. checksum) */
+  apr_pool_t *pool;             /* Pool that this baton lives in. */
+
+#if APR_HAS_THREADS
+  parallel_delta_t *parallel;   /* Window pipeline; created once we know
+                                   that there are multiple windows. */
+#endif
 };
 
 
@@ -353,44 +442,314 @@ svn_txdelta_md5_digest(svn_txdelta_stream_t *stream)
 
 
 
+void
+svn_delta__set_delta_threads(int threads)
+{
+  delta_threads = threads > 0 ? threads : 0;
+}
+
+/* Read the data for the next delta window of B into BUF, which must
+   provide space for 2 * SVN_DELTA_WINDOW_SIZE bytes.  Return the number
+   of source and target bytes read in *SOURCE_LEN and *TARGET_LEN,
+   respectively.  The source data precedes the target data in BUF.
+
+   *TARGET_LEN will be 0 at the end of the target stream.  The target
+   checksum will then be final. */
 static svn_error_t *
-txdelta_next_window(svn_txdelta_window_t **window,
-                    void *baton,
-                    apr_pool_t *pool)
+read_window_data(apr_size_t *source_len,
+                 apr_size_t *target_len,
+                 struct txdelta_baton *b,
+                 char *buf)
 {
-  struct txdelta_baton *b = baton;
-  apr_size_t source_len = SVN_DELTA_WINDOW_SIZE;
-  apr_size_t target_len = SVN_DELTA_WINDOW_SIZE;
+  *source_len = SVN_DELTA_WINDOW_SIZE;
+  *target_len = SVN_DELTA_WINDOW_SIZE;
 
   /* Read the source stream. */
   if (b->more_source)
     {
-      SVN_ERR(svn_stream_read_full(b->source, b->buf, &source_len));
-      b->more_source = (source_len == SVN_DELTA_WINDOW_SIZE);
+      SVN_ERR(svn_stream_read_full(b->source, buf, source_len));
+      b->more_source = (*source_len == SVN_DELTA_WINDOW_SIZE);
     }
   else
-    source_len = 0;
+    *source_len = 0;
 
   /* Read the target stream. */
-  SVN_ERR(svn_stream_read_full(b->target, b->buf + source_len, &target_len));
-  b->pos += source_len;
+  SVN_ERR(svn_stream_read_full(b->target, buf + *source_len, target_len));
+  b->pos += *source_len;
 
-  if (target_len == 0)
+  if (*target_len == 0)
     {
-      /* No target data?  We're done; return the final window. */
+      /* No target data?  We're done. */
       if (b->context != NULL)
         SVN_ERR(svn_checksum_final(&b->checksum, b->context, b->result_pool));
+    }
+  else if (b->context != NULL)
+    SVN_ERR(svn_checksum_update(b->context, buf + *source_len, *target_len));
+
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS
+
+/* Implements svn_atomic__str_init_func_t.
+   Create DELTA_THREAD_POOL. */
+static const char *
+init_delta_thread_pool(void *baton)
+{
+  /* The thread-pool must be allocated from a thread-safe pool that lives
+     as long as the process. */
+  apr_pool_t *pool = svn_pool_create(NULL);
+  apr_status_t status;
+
+  status = apr_thread_pool_create(&delta_thread_pool, 0, delta_threads,
+                                  pool);
+  if (status)
+    {
+      delta_thread_pool = NULL;
+      svn_pool_destroy(pool);
+      return "Can't create delta thread pool";
+    }
+
+  /* Let idle threads linger for a while; the next large file is often
+     not far away. */
+  apr_thread_pool_idle_wait_set(delta_thread_pool,
+                                THREADPOOL_THREAD_IDLE_LIMIT);
+
+  return NULL;
+}
+
+/* Lock PIPELINE->MUTEX and wait until JOB has been completed. */
+static svn_error_t *
+wait_for_delta_job(parallel_delta_t *pipeline,
+                   delta_job_t *job)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+
+  SVN_ERR(svn_mutex__lock(pipeline->mutex));
+
+  /* This loop implicitly handles spurious wake-ups. */
+  while (!job->done)
+    {
+      apr_status_t status
+        = apr_thread_cond_wait(pipeline->cond,
+                               svn_mutex__get(pipeline->mutex));
+      if (status)
+        {
+          err = svn_error_wrap_apr(status,
+                                   _("Can't wait for condition variable"));
+          break;
+        }
+    }
+
+  return svn_error_trace(svn_mutex__unlock(pipeline->mutex, err));
+}
+
+/* Thread-pool task.  Compute the delta window for the delta_job_t given
+   by DATA. */
+static void * APR_THREAD_FUNC
+delta_task(apr_thread_t *tid,
+           void *data)
+{
+  delta_job_t *job = data;
+  parallel_delta_t *pipeline = job->pipeline;
+  svn_error_t *err;
+
+  job->window = compute_window(job->data, job->source_len, job->target_len,
+                               job->source_offset, job->pool);
+
+  /* The main thread will wait forever if we could not signal it.  There
+     is no way to tell it about errors here, so at least make sure the
+     flag gets set. */
+  err = svn_mutex__lock(pipeline->mutex);
+  if (err)
+    {
+      svn_error_clear(err);
+      job->done = TRUE;
+      return NULL;
+    }
+
+  job->done = TRUE;
+  apr_thread_cond_broadcast(pipeline->cond);
+  svn_error_clear(svn_mutex__unlock(pipeline->mutex, SVN_NO_ERROR));
+
+  return NULL;
+}
+
+/* Pool pre-cleanup function for the txdelta_baton given by DATA.
+   Worker threads may still process windows for a delta stream that has
+   not been read to the end.  Wait for them before their data gets
+   released. */
+static apr_status_t
+parallel_delta_cleanup(void *data)
+{
+  struct txdelta_baton *b = data;
+  parallel_delta_t *pipeline = b->parallel;
+
+  if (pipeline && pipeline->jobs_pool)
+    {
+      while (pipeline->count)
+        {
+          delta_job_t *job = pipeline->jobs[pipeline->first];
+          svn_error_clear(wait_for_delta_job(pipeline, job));
+
+          pipeline->first = (pipeline->first + 1) % pipeline->max_jobs;
+          pipeline->count--;
+        }
+
+      svn_pool_destroy(pipeline->jobs_pool);
+      pipeline->jobs_pool = NULL;
+    }
+
+  return APR_SUCCESS;
+}
+
+/* Set B->PARALLEL to a new, empty window pipeline.  Leave it as NULL if
+   the environment does not support parallel delta computation. */
+static svn_error_t *
+create_parallel_delta(struct txdelta_baton *b)
+{
+  parallel_delta_t *pipeline;
+  apr_status_t status;
+
+  if (svn_atomic__init_once_no_error(&delta_thread_pool_state,
+                                     init_delta_thread_pool, NULL))
+    return SVN_NO_ERROR;
+
+  pipeline = apr_pcalloc(b->pool, sizeof(*pipeline));
+  SVN_ERR(svn_mutex__init(&pipeline->mutex, TRUE, b->pool));
+  status = apr_thread_cond_create(&pipeline->cond, b->pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create condition variable"));
+
+  /* Keep all workers busy while the consumer processes the oldest
+     window. */
+  pipeline->max_jobs = 2 * delta_threads;
+  pipeline->jobs = apr_pcalloc(b->pool,
+                               pipeline->max_jobs * sizeof(*pipeline->jobs));
+  pipeline->jobs_pool = svn_pool_create_ex(NULL,
+                                           svn_pool_create_allocator(TRUE));
+
+  /* Must run before the mutex & condition variable get destroyed. */
+  apr_pool_pre_cleanup_register(b->pool, b, parallel_delta_cleanup);
+  b->parallel = pipeline;
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the data for the next window of B and queue it in B's pipeline.
+   Set the pipeline's TARGET_DONE flag at the end of the target stream. */
+static svn_error_t *
+push_delta_job(struct txdelta_baton *b)
+{
+  parallel_delta_t *pipeline = b->parallel;
+  apr_pool_t *pool = svn_pool_create(pipeline->jobs_pool);
+  delta_job_t *job = apr_pcalloc(pool, sizeof(*job));
+  apr_status_t status;
+
+  job->data = apr_palloc(pool, 2 * SVN_DELTA_WINDOW_SIZE);
+  SVN_ERR(read_window_data(&job->source_len, &job->target_len, b,
+                           job->data));
+  if (job->target_len == 0)
+    {
+      pipeline->target_done = TRUE;
+      svn_pool_destroy(pool);
+      return SVN_NO_ERROR;
+    }
+
+  job->source_offset = b->pos - job->source_len;
+  job->pipeline = pipeline;
+  job->pool = pool;
+
+  pipeline->jobs[(pipeline->first + pipeline->count) % pipeline->max_jobs]
+    = job;
+  pipeline->count++;
+
+  status = apr_thread_pool_push(delta_thread_pool, delta_task, job,
+                                0, pipeline);
+  if (status)
+    {
+      /* Do it ourselves then. */
+      job->window = compute_window(job->data, job->source_len,
+                                   job->target_len, job->source_offset,
+                                   job->pool);
+      job->done = TRUE;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the next window of B's pipeline in *WINDOW, allocated in POOL.
+   Refill the pipeline with new windows first. */
+static svn_error_t *
+next_parallel_window(svn_txdelta_window_t **window,
+                     struct txdelta_baton *b,
+                     apr_pool_t *pool)
+{
+  parallel_delta_t *pipeline = b->parallel;
+  delta_job_t *job;
+
+  while (!pipeline->target_done && pipeline->count < pipeline->max_jobs)
+    SVN_ERR(push_delta_job(b));
+
+  if (pipeline->count == 0)
+    {
+      /* We're done; return the final window. */
+      svn_pool_destroy(pipeline->jobs_pool);
+      pipeline->jobs_pool = NULL;
 
       *window = NULL;
       b->more = FALSE;
       return SVN_NO_ERROR;
     }
-  else if (b->context != NULL)
-    SVN_ERR(svn_checksum_update(b->context, b->buf + source_len, target_len));
+
+  job = pipeline->jobs[pipeline->first];
+  SVN_ERR(wait_for_delta_job(pipeline, job));
+
+  pipeline->jobs[pipeline->first] = NULL;
+  pipeline->first = (pipeline->first + 1) % pipeline->max_jobs;
+  pipeline->count--;
+
+  *window = svn_txdelta_window_dup(job->window, pool);
+  svn_pool_destroy(job->pool);
+
+  return SVN_NO_ERROR;
+}
+
+#endif
+
+static svn_error_t *
+txdelta_next_window(svn_txdelta_window_t **window,
+                    void *baton,
+                    apr_pool_t *pool)
+{
+  struct txdelta_baton *b = baton;
+  apr_size_t source_len;
+  apr_size_t target_len;
+
+#if APR_HAS_THREADS
+  if (b->parallel)
+    return svn_error_trace(next_parallel_window(window, b, pool));
+#endif
+
+  SVN_ERR(read_window_data(&source_len, &target_len, b, b->buf));
+  if (target_len == 0)
+    {
+      /* No target data?  We're done; return the final window. */
+      *window = NULL;
+      b->more = FALSE;
+      return SVN_NO_ERROR;
+    }
 
   *window = compute_window(b->buf, source_len, target_len,
                            b->pos - source_len, pool);
 
+#if APR_HAS_THREADS
+  /* Most deltas consist of a single window and would see no benefit from
+     the pipeline.  Start it only once there is likely more to come. */
+  if (target_len == SVN_DELTA_WINDOW_SIZE && delta_threads > 0)
+    SVN_ERR(create_parallel_delta(b));
+#endif
+
   /* That's it. */
   return SVN_NO_ERROR;
 }
@@ -427,19 +786,22 @@ svn_txdelta_run(svn_stream_t *source,
                 apr_pool_t *scratch_pool)
 {
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
-  struct txdelta_baton tb = { 0 };
+  struct txdelta_baton *tb = apr_pcalloc(scratch_pool, sizeof(*tb));
   svn_txdelta_window_t *window;
 
-  tb.source = source;
-  tb.target = target;
-  tb.more_source = TRUE;
-  tb.more = TRUE;
-  tb.pos = 0;
-  tb.buf = apr_palloc(scratch_pool, 2 * SVN_DELTA_WINDOW_SIZE);
-  tb.result_pool = result_pool;
+  /* TB must live in SCRATCH_POOL because a window pipeline will register
+     a cleanup for it. */
+  tb->source = source;
+  tb->target = target;
+  tb->more_source = TRUE;
+  tb->more = TRUE;
+  tb->pos = 0;
+  tb->buf = apr_palloc(scratch_pool, 2 * SVN_DELTA_WINDOW_SIZE);
+  tb->result_pool = result_pool;
+  tb->pool = scratch_pool;
 
   if (checksum != NULL)
-    tb.context = svn_checksum_ctx_create(checksum_kind, scratch_pool);
+    tb->context = svn_checksum_ctx_create(checksum_kind, scratch_pool);
 
   do
     {
@@ -447,7 +809,7 @@ svn_txdelta_run(svn_stream_t *source,
       svn_pool_clear(iterpool);
 
       /* read in a single delta window */
-      SVN_ERR(txdelta_next_window(&window, &tb, iterpool));
+      SVN_ERR(txdelta_next_window(&window, tb, iterpool));
 
       /* shove it at the handler */
       SVN_ERR((*handler)(window, handler_baton));
@@ -460,7 +822,7 @@ svn_txdelta_run(svn_stream_t *source,
   svn_pool_destroy(iterpool);
 
   if (checksum != NULL)
-    *checksum = tb.checksum;  /* should be there! */
+    *checksum = tb->checksum;  /* should be there! */
 
   return SVN_NO_ERROR;
 }
@@ -484,6 +846,7 @@ svn_txdelta2(svn_txdelta_stream_t **stream,
              ? svn_checksum_ctx_create(svn_checksum_md5, pool)
              : NULL;
   b->result_pool = pool;
+  b->pool = pool;
 
   *stream = svn_txdelta_stream_create(b, txdelta_next_window,
                                       txdelta_md5_digest, pool);
@@ -602,6 +965,507 @@ svn_txdelta_target_push(svn_txdelta_window_handler_t handler,
 }
 
 
+
+/* Functions for content-defined delta windows.
+ *
+ * Fixed-size windows pair the N-th target window with the N-th source
+ * window.  Data inserted into or removed from the target shifts all later
+ * target windows against their source windows, and once the shift gets
+ * close to SVN_DELTA_WINDOW_SIZE, xdelta finds hardly anything to copy.
+ *
+ * Here, target windows end where a "gear" rolling hash over the last
+ * CDC_HASH_WINDOW bytes has its top CDC_MASK_BITS bits cleared.  These
+ * boundaries depend on the local content only, so the same positions get
+ * found in the source.  We remember them as "anchors" while reading the
+ * source ahead and start each source view at the anchor that matches the
+ * beginning of the target window.  Where there is no such anchor, the
+ * source view follows the copies made by the previous window.
+ */
+
+/* Target windows are at least that long unless the target ends. */
+#define CDC_MIN_WINDOW (SVN_DELTA_WINDOW_SIZE / 4)
+
+/* Boundaries are where the top CDC_MASK_BITS bits of the hash are 0.
+   Only the top bits depend on all of the last CDC_HASH_WINDOW bytes. */
+#define CDC_MASK_BITS 15
+#define CDC_MASK (~APR_UINT64_C(0) << (64 - CDC_MASK_BITS))
+
+/* Bytes shift out of the hash after that many steps. */
+#define CDC_HASH_WINDOW 64
+
+/* Number of bytes to compare when matching a window start to an anchor. */
+#define CDC_ANCHOR_LEN 64
+
+/* Read the source that far ahead of the current source view.  Removed
+   sections of up to about that size can be bridged. */
+#define CDC_LOOKAHEAD (8 * SVN_DELTA_WINDOW_SIZE)
+
+/* Size of the source buffer.  The excess over CDC_LOOKAHEAD determines
+   how often we discard old data from the buffer. */
+#define CDC_SOURCE_BUFFER_SIZE (2 * CDC_LOOKAHEAD)
+
+/* Minimum distance between anchors, limiting their number. */
+#define CDC_ANCHOR_DISTANCE 4096
+#define CDC_MAX_ANCHORS (CDC_SOURCE_BUFFER_SIZE / CDC_ANCHOR_DISTANCE + 1)
+
+/* Without an anchor, start the source view up to that many bytes before
+   the expected source position. */
+#define CDC_VIEW_SLACK (SVN_DELTA_WINDOW_SIZE / 8)
+
+/* Random values per byte value for the gear hash. */
+static apr_uint64_t gear_table[256];
+static volatile svn_atomic_t gear_table_init_state = 0;
+
+/* Implements svn_atomic__str_init_func_t.  Fill GEAR_TABLE using
+   splitmix64, which gives us well-mixed, reproducible values. */
+static const char *
+init_gear_table(void *baton)
+{
+  apr_uint64_t seed = 0;
+  int i;
+
+  for (i = 0; i < 256; ++i)
+    {
+      apr_uint64_t value = (seed += APR_UINT64_C(0x9e3779b97f4a7c15));
+      value = (value ^ (value >> 30)) * APR_UINT64_C(0xbf58476d1ce4e5b9);
+      value = (value ^ (value >> 27)) * APR_UINT64_C(0x94d049bb133111eb);
+      gear_table[i] = value ^ (value >> 31);
+    }
+
+  return NULL;
+}
+
+/* Return the length of the next target window within the LEN bytes at
+   DATA.  LEN may only be less than SVN_DELTA_WINDOW_SIZE at the end of
+   the target. */
+static apr_size_t
+cdc_window_length(const char *data,
+                  apr_size_t len)
+{
+  const unsigned char *p = (const unsigned char *)data;
+  apr_uint64_t hash = 0;
+  apr_size_t i;
+
+  if (len <= CDC_MIN_WINDOW)
+    return len;
+  if (len > SVN_DELTA_WINDOW_SIZE)
+    len = SVN_DELTA_WINDOW_SIZE;
+
+  for (i = CDC_MIN_WINDOW - CDC_HASH_WINDOW; i < CDC_MIN_WINDOW; ++i)
+    hash = (hash << 1) + gear_table[p[i]];
+
+  for (; i < len; ++i)
+    {
+      if ((hash & CDC_MASK) == 0)
+        return i;
+
+      hash = (hash << 1) + gear_table[p[i]];
+    }
+
+  return len;
+}
+
+/* Source side of a content-defined delta. */
+typedef struct cdc_source_t
+{
+  /* The source stream and whether it has more data. */
+  svn_stream_t *stream;
+  svn_boolean_t more;
+
+  /* Read-ahead buffer holding LEN bytes of source data starting at
+     stream offset OFFSET. */
+  char *buf;
+  apr_size_t len;
+  svn_filesize_t offset;
+
+  /* Rolling hash over the data in front of OFFSET + LEN. */
+  apr_uint64_t hash;
+
+  /* Stream offsets of the boundaries found in BUF, ascending. */
+  svn_filesize_t anchors[CDC_MAX_ANCHORS];
+  int anchor_count;
+
+  /* Offset of the last source view.  Views must not slide backwards. */
+  svn_filesize_t view_offset;
+
+  /* Source offset that the next target window most likely starts at. */
+  svn_filesize_t expected;
+
+  /* Buffer for the source view and target window that we pass to xdelta.
+     Holds 2 * SVN_DELTA_WINDOW_SIZE bytes. */
+  char *window_buf;
+} cdc_source_t;
+
+/* Return a new source reader for SOURCE allocated in POOL. */
+static cdc_source_t *
+create_cdc_source(svn_stream_t *source,
+                  apr_pool_t *pool)
+{
+  cdc_source_t *cdc = apr_pcalloc(pool, sizeof(*cdc));
+
+  svn_atomic__init_once_no_error(&gear_table_init_state, init_gear_table,
+                                 NULL);
+
+  cdc->stream = source;
+  cdc->more = TRUE;
+  cdc->buf = apr_palloc(pool, CDC_SOURCE_BUFFER_SIZE);
+  cdc->window_buf = apr_palloc(pool, 2 * SVN_DELTA_WINDOW_SIZE);
+
+  return cdc;
+}
+
+/* Make CDC buffer the source data up to CDC_LOOKAHEAD bytes past its
+   current view. */
+static svn_error_t *
+fill_cdc_source(cdc_source_t *cdc)
+{
+  const unsigned char *p;
+  apr_size_t requested, to_read;
+  apr_size_t i;
+  svn_filesize_t pos;
+  svn_filesize_t last_anchor;
+  svn_filesize_t end;
+
+  /* Discard data that no future view can refer to. */
+  if (cdc->view_offset - cdc->offset > CDC_SOURCE_BUFFER_SIZE - CDC_LOOKAHEAD)
+    {
+      apr_size_t discard = (apr_size_t)(cdc->view_offset - cdc->offset);
+      int k;
+
+      memmove(cdc->buf, cdc->buf + discard, cdc->len - discard);
+      cdc->len -= discard;
+      cdc->offset += discard;
+
+      for (k = 0; k < cdc->anchor_count; ++k)
+        if (cdc->anchors[k] >= cdc->offset)
+          break;
+
+      memmove(cdc->anchors, cdc->anchors + k,
+              (cdc->anchor_count - k) * sizeof(*cdc->anchors));
+      cdc->anchor_count -= k;
+    }
+
+  /* LEN is bounded by CDC_SOURCE_BUFFER_SIZE, so it fits into the
+     offset type. */
+  end = cdc->offset + (svn_filesize_t)cdc->len;
+  if (!cdc->more || end >= cdc->view_offset + CDC_LOOKAHEAD)
+    return SVN_NO_ERROR;
+
+  /* Top up the buffer. */
+  requested = (apr_size_t)(cdc->view_offset + CDC_LOOKAHEAD - end);
+  to_read = requested;
+  SVN_ERR(svn_stream_read_full(cdc->stream, cdc->buf + cdc->len, &to_read));
+  cdc->more = (to_read == requested);
+
+  /* Find the boundaries within the new data. */
+  p = (const unsigned char *)cdc->buf + cdc->len;
+  pos = cdc->offset + cdc->len;
+  last_anchor = cdc->anchor_count
+              ? cdc->anchors[cdc->anchor_count - 1]
+              : -CDC_ANCHOR_DISTANCE;
+
+  for (i = 0; i < to_read; ++i, ++pos)
+    {
+      if (   (cdc->hash & CDC_MASK) == 0
+          && pos - last_anchor >= CDC_ANCHOR_DISTANCE)
+        {
+          cdc->anchors[cdc->anchor_count++] = pos;
+          last_anchor = pos;
+        }
+
+      cdc->hash = (cdc->hash << 1) + gear_table[p[i]];
+    }
+
+  cdc->len += to_read;
+
+  return SVN_NO_ERROR;
+}
+
+/* Compute the delta *WINDOW for the TARGET_LEN bytes of target data at
+   TARGET against a suitable view into the source of CDC.  Allocate the
+   window in POOL. */
+static svn_error_t *
+compute_cdc_window(svn_txdelta_window_t **window,
+                   cdc_source_t *cdc,
+                   const char *target,
+                   apr_size_t target_len,
+                   apr_pool_t *pool)
+{
+  svn_filesize_t start = -1;
+  svn_filesize_t best_distance = APR_INT64_MAX;
+  svn_filesize_t end;
+  apr_size_t source_len = 0;
+  apr_size_t target_pos;
+  int i;
+
+  SVN_ERR(fill_cdc_source(cdc));
+  end = cdc->offset + cdc->len;
+
+  /* Prefer the anchor closest to where we expect the target data. */
+  if (target_len >= CDC_ANCHOR_LEN)
+    for (i = 0; i < cdc->anchor_count; ++i)
+      {
+        svn_filesize_t anchor = cdc->anchors[i];
+        svn_filesize_t distance = anchor > cdc->expected
+                                ? anchor - cdc->expected
+                                : cdc->expected - anchor;
+
+        if (anchor < cdc->view_offset)
+          continue;
+        if (anchor + CDC_ANCHOR_LEN > end)
+          break;
+
+        if (   distance < best_distance
+            && memcmp(cdc->buf + (anchor - cdc->offset), target,
+                      CDC_ANCHOR_LEN) == 0)
+          {
+            start = anchor;
+            best_distance = distance;
+          }
+      }
+
+  /* Otherwise, cover the expected range and use any spare room in the
+     view to catch small backward shifts. */
+  if (start < 0)
+    {
+      svn_filesize_t slack = MIN(CDC_VIEW_SLACK,
+                                 SVN_DELTA_WINDOW_SIZE - (svn_filesize_t)target_len);
+      start = MAX(cdc->view_offset, cdc->expected - slack);
+    }
+
+  if (start < end)
+    source_len = (apr_size_t)MIN(end - start, SVN_DELTA_WINDOW_SIZE);
+  else
+    start = cdc->view_offset;
+
+  memcpy(cdc->window_buf, cdc->buf + (start - cdc->offset), source_len);
+  memcpy(cdc->window_buf + source_len, target, target_len);
+  *window = compute_window(cdc->window_buf, source_len, target_len, start,
+                           pool);
+
+  if (source_len)
+    cdc->view_offset = start;
+
+  /* The next target window should continue in the source right after
+     the last source copy of this window.  Pure insertions leave the
+     expected position where it is. */
+  for (i = 0, target_pos = 0; i < (*window)->num_ops; ++i)
+    {
+      const svn_txdelta_op_t *op = &(*window)->ops[i];
+      target_pos += op->length;
+
+      if (op->action_code == svn_txdelta_source)
+        cdc->expected = start + op->offset + op->length
+                      + (target_len - target_pos);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Pull-style content-defined delta stream. */
+struct cdc_baton
+{
+  svn_stream_t *target;
+  svn_boolean_t more_target;    /* FALSE if target stream hit EOF. */
+  cdc_source_t *cdc;
+
+  /* The next TARGET_LEN bytes of target data.  Holds up to
+     SVN_DELTA_WINDOW_SIZE bytes. */
+  char *buf;
+  apr_size_t target_len;
+
+  svn_checksum_ctx_t *context;  /* If not NULL, the context for computing
+                                   the checksum. */
+  svn_checksum_t *checksum;     /* If non-NULL, the checksum of TARGET. */
+  apr_pool_t *pool;
+};
+
+/* Implements svn_txdelta_next_window_fn_t. */
+static svn_error_t *
+cdc_next_window(svn_txdelta_window_t **window,
+                void *baton,
+                apr_pool_t *pool)
+{
+  struct cdc_baton *b = baton;
+  apr_size_t window_len;
+
+  if (b->more_target)
+    {
+      apr_size_t len = SVN_DELTA_WINDOW_SIZE - b->target_len;
+      SVN_ERR(svn_stream_read_full(b->target, b->buf + b->target_len, &len));
+      b->more_target = (b->target_len + len == SVN_DELTA_WINDOW_SIZE);
+
+      if (b->context != NULL)
+        SVN_ERR(svn_checksum_update(b->context, b->buf + b->target_len, len));
+      b->target_len += len;
+
+      if (!b->more_target && b->context != NULL)
+        SVN_ERR(svn_checksum_final(&b->checksum, b->context, b->pool));
+    }
+
+  if (b->target_len == 0)
+    {
+      *window = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  window_len = cdc_window_length(b->buf, b->target_len);
+  SVN_ERR(compute_cdc_window(window, b->cdc, b->buf, window_len, pool));
+
+  b->target_len -= window_len;
+  memmove(b->buf, b->buf + window_len, b->target_len);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_txdelta_md5_digest_fn_t. */
+static const unsigned char *
+cdc_md5_digest(void *baton)
+{
+  struct cdc_baton *b = baton;
+
+  /* Only available once we read all of the target. */
+  if (b->more_target || b->checksum == NULL)
+    return NULL;
+
+  return b->checksum->digest;
+}
+
+void
+svn_txdelta__cdc(svn_txdelta_stream_t **stream,
+                 svn_stream_t *source,
+                 svn_stream_t *target,
+                 svn_boolean_t calculate_checksum,
+                 apr_pool_t *pool)
+{
+  struct cdc_baton *b = apr_pcalloc(pool, sizeof(*b));
+
+  b->target = target;
+  b->more_target = TRUE;
+  b->cdc = create_cdc_source(source, pool);
+  b->buf = apr_palloc(pool, SVN_DELTA_WINDOW_SIZE);
+  b->context = calculate_checksum
+             ? svn_checksum_ctx_create(svn_checksum_md5, pool)
+             : NULL;
+  b->pool = pool;
+
+  *stream = svn_txdelta_stream_create(b, cdc_next_window, cdc_md5_digest,
+                                      pool);
+}
+
+
+/* Push-style content-defined delta stream. */
+struct cdc_push_baton
+{
+  svn_txdelta_window_handler_t wh;
+  void *whb;
+  cdc_source_t *cdc;
+
+  /* Buffered target data.  Holds up to SVN_DELTA_WINDOW_SIZE bytes. */
+  char *buf;
+  apr_size_t target_len;
+
+  apr_pool_t *pool;
+};
+
+/* Send the delta window for the first WINDOW_LEN bytes of target data
+   buffered in TB to its handler and remove them from the buffer.  Use
+   SCRATCH_POOL for temporaries. */
+static svn_error_t *
+send_cdc_window(struct cdc_push_baton *tb,
+                apr_size_t window_len,
+                apr_pool_t *scratch_pool)
+{
+  svn_txdelta_window_t *window;
+
+  SVN_ERR(compute_cdc_window(&window, tb->cdc, tb->buf, window_len,
+                             scratch_pool));
+  SVN_ERR(tb->wh(window, tb->whb));
+
+  tb->target_len -= window_len;
+  memmove(tb->buf, tb->buf + window_len, tb->target_len);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_write_fn_t.  Buffer target data and send delta windows
+   whenever the buffer is full. */
+static svn_error_t *
+cdc_push_write_handler(void *baton,
+                       const char *data,
+                       apr_size_t *len)
+{
+  struct cdc_push_baton *tb = baton;
+  apr_size_t data_len = *len;
+  apr_pool_t *iterpool = svn_pool_create(tb->pool);
+
+  while (data_len > 0)
+    {
+      apr_size_t chunk_len = SVN_DELTA_WINDOW_SIZE - tb->target_len;
+      if (chunk_len > data_len)
+        chunk_len = data_len;
+
+      memcpy(tb->buf + tb->target_len, data, chunk_len);
+      data += chunk_len;
+      data_len -= chunk_len;
+      tb->target_len += chunk_len;
+
+      if (tb->target_len == SVN_DELTA_WINDOW_SIZE)
+        {
+          svn_pool_clear(iterpool);
+          SVN_ERR(send_cdc_window(tb, cdc_window_length(tb->buf,
+                                                        tb->target_len),
+                                  iterpool));
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_close_fn_t.  Send the windows for the remaining target
+   data, followed by the final NULL window. */
+static svn_error_t *
+cdc_push_close_handler(void *baton)
+{
+  struct cdc_push_baton *tb = baton;
+  apr_pool_t *iterpool = svn_pool_create(tb->pool);
+
+  while (tb->target_len > 0)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(send_cdc_window(tb, cdc_window_length(tb->buf,
+                                                    tb->target_len),
+                              iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  return tb->wh(NULL, tb->whb);
+}
+
+svn_stream_t *
+svn_txdelta__target_push_cdc(svn_txdelta_window_handler_t handler,
+                             void *handler_baton,
+                             svn_stream_t *source,
+                             apr_pool_t *pool)
+{
+  struct cdc_push_baton *tb = apr_pcalloc(pool, sizeof(*tb));
+  svn_stream_t *stream;
+
+  tb->wh = handler;
+  tb->whb = handler_baton;
+  tb->cdc = create_cdc_source(source, pool);
+  tb->buf = apr_palloc(pool, SVN_DELTA_WINDOW_SIZE);
+  tb->pool = pool;
+
+  stream = svn_stream_create(tb, pool);
+  svn_stream_set_write(stream, cdc_push_write_handler);
+  svn_stream_set_close(stream, cdc_push_close_handler);
+  return stream;
+}
+
+
 
 /* Functions for applying deltas.  */
 
@@ -622,33 +1486,66 @@ size_buffer(char **buf, apr_size_t *buf_size,
   return SVN_NO_ERROR;
 }
 
+/* Copy LEN bytes from SOURCE to TARGET, optimizing for the case where
+ * LEN is often very small.  Return a pointer to the first byte after the
+ * copied target range.  The ranges must not overlap.  */
+static APR_INLINE char *
+fast_memcpy(char *target, const char *source, apr_size_t len)
+{
+  if (len > 7)
+    {
+      memcpy(target, source, len);
+      target += len;
+    }
+  else
+    {
+      /* memcpy is not exactly fast for small block sizes.
+       * Since they are common, let's run optimized code for them. */
+      const char *end = source + len;
+      for (; source != end; source++)
+        *(target++) = *source;
+    }
+
+  return target;
+}
+
 /* Copy LEN bytes from SOURCE to TARGET.  Unlike memmove() or memcpy(),
  * create repeating patterns if the source and target ranges overlap.
  * Return a pointer to the first byte after the copied target range.  */
 static APR_INLINE char *
 patterning_copy(char *target, const char *source, apr_size_t len)
 {
+  apr_size_t overlap = target - source;
+
+  /* Non-overlapping copies are by far the most common case. */
+  if (len <= overlap)
+    return fast_memcpy(target, source, len);
+
+  /* Runs of a single byte. */
+  if (overlap == 1)
+    {
+      memset(target, *source, len);
+      return target + len;
+    }
+
   /* If the source and target overlap, repeat the overlapping pattern
-     in the target buffer. Always copy from the source buffer because
+     in the target buffer.  Everything between SOURCE and TARGET is a
+     multiple of the pattern, so each step may copy all of it, doubling
+     the chunk size every time.  Short periods thus take only a few
+     memcpy() calls.  Always copy from the source buffer because
      presumably it will be in the L1 cache after the first iteration
      and doing this should avoid pipeline stalls due to write/read
      dependencies. */
-  const apr_size_t overlap = target - source;
   while (len > overlap)
     {
       memcpy(target, source, overlap);
       target += overlap;
       len -= overlap;
+      overlap = target - source;
     }
 
   /* Copy any remaining source pattern. */
-  if (len)
-    {
-      memcpy(target, source, len);
-      target += len;
-    }
-
-  return target;
+  return fast_memcpy(target, source, len);
 }
 
 void
@@ -678,7 +1575,7 @@ svn_txdelta_apply_instructions(svn_txdelta_window_t *window,
           /* Copy from source area.  */
           assert(sbuf);
           assert(op->offset + op->length <= window->sview_len);
-          memcpy(tbuf + tpos, sbuf + op->offset, buf_len);
+          fast_memcpy(tbuf + tpos, sbuf + op->offset, buf_len);
           break;
 
         case svn_txdelta_target:
@@ -695,9 +1592,9 @@ svn_txdelta_apply_instructions(svn_txdelta_window_t *window,
         case svn_txdelta_new:
           /* Copy from window new area.  */
           assert(op->offset + op->length <= window->new_data->len);
-          memcpy(tbuf + tpos,
-                 window->new_data->data + op->offset,
-                 buf_len);
+          fast_memcpy(tbuf + tpos,
+                      window->new_data->data + op->offset,
+                      buf_len);
           break;
 
         default:
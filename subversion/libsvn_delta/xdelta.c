@@ -31,6 +31,14 @@
 #include "svn_delta.h"
 #include "private/svn_string_private.h"
 #include "delta.h"
+
+/* SSE2 is part of the x86-64 base ISA, so no runtime CPU detection is
+ * needed for the vectorized checksum code.
+ */
+#if defined(__GNUC__) && defined(__SSE2__)
+#  define XDELTA_SSE2 1
+#  include <emmintrin.h>
+#endif
 
 /* This is pseudo-adler32. It is adler32 without the prime modulus.
    The idea is borrowed from monotone, and is a translation of the C++
@@ -82,6 +90,42 @@ adler32_replace(apr_uint32_t adler32, const char c_out, const char c_in)
 static APR_INLINE apr_uint32_t
 init_adler32(const char *data)
 {
+#ifdef XDELTA_SSE2
+
+  /* S1 is the plain sum of all bytes and S2 weighs byte K with
+   * MATCH_BLOCKSIZE - K.  Process 16 bytes per step. */
+  const __m128i zero = _mm_setzero_si128();
+  __m128i weights_lo = _mm_set_epi16(57, 58, 59, 60, 61, 62, 63, 64);
+  __m128i weights_hi = _mm_set_epi16(49, 50, 51, 52, 53, 54, 55, 56);
+  const __m128i step = _mm_set1_epi16(16);
+  __m128i s1 = zero;
+  __m128i s2 = zero;
+  int i;
+
+  for (i = 0; i < MATCH_BLOCKSIZE; i += 16)
+    {
+      __m128i chunk = _mm_loadu_si128((const __m128i *)(data + i));
+      s1 = _mm_add_epi64(s1, _mm_sad_epu8(chunk, zero));
+      s2 = _mm_add_epi32(s2,
+                         _mm_madd_epi16(_mm_unpacklo_epi8(chunk, zero),
+                                        weights_lo));
+      s2 = _mm_add_epi32(s2,
+                         _mm_madd_epi16(_mm_unpackhi_epi8(chunk, zero),
+                                        weights_hi));
+      weights_lo = _mm_sub_epi16(weights_lo, step);
+      weights_hi = _mm_sub_epi16(weights_hi, step);
+    }
+
+  /* horizontal sums */
+  s1 = _mm_add_epi64(s1, _mm_srli_si128(s1, 8));
+  s2 = _mm_add_epi32(s2, _mm_srli_si128(s2, 8));
+  s2 = _mm_add_epi32(s2, _mm_srli_si128(s2, 4));
+
+  return (apr_uint32_t)_mm_cvtsi128_si32(s2) * 0x10000
+       + (apr_uint32_t)_mm_cvtsi128_si32(s1);
+
+#else
+
   const unsigned char *input = (const unsigned char *)data;
   const unsigned char *last = input + MATCH_BLOCKSIZE;
 
@@ -101,8 +145,55 @@ init_adler32(const char *data)
     }
 
   return s2 * 0x10000 + s1;
+
+#endif
 }
 
+#ifdef XDELTA_SSE2
+
+/* Roll the checksum ADLER32 of the block at DATA forward by 8 positions
+ * at once.  Store the checksums for the blocks at DATA + 1 to DATA + 8 in
+ * SUMS.  DATA must be followed by at least MATCH_BLOCKSIZE + 8 bytes.
+ *
+ * The result is the same as 8 consecutive calls to adler32_replace:
+ * Per position, S1 changes by the difference D between the incoming and
+ * outgoing byte and S2 by the new S1 minus MATCH_BLOCKSIZE times the
+ * outgoing byte.  Both are prefix sums over the 8 positions, which we
+ * calculate in 16 bit lanes.  That is sufficient because S1 never
+ * exceeds 16 bits and S2 is only used modulo 0x10000.
+ */
+static APR_INLINE void
+adler32_replace_8(apr_uint32_t sums[8],
+                  apr_uint32_t adler32,
+                  const char *data)
+{
+  const __m128i zero = _mm_setzero_si128();
+  __m128i c_out = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)data),
+                                    zero);
+  __m128i c_in = _mm_unpacklo_epi8(
+                   _mm_loadl_epi64((const __m128i *)(data + MATCH_BLOCKSIZE)),
+                   zero);
+
+  __m128i s1 = _mm_sub_epi16(c_in, c_out);
+  __m128i s2;
+
+  s1 = _mm_add_epi16(s1, _mm_slli_si128(s1, 2));
+  s1 = _mm_add_epi16(s1, _mm_slli_si128(s1, 4));
+  s1 = _mm_add_epi16(s1, _mm_slli_si128(s1, 8));
+  s1 = _mm_add_epi16(s1, _mm_set1_epi16((short)(adler32 & 0xffff)));
+
+  s2 = _mm_sub_epi16(s1, _mm_slli_epi16(c_out, 6));
+  s2 = _mm_add_epi16(s2, _mm_slli_si128(s2, 2));
+  s2 = _mm_add_epi16(s2, _mm_slli_si128(s2, 4));
+  s2 = _mm_add_epi16(s2, _mm_slli_si128(s2, 8));
+  s2 = _mm_add_epi16(s2, _mm_set1_epi16((short)(adler32 >> 16)));
+
+  _mm_storeu_si128((__m128i *)sums, _mm_unpacklo_epi16(s1, s2));
+  _mm_storeu_si128((__m128i *)(sums + 4), _mm_unpackhi_epi16(s1, s2));
+}
+
+#endif
+
 /* Information for a block of the delta source.  The length of the
    block is the smaller of MATCH_BLOCKSIZE and the difference between
    the size of the source data and the position of this block. */
@@ -296,11 +387,16 @@ find_match(const struct blocks *blocks,
 
   /* See if we can extend backwards (max MATCH_BLOCKSIZE-1 steps because A's
      content has been sampled only every MATCH_BLOCKSIZE positions).  */
-  while (apos > 0 && bpos > pending_insert_start && a[apos-1] == b[bpos-1])
+  max_delta = apos < bpos - pending_insert_start
+            ? apos
+            : bpos - pending_insert_start;
+  if (max_delta)
     {
-      --apos;
-      --bpos;
-      ++delta;
+      apr_size_t len = svn_cstring__reverse_match_length(a + apos, b + bpos,
+                                                         max_delta);
+      apos -= len;
+      bpos -= len;
+      delta += len;
     }
 
   *aposp = apos;
@@ -414,6 +510,25 @@ compute_delta(svn_txdelta__ops_baton_t *build_baton,
 
       /* Quickly skip positions whose respective ROLLING checksums
          definitely do not match any SLOT in BLOCKS. */
+#ifdef XDELTA_SSE2
+      /* Calculate the next 8 checksums in one go.  That breaks up the
+         dependency chain of the scalar loop below, which we then only use
+         for the last few positions. */
+      while (!(blocks.flags[hash_flags(rolling)] & (1 << (rolling & 7)))
+             && lo + 8 <= upper)
+        {
+          apr_uint32_t sums[8];
+          int i;
+
+          adler32_replace_8(sums, rolling, b + lo);
+          for (i = 0; i < 7; ++i)
+            if (blocks.flags[hash_flags(sums[i])] & (1 << (sums[i] & 7)))
+              break;
+
+          rolling = sums[i];
+          lo += i + 1;
+        }
+#endif
       while (!(blocks.flags[hash_flags(rolling)] & (1 << (rolling & 7)))
              && lo < upper)
         {
@@ -126,9 +126,10 @@ svn_diff__diff(svn_diff__lcs_t *lcs,
 
 
 svn_error_t *
-svn_diff_diff_2(svn_diff_t **diff,
+svn_diff__diff2(svn_diff_t **diff,
                 void *diff_baton,
                 const svn_diff_fns2_t *vtable,
+                svn_diff_algorithm_t algorithm,
                 apr_pool_t *pool)
 {
   svn_diff__tree_t *tree;
@@ -185,9 +186,10 @@ svn_diff_diff_2(svn_diff_t **diff,
                                                subpool);
 
   /* Get the lcs */
-  lcs = svn_diff__lcs(position_list[0], position_list[1], token_counts[0],
-                      token_counts[1], num_tokens, prefix_lines,
-                      suffix_lines, subpool);
+  lcs = svn_diff__find_lcs(algorithm,
+                           position_list[0], position_list[1],
+                           token_counts[0], token_counts[1], num_tokens,
+                           prefix_lines, suffix_lines, subpool);
 
   /* Produce the diff */
   *diff = svn_diff__diff(lcs, 1, 1, TRUE, pool);
@@ -197,3 +199,13 @@ svn_diff_diff_2(svn_diff_t **diff,
 
   return SVN_NO_ERROR;
 }
+
+svn_error_t *
+svn_diff_diff_2(svn_diff_t **diff,
+                void *diff_baton,
+                const svn_diff_fns2_t *vtable,
+                apr_pool_t *pool)
+{
+  return svn_error_trace(svn_diff__diff2(diff, diff_baton, vtable,
+                                         svn_diff_algorithm_lcs, pool));
+}
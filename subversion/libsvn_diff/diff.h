@@ -115,6 +115,41 @@ svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
               apr_pool_t *pool);
 
 
+/*
+ * Like svn_diff__lcs(), but find a common subsequence that need not be
+ * the longest one using the histogram algorithm: Anchor on the least
+ * frequent tokens that occur in both lists and recurse into the sequences
+ * between the anchors.  All tokens in the result are still matched in
+ * order, so the result can be used exactly like that of svn_diff__lcs().
+ *
+ * The runtime is bounded by a small multiple of the number of tokens.
+ */
+svn_diff__lcs_t *
+svn_diff__histogram(svn_diff__position_t *position_list1, /* tail (ring) */
+                    svn_diff__position_t *position_list2, /* tail (ring) */
+                    svn_diff__token_index_t *token_counts_list1,
+                    svn_diff__token_index_t *token_counts_list2,
+                    svn_diff__token_index_t num_tokens,
+                    apr_off_t prefix_lines,
+                    apr_off_t suffix_lines,
+                    apr_pool_t *pool);
+
+/*
+ * Call svn_diff__lcs() or svn_diff__histogram(), depending on ALGORITHM,
+ * with the remaining arguments.
+ */
+svn_diff__lcs_t *
+svn_diff__find_lcs(svn_diff_algorithm_t algorithm,
+                   svn_diff__position_t *position_list1,
+                   svn_diff__position_t *position_list2,
+                   svn_diff__token_index_t *token_counts_list1,
+                   svn_diff__token_index_t *token_counts_list2,
+                   svn_diff__token_index_t num_tokens,
+                   apr_off_t prefix_lines,
+                   apr_off_t suffix_lines,
+                   apr_pool_t *pool);
+
+
 /*
  * Returns number of tokens in a tree
  */
@@ -158,6 +193,29 @@ svn_diff__diff(svn_diff__lcs_t *lcs,
                svn_boolean_t want_common,
                apr_pool_t *pool);
 
+/* The implementations of svn_diff_diff_2(), svn_diff_diff3_2() and
+ * svn_diff_diff4_2(), comparing the datasources using ALGORITHM. */
+svn_error_t *
+svn_diff__diff2(svn_diff_t **diff,
+                void *diff_baton,
+                const svn_diff_fns2_t *vtable,
+                svn_diff_algorithm_t algorithm,
+                apr_pool_t *pool);
+
+svn_error_t *
+svn_diff__diff3(svn_diff_t **diff,
+                void *diff_baton,
+                const svn_diff_fns2_t *vtable,
+                svn_diff_algorithm_t algorithm,
+                apr_pool_t *pool);
+
+svn_error_t *
+svn_diff__diff4(svn_diff_t **diff,
+                void *diff_baton,
+                const svn_diff_fns2_t *vtable,
+                svn_diff_algorithm_t algorithm,
+                apr_pool_t *pool);
+
 void
 svn_diff__resolve_conflict(svn_diff_t *hunk,
                            svn_diff__position_t **position_list1,
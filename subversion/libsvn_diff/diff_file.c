@@ -32,6 +32,11 @@
 #include <apr_getopt.h>
 
 #include <assert.h>
+#include <string.h>
+
+#if APR_HAS_THREADS
+#include <apr_thread_proc.h>
+#endif
 
 #include "svn_error.h"
 #include "svn_diff.h"
@@ -66,6 +71,9 @@ typedef struct svn_diff__file_token_t
   apr_off_t raw_length;
   /* Total length - after normalization. */
   apr_off_t length;
+  /* The normalized token in memory, if the datasource has been tokenized
+     in advance (see pretokenize_datasources()).  NULL otherwise. */
+  const char *data;
 } svn_diff__file_token_t;
 
 
@@ -91,6 +99,14 @@ typedef struct svn_diff__file_baton_t
     /* Where the identical suffix starts in this datasource */
     int suffix_start_chunk;
     apr_off_t suffix_offset_in_chunk;
+
+    /* If not NULL, all tokens between the identical prefix and suffix,
+     * read in advance, and their hashes.  NEXT_PRETOKEN is the index
+     * of the token to return next. */
+    svn_diff__file_token_t *pretokens;
+    apr_uint32_t *pretoken_hashes;
+    apr_size_t pretoken_count;
+    apr_size_t next_pretoken;
   } files[4];
 
   /* List of free tokens that may be reused. */
@@ -752,6 +768,290 @@ find_identical_suffix(apr_off_t *suffix_lines, struct file_info file[],
 }
 
 
+/* Default for the maximum number of datasources that get tokenized
+   concurrently. */
+#define DEFAULT_TOKENIZE_THREADS 4
+
+/* Maximum number of datasources tokenized concurrently, see
+   svn_diff__set_tokenize_threads().  Values below 2 disable the
+   concurrent tokenization. */
+static int tokenize_threads = DEFAULT_TOKENIZE_THREADS;
+
+void
+svn_diff__set_tokenize_threads(int threads)
+{
+  tokenize_threads = threads > 0 ? threads : 0;
+}
+
+#if APR_HAS_THREADS
+
+/* Only tokenize the datasources in advance if the data between their
+ * identical prefix and suffix adds up to at least this many bytes.  Below
+ * that, starting the threads costs more than it saves. */
+#define PRETOKENIZE_MIN_SIZE (1024 * 1024)
+
+/* ... and if none of the datasources has more than this many bytes in
+ * that range, because all of it will be kept in memory. */
+#define PRETOKENIZE_MAX_SIZE (128 * 1024 * 1024)
+
+/* Everything needed to read and tokenize one datasource.  Each job has
+ * its own root POOL so that it can run in a separate thread. */
+typedef struct tokenize_job_t
+{
+  /* The datasource to tokenize. */
+  struct file_info *file;
+  svn_diff_datasource_e datasource;
+  const svn_diff_file_options_t *options;
+
+  /* The range of the datasource to tokenize, in bytes. */
+  apr_off_t start;
+  apr_off_t end;
+
+  /* The tokens found and their hashes. */
+  svn_diff__file_token_t *tokens;
+  apr_uint32_t *hashes;
+  apr_size_t count;
+
+  /* The error that occurred while tokenizing, if any. */
+  svn_error_t *err;
+
+  apr_pool_t *pool;
+} tokenize_job_t;
+
+/* Split the range of JOB's datasource into tokens.  Read the entire range
+ * into memory and normalize it in place, in the same way as
+ * datasource_get_next_token() would, so that the tokens can be compared
+ * with memcmp() later on.  Allocate everything in JOB->POOL.
+ *
+ * This only touches JOB and may therefore run in any thread. */
+static svn_error_t *
+tokenize_range(tokenize_job_t *job)
+{
+  apr_file_t *file;
+  apr_size_t length = (apr_size_t)(job->end - job->start);
+  apr_size_t capacity = length / 32 + 16;
+  svn_diff__normalize_state_t state = svn_diff__normalize_state_normal;
+  char *data;
+  char *curp;
+  char *endp;
+
+  data = apr_palloc(job->pool, length + 1);
+  SVN_ERR(svn_io_file_open(&file, job->file->path, APR_READ, APR_OS_DEFAULT,
+                           job->pool));
+  SVN_ERR(read_chunk(file, data, length, job->start, job->pool));
+  SVN_ERR(svn_io_file_close(file, job->pool));
+
+  job->tokens = apr_palloc(job->pool, capacity * sizeof(*job->tokens));
+  job->hashes = apr_palloc(job->pool, capacity * sizeof(*job->hashes));
+  job->count = 0;
+
+  curp = data;
+  endp = data + length;
+  while (curp < endp)
+    {
+      svn_diff__file_token_t *token;
+      char *eol = svn_eol__find_eol_start(curp, endp - curp);
+      char *c = curp;
+      apr_off_t len;
+
+      if (eol)
+        {
+          /* Also skip past the '\n' in an '\r\n' sequence. */
+          if (*eol == '\r' && eol + 1 < endp && eol[1] == '\n')
+            eol++;
+          eol++;
+        }
+      else
+        eol = endp;
+
+      if (job->count == capacity)
+        {
+          svn_diff__file_token_t *tokens;
+          apr_uint32_t *hashes;
+
+          capacity *= 2;
+          tokens = apr_palloc(job->pool, capacity * sizeof(*tokens));
+          hashes = apr_palloc(job->pool, capacity * sizeof(*hashes));
+          memcpy(tokens, job->tokens, job->count * sizeof(*tokens));
+          memcpy(hashes, job->hashes, job->count * sizeof(*hashes));
+          job->tokens = tokens;
+          job->hashes = hashes;
+        }
+
+      token = &job->tokens[job->count];
+      token->next = NULL;
+      token->datasource = job->datasource;
+      token->offset = job->start + (curp - data);
+      token->raw_length = eol - curp;
+
+      len = token->raw_length;
+      svn_diff__normalize_buffer(&c, &len, &state, curp, job->options);
+      token->norm_offset = token->offset + (c - curp);
+      token->length = len;
+      token->data = c;
+
+      job->hashes[job->count] = svn__adler32(0, c, len);
+      job->count++;
+      curp = eol;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread function running tokenize_range() for the tokenize_job_t DATA. */
+static void * APR_THREAD_FUNC
+tokenize_thread(apr_thread_t *thread, void *data)
+{
+  tokenize_job_t *job = data;
+
+  job->err = tokenize_range(job);
+  apr_thread_exit(thread, APR_SUCCESS);
+
+  return NULL;
+}
+
+/* Pool cleanup handler destroying the pool of the tokenize_job_t DATA
+ * and with it, the datasource's tokens. */
+static apr_status_t
+cleanup_tokenize_job(void *data)
+{
+  tokenize_job_t *job = data;
+
+  job->file->pretokens = NULL;
+  job->file->pretoken_hashes = NULL;
+  job->file->pretoken_count = 0;
+  svn_pool_destroy(job->pool);
+
+  return APR_SUCCESS;
+}
+
+/* Return the offset in FILE where the identical prefix ends, given that
+ * find_identical_prefix() left FILE->CURP there. */
+static apr_off_t
+prefix_end(const struct file_info *file)
+{
+  return chunk_to_offset((apr_off_t)file->chunk) + (file->curp - file->buffer);
+}
+
+/* Return the offset in FILE where the identical suffix starts. */
+static apr_off_t
+suffix_start(const struct file_info *file)
+{
+  if (file->suffix_start_chunk < 0)
+    return file->size;
+
+  return chunk_to_offset((apr_off_t)file->suffix_start_chunk)
+         + file->suffix_offset_in_chunk;
+}
+
+/* If there is enough data in the DATASOURCES_LEN datasources DATASOURCES
+ * of FILE_BATON between their identical prefix and suffix, read and
+ * tokenize all of them in advance, using up to TOKENIZE_THREADS threads.
+ * datasource_get_next_token() will then simply return the stored tokens.
+ *
+ * Inserting the tokens into the token tree stays serial because the tree
+ * is shared between all datasources.  Only reading, line splitting,
+ * normalization and hashing run concurrently.
+ *
+ * Do nothing if the concurrent tokenization is disabled. */
+static svn_error_t *
+pretokenize_datasources(svn_diff__file_baton_t *file_baton,
+                        const svn_diff_datasource_e *datasources,
+                        apr_size_t datasources_len)
+{
+  tokenize_job_t *jobs[4];
+  apr_thread_t *threads[4] = { NULL };
+  apr_off_t total = 0;
+  svn_error_t *err = SVN_NO_ERROR;
+  apr_size_t i;
+
+  if (tokenize_threads < 2 || datasources_len < 2)
+    return SVN_NO_ERROR;
+
+  for (i = 0; i < datasources_len; i++)
+    {
+      struct file_info *file
+        = &file_baton->files[datasource_to_index(datasources[i])];
+      apr_off_t size = suffix_start(file) - prefix_end(file);
+
+      if (size > PRETOKENIZE_MAX_SIZE)
+        return SVN_NO_ERROR;
+
+      total += size;
+    }
+
+  if (total < PRETOKENIZE_MIN_SIZE)
+    return SVN_NO_ERROR;
+
+  for (i = 0; i < datasources_len; i++)
+    {
+      tokenize_job_t *job;
+      apr_pool_t *pool
+        = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+
+      job = apr_pcalloc(pool, sizeof(*job));
+      job->file = &file_baton->files[datasource_to_index(datasources[i])];
+      job->datasource = datasources[i];
+      job->options = file_baton->options;
+      job->start = prefix_end(job->file);
+      job->end = suffix_start(job->file);
+      job->pool = pool;
+      apr_pool_cleanup_register(file_baton->pool, job, cleanup_tokenize_job,
+                                apr_pool_cleanup_null);
+
+      jobs[i] = job;
+    }
+
+  /* Hand all but the first datasource to separate threads and tokenize
+   * those that don't get one ourselves. */
+  for (i = 1; i < datasources_len; i++)
+    {
+      apr_status_t status = APR_EGENERAL;
+
+      if (i < (apr_size_t)tokenize_threads)
+        status = apr_thread_create(&threads[i], NULL, tokenize_thread,
+                                   jobs[i], jobs[i]->pool);
+
+      if (status)
+        {
+          threads[i] = NULL;
+          jobs[i]->err = tokenize_range(jobs[i]);
+        }
+    }
+
+  jobs[0]->err = tokenize_range(jobs[0]);
+
+  for (i = 1; i < datasources_len; i++)
+    if (threads[i])
+      {
+        apr_status_t retval;
+        apr_status_t status = apr_thread_join(&retval, threads[i]);
+
+        if (status)
+          err = svn_error_compose_create(
+                  err, svn_error_wrap_apr(status,
+                                          _("Can't join tokenizer thread")));
+      }
+
+  for (i = 0; i < datasources_len; i++)
+    err = svn_error_compose_create(err, jobs[i]->err);
+
+  SVN_ERR(err);
+
+  for (i = 0; i < datasources_len; i++)
+    {
+      jobs[i]->file->pretokens = jobs[i]->tokens;
+      jobs[i]->file->pretoken_hashes = jobs[i]->hashes;
+      jobs[i]->file->pretoken_count = jobs[i]->count;
+      jobs[i]->file->next_pretoken = 0;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+#endif /* APR_HAS_THREADS */
+
+
 /* Let FILE stand for the array of file_info struct elements of BATON->files
  * that are indexed by the elements of the DATASOURCE array.
  * BATON's type is (svn_diff__file_baton_t *).
@@ -835,6 +1135,10 @@ datasources_open(void *baton,
   for (i = 0; i < datasources_len; i++)
     file_baton->files[datasource_to_index(datasources[i])] = files[i];
 
+#if APR_HAS_THREADS
+  SVN_ERR(pretokenize_datasources(file_baton, datasources, datasources_len));
+#endif
+
   return SVN_NO_ERROR;
 }
 
@@ -869,6 +1173,18 @@ datasource_get_next_token(apr_uint32_t *hash, void **token, void *baton,
 
   *token = NULL;
 
+  /* Serve tokens read in advance from the array. */
+  if (file->pretokens)
+    {
+      if (file->next_pretoken < file->pretoken_count)
+        {
+          *hash = file->pretoken_hashes[file->next_pretoken];
+          *token = &file->pretokens[file->next_pretoken++];
+        }
+
+      return SVN_NO_ERROR;
+    }
+
   curp = file->curp;
   endp = file->endp;
 
@@ -911,6 +1227,7 @@ datasource_get_next_token(apr_uint32_t *hash, void **token, void *baton,
   file_token->norm_offset = file_token->offset;
   file_token->raw_length = 0;
   file_token->length = 0;
+  file_token->data = NULL;
 
   while (1)
     {
@@ -1054,6 +1371,14 @@ token_compare(void *baton, void *token1, void *token2, int *compare)
       return SVN_NO_ERROR;
     }
 
+  /* Tokens read in advance are already normalized in memory. */
+  if (file_token[0]->data && file_token[1]->data)
+    {
+      *compare = memcmp(file_token[0]->data, file_token[1]->data,
+                        (size_t) total_length);
+      return SVN_NO_ERROR;
+    }
+
   for (i = 0; i < 2; ++i)
     {
       int idx = datasource_to_index(file_token[i]->datasource);
@@ -1152,6 +1477,10 @@ token_discard(void *baton, void *token)
   svn_diff__file_baton_t *file_baton = baton;
   svn_diff__file_token_t *file_token = token;
 
+  /* Tokens read in advance live in their datasource's array. */
+  if (file_token->data)
+    return;
+
   /* Prepend FILE_TOKEN to FILE_BATON->TOKENS, for reuse. */
   file_token->next = file_baton->tokens;
   file_baton->tokens = file_token;
@@ -1181,6 +1510,7 @@ static const svn_diff_fns2_t svn_diff__file_vtable =
 
 /* Id for the --ignore-eol-style option, which doesn't have a short name. */
 #define SVN_DIFF__OPT_IGNORE_EOL_STYLE 256
+#define SVN_DIFF__OPT_HISTOGRAM 257
 
 /* Options supported by svn_diff_file_options_parse(). */
 static const apr_getopt_option_t diff_options[] =
@@ -1193,6 +1523,7 @@ static const apr_getopt_option_t diff_options[] =
    * ### we don't have optional argument support. */
   { "unified", 'u', 0, NULL },
   { "context", 'U', 1, NULL },
+  { "histogram", SVN_DIFF__OPT_HISTOGRAM, 0, NULL },
   { NULL, 0, 0, NULL }
 };
 
@@ -1298,6 +1629,9 @@ svn_diff_file_options_parse(svn_diff_file_options_t *options,
         case 'U':
           SVN_ERR(svn_cstring_atoi(&options->context_size, opt_arg));
           break;
+        case SVN_DIFF__OPT_HISTOGRAM:
+          options->algorithm = svn_diff_algorithm_histogram;
+          break;
         default:
           break;
         }
@@ -1326,7 +1660,8 @@ svn_diff_file_diff_2(svn_diff_t **diff,
   baton.files[1].path = modified;
   baton.pool = svn_pool_create(pool);
 
-  SVN_ERR(svn_diff_diff_2(diff, &baton, &svn_diff__file_vtable, pool));
+  SVN_ERR(svn_diff__diff2(diff, &baton, &svn_diff__file_vtable,
+                          options->algorithm, pool));
 
   svn_pool_destroy(baton.pool);
   return SVN_NO_ERROR;
@@ -1348,7 +1683,8 @@ svn_diff_file_diff3_2(svn_diff_t **diff,
   baton.files[2].path = latest;
   baton.pool = svn_pool_create(pool);
 
-  SVN_ERR(svn_diff_diff3_2(diff, &baton, &svn_diff__file_vtable, pool));
+  SVN_ERR(svn_diff__diff3(diff, &baton, &svn_diff__file_vtable,
+                          options->algorithm, pool));
 
   svn_pool_destroy(baton.pool);
   return SVN_NO_ERROR;
@@ -1372,7 +1708,8 @@ svn_diff_file_diff4_2(svn_diff_t **diff,
   baton.files[3].path = ancestor;
   baton.pool = svn_pool_create(pool);
 
-  SVN_ERR(svn_diff_diff4_2(diff, &baton, &svn_diff__file_vtable, pool));
+  SVN_ERR(svn_diff__diff4(diff, &baton, &svn_diff__file_vtable,
+                          options->algorithm, pool));
 
   svn_pool_destroy(baton.pool);
   return SVN_NO_ERROR;
@@ -293,7 +293,8 @@ svn_diff_mem_string_diff(svn_diff_t **diff,
 
   baton.normalization_options = options;
 
-  return svn_diff_diff_2(diff, &baton, &svn_diff__mem_vtable, pool);
+  return svn_diff__diff2(diff, &baton, &svn_diff__mem_vtable,
+                         options->algorithm, pool);
 }
 
 svn_error_t *
@@ -313,7 +314,8 @@ svn_diff_mem_string_diff3(svn_diff_t **diff,
 
   baton.normalization_options = options;
 
-  return svn_diff_diff3_2(diff, &baton, &svn_diff__mem_vtable, pool);
+  return svn_diff__diff3(diff, &baton, &svn_diff__mem_vtable,
+                         options->algorithm, pool);
 }
 
 
@@ -336,7 +338,8 @@ svn_diff_mem_string_diff4(svn_diff_t **diff,
 
   baton.normalization_options = options;
 
-  return svn_diff_diff4_2(diff, &baton, &svn_diff__mem_vtable, pool);
+  return svn_diff__diff4(diff, &baton, &svn_diff__mem_vtable,
+                         options->algorithm, pool);
 }
 
 
@@ -0,0 +1,533 @@
+/*
+ * histogram.c :  routines for creating a histogram-based lcs
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+#include <apr.h>
+#include <apr_pools.h>
+#include <apr_general.h>
+
+#include "svn_pools.h"
+#include "svn_sorts.h"
+
+#include "diff.h"
+
+
+/*
+ * Calculate a common subsequence of two datasources using the histogram
+ * algorithm, as known from JGit and Git.
+ *
+ * For a section of both token lists, count how often each token occurs
+ * in the section of the first list.  Then find the longest run of
+ * matching tokens that contains a token with the lowest such count.
+ * That run splits the section into the parts before and after it,
+ * which get processed the same way.  Lines that are rare in the file,
+ * like function headers or distinct statements, thus become anchors,
+ * while frequent lines like blank lines and closing braces only get
+ * matched between anchors.  Unlike the LCS algorithm, this does not
+ * degrade with the number of differences.
+ *
+ * Tokens that occur more than MAX_CHAIN_LENGTH times in a section are
+ * never used as anchors.  If a section contains nothing else that both
+ * sides have in common, it is handed to the LCS algorithm if it is
+ * small enough, or reported as changed otherwise.  Together with a limit
+ * on the total work spent on searching anchors, this bounds the runtime
+ * by a constant multiple of the number of tokens.
+ */
+
+/* Tokens occurring more often than this in a section are not anchors. */
+#define MAX_CHAIN_LENGTH 64
+
+/* Sections without anchors are only compared using the LCS algorithm if
+ * they contain at most this many tokens on both sides combined. */
+#define MAX_LCS_TOKENS 2048
+
+/* Budget of anchor search steps per input token. */
+#define WORK_PER_TOKEN 256
+
+/* A section of both token lists, identified by the [START, END) ranges of
+ * token numbers in each list.  If IS_MATCH is set, the ranges are of equal
+ * length and all their tokens match. */
+typedef struct section_t
+{
+  svn_diff__token_index_t start[2];
+  svn_diff__token_index_t end[2];
+  svn_boolean_t is_match;
+} section_t;
+
+/* Working data of the histogram algorithm. */
+typedef struct histogram_t
+{
+  /* The token indexes and positions of the tokens in both lists. */
+  svn_diff__token_index_t *tokens[2];
+  svn_diff__position_t **positions[2];
+
+  /* Per token index: GENERATION value when COUNT and FIRST were last set,
+   * number of occurrences in the current section of the first list and the
+   * number of the first of them. */
+  apr_uint32_t *stamp;
+  svn_diff__token_index_t *count;
+  svn_diff__token_index_t *first;
+  apr_uint32_t generation;
+
+  /* Per token in the first list: The number of the next token with the
+   * same index in the current section or -1. */
+  svn_diff__token_index_t *next;
+
+  /* Anchor search steps we may still spend. */
+  apr_int64_t work_left;
+
+  /* The matches found so far, as section_t in increasing order. */
+  apr_array_header_t *matches;
+
+  /* For temporary data of LCS runs on sections. */
+  apr_pool_t *scratch_pool;
+} histogram_t;
+
+
+/* Append the run of LENGTH matching tokens starting at token numbers
+ * START0 and START1 to the matches in H. */
+static void
+add_match(histogram_t *h,
+          svn_diff__token_index_t start0,
+          svn_diff__token_index_t start1,
+          svn_diff__token_index_t length)
+{
+  section_t *match;
+
+  if (h->matches->nelts)
+    {
+      match = &APR_ARRAY_IDX(h->matches, h->matches->nelts - 1, section_t);
+      if (match->end[0] == start0 && match->end[1] == start1)
+        {
+          match->end[0] += length;
+          match->end[1] += length;
+          return;
+        }
+    }
+
+  match = apr_array_push(h->matches);
+  match->start[0] = start0;
+  match->start[1] = start1;
+  match->end[0] = start0 + length;
+  match->end[1] = start1 + length;
+  match->is_match = TRUE;
+}
+
+/* Find the best anchor in SECTION as described at the top of this file and
+ * return it in *ANCHOR.  Return 1 if an anchor was found, 0 if the list
+ * sections have no token in common and -1 if no anchor could be found
+ * for other reasons. */
+static int
+find_anchor(section_t *anchor,
+            histogram_t *h,
+            const section_t *section)
+{
+  const svn_diff__token_index_t *a = h->tokens[0];
+  const svn_diff__token_index_t *b = h->tokens[1];
+  svn_diff__token_index_t best_count = MAX_CHAIN_LENGTH + 1;
+  svn_diff__token_index_t best_length = 0;
+  svn_diff__token_index_t best_distance = 0;
+  svn_diff__token_index_t i, j;
+  svn_boolean_t have_common = FALSE;
+
+  /* Count the tokens in the first list's section and chain them up. */
+  h->generation++;
+  for (i = section->end[0] - 1; i >= section->start[0]; i--)
+    {
+      svn_diff__token_index_t token = a[i];
+
+      if (h->stamp[token] != h->generation)
+        {
+          h->stamp[token] = h->generation;
+          h->count[token] = 0;
+          h->next[i] = -1;
+        }
+      else
+        {
+          h->next[i] = h->first[token];
+        }
+
+      h->first[token] = i;
+      h->count[token]++;
+    }
+
+  h->work_left -= section->end[0] - section->start[0];
+  h->work_left -= section->end[1] - section->start[1];
+
+  /* Try every occurrence of every rare enough token of the second list's
+   * section as a starting point. */
+  for (j = section->start[1]; j < section->end[1] && h->work_left > 0; )
+    {
+      svn_diff__token_index_t token = b[j];
+      svn_diff__token_index_t next_j = j + 1;
+
+      if (h->stamp[token] == h->generation)
+        {
+          have_common = TRUE;
+          if (   h->count[token] <= MAX_CHAIN_LENGTH
+              && h->count[token] <= best_count)
+            for (i = h->first[token]; i >= 0; i = h->next[i])
+              {
+                svn_diff__token_index_t start0 = i, start1 = j;
+                svn_diff__token_index_t end0 = i + 1, end1 = j + 1;
+                svn_diff__token_index_t min_count = h->count[token];
+                svn_diff__token_index_t distance;
+
+                while (   start0 > section->start[0]
+                       && start1 > section->start[1]
+                       && a[start0 - 1] == b[start1 - 1])
+                  {
+                    --start0;
+                    --start1;
+                    min_count = MIN(min_count, h->count[a[start0]]);
+                  }
+
+                while (   end0 < section->end[0]
+                       && end1 < section->end[1]
+                       && a[end0] == b[end1])
+                  {
+                    min_count = MIN(min_count, h->count[a[end0]]);
+                    ++end0;
+                    ++end1;
+                  }
+
+                h->work_left -= end0 - start0 + 1;
+                next_j = MAX(next_j, end1);
+
+                /* Among equally good anchors, prefer the one closest to
+                 * the middle.  That keeps the recursion shallow when there
+                 * are many of them. */
+                distance = 2 * start1 - section->start[1] - section->end[1];
+                if (distance < 0)
+                  distance = -distance;
+
+                if (   end0 - start0 > best_length
+                    || min_count < best_count
+                    || (   end0 - start0 == best_length
+                        && min_count == best_count
+                        && distance < best_distance))
+                  {
+                    anchor->start[0] = start0;
+                    anchor->start[1] = start1;
+                    anchor->end[0] = end0;
+                    anchor->end[1] = end1;
+                    anchor->is_match = TRUE;
+
+                    best_length = end0 - start0;
+                    best_count = min_count;
+                    best_distance = distance;
+                  }
+              }
+        }
+
+      j = next_j;
+    }
+
+  if (best_length > 0)
+    return 1;
+
+  return have_common || h->work_left <= 0 ? -1 : 0;
+}
+
+/* Find the longest common subsequence of the token lists in SECTION using
+ * svn_diff__lcs() and add it to the matches in H. */
+static void
+lcs_section(histogram_t *h,
+            const section_t *section)
+{
+  svn_diff__token_index_t length[2];
+  svn_diff__token_index_t num_tokens = 0;
+  svn_diff__token_index_t *token_counts;
+  svn_diff__position_t *positions[2];
+  svn_diff__lcs_t *lcs;
+  svn_diff__token_index_t i;
+  int list;
+
+  length[0] = section->end[0] - section->start[0];
+  length[1] = section->end[1] - section->start[1];
+
+  /* Renumber the tokens of the section from 0, using FIRST as the map. */
+  h->generation++;
+  for (list = 0; list < 2; list++)
+    for (i = section->start[list]; i < section->end[list]; i++)
+      {
+        svn_diff__token_index_t token = h->tokens[list][i];
+
+        if (h->stamp[token] != h->generation)
+          {
+            h->stamp[token] = h->generation;
+            h->first[token] = num_tokens++;
+          }
+      }
+
+  /* Build the rings of positions that svn_diff__lcs() expects.  Number
+   * them from 1 like svn_diff__get_tokens() does. */
+  token_counts = apr_pcalloc(h->scratch_pool,
+                             2 * num_tokens * sizeof(*token_counts));
+  for (list = 0; list < 2; list++)
+    {
+      positions[list] = apr_palloc(h->scratch_pool,
+                                   length[list] * sizeof(*positions[list]));
+      for (i = 0; i < length[list]; i++)
+        {
+          svn_diff__token_index_t token
+            = h->first[h->tokens[list][section->start[list] + i]];
+
+          positions[list][i].next = &positions[list][(i + 1) % length[list]];
+          positions[list][i].token_index = token;
+          positions[list][i].offset = i + 1;
+          token_counts[list * num_tokens + token]++;
+        }
+    }
+
+  lcs = svn_diff__lcs(&positions[0][length[0] - 1],
+                      &positions[1][length[1] - 1],
+                      token_counts, token_counts + num_tokens, num_tokens,
+                      0, 0, h->scratch_pool);
+
+  for (; lcs; lcs = lcs->next)
+    if (lcs->length)
+      add_match(h,
+                section->start[0] + lcs->position[0]->offset - 1,
+                section->start[1] + lcs->position[1]->offset - 1,
+                lcs->length);
+
+  svn_pool_clear(h->scratch_pool);
+}
+
+/* Append a new lcs chunk for LENGTH tokens at the given positions
+ * POSITION0 and POSITION1 to **LCS_REF and return the next link to fill. */
+static svn_diff__lcs_t **
+append_lcs(svn_diff__lcs_t **lcs_ref,
+           svn_diff__position_t *position0,
+           svn_diff__position_t *position1,
+           apr_off_t length,
+           apr_pool_t *pool)
+{
+  svn_diff__lcs_t *lcs = apr_palloc(pool, sizeof(*lcs));
+
+  lcs->position[0] = position0;
+  lcs->position[1] = position1;
+  lcs->length = length;
+  lcs->refcount = 1;
+  lcs->next = NULL;
+
+  *lcs_ref = lcs;
+  return &lcs->next;
+}
+
+/* Return a new position at OFFSET that is not part of any list. */
+static svn_diff__position_t *
+make_position(apr_off_t offset,
+              apr_pool_t *pool)
+{
+  svn_diff__position_t *position = apr_pcalloc(pool, sizeof(*position));
+  position->offset = offset;
+
+  return position;
+}
+
+
+svn_diff__lcs_t *
+svn_diff__histogram(svn_diff__position_t *position_list1, /* tail (ring) */
+                    svn_diff__position_t *position_list2, /* tail (ring) */
+                    svn_diff__token_index_t *token_counts_list1,
+                    svn_diff__token_index_t *token_counts_list2,
+                    svn_diff__token_index_t num_tokens,
+                    apr_off_t prefix_lines,
+                    apr_off_t suffix_lines,
+                    apr_pool_t *pool)
+{
+  svn_diff__position_t *position_list[2];
+  svn_diff__token_index_t length[2];
+  apr_array_header_t *sections;
+  section_t *section;
+  histogram_t h;
+  svn_diff__lcs_t *lcs = NULL;
+  svn_diff__lcs_t **lcs_ref = &lcs;
+  apr_off_t eof[2];
+  int list, i;
+
+  /* Without tokens, there is nothing to compare and the LCS algorithm
+   * returns the prefix and suffix immediately. */
+  if (position_list1 == NULL || position_list2 == NULL)
+    return svn_diff__lcs(position_list1, position_list2,
+                         token_counts_list1, token_counts_list2, num_tokens,
+                         prefix_lines, suffix_lines, pool);
+
+  position_list[0] = position_list1;
+  position_list[1] = position_list2;
+
+  /* Put both lists into arrays. */
+  for (list = 0; list < 2; list++)
+    {
+      svn_diff__position_t *position = position_list[list]->next;
+      svn_diff__token_index_t k;
+
+      length[list] = (svn_diff__token_index_t)
+        (position_list[list]->offset - position->offset + 1);
+      h.tokens[list] = apr_palloc(pool,
+                                  length[list] * sizeof(*h.tokens[list]));
+      h.positions[list]
+        = apr_palloc(pool, length[list] * sizeof(*h.positions[list]));
+
+      for (k = 0; k < length[list]; k++, position = position->next)
+        {
+          h.tokens[list][k] = position->token_index;
+          h.positions[list][k] = position;
+        }
+    }
+
+  h.stamp = apr_pcalloc(pool, num_tokens * sizeof(*h.stamp));
+  h.count = apr_palloc(pool, num_tokens * sizeof(*h.count));
+  h.first = apr_palloc(pool, num_tokens * sizeof(*h.first));
+  h.generation = 0;
+  h.next = apr_palloc(pool, length[0] * sizeof(*h.next));
+  h.work_left = (apr_int64_t)WORK_PER_TOKEN * (length[0] + length[1]);
+  h.matches = apr_array_make(pool, 16, sizeof(section_t));
+  h.scratch_pool = svn_pool_create(pool);
+
+  /* Process sections depth-first.  To report the matches in order, push
+   * the parts of a section in reverse order. */
+  sections = apr_array_make(pool, 16, sizeof(section_t));
+  section = apr_array_push(sections);
+  section->start[0] = 0;
+  section->start[1] = 0;
+  section->end[0] = length[0];
+  section->end[1] = length[1];
+  section->is_match = FALSE;
+
+  while (sections->nelts)
+    {
+      section_t current = *(section_t *)apr_array_pop(sections);
+      section_t anchor;
+      svn_diff__token_index_t common;
+      int found;
+
+      if (current.is_match)
+        {
+          add_match(&h, current.start[0], current.start[1],
+                    current.end[0] - current.start[0]);
+          continue;
+        }
+
+      /* Matching tokens at the start and end of the section are part of
+       * the result, no matter what. */
+      for (common = 0;
+              current.start[0] + common < current.end[0]
+           && current.start[1] + common < current.end[1]
+           && h.tokens[0][current.start[0] + common]
+              == h.tokens[1][current.start[1] + common];
+           common++)
+        ;
+
+      if (common)
+        {
+          add_match(&h, current.start[0], current.start[1], common);
+          current.start[0] += common;
+          current.start[1] += common;
+        }
+
+      for (common = 0;
+              current.end[0] - common > current.start[0]
+           && current.end[1] - common > current.start[1]
+           && h.tokens[0][current.end[0] - common - 1]
+              == h.tokens[1][current.end[1] - common - 1];
+           common++)
+        ;
+
+      if (common)
+        {
+          section = apr_array_push(sections);
+          section->start[0] = current.end[0] - common;
+          section->start[1] = current.end[1] - common;
+          section->end[0] = current.end[0];
+          section->end[1] = current.end[1];
+          section->is_match = TRUE;
+
+          current.end[0] -= common;
+          current.end[1] -= common;
+        }
+
+      if (   current.start[0] == current.end[0]
+          || current.start[1] == current.end[1])
+        continue;
+
+      found = h.work_left > 0 ? find_anchor(&anchor, &h, &current) : -1;
+      if (found > 0)
+        {
+          section = apr_array_push(sections);
+          section->start[0] = anchor.end[0];
+          section->start[1] = anchor.end[1];
+          section->end[0] = current.end[0];
+          section->end[1] = current.end[1];
+          section->is_match = FALSE;
+
+          APR_ARRAY_PUSH(sections, section_t) = anchor;
+
+          section = apr_array_push(sections);
+          section->start[0] = current.start[0];
+          section->start[1] = current.start[1];
+          section->end[0] = anchor.start[0];
+          section->end[1] = anchor.start[1];
+          section->is_match = FALSE;
+        }
+      else if (found < 0
+               && (  current.end[0] - current.start[0]
+                   + current.end[1] - current.start[1]) <= MAX_LCS_TOKENS)
+        {
+          lcs_section(&h, &current);
+        }
+    }
+
+  svn_pool_destroy(h.scratch_pool);
+
+  /* Build the lcs chain, including the prefix, suffix and the EOF link
+   * that svn_diff__lcs() adds as well. */
+  eof[0] = position_list1->offset + suffix_lines + 1;
+  eof[1] = position_list2->offset + suffix_lines + 1;
+
+  if (prefix_lines)
+    lcs_ref = append_lcs(lcs_ref, make_position(1, pool),
+                         make_position(1, pool), prefix_lines, pool);
+
+  for (i = 0; i < h.matches->nelts; i++)
+    {
+      section = &APR_ARRAY_IDX(h.matches, i, section_t);
+      lcs_ref = append_lcs(lcs_ref,
+                           h.positions[0][section->start[0]],
+                           h.positions[1][section->start[1]],
+                           section->end[0] - section->start[0], pool);
+    }
+
+  if (suffix_lines)
+    lcs_ref = append_lcs(lcs_ref,
+                         make_position(eof[0] - suffix_lines, pool),
+                         make_position(eof[1] - suffix_lines, pool),
+                         suffix_lines, pool);
+
+  append_lcs(lcs_ref, make_position(eof[0], pool),
+             make_position(eof[1], pool), 0, pool);
+
+  return lcs;
+}
@@ -373,3 +373,24 @@ svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
   else
     return lcs;
 }
+
+svn_diff__lcs_t *
+svn_diff__find_lcs(svn_diff_algorithm_t algorithm,
+                   svn_diff__position_t *position_list1,
+                   svn_diff__position_t *position_list2,
+                   svn_diff__token_index_t *token_counts_list1,
+                   svn_diff__token_index_t *token_counts_list2,
+                   svn_diff__token_index_t num_tokens,
+                   apr_off_t prefix_lines,
+                   apr_off_t suffix_lines,
+                   apr_pool_t *pool)
+{
+  if (algorithm == svn_diff_algorithm_histogram)
+    return svn_diff__histogram(position_list1, position_list2,
+                               token_counts_list1, token_counts_list2,
+                               num_tokens, prefix_lines, suffix_lines, pool);
+
+  return svn_diff__lcs(position_list1, position_list2,
+                       token_counts_list1, token_counts_list2,
+                       num_tokens, prefix_lines, suffix_lines, pool);
+}
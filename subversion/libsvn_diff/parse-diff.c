@@ -25,6 +25,8 @@
 #include <stddef.h>
 #include <string.h>
 
+#include <apr_mmap.h>
+
 #include "svn_hash.h"
 #include "svn_types.h"
 #include "svn_error.h"
@@ -62,12 +64,227 @@ struct svn_diff__hunk_range {
   apr_off_t current;
 };
 
+/* A file that the patch parser reads from.
+ *
+ * Patch files get memory mapped if possible.  DATA then points to the
+ * SIZE bytes of the mapping and POS is the current read position.  All
+ * reads are served from memory, without system calls or per-byte file
+ * I/O.  Otherwise, DATA is NULL and all reads go through APR_FILE.
+ *
+ * Both variants behave exactly like the svn_io_file_* functions. */
+typedef struct patch_source_t
+{
+  apr_file_t *apr_file;
+
+  const char *data;
+  apr_off_t size;
+  apr_off_t pos;
+
+  /* Whether the last read operation tried to read past the end of DATA,
+   * see apr_file_eof(). */
+  svn_boolean_t eof_hit;
+
+#if APR_HAS_MMAP
+  apr_mmap_t *mmap;
+#endif
+} patch_source_t;
+
+/* Patch files smaller than this are read through APR's file buffer. */
+#define PATCH_MMAP_THRESHOLD (64 * 1024)
+
+/* Return a patch source in *SOURCE that reads from APR_FILE, which is
+ * opened for reading and positioned at the start of the file.  Memory map
+ * APR_FILE if it is large enough and mapping is supported.  Allocate the
+ * source, and the mapping, in RESULT_POOL. */
+static svn_error_t *
+source_create(patch_source_t **source,
+              apr_file_t *apr_file,
+              apr_pool_t *result_pool,
+              apr_pool_t *scratch_pool)
+{
+  patch_source_t *s = apr_pcalloc(result_pool, sizeof(*s));
+
+  s->apr_file = apr_file;
+
+#if APR_HAS_MMAP
+  {
+    apr_finfo_t finfo;
+
+    SVN_ERR(svn_io_file_info_get(&finfo, APR_FINFO_SIZE, apr_file,
+                                 scratch_pool));
+
+    if (finfo.size >= PATCH_MMAP_THRESHOLD && finfo.size <= APR_SIZE_MAX
+        && apr_mmap_create(&s->mmap, apr_file, 0, (apr_size_t)finfo.size,
+                           APR_MMAP_READ, result_pool) == APR_SUCCESS)
+      {
+        s->data = s->mmap->mm;
+        s->size = finfo.size;
+      }
+    else
+      {
+        /* On failure, we just read through APR_FILE instead. */
+        s->mmap = NULL;
+      }
+  }
+#endif
+
+  *source = s;
+  return SVN_NO_ERROR;
+}
+
+/* Like svn_io_file_get_offset() for SOURCE. */
+static svn_error_t *
+source_get_offset(apr_off_t *offset,
+                  patch_source_t *source,
+                  apr_pool_t *scratch_pool)
+{
+  if (!source->data)
+    return svn_error_trace(svn_io_file_get_offset(offset, source->apr_file,
+                                                  scratch_pool));
+
+  *offset = source->pos;
+  return SVN_NO_ERROR;
+}
+
+/* Like svn_io_file_seek() with APR_SET for SOURCE. */
+static svn_error_t *
+source_seek(patch_source_t *source,
+            apr_off_t *offset,
+            apr_pool_t *scratch_pool)
+{
+  if (!source->data)
+    return svn_error_trace(svn_io_file_seek(source->apr_file, APR_SET,
+                                            offset, scratch_pool));
+
+  source->pos = *offset;
+  source->eof_hit = FALSE;
+  return SVN_NO_ERROR;
+}
+
+/* Return TRUE if the last read from SOURCE hit its end, like
+ * apr_file_eof() does. */
+static svn_boolean_t
+source_eof(patch_source_t *source)
+{
+  if (!source->data)
+    return apr_file_eof(source->apr_file) == APR_EOF;
+
+  return source->eof_hit;
+}
+
+/* Like svn_io_file_read_full2() for SOURCE. */
+static svn_error_t *
+source_read_full(patch_source_t *source,
+                 void *buf,
+                 apr_size_t nbytes,
+                 apr_size_t *bytes_read,
+                 svn_boolean_t *hit_eof,
+                 apr_pool_t *scratch_pool)
+{
+  apr_size_t available;
+  svn_boolean_t short_read = FALSE;
+
+  if (!source->data)
+    return svn_error_trace(svn_io_file_read_full2(source->apr_file, buf,
+                                                  nbytes, bytes_read,
+                                                  hit_eof, scratch_pool));
+
+  available = source->pos < source->size
+            ? (apr_size_t)(source->size - source->pos) : 0;
+  if (nbytes > available)
+    {
+      nbytes = available;
+      short_read = TRUE;
+      source->eof_hit = TRUE;
+    }
+
+  memcpy(buf, source->data + source->pos, nbytes);
+  source->pos += nbytes;
+
+  if (bytes_read)
+    *bytes_read = nbytes;
+  if (hit_eof)
+    *hit_eof = short_read;
+
+  return SVN_NO_ERROR;
+}
+
+/* Like svn_io_file_readline() for SOURCE. */
+static svn_error_t *
+source_readline(patch_source_t *source,
+                svn_stringbuf_t **stringbuf,
+                const char **eol,
+                svn_boolean_t *eof,
+                apr_size_t max_len,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  const char *start;
+  const char *limit;
+  const char *next;
+  char *p;
+  const char *eol_str = NULL;
+  apr_size_t available;
+
+  if (!source->data)
+    return svn_error_trace(svn_io_file_readline(source->apr_file, stringbuf,
+                                                eol, eof, max_len,
+                                                result_pool, scratch_pool));
+
+  /* The mapping, and thus SIZE, fits into memory. */
+  available = source->pos < source->size
+            ? (apr_size_t)(source->size - source->pos) : 0;
+  start = source->data + source->pos;
+  limit = start + (max_len < available ? max_len : available);
+
+  /* Like svn_io_file_readline(), consume at most MAX_LEN bytes, including
+   * the EOL sequence. */
+  p = svn_eol__find_eol_start((char *)start, limit - start);
+  if (p)
+    {
+      next = p + 1;
+      if (*p == '\n')
+        {
+          eol_str = "\n";
+        }
+      else
+        {
+          eol_str = "\r";
+          if (next < limit && *next == '\n')
+            {
+              eol_str = "\r\n";
+              next++;
+            }
+        }
+    }
+  else
+    {
+      p = (char *)limit;
+      next = limit;
+
+      /* Only if there was no MAX_LEN bytes limit, we tried to read past
+       * the end of the file. */
+      if (max_len > available)
+        source->eof_hit = TRUE;
+    }
+
+  *stringbuf = svn_stringbuf_ncreate(start, p - start, result_pool);
+  source->pos += next - start;
+
+  if (eol)
+    *eol = eol_str;
+  if (eof)
+    *eof = (eol_str == NULL);
+
+  return SVN_NO_ERROR;
+}
+
 struct svn_diff_hunk_t {
   /* The patch this hunk belongs to. */
   const svn_patch_t *patch;
 
-  /* APR file handle to the patch file this hunk came from. */
-  apr_file_t *apr_file;
+  /* The patch file this hunk came from. */
+  patch_source_t *source;
 
   /* Ranges used to keep track of this hunk's texts positions within
    * the patch file. */
@@ -99,15 +316,15 @@ struct svn_diff_binary_patch_t {
   /* The patch this hunk belongs to. */
   const svn_patch_t *patch;
 
-  /* APR file handle to the patch file this hunk came from. */
-  apr_file_t *apr_file;
+  /* The patch file this hunk came from. */
+  patch_source_t *source;
 
-  /* Offsets inside APR_FILE representing the location of the patch */
+  /* Offsets inside SOURCE representing the location of the patch */
   apr_off_t src_start;
   apr_off_t src_end;
   svn_filesize_t src_filesize; /* Expanded/final size */
 
-  /* Offsets inside APR_FILE representing the location of the patch */
+  /* Offsets inside SOURCE representing the location of the patch */
   apr_off_t dst_start;
   apr_off_t dst_end;
   svn_filesize_t dst_filesize; /* Expanded/final size */
@@ -132,10 +349,11 @@ add_or_delete_single_line(svn_diff_hunk_t **hunk_out,
   const apr_size_t len = strlen(line);
   const apr_size_t end = header_len + (1 + len); /* The +1 is for the \n. */
   svn_stringbuf_t *buf = svn_stringbuf_create_ensure(end + 1, scratch_pool);
+  apr_file_t *file;
 
   hunk->patch = patch;
 
-  /* hunk->apr_file is created below. */
+  /* hunk->source is created below. */
 
   hunk->diff_text_range.start = header_len;
   hunk->diff_text_range.current = header_len;
@@ -180,7 +398,7 @@ add_or_delete_single_line(svn_diff_hunk_t **hunk_out,
   hunk->leading_context = 0;
   hunk->trailing_context = 0;
 
-  /* Create APR_FILE and put just a hunk in it (without a diff header).
+  /* Create a file and put just a hunk in it (without a diff header).
    * Save the offset of the last byte of the diff line. */
   svn_stringbuf_appendbytes(buf, hunk_header[add], header_len);
   svn_stringbuf_appendbyte(buf, add ? '+' : '-');
@@ -190,14 +408,16 @@ add_or_delete_single_line(svn_diff_hunk_t **hunk_out,
 
   hunk->diff_text_range.end = buf->len;
 
-  SVN_ERR(svn_io_open_unique_file3(&hunk->apr_file, NULL /* filename */,
+  SVN_ERR(svn_io_open_unique_file3(&file, NULL /* filename */,
                                    NULL /* system tempdir */,
                                    svn_io_file_del_on_pool_cleanup,
                                    result_pool, scratch_pool));
-  SVN_ERR(svn_io_file_write_full(hunk->apr_file,
+  SVN_ERR(svn_io_file_write_full(file,
                                  buf->data, buf->len,
                                  NULL, scratch_pool));
-  /* No need to seek. */
+  /* No need to seek, and the file is too small to be mapped. */
+  hunk->source = apr_pcalloc(result_pool, sizeof(*hunk->source));
+  hunk->source->apr_file = file;
 
   *hunk_out = hunk;
   return SVN_NO_ERROR;
@@ -298,7 +518,7 @@ svn_diff_hunk__get_fuzz_penalty(const svn_diff_hunk_t *hunk)
 /* Baton for the base85 stream implementation */
 struct base85_baton_t
 {
-  apr_file_t *file;
+  patch_source_t *file;
   apr_pool_t *iterpool;
   char buffer[52];        /* Bytes on current line */
   apr_off_t next_pos;     /* Start position of next line */
@@ -347,16 +567,14 @@ read_handler_base85(void *baton, char *buffer, apr_size_t *len)
 
       if (b85b->next_pos >= b85b->end_pos)
         break; /* At EOF */
-      SVN_ERR(svn_io_file_seek(b85b->file, APR_SET, &b85b->next_pos,
-                               iterpool));
-      SVN_ERR(svn_io_file_readline(b85b->file, &line, NULL, &at_eof,
-                                   APR_SIZE_MAX, iterpool, iterpool));
+      SVN_ERR(source_seek(b85b->file, &b85b->next_pos, iterpool));
+      SVN_ERR(source_readline(b85b->file, &line, NULL, &at_eof, APR_SIZE_MAX,
+                              iterpool, iterpool));
       if (at_eof)
         b85b->next_pos = b85b->end_pos;
       else
         {
-          SVN_ERR(svn_io_file_get_offset(&b85b->next_pos, b85b->file,
-                                         iterpool));
+          SVN_ERR(source_get_offset(&b85b->next_pos, b85b->file, iterpool));
         }
 
       if (line->len && line->data[0] >= 'A' && line->data[0] <= 'Z')
@@ -397,7 +615,7 @@ close_handler_base85(void *baton)
    The current implementation might assume that both start_pos and end_pos
    are located at line boundaries. */
 static svn_stream_t *
-get_base85_data_stream(apr_file_t *file,
+get_base85_data_stream(patch_source_t *file,
                        apr_off_t start_pos,
                        apr_off_t end_pos,
                        apr_pool_t *result_pool)
@@ -479,7 +697,7 @@ svn_stream_t *
 svn_diff_get_binary_diff_original_stream(const svn_diff_binary_patch_t *bpatch,
                                          apr_pool_t *result_pool)
 {
-  svn_stream_t *s = get_base85_data_stream(bpatch->apr_file, bpatch->src_start,
+  svn_stream_t *s = get_base85_data_stream(bpatch->source, bpatch->src_start,
                                            bpatch->src_end, result_pool);
 
   s = svn_stream_compressed(s, result_pool);
@@ -494,7 +712,7 @@ svn_stream_t *
 svn_diff_get_binary_diff_result_stream(const svn_diff_binary_patch_t *bpatch,
                                        apr_pool_t *result_pool)
 {
-  svn_stream_t *s = get_base85_data_stream(bpatch->apr_file, bpatch->dst_start,
+  svn_stream_t *s = get_base85_data_stream(bpatch->source, bpatch->dst_start,
                                            bpatch->dst_end, result_pool);
 
   s = svn_stream_compressed(s, result_pool);
@@ -649,7 +867,7 @@ parse_hunk_header(const char *header, svn_diff_hunk_t *hunk,
  * and svn_diff_hunk_readline_modified_text().
  */
 static svn_error_t *
-hunk_readline_original_or_modified(apr_file_t *file,
+hunk_readline_original_or_modified(patch_source_t *file,
                                    struct svn_diff__hunk_range *range,
                                    svn_stringbuf_t **stringbuf,
                                    const char **eol,
@@ -678,8 +896,8 @@ hunk_readline_original_or_modified(apr_file_t *file,
       return SVN_NO_ERROR;
     }
 
-  SVN_ERR(svn_io_file_get_offset(&pos, file, scratch_pool));
-  SVN_ERR(svn_io_file_seek(file, APR_SET, &range->current, scratch_pool));
+  SVN_ERR(source_get_offset(&pos, file, scratch_pool));
+  SVN_ERR(source_seek(file, &range->current, scratch_pool));
 
   /* It's not ITERPOOL because we use data allocated in LAST_POOL out
      of the loop. */
@@ -689,9 +907,9 @@ hunk_readline_original_or_modified(apr_file_t *file,
       svn_pool_clear(last_pool);
 
       max_len = range->end - range->current;
-      SVN_ERR(svn_io_file_readline(file, &str, eol, eof, max_len,
-                                   last_pool, last_pool));
-      SVN_ERR(svn_io_file_get_offset(&range->current, file, last_pool));
+      SVN_ERR(source_readline(file, &str, eol, eof, max_len, last_pool,
+                              last_pool));
+      SVN_ERR(source_get_offset(&range->current, file, last_pool));
       filtered = (str->data[0] == verboten || str->data[0] == '\\');
     }
   while (filtered && ! *eof);
@@ -725,10 +943,10 @@ hunk_readline_original_or_modified(apr_file_t *file,
         {
           apr_off_t start = 0;
 
-          SVN_ERR(svn_io_file_seek(file, APR_SET, &start, scratch_pool));
+          SVN_ERR(source_seek(file, &start, scratch_pool));
 
-          SVN_ERR(svn_io_file_readline(file, &str, eol, NULL, APR_SIZE_MAX,
-                                       scratch_pool, scratch_pool));
+          SVN_ERR(source_readline(file, &str, eol, NULL, APR_SIZE_MAX,
+                                  scratch_pool, scratch_pool));
 
           /* Every patch file that has hunks has at least one EOL*/
           SVN_ERR_ASSERT(*eol != NULL);
@@ -737,7 +955,7 @@ hunk_readline_original_or_modified(apr_file_t *file,
       *eof = FALSE;
       /* Fall through to seek back to the right location */
     }
-  SVN_ERR(svn_io_file_seek(file, APR_SET, &pos, scratch_pool));
+  SVN_ERR(source_seek(file, &pos, scratch_pool));
 
   svn_pool_destroy(last_pool);
   return SVN_NO_ERROR;
@@ -752,7 +970,7 @@ svn_diff_hunk_readline_original_text(svn_diff_hunk_t *hunk,
                                      apr_pool_t *scratch_pool)
 {
   return svn_error_trace(
-    hunk_readline_original_or_modified(hunk->apr_file,
+    hunk_readline_original_or_modified(hunk->source,
                                        hunk->patch->reverse ?
                                          &hunk->modified_text_range :
                                          &hunk->original_text_range,
@@ -773,7 +991,7 @@ svn_diff_hunk_readline_modified_text(svn_diff_hunk_t *hunk,
                                      apr_pool_t *scratch_pool)
 {
   return svn_error_trace(
-    hunk_readline_original_or_modified(hunk->apr_file,
+    hunk_readline_original_or_modified(hunk->source,
                                        hunk->patch->reverse ?
                                          &hunk->original_text_range :
                                          &hunk->modified_text_range,
@@ -810,15 +1028,14 @@ svn_diff_hunk_readline_diff_text(svn_diff_hunk_t *hunk,
       return SVN_NO_ERROR;
     }
 
-  SVN_ERR(svn_io_file_get_offset(&pos, hunk->apr_file, scratch_pool));
-  SVN_ERR(svn_io_file_seek(hunk->apr_file, APR_SET,
-                           &hunk->diff_text_range.current, scratch_pool));
+  SVN_ERR(source_get_offset(&pos, hunk->source, scratch_pool));
+  SVN_ERR(source_seek(hunk->source, &hunk->diff_text_range.current,
+                      scratch_pool));
   max_len = hunk->diff_text_range.end - hunk->diff_text_range.current;
-  SVN_ERR(svn_io_file_readline(hunk->apr_file, &line, eol, eof, max_len,
-                               result_pool,
-                   scratch_pool));
-  SVN_ERR(svn_io_file_get_offset(&hunk->diff_text_range.current,
-                                 hunk->apr_file, scratch_pool));
+  SVN_ERR(source_readline(hunk->source, &line, eol, eof, max_len, result_pool,
+                          scratch_pool));
+  SVN_ERR(source_get_offset(&hunk->diff_text_range.current, hunk->source,
+                            scratch_pool));
 
   if (*eof && !*eol && *line->data)
     {
@@ -834,12 +1051,10 @@ svn_diff_hunk_readline_diff_text(svn_diff_hunk_t *hunk,
           apr_off_t start = 0;
           svn_stringbuf_t *str;
 
-          SVN_ERR(svn_io_file_seek(hunk->apr_file, APR_SET, &start,
-                                   scratch_pool));
+          SVN_ERR(source_seek(hunk->source, &start, scratch_pool));
 
-          SVN_ERR(svn_io_file_readline(hunk->apr_file, &str, eol, NULL,
-                                       APR_SIZE_MAX,
-                                       scratch_pool, scratch_pool));
+          SVN_ERR(source_readline(hunk->source, &str, eol, NULL, APR_SIZE_MAX,
+                                  scratch_pool, scratch_pool));
 
           /* Every patch file that has hunks has at least one EOL*/
           SVN_ERR_ASSERT(*eol != NULL);
@@ -850,7 +1065,7 @@ svn_diff_hunk_readline_diff_text(svn_diff_hunk_t *hunk,
       /* Fall through to seek back to the right location */
     }
 
-  SVN_ERR(svn_io_file_seek(hunk->apr_file, APR_SET, &pos, scratch_pool));
+  SVN_ERR(source_seek(hunk->source, &pos, scratch_pool));
 
   if (hunk->patch->reverse)
     {
@@ -1028,7 +1243,7 @@ parse_mergeinfo(svn_boolean_t *found_mergeinfo,
   return SVN_NO_ERROR;
 }
 
-/* Return the next *HUNK from a PATCH in APR_FILE.
+/* Return the next *HUNK from a PATCH in SOURCE.
  * If no hunk can be found, set *HUNK to NULL.
  * Set IS_PROPERTY to TRUE if we have a property hunk. If the returned HUNK
  * is the first belonging to a certain property, then PROP_NAME and
@@ -1042,7 +1257,7 @@ parse_next_hunk(svn_diff_hunk_t **hunk,
                 const char **prop_name,
                 svn_diff_operation_kind_t *prop_operation,
                 svn_patch_t *patch,
-                apr_file_t *apr_file,
+                patch_source_t *source,
                 svn_boolean_t ignore_whitespace,
                 apr_pool_t *result_pool,
                 apr_pool_t *scratch_pool)
@@ -1077,7 +1292,7 @@ parse_next_hunk(svn_diff_hunk_t **hunk,
   *prop_name = NULL;
   *is_property = FALSE;
 
-  if (apr_file_eof(apr_file) == APR_EOF)
+  if (source_eof(source))
     {
       /* No more hunks here. */
       *hunk = NULL;
@@ -1094,7 +1309,7 @@ parse_next_hunk(svn_diff_hunk_t **hunk,
   *hunk = apr_pcalloc(result_pool, sizeof(**hunk));
 
   /* Get current seek position. */
-  SVN_ERR(svn_io_file_get_offset(&pos, apr_file, scratch_pool));
+  SVN_ERR(source_get_offset(&pos, source, scratch_pool));
 
   /* Start out assuming noise. */
   last_line_type = noise_line;
@@ -1107,11 +1322,11 @@ parse_next_hunk(svn_diff_hunk_t **hunk,
 
       /* Remember the current line's offset, and read the line. */
       last_line = pos;
-      SVN_ERR(svn_io_file_readline(apr_file, &line, NULL, &eof, APR_SIZE_MAX,
-                                   iterpool, iterpool));
+      SVN_ERR(source_readline(source, &line, NULL, &eof, APR_SIZE_MAX,
+                              iterpool, iterpool));
 
       /* Update line offset for next iteration. */
-      SVN_ERR(svn_io_file_get_offset(&pos, apr_file, iterpool));
+      SVN_ERR(source_get_offset(&pos, source, iterpool));
 
       /* Lines starting with a backslash indicate a missing EOL:
        * "\ No newline at end of file" or "end of property". */
@@ -1128,10 +1343,10 @@ parse_next_hunk(svn_diff_hunk_t **hunk,
                * has no trailing EOL. Snip off trailing EOL which is part
                * of the patch file but not part of the hunk text. */
               off = last_line - 2;
-              SVN_ERR(svn_io_file_seek(apr_file, APR_SET, &off, iterpool));
+              SVN_ERR(source_seek(source, &off, iterpool));
               len = sizeof(eolbuf);
-              SVN_ERR(svn_io_file_read_full2(apr_file, eolbuf, len, &len,
-                                             &eof, iterpool));
+              SVN_ERR(source_read_full(source, eolbuf, len, &len, &eof,
+                                       iterpool));
               if (eolbuf[0] == '\r' && eolbuf[1] == '\n')
                 hunk_text_end = last_line - 2;
               else if (eolbuf[1] == '\n' || eolbuf[1] == '\r')
@@ -1151,7 +1366,7 @@ parse_next_hunk(svn_diff_hunk_t **hunk,
                     modified_end = hunk_text_end;
                 }
 
-              SVN_ERR(svn_io_file_seek(apr_file, APR_SET, &pos, iterpool));
+              SVN_ERR(source_seek(source, &pos, iterpool));
               /* Set for the type and context by using != the other type */
               if (last_line_type != modified_line)
                 original_no_final_eol = TRUE;
@@ -1350,7 +1565,7 @@ parse_next_hunk(svn_diff_hunk_t **hunk,
     /* Rewind to the start of the line just read, so subsequent calls
      * to this function or svn_diff_parse_next_patch() don't end
      * up skipping the line -- it may contain a patch or hunk header. */
-    SVN_ERR(svn_io_file_seek(apr_file, APR_SET, &last_line, scratch_pool));
+    SVN_ERR(source_seek(source, &last_line, scratch_pool));
 
   if (hunk_seen && start < end)
     {
@@ -1370,7 +1585,7 @@ parse_next_hunk(svn_diff_hunk_t **hunk,
         }
 
       (*hunk)->patch = patch;
-      (*hunk)->apr_file = apr_file;
+      (*hunk)->source = source;
       (*hunk)->leading_context = leading_context;
       (*hunk)->trailing_context = trailing_context;
       (*hunk)->diff_text_range.start = start;
@@ -1909,8 +2124,8 @@ add_property_hunk(svn_patch_t *patch, const char *prop_name,
 
 struct svn_patch_file_t
 {
-  /* The APR file handle to the patch file. */
-  apr_file_t *apr_file;
+  /* The patch file. */
+  patch_source_t *source;
 
   /* The file offset at which the next patch is expected. */
   apr_off_t next_patch_offset;
@@ -1922,25 +2137,27 @@ svn_diff_open_patch_file(svn_patch_file_t **patch_file,
                          apr_pool_t *result_pool)
 {
   svn_patch_file_t *p;
+  apr_file_t *file;
 
   p = apr_palloc(result_pool, sizeof(*p));
-  SVN_ERR(svn_io_file_open(&p->apr_file, local_abspath,
+  SVN_ERR(svn_io_file_open(&file, local_abspath,
                            APR_READ | APR_BUFFERED, APR_OS_DEFAULT,
                            result_pool));
+  SVN_ERR(source_create(&p->source, file, result_pool, result_pool));
   p->next_patch_offset = 0;
   *patch_file = p;
 
   return SVN_NO_ERROR;
 }
 
-/* Parse hunks from APR_FILE and store them in PATCH->HUNKS.
+/* Parse hunks from SOURCE and store them in PATCH->HUNKS.
  * Parsing stops if no valid next hunk can be found.
  * If IGNORE_WHITESPACE is TRUE, lines without
  * leading spaces will be treated as context lines.
  * Allocate results in RESULT_POOL.
  * Use SCRATCH_POOL for temporary allocations. */
 static svn_error_t *
-parse_hunks(svn_patch_t *patch, apr_file_t *apr_file,
+parse_hunks(svn_patch_t *patch, patch_source_t *source,
             svn_boolean_t ignore_whitespace,
             apr_pool_t *result_pool, apr_pool_t *scratch_pool)
 {
@@ -1961,7 +2178,7 @@ parse_hunks(svn_patch_t *patch, apr_file_t *apr_file,
       svn_pool_clear(iterpool);
 
       SVN_ERR(parse_next_hunk(&hunk, &is_property, &prop_name, &prop_operation,
-                              patch, apr_file, ignore_whitespace, result_pool,
+                              patch, source, ignore_whitespace, result_pool,
                               iterpool));
 
       if (hunk && is_property)
@@ -1994,7 +2211,7 @@ parse_hunks(svn_patch_t *patch, apr_file_t *apr_file,
 }
 
 static svn_error_t *
-parse_binary_patch(svn_patch_t *patch, apr_file_t *apr_file,
+parse_binary_patch(svn_patch_t *patch, patch_source_t *source,
                    svn_boolean_t reverse,
                    apr_pool_t *result_pool, apr_pool_t *scratch_pool)
 {
@@ -2006,20 +2223,20 @@ parse_binary_patch(svn_patch_t *patch, apr_file_t *apr_file,
   svn_boolean_t in_blob = FALSE;
   svn_boolean_t in_src = FALSE;
 
-  bpatch->apr_file = apr_file;
+  bpatch->source = source;
 
   patch->prop_patches = apr_hash_make(result_pool);
 
-  SVN_ERR(svn_io_file_get_offset(&pos, apr_file, scratch_pool));
+  SVN_ERR(source_get_offset(&pos, source, scratch_pool));
 
   while (!eof)
     {
       last_line = pos;
-      SVN_ERR(svn_io_file_readline(apr_file, &line, NULL, &eof, APR_SIZE_MAX,
-                               iterpool, iterpool));
+      SVN_ERR(source_readline(source, &line, NULL, &eof, APR_SIZE_MAX,
+                              iterpool, iterpool));
 
       /* Update line offset for next iteration. */
-      SVN_ERR(svn_io_file_get_offset(&pos, apr_file, iterpool));
+      SVN_ERR(source_get_offset(&pos, source, iterpool));
 
       if (in_blob)
         {
@@ -2086,7 +2303,7 @@ parse_binary_patch(svn_patch_t *patch, apr_file_t *apr_file,
   if (!eof)
     /* Rewind to the start of the line just read, so subsequent calls
      * don't end up skipping the line. It may contain a patch or hunk header.*/
-    SVN_ERR(svn_io_file_seek(apr_file, APR_SET, &last_line, scratch_pool));
+    SVN_ERR(source_seek(source, &last_line, scratch_pool));
   else if (in_src
            && ((bpatch->src_end > bpatch->src_start) || !bpatch->src_filesize))
     {
@@ -2167,7 +2384,7 @@ svn_diff_parse_next_patch(svn_patch_t **patch_p,
   svn_patch_t *patch;
   enum parse_state state = state_start;
 
-  if (apr_file_eof(patch_file->apr_file) == APR_EOF)
+  if (source_eof(patch_file->source))
     {
       /* No more patches here. */
       *patch_p = NULL;
@@ -2181,7 +2398,7 @@ svn_diff_parse_next_patch(svn_patch_t **patch_p,
   patch->new_symlink_bit = svn_tristate_unknown;
 
   pos = patch_file->next_patch_offset;
-  SVN_ERR(svn_io_file_seek(patch_file->apr_file, APR_SET, &pos, scratch_pool));
+  SVN_ERR(source_seek(patch_file->source, &pos, scratch_pool));
 
   iterpool = svn_pool_create(scratch_pool);
   do
@@ -2194,14 +2411,13 @@ svn_diff_parse_next_patch(svn_patch_t **patch_p,
 
       /* Remember the current line's offset, and read the line. */
       last_line = pos;
-      SVN_ERR(svn_io_file_readline(patch_file->apr_file, &line, NULL, &eof,
-                                   APR_SIZE_MAX, iterpool, iterpool));
+      SVN_ERR(source_readline(patch_file->source, &line, NULL, &eof,
+                              APR_SIZE_MAX, iterpool, iterpool));
 
       if (! eof)
         {
           /* Update line offset for next iteration. */
-          SVN_ERR(svn_io_file_get_offset(&pos, patch_file->apr_file,
-                                         iterpool));
+          SVN_ERR(source_get_offset(&pos, patch_file->source, iterpool));
         }
 
       /* Run the state machine. */
@@ -2232,8 +2448,7 @@ svn_diff_parse_next_patch(svn_patch_t **patch_p,
            * Rewind to the start of the line just read, so subsequent calls
            * to this function don't end up skipping the line -- it may
            * contain a patch. */
-          SVN_ERR(svn_io_file_seek(patch_file->apr_file, APR_SET, &last_line,
-                                   scratch_pool));
+          SVN_ERR(source_seek(patch_file->source, &last_line, scratch_pool));
           break;
         }
       else if (state == state_git_tree_seen
@@ -2248,8 +2463,7 @@ svn_diff_parse_next_patch(svn_patch_t **patch_p,
            *
            * Rewind to the start of the line just read - it may be a new
            * header that begins there. */
-          SVN_ERR(svn_io_file_seek(patch_file->apr_file, APR_SET, &last_line,
-                                   scratch_pool));
+          SVN_ERR(source_seek(patch_file->source, &last_line, scratch_pool));
           state = state_start;
         }
 
@@ -2303,19 +2517,19 @@ svn_diff_parse_next_patch(svn_patch_t **patch_p,
     {
       if (state == state_binary_patch_found)
         {
-          SVN_ERR(parse_binary_patch(patch, patch_file->apr_file, reverse,
+          SVN_ERR(parse_binary_patch(patch, patch_file->source, reverse,
                                      result_pool, iterpool));
           /* And fall through in property parsing */
         }
 
-      SVN_ERR(parse_hunks(patch, patch_file->apr_file, ignore_whitespace,
+      SVN_ERR(parse_hunks(patch, patch_file->source, ignore_whitespace,
                           result_pool, iterpool));
     }
 
   svn_pool_destroy(iterpool);
 
-  SVN_ERR(svn_io_file_get_offset(&patch_file->next_patch_offset,
-                                 patch_file->apr_file, scratch_pool));
+  SVN_ERR(source_get_offset(&patch_file->next_patch_offset, patch_file->source,
+                            scratch_pool));
 
   if (patch && patch->hunks)
     {
@@ -2334,6 +2548,18 @@ svn_error_t *
 svn_diff_close_patch_file(svn_patch_file_t *patch_file,
                           apr_pool_t *scratch_pool)
 {
-  return svn_error_trace(svn_io_file_close(patch_file->apr_file,
+#if APR_HAS_MMAP
+  if (patch_file->source->mmap)
+    {
+      apr_status_t status = apr_mmap_delete(patch_file->source->mmap);
+
+      patch_file->source->mmap = NULL;
+      patch_file->source->data = NULL;
+      if (status)
+        return svn_error_wrap_apr(status, _("Failed to unmap patch file"));
+    }
+#endif
+
+  return svn_error_trace(svn_io_file_close(patch_file->source->apr_file,
                                            scratch_pool));
 }
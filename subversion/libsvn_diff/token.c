@@ -22,6 +22,8 @@
  */
 
 
+#include <string.h>
+
 #include <apr.h>
 #include <apr_pools.h>
 #include <apr_general.h>
@@ -34,27 +36,42 @@
 
 
 /*
- * Prime number to use as the size of the hash table.  This number was
- * not selected by testing of any kind and may need tweaking.
+ * Initial number of slots in the hash table.  Must be a power of two.
  */
-#define SVN_DIFF__HASH_SIZE 127
+#define SVN_DIFF__INITIAL_SLOTS 256
 
+/* A distinct token.  Its index in the tree's NODES array is the
+ * token index used by the positions. */
 struct svn_diff__node_t
 {
-  svn_diff__node_t       *parent;
-  svn_diff__node_t       *left;
-  svn_diff__node_t       *right;
-
   apr_uint32_t            hash;
-  svn_diff__token_index_t index;
   void                   *token;
 };
 
+/* A slot in the hash table. */
+typedef struct slot_t
+{
+  /* Hash of the token in this slot. */
+  apr_uint32_t            hash;
+
+  /* 1 + the index of the token in NODES, or 0 if the slot is empty. */
+  apr_uint32_t            node;
+} slot_t;
+
 struct svn_diff__tree_t
 {
-  svn_diff__node_t       *root[SVN_DIFF__HASH_SIZE];
-  apr_pool_t             *pool;
+  /* All distinct tokens in the order they were first seen.  NODE_COUNT
+   * elements of NODE_ALLOC are in use. */
+  svn_diff__node_t       *nodes;
+  svn_diff__token_index_t node_alloc;
   svn_diff__token_index_t node_count;
+
+  /* Open addressing hash table with linear probing over NODES, with
+   * 2^(32 - SLOT_SHIFT) slots.  At most half of them are in use. */
+  slot_t                 *slots;
+  int                     slot_shift;
+
+  apr_pool_t             *pool;
 };
 
 
@@ -74,35 +91,91 @@ svn_diff__get_node_count(svn_diff__tree_t *tree)
 void
 svn_diff__tree_create(svn_diff__tree_t **tree, apr_pool_t *pool)
 {
+  int shift = 32;
+  apr_uint32_t slots;
+
+  for (slots = SVN_DIFF__INITIAL_SLOTS; slots > 1; slots >>= 1)
+    --shift;
+
   *tree = apr_pcalloc(pool, sizeof(**tree));
   (*tree)->pool = pool;
   (*tree)->node_count = 0;
+  (*tree)->node_alloc = SVN_DIFF__INITIAL_SLOTS / 2;
+  (*tree)->nodes = apr_palloc(pool, (*tree)->node_alloc
+                                    * sizeof(*(*tree)->nodes));
+  (*tree)->slots = apr_pcalloc(pool, SVN_DIFF__INITIAL_SLOTS
+                                     * sizeof(*(*tree)->slots));
+  (*tree)->slot_shift = shift;
 }
 
+/* Return the first slot to probe for HASH in TREE.  Spread the hash
+ * values over the table by Fibonacci hashing because the low bits of
+ * the Adler-32 checksums used by the datasources vary little. */
+static APR_INLINE apr_uint32_t
+first_slot(const svn_diff__tree_t *tree, apr_uint32_t hash)
+{
+  return (apr_uint32_t)(hash * 0x9e3779b1U) >> tree->slot_shift;
+}
+
+/* Double the number of slots in TREE and re-insert all nodes. */
+static void
+grow_slots(svn_diff__tree_t *tree)
+{
+  apr_uint32_t mask;
+  svn_diff__token_index_t i;
+
+  tree->slot_shift--;
+  mask = 0xffffffffU >> tree->slot_shift;
+  tree->slots = apr_pcalloc(tree->pool, ((apr_size_t)mask + 1)
+                                        * sizeof(*tree->slots));
+
+  for (i = 0; i < tree->node_count; i++)
+    {
+      apr_uint32_t hash = tree->nodes[i].hash;
+      apr_uint32_t s = first_slot(tree, hash);
+
+      while (tree->slots[s].node)
+        s = (s + 1) & mask;
+
+      tree->slots[s].hash = hash;
+      tree->slots[s].node = (apr_uint32_t)i + 1;
+    }
+}
 
+/* Return in *INDEX the index of the token in TREE that is equal to TOKEN,
+ * as determined by VTABLE and DIFF_BATON.  If there is no such token, add
+ * TOKEN with the next index.  HASH is the hash value of TOKEN. */
 static svn_error_t *
-tree_insert_token(svn_diff__node_t **node, svn_diff__tree_t *tree,
+tree_insert_token(svn_diff__token_index_t *index, svn_diff__tree_t *tree,
                   void *diff_baton,
                   const svn_diff_fns2_t *vtable,
                   apr_uint32_t hash, void *token)
 {
-  svn_diff__node_t *new_node;
-  svn_diff__node_t **node_ref;
-  svn_diff__node_t *parent;
-  int rv;
+  svn_diff__node_t *node;
+  apr_uint32_t mask;
+  apr_uint32_t s;
 
   SVN_ERR_ASSERT(token);
 
-  parent = NULL;
-  node_ref = &tree->root[hash % SVN_DIFF__HASH_SIZE];
+  /* Keep at least half of the slots free so that probe sequences stay
+   * short and there is always an empty slot to stop at. */
+  mask = 0xffffffffU >> tree->slot_shift;
+  if (2 * ((apr_size_t)tree->node_count + 1) > (apr_size_t)mask + 1)
+    {
+      SVN_ERR_ASSERT(tree->slot_shift > 1);
+      grow_slots(tree);
+      mask = 0xffffffffU >> tree->slot_shift;
+    }
 
-  while (*node_ref != NULL)
+  for (s = first_slot(tree, hash); tree->slots[s].node; s = (s + 1) & mask)
     {
-      parent = *node_ref;
+      int rv;
 
-      rv = hash - parent->hash;
-      if (!rv)
-        SVN_ERR(vtable->token_compare(diff_baton, parent->token, token, &rv));
+      if (tree->slots[s].hash != hash)
+        continue;
+
+      node = &tree->nodes[tree->slots[s].node - 1];
+      SVN_ERR(vtable->token_compare(diff_baton, node->token, token, &rv));
 
       if (rv == 0)
         {
@@ -110,33 +183,33 @@ tree_insert_token(svn_diff__node_t **node, svn_diff__tree_t *tree,
            * only recently read tokens are still in memory.
            */
           if (vtable->token_discard != NULL)
-            vtable->token_discard(diff_baton, parent->token);
+            vtable->token_discard(diff_baton, node->token);
 
-          parent->token = token;
-          *node = parent;
+          node->token = token;
+          *index = tree->slots[s].node - 1;
 
           return SVN_NO_ERROR;
         }
-      else if (rv > 0)
-        {
-          node_ref = &parent->left;
-        }
-      else
-        {
-          node_ref = &parent->right;
-        }
     }
 
-  /* Create a new node */
-  new_node = apr_palloc(tree->pool, sizeof(*new_node));
-  new_node->parent = parent;
-  new_node->left = NULL;
-  new_node->right = NULL;
-  new_node->hash = hash;
-  new_node->token = token;
-  new_node->index = tree->node_count++;
+  /* Add a new node */
+  if (tree->node_count == tree->node_alloc)
+    {
+      svn_diff__node_t *nodes;
 
-  *node = *node_ref = new_node;
+      tree->node_alloc *= 2;
+      nodes = apr_palloc(tree->pool, tree->node_alloc * sizeof(*nodes));
+      memcpy(nodes, tree->nodes, tree->node_count * sizeof(*nodes));
+      tree->nodes = nodes;
+    }
+
+  node = &tree->nodes[tree->node_count];
+  node->hash = hash;
+  node->token = token;
+
+  tree->slots[s].hash = hash;
+  tree->slots[s].node = (apr_uint32_t)tree->node_count + 1;
+  *index = tree->node_count++;
 
   return SVN_NO_ERROR;
 }
@@ -158,7 +231,7 @@ svn_diff__get_tokens(svn_diff__position_t **position_list,
   svn_diff__position_t *start_position;
   svn_diff__position_t *position = NULL;
   svn_diff__position_t **position_ref;
-  svn_diff__node_t *node;
+  svn_diff__token_index_t index;
   void *token;
   apr_off_t offset;
   apr_uint32_t hash;
@@ -176,12 +249,13 @@ svn_diff__get_tokens(svn_diff__position_t **position_list,
         break;
 
       offset++;
-      SVN_ERR(tree_insert_token(&node, tree, diff_baton, vtable, hash, token));
+      SVN_ERR(tree_insert_token(&index, tree, diff_baton, vtable, hash,
+                                token));
 
       /* Create a new position */
       position = apr_palloc(pool, sizeof(*position));
       position->next = NULL;
-      position->token_index = node->index;
+      position->token_index = index;
       position->offset = offset;
 
       *position_ref = position;
@@ -49,6 +49,7 @@
 #include "private/svn_utf_private.h"
 #include "private/svn_mutex.h"
 #include "private/svn_subr_private.h"
+#include "private/svn_sorts_private.h"
 
 #include "fs-loader.h"
 
@@ -710,20 +711,22 @@ svn_fs_hotcopy3(const char *src_path, const char *dst_path,
 }
 
 svn_error_t *
-svn_fs_pack(const char *path,
-            svn_fs_pack_notify_t notify_func,
-            void *notify_baton,
-            svn_cancel_func_t cancel_func,
-            void *cancel_baton,
-            apr_pool_t *pool)
+svn_fs_pack2(const char *path,
+             int jobs,
+             apr_hash_t *fs_config,
+             svn_fs_pack_notify_t notify_func,
+             void *notify_baton,
+             svn_cancel_func_t cancel_func,
+             void *cancel_baton,
+             apr_pool_t *pool)
 {
   fs_library_vtable_t *vtable;
   svn_fs_t *fs;
 
   SVN_ERR(fs_library_vtable(&vtable, path, pool));
-  fs = fs_new(NULL, pool);
+  fs = fs_new(fs_config, pool);
 
-  SVN_ERR(vtable->pack_fs(fs, path, notify_func, notify_baton,
+  SVN_ERR(vtable->pack_fs(fs, path, jobs, notify_func, notify_baton,
                           cancel_func, cancel_baton, common_pool_lock,
                           pool, common_pool));
   return SVN_NO_ERROR;
@@ -767,6 +770,28 @@ svn_fs_freeze(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_build_rep_cache(svn_fs_t *fs,
+                       svn_revnum_t start_rev,
+                       svn_revnum_t end_rev,
+                       int jobs,
+                       svn_fs_progress_notify_func_t progress_func,
+                       void *progress_baton,
+                       svn_cancel_func_t cancel_func,
+                       void *cancel_baton,
+                       apr_pool_t *pool)
+{
+  if (fs->vtable->build_rep_cache == NULL)
+    return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                            _("The filesystem has no representation cache"));
+
+  return svn_error_trace(fs->vtable->build_rep_cache(fs, start_rev, end_rev,
+                                                     jobs, progress_func,
+                                                     progress_baton,
+                                                     cancel_func,
+                                                     cancel_baton, pool));
+}
+
 
 /* --- Berkeley-specific functions --- */
 
@@ -1438,6 +1463,46 @@ svn_fs_dir_entries(apr_hash_t **entries_p, svn_fs_root_t *root,
                                                    pool));
 }
 
+/* Implements svn_sort__array's comparison function for svn_fs_dirent_t *,
+   ordering them like svn_sort_compare_items_lexically() orders names. */
+static int
+compare_dirents_by_name(const void *a,
+                        const void *b)
+{
+  const svn_fs_dirent_t *lhs = *(const svn_fs_dirent_t * const *)a;
+  const svn_fs_dirent_t *rhs = *(const svn_fs_dirent_t * const *)b;
+
+  return strcmp(lhs->name, rhs->name);
+}
+
+svn_error_t *
+svn_fs_dir_entries_sorted(apr_array_header_t **entries_p,
+                          svn_fs_root_t *root,
+                          const char *path,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
+{
+  apr_hash_t *entries;
+  apr_hash_index_t *hi;
+
+  if (root->vtable->dir_entries_sorted)
+    return svn_error_trace(root->vtable->dir_entries_sorted(entries_p, root,
+                                                            path,
+                                                            result_pool,
+                                                            scratch_pool));
+
+  /* Back-ends without sorted directories get the hash sorted here. */
+  SVN_ERR(root->vtable->dir_entries(&entries, root, path, result_pool));
+  *entries_p = apr_array_make(result_pool, apr_hash_count(entries),
+                              sizeof(svn_fs_dirent_t *));
+  for (hi = apr_hash_first(scratch_pool, entries); hi; hi = apr_hash_next(hi))
+    APR_ARRAY_PUSH(*entries_p, svn_fs_dirent_t *) = apr_hash_this_val(hi);
+
+  svn_sort__array(*entries_p, compare_dirents_by_name);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_dir_optimal_order(apr_array_header_t **ordered_p,
                          svn_fs_root_t *root,
@@ -1540,6 +1605,24 @@ svn_fs_try_process_file_contents(svn_boolean_t *success,
                          processor, baton, pool));
 }
 
+svn_error_t *
+svn_fs__file_contents_location(const char **file_path,
+                               apr_off_t *offset,
+                               svn_filesize_t *length,
+                               svn_fs_root_t *root,
+                               const char *path,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool)
+{
+  *file_path = NULL;
+  if (root->vtable->file_contents_location == NULL)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(root->vtable->file_contents_location(
+                         file_path, offset, length, root, path,
+                         result_pool, scratch_pool));
+}
+
 svn_error_t *
 svn_fs_make_file(svn_fs_root_t *root, const char *path, apr_pool_t *pool)
 {
@@ -1547,6 +1630,36 @@ svn_fs_make_file(svn_fs_root_t *root, const char *path, apr_pool_t *pool)
   return svn_error_trace(root->vtable->make_file(root, path, pool));
 }
 
+svn_error_t *
+svn_fs_make_files(svn_fs_root_t *root,
+                  const apr_array_header_t *paths,
+                  apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool;
+  int i;
+
+  for (i = 0; i < paths->nelts; ++i)
+    SVN_ERR(svn_fs__path_valid(APR_ARRAY_IDX(paths, i, const char *),
+                               scratch_pool));
+
+  if (root->vtable->make_files)
+    return svn_error_trace(root->vtable->make_files(root, paths,
+                                                    scratch_pool));
+
+  /* Back-ends without batch support create one file at a time. */
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(root->vtable->make_file(root,
+                                      APR_ARRAY_IDX(paths, i, const char *),
+                                      iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_apply_textdelta(svn_txdelta_window_handler_t *contents_p,
                        void **contents_baton_p, svn_fs_root_t *root,
@@ -1704,6 +1817,44 @@ svn_fs_get_file_delta_stream(svn_txdelta_stream_t **stream_p,
                            target_root, target_path, pool));
 }
 
+svn_error_t *
+svn_fs__get_changed_revisions(apr_array_header_t **revisions,
+                              svn_fs_t *fs,
+                              const char *path,
+                              svn_revnum_t start,
+                              svn_revnum_t end,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool)
+{
+  *revisions = NULL;
+  if (fs->vtable->changed_revisions == NULL)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(fs->vtable->changed_revisions(revisions, fs, path,
+                                                       start, end,
+                                                       result_pool,
+                                                       scratch_pool));
+}
+
+svn_error_t *
+svn_fs__get_revision_files(apr_array_header_t **files,
+                           svn_revnum_t *start_rev,
+                           svn_revnum_t *end_rev,
+                           svn_fs_t *fs,
+                           svn_revnum_t rev,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool)
+{
+  *files = NULL;
+  if (fs->vtable->revision_files == NULL)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(fs->vtable->revision_files(files, start_rev,
+                                                    end_rev, fs, rev,
+                                                    result_pool,
+                                                    scratch_pool));
+}
+
 svn_error_t *
 svn_fs__get_deleted_node(svn_fs_root_t **node_root,
                          const char **node_path,
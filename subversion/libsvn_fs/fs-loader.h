@@ -129,7 +129,7 @@ typedef struct fs_library_vtable_t
   svn_error_t *(*recover)(svn_fs_t *fs,
                           svn_cancel_func_t cancel_func, void *cancel_baton,
                           apr_pool_t *pool);
-  svn_error_t *(*pack_fs)(svn_fs_t *fs, const char *path,
+  svn_error_t *(*pack_fs)(svn_fs_t *fs, const char *path, int jobs,
                           svn_fs_pack_notify_t notify_func, void *notify_baton,
                           svn_cancel_func_t cancel_func, void *cancel_baton,
                           svn_mutex__t *common_pool_lock,
@@ -266,6 +266,33 @@ typedef struct fs_vtable_t
   svn_error_t *(*bdb_set_errcall)(svn_fs_t *fs,
                                   void (*handler)(const char *errpfx,
                                                   char *msg));
+  /* May be NULL if the backend has no changed paths index. */
+  svn_error_t *(*changed_revisions)(apr_array_header_t **revisions,
+                                    svn_fs_t *fs,
+                                    const char *path,
+                                    svn_revnum_t start,
+                                    svn_revnum_t end,
+                                    apr_pool_t *result_pool,
+                                    apr_pool_t *scratch_pool);
+  /* May be NULL if the backend cannot tell in which files it stores
+     revisions. */
+  svn_error_t *(*revision_files)(apr_array_header_t **files,
+                                 svn_revnum_t *start_rev,
+                                 svn_revnum_t *end_rev,
+                                 svn_fs_t *fs,
+                                 svn_revnum_t rev,
+                                 apr_pool_t *result_pool,
+                                 apr_pool_t *scratch_pool);
+  /* May be NULL if the backend has no rep-cache. */
+  svn_error_t *(*build_rep_cache)(svn_fs_t *fs,
+                                  svn_revnum_t start_rev,
+                                  svn_revnum_t end_rev,
+                                  int jobs,
+                                  svn_fs_progress_notify_func_t progress_func,
+                                  void *progress_baton,
+                                  svn_cancel_func_t cancel_func,
+                                  void *cancel_baton,
+                                  apr_pool_t *pool);
 } fs_vtable_t;
 
 
@@ -364,6 +391,11 @@ typedef struct root_vtable_t
   /* Directories */
   svn_error_t *(*dir_entries)(apr_hash_t **entries_p, svn_fs_root_t *root,
                               const char *path, apr_pool_t *pool);
+  svn_error_t *(*dir_entries_sorted)(apr_array_header_t **entries_p,
+                                     svn_fs_root_t *root,
+                                     const char *path,
+                                     apr_pool_t *result_pool,
+                                     apr_pool_t *scratch_pool);
   svn_error_t *(*dir_optimal_order)(apr_array_header_t **ordered_p,
                                     svn_fs_root_t *root,
                                     apr_hash_t *entries,
@@ -387,8 +419,18 @@ typedef struct root_vtable_t
                                             svn_fs_process_contents_func_t processor,
                                             void* baton,
                                             apr_pool_t *pool);
+  svn_error_t *(*file_contents_location)(const char **file_path,
+                                         apr_off_t *offset,
+                                         svn_filesize_t *length,
+                                         svn_fs_root_t *root,
+                                         const char *path,
+                                         apr_pool_t *result_pool,
+                                         apr_pool_t *scratch_pool);
   svn_error_t *(*make_file)(svn_fs_root_t *root, const char *path,
                             apr_pool_t *pool);
+  svn_error_t *(*make_files)(svn_fs_root_t *root,
+                             const apr_array_header_t *paths,
+                             apr_pool_t *pool);
   svn_error_t *(*apply_textdelta)(svn_txdelta_window_handler_t *contents_p,
                                   void **contents_baton_p,
                                   svn_fs_root_t *root, const char *path,
@@ -574,6 +574,9 @@ static fs_vtable_t fs_vtable = {
   base_bdb_verify_root,
   base_bdb_freeze,
   base_bdb_set_errcall,
+  NULL /* changed_revisions */,
+  NULL /* revision_files */,
+  NULL /* build_rep_cache */
 };
 
 /* Where the format number is stored. */
@@ -1023,6 +1026,7 @@ base_bdb_recover(svn_fs_t *fs,
 static svn_error_t *
 base_bdb_pack(svn_fs_t *fs,
               const char *path,
+              int jobs,
               svn_fs_pack_notify_t notify_func,
               void *notify_baton,
               svn_cancel_func_t cancel,
@@ -21,10 +21,13 @@
  */
 
 #include <assert.h>
+#include <string.h>
 
 #include "svn_fs.h"
 #include "svn_pools.h"
 
+#include "private/svn_delta_private.h"
+
 #include "fs.h"
 #include "err.h"
 #include "trail.h"
@@ -161,6 +164,13 @@ struct compose_handler_baton
   svn_txdelta_window_t *window;
   apr_pool_t *window_pool;
 
+  /* Pool for the next combined window.  It swaps roles with WINDOW_POOL
+     after each combination. */
+  apr_pool_t *spare_pool;
+
+  /* Buffers for the window combiner, reused for all windows. */
+  svn_txdelta__compose_ctx_t *compose_ctx;
+
   /* If the incoming window was self-compressed, and the combined WINDOW
      exists from previous iterations, SOURCE_BUF will point to the
      expanded self-compressed window. */
@@ -218,12 +228,18 @@ compose_handler(svn_txdelta_window_t *window, void *baton)
       else
         {
           /* Combine the incoming window with whatever's in the baton. */
-          apr_pool_t *composite_pool = svn_pool_create(cb->trail->pool);
+          apr_pool_t *composite_pool = cb->spare_pool;
           svn_txdelta_window_t *composite;
 
-          composite = svn_txdelta_compose_windows(window, cb->window,
-                                                  composite_pool);
-          svn_pool_destroy(cb->window_pool);
+          if (composite_pool)
+            svn_pool_clear(composite_pool);
+          else
+            composite_pool = svn_pool_create(cb->trail->pool);
+
+          composite = svn_txdelta__compose_windows(cb->compose_ctx,
+                                                   window, cb->window,
+                                                   composite_pool);
+          cb->spare_pool = cb->window_pool;
           cb->window = composite;
           cb->window_pool = composite_pool;
           cb->done = (composite->sview_len == 0 || composite->src_ops == 0);
@@ -333,6 +349,9 @@ rep_undeltify_range(svn_fs_t *fs,
                     apr_pool_t *pool)
 {
   apr_size_t len_read = 0;
+  apr_pool_t *compose_pool = svn_pool_create(pool);
+  svn_txdelta__compose_ctx_t *compose_ctx
+    = svn_txdelta__compose_ctx_create(compose_pool);
 
   do
     {
@@ -342,6 +361,7 @@ rep_undeltify_range(svn_fs_t *fs,
       int cur_rep;
 
       cb.trail = trail;
+      cb.compose_ctx = compose_ctx;
       cb.done = FALSE;
       for (cur_rep = 0; !cb.done && cur_rep < deltas->nelts; ++cur_rep)
         {
@@ -406,6 +426,8 @@ rep_undeltify_range(svn_fs_t *fs,
         }
       /* Don't need this window any more. */
       svn_pool_destroy(cb.window_pool);
+      if (cb.spare_pool)
+        svn_pool_destroy(cb.spare_pool);
 
       len_read += target_len;
       buf += target_len;
@@ -413,6 +435,8 @@ rep_undeltify_range(svn_fs_t *fs,
     }
   while (len_read < *len);
 
+  svn_pool_destroy(compose_pool);
+
   *len = len_read;
   return SVN_NO_ERROR;
 }
@@ -618,6 +642,13 @@ svn_fs_base__delete_rep_if_mutable(svn_fs_t *fs,
 
 /** Reading. **/
 
+/* Streams that read outside of a trail fetch up to this many bytes per
+   trail and hand them out from a buffer.  Every trail has to begin a
+   Berkeley DB transaction and re-fetch the rep skel, so reading in
+   SVN__STREAM_CHUNK_SIZE pieces would spend most of its time on that
+   instead of on copying string records. */
+#define READ_AHEAD_SIZE (16 * SVN__STREAM_CHUNK_SIZE)
+
 struct rep_read_baton
 {
   /* The FS from which we're reading. */
@@ -673,6 +704,16 @@ struct rep_read_baton
      is digestified. */
   svn_boolean_t checksum_finalized;
 
+  /* Read-ahead buffer for reads that are not done as part of a trail.
+     OFFSET already accounts for all of its READ_AHEAD_LEN bytes, of which
+     the first READ_AHEAD_POS have been handed out.  NULL until needed. */
+  char *read_ahead_buf;
+  apr_size_t read_ahead_len;
+  apr_size_t read_ahead_pos;
+
+  /* Pool for the read-ahead buffer; the pool the baton lives in. */
+  apr_pool_t *pool;
+
   /* Used for temporary allocations.  This pool is cleared at the
      start of each invocation of the relevant stream read function --
      see rep_read_contents().  */
@@ -705,6 +746,7 @@ rep_read_get_baton(struct rep_read_baton **rb_p,
   b->fs = fs;
   b->trail = use_trail_for_reads ? trail : NULL;
   b->scratch_pool = svn_pool_create(pool);
+  b->pool = pool;
   b->rep_key = rep_key;
   b->offset = 0;
 
@@ -969,16 +1011,72 @@ rep_read_contents(void *baton, char *buf, apr_size_t *len)
     SVN_ERR(txn_body_read_rep(&args, rb->trail));
   else
     {
-      /* In the case of reading from the db, any returned data should
-         live in our pre-allocated buffer, so the whole operation can
-         happen within a single malloc/free cycle.  This prevents us
-         from creating millions of unnecessary trail subpools when
-         reading a big file.  */
-      SVN_ERR(svn_fs_base__retry_txn(rb->fs,
-                                     txn_body_read_rep,
-                                     &args,
-                                     TRUE,
-                                     rb->scratch_pool));
+      apr_size_t requested = *len;
+      apr_size_t copied = 0;
+
+      while (copied < requested)
+        {
+          apr_size_t available = rb->read_ahead_len - rb->read_ahead_pos;
+          apr_size_t to_copy;
+
+          /* Refill the buffer with the next section of the contents.
+             Any returned data lives in our pre-allocated buffer, so
+             the whole operation can happen within a single malloc/free
+             cycle.  This prevents us from creating millions of
+             unnecessary trail subpools when reading a big file.  */
+          if (available == 0)
+            {
+              apr_size_t read_ahead_len = READ_AHEAD_SIZE;
+
+              if (rb->size - rb->offset < read_ahead_len)
+                read_ahead_len = (apr_size_t)(rb->size - rb->offset);
+
+              /* At the end of the contents, let the trail handle
+                 null reps and repeated reads of 0 bytes. */
+              if (read_ahead_len == 0)
+                {
+                  apr_size_t remaining = requested - copied;
+
+                  args.buf = buf + copied;
+                  args.len = &remaining;
+                  SVN_ERR(svn_fs_base__retry_txn(rb->fs,
+                                                 txn_body_read_rep,
+                                                 &args, TRUE,
+                                                 rb->scratch_pool));
+                  copied += remaining;
+                  break;
+                }
+
+              if (! rb->read_ahead_buf)
+                rb->read_ahead_buf = apr_palloc(rb->pool, read_ahead_len);
+
+              args.buf = rb->read_ahead_buf;
+              args.len = &read_ahead_len;
+              SVN_ERR(svn_fs_base__retry_txn(rb->fs,
+                                             txn_body_read_rep,
+                                             &args, TRUE,
+                                             rb->scratch_pool));
+
+              rb->read_ahead_len = read_ahead_len;
+              rb->read_ahead_pos = 0;
+              available = read_ahead_len;
+
+              /* Short read: the contents ended early. */
+              if (available == 0)
+                break;
+            }
+
+          to_copy = requested - copied;
+          if (to_copy > available)
+            to_copy = available;
+
+          memcpy(buf + copied, rb->read_ahead_buf + rb->read_ahead_pos,
+                 to_copy);
+          rb->read_ahead_pos += to_copy;
+          copied += to_copy;
+        }
+
+      *len = copied;
     }
   return SVN_NO_ERROR;
 }
@@ -5525,13 +5525,16 @@ static root_vtable_t root_vtable = {
   base_change_node_prop,
   base_props_changed,
   base_dir_entries,
+  NULL,
   base_dir_optimal_order,
   base_make_dir,
   base_file_length,
   base_file_checksum,
   base_file_contents,
   NULL,
+  NULL,
   base_make_file,
+  NULL,
   base_apply_textdelta,
   base_apply_text,
   base_contents_changed,
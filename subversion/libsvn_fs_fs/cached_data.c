@@ -24,11 +24,18 @@
 
 #include <assert.h>
 
+#include <apr_thread_proc.h>
+#include <apr_thread_cond.h>
+
 #include "svn_hash.h"
 #include "svn_ctype.h"
 #include "svn_sorts.h"
+#include "svn_cache_config.h"
+#include "private/svn_atomic.h"
 #include "private/svn_delta_private.h"
 #include "private/svn_io_private.h"
+#include "private/svn_mutex.h"
+#include "private/svn_probes.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_temp_serializer.h"
@@ -40,6 +47,7 @@
 #include "pack.h"
 #include "util.h"
 #include "temp_serializer.h"
+#include "transaction.h"
 
 #include "../libsvn_fs/fs-loader.h"
 #include "../libsvn_delta/delta.h"  /* for SVN_DELTA_WINDOW_SIZE */
@@ -245,10 +253,34 @@ open_and_seek_transaction(svn_fs_fs__revision_file_t **file,
 {
   apr_off_t offset;
 
-  SVN_ERR(svn_fs_fs__open_proto_rev_file(file, fs, &rep->txn_id, pool, pool));
-
   SVN_ERR(svn_fs_fs__item_offset(&offset, fs, NULL, SVN_INVALID_REVNUM,
                                  &rep->txn_id, rep->item_index, pool));
+
+  /* Not in the proto-rev, yet?  Then, it is still in a pending fragment.
+     That fragment may get merged before we can open it, though. */
+  if (offset == -1 && svn_fs_fs__use_log_addressing(fs))
+    {
+      const char *path;
+      svn_error_t *err;
+
+      SVN_ERR(svn_fs_fs__find_txn_fragment(&path, fs, &rep->txn_id,
+                                           rep->item_index, pool, pool));
+      if (path)
+        {
+          err = svn_fs_fs__open_proto_rev_fragment(file, path, pool);
+          if (!err)
+            return SVN_NO_ERROR;
+          if (!APR_STATUS_IS_ENOENT(err->apr_err))
+            return svn_error_trace(err);
+
+          svn_error_clear(err);
+        }
+
+      SVN_ERR(svn_fs_fs__item_offset(&offset, fs, NULL, SVN_INVALID_REVNUM,
+                                     &rep->txn_id, rep->item_index, pool));
+    }
+
+  SVN_ERR(svn_fs_fs__open_proto_rev_file(file, fs, &rep->txn_id, pool, pool));
   SVN_ERR(aligned_seek(fs, (*file)->file, NULL, offset, pool));
 
   return SVN_NO_ERROR;
@@ -533,6 +565,79 @@ svn_fs_fs__get_node_revision(node_revision_t **noderev_p,
   return svn_error_trace(err);
 }
 
+svn_error_t *
+svn_fs_fs__get_predecessor(node_revision_t **predecessor_p,
+                           svn_fs_t *fs,
+                           node_revision_t *noderev,
+                           int count,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  SVN_ERR_ASSERT(count >= 0 && count <= noderev->predecessor_count);
+  while (noderev->predecessor_count > count)
+    {
+      /* Like skip-deltas, skip links clear the lowest set bit of the
+         predecessor count.  Take them as long as we don't overshoot. */
+      int skip_count
+        = noderev->predecessor_count & (noderev->predecessor_count - 1);
+      const svn_fs_id_t *next_id
+        = (noderev->skip_id && skip_count >= count)
+        ? noderev->skip_id
+        : noderev->predecessor_id;
+
+      if (next_id == NULL)
+        return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                                 _("Missing predecessor of node-rev '%s'"),
+                                 svn_fs_fs__id_unparse(noderev->id,
+                                                       scratch_pool)->data);
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, next_id,
+                                           result_pool, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  *predecessor_p = noderev;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__get_mergeinfo_count(apr_int64_t *count,
+                               svn_fs_t *fs,
+                               const svn_fs_id_t *id,
+                               apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  node_revision_t *noderev;
+
+  /* Avoid deserializing the whole noderev if it has been cached. */
+  if (ffd->node_revision_cache && !svn_fs_fs__id_is_txn(id))
+    {
+      const svn_fs_fs__id_part_t *rev_item = svn_fs_fs__id_rev_item(id);
+      pair_cache_key_t key = { 0 };
+      svn_boolean_t is_cached;
+
+      key.revision = rev_item->revision;
+      key.second = rev_item->number;
+
+      SVN_ERR(svn_cache__get_partial((void **)count, &is_cached,
+                                     ffd->node_revision_cache, &key,
+                                     svn_fs_fs__get_noderev_mergeinfo_count,
+                                     NULL, scratch_pool));
+      if (is_cached)
+        return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, id, scratch_pool,
+                                       scratch_pool));
+  *count = noderev->mergeinfo_count;
+
+  return SVN_NO_ERROR;
+}
+
 
 /* Given a revision file REV_FILE, opened to REV in FS, find the Node-ID
    of the header located at OFFSET and store it in *ID_P.  Allocate
@@ -1221,6 +1326,10 @@ struct rep_read_baton
      window stream before we continue normal operation. */
   svn_filesize_t fulltext_delivered;
 
+  /* Set once the caller skipped parts of the contents.  We can then
+     neither verify the checksum nor cache the fulltext anymore. */
+  svn_boolean_t skipped;
+
   /* Used for temporary allocations during the read. */
   apr_pool_t *pool;
 
@@ -1268,8 +1377,8 @@ parse_raw_window(void **out,
   stream = svn_stream_from_string(&raw_window, result_pool);
 
   /* parse it */
-  SVN_ERR(svn_txdelta_read_svndiff_window(&result->window, stream, 1,
-                                          result_pool));
+  SVN_ERR(svn_txdelta_read_svndiff_window(&result->window, stream,
+                                          window->ver, result_pool));
 
   /* complete the window and return it */
   result->end_offset = window->end_offset;
@@ -1532,6 +1641,7 @@ rep_read_get_baton(struct rep_read_baton **rb_p,
   b->filehandle_pool = svn_pool_create(pool);
   b->fulltext_cache = NULL;
   b->fulltext_delivered = 0;
+  b->skipped = FALSE;
   b->current_fulltext = NULL;
 
   /* Save our output baton. */
@@ -1678,7 +1788,7 @@ static svn_error_t *
 get_combined_window(svn_stringbuf_t **result,
                     struct rep_read_baton *rb)
 {
-  apr_pool_t *pool, *new_pool, *window_pool;
+  apr_pool_t *pool, *new_pool, *spare_pool = NULL, *window_pool;
   int i;
   apr_array_header_t *windows;
   svn_stringbuf_t *source, *buf = rb->base_window;
@@ -1741,8 +1851,18 @@ get_combined_window(svn_stringbuf_t **result,
             SVN_ERR(skip_plain_window(rb->src_state, window->sview_len));
         }
 
-      /* Combine this window with the current one. */
-      new_pool = svn_pool_create(rb->pool);
+      /* Combine this window with the current one.  Reuse the pool of
+         the window before the previous one, which nobody refers to now. */
+      if (spare_pool)
+        {
+          new_pool = spare_pool;
+          svn_pool_clear(new_pool);
+        }
+      else
+        {
+          new_pool = svn_pool_create(rb->pool);
+        }
+
       buf = svn_stringbuf_create_ensure(window->tview_len, new_pool);
       buf->len = window->tview_len;
 
@@ -1763,10 +1883,12 @@ get_combined_window(svn_stringbuf_t **result,
       rs->chunk_index++;
 
       /* Cycle pools so that we only need to hold three windows at a time. */
-      svn_pool_destroy(pool);
+      spare_pool = pool;
       pool = new_pool;
     }
   svn_pool_destroy(iterpool);
+  if (spare_pool)
+    svn_pool_destroy(spare_pool);
 
   svn_pool_destroy(window_pool);
 
@@ -2018,6 +2140,129 @@ optimimal_allocation_size(apr_size_t needed)
   return optimal - overhead;
 }
 
+/* Read the header of the next delta window in RS and return the size of
+ * its target view in *TVIEW_LEN and the size of the raw window data in
+ * *WINDOW_LEN.  This does not advance RS beyond that window.  Use
+ * SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+read_delta_window_sizes(apr_size_t *tview_len,
+                        apr_size_t *window_len,
+                        rep_state_t *rs,
+                        apr_pool_t *scratch_pool)
+{
+  SVN_ERR(auto_open_shared_file(rs->sfile));
+  SVN_ERR(auto_set_start_offset(rs, scratch_pool));
+  SVN_ERR(auto_read_diff_version(rs, scratch_pool));
+
+  SVN_ERR(rs_aligned_seek(rs, NULL, rs->start + rs->current, scratch_pool));
+  SVN_ERR(svn_txdelta__read_raw_window_sizes(tview_len, window_len,
+                                             rs->sfile->rfile->stream,
+                                             scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Advance the window stream in BATON by LEN bytes or to the end of the
+ * representation, whichever comes first.
+ *
+ * Delta windows that lie completely within the skipped range are stepped
+ * over by reading their headers only.  Only the window that contains the
+ * new read position needs to be reconstructed.
+ */
+static svn_error_t *
+skip_windows(struct rep_read_baton *baton,
+             svn_filesize_t len)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+  rep_state_t *rs;
+
+  /* Plain texts can simply be skipped. */
+  if (baton->rs_list->nelts == 0)
+    {
+      rs = baton->src_state;
+      if (len > rs->size - rs->current)
+        len = rs->size - rs->current;
+
+      rs->current += (apr_off_t)len;
+      return SVN_NO_ERROR;
+    }
+
+  /* Drop the data that we already reconstructed. */
+  if (baton->buf)
+    {
+      apr_size_t buffered = baton->buf_len - baton->buf_pos;
+      if (len < buffered)
+        {
+          baton->buf_pos += (apr_size_t)len;
+          return SVN_NO_ERROR;
+        }
+
+      len -= buffered;
+      svn_pool_clear(baton->pool);
+      baton->buf = NULL;
+    }
+
+  /* Step over whole windows.  The other reps in the delta chain will
+   * catch up with the chunk index in read_delta_window().  A PLAIN base
+   * rep, however, is being read in lockstep with the windows that we
+   * combine, i.e. we would need to parse all windows in the chain to
+   * know how far to skip in the base.  Don't do that. */
+  rs = APR_ARRAY_IDX(baton->rs_list, 0, rep_state_t *);
+  if (baton->src_state == NULL || baton->base_window != NULL)
+    {
+      apr_pool_t *iterpool = svn_pool_create(baton->pool);
+      while (len > 0 && rs->current < rs->size)
+        {
+          apr_size_t tview_len, window_len;
+
+          svn_pool_clear(iterpool);
+          SVN_ERR(read_delta_window_sizes(&tview_len, &window_len, rs,
+                                          iterpool));
+          if (tview_len > len)
+            break;
+
+          rs->current += window_len;
+          if (rs->current > rs->size)
+            return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                                    _("Reading one svndiff window read "
+                                      "beyond the end of the "
+                                      "representation"));
+
+          rs->chunk_index++;
+          baton->chunk_index++;
+          len -= tview_len;
+        }
+      svn_pool_destroy(iterpool);
+    }
+
+  /* Drain the remaining LEN bytes from the window stream.  Note that
+   * reading from it may clear BATON->POOL. */
+  if (len > 0)
+    {
+      apr_pool_t *subpool = svn_pool_create(baton->filehandle_pool);
+      char *buffer = apr_palloc(subpool, SVN__STREAM_CHUNK_SIZE);
+
+      while (len > 0 && !err)
+        {
+          apr_size_t to_read = len > SVN__STREAM_CHUNK_SIZE
+                            ? SVN__STREAM_CHUNK_SIZE
+                            : (apr_size_t)len;
+
+          err = get_contents_from_windows(baton, buffer, &to_read);
+          len -= to_read;
+
+          /* End of representation? */
+          if (to_read == 0)
+            break;
+        }
+
+      svn_pool_destroy(subpool);
+    }
+
+  return svn_error_trace(err);
+}
+
 /* After a fulltext cache lookup failure, we will continue to read from
  * combined delta or plain windows.  However, we must first make that data
  * stream in BATON catch up tho the position LEN already delivered from the
@@ -2031,7 +2276,8 @@ skip_contents(struct rep_read_baton *baton,
   svn_error_t *err = SVN_NO_ERROR;
 
   /* Do we want to cache the reconstructed fulltext? */
-  if (SVN_IS_VALID_REVNUM(baton->fulltext_cache_key.revision))
+  if (   SVN_IS_VALID_REVNUM(baton->fulltext_cache_key.revision)
+      && !baton->skipped)
     {
       char *buffer;
       svn_filesize_t to_alloc = MAX(len, baton->len);
@@ -2061,21 +2307,8 @@ skip_contents(struct rep_read_baton *baton,
     }
   else if (len > 0)
     {
-      /* Simply drain LEN bytes from the window stream. */
-      apr_pool_t *subpool = svn_pool_create(baton->pool);
-      char *buffer = apr_palloc(subpool, SVN__STREAM_CHUNK_SIZE);
-
-      while (len > 0 && !err)
-        {
-          apr_size_t to_read = len > SVN__STREAM_CHUNK_SIZE
-                            ? SVN__STREAM_CHUNK_SIZE
-                            : (apr_size_t)len;
-
-          err = get_contents_from_windows(baton, buffer, &to_read);
-          len -= to_read;
-        }
-
-      svn_pool_destroy(subpool);
+      /* Simply move LEN bytes ahead in the window stream. */
+      err = skip_windows(baton, len);
     }
 
   return svn_error_trace(err);
@@ -2163,6 +2396,37 @@ rep_read_contents(void *baton,
   return SVN_NO_ERROR;
 }
 
+/* BATON is of type `rep_read_baton'; skip the next LEN bytes of the
+   representation.  Since we won't see all of the data anymore, this
+   disables checksum verification and fulltext caching for the stream. */
+static svn_error_t *
+rep_read_skip(void *baton,
+              apr_size_t len)
+{
+  struct rep_read_baton *rb = baton;
+
+  if (len == 0)
+    return SVN_NO_ERROR;
+
+  rb->skipped = TRUE;
+  rb->checksum_finalized = TRUE;
+  rb->current_fulltext = NULL;
+
+  /* As long as we read from the fulltext cache or did not start reading
+     from the window stream, yet, simply move the start position ahead.
+     The window stream will catch up upon the first cache miss. */
+  if (rb->fulltext_cache || !rb->rs_list)
+    {
+      rb->fulltext_delivered += len;
+      if (rb->fulltext_delivered > rb->len)
+        rb->fulltext_delivered = rb->len;
+
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(skip_windows(rb, len));
+}
+
 svn_error_t *
 svn_fs_fs__get_contents(svn_stream_t **contents_p,
                         svn_fs_t *fs,
@@ -2203,9 +2467,13 @@ svn_fs_fs__get_contents(svn_stream_t **contents_p,
           rb->fulltext_cache_key.revision = SVN_INVALID_REVNUM;
         }
 
+      SVN_PROBE3(fsfs__get_contents, rep->revision, rep->item_index,
+                 rep->expanded_size);
+
       *contents_p = svn_stream_create(rb, pool);
       svn_stream_set_read2(*contents_p, NULL /* only full read support */,
                            rep_read_contents);
+      svn_stream_set_skip(*contents_p, rep_read_skip);
       svn_stream_set_close(*contents_p, rep_read_contents_close);
     }
 
@@ -2281,6 +2549,50 @@ svn_fs_fs__try_process_file_contents(svn_boolean_t *success,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__get_contents_location(const char **file_path,
+                                 apr_off_t *offset,
+                                 svn_filesize_t *length,
+                                 svn_fs_t *fs,
+                                 representation_t *rep,
+                                 apr_pool_t *result_pool,
+                                 apr_pool_t *scratch_pool)
+{
+  svn_fs_fs__revision_file_t *rev_file;
+  svn_fs_fs__rep_header_t *rep_header;
+  apr_off_t item_offset = -1;
+  const char *name;
+
+  *file_path = NULL;
+
+  /* Data in transactions may still change and lives in a different file. */
+  if (!rep || svn_fs_fs__id_txn_used(&rep->txn_id))
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_fs__ensure_revision_exists(rep->revision, fs,
+                                            scratch_pool));
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, rep->revision,
+                                           scratch_pool, scratch_pool));
+  SVN_ERR(svn_fs_fs__item_offset(&item_offset, fs, rev_file, rep->revision,
+                                 NULL, rep->item_index, scratch_pool));
+  SVN_ERR(aligned_seek(fs, rev_file->file, NULL, item_offset, scratch_pool));
+  SVN_ERR(svn_fs_fs__read_rep_header(&rep_header, rev_file->stream,
+                                     scratch_pool, scratch_pool));
+
+  /* Only PLAIN reps contain the fulltext as is. */
+  if (rep_header->type == svn_fs_fs__rep_plain)
+    {
+      SVN_ERR(svn_io_file_name_get(&name, rev_file->file, scratch_pool));
+      *file_path = apr_pstrdup(result_pool, name);
+      *offset = item_offset + rep_header->header_size;
+      *length = rep->size;
+    }
+
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+
+  return SVN_NO_ERROR;
+}
+
 
 /* Baton used when reading delta windows. */
 struct delta_read_baton
@@ -2697,6 +3009,190 @@ locate_dir_cache(svn_fs_t *fs,
     }
 }
 
+/* Directories that are too large to be cached as a whole get cached in
+ * chunks of that many entries.  Lookups then only need to deserialize the
+ * index and a single chunk instead of re-reading the whole directory.
+ */
+#define DIR_CHUNK_SIZE 1024
+
+/* Chunk number of the chunk index in the dir chunk cache. */
+#define DIR_CHUNK_INDEX -1
+
+/* Return the dir chunk cache of FS if it applies to NODEREV, and NULL
+ * otherwise.  Initialize *KEY for NODEREV and CHUNK.
+ */
+static svn_cache__t *
+locate_dir_chunk_cache(window_cache_key_t *key,
+                       svn_fs_t *fs,
+                       node_revision_t *noderev,
+                       apr_int64_t chunk)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  /* Only committed data is immutable. */
+  if (   !noderev->data_rep
+      || svn_fs_fs__id_txn_used(&noderev->data_rep->txn_id))
+    return NULL;
+
+  key->revision = noderev->data_rep->revision;
+  key->item_index = noderev->data_rep->item_index;
+  key->chunk_index = chunk;
+
+  return ffd->dir_chunk_cache;
+}
+
+/* Store the committed directory contents DIR of NODEREV in FS in the dir
+ * chunk cache.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+cache_dir_chunks(svn_fs_t *fs,
+                 node_revision_t *noderev,
+                 svn_fs_fs__dir_data_t *dir,
+                 apr_pool_t *scratch_pool)
+{
+  window_cache_key_t key;
+  svn_cache__t *cache = locate_dir_chunk_cache(&key, fs, noderev, 0);
+  apr_array_header_t *entries = dir->entries;
+  svn_fs_fs__dir_data_t chunk;
+  svn_fs_fs__dir_data_t index;
+  apr_pool_t *iterpool;
+  int i;
+
+  if (!cache || entries->nelts == 0)
+    return SVN_NO_ERROR;
+
+  index.entries = apr_array_make(scratch_pool,
+                                 1 + (entries->nelts - 1) / DIR_CHUNK_SIZE,
+                                 sizeof(svn_fs_dirent_t *));
+  index.txn_filesize = dir->txn_filesize;
+  chunk.txn_filesize = dir->txn_filesize;
+
+  /* Write the chunks before the index such that readers will not find an
+   * index for chunks that have never been written. */
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < entries->nelts; i += DIR_CHUNK_SIZE)
+    {
+      int count = MIN(DIR_CHUNK_SIZE, entries->nelts - i);
+
+      svn_pool_clear(iterpool);
+
+      chunk.entries = apr_array_make(iterpool, count,
+                                     sizeof(svn_fs_dirent_t *));
+      memcpy(chunk.entries->elts,
+             &APR_ARRAY_IDX(entries, i, svn_fs_dirent_t *),
+             count * sizeof(svn_fs_dirent_t *));
+      chunk.entries->nelts = count;
+
+      key.chunk_index = i / DIR_CHUNK_SIZE;
+      SVN_ERR(svn_cache__set(cache, &key, &chunk, iterpool));
+
+      APR_ARRAY_PUSH(index.entries, svn_fs_dirent_t *)
+        = APR_ARRAY_IDX(entries, i, svn_fs_dirent_t *);
+    }
+  svn_pool_destroy(iterpool);
+
+  key.chunk_index = DIR_CHUNK_INDEX;
+  SVN_ERR(svn_cache__set(cache, &key, &index, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *ENTRIES_P to the contents of the committed directory NODEREV in FS
+ * as found in the dir chunk cache.  Set it to NULL if some of the data is
+ * not cached.  Allocate the result in RESULT_POOL and use SCRATCH_POOL for
+ * temporary allocations.
+ */
+static svn_error_t *
+get_dir_from_chunks(apr_array_header_t **entries_p,
+                    svn_fs_t *fs,
+                    node_revision_t *noderev,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  window_cache_key_t key;
+  svn_cache__t *cache = locate_dir_chunk_cache(&key, fs, noderev,
+                                               DIR_CHUNK_INDEX);
+  svn_fs_fs__dir_data_t *index;
+  apr_array_header_t *entries;
+  svn_boolean_t found = FALSE;
+  int i;
+
+  *entries_p = NULL;
+  if (cache)
+    SVN_ERR(svn_cache__get((void **)&index, &found, cache, &key,
+                           scratch_pool));
+  if (!found)
+    return SVN_NO_ERROR;
+
+  entries = apr_array_make(result_pool,
+                           index->entries->nelts * DIR_CHUNK_SIZE,
+                           sizeof(svn_fs_dirent_t *));
+  for (i = 0; i < index->entries->nelts; ++i)
+    {
+      svn_fs_fs__dir_data_t *chunk;
+
+      key.chunk_index = i;
+      SVN_ERR(svn_cache__get((void **)&chunk, &found, cache, &key,
+                             result_pool));
+      if (!found)
+        return SVN_NO_ERROR;
+
+      apr_array_cat(entries, chunk->entries);
+    }
+
+  *entries_p = entries;
+
+  return SVN_NO_ERROR;
+}
+
+/* Look up the entry NAME in the committed directory NODEREV in FS using
+ * the dir chunk cache.  Set *FOUND to TRUE and *DIRENT to the entry, NULL
+ * if it does not exist, if the cache could answer the query.  Otherwise,
+ * set *FOUND to FALSE.  Allocate *DIRENT in RESULT_POOL.  Use SCRATCH_POOL
+ * for temporary allocations.
+ */
+static svn_error_t *
+get_dir_entry_from_chunks(svn_fs_dirent_t **dirent,
+                          svn_boolean_t *found,
+                          svn_fs_t *fs,
+                          node_revision_t *noderev,
+                          const char *name,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
+{
+  window_cache_key_t key;
+  svn_cache__t *cache = locate_dir_chunk_cache(&key, fs, noderev,
+                                               DIR_CHUNK_INDEX);
+  extract_dir_entry_baton_t baton;
+  int chunk_no = 0;
+
+  *found = FALSE;
+  *dirent = NULL;
+  if (!cache)
+    return SVN_NO_ERROR;
+
+  /* Which chunk would contain NAME? */
+  SVN_ERR(svn_cache__get_partial((void **)&chunk_no, found, cache, &key,
+                                 svn_fs_fs__extract_dir_chunk_no,
+                                 (void *)name, scratch_pool));
+
+  /* Not found or sorting before all entries, i.e. not in the directory. */
+  if (!*found || chunk_no < 0)
+    return SVN_NO_ERROR;
+
+  /* Look it up in this chunk. */
+  baton.txn_filesize = SVN_INVALID_FILESIZE;
+  baton.name = name;
+  key.chunk_index = chunk_no;
+  SVN_ERR(svn_cache__get_partial((void **)dirent, found, cache, &key,
+                                 svn_fs_fs__extract_dir_entry, &baton,
+                                 result_pool));
+  if (*found && baton.out_of_date)
+    *found = FALSE;
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__rep_contents_dir(apr_array_header_t **entries_p,
                             svn_fs_t *fs,
@@ -2733,6 +3229,12 @@ svn_fs_fs__rep_contents_dir(apr_array_header_t **entries_p,
         }
     }
 
+  /* Very large directories may have been cached in chunks. */
+  SVN_ERR(get_dir_from_chunks(entries_p, fs, noderev, result_pool,
+                              scratch_pool));
+  if (*entries_p)
+    return SVN_NO_ERROR;
+
   /* Read in the directory contents. */
   dir = apr_pcalloc(scratch_pool, sizeof(*dir));
   SVN_ERR(get_dir_contents(dir, fs, noderev, result_pool, scratch_pool));
@@ -2742,9 +3244,12 @@ svn_fs_fs__rep_contents_dir(apr_array_header_t **entries_p,
    *
    * Don't even attempt to serialize very large directories; it would cause
    * an unnecessary memory allocation peak.  150 bytes/entry is about right.
+   * Cache those in chunks instead.
    */
   if (cache && svn_cache__is_cachable(cache, 150 * dir->entries->nelts))
     SVN_ERR(svn_cache__set(cache, key, dir, scratch_pool));
+  else
+    SVN_ERR(cache_dir_chunks(fs, noderev, dir, scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -2792,8 +3297,13 @@ svn_fs_fs__rep_contents_dir_entry(svn_fs_dirent_t **dirent,
                                      result_pool));
     }
 
-  /* fetch data from disk if we did not find it in the cache */
+  /* Very large directories may have been cached in chunks. */
   if (! found || baton.out_of_date)
+    SVN_ERR(get_dir_entry_from_chunks(dirent, &found, fs, noderev, name,
+                                      result_pool, scratch_pool));
+
+  /* fetch data from disk if we did not find it in the cache */
+  if (! found)
     {
       svn_fs_dirent_t *entry;
       svn_fs_dirent_t *entry_copy = NULL;
@@ -2807,9 +3317,11 @@ svn_fs_fs__rep_contents_dir_entry(svn_fs_dirent_t **dirent,
        *
        * Don't even attempt to serialize very large directories; it would
        * cause an unnecessary memory allocation peak.  150 bytes / entry is
-       * about right. */
+       * about right.  Cache those in chunks instead. */
       if (cache && svn_cache__is_cachable(cache, 150 * dir.entries->nelts))
         SVN_ERR(svn_cache__set(cache, key, &dir, scratch_pool));
+      else
+        SVN_ERR(cache_dir_chunks(fs, noderev, &dir, scratch_pool));
 
       /* find desired entry and return a copy in POOL, if found */
       entry = svn_fs_fs__find_dir_entry(dir.entries, name, NULL);
@@ -2862,6 +3374,7 @@ svn_fs_fs__get_proplist(apr_hash_t **proplist_p,
       fs_fs_data_t *ffd = fs->fsap_data;
       representation_t *rep = noderev->prop_rep;
       pair_cache_key_t key = { 0 };
+      svn_stringbuf_t *content;
 
       key.revision = rep->revision;
       key.second = rep->item_index;
@@ -2874,20 +3387,25 @@ svn_fs_fs__get_proplist(apr_hash_t **proplist_p,
             return SVN_NO_ERROR;
         }
 
+      /* Property lists are small.  Read them en bloc and parse them in
+         place, so all keys and values share the same buffer. */
       proplist = apr_hash_make(pool);
       SVN_ERR(svn_fs_fs__get_contents(&stream, fs, noderev->prop_rep, FALSE,
                                       pool));
-      err = svn_hash_read2(proplist, stream, SVN_HASH_TERMINATOR, pool);
+      err = svn_stringbuf_from_stream(&content, stream,
+                                      (apr_size_t)rep->expanded_size, pool);
+      err = svn_error_compose_create(err, svn_stream_close(stream));
+      if (!err)
+        err = svn_hash__parse(proplist, content->data, content->len,
+                              SVN_HASH_TERMINATOR, pool);
       if (err)
         {
           svn_string_t *id_str = svn_fs_fs__id_unparse(noderev->id, pool);
 
-          err = svn_error_compose_create(err, svn_stream_close(stream));
           return svn_error_quick_wrapf(err,
                    _("malformed property list for node-revision '%s'"),
                    id_str->data);
         }
-      SVN_ERR(svn_stream_close(stream));
 
       if (ffd->properties_cache && SVN_IS_VALID_REVNUM(rep->revision))
         SVN_ERR(svn_cache__set(ffd->properties_cache, &key, proplist, pool));
@@ -3091,7 +3609,7 @@ init_rep_state(rep_state_t *rs,
   rs->start = entry->offset + rs->header_size;
   rs->current = rep_header->type == svn_fs_fs__rep_plain ? 0 : 4;
   rs->size = entry->size - rep_header->header_size - 7;
-  rs->ver = 1;
+  rs->ver = rep_header->type == svn_fs_fs__rep_plain ? 1 : -1;
   rs->chunk_index = 0;
   rs->raw_window_cache = ffd->raw_window_cache;
   rs->window_cache = ffd->txdelta_window_cache;
@@ -3209,6 +3727,7 @@ cache_windows(svn_fs_t *fs,
           window.end_offset = rs->current;
           window.window.len = window_len;
           window.window.data = buf;
+          window.ver = rs->ver;
 
           /* cache the window now */
           SVN_ERR(svn_cache__set(rs->raw_window_cache, &key, &window,
@@ -3287,6 +3806,7 @@ block_read_windows(svn_fs_fs__rep_header_t *rep_header,
     }
   else
     {
+      SVN_ERR(auto_read_diff_version(&rs, scratch_pool));
       SVN_ERR(cache_windows(fs, &rs, max_offset, scratch_pool));
     }
 
@@ -3355,12 +3875,12 @@ block_read_contents(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
-/* For the given REV_FILE in FS, in *STREAM return a stream covering the
+/* For the given REV_FILE in FS, in *TEXT_P return the contents of the
  * item specified by ENTRY.  Also, verify the item's content by low-level
  * checksum.  Allocate the result in POOL.
  */
 static svn_error_t *
-read_item(svn_stream_t **stream,
+read_item(svn_stringbuf_t **text_p,
           svn_fs_t *fs,
           svn_fs_fs__revision_file_t *rev_file,
           svn_fs_fs__p2l_entry_t* entry,
@@ -3377,8 +3897,8 @@ read_item(svn_stream_t **stream,
   SVN_ERR(svn_io_file_read_full2(rev_file->file, text->data, text->len,
                                  NULL, NULL, pool));
 
-  /* Return (construct, calculate) stream and checksum. */
-  *stream = svn_stream_from_stringbuf(text, pool);
+  /* Return the text and calculate its checksum. */
+  *text_p = text;
   digest = svn__fnv1a_32x4(text->data, text->len);
 
   /* Checksums will match most of the time. */
@@ -3417,7 +3937,7 @@ block_read_changes(svn_fs_t *fs,
                    apr_pool_t *scratch_pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
-  svn_stream_t *stream;
+  svn_stringbuf_t *text;
   apr_array_header_t *changes;
 
   pair_cache_key_t key;
@@ -3437,17 +3957,17 @@ block_read_changes(svn_fs_t *fs,
         return SVN_NO_ERROR;
     }
 
-  SVN_ERR(read_item(&stream, fs, rev_file, entry, scratch_pool));
+  SVN_ERR(read_item(&text, fs, rev_file, entry, scratch_pool));
 
-  /* Read changes from revision file.  But read just past the first block to
+  /* Parse the changes in place.  But parse just past the first block to
      enable us to determine whether the first block already hit the EOL.
 
      Note: A 100 entries block is already > 10kB on disk.  With a 4kB default
            disk block size, this function won't even be called for larger
            changed paths lists. */
-  SVN_ERR(svn_fs_fs__read_changes(&changes, stream,
-                                  SVN_FS_FS__CHANGES_BLOCK_SIZE + 1,
-                                  scratch_pool, scratch_pool));
+  SVN_ERR(svn_fs_fs__parse_changes(&changes, text,
+                                   SVN_FS_FS__CHANGES_BLOCK_SIZE + 1,
+                                   scratch_pool));
 
   /* We can only cache small lists that don't need to be split up.
      For longer lists, we miss the file offset info for the respective */
@@ -3484,7 +4004,7 @@ block_read_noderev(node_revision_t **noderev_p,
                    apr_pool_t *scratch_pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
-  svn_stream_t *stream;
+  svn_stringbuf_t *text;
 
   pair_cache_key_t key = { 0 };
   key.revision = entry->item.revision;
@@ -3503,11 +4023,12 @@ block_read_noderev(node_revision_t **noderev_p,
         return SVN_NO_ERROR;
     }
 
-  SVN_ERR(read_item(&stream, fs, rev_file, entry, scratch_pool));
+  /* The noderev will point into TEXT. */
+  SVN_ERR(read_item(&text, fs, rev_file, entry, result_pool));
 
-  /* read node rev from revision file */
-  SVN_ERR(svn_fs_fs__read_noderev(noderev_p, stream,
-                                  result_pool, scratch_pool));
+  /* parse node rev in place */
+  SVN_ERR(svn_fs_fs__parse_noderev(noderev_p, text,
+                                   result_pool, scratch_pool));
   SVN_ERR(fixup_node_revision(fs, *noderev_p, scratch_pool));
 
   if (ffd->node_revision_cache)
@@ -3517,6 +4038,369 @@ block_read_noderev(node_revision_t **noderev_p,
   return SVN_NO_ERROR;
 }
 
+/* Read the item described by ENTRY from REVISION_FILE in FS and put it
+ * into the respective cache.  For noderevs, read them even if they are
+ * cached already if MUST_READ is set.  Return them in *ITEM allocated in
+ * RESULT_POOL then.  MAX_OFFSET is as for block_read_contents().
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+block_read_item(void **item,
+                svn_fs_t *fs,
+                svn_fs_fs__revision_file_t *revision_file,
+                svn_fs_fs__p2l_entry_t *entry,
+                apr_off_t max_offset,
+                svn_boolean_t must_read,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  SVN_ERR(svn_io_file_seek(revision_file->file, APR_SET, &entry->offset,
+                           scratch_pool));
+  switch (entry->type)
+    {
+      case SVN_FS_FS__ITEM_TYPE_FILE_REP:
+      case SVN_FS_FS__ITEM_TYPE_DIR_REP:
+      case SVN_FS_FS__ITEM_TYPE_FILE_PROPS:
+      case SVN_FS_FS__ITEM_TYPE_DIR_PROPS:
+        SVN_ERR(block_read_contents(fs, revision_file, entry, max_offset,
+                                    scratch_pool));
+        break;
+
+      case SVN_FS_FS__ITEM_TYPE_NODEREV:
+        if (ffd->node_revision_cache || must_read)
+          SVN_ERR(block_read_noderev((node_revision_t **)item, fs,
+                                     revision_file, entry, must_read,
+                                     result_pool, scratch_pool));
+        break;
+
+      case SVN_FS_FS__ITEM_TYPE_CHANGES:
+        SVN_ERR(block_read_changes(fs, revision_file, entry,
+                                   scratch_pool));
+        break;
+
+      default:
+        break;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS
+
+/* Number of blocks to read ahead after each block read. */
+#define READ_AHEAD_BLOCKS 4
+
+/* State of the read-ahead thread of a filesystem object. */
+struct svn_fs_fs__read_ahead_t
+{
+  /* Protects REVISION, OFFSET and SHUTDOWN.  Used with COND. */
+  svn_mutex__t *mutex;
+
+  /* Signaled whenever a new request has been queued or at shutdown. */
+  apr_thread_cond_t *cond;
+
+  /* The latest request: read the blocks following OFFSET in the rev /
+     pack file of REVISION. */
+  svn_revnum_t revision;
+  apr_off_t offset;
+
+  /* Non-zero while a request has not been picked up by the thread yet
+     or when the thread shall terminate. */
+  volatile svn_atomic_t pending;
+
+  /* Set when the thread shall terminate. */
+  svn_boolean_t shutdown;
+
+  /* Private filesystem instance used by the thread.  Shares the caches
+     with the filesystem object that requests the read-ahead. */
+  svn_fs_t *fs;
+
+  /* Root pool of the thread. */
+  apr_pool_t *pool;
+
+  /* The thread itself. */
+  apr_thread_t *thread;
+};
+
+/* Read the items in the block starting at BLOCK_START in REVISION_FILE
+ * of REVISION in FS and put them into the cache.  Skip items that cross
+ * the block boundaries.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+read_ahead_block(svn_fs_t *fs,
+                 svn_fs_fs__revision_file_t *revision_file,
+                 svn_revnum_t revision,
+                 apr_off_t block_start,
+                 apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_array_header_t *entries;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  SVN_ERR(svn_fs_fs__p2l_index_lookup(&entries, fs, revision_file,
+                                      revision, block_start,
+                                      ffd->block_size, scratch_pool,
+                                      scratch_pool));
+  SVN_ERR(aligned_seek(fs, revision_file->file, &block_start, block_start,
+                       iterpool));
+
+  for (i = 0; i < entries->nelts; ++i)
+    {
+      void *item = NULL;
+      svn_fs_fs__p2l_entry_t *entry
+        = &APR_ARRAY_IDX(entries, i, svn_fs_fs__p2l_entry_t);
+
+      svn_pool_clear(iterpool);
+
+      if (   entry->type == SVN_FS_FS__ITEM_TYPE_UNUSED
+          || entry->offset < block_start
+          || entry->size >= ffd->block_size)
+        continue;
+
+      SVN_ERR(block_read_item(&item, fs, revision_file, entry,
+                              block_start + ffd->block_size, FALSE,
+                              iterpool, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Wait for the next request to RA and return it in *REVISION and *OFFSET.
+ * Set *REVISION to SVN_INVALID_REVNUM if the thread shall terminate.
+ */
+static svn_error_t *
+next_read_ahead(svn_revnum_t *revision,
+                apr_off_t *offset,
+                struct svn_fs_fs__read_ahead_t *ra)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+
+  SVN_ERR(svn_mutex__lock(ra->mutex));
+
+  /* This loop implicitly handles spurious wake-ups. */
+  while (!ra->shutdown && !svn_atomic_read(&ra->pending))
+    {
+      apr_status_t status
+        = apr_thread_cond_wait(ra->cond, svn_mutex__get(ra->mutex));
+      if (status)
+        {
+          err = svn_error_wrap_apr(status,
+                                   _("Can't wait for condition variable"));
+          break;
+        }
+    }
+
+  if (err || ra->shutdown)
+    {
+      *revision = SVN_INVALID_REVNUM;
+    }
+  else
+    {
+      *revision = ra->revision;
+      *offset = ra->offset;
+      svn_atomic_set(&ra->pending, FALSE);
+    }
+
+  return svn_error_trace(svn_mutex__unlock(ra->mutex, err));
+}
+
+/* Thread function.  Serve the read-ahead requests to the
+ * svn_fs_fs__read_ahead_t given by DATA until it shuts down.
+ */
+static void * APR_THREAD_FUNC
+read_ahead_thread(apr_thread_t *tid,
+                  void *data)
+{
+  struct svn_fs_fs__read_ahead_t *ra = data;
+  fs_fs_data_t *ffd = ra->fs->fsap_data;
+  apr_pool_t *iterpool = svn_pool_create(ra->pool);
+
+  while (TRUE)
+    {
+      svn_fs_fs__revision_file_t *revision_file;
+      svn_revnum_t revision;
+      apr_off_t offset, max_offset;
+      svn_error_t *err;
+      int i;
+
+      svn_pool_clear(iterpool);
+
+      err = next_read_ahead(&revision, &offset, ra);
+      if (err || !SVN_IS_VALID_REVNUM(revision))
+        {
+          svn_error_clear(err);
+          break;
+        }
+
+      err = svn_fs_fs__open_pack_or_rev_file(&revision_file, ra->fs,
+                                             revision, iterpool, iterpool);
+      if (!err)
+        {
+          err = svn_fs_fs__p2l_get_max_offset(&max_offset, ra->fs,
+                                              revision_file, revision,
+                                              iterpool);
+
+          /* Give up on the current request as soon as there is a new
+             one.  The reader has moved on. */
+          for (i = 0;
+               !err && i < READ_AHEAD_BLOCKS && offset < max_offset
+                    && !svn_atomic_read(&ra->pending);
+               ++i, offset += ffd->block_size)
+            err = read_ahead_block(ra->fs, revision_file, revision, offset,
+                                   iterpool);
+
+          err = svn_error_compose_create(err,
+                    svn_fs_fs__close_revision_file(revision_file));
+        }
+
+      /* Reading ahead is opportunistic.  The reader will run into the
+         same problems and report them. */
+      svn_error_clear(err);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return NULL;
+}
+
+/* Pool cleanup handler terminating the read-ahead thread given by DATA.
+ */
+static apr_status_t
+stop_read_ahead(void *data)
+{
+  struct svn_fs_fs__read_ahead_t *ra = data;
+  apr_status_t retval;
+  svn_error_t *err;
+
+  err = svn_mutex__lock(ra->mutex);
+  ra->shutdown = TRUE;
+  svn_atomic_set(&ra->pending, TRUE);
+  apr_thread_cond_broadcast(ra->cond);
+  svn_error_clear(svn_mutex__unlock(ra->mutex, err));
+
+  apr_thread_join(&retval, ra->thread);
+  svn_pool_destroy(ra->pool);
+
+  return APR_SUCCESS;
+}
+
+/* Implements svn_fs_warning_callback_t.  The read-ahead thread must not
+ * run FS's warning handler, which may not expect to be called from
+ * another thread and defaults to aborting the process.  Whatever went
+ * wrong, the reader will run into it and report it itself.
+ */
+static void
+ignore_warning(void *baton,
+               svn_error_t *err)
+{
+}
+
+/* Start the read-ahead thread for FS and return its state in *RA_P.
+ * The state is bound to the lifetime of FS.  Use SCRATCH_POOL for
+ * temporary allocations.
+ */
+static svn_error_t *
+start_read_ahead(struct svn_fs_fs__read_ahead_t **ra_p,
+                 svn_fs_t *fs,
+                 apr_pool_t *scratch_pool)
+{
+  struct svn_fs_fs__read_ahead_t *ra = apr_pcalloc(fs->pool, sizeof(*ra));
+  fs_fs_data_t *instance_ffd;
+  apr_status_t status;
+  svn_error_t *err;
+
+  /* Without shared, thread-safe caches, the thread could not hand the
+     data over to us. */
+  if (   !svn_cache__get_global_membuffer_cache()
+      || svn_cache_config_get()->single_threaded)
+    return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                            _("Read-ahead requires thread-safe caches"));
+
+  SVN_ERR(svn_mutex__init(&ra->mutex, TRUE, fs->pool));
+  status = apr_thread_cond_create(&ra->cond, fs->pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create condition variable"));
+
+  ra->revision = SVN_INVALID_REVNUM;
+  ra->pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+
+  /* FS objects must not be shared between threads.  Also, the thread's
+     own block reads must not trigger further read-ahead. */
+  err = svn_fs_fs__open_instance(&ra->fs, fs, ra->pool, scratch_pool);
+  if (err)
+    {
+      svn_pool_destroy(ra->pool);
+      return svn_error_trace(err);
+    }
+
+  instance_ffd = ra->fs->fsap_data;
+  instance_ffd->use_read_ahead = FALSE;
+  ra->fs->warning = ignore_warning;
+  ra->fs->warning_baton = NULL;
+
+  status = apr_thread_create(&ra->thread, NULL, read_ahead_thread, ra,
+                             ra->pool);
+  if (status)
+    {
+      svn_pool_destroy(ra->pool);
+      return svn_error_wrap_apr(status, _("Can't create read-ahead thread"));
+    }
+
+  apr_pool_pre_cleanup_register(fs->pool, ra, stop_read_ahead);
+  *ra_p = ra;
+
+  return SVN_NO_ERROR;
+}
+
+/* Let the read-ahead thread of FS read the blocks following the one
+ * at BLOCK_START in the rev / pack file containing REVISION.  Replace
+ * any request that has not been picked up yet.  Start the thread if
+ * necessary.  If that fails, disable read-ahead for FS.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static void
+read_ahead(svn_fs_t *fs,
+           svn_revnum_t revision,
+           apr_off_t block_start,
+           apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  struct svn_fs_fs__read_ahead_t *ra = ffd->read_ahead;
+  svn_error_t *err;
+
+  if (!ra)
+    {
+      err = start_read_ahead(&ffd->read_ahead, fs, scratch_pool);
+      if (err)
+        {
+          svn_error_clear(err);
+          ffd->use_read_ahead = FALSE;
+          return;
+        }
+
+      ra = ffd->read_ahead;
+    }
+
+  err = svn_mutex__lock(ra->mutex);
+  if (!err)
+    {
+      ra->revision = revision;
+      ra->offset = block_start + ffd->block_size;
+      svn_atomic_set(&ra->pending, TRUE);
+      apr_thread_cond_signal(ra->cond);
+      err = svn_mutex__unlock(ra->mutex, SVN_NO_ERROR);
+    }
+
+  svn_error_clear(err);
+}
+
+#endif /* APR_HAS_THREADS */
+
 /* Read the whole (e.g. 64kB) block containing ITEM_INDEX of REVISION in FS
  * and put all data into cache.  If necessary and depending on heuristics,
  * neighboring blocks may also get read.  The data is being read from
@@ -3548,6 +4432,7 @@ block_read(void **result,
   if (!result)
     return SVN_NO_ERROR;
 
+  SVN_PROBE2(fsfs__block_read__start, revision, item_index);
   iterpool = svn_pool_create(scratch_pool);
 
   /* don't try this on transaction protorev files */
@@ -3610,37 +4495,11 @@ block_read(void **result,
                             && entry->size < ffd->block_size))
             {
               void *item = NULL;
-              SVN_ERR(svn_io_file_seek(revision_file->file, APR_SET,
-                                       &entry->offset, iterpool));
-              switch (entry->type)
-                {
-                  case SVN_FS_FS__ITEM_TYPE_FILE_REP:
-                  case SVN_FS_FS__ITEM_TYPE_DIR_REP:
-                  case SVN_FS_FS__ITEM_TYPE_FILE_PROPS:
-                  case SVN_FS_FS__ITEM_TYPE_DIR_PROPS:
-                    SVN_ERR(block_read_contents(fs, revision_file, entry,
-                                                is_wanted
-                                                  ? -1
-                                                  : block_start + ffd->block_size,
-                                                iterpool));
-                    break;
-
-                  case SVN_FS_FS__ITEM_TYPE_NODEREV:
-                    if (ffd->node_revision_cache || is_result)
-                      SVN_ERR(block_read_noderev((node_revision_t **)&item,
-                                                 fs, revision_file,
-                                                 entry, is_result, pool,
-                                                 iterpool));
-                    break;
-
-                  case SVN_FS_FS__ITEM_TYPE_CHANGES:
-                    SVN_ERR(block_read_changes(fs, revision_file,
-                                               entry, iterpool));
-                    break;
-
-                  default:
-                    break;
-                }
+              SVN_ERR(block_read_item(&item, fs, revision_file, entry,
+                                      is_wanted
+                                        ? -1
+                                        : block_start + ffd->block_size,
+                                      is_result, pool, iterpool));
 
               if (is_result)
                 *result = item;
@@ -3657,9 +4516,16 @@ block_read(void **result,
   while(run_count++ == 1); /* can only be true once and only if a block
                             * boundary got crossed */
 
+#if APR_HAS_THREADS
+  /* Sequential readers will most likely need the next blocks, too. */
+  if (ffd->use_read_ahead)
+    read_ahead(fs, revision, block_start, iterpool);
+#endif
+
   /* if the caller requested a result, we must have provided one by now */
   assert(!result || *result);
   svn_pool_destroy(iterpool);
+  SVN_PROBE2(fsfs__block_read__done, revision, item_index);
 
   return SVN_NO_ERROR;
 }
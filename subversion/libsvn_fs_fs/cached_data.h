@@ -51,6 +51,28 @@ svn_fs_fs__get_node_revision(node_revision_t **noderev_p,
                              apr_pool_t *result_pool,
                              apr_pool_t *scratch_pool);
 
+/* Set *PREDECESSOR_P to the node-revision on NODEREV's line of history
+   in FS that has COUNT predecessors of its own.  COUNT must not exceed
+   NODEREV's predecessor count.  Skip pointers get followed where they
+   exist, so this takes O(log N) hops in repositories that record them.
+   Allocate the result in RESULT_POOL. */
+svn_error_t *
+svn_fs_fs__get_predecessor(node_revision_t **predecessor_p,
+                           svn_fs_t *fs,
+                           node_revision_t *noderev,
+                           int count,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool);
+
+/* Set *COUNT to the mergeinfo count of the node revision ID in FS.
+   For committed node revisions, this is read in place from the noderev
+   cache if possible.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__get_mergeinfo_count(apr_int64_t *count,
+                               svn_fs_t *fs,
+                               const svn_fs_id_t *id,
+                               apr_pool_t *scratch_pool);
+
 /* Set *ROOT_ID to the node-id for the root of revision REV in
    filesystem FS.  Do any allocations in POOL. */
 svn_error_t *
@@ -85,6 +107,10 @@ svn_fs_fs__rep_chain_length(int *chain_length,
    representation REP as seen in filesystem FS.  If CACHE_FULLTEXT is
    not set, bypass fulltext cache lookup for this rep and don't put the
    reconstructed fulltext into cache.
+
+   The stream supports svn_stream_skip() without reconstructing the delta
+   windows that are being skipped over.  Skipped data won't be verified
+   against the checksum, though.
    Use POOL for allocations. */
 svn_error_t *
 svn_fs_fs__get_contents(svn_stream_t **contents_p,
@@ -107,6 +133,21 @@ svn_fs_fs__try_process_file_contents(svn_boolean_t *success,
                                      void* baton,
                                      apr_pool_t *pool);
 
+/* If the representation REP in FS is committed and stores its contents
+   verbatim (PLAIN), set *FILE_PATH to the revision or pack file containing
+   it, allocated in RESULT_POOL, *OFFSET to the position of the first
+   content byte and *LENGTH to the number of bytes.  Otherwise, including
+   for a NULL REP, set *FILE_PATH to NULL.  Use SCRATCH_POOL for temporary
+   allocations. */
+svn_error_t *
+svn_fs_fs__get_contents_location(const char **file_path,
+                                 apr_off_t *offset,
+                                 svn_filesize_t *length,
+                                 svn_fs_t *fs,
+                                 representation_t *rep,
+                                 apr_pool_t *result_pool,
+                                 apr_pool_t *scratch_pool);
+
 /* Set *STREAM_P to a delta stream turning the contents of the file SOURCE into
    the contents of the file TARGET, allocated in POOL.
    If SOURCE is null, the empty string will be used. */
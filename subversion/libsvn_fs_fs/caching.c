@@ -66,9 +66,14 @@ normalize_key_part(const char *original,
   return normalized->data;
 }
 
+/* Default size limit of the persistent second cache tier. */
+#define DEFAULT_CACHE_DISK_SIZE (APR_UINT64_C(16) * 1024 * 1024 * 1024)
+
 /* *CACHE_TXDELTAS, *CACHE_FULLTEXTS, *CACHE_NODEPROPS flags will be set
    according to FS->CONFIG. *CACHE_NAMESPACE receives the cache prefix to
-   use.
+   use.  *CACHE_DISK_PATH and *CACHE_DISK_SIZE receive the location and
+   size of the persistent second cache tier; the path will be NULL if
+   there shall be none.
 
    Use FS->pool for allocating the memcache and CACHE_NAMESPACE, and POOL
    for temporary allocations. */
@@ -77,9 +82,13 @@ read_config(const char **cache_namespace,
             svn_boolean_t *cache_txdeltas,
             svn_boolean_t *cache_fulltexts,
             svn_boolean_t *cache_nodeprops,
+            const char **cache_disk_path,
+            apr_uint64_t *cache_disk_size,
             svn_fs_t *fs,
             apr_pool_t *pool)
 {
+  const char *disk_size;
+
   /* No cache namespace by default.  I.e. all FS instances share the
    * cached data.  If you specify different namespaces, the data will
    * share / compete for the same cache memory but keys will not match
@@ -127,6 +136,22 @@ read_config(const char **cache_namespace,
     = svn_hash__get_bool(fs->config,
                          SVN_FS_CONFIG_FSFS_CACHE_NODEPROPS,
                          TRUE);
+
+  /* No disk tier by default.  It only pays off if the cache directory is
+   * on storage that is considerably faster than the repository's. */
+  *cache_disk_path = svn_hash__get_cstring(fs->config,
+                                           SVN_FS_CONFIG_FSFS_CACHE_DISK_PATH,
+                                           NULL);
+  if (*cache_disk_path && **cache_disk_path == '\0')
+    *cache_disk_path = NULL;
+
+  *cache_disk_size = DEFAULT_CACHE_DISK_SIZE;
+  disk_size = svn_hash__get_cstring(fs->config,
+                                    SVN_FS_CONFIG_FSFS_CACHE_DISK_SIZE,
+                                    NULL);
+  if (disk_size)
+    SVN_ERR(svn_cstring_atoui64(cache_disk_size, disk_size));
+
   return SVN_NO_ERROR;
 }
 
@@ -349,13 +374,43 @@ create_cache(svn_cache__t **cache_p,
   return SVN_NO_ERROR;
 }
 
+/* If DISK_PATH is not NULL, replace the non-NULL *CACHE_P with a cache
+ * that adds a persistent second tier of DISK_SIZE bytes in DISK_PATH
+ * below it.  SERIALIZER, DESERIALIZER, KLEN and PREFIX must match the
+ * ones *CACHE_P has been created with.  Allocate the result in
+ * RESULT_POOL.
+ */
+static svn_error_t *
+add_disk_tier(svn_cache__t **cache_p,
+              const char *disk_path,
+              apr_uint64_t disk_size,
+              svn_cache__serialize_func_t serializer,
+              svn_cache__deserialize_func_t deserializer,
+              apr_ssize_t klen,
+              const char *prefix,
+              apr_pool_t *result_pool)
+{
+  if (*cache_p && disk_path)
+    SVN_ERR(svn_cache__create_disk_tier(cache_p, *cache_p, disk_path,
+                                        disk_size, serializer, deserializer,
+                                        klen, prefix, result_pool));
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__initialize_caches(svn_fs_t *fs,
                              apr_pool_t *pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
+
+  /* Keep the instance ID in the prefix: Cache contents may outlive the
+   * process (see svn_cache__membuffer_save) and a repository that got
+   * replaced by a dump / load cycle must not see the old contents even
+   * if its UUID and path did not change. */
   const char *prefix = apr_pstrcat(pool,
                                    "fsfs:", fs->uuid,
+                                   "--", ffd->instance_id,
                                    "/", normalize_key_part(fs->path, pool),
                                    ":",
                                    SVN_VA_NULL);
@@ -364,6 +419,8 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
   svn_boolean_t cache_txdeltas;
   svn_boolean_t cache_fulltexts;
   svn_boolean_t cache_nodeprops;
+  const char *cache_disk_path;
+  apr_uint64_t cache_disk_size;
   const char *cache_namespace;
   svn_boolean_t has_namespace;
 
@@ -372,6 +429,8 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                       &cache_txdeltas,
                       &cache_fulltexts,
                       &cache_nodeprops,
+                      &cache_disk_path,
+                      &cache_disk_size,
                       fs,
                       pool));
 
@@ -456,6 +515,21 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                        no_handler,
                        fs->pool, pool));
 
+  /* Only used for very large directories. */
+  SVN_ERR(create_cache(&(ffd->dir_chunk_cache),
+                       NULL,
+                       membuffer,
+                       1, 8,
+                       svn_fs_fs__serialize_dir_entries,
+                       svn_fs_fs__deserialize_dir_entries,
+                       sizeof(window_cache_key_t),
+                       apr_pstrcat(pool, prefix, "DIRCHUNK", SVN_VA_NULL),
+                       SVN_CACHE__MEMBUFFER_HIGH_PRIORITY,
+                       has_namespace,
+                       fs,
+                       no_handler,
+                       fs->pool, pool));
+
   /* 8 kBytes per entry (1000 revs / shared, one file offset per rev).
      Covering about 8 pack files gives us an "o.k." hit rate. */
   SVN_ERR(create_cache(&(ffd->packed_offset_cache),
@@ -549,6 +623,12 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                            fs,
                            no_handler,
                            fs->pool, pool));
+      SVN_ERR(add_disk_tier(&(ffd->fulltext_cache),
+                            cache_disk_path, cache_disk_size,
+                            NULL, NULL,
+                            sizeof(pair_cache_key_t),
+                            apr_pstrcat(pool, prefix, "TEXT", SVN_VA_NULL),
+                            fs->pool));
 
       SVN_ERR(create_cache(&(ffd->mergeinfo_cache),
                            NULL,
@@ -657,6 +737,13 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                            fs,
                            no_handler,
                            fs->pool, pool));
+      SVN_ERR(add_disk_tier(&(ffd->combined_window_cache),
+                            cache_disk_path, cache_disk_size,
+                            NULL, NULL,
+                            sizeof(window_cache_key_t),
+                            apr_pstrcat(pool, prefix, "COMBINED_WINDOW",
+                                        SVN_VA_NULL),
+                            fs->pool));
     }
   else
     {
@@ -0,0 +1,363 @@
+/* changed_paths.c --- the FSFS changed paths index
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include "svn_pools.h"
+#include "svn_hash.h"
+#include "svn_dirent_uri.h"
+#include "svn_sorts.h"
+
+#include "changed_paths.h"
+#include "fs_fs.h"
+#include "transaction.h"
+#include "util.h"
+
+#include "private/svn_fspath.h"
+#include "private/svn_string_private.h"
+#include "../libsvn_fs/fs-loader.h"
+
+#include "svn_private_config.h"
+
+/* The longest line that may terminate an index record: "r" followed by
+ * a revision number and a newline. */
+#define MAX_TRAILER_LEN (1 + SVN_INT64_BUFFER_SIZE + 1)
+
+/* Return TRUE if a change to CHANGED_PATH may be relevant to the history
+ * of PATH, i.e. if either one is a parent of (or the same as) the other.
+ */
+static svn_boolean_t
+is_related(const char *path,
+           const char *changed_path)
+{
+  return svn_fspath__skip_ancestor(path, changed_path) != NULL
+      || svn_fspath__skip_ancestor(changed_path, path) != NULL;
+}
+
+/* Parse the index CONTENTS of the shard starting at FIRST_REV.  Set
+ * *LAST_REV to the last revision for which the index contains a complete
+ * record, or to FIRST_REV - 1 if there is none.
+ *
+ * If PATH is not NULL, append all revisions within [START, END] that
+ * contain a change related to PATH to REVISIONS.
+ */
+static void
+scan_index(svn_revnum_t *last_rev,
+           apr_array_header_t *revisions,
+           const char *path,
+           svn_revnum_t start,
+           svn_revnum_t end,
+           svn_revnum_t first_rev,
+           svn_stringbuf_t *contents)
+{
+  char *line = contents->data;
+  char *eol;
+  svn_boolean_t related = FALSE;
+
+  *last_rev = first_rev - 1;
+  for (; (eol = strchr(line, '\n')) != NULL; line = eol + 1)
+    {
+      svn_revnum_t rev;
+      const char *rev_end;
+
+      *eol = '\0';
+      if (*line == '/')
+        {
+          if (path && !related)
+            related = is_related(path, line);
+          continue;
+        }
+
+      /* Anything that is not a well-formed record trailer for the next
+       * revision ends the part of the index that we can trust. */
+      if (*line != 'r'
+          || svn_revnum_parse(&rev, line + 1, &rev_end)
+          || *rev_end != '\0'
+          || rev != *last_rev + 1)
+        break;
+
+      *last_rev = rev;
+      if (related && rev >= start && rev <= end)
+        APR_ARRAY_PUSH(revisions, svn_revnum_t) = rev;
+
+      related = FALSE;
+    }
+}
+
+/* Read the index file at PATH into *CONTENTS.  Set it to NULL if the
+ * file does not exist.  Allocate the result in POOL. */
+static svn_error_t *
+read_index(svn_stringbuf_t **contents,
+           const char *path,
+           apr_pool_t *pool)
+{
+  svn_error_t *err = svn_stringbuf_from_file2(contents, path, pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      *contents = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(err);
+}
+
+/* Set *LAST_REV to the revision number in the record trailer at the end
+ * of the open index FILE.  Set it to SVN_INVALID_REVNUM if the file does
+ * not end with a complete record.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+read_last_rev(svn_revnum_t *last_rev,
+              apr_file_t *file,
+              apr_pool_t *scratch_pool)
+{
+  char buffer[MAX_TRAILER_LEN + 1];
+  apr_off_t size, offset;
+  apr_size_t len;
+  const char *line, *rev_end;
+
+  *last_rev = SVN_INVALID_REVNUM;
+
+  SVN_ERR(svn_io_file_size_get(&size, file, scratch_pool));
+  offset = size > MAX_TRAILER_LEN ? size - MAX_TRAILER_LEN : 0;
+  SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, scratch_pool));
+  SVN_ERR(svn_io_file_read_full2(file, buffer, MAX_TRAILER_LEN, &len,
+                                 NULL, scratch_pool));
+
+  if (len == 0 || buffer[len - 1] != '\n')
+    return SVN_NO_ERROR;
+  buffer[len - 1] = '\0';
+
+  line = strrchr(buffer, '\n');
+  if (line)
+    ++line;
+  else if (offset == 0)
+    line = buffer;
+  else
+    return SVN_NO_ERROR;
+
+  if (   *line == 'r'
+      && !svn_revnum_parse(last_rev, line + 1, &rev_end)
+      && *rev_end == '\0')
+    return SVN_NO_ERROR;
+
+  *last_rev = SVN_INVALID_REVNUM;
+  return SVN_NO_ERROR;
+}
+
+/* Append the index record for REV with CHANGED_PATHS (see
+ * svn_fs_fs__changed_paths_index_add) to BUFFER. */
+static void
+append_record(svn_stringbuf_t *buffer,
+              svn_revnum_t rev,
+              apr_hash_t *changed_paths,
+              apr_pool_t *scratch_pool)
+{
+  apr_hash_index_t *hi;
+
+  for (hi = apr_hash_first(scratch_pool, changed_paths);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      svn_stringbuf_appendcstr(buffer, apr_hash_this_key(hi));
+      svn_stringbuf_appendbyte(buffer, '\n');
+    }
+
+  svn_stringbuf_appendcstr(buffer, apr_psprintf(scratch_pool, "r%ld\n",
+                                                rev));
+}
+
+svn_error_t *
+svn_fs_fs__changed_paths_index_add(svn_fs_t *fs,
+                                   svn_revnum_t rev,
+                                   apr_hash_t *changed_paths,
+                                   apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  const char *path;
+  svn_stringbuf_t *record;
+  apr_file_t *file;
+  svn_revnum_t last_rev;
+  svn_error_t *err;
+
+  if (!ffd->changed_paths_index || !ffd->max_files_per_dir)
+    return SVN_NO_ERROR;
+
+  path = svn_fs_fs__path_changed_paths_index(fs, rev, scratch_pool);
+  record = svn_stringbuf_create_empty(scratch_pool);
+
+  if (rev % ffd->max_files_per_dir == 0)
+    {
+      /* First revision in this shard.  Start a new index file. */
+      SVN_ERR(svn_io_make_dir_recursively(svn_dirent_dirname(path,
+                                                             scratch_pool),
+                                          scratch_pool));
+      append_record(record, rev, changed_paths, scratch_pool);
+      return svn_error_trace(svn_io_file_create_bytes(path, record->data,
+                                                      record->len,
+                                                      scratch_pool));
+    }
+
+  err = svn_io_file_open(&file, path, APR_READ | APR_WRITE | APR_APPEND,
+                         APR_OS_DEFAULT, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err) && rev == 1)
+    {
+      /* Revision 0 never gets committed and is always empty.  Seed the
+       * first shard's index with it. */
+      svn_error_clear(err);
+      SVN_ERR(svn_io_make_dir_recursively(svn_dirent_dirname(path,
+                                                             scratch_pool),
+                                          scratch_pool));
+      svn_stringbuf_appendcstr(record, "r0\n");
+      append_record(record, rev, changed_paths, scratch_pool);
+      return svn_error_trace(svn_io_file_create_bytes(path, record->data,
+                                                      record->len,
+                                                      scratch_pool));
+    }
+  else if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      /* The index was not enabled at the start of this shard. */
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  /* Only extend the index if it covers every revision up to REV. */
+  SVN_ERR(read_last_rev(&last_rev, file, scratch_pool));
+  if (last_rev == rev - 1)
+    {
+      append_record(record, rev, changed_paths, scratch_pool);
+      SVN_ERR(svn_io_file_write_full(file, record->data, record->len, NULL,
+                                     scratch_pool));
+    }
+
+  return svn_error_trace(svn_io_file_close(file, scratch_pool));
+}
+
+svn_error_t *
+svn_fs_fs__changed_paths_index_build(svn_fs_t *fs,
+                                     apr_int64_t shard,
+                                     svn_cancel_func_t cancel_func,
+                                     void *cancel_baton,
+                                     apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_revnum_t first_rev, last_rev, rev;
+  const char *path, *temp_path;
+  svn_stringbuf_t *contents;
+  apr_file_t *file;
+  apr_pool_t *iterpool;
+
+  if (!ffd->changed_paths_index || !ffd->max_files_per_dir)
+    return SVN_NO_ERROR;
+
+  first_rev = (svn_revnum_t)(shard * ffd->max_files_per_dir);
+  path = svn_fs_fs__path_changed_paths_index(fs, first_rev, scratch_pool);
+
+  /* Nothing to do if the index got maintained during all commits. */
+  SVN_ERR(read_index(&contents, path, scratch_pool));
+  if (contents)
+    {
+      scan_index(&last_rev, NULL, NULL, 0, 0, first_rev, contents);
+      if (last_rev == first_rev + ffd->max_files_per_dir - 1)
+        return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_io_make_dir_recursively(svn_dirent_dirname(path,
+                                                         scratch_pool),
+                                      scratch_pool));
+  SVN_ERR(svn_io_open_unique_file3(&file, &temp_path,
+                                   svn_dirent_dirname(path, scratch_pool),
+                                   svn_io_file_del_on_pool_cleanup,
+                                   scratch_pool, scratch_pool));
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (rev = first_rev; rev < first_rev + ffd->max_files_per_dir; ++rev)
+    {
+      apr_hash_t *changed_paths;
+      svn_stringbuf_t *record;
+
+      svn_pool_clear(iterpool);
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(svn_fs_fs__paths_changed(&changed_paths, fs, rev, iterpool));
+
+      record = svn_stringbuf_create_empty(iterpool);
+      append_record(record, rev, changed_paths, iterpool);
+      SVN_ERR(svn_io_file_write_full(file, record->data, record->len, NULL,
+                                     iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  SVN_ERR(svn_io_file_close(file, scratch_pool));
+  SVN_ERR(svn_io_file_rename2(temp_path, path, FALSE, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__changed_revisions(apr_array_header_t **revisions,
+                             svn_fs_t *fs,
+                             const char *path,
+                             svn_revnum_t start,
+                             svn_revnum_t end,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_array_header_t *result;
+  svn_revnum_t first_rev;
+  apr_pool_t *iterpool;
+
+  *revisions = NULL;
+  if (!ffd->changed_paths_index || !ffd->max_files_per_dir)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_fs__ensure_revision_exists(end, fs, scratch_pool));
+
+  result = apr_array_make(result_pool, 16, sizeof(svn_revnum_t));
+  iterpool = svn_pool_create(scratch_pool);
+  for (first_rev = start - start % ffd->max_files_per_dir;
+       first_rev <= end;
+       first_rev += ffd->max_files_per_dir)
+    {
+      svn_stringbuf_t *contents;
+      svn_revnum_t last_rev;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(read_index(&contents,
+                         svn_fs_fs__path_changed_paths_index(fs, first_rev,
+                                                             iterpool),
+                         iterpool));
+      if (!contents)
+        return SVN_NO_ERROR;
+
+      /* The index must cover the whole part of the range in this shard. */
+      scan_index(&last_rev, result, path, start, end, first_rev, contents);
+      if (last_rev < MIN(end, first_rev + ffd->max_files_per_dir - 1))
+        return SVN_NO_ERROR;
+    }
+  svn_pool_destroy(iterpool);
+
+  *revisions = result;
+  return SVN_NO_ERROR;
+}
@@ -0,0 +1,90 @@
+/* changed_paths.h : interface to the FSFS changed paths index
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_FS_FS_CHANGED_PATHS_H
+#define SVN_LIBSVN_FS_FS_CHANGED_PATHS_H
+
+#include "svn_error.h"
+
+#include "fs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* The changed paths index is an optional, per-shard text file in
+ * PATH_CHANGED_PATHS_DIR.  For every revision of the shard, in ascending
+ * order, it lists the paths in that revision's changed paths list, one
+ * per line, followed by a line "r<revision>".  An incomplete trailing
+ * record (e.g. after a crash) simply ends the range of revisions that the
+ * index covers.
+ *
+ * The index is a pure hint.  Whenever it does not cover a revision,
+ * the callers have to fall back to reading the changed paths lists.
+ */
+
+/* Append the CHANGED_PATHS (a hash mapping const char * paths to
+ * svn_fs_path_change2_t *) of the just committed revision REV in FS to
+ * the respective changed paths index.  Do nothing if the index is disabled
+ * or if it does not cover the revision immediately preceding REV.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs_fs__changed_paths_index_add(svn_fs_t *fs,
+                                   svn_revnum_t rev,
+                                   apr_hash_t *changed_paths,
+                                   apr_pool_t *scratch_pool);
+
+/* Unless it is already complete, rebuild the changed paths index for
+ * SHARD in FS from the revisions' changed paths lists.  Do nothing if the
+ * index is disabled.  Use CANCEL_FUNC and CANCEL_BATON for cancellation
+ * and SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs_fs__changed_paths_index_build(svn_fs_t *fs,
+                                     apr_int64_t shard,
+                                     svn_cancel_func_t cancel_func,
+                                     void *cancel_baton,
+                                     apr_pool_t *scratch_pool);
+
+/* Implements the changed_revisions() FS loader vtable entry.
+ *
+ * Set *REVISIONS to the sorted array of svn_revnum_t in [START, END]
+ * whose changed paths list contain PATH, any parent or any descendant of
+ * it.  Set it to NULL if the index is disabled or incomplete for that
+ * range.  Allocate the result in RESULT_POOL and use SCRATCH_POOL for
+ * temporary allocations.
+ */
+svn_error_t *
+svn_fs_fs__changed_revisions(apr_array_header_t **revisions,
+                             svn_fs_t *fs,
+                             const char *path,
+                             svn_revnum_t start,
+                             svn_revnum_t end,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_FS_FS_CHANGED_PATHS_H */
@@ -244,6 +244,18 @@ svn_fs_fs__dag_get_predecessor_id(const svn_fs_id_t **id_p,
 }
 
 
+svn_error_t *
+svn_fs_fs__dag_get_skip_predecessor_id(const svn_fs_id_t **id_p,
+                                       dag_node_t *node)
+{
+  node_revision_t *noderev;
+
+  SVN_ERR(get_node_revision(&noderev, node));
+  *id_p = noderev->skip_id;
+  return SVN_NO_ERROR;
+}
+
+
 svn_error_t *
 svn_fs_fs__dag_get_predecessor_count(int *count,
                                      dag_node_t *node)
@@ -351,21 +363,21 @@ set_entry(dag_node_t *parent,
 }
 
 
-/* Make a new entry named NAME in PARENT.  If IS_DIR is true, then the
-   node revision the new entry points to will be a directory, else it
-   will be a file.  The new node will be allocated in POOL.  PARENT
-   must be mutable, and must not have an entry named NAME.
+/* Create a new node to become the entry named NAME in PARENT, without
+   adding it to PARENT yet.  If IS_DIR is true, then the node revision
+   will be a directory, else it will be a file.  The new node will be
+   allocated in POOL.  PARENT must be mutable.
 
    Use POOL for all allocations, except caching the node_revision in PARENT.
  */
 static svn_error_t *
-make_entry(dag_node_t **child_p,
-           dag_node_t *parent,
-           const char *parent_path,
-           const char *name,
-           svn_boolean_t is_dir,
-           const svn_fs_fs__id_part_t *txn_id,
-           apr_pool_t *pool)
+make_child_node(dag_node_t **child_p,
+                dag_node_t *parent,
+                const char *parent_path,
+                const char *name,
+                svn_boolean_t is_dir,
+                const svn_fs_fs__id_part_t *txn_id,
+                apr_pool_t *pool)
 {
   const svn_fs_id_t *new_node_id;
   node_revision_t new_noderev, *parent_noderev;
@@ -406,14 +418,35 @@ make_entry(dag_node_t **child_p,
            txn_id, pool));
 
   /* Create a new dag_node_t for our new node */
-  SVN_ERR(svn_fs_fs__dag_get_node(child_p, svn_fs_fs__dag_get_fs(parent),
-                                  new_node_id, pool));
+  return svn_error_trace(svn_fs_fs__dag_get_node(child_p,
+                                                 svn_fs_fs__dag_get_fs(parent),
+                                                 new_node_id, pool));
+}
+
+/* Make a new entry named NAME in PARENT.  If IS_DIR is true, then the
+   node revision the new entry points to will be a directory, else it
+   will be a file.  The new node will be allocated in POOL.  PARENT
+   must be mutable, and must not have an entry named NAME.
+
+   Use POOL for all allocations, except caching the node_revision in PARENT.
+ */
+static svn_error_t *
+make_entry(dag_node_t **child_p,
+           dag_node_t *parent,
+           const char *parent_path,
+           const char *name,
+           svn_boolean_t is_dir,
+           const svn_fs_fs__id_part_t *txn_id,
+           apr_pool_t *pool)
+{
+  SVN_ERR(make_child_node(child_p, parent, parent_path, name, is_dir,
+                          txn_id, pool));
 
   /* We can safely call set_entry because we already know that
      PARENT is mutable, and we just created CHILD, so we know it has
      no ancestors (therefore, PARENT cannot be an ancestor of CHILD) */
   return set_entry(parent, name, svn_fs_fs__dag_get_id(*child_p),
-                   new_noderev.kind, txn_id, pool);
+                   svn_fs_fs__dag_node_kind(*child_p), txn_id, pool);
 }
 
 
@@ -933,6 +966,44 @@ svn_fs_fs__dag_make_file(dag_node_t **child_p,
 }
 
 
+svn_error_t *
+svn_fs_fs__dag_make_files(apr_array_header_t **children_p,
+                          dag_node_t *parent,
+                          const char *parent_path,
+                          const apr_array_header_t *names,
+                          const svn_fs_fs__id_part_t *txn_id,
+                          apr_pool_t *pool)
+{
+  apr_array_header_t *entries = apr_array_make(pool, names->nelts,
+                                               sizeof(svn_fs_dirent_t *));
+  node_revision_t *parent_noderev;
+  int i;
+
+  *children_p = apr_array_make(pool, names->nelts, sizeof(dag_node_t *));
+  for (i = 0; i < names->nelts; ++i)
+    {
+      const char *name = APR_ARRAY_IDX(names, i, const char *);
+      svn_fs_dirent_t *entry = apr_pcalloc(pool, sizeof(*entry));
+      dag_node_t *child;
+
+      SVN_ERR(make_child_node(&child, parent, parent_path, name, FALSE,
+                              txn_id, pool));
+      APR_ARRAY_PUSH(*children_p, dag_node_t *) = child;
+
+      entry->name = name;
+      entry->id = svn_fs_fs__dag_get_id(child);
+      entry->kind = svn_node_file;
+      APR_ARRAY_PUSH(entries, svn_fs_dirent_t *) = entry;
+    }
+
+  /* As in make_entry, the new children can't be ancestors of PARENT. */
+  SVN_ERR(get_node_revision(&parent_noderev, parent));
+  return svn_error_trace(svn_fs_fs__set_entries(parent->fs, txn_id,
+                                                parent_noderev, entries,
+                                                pool));
+}
+
+
 svn_error_t *
 svn_fs_fs__dag_make_dir(dag_node_t **child_p,
                         dag_node_t *parent,
@@ -1019,6 +1090,29 @@ svn_fs_fs__dag_try_process_file_contents(svn_boolean_t *success,
                                               processor, baton, pool);
 }
 
+svn_error_t *
+svn_fs_fs__dag_file_contents_location(const char **file_path,
+                                      apr_off_t *offset,
+                                      svn_filesize_t *length,
+                                      dag_node_t *node,
+                                      apr_pool_t *result_pool,
+                                      apr_pool_t *scratch_pool)
+{
+  node_revision_t *noderev;
+
+  /* Make sure our node is a file. */
+  if (node->kind != svn_node_file)
+    return svn_error_createf
+      (SVN_ERR_FS_NOT_FILE, NULL,
+       "Attempted to get textual contents of a *non*-file node");
+
+  SVN_ERR(get_node_revision(&noderev, node));
+
+  return svn_fs_fs__get_contents_location(file_path, offset, length,
+                                          node->fs, noderev->data_rep,
+                                          result_pool, scratch_pool);
+}
+
 
 svn_error_t *
 svn_fs_fs__dag_file_length(svn_filesize_t *length,
@@ -129,6 +129,13 @@ svn_error_t *svn_fs_fs__dag_get_predecessor_id(const svn_fs_id_t **id_p,
                                                dag_node_t *node);
 
 
+/* Set *ID_P to the node revision ID of NODE's skip predecessor, or NULL
+   if NODE has no skip link recorded.
+ */
+svn_error_t *svn_fs_fs__dag_get_skip_predecessor_id(const svn_fs_id_t **id_p,
+                                                    dag_node_t *node);
+
+
 /* Set *COUNT to the number of predecessors NODE has (recursively), or
    -1 if not known.
  */
@@ -426,6 +433,21 @@ svn_fs_fs__dag_try_process_file_contents(svn_boolean_t *success,
                                          void* baton,
                                          apr_pool_t *pool);
 
+/* Find out whether the contents of the file NODE are stored verbatim in
+   a revision or pack file.  If so, set *FILE_PATH to that file's path,
+   allocated in RESULT_POOL, *OFFSET to the position of the contents
+   within it and *LENGTH to their size.  Otherwise, set *FILE_PATH to NULL.
+
+   Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs_fs__dag_file_contents_location(const char **file_path,
+                                      apr_off_t *offset,
+                                      svn_filesize_t *length,
+                                      dag_node_t *node,
+                                      apr_pool_t *result_pool,
+                                      apr_pool_t *scratch_pool);
+
 
 /* Set *STREAM_P to a delta stream that will turn the contents of SOURCE into
    the contents of TARGET, allocated in POOL.  If SOURCE is null, the empty
@@ -508,6 +530,21 @@ svn_error_t *svn_fs_fs__dag_make_file(dag_node_t **child_p,
                                       const svn_fs_fs__id_part_t *txn_id,
                                       apr_pool_t *pool);
 
+/* Like svn_fs_fs__dag_make_file() but create a file for each of the
+   NAMES (const char *) in PARENT and add all of them to PARENT in a
+   single update.  Set *CHILDREN_P to an array of the new dag_node_t *,
+   in the order of NAMES.  None of the NAMES may already exist in PARENT
+   and NAMES must not contain duplicates.
+
+   Use POOL for all allocations.
+ */
+svn_error_t *svn_fs_fs__dag_make_files(apr_array_header_t **children_p,
+                                       dag_node_t *parent,
+                                       const char *parent_path,
+                                       const apr_array_header_t *names,
+                                       const svn_fs_fs__id_part_t *txn_id,
+                                       apr_pool_t *pool);
+
 
 
 /* Copies */
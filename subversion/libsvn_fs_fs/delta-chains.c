@@ -0,0 +1,131 @@
+/* delta-chains.c -- implements the svn_fs_fs__find_long_delta_chains
+ *                   private API
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_pools.h"
+#include "private/svn_fs_fs_private.h"
+
+#include "cached_data.h"
+#include "fs_fs.h"
+#include "transaction.h"
+
+#include "../libsvn_fs/fs-loader.h"
+
+/* If REP has been created in REVISION, determine its delta chain length
+ * in FS and report it through CALLBACK_FUNC with CALLBACK_BATON if it
+ * exceeds MAX_CHAIN_LENGTH.  PATH and IS_PROPS will be passed through.
+ * Use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+check_rep(svn_fs_t *fs,
+          representation_t *rep,
+          svn_revnum_t revision,
+          const char *path,
+          svn_boolean_t is_props,
+          int max_chain_length,
+          svn_fs_fs__long_chain_func_t callback_func,
+          void *callback_baton,
+          apr_pool_t *scratch_pool)
+{
+  int chain_length;
+  int shard_count;
+
+  /* Shared and unchanged reps will be checked for the revision that
+   * created them. */
+  if (rep == NULL || rep->revision != revision)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_fs__rep_chain_length(&chain_length, &shard_count, rep, fs,
+                                      scratch_pool));
+  if (chain_length > max_chain_length)
+    SVN_ERR(callback_func(callback_baton, revision, path, is_props,
+                          chain_length, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__find_long_delta_chains(svn_fs_t *fs,
+                                  svn_revnum_t start,
+                                  svn_revnum_t end,
+                                  int max_chain_length,
+                                  svn_fs_fs__long_chain_func_t callback_func,
+                                  void *callback_baton,
+                                  svn_cancel_func_t cancel_func,
+                                  void *cancel_baton,
+                                  apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_pool_t *subpool = svn_pool_create(scratch_pool);
+  svn_revnum_t revision;
+
+  SVN_ERR(svn_fs_fs__ensure_revision_exists(start, fs, scratch_pool));
+  SVN_ERR(svn_fs_fs__ensure_revision_exists(end, fs, scratch_pool));
+
+  /* Delta bases with chains of that length or longer will be rejected
+   * by choose_delta_base() when writing new representations. */
+  if (max_chain_length == 0)
+    max_chain_length = 2 * (int)ffd->max_linear_deltification + 1;
+
+  for (revision = start; revision <= end; ++revision)
+    {
+      apr_hash_t *changed_paths;
+      apr_hash_index_t *hi;
+
+      svn_pool_clear(iterpool);
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      /* Every representation created in REVISION belongs to a node
+       * that has been changed in REVISION. */
+      SVN_ERR(svn_fs_fs__paths_changed(&changed_paths, fs, revision,
+                                       iterpool));
+      for (hi = apr_hash_first(iterpool, changed_paths);
+           hi;
+           hi = apr_hash_next(hi))
+        {
+          const char *path = apr_hash_this_key(hi);
+          svn_fs_path_change2_t *change = apr_hash_this_val(hi);
+          node_revision_t *noderev;
+
+          svn_pool_clear(subpool);
+          if (change->change_kind == svn_fs_path_change_delete)
+            continue;
+
+          SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs,
+                                               change->node_rev_id,
+                                               subpool, subpool));
+          SVN_ERR(check_rep(fs, noderev->data_rep, revision, path, FALSE,
+                            max_chain_length, callback_func, callback_baton,
+                            subpool));
+          SVN_ERR(check_rep(fs, noderev->prop_rep, revision, path, TRUE,
+                            max_chain_length, callback_func, callback_baton,
+                            subpool));
+        }
+    }
+
+  svn_pool_destroy(subpool);
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
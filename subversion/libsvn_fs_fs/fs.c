@@ -33,6 +33,8 @@
 #include "svn_version.h"
 #include "svn_pools.h"
 #include "fs.h"
+#include "batch_fsync.h"
+#include "changed_paths.h"
 #include "fs_fs.h"
 #include "tree.h"
 #include "lock.h"
@@ -42,6 +44,7 @@
 #include "recovery.h"
 #include "rep-cache.h"
 #include "revprops.h"
+#include "rev_file.h"
 #include "transaction.h"
 #include "util.h"
 #include "verify.h"
@@ -123,6 +126,15 @@ fs_serialized_init(svn_fs_t *fs, apr_pool_t *common_pool, apr_pool_t *pool)
          transaction list and free transaction pointer. */
       SVN_ERR(svn_mutex__init(&ffsd->txn_list_lock, TRUE, common_pool));
 
+      /* Writers of proto-rev fragments allocate IDs and item indexes
+         without holding the proto-rev lock. */
+      SVN_ERR(svn_mutex__init(&ffsd->txn_ids_lock,
+                              SVN_FS_FS__USE_LOCK_MUTEX, common_pool));
+
+      /* Committers in group commit mode coordinate their final fsync. */
+      SVN_ERR(svn_fs_fs__fsync_group_create(&ffsd->current_fsync_group,
+                                            common_pool));
+
       key = apr_pstrdup(common_pool, key);
       status = apr_pool_userdata_set(ffsd, key, NULL, common_pool);
       if (status)
@@ -279,7 +291,10 @@ static fs_vtable_t fs_vtable = {
   fs_info,
   svn_fs_fs__verify_root,
   fs_freeze,
-  fs_set_errcall
+  fs_set_errcall,
+  svn_fs_fs__changed_revisions,
+  svn_fs_fs__revision_files,
+  svn_fs_fs__build_rep_cache
 };
 
 
@@ -367,6 +382,34 @@ fs_open(svn_fs_t *fs,
 
 
 
+svn_error_t *
+svn_fs_fs__open_instance(svn_fs_t **instance_p,
+                         svn_fs_t *fs,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_fs_t *instance = apr_pcalloc(result_pool, sizeof(*instance));
+
+  instance->pool = result_pool;
+  instance->warning = fs->warning;
+  instance->warning_baton = fs->warning_baton;
+  instance->config = fs->config ? apr_hash_copy(result_pool, fs->config)
+                                : NULL;
+
+  SVN_ERR(initialize_fs_struct(instance));
+  SVN_ERR(svn_fs_fs__open(instance, fs->path, scratch_pool));
+  SVN_ERR(svn_fs_fs__initialize_caches(instance, scratch_pool));
+
+  /* No need to look up the shared data again; it is the same for all
+     instances of this repository. */
+  ((fs_fs_data_t *)instance->fsap_data)->shared = ffd->shared;
+
+  *instance_p = instance;
+
+  return SVN_NO_ERROR;
+}
+
 /* This implements the fs_library_vtable_t.open_for_recovery() API. */
 static svn_error_t *
 fs_open_for_recovery(svn_fs_t *fs,
@@ -466,6 +509,7 @@ fs_verify(svn_fs_t *fs, const char *path,
 static svn_error_t *
 fs_pack(svn_fs_t *fs,
         const char *path,
+        int jobs,
         svn_fs_pack_notify_t notify_func,
         void *notify_baton,
         svn_cancel_func_t cancel_func,
@@ -475,7 +519,7 @@ fs_pack(svn_fs_t *fs,
         apr_pool_t *common_pool)
 {
   SVN_ERR(fs_open(fs, path, common_pool_lock, pool, common_pool));
-  return svn_fs_fs__pack(fs, 0, notify_func, notify_baton,
+  return svn_fs_fs__pack(fs, 0, jobs, notify_func, notify_baton,
                          cancel_func, cancel_baton, pool);
 }
 
@@ -546,6 +590,9 @@ static svn_error_t *
 fs_delete_fs(const char *path,
              apr_pool_t *pool)
 {
+  /* Open files can't be deleted on some platforms. */
+  SVN_ERR(svn_fs_fs__purge_file_handles());
+
   /* Remove everything. */
   return svn_error_trace(svn_io_remove_dir2(path, FALSE, NULL, NULL, pool));
 }
@@ -625,6 +672,8 @@ svn_fs_fs__init(const svn_version_t *loader_version,
                              loader_version->major);
   SVN_ERR(svn_ver_check_list2(fs_version(), checklist, svn_ver_equal));
 
+  SVN_ERR(svn_fs_fs__batch_fsync_init());
+
   *vtable = &library_vtable;
   return SVN_NO_ERROR;
 }
@@ -53,6 +53,8 @@ extern "C" {
 #define PATH_FORMAT           "format"           /* Contains format number */
 #define PATH_UUID             "uuid"             /* Contains UUID */
 #define PATH_CURRENT          "current"          /* Youngest revision */
+#define PATH_NEXT             "next"             /* Youngest revision, before
+                                                    it becomes 'current' */
 #define PATH_LOCK_FILE        "write-lock"       /* Revision lock file */
 #define PATH_PACK_LOCK_FILE   "pack-lock"        /* Pack lock file */
 #define PATH_REVS_DIR         "revs"             /* Directory of revisions */
@@ -60,6 +62,8 @@ extern "C" {
 #define PATH_TXNS_DIR         "transactions"     /* Directory of transactions in
                                                     repos w/o log addressing */
 #define PATH_NODE_ORIGINS_DIR "node-origins"     /* Lazy node-origin cache */
+#define PATH_CHANGED_PATHS_DIR "changed-paths"  /* Per-shard changed paths
+                                                    index */
 #define PATH_TXN_PROTOS_DIR   "txn-protorevs"    /* Directory of proto-revs */
 #define PATH_TXN_CURRENT      "txn-current"      /* File with next txn key */
 #define PATH_TXN_CURRENT_LOCK "txn-current-lock" /* Lock for txn-current */
@@ -91,6 +95,12 @@ extern "C" {
 #define PATH_EXT_REV_LOCK  ".rev-lock"     /* Extension of protorev lock file */
 #define PATH_TXN_ITEM_INDEX "itemidx"      /* File containing the current item
                                               index number */
+#define PATH_TXN_IDS_LOCK  "ids.lock"      /* Lock file for ID and item index
+                                              allocation */
+#define PATH_TXN_FRAGMENTS "fragments"   /* Directory of proto-rev fragments
+                                              written in parallel */
+#define PATH_EXT_FRAGMENT  ".frag"         /* Extension of the descriptor of
+                                              a complete fragment */
 #define PATH_INDEX          "index"        /* name of index files w/o ext */
 
 /* Names of files in legacy FS formats */
@@ -107,7 +117,10 @@ extern "C" {
 #define CONFIG_OPTION_ENABLE_PROPS_DELTIFICATION "enable-props-deltification"
 #define CONFIG_OPTION_MAX_DELTIFICATION_WALK     "max-deltification-walk"
 #define CONFIG_OPTION_MAX_LINEAR_DELTIFICATION   "max-linear-deltification"
+#define CONFIG_OPTION_MAX_DELTA_BASE_SIZE        "max-delta-base-size"
 #define CONFIG_OPTION_COMPRESSION_LEVEL  "compression-level"
+#define CONFIG_OPTION_COMPRESSION        "compression"
+#define CONFIG_OPTION_CONTENT_DEFINED_WINDOWS "content-defined-windows"
 #define CONFIG_SECTION_PACKED_REVPROPS   "packed-revprops"
 #define CONFIG_OPTION_REVPROP_PACK_SIZE  "revprop-pack-size"
 #define CONFIG_OPTION_COMPRESS_PACKED_REVPROPS  "compress-packed-revprops"
@@ -115,6 +128,14 @@ extern "C" {
 #define CONFIG_OPTION_BLOCK_SIZE         "block-size"
 #define CONFIG_OPTION_L2P_PAGE_SIZE      "l2p-page-size"
 #define CONFIG_OPTION_P2L_PAGE_SIZE      "p2l-page-size"
+#define CONFIG_OPTION_GROUP_COMMIT       "group-commit"
+#define CONFIG_OPTION_HOTCOPY_THREADS    "hotcopy-threads"
+#define CONFIG_SECTION_CHANGED_PATHS     "changed-paths"
+#define CONFIG_OPTION_ENABLE_CHANGED_PATHS_INDEX "enable-changed-paths-index"
+#define CONFIG_SECTION_MERGEINFO_INDEX   "mergeinfo-index"
+#define CONFIG_OPTION_ENABLE_MERGEINFO_INDEX "enable-mergeinfo-index"
+#define CONFIG_SECTION_LOCKS             "locks"
+#define CONFIG_OPTION_ENABLE_LOCK_INDEX  "enable-lock-index"
 #define CONFIG_SECTION_DEBUG             "debug"
 #define CONFIG_OPTION_PACK_AFTER_COMMIT  "pack-after-commit"
 
@@ -125,7 +146,7 @@ extern "C" {
    Note: If you bump this, please update the switch statement in
          svn_fs_fs__create() as well.
  */
-#define SVN_FS_FS__FORMAT_NUMBER   7
+#define SVN_FS_FS__FORMAT_NUMBER   8
 
 /* The minimum format number that supports svndiff version 1.  */
 #define SVN_FS_FS__MIN_SVNDIFF1_FORMAT 2
@@ -180,6 +201,12 @@ extern "C" {
 /* Minimum format number that supports per-instance filesystem IDs. */
 #define SVN_FS_FS__MIN_INSTANCE_ID_FORMAT 7
 
+/* Minimum format number that supports svndiff version 2 (LZ4) deltas. */
+#define SVN_FS_FS__MIN_SVNDIFF2_FORMAT 8
+
+/* Minimum format number that stores skip pointers into node histories. */
+#define SVN_FS_FS__MIN_SKIP_PREDECESSOR_FORMAT 8
+
 /* The minimum format number that supports a configuration file (fsfs.conf) */
 #define SVN_FS_FS__MIN_CONFIG_FILE 4
 
@@ -198,6 +225,10 @@ extern "C" {
    At 100..300 bytes per entry, this limits the allocation to ~30kB. */
 #define SVN_FS_FS__CHANGES_BLOCK_SIZE 100
 
+/* Upper limit to the number of packed shards that hotcopy copies
+   concurrently, i.e. to the hotcopy-threads setting. */
+#define SVN_FS_FS__MAX_HOTCOPY_THREADS 32
+
 /* Private FSFS-specific data shared between all svn_txn_t objects that
    relate to a particular transaction in a filesystem (as identified
    by transaction id and filesystem UUID).  Objects of this type are
@@ -241,7 +272,12 @@ typedef struct fs_fs_shared_data_t
      declaration here.  Any subset may be acquired and held at any given
      time but their relative acquisition order must not change.
 
-     (lock 'txn-current' before 'pack' before 'write' before 'txn-list') */
+     (lock 'txn-current' before 'pack' before 'write' before 'txn-list'
+      before 'txn-ids') */
+
+  /* A lock for intra-process synchronization when allocating node IDs,
+     copy IDs or item indexes within any transaction. */
+  svn_mutex__t *txn_ids_lock;
 
   /* A lock for intra-process synchronization when accessing the TXNS list. */
   svn_mutex__t *txn_list_lock;
@@ -258,6 +294,10 @@ typedef struct fs_fs_shared_data_t
      txn-current file. */
   svn_mutex__t *txn_current_lock;
 
+  /* Lets concurrent committers share the final fsync of the 'current'
+     file's directory entry in group commit mode. */
+  struct svn_fs_fs__fsync_group_t *current_fsync_group;
+
   /* The common pool, under which this object is allocated, subpools
      of which are used to allocate the transaction objects. */
   apr_pool_t *common_pool;
@@ -323,6 +363,17 @@ typedef struct fs_fs_data_t
    * (not just the one bit that we need, atm). */
   svn_boolean_t use_block_read;
 
+  /* If set, block reads trigger reading the following blocks in a
+   * background thread.  Implies USE_BLOCK_READ. */
+  svn_boolean_t use_read_ahead;
+
+  /* State of the read-ahead thread.  NULL until first used. */
+  struct svn_fs_fs__read_ahead_t *read_ahead;
+
+  /* Access profile to use for item placement when packing.  NULL if
+   * there is none. */
+  const char *pack_access_profile;
+
   /* The revision that was youngest, last time we checked. */
   svn_revnum_t youngest_rev_cache;
 
@@ -352,6 +403,11 @@ typedef struct fs_fs_data_t
      names to (svn_fs_dirent_t *). */
   svn_cache__t *dir_cache;
 
+  /* Directories too large for DIR_CACHE, cached in chunks of entries;
+     maps from window_cache_key_t to svn_fs_fs__dir_data_t.  The chunk
+     index -1 holds the first entry of each chunk.  See cached_data.c. */
+  svn_cache__t *dir_chunk_cache;
+
   /* Fulltext cache; currently only used with memcached.  Maps from
      rep key (revision/offset) to svn_stringbuf_t. */
   svn_cache__t *fulltext_cache;
@@ -365,6 +421,15 @@ typedef struct fs_fs_data_t
      will be written to the cache but the getter returns apr_hash_t. */
   svn_cache__t *revprop_cache;
 
+  /* Packed revprop manifests read by this FS object.  Maps the shard
+     number (apr_int64_t) to the apr_array_header_t * of const char *
+     pack file names, i.e. packed_revprops_t.MANIFEST in revprops.c.  Only
+     valid for REVPROP_MANIFESTS_PREFIX matching REVPROP_PREFIX.  Lazily
+     allocated in REVPROP_MANIFESTS_POOL. */
+  apr_hash_t *revprop_manifests;
+  apr_uint64_t revprop_manifests_prefix;
+  apr_pool_t *revprop_manifests_pool;
+
   /* Node properties cache.  Maps from rep key to apr_hash_t. */
   svn_cache__t *properties_cache;
 
@@ -441,6 +506,25 @@ typedef struct fs_fs_data_t
   /* Thread-safe boolean */
   svn_atomic_t rep_cache_db_opened;
 
+  /* Bloom filter over the keys in REP_CACHE_DB, NULL if not available.
+     See rep-cache.c. */
+  struct svn_fs_fs__rep_filter_t *rep_filter;
+
+  /* Number of rep-cache lookups that did not find a match. */
+  apr_uint64_t rep_cache_misses;
+
+  /* The sqlite database used for the mergeinfo index. */
+  svn_sqlite__db_t *mergeinfo_index_db;
+
+  /* Thread-safe boolean */
+  svn_atomic_t mergeinfo_index_db_opened;
+
+  /* The sqlite database used for the lock index. */
+  svn_sqlite__db_t *lock_index_db;
+
+  /* Thread-safe boolean */
+  svn_atomic_t lock_index_db_opened;
+
   /* The oldest revision not in a pack file.  It also applies to revprops
    * if revprop packing has been enabled by the FSFS format version. */
   svn_revnum_t min_unpacked_rev;
@@ -469,12 +553,42 @@ typedef struct fs_fs_data_t
    * deltification history after which skip deltas will be used. */
   apr_int64_t max_linear_deltification;
 
+  /* File contents larger than this (in bytes) will not be used as delta
+   * bases.  0 for no limit. */
+  apr_int64_t max_delta_base_size;
+
   /* Compression level to use with txdelta storage format in new revs. */
   int delta_compression_level;
 
+  /* Svndiff version to use for deltas in new revs.  2 selects LZ4,
+   * 1 selects zlib with DELTA_COMPRESSION_LEVEL. */
+  int delta_svndiff_version;
+
+  /* Whether to choose delta window boundaries by content. */
+  svn_boolean_t content_defined_windows;
+
   /* Pack after every commit. */
   svn_boolean_t pack_after_commit;
 
+  /* Release the write lock before the final fsync of a commit and share
+     that fsync with concurrent committers. */
+  svn_boolean_t group_commit;
+
+  /* Number of packed shards that hotcopy may copy concurrently,
+     1 .. SVN_FS_FS__MAX_HOTCOPY_THREADS. */
+  int hotcopy_threads;
+
+  /* Maintain the per-shard changed paths index on commit and pack and
+     use it to answer svn_fs__get_changed_revisions(). */
+  svn_boolean_t changed_paths_index;
+
+  /* Answer descendant mergeinfo queries from the mergeinfo index and
+     add missing entries to it. */
+  svn_boolean_t mergeinfo_index;
+
+  /* Keep all locks in the lock index and answer lock queries from it. */
+  svn_boolean_t lock_index;
+
   /* Per-instance filesystem ID, which provides an additional level of
      uniqueness for filesystems that share the same UUID, but should
      still be distinguishable (e.g. backups produced by svn_fs_hotcopy()
@@ -581,6 +695,11 @@ typedef struct node_revision_t
      for this node revision */
   const svn_fs_id_t *predecessor_id;
 
+  /* The predecessor with PREDECESSOR_COUNT & (PREDECESSOR_COUNT - 1)
+     predecessors of its own, or NULL if that is PREDECESSOR_ID or has
+     not been recorded. */
+  const svn_fs_id_t *skip_id;
+
   /* If this node-rev is a copy, where was it copied from? */
   const char *copyfrom_path;
   svn_revnum_t copyfrom_rev;
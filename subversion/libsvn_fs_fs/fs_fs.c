@@ -37,6 +37,8 @@
 #include "cached_data.h"
 #include "id.h"
 #include "index.h"
+#include "lock-index.h"
+#include "mergeinfo-index.h"
 #include "rep-cache.h"
 #include "revprops.h"
 #include "transaction.h"
@@ -45,6 +47,7 @@
 
 #include "private/svn_fs_util.h"
 #include "private/svn_io_private.h"
+#include "private/svn_sorts_private.h"
 #include "private/svn_string_private.h"
 #include "private/svn_subr_private.h"
 #include "../libsvn_fs/fs-loader.h"
@@ -109,6 +112,12 @@ svn_fs_fs__path_current(svn_fs_t *fs, apr_pool_t *pool)
   return svn_dirent_join(fs->path, PATH_CURRENT, pool);
 }
 
+const char *
+svn_fs_fs__path_next(svn_fs_t *fs, apr_pool_t *pool)
+{
+  return svn_dirent_join(fs->path, PATH_NEXT, pool);
+}
+
 
 
 /* Get a lock on empty file LOCK_FILENAME, creating it in POOL. */
@@ -159,6 +168,13 @@ typedef struct with_lock_baton_t
   /* If true, set FS->HAS_WRITE_LOCK after we acquired the lock. */
   svn_boolean_t is_global_lock;
 
+  /* Name of the lock in the lock statistics. */
+  const char *lock_name;
+
+  /* If lock statistics are being collected, the time at which we started
+     to acquire this lock.  0 otherwise. */
+  apr_time_t wait_start;
+
   /* Function body to execute after we acquired the lock.
      This may be user-provided or a nested call to with_lock(). */
   svn_error_t *(*body)(void *baton,
@@ -191,12 +207,21 @@ with_some_lock_file(with_lock_baton_t *baton)
 {
   apr_pool_t *pool = baton->lock_pool;
   svn_error_t *err = get_lock_on_filesystem(baton->lock_path, pool);
+  apr_time_t locked = 0;
 
   if (!err)
     {
       svn_fs_t *fs = baton->fs;
       fs_fs_data_t *ffd = fs->fsap_data;
 
+      /* Waiting includes the in-process mutex as well as the file lock. */
+      if (baton->wait_start)
+        {
+          locked = apr_time_now();
+          svn_mutex__stats_add_wait(baton->lock_name,
+                                    locked - baton->wait_start);
+        }
+
       if (baton->is_global_lock)
         {
           /* set the "got the lock" flag and register reset function */
@@ -221,6 +246,11 @@ with_some_lock_file(with_lock_baton_t *baton)
         err = baton->body(baton->baton, pool);
     }
 
+  /* File locks of nested lock batons get released along with the
+     outermost one.  Close enough. */
+  if (locked)
+    svn_mutex__stats_add_hold(baton->lock_name, apr_time_now() - locked);
+
   if (baton->is_outer_most_lock)
     svn_pool_destroy(pool);
 
@@ -236,6 +266,8 @@ with_lock(void *baton,
           apr_pool_t *pool)
 {
   with_lock_baton_t *lock_baton = baton;
+
+  lock_baton->wait_start = svn_mutex__stats_enabled() ? apr_time_now() : 0;
   SVN_MUTEX__WITH_LOCK(lock_baton->mutex, with_some_lock_file(lock_baton));
 
   return SVN_NO_ERROR;
@@ -265,6 +297,7 @@ init_lock_baton(with_lock_baton_t *baton,
       baton->mutex = ffsd->fs_write_lock;
       baton->lock_path = svn_fs_fs__path_lock(baton->fs, baton->lock_pool);
       baton->is_global_lock = TRUE;
+      baton->lock_name = "fsfs-write-lock";
       break;
 
     case txn_lock:
@@ -272,6 +305,7 @@ init_lock_baton(with_lock_baton_t *baton,
       baton->lock_path = svn_fs_fs__path_txn_current_lock(baton->fs,
                                                           baton->lock_pool);
       baton->is_global_lock = FALSE;
+      baton->lock_name = "fsfs-txn-current-lock";
       break;
 
     case pack_lock:
@@ -279,6 +313,7 @@ init_lock_baton(with_lock_baton_t *baton,
       baton->lock_path = svn_fs_fs__path_pack_lock(baton->fs,
                                                    baton->lock_pool);
       baton->is_global_lock = FALSE;
+      baton->lock_name = "fsfs-pack-lock";
       break;
     }
 }
@@ -683,21 +718,55 @@ verify_block_size(apr_int64_t block_size,
   return SVN_NO_ERROR;
 }
 
-/* Read the configuration information of the file system at FS_PATH
- * and set the respective values in FFD.  Use pools as usual.
+/* Read the "compression" option from CONFIG and set *SVNDIFF_VERSION
+ * accordingly for a repository of the given FORMAT.  "none" will also
+ * reset *COMPRESSION_LEVEL, which is otherwise left untouched.
+ *
+ * LZ4 falls back to zlib if FORMAT or the current build does not
+ * support svndiff2.
  */
 static svn_error_t *
-read_config(fs_fs_data_t *ffd,
-            const char *fs_path,
-            apr_pool_t *result_pool,
-            apr_pool_t *scratch_pool)
+read_compression_config(int *svndiff_version,
+                        int *compression_level,
+                        svn_config_t *config,
+                        int format)
 {
-  svn_config_t *config;
+  const char *compression;
 
-  SVN_ERR(svn_config_read3(&config,
-                           svn_dirent_join(fs_path, PATH_CONFIG, scratch_pool),
-                           FALSE, FALSE, FALSE, scratch_pool));
+  svn_config_get(config, &compression, CONFIG_SECTION_DELTIFICATION,
+                 CONFIG_OPTION_COMPRESSION, "zlib");
+
+  *svndiff_version = 1;
+  if (svn_cstring_casecmp(compression, "none") == 0)
+    {
+      *compression_level = SVN_DELTA_COMPRESSION_LEVEL_NONE;
+    }
+  else if (svn_cstring_casecmp(compression, "lz4") == 0)
+    {
+      if (   format >= SVN_FS_FS__MIN_SVNDIFF2_FORMAT
+          && svn_lz4__compiled_version())
+        *svndiff_version = 2;
+    }
+  else if (svn_cstring_casecmp(compression, "zlib") != 0)
+    {
+      return svn_error_createf(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                               _("'%s' is not a valid value for fsfs.conf "
+                                 "setting '%s'."),
+                               compression, CONFIG_OPTION_COMPRESSION);
+    }
+
+  return SVN_NO_ERROR;
+}
 
+/* Set the values in FFD that are controlled by the file system
+ * configuration CONFIG.  Use pools as usual.
+ */
+static svn_error_t *
+apply_config(fs_fs_data_t *ffd,
+             svn_config_t *config,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
   /* Initialize ffd->rep_sharing_allowed. */
   if (ffd->format >= SVN_FS_FS__MIN_REP_SHARING_FORMAT)
     SVN_ERR(svn_config_get_bool(config, &ffd->rep_sharing_allowed,
@@ -727,6 +796,10 @@ read_config(fs_fs_data_t *ffd,
                                    CONFIG_SECTION_DELTIFICATION,
                                    CONFIG_OPTION_MAX_LINEAR_DELTIFICATION,
                                    SVN_FS_FS_MAX_LINEAR_DELTIFICATION));
+      SVN_ERR(svn_config_get_int64(config, &ffd->max_delta_base_size,
+                                   CONFIG_SECTION_DELTIFICATION,
+                                   CONFIG_OPTION_MAX_DELTA_BASE_SIZE, 0));
+      ffd->max_delta_base_size = MAX(0, ffd->max_delta_base_size) * 1024;
 
       SVN_ERR(svn_config_get_int64(config, &compression_level,
                                    CONFIG_SECTION_DELTIFICATION,
@@ -735,6 +808,15 @@ read_config(fs_fs_data_t *ffd,
       ffd->delta_compression_level
         = (int)MIN(MAX(SVN_DELTA_COMPRESSION_LEVEL_NONE, compression_level),
                    SVN_DELTA_COMPRESSION_LEVEL_MAX);
+
+      SVN_ERR(read_compression_config(&ffd->delta_svndiff_version,
+                                      &ffd->delta_compression_level,
+                                      config, ffd->format));
+
+      SVN_ERR(svn_config_get_bool(config, &ffd->content_defined_windows,
+                                  CONFIG_SECTION_DELTIFICATION,
+                                  CONFIG_OPTION_CONTENT_DEFINED_WINDOWS,
+                                  FALSE));
     }
   else
     {
@@ -742,7 +824,11 @@ read_config(fs_fs_data_t *ffd,
       ffd->deltify_properties = FALSE;
       ffd->max_deltification_walk = SVN_FS_FS_MAX_DELTIFICATION_WALK;
       ffd->max_linear_deltification = SVN_FS_FS_MAX_LINEAR_DELTIFICATION;
+      ffd->max_delta_base_size = 0;
       ffd->delta_compression_level = SVN_DELTA_COMPRESSION_LEVEL_DEFAULT;
+      ffd->delta_svndiff_version
+        = ffd->format >= SVN_FS_FS__MIN_SVNDIFF1_FORMAT ? 1 : 0;
+      ffd->content_defined_windows = FALSE;
     }
 
   /* Initialize revprop packing settings in ffd. */
@@ -805,6 +891,39 @@ read_config(fs_fs_data_t *ffd,
       ffd->p2l_page_size = 0x100000;  /* Matches above default in bytes. */
     }
 
+  SVN_ERR(svn_config_get_bool(config, &ffd->group_commit,
+                              CONFIG_SECTION_IO,
+                              CONFIG_OPTION_GROUP_COMMIT,
+                              FALSE));
+
+  {
+    apr_int64_t hotcopy_threads;
+    SVN_ERR(svn_config_get_int64(config, &hotcopy_threads,
+                                 CONFIG_SECTION_IO,
+                                 CONFIG_OPTION_HOTCOPY_THREADS,
+                                 1));
+    ffd->hotcopy_threads
+      = (int)MIN(MAX(1, hotcopy_threads), SVN_FS_FS__MAX_HOTCOPY_THREADS);
+  }
+
+  SVN_ERR(svn_config_get_bool(config, &ffd->changed_paths_index,
+                              CONFIG_SECTION_CHANGED_PATHS,
+                              CONFIG_OPTION_ENABLE_CHANGED_PATHS_INDEX,
+                              FALSE));
+
+  if (ffd->format >= SVN_FS_FS__MIN_MERGEINFO_FORMAT)
+    SVN_ERR(svn_config_get_bool(config, &ffd->mergeinfo_index,
+                                CONFIG_SECTION_MERGEINFO_INDEX,
+                                CONFIG_OPTION_ENABLE_MERGEINFO_INDEX,
+                                FALSE));
+  else
+    ffd->mergeinfo_index = FALSE;
+
+  SVN_ERR(svn_config_get_bool(config, &ffd->lock_index,
+                              CONFIG_SECTION_LOCKS,
+                              CONFIG_OPTION_ENABLE_LOCK_INDEX,
+                              FALSE));
+
   if (ffd->format >= SVN_FS_FS__MIN_PACKED_FORMAT)
     {
       SVN_ERR(svn_config_get_bool(config, &ffd->pack_after_commit,
@@ -828,6 +947,25 @@ read_config(fs_fs_data_t *ffd,
   return SVN_NO_ERROR;
 }
 
+/* Read the configuration information of the file system at FS_PATH
+ * and set the respective values in FFD.  Use pools as usual.
+ */
+static svn_error_t *
+read_config(fs_fs_data_t *ffd,
+            const char *fs_path,
+            apr_pool_t *result_pool,
+            apr_pool_t *scratch_pool)
+{
+  svn_config_t *config;
+
+  SVN_ERR(svn_config_read3(&config,
+                           svn_dirent_join(fs_path, PATH_CONFIG, scratch_pool),
+                           FALSE, FALSE, FALSE, scratch_pool));
+
+  return svn_error_trace(apply_config(ffd, config, result_pool,
+                                      scratch_pool));
+}
+
 static svn_error_t *
 write_config(svn_fs_t *fs,
              apr_pool_t *pool)
@@ -935,6 +1073,15 @@ write_config(svn_fs_t *fs,
 "### For 1.8, the default value is 16; earlier versions use 1."              NL
 "# " CONFIG_OPTION_MAX_LINEAR_DELTIFICATION " = 16"                          NL
 "###"                                                                        NL
+"### Deltifying new file contents requires the delta base to be read and"    NL
+"### reconstructed first.  For large binaries, this can make up most of the" NL
+"### commit time.  This setting (in kBytes) stores new contents as"          NL
+"### compressed fulltexts instead whenever the delta base would be larger"   NL
+"### than the given size.  Commits get faster for the cost of disk space;"   NL
+"### 'svnadmin dump' and 'svnadmin load' will deltify the data normally."     NL
+"### A value of 0 means no limit, which is the default."                     NL
+"# " CONFIG_OPTION_MAX_DELTA_BASE_SIZE " = 0"                                NL
+"###"                                                                        NL
 "### After deltification, we compress the data through zlib to minimize on-" NL
 "### disk size.  That can be an expensive and ineffective process.  This"    NL
 "### setting controls the usage of zlib in future revisions."                NL
@@ -952,6 +1099,30 @@ write_config(svn_fs_t *fs,
 "### and 0 disabling it altogether."                                         NL
 "### The default value is 5."                                                NL
 "# " CONFIG_OPTION_COMPRESSION_LEVEL " = 5"                                  NL
+"###"                                                                        NL
+"### This setting selects the compression method used for deltas in future"  NL
+"### revisions.  Valid values are 'zlib', 'lz4' and 'none'.  'zlib' uses the" NL
+"### compression level given above.  'lz4' compresses a bit worse but is"   NL
+"### much faster, which mostly helps when cpu time rather than disk or"      NL
+"### network throughput limits commits and checkouts.  It requires format 8" NL
+"### and an LZ4-enabled build; otherwise 'zlib' will be used instead."      NL
+"### Repositories that use LZ4 can only be read by LZ4-enabled servers."     NL
+"### The default value is 'zlib'."                                           NL
+"# " CONFIG_OPTION_COMPRESSION " = zlib"                                     NL
+"###"                                                                        NL
+"### Deltas are computed in windows of about 100 kB.  By default, the target" NL
+"### is cut into windows at fixed offsets, and each window is compared with"  NL
+"### the respective range of the delta base.  If data gets inserted or"       NL
+"### removed near the start of a large file, as in VM images or archives,"   NL
+"### all later windows are off by that amount and the delta may become"      NL
+"### almost as large as the file itself.  With this setting enabled, window" NL
+"### boundaries are placed where the content has certain patterns and the"   NL
+"### respective window of the delta base starts at the same pattern."        NL
+"### Deltas then stay small despite shifted content, for a slightly higher"  NL
+"### commit time.  The setting only affects data written in the future and"  NL
+"### the resulting deltas can be read by all versions."                       NL
+"### Content-defined windows are disabled by default."                       NL
+"# " CONFIG_OPTION_CONTENT_DEFINED_WINDOWS " = false"                        NL
 ""                                                                           NL
 "[" CONFIG_SECTION_PACKED_REVPROPS "]"                                       NL
 "### This parameter controls the size (in kBytes) of packed revprop files."  NL
@@ -1020,6 +1191,53 @@ write_config(svn_fs_t *fs,
 "### Must be a power of 2."                                                  NL
 "### p2l-page-size is given in kBytes and with a default of 1024 kBytes."    NL
 "# " CONFIG_OPTION_P2L_PAGE_SIZE " = 1024"                                   NL
+"###"                                                                        NL
+"### Enabling group commit releases the repository write lock before the"    NL
+"### last fsync of every commit and lets concurrent committers within the"   NL
+"### same server process share that fsync.  The next commit may then"        NL
+"### proceed while the previous one is still being flushed to disk.  The"    NL
+"### revision data itself is always on disk before it becomes visible."      NL
+"### This applies to all repository formats and is disabled by default."     NL
+"# " CONFIG_OPTION_GROUP_COMMIT " = false"                                   NL
+"###"                                                                        NL
+"### hotcopy-threads sets the number of packed shards that 'svnadmin"        NL
+"### hotcopy' copies concurrently from this repository.  Higher values"      NL
+"### help on storage that performs well with parallel I/O.  Where the OS"    NL
+"### and file system support it, files are copied within the kernel or"      NL
+"### cloned (reflinks) instead of being read and written.  The default is"   NL
+"### 1, i.e. shards get copied one after another.  The maximum is 32."       NL
+"# " CONFIG_OPTION_HOTCOPY_THREADS " = 1"                                    NL
+""                                                                           NL
+"[" CONFIG_SECTION_CHANGED_PATHS "]"                                         NL
+"### If enabled, FSFS maintains a list of changed paths for every shard in"  NL
+"### the db/" PATH_CHANGED_PATHS_DIR " directory.  It gets updated during commit"  NL
+"### and rebuilt when a shard is packed.  'svn log' uses it to skip target"  NL
+"### paths that did not change in the requested revision range.  The"        NL
+"### index is only a hint and is ignored when it is incomplete."             NL
+"### Only sharded repositories support this index.  It is disabled by"       NL
+"### default."                                                               NL
+"# " CONFIG_OPTION_ENABLE_CHANGED_PATHS_INDEX " = false"                     NL
+""                                                                           NL
+"[" CONFIG_SECTION_MERGEINFO_INDEX "]"                                       NL
+"### If enabled, mergeinfo queries that include the mergeinfo of a whole"    NL
+"### sub-tree, like those of 'svn merge' and 'svn mergeinfo', store their"   NL
+"### results in the " MERGEINFO_INDEX_DB_NAME " database.  Later queries"    NL
+"### for the same sub-tree in revisions that did not change it are"          NL
+"### answered from that database instead of searching the tree again.  The"  NL
+"### database may be deleted at any time; it will be recreated as needed."   NL
+"### The mergeinfo index is disabled by default."                            NL
+"# " CONFIG_OPTION_ENABLE_MERGEINFO_INDEX " = false"                         NL
+""                                                                           NL
+"[" CONFIG_SECTION_LOCKS "]"                                                 NL
+"### If enabled, FSFS keeps a copy of all locks in the " LOCK_INDEX_DB_NAME     NL
+"### database, sorted by path.  Listing the locks of a sub-tree, e.g. for"   NL
+"### 'svn status -u' or when committing a directory deletion, then reads"   NL
+"### a single range of that database instead of one file per lock.  The"    NL
+"### database is created by the next lock or unlock operation; the lock"    NL
+"### files in the db/" PATH_LOCKS_DIR " directory are kept up to date as well."    NL
+"### Disabling the option removes the database with the next lock or"       NL
+"### unlock operation.  The lock index is disabled by default."              NL
+"# " CONFIG_OPTION_ENABLE_LOCK_INDEX " = false"                              NL
 ;
 #undef NL
   return svn_io_file_create(svn_dirent_join(fs->path, PATH_CONFIG, pool),
@@ -1036,9 +1254,19 @@ read_global_config(svn_fs_t *fs)
   ffd->use_block_read = svn_hash__get_bool(fs->config,
                                            SVN_FS_CONFIG_FSFS_BLOCK_READ,
                                            FALSE);
+  ffd->use_read_ahead = ffd->use_block_read
+                     && svn_hash__get_bool(fs->config,
+                                           SVN_FS_CONFIG_FSFS_READ_AHEAD,
+                                           FALSE);
   ffd->flush_to_disk = !svn_hash__get_bool(fs->config,
                                            SVN_FS_CONFIG_NO_FLUSH_TO_DISK,
                                            FALSE);
+  ffd->pack_access_profile
+    = svn_hash__get_cstring(fs->config,
+                            SVN_FS_CONFIG_FSFS_PACK_ACCESS_PROFILE, NULL);
+  if (ffd->pack_access_profile)
+    ffd->pack_access_profile = apr_pstrdup(fs->pool,
+                                           ffd->pack_access_profile);
 
   /* Ignore the user-specified larger block size if we don't use block-read.
      Defaulting to 4k gives us the same access granularity in format 7 as in
@@ -1105,25 +1333,273 @@ svn_fs_fs__read_format_file(svn_fs_t *fs, apr_pool_t *scratch_pool)
   return SVN_NO_ERROR;
 }
 
-svn_error_t *
-svn_fs_fs__open(svn_fs_t *fs, const char *path, apr_pool_t *pool)
+/* Files modified less than this before we looked at them may change again
+ * without their file_stamp_t changing.  We don't cache their contents. */
+#define STAMP_GRANULARITY apr_time_from_sec(1)
+
+/* Identifies a version of a file on disk. */
+typedef struct file_stamp_t
+{
+  apr_time_t mtime;
+  apr_off_t size;
+  apr_ino_t inode;
+} file_stamp_t;
+
+/* The data that svn_fs_fs__open reads from files which rarely change.
+ */
+typedef struct open_data_t
+{
+  /* The versions of the format, uuid and config files that the data
+   * below has been read from. */
+  file_stamp_t format_stamp;
+  file_stamp_t uuid_stamp;
+  file_stamp_t config_stamp;
+
+  /* Contents of the format file. */
+  int format;
+  int max_files_per_dir;
+  svn_boolean_t use_log_addressing;
+
+  /* Contents of the uuid file. */
+  const char *uuid;
+  const char *instance_id;
+
+  /* Parsed contents of the config file. */
+  svn_config_t *config;
+
+  /* The pool that all of the above is allocated in. */
+  apr_pool_t *pool;
+} open_data_t;
+
+/* Process-wide cache of the open_data_t of all file systems opened so far.
+ * Opening a repository only needs to stat() the respective files instead
+ * of reading and parsing them again. */
+typedef struct open_data_cache_t
+{
+  /* Serializes all access to ENTRIES, including their contents. */
+  svn_mutex__t *mutex;
+
+  /* const char * file system path -> open_data_t *.  The keys are
+   * allocated in POOL, the values in their own root pools. */
+  apr_hash_t *entries;
+  apr_pool_t *pool;
+} open_data_cache_t;
+
+/* Initialization state of OPEN_DATA_CACHE. */
+static volatile svn_atomic_t open_data_cache_init_state = 0;
+
+/* The process-wide open_data_t cache. */
+static open_data_cache_t *open_data_cache = NULL;
+
+/* Implements svn_atomic__err_init_func_t.  Create OPEN_DATA_CACHE. */
+static svn_error_t *
+init_open_data_cache(void *baton,
+                     apr_pool_t *unused_pool)
+{
+  /* The cache lives as long as the process. */
+  apr_pool_t *pool = svn_pool_create(NULL);
+  open_data_cache_t *cache = apr_pcalloc(pool, sizeof(*cache));
+
+  SVN_ERR(svn_mutex__init(&cache->mutex, TRUE, pool));
+  cache->entries = apr_hash_make(pool);
+  cache->pool = pool;
+
+  open_data_cache = cache;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *STAMP to the version of the file at PATH.  If the file does not
+ * exist, set all elements to 0.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+get_file_stamp(file_stamp_t *stamp,
+               const char *path,
+               apr_pool_t *scratch_pool)
+{
+  apr_finfo_t finfo;
+  svn_error_t *err = svn_io_stat(&finfo, path,
+                                 APR_FINFO_MTIME | APR_FINFO_SIZE,
+                                 scratch_pool);
+
+  memset(stamp, 0, sizeof(*stamp));
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(err);
+
+  stamp->mtime = finfo.mtime;
+  stamp->size = finfo.size;
+  if (finfo.valid & APR_FINFO_INODE)
+    stamp->inode = finfo.inode;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return TRUE, if LHS and RHS identify the same file version. */
+static svn_boolean_t
+file_stamp_equal(const file_stamp_t *lhs,
+                 const file_stamp_t *rhs)
+{
+  return lhs->mtime == rhs->mtime
+      && lhs->size == rhs->size
+      && lhs->inode == rhs->inode;
+}
+
+/* Return TRUE, if the file version STAMP, taken at time NOW, has been
+ * stable long enough for its contents to be cached. */
+static svn_boolean_t
+file_stamp_settled(const file_stamp_t *stamp,
+                   apr_time_t now)
+{
+  return stamp->mtime + STAMP_GRANULARITY < now;
+}
+
+/* If OPEN_DATA_CACHE contains the data for FS read from the file versions
+ * given in CURRENT, copy that data into FS and set *FOUND.  Otherwise,
+ * set *FOUND to FALSE.  The caller must hold OPEN_DATA_CACHE->MUTEX.
+ * Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+get_cached_open_data(svn_boolean_t *found,
+                     svn_fs_t *fs,
+                     const open_data_t *current,
+                     apr_pool_t *scratch_pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
-  fs->path = apr_pstrdup(fs->pool, path);
+  open_data_t *entry = svn_hash_gets(open_data_cache->entries, fs->path);
+
+  *found = entry
+        && file_stamp_equal(&entry->format_stamp, &current->format_stamp)
+        && file_stamp_equal(&entry->uuid_stamp, &current->uuid_stamp)
+        && file_stamp_equal(&entry->config_stamp, &current->config_stamp);
+  if (!*found)
+    return SVN_NO_ERROR;
+
+  ffd->format = entry->format;
+  ffd->max_files_per_dir = entry->max_files_per_dir;
+  ffd->use_log_addressing = entry->use_log_addressing;
+
+  fs->uuid = apr_pstrdup(fs->pool, entry->uuid);
+  ffd->instance_id = apr_pstrdup(fs->pool, entry->instance_id);
+
+  return svn_error_trace(apply_config(ffd, entry->config, fs->pool,
+                                      scratch_pool));
+}
+
+/* Make ENTRY the cached data for the file system at PATH, replacing any
+ * older data.  The caller must hold OPEN_DATA_CACHE->MUTEX. */
+static svn_error_t *
+set_cached_open_data(const char *path,
+                     open_data_t *entry)
+{
+  open_data_t *old_entry = svn_hash_gets(open_data_cache->entries, path);
+
+  if (old_entry)
+    {
+      /* Keep the original key.  Nobody else can see the old data. */
+      svn_hash_sets(open_data_cache->entries, path, entry);
+      svn_pool_destroy(old_entry->pool);
+    }
+  else
+    {
+      svn_hash_sets(open_data_cache->entries,
+                    apr_pstrdup(open_data_cache->pool, path), entry);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the format, uuid and config files of FS and set the respective
+ * members of FS.  Use the data cached in OPEN_DATA_CACHE if the files
+ * did not change since they were last read.  Use SCRATCH_POOL for
+ * temporary allocations. */
+static svn_error_t *
+read_open_data(svn_fs_t *fs,
+               apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  const char *config_path = svn_dirent_join(fs->path, PATH_CONFIG,
+                                            scratch_pool);
+  apr_time_t now = apr_time_now();
+  open_data_t current = { { 0 } };
+  open_data_t *entry;
+  apr_pool_t *entry_pool;
+  svn_boolean_t found;
+  svn_error_t *err;
+
+  SVN_ERR(svn_atomic__init_once(&open_data_cache_init_state,
+                                init_open_data_cache, NULL, scratch_pool));
+
+  /* Stamp the files *before* reading them.  Should they get modified
+   * in between, we will simply read them again next time. */
+  SVN_ERR(get_file_stamp(&current.format_stamp, path_format(fs, scratch_pool),
+                         scratch_pool));
+  SVN_ERR(get_file_stamp(&current.uuid_stamp, path_uuid(fs, scratch_pool),
+                         scratch_pool));
+  SVN_ERR(get_file_stamp(&current.config_stamp, config_path, scratch_pool));
+
+  SVN_MUTEX__WITH_LOCK(open_data_cache->mutex,
+                       get_cached_open_data(&found, fs, &current,
+                                            scratch_pool));
+  if (found)
+    return SVN_NO_ERROR;
 
   /* Read the FS format file. */
-  SVN_ERR(svn_fs_fs__read_format_file(fs, pool));
+  SVN_ERR(svn_fs_fs__read_format_file(fs, scratch_pool));
 
   /* Read in and cache the repository uuid. */
-  SVN_ERR(read_uuid(fs, pool));
+  SVN_ERR(read_uuid(fs, scratch_pool));
+
+  /* Recently modified files may change again without us noticing.
+   * Simply read the configuration file in that case. */
+  if (   !file_stamp_settled(&current.format_stamp, now)
+      || !file_stamp_settled(&current.uuid_stamp, now)
+      || !file_stamp_settled(&current.config_stamp, now))
+    return svn_error_trace(read_config(ffd, fs->path, fs->pool,
+                                       scratch_pool));
+
+  /* Read the configuration file into a new cache entry. */
+  entry_pool = svn_pool_create(NULL);
+  entry = apr_pmemdup(entry_pool, &current, sizeof(current));
+  entry->pool = entry_pool;
+
+  err = svn_config_read3(&entry->config, config_path, FALSE, FALSE, FALSE,
+                         entry->pool);
+  if (!err)
+    err = apply_config(ffd, entry->config, fs->pool, scratch_pool);
+  if (err)
+    {
+      svn_pool_destroy(entry->pool);
+      return svn_error_trace(err);
+    }
+
+  entry->format = ffd->format;
+  entry->max_files_per_dir = ffd->max_files_per_dir;
+  entry->use_log_addressing = ffd->use_log_addressing;
+  entry->uuid = apr_pstrdup(entry->pool, fs->uuid);
+  entry->instance_id = apr_pstrdup(entry->pool, ffd->instance_id);
+
+  SVN_MUTEX__WITH_LOCK(open_data_cache->mutex,
+                       set_cached_open_data(fs->path, entry));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__open(svn_fs_t *fs, const char *path, apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  fs->path = apr_pstrdup(fs->pool, path);
+
+  /* Read the format, uuid and configuration files. */
+  SVN_ERR(read_open_data(fs, pool));
 
   /* Read the min unpacked revision. */
   if (ffd->format >= SVN_FS_FS__MIN_PACKED_FORMAT)
     SVN_ERR(svn_fs_fs__update_min_unpacked_rev(fs, pool));
 
-  /* Read the configuration file. */
-  SVN_ERR(read_config(ffd, fs->path, fs->pool, pool));
-
   /* Global configuration options. */
   SVN_ERR(read_global_config(fs));
 
@@ -1369,6 +1845,75 @@ svn_fs_fs__ensure_revision_exists(svn_revnum_t rev,
                            _("No such revision %ld"), rev);
 }
 
+svn_error_t *
+svn_fs_fs__revision_files(apr_array_header_t **files,
+                          svn_revnum_t *start_rev,
+                          svn_revnum_t *end_rev,
+                          svn_fs_t *fs,
+                          svn_revnum_t rev,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_revnum_t i;
+
+  SVN_ERR(svn_fs_fs__ensure_revision_exists(rev, fs, scratch_pool));
+  if (ffd->format >= SVN_FS_FS__MIN_PACKED_FORMAT)
+    SVN_ERR(svn_fs_fs__update_min_unpacked_rev(fs, scratch_pool));
+
+  *files = apr_array_make(result_pool, 4, sizeof(const char *));
+  if (svn_fs_fs__is_packed_rev(fs, rev))
+    {
+      *start_rev = rev - (rev % ffd->max_files_per_dir);
+      *end_rev = *start_rev + ffd->max_files_per_dir - 1;
+
+      APR_ARRAY_PUSH(*files, const char *)
+        = svn_fs_fs__path_rev_packed(fs, rev, PATH_PACKED, result_pool);
+      if (!svn_fs_fs__use_log_addressing(fs))
+        APR_ARRAY_PUSH(*files, const char *)
+          = svn_fs_fs__path_rev_packed(fs, rev, PATH_MANIFEST, result_pool);
+    }
+  else
+    {
+      *start_rev = rev;
+      *end_rev = rev;
+
+      APR_ARRAY_PUSH(*files, const char *)
+        = svn_fs_fs__path_rev(fs, rev, result_pool);
+    }
+
+  /* Non-packed revprops.  Note that r0 never gets its revprops packed. */
+  for (i = *start_rev; i <= *end_rev; ++i)
+    if (!svn_fs_fs__is_packed_revprop(fs, i))
+      APR_ARRAY_PUSH(*files, const char *)
+        = svn_fs_fs__path_revprops(fs, i, result_pool);
+
+  /* Packed revprops are spread over a number of files in the shard. */
+  if (svn_fs_fs__is_packed_revprop(fs, *end_rev))
+    {
+      const char *shard_path
+        = svn_fs_fs__path_revprops_pack_shard(fs, *end_rev, scratch_pool);
+      apr_hash_t *dirents;
+      apr_array_header_t *sorted;
+      int k;
+
+      SVN_ERR(svn_io_get_dirents3(&dirents, shard_path, TRUE,
+                                  scratch_pool, scratch_pool));
+      sorted = svn_sort__hash(dirents, svn_sort_compare_items_lexically,
+                              scratch_pool);
+      for (k = 0; k < sorted->nelts; ++k)
+        {
+          const svn_sort__item_t *item
+            = &APR_ARRAY_IDX(sorted, k, svn_sort__item_t);
+
+          APR_ARRAY_PUSH(*files, const char *)
+            = svn_dirent_join(shard_path, item->key, result_pool);
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__file_length(svn_filesize_t *length,
                        node_revision_t *noderev,
@@ -1812,6 +2357,9 @@ svn_fs_fs__create(svn_fs_t *fs,
           case 8: format = 6;
                   break;
 
+          case 9: format = 7;
+                  break;
+
           default:format = SVN_FS_FS__FORMAT_NUMBER;
         }
 
@@ -2180,8 +2728,11 @@ svn_fs_fs__info_format(int *fs_format,
     case 7:
       (*supports_version)->minor = 9;
       break;
+    case 8:
+      (*supports_version)->minor = 10;
+      break;
 #ifdef SVN_DEBUG
-# if SVN_FS_FS__FORMAT_NUMBER != 7
+# if SVN_FS_FS__FORMAT_NUMBER != 8
 #  error "Need to add a 'case' statement here"
 # endif
 #endif
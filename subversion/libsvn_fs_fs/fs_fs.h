@@ -48,6 +48,16 @@ svn_error_t *svn_fs_fs__initialize_shared_data(svn_fs_t *fs,
                                                apr_pool_t *pool,
                                                apr_pool_t *common_pool);
 
+/* Set *INSTANCE_P to another filesystem object for the already open FS,
+   with its own caches and file handles but otherwise configured like FS.
+   This allows for accessing the repository from multiple threads.
+   Allocate the result in RESULT_POOL and use SCRATCH_POOL for temporary
+   allocations. */
+svn_error_t *svn_fs_fs__open_instance(svn_fs_t **instance_p,
+                                      svn_fs_t *fs,
+                                      apr_pool_t *result_pool,
+                                      apr_pool_t *scratch_pool);
+
 /* Upgrade the fsfs filesystem FS.  Indicate progress via the optional
  * NOTIFY_FUNC callback using NOTIFY_BATON.  The optional CANCEL_FUNC
  * will periodically be called with CANCEL_BATON to allow for preemption.
@@ -84,6 +94,22 @@ svn_fs_fs__ensure_revision_exists(svn_revnum_t rev,
                                   svn_fs_t *fs,
                                   apr_pool_t *pool);
 
+/* Set *FILES to the absolute paths of all files in FS that contain data
+   of revision REV, i.e. the rev or pack file, the pack manifest and the
+   revprop files.  Set *START_REV and *END_REV to the range of revisions
+   stored in them.  Allocate *FILES in RESULT_POOL and use SCRATCH_POOL
+   for temporaries.
+
+   This implements the fs_vtable_t.revision_files() API. */
+svn_error_t *
+svn_fs_fs__revision_files(apr_array_header_t **files,
+                          svn_revnum_t *start_rev,
+                          svn_revnum_t *end_rev,
+                          svn_fs_t *fs,
+                          svn_revnum_t rev,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool);
+
 /* Set *LENGTH to the be fulltext length of the node revision
    specified by NODEREV.  Use POOL for temporary allocations. */
 svn_error_t *svn_fs_fs__file_length(svn_filesize_t *length,
@@ -174,6 +200,12 @@ svn_error_t *svn_fs_fs__set_uuid(svn_fs_t *fs,
 const char *
 svn_fs_fs__path_current(svn_fs_t *fs, apr_pool_t *pool);
 
+/* Return the path to the 'next' file in FS, i.e. the temporary file that
+   replaces 'current' at the end of a commit.
+   Perform allocation in POOL. */
+const char *
+svn_fs_fs__path_next(svn_fs_t *fs, apr_pool_t *pool);
+
 /* Write the format number and maximum number of files per directory
    for FS, possibly expecting to overwrite a previously existing file.
 
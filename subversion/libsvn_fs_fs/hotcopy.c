@@ -19,15 +19,20 @@
  *    under the License.
  * ====================================================================
  */
+#include <apr_thread_proc.h>
+
 #include "svn_pools.h"
 #include "svn_path.h"
 #include "svn_dirent_uri.h"
+#include "svn_sorts.h"
 
 #include "fs_fs.h"
 #include "hotcopy.h"
 #include "util.h"
 #include "recovery.h"
 #include "revprops.h"
+#include "lock-index.h"
+#include "mergeinfo-index.h"
 #include "rep-cache.h"
 
 #include "../libsvn_fs/fs-loader.h"
@@ -279,15 +284,14 @@ hotcopy_copy_shard_file(svn_boolean_t *skipped_p,
 
 /* Copy a packed shard containing revision REV, and which contains
  * MAX_FILES_PER_DIR revisions, from SRC_FS to DST_FS.
- * Update *DST_MIN_UNPACKED_REV in case the shard is new in DST_FS.
  * Do not re-copy data which already exists in DST_FS.
  * Set *SKIPPED_P to FALSE only if at least one part of the shard
  * was copied, do not change the value in *SKIPPED_P otherwise.
  * SKIPPED_P may be NULL if not required.
- * Use SCRATCH_POOL for temporary allocations. */
+ * This only reads SRC_FS and DST_FS, i.e. it may be called for different
+ * shards concurrently.  Use SCRATCH_POOL for temporary allocations. */
 static svn_error_t *
 hotcopy_copy_packed_shard(svn_boolean_t *skipped_p,
-                          svn_revnum_t *dst_min_unpacked_rev,
                           svn_fs_t *src_fs,
                           svn_fs_t *dst_fs,
                           svn_revnum_t rev,
@@ -357,13 +361,144 @@ hotcopy_copy_packed_shard(svn_boolean_t *skipped_p,
                                               scratch_pool));
     }
 
-  /* If necessary, update the min-unpacked rev file in the hotcopy. */
-  if (*dst_min_unpacked_rev < rev + max_files_per_dir)
+  return SVN_NO_ERROR;
+}
+
+/* Parameters and result of copying a single packed shard. */
+typedef struct shard_copy_t
+{
+  /* Input parameters to hotcopy_copy_packed_shard(). */
+  svn_fs_t *src_fs;
+  svn_fs_t *dst_fs;
+  svn_revnum_t rev;
+  int max_files_per_dir;
+
+  /* Set to FALSE if anything got copied.  Initialized to TRUE. */
+  svn_boolean_t skipped;
+
+  /* Result of the copy operation. */
+  svn_error_t *result;
+
+  /* Pool private to this copy operation, i.e. to the thread running it. */
+  apr_pool_t *pool;
+
+#if APR_HAS_THREADS
+  /* The thread running the copy operation. */
+  apr_thread_t *thread;
+#endif
+} shard_copy_t;
+
+/* Execute the shard copy operation COPY. */
+static void
+run_shard_copy(shard_copy_t *copy)
+{
+  copy->result = hotcopy_copy_packed_shard(&copy->skipped,
+                                           copy->src_fs, copy->dst_fs,
+                                           copy->rev,
+                                           copy->max_files_per_dir,
+                                           copy->pool);
+}
+
+#if APR_HAS_THREADS
+/* APR thread start function executing the shard_copy_t given as DATA. */
+static void * APR_THREAD_FUNC
+copy_shard_task(apr_thread_t *thread,
+                void *data)
+{
+  run_shard_copy(data);
+  return NULL;
+}
+#endif
+
+/* Copy the packed shards starting at revision REV from SRC_FS to DST_FS
+ * but stop at revision END_REV.  Copy up to the number of shards that the
+ * SRC_FS configuration allows concurrently.  Return the number of shards
+ * copied in *COUNT and their respective skipped flags in the array
+ * SKIPPED, which must provide at least SVN_FS_FS__MAX_HOTCOPY_THREADS
+ * elements.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+hotcopy_copy_packed_shards(int *count,
+                           svn_boolean_t *skipped,
+                           svn_fs_t *src_fs,
+                           svn_fs_t *dst_fs,
+                           svn_revnum_t rev,
+                           svn_revnum_t end_rev,
+                           apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *src_ffd = src_fs->fsap_data;
+  int max_files_per_dir = src_ffd->max_files_per_dir;
+  shard_copy_t copies[SVN_FS_FS__MAX_HOTCOPY_THREADS];
+  int threads = MAX(1, src_ffd->hotcopy_threads);
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  /* Number of shards to copy in this batch.  This is at least one. */
+  SVN_ERR_ASSERT(rev < end_rev);
+  *count = 0;
+  while (*count < threads && rev + *count * max_files_per_dir < end_rev)
+    ++*count;
+
+  for (i = 0; i < *count; ++i)
+    {
+      copies[i].src_fs = src_fs;
+      copies[i].dst_fs = dst_fs;
+      copies[i].rev = rev + i * max_files_per_dir;
+      copies[i].max_files_per_dir = max_files_per_dir;
+      copies[i].skipped = TRUE;
+      copies[i].result = SVN_NO_ERROR;
+    }
+
+#if APR_HAS_THREADS
+  if (*count > 1)
+    {
+      int started;
+
+      /* Each thread needs a pool that it does not share with any other
+       * thread, including its allocator. */
+      for (started = 0; started < *count; ++started)
+        {
+          apr_status_t status;
+
+          copies[started].pool = svn_pool_create(NULL);
+          status = apr_thread_create(&copies[started].thread, NULL,
+                                     copy_shard_task, &copies[started],
+                                     copies[started].pool);
+          if (status)
+            {
+              err = svn_error_wrap_apr(status,
+                                       _("Can't create hotcopy thread"));
+              svn_pool_destroy(copies[started].pool);
+              break;
+            }
+        }
+
+      /* Wait for all threads that we started, even if we failed to start
+       * some of them. */
+      for (i = 0; i < started; ++i)
+        {
+          apr_status_t retval;
+          apr_status_t status = apr_thread_join(&retval, copies[i].thread);
+          if (status)
+            err = svn_error_compose_create(err,
+                           svn_error_wrap_apr(status,
+                                              _("Can't join hotcopy thread")));
+
+          err = svn_error_compose_create(err, copies[i].result);
+          skipped[i] = copies[i].skipped;
+          svn_pool_destroy(copies[i].pool);
+        }
+
+      return svn_error_trace(err);
+    }
+#endif
+
+  for (i = 0; i < *count; ++i)
     {
-      *dst_min_unpacked_rev = rev + max_files_per_dir;
-      SVN_ERR(svn_fs_fs__write_min_unpacked_rev(dst_fs,
-                                                *dst_min_unpacked_rev,
-                                                scratch_pool));
+      copies[i].pool = scratch_pool;
+      run_shard_copy(&copies[i]);
+      SVN_ERR(copies[i].result);
+      skipped[i] = copies[i].skipped;
     }
 
   return SVN_NO_ERROR;
@@ -563,6 +698,9 @@ hotcopy_revisions(svn_fs_t *src_fs,
   svn_revnum_t dst_min_unpacked_rev;
   svn_revnum_t rev;
   apr_pool_t *iterpool;
+  svn_boolean_t skipped_shards[SVN_FS_FS__MAX_HOTCOPY_THREADS];
+  int pending = 0;
+  int copied = 0;
 
   /* Copy the min unpacked rev, and read its value. */
   if (src_ffd->format >= SVN_FS_FS__MIN_PACKED_FORMAT)
@@ -601,22 +739,38 @@ hotcopy_revisions(svn_fs_t *src_fs,
    */
 
   iterpool = svn_pool_create(pool);
-  /* First, copy packed shards. */
+  /* First, copy packed shards.  Several of them may be copied concurrently
+   * but we update the destination's state in revision order. */
   for (rev = 0; rev < src_min_unpacked_rev; rev += max_files_per_dir)
     {
-      svn_boolean_t skipped = TRUE;
+      svn_boolean_t skipped;
       svn_revnum_t pack_end_rev;
 
-      svn_pool_clear(iterpool);
+      if (copied == pending)
+        {
+          svn_pool_clear(iterpool);
 
-      if (cancel_func)
-        SVN_ERR(cancel_func(cancel_baton));
+          if (cancel_func)
+            SVN_ERR(cancel_func(cancel_baton));
+
+          /* Copy the next batch of packed shards. */
+          SVN_ERR(hotcopy_copy_packed_shards(&pending, skipped_shards,
+                                             src_fs, dst_fs, rev,
+                                             src_min_unpacked_rev,
+                                             iterpool));
+          copied = 0;
+        }
+
+      skipped = skipped_shards[copied++];
 
-      /* Copy the packed shard. */
-      SVN_ERR(hotcopy_copy_packed_shard(&skipped, &dst_min_unpacked_rev,
-                                        src_fs, dst_fs,
-                                        rev, max_files_per_dir,
-                                        iterpool));
+      /* If necessary, update the min-unpacked rev file in the hotcopy. */
+      if (dst_min_unpacked_rev < rev + max_files_per_dir)
+        {
+          dst_min_unpacked_rev = rev + max_files_per_dir;
+          SVN_ERR(svn_fs_fs__write_min_unpacked_rev(dst_fs,
+                                                    dst_min_unpacked_rev,
+                                                    iterpool));
+        }
 
       pack_end_rev = rev + max_files_per_dir - 1;
 
@@ -959,6 +1113,11 @@ hotcopy_body(void *baton, apr_pool_t *pool)
                                         PATH_LOCKS_DIR, TRUE,
                                         cancel_func, cancel_baton, pool));
 
+  /* The lock index of the destination does not match the new locks tree.
+   * Copying the source's index would not be atomic with the tree copy,
+   * so drop it instead.  The next lock operation rebuilds it. */
+  SVN_ERR(svn_fs_fs__remove_lock_index(dst_fs, pool));
+
   /* Now copy the node-origins cache tree. */
   src_subdir = svn_dirent_join(src_fs->path, PATH_NODE_ORIGINS_DIR, pool);
   SVN_ERR(svn_io_check_path(src_subdir, &kind, pool));
@@ -990,6 +1149,17 @@ hotcopy_body(void *baton, apr_pool_t *pool)
         }
     }
 
+  /* Copy the mergeinfo index the same way. */
+  src_subdir = svn_dirent_join(src_fs->path, MERGEINFO_INDEX_DB_NAME, pool);
+  dst_subdir = svn_dirent_join(dst_fs->path, MERGEINFO_INDEX_DB_NAME, pool);
+  SVN_ERR(svn_io_check_path(src_subdir, &kind, pool));
+  if (kind == svn_node_file)
+    {
+      SVN_ERR(svn_sqlite__hotcopy(src_subdir, dst_subdir, pool));
+      SVN_ERR(svn_io_set_file_read_write(dst_subdir, FALSE, pool));
+      SVN_ERR(svn_fs_fs__del_indexed_mergeinfo(dst_fs, src_youngest, pool));
+    }
+
   /* Copy the txn-current file. */
   if (dst_ffd->format >= SVN_FS_FS__MIN_TXN_CURRENT_FORMAT)
     SVN_ERR(svn_io_dir_file_copy(src_fs->path, dst_fs->path,
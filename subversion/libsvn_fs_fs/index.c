@@ -21,6 +21,7 @@
  */
 
 #include <assert.h>
+#include <apr_mmap.h>
 
 #include "svn_io.h"
 #include "svn_pools.h"
@@ -40,6 +41,19 @@
 
 #include "../libsvn_fs/fs-loader.h"
 
+/* Index data gets memory mapped starting at file offsets that are a
+ * multiple of this.  It covers the page size and the mapping granularity
+ * of all common platforms.
+ */
+#define MMAP_ALIGNMENT 0x10000
+
+/* On x86-64, SSE2 is part of the base ISA.  Use it to find runs of
+ * single-byte numbers in the index streams 16 bytes at a time. */
+#if defined(__GNUC__) && defined(__SSE2__)
+#  define INDEX_SSE2 1
+#  include <emmintrin.h>
+#endif
+
 /* maximum length of a uint64 in an 7/8b encoding */
 #define ENCODED_INT_LENGTH 10
 
@@ -208,6 +222,13 @@ struct svn_fs_fs__packed_number_stream_t
   /* offset in FILE from which the next number has to be read */
   apr_off_t next_offset;
 
+  /* If not NULL, the file contents from offset DATA_START up to STREAM_END
+   * mapped into memory.  Numbers will be decoded from there directly. */
+  const unsigned char *data;
+
+  /* offset in FILE that corresponds to DATA[0] */
+  apr_off_t data_start;
+
   /* read the file in chunks of this size */
   apr_size_t block_size;
 
@@ -239,6 +260,26 @@ stream_error_create(svn_fs_fs__packed_number_stream_t *stream,
                                         (apr_uint64_t)offset));
 }
 
+/* Return the number of leading bytes at P, up to 16, that are complete
+ * encoded numbers < 128 each.  P must point to 16 readable bytes.
+ */
+static APR_INLINE apr_size_t
+count_short_numbers(const unsigned char *p)
+{
+#ifdef INDEX_SSE2
+  unsigned int mask
+    = (unsigned int)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)p));
+
+  return __builtin_ctz(mask | 0x10000);
+#else
+  apr_size_t count = 0;
+  while (count < 16 && p[count] < 0x80)
+    ++count;
+
+  return count;
+#endif
+}
+
 /* Read up to MAX_NUMBER_PREFETCH numbers from the STREAM->NEXT_OFFSET in
  * STREAM->FILE and buffer them.
  *
@@ -250,43 +291,55 @@ SVN__PREVENT_INLINE
 static svn_error_t *
 packed_stream_read(svn_fs_fs__packed_number_stream_t *stream)
 {
-  unsigned char buffer[MAX_NUMBER_PREFETCH];
+  unsigned char file_buffer[MAX_NUMBER_PREFETCH];
+  const unsigned char *buffer = file_buffer;
   apr_size_t bytes_read = 0;
   apr_size_t i;
   value_position_pair_t *target;
   apr_off_t block_start = 0;
   apr_off_t block_left = 0;
-  apr_status_t err;
+  apr_status_t err = APR_SUCCESS;
 
   /* all buffered data will have been read starting here */
   stream->start_offset = stream->next_offset;
 
-  /* packed numbers are usually not aligned to MAX_NUMBER_PREFETCH blocks,
-   * i.e. the last number has been incomplete (and not buffered in stream)
-   * and need to be re-read.  Therefore, always correct the file pointer.
-   */
-  SVN_ERR(svn_io_file_aligned_seek(stream->file, stream->block_size,
-                                   &block_start, stream->next_offset,
-                                   stream->pool));
+  if (stream->data)
+    {
+      /* No I/O required.  Simply decode the next chunk of mapped data. */
+      buffer = stream->data + (stream->next_offset - stream->data_start);
+      bytes_read = (apr_size_t)MIN(MAX_NUMBER_PREFETCH,
+                                   stream->stream_end - stream->next_offset);
+    }
+  else
+    {
+      /* packed numbers are usually not aligned to MAX_NUMBER_PREFETCH
+       * blocks, i.e. the last number has been incomplete (and not buffered
+       * in stream) and need to be re-read.  Therefore, always correct the
+       * file pointer.
+       */
+      SVN_ERR(svn_io_file_aligned_seek(stream->file, stream->block_size,
+                                       &block_start, stream->next_offset,
+                                       stream->pool));
 
-  /* prefetch at least one number but, if feasible, don't cross block
-   * boundaries.  This shall prevent jumping back and forth between two
-   * blocks because the extra data was not actually request _now_.
-   */
-  bytes_read = sizeof(buffer);
-  block_left = stream->block_size - (stream->next_offset - block_start);
-  if (block_left >= 10 && block_left < bytes_read)
-    bytes_read = (apr_size_t)block_left;
-
-  /* Don't read beyond the end of the file section that belongs to this
-   * index / stream. */
-  bytes_read = (apr_size_t)MIN(bytes_read,
-                               stream->stream_end - stream->next_offset);
-
-  err = apr_file_read(stream->file, buffer, &bytes_read);
-  if (err && !APR_STATUS_IS_EOF(err))
-    return stream_error_create(stream, err,
-      _("Can't read index file '%s' at offset 0x%s"));
+      /* prefetch at least one number but, if feasible, don't cross block
+       * boundaries.  This shall prevent jumping back and forth between two
+       * blocks because the extra data was not actually request _now_.
+       */
+      bytes_read = sizeof(file_buffer);
+      block_left = stream->block_size - (stream->next_offset - block_start);
+      if (block_left >= 10 && block_left < bytes_read)
+        bytes_read = (apr_size_t)block_left;
+
+      /* Don't read beyond the end of the file section that belongs to this
+       * index / stream. */
+      bytes_read = (apr_size_t)MIN(bytes_read,
+                                   stream->stream_end - stream->next_offset);
+
+      err = apr_file_read(stream->file, file_buffer, &bytes_read);
+      if (err && !APR_STATUS_IS_EOF(err))
+        return stream_error_create(stream, err,
+          _("Can't read index file '%s' at offset 0x%s"));
+    }
 
   /* if the last number is incomplete, trim it from the buffer */
   while (bytes_read > 0 && buffer[bytes_read-1] >= 0x80)
@@ -302,6 +355,25 @@ packed_stream_read(svn_fs_fs__packed_number_stream_t *stream)
   target = stream->buffer;
   for (i = 0; i < bytes_read;)
     {
+      if (bytes_read - i >= 16)
+        {
+          /* numbers < 128 usually come in runs, e.g. item numbers and
+           * small sizes.  Expand those without further tests. */
+          apr_size_t count = count_short_numbers(buffer + i);
+          apr_size_t k;
+
+          for (k = 0; k < count; ++k)
+            {
+              target[k].value = buffer[i + k];
+              target[k].total_len = i + k + 1;
+            }
+
+          target += count;
+          i += count;
+          if (count == 16)
+            continue;
+        }
+
       if (buffer[i] < 0x80)
         {
           /* numbers < 128 are relatively frequent and particularly easy
@@ -343,9 +415,43 @@ packed_stream_read(svn_fs_fs__packed_number_stream_t *stream)
   return SVN_NO_ERROR;
 }
 
+/* If supported, map the contents of FILE from offset START to END into
+ * memory and return the address that corresponds to file offset
+ * *DATA_START in *DATA.  The mapping will be removed when RESULT_POOL gets
+ * cleaned up.  Set *DATA to NULL if the section could not be mapped.
+ */
+static void
+map_stream_data(const unsigned char **data,
+                apr_off_t *data_start,
+                apr_file_t *file,
+                apr_off_t start,
+                apr_off_t end,
+                apr_pool_t *result_pool)
+{
+  *data = NULL;
+  *data_start = start - start % MMAP_ALIGNMENT;
+
+#if APR_HAS_MMAP
+  /* We won't be able to map large sections on 32 bit systems. */
+  if (start < end && end - *data_start <= APR_SIZE_MAX)
+    {
+      apr_mmap_t *mmap;
+      apr_status_t status = apr_mmap_create(&mmap, file, *data_start,
+                                            (apr_size_t)(end - *data_start),
+                                            APR_MMAP_READ, result_pool);
+
+      /* Failing to map the file is not an error.  We simply read it. */
+      if (status == APR_SUCCESS)
+        *data = mmap->mm;
+    }
+#endif
+}
+
 /* Create and open a packed number stream reading from offsets START to
  * END in FILE and return it in *STREAM.  Access the file in chunks of
  * BLOCK_SIZE bytes.  Expect the stream to be prefixed by STREAM_PREFIX.
+ * If USE_MMAP is set, try to map the stream data into memory instead.
+ * Only do that for files that will not change while RESULT_POOL exists.
  * Allocate *STREAM in RESULT_POOL and use SCRATCH_POOL for temporaries.
  */
 static svn_error_t *
@@ -355,22 +461,35 @@ packed_stream_open(svn_fs_fs__packed_number_stream_t **stream,
                    apr_off_t end,
                    const char *stream_prefix,
                    apr_size_t block_size,
+                   svn_boolean_t use_mmap,
                    apr_pool_t *result_pool,
                    apr_pool_t *scratch_pool)
 {
   char buffer[STREAM_PREFIX_LEN + 1] = { 0 };
   apr_size_t len = strlen(stream_prefix);
   svn_fs_fs__packed_number_stream_t *result;
+  const unsigned char *data = NULL;
+  apr_off_t data_start = 0;
 
   /* If this is violated, we forgot to adjust STREAM_PREFIX_LEN after
    * changing the index header prefixes. */
   SVN_ERR_ASSERT(len < sizeof(buffer));
 
+  if (use_mmap)
+    map_stream_data(&data, &data_start, file, start, end, result_pool);
+
   /* Read the header prefix and compare it with the expected prefix */
-  SVN_ERR(svn_io_file_aligned_seek(file, block_size, NULL, start,
-                                   scratch_pool));
-  SVN_ERR(svn_io_file_read_full2(file, buffer, len, NULL, NULL,
-                                 scratch_pool));
+  if (data && end - start >= len)
+    {
+      memcpy(buffer, data + (start - data_start), len);
+    }
+  else
+    {
+      SVN_ERR(svn_io_file_aligned_seek(file, block_size, NULL, start,
+                                       scratch_pool));
+      SVN_ERR(svn_io_file_read_full2(file, buffer, len, NULL, NULL,
+                                     scratch_pool));
+    }
 
   if (strncmp(buffer, stream_prefix, len))
     return svn_error_createf(SVN_ERR_FS_INDEX_CORRUPTION, NULL,
@@ -391,6 +510,8 @@ packed_stream_open(svn_fs_fs__packed_number_stream_t **stream,
   result->start_offset = result->stream_start;
   result->next_offset = result->stream_start;
   result->block_size = block_size;
+  result->data = data;
+  result->data_start = data_start;
 
   *stream = result;
 
@@ -945,12 +1066,16 @@ auto_open_l2p_index(svn_fs_fs__revision_file_t *rev_file,
       fs_fs_data_t *ffd = fs->fsap_data;
 
       SVN_ERR(svn_fs_fs__auto_read_footer(rev_file));
+
+      /* Cached pack file handles are read-only and live long enough
+       * for a mapping to pay off. */
       SVN_ERR(packed_stream_open(&rev_file->l2p_stream,
                                  rev_file->file,
                                  rev_file->l2p_offset,
                                  rev_file->p2l_offset,
                                  L2P_STREAM_PREFIX,
                                  (apr_size_t)ffd->block_size,
+                                 rev_file->handle != NULL,
                                  rev_file->pool,
                                  rev_file->pool));
     }
@@ -2137,12 +2262,16 @@ auto_open_p2l_index(svn_fs_fs__revision_file_t *rev_file,
       fs_fs_data_t *ffd = fs->fsap_data;
 
       SVN_ERR(svn_fs_fs__auto_read_footer(rev_file));
+
+      /* Cached pack file handles are read-only and live long enough
+       * for a mapping to pay off. */
       SVN_ERR(packed_stream_open(&rev_file->p2l_stream,
                                  rev_file->file,
                                  rev_file->p2l_offset,
                                  rev_file->footer_offset,
                                  P2L_STREAM_PREFIX,
                                  (apr_size_t)ffd->block_size,
+                                 rev_file->handle != NULL,
                                  rev_file->pool,
                                  rev_file->pool));
     }
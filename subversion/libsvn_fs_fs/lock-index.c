@@ -0,0 +1,316 @@
+/* lock-index.c --- the FSFS lock index
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_pools.h"
+#include "svn_dirent_uri.h"
+
+#include "svn_private_config.h"
+
+#include "fs_fs.h"
+#include "fs.h"
+#include "lock-index.h"
+#include "util.h"
+
+#include "private/svn_sqlite.h"
+#include "../libsvn_fs/fs-loader.h"
+
+#include "lock-index-db.h"
+
+/* A few magic values */
+#define LOCK_INDEX_SCHEMA_FORMAT   1
+
+LOCK_INDEX_DB_SQL_DECLARE_STATEMENTS(statements);
+
+
+
+/** Helper functions. **/
+static APR_INLINE const char *
+path_lock_index_db(const char *fs_path,
+                   apr_pool_t *result_pool)
+{
+  return svn_dirent_join(fs_path, LOCK_INDEX_DB_NAME, result_pool);
+}
+
+/* Return the lock described by the current row of STMT, allocated in
+   RESULT_POOL. */
+static svn_lock_t *
+lock_from_row(svn_sqlite__stmt_t *stmt,
+              apr_pool_t *result_pool)
+{
+  svn_lock_t *lock = svn_lock_create(result_pool);
+
+  lock->path = svn_sqlite__column_text(stmt, 0, result_pool);
+  lock->token = svn_sqlite__column_text(stmt, 1, result_pool);
+  lock->owner = svn_sqlite__column_text(stmt, 2, result_pool);
+  lock->comment = svn_sqlite__column_text(stmt, 3, result_pool);
+  lock->is_dav_comment = svn_sqlite__column_boolean(stmt, 4);
+  lock->creation_date = svn_sqlite__column_int64(stmt, 5);
+  lock->expiration_date = svn_sqlite__column_int64(stmt, 6);
+
+  return lock;
+}
+
+/* Store LOCK in the lock index database SDB. */
+static svn_error_t *
+set_lock_row(svn_sqlite__db_t *sdb,
+             const svn_lock_t *lock)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_SET_LOCK));
+  SVN_ERR(svn_sqlite__bindf(stmt, "ssssdii", lock->path, lock->token,
+                            lock->owner, lock->comment,
+                            lock->is_dav_comment ? 1 : 0,
+                            (apr_int64_t)lock->creation_date,
+                            (apr_int64_t)lock->expiration_date));
+
+  return svn_error_trace(svn_sqlite__insert(NULL, stmt));
+}
+
+/* Implements svn_fs_get_locks_callback_t, adding LOCK to the
+   svn_sqlite__db_t * BATON. */
+static svn_error_t *
+add_lock_row(void *baton,
+             svn_lock_t *lock,
+             apr_pool_t *pool)
+{
+  return svn_error_trace(set_lock_row(baton, lock));
+}
+
+
+/** Library-private API's. **/
+
+/* Body of svn_fs_fs__open_lock_index().
+   Implements svn_atomic__init_once().init_func.
+ */
+static svn_error_t *
+open_lock_index(void *baton,
+                apr_pool_t *pool)
+{
+  svn_fs_t *fs = baton;
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__db_t *sdb;
+  int version;
+
+  /* The database gets only ever created as a whole by
+     svn_fs_fs__build_lock_index().  It will be automatically closed
+     when fs->pool is destroyed. */
+  SVN_ERR(svn_sqlite__open(&sdb, path_lock_index_db(fs->path, pool),
+                           svn_sqlite__mode_readwrite, statements,
+                           0, NULL, 0,
+                           fs->pool, pool));
+
+  SVN_SQLITE__ERR_CLOSE(svn_sqlite__read_schema_version(&version, sdb, pool),
+                        sdb);
+  if (version != LOCK_INDEX_SCHEMA_FORMAT)
+    return svn_error_compose_create(
+             svn_error_createf(SVN_ERR_FS_UNSUPPORTED_FORMAT, NULL,
+                               _("Unsupported lock index format %d"),
+                               version),
+             svn_sqlite__close(sdb));
+
+  /* This is used as a flag that the database is available so don't
+     set it earlier. */
+  ffd->lock_index_db = sdb;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__open_lock_index(svn_fs_t *fs,
+                           apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_error_t *err = svn_atomic__init_once(&ffd->lock_index_db_opened,
+                                           open_lock_index, fs, pool);
+  return svn_error_quick_wrap(err, _("Couldn't open lock index"));
+}
+
+svn_error_t *
+svn_fs_fs__exists_lock_index(svn_boolean_t *exists,
+                             svn_fs_t *fs,
+                             apr_pool_t *pool)
+{
+  svn_node_kind_t kind;
+
+  SVN_ERR(svn_io_check_path(path_lock_index_db(fs->path, pool),
+                            &kind, pool));
+
+  *exists = (kind != svn_node_none);
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__build_lock_index(svn_fs_t *fs,
+                            svn_fs_fs__lock_walker_t walker,
+                            apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  const char *db_path = path_lock_index_db(fs->path, pool);
+  const char *tmp_path = apr_pstrcat(pool, db_path, ".tmp", SVN_VA_NULL);
+  svn_sqlite__db_t *sdb;
+  svn_error_t *err;
+
+  /* Populate a temporary database first, so that an interrupted build
+     leaves no incomplete index behind.  Remove leftovers of an earlier
+     attempt. */
+  SVN_ERR(svn_io_remove_file2(tmp_path, TRUE, pool));
+  SVN_ERR(svn_sqlite__open(&sdb, tmp_path, svn_sqlite__mode_rwcreate,
+                           statements, 0, NULL, 0, pool, pool));
+
+  err = svn_sqlite__exec_statements(sdb, STMT_CREATE_SCHEMA);
+  if (!err)
+    {
+      err = svn_sqlite__begin_transaction(sdb);
+      if (!err)
+        err = svn_sqlite__finish_transaction(sdb,
+                                             walker(fs, add_lock_row, sdb,
+                                                    pool));
+    }
+
+  SVN_ERR(svn_error_compose_create(err, svn_sqlite__close(sdb)));
+
+#ifndef WIN32
+  /* Like the rep-cache, extend the permissions that apply to the
+     repository as a whole. */
+  SVN_ERR(svn_io_copy_perms(svn_fs_fs__path_current(fs, pool), tmp_path,
+                            pool));
+#endif
+
+  SVN_ERR(svn_io_file_rename2(tmp_path, db_path, ffd->flush_to_disk, pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__remove_lock_index(svn_fs_t *fs,
+                             apr_pool_t *pool)
+{
+  return svn_error_trace(svn_io_remove_file2(path_lock_index_db(fs->path,
+                                                                pool),
+                                             TRUE, pool));
+}
+
+svn_error_t *
+svn_fs_fs__get_indexed_lock(svn_lock_t **lock,
+                            svn_fs_t *fs,
+                            const char *path,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  if (! ffd->lock_index_db)
+    SVN_ERR(svn_fs_fs__open_lock_index(fs, scratch_pool));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->lock_index_db,
+                                    STMT_GET_LOCK));
+  SVN_ERR(svn_sqlite__bindf(stmt, "s", path));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  *lock = have_row ? lock_from_row(stmt, result_pool) : NULL;
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+svn_error_t *
+svn_fs_fs__get_indexed_locks(apr_array_header_t **locks,
+                             svn_fs_t *fs,
+                             const char *lower,
+                             const char *upper,
+                             int limit,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  if (! ffd->lock_index_db)
+    SVN_ERR(svn_fs_fs__open_lock_index(fs, scratch_pool));
+
+  *locks = apr_array_make(result_pool, 16, sizeof(svn_lock_t *));
+
+  /* Fetch the whole batch before returning, so that our callers may
+     run other queries against the index while processing it. */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->lock_index_db,
+                                    STMT_GET_LOCKS_IN_RANGE));
+  SVN_ERR(svn_sqlite__bindf(stmt, "ssd", lower, upper, limit));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      APR_ARRAY_PUSH(*locks, svn_lock_t *) = lock_from_row(stmt,
+                                                           result_pool);
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+svn_error_t *
+svn_fs_fs__set_indexed_lock(svn_fs_t *fs,
+                            const svn_lock_t *lock,
+                            apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  if (! ffd->lock_index_db)
+    SVN_ERR(svn_fs_fs__open_lock_index(fs, scratch_pool));
+
+  return svn_error_trace(set_lock_row(ffd->lock_index_db, lock));
+}
+
+svn_error_t *
+svn_fs_fs__delete_indexed_lock(svn_fs_t *fs,
+                               const char *path,
+                               apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+
+  if (! ffd->lock_index_db)
+    SVN_ERR(svn_fs_fs__open_lock_index(fs, scratch_pool));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->lock_index_db,
+                                    STMT_DELETE_LOCK));
+  SVN_ERR(svn_sqlite__bindf(stmt, "s", path));
+
+  return svn_error_trace(svn_sqlite__step_done(stmt));
+}
+
+svn_error_t *
+svn_fs_fs__with_lock_index_txn(svn_fs_t *fs,
+                               svn_error_t *(*body)(void *baton,
+                                                    apr_pool_t *pool),
+                               void *baton,
+                               apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  if (! ffd->lock_index_db)
+    SVN_ERR(svn_fs_fs__open_lock_index(fs, pool));
+
+  SVN_SQLITE__WITH_TXN(body(baton, pool), ffd->lock_index_db);
+
+  return SVN_NO_ERROR;
+}
@@ -0,0 +1,135 @@
+/* lock-index.h : interface to the FSFS lock index
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_FS_FS_LOCK_INDEX_H
+#define SVN_LIBSVN_FS_FS_LOCK_INDEX_H
+
+#include "svn_error.h"
+#include "svn_fs.h"
+
+#include "fs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+
+#define LOCK_INDEX_DB_NAME  "lock-index.db"
+
+/* The lock index is an optional SQLite database that holds a copy of
+ * all locks, keyed and sorted by path.  It lets us find all locks in a
+ * sub-tree with a single range query instead of reading one digest file
+ * per lock.  Once the database exists, lock.c reads locks from it and
+ * keeps the digest files under PATH_LOCKS_DIR in sync with it, so they
+ * can be used again when the index gets disabled or deleted.
+ *
+ * The index only gets created and modified while holding the repository
+ * write lock.
+ */
+
+/* Callback type used to populate a new lock index.  It must call
+   CALLBACK with CALLBACK_BATON for every lock in FS.  Use POOL for
+   temporary allocations. */
+typedef svn_error_t *
+(*svn_fs_fs__lock_walker_t)(svn_fs_t *fs,
+                            svn_fs_get_locks_callback_t callback,
+                            void *callback_baton,
+                            apr_pool_t *pool);
+
+/* Open the existing lock index database associated with FS.
+   Use POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__open_lock_index(svn_fs_t *fs,
+                           apr_pool_t *pool);
+
+/* Set *EXISTS to TRUE iff the lock index DB file exists. */
+svn_error_t *
+svn_fs_fs__exists_lock_index(svn_boolean_t *exists,
+                             svn_fs_t *fs,
+                             apr_pool_t *pool);
+
+/* Create the lock index for FS and fill it with all locks that WALKER
+   reports.  The database becomes visible only once it is complete.
+   The caller must hold the write lock.  Use POOL for temporary
+   allocations. */
+svn_error_t *
+svn_fs_fs__build_lock_index(svn_fs_t *fs,
+                            svn_fs_fs__lock_walker_t walker,
+                            apr_pool_t *pool);
+
+/* Delete the lock index of FS, if it exists.  The caller must hold the
+   write lock.  Use POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__remove_lock_index(svn_fs_t *fs,
+                             apr_pool_t *pool);
+
+/* Set *LOCK to the indexed lock on PATH in FS, or to NULL if there is
+   none.  Expired locks are returned as well.  Allocate the result in
+   RESULT_POOL and use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__get_indexed_lock(svn_lock_t **lock,
+                            svn_fs_t *fs,
+                            const char *path,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool);
+
+/* Set *LOCKS to an array of up to LIMIT svn_lock_t * from the index of
+   FS, in path order, whose paths lie strictly between LOWER and UPPER.
+   Expired locks are returned as well.  Allocate the result in
+   RESULT_POOL and use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__get_indexed_locks(apr_array_header_t **locks,
+                             svn_fs_t *fs,
+                             const char *lower,
+                             const char *upper,
+                             int limit,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool);
+
+/* Add LOCK to the index of FS, replacing any previous lock on the same
+   path.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__set_indexed_lock(svn_fs_t *fs,
+                            const svn_lock_t *lock,
+                            apr_pool_t *scratch_pool);
+
+/* Remove the lock on PATH from the index of FS.  Do nothing, if there
+   is none.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__delete_indexed_lock(svn_fs_t *fs,
+                               const char *path,
+                               apr_pool_t *scratch_pool);
+
+/* Call BODY with BATON and POOL within a single transaction on the lock
+   index of FS.  Roll back all index modifications if BODY fails. */
+svn_error_t *
+svn_fs_fs__with_lock_index_txn(svn_fs_t *fs,
+                               svn_error_t *(*body)(void *baton,
+                                                    apr_pool_t *pool),
+                               void *baton,
+                               apr_pool_t *pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_FS_FS_LOCK_INDEX_H */
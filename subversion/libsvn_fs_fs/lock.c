@@ -34,6 +34,7 @@
 #include <apr_file_info.h>
 
 #include "lock.h"
+#include "lock-index.h"
 #include "tree.h"
 #include "fs_fs.h"
 #include "util.h"
@@ -58,6 +59,9 @@
    calculate a subdirectory in which to drop that file. */
 #define DIGEST_SUBDIR_LEN 3
 
+/* Number of locks to fetch from the lock index at once. */
+#define LOCK_INDEX_BATCH_SIZE 1000
+
 
 
 /*** Generic helper functions. ***/
@@ -457,6 +461,25 @@ static svn_boolean_t lock_expired(const svn_lock_t *lock)
   return lock->expiration_date && (apr_time_now() > lock->expiration_date);
 }
 
+/* Set *USE_INDEX to TRUE if locks in FS shall be read from the lock index
+   instead of the digest files.  Use POOL for temporary allocations. */
+static svn_error_t *
+use_lock_index(svn_boolean_t *use_index,
+               svn_fs_t *fs,
+               apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  if (!ffd->lock_index)
+    *use_index = FALSE;
+  else if (ffd->lock_index_db)
+    *use_index = TRUE;
+  else
+    SVN_ERR(svn_fs_fs__exists_lock_index(use_index, fs, pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Set *LOCK_P to the lock for PATH in FS.  HAVE_WRITE_LOCK should be
    TRUE if the caller (or one of its callers) has taken out the
    repository-wide write lock, FALSE otherwise.  If MUST_EXIST is
@@ -472,15 +495,24 @@ get_lock(svn_lock_t **lock_p,
          apr_pool_t *pool)
 {
   svn_lock_t *lock = NULL;
-  const char *digest_path;
-  svn_node_kind_t kind;
-
-  SVN_ERR(digest_path_from_path(&digest_path, fs->path, path, pool));
-  SVN_ERR(svn_io_check_path(digest_path, &kind, pool));
+  svn_boolean_t use_index;
 
   *lock_p = NULL;
-  if (kind != svn_node_none)
-    SVN_ERR(read_digest_file(NULL, &lock, fs->path, digest_path, pool));
+  SVN_ERR(use_lock_index(&use_index, fs, pool));
+  if (use_index)
+    {
+      SVN_ERR(svn_fs_fs__get_indexed_lock(&lock, fs, path, pool, pool));
+    }
+  else
+    {
+      const char *digest_path;
+      svn_node_kind_t kind;
+
+      SVN_ERR(digest_path_from_path(&digest_path, fs->path, path, pool));
+      SVN_ERR(svn_io_check_path(digest_path, &kind, pool));
+      if (kind != svn_node_none)
+        SVN_ERR(read_digest_file(NULL, &lock, fs->path, digest_path, pool));
+    }
 
   if (! lock)
     return must_exist ? SVN_FS__ERR_NO_SUCH_LOCK(fs, path) : SVN_NO_ERROR;
@@ -595,6 +627,158 @@ walk_locks(svn_fs_t *fs,
 }
 
 
+/* Call GET_LOCKS_FUNC with GET_LOCKS_BATON for LOCK in FS unless it has
+   expired.  Remove expired locks if HAVE_WRITE_LOCK is set.  Use POOL
+   for temporary allocations. */
+static svn_error_t *
+report_indexed_lock(svn_fs_t *fs,
+                    svn_lock_t *lock,
+                    svn_fs_get_locks_callback_t get_locks_func,
+                    void *get_locks_baton,
+                    svn_boolean_t have_write_lock,
+                    apr_pool_t *pool)
+{
+  if (lock_expired(lock))
+    {
+      /* Only remove the lock if we have the write lock.
+         Read operations shouldn't change the filesystem. */
+      if (have_write_lock)
+        SVN_ERR(unlock_single(fs, lock, pool));
+    }
+  else
+    {
+      SVN_ERR(get_locks_func(get_locks_baton, lock, pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Like walk_locks() but read the locks in and under PATH from the lock
+   index of FS. */
+static svn_error_t *
+walk_indexed_locks(svn_fs_t *fs,
+                   const char *path,
+                   svn_fs_get_locks_callback_t get_locks_func,
+                   void *get_locks_baton,
+                   svn_boolean_t have_write_lock,
+                   apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_array_header_t *locks;
+  const char *lower;
+  char *upper;
+  svn_lock_t *lock;
+  int i;
+
+  /* First, send up the lock on PATH itself. */
+  SVN_ERR(svn_fs_fs__get_indexed_lock(&lock, fs, path, pool, pool));
+  if (lock)
+    SVN_ERR(report_indexed_lock(fs, lock, get_locks_func, get_locks_baton,
+                                have_write_lock, pool));
+
+  /* All paths below PATH lie between "PATH/" and "PATH0" because '0'
+     immediately follows '/' in ASCII. */
+  lower = svn_fspath__is_root(path, strlen(path))
+        ? path
+        : apr_pstrcat(pool, path, "/", SVN_VA_NULL);
+  upper = apr_pstrdup(pool, lower);
+  upper[strlen(upper) - 1] = '0';
+
+  /* Now, the locks below PATH in batches.  Each batch continues after
+     the last path of the previous one. */
+  do
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_fs__get_indexed_locks(&locks, fs, lower, upper,
+                                           LOCK_INDEX_BATCH_SIZE,
+                                           iterpool, iterpool));
+      for (i = 0; i < locks->nelts; ++i)
+        SVN_ERR(report_indexed_lock(fs, APR_ARRAY_IDX(locks, i, svn_lock_t *),
+                                    get_locks_func, get_locks_baton,
+                                    have_write_lock, iterpool));
+
+      if (locks->nelts)
+        lower = apr_pstrdup(pool, APR_ARRAY_IDX(locks, locks->nelts - 1,
+                                                svn_lock_t *)->path);
+    }
+  while (locks->nelts == LOCK_INDEX_BATCH_SIZE);
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_fs_fs__lock_walker_t, reporting all locks from the
+   digest files of FS. */
+static svn_error_t *
+walk_all_digest_locks(svn_fs_t *fs,
+                      svn_fs_get_locks_callback_t callback,
+                      void *callback_baton,
+                      apr_pool_t *pool)
+{
+  const char *digest_path;
+
+  /* Expired locks get removed by the next operation that hits them
+     in the index.  Don't remove them here because that would try to
+     update the index that we are just about to create. */
+  SVN_ERR(digest_path_from_path(&digest_path, fs->path, "/", pool));
+  return svn_error_trace(walk_locks(fs, digest_path, callback,
+                                    callback_baton, FALSE, pool));
+}
+
+/* Report all locks in and under PATH in FS like walk_locks() does,
+   reading them from the lock index if that is available. */
+static svn_error_t *
+walk_path_locks(svn_fs_t *fs,
+                const char *path,
+                svn_fs_get_locks_callback_t get_locks_func,
+                void *get_locks_baton,
+                svn_boolean_t have_write_lock,
+                apr_pool_t *pool)
+{
+  const char *digest_path;
+  svn_boolean_t use_index;
+
+  SVN_ERR(use_lock_index(&use_index, fs, pool));
+  if (use_index)
+    return svn_error_trace(walk_indexed_locks(fs, path, get_locks_func,
+                                              get_locks_baton,
+                                              have_write_lock, pool));
+
+  SVN_ERR(digest_path_from_path(&digest_path, fs->path, path, pool));
+  return svn_error_trace(walk_locks(fs, digest_path, get_locks_func,
+                                    get_locks_baton, have_write_lock,
+                                    pool));
+}
+
+/* Create the lock index of FS if it is enabled but does not exist, yet,
+   and remove it if it has been disabled.  Set *USE_INDEX to TRUE if lock
+   modifications need to be applied to the index.  This assumes that the
+   write lock is held.  Use POOL for temporary allocations. */
+static svn_error_t *
+prepare_lock_index(svn_boolean_t *use_index,
+                   svn_fs_t *fs,
+                   apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_boolean_t exists;
+
+  if (ffd->lock_index_db)
+    {
+      *use_index = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_fs_fs__exists_lock_index(&exists, fs, pool));
+  if (ffd->lock_index && !exists)
+    SVN_ERR(svn_fs_fs__build_lock_index(fs, walk_all_digest_locks, pool));
+  else if (!ffd->lock_index && exists)
+    SVN_ERR(svn_fs_fs__remove_lock_index(fs, pool));
+
+  *use_index = ffd->lock_index;
+  return SVN_NO_ERROR;
+}
+
+
 /* Utility function:  verify that a lock can be used.  Interesting
    errors returned from this function:
 
@@ -652,10 +836,8 @@ svn_fs_fs__allow_locked_operation(const char *path,
   if (recurse)
     {
       /* Discover all locks at or below the path. */
-      const char *digest_path;
-      SVN_ERR(digest_path_from_path(&digest_path, fs->path, path, pool));
-      SVN_ERR(walk_locks(fs, digest_path, get_locks_callback,
-                         fs, have_write_lock, pool));
+      SVN_ERR(walk_path_locks(fs, path, get_locks_callback,
+                              fs, have_write_lock, pool));
     }
   else
     {
@@ -707,6 +889,10 @@ struct lock_baton {
   apr_time_t expiration_date;
   svn_boolean_t steal_lock;
   apr_pool_t *result_pool;
+
+  /* Set by lock_body(). */
+  apr_hash_t *index_updates;
+  svn_boolean_t use_index;
 };
 
 static svn_error_t *
@@ -823,59 +1009,19 @@ struct lock_info_t {
   svn_error_t *fs_err;
 };
 
-/* The body of svn_fs_fs__lock(), which see.
-
-   BATON is a 'struct lock_baton *' holding the effective arguments.
-   BATON->targets is an array of 'svn_sort__item_t' targets, sorted by
-   path, mapping canonical path to 'svn_fs_lock_target_t'.  Set
-   BATON->infos to an array of 'lock_info_t' holding the results.  For
-   the other arguments, see svn_fs_lock_many().
-
-   This implements the svn_fs_fs__with_write_lock() 'body' callback
-   type, and assumes that the write lock is held.
- */
+/* Write the locks for all BATON->infos without an error, together with
+   the scheduled BATON->index_updates, and add them to the lock index if
+   BATON->use_index is set.  BATON is a 'struct lock_baton *'.  Use POOL
+   for temporary allocations. */
 static svn_error_t *
-lock_body(void *baton, apr_pool_t *pool)
+write_locks(void *baton, apr_pool_t *pool)
 {
   struct lock_baton *lb = baton;
-  svn_fs_root_t *root;
-  svn_revnum_t youngest;
   const char *rev_0_path;
   int i;
-  apr_hash_t *index_updates = apr_hash_make(pool);
   apr_hash_index_t *hi;
   apr_pool_t *iterpool = svn_pool_create(pool);
 
-  /* Until we implement directory locks someday, we only allow locks
-     on files. */
-  /* Use fs->vtable->foo instead of svn_fs_foo to avoid circular
-     library dependencies, which are not portable. */
-  SVN_ERR(lb->fs->vtable->youngest_rev(&youngest, lb->fs, pool));
-  SVN_ERR(lb->fs->vtable->revision_root(&root, lb->fs, youngest, pool));
-
-  for (i = 0; i < lb->targets->nelts; ++i)
-    {
-      const svn_sort__item_t *item = &APR_ARRAY_IDX(lb->targets, i,
-                                                    svn_sort__item_t);
-      struct lock_info_t info;
-
-      svn_pool_clear(iterpool);
-
-      info.path = item->key;
-      info.lock = NULL;
-      info.fs_err = SVN_NO_ERROR;
-
-      SVN_ERR(check_lock(&info.fs_err, info.path, item->value, lb, root,
-                         youngest, iterpool));
-
-      /* If no error occurred while pre-checking, schedule the index updates for
-         this path. */
-      if (!info.fs_err)
-        schedule_index_update(index_updates, info.path, iterpool);
-
-      APR_ARRAY_PUSH(lb->infos, struct lock_info_t) = info;
-    }
-
   rev_0_path = svn_fs_fs__path_rev_absolute(lb->fs, 0, pool);
 
   /* We apply the scheduled index updates before writing the actual locks.
@@ -887,7 +1033,8 @@ lock_body(void *baton, apr_pool_t *pool)
      index is inconsistent, svn_fs_fs__allow_locked_operation will
      show locked on the file but unlocked on the parent. */
 
-  for (hi = apr_hash_first(pool, index_updates); hi; hi = apr_hash_next(hi))
+  for (hi = apr_hash_first(pool, lb->index_updates); hi;
+       hi = apr_hash_next(hi))
     {
       const char *path = apr_hash_this_key(hi);
       apr_array_header_t *children = apr_hash_this_val(hi);
@@ -927,6 +1074,11 @@ lock_body(void *baton, apr_pool_t *pool)
 
           info->fs_err = set_lock(lb->fs->path, info->lock, rev_0_path,
                                   iterpool);
+
+          /* The index must not report locks that we failed to write. */
+          if (! info->fs_err && lb->use_index)
+            SVN_ERR(svn_fs_fs__set_indexed_lock(lb->fs, info->lock,
+                                                iterpool));
         }
     }
 
@@ -934,6 +1086,69 @@ lock_body(void *baton, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* The body of svn_fs_fs__lock(), which see.
+
+   BATON is a 'struct lock_baton *' holding the effective arguments.
+   BATON->targets is an array of 'svn_sort__item_t' targets, sorted by
+   path, mapping canonical path to 'svn_fs_lock_target_t'.  Set
+   BATON->infos to an array of 'lock_info_t' holding the results.  For
+   the other arguments, see svn_fs_lock_many().
+
+   This implements the svn_fs_fs__with_write_lock() 'body' callback
+   type, and assumes that the write lock is held.
+ */
+static svn_error_t *
+lock_body(void *baton, apr_pool_t *pool)
+{
+  struct lock_baton *lb = baton;
+  svn_fs_root_t *root;
+  svn_revnum_t youngest;
+  int i;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  /* Until we implement directory locks someday, we only allow locks
+     on files. */
+  /* Use fs->vtable->foo instead of svn_fs_foo to avoid circular
+     library dependencies, which are not portable. */
+  SVN_ERR(lb->fs->vtable->youngest_rev(&youngest, lb->fs, pool));
+  SVN_ERR(lb->fs->vtable->revision_root(&root, lb->fs, youngest, pool));
+  SVN_ERR(prepare_lock_index(&lb->use_index, lb->fs, pool));
+  lb->index_updates = apr_hash_make(pool);
+
+  for (i = 0; i < lb->targets->nelts; ++i)
+    {
+      const svn_sort__item_t *item = &APR_ARRAY_IDX(lb->targets, i,
+                                                    svn_sort__item_t);
+      struct lock_info_t info;
+
+      svn_pool_clear(iterpool);
+
+      info.path = item->key;
+      info.lock = NULL;
+      info.fs_err = SVN_NO_ERROR;
+
+      SVN_ERR(check_lock(&info.fs_err, info.path, item->value, lb, root,
+                         youngest, iterpool));
+
+      /* If no error occurred while pre-checking, schedule the index updates for
+         this path. */
+      if (!info.fs_err)
+        schedule_index_update(lb->index_updates, info.path, iterpool);
+
+      APR_ARRAY_PUSH(lb->infos, struct lock_info_t) = info;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  /* Readers see either all or none of the new locks in the index. */
+  if (lb->use_index)
+    SVN_ERR(svn_fs_fs__with_lock_index_txn(lb->fs, write_locks, lb, pool));
+  else
+    SVN_ERR(write_locks(lb, pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* The effective arguments for unlock_body() below. */
 struct unlock_baton {
   svn_fs_t *fs;
@@ -943,6 +1158,10 @@ struct unlock_baton {
   svn_boolean_t skip_check;
   svn_boolean_t break_lock;
   apr_pool_t *result_pool;
+
+  /* Set by unlock_body(). */
+  apr_hash_t *index_updates;
+  svn_boolean_t use_index;
 };
 
 static svn_error_t *
@@ -975,6 +1194,56 @@ struct unlock_info_t {
   svn_boolean_t done;
 };
 
+/* Delete the locks for all BATON->infos without an error, remove them
+   from the lock index if BATON->use_index is set, and then apply the
+   scheduled BATON->index_updates.  BATON is a 'struct unlock_baton *'.
+   Use POOL for temporary allocations. */
+static svn_error_t *
+delete_locks(void *baton, apr_pool_t *pool)
+{
+  struct unlock_baton *ub = baton;
+  const char *rev_0_path;
+  int i;
+  apr_hash_index_t *hi;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  rev_0_path = svn_fs_fs__path_rev_absolute(ub->fs, 0, pool);
+
+  /* Unlike the lock_body(), we need to delete locks *before* we start to
+     update indices. */
+
+  for (i = 0; i < ub->infos->nelts; ++i)
+    {
+      struct unlock_info_t *info = &APR_ARRAY_IDX(ub->infos, i,
+                                                  struct unlock_info_t);
+
+      svn_pool_clear(iterpool);
+
+      if (! info->fs_err)
+        {
+          SVN_ERR(delete_lock(ub->fs->path, info->path, iterpool));
+          if (ub->use_index)
+            SVN_ERR(svn_fs_fs__delete_indexed_lock(ub->fs, info->path,
+                                                   iterpool));
+          info->done = TRUE;
+        }
+    }
+
+  for (hi = apr_hash_first(pool, ub->index_updates); hi;
+       hi = apr_hash_next(hi))
+    {
+      const char *path = apr_hash_this_key(hi);
+      apr_array_header_t *children = apr_hash_this_val(hi);
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(delete_from_digest(ub->fs->path, children, path, rev_0_path,
+                                 iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
 /* The body of svn_fs_fs__unlock(), which see.
 
    BATON is a 'struct unlock_baton *' holding the effective arguments.
@@ -992,14 +1261,13 @@ unlock_body(void *baton, apr_pool_t *pool)
   struct unlock_baton *ub = baton;
   svn_fs_root_t *root;
   svn_revnum_t youngest;
-  const char *rev_0_path;
   int i;
-  apr_hash_t *indices_updates = apr_hash_make(pool);
-  apr_hash_index_t *hi;
   apr_pool_t *iterpool = svn_pool_create(pool);
 
   SVN_ERR(ub->fs->vtable->youngest_rev(&youngest, ub->fs, pool));
   SVN_ERR(ub->fs->vtable->revision_root(&root, ub->fs, youngest, pool));
+  SVN_ERR(prepare_lock_index(&ub->use_index, ub->fs, pool));
+  ub->index_updates = apr_hash_make(pool);
 
   for (i = 0; i < ub->targets->nelts; ++i)
     {
@@ -1021,41 +1289,18 @@ unlock_body(void *baton, apr_pool_t *pool)
       /* If no error occurred while pre-checking, schedule the index updates for
          this path. */
       if (!info.fs_err)
-        schedule_index_update(indices_updates, info.path, iterpool);
+        schedule_index_update(ub->index_updates, info.path, iterpool);
 
       APR_ARRAY_PUSH(ub->infos, struct unlock_info_t) = info;
     }
 
-  rev_0_path = svn_fs_fs__path_rev_absolute(ub->fs, 0, pool);
-
-  /* Unlike the lock_body(), we need to delete locks *before* we start to
-     update indices. */
-
-  for (i = 0; i < ub->infos->nelts; ++i)
-    {
-      struct unlock_info_t *info = &APR_ARRAY_IDX(ub->infos, i,
-                                                  struct unlock_info_t);
-
-      svn_pool_clear(iterpool);
-
-      if (! info->fs_err)
-        {
-          SVN_ERR(delete_lock(ub->fs->path, info->path, iterpool));
-          info->done = TRUE;
-        }
-    }
-
-  for (hi = apr_hash_first(pool, indices_updates); hi; hi = apr_hash_next(hi))
-    {
-      const char *path = apr_hash_this_key(hi);
-      apr_array_header_t *children = apr_hash_this_val(hi);
+  svn_pool_destroy(iterpool);
 
-      svn_pool_clear(iterpool);
-      SVN_ERR(delete_from_digest(ub->fs->path, children, path, rev_0_path,
-                                 iterpool));
-    }
+  if (ub->use_index)
+    SVN_ERR(svn_fs_fs__with_lock_index_txn(ub->fs, delete_locks, ub, pool));
+  else
+    SVN_ERR(delete_locks(ub, pool));
 
-  svn_pool_destroy(iterpool);
   return SVN_NO_ERROR;
 }
 
@@ -1348,7 +1593,6 @@ svn_fs_fs__get_locks(svn_fs_t *fs,
                      void *get_locks_baton,
                      apr_pool_t *pool)
 {
-  const char *digest_path;
   get_locks_filter_baton_t glfb;
 
   SVN_ERR(svn_fs__check_fs(fs, TRUE));
@@ -1359,9 +1603,8 @@ svn_fs_fs__get_locks(svn_fs_t *fs,
   glfb.get_locks_func = get_locks_func;
   glfb.get_locks_baton = get_locks_baton;
 
-  /* Get the top digest path in our tree of interest, and then walk it. */
-  SVN_ERR(digest_path_from_path(&digest_path, fs->path, path, pool));
-  SVN_ERR(walk_locks(fs, digest_path, get_locks_filter_func, &glfb,
-                     FALSE, pool));
+  /* Walk our tree of interest. */
+  SVN_ERR(walk_path_locks(fs, path, get_locks_filter_func, &glfb,
+                          FALSE, pool));
   return SVN_NO_ERROR;
 }
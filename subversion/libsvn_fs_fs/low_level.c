@@ -41,6 +41,7 @@
 #define HEADER_TEXT        "text"
 #define HEADER_CPATH       "cpath"
 #define HEADER_PRED        "pred"
+#define HEADER_SKIP        "skip"
 #define HEADER_COPYFROM    "copyfrom"
 #define HEADER_COPYROOT    "copyroot"
 #define HEADER_FRESHTXNRT  "is-fresh-txn-root"
@@ -291,33 +292,47 @@ svn_fs_fs__unparse_footer(apr_off_t l2p_offset,
                                                        scratch_pool));
 }
 
-/* Read the next entry in the changes record from file FILE and store
-   the resulting change in *CHANGE_P.  If there is no next record,
-   store NULL there.  Perform all allocations from POOL. */
-static svn_error_t *
-read_change(change_t **change_p,
-            svn_stream_t *stream,
-            apr_pool_t *result_pool,
-            apr_pool_t *scratch_pool)
+/* Return the next line of the buffer that starts at *DATA and ends at END.
+   Terminate the line in place, store its length in *LEN and advance *DATA
+   to the start of the following line.  Like svn_stream_readline(), treat
+   an unterminated last line as the end of the data and return NULL. */
+static char *
+next_line(apr_size_t *len,
+          char **data,
+          const char *end)
 {
-  svn_stringbuf_t *line;
-  svn_boolean_t eof = TRUE;
-  change_t *change;
-  char *str, *last_str, *kind_str;
-  svn_fs_path_change2_t *info;
+  char *line = *data;
+  char *eol;
 
-  /* Default return value. */
-  *change_p = NULL;
+  if (line >= end)
+    return NULL;
 
-  SVN_ERR(svn_stream_readline(stream, &line, "\n", &eof, scratch_pool));
+  eol = memchr(line, '\n', end - line);
+  if (eol == NULL)
+    return NULL;
 
-  /* Check for a blank line. */
-  if (eof || (line->len == 0))
-    return SVN_NO_ERROR;
+  *eol = '\0';
+  *len = eol - line;
+  *data = eol + 1;
+
+  return line;
+}
+
+/* Parse the changes LINE and the COPYFROM_LINE following it and store
+   the result in CHANGE.  COPYFROM_LINE may be NULL.  Both lines will be
+   modified and CHANGE points into them for the paths.  Allocate the ids
+   in RESULT_POOL. */
+static svn_error_t *
+parse_change(change_t *change,
+             char *line,
+             char *copyfrom_line,
+             apr_pool_t *result_pool)
+{
+  char *str, *last_str, *kind_str;
+  svn_fs_path_change2_t *info;
 
-  change = apr_pcalloc(result_pool, sizeof(*change));
   info = &change->info;
-  last_str = line->data;
+  last_str = line;
 
   /* Get the node-id of the change. */
   str = svn_cstring_tokenize(" ", &last_str);
@@ -452,28 +467,67 @@ read_change(change_t **change_p,
                             _("Invalid path in changes line"));
 
   change->path.len = strlen(last_str);
-  change->path.data = apr_pstrdup(result_pool, last_str);
+  change->path.data = last_str;
 
-  /* Read the next line, the copyfrom line. */
-  SVN_ERR(svn_stream_readline(stream, &line, "\n", &eof, scratch_pool));
+  /* Parse the copyfrom line. */
   info->copyfrom_known = TRUE;
-  if (eof || line->len == 0)
+  if (copyfrom_line == NULL || *copyfrom_line == '\0')
     {
       info->copyfrom_rev = SVN_INVALID_REVNUM;
       info->copyfrom_path = NULL;
     }
   else
     {
-      last_str = line->data;
+      last_str = copyfrom_line;
       SVN_ERR(parse_revnum(&info->copyfrom_rev, (const char **)&last_str));
 
       if (!svn_fspath__is_canonical(last_str))
         return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
                                 _("Invalid copy-from path in changes line"));
 
-      info->copyfrom_path = apr_pstrdup(result_pool, last_str);
+      info->copyfrom_path = last_str;
     }
 
+  return SVN_NO_ERROR;
+}
+
+/* Read the next entry in the changes record from file FILE and store
+   the resulting change in *CHANGE_P.  If there is no next record,
+   store NULL there.  Perform all allocations from POOL. */
+static svn_error_t *
+read_change(change_t **change_p,
+            svn_stream_t *stream,
+            apr_pool_t *result_pool,
+            apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *line, *copyfrom_line;
+  svn_boolean_t eof = TRUE;
+  change_t *change;
+
+  /* Default return value. */
+  *change_p = NULL;
+
+  SVN_ERR(svn_stream_readline(stream, &line, "\n", &eof, scratch_pool));
+
+  /* Check for a blank line. */
+  if (eof || (line->len == 0))
+    return SVN_NO_ERROR;
+
+  /* Read the next line, the copyfrom line. */
+  SVN_ERR(svn_stream_readline(stream, &copyfrom_line, "\n", &eof,
+                              scratch_pool));
+
+  change = apr_pcalloc(result_pool, sizeof(*change));
+  SVN_ERR(parse_change(change, line->data, eof ? NULL : copyfrom_line->data,
+                       result_pool));
+
+  /* The lines only live in SCRATCH_POOL. */
+  change->path.data = apr_pstrmemdup(result_pool, change->path.data,
+                                     change->path.len);
+  if (change->info.copyfrom_path)
+    change->info.copyfrom_path = apr_pstrdup(result_pool,
+                                             change->info.copyfrom_path);
+
   *change_p = change;
 
   return SVN_NO_ERROR;
@@ -514,6 +568,51 @@ svn_fs_fs__read_changes(apr_array_header_t **changes,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__parse_changes(apr_array_header_t **changes,
+                         svn_stringbuf_t *text,
+                         int max_count,
+                         apr_pool_t *result_pool)
+{
+  char *data = text->data;
+  const char *end = text->data + text->len;
+  change_t *change_block = NULL;
+  int block_left = 0;
+
+  /* Same as in svn_fs_fs__read_changes. */
+  *changes = apr_array_make(result_pool, 63, sizeof(change_t *));
+
+  for (; max_count > 0; --max_count)
+    {
+      apr_size_t len;
+      char *line, *copyfrom_line;
+      change_t *change;
+
+      /* Stop at the blank line terminating the list. */
+      line = next_line(&len, &data, end);
+      if (line == NULL || len == 0)
+        break;
+
+      copyfrom_line = next_line(&len, &data, end);
+
+      /* Allocate the change structs in bulk rather than one by one. */
+      if (block_left == 0)
+        {
+          block_left = MIN(max_count, 64);
+          change_block = apr_pcalloc(result_pool,
+                                     block_left * sizeof(*change_block));
+        }
+
+      change = change_block++;
+      --block_left;
+
+      SVN_ERR(parse_change(change, line, copyfrom_line, result_pool));
+      APR_ARRAY_PUSH(*changes, change_t*) = change;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__read_changes_incrementally(svn_stream_t *stream,
                                       svn_fs_fs__change_receiver_t
@@ -677,23 +776,128 @@ svn_fs_fs__write_changes(svn_stream_t *stream,
   return SVN_NO_ERROR;
 }
 
+/* The values of all node-revision headers that we know of.  The members
+   point to the values as found in the header block and are NULL for
+   headers that are not present. */
+typedef struct noderev_headers_t
+{
+  char *id;
+  char *type;
+  char *count;
+  char *props;
+  char *text;
+  char *cpath;
+  char *pred;
+  char *skip;
+  char *copyfrom;
+  char *copyroot;
+  char *fresh_txn_root;
+  char *minfo_here;
+  char *minfo_cnt;
+} noderev_headers_t;
+
+/* Parse the header LINE of length LEN in place and store its value in
+   the respective member of HEADERS.  Unknown headers will be ignored. */
+static svn_error_t *
+parse_header_line(noderev_headers_t *headers,
+                  char *line,
+                  apr_size_t len)
+{
+  char *name, *value;
+  apr_size_t i = 0;
+
+  while (line[i] != ':')
+    {
+      if (line[i] == '\0')
+        return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                                 _("Found malformed header '%s' in "
+                                   "revision file"),
+                                 line);
+      i++;
+    }
+
+  /* Check if we have enough data to parse. */
+  if (i + 2 > len)
+    return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                             _("Found malformed header '%s' in "
+                               "revision file"),
+                             line);
+
+  /* Create a 'name' string and point to it. */
+  line[i] = '\0';
+  name = line;
+
+  /* Skip over the NULL byte and the space following it. */
+  value = line + i + 2;
+
+  /* Dispatch on the first character to keep the number of string
+     comparisons per line low. */
+  switch (*name)
+    {
+      case 'c':
+        if (strcmp(name, HEADER_CPATH) == 0)
+          headers->cpath = value;
+        else if (strcmp(name, HEADER_COUNT) == 0)
+          headers->count = value;
+        else if (strcmp(name, HEADER_COPYROOT) == 0)
+          headers->copyroot = value;
+        else if (strcmp(name, HEADER_COPYFROM) == 0)
+          headers->copyfrom = value;
+        break;
+
+      case 'i':
+        if (strcmp(name, HEADER_ID) == 0)
+          headers->id = value;
+        else if (strcmp(name, HEADER_FRESHTXNRT) == 0)
+          headers->fresh_txn_root = value;
+        break;
+
+      case 'm':
+        if (strcmp(name, HEADER_MINFO_CNT) == 0)
+          headers->minfo_cnt = value;
+        else if (strcmp(name, HEADER_MINFO_HERE) == 0)
+          headers->minfo_here = value;
+        break;
+
+      case 'p':
+        if (strcmp(name, HEADER_PRED) == 0)
+          headers->pred = value;
+        else if (strcmp(name, HEADER_PROPS) == 0)
+          headers->props = value;
+        break;
+
+      case 's':
+        if (strcmp(name, HEADER_SKIP) == 0)
+          headers->skip = value;
+        break;
+
+      case 't':
+        if (strcmp(name, HEADER_TYPE) == 0)
+          headers->type = value;
+        else if (strcmp(name, HEADER_TEXT) == 0)
+          headers->text = value;
+        break;
+
+      default:
+        break;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Given a revision file FILE that has been pre-positioned at the
    beginning of a Node-Rev header block, read in that header block and
-   store it in the apr_hash_t HEADERS.  All allocations will be from
-   RESULT_POOL. */
+   store it in HEADERS.  All allocations will be from RESULT_POOL. */
 static svn_error_t *
-read_header_block(apr_hash_t **headers,
+read_header_block(noderev_headers_t *headers,
                   svn_stream_t *stream,
                   apr_pool_t *result_pool)
 {
-  *headers = svn_hash__make(result_pool);
+  memset(headers, 0, sizeof(*headers));
 
   while (1)
     {
       svn_stringbuf_t *header_str;
-      const char *name, *value;
-      apr_size_t i = 0;
-      apr_size_t name_len;
       svn_boolean_t eof;
 
       SVN_ERR(svn_stream_readline(stream, &header_str, "\n", &eof,
@@ -702,40 +906,9 @@ read_header_block(apr_hash_t **headers,
       if (eof || header_str->len == 0)
         break; /* end of header block */
 
-      while (header_str->data[i] != ':')
-        {
-          if (header_str->data[i] == '\0')
-            return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
-                                     _("Found malformed header '%s' in "
-                                       "revision file"),
-                                     header_str->data);
-          i++;
-        }
-
-      /* Create a 'name' string and point to it. */
-      header_str->data[i] = '\0';
-      name = header_str->data;
-      name_len = i;
-
-      /* Check if we have enough data to parse. */
-      if (i + 2 > header_str->len)
-        {
-          /* Restore the original line for the error. */
-          header_str->data[i] = ':';
-          return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
-                                   _("Found malformed header '%s' in "
-                                     "revision file"),
-                                   header_str->data);
-        }
-
-      /* Skip over the NULL byte and the space following it. */
-      i += 2;
-
-      value = header_str->data + i;
-
       /* header_str is safely in our pool, so we can use bits of it as
          key and value. */
-      apr_hash_set(*headers, name, name_len, value);
+      SVN_ERR(parse_header_line(headers, header_str->data, header_str->len));
     }
 
   return SVN_NO_ERROR;
@@ -888,35 +1061,34 @@ read_rep_offsets(representation_t **rep_p,
   return SVN_NO_ERROR;
 }
 
-svn_error_t *
-svn_fs_fs__read_noderev(node_revision_t **noderev_p,
-                        svn_stream_t *stream,
-                        apr_pool_t *result_pool,
-                        apr_pool_t *scratch_pool)
+/* Construct the node-revision described by HEADERS and return it in
+   *NODEREV_P.  The paths in *NODEREV_P will point into the header values.
+   Allocate everything else in RESULT_POOL and use SCRATCH_POOL for
+   temporaries. */
+static svn_error_t *
+noderev_from_headers(node_revision_t **noderev_p,
+                     noderev_headers_t *headers,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
 {
-  apr_hash_t *headers;
   node_revision_t *noderev;
   char *value;
   const char *noderev_id;
 
-  SVN_ERR(read_header_block(&headers, stream, scratch_pool));
-
   noderev = apr_pcalloc(result_pool, sizeof(*noderev));
 
   /* Read the node-rev id. */
-  value = svn_hash_gets(headers, HEADER_ID);
+  value = headers->id;
   if (value == NULL)
       /* ### More information: filename/offset coordinates */
       return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
                               _("Missing id field in node-rev"));
 
-  SVN_ERR(svn_stream_close(stream));
-
   SVN_ERR(svn_fs_fs__id_parse(&noderev->id, value, result_pool));
   noderev_id = value; /* for error messages later */
 
   /* Read the type. */
-  value = svn_hash_gets(headers, HEADER_TYPE);
+  value = headers->type;
 
   if ((value == NULL) ||
       (   strcmp(value, SVN_FS_FS__KIND_FILE)
@@ -931,14 +1103,14 @@ svn_fs_fs__read_noderev(node_revision_t **noderev_p,
                 : svn_node_dir;
 
   /* Read the 'count' field. */
-  value = svn_hash_gets(headers, HEADER_COUNT);
+  value = headers->count;
   if (value)
     SVN_ERR(svn_cstring_atoi(&noderev->predecessor_count, value));
   else
     noderev->predecessor_count = 0;
 
   /* Get the properties location. */
-  value = svn_hash_gets(headers, HEADER_PROPS);
+  value = headers->props;
   if (value)
     {
       SVN_ERR(read_rep_offsets(&noderev->prop_rep, value,
@@ -946,7 +1118,7 @@ svn_fs_fs__read_noderev(node_revision_t **noderev_p,
     }
 
   /* Get the data location. */
-  value = svn_hash_gets(headers, HEADER_TEXT);
+  value = headers->text;
   if (value)
     {
       SVN_ERR(read_rep_offsets(&noderev->data_rep, value,
@@ -954,7 +1126,7 @@ svn_fs_fs__read_noderev(node_revision_t **noderev_p,
     }
 
   /* Get the created path. */
-  value = svn_hash_gets(headers, HEADER_CPATH);
+  value = headers->cpath;
   if (value == NULL)
     {
       return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
@@ -968,20 +1140,25 @@ svn_fs_fs__read_noderev(node_revision_t **noderev_p,
                             _("Non-canonical cpath field in node-rev '%s'"),
                             noderev_id);
 
-      noderev->created_path = apr_pstrdup(result_pool, value);
+      noderev->created_path = value;
     }
 
   /* Get the predecessor ID. */
-  value = svn_hash_gets(headers, HEADER_PRED);
+  value = headers->pred;
   if (value)
     SVN_ERR(svn_fs_fs__id_parse(&noderev->predecessor_id, value,
                                 result_pool));
 
+  /* Get the skip predecessor ID. */
+  value = headers->skip;
+  if (value)
+    SVN_ERR(svn_fs_fs__id_parse(&noderev->skip_id, value, result_pool));
+
   /* Get the copyroot. */
-  value = svn_hash_gets(headers, HEADER_COPYROOT);
+  value = headers->copyroot;
   if (value == NULL)
     {
-      noderev->copyroot_path = apr_pstrdup(result_pool, noderev->created_path);
+      noderev->copyroot_path = noderev->created_path;
       noderev->copyroot_rev = svn_fs_fs__id_rev(noderev->id);
     }
   else
@@ -992,11 +1169,11 @@ svn_fs_fs__read_noderev(node_revision_t **noderev_p,
         return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
                                  _("Malformed copyroot line in node-rev '%s'"),
                                  noderev_id);
-      noderev->copyroot_path = apr_pstrdup(result_pool, value);
+      noderev->copyroot_path = value;
     }
 
   /* Get the copyfrom. */
-  value = svn_hash_gets(headers, HEADER_COPYFROM);
+  value = headers->copyfrom;
   if (value == NULL)
     {
       noderev->copyfrom_path = NULL;
@@ -1010,22 +1187,22 @@ svn_fs_fs__read_noderev(node_revision_t **noderev_p,
         return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
                                  _("Malformed copyfrom line in node-rev '%s'"),
                                  noderev_id);
-      noderev->copyfrom_path = apr_pstrdup(result_pool, value);
+      noderev->copyfrom_path = value;
     }
 
   /* Get whether this is a fresh txn root. */
-  value = svn_hash_gets(headers, HEADER_FRESHTXNRT);
+  value = headers->fresh_txn_root;
   noderev->is_fresh_txn_root = (value != NULL);
 
   /* Get the mergeinfo count. */
-  value = svn_hash_gets(headers, HEADER_MINFO_CNT);
+  value = headers->minfo_cnt;
   if (value)
     SVN_ERR(svn_cstring_atoi64(&noderev->mergeinfo_count, value));
   else
     noderev->mergeinfo_count = 0;
 
   /* Get whether *this* node has mergeinfo. */
-  value = svn_hash_gets(headers, HEADER_MINFO_HERE);
+  value = headers->minfo_here;
   noderev->has_mergeinfo = (value != NULL);
 
   *noderev_p = noderev;
@@ -1033,6 +1210,53 @@ svn_fs_fs__read_noderev(node_revision_t **noderev_p,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__read_noderev(node_revision_t **noderev_p,
+                        svn_stream_t *stream,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool)
+{
+  noderev_headers_t headers;
+  node_revision_t *noderev;
+
+  SVN_ERR(read_header_block(&headers, stream, scratch_pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  SVN_ERR(noderev_from_headers(&noderev, &headers, result_pool,
+                               scratch_pool));
+
+  /* The header values only live in SCRATCH_POOL. */
+  noderev->created_path = apr_pstrdup(result_pool, noderev->created_path);
+  noderev->copyroot_path = apr_pstrdup(result_pool, noderev->copyroot_path);
+  if (noderev->copyfrom_path)
+    noderev->copyfrom_path = apr_pstrdup(result_pool,
+                                         noderev->copyfrom_path);
+
+  *noderev_p = noderev;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__parse_noderev(node_revision_t **noderev_p,
+                         svn_stringbuf_t *text,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  noderev_headers_t headers = { 0 };
+  char *data = text->data;
+  const char *end = text->data + text->len;
+  char *line;
+  apr_size_t len;
+
+  /* Scan the header block up to the first empty line. */
+  while ((line = next_line(&len, &data, end)) && len > 0)
+    SVN_ERR(parse_header_line(&headers, line, len));
+
+  return svn_error_trace(noderev_from_headers(noderev_p, &headers,
+                                              result_pool, scratch_pool));
+}
+
 /* Return a textual representation of the DIGEST of given KIND.
  * If IS_NULL is TRUE, no digest is available.
  * Allocate the result in RESULT_POOL.
@@ -1112,6 +1336,11 @@ svn_fs_fs__write_noderev(svn_stream_t *outfile,
   SVN_ERR(svn_stream_printf(outfile, scratch_pool, HEADER_COUNT ": %d\n",
                             noderev->predecessor_count));
 
+  if (noderev->skip_id && format >= SVN_FS_FS__MIN_SKIP_PREDECESSOR_FORMAT)
+    SVN_ERR(svn_stream_printf(outfile, scratch_pool, HEADER_SKIP ": %s\n",
+                              svn_fs_fs__id_unparse(noderev->skip_id,
+                                                    scratch_pool)->data));
+
   if (noderev->data_rep)
     SVN_ERR(svn_stream_printf(outfile, scratch_pool, HEADER_TEXT ": %s\n",
                               svn_fs_fs__unparse_representation
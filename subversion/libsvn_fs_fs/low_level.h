@@ -107,6 +107,17 @@ svn_fs_fs__read_changes(apr_array_header_t **changes,
                         apr_pool_t *result_pool,
                         apr_pool_t *scratch_pool);
 
+/* Parse up to MAX_COUNT of the changes from the changed paths list in
+   TEXT and store them in *CHANGES, allocated in RESULT_POOL.  This is
+   the in-memory equivalent of svn_fs_fs__read_changes().  TEXT will be
+   modified and the paths in *CHANGES point into it, i.e. TEXT must
+   remain valid for as long as RESULT_POOL. */
+svn_error_t *
+svn_fs_fs__parse_changes(apr_array_header_t **changes,
+                         svn_stringbuf_t *text,
+                         int max_count,
+                         apr_pool_t *result_pool);
+
 /* Callback function used by svn_fs_fs__read_changes_incrementally(),
  * asking the receiver to process to process CHANGE using BATON.  CHANGE
  * and SCRATCH_POOL will not be valid beyond the current callback invocation.
@@ -147,6 +158,18 @@ svn_fs_fs__read_noderev(node_revision_t **noderev,
                         apr_pool_t *result_pool,
                         apr_pool_t *scratch_pool);
 
+/* Parse the node-revision header block at the start of TEXT.  Set
+   *NODEREV to the new structure, allocated in RESULT_POOL.  This is the
+   in-memory equivalent of svn_fs_fs__read_noderev().  TEXT will be
+   modified and the paths in *NODEREV point into it, i.e. TEXT must
+   remain valid for as long as RESULT_POOL.  Use SCRATCH_POOL for
+   temporaries. */
+svn_error_t *
+svn_fs_fs__parse_noderev(node_revision_t **noderev,
+                         svn_stringbuf_t *text,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool);
+
 /* Write the node-revision NODEREV into the stream OUTFILE, compatible with
    filesystem format FORMAT.  Only write mergeinfo-related metadata if
    INCLUDE_MERGEINFO is true.  Temporary allocations are from SCRATCH_POOL. */
@@ -0,0 +1,52 @@
+/* mergeinfo-index-db.sql -- schema of the mergeinfo index
+ *   This is intended for use with SQLite 3
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+-- STMT_CREATE_SCHEMA
+/* A table mapping directory node-revision IDs to the mergeinfo of all
+   their descendants.  Node-revisions are immutable, so rows never need
+   to be updated once written.  CATALOG is a hash dump mapping relative
+   paths to the respective node's (canonicalized) mergeinfo. */
+CREATE TABLE mergeinfo_index (
+  node_id TEXT NOT NULL PRIMARY KEY,
+  revision INTEGER NOT NULL,
+  catalog BLOB NOT NULL
+  );
+
+CREATE INDEX i_mergeinfo_index_revision ON mergeinfo_index (revision);
+
+PRAGMA USER_VERSION = 1;
+
+
+-- STMT_GET_CATALOG
+SELECT catalog
+FROM mergeinfo_index
+WHERE node_id = ?1
+
+/* Concurrent readers may index the same node at the same time. */
+-- STMT_SET_CATALOG
+INSERT OR IGNORE INTO mergeinfo_index (node_id, revision, catalog)
+VALUES (?1, ?2, ?3)
+
+-- STMT_DEL_CATALOGS_YOUNGER_THAN_REV
+DELETE FROM mergeinfo_index
+WHERE revision > ?1
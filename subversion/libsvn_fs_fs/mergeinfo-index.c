@@ -0,0 +1,226 @@
+/* mergeinfo-index.c --- the FSFS mergeinfo index
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_pools.h"
+#include "svn_hash.h"
+#include "svn_dirent_uri.h"
+
+#include "svn_private_config.h"
+
+#include "fs_fs.h"
+#include "fs.h"
+#include "mergeinfo-index.h"
+#include "util.h"
+
+#include "private/svn_sqlite.h"
+#include "private/svn_subr_private.h"
+#include "../libsvn_fs/fs-loader.h"
+
+#include "mergeinfo-index-db.h"
+
+/* A few magic values */
+#define MERGEINFO_INDEX_SCHEMA_FORMAT   1
+
+MERGEINFO_INDEX_DB_SQL_DECLARE_STATEMENTS(statements);
+
+
+
+/** Helper functions. **/
+static APR_INLINE const char *
+path_mergeinfo_index_db(const char *fs_path,
+                        apr_pool_t *result_pool)
+{
+  return svn_dirent_join(fs_path, MERGEINFO_INDEX_DB_NAME, result_pool);
+}
+
+
+/** Library-private API's. **/
+
+/* Body of svn_fs_fs__open_mergeinfo_index().
+   Implements svn_atomic__init_once().init_func.
+ */
+static svn_error_t *
+open_mergeinfo_index(void *baton,
+                     apr_pool_t *pool)
+{
+  svn_fs_t *fs = baton;
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__db_t *sdb;
+  const char *db_path;
+  int version;
+
+  /* Open (or create) the sqlite database.  It will be automatically
+     closed when fs->pool is destroyed. */
+  db_path = path_mergeinfo_index_db(fs->path, pool);
+#ifndef WIN32
+  {
+    /* Like the rep-cache, extend the permissions that apply to the
+       repository as a whole. */
+    svn_boolean_t exists;
+
+    SVN_ERR(svn_fs_fs__exists_mergeinfo_index(&exists, fs, pool));
+    if (!exists)
+      {
+        const char *current = svn_fs_fs__path_current(fs, pool);
+        svn_error_t *err = svn_io_file_create_empty(db_path, pool);
+
+        if (err && !APR_STATUS_IS_EEXIST(err->apr_err))
+          /* A real error. */
+          return svn_error_trace(err);
+        else if (err)
+          /* Some other thread/process created the file. */
+          svn_error_clear(err);
+        else
+          /* We created the file. */
+          SVN_ERR(svn_io_copy_perms(current, db_path, pool));
+      }
+  }
+#endif
+  SVN_ERR(svn_sqlite__open(&sdb, db_path,
+                           svn_sqlite__mode_rwcreate, statements,
+                           0, NULL, 0,
+                           fs->pool, pool));
+
+  SVN_SQLITE__ERR_CLOSE(svn_sqlite__read_schema_version(&version, sdb, pool),
+                        sdb);
+  if (version < MERGEINFO_INDEX_SCHEMA_FORMAT)
+    {
+      /* Must be 0 -- an uninitialized (no schema) database. Create
+         the schema. Results in schema version of 1.  */
+      SVN_SQLITE__ERR_CLOSE(svn_sqlite__exec_statements(sdb,
+                                                        STMT_CREATE_SCHEMA),
+                            sdb);
+    }
+
+  /* This is used as a flag that the database is available so don't
+     set it earlier. */
+  ffd->mergeinfo_index_db = sdb;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__open_mergeinfo_index(svn_fs_t *fs,
+                                apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_error_t *err = svn_atomic__init_once(&ffd->mergeinfo_index_db_opened,
+                                           open_mergeinfo_index, fs, pool);
+  return svn_error_quick_wrap(err, _("Couldn't open mergeinfo index"));
+}
+
+svn_error_t *
+svn_fs_fs__exists_mergeinfo_index(svn_boolean_t *exists,
+                                  svn_fs_t *fs,
+                                  apr_pool_t *pool)
+{
+  svn_node_kind_t kind;
+
+  SVN_ERR(svn_io_check_path(path_mergeinfo_index_db(fs->path, pool),
+                            &kind, pool));
+
+  *exists = (kind != svn_node_none);
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__get_indexed_mergeinfo(apr_hash_t **catalog,
+                                 svn_fs_t *fs,
+                                 const char *node_id,
+                                 apr_pool_t *result_pool,
+                                 apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  *catalog = NULL;
+  if (! ffd->mergeinfo_index_db)
+    SVN_ERR(svn_fs_fs__open_mergeinfo_index(fs, scratch_pool));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->mergeinfo_index_db,
+                                    STMT_GET_CATALOG));
+  SVN_ERR(svn_sqlite__bindf(stmt, "s", node_id));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  if (have_row)
+    {
+      apr_size_t len;
+      const void *data = svn_sqlite__column_blob(stmt, 0, &len,
+                                                 scratch_pool);
+      svn_stream_t *stream
+        = svn_stream_from_string(svn_string_ncreate(data, len, scratch_pool),
+                                 scratch_pool);
+
+      *catalog = svn_hash__make(result_pool);
+      err = svn_hash_read2(*catalog, stream, SVN_HASH_TERMINATOR,
+                           result_pool);
+    }
+
+  return svn_error_trace(svn_error_compose_create(err,
+                                                  svn_sqlite__reset(stmt)));
+}
+
+svn_error_t *
+svn_fs_fs__set_indexed_mergeinfo(svn_fs_t *fs,
+                                 const char *node_id,
+                                 svn_revnum_t revision,
+                                 apr_hash_t *catalog,
+                                 apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+  svn_stringbuf_t *data = svn_stringbuf_create_empty(scratch_pool);
+
+  if (! ffd->mergeinfo_index_db)
+    SVN_ERR(svn_fs_fs__open_mergeinfo_index(fs, scratch_pool));
+
+  SVN_ERR(svn_hash_write2(catalog,
+                          svn_stream_from_stringbuf(data, scratch_pool),
+                          SVN_HASH_TERMINATOR, scratch_pool));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->mergeinfo_index_db,
+                                    STMT_SET_CATALOG));
+  SVN_ERR(svn_sqlite__bindf(stmt, "srb", node_id, revision,
+                            data->data, data->len));
+
+  return svn_error_trace(svn_sqlite__insert(NULL, stmt));
+}
+
+svn_error_t *
+svn_fs_fs__del_indexed_mergeinfo(svn_fs_t *fs,
+                                 svn_revnum_t youngest,
+                                 apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+
+  if (! ffd->mergeinfo_index_db)
+    SVN_ERR(svn_fs_fs__open_mergeinfo_index(fs, pool));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->mergeinfo_index_db,
+                                    STMT_DEL_CATALOGS_YOUNGER_THAN_REV));
+  SVN_ERR(svn_sqlite__bindf(stmt, "r", youngest));
+  SVN_ERR(svn_sqlite__step_done(stmt));
+
+  return SVN_NO_ERROR;
+}
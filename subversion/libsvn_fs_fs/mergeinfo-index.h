@@ -0,0 +1,90 @@
+/* mergeinfo-index.h : interface to the FSFS mergeinfo index
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_FS_FS_MERGEINFO_INDEX_H
+#define SVN_LIBSVN_FS_FS_MERGEINFO_INDEX_H
+
+#include "svn_error.h"
+
+#include "fs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+
+#define MERGEINFO_INDEX_DB_NAME  "mergeinfo-index.db"
+
+/* The mergeinfo index is an optional SQLite database that maps the IDs
+ * of directory node-revisions with mergeinfo in their sub-tree to the
+ * mergeinfo of all those descendants.  Because node-revisions are
+ * immutable, entries never become outdated.  They get added by the first
+ * query that has to crawl the respective sub-tree.
+ */
+
+/* Open and create, if needed, the mergeinfo index database associated
+   with FS.  Use POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__open_mergeinfo_index(svn_fs_t *fs,
+                                apr_pool_t *pool);
+
+/* Set *EXISTS to TRUE iff the mergeinfo index DB file exists. */
+svn_error_t *
+svn_fs_fs__exists_mergeinfo_index(svn_boolean_t *exists,
+                                  svn_fs_t *fs,
+                                  apr_pool_t *pool);
+
+/* Set *CATALOG to the descendants' mergeinfo stored for the directory
+   node-revision with the unparsed ID NODE_ID in FS.  *CATALOG maps
+   relative paths to their svn_string_t * mergeinfo.  Set it to NULL if
+   the node has not been indexed, yet.  Allocate the result in
+   RESULT_POOL and use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__get_indexed_mergeinfo(apr_hash_t **catalog,
+                                 svn_fs_t *fs,
+                                 const char *node_id,
+                                 apr_pool_t *result_pool,
+                                 apr_pool_t *scratch_pool);
+
+/* Store CATALOG, in the format described for
+   svn_fs_fs__get_indexed_mergeinfo, for the directory node-revision with
+   the unparsed ID NODE_ID from REVISION in FS.  Do nothing if an
+   entry already exists.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__set_indexed_mergeinfo(svn_fs_t *fs,
+                                 const char *node_id,
+                                 svn_revnum_t revision,
+                                 apr_hash_t *catalog,
+                                 apr_pool_t *scratch_pool);
+
+/* Delete from the index all entries for node-revisions younger than
+   YOUNGEST. */
+svn_error_t *
+svn_fs_fs__del_indexed_mergeinfo(svn_fs_t *fs,
+                                 svn_revnum_t youngest,
+                                 apr_pool_t *pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_FS_FS_MERGEINFO_INDEX_H */
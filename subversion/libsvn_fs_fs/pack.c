@@ -20,8 +20,12 @@
  * ====================================================================
  */
 #include <assert.h>
+#include <stdlib.h>
 #include <string.h>
 
+#include <apr_thread_proc.h>
+#include <apr_thread_cond.h>
+
 #include "svn_pools.h"
 #include "svn_dirent_uri.h"
 #include "svn_sorts.h"
@@ -30,9 +34,12 @@
 #include "private/svn_subr_private.h"
 #include "private/svn_string_private.h"
 #include "private/svn_io_private.h"
+#include "private/svn_atomic.h"
+#include "private/svn_mutex.h"
 
 #include "fs_fs.h"
 #include "pack.h"
+#include "changed_paths.h"
 #include "util.h"
 #include "id.h"
 #include "index.h"
@@ -78,6 +85,12 @@
  *   with special treatment of "trunk" and "branches"
  * - same for file representations
  *
+ * If an access profile has been configured, i.e. a list of items in the
+ * order they have been read by a typical workload, the items it lists
+ * will be placed in front of the others in each bucket, in the order of
+ * their first access.  This way, items that are read together end up in
+ * the same blocks.
+ *
  * Step 4 copies the items from the temporary buckets into the final
  * pack file and writes the temporary index files.
  *
@@ -119,6 +132,10 @@ typedef struct path_order_t
 
   /* item ID of the representation containing the new data. May be (0, 0). */
   svn_fs_fs__id_part_t rep_id;
+
+  /* position of the first access to the noderev or rep in the access
+   * profile.  0 if neither of them is listed. */
+  int access_rank;
 } path_order_t;
 
 /* Represents a reference from item FROM to item TO.  FROM may be a noderev
@@ -234,10 +251,125 @@ typedef struct pack_context_t
    * the next range of revisions is being processed */
   apr_pool_t *info_pool;
 
+  /* svn_fs_fs__id_part_t -> int *, the position of the first access to
+   * that item in the access profile, counting from 1.  Only contains the
+   * items of the current shard.  NULL if there is no access profile. */
+  apr_hash_t *access_ranks;
+
   /* ensure that all filesystem changes are written to disk. */
   svn_boolean_t flush_to_disk;
 } pack_context_t;
 
+/* Return the hash key for item ID in CONTEXT->ACCESS_RANKS.  Zero any
+ * padding such that equal IDs give equal keys.  Allocate it in POOL. */
+static svn_fs_fs__id_part_t *
+access_rank_key(const svn_fs_fs__id_part_t *id,
+                apr_pool_t *pool)
+{
+  svn_fs_fs__id_part_t *key = apr_pcalloc(pool, sizeof(*key));
+  key->revision = id->revision;
+  key->number = id->number;
+
+  return key;
+}
+
+/* Read the access profile at PATH and store the access ranks of all
+ * items of the shard in CONTEXT in CONTEXT->ACCESS_RANKS.  Allocate them
+ * in POOL.
+ *
+ * The profile contains one "REVISION ITEM_INDEX" pair per line, listing
+ * the items in the order they have been read.  Empty lines and lines
+ * starting with '#' are being ignored.
+ */
+static svn_error_t *
+read_access_profile(pack_context_t *context,
+                    const char *path,
+                    apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_stream_t *stream;
+  svn_boolean_t eof = FALSE;
+  int line_no = 0;
+  int rank = 0;
+
+  context->access_ranks = apr_hash_make(pool);
+  SVN_ERR(svn_stream_open_readonly(&stream, path, pool, iterpool));
+
+  while (!eof)
+    {
+      svn_stringbuf_t *line;
+      apr_array_header_t *fields;
+      svn_fs_fs__id_part_t id;
+      apr_int64_t revision;
+      apr_uint64_t number;
+      svn_fs_fs__id_part_t *key;
+      svn_error_t *err = SVN_NO_ERROR;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_stream_readline(stream, &line, "\n", &eof, iterpool));
+      ++line_no;
+
+      svn_stringbuf_strip_whitespace(line);
+      if (line->len == 0 || line->data[0] == '#')
+        continue;
+
+      fields = svn_cstring_split(line->data, " \t", TRUE, iterpool);
+      if (fields->nelts != 2)
+        err = svn_error_create(SVN_ERR_MALFORMED_FILE, NULL, NULL);
+      if (!err)
+        err = svn_cstring_atoi64(&revision,
+                                 APR_ARRAY_IDX(fields, 0, const char *));
+      if (!err)
+        err = svn_cstring_atoui64(&number,
+                                  APR_ARRAY_IDX(fields, 1, const char *));
+      if (err)
+        return svn_error_createf(SVN_ERR_MALFORMED_FILE, err,
+                                 _("Malformed line %d in access profile "
+                                   "'%s'"),
+                                 line_no,
+                                 svn_dirent_local_style(path, pool));
+
+      ++rank;
+      if (   revision < context->shard_rev
+          || revision >= context->shard_end_rev)
+        continue;
+
+      /* Only the first access to an item determines its position. */
+      id.revision = (svn_revnum_t)revision;
+      id.number = number;
+      key = access_rank_key(&id, iterpool);
+      if (apr_hash_get(context->access_ranks, key, sizeof(*key)))
+        continue;
+
+      key = apr_pmemdup(pool, key, sizeof(*key));
+      apr_hash_set(context->access_ranks, key, sizeof(*key),
+                   apr_pmemdup(pool, &rank, sizeof(rank)));
+    }
+
+  SVN_ERR(svn_stream_close(stream));
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the access rank of item ID in CONTEXT or 0, if the access
+ * profile does not list it.  Use POOL for temporary allocations. */
+static int
+get_access_rank(pack_context_t *context,
+                const svn_fs_fs__id_part_t *id,
+                apr_pool_t *pool)
+{
+  int *rank;
+
+  if (context->access_ranks == NULL)
+    return 0;
+
+  rank = apr_hash_get(context->access_ranks, access_rank_key(id, pool),
+                      sizeof(*id));
+
+  return rank ? *rank : 0;
+}
+
 /* Create and initialize a new pack context for packing shard SHARD_REV in
  * SHARD_DIR into PACK_FILE_DIR within filesystem FS.  Allocate it in POOL
  * and return the structure in *CONTEXT.
@@ -331,6 +463,9 @@ initialize_pack_context(pack_context_t *context,
 
   context->flush_to_disk = flush_to_disk;
 
+  if (ffd->pack_access_profile)
+    SVN_ERR(read_access_profile(context, ffd->pack_access_profile, pool));
+
   return SVN_NO_ERROR;
 }
 
@@ -770,6 +905,19 @@ copy_node_to_temp(pack_context_t *context,
   path_order->revision = svn_fs_fs__id_rev(noderev->id);
   path_order->predecessor_count = noderev->predecessor_count;
   path_order->noderev_id = *svn_fs_fs__id_rev_item(noderev->id);
+
+  /* Whichever of noderev and rep gets read first determines the
+   * position of the pair. */
+  path_order->access_rank = get_access_rank(context, &path_order->noderev_id,
+                                            pool);
+  if (path_order->rep_id.number)
+    {
+      int rep_rank = get_access_rank(context, &path_order->rep_id, pool);
+      if (rep_rank && (!path_order->access_rank
+                       || rep_rank < path_order->access_rank))
+        path_order->access_rank = rep_rank;
+    }
+
   APR_ARRAY_PUSH(context->path_order, path_order_t *) = path_order;
 
   return SVN_NO_ERROR;
@@ -824,6 +972,21 @@ compare_ref_to_item(const reference_t * const * lhs_p,
   return svn_fs_fs__id_part_compare(&(*lhs_p)->from, rhs_p);
 }
 
+/* implements compare_fn_t.  Sort ascendingly by ACCESS_RANK.
+ */
+static int
+compare_access_rank(const void *lhs_p,
+                    const void *rhs_p)
+{
+  const path_order_t *lhs = *(const path_order_t * const *)lhs_p;
+  const path_order_t *rhs = *(const path_order_t * const *)rhs_p;
+
+  if (lhs->access_rank == rhs->access_rank)
+    return 0;
+
+  return lhs->access_rank < rhs->access_rank ? -1 : 1;
+}
+
 /* Look for the least significant bit set in VALUE and return the smallest
  * number with the same property, i.e. the largest power of 2 that is a
  * factor in VALUE.  Edge case: roundness(0) := 0 . */
@@ -890,6 +1053,7 @@ sort_reps_range(pack_context_t *context,
 
   /* Re-order noderevs like this:
    *
+   * (0) Anything listed in the access profile, in order of first access.
    * (1) Most likely to be referenced by future pack files, in path order.
    * (2) highest revision rep per path + dependency chain
    * (3) Remaining reps in path, rev order
@@ -898,6 +1062,17 @@ sort_reps_range(pack_context_t *context,
    */
   dest = first;
 
+  /* (0) The access profile tells us exactly which items get read together.
+   * Their relative order in PATH_ORDER is path order.  So, sort them. */
+  for (i = first; i < last; ++i)
+    if (path_order[i]->access_rank)
+      {
+        temp[dest++] = path_order[i];
+        path_order[i] = NULL;
+      }
+
+  qsort(temp + first, dest - first, sizeof(*temp), compare_access_rank);
+
   /* (1) There are two classes of representations that are likely to be
    * referenced from future shards.  These form a "hot zone" of mostly
    * relevant data, i.e. we try to include as many reps as possible that
@@ -914,7 +1089,14 @@ sort_reps_range(pack_context_t *context,
    */
   for (i = first; i < last; ++i)
     {
-      int round = roundness(path_order[i]->predecessor_count);
+      int round;
+      svn_boolean_t likely_target;
+      svn_boolean_t likely_head;
+
+      if (path_order[i] == NULL)
+        continue;
+
+      round = roundness(path_order[i]->predecessor_count);
 
       /* Class 1:
        * Pretty round _and_ a significant stop in the node's delta chain.
@@ -925,7 +1107,7 @@ sort_reps_range(pack_context_t *context,
        * Larger values increase the number of items in the "hot zone".
        * Smaller values make delta chains at HEAD more likely to contain
        * "cold zone" representations. */
-      svn_boolean_t likely_target
+      likely_target
         =    (round >= ffd->max_linear_deltification)
           && (round >= path_order[i]->predecessor_count / 4);
 
@@ -933,7 +1115,7 @@ sort_reps_range(pack_context_t *context,
        * Anything from short node chains.  The default of 16 is generous
        * but we'd rather include too many than too few nodes here to keep
        * seeks between different regions of this pack file at a minimum. */
-      svn_boolean_t likely_head
+      likely_head
         =   path_order[i]->predecessor_count
           < ffd->max_linear_deltification;
 
@@ -1061,14 +1243,84 @@ compare_p2l_info(const svn_fs_fs__p2l_entry_t * const * lhs,
   return (*lhs)->item.revision > (*rhs)->item.revision ? -1 : 1;
 }
 
+/* An item listed in the access profile, see sort_items(). */
+typedef struct ranked_item_t
+{
+  /* position of its first access in the profile */
+  int access_rank;
+
+  /* the item itself */
+  svn_fs_fs__p2l_entry_t *entry;
+} ranked_item_t;
+
+/* implements compare_fn_t.  Sort ascendingly by ACCESS_RANK.
+ */
+static int
+compare_ranked_items(const void *lhs_p,
+                     const void *rhs_p)
+{
+  const ranked_item_t *lhs = lhs_p;
+  const ranked_item_t *rhs = rhs_p;
+
+  if (lhs->access_rank == rhs->access_rank)
+    return 0;
+
+  return lhs->access_rank < rhs->access_rank ? -1 : 1;
+}
+
 /* Sort svn_fs_fs__p2l_entry_t * array ENTRIES by age.  Place the latest
- * items first.
+ * items first.  If CONTEXT has an access profile, place the items listed
+ * in there in front of all others, in the order of their first access.
+ * Use POOL for temporary allocations.
  */
 static void
-sort_items(apr_array_header_t *entries)
+sort_items(pack_context_t *context,
+           apr_array_header_t *entries,
+           apr_pool_t *pool)
 {
+  apr_array_header_t *ranked;
+  apr_array_header_t *unranked;
+  int i;
+
   svn_sort__array(entries,
                   (int (*)(const void *, const void *))compare_p2l_info);
+  if (context->access_ranks == NULL)
+    return;
+
+  /* Partition ENTRIES.  This keeps the age order among unranked items. */
+  ranked = apr_array_make(pool, 16, sizeof(ranked_item_t));
+  unranked = apr_array_make(pool, entries->nelts,
+                            sizeof(svn_fs_fs__p2l_entry_t *));
+  for (i = 0; i < entries->nelts; ++i)
+    {
+      svn_fs_fs__p2l_entry_t *entry
+        = APR_ARRAY_IDX(entries, i, svn_fs_fs__p2l_entry_t *);
+      svn_fs_fs__id_part_t id;
+      int rank;
+
+      id.revision = entry->item.revision;
+      id.number = entry->item.number;
+      rank = get_access_rank(context, &id, pool);
+      if (rank)
+        {
+          ranked_item_t *item = apr_array_push(ranked);
+          item->access_rank = rank;
+          item->entry = entry;
+        }
+      else
+        {
+          APR_ARRAY_PUSH(unranked, svn_fs_fs__p2l_entry_t *) = entry;
+        }
+    }
+
+  qsort(ranked->elts, ranked->nelts, ranked->elt_size, compare_ranked_items);
+
+  for (i = 0; i < ranked->nelts; ++i)
+    APR_ARRAY_IDX(entries, i, svn_fs_fs__p2l_entry_t *)
+      = APR_ARRAY_IDX(ranked, i, ranked_item_t).entry;
+  for (i = 0; i < unranked->nelts; ++i)
+    APR_ARRAY_IDX(entries, ranked->nelts + i, svn_fs_fs__p2l_entry_t *)
+      = APR_ARRAY_IDX(unranked, i, svn_fs_fs__p2l_entry_t *);
 }
 
 /* Return the remaining unused bytes in the current block in CONTEXT's
@@ -1426,9 +1678,9 @@ pack_range(pack_context_t *context,
 
   /* phase 3: placement.
    * Use "newest first" placement for simple items. */
-  sort_items(context->changes);
-  sort_items(context->file_props);
-  sort_items(context->dir_props);
+  sort_items(context, context->changes, context->info_pool);
+  sort_items(context, context->file_props, context->info_pool);
+  sort_items(context, context->dir_props, context->info_pool);
 
   /* follow dependencies recursively for noderevs and data representations */
   sort_reps(context);
@@ -1850,6 +2102,395 @@ pack_rev_shard(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
+/* Set *PACK_FILE_DIR and *SHARD_PATH to the directories of the packed
+ * and the non-packed revision SHARD in REVS_DIR, respectively.  Allocate
+ * them in POOL.
+ */
+static void
+get_shard_paths(const char **pack_file_dir,
+                const char **shard_path,
+                const char *revs_dir,
+                apr_int64_t shard,
+                apr_pool_t *pool)
+{
+  *pack_file_dir = svn_dirent_join(revs_dir,
+                  apr_psprintf(pool,
+                               "%" APR_INT64_T_FMT PATH_EXT_PACKED_SHARD,
+                               shard),
+                  pool);
+  *shard_path = svn_dirent_join(revs_dir,
+                                apr_psprintf(pool, "%" APR_INT64_T_FMT, shard),
+                                pool);
+}
+
+/* State of the worker threads that pack revision shards ahead of the
+ * one currently being processed by pack_body().  Only the rev files get
+ * packed concurrently.  Publishing the packed shards and the revprop
+ * packing still happens in strict shard order in the thread that runs
+ * pack_body().
+ */
+typedef struct shard_packer_t shard_packer_t;
+
+#if APR_HAS_THREADS
+
+/* Number of shards per worker thread that may be packed ahead of the
+   oldest one not published yet. */
+#define PACK_WINDOW_PER_THREAD 2
+
+/* Check for cancellation that often while waiting for a worker. */
+#define PACK_WAIT_INTERVAL apr_time_from_msec(100)
+
+/* Outcome of packing a single shard in a worker thread. */
+typedef struct pack_job_t
+{
+  /* The shard that has been packed. */
+  apr_int64_t shard;
+
+  /* The error returned by pack_rev_shard(). */
+  svn_error_t *err;
+} pack_job_t;
+
+/* Per-thread data of a pack worker. */
+typedef struct pack_worker_t
+{
+  /* The shared state. */
+  shard_packer_t *packer;
+
+  /* Private filesystem instance. */
+  svn_fs_t *fs;
+
+  /* Root pool used only by this thread. */
+  apr_pool_t *pool;
+
+  /* The thread itself or NULL if it could not be started. */
+  apr_thread_t *thread;
+} pack_worker_t;
+
+struct shard_packer_t
+{
+  /* Protects NEXT_SHARD, FIRST_SHARD and JOBS.  Used with COND. */
+  svn_mutex__t *mutex;
+
+  /* Signaled whenever a job completes, a worker terminates or a shard
+     has been published. */
+  apr_thread_cond_t *cond;
+
+  /* The next shard to be claimed by a worker. */
+  apr_int64_t next_shard;
+
+  /* The oldest shard that has not been published yet. */
+  apr_int64_t first_shard;
+
+  /* One past the last shard to pack. */
+  apr_int64_t end_shard;
+
+  /* Completed jobs, indexed by shard modulo MAX_JOBS.  Workers don't
+     claim shards MAX_JOBS or more ahead of FIRST_SHARD. */
+  pack_job_t *jobs;
+  svn_boolean_t *done;
+  int max_jobs;
+
+  /* Number of worker threads that have not terminated yet. */
+  volatile svn_atomic_t running;
+
+  /* Non-zero once the workers shall stop. */
+  volatile svn_atomic_t aborted;
+
+  /* Parameters for pack_rev_shard().  Read-only. */
+  const char *revs_dir;
+  int max_files_per_dir;
+  apr_size_t max_mem;
+  svn_boolean_t flush_to_disk;
+
+  /* All worker threads. */
+  pack_worker_t *workers;
+  int worker_count;
+};
+
+/* Implements svn_cancel_func_t for the shard_packer_t BATON.
+   Workers must not call the caller's cancellation function. */
+static svn_error_t *
+check_pack_aborted(void *baton)
+{
+  shard_packer_t *packer = baton;
+
+  if (svn_atomic_read(&packer->aborted))
+    return svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *SHARD to the next shard to pack for PACKER.  Wait until it is
+   within the job window.  Set it to -1 if there is nothing left to do. */
+static svn_error_t *
+claim_shard(apr_int64_t *shard,
+            shard_packer_t *packer)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+
+  SVN_ERR(svn_mutex__lock(packer->mutex));
+
+  /* This loop implicitly handles spurious wake-ups. */
+  while (!svn_atomic_read(&packer->aborted)
+         && packer->next_shard < packer->end_shard
+         && packer->next_shard - packer->first_shard >= packer->max_jobs)
+    {
+      apr_status_t status
+        = apr_thread_cond_wait(packer->cond, svn_mutex__get(packer->mutex));
+      if (status)
+        {
+          err = svn_error_wrap_apr(status,
+                                   _("Can't wait for condition variable"));
+          break;
+        }
+    }
+
+  if (err
+      || svn_atomic_read(&packer->aborted)
+      || packer->next_shard >= packer->end_shard)
+    *shard = -1;
+  else
+    *shard = packer->next_shard++;
+
+  return svn_error_trace(svn_mutex__unlock(packer->mutex, err));
+}
+
+/* Thread function.  Pack shards for the pack_worker_t given by DATA until
+   there are no more or packing got aborted. */
+static void * APR_THREAD_FUNC
+pack_thread(apr_thread_t *tid,
+            void *data)
+{
+  pack_worker_t *worker = data;
+  shard_packer_t *packer = worker->packer;
+  apr_pool_t *iterpool = svn_pool_create(worker->pool);
+  svn_error_t *err = SVN_NO_ERROR;
+
+  while (!err)
+    {
+      apr_int64_t shard;
+      const char *pack_file_dir, *shard_path;
+      svn_error_t *pack_err;
+      int slot;
+
+      svn_pool_clear(iterpool);
+
+      err = claim_shard(&shard, packer);
+      if (err || shard < 0)
+        break;
+
+      /* Our FS instance does not know about the shards that got packed
+         since we opened it.  Nothing beyond those changes, though. */
+      get_shard_paths(&pack_file_dir, &shard_path, packer->revs_dir, shard,
+                      iterpool);
+      pack_err = pack_rev_shard(worker->fs, pack_file_dir, shard_path, shard,
+                                packer->max_files_per_dir, packer->max_mem,
+                                packer->flush_to_disk,
+                                check_pack_aborted, packer, iterpool);
+
+      /* Once claimed, the main thread waits for this shard.  So, hand it
+         over even if we could not get the lock. */
+      err = svn_mutex__lock(packer->mutex);
+      slot = (int)(shard % packer->max_jobs);
+      packer->jobs[slot].shard = shard;
+      packer->jobs[slot].err = pack_err;
+      packer->done[slot] = TRUE;
+      if (!err)
+        {
+          apr_thread_cond_broadcast(packer->cond);
+          err = svn_mutex__unlock(packer->mutex, SVN_NO_ERROR);
+        }
+    }
+
+  svn_error_clear(err);
+  svn_pool_destroy(iterpool);
+
+  /* Shards that no worker is left for will be packed by the main
+     thread. */
+  err = svn_mutex__lock(packer->mutex);
+  svn_atomic_dec(&packer->running);
+  if (!err)
+    {
+      apr_thread_cond_broadcast(packer->cond);
+      err = svn_mutex__unlock(packer->mutex, SVN_NO_ERROR);
+    }
+
+  svn_error_clear(err);
+
+  return NULL;
+}
+
+/* Wait for the worker threads of PACKER to pack the rev files of SHARD,
+   which is the oldest shard not published yet.  Check for cancellation
+   through CANCEL_FUNC and CANCEL_BATON periodically.  Set *PACKED to FALSE
+   if no worker is left to pack SHARD.  Otherwise, set it to TRUE and
+   return the error that packing SHARD returned. */
+static svn_error_t *
+wait_for_shard(svn_boolean_t *packed,
+               shard_packer_t *packer,
+               apr_int64_t shard,
+               svn_cancel_func_t cancel_func,
+               void *cancel_baton)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+  int slot = (int)(shard % packer->max_jobs);
+
+  SVN_ERR(svn_mutex__lock(packer->mutex));
+
+  while (!packer->done[slot] && svn_atomic_read(&packer->running))
+    {
+      apr_status_t status;
+
+      if (cancel_func)
+        {
+          err = cancel_func(cancel_baton);
+          if (err)
+            break;
+        }
+
+      status = apr_thread_cond_timedwait(packer->cond,
+                                         svn_mutex__get(packer->mutex),
+                                         PACK_WAIT_INTERVAL);
+      if (status && !APR_STATUS_IS_TIMEUP(status))
+        {
+          err = svn_error_wrap_apr(status,
+                                   _("Can't wait for condition variable"));
+          break;
+        }
+    }
+
+  if (!err)
+    {
+      *packed = packer->done[slot];
+      if (*packed)
+        {
+          SVN_ERR_ASSERT_NO_RETURN(packer->jobs[slot].shard == shard);
+          err = packer->jobs[slot].err;
+          packer->jobs[slot].err = SVN_NO_ERROR;
+          packer->done[slot] = FALSE;
+        }
+
+      /* Free the slot for the next shard. */
+      packer->first_shard = shard + 1;
+      apr_thread_cond_broadcast(packer->cond);
+    }
+
+  return svn_error_trace(svn_mutex__unlock(packer->mutex, err));
+}
+
+/* Start up to JOBS worker threads in *PACKER that pack the rev files of
+   shards FIRST_SHARD up to but not including END_SHARD in FS.  The
+   workers write to the pack directories in REVS_DIR but never publish
+   the result.  MAX_MEM is as for pack_rev_shard().  Use POOL for the
+   shared state. */
+static svn_error_t *
+start_shard_packer(shard_packer_t **packer_p,
+                   svn_fs_t *fs,
+                   const char *revs_dir,
+                   apr_int64_t first_shard,
+                   apr_int64_t end_shard,
+                   int jobs,
+                   apr_size_t max_mem,
+                   apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  shard_packer_t *packer = apr_pcalloc(pool, sizeof(*packer));
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_status_t status;
+  int i;
+
+  SVN_ERR(svn_mutex__init(&packer->mutex, TRUE, pool));
+  status = apr_thread_cond_create(&packer->cond, pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create condition variable"));
+
+  if (end_shard - first_shard < jobs)
+    jobs = (int)(end_shard - first_shard);
+
+  packer->next_shard = first_shard;
+  packer->first_shard = first_shard;
+  packer->end_shard = end_shard;
+  packer->max_jobs = jobs * PACK_WINDOW_PER_THREAD;
+  packer->jobs = apr_pcalloc(pool, packer->max_jobs * sizeof(*packer->jobs));
+  packer->done = apr_pcalloc(pool, packer->max_jobs * sizeof(*packer->done));
+  packer->revs_dir = revs_dir;
+  packer->max_files_per_dir = ffd->max_files_per_dir;
+  packer->max_mem = max_mem;
+  packer->flush_to_disk = ffd->flush_to_disk;
+  packer->workers = apr_pcalloc(pool, jobs * sizeof(*packer->workers));
+
+  for (i = 0; i < jobs; i++)
+    {
+      pack_worker_t *worker = &packer->workers[packer->worker_count];
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+
+      worker->packer = packer;
+      worker->pool
+        = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+
+      /* FS objects must not be shared between threads.  Leave the work
+         to the other workers or to the main thread if we can't get one. */
+      err = svn_fs_fs__open_instance(&worker->fs, fs, worker->pool,
+                                     iterpool);
+      if (!err)
+        {
+          svn_atomic_inc(&packer->running);
+          status = apr_thread_create(&worker->thread, NULL, pack_thread,
+                                     worker, worker->pool);
+          if (status)
+            svn_atomic_dec(&packer->running);
+          else
+            packer->worker_count++;
+        }
+
+      if (err || status)
+        {
+          svn_error_clear(err);
+          svn_pool_destroy(worker->pool);
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  *packer_p = packer;
+
+  return SVN_NO_ERROR;
+}
+
+/* Stop all worker threads of PACKER and discard their results. */
+static svn_error_t *
+stop_shard_packer(shard_packer_t *packer)
+{
+  svn_error_t *err;
+  int i;
+
+  svn_atomic_set(&packer->aborted, TRUE);
+  err = svn_mutex__lock(packer->mutex);
+  apr_thread_cond_broadcast(packer->cond);
+  err = svn_mutex__unlock(packer->mutex, err);
+
+  for (i = 0; i < packer->worker_count; i++)
+    {
+      apr_status_t retval;
+      apr_status_t status = apr_thread_join(&retval,
+                                            packer->workers[i].thread);
+      if (status)
+        err = svn_error_compose_create(
+                err, svn_error_wrap_apr(status, _("Can't join pack thread")));
+
+      svn_pool_destroy(packer->workers[i].pool);
+    }
+
+  for (i = 0; i < packer->max_jobs; i++)
+    if (packer->done[i])
+      svn_error_clear(packer->jobs[i].err);
+
+  return svn_error_trace(err);
+}
+
+#endif /* APR_HAS_THREADS */
+
 /* Baton struct used by pack_body(), pack_shard() and synced_pack_shard().
    These calls are nested and for every level additional fields will be
    available. */
@@ -1862,8 +2503,10 @@ struct pack_baton
   svn_cancel_func_t cancel_func;
   void *cancel_baton;
   size_t max_mem;
+  int jobs;
 
   /* Additional entries valid when entering pack_shard(). */
+  shard_packer_t *packer;
   const char *revs_dir;
   const char *revsprops_dir;
   apr_int64_t shard;
@@ -1965,6 +2608,7 @@ pack_shard(struct pack_baton *baton,
 {
   fs_fs_data_t *ffd = baton->fs->fsap_data;
   const char *rev_pack_file_dir;
+  svn_boolean_t packed = FALSE;
 
   /* Notify caller we're starting to pack this shard. */
   if (baton->notify_func)
@@ -1972,22 +2616,22 @@ pack_shard(struct pack_baton *baton,
                                svn_fs_pack_notify_start, pool));
 
   /* Some useful paths. */
-  rev_pack_file_dir = svn_dirent_join(baton->revs_dir,
-                  apr_psprintf(pool,
-                               "%" APR_INT64_T_FMT PATH_EXT_PACKED_SHARD,
-                               baton->shard),
-                  pool);
-  baton->rev_shard_path = svn_dirent_join(baton->revs_dir,
-                                          apr_psprintf(pool,
-                                                       "%" APR_INT64_T_FMT,
-                                                       baton->shard),
-                                          pool);
-
-  /* pack the revision content */
-  SVN_ERR(pack_rev_shard(baton->fs, rev_pack_file_dir, baton->rev_shard_path,
-                         baton->shard, ffd->max_files_per_dir,
-                         baton->max_mem, ffd->flush_to_disk,
-                         baton->cancel_func, baton->cancel_baton, pool));
+  get_shard_paths(&rev_pack_file_dir, &baton->rev_shard_path,
+                  baton->revs_dir, baton->shard, pool);
+
+  /* pack the revision content, unless some worker thread did it already */
+#if APR_HAS_THREADS
+  if (baton->packer)
+    SVN_ERR(wait_for_shard(&packed, baton->packer, baton->shard,
+                           baton->cancel_func, baton->cancel_baton));
+#endif
+
+  if (!packed)
+    SVN_ERR(pack_rev_shard(baton->fs, rev_pack_file_dir,
+                           baton->rev_shard_path, baton->shard,
+                           ffd->max_files_per_dir, baton->max_mem,
+                           ffd->flush_to_disk, baton->cancel_func,
+                           baton->cancel_baton, pool));
 
   /* For newer repo formats, we only acquired the pack lock so far.
      Before modifying the repo state by switching over to the packed
@@ -1998,6 +2642,11 @@ pack_shard(struct pack_baton *baton,
   else
     SVN_ERR(synced_pack_shard(baton, pool));
 
+  /* The shard is complete now.  Make sure its changed paths index is. */
+  SVN_ERR(svn_fs_fs__changed_paths_index_build(baton->fs, baton->shard,
+                                               baton->cancel_func,
+                                               baton->cancel_baton, pool));
+
   /* Notify caller we're starting to pack this shard. */
   if (baton->notify_func)
     SVN_ERR(baton->notify_func(baton->notify_baton, baton->shard,
@@ -2055,8 +2704,10 @@ pack_body(void *baton,
   struct pack_baton *pb = baton;
   fs_fs_data_t *ffd = pb->fs->fsap_data;
   apr_int64_t completed_shards;
+  apr_int64_t first_shard;
   apr_pool_t *iterpool;
   svn_boolean_t fully_packed;
+  svn_error_t *err = SVN_NO_ERROR;
 
   /* Since another process might have already packed the repo,
      we need to re-read the pack status. */
@@ -2077,26 +2728,47 @@ pack_body(void *baton,
     pb->revsprops_dir = svn_dirent_join(pb->fs->path, PATH_REVPROPS_DIR,
                                         pool);
 
+  first_shard = ffd->min_unpacked_rev / ffd->max_files_per_dir;
+
+#if APR_HAS_THREADS
+  /* Let worker threads pack the rev files of the upcoming shards while
+     we publish them one by one. */
+  if (pb->jobs > 1 && completed_shards - first_shard > 1)
+    SVN_ERR(start_shard_packer(&pb->packer, pb->fs, pb->revs_dir,
+                               first_shard, completed_shards, pb->jobs,
+                               pb->max_mem, pool));
+#endif
+
   iterpool = svn_pool_create(pool);
-  for (pb->shard = ffd->min_unpacked_rev / ffd->max_files_per_dir;
-       pb->shard < completed_shards;
+  for (pb->shard = first_shard;
+       !err && pb->shard < completed_shards;
        pb->shard++)
     {
       svn_pool_clear(iterpool);
 
       if (pb->cancel_func)
-        SVN_ERR(pb->cancel_func(pb->cancel_baton));
+        err = pb->cancel_func(pb->cancel_baton);
 
-      SVN_ERR(pack_shard(pb, iterpool));
+      if (!err)
+        err = pack_shard(pb, iterpool);
     }
 
+#if APR_HAS_THREADS
+  if (pb->packer)
+    {
+      err = svn_error_compose_create(err, stop_shard_packer(pb->packer));
+      pb->packer = NULL;
+    }
+#endif
+
   svn_pool_destroy(iterpool);
-  return SVN_NO_ERROR;
+  return svn_error_trace(err);
 }
 
 svn_error_t *
 svn_fs_fs__pack(svn_fs_t *fs,
                 apr_size_t max_mem,
+                int jobs,
                 svn_fs_pack_notify_t notify_func,
                 void *notify_baton,
                 svn_cancel_func_t cancel_func,
@@ -2143,6 +2815,7 @@ svn_fs_fs__pack(svn_fs_t *fs,
   pb.cancel_func = cancel_func;
   pb.cancel_baton = cancel_baton;
   pb.max_mem = max_mem ? max_mem : DEFAULT_MAX_MEM;
+  pb.jobs = jobs;
 
   if (ffd->format >= SVN_FS_FS__MIN_PACK_LOCK_FORMAT)
     {
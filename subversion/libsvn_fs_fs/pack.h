@@ -31,6 +31,8 @@
 
    MAX_MEM limits the size of in-memory data structures needed for reordering
    items in format 7 repositories.  0 means use the built-in default.
+   It applies to each of the up to JOBS shards being packed concurrently.
+   Values of JOBS below 2 pack one shard after the other.
 
    If given, NOTIFY_FUNC will be called with NOTIFY_BATON to report progress.
    Use optional CANCEL_FUNC/CANCEL_BATON for cancellation support.
@@ -39,6 +41,7 @@
 svn_error_t *
 svn_fs_fs__pack(svn_fs_t *fs,
                 apr_size_t max_mem,
+                int jobs,
                 svn_fs_pack_notify_t notify_func,
                 void *notify_baton,
                 svn_cancel_func_t cancel_func,
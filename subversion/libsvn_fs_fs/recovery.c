@@ -20,14 +20,18 @@
  * ====================================================================
  */
 
+#include <apr_thread_proc.h>
+
 #include "recovery.h"
 
 #include "svn_hash.h"
 #include "svn_pools.h"
+#include "svn_sorts.h"
 #include "private/svn_string_private.h"
 
 #include "index.h"
 #include "low_level.h"
+#include "mergeinfo-index.h"
 #include "rep-cache.h"
 #include "revprops.h"
 #include "util.h"
@@ -331,6 +335,188 @@ recover_get_root_offset(apr_off_t *root_offset,
   return SVN_NO_ERROR;
 }
 
+/* Number of revision ranges that recover_scan_revisions() scans
+   concurrently and the number of revisions in each of these ranges. */
+#define RECOVERY_THREADS 8
+#define RECOVERY_RANGE_SIZE 100
+
+/* Part of the recovery procedure.  Scan the revisions START_REV (inclusive)
+   to END_REV (exclusive) in FS and set MAX_NODE_ID and MAX_COPY_ID to the
+   largest node-id and copy-id found, if greater than the current value
+   stored in either.  Perform temporary allocations in SCRATCH_POOL. */
+static svn_error_t *
+recover_scan_range(svn_fs_t *fs,
+                   svn_revnum_t start_rev,
+                   svn_revnum_t end_rev,
+                   apr_uint64_t *max_node_id,
+                   apr_uint64_t *max_copy_id,
+                   apr_pool_t *scratch_pool)
+{
+  svn_revnum_t rev;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  for (rev = start_rev; rev < end_rev; rev++)
+    {
+      svn_fs_fs__revision_file_t *rev_file;
+      apr_off_t root_offset;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, rev, iterpool,
+                                               iterpool));
+      SVN_ERR(recover_get_root_offset(&root_offset, rev, rev_file,
+                                      iterpool));
+      SVN_ERR(recover_find_max_ids(fs, rev, rev_file, root_offset,
+                                   max_node_id, max_copy_id, iterpool));
+      SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Parameters and results of a recover_scan_range() call. */
+typedef struct range_scan_t
+{
+  /* Input parameters to recover_scan_range(). */
+  svn_fs_t *fs;
+  svn_revnum_t start_rev;
+  svn_revnum_t end_rev;
+
+  /* Maximum IDs found in the range.  Initialized to 0. */
+  apr_uint64_t max_node_id;
+  apr_uint64_t max_copy_id;
+
+  /* Result of the scan. */
+  svn_error_t *result;
+
+  /* Pool private to this scan, i.e. to the thread running it. */
+  apr_pool_t *pool;
+
+#if APR_HAS_THREADS
+  /* The thread running the scan. */
+  apr_thread_t *thread;
+#endif
+} range_scan_t;
+
+/* Execute the range scan SCAN. */
+static void
+run_range_scan(range_scan_t *scan)
+{
+  scan->result = recover_scan_range(scan->fs, scan->start_rev, scan->end_rev,
+                                    &scan->max_node_id, &scan->max_copy_id,
+                                    scan->pool);
+}
+
+#if APR_HAS_THREADS
+/* APR thread start function executing the range_scan_t given as DATA. */
+static void * APR_THREAD_FUNC
+range_scan_task(apr_thread_t *thread,
+                void *data)
+{
+  run_range_scan(data);
+  return NULL;
+}
+#endif
+
+/* Part of the recovery procedure.  Scan up to RECOVERY_THREADS ranges of
+   RECOVERY_RANGE_SIZE revisions each in FS concurrently, starting at
+   revision START_REV but stopping at revision END_REV (exclusive).  Set
+   *NEXT_REV to the first revision not scanned and update MAX_NODE_ID and
+   MAX_COPY_ID as recover_scan_range() does.  Use SCRATCH_POOL for
+   temporary allocations. */
+static svn_error_t *
+recover_scan_revisions(svn_revnum_t *next_rev,
+                       svn_fs_t *fs,
+                       svn_revnum_t start_rev,
+                       svn_revnum_t end_rev,
+                       apr_uint64_t *max_node_id,
+                       apr_uint64_t *max_copy_id,
+                       apr_pool_t *scratch_pool)
+{
+  range_scan_t scans[RECOVERY_THREADS];
+  svn_error_t *err = SVN_NO_ERROR;
+  svn_revnum_t rev = start_rev;
+  int count = 0;
+  int i;
+
+  SVN_ERR_ASSERT(start_rev < end_rev);
+  while (count < RECOVERY_THREADS && rev < end_rev)
+    {
+      scans[count].fs = fs;
+      scans[count].start_rev = rev;
+      scans[count].end_rev = MIN(rev + RECOVERY_RANGE_SIZE, end_rev);
+      scans[count].max_node_id = 0;
+      scans[count].max_copy_id = 0;
+      scans[count].result = SVN_NO_ERROR;
+
+      rev = scans[count].end_rev;
+      ++count;
+    }
+
+  *next_rev = rev;
+
+#if APR_HAS_THREADS
+  if (count > 1)
+    {
+      int started;
+
+      /* Each thread needs a pool that it does not share with any other
+       * thread, including its allocator. */
+      for (started = 0; started < count; ++started)
+        {
+          apr_status_t status;
+
+          scans[started].pool = svn_pool_create(NULL);
+          status = apr_thread_create(&scans[started].thread, NULL,
+                                     range_scan_task, &scans[started],
+                                     scans[started].pool);
+          if (status)
+            {
+              err = svn_error_wrap_apr(status,
+                                       _("Can't create recovery thread"));
+              svn_pool_destroy(scans[started].pool);
+              break;
+            }
+        }
+
+      /* Wait for all threads that we started, even if we failed to start
+       * some of them. */
+      for (i = 0; i < started; ++i)
+        {
+          apr_status_t retval;
+          apr_status_t status = apr_thread_join(&retval, scans[i].thread);
+          if (status)
+            err = svn_error_compose_create(err,
+                         svn_error_wrap_apr(status,
+                                            _("Can't join recovery thread")));
+
+          err = svn_error_compose_create(err, scans[i].result);
+          svn_pool_destroy(scans[i].pool);
+        }
+
+      SVN_ERR(err);
+    }
+  else
+#endif
+    {
+      for (i = 0; i < count; ++i)
+        {
+          scans[i].pool = scratch_pool;
+          run_range_scan(&scans[i]);
+          SVN_ERR(scans[i].result);
+        }
+    }
+
+  for (i = 0; i < count; ++i)
+    {
+      *max_node_id = MAX(*max_node_id, scans[i].max_node_id);
+      *max_copy_id = MAX(*max_copy_id, scans[i].max_copy_id);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Baton used for recover_body below. */
 struct recover_baton {
   svn_fs_t *fs;
@@ -408,26 +594,21 @@ recover_body(void *baton, apr_pool_t *pool)
       /* Next we need to find the maximum node id and copy id in use across the
          filesystem.  Unfortunately, the only way we can get this information
          is to scan all the noderevs of all the revisions and keep track as
-         we go along. */
-      svn_revnum_t rev;
+         we go along.  Revisions are independent of each other in that
+         respect, so scan multiple revision ranges concurrently. */
+      svn_revnum_t rev = 0;
       apr_pool_t *iterpool = svn_pool_create(pool);
 
-      for (rev = 0; rev <= max_rev; rev++)
+      while (rev <= max_rev)
         {
-          svn_fs_fs__revision_file_t *rev_file;
-          apr_off_t root_offset;
-
           svn_pool_clear(iterpool);
 
           if (b->cancel_func)
             SVN_ERR(b->cancel_func(b->cancel_baton));
 
-          SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, rev, pool,
-                                                   iterpool));
-          SVN_ERR(recover_get_root_offset(&root_offset, rev, rev_file, pool));
-          SVN_ERR(recover_find_max_ids(fs, rev, rev_file, root_offset,
-                                       &next_node_id, &next_copy_id, pool));
-          SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+          SVN_ERR(recover_scan_revisions(&rev, fs, rev, max_rev + 1,
+                                         &next_node_id, &next_copy_id,
+                                         iterpool));
         }
       svn_pool_destroy(iterpool);
 
@@ -482,6 +663,16 @@ recover_body(void *baton, apr_pool_t *pool)
         SVN_ERR(svn_fs_fs__del_rep_reference(fs, max_rev, pool));
     }
 
+  /* Likewise for the mergeinfo index. */
+  {
+    svn_boolean_t mergeinfo_index_exists;
+
+    SVN_ERR(svn_fs_fs__exists_mergeinfo_index(&mergeinfo_index_exists, fs,
+                                              pool));
+    if (mergeinfo_index_exists)
+      SVN_ERR(svn_fs_fs__del_indexed_mergeinfo(fs, max_rev, pool));
+  }
+
   /* Now store the discovered youngest revision, and the next IDs if
      relevant, in a new 'current' file. */
   return svn_fs_fs__write_current(fs, max_rev, next_node_id, next_copy_id,
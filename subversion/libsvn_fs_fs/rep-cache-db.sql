@@ -52,6 +52,21 @@ WHERE revision >= ?1 AND revision <= ?2
 SELECT MAX(revision)
 FROM rep_cache
 
+-- STMT_GET_ALL_HASHES
+SELECT hash
+FROM rep_cache
+
+/* The highest rowid is an upper bound for the number of rows and can be
+   determined without a table scan. */
+-- STMT_GET_MAX_ROWID
+SELECT MAX(rowid)
+FROM rep_cache
+
+/* Changes whenever another connection modified the database.
+   Requires SQLite 3.8.4 or newer; older versions return no row. */
+-- STMT_GET_DATA_VERSION
+PRAGMA data_version
+
 -- STMT_DEL_REPS_YOUNGER_THAN_REV
 DELETE FROM rep_cache
 WHERE revision > ?1
@@ -20,6 +20,9 @@
  * ====================================================================
  */
 
+#include <apr_thread_proc.h>
+#include <apr_thread_cond.h>
+
 #include "svn_pools.h"
 
 #include "svn_private_config.h"
@@ -27,11 +30,15 @@
 #include "cached_data.h"
 #include "fs_fs.h"
 #include "fs.h"
+#include "id.h"
 #include "rep-cache.h"
 #include "../libsvn_fs/fs-loader.h"
 
 #include "svn_path.h"
+#include "svn_sorts.h"
 
+#include "private/svn_atomic.h"
+#include "private/svn_mutex.h"
 #include "private/svn_sqlite.h"
 
 #include "rep-cache-db.h"
@@ -51,6 +58,275 @@ path_rep_cache_db(const char *fs_path,
   return svn_dirent_join(fs_path, REP_CACHE_DB_NAME, result_pool);
 }
 
+
+/** The rep-cache Bloom filter. **/
+
+/* Once a large share of rep-cache lookups fail, e.g. because we load new
+ * contents, we build a Bloom filter over all keys in the rep-cache.  It
+ * tells us that a key is "definitely not present" without running a query.
+ *
+ * Other connections may add rows at any time, which would invalidate the
+ * filter.  SQLite's data_version tells us whether that happened.  If so,
+ * we stop using the filter for the lifetime of the FS instance.  It is
+ * more expensive to rebuild it than we could save in most of these cases.
+ */
+
+/* Number of misses before we consider building the filter at all.  We
+ * will then only build it if a scan of the table is cheap compared to the
+ * lookups we were doing.
+ */
+#define REP_FILTER_MIN_MISSES 1024
+
+/* A table scan is that much cheaper per row than an individual query. */
+#define REP_FILTER_SCAN_FACTOR 16
+
+/* Filter bits per expected key and number of bits set per key.
+ * This gives less than 0.1% false positives at full capacity. */
+#define REP_FILTER_BITS_PER_KEY 16
+#define REP_FILTER_HASH_COUNT 6
+
+/* The Bloom filter object. */
+typedef struct svn_fs_fs__rep_filter_t
+{
+  /* The filter bits. */
+  apr_uint32_t *bits;
+
+  /* Number of bits in BITS minus 1.  The number of bits is a power of 2. */
+  apr_uint32_t mask;
+
+  /* Number of keys added since the filter has been created.  If this
+   * exceeds the designed capacity, the filter gets rebuilt. */
+  apr_uint64_t key_count;
+
+  /* Value of data_version when the filter was in sync with the DB. */
+  apr_int64_t data_version;
+
+  /* If FALSE, the filter must not be used anymore. */
+  svn_boolean_t valid;
+
+  /* Pool containing BITS. */
+  apr_pool_t *pool;
+} svn_fs_fs__rep_filter_t;
+
+/* Add the SHA1 DIGEST to FILTER. */
+static void
+rep_filter_add(svn_fs_fs__rep_filter_t *filter,
+               const unsigned char *digest)
+{
+  /* SHA1 digests are well distributed, so their bits can be used as hash
+   * values directly.  Combine two of them for the various functions. */
+  apr_uint32_t h1 = ((apr_uint32_t)digest[0] << 24) | (digest[1] << 16)
+                  | (digest[2] << 8) | digest[3];
+  apr_uint32_t h2 = ((apr_uint32_t)digest[4] << 24) | (digest[5] << 16)
+                  | (digest[6] << 8) | digest[7] | 1;
+  int i;
+
+  for (i = 0; i < REP_FILTER_HASH_COUNT; ++i, h1 += h2)
+    filter->bits[(h1 & filter->mask) / 32] |= 1u << (h1 % 32);
+
+  filter->key_count++;
+}
+
+/* Return TRUE if the SHA1 DIGEST may have been added to FILTER. */
+static svn_boolean_t
+rep_filter_may_contain(const svn_fs_fs__rep_filter_t *filter,
+                       const unsigned char *digest)
+{
+  apr_uint32_t h1 = ((apr_uint32_t)digest[0] << 24) | (digest[1] << 16)
+                  | (digest[2] << 8) | digest[3];
+  apr_uint32_t h2 = ((apr_uint32_t)digest[4] << 24) | (digest[5] << 16)
+                  | (digest[6] << 8) | digest[7] | 1;
+  int i;
+
+  for (i = 0; i < REP_FILTER_HASH_COUNT; ++i, h1 += h2)
+    if ((filter->bits[(h1 & filter->mask) / 32] & (1u << (h1 % 32))) == 0)
+      return FALSE;
+
+  return TRUE;
+}
+
+/* Return TRUE if FILTER has more keys than it has been designed for. */
+static svn_boolean_t
+rep_filter_is_full(const svn_fs_fs__rep_filter_t *filter)
+{
+  return filter->key_count * REP_FILTER_BITS_PER_KEY
+       > (apr_uint64_t)filter->mask + 1;
+}
+
+/* Read the current data_version of the rep-cache database in FS and
+ * return it in *VERSION.  Set *VALID to FALSE if SQLite does not support
+ * that feature.
+ */
+static svn_error_t *
+get_data_version(apr_int64_t *version,
+                 svn_boolean_t *valid,
+                 svn_fs_t *fs)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db,
+                                    STMT_GET_DATA_VERSION));
+  SVN_ERR(svn_sqlite__step(valid, stmt));
+  *version = *valid ? svn_sqlite__column_int64(stmt, 0) : 0;
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* Decode the first 8 bytes of the hex string HEX into DIGEST.
+ * Return FALSE if HEX is not a lower-case hex string of that length. */
+static svn_boolean_t
+decode_digest_prefix(unsigned char *digest,
+                     const char *hex)
+{
+  int i;
+  for (i = 0; i < 16; ++i)
+    {
+      int value;
+      if (hex[i] >= '0' && hex[i] <= '9')
+        value = hex[i] - '0';
+      else if (hex[i] >= 'a' && hex[i] <= 'f')
+        value = hex[i] - 'a' + 10;
+      else
+        return FALSE;
+
+      if (i % 2)
+        digest[i / 2] |= value;
+      else
+        digest[i / 2] = (unsigned char)(value << 4);
+    }
+
+  return TRUE;
+}
+
+/* Build a new Bloom filter for the rep-cache of FS and make it the
+ * current one.  Leave the filter unchanged if the database does not
+ * let us detect concurrent modifications.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+static svn_error_t *
+build_rep_filter(svn_fs_t *fs,
+                 apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_fs_fs__rep_filter_t *filter;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  apr_int64_t row_count;
+  apr_uint64_t bit_count = 0x10000;
+  apr_int64_t version;
+  svn_boolean_t valid;
+  apr_pool_t *pool;
+
+  /* Without data_version, we could not tell whether the filter is still
+   * valid when we use it. */
+  SVN_ERR(get_data_version(&version, &valid, fs));
+  if (!valid)
+    return SVN_NO_ERROR;
+
+  /* Is it worth building the filter? */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db,
+                                    STMT_GET_MAX_ROWID));
+  SVN_ERR(svn_sqlite__step_row(stmt));
+  row_count = svn_sqlite__column_int64(stmt, 0);
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  if (   ffd->rep_cache_misses * REP_FILTER_SCAN_FACTOR
+      < (apr_uint64_t)row_count)
+    return SVN_NO_ERROR;
+
+  /* Leave room for at least as many keys to be added as there are now.
+   * 32 bit indexes need to be sufficient. */
+  while (bit_count < (apr_uint64_t)row_count * 2 * REP_FILTER_BITS_PER_KEY
+         && bit_count < APR_UINT64_C(0x100000000))
+    bit_count *= 2;
+
+  pool = svn_pool_create(fs->pool);
+  filter = apr_pcalloc(pool, sizeof(*filter));
+  filter->pool = pool;
+  filter->mask = (apr_uint32_t)(bit_count - 1);
+  filter->bits = apr_pcalloc(pool, (apr_size_t)(bit_count / 8));
+  filter->data_version = version;
+  filter->valid = TRUE;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db,
+                                    STMT_GET_ALL_HASHES));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      unsigned char digest[8];
+      const char *hex = svn_sqlite__column_text(stmt, 0, NULL);
+
+      /* Rows with malformed keys can't be found by lookups anyway. */
+      if (hex && strlen(hex) >= 16 && decode_digest_prefix(digest, hex))
+        rep_filter_add(filter, digest);
+
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  /* Replace the old filter, if any. */
+  if (ffd->rep_filter)
+    svn_pool_destroy(ffd->rep_filter->pool);
+  ffd->rep_filter = filter;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *ABSENT to TRUE if the rep-cache of FS definitely does not contain
+ * the SHA1 DIGEST.  Otherwise, set it to FALSE.  Use SCRATCH_POOL for
+ * temporary allocations.
+ */
+static svn_error_t *
+rep_filter_check(svn_boolean_t *absent,
+                 svn_fs_t *fs,
+                 const unsigned char *digest,
+                 apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_fs_fs__rep_filter_t *filter = ffd->rep_filter;
+
+  *absent = FALSE;
+
+  /* Build or grow the filter as necessary. */
+  if (filter == NULL)
+    {
+      if (   ffd->rep_cache_misses < REP_FILTER_MIN_MISSES
+          || ffd->rep_cache_misses % REP_FILTER_MIN_MISSES)
+        return SVN_NO_ERROR;
+
+      SVN_ERR(build_rep_filter(fs, scratch_pool));
+      filter = ffd->rep_filter;
+      if (filter == NULL)
+        return SVN_NO_ERROR;
+    }
+  else if (filter->valid && rep_filter_is_full(filter))
+    {
+      SVN_ERR(build_rep_filter(fs, scratch_pool));
+
+      /* Too many false positives with the old filter. */
+      if (ffd->rep_filter == filter)
+        filter->valid = FALSE;
+
+      filter = ffd->rep_filter;
+    }
+
+  if (filter->valid && !rep_filter_may_contain(filter, digest))
+    {
+      /* Only trust the filter if nobody else modified the DB. */
+      apr_int64_t version;
+      svn_boolean_t valid;
+
+      SVN_ERR(get_data_version(&version, &valid, fs));
+      if (valid && version == filter->data_version)
+        *absent = TRUE;
+      else
+        filter->valid = FALSE;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 
 /** Library-private API's. **/
 
@@ -138,6 +414,10 @@ svn_fs_fs__close_rep_cache(svn_fs_t *fs)
       SVN_ERR(svn_sqlite__close(ffd->rep_cache_db));
       ffd->rep_cache_db = NULL;
       ffd->rep_cache_db_opened = 0;
+
+      /* The data_version of a new connection will be unrelated. */
+      if (ffd->rep_filter)
+        ffd->rep_filter->valid = FALSE;
     }
 
   return SVN_NO_ERROR;
@@ -265,6 +545,7 @@ svn_fs_fs__get_rep_reference(representation_t **rep_p,
   fs_fs_data_t *ffd = fs->fsap_data;
   svn_sqlite__stmt_t *stmt;
   svn_boolean_t have_row;
+  svn_boolean_t absent;
   representation_t *rep;
 
   SVN_ERR_ASSERT(ffd->rep_sharing_allowed);
@@ -277,6 +558,15 @@ svn_fs_fs__get_rep_reference(representation_t **rep_p,
                             _("Only SHA1 checksums can be used as keys in the "
                               "rep_cache table.\n"));
 
+  /* Skip the query if we know that there is no match. */
+  SVN_ERR(rep_filter_check(&absent, fs, checksum->digest, pool));
+  if (absent)
+    {
+      ffd->rep_cache_misses++;
+      *rep_p = NULL;
+      return SVN_NO_ERROR;
+    }
+
   SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db, STMT_GET_REP));
   SVN_ERR(svn_sqlite__bindf(stmt, "s",
                             svn_checksum_to_cstring(checksum, pool)));
@@ -294,7 +584,10 @@ svn_fs_fs__get_rep_reference(representation_t **rep_p,
       rep->expanded_size = svn_sqlite__column_int64(stmt, 3);
     }
   else
-    rep = NULL;
+    {
+      ffd->rep_cache_misses++;
+      rep = NULL;
+    }
 
   SVN_ERR(svn_sqlite__reset(stmt));
 
@@ -348,6 +641,11 @@ svn_fs_fs__set_rep_reference(svn_fs_t *fs,
                             (apr_int64_t) rep->expanded_size));
 
   err = svn_sqlite__insert(NULL, stmt);
+
+  /* Keep the filter in sync with our own modifications. */
+  if (ffd->rep_filter && ffd->rep_filter->valid)
+    rep_filter_add(ffd->rep_filter, rep->sha1_digest);
+
   if (err)
     {
       representation_t *old_rep;
@@ -434,8 +732,612 @@ svn_fs_fs__with_rep_cache_lock(svn_fs_t *fs,
                                apr_pool_t *pool)
 {
   svn_error_t *err;
+  apr_time_t start = svn_mutex__stats_enabled() ? apr_time_now() : 0;
+  apr_time_t locked = 0;
 
   SVN_ERR(lock_rep_cache(fs, pool));
+  if (start)
+    {
+      locked = apr_time_now();
+      svn_mutex__stats_add_wait("fsfs-rep-cache-lock", locked - start);
+    }
+
   err = body(baton, pool);
-  return svn_error_compose_create(err, unlock_rep_cache(fs, pool));
+  err = svn_error_compose_create(err, unlock_rep_cache(fs, pool));
+
+  if (start)
+    svn_mutex__stats_add_hold("fsfs-rep-cache-lock", apr_time_now() - locked);
+
+  return err;
+}
+
+
+
+/** Building the rep-cache for existing revisions. **/
+
+/* Number of revisions whose reps get collected in one go and written in
+   a single SQLite transaction.  Non-sharded repositories use this as
+   well; sharded ones process one shard at a time. */
+#define BUILD_CHUNK_SIZE 1000
+
+/* Append REP to REPS, an array of representation_t, if it has been added
+   in revision REV and is eligible for the rep-cache.  Use SCRATCH_POOL
+   for temporary allocations. */
+static svn_error_t *
+add_rep_to_build(apr_array_header_t *reps,
+                 svn_fs_t *fs,
+                 representation_t *rep,
+                 svn_revnum_t rev,
+                 apr_pool_t *scratch_pool)
+{
+  /* Reps without SHA1 come from formats that predate rep-sharing. */
+  if (rep == NULL || rep->revision != rev || !rep->has_sha1)
+    return SVN_NO_ERROR;
+
+  /* Record the same EXPANDED_SIZE a commit would. */
+  SVN_ERR(svn_fs_fs__fixup_expanded_size(fs, rep, scratch_pool));
+  APR_ARRAY_PUSH(reps, representation_t) = *rep;
+
+  return SVN_NO_ERROR;
+}
+
+/* Append the file contents and property reps added in revisions FIRST to
+   LAST of FS to REPS, an array of representation_t.  Every node-revision
+   that may have new reps shows up in the changed paths lists, so we don't
+   need to walk the trees.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+collect_reps(apr_array_header_t *reps,
+             svn_fs_t *fs,
+             svn_revnum_t first,
+             svn_revnum_t last,
+             svn_cancel_func_t cancel_func,
+             void *cancel_baton,
+             apr_pool_t *scratch_pool)
+{
+  apr_pool_t *revpool = svn_pool_create(scratch_pool);
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_revnum_t rev;
+
+  for (rev = first; rev <= last; ++rev)
+    {
+      svn_fs_fs__changes_context_t *context;
+
+      svn_pool_clear(revpool);
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(svn_fs_fs__create_changes_context(&context, fs, rev, revpool));
+      while (!context->eol)
+        {
+          apr_array_header_t *changes;
+          int i;
+
+          svn_pool_clear(iterpool);
+          SVN_ERR(svn_fs_fs__get_changes(&changes, context, iterpool,
+                                         iterpool));
+          for (i = 0; i < changes->nelts; ++i)
+            {
+              change_t *change = APR_ARRAY_IDX(changes, i, change_t *);
+              const svn_fs_id_t *id = change->info.node_rev_id;
+              node_revision_t *noderev;
+
+              if (change->info.change_kind == svn_fs_path_change_delete
+                  || id == NULL
+                  || svn_fs_fs__id_rev(id) != rev)
+                continue;
+
+              SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, id,
+                                                   iterpool, iterpool));
+              if (noderev->kind == svn_node_file)
+                SVN_ERR(add_rep_to_build(reps, fs, noderev->data_rep, rev,
+                                         iterpool));
+              SVN_ERR(add_rep_to_build(reps, fs, noderev->prop_rep, rev,
+                                       iterpool));
+            }
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  svn_pool_destroy(revpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Add REPS, an array of representation_t, to the rep-cache of FS in a
+   single SQLite transaction.  Use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+write_built_reps(svn_fs_t *fs,
+                 const apr_array_header_t *reps,
+                 apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  if (reps->nelts == 0)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_sqlite__begin_transaction(ffd->rep_cache_db));
+  for (i = 0; i < reps->nelts && !err; ++i)
+    {
+      svn_pool_clear(iterpool);
+      err = svn_fs_fs__set_rep_reference(fs,
+                                         &APR_ARRAY_IDX(reps, i,
+                                                        representation_t),
+                                         iterpool);
+    }
+  err = svn_sqlite__finish_transaction(ffd->rep_cache_db, err);
+  svn_pool_destroy(iterpool);
+
+  /* See svn_fs_fs__commit(). */
+  if (svn_error_find_cause(err, SVN_ERR_SQLITE_ROLLBACK_FAILED))
+    err = svn_error_compose_create(err, svn_fs_fs__close_rep_cache(fs));
+
+  return svn_error_trace(err);
+}
+
+/* State of the worker threads that collect the reps of revision chunks
+   ahead of the one currently being written to the rep-cache.  Only the
+   thread running svn_fs_fs__build_rep_cache() writes to the database. */
+typedef struct rep_cache_builder_t rep_cache_builder_t;
+
+#if APR_HAS_THREADS
+
+/* Number of chunks per worker thread that may be collected ahead of the
+   oldest one not written yet. */
+#define BUILD_WINDOW_PER_THREAD 2
+
+/* Check for cancellation that often while waiting for a worker. */
+#define BUILD_WAIT_INTERVAL apr_time_from_msec(100)
+
+/* Reps collected for a single chunk in a worker thread. */
+typedef struct build_job_t
+{
+  /* The chunk that has been collected. */
+  apr_int64_t chunk;
+
+  /* The representation_t collected, allocated in POOL. */
+  apr_array_header_t *reps;
+
+  /* Root pool owned by whoever holds the job. */
+  apr_pool_t *pool;
+
+  /* The error returned by collect_reps(). */
+  svn_error_t *err;
+} build_job_t;
+
+/* Per-thread data of a build worker. */
+typedef struct build_worker_t
+{
+  /* The shared state. */
+  rep_cache_builder_t *builder;
+
+  /* Private filesystem instance. */
+  svn_fs_t *fs;
+
+  /* Root pool used only by this thread. */
+  apr_pool_t *pool;
+
+  /* The thread itself. */
+  apr_thread_t *thread;
+} build_worker_t;
+
+struct rep_cache_builder_t
+{
+  /* Protects NEXT_CHUNK, FIRST_CHUNK, JOBS and DONE.  Used with COND. */
+  svn_mutex__t *mutex;
+
+  /* Signaled whenever a job completes, a worker terminates or a chunk
+     has been written. */
+  apr_thread_cond_t *cond;
+
+  /* The next chunk to be claimed by a worker. */
+  apr_int64_t next_chunk;
+
+  /* The oldest chunk that has not been written yet. */
+  apr_int64_t first_chunk;
+
+  /* One past the last chunk. */
+  apr_int64_t end_chunk;
+
+  /* Chunk 0 starts at START_REV.  Each covers CHUNK_SIZE revisions,
+     up to END_REV.  Read-only. */
+  svn_revnum_t start_rev;
+  svn_revnum_t end_rev;
+  int chunk_size;
+
+  /* Completed jobs, indexed by chunk modulo MAX_JOBS.  Workers don't
+     claim chunks MAX_JOBS or more ahead of FIRST_CHUNK. */
+  build_job_t *jobs;
+  svn_boolean_t *done;
+  int max_jobs;
+
+  /* Number of worker threads that have not terminated yet. */
+  volatile svn_atomic_t running;
+
+  /* Non-zero once the workers shall stop. */
+  volatile svn_atomic_t aborted;
+
+  /* All worker threads. */
+  build_worker_t *workers;
+  int worker_count;
+};
+
+/* Implements svn_cancel_func_t for the rep_cache_builder_t BATON.
+   Workers must not call the caller's cancellation function. */
+static svn_error_t *
+check_build_aborted(void *baton)
+{
+  rep_cache_builder_t *builder = baton;
+
+  if (svn_atomic_read(&builder->aborted))
+    return svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *CHUNK to the next chunk to collect for BUILDER.  Wait until it is
+   within the job window.  Set it to -1 if there is nothing left to do. */
+static svn_error_t *
+claim_chunk(apr_int64_t *chunk,
+            rep_cache_builder_t *builder)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+
+  SVN_ERR(svn_mutex__lock(builder->mutex));
+
+  /* This loop implicitly handles spurious wake-ups. */
+  while (!svn_atomic_read(&builder->aborted)
+         && builder->next_chunk < builder->end_chunk
+         && builder->next_chunk - builder->first_chunk >= builder->max_jobs)
+    {
+      apr_status_t status
+        = apr_thread_cond_wait(builder->cond, svn_mutex__get(builder->mutex));
+      if (status)
+        {
+          err = svn_error_wrap_apr(status,
+                                   _("Can't wait for condition variable"));
+          break;
+        }
+    }
+
+  if (err
+      || svn_atomic_read(&builder->aborted)
+      || builder->next_chunk >= builder->end_chunk)
+    *chunk = -1;
+  else
+    *chunk = builder->next_chunk++;
+
+  return svn_error_trace(svn_mutex__unlock(builder->mutex, err));
+}
+
+/* Thread function.  Collect reps for the build_worker_t given by DATA
+   until there are no more chunks or building got aborted. */
+static void * APR_THREAD_FUNC
+build_thread(apr_thread_t *tid,
+             void *data)
+{
+  build_worker_t *worker = data;
+  rep_cache_builder_t *builder = worker->builder;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  while (!err)
+    {
+      apr_int64_t chunk;
+      build_job_t job;
+      svn_revnum_t first;
+      int slot;
+
+      err = claim_chunk(&chunk, builder);
+      if (err || chunk < 0)
+        break;
+
+      first = builder->start_rev + (svn_revnum_t)chunk * builder->chunk_size;
+      job.chunk = chunk;
+      job.pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+      job.reps = apr_array_make(job.pool, 16, sizeof(representation_t));
+      job.err = collect_reps(job.reps, worker->fs, first,
+                             MIN(first + builder->chunk_size - 1,
+                                 builder->end_rev),
+                             check_build_aborted, builder, worker->pool);
+
+      /* Once claimed, the main thread waits for this chunk.  So, hand it
+         over even if we could not get the lock. */
+      err = svn_mutex__lock(builder->mutex);
+      slot = (int)(chunk % builder->max_jobs);
+      builder->jobs[slot] = job;
+      builder->done[slot] = TRUE;
+      if (!err)
+        {
+          apr_thread_cond_broadcast(builder->cond);
+          err = svn_mutex__unlock(builder->mutex, SVN_NO_ERROR);
+        }
+    }
+
+  svn_error_clear(err);
+
+  /* Chunks that no worker is left for will be collected by the main
+     thread. */
+  err = svn_mutex__lock(builder->mutex);
+  svn_atomic_dec(&builder->running);
+  if (!err)
+    {
+      apr_thread_cond_broadcast(builder->cond);
+      err = svn_mutex__unlock(builder->mutex, SVN_NO_ERROR);
+    }
+
+  svn_error_clear(err);
+
+  return NULL;
+}
+
+/* Wait for the worker threads of BUILDER to collect the reps of CHUNK,
+   which is the oldest chunk not written yet.  Check for cancellation
+   through CANCEL_FUNC and CANCEL_BATON periodically.  If no worker is
+   left to collect CHUNK, set *JOB to NULL.  Otherwise, set it to the
+   completed job, which the caller then owns, and return its error. */
+static svn_error_t *
+wait_for_chunk(build_job_t **job,
+               rep_cache_builder_t *builder,
+               apr_int64_t chunk,
+               svn_cancel_func_t cancel_func,
+               void *cancel_baton,
+               apr_pool_t *result_pool)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+  int slot = (int)(chunk % builder->max_jobs);
+
+  *job = NULL;
+  SVN_ERR(svn_mutex__lock(builder->mutex));
+
+  while (!builder->done[slot] && svn_atomic_read(&builder->running))
+    {
+      apr_status_t status;
+
+      if (cancel_func)
+        {
+          err = cancel_func(cancel_baton);
+          if (err)
+            break;
+        }
+
+      status = apr_thread_cond_timedwait(builder->cond,
+                                         svn_mutex__get(builder->mutex),
+                                         BUILD_WAIT_INTERVAL);
+      if (status && !APR_STATUS_IS_TIMEUP(status))
+        {
+          err = svn_error_wrap_apr(status,
+                                   _("Can't wait for condition variable"));
+          break;
+        }
+    }
+
+  if (!err)
+    {
+      if (builder->done[slot])
+        {
+          SVN_ERR_ASSERT_NO_RETURN(builder->jobs[slot].chunk == chunk);
+          *job = apr_pmemdup(result_pool, &builder->jobs[slot],
+                             sizeof(**job));
+          err = (*job)->err;
+          (*job)->err = SVN_NO_ERROR;
+          builder->done[slot] = FALSE;
+        }
+
+      /* Free the slot for the next chunk. */
+      builder->first_chunk = chunk + 1;
+      apr_thread_cond_broadcast(builder->cond);
+    }
+
+  return svn_error_trace(svn_mutex__unlock(builder->mutex, err));
+}
+
+/* Start up to JOBS worker threads in *BUILDER_P that collect the reps of
+   the chunks of CHUNK_SIZE revisions from START_REV to END_REV in FS.
+   Use POOL for the shared state. */
+static svn_error_t *
+start_rep_cache_builder(rep_cache_builder_t **builder_p,
+                        svn_fs_t *fs,
+                        svn_revnum_t start_rev,
+                        svn_revnum_t end_rev,
+                        int chunk_size,
+                        int jobs,
+                        apr_pool_t *pool)
+{
+  rep_cache_builder_t *builder = apr_pcalloc(pool, sizeof(*builder));
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_status_t status;
+  int i;
+
+  SVN_ERR(svn_mutex__init(&builder->mutex, TRUE, pool));
+  status = apr_thread_cond_create(&builder->cond, pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create condition variable"));
+
+  builder->start_rev = start_rev;
+  builder->end_rev = end_rev;
+  builder->chunk_size = chunk_size;
+  builder->end_chunk = (end_rev - start_rev) / chunk_size + 1;
+  if (builder->end_chunk < jobs)
+    jobs = (int)builder->end_chunk;
+
+  builder->max_jobs = jobs * BUILD_WINDOW_PER_THREAD;
+  builder->jobs = apr_pcalloc(pool,
+                              builder->max_jobs * sizeof(*builder->jobs));
+  builder->done = apr_pcalloc(pool,
+                              builder->max_jobs * sizeof(*builder->done));
+  builder->workers = apr_pcalloc(pool, jobs * sizeof(*builder->workers));
+
+  for (i = 0; i < jobs; i++)
+    {
+      build_worker_t *worker = &builder->workers[builder->worker_count];
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+
+      worker->builder = builder;
+      worker->pool
+        = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+
+      /* FS objects must not be shared between threads.  Leave the work
+         to the other workers or to the main thread if we can't get one. */
+      err = svn_fs_fs__open_instance(&worker->fs, fs, worker->pool,
+                                     iterpool);
+      if (!err)
+        {
+          svn_atomic_inc(&builder->running);
+          status = apr_thread_create(&worker->thread, NULL, build_thread,
+                                     worker, worker->pool);
+          if (status)
+            svn_atomic_dec(&builder->running);
+          else
+            builder->worker_count++;
+        }
+
+      if (err || status)
+        {
+          svn_error_clear(err);
+          svn_pool_destroy(worker->pool);
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  *builder_p = builder;
+
+  return SVN_NO_ERROR;
+}
+
+/* Stop all worker threads of BUILDER and discard their results. */
+static svn_error_t *
+stop_rep_cache_builder(rep_cache_builder_t *builder)
+{
+  svn_error_t *err;
+  int i;
+
+  svn_atomic_set(&builder->aborted, TRUE);
+  err = svn_mutex__lock(builder->mutex);
+  apr_thread_cond_broadcast(builder->cond);
+  err = svn_mutex__unlock(builder->mutex, err);
+
+  for (i = 0; i < builder->worker_count; i++)
+    {
+      apr_status_t retval;
+      apr_status_t status = apr_thread_join(&retval,
+                                            builder->workers[i].thread);
+      if (status)
+        err = svn_error_compose_create(
+                err, svn_error_wrap_apr(status,
+                                        _("Can't join rep-cache thread")));
+
+      svn_pool_destroy(builder->workers[i].pool);
+    }
+
+  for (i = 0; i < builder->max_jobs; i++)
+    if (builder->done[i])
+      {
+        svn_error_clear(builder->jobs[i].err);
+        svn_pool_destroy(builder->jobs[i].pool);
+      }
+
+  return svn_error_trace(err);
+}
+
+#endif /* APR_HAS_THREADS */
+
+svn_error_t *
+svn_fs_fs__build_rep_cache(svn_fs_t *fs,
+                           svn_revnum_t start_rev,
+                           svn_revnum_t end_rev,
+                           int jobs,
+                           svn_fs_progress_notify_func_t progress_func,
+                           void *progress_baton,
+                           svn_cancel_func_t cancel_func,
+                           void *cancel_baton,
+                           apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  rep_cache_builder_t *builder = NULL;
+  apr_pool_t *iterpool;
+  apr_int64_t chunk, end_chunk;
+  int chunk_size = ffd->max_files_per_dir ? ffd->max_files_per_dir
+                                          : BUILD_CHUNK_SIZE;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  if (!ffd->rep_sharing_allowed)
+    return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                            _("Representation sharing is not enabled for "
+                              "this filesystem"));
+
+  SVN_ERR(svn_fs_fs__ensure_revision_exists(end_rev, fs, pool));
+  if (start_rev > end_rev)
+    return svn_error_createf(SVN_ERR_FS_NO_SUCH_REVISION, NULL,
+                             _("Invalid revision range %ld:%ld"),
+                             start_rev, end_rev);
+
+  SVN_ERR(svn_fs_fs__open_rep_cache(fs, pool));
+
+#if APR_HAS_THREADS
+  if (jobs > 1)
+    SVN_ERR(start_rep_cache_builder(&builder, fs, start_rev, end_rev,
+                                    chunk_size, jobs, pool));
+#endif
+
+  iterpool = svn_pool_create(pool);
+  end_chunk = (end_rev - start_rev) / chunk_size + 1;
+  for (chunk = 0; chunk < end_chunk && !err; ++chunk)
+    {
+      svn_revnum_t first = start_rev + (svn_revnum_t)chunk * chunk_size;
+      svn_revnum_t last = MIN(first + chunk_size - 1, end_rev);
+      apr_array_header_t *reps = NULL;
+      apr_pool_t *job_pool = NULL;
+      svn_revnum_t rev;
+
+      svn_pool_clear(iterpool);
+
+#if APR_HAS_THREADS
+      if (builder)
+        {
+          build_job_t *job;
+
+          err = wait_for_chunk(&job, builder, chunk, cancel_func,
+                               cancel_baton, iterpool);
+          if (job)
+            {
+              reps = job->reps;
+              job_pool = job->pool;
+            }
+        }
+#endif
+
+      /* Without a worker for it, collect the reps ourselves. */
+      if (reps == NULL && !err)
+        {
+          reps = apr_array_make(iterpool, 16, sizeof(representation_t));
+          err = collect_reps(reps, fs, first, last, cancel_func,
+                             cancel_baton, iterpool);
+        }
+
+      if (!err)
+        err = write_built_reps(fs, reps, iterpool);
+
+      if (job_pool)
+        svn_pool_destroy(job_pool);
+      if (err)
+        break;
+
+      if (progress_func)
+        for (rev = first; rev <= last; ++rev)
+          progress_func(rev, progress_baton, iterpool);
+    }
+
+#if APR_HAS_THREADS
+  if (builder)
+    err = svn_error_compose_create(err, stop_rep_cache_builder(builder));
+#endif
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(err);
 }
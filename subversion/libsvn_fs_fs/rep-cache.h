@@ -100,6 +100,24 @@ svn_fs_fs__with_rep_cache_lock(svn_fs_t *fs,
                                void *baton,
                                apr_pool_t *pool);
 
+/* Add the file contents and property representations of revisions
+   START_REV to END_REV of FS to its rep-cache, reading up to JOBS
+   revision ranges concurrently.  Call PROGRESS_FUNC with PROGRESS_BATON,
+   if given, for every revision after its reps have been added.  Use
+   POOL for temporary allocations.
+
+   This implements svn_fs_build_rep_cache(). */
+svn_error_t *
+svn_fs_fs__build_rep_cache(svn_fs_t *fs,
+                           svn_revnum_t start_rev,
+                           svn_revnum_t end_rev,
+                           int jobs,
+                           svn_fs_progress_notify_func_t progress_func,
+                           void *progress_baton,
+                           svn_cancel_func_t cancel_func,
+                           void *cancel_baton,
+                           apr_pool_t *pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
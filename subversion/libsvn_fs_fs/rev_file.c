@@ -28,7 +28,12 @@
 
 #include "../libsvn_fs/fs-loader.h"
 
+#include "svn_cache_config.h"
+#include "svn_pools.h"
+
+#include "private/svn_atomic.h"
 #include "private/svn_io_private.h"
+#include "private/svn_mutex.h"
 #include "svn_private_config.h"
 
 /* Initialize the *FILE structure for REVISION in filesystem FS.  Set its
@@ -55,6 +60,7 @@ init_revision_file(svn_fs_fs__revision_file_t *file,
   file->p2l_checksum = NULL;
   file->footer_offset = -1;
   file->pool = pool;
+  file->handle = NULL;
 }
 
 /* Baton type for set_read_only() */
@@ -120,6 +126,347 @@ auto_make_writable(const char *path,
   return SVN_NO_ERROR;
 }
 
+/* Process-wide cache of open pack file handles.
+ *
+ * Packed shards never change once they have been published.  Keeping
+ * their files open across svn_fs_t instances saves the open() and the
+ * footer parsing, which are expensive on network file systems.  Every
+ * handle is used by at most one svn_fs_fs__revision_file_t at a time,
+ * so file pointers and buffers are never shared.  Idle handles are kept
+ * in MRU order; at most svn_cache_config_t.FILE_HANDLE_COUNT of them.
+ *
+ * We only cache pack files of repositories that have an instance ID,
+ * i.e. which have been created after we started to support those.  The
+ * cache key includes that ID, so handles will never be used with a copy
+ * or re-creation of a repository at the same path.
+ */
+
+/* An open pack file plus its parsed footer and index streams.  All of it
+ * is allocated in POOL. */
+typedef struct file_handle_t
+{
+  /* Instance ID of the repository, followed by the file path. */
+  const char *key;
+
+  /* The root pool owning this handle. */
+  apr_pool_t *pool;
+
+  /* While in use, the pool that will return the handle upon cleanup. */
+  apr_pool_t *owner;
+
+  /* Open r/o pack file. */
+  apr_file_t *file;
+
+  /* Cached index streams and footer values, see
+   * svn_fs_fs__revision_file_t. */
+  svn_fs_fs__packed_number_stream_t *p2l_stream;
+  svn_fs_fs__packed_number_stream_t *l2p_stream;
+  apr_off_t l2p_offset;
+  svn_checksum_t *l2p_checksum;
+  apr_off_t p2l_offset;
+  svn_checksum_t *p2l_checksum;
+  apr_off_t footer_offset;
+
+  /* Value of the cache's GENERATION when this handle was opened. */
+  svn_atomic_t generation;
+
+  /* Next idle handle, i.e. the one used less recently than this one. */
+  struct file_handle_t *next;
+} file_handle_t;
+
+/* The process-wide handle cache. */
+typedef struct handle_cache_t
+{
+  /* Serializes all access to the members below. */
+  svn_mutex__t *mutex;
+
+  /* Idle handles, most recently used first. */
+  file_handle_t *idle;
+
+  /* Number of entries in IDLE. */
+  apr_size_t idle_count;
+
+  /* Incremented whenever pack files get opened for writing.  Handles from
+   * older generations will not be kept. */
+  volatile svn_atomic_t generation;
+} handle_cache_t;
+
+/* Initialization state and singleton instance of the handle cache. */
+static volatile svn_atomic_t handle_cache_init_state = 0;
+static handle_cache_t *handle_cache = NULL;
+
+/* Implements svn_atomic__err_init_func_t.  Create the global handle
+ * cache.  BATON and POOL are unused.
+ */
+static svn_error_t *
+init_handle_cache(void *baton,
+                  apr_pool_t *pool)
+{
+  /* The cache lives as long as the process. */
+  apr_pool_t *cache_pool = svn_pool_create(NULL);
+  handle_cache_t *cache = apr_pcalloc(cache_pool, sizeof(*cache));
+
+  SVN_ERR(svn_mutex__init(&cache->mutex, TRUE, cache_pool));
+  handle_cache = cache;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the handle cache or NULL if handles shall not be cached.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static handle_cache_t *
+get_handle_cache(apr_pool_t *scratch_pool)
+{
+  svn_error_t *err;
+
+  if (svn_cache_config_get()->file_handle_count == 0)
+    return NULL;
+
+  err = svn_atomic__init_once(&handle_cache_init_state, init_handle_cache,
+                              NULL, scratch_pool);
+  if (err)
+    {
+      /* Caching is only an optimization. */
+      svn_error_clear(err);
+      return NULL;
+    }
+
+  return handle_cache;
+}
+
+/* Return the cache key for the pack file at PATH in FS, allocated in
+ * RESULT_POOL.  Return NULL if its handles must not be cached.
+ */
+static const char *
+get_handle_key(svn_fs_t *fs,
+               const char *path,
+               apr_pool_t *result_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  if (ffd->format < SVN_FS_FS__MIN_INSTANCE_ID_FORMAT || !ffd->instance_id)
+    return NULL;
+
+  return apr_pstrcat(result_pool, ffd->instance_id, ":", path, SVN_VA_NULL);
+}
+
+/* Remove an idle handle for KEY from CACHE and return it in *HANDLE.
+ * Set *HANDLE to NULL if there is none.
+ */
+static svn_error_t *
+checkout_handle(file_handle_t **handle,
+                handle_cache_t *cache,
+                const char *key)
+{
+  file_handle_t **link;
+
+  SVN_ERR(svn_mutex__lock(cache->mutex));
+
+  *handle = NULL;
+  for (link = &cache->idle; *link; link = &(*link)->next)
+    if (strcmp((*link)->key, key) == 0)
+      {
+        *handle = *link;
+        *link = (*link)->next;
+        (*handle)->next = NULL;
+        cache->idle_count--;
+        break;
+      }
+
+  return svn_error_trace(svn_mutex__unlock(cache->mutex, SVN_NO_ERROR));
+}
+
+/* Return HANDLE to CACHE, closing it - or the least recently used idle
+ * handle - if the cache would exceed its capacity.
+ */
+static void
+checkin_handle(handle_cache_t *cache,
+               file_handle_t *handle)
+{
+  apr_size_t capacity = svn_cache_config_get()->file_handle_count;
+  file_handle_t *victims = NULL;
+  svn_error_t *err;
+
+  err = svn_mutex__lock(cache->mutex);
+  if (err)
+    {
+      svn_error_clear(err);
+      svn_pool_destroy(handle->pool);
+      return;
+    }
+
+  if (handle->generation != cache->generation || capacity == 0)
+    {
+      victims = handle;
+    }
+  else
+    {
+      handle->next = cache->idle;
+      cache->idle = handle;
+      cache->idle_count++;
+
+      /* Evict the least recently used handles. */
+      if (cache->idle_count > capacity)
+        {
+          file_handle_t *last = cache->idle;
+          apr_size_t i;
+
+          for (i = 1; i < capacity; ++i)
+            last = last->next;
+
+          victims = last->next;
+          last->next = NULL;
+          cache->idle_count = capacity;
+        }
+    }
+
+  svn_error_clear(svn_mutex__unlock(cache->mutex, SVN_NO_ERROR));
+
+  /* Close files outside the lock. */
+  while (victims)
+    {
+      file_handle_t *next = victims->next;
+      svn_pool_destroy(victims->pool);
+      victims = next;
+    }
+}
+
+/* Close all idle handles in CACHE and make sure that those currently in
+ * use will not be kept either.  This is necessary before modifying any
+ * pack file.
+ */
+static svn_error_t *
+purge_handle_cache(handle_cache_t *cache)
+{
+  file_handle_t *victims;
+
+  SVN_ERR(svn_mutex__lock(cache->mutex));
+
+  victims = cache->idle;
+  cache->idle = NULL;
+  cache->idle_count = 0;
+  svn_atomic_inc(&cache->generation);
+
+  SVN_ERR(svn_mutex__unlock(cache->mutex, SVN_NO_ERROR));
+
+  while (victims)
+    {
+      file_handle_t *next = victims->next;
+      svn_pool_destroy(victims->pool);
+      victims = next;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Hand the cached handle of FILE back to the handle cache and reset FILE.
+ */
+static void
+release_handle(svn_fs_fs__revision_file_t *file)
+{
+  file_handle_t *handle = file->handle;
+
+  /* Keep what has been read while we used the handle. */
+  handle->p2l_stream = file->p2l_stream;
+  handle->l2p_stream = file->l2p_stream;
+  handle->l2p_offset = file->l2p_offset;
+  handle->l2p_checksum = file->l2p_checksum;
+  handle->p2l_offset = file->p2l_offset;
+  handle->p2l_checksum = file->p2l_checksum;
+  handle->footer_offset = file->footer_offset;
+
+  file->handle = NULL;
+  file->file = NULL;
+  file->stream = NULL;
+  file->l2p_stream = NULL;
+  file->p2l_stream = NULL;
+
+  checkin_handle(handle_cache, handle);
+}
+
+/* APR pool cleanup handler returning the handle of the
+ * svn_fs_fs__revision_file_t given by DATA to the handle cache. */
+static apr_status_t
+release_handle_cleanup(void *data)
+{
+  svn_fs_fs__revision_file_t *file = data;
+  if (file->handle)
+    release_handle(file);
+
+  return APR_SUCCESS;
+}
+
+/* Set up FILE to use HANDLE.  Allocate the stream in RESULT_POOL and
+ * return the handle to the cache when RESULT_POOL gets cleaned up.
+ */
+static svn_error_t *
+use_handle(svn_fs_fs__revision_file_t *file,
+           file_handle_t *handle,
+           apr_pool_t *result_pool)
+{
+  apr_off_t offset = 0;
+
+  file->handle = handle;
+  file->file = handle->file;
+  file->stream = svn_stream_from_aprfile2(handle->file, TRUE, result_pool);
+  file->p2l_stream = handle->p2l_stream;
+  file->l2p_stream = handle->l2p_stream;
+  file->l2p_offset = handle->l2p_offset;
+  file->l2p_checksum = handle->l2p_checksum;
+  file->p2l_offset = handle->p2l_offset;
+  file->p2l_checksum = handle->p2l_checksum;
+  file->footer_offset = handle->footer_offset;
+  file->pool = handle->pool;
+
+  handle->owner = result_pool;
+  apr_pool_cleanup_register(result_pool, file, release_handle_cleanup,
+                            apr_pool_cleanup_null);
+
+  /* Behave like a freshly opened file. */
+  return svn_error_trace(svn_io_file_seek(handle->file, APR_SET, &offset,
+                                          handle->pool));
+}
+
+/* Open the pack file at PATH using a new handle for CACHE under KEY and
+ * return it in *HANDLE.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+open_handle(file_handle_t **handle,
+            handle_cache_t *cache,
+            const char *key,
+            const char *path,
+            apr_pool_t *scratch_pool)
+{
+  apr_pool_t *pool
+    = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  file_handle_t *result = apr_pcalloc(pool, sizeof(*result));
+  svn_error_t *err;
+
+  result->pool = pool;
+  result->key = apr_pstrdup(pool, key);
+  result->l2p_offset = -1;
+  result->p2l_offset = -1;
+  result->footer_offset = -1;
+
+  /* Reading the generation without the lock is fine.  We only need to
+   * make sure not to see the new value before any pack file that we
+   * might open got modified. */
+  result->generation = svn_atomic_read(&cache->generation);
+
+  err = svn_io_file_open(&result->file, path, APR_READ | APR_BUFFERED,
+                         APR_OS_DEFAULT, pool);
+  if (err)
+    {
+      svn_pool_destroy(pool);
+      return svn_error_trace(err);
+    }
+
+  *handle = result;
+
+  return SVN_NO_ERROR;
+}
+
 /* Core implementation of svn_fs_fs__open_pack_or_rev_file working on an
  * existing, initialized FILE structure.  If WRITABLE is TRUE, give write
  * access to the file - temporarily resetting the r/o state if necessary.
@@ -133,25 +480,52 @@ open_pack_or_rev_file(svn_fs_fs__revision_file_t *file,
                       apr_pool_t *scratch_pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
+  handle_cache_t *cache = ffd->use_log_addressing
+                        ? get_handle_cache(scratch_pool)
+                        : NULL;
   svn_error_t *err;
   svn_boolean_t retry = FALSE;
 
+  /* Cached handles must not outlive modifications to their files. */
+  if (cache && writable)
+    SVN_ERR(purge_handle_cache(cache));
+
   do
     {
       const char *path = svn_fs_fs__path_rev_absolute(fs, rev, scratch_pool);
+      const char *key = NULL;
       apr_file_t *apr_file;
       apr_int32_t flags = writable
                         ? APR_READ | APR_WRITE | APR_BUFFERED
                         : APR_READ | APR_BUFFERED;
 
-      /* We may have to *temporarily* enable write access. */
-      err = writable ? auto_make_writable(path, result_pool, scratch_pool)
-                     : SVN_NO_ERROR;
+      /* Pack files are immutable and may be shared between instances. */
+      if (cache && !writable && svn_fs_fs__is_packed_rev(fs, rev))
+        key = get_handle_key(fs, path, scratch_pool);
 
-      /* open the revision file in buffered r/o or r/w mode */
-      if (!err)
-        err = svn_io_file_open(&apr_file, path, flags, APR_OS_DEFAULT,
-                               result_pool);
+      if (key)
+        {
+          file_handle_t *handle;
+          SVN_ERR(checkout_handle(&handle, cache, key));
+          err = handle ? SVN_NO_ERROR
+                       : open_handle(&handle, cache, key, path, scratch_pool);
+          if (!err)
+            {
+              file->is_packed = TRUE;
+              return svn_error_trace(use_handle(file, handle, result_pool));
+            }
+        }
+      else
+        {
+          /* We may have to *temporarily* enable write access. */
+          err = writable ? auto_make_writable(path, result_pool, scratch_pool)
+                         : SVN_NO_ERROR;
+
+          /* open the revision file in buffered r/o or r/w mode */
+          if (!err)
+            err = svn_io_file_open(&apr_file, path, flags, APR_OS_DEFAULT,
+                                   result_pool);
+        }
 
       if (!err)
         {
@@ -199,6 +573,16 @@ open_pack_or_rev_file(svn_fs_fs__revision_file_t *file,
   return svn_error_trace(err);
 }
 
+svn_error_t *
+svn_fs_fs__purge_file_handles(void)
+{
+  /* Don't create the cache just to find it empty. */
+  if (handle_cache)
+    SVN_ERR(purge_handle_cache(handle_cache));
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__open_pack_or_rev_file(svn_fs_fs__revision_file_t **file,
                                  svn_fs_t *fs,
@@ -267,19 +651,16 @@ svn_fs_fs__auto_read_footer(svn_fs_fs__revision_file_t *file)
   return SVN_NO_ERROR;
 }
 
-svn_error_t *
-svn_fs_fs__open_proto_rev_file(svn_fs_fs__revision_file_t **file,
-                               svn_fs_t *fs,
-                               const svn_fs_fs__id_part_t *txn_id,
-                               apr_pool_t* result_pool,
-                               apr_pool_t *scratch_pool)
+/* Open the transaction data file at PATH for reading and return it in
+ * *FILE, allocated in RESULT_POOL. */
+static svn_error_t *
+open_txn_file(svn_fs_fs__revision_file_t **file,
+              const char *path,
+              apr_pool_t *result_pool)
 {
   apr_file_t *apr_file;
-  SVN_ERR(svn_io_file_open(&apr_file,
-                           svn_fs_fs__path_txn_proto_rev(fs, txn_id,
-                                                         scratch_pool),
-                           APR_READ | APR_BUFFERED, APR_OS_DEFAULT,
-                           result_pool));
+  SVN_ERR(svn_io_file_open(&apr_file, path, APR_READ | APR_BUFFERED,
+                           APR_OS_DEFAULT, result_pool));
 
   *file = apr_pcalloc(result_pool, sizeof(**file));
   (*file)->file = apr_file;
@@ -290,9 +671,41 @@ svn_fs_fs__open_proto_rev_file(svn_fs_fs__revision_file_t **file,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__open_proto_rev_file(svn_fs_fs__revision_file_t **file,
+                               svn_fs_t *fs,
+                               const svn_fs_fs__id_part_t *txn_id,
+                               apr_pool_t* result_pool,
+                               apr_pool_t *scratch_pool)
+{
+  const char *path = svn_fs_fs__path_txn_proto_rev(fs, txn_id, scratch_pool);
+  return svn_error_trace(open_txn_file(file, path, result_pool));
+}
+
+svn_error_t *
+svn_fs_fs__open_proto_rev_fragment(svn_fs_fs__revision_file_t **file,
+                                   const char *path,
+                                   apr_pool_t *result_pool)
+{
+  return svn_error_trace(open_txn_file(file, path, result_pool));
+}
+
 svn_error_t *
 svn_fs_fs__close_revision_file(svn_fs_fs__revision_file_t *file)
 {
+  /* Cached handles stay open.  Hand them back for the next user. */
+  if (file->handle)
+    {
+      if (file->stream)
+        SVN_ERR(svn_stream_close(file->stream));
+
+      apr_pool_cleanup_kill(file->handle->owner, file,
+                            release_handle_cleanup);
+      release_handle(file);
+
+      return SVN_NO_ERROR;
+    }
+
   if (file->stream)
     SVN_ERR(svn_stream_close(file->stream));
   if (file->file)
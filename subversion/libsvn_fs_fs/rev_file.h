@@ -92,6 +92,11 @@ typedef struct svn_fs_fs__revision_file_t
 
   /* pool containing this object */
   apr_pool_t *pool;
+
+  /* If not NULL, FILE has been taken from the process-wide handle cache
+   * and will be returned to it upon close.  POOL is the handle's pool
+   * then, such that the index streams and footer info can be reused. */
+  struct file_handle_t *handle;
 } svn_fs_fs__revision_file_t;
 
 /* Open the correct revision file for REV.  If the filesystem FS has
@@ -137,9 +142,25 @@ svn_fs_fs__open_proto_rev_file(svn_fs_fs__revision_file_t **file,
                                apr_pool_t* result_pool,
                                apr_pool_t *scratch_pool);
 
-/* Close all files and streams in FILE.
+/* Open the proto-rev fragment file at PATH and return it in *FILE.
+ * The representation in it starts at offset 0.  Allocate *FILE in
+ * RESULT_POOL. */
+svn_error_t *
+svn_fs_fs__open_proto_rev_fragment(svn_fs_fs__revision_file_t **file,
+                                   const char *path,
+                                   apr_pool_t *result_pool);
+
+/* Close all files and streams in FILE.  If FILE uses a cached pack file
+ * handle, that handle is returned to the process-wide cache instead.
  */
 svn_error_t *
 svn_fs_fs__close_revision_file(svn_fs_fs__revision_file_t *file);
 
+/* Close all idle pack file handles in the process-wide cache and make
+ * sure that those currently in use will be closed upon release.  Call this
+ * before deleting or replacing a repository.
+ */
+svn_error_t *
+svn_fs_fs__purge_file_handles(void);
+
 #endif
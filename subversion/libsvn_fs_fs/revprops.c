@@ -21,6 +21,7 @@
  */
 
 #include <assert.h>
+#include <apr_mmap.h>
 
 #include "svn_pools.h"
 #include "svn_hash.h"
@@ -196,11 +197,12 @@ parse_revprop(apr_hash_t **properties,
               apr_pool_t *result_pool,
               apr_pool_t *scratch_pool)
 {
-  svn_stream_t *stream = svn_stream_from_string(content, scratch_pool);
+  /* The parsed keys and values will point into this copy. */
+  char *data = apr_pmemdup(result_pool, content->data, content->len);
   *properties = apr_hash_make(result_pool);
 
-  SVN_ERR_W(svn_hash_read2(*properties, stream, SVN_HASH_TERMINATOR,
-                           result_pool),
+  SVN_ERR_W(svn_hash__parse(*properties, data, content->len,
+                            SVN_HASH_TERMINATOR, result_pool),
             apr_psprintf(scratch_pool, "Failed to parse revprops for r%ld.",
                          revision));
 
@@ -308,13 +310,49 @@ get_min_filename_len(packed_revprops_t *revprops)
   return svn__i64toa(number_buffer, revprops->manifest_start) + 2;
 }
 
+/* Maximum number of packed revprop manifests that we keep in
+ * fs_fs_data_t.REVPROP_MANIFESTS before starting over. */
+#define MAX_CACHED_REVPROP_MANIFESTS 64
+
+/* Return the hash of manifests cached in FS for the current revprop cache
+ * prefix, starting over if it has been invalidated or grown too large.
+ */
+static apr_hash_t *
+get_revprop_manifests(svn_fs_t *fs)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  if (   ffd->revprop_manifests == NULL
+      || ffd->revprop_manifests_prefix != ffd->revprop_prefix
+      || apr_hash_count(ffd->revprop_manifests)
+           >= MAX_CACHED_REVPROP_MANIFESTS)
+    {
+      if (ffd->revprop_manifests_pool)
+        svn_pool_clear(ffd->revprop_manifests_pool);
+      else
+        ffd->revprop_manifests_pool = svn_pool_create(fs->pool);
+
+      ffd->revprop_manifests = svn_hash__make(ffd->revprop_manifests_pool);
+      ffd->revprop_manifests_prefix = ffd->revprop_prefix;
+    }
+
+  return ffd->revprop_manifests;
+}
+
 /* Given FS and REVPROPS->REVISION, fill the FILENAME, FOLDER and MANIFEST
  * members. Use RESULT_POOL for allocating results and SCRATCH_POOL for
  * temporaries.
+ *
+ * If USE_CACHE is set, the revprop cache must have been prepared.  Then,
+ * take the manifest from FS' per-shard manifest cache if READ_CACHED is
+ * set as well and update the cache after reading it from disk.  Cached
+ * manifests are shared and must not be modified.
  */
 static svn_error_t *
 get_revprop_packname(svn_fs_t *fs,
                      packed_revprops_t *revprops,
+                     svn_boolean_t use_cache,
+                     svn_boolean_t read_cached,
                      apr_pool_t *result_pool,
                      apr_pool_t *scratch_pool)
 {
@@ -325,6 +363,8 @@ get_revprop_packname(svn_fs_t *fs,
   char *buffer, *buffer_end;
   const char **filenames, **filenames_end;
   apr_size_t min_filename_len;
+  apr_hash_t *manifests = NULL;
+  apr_int64_t shard = revprops->revision / ffd->max_files_per_dir;
 
   /* Determine the dimensions. Rev 0 is excluded from the first shard. */
   rev_count = ffd->max_files_per_dir;
@@ -336,6 +376,31 @@ get_revprop_packname(svn_fs_t *fs,
       --rev_count;
     }
 
+  revprops->folder
+    = svn_fs_fs__path_revprops_pack_shard(fs, revprops->revision,
+                                          result_pool);
+
+  /* Parsing the manifest is expensive compared to reading a single
+   * revision's revprops from the pack file.  Re-use it when we can. */
+  if (use_cache)
+    {
+      SVN_ERR_ASSERT(ffd->revprop_prefix);
+      manifests = get_revprop_manifests(fs);
+      if (read_cached)
+        revprops->manifest = apr_hash_get(manifests, &shard, sizeof(shard));
+
+      if (revprops->manifest)
+        {
+          idx = (int)(revprops->revision - revprops->manifest_start);
+          revprops->filename = APR_ARRAY_IDX(revprops->manifest, idx,
+                                             const char*);
+          return SVN_NO_ERROR;
+        }
+
+      /* The manifest will be added to the cache. */
+      result_pool = ffd->revprop_manifests_pool;
+    }
+
   revprops->manifest = apr_array_make(result_pool, rev_count,
                                       sizeof(const char*));
 
@@ -343,11 +408,8 @@ get_revprop_packname(svn_fs_t *fs,
   min_filename_len = get_min_filename_len(revprops);
 
   /* Read the content of the manifest file */
-  revprops->folder
-    = svn_fs_fs__path_revprops_pack_shard(fs, revprops->revision,
-                                          result_pool);
   manifest_file_path
-    = svn_dirent_join(revprops->folder, PATH_MANIFEST, result_pool);
+    = svn_dirent_join(revprops->folder, PATH_MANIFEST, scratch_pool);
 
   SVN_ERR(svn_fs_fs__read_content(&content, manifest_file_path, result_pool));
 
@@ -411,6 +473,11 @@ get_revprop_packname(svn_fs_t *fs,
   /* The target array has now exactly one entry per revision. */
   revprops->manifest->nelts = rev_count;
 
+  if (manifests)
+    apr_hash_set(manifests,
+                 apr_pmemdup(result_pool, &shard, sizeof(shard)),
+                 sizeof(shard), revprops->manifest);
+
   /* Now get the file name */
   idx = (int)(revprops->revision - revprops->manifest_start);
   revprops->filename = APR_ARRAY_IDX(revprops->manifest, idx, const char*);
@@ -562,6 +629,58 @@ parse_packed_revprops(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
+/* Like svn_fs_fs__try_stringbuf_from_file but map the file at PATH into
+ * memory, if supported.  The resulting *CONTENT is read-only and must not
+ * be modified or resized.  It remains valid as long as POOL exists.
+ */
+static svn_error_t *
+try_map_file(svn_stringbuf_t **content,
+             svn_boolean_t *missing,
+             const char *path,
+             svn_boolean_t last_attempt,
+             apr_pool_t *pool)
+{
+#if APR_HAS_MMAP
+  apr_file_t *file;
+  apr_finfo_t finfo;
+  apr_mmap_t *mmap;
+  svn_error_t *err;
+
+  /* Pack files never get modified in place.  Thus, we may keep them
+   * mapped for as long as we like. */
+  err = svn_io_file_open(&file, path, APR_READ | APR_BINARY, APR_OS_DEFAULT,
+                         pool);
+  if (!err)
+    err = svn_io_file_info_get(&finfo, APR_FINFO_SIZE, file, pool);
+
+  if (   !err
+      && finfo.size > 0
+      && finfo.size <= APR_SIZE_MAX
+      && apr_mmap_create(&mmap, file, 0, (apr_size_t)finfo.size,
+                         APR_MMAP_READ, pool) == APR_SUCCESS)
+    {
+      *content = apr_pcalloc(pool, sizeof(**content));
+      (*content)->data = mmap->mm;
+      (*content)->len = (apr_size_t)finfo.size;
+      (*content)->blocksize = (*content)->len;
+      (*content)->pool = pool;
+
+      if (missing)
+        *missing = FALSE;
+
+      return SVN_NO_ERROR;
+    }
+
+  /* Let the default file reader handle all special cases and errors. */
+  svn_error_clear(err);
+#endif
+
+  return svn_error_trace(svn_fs_fs__try_stringbuf_from_file(content, missing,
+                                                            path,
+                                                            last_attempt,
+                                                            pool));
+}
+
 /* In filesystem FS, read the packed revprops for revision REV into
  * *REVPROPS. Populate the revprop cache, if POPULATE_CACHE is set.
  * If you want to modify revprop contents / update REVPROPS, READ_ALL
@@ -582,6 +701,10 @@ read_pack_revprop(packed_revprops_t **revprops,
   packed_revprops_t *result;
   int i;
 
+  /* Callers that modify the revprops need a private copy of the manifest.
+   * Also, don't trust cached manifests across sync barriers. */
+  svn_boolean_t use_manifest_cache = populate_cache && !read_all;
+
   /* someone insisted that REV is packed. Double-check if necessary */
   if (!svn_fs_fs__is_packed_revprop(fs, rev))
      SVN_ERR(svn_fs_fs__update_min_unpacked_rev(fs, iterpool));
@@ -606,15 +729,17 @@ read_pack_revprop(packed_revprops_t **revprops,
       /* there might have been concurrent writes.
        * Re-read the manifest and the pack file.
        */
-      SVN_ERR(get_revprop_packname(fs, result, pool, iterpool));
+      SVN_ERR(get_revprop_packname(fs, result, use_manifest_cache, i == 0,
+                                   pool, iterpool));
       file_path  = svn_dirent_join(result->folder,
                                    result->filename,
                                    iterpool);
-      SVN_ERR(svn_fs_fs__try_stringbuf_from_file(&result->packed_revprops,
-                                &missing,
-                                file_path,
-                                i + 1 < SVN_FS_FS__RECOVERABLE_RETRY_COUNT,
-                                pool));
+
+      /* The pack file contents is only needed until it has been parsed,
+       * so map it into ITERPOOL. */
+      SVN_ERR(try_map_file(&result->packed_revprops, &missing, file_path,
+                           i + 1 < SVN_FS_FS__RECOVERABLE_RETRY_COUNT,
+                           iterpool));
     }
 
   /* the file content should be available now */
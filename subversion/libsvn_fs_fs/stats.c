@@ -20,12 +20,17 @@
  * ====================================================================
  */
 
+#include <apr_thread_proc.h>
+#include <apr_thread_cond.h>
+
 #include "svn_dirent_uri.h"
 #include "svn_fs.h"
 #include "svn_pools.h"
 #include "svn_sorts.h"
 
+#include "private/svn_atomic.h"
 #include "private/svn_cache.h"
+#include "private/svn_mutex.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_string_private.h"
 #include "private/svn_fs_fs_private.h"
@@ -164,9 +169,63 @@ typedef struct revision_info_t
   svn_fs_fs__revision_file_t *rev_file;
 } revision_info_t;
 
-/* Root data structure containing all information about a given repository.
- * We use it as a wrapper around svn_fs_t and pass it around where we would
- * otherwise just use a svn_fs_t.
+/* Identifies a representation independently of any rev / pack file
+ * contents.  Used as hash key, hence the padding-free layout. */
+typedef struct rep_key_t
+{
+  /* Revision that contains this representation. */
+  apr_int64_t revision;
+
+  /* Item index of this rep within REVISION. */
+  apr_uint64_t item_index;
+} rep_key_t;
+
+/* A noderev referencing a representation that has been created outside
+ * the batch of revisions that contains the noderev.  The representation
+ * itself gets accounted for by the batch that contains it.  We only need
+ * to count the additional reference when merging the batch results. */
+typedef struct foreign_ref_t
+{
+  /* The representation being referenced. */
+  rep_key_t key;
+
+  /* item length in bytes */
+  apr_uint64_t size;
+
+  /* item length after de-deltification */
+  apr_uint64_t expanded_size;
+
+  /* classification of the representation as seen by the referencing
+   * noderev. values of rep_kind_t */
+  char kind;
+} foreign_ref_t;
+
+/* Number of entries in a chain_cache_entry_t array.  Must be a power of 2.
+ */
+#define CHAIN_CACHE_SIZE 0x10000
+
+/* Entry in the direct-mapped cache of delta chain lengths of
+ * representations outside the batch currently being read.
+ */
+typedef struct chain_cache_entry_t
+{
+  /* Representation of this entry.  REVISION is SVN_INVALID_REVNUM for
+   * unused entries. */
+  rep_key_t key;
+
+  /* length of the delta chain, including this representation,
+   * saturated to 255 - if need be */
+  apr_byte_t chain_length;
+} chain_cache_entry_t;
+
+/* Root data structure containing all information about the batch of
+ * revisions currently being read.  We use it as a wrapper around svn_fs_t
+ * and pass it around where we would otherwise just use a svn_fs_t.
+ *
+ * A batch is either a single pack file or the non-packed revisions of a
+ * single shard.  Each batch is read independently of all others, which
+ * allows us to process them in parallel and to discard all per-rep data
+ * once the batch results have been merged.
  */
 typedef struct query_t
 {
@@ -182,9 +241,20 @@ typedef struct query_t
   /* First non-packed revision. */
   svn_revnum_t min_unpacked_rev;
 
-  /* all revisions */
+  /* First revision of the batch.  References to representations in older
+   * revisions will be collected in FOREIGN_REFS. */
+  svn_revnum_t start_rev;
+
+  /* all revisions of the batch, starting at START_REV */
   apr_array_header_t *revisions;
 
+  /* foreign_ref_t for all references to reps before START_REV */
+  apr_array_header_t *foreign_refs;
+
+  /* Delta chain lengths of representations outside this batch.
+   * CHAIN_CACHE_SIZE entries. */
+  chain_cache_entry_t *chain_cache;
+
   /* empty representation.
    * Used as a dummy base for DELTA reps without base. */
   rep_stats_t *null_base;
@@ -192,12 +262,6 @@ typedef struct query_t
   /* collected statistics */
   svn_fs_fs__stats_t *stats;
 
-  /* Progress notification callback to call after each shard.  May be NULL. */
-  svn_fs_progress_notify_func_t progress_func;
-
-  /* Baton for PROGRESS_FUNC. */
-  void *progress_baton;
-
   /* Cancellation support callback to call once in a while.  May be NULL. */
   svn_cancel_func_t cancel_func;
 
@@ -255,6 +319,60 @@ add_to_histogram(svn_fs_fs__histogram_t *histogram,
   histogram->lines[(apr_size_t)shift].sum += size;
 }
 
+/* Add SIZE, REVISION and PATH to LARGEST_CHANGES, if SIZE is large enough.
+ */
+static void
+add_to_largest_changes(svn_fs_fs__largest_changes_t *largest_changes,
+                       apr_uint64_t size,
+                       svn_revnum_t revision,
+                       const char *path)
+{
+  apr_size_t i;
+  svn_fs_fs__large_change_info_t *info;
+
+  if (size < largest_changes->min_size)
+    return;
+
+  info = largest_changes->changes[largest_changes->count - 1];
+  info->size = size;
+  info->revision = revision;
+  svn_stringbuf_set(info->path, path);
+
+  /* linear insertion but not too bad since count is low and insertions
+   * near the end are more likely than close to front */
+  for (i = largest_changes->count - 1; i > 0; --i)
+    if (largest_changes->changes[i-1]->size >= size)
+      break;
+    else
+      largest_changes->changes[i] = largest_changes->changes[i-1];
+
+  largest_changes->changes[i] = info;
+  largest_changes->min_size
+    = largest_changes->changes[largest_changes->count-1]->size;
+}
+
+/* Return the entry for EXTENSION in STATS, auto-inserting it if necessary.
+ */
+static svn_fs_fs__extension_info_t *
+get_extension_info(svn_fs_fs__stats_t *stats,
+                   const char *extension)
+{
+  svn_fs_fs__extension_info_t *info
+    = apr_hash_get(stats->by_extension, extension, APR_HASH_KEY_STRING);
+
+  if (info == NULL)
+    {
+      apr_pool_t *pool = apr_hash_pool_get(stats->by_extension);
+      info = apr_pcalloc(pool, sizeof(*info));
+      info->extension = apr_pstrdup(pool, extension);
+
+      apr_hash_set(stats->by_extension, info->extension,
+                   APR_HASH_KEY_STRING, info);
+    }
+
+  return info;
+}
+
 /* Update data aggregators in STATS with this representation of type KIND,
  * on-disk REP_SIZE and expanded node size EXPANDED_SIZE for PATH in REVSION.
  * PLAIN_ADDED indicates whether the node has a deltification predecessor.
@@ -269,28 +387,7 @@ add_change(svn_fs_fs__stats_t *stats,
            svn_boolean_t plain_added)
 {
   /* identify largest reps */
-  if (rep_size >= stats->largest_changes->min_size)
-    {
-      apr_size_t i;
-      svn_fs_fs__largest_changes_t *largest_changes = stats->largest_changes;
-      svn_fs_fs__large_change_info_t *info
-        = largest_changes->changes[largest_changes->count - 1];
-      info->size = rep_size;
-      info->revision = revision;
-      svn_stringbuf_set(info->path, path);
-
-      /* linear insertion but not too bad since count is low and insertions
-       * near the end are more likely than close to front */
-      for (i = largest_changes->count - 1; i > 0; --i)
-        if (largest_changes->changes[i-1]->size >= rep_size)
-          break;
-        else
-          largest_changes->changes[i] = largest_changes->changes[i-1];
-
-      largest_changes->changes[i] = info;
-      largest_changes->min_size
-        = largest_changes->changes[largest_changes->count-1]->size;
-    }
+  add_to_largest_changes(stats->largest_changes, rep_size, revision, path);
 
   /* global histograms */
   add_to_histogram(&stats->rep_size_histogram, rep_size);
@@ -338,16 +435,7 @@ add_change(svn_fs_fs__stats_t *stats,
         extension = "(none)";
 
       /* get / auto-insert entry for this extension */
-      info = apr_hash_get(stats->by_extension, extension, APR_HASH_KEY_STRING);
-      if (info == NULL)
-        {
-          apr_pool_t *pool = apr_hash_pool_get(stats->by_extension);
-          info = apr_pcalloc(pool, sizeof(*info));
-          info->extension = apr_pstrdup(pool, extension);
-
-          apr_hash_set(stats->by_extension, info->extension,
-                       APR_HASH_KEY_STRING, info);
-        }
+      info = get_extension_info(stats, extension);
 
       /* update per-extension histogram */
       add_to_histogram(&info->node_histogram, expanded_size);
@@ -393,7 +481,14 @@ find_representation(int *idx,
   info = revision_info ? *revision_info : NULL;
   if (info == NULL || info->revision != revision)
     {
-      info = APR_ARRAY_IDX(query->revisions, revision, revision_info_t*);
+      /* Revisions outside the current batch are not available. */
+      if (   revision < query->start_rev
+          || revision - query->start_rev >= query->revisions->nelts)
+        info = NULL;
+      else
+        info = APR_ARRAY_IDX(query->revisions, revision - query->start_rev,
+                             revision_info_t*);
+
       if (revision_info)
         *revision_info = info;
     }
@@ -419,6 +514,189 @@ find_representation(int *idx,
   return NULL;
 }
 
+/* Return the slot in CHAIN_CACHE for the representation ITEM_INDEX in
+ * REVISION.
+ */
+static chain_cache_entry_t *
+get_chain_cache_entry(chain_cache_entry_t *chain_cache,
+                      svn_revnum_t revision,
+                      apr_uint64_t item_index)
+{
+  apr_uint64_t hash = (apr_uint64_t)revision * 0xd1342543de82ef95ull
+                    + item_index;
+
+  return &chain_cache[(hash ^ (hash >> 29)) & (CHAIN_CACHE_SIZE - 1)];
+}
+
+/* Remember CHAIN_LENGTH for the representation ITEM_INDEX in REVISION
+ * in CHAIN_CACHE.
+ */
+static void
+set_cached_chain_length(chain_cache_entry_t *chain_cache,
+                        svn_revnum_t revision,
+                        apr_uint64_t item_index,
+                        apr_byte_t chain_length)
+{
+  chain_cache_entry_t *entry = get_chain_cache_entry(chain_cache, revision,
+                                                     item_index);
+  entry->key.revision = revision;
+  entry->key.item_index = item_index;
+  entry->chain_length = chain_length;
+}
+
+/* Allocate a chain length cache with CHAIN_CACHE_SIZE empty entries in
+ * RESULT_POOL and return it.
+ */
+static chain_cache_entry_t *
+create_chain_cache(apr_pool_t *result_pool)
+{
+  int i;
+  chain_cache_entry_t *chain_cache
+    = apr_pcalloc(result_pool, CHAIN_CACHE_SIZE * sizeof(*chain_cache));
+
+  for (i = 0; i < CHAIN_CACHE_SIZE; ++i)
+    chain_cache[i].key.revision = SVN_INVALID_REVNUM;
+
+  return chain_cache;
+}
+
+/* Read the header of the representation ITEM_INDEX in REVISION of FS and
+ * return it in *HEADER, allocated in SCRATCH_POOL.  *REV_FILE may be NULL
+ * or some open rev / pack file.  If it does not contain REVISION, close it
+ * and replace it with the correct one, allocated in FILE_POOL.
+ */
+static svn_error_t *
+read_rep_header(svn_fs_fs__rep_header_t **header,
+                svn_fs_fs__revision_file_t **rev_file,
+                svn_fs_t *fs,
+                svn_revnum_t revision,
+                apr_uint64_t item_index,
+                apr_pool_t *file_pool,
+                apr_pool_t *scratch_pool)
+{
+  apr_off_t offset;
+
+  if (   *rev_file
+      && (*rev_file)->start_revision != svn_fs_fs__packed_base_rev(fs,
+                                                                  revision))
+    {
+      SVN_ERR(svn_fs_fs__close_revision_file(*rev_file));
+      *rev_file = NULL;
+    }
+
+  if (*rev_file == NULL)
+    SVN_ERR(svn_fs_fs__open_pack_or_rev_file(rev_file, fs, revision,
+                                             file_pool, scratch_pool));
+
+  SVN_ERR(svn_fs_fs__item_offset(&offset, fs, *rev_file, revision, NULL,
+                                 item_index, scratch_pool));
+  SVN_ERR(svn_io_file_aligned_seek((*rev_file)->file,
+                                   (*rev_file)->block_size, NULL, offset,
+                                   scratch_pool));
+  SVN_ERR(svn_fs_fs__read_rep_header(header, (*rev_file)->stream,
+                                     scratch_pool, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *CHAIN_LENGTH to the length of the delta chain of the representation
+ * ITEM_INDEX in REVISION, which has been read by a different batch than
+ * the one in QUERY.  Follow the chain on disk until we hit a rep known to
+ * QUERY->CHAIN_CACHE and add all reps along the way to the cache.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+get_foreign_chain_length(apr_byte_t *chain_length,
+                         query_t *query,
+                         svn_revnum_t revision,
+                         apr_uint64_t item_index,
+                         apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_array_header_t *chain = apr_array_make(scratch_pool, 16,
+                                             sizeof(rep_key_t));
+  svn_fs_fs__revision_file_t *rev_file = NULL;
+  apr_byte_t length = 0;
+  int i;
+
+  while (TRUE)
+    {
+      svn_fs_fs__rep_header_t *header;
+      rep_key_t *link;
+      chain_cache_entry_t *entry
+        = get_chain_cache_entry(query->chain_cache, revision, item_index);
+
+      if (   entry->key.revision == revision
+          && entry->key.item_index == item_index)
+        {
+          length = entry->chain_length;
+          break;
+        }
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(read_rep_header(&header, &rev_file, query->fs, revision,
+                              item_index, scratch_pool, iterpool));
+
+      link = apr_array_push(chain);
+      link->revision = revision;
+      link->item_index = item_index;
+
+      if (header->type != svn_fs_fs__rep_delta)
+        break;
+
+      revision = header->base_revision;
+      item_index = header->base_item_index;
+    }
+
+  if (rev_file)
+    SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+
+  /* Every link we followed got 1 element longer than its base. */
+  for (i = chain->nelts; i > 0; --i)
+    {
+      rep_key_t *link = &APR_ARRAY_IDX(chain, i - 1, rep_key_t);
+      length = 1 + MIN(length, (apr_byte_t)0xfe);
+      set_cached_chain_length(query->chain_cache, (svn_revnum_t)link->revision,
+                              link->item_index, length);
+    }
+
+  *chain_length = length;
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *CHAIN_LENGTH to the delta chain length of the base representation
+ * BASE_ITEM_INDEX in BASE_REVISION.  Look within the batch in QUERY first.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+get_base_chain_length(apr_byte_t *chain_length,
+                      query_t *query,
+                      svn_revnum_t base_revision,
+                      apr_uint64_t base_item_index,
+                      apr_pool_t *scratch_pool)
+{
+  int idx;
+  rep_stats_t *base;
+
+  if (base_revision < query->start_rev)
+    return svn_error_trace(get_foreign_chain_length(chain_length, query,
+                                                    base_revision,
+                                                    base_item_index,
+                                                    scratch_pool));
+
+  /* No dangling pointers and all base reps have been processed. */
+  base = find_representation(&idx, query, NULL, base_revision,
+                             base_item_index);
+  SVN_ERR_ASSERT(base);
+  SVN_ERR_ASSERT(base->chain_length);
+
+  *chain_length = base->chain_length;
+
+  return SVN_NO_ERROR;
+}
+
 /* Find / auto-construct the representation stats for REP in QUERY and
  * return it in *REPRESENTATION.
  *
@@ -473,14 +751,13 @@ parse_representation(rep_stats_t **representation,
           /* Determine length of the delta chain. */
           if (header->type == svn_fs_fs__rep_delta)
             {
-              int base_idx;
-              rep_stats_t *base_rep
-                = find_representation(&base_idx, query, NULL,
-                                      header->base_revision,
-                                      header->base_item_index);
-
-              result->chain_length = 1 + MIN(base_rep->chain_length,
-                                             (apr_byte_t)0xfe);
+              apr_byte_t base_length;
+              SVN_ERR(get_base_chain_length(&base_length, query,
+                                            header->base_revision,
+                                            header->base_item_index,
+                                            scratch_pool));
+
+              result->chain_length = 1 + MIN(base_length, (apr_byte_t)0xfe);
             }
           else
             {
@@ -497,6 +774,23 @@ parse_representation(rep_stats_t **representation,
 }
 
 
+/* Record in QUERY another reference to REP of type KIND.  REP has been
+ * created before the current batch.
+ */
+static void
+add_foreign_ref(query_t *query,
+                representation_t *rep,
+                rep_kind_t kind)
+{
+  foreign_ref_t *ref = apr_array_push(query->foreign_refs);
+
+  ref->key.revision = rep->revision;
+  ref->key.item_index = rep->item_index;
+  ref->size = rep->size;
+  ref->expanded_size = rep->expanded_size;
+  ref->kind = (char)kind;
+}
+
 /* forward declaration */
 static svn_error_t *
 read_noderev(query_t *query,
@@ -620,25 +914,43 @@ read_noderev(query_t *query,
 
   if (noderev->data_rep)
     {
-      SVN_ERR(parse_representation(&text, query,
-                                   noderev->data_rep, revision_info,
-                                   result_pool, scratch_pool));
+      rep_kind_t kind = noderev->kind == svn_node_dir ? dir_rep : file_rep;
 
-      /* if we are the first to use this rep, mark it as "text rep" */
-      if (++text->ref_count == 1)
-        text->kind = noderev->kind == svn_node_dir ? dir_rep : file_rep;
+      if (noderev->data_rep->revision < query->start_rev)
+        {
+          add_foreign_ref(query, noderev->data_rep, kind);
+        }
+      else
+        {
+          SVN_ERR(parse_representation(&text, query,
+                                       noderev->data_rep, revision_info,
+                                       result_pool, scratch_pool));
+
+          /* if we are the first to use this rep, mark it as "text rep" */
+          if (++text->ref_count == 1)
+            text->kind = kind;
+        }
     }
 
   if (noderev->prop_rep)
     {
-      SVN_ERR(parse_representation(&props, query,
-                                   noderev->prop_rep, revision_info,
-                                   result_pool, scratch_pool));
-
-      /* if we are the first to use this rep, mark it as "prop rep" */
-      if (++props->ref_count == 1)
-        props->kind = noderev->kind == svn_node_dir ? dir_property_rep
-                                                    : file_property_rep;
+      rep_kind_t kind = noderev->kind == svn_node_dir ? dir_property_rep
+                                                      : file_property_rep;
+
+      if (noderev->prop_rep->revision < query->start_rev)
+        {
+          add_foreign_ref(query, noderev->prop_rep, kind);
+        }
+      else
+        {
+          SVN_ERR(parse_representation(&props, query,
+                                       noderev->prop_rep, revision_info,
+                                       result_pool, scratch_pool));
+
+          /* if we are the first to use this rep, mark it as "prop rep" */
+          if (++props->ref_count == 1)
+            props->kind = kind;
+        }
     }
 
   /* record largest changes */
@@ -813,10 +1125,6 @@ read_phys_pack_file(query_t *query,
   /* Done with this pack file. */
   SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
 
-  /* one more pack file processed */
-  if (query->progress_func)
-    query->progress_func(base, query->progress_baton, scratch_pool);
-
   return SVN_NO_ERROR;
 }
 
@@ -862,15 +1170,6 @@ read_phys_revision_file(query_t *query,
   /* put it into our container */
   APR_ARRAY_PUSH(query->revisions, revision_info_t*) = info;
 
-  /* show progress every 1000 revs or so */
-  if (query->progress_func)
-    {
-      if (query->shard_size && (revision % query->shard_size == 0))
-        query->progress_func(revision, query->progress_baton, scratch_pool);
-      if (!query->shard_size && (revision % 1000 == 0))
-        query->progress_func(revision, query->progress_baton, scratch_pool);
-    }
-
   return SVN_NO_ERROR;
 }
 
@@ -940,8 +1239,10 @@ compare_representation_refs(const void *lhs, const void *rhs)
  */
 static svn_error_t *
 resolve_representation_refs(query_t *query,
-                            apr_array_header_t *rep_refs)
+                            apr_array_header_t *rep_refs,
+                            apr_pool_t *scratch_pool)
 {
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
   int i;
 
   /* Because delta chains can only point to previous revs, after sorting
@@ -970,17 +1271,19 @@ resolve_representation_refs(query_t *query,
         }
       else
         {
-          rep_stats_t *base;
+          apr_byte_t base_length;
 
-          base = find_representation(&idx, query, NULL, ref->base_revision,
-                                     ref->base_item_index);
-          SVN_ERR_ASSERT(base);
-          SVN_ERR_ASSERT(base->chain_length);
+          svn_pool_clear(iterpool);
+          SVN_ERR(get_base_chain_length(&base_length, query,
+                                        ref->base_revision,
+                                        ref->base_item_index, iterpool));
 
-          rep->chain_length = 1 + MIN(base->chain_length, (apr_byte_t)0xfe);
+          rep->chain_length = 1 + MIN(base_length, (apr_byte_t)0xfe);
         }
     }
 
+  svn_pool_destroy(iterpool);
+
   return SVN_NO_ERROR;
 }
 
@@ -1030,7 +1333,8 @@ read_log_rev_or_packfile(query_t *query,
 
   /* record the whole pack size in the first rev so the total sum will
      still be correct */
-  APR_ARRAY_IDX(query->revisions, base, revision_info_t*)->end = max_offset;
+  APR_ARRAY_IDX(query->revisions, base - query->start_rev,
+                revision_info_t*)->end = max_offset;
 
   /* for all offsets in the file, get the P2L index entries and process
      the interesting items (change lists, noderevs) */
@@ -1066,7 +1370,8 @@ read_log_rev_or_packfile(query_t *query,
             continue;
 
           /* read and process interesting items */
-          info = APR_ARRAY_IDX(query->revisions, entry->item.revision,
+          info = APR_ARRAY_IDX(query->revisions,
+                               entry->item.revision - query->start_rev,
                                revision_info_t*);
 
           if (entry->type == SVN_FS_FS__ITEM_TYPE_NODEREV)
@@ -1122,7 +1427,7 @@ read_log_rev_or_packfile(query_t *query,
     }
 
   /* Resolve the delta chain links. */
-  SVN_ERR(resolve_representation_refs(query, rep_refs));
+  SVN_ERR(resolve_representation_refs(query, rep_refs, scratch_pool));
 
   /* clean up and close file handles */
   svn_pool_destroy(iterpool);
@@ -1142,14 +1447,10 @@ read_log_pack_file(query_t *query,
                    apr_pool_t *result_pool,
                    apr_pool_t *scratch_pool)
 {
-  SVN_ERR(read_log_rev_or_packfile(query, base, query->shard_size,
-                                   result_pool, scratch_pool));
-
-  /* one more pack file processed */
-  if (query->progress_func)
-    query->progress_func(base, query->progress_baton, scratch_pool);
-
-  return SVN_NO_ERROR;
+  return svn_error_trace(read_log_rev_or_packfile(query, base,
+                                                  query->shard_size,
+                                                  result_pool,
+                                                  scratch_pool));
 }
 
 /* Read the content of the file for REVISION in logical addressing mode
@@ -1164,58 +1465,47 @@ read_log_revision_file(query_t *query,
                        apr_pool_t *result_pool,
                        apr_pool_t *scratch_pool)
 {
-  SVN_ERR(read_log_rev_or_packfile(query, revision, 1,
-                                   result_pool, scratch_pool));
-
-  /* show progress every 1000 revs or so */
-  if (query->progress_func)
-    {
-      if (query->shard_size && (revision % query->shard_size == 0))
-        query->progress_func(revision, query->progress_baton, scratch_pool);
-      if (!query->shard_size && (revision % 1000 == 0))
-        query->progress_func(revision, query->progress_baton, scratch_pool);
-    }
-
-  return SVN_NO_ERROR;
+  return svn_error_trace(read_log_rev_or_packfile(query, revision, 1,
+                                                  result_pool,
+                                                  scratch_pool));
 }
 
-/* Read the repository and collect the stats info in QUERY.
+/* Read the batch of revisions in QUERY, i.e. either the pack file starting
+ * at QUERY->START_REV or all non-packed revisions from QUERY->START_REV up
+ * to but not including END_REV, and collect the stats info in QUERY.
  *
  * Use RESULT_POOL for persistent allocations and SCRATCH_POOL for
  * temporaries.
  */
 static svn_error_t *
 read_revisions(query_t *query,
+               svn_revnum_t end_rev,
                apr_pool_t *result_pool,
                apr_pool_t *scratch_pool)
 {
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
-  svn_revnum_t revision;
+  svn_revnum_t revision = query->start_rev;
 
-  /* read all packed revs */
-  for ( revision = 0
-      ; revision < query->min_unpacked_rev
-      ; revision += query->shard_size)
+  if (revision < query->min_unpacked_rev)
     {
-      svn_pool_clear(iterpool);
-
       if (svn_fs_fs__use_log_addressing(query->fs))
         SVN_ERR(read_log_pack_file(query, revision, result_pool, iterpool));
       else
         SVN_ERR(read_phys_pack_file(query, revision, result_pool, iterpool));
     }
-
-  /* read non-packed revs */
-  for ( ; revision <= query->head; ++revision)
+  else
     {
-      svn_pool_clear(iterpool);
+      for ( ; revision < end_rev; ++revision)
+        {
+          svn_pool_clear(iterpool);
 
-      if (svn_fs_fs__use_log_addressing(query->fs))
-        SVN_ERR(read_log_revision_file(query, revision, result_pool,
-                                       iterpool));
-      else
-        SVN_ERR(read_phys_revision_file(query, revision, result_pool,
-                                        iterpool));
+          if (svn_fs_fs__use_log_addressing(query->fs))
+            SVN_ERR(read_log_revision_file(query, revision, result_pool,
+                                           iterpool));
+          else
+            SVN_ERR(read_phys_revision_file(query, revision, result_pool,
+                                            iterpool));
+        }
     }
 
   svn_pool_destroy(iterpool);
@@ -1253,13 +1543,54 @@ add_rep_stats(svn_fs_fs__representation_stats_t *stats,
   stats->chain_len += rep->chain_length;
 }
 
-/* Aggregate the info the in revision_info_t * array REVISIONS into the
- * respectve fields of STATS.
+/* Move REP, which has previously been accounted for as unique in STATS,
+ * to the shared representations in STATS.
+ */
+static void
+make_rep_shared(svn_fs_fs__representation_stats_t *stats,
+                rep_stats_t *rep)
+{
+  add_rep_pack_stats(&stats->shared, rep);
+
+  stats->uniques.count--;
+  stats->uniques.packed_size -= rep->size;
+  stats->uniques.expanded_size -= rep->expanded_size;
+  stats->uniques.overhead_size -= rep->header_size + 7 /* ENDREP\n */;
+}
+
+/* Return the representation stats in STATS for representations of the
+ * given KIND.  Return NULL for unused reps.
+ */
+static svn_fs_fs__representation_stats_t *
+get_rep_stats(svn_fs_fs__stats_t *stats,
+              rep_kind_t kind)
+{
+  switch (kind)
+    {
+      case file_rep:
+        return &stats->file_rep_stats;
+      case dir_rep:
+        return &stats->dir_rep_stats;
+      case file_property_rep:
+        return &stats->file_prop_rep_stats;
+      case dir_property_rep:
+        return &stats->dir_prop_rep_stats;
+      default:
+        return NULL;
+    }
+}
+
+/* Aggregate the info the in revision_info_t * array QUERY->REVISIONS into
+ * the respectve fields of QUERY->STATS.  Add the keys of all reps that are
+ * referenced more than once to SHARED_REPS and the delta chain lengths of
+ * all reps to QUERY->CHAIN_CACHE.
  */
 static void
-aggregate_stats(const apr_array_header_t *revisions,
-                svn_fs_fs__stats_t *stats)
+aggregate_stats(query_t *query,
+                apr_array_header_t *shared_reps)
 {
+  const apr_array_header_t *revisions = query->revisions;
+  svn_fs_fs__stats_t *stats = query->stats;
   int i, k;
 
   /* aggregate info from all revisions */
@@ -1288,27 +1619,26 @@ aggregate_stats(const apr_array_header_t *revisions,
         {
           rep_stats_t *rep = APR_ARRAY_IDX(revision->representations, k,
                                            rep_stats_t *);
+          svn_fs_fs__representation_stats_t *rep_stats
+            = get_rep_stats(stats, rep->kind);
 
           /* accumulate in the right bucket */
-          switch(rep->kind)
+          if (rep_stats)
+            add_rep_stats(rep_stats, rep);
+
+          add_rep_stats(&stats->total_rep_stats, rep);
+
+          /* Later batches may add references to shared reps or use any
+           * of them as delta base. */
+          if (rep->ref_count > 1)
             {
-              case file_rep:
-                add_rep_stats(&stats->file_rep_stats, rep);
-                break;
-              case dir_rep:
-                add_rep_stats(&stats->dir_rep_stats, rep);
-                break;
-              case file_property_rep:
-                add_rep_stats(&stats->file_prop_rep_stats, rep);
-                break;
-              case dir_property_rep:
-                add_rep_stats(&stats->dir_prop_rep_stats, rep);
-                break;
-              default:
-                break;
+              rep_key_t *key = apr_array_push(shared_reps);
+              key->revision = rep->revision;
+              key->item_index = rep->item_index;
             }
 
-          add_rep_stats(&stats->total_rep_stats, rep);
+          set_cached_chain_length(query->chain_cache, rep->revision,
+                                  rep->item_index, rep->chain_length);
         }
     }
 }
@@ -1326,55 +1656,762 @@ create_stats(apr_pool_t *result_pool)
   return stats;
 }
 
-/* Create a *QUERY, allocated in RESULT_POOL, reading filesystem FS and
- * collecting results in STATS.  Store the optional PROCESS_FUNC and
- * PROGRESS_BATON as well as CANCEL_FUNC and CANCEL_BATON in *QUERY, too.
+/* How the revisions of a repository get split into batches.
+ */
+typedef struct batch_plan_t
+{
+  /* The HEAD revision. */
+  svn_revnum_t head;
+
+  /* First non-packed revision. */
+  svn_revnum_t min_unpacked_rev;
+
+  /* Number of revs per shard; 0 for non-sharded repos. */
+  int shard_size;
+
+  /* Maximum number of non-packed revisions per batch. */
+  int batch_size;
+
+  /* Number of batches covering pack files.  They come first. */
+  int packed_count;
+
+  /* Total number of batches. */
+  int count;
+} batch_plan_t;
+
+/* Initialize *PLAN for the repository FS.
  * Use SCRATCH_POOL for temporary allocations.
  */
 static svn_error_t *
-create_query(query_t **query,
-             svn_fs_t *fs,
+create_plan(batch_plan_t *plan,
+            svn_fs_t *fs,
+            apr_pool_t *scratch_pool)
+{
+  /* Read repository dimensions. */
+  plan->shard_size = svn_fs_fs__shard_size(fs);
+  SVN_ERR(svn_fs_fs__youngest_rev(&plan->head, fs, scratch_pool));
+  SVN_ERR(svn_fs_fs__min_unpacked_rev(&plan->min_unpacked_rev, fs,
+                                      scratch_pool));
+
+  /* Non-packed revs get batched by shard or, in non-sharded repos, in
+   * groups of 1000. */
+  plan->batch_size = plan->shard_size ? plan->shard_size : 1000;
+  plan->packed_count = plan->shard_size
+                     ? (int)(plan->min_unpacked_rev / plan->shard_size)
+                     : 0;
+  plan->count = plan->packed_count
+              + (int)((plan->head - plan->min_unpacked_rev
+                       + plan->batch_size) / plan->batch_size);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *START_REV and *END_REV to the first and one past the last revision
+ * of batch number INDEX in PLAN.
+ */
+static void
+get_batch_range(svn_revnum_t *start_rev,
+                svn_revnum_t *end_rev,
+                const batch_plan_t *plan,
+                int index)
+{
+  if (index < plan->packed_count)
+    {
+      *start_rev = (svn_revnum_t)index * plan->shard_size;
+      *end_rev = *start_rev + plan->shard_size;
+    }
+  else
+    {
+      *start_rev = plan->min_unpacked_rev
+                 + (svn_revnum_t)(index - plan->packed_count)
+                 * plan->batch_size;
+      *end_rev = MIN(*start_rev + plan->batch_size, plan->head + 1);
+    }
+}
+
+/* Create a *QUERY, allocated in RESULT_POOL, reading filesystem FS with
+ * the dimensions given by PLAN for the batch starting at START_REV up to
+ * but not including END_REV.  Collect results in STATS and FOREIGN_REFS
+ * and look up delta chains outside the batch in CHAIN_CACHE.  Store the
+ * optional CANCEL_FUNC and CANCEL_BATON in *QUERY, too.
+ */
+static query_t *
+create_query(svn_fs_t *fs,
+             const batch_plan_t *plan,
+             svn_revnum_t start_rev,
+             svn_revnum_t end_rev,
              svn_fs_fs__stats_t *stats,
-             svn_fs_progress_notify_func_t progress_func,
-             void *progress_baton,
+             apr_array_header_t *foreign_refs,
+             chain_cache_entry_t *chain_cache,
              svn_cancel_func_t cancel_func,
              void *cancel_baton,
-             apr_pool_t *result_pool,
-             apr_pool_t *scratch_pool)
+             apr_pool_t *result_pool)
 {
-  *query = apr_pcalloc(result_pool, sizeof(**query));
+  query_t *query = apr_pcalloc(result_pool, sizeof(*query));
 
-  /* Read repository dimensions. */
-  (*query)->shard_size = svn_fs_fs__shard_size(fs);
-  SVN_ERR(svn_fs_fs__youngest_rev(&(*query)->head, fs, scratch_pool));
-  SVN_ERR(svn_fs_fs__min_unpacked_rev(&(*query)->min_unpacked_rev, fs,
-                                      scratch_pool));
+  /* Repository dimensions. */
+  query->shard_size = plan->shard_size;
+  query->head = plan->head;
+  query->min_unpacked_rev = plan->min_unpacked_rev;
+  query->start_rev = start_rev;
 
-  /* create data containers and caches
-   * Note: this assumes that int is at least 32-bits and that we only support
-   * 32-bit wide revision numbers (actually 31-bits due to the signedness
-   * of both the nelts field of the array and our revision numbers). This
-   * means this code will fail on platforms where int is less than 32-bits
-   * and the repository has more revisions than int can hold. */
-  (*query)->revisions = apr_array_make(result_pool, (int) (*query)->head + 1,
-                                       sizeof(revision_info_t *));
-  (*query)->null_base = apr_pcalloc(result_pool,
-                                    sizeof(*(*query)->null_base));
+  /* create data containers */
+  query->revisions = apr_array_make(result_pool, (int)(end_rev - start_rev),
+                                    sizeof(revision_info_t *));
+  query->null_base = apr_pcalloc(result_pool, sizeof(*query->null_base));
 
   /* Store other parameters */
-  (*query)->fs = fs;
-  (*query)->stats = stats;
-  (*query)->progress_func = progress_func;
-  (*query)->progress_baton = progress_baton;
-  (*query)->cancel_func = cancel_func;
-  (*query)->cancel_baton = cancel_baton;
+  query->fs = fs;
+  query->stats = stats;
+  query->foreign_refs = foreign_refs;
+  query->chain_cache = chain_cache;
+  query->cancel_func = cancel_func;
+  query->cancel_baton = cancel_baton;
+
+  return query;
+}
+
+/* Results of reading a single batch of revisions.  All data that we keep
+ * per representation is gone at that point, except for the few reps that
+ * we need to track across batches.
+ */
+typedef struct stats_batch_t
+{
+  /* Root pool containing this struct and everything referenced by it. */
+  apr_pool_t *pool;
+
+  /* First revision of the batch. */
+  svn_revnum_t start_rev;
+
+  /* Statistics over this batch alone. */
+  svn_fs_fs__stats_t *stats;
+
+  /* rep_key_t of all reps in this batch that are referenced more than
+   * once within this batch. */
+  apr_array_header_t *shared_reps;
+
+  /* foreign_ref_t of all references to reps of previous batches. */
+  apr_array_header_t *foreign_refs;
+} stats_batch_t;
+
+/* Read the revisions START_REV up to but not including END_REV in
+ * filesystem FS, which must be a batch as defined by PLAN, and return the
+ * result in *BATCH.  The result will have its own root pool.  Use and
+ * update the delta chain lengths in CHAIN_CACHE.  CANCEL_FUNC and
+ * CANCEL_BATON are optional.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+read_batch(stats_batch_t **batch,
+           svn_fs_t *fs,
+           const batch_plan_t *plan,
+           svn_revnum_t start_rev,
+           svn_revnum_t end_rev,
+           chain_cache_entry_t *chain_cache,
+           svn_cancel_func_t cancel_func,
+           void *cancel_baton,
+           apr_pool_t *scratch_pool)
+{
+  apr_pool_t *pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  apr_pool_t *subpool = svn_pool_create(scratch_pool);
+  stats_batch_t *result = apr_pcalloc(pool, sizeof(*result));
+  query_t *query;
+  svn_error_t *err;
+
+  result->pool = pool;
+  result->start_rev = start_rev;
+  result->stats = create_stats(pool);
+  result->shared_reps = apr_array_make(pool, 16, sizeof(rep_key_t));
+  result->foreign_refs = apr_array_make(pool, 16, sizeof(foreign_ref_t));
+
+  /* All per-rep data lives in SUBPOOL only. */
+  query = create_query(fs, plan, start_rev, end_rev, result->stats,
+                       result->foreign_refs, chain_cache, cancel_func,
+                       cancel_baton, subpool);
+  err = read_revisions(query, end_rev, subpool, subpool);
+  if (err)
+    {
+      svn_pool_destroy(pool);
+      return svn_error_trace(err);
+    }
+
+  aggregate_stats(query, result->shared_reps);
+  svn_pool_destroy(subpool);
+
+  *batch = result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Add the data in SOURCE to TARGET.
+ */
+static void
+merge_histogram(svn_fs_fs__histogram_t *target,
+                const svn_fs_fs__histogram_t *source)
+{
+  apr_size_t i;
+
+  target->total.count += source->total.count;
+  target->total.sum += source->total.sum;
+
+  for (i = 0; i < sizeof(source->lines) / sizeof(source->lines[0]); ++i)
+    {
+      target->lines[i].count += source->lines[i].count;
+      target->lines[i].sum += source->lines[i].sum;
+    }
+}
+
+/* Add the data in SOURCE to TARGET.
+ */
+static void
+merge_rep_pack_stats(svn_fs_fs__rep_pack_stats_t *target,
+                     const svn_fs_fs__rep_pack_stats_t *source)
+{
+  target->count += source->count;
+  target->packed_size += source->packed_size;
+  target->expanded_size += source->expanded_size;
+  target->overhead_size += source->overhead_size;
+}
+
+/* Add the data in SOURCE to TARGET.
+ */
+static void
+merge_rep_stats(svn_fs_fs__representation_stats_t *target,
+                const svn_fs_fs__representation_stats_t *source)
+{
+  merge_rep_pack_stats(&target->total, &source->total);
+  merge_rep_pack_stats(&target->uniques, &source->uniques);
+  merge_rep_pack_stats(&target->shared, &source->shared);
+
+  target->references += source->references;
+  target->expanded_size += source->expanded_size;
+  target->chain_len += source->chain_len;
+}
+
+/* Add the data in SOURCE to TARGET.
+ */
+static void
+merge_node_stats(svn_fs_fs__node_stats_t *target,
+                 const svn_fs_fs__node_stats_t *source)
+{
+  target->count += source->count;
+  target->size += source->size;
+}
+
+/* Add the additional reference REF to a representation of a previous
+ * batch to STATS.  SHARED_REPS contains the rep_key_t of all reps that
+ * have been referenced more than once so far.  Use and update *REV_FILE
+ * as described for read_rep_header() in FS with FILE_POOL.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+add_foreign_ref_stats(svn_fs_fs__stats_t *stats,
+                      apr_hash_t *shared_reps,
+                      svn_fs_fs__revision_file_t **rev_file,
+                      svn_fs_t *fs,
+                      const foreign_ref_t *ref,
+                      apr_pool_t *file_pool,
+                      apr_pool_t *scratch_pool)
+{
+  svn_fs_fs__representation_stats_t *rep_stats
+    = get_rep_stats(stats, ref->kind);
+
+  /* Until now, that rep has been counted as "unique".  We need its header
+   * size to move it to the shared reps. */
+  if (!apr_hash_get(shared_reps, &ref->key, sizeof(ref->key)))
+    {
+      apr_pool_t *hash_pool = apr_hash_pool_get(shared_reps);
+      svn_fs_fs__rep_header_t *header;
+      rep_stats_t rep = { 0 };
+
+      SVN_ERR(read_rep_header(&header, rev_file, fs,
+                              (svn_revnum_t)ref->key.revision,
+                              ref->key.item_index, file_pool,
+                              scratch_pool));
+
+      rep.size = ref->size;
+      rep.expanded_size = ref->expanded_size;
+      rep.header_size = (apr_uint16_t)header->header_size;
+
+      make_rep_shared(&stats->total_rep_stats, &rep);
+      if (rep_stats)
+        make_rep_shared(rep_stats, &rep);
+
+      apr_hash_set(shared_reps,
+                   apr_pmemdup(hash_pool, &ref->key, sizeof(ref->key)),
+                   sizeof(ref->key), hash_pool);
+    }
+
+  /* One more reference. */
+  stats->total_rep_stats.references++;
+  stats->total_rep_stats.expanded_size += ref->expanded_size;
+  if (rep_stats)
+    {
+      rep_stats->references++;
+      rep_stats->expanded_size += ref->expanded_size;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Add the results in BATCH to STATS.  SHARED_REPS contains the rep_key_t
+ * of all reps that have been referenced more than once in all previous
+ * batches and will be updated accordingly.  Because delta bases and
+ * shared reps must be older than the references to them, all batches
+ * must be merged in revision order.  FS is the filesystem being scanned.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+merge_batch(svn_fs_fs__stats_t *stats,
+            apr_hash_t *shared_reps,
+            svn_fs_t *fs,
+            const stats_batch_t *batch,
+            apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_pool_t *hash_pool = apr_hash_pool_get(shared_reps);
+  svn_fs_fs__stats_t *source = batch->stats;
+  svn_fs_fs__revision_file_t *rev_file = NULL;
+  apr_hash_index_t *hi;
+  apr_size_t k;
+  int i;
+
+  stats->total_size += source->total_size;
+  stats->revision_count += source->revision_count;
+  stats->change_count += source->change_count;
+  stats->change_len += source->change_len;
+
+  merge_rep_stats(&stats->total_rep_stats, &source->total_rep_stats);
+  merge_rep_stats(&stats->file_rep_stats, &source->file_rep_stats);
+  merge_rep_stats(&stats->dir_rep_stats, &source->dir_rep_stats);
+  merge_rep_stats(&stats->file_prop_rep_stats, &source->file_prop_rep_stats);
+  merge_rep_stats(&stats->dir_prop_rep_stats, &source->dir_prop_rep_stats);
+
+  merge_node_stats(&stats->total_node_stats, &source->total_node_stats);
+  merge_node_stats(&stats->file_node_stats, &source->file_node_stats);
+  merge_node_stats(&stats->dir_node_stats, &source->dir_node_stats);
+
+  for (k = 0; k < source->largest_changes->count; ++k)
+    {
+      svn_fs_fs__large_change_info_t *info
+        = source->largest_changes->changes[k];
+
+      /* Skip unused entries. */
+      if (!SVN_IS_VALID_REVNUM(info->revision))
+        break;
+
+      add_to_largest_changes(stats->largest_changes, info->size,
+                             info->revision, info->path->data);
+    }
+
+  merge_histogram(&stats->rep_size_histogram, &source->rep_size_histogram);
+  merge_histogram(&stats->node_size_histogram, &source->node_size_histogram);
+  merge_histogram(&stats->added_rep_size_histogram,
+                  &source->added_rep_size_histogram);
+  merge_histogram(&stats->added_node_size_histogram,
+                  &source->added_node_size_histogram);
+  merge_histogram(&stats->unused_rep_histogram,
+                  &source->unused_rep_histogram);
+  merge_histogram(&stats->file_histogram, &source->file_histogram);
+  merge_histogram(&stats->file_rep_histogram, &source->file_rep_histogram);
+  merge_histogram(&stats->file_prop_histogram, &source->file_prop_histogram);
+  merge_histogram(&stats->file_prop_rep_histogram,
+                  &source->file_prop_rep_histogram);
+  merge_histogram(&stats->dir_histogram, &source->dir_histogram);
+  merge_histogram(&stats->dir_rep_histogram, &source->dir_rep_histogram);
+  merge_histogram(&stats->dir_prop_histogram, &source->dir_prop_histogram);
+  merge_histogram(&stats->dir_prop_rep_histogram,
+                  &source->dir_prop_rep_histogram);
+
+  for (hi = apr_hash_first(scratch_pool, source->by_extension);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      svn_fs_fs__extension_info_t *info = apr_hash_this_val(hi);
+      svn_fs_fs__extension_info_t *target
+        = get_extension_info(stats, info->extension);
+
+      merge_histogram(&target->rep_histogram, &info->rep_histogram);
+      merge_histogram(&target->node_histogram, &info->node_histogram);
+    }
+
+  /* Remember the shared reps of this batch. */
+  for (i = 0; i < batch->shared_reps->nelts; ++i)
+    {
+      rep_key_t *key = &APR_ARRAY_IDX(batch->shared_reps, i, rep_key_t);
+      apr_hash_set(shared_reps, apr_pmemdup(hash_pool, key, sizeof(*key)),
+                   sizeof(*key), hash_pool);
+    }
+
+  /* Account for references to reps of previous batches. */
+  for (i = 0; i < batch->foreign_refs->nelts; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(add_foreign_ref_stats(stats, shared_reps, &rev_file, fs,
+                                    &APR_ARRAY_IDX(batch->foreign_refs, i,
+                                                   foreign_ref_t),
+                                    scratch_pool, iterpool));
+    }
+
+  if (rev_file)
+    SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* State of the worker threads that read batches of revisions ahead of the
+ * one currently being merged by svn_fs_fs__get_stats().  Merging happens
+ * in strict revision order in the thread that called svn_fs_fs__get_stats.
+ */
+typedef struct stats_reader_t stats_reader_t;
+
+#if APR_HAS_THREADS
+
+/* Number of batches per worker thread that may be read ahead of the
+   oldest one not merged yet.  This limits our memory usage. */
+#define STATS_WINDOW_PER_THREAD 2
+
+/* Check for cancellation that often while waiting for a worker. */
+#define STATS_WAIT_INTERVAL apr_time_from_msec(100)
+
+/* Per-thread data of a stats worker. */
+typedef struct stats_worker_t
+{
+  /* The shared state. */
+  stats_reader_t *reader;
+
+  /* Private filesystem instance. */
+  svn_fs_t *fs;
+
+  /* Delta chain lengths of reps this worker has seen.  Private. */
+  chain_cache_entry_t *chain_cache;
+
+  /* Root pool used only by this thread. */
+  apr_pool_t *pool;
+
+  /* The thread itself or NULL if it could not be started. */
+  apr_thread_t *thread;
+} stats_worker_t;
+
+struct stats_reader_t
+{
+  /* Protects NEXT_BATCH, FIRST_BATCH and the slots.  Used with COND. */
+  svn_mutex__t *mutex;
+
+  /* Signaled whenever a batch completes, a worker terminates or a batch
+     has been merged. */
+  apr_thread_cond_t *cond;
+
+  /* Batch layout.  Read-only. */
+  const batch_plan_t *plan;
+
+  /* The next batch to be claimed by a worker. */
+  int next_batch;
+
+  /* The oldest batch that has not been merged yet. */
+  int first_batch;
+
+  /* Completed batches, their errors and completion flags, indexed by
+     batch number modulo MAX_JOBS.  Workers don't claim batches MAX_JOBS
+     or more ahead of FIRST_BATCH. */
+  stats_batch_t **batches;
+  svn_error_t **errors;
+  svn_boolean_t *done;
+  int max_jobs;
+
+  /* Number of worker threads that have not terminated yet. */
+  volatile svn_atomic_t running;
+
+  /* Non-zero once the workers shall stop. */
+  volatile svn_atomic_t aborted;
+
+  /* All worker threads. */
+  stats_worker_t *workers;
+  int worker_count;
+};
+
+/* Implements svn_cancel_func_t for the stats_reader_t BATON.
+   Workers must not call the caller's cancellation function. */
+static svn_error_t *
+check_stats_aborted(void *baton)
+{
+  stats_reader_t *reader = baton;
+
+  if (svn_atomic_read(&reader->aborted))
+    return svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
 
   return SVN_NO_ERROR;
 }
 
+/* Set *INDEX to the next batch to read for READER.  Wait until it is
+   within the job window.  Set it to -1 if there is nothing left to do. */
+static svn_error_t *
+claim_batch(int *index,
+            stats_reader_t *reader)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+
+  SVN_ERR(svn_mutex__lock(reader->mutex));
+
+  /* This loop implicitly handles spurious wake-ups. */
+  while (!svn_atomic_read(&reader->aborted)
+         && reader->next_batch < reader->plan->count
+         && reader->next_batch - reader->first_batch >= reader->max_jobs)
+    {
+      apr_status_t status
+        = apr_thread_cond_wait(reader->cond, svn_mutex__get(reader->mutex));
+      if (status)
+        {
+          err = svn_error_wrap_apr(status,
+                                   _("Can't wait for condition variable"));
+          break;
+        }
+    }
+
+  if (err
+      || svn_atomic_read(&reader->aborted)
+      || reader->next_batch >= reader->plan->count)
+    *index = -1;
+  else
+    *index = reader->next_batch++;
+
+  return svn_error_trace(svn_mutex__unlock(reader->mutex, err));
+}
+
+/* Thread function.  Read batches for the stats_worker_t given by DATA
+   until there are no more or reading got aborted. */
+static void * APR_THREAD_FUNC
+stats_thread(apr_thread_t *tid,
+             void *data)
+{
+  stats_worker_t *worker = data;
+  stats_reader_t *reader = worker->reader;
+  apr_pool_t *iterpool = svn_pool_create(worker->pool);
+  svn_error_t *err = SVN_NO_ERROR;
+
+  while (!err)
+    {
+      int index;
+      int slot;
+      svn_revnum_t start_rev, end_rev;
+      stats_batch_t *batch = NULL;
+      svn_error_t *read_err;
+
+      svn_pool_clear(iterpool);
+
+      err = claim_batch(&index, reader);
+      if (err || index < 0)
+        break;
+
+      get_batch_range(&start_rev, &end_rev, reader->plan, index);
+      read_err = read_batch(&batch, worker->fs, reader->plan, start_rev,
+                            end_rev, worker->chain_cache,
+                            check_stats_aborted, reader, iterpool);
+
+      /* Once claimed, the main thread waits for this batch.  So, hand it
+         over even if we could not get the lock. */
+      err = svn_mutex__lock(reader->mutex);
+      slot = index % reader->max_jobs;
+      reader->batches[slot] = batch;
+      reader->errors[slot] = read_err;
+      reader->done[slot] = TRUE;
+      if (!err)
+        {
+          apr_thread_cond_broadcast(reader->cond);
+          err = svn_mutex__unlock(reader->mutex, SVN_NO_ERROR);
+        }
+    }
+
+  svn_error_clear(err);
+  svn_pool_destroy(iterpool);
+
+  /* Batches that no worker is left for will be read by the main
+     thread. */
+  err = svn_mutex__lock(reader->mutex);
+  svn_atomic_dec(&reader->running);
+  if (!err)
+    {
+      apr_thread_cond_broadcast(reader->cond);
+      err = svn_mutex__unlock(reader->mutex, SVN_NO_ERROR);
+    }
+
+  svn_error_clear(err);
+
+  return NULL;
+}
+
+/* Wait for the worker threads of READER to read batch number INDEX, which
+   is the oldest batch not merged yet.  Check for cancellation through
+   CANCEL_FUNC and CANCEL_BATON periodically.  Set *BATCH to NULL if no
+   worker is left to read that batch.  Otherwise, set it to the result and
+   return the error that reading the batch returned. */
+static svn_error_t *
+wait_for_batch(stats_batch_t **batch,
+               stats_reader_t *reader,
+               int index,
+               svn_cancel_func_t cancel_func,
+               void *cancel_baton)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+  int slot = index % reader->max_jobs;
+
+  *batch = NULL;
+  SVN_ERR(svn_mutex__lock(reader->mutex));
+
+  while (!reader->done[slot] && svn_atomic_read(&reader->running))
+    {
+      apr_status_t status;
+
+      if (cancel_func)
+        {
+          err = cancel_func(cancel_baton);
+          if (err)
+            break;
+        }
+
+      status = apr_thread_cond_timedwait(reader->cond,
+                                         svn_mutex__get(reader->mutex),
+                                         STATS_WAIT_INTERVAL);
+      if (status && !APR_STATUS_IS_TIMEUP(status))
+        {
+          err = svn_error_wrap_apr(status,
+                                   _("Can't wait for condition variable"));
+          break;
+        }
+    }
+
+  if (!err)
+    {
+      if (reader->done[slot])
+        {
+          *batch = reader->batches[slot];
+          err = reader->errors[slot];
+          reader->batches[slot] = NULL;
+          reader->errors[slot] = SVN_NO_ERROR;
+          reader->done[slot] = FALSE;
+        }
+
+      /* Free the slot for the next batch. */
+      reader->first_batch = index + 1;
+      apr_thread_cond_broadcast(reader->cond);
+    }
+
+  return svn_error_trace(svn_mutex__unlock(reader->mutex, err));
+}
+
+/* Start up to JOBS worker threads in *READER that read the batches of
+   filesystem FS as given by PLAN.  Use POOL for the shared state. */
+static svn_error_t *
+start_stats_reader(stats_reader_t **reader_p,
+                   svn_fs_t *fs,
+                   const batch_plan_t *plan,
+                   int jobs,
+                   apr_pool_t *pool)
+{
+  stats_reader_t *reader = apr_pcalloc(pool, sizeof(*reader));
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_status_t status;
+  int i;
+
+  SVN_ERR(svn_mutex__init(&reader->mutex, TRUE, pool));
+  status = apr_thread_cond_create(&reader->cond, pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create condition variable"));
+
+  if (plan->count < jobs)
+    jobs = plan->count;
+
+  reader->plan = plan;
+  reader->max_jobs = jobs * STATS_WINDOW_PER_THREAD;
+  reader->batches = apr_pcalloc(pool,
+                                reader->max_jobs * sizeof(*reader->batches));
+  reader->errors = apr_pcalloc(pool,
+                               reader->max_jobs * sizeof(*reader->errors));
+  reader->done = apr_pcalloc(pool, reader->max_jobs * sizeof(*reader->done));
+  reader->workers = apr_pcalloc(pool, jobs * sizeof(*reader->workers));
+
+  for (i = 0; i < jobs; i++)
+    {
+      stats_worker_t *worker = &reader->workers[reader->worker_count];
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+
+      worker->reader = reader;
+      worker->pool
+        = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+      worker->chain_cache = create_chain_cache(worker->pool);
+
+      /* FS objects must not be shared between threads.  Leave the work
+         to the other workers or to the main thread if we can't get one. */
+      err = svn_fs_fs__open_instance(&worker->fs, fs, worker->pool,
+                                     iterpool);
+      if (!err)
+        {
+          svn_atomic_inc(&reader->running);
+          status = apr_thread_create(&worker->thread, NULL, stats_thread,
+                                     worker, worker->pool);
+          if (status)
+            svn_atomic_dec(&reader->running);
+          else
+            reader->worker_count++;
+        }
+
+      if (err || status)
+        {
+          svn_error_clear(err);
+          svn_pool_destroy(worker->pool);
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  *reader_p = reader;
+
+  return SVN_NO_ERROR;
+}
+
+/* Stop all worker threads of READER and discard their results. */
+static svn_error_t *
+stop_stats_reader(stats_reader_t *reader)
+{
+  svn_error_t *err;
+  int i;
+
+  svn_atomic_set(&reader->aborted, TRUE);
+  err = svn_mutex__lock(reader->mutex);
+  apr_thread_cond_broadcast(reader->cond);
+  err = svn_mutex__unlock(reader->mutex, err);
+
+  for (i = 0; i < reader->worker_count; i++)
+    {
+      apr_status_t retval;
+      apr_status_t status = apr_thread_join(&retval,
+                                            reader->workers[i].thread);
+      if (status)
+        err = svn_error_compose_create(
+                err, svn_error_wrap_apr(status, _("Can't join stats thread")));
+
+      svn_pool_destroy(reader->workers[i].pool);
+    }
+
+  for (i = 0; i < reader->max_jobs; i++)
+    if (reader->done[i])
+      {
+        svn_error_clear(reader->errors[i]);
+        if (reader->batches[i])
+          svn_pool_destroy(reader->batches[i]->pool);
+      }
+
+  return svn_error_trace(err);
+}
+
+#endif /* APR_HAS_THREADS */
+
 svn_error_t *
 svn_fs_fs__get_stats(svn_fs_fs__stats_t **stats,
                      svn_fs_t *fs,
+                     int jobs,
                      svn_fs_progress_notify_func_t progress_func,
                      void *progress_baton,
                      svn_cancel_func_t cancel_func,
@@ -1382,14 +2419,78 @@ svn_fs_fs__get_stats(svn_fs_fs__stats_t **stats,
                      apr_pool_t *result_pool,
                      apr_pool_t *scratch_pool)
 {
-  query_t *query;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_hash_t *shared_reps = apr_hash_make(scratch_pool);
+  chain_cache_entry_t *chain_cache = NULL;
+  batch_plan_t plan;
+  int i;
+#if APR_HAS_THREADS
+  stats_reader_t *reader = NULL;
+#endif
 
   *stats = create_stats(result_pool);
-  SVN_ERR(create_query(&query, fs, *stats, progress_func, progress_baton,
-                       cancel_func, cancel_baton, scratch_pool,
-                       scratch_pool));
-  SVN_ERR(read_revisions(query, scratch_pool, scratch_pool));
-  aggregate_stats(query->revisions, *stats);
+  SVN_ERR(create_plan(&plan, fs, scratch_pool));
+
+#if APR_HAS_THREADS
+  /* Let worker threads read the batches while we merge them in order. */
+  if (jobs > 1 && plan.count > 1)
+    SVN_ERR(start_stats_reader(&reader, fs, &plan, jobs, scratch_pool));
+#endif
+
+  for (i = 0; i < plan.count; ++i)
+    {
+      svn_revnum_t start_rev, end_rev;
+      stats_batch_t *batch = NULL;
+      svn_error_t *err = SVN_NO_ERROR;
+
+      svn_pool_clear(iterpool);
+      get_batch_range(&start_rev, &end_rev, &plan, i);
+
+      if (cancel_func)
+        err = cancel_func(cancel_baton);
+
+#if APR_HAS_THREADS
+      if (!err && reader)
+        err = wait_for_batch(&batch, reader, i, cancel_func, cancel_baton);
+#endif
+
+      /* Read the batch ourselves, unless some worker thread did it. */
+      if (!err && !batch)
+        {
+          if (!chain_cache)
+            chain_cache = create_chain_cache(scratch_pool);
+
+          err = read_batch(&batch, fs, &plan, start_rev, end_rev,
+                           chain_cache, cancel_func, cancel_baton, iterpool);
+        }
+
+      if (!err)
+        err = merge_batch(*stats, shared_reps, fs, batch, iterpool);
+
+      /* All per-batch data is gone after this. */
+      if (batch)
+        svn_pool_destroy(batch->pool);
+
+      if (err)
+        {
+#if APR_HAS_THREADS
+          if (reader)
+            err = svn_error_compose_create(err, stop_stats_reader(reader));
+#endif
+          return svn_error_trace(err);
+        }
+
+      /* one more batch processed */
+      if (progress_func)
+        progress_func(start_rev, progress_baton, iterpool);
+    }
+
+#if APR_HAS_THREADS
+  if (reader)
+    SVN_ERR(stop_stats_reader(reader));
+#endif
+
+  svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
 }
@@ -313,6 +313,7 @@ svn_fs_fs__noderev_serialize(svn_temp_serializer__context_t *context,
   /* serialize sub-structures */
   svn_fs_fs__id_serialize(context, &noderev->id);
   svn_fs_fs__id_serialize(context, &noderev->predecessor_id);
+  svn_fs_fs__id_serialize(context, &noderev->skip_id);
   serialize_representation(context, &noderev->prop_rep);
   serialize_representation(context, &noderev->data_rep);
 
@@ -343,6 +344,7 @@ svn_fs_fs__noderev_deserialize(void *buffer,
   /* fixup of sub-structures */
   svn_fs_fs__id_deserialize(noderev, (svn_fs_id_t **)&noderev->id);
   svn_fs_fs__id_deserialize(noderev, (svn_fs_id_t **)&noderev->predecessor_id);
+  svn_fs_fs__id_deserialize(noderev, (svn_fs_id_t **)&noderev->skip_id);
   svn_temp_deserializer__resolve(noderev, (void **)&noderev->prop_rep);
   svn_temp_deserializer__resolve(noderev, (void **)&noderev->data_rep);
 
@@ -682,17 +684,11 @@ svn_fs_fs__deserialize_revprops(void **out,
                                 apr_size_t data_len,
                                 apr_pool_t *pool)
 {
-  apr_hash_t *properties;
-  svn_stream_t *stream;
+  apr_hash_t *properties = svn_hash__make(pool);
 
-  svn_string_t buffer;
-  buffer.data = data;
-  buffer.len = data_len;
-
-  stream = svn_stream_from_string(&buffer, pool);
-  properties = svn_hash__make(pool);
-
-  SVN_ERR(svn_hash_read2(properties, stream, SVN_HASH_TERMINATOR, pool));
+  /* DATA is our own copy of the cached buffer.  Parse it in place. */
+  SVN_ERR(svn_hash__parse(properties, data, data_len, SVN_HASH_TERMINATOR,
+                          pool));
 
   /* done */
   *out = properties;
@@ -852,6 +848,22 @@ svn_fs_fs__deserialize_dir_entries(void **out,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__get_noderev_mergeinfo_count(void **out,
+                                       const void *data,
+                                       apr_size_t data_len,
+                                       void *baton,
+                                       apr_pool_t *pool)
+{
+  /* The noderev struct is the root of the serialized data and the
+   * counter is no pointer, i.e. needs no fixup. */
+  const node_revision_t *noderev = data;
+
+  *(apr_int64_t *)out = noderev->mergeinfo_count;
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__get_sharded_offset(void **out,
                               const void *data,
@@ -981,6 +993,31 @@ svn_fs_fs__extract_dir_entry(void **out,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__extract_dir_chunk_no(void **out,
+                                const void *data,
+                                apr_size_t data_len,
+                                void *baton,
+                                apr_pool_t *pool)
+{
+  const dir_data_t *dir_data = data;
+  const char *name = baton;
+  svn_boolean_t found;
+
+  /* resolve the reference to the entries array */
+  const svn_fs_dirent_t * const *entries =
+    svn_temp_deserializer__ptr(data, (const void *const *)&dir_data->entries);
+
+  /* The chunk that starts with NAME or the one before the first chunk
+   * that starts with a larger name. */
+  apr_size_t pos = find_entry((svn_fs_dirent_t **)entries, name,
+                              dir_data->count, &found);
+
+  *(int *)out = found ? (int)pos : (int)pos - 1;
+
+  return SVN_NO_ERROR;
+}
+
 /* Utility function for svn_fs_fs__replace_dir_entry that implements the
  * modification as a simply deserialize / modify / serialize sequence.
  */
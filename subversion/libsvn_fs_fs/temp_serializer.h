@@ -60,6 +60,9 @@ typedef struct
 
   /* the offset within the representation right after reading the window */
   apr_off_t end_offset;
+
+  /* svndiff version used by the window */
+  int ver;
 } svn_fs_fs__raw_cached_window_t;
 
 /**
@@ -239,6 +242,18 @@ svn_fs_fs__deserialize_dir_entries(void **out,
                                    apr_size_t data_len,
                                    apr_pool_t *pool);
 
+/**
+ * Implements #svn_cache__partial_getter_func_t.  Set (apr_int64_t) @a *out
+ * to the mergeinfo count of the serialized node revision @a data and
+ * @a data_len, reading it in place.  @a baton is unused.
+ */
+svn_error_t *
+svn_fs_fs__get_noderev_mergeinfo_count(void **out,
+                                       const void *data,
+                                       apr_size_t data_len,
+                                       void *baton,
+                                       apr_pool_t *pool);
+
 /**
  * Implements #svn_cache__partial_getter_func_t.  Set (apr_off_t) @a *out
  * to the element indexed by (apr_int64_t) @a *baton within the
@@ -297,6 +312,21 @@ svn_fs_fs__extract_dir_entry(void **out,
                              void *baton,
                              apr_pool_t *pool);
 
+/**
+ * Implements #svn_cache__partial_getter_func_t for the index of a
+ * directory that has been cached in chunks.  The index is a serialized
+ * directory containing the first entry of each chunk.  Set (int) @a *out
+ * to the number of the chunk that may contain the entry with the name
+ * given in (const char *) @a baton.  Set it to -1 if that name sorts
+ * before all entries.
+ */
+svn_error_t *
+svn_fs_fs__extract_dir_chunk_no(void **out,
+                                const void *data,
+                                apr_size_t data_len,
+                                void *baton,
+                                apr_pool_t *pool);
+
 /**
  * Describes the change to be done to a directory: Set the entry
  * identify by @a name to the value @a new_entry. If the latter is
@@ -33,6 +33,8 @@
 #include "svn_dirent_uri.h"
 
 #include "fs_fs.h"
+#include "batch_fsync.h"
+#include "changed_paths.h"
 #include "index.h"
 #include "tree.h"
 #include "util.h"
@@ -43,8 +45,10 @@
 #include "lock.h"
 #include "rep-cache.h"
 
+#include "private/svn_delta_private.h"
 #include "private/svn_fs_util.h"
 #include "private/svn_fspath.h"
+#include "private/svn_probes.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_string_private.h"
@@ -88,6 +92,15 @@ path_txn_props(svn_fs_t *fs,
                          PATH_TXN_PROPS, pool);
 }
 
+static APR_INLINE const char *
+path_txn_fragments(svn_fs_t *fs,
+                   const svn_fs_fs__id_part_t *txn_id,
+                   apr_pool_t *pool)
+{
+  return svn_dirent_join(svn_fs_fs__path_txn_dir(fs, txn_id, pool),
+                         PATH_TXN_FRAGMENTS, pool);
+}
+
 static APR_INLINE const char *
 path_txn_next_ids(svn_fs_t *fs,
                   const svn_fs_fs__id_part_t *txn_id,
@@ -97,6 +110,15 @@ path_txn_next_ids(svn_fs_t *fs,
                          PATH_NEXT_IDS, pool);
 }
 
+static APR_INLINE const char *
+path_txn_ids_lock(svn_fs_t *fs,
+                  const svn_fs_fs__id_part_t *txn_id,
+                  apr_pool_t *pool)
+{
+  return svn_dirent_join(svn_fs_fs__path_txn_dir(fs, txn_id, pool),
+                         PATH_TXN_IDS_LOCK, pool);
+}
+
 
 /* The vtable associated with an open transaction object. */
 static txn_vtable_t txn_vtable = {
@@ -548,7 +570,6 @@ store_sha1_rep_mapping(svn_fs_t *fs,
       && noderev->data_rep
       && noderev->data_rep->has_sha1)
     {
-      apr_file_t *rep_file;
       const char *file_name = path_txn_sha1(fs,
                                             &noderev->data_rep->txn_id,
                                             noderev->data_rep->sha1_digest,
@@ -558,14 +579,11 @@ store_sha1_rep_mapping(svn_fs_t *fs,
                                             ffd->format,
                                             (noderev->kind == svn_node_dir),
                                             scratch_pool, scratch_pool);
-      SVN_ERR(svn_io_file_open(&rep_file, file_name,
-                               APR_WRITE | APR_CREATE | APR_TRUNCATE
-                               | APR_BUFFERED, APR_OS_DEFAULT, scratch_pool));
-
-      SVN_ERR(svn_io_file_write_full(rep_file, rep_string->data,
-                                     rep_string->len, NULL, scratch_pool));
 
-      SVN_ERR(svn_io_file_close(rep_file, scratch_pool));
+      /* Concurrent fragment writers may look up the same mapping. */
+      SVN_ERR(svn_io_write_atomic2(file_name, rep_string->data,
+                                   rep_string->len, NULL, FALSE,
+                                   scratch_pool));
     }
 
   return SVN_NO_ERROR;
@@ -987,6 +1005,7 @@ create_new_txn_noderev_from_rev(svn_fs_t *fs,
 
   noderev->predecessor_id = noderev->id;
   noderev->predecessor_count++;
+  noderev->skip_id = NULL;
   noderev->copyfrom_path = NULL;
   noderev->copyfrom_rev = SVN_INVALID_REVNUM;
 
@@ -1345,6 +1364,59 @@ write_next_ids(svn_fs_t *fs,
   return svn_io_file_close(file, pool);
 }
 
+/* Implement with_txn_ids_lock() while being protected by the in-process
+ * ID lock.
+ */
+static svn_error_t *
+with_txn_ids_file_lock(svn_fs_t *fs,
+                       const svn_fs_fs__id_part_t *txn_id,
+                       svn_error_t *(*body)(void *baton,
+                                            apr_pool_t *pool),
+                       void *baton,
+                       apr_pool_t *pool)
+{
+  apr_pool_t *subpool = svn_pool_create(pool);
+  apr_file_t *lockfile;
+  svn_error_t *err;
+
+  /* The lock file gets created on demand. */
+  SVN_ERR(svn_io_file_open(&lockfile, path_txn_ids_lock(fs, txn_id, subpool),
+                           APR_WRITE | APR_CREATE, APR_OS_DEFAULT, subpool));
+  SVN_ERR(svn_io_lock_open_file(lockfile, TRUE, FALSE, subpool));
+
+  err = body(baton, subpool);
+
+  /* This releases the lock as well. */
+  svn_pool_destroy(subpool);
+
+  return svn_error_trace(err);
+}
+
+/* Call BODY with BATON and a scratch pool while holding the lock that
+ * serializes the allocation of node IDs, copy IDs and item indexes in
+ * transaction TXN_ID of FS across threads and processes.  Writers of
+ * proto-rev fragments allocate those without holding the proto-rev lock.
+ * Use POOL for temporaries.
+ *
+ * This lock must not be held while acquiring any other lock.
+ */
+static svn_error_t *
+with_txn_ids_lock(svn_fs_t *fs,
+                  const svn_fs_fs__id_part_t *txn_id,
+                  svn_error_t *(*body)(void *baton,
+                                       apr_pool_t *pool),
+                  void *baton,
+                  apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  SVN_MUTEX__WITH_LOCK(ffd->shared->txn_ids_lock,
+                       with_txn_ids_file_lock(fs, txn_id, body, baton,
+                                              pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Find out what the next unique node-id and copy-id are for
    transaction TXN_ID in filesystem FS.  Store the results in *NODE_ID
    and *COPY_ID.  The next node-id is used both for creating new unique
@@ -1380,6 +1452,45 @@ read_next_ids(apr_uint64_t *node_id,
   return SVN_NO_ERROR;
 }
 
+/* Baton type for bump_next_ids().
+ */
+typedef struct bump_next_ids_baton_t
+{
+  svn_fs_t *fs;
+  const svn_fs_fs__id_part_t *txn_id;
+
+  /* Whether to take the next copy-id rather than the next node-id. */
+  svn_boolean_t copy_id;
+
+  /* The ID number taken. */
+  apr_uint64_t number;
+} bump_next_ids_baton_t;
+
+/* Take the next node-id or copy-id as described by BATON, a
+ * bump_next_ids_baton_t, and update the next-ids file accordingly.
+ * Use POOL for temporaries.  The caller must hold the txn's ID lock.
+ */
+static svn_error_t *
+bump_next_ids(void *baton,
+              apr_pool_t *pool)
+{
+  bump_next_ids_baton_t *b = baton;
+  apr_uint64_t node_id, copy_id;
+
+  /* First read in the current next-ids file. */
+  SVN_ERR(read_next_ids(&node_id, &copy_id, b->fs, b->txn_id, pool));
+
+  if (b->copy_id)
+    b->number = copy_id++;
+  else
+    b->number = node_id++;
+
+  /* Update the ID counter file */
+  SVN_ERR(write_next_ids(b->fs, b->txn_id, node_id, copy_id, pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Get a new and unique to this transaction node-id for transaction
    TXN_ID in filesystem FS.  Store the new node-id in *NODE_ID_P.
    Node-ids are guaranteed to be unique to this transction, but may
@@ -1390,15 +1501,15 @@ get_new_txn_node_id(svn_fs_fs__id_part_t *node_id_p,
                     const svn_fs_fs__id_part_t *txn_id,
                     apr_pool_t *pool)
 {
-  apr_uint64_t node_id, copy_id;
+  bump_next_ids_baton_t baton;
 
-  /* First read in the current next-ids file. */
-  SVN_ERR(read_next_ids(&node_id, &copy_id, fs, txn_id, pool));
+  baton.fs = fs;
+  baton.txn_id = txn_id;
+  baton.copy_id = FALSE;
+  SVN_ERR(with_txn_ids_lock(fs, txn_id, bump_next_ids, &baton, pool));
 
   node_id_p->revision = SVN_INVALID_REVNUM;
-  node_id_p->number = node_id;
-
-  SVN_ERR(write_next_ids(fs, txn_id, ++node_id, copy_id, pool));
+  node_id_p->number = baton.number;
 
   return SVN_NO_ERROR;
 }
@@ -1409,17 +1520,16 @@ svn_fs_fs__reserve_copy_id(svn_fs_fs__id_part_t *copy_id_p,
                            const svn_fs_fs__id_part_t *txn_id,
                            apr_pool_t *pool)
 {
-  apr_uint64_t node_id, copy_id;
+  bump_next_ids_baton_t baton;
 
-  /* First read in the current next-ids file. */
-  SVN_ERR(read_next_ids(&node_id, &copy_id, fs, txn_id, pool));
+  baton.fs = fs;
+  baton.txn_id = txn_id;
+  baton.copy_id = TRUE;
+  SVN_ERR(with_txn_ids_lock(fs, txn_id, bump_next_ids, &baton, pool));
 
   /* this is an in-txn ID now */
   copy_id_p->revision = SVN_INVALID_REVNUM;
-  copy_id_p->number = copy_id;
-
-  /* Update the ID counter file */
-  SVN_ERR(write_next_ids(fs, txn_id, node_id, ++copy_id, pool));
+  copy_id_p->number = baton.number;
 
   return SVN_NO_ERROR;
 }
@@ -1539,6 +1649,26 @@ svn_fs_fs__set_entry(svn_fs_t *fs,
                      const svn_fs_id_t *id,
                      svn_node_kind_t kind,
                      apr_pool_t *pool)
+{
+  apr_array_header_t *entries = apr_array_make(pool, 1,
+                                               sizeof(svn_fs_dirent_t *));
+  svn_fs_dirent_t *entry = apr_pcalloc(pool, sizeof(*entry));
+
+  entry->name = name;
+  entry->id = id;
+  entry->kind = kind;
+  APR_ARRAY_PUSH(entries, svn_fs_dirent_t *) = entry;
+
+  return svn_error_trace(svn_fs_fs__set_entries(fs, txn_id, parent_noderev,
+                                                entries, pool));
+}
+
+svn_error_t *
+svn_fs_fs__set_entries(svn_fs_t *fs,
+                       const svn_fs_fs__id_part_t *txn_id,
+                       node_revision_t *parent_noderev,
+                       const apr_array_header_t *changes,
+                       apr_pool_t *pool)
 {
   representation_t *rep = parent_noderev->data_rep;
   const char *filename
@@ -1548,6 +1678,7 @@ svn_fs_fs__set_entry(svn_fs_t *fs,
   svn_filesize_t filesize;
   fs_fs_data_t *ffd = fs->fsap_data;
   apr_pool_t *subpool = svn_pool_create(pool);
+  int i;
 
   if (!rep || !is_txn_rep(rep))
     {
@@ -1633,20 +1764,17 @@ svn_fs_fs__set_entry(svn_fs_t *fs,
         }
     }
 
-  /* Append an incremental hash entry for the entry change. */
-  if (id)
+  /* Append an incremental hash entry for each entry change. */
+  for (i = 0; i < changes->nelts; ++i)
     {
-      svn_fs_dirent_t entry;
-      entry.name = name;
-      entry.id = id;
-      entry.kind = kind;
+      svn_fs_dirent_t *entry = APR_ARRAY_IDX(changes, i, svn_fs_dirent_t *);
 
-      SVN_ERR(unparse_dir_entry(&entry, out, subpool));
-    }
-  else
-    {
-      SVN_ERR(svn_stream_printf(out, subpool, "D %" APR_SIZE_T_FMT "\n%s\n",
-                                strlen(name), name));
+      if (entry->id)
+        SVN_ERR(unparse_dir_entry(entry, out, subpool));
+      else
+        SVN_ERR(svn_stream_printf(out, subpool,
+                                  "D %" APR_SIZE_T_FMT "\n%s\n",
+                                  strlen(entry->name), entry->name));
     }
 
   /* Flush APR buffers. */
@@ -1660,23 +1788,24 @@ svn_fs_fs__set_entry(svn_fs_t *fs,
   svn_pool_clear(subpool);
 
   /* if we have a directory cache for this transaction, update it */
-  if (ffd->txn_dir_cache)
+  if (ffd->txn_dir_cache && changes->nelts == 1)
     {
       /* build parameters: name, new entry, new file size  */
+      svn_fs_dirent_t *entry = APR_ARRAY_IDX(changes, 0, svn_fs_dirent_t *);
       const char *key =
           svn_fs_fs__id_unparse(parent_noderev->id, subpool)->data;
       replace_baton_t baton;
 
-      baton.name = name;
+      baton.name = entry->name;
       baton.new_entry = NULL;
       baton.txn_filesize = filesize;
 
-      if (id)
+      if (entry->id)
         {
           baton.new_entry = apr_pcalloc(subpool, sizeof(*baton.new_entry));
-          baton.new_entry->name = name;
-          baton.new_entry->kind = kind;
-          baton.new_entry->id = id;
+          baton.new_entry->name = entry->name;
+          baton.new_entry->kind = entry->kind;
+          baton.new_entry->id = entry->id;
         }
 
       /* actually update the cached directory (if cached) */
@@ -1684,6 +1813,15 @@ svn_fs_fs__set_entry(svn_fs_t *fs,
                                      svn_fs_fs__replace_dir_entry, &baton,
                                      subpool));
     }
+  else if (ffd->txn_dir_cache)
+    {
+      /* Rather than patching the cached directory once per entry,
+       * drop it and let the next reader parse the file once. */
+      const char *key =
+          svn_fs_fs__id_unparse(parent_noderev->id, subpool)->data;
+
+      SVN_ERR(svn_cache__set(ffd->txn_dir_cache, key, NULL, subpool));
+    }
 
   svn_pool_destroy(subpool);
   return SVN_NO_ERROR;
@@ -1782,6 +1920,82 @@ store_p2l_index_entry(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
+/* Baton type for next_item_index_body().
+ */
+typedef struct next_item_index_baton_t
+{
+  svn_fs_t *fs;
+  const svn_fs_fs__id_part_t *txn_id;
+
+  /* The item index taken. */
+  apr_uint64_t item_index;
+} next_item_index_baton_t;
+
+/* Implement next_item_index() for BATON, a next_item_index_baton_t,
+ * while holding the txn's ID lock.  Use POOL for allocations.
+ */
+static svn_error_t *
+next_item_index_body(void *baton,
+                     apr_pool_t *pool)
+{
+  next_item_index_baton_t *b = baton;
+  svn_fs_t *fs = b->fs;
+  const svn_fs_fs__id_part_t *txn_id = b->txn_id;
+  apr_uint64_t *item_index = &b->item_index;
+  apr_file_t *file;
+  char buffer[SVN_INT64_BUFFER_SIZE] = { 0 };
+  svn_boolean_t eof = FALSE;
+  apr_size_t to_write;
+  apr_size_t bytes_read;
+  apr_off_t offset = 0;
+
+  /* read number, increment it and write it back to disk */
+  SVN_ERR(svn_io_file_open(&file,
+                     svn_fs_fs__path_txn_item_index(fs, txn_id, pool),
+                     APR_READ | APR_WRITE | APR_CREATE,
+                     APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_read_full2(file, buffer, sizeof(buffer)-1,
+                                 &bytes_read, &eof, pool));
+
+  /* Item index file should be shorter than SVN_INT64_BUFFER_SIZE,
+     otherwise we truncate data. */
+  if (!eof)
+      return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                              _("Unexpected itemidx file length"));
+  else if (bytes_read)
+    SVN_ERR(svn_cstring_atoui64(item_index, buffer));
+  else
+    *item_index = SVN_FS_FS__ITEM_INDEX_FIRST_USER;
+
+  to_write = svn__ui64toa(buffer, *item_index + 1);
+  SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, pool));
+  SVN_ERR(svn_io_file_write_full(file, buffer, to_write, NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Increment the item index counter file of transaction TXN_ID in file
+ * system FS and return its previous value in *ITEM_INDEX.  Use POOL for
+ * allocations.  This function assumes that FS uses logical addressing.
+ */
+static svn_error_t *
+next_item_index(apr_uint64_t *item_index,
+                svn_fs_t *fs,
+                const svn_fs_fs__id_part_t *txn_id,
+                apr_pool_t *pool)
+{
+  next_item_index_baton_t baton;
+
+  baton.fs = fs;
+  baton.txn_id = txn_id;
+  SVN_ERR(with_txn_ids_lock(fs, txn_id, next_item_index_body, &baton,
+                            pool));
+  *item_index = baton.item_index;
+
+  return SVN_NO_ERROR;
+}
+
 /* Allocate an item index for the given MY_OFFSET in the transaction TXN_ID
  * of file system FS and return it in *ITEM_INDEX.  For old formats, it
  * will simply return the offset as item index; in new formats, it will
@@ -1797,35 +2011,7 @@ allocate_item_index(apr_uint64_t *item_index,
 {
   if (svn_fs_fs__use_log_addressing(fs))
     {
-      apr_file_t *file;
-      char buffer[SVN_INT64_BUFFER_SIZE] = { 0 };
-      svn_boolean_t eof = FALSE;
-      apr_size_t to_write;
-      apr_size_t bytes_read;
-      apr_off_t offset = 0;
-
-      /* read number, increment it and write it back to disk */
-      SVN_ERR(svn_io_file_open(&file,
-                         svn_fs_fs__path_txn_item_index(fs, txn_id, pool),
-                         APR_READ | APR_WRITE | APR_CREATE,
-                         APR_OS_DEFAULT, pool));
-      SVN_ERR(svn_io_file_read_full2(file, buffer, sizeof(buffer)-1,
-                                     &bytes_read, &eof, pool));
-
-      /* Item index file should be shorter than SVN_INT64_BUFFER_SIZE,
-         otherwise we truncate data. */
-      if (!eof)
-          return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
-                                  _("Unexpected itemidx file length"));
-      else if (bytes_read)
-        SVN_ERR(svn_cstring_atoui64(item_index, buffer));
-      else
-        *item_index = SVN_FS_FS__ITEM_INDEX_FIRST_USER;
-
-      to_write = svn__ui64toa(buffer, *item_index + 1);
-      SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, pool));
-      SVN_ERR(svn_io_file_write_full(file, buffer, to_write, NULL, pool));
-      SVN_ERR(svn_io_file_close(file, pool));
+      SVN_ERR(next_item_index(item_index, fs, txn_id, pool));
 
       /* write log-to-phys index */
       SVN_ERR(store_l2p_index_entry(fs, txn_id, my_offset, *item_index, pool));
@@ -1838,6 +2024,351 @@ allocate_item_index(apr_uint64_t *item_index,
   return SVN_NO_ERROR;
 }
 
+/* Proto-rev fragments.
+ *
+ * Only one writer at a time may append to the proto-rev file of a txn.
+ * With logical addressing, node-revs refer to representations by item
+ * index only, so file contents don't need to be written to the proto-rev
+ * directly.  If the proto-rev is busy, the contents are written to a
+ * separate fragment file in PATH_TXN_FRAGMENTS instead.  Once complete,
+ * a descriptor file with the fragment's name plus PATH_EXT_FRAGMENT will
+ * be created next to it, containing the item index, size and FNV-1a
+ * checksum of the representation.
+ *
+ * Whoever acquires the proto-rev lock next appends all complete fragments
+ * to the proto-rev and adds the respective index entries.  Every writer
+ * checks for fragments after releasing the proto-rev lock and so does
+ * every fragment writer after publishing its descriptor.  Hence, no
+ * fragment remains unmerged while the proto-rev is not locked.
+ */
+
+/* Create a new, empty fragment file for transaction TXN_ID in FS.  Return
+ * the open file in *FILE and its path in *PATH.  Allocate both in
+ * RESULT_POOL and use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+create_fragment(apr_file_t **file,
+                const char **path,
+                svn_fs_t *fs,
+                const svn_fs_fs__id_part_t *txn_id,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  const char *dir = path_txn_fragments(fs, txn_id, scratch_pool);
+
+  SVN_ERR(svn_io_make_dir_recursively(dir, scratch_pool));
+  SVN_ERR(svn_io_open_unique_file3(file, path, dir, svn_io_file_del_none,
+                                   result_pool, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Mark the fragment at PATH in FS as complete, describing its contents
+ * with the index ENTRY.  Use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+publish_fragment(const char *path,
+                 const svn_fs_fs__p2l_entry_t *entry,
+                 apr_pool_t *scratch_pool)
+{
+  const char *descriptor
+    = apr_psprintf(scratch_pool, "%" APR_UINT64_T_FMT " %s %u\n",
+                   entry->item.number,
+                   apr_off_t_toa(scratch_pool, entry->size),
+                   (unsigned int)entry->fnv1_checksum);
+
+  return svn_error_trace(svn_io_write_atomic2(
+                           apr_pstrcat(scratch_pool, path, PATH_EXT_FRAGMENT,
+                                       SVN_VA_NULL),
+                           descriptor, strlen(descriptor), NULL, FALSE,
+                           scratch_pool));
+}
+
+/* Set *DESCRIPTORS to the names of all complete fragments of transaction
+ * TXN_ID in FS, i.e. an array of const char *.  Allocate the result in
+ * RESULT_POOL and use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+list_fragments(apr_array_header_t **descriptors,
+               svn_fs_t *fs,
+               const svn_fs_fs__id_part_t *txn_id,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  apr_hash_t *dirents;
+  apr_hash_index_t *hi;
+  svn_error_t *err;
+
+  *descriptors = apr_array_make(result_pool, 0, sizeof(const char *));
+  if (!svn_fs_fs__use_log_addressing(fs))
+    return SVN_NO_ERROR;
+
+  err = svn_io_get_dirents3(&dirents,
+                            path_txn_fragments(fs, txn_id, scratch_pool),
+                            TRUE, scratch_pool, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  for (hi = apr_hash_first(scratch_pool, dirents); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = apr_hash_this_key(hi);
+      apr_size_t len = apr_hash_this_key_len(hi);
+
+      if (   len > sizeof(PATH_EXT_FRAGMENT) - 1
+          && !strcmp(name + len - (sizeof(PATH_EXT_FRAGMENT) - 1),
+                     PATH_EXT_FRAGMENT))
+        APR_ARRAY_PUSH(*descriptors, const char *)
+          = apr_pstrdup(result_pool, name);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the fragment descriptor at DESCRIPTOR_PATH and return the item
+ * index, size and FNV-1a checksum stored in it in *ENTRY.  The other
+ * members of *ENTRY remain unchanged.  Use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+read_fragment_descriptor(svn_fs_fs__p2l_entry_t *entry,
+                         const char *descriptor_path,
+                         apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *contents;
+  apr_array_header_t *fields;
+  apr_uint64_t fnv1_checksum;
+  apr_int64_t size;
+
+  SVN_ERR(svn_stringbuf_from_file2(&contents, descriptor_path,
+                                   scratch_pool));
+  fields = svn_cstring_split(contents->data, " \n", TRUE, scratch_pool);
+  if (fields->nelts != 3)
+    return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                             _("Corrupt proto-rev fragment descriptor '%s'"),
+                             svn_dirent_local_style(descriptor_path,
+                                                    scratch_pool));
+
+  SVN_ERR(svn_cstring_atoui64(&entry->item.number,
+                              APR_ARRAY_IDX(fields, 0, const char *)));
+  SVN_ERR(svn_cstring_atoi64(&size, APR_ARRAY_IDX(fields, 1, const char *)));
+  SVN_ERR(svn_cstring_atoui64(&fnv1_checksum,
+                              APR_ARRAY_IDX(fields, 2, const char *)));
+  entry->size = (apr_off_t)size;
+  entry->fnv1_checksum = (apr_uint32_t)fnv1_checksum;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__find_txn_fragment(const char **path,
+                             svn_fs_t *fs,
+                             const svn_fs_fs__id_part_t *txn_id,
+                             apr_uint64_t item_index,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool)
+{
+  const char *dir = path_txn_fragments(fs, txn_id, scratch_pool);
+  apr_array_header_t *descriptors;
+  apr_pool_t *iterpool;
+  int i;
+
+  *path = NULL;
+  SVN_ERR(list_fragments(&descriptors, fs, txn_id, scratch_pool,
+                         scratch_pool));
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < descriptors->nelts; ++i)
+    {
+      const char *descriptor_path;
+      svn_fs_fs__p2l_entry_t entry;
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+      descriptor_path = svn_dirent_join(dir,
+                                        APR_ARRAY_IDX(descriptors, i,
+                                                      const char *),
+                                        iterpool);
+
+      /* The fragment may have been merged in the meantime. */
+      err = read_fragment_descriptor(&entry, descriptor_path, iterpool);
+      if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+        {
+          svn_error_clear(err);
+          continue;
+        }
+      SVN_ERR(err);
+
+      if (entry.item.number == item_index)
+        {
+          *path = apr_pstrmemdup(result_pool, descriptor_path,
+                                 strlen(descriptor_path)
+                                   - (sizeof(PATH_EXT_FRAGMENT) - 1));
+          break;
+        }
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Append the complete fragment described by DESCRIPTOR, a file name in
+ * the fragments directory of transaction TXN_ID in FS, to PROTO_FILE and
+ * remove it.  PROTO_FILE must be locked and positioned at its end.
+ * Use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+merge_fragment(apr_file_t *proto_file,
+               svn_fs_t *fs,
+               const svn_fs_fs__id_part_t *txn_id,
+               const char *descriptor,
+               apr_pool_t *scratch_pool)
+{
+  const char *dir = path_txn_fragments(fs, txn_id, scratch_pool);
+  const char *descriptor_path = svn_dirent_join(dir, descriptor,
+                                                scratch_pool);
+  const char *fragment_path
+    = apr_pstrmemdup(scratch_pool, descriptor_path,
+                     strlen(descriptor_path)
+                       - (sizeof(PATH_EXT_FRAGMENT) - 1));
+  svn_fs_fs__p2l_entry_t entry;
+  svn_stream_t *source;
+  apr_off_t end_offset;
+
+  SVN_ERR(read_fragment_descriptor(&entry, descriptor_path, scratch_pool));
+
+  /* Append the representation to the proto-rev. */
+  SVN_ERR(svn_io_file_get_offset(&entry.offset, proto_file, scratch_pool));
+  SVN_ERR(svn_stream_open_readonly(&source, fragment_path, scratch_pool,
+                                   scratch_pool));
+  SVN_ERR(svn_stream_copy3(source,
+                           svn_stream_from_aprfile2(proto_file, TRUE,
+                                                    scratch_pool),
+                           NULL, NULL, scratch_pool));
+
+  SVN_ERR(svn_io_file_get_offset(&end_offset, proto_file, scratch_pool));
+  if (end_offset - entry.offset != entry.size)
+    return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                             _("Proto-rev fragment '%s' has the wrong size"),
+                             svn_dirent_local_style(fragment_path,
+                                                    scratch_pool));
+
+  /* Index it like a representation written to the proto-rev directly.
+   * The p2l proto index entry decides whether the data counts as part of
+   * the proto-rev, so add it last. */
+  entry.type = SVN_FS_FS__ITEM_TYPE_FILE_REP;
+  entry.item.revision = SVN_INVALID_REVNUM;
+
+  SVN_ERR(store_l2p_index_entry(fs, txn_id, entry.offset, entry.item.number,
+                                scratch_pool));
+  SVN_ERR(store_p2l_index_entry(fs, txn_id, &entry, scratch_pool));
+
+  /* Done with this one. */
+  SVN_ERR(svn_io_remove_file2(descriptor_path, FALSE, scratch_pool));
+  SVN_ERR(svn_io_remove_file2(fragment_path, TRUE, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Append all complete fragments of transaction TXN_ID in FS to the locked
+ * PROTO_FILE, positioned at its end.  Use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+merge_fragments(apr_file_t *proto_file,
+                svn_fs_t *fs,
+                const svn_fs_fs__id_part_t *txn_id,
+                apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *descriptors;
+  apr_pool_t *iterpool;
+  int i;
+
+  SVN_ERR(list_fragments(&descriptors, fs, txn_id, scratch_pool,
+                         scratch_pool));
+  if (descriptors->nelts == 0)
+    return SVN_NO_ERROR;
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < descriptors->nelts; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(merge_fragment(proto_file, fs, txn_id,
+                             APR_ARRAY_IDX(descriptors, i, const char *),
+                             iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Like get_writable_proto_rev but also merge all complete fragments into
+ * the proto-rev before returning it in *FILE.
+ */
+static svn_error_t *
+acquire_proto_rev(apr_file_t **file,
+                  void **lockcookie,
+                  svn_fs_t *fs,
+                  const svn_fs_fs__id_part_t *txn_id,
+                  apr_pool_t *pool)
+{
+  svn_error_t *err;
+
+  SVN_ERR(get_writable_proto_rev(file, lockcookie, fs, txn_id, pool));
+
+  err = merge_fragments(*file, fs, txn_id, pool);
+  if (err)
+    {
+      err = svn_error_compose_create(err, svn_io_file_close(*file, pool));
+      err = svn_error_compose_create(err, unlock_proto_rev(fs, txn_id,
+                                                           *lockcookie,
+                                                           pool));
+      *lockcookie = NULL;
+    }
+
+  return svn_error_trace(err);
+}
+
+/* Merge all complete fragments of transaction TXN_ID in FS into its
+ * proto-rev unless someone else currently holds the proto-rev lock.
+ * In that case, it is up to them to merge the fragments after they
+ * released the lock.  Use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+try_merge_fragments(svn_fs_t *fs,
+                    const svn_fs_fs__id_part_t *txn_id,
+                    apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_array_header_t *descriptors;
+
+  /* More fragments may get completed while we hold the lock. */
+  SVN_ERR(list_fragments(&descriptors, fs, txn_id, iterpool, iterpool));
+  while (descriptors->nelts)
+    {
+      apr_file_t *file;
+      void *lockcookie;
+      svn_error_t *err = acquire_proto_rev(&file, &lockcookie, fs, txn_id,
+                                           iterpool);
+      if (err && err->apr_err == SVN_ERR_FS_REP_BEING_WRITTEN)
+        {
+          svn_error_clear(err);
+          break;
+        }
+      SVN_ERR(err);
+
+      SVN_ERR(svn_io_file_close(file, iterpool));
+      SVN_ERR(unlock_proto_rev(fs, txn_id, lockcookie, iterpool));
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(list_fragments(&descriptors, fs, txn_id, iterpool, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
 /* Baton used by fnv1a_write_handler to calculate the FNV checksum
  * before passing the data on to the INNER_STREAM.
  */
@@ -1935,8 +2466,12 @@ struct rep_write_baton
      writing to it. */
   void *lockcookie;
 
-  svn_checksum_ctx_t *md5_checksum_ctx;
-  svn_checksum_ctx_t *sha1_checksum_ctx;
+  /* If not NULL, FILE is not the proto-rev but the fragment file at this
+     path.  LOCKCOOKIE is NULL then. */
+  const char *fragment_path;
+
+  /* MD5 and SHA1 checksums of the fulltext. */
+  svn_checksum__md5_sha1_ctx_t *checksum_ctx;
 
   /* calculate a modified FNV-1a checksum of the on-disk representation */
   svn_checksum_ctx_t *fnv1a_checksum_ctx;
@@ -1958,8 +2493,7 @@ rep_write_contents(void *baton,
 {
   struct rep_write_baton *b = baton;
 
-  SVN_ERR(svn_checksum_update(b->md5_checksum_ctx, data, *len));
-  SVN_ERR(svn_checksum_update(b->sha1_checksum_ctx, data, *len));
+  SVN_ERR(svn_checksum__md5_sha1_update(b->checksum_ctx, data, *len));
   b->rep_size += *len;
 
   /* If we are writing a delta, use that stream. */
@@ -2026,7 +2560,6 @@ choose_delta_base(representation_t **rep,
   int walk;
   node_revision_t *base;
   fs_fs_data_t *ffd = fs->fsap_data;
-  apr_pool_t *iterpool;
 
   /* If we have no predecessors, or that one is empty, then use the empty
    * stream as a base. */
@@ -2068,20 +2601,11 @@ choose_delta_base(representation_t **rep,
         count = noderev->predecessor_count - 1;
     }
 
-  /* Walk back a number of predecessors equal to the difference
-     between count and the original predecessor count.  (For example,
-     if noderev has ten predecessors and we want the eighth file rev,
-     walk back two predecessors.) */
-  base = noderev;
-  iterpool = svn_pool_create(pool);
-  while ((count++) < noderev->predecessor_count)
-    {
-      svn_pool_clear(iterpool);
-      SVN_ERR(svn_fs_fs__get_node_revision(&base, fs,
-                                           base->predecessor_id, pool,
-                                           iterpool));
-    }
-  svn_pool_destroy(iterpool);
+  /* Walk back to the predecessor with COUNT predecessors of its own.
+     (For example, if noderev has ten predecessors and we want the eighth
+     file rev, walk back two predecessors.)  Skip links make this cheap
+     even for long histories. */
+  SVN_ERR(svn_fs_fs__get_predecessor(&base, fs, noderev, count, pool, pool));
 
   /* return a suitable base representation */
   *rep = props ? base->prop_rep : base->data_rep;
@@ -2102,6 +2626,16 @@ choose_delta_base(representation_t **rep,
           return SVN_NO_ERROR;
         }
 
+      /* Reconstructing and scanning large bases may take much longer
+       * than storing the new contents as a self-compressed fulltext. */
+      if (   !props
+          && ffd->max_delta_base_size
+          && rep_size > ffd->max_delta_base_size)
+        {
+          *rep = NULL;
+          return SVN_NO_ERROR;
+        }
+
       /* Check whether the length of the deltification chain is acceptable.
        * Otherwise, shared reps may form a non-skipping delta chain in
        * extreme cases. */
@@ -2136,6 +2670,24 @@ rep_write_cleanup(void *data)
   struct rep_write_baton *b = data;
   svn_error_t *err;
 
+  /* Fragments are private to this writer and may simply be removed. */
+  if (b->fragment_path)
+    {
+      err = svn_io_file_close(b->file, b->scratch_pool);
+      err = svn_error_compose_create(err,
+                                     svn_io_remove_file2(b->fragment_path,
+                                                         TRUE,
+                                                         b->scratch_pool));
+      if (err)
+        {
+          apr_status_t rc = err->apr_err;
+          svn_error_clear(err);
+          return rc;
+        }
+
+      return APR_SUCCESS;
+    }
+
   /* Truncate and close the protorevfile. */
   err = svn_io_file_trunc(b->file, b->rep_offset, b->scratch_pool);
   err = svn_error_compose_create(err, svn_io_file_close(b->file,
@@ -2176,13 +2728,14 @@ rep_write_get_baton(struct rep_write_baton **wb_p,
   svn_txdelta_window_handler_t wh;
   void *whb;
   fs_fs_data_t *ffd = fs->fsap_data;
-  int diff_version = ffd->format >= SVN_FS_FS__MIN_SVNDIFF1_FORMAT ? 1 : 0;
+  int diff_version = ffd->delta_svndiff_version;
   svn_fs_fs__rep_header_t header = { 0 };
+  const svn_fs_fs__id_part_t *txn_id = svn_fs_fs__id_txn_id(noderev->id);
+  svn_error_t *err;
 
   b = apr_pcalloc(pool, sizeof(*b));
 
-  b->sha1_checksum_ctx = svn_checksum_ctx_create(svn_checksum_sha1, pool);
-  b->md5_checksum_ctx = svn_checksum_ctx_create(svn_checksum_md5, pool);
+  b->checksum_ctx = svn_checksum__md5_sha1_ctx_create(pool);
 
   b->fs = fs;
   b->result_pool = pool;
@@ -2190,10 +2743,20 @@ rep_write_get_baton(struct rep_write_baton **wb_p,
   b->rep_size = 0;
   b->noderev = noderev;
 
-  /* Open the prototype rev file and seek to its end. */
-  SVN_ERR(get_writable_proto_rev(&file, &b->lockcookie,
-                                 fs, svn_fs_fs__id_txn_id(noderev->id),
-                                 b->scratch_pool));
+  /* Open the prototype rev file and seek to its end.  If someone else is
+     writing to it, write to a fragment that gets merged later. */
+  err = acquire_proto_rev(&file, &b->lockcookie, fs, txn_id,
+                          b->scratch_pool);
+  if (   err
+      && err->apr_err == SVN_ERR_FS_REP_BEING_WRITTEN
+      && svn_fs_fs__use_log_addressing(fs))
+    {
+      svn_error_clear(err);
+      b->lockcookie = NULL;
+      err = create_fragment(&file, &b->fragment_path, fs, txn_id,
+                            b->scratch_pool, b->scratch_pool);
+    }
+  SVN_ERR(err);
 
   b->file = file;
   b->rep_stream = svn_stream_from_aprfile2(file, TRUE, b->scratch_pool);
@@ -2239,8 +2802,12 @@ rep_write_get_baton(struct rep_write_baton **wb_p,
                           ffd->delta_compression_level,
                           pool);
 
-  b->delta_stream = svn_txdelta_target_push(wh, whb, source,
-                                            b->scratch_pool);
+  if (ffd->content_defined_windows)
+    b->delta_stream = svn_txdelta__target_push_cdc(wh, whb, source,
+                                                   b->scratch_pool);
+  else
+    b->delta_stream = svn_txdelta_target_push(wh, whb, source,
+                                              b->scratch_pool);
 
   *wb_p = b;
 
@@ -2415,6 +2982,24 @@ digests_final(representation_t *rep,
   return SVN_NO_ERROR;
 }
 
+/* Set the MD5 and SHA1 digests in REP to those calculated by CTX.
+ * Use POOL for allocations.
+ */
+static svn_error_t *
+md5_sha1_digests_final(representation_t *rep,
+                       const svn_checksum__md5_sha1_ctx_t *ctx,
+                       apr_pool_t *pool)
+{
+  svn_checksum_t *md5, *sha1;
+
+  SVN_ERR(svn_checksum__md5_sha1_final(&md5, &sha1, ctx, pool));
+  memcpy(rep->md5_digest, md5->digest, svn_checksum_size(md5));
+  memcpy(rep->sha1_digest, sha1->digest, svn_checksum_size(sha1));
+  rep->has_sha1 = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
 /* Close handler for the representation write stream.  BATON is a
    rep_write_baton.  Writes out a new node-rev that correctly
    references the representation we just finished writing. */
@@ -2444,8 +3029,7 @@ rep_write_contents_close(void *baton)
   rep->revision = SVN_INVALID_REVNUM;
 
   /* Finalize the checksum. */
-  SVN_ERR(digests_final(rep, b->md5_checksum_ctx, b->sha1_checksum_ctx,
-                        b->result_pool));
+  SVN_ERR(md5_sha1_digests_final(rep, b->checksum_ctx, b->result_pool));
 
   /* Check and see if we already have a representation somewhere that's
      identical to the one we just wrote out. */
@@ -2462,10 +3046,15 @@ rep_write_contents_close(void *baton)
     }
   else
     {
-      /* Write out our cosmetic end marker. */
+      /* Write out our cosmetic end marker.  Fragments get their l2p
+         index entry once we know their final offset. */
       SVN_ERR(svn_stream_puts(b->rep_stream, "ENDREP\n"));
-      SVN_ERR(allocate_item_index(&rep->item_index, b->fs, &rep->txn_id,
-                                  b->rep_offset, b->scratch_pool));
+      if (b->fragment_path)
+        SVN_ERR(next_item_index(&rep->item_index, b->fs, &rep->txn_id,
+                                b->scratch_pool));
+      else
+        SVN_ERR(allocate_item_index(&rep->item_index, b->fs, &rep->txn_id,
+                                    b->rep_offset, b->scratch_pool));
 
       b->noderev->data_rep = rep;
     }
@@ -2473,9 +3062,8 @@ rep_write_contents_close(void *baton)
   /* Remove cleanup callback. */
   apr_pool_cleanup_kill(b->scratch_pool, b, rep_write_cleanup);
 
-  /* Write out the new node-rev information. */
-  SVN_ERR(svn_fs_fs__put_node_revision(b->fs, b->noderev->id, b->noderev,
-                                       FALSE, b->scratch_pool));
+  /* Index the rep before the node-rev refers to it, so readers will find
+     it either in the proto-rev or as a pending fragment. */
   if (!old_rep && svn_fs_fs__use_log_addressing(b->fs))
     {
       svn_fs_fs__p2l_entry_t entry;
@@ -2490,19 +3078,50 @@ rep_write_contents_close(void *baton)
                                       b->fnv1a_checksum_ctx,
                                       b->scratch_pool));
 
-      SVN_ERR(store_p2l_index_entry(b->fs, &rep->txn_id, &entry,
-                                    b->scratch_pool));
+      if (b->fragment_path)
+        {
+          SVN_ERR(svn_io_file_close(b->file, b->scratch_pool));
+          SVN_ERR(publish_fragment(b->fragment_path, &entry,
+                                   b->scratch_pool));
+        }
+      else
+        {
+          SVN_ERR(store_p2l_index_entry(b->fs, &rep->txn_id, &entry,
+                                        b->scratch_pool));
+        }
     }
 
-  SVN_ERR(svn_io_file_close(b->file, b->scratch_pool));
+  /* Write out the new node-rev information. */
+  SVN_ERR(svn_fs_fs__put_node_revision(b->fs, b->noderev->id, b->noderev,
+                                       FALSE, b->scratch_pool));
+
+  if (b->fragment_path)
+    {
+      /* Unless published above, the fragment is of no further use. */
+      if (old_rep)
+        {
+          SVN_ERR(svn_io_file_close(b->file, b->scratch_pool));
+          SVN_ERR(svn_io_remove_file2(b->fragment_path, TRUE,
+                                      b->scratch_pool));
+        }
+    }
+  else
+    {
+      SVN_ERR(svn_io_file_close(b->file, b->scratch_pool));
+    }
 
   /* Write the sha1->rep mapping *after* we successfully written node
    * revision to disk. */
   if (!old_rep)
     SVN_ERR(store_sha1_rep_mapping(b->fs, b->noderev, b->scratch_pool));
 
-  SVN_ERR(unlock_proto_rev(b->fs, &rep->txn_id, b->lockcookie,
-                           b->scratch_pool));
+  if (!b->fragment_path)
+    SVN_ERR(unlock_proto_rev(b->fs, &rep->txn_id, b->lockcookie,
+                             b->scratch_pool));
+
+  /* Fragments completed while we held the lock as well as our own one
+     need to be merged into the proto-rev. */
+  SVN_ERR(try_merge_fragments(b->fs, &rep->txn_id, b->scratch_pool));
   svn_pool_destroy(b->scratch_pool);
 
   return SVN_NO_ERROR;
@@ -2810,7 +3429,7 @@ write_container_delta_rep(representation_t *rep,
 
   struct write_container_baton *whb;
   fs_fs_data_t *ffd = fs->fsap_data;
-  int diff_version = ffd->format >= SVN_FS_FS__MIN_SVNDIFF1_FORMAT ? 1 : 0;
+  int diff_version = ffd->delta_svndiff_version;
   svn_boolean_t is_props = (item_type == SVN_FS_FS__ITEM_TYPE_FILE_PROPS)
                         || (item_type == SVN_FS_FS__ITEM_TYPE_DIR_PROPS);
 
@@ -2997,6 +3616,32 @@ get_final_id(svn_fs_fs__id_part_t *part,
     }
 }
 
+/* Set the skip link of NODEREV in FS to its predecessor with
+   PREDECESSOR_COUNT & (PREDECESSOR_COUNT - 1) predecessors, unless that
+   is the immediate predecessor anyway or the format does not support
+   skip links.  Use POOL for allocations. */
+static svn_error_t *
+set_skip_predecessor(svn_fs_t *fs,
+                     node_revision_t *noderev,
+                     apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  int count = noderev->predecessor_count & (noderev->predecessor_count - 1);
+  node_revision_t *skip;
+
+  noderev->skip_id = NULL;
+  if (   ffd->format < SVN_FS_FS__MIN_SKIP_PREDECESSOR_FORMAT
+      || noderev->predecessor_id == NULL
+      || count >= noderev->predecessor_count - 1)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_fs__get_predecessor(&skip, fs, noderev, count, pool,
+                                     pool));
+  noderev->skip_id = skip->id;
+
+  return SVN_NO_ERROR;
+}
+
 /* Copy a node-revision specified by id ID in fileystem FS from a
    transaction into the proto-rev-file FILE.  Set *NEW_ID_P to a
    pointer to the new node-id which will be allocated in POOL.
@@ -3199,6 +3844,9 @@ write_final_rev(const svn_fs_id_t **new_id_p,
 
   noderev->id = new_id;
 
+  /* Record a shortcut into the node's history. */
+  SVN_ERR(set_skip_predecessor(fs, noderev, pool));
+
   if (ffd->rep_sharing_allowed)
     {
       /* Save the data representation's hash in the rep cache. */
@@ -3375,31 +4023,66 @@ verify_as_revision_before_current_plus_plus(svn_fs_t *fs,
 
 /* Update the 'current' file to hold the correct next node and copy_ids
    from transaction TXN_ID in filesystem FS.  The current revision is
-   set to REV.  Perform temporary allocations in POOL. */
+   set to REV.
+
+   Before replacing 'current', flush all changes scheduled in BATCH to
+   disk together with the new contents.  Afterwards, schedule the update
+   of 'current' in BATCH and, unless FS is in group commit mode, flush it
+   as well.  Perform temporary allocations in POOL. */
 static svn_error_t *
 write_final_current(svn_fs_t *fs,
                     const svn_fs_fs__id_part_t *txn_id,
                     svn_revnum_t rev,
                     apr_uint64_t start_node_id,
                     apr_uint64_t start_copy_id,
+                    svn_fs_fs__batch_fsync_t *batch,
                     apr_pool_t *pool)
 {
   apr_uint64_t txn_node_id;
   apr_uint64_t txn_copy_id;
   fs_fs_data_t *ffd = fs->fsap_data;
+  const char *current_filename = svn_fs_fs__path_current(fs, pool);
+  const char *next_filename = svn_fs_fs__path_next(fs, pool);
+  const char *buf;
+  apr_file_t *file;
 
   if (ffd->format >= SVN_FS_FS__MIN_NO_GLOBAL_IDS_FORMAT)
-    return svn_fs_fs__write_current(fs, rev, 0, 0, pool);
+    {
+      start_node_id = 0;
+      start_copy_id = 0;
+    }
+  else
+    {
+      /* To find the next available ids, we add the id that used to be in
+         the 'current' file, to the next ids from the transaction file. */
+      SVN_ERR(read_next_ids(&txn_node_id, &txn_copy_id, fs, txn_id, pool));
+
+      start_node_id += txn_node_id;
+      start_copy_id += txn_copy_id;
+    }
+
+  /* Write the 'next' file.  It may be left over from a failed commit. */
+  buf = svn_fs_fs__unparse_current(fs, rev, start_node_id, start_copy_id,
+                                   pool);
+  SVN_ERR(svn_fs_fs__batch_fsync_open_file(&file, batch, next_filename,
+                                           pool));
+  SVN_ERR(svn_io_file_trunc(file, 0, pool));
+  SVN_ERR(svn_io_file_write_full(file, buf, strlen(buf), NULL, pool));
+  SVN_ERR(svn_io_copy_perms(current_filename, next_filename, pool));
 
-  /* To find the next available ids, we add the id that used to be in
-     the 'current' file, to the next ids from the transaction file. */
-  SVN_ERR(read_next_ids(&txn_node_id, &txn_copy_id, fs, txn_id, pool));
+  /* Commit all changes to disk. */
+  SVN_ERR(svn_fs_fs__batch_fsync_run(batch, pool));
 
-  start_node_id += txn_node_id;
-  start_copy_id += txn_copy_id;
+  /* Make the revision visible to all processes and threads. */
+  SVN_ERR(svn_io_file_rename2(next_filename, current_filename, FALSE, pool));
+  SVN_ERR(svn_fs_fs__batch_fsync_new_path(batch, current_filename, pool));
 
-  return svn_fs_fs__write_current(fs, rev, start_node_id, start_copy_id,
-                                  pool);
+  /* Make the new revision permanently visible.  In group commit mode,
+     svn_fs_fs__commit does that after releasing the write lock. */
+  if (!ffd->group_commit)
+    SVN_ERR(svn_fs_fs__batch_fsync_run(batch, pool));
+
+  return SVN_NO_ERROR;
 }
 
 /* Verify that the user registered with FS has all the locks necessary to
@@ -3475,13 +4158,14 @@ verify_locks(svn_fs_t *fs,
 }
 
 /* Writes final revision properties to file PATH applying permissions
-   from file PERMS_REFERENCE. This involves setting svn:date and
-   removing any temporary properties associated with the commit flags. */
+   from file PERMS_REFERENCE and schedules it for fsync in BATCH.  This
+   involves setting svn:date and removing any temporary properties
+   associated with the commit flags. */
 static svn_error_t *
 write_final_revprop(const char *path,
                     const char *perms_reference,
                     svn_fs_txn_t *txn,
-                    svn_boolean_t flush_to_disk,
+                    svn_fs_fs__batch_fsync_t *batch,
                     apr_pool_t *pool)
 {
   apr_hash_t *txnprops;
@@ -3511,19 +4195,19 @@ write_final_revprop(const char *path,
       svn_hash_sets(txnprops, SVN_PROP_REVISION_DATE, &date);
     }
 
-  /* Create new revprops file. Tell OS to truncate existing file,
-     since  file may already exists from failed transaction. */
-  SVN_ERR(svn_io_file_open(&revprop_file, path,
-                           APR_WRITE | APR_CREATE | APR_TRUNCATE
-                           | APR_BUFFERED, APR_OS_DEFAULT, pool));
+  /* Create new revprops file. Truncate existing file, since file may
+     already exists from failed transaction. */
+  SVN_ERR(svn_fs_fs__batch_fsync_open_file(&revprop_file, batch, path,
+                                           pool));
+  SVN_ERR(svn_io_file_trunc(revprop_file, 0, pool));
 
   stream = svn_stream_from_aprfile2(revprop_file, TRUE, pool);
   SVN_ERR(svn_hash_write2(txnprops, stream, SVN_HASH_TERMINATOR, pool));
   SVN_ERR(svn_stream_close(stream));
 
-  if (flush_to_disk)
-    SVN_ERR(svn_io_file_flush_to_disk(revprop_file, pool));
-  SVN_ERR(svn_io_file_close(revprop_file, pool));
+  /* BATCH keeps the file open.  Make its contents visible to readers
+     already, e.g. for the verification in SVN_DEBUG mode. */
+  SVN_ERR(svn_io_file_flush(revprop_file, pool));
 
   SVN_ERR(svn_io_copy_perms(perms_reference, path, pool));
 
@@ -3611,6 +4295,7 @@ struct commit_baton {
   svn_revnum_t *new_rev_p;
   svn_fs_t *fs;
   svn_fs_txn_t *txn;
+  svn_fs_fs__batch_fsync_t *batch;
   apr_array_header_t *reps_to_cache;
   apr_hash_t *reps_hash;
   apr_pool_t *reps_pool;
@@ -3624,13 +4309,14 @@ commit_body(void *baton, apr_pool_t *pool)
 {
   struct commit_baton *cb = baton;
   fs_fs_data_t *ffd = cb->fs->fsap_data;
+  svn_fs_fs__batch_fsync_t *batch = cb->batch;
   const char *old_rev_filename, *rev_filename, *proto_filename;
   const char *revprop_filename;
   const svn_fs_id_t *root_id, *new_root_id;
   apr_uint64_t start_node_id;
   apr_uint64_t start_copy_id;
   svn_revnum_t old_rev, new_rev;
-  apr_file_t *proto_file;
+  apr_file_t *proto_file, *rev_file;
   void *proto_file_lockcookie;
   apr_off_t initial_offset, changed_path_offset;
   const svn_fs_fs__id_part_t *txn_id = svn_fs_fs__txn_get_id(cb->txn);
@@ -3652,6 +4338,7 @@ commit_body(void *baton, apr_pool_t *pool)
      mode for the final rev.  We must be sure to detect that cause because
      the failure would only manifest once the new revision got committed.
    */
+  SVN_PROBE2(fsfs__commit__phase, cb->txn->id, "verify");
   SVN_ERR(svn_fs_fs__read_format_file(cb->fs, pool));
 
   /* Read the current youngest revision and, possibly, the next available
@@ -3682,8 +4369,9 @@ commit_body(void *baton, apr_pool_t *pool)
   new_rev = old_rev + 1;
 
   /* Get a write handle on the proto revision file. */
-  SVN_ERR(get_writable_proto_rev(&proto_file, &proto_file_lockcookie,
-                                 cb->fs, txn_id, pool));
+  SVN_PROBE2(fsfs__commit__phase, cb->txn->id, "write-rev");
+  SVN_ERR(acquire_proto_rev(&proto_file, &proto_file_lockcookie,
+                            cb->fs, txn_id, pool));
   SVN_ERR(svn_io_file_get_offset(&initial_offset, proto_file, pool));
 
   /* Write out all the node-revisions and directory contents. */
@@ -3694,6 +4382,7 @@ commit_body(void *baton, apr_pool_t *pool)
                           cb->reps_pool, TRUE, pool));
 
   /* Write the changed-path information. */
+  SVN_PROBE2(fsfs__commit__phase, cb->txn->id, "write-changes");
   SVN_ERR(write_final_changed_path_info(&changed_path_offset, proto_file,
                                         cb->fs, txn_id, changed_paths,
                                         pool));
@@ -3719,8 +4408,7 @@ commit_body(void *baton, apr_pool_t *pool)
                                      NULL, pool));
     }
 
-  if (ffd->flush_to_disk)
-    SVN_ERR(svn_io_file_flush_to_disk(proto_file, pool));
+  /* BATCH will flush the contents to disk once the file is in place. */
   SVN_ERR(svn_io_file_close(proto_file, pool));
 
   /* We don't unlock the prototype revision file immediately to avoid a
@@ -3745,6 +4433,7 @@ commit_body(void *baton, apr_pool_t *pool)
                                                     PATH_REVS_DIR,
                                                     pool),
                                     new_dir, pool));
+          SVN_ERR(svn_fs_fs__batch_fsync_new_path(batch, new_dir, pool));
         }
 
       /* Create the revprops shard. */
@@ -3761,6 +4450,7 @@ commit_body(void *baton, apr_pool_t *pool)
                                                     PATH_REVPROPS_DIR,
                                                     pool),
                                     new_dir, pool));
+          SVN_ERR(svn_fs_fs__batch_fsync_new_path(batch, new_dir, pool));
         }
     }
 
@@ -3769,12 +4459,19 @@ commit_body(void *baton, apr_pool_t *pool)
      ### This "breaks" the transaction by removing the protorev file
      ### but the revision is not yet complete.  If this commit does
      ### not complete for any reason the transaction will be lost. */
+  SVN_PROBE2(fsfs__commit__phase, cb->txn->id, "move-into-place");
   old_rev_filename = svn_fs_fs__path_rev_absolute(cb->fs, old_rev, pool);
   rev_filename = svn_fs_fs__path_rev(cb->fs, new_rev, pool);
   proto_filename = svn_fs_fs__path_txn_proto_rev(cb->fs, txn_id, pool);
+
+  /* Keep the proto-rev permissions until BATCH holds a writable handle
+     to the final rev file.  Only then make it read-only. */
   SVN_ERR(svn_fs_fs__move_into_place(proto_filename, rev_filename,
-                                     old_rev_filename, ffd->flush_to_disk,
-                                     pool));
+                                     proto_filename, FALSE, pool));
+  SVN_ERR(svn_fs_fs__batch_fsync_open_file(&rev_file, batch, rev_filename,
+                                           pool));
+  SVN_ERR(svn_fs_fs__batch_fsync_new_path(batch, rev_filename, pool));
+  SVN_ERR(svn_io_copy_perms(old_rev_filename, rev_filename, pool));
 
   /* Now that we've moved the prototype revision file out of the way,
      we can unlock it (since further attempts to write to the file
@@ -3786,12 +4483,13 @@ commit_body(void *baton, apr_pool_t *pool)
   SVN_ERR_ASSERT(! svn_fs_fs__is_packed_revprop(cb->fs, new_rev));
   revprop_filename = svn_fs_fs__path_revprops(cb->fs, new_rev, pool);
   SVN_ERR(write_final_revprop(revprop_filename, old_rev_filename,
-                              cb->txn, ffd->flush_to_disk, pool));
+                              cb->txn, batch, pool));
 
   /* Update the 'current' file. */
+  SVN_PROBE2(fsfs__commit__phase, cb->txn->id, "write-current");
   SVN_ERR(verify_as_revision_before_current_plus_plus(cb->fs, new_rev, pool));
   SVN_ERR(write_final_current(cb->fs, txn_id, new_rev, start_node_id,
-                              start_copy_id, pool));
+                              start_copy_id, batch, pool));
 
   /* At this point the new revision is committed and globally visible
      so let the caller know it succeeded by giving it the new revision
@@ -3801,27 +4499,39 @@ commit_body(void *baton, apr_pool_t *pool)
   *cb->new_rev_p = new_rev;
 
   ffd->youngest_rev_cache = new_rev;
+  SVN_PROBE2(fsfs__commit__phase, cb->txn->id, "post-commit");
 
   /* Make the directory contents alreday cached for the new revision
    * visible. */
   SVN_ERR(promote_cached_directories(cb->fs, directory_ids, pool));
 
+  /* Keep the changed paths index, if enabled, up to date. */
+  SVN_ERR(svn_fs_fs__changed_paths_index_add(cb->fs, new_rev, changed_paths,
+                                             pool));
+
   /* Remove this transaction directory. */
   SVN_ERR(svn_fs_fs__purge_txn(cb->fs, cb->txn->id, pool));
 
   return SVN_NO_ERROR;
 }
 
+/* Maximum number of rep-cache entries to add in a single SQLite
+ * transaction.  Other writers will be blocked while we add them. */
+#define REPS_TO_CACHE_BATCH_SIZE 1024
+
 /* Add the representations in REPS_TO_CACHE (an array of representation_t *)
- * to the rep-cache database of FS. */
+ * from index FIRST up to but not including index LAST to the rep-cache
+ * database of FS. */
 static svn_error_t *
 write_reps_to_cache(svn_fs_t *fs,
                     const apr_array_header_t *reps_to_cache,
+                    int first,
+                    int last,
                     apr_pool_t *scratch_pool)
 {
   int i;
 
-  for (i = 0; i < reps_to_cache->nelts; i++)
+  for (i = first; i < last; i++)
     {
       representation_t *rep = APR_ARRAY_IDX(reps_to_cache, i, representation_t *);
 
@@ -3839,11 +4549,20 @@ svn_fs_fs__commit(svn_revnum_t *new_rev_p,
 {
   struct commit_baton cb;
   fs_fs_data_t *ffd = fs->fsap_data;
+  svn_error_t *err;
+
+  *new_rev_p = SVN_INVALID_REVNUM;
 
   cb.new_rev_p = new_rev_p;
   cb.fs = fs;
   cb.txn = txn;
 
+  /* Use this to force all data to be flushed to physical storage
+     (to the degree our environment will allow).  It must outlive the
+     write lock in group commit mode. */
+  SVN_ERR(svn_fs_fs__batch_fsync_create(&cb.batch, ffd->flush_to_disk,
+                                        pool));
+
   if (ffd->rep_sharing_allowed)
     {
       cb.reps_to_cache = apr_array_make(pool, 5, sizeof(representation_t *));
@@ -3857,42 +4576,66 @@ svn_fs_fs__commit(svn_revnum_t *new_rev_p,
       cb.reps_pool = NULL;
     }
 
-  SVN_ERR(svn_fs_fs__with_write_lock(fs, commit_body, &cb, pool));
+  SVN_PROBE2(fsfs__commit__start, txn->id, txn->base_rev);
+  err = svn_fs_fs__with_write_lock(fs, commit_body, &cb, pool);
+
+  /* In group commit mode, the update of 'current' has not been flushed
+     to disk, yet.  Share that fsync with concurrent committers. */
+  if (ffd->group_commit && SVN_IS_VALID_REVNUM(*new_rev_p))
+    {
+      svn_fs_fs__fsync_group_t *group = ffd->shared->current_fsync_group;
+      svn_error_t *flush_err
+        = svn_fs_fs__batch_fsync_run_grouped(cb.batch, group, pool);
+
+      err = svn_error_compose_create(err, flush_err);
+    }
+  SVN_ERR(err);
 
   /* At this point, *NEW_REV_P has been set, so errors below won't affect
      the success of the commit.  (See svn_fs_commit_txn().)  */
 
   if (ffd->rep_sharing_allowed)
     {
-      svn_error_t *err;
+      int first;
 
+      SVN_PROBE2(fsfs__commit__phase, txn->id, "rep-cache");
       SVN_ERR(svn_fs_fs__open_rep_cache(fs, pool));
 
       /* Write new entries to the rep-sharing database.
        *
-       * We use an sqlite transaction to speed things up;
+       * We use sqlite transactions to speed things up;
        * see <http://www.sqlite.org/faq.html#q19>.
+       *
+       * Write in batches, such that a commit that touches thousands of
+       * files will not starve other (reader/writer) commits.
        */
-      /* ### A commit that touches thousands of files will starve other
-             (reader/writer) commits for the duration of the below call.
-             Maybe write in batches? */
-      SVN_ERR(svn_sqlite__begin_transaction(ffd->rep_cache_db));
-      err = write_reps_to_cache(fs, cb.reps_to_cache, pool);
-      err = svn_sqlite__finish_transaction(ffd->rep_cache_db, err);
-
-      if (svn_error_find_cause(err, SVN_ERR_SQLITE_ROLLBACK_FAILED))
+      for (first = 0; first < cb.reps_to_cache->nelts;
+           first += REPS_TO_CACHE_BATCH_SIZE)
         {
-          /* Failed rollback means that our db connection is unusable, and
-             the only thing we can do is close it.  The connection will be
-             reopened during the next operation with rep-cache.db. */
-          return svn_error_trace(
-              svn_error_compose_create(err,
-                                       svn_fs_fs__close_rep_cache(fs)));
+          int last = MIN(first + REPS_TO_CACHE_BATCH_SIZE,
+                         cb.reps_to_cache->nelts);
+
+          SVN_ERR(svn_sqlite__begin_transaction(ffd->rep_cache_db));
+          err = write_reps_to_cache(fs, cb.reps_to_cache, first, last, pool);
+          err = svn_sqlite__finish_transaction(ffd->rep_cache_db, err);
+
+          if (svn_error_find_cause(err, SVN_ERR_SQLITE_ROLLBACK_FAILED))
+            {
+              /* Failed rollback means that our db connection is unusable,
+                 and the only thing we can do is close it.  The connection
+                 will be reopened during the next operation with
+                 rep-cache.db. */
+              return svn_error_trace(
+                  svn_error_compose_create(err,
+                                           svn_fs_fs__close_rep_cache(fs)));
+            }
+          else if (err)
+            return svn_error_trace(err);
         }
-      else if (err)
-        return svn_error_trace(err);
     }
 
+  SVN_PROBE2(fsfs__commit__done, txn->id, *new_rev_p);
+
   return SVN_NO_ERROR;
 }
 
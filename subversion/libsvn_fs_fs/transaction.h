@@ -136,6 +136,16 @@ svn_fs_fs__set_entry(svn_fs_t *fs,
                      svn_node_kind_t kind,
                      apr_pool_t *pool);
 
+/* Like svn_fs_fs__set_entry() but apply all CHANGES, an array of
+   svn_fs_dirent_t *, in one go.  An entry with a NULL id removes the
+   entry of that name.  Allocations are done in POOL. */
+svn_error_t *
+svn_fs_fs__set_entries(svn_fs_t *fs,
+                       const svn_fs_fs__id_part_t *txn_id,
+                       node_revision_t *parent_noderev,
+                       const apr_array_header_t *changes,
+                       apr_pool_t *pool);
+
 /* Add a change to the changes record for filesystem FS in transaction
    TXN_ID.  Mark path PATH, having node-id ID, as changed according to
    the type in CHANGE_KIND.  If the text representation was changed set
@@ -158,6 +168,18 @@ svn_fs_fs__add_change(svn_fs_t *fs,
                       const char *copyfrom_path,
                       apr_pool_t *pool);
 
+/* Find the complete but not yet merged proto-rev fragment containing
+   the item ITEM_INDEX of transaction TXN_ID in FS and return its path
+   in *PATH, allocated in RESULT_POOL.  Set *PATH to NULL if there is
+   no such fragment.  Use SCRATCH_POOL for temporaries. */
+svn_error_t *
+svn_fs_fs__find_txn_fragment(const char **path,
+                             svn_fs_t *fs,
+                             const svn_fs_fs__id_part_t *txn_id,
+                             apr_uint64_t item_index,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool);
+
 /* Return a writable stream in *STREAM that allows storing the text
    representation of node-revision NODEREV in filesystem FS.
    Allocations are from POOL. */
@@ -55,6 +55,7 @@
 #include "cached_data.h"
 #include "dag.h"
 #include "lock.h"
+#include "mergeinfo-index.h"
 #include "tree.h"
 #include "fs_fs.h"
 #include "id.h"
@@ -67,6 +68,7 @@
 #include "private/svn_subr_private.h"
 #include "private/svn_fs_util.h"
 #include "private/svn_fspath.h"
+#include "private/svn_sorts_private.h"
 #include "../libsvn_fs/fs-loader.h"
 
 
@@ -195,18 +197,22 @@ svn_fs_fs__create_dag_cache(apr_pool_t *pool)
   return result;
 }
 
-/* Clears the CACHE at regular intervals (destroying all cached nodes)
+/* Clears the CACHE at regular intervals (destroying all cached nodes).
+ * Return TRUE if the cache got cleared and previously obtained references
+ * to cache contents have become invalid.
  */
-static void
+static svn_boolean_t
 auto_clear_dag_cache(fs_fs_dag_cache_t* cache)
 {
-  if (cache->insertions > BUCKET_COUNT)
-    {
-      svn_pool_clear(cache->pool);
+  if (cache->insertions <= BUCKET_COUNT)
+    return FALSE;
 
-      memset(cache->buckets, 0, sizeof(cache->buckets));
-      cache->insertions = 0;
-    }
+  svn_pool_clear(cache->pool);
+
+  memset(cache->buckets, 0, sizeof(cache->buckets));
+  cache->insertions = 0;
+
+  return TRUE;
 }
 
 /* Returns a 32 bit hash value for the given REVISION and PATH of exactly
@@ -271,16 +277,21 @@ hash_func(svn_revnum_t revision,
   return hash_value;
 }
 
-/* For the given REVISION and PATH, return the respective node found in
- * CACHE.  If there is none, return NULL.
+/* For the given REVISION and the first PATH_LEN chars of PATH, return the
+ * respective entry in CACHE.  PATH does not need to be NUL-terminated at
+ * PATH_LEN, i.e. callers may look up all parent directories of a path
+ * without copying it.
+ *
+ * If the entry is empty, its NODE member will be NULL and the caller
+ * may then set it to the corresponding DAG node allocated in CACHE->POOL.
  */
-static dag_node_t *
-cache_lookup( fs_fs_dag_cache_t *cache
-            , svn_revnum_t revision
-            , const char *path)
+static cache_entry_t *
+cache_lookup(fs_fs_dag_cache_t *cache,
+             svn_revnum_t revision,
+             const char *path,
+             apr_size_t path_len)
 {
   apr_size_t bucket_index;
-  apr_size_t path_len = strlen(path);
   apr_uint32_t hash_value;
 
   /* optimistic lookup: hit the same bucket again? */
@@ -293,7 +304,7 @@ cache_lookup( fs_fs_dag_cache_t *cache
       if (result->node)
         cache->last_non_empty = cache->last_hit;
 
-      return result->node;
+      return result;
     }
 
   /* need to do a full lookup. */
@@ -313,7 +324,19 @@ cache_lookup( fs_fs_dag_cache_t *cache
       || (result->path_len != path_len)
       || memcmp(result->path, path, path_len))
     {
-      return NULL;
+      result->hash_value = hash_value;
+      result->revision = revision;
+
+      if (result->path_len < path_len || result->path_len == 0)
+        result->path = apr_palloc(cache->pool, path_len + 1);
+      result->path_len = path_len;
+
+      memcpy(result->path, path, path_len);
+      result->path[path_len] = 0;
+
+      result->node = NULL;
+
+      cache->insertions++;
     }
   else if (result->node)
     {
@@ -322,7 +345,7 @@ cache_lookup( fs_fs_dag_cache_t *cache
       cache->last_non_empty = bucket_index;
     }
 
-  return result->node;
+  return result;
 }
 
 /* Store a copy of NODE in CACHE, taking  REVISION and PATH as key.
@@ -334,34 +357,11 @@ cache_insert(fs_fs_dag_cache_t *cache,
              const char *path,
              dag_node_t *node)
 {
-  apr_size_t bucket_index;
-  apr_size_t path_len = strlen(path);
-  apr_uint32_t hash_value;
   cache_entry_t *entry;
 
   auto_clear_dag_cache(cache);
-
-  /* calculate the bucket index to use */
-  hash_value = hash_func(revision, path, path_len);
-
-  bucket_index = hash_value + (hash_value >> 16);
-  bucket_index = (bucket_index + (bucket_index >> 8)) % BUCKET_COUNT;
-
-  /* access the corresponding bucket and remember its location */
-  entry = &cache->buckets[bucket_index];
-  cache->last_hit = bucket_index;
-
-  /* if it is *NOT* a match,  clear the bucket, expect the caller to fill
-     in the node and count it as an insertion */
-  entry->hash_value = hash_value;
-  entry->revision = revision;
-  if (entry->path_len < path_len)
-    entry->path = apr_palloc(cache->pool, path_len + 1);
-  entry->path_len = path_len;
-  memcpy(entry->path, path, path_len + 1);
-
+  entry = cache_lookup(cache, revision, path, strlen(path));
   entry->node = svn_fs_fs__dag_dup(node, cache->pool);
-  cache->insertions++;
 }
 
 /* Optimistic lookup using the last seen non-empty location in CACHE.
@@ -440,7 +440,9 @@ dag_node_cache_get(dag_node_t **node_p,
 
       fs_fs_data_t *ffd = root->fs->fsap_data;
 
-      node = cache_lookup(ffd->dag_node_cache, root->rev, path);
+      auto_clear_dag_cache(ffd->dag_node_cache);
+      node = cache_lookup(ffd->dag_node_cache, root->rev, path,
+                          strlen(path))->node;
       if (node == NULL)
         {
           locate_cache(&cache, &key, root, path, pool);
@@ -921,6 +923,190 @@ try_match_last_node(dag_node_t **node_p,
 }
 
 
+/* From directory node PARENT, under the revision root ROOT, go one step
+   down to the entry NAME and return a reference to it in *CHILD_P.
+
+   The first PATH_LEN chars of PATH are the combination of PARENT's path
+   and NAME and are provided by the caller such that we don't have to
+   construct the path here ourselves.  If the directory entry cannot be
+   found, set *CHILD_P to NULL.
+
+   NOTE: *CHILD_P will live within the DAG cache and we merely return a
+   reference to it.  Hence, it will invalid upon the next cache insertion.
+   Callers must create a copy if they want a non-temporary object.
+   Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+dag_step(dag_node_t **child_p,
+         svn_fs_root_t *root,
+         dag_node_t *parent,
+         const char *name,
+         const char *path,
+         apr_size_t path_len,
+         apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = root->fs->fsap_data;
+  fs_fs_dag_cache_t *cache = ffd->dag_node_cache;
+  cache_entry_t *bucket;
+  dag_node_t *node = NULL;
+  svn_boolean_t found;
+  const char *key;
+
+  /* Locate the corresponding cache entry.  We may need PARENT to remain
+     valid for later use, so don't call auto_clear_dag_cache() here. */
+  bucket = cache_lookup(cache, root->rev, path, path_len);
+  if (bucket->node)
+    {
+      /* Already cached. Return a reference to the cached object. */
+      *child_p = bucket->node;
+      return SVN_NO_ERROR;
+    }
+
+  /* Another FS instance may already have found that node. */
+  key = svn_fs_fs__combine_number_and_string(root->rev,
+                                             apr_pstrmemdup(scratch_pool,
+                                                            path, path_len),
+                                             scratch_pool);
+  SVN_ERR(svn_cache__get((void **)&node, &found, ffd->rev_node_cache, key,
+                         scratch_pool));
+  if (found && node)
+    {
+      /* Patch up the FS, since this might have come from an old FS
+       * object. */
+      svn_fs_fs__dag_set_fs(node, root->fs);
+    }
+  else
+    {
+      SVN_ERR(svn_fs_fs__dag_open(&node, parent, name, scratch_pool,
+                                  scratch_pool));
+
+      /* No such directory entry? */
+      if (node == NULL)
+        {
+          *child_p = NULL;
+          return SVN_NO_ERROR;
+        }
+
+      SVN_ERR(svn_cache__set(ffd->rev_node_cache, key, node, scratch_pool));
+    }
+
+  /* We are about to add a new entry to the cache.  Periodically clear it.
+     If we had to clear it just now (< 1% chance), re-add the entry for our
+     item. */
+  if (auto_clear_dag_cache(cache))
+    bucket = cache_lookup(cache, root->rev, path, path_len);
+
+  /* Let the DAG node object live in the cache. */
+  bucket->node = svn_fs_fs__dag_dup(node, cache->pool);
+
+  /* Return a reference to the cached object. */
+  *child_p = bucket->node;
+  return SVN_NO_ERROR;
+}
+
+/* Walk the DAG of the revision root ROOT, following the canonical PATH
+   and return a reference to the target node in *NODE_P.  Every parent
+   directory found along the way gets cached, keyed by the respective
+   prefix of PATH.  Return SVN_ERR_FS_NOT_FOUND if there is no such node.
+   Use SCRATCH_POOL for temporary allocations.
+
+   NOTE: *NODE_P will live within the DAG cache and we merely return a
+   reference to it.  Hence, it will invalid upon the next cache insertion.
+   Callers must create a copy if they want a non-temporary object.
+ */
+static svn_error_t *
+walk_dag_path(dag_node_t **node_p,
+              svn_fs_root_t *root,
+              const char *path,
+              apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = root->fs->fsap_data;
+  dag_node_t *here = NULL; /* The directory we're currently looking at.  */
+  apr_size_t path_len = strlen(path);
+  apr_size_t dir_len; /* Length of the prefix of PATH that HERE is at. */
+  svn_stringbuf_t *entry;
+  apr_pool_t *iterpool;
+
+  SVN_ERR_ASSERT(!root->is_txn_root);
+
+  /* Special case: root directory.  Revision roots have it opened already
+     and we will later assume all other paths to have a parent. */
+  if (path_len == 1)
+    {
+      *node_p = root->fsap_data;
+      return SVN_NO_ERROR;
+    }
+
+  /* First attempt: Assume that we access the DAG for the same path as
+     in the last lookup but for a different revision that happens to be
+     the last revision that touched the respective node. */
+  SVN_ERR(try_match_last_node(node_p, root, path, path_len, scratch_pool));
+  if (*node_p)
+    return SVN_NO_ERROR;
+
+  /* Second attempt: Try starting the lookup immediately at the parent
+     node.  We will often have recently accessed either a sibling or
+     said parent directory itself for the same revision. */
+  dir_len = path_len;
+  while (path[dir_len - 1] != '/')
+    --dir_len;
+
+  if (dir_len > 1)
+    {
+      here = cache_lookup(ffd->dag_node_cache, root->rev, path,
+                          dir_len - 1)->node;
+      if (here)
+        --dir_len;
+    }
+
+  /* Did the shortcut work?  If not, start at the root directory. */
+  if (!here)
+    {
+      here = root->fsap_data;
+      dir_len = 0;
+    }
+
+  /* Walk the remaining segments.  At the top of this loop, HERE is the
+     node for the first DIR_LEN chars of PATH. */
+  entry = svn_stringbuf_create_ensure(64, scratch_pool);
+  iterpool = svn_pool_create(scratch_pool);
+  while (dir_len < path_len)
+    {
+      const char *segment_start = path + dir_len + 1;
+      const char *segment_end = segment_start;
+
+      svn_pool_clear(iterpool);
+
+      /* The path isn't finished yet; we'd better be in a directory.  */
+      if (svn_fs_fs__dag_node_kind(here) != svn_node_dir)
+        {
+          const char *dir = apr_pstrmemdup(iterpool, path,
+                                           dir_len ? dir_len : 1);
+          SVN_ERR_W(SVN_FS__ERR_NOT_DIRECTORY(root->fs, dir),
+                    apr_psprintf(iterpool, _("Failure opening '%s'"), path));
+        }
+
+      while (*segment_end != '/' && *segment_end != '\0')
+        ++segment_end;
+
+      svn_stringbuf_setempty(entry);
+      svn_stringbuf_appendbytes(entry, segment_start,
+                                segment_end - segment_start);
+      dir_len = segment_end - path;
+
+      SVN_ERR(dag_step(&here, root, here, entry->data, path, dir_len,
+                       iterpool));
+      if (here == NULL)
+        return SVN_FS__NOT_FOUND(root, path);
+    }
+
+  svn_pool_destroy(iterpool);
+  *node_p = here;
+
+  return SVN_NO_ERROR;
+}
+
+
 /* Open the node identified by PATH in ROOT, allocating in POOL.  Set
    *PARENT_PATH_P to a path from the node up to ROOT.  The resulting
    **PARENT_PATH_P value is guaranteed to contain at least one
@@ -1287,14 +1473,25 @@ get_dag(dag_node_t **dag_node_p,
 
       if (! node)
         {
-          /* Call open_path with no flags, as we want this to return an
-           * error if the node for which we are searching doesn't exist. */
-          SVN_ERR(open_path(&parent_path, root, path,
-                            open_path_uncached | open_path_node_only,
-                            FALSE, pool));
-          node = parent_path->node;
-
-          /* No need to cache our find -- open_path() will do that for us. */
+          if (root->is_txn_root)
+            {
+              /* Call open_path with no flags, as we want this to return an
+               * error if the node for which we are searching doesn't
+               * exist. */
+              SVN_ERR(open_path(&parent_path, root, path,
+                                open_path_uncached | open_path_node_only,
+                                FALSE, pool));
+              node = parent_path->node;
+            }
+          else
+            {
+              /* Committed nodes never change.  Walk the path through our
+               * bucketed cache, reusing any cached parent directories. */
+              SVN_ERR(walk_dag_path(&node, root, path, pool));
+              node = svn_fs_fs__dag_dup(node, pool);
+            }
+
+          /* No need to cache our find -- both paths do that for us. */
         }
     }
 
@@ -2314,7 +2511,7 @@ svn_fs_fs__commit_txn(const char **conflict_p,
 
   if (ffd->pack_after_commit)
     {
-      SVN_ERR(svn_fs_fs__pack(fs, 0, NULL, NULL, NULL, NULL, pool));
+      SVN_ERR(svn_fs_fs__pack(fs, 0, 1, NULL, NULL, NULL, NULL, pool));
     }
 
   return SVN_NO_ERROR;
@@ -2431,6 +2628,23 @@ fs_dir_entries(apr_hash_t **table_p,
   return SVN_NO_ERROR;
 }
 
+/* Set *ENTRIES_P to the entries of the directory at PATH in ROOT as an
+   array of svn_fs_dirent_t *.  Directories are sorted by name already. */
+static svn_error_t *
+fs_dir_entries_sorted(apr_array_header_t **entries_p,
+                      svn_fs_root_t *root,
+                      const char *path,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  dag_node_t *node;
+
+  SVN_ERR(get_dag(&node, root, path, scratch_pool));
+  SVN_ERR(svn_fs_fs__dag_dir_entries(entries_p, node, result_pool));
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 fs_dir_optimal_order(apr_array_header_t **ordered_p,
                      svn_fs_root_t *root,
@@ -2837,6 +3051,123 @@ fs_make_file(svn_fs_root_t *root,
 }
 
 
+/* Create the empty files PATHS (canonical const char *) under ROOT.
+   All of them must be direct children of the directory PARENT_DIR.
+   Temporary allocations are in POOL. */
+static svn_error_t *
+make_sibling_files(svn_fs_root_t *root,
+                   const char *parent_dir,
+                   const apr_array_header_t *paths,
+                   apr_pool_t *pool)
+{
+  parent_path_t *parent_path;
+  apr_array_header_t *names, *children;
+  apr_hash_t *names_seen = apr_hash_make(pool);
+  const svn_fs_fs__id_part_t *txn_id = root_txn_id(root);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  SVN_ERR(open_path(&parent_path, root, parent_dir, 0, TRUE, pool));
+
+  /* Check all paths before changing anything. */
+  names = apr_array_make(pool, paths->nelts, sizeof(const char *));
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      const char *name = svn_fspath__basename(path, pool);
+      svn_fs_dirent_t *dirent;
+
+      svn_pool_clear(iterpool);
+
+      /* If there's already a file by that name, complain. */
+      SVN_ERR(svn_fs_fs__dag_dir_entry(&dirent, parent_path->node, name,
+                                       iterpool, iterpool));
+      if (dirent || svn_hash_gets(names_seen, name))
+        return SVN_FS__ALREADY_EXISTS(root, path);
+
+      /* Check (non-recursively) to see if path is locked;  if so, check
+         that we can use it. */
+      if (root->txn_flags & SVN_FS_TXN_CHECK_LOCKS)
+        SVN_ERR(svn_fs_fs__allow_locked_operation(path, root->fs, FALSE,
+                                                  FALSE, iterpool));
+
+      svn_hash_sets(names_seen, name, name);
+      APR_ARRAY_PUSH(names, const char *) = name;
+    }
+
+  /* Create the files with a single update of their parent. */
+  SVN_ERR(make_path_mutable(root, parent_path, parent_dir, pool));
+  SVN_ERR(svn_fs_fs__dag_make_files(&children, parent_path->node,
+                                    parent_dir, names, txn_id, pool));
+
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      dag_node_t *child = APR_ARRAY_IDX(children, i, dag_node_t *);
+
+      svn_pool_clear(iterpool);
+
+      /* Add this file to the path cache. */
+      SVN_ERR(dag_node_cache_set(root, path, child, iterpool));
+
+      /* Make a record of this modification in the changes table. */
+      SVN_ERR(add_change(root->fs, txn_id, path,
+                         svn_fs_fs__dag_get_id(child),
+                         svn_fs_path_change_add, TRUE, FALSE, FALSE,
+                         svn_node_file, SVN_INVALID_REVNUM, NULL, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* Create the empty files PATHS (const char *) under ROOT.  Files in the
+   same directory are added together as long as they are adjacent in
+   PATHS.  Temporary allocations are in POOL. */
+static svn_error_t *
+fs_make_files(svn_fs_root_t *root,
+              const apr_array_header_t *paths,
+              apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_array_header_t *siblings = apr_array_make(pool, 16,
+                                                sizeof(const char *));
+  const char *parent_dir = NULL;
+  int i;
+
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      const char *dir;
+
+      SVN_ERR(check_newline(path, pool));
+      path = svn_fs__canonicalize_abspath(path, pool);
+
+      /* This also catches the case of trying to make a file named `/'. */
+      if (path[1] == '\0')
+        return SVN_FS__ALREADY_EXISTS(root, path);
+
+      /* Flush the files collected for the previous directory. */
+      dir = svn_fspath__dirname(path, pool);
+      if (parent_dir && strcmp(dir, parent_dir) != 0)
+        {
+          svn_pool_clear(iterpool);
+          SVN_ERR(make_sibling_files(root, parent_dir, siblings, iterpool));
+          apr_array_clear(siblings);
+        }
+
+      parent_dir = dir;
+      APR_ARRAY_PUSH(siblings, const char *) = path;
+    }
+
+  if (siblings->nelts)
+    SVN_ERR(make_sibling_files(root, parent_dir, siblings, iterpool));
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+
 /* Set *LENGTH_P to the size of the file PATH under ROOT.  Temporary
    allocations are in POOL. */
 static svn_error_t *
@@ -2918,6 +3249,28 @@ fs_try_process_file_contents(svn_boolean_t *success,
 /* --- End machinery for svn_fs_try_process_file_contents() ---  */
 
 
+/* --- Machinery for svn_fs__file_contents_location() ---  */
+
+static svn_error_t *
+fs_file_contents_location(const char **file_path,
+                          apr_off_t *offset,
+                          svn_filesize_t *length,
+                          svn_fs_root_t *root,
+                          const char *path,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
+{
+  dag_node_t *node;
+  SVN_ERR(get_dag(&node, root, path, scratch_pool));
+
+  return svn_fs_fs__dag_file_contents_location(file_path, offset, length,
+                                               node, result_pool,
+                                               scratch_pool);
+}
+
+/* --- End machinery for svn_fs__file_contents_location() ---  */
+
+
 /* --- Machinery for svn_fs_apply_textdelta() ---  */
 
 
@@ -3303,8 +3656,11 @@ convert_path_change(svn_fs_path_change3_t *output,
 /* FSAP data structure for in-txn changes list iterators. */
 typedef struct fs_txn_changes_iterator_data_t
 {
-  /* Current iterator position. */
-  apr_hash_index_t *hi;
+  /* All changes as svn_sort__item_t, sorted by path. */
+  apr_array_header_t *changes;
+
+  /* Index of the next entry in CHANGES to report. */
+  int idx;
 
   /* For efficiency such that we don't need to dynamically allocate
      yet another copy of that data. */
@@ -3318,17 +3674,16 @@ fs_txn_changes_iterator_get(svn_fs_path_change3_t **change,
 {
   fs_txn_changes_iterator_data_t *data = iterator->fsap_data;
 
-  if (data->hi)
+  if (data->idx < data->changes->nelts)
     {
-      const void *key;
-      apr_ssize_t length;
-      void *value;
-      apr_hash_this(data->hi, &key, &length, &value);
+      svn_sort__item_t *item = &APR_ARRAY_IDX(data->changes, data->idx,
+                                              svn_sort__item_t);
 
-      convert_path_change(&data->change, key, length, value);
+      convert_path_change(&data->change, item->key, item->klen,
+                          item->value);
 
       *change = &data->change;
-      data->hi = apr_hash_next(data->hi);
+      ++data->idx;
     }
   else
     {
@@ -3426,7 +3781,11 @@ fs_report_changes(svn_fs_path_change_iterator_t **iterator,
       SVN_ERR(svn_fs_fs__txn_changes_fetch(&changed_paths, root->fs,
                                            root_txn_id(root), result_pool));
 
-      data->hi = apr_hash_first(result_pool, changed_paths);
+      /* Report the changes in the same order as they will be stored in
+         the revision, i.e. sorted by path. */
+      data->changes = svn_sort__hash(changed_paths,
+                                     svn_sort_compare_items_lexically,
+                                     result_pool);
       result->fsap_data = data;
       result->vtable = &txn_changes_iterator_vtable;
     }
@@ -4387,6 +4746,71 @@ get_mergeinfo_for_path(svn_mergeinfo_t *mergeinfo,
   return SVN_NO_ERROR;
 }
 
+/* Like crawl_directory_dag_for_mergeinfo() but use the mergeinfo index
+   of ROOT's FS.  If DIR_DAG has not been indexed, yet, crawl it and add
+   the result to the index. */
+static svn_error_t *
+get_indexed_mergeinfo_for_directory(svn_fs_root_t *root,
+                                    const char *this_path,
+                                    dag_node_t *dir_dag,
+                                    svn_mergeinfo_catalog_t result_catalog,
+                                    apr_pool_t *result_pool,
+                                    apr_pool_t *scratch_pool)
+{
+  const svn_fs_id_t *id = svn_fs_fs__dag_get_id(dir_dag);
+  const char *node_id = svn_fs_fs__id_unparse(id, scratch_pool)->data;
+  apr_hash_t *catalog;
+  apr_hash_index_t *hi;
+
+  SVN_ERR(svn_fs_fs__get_indexed_mergeinfo(&catalog, root->fs, node_id,
+                                           scratch_pool, scratch_pool));
+  if (catalog == NULL)
+    {
+      svn_mergeinfo_catalog_t crawled = svn_hash__make(scratch_pool);
+
+      SVN_ERR(crawl_directory_dag_for_mergeinfo(root, this_path, dir_dag,
+                                                crawled, scratch_pool,
+                                                scratch_pool));
+
+      /* Store the result relative to DIR_DAG, so it can be used at any
+         path that DIR_DAG has been copied to. */
+      catalog = svn_hash__make(scratch_pool);
+      for (hi = apr_hash_first(scratch_pool, crawled);
+           hi;
+           hi = apr_hash_next(hi))
+        {
+          svn_string_t *mergeinfo_string;
+
+          SVN_ERR(svn_mergeinfo_to_string(&mergeinfo_string,
+                                          apr_hash_this_val(hi),
+                                          scratch_pool));
+          svn_hash_sets(catalog,
+                        svn_fspath__skip_ancestor(this_path,
+                                                  apr_hash_this_key(hi)),
+                        mergeinfo_string);
+        }
+
+      SVN_ERR(svn_fs_fs__set_indexed_mergeinfo(root->fs, node_id,
+                                               svn_fs_fs__id_rev(id),
+                                               catalog, scratch_pool));
+    }
+
+  for (hi = apr_hash_first(scratch_pool, catalog); hi; hi = apr_hash_next(hi))
+    {
+      const svn_string_t *mergeinfo_string = apr_hash_this_val(hi);
+      svn_mergeinfo_t kid_mergeinfo;
+
+      SVN_ERR(svn_mergeinfo_parse(&kid_mergeinfo, mergeinfo_string->data,
+                                  result_pool));
+      svn_hash_sets(result_catalog,
+                    svn_fspath__join(this_path, apr_hash_this_key(hi),
+                                     result_pool),
+                    kid_mergeinfo);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Adds mergeinfo for each descendant of PATH (but not PATH itself)
    under ROOT to RESULT_CATALOG.  Returned values are allocated in
    RESULT_POOL; temporary values in POOL. */
@@ -4397,13 +4821,21 @@ add_descendant_mergeinfo(svn_mergeinfo_catalog_t result_catalog,
                          apr_pool_t *result_pool,
                          apr_pool_t *scratch_pool)
 {
+  fs_fs_data_t *ffd = root->fs->fsap_data;
   dag_node_t *this_dag;
   svn_boolean_t go_down;
 
   SVN_ERR(get_dag(&this_dag, root, path, scratch_pool));
   SVN_ERR(svn_fs_fs__dag_has_descendants_with_mergeinfo(&go_down,
                                                         this_dag));
-  if (go_down)
+  if (go_down && ffd->mergeinfo_index)
+    SVN_ERR(get_indexed_mergeinfo_for_directory(root,
+                                                path,
+                                                this_dag,
+                                                result_catalog,
+                                                result_pool,
+                                                scratch_pool));
+  else if (go_down)
     SVN_ERR(crawl_directory_dag_for_mergeinfo(root,
                                               path,
                                               this_dag,
@@ -4525,13 +4957,16 @@ static root_vtable_t root_vtable = {
   fs_change_node_prop,
   fs_props_changed,
   fs_dir_entries,
+  fs_dir_entries_sorted,
   fs_dir_optimal_order,
   fs_make_dir,
   fs_file_length,
   fs_file_checksum,
   fs_file_contents,
   fs_try_process_file_contents,
+  fs_file_contents_location,
   fs_make_file,
+  fs_make_files,
   fs_apply_textdelta,
   fs_apply_text,
   fs_contents_changed,
@@ -4643,6 +5078,7 @@ verify_node(dag_node_t *node,
   svn_boolean_t has_mergeinfo;
   apr_int64_t mergeinfo_count;
   const svn_fs_id_t *pred_id;
+  const svn_fs_id_t *skip_id;
   svn_fs_t *fs = svn_fs_fs__dag_get_fs(node);
   int pred_count;
   svn_node_kind_t kind;
@@ -4690,6 +5126,23 @@ verify_node(dag_node_t *node,
                                  pred_pred_count);
     }
 
+  /* Skip links must lead to the predecessor they are meant for. */
+  SVN_ERR(svn_fs_fs__dag_get_skip_predecessor_id(&skip_id, node));
+  if (skip_id)
+    {
+      dag_node_t *skip;
+      int skip_pred_count;
+      SVN_ERR(svn_fs_fs__dag_get_node(&skip, fs, skip_id, iterpool));
+      SVN_ERR(svn_fs_fs__dag_get_predecessor_count(&skip_pred_count, skip));
+      if (skip_pred_count != (pred_count & (pred_count - 1)))
+        return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                                 "Skip predecessor count mismatch: "
+                                 "%s has %d, but %s has %d",
+                                 stringify_node(node, iterpool), pred_count,
+                                 stringify_node(skip, iterpool),
+                                 skip_pred_count);
+    }
+
   /* Kind-dependent verifications. */
   if (kind == svn_node_none)
     {
@@ -4737,10 +5190,8 @@ verify_node(dag_node_t *node,
           else
             {
               /* access mergeinfo counter with minimal overhead */
-              node_revision_t *noderev;
-              SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, dirent->id,
-                                                   iterpool, iterpool));
-              child_mergeinfo = noderev->mergeinfo_count;
+              SVN_ERR(svn_fs_fs__get_mergeinfo_count(&child_mergeinfo, fs,
+                                                     dirent->id, iterpool));
             }
 
           children_mergeinfo += child_mergeinfo;
@@ -365,6 +365,20 @@ svn_fs_fs__path_node_origin(svn_fs_t *fs,
                               buffer, SVN_VA_NULL);
 }
 
+const char *
+svn_fs_fs__path_changed_paths_index(svn_fs_t *fs,
+                                    svn_revnum_t rev,
+                                    apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  assert(ffd->max_files_per_dir);
+  return svn_dirent_join_many(pool, fs->path, PATH_CHANGED_PATHS_DIR,
+                              apr_psprintf(pool, "%ld",
+                                                 rev / ffd->max_files_per_dir),
+                              SVN_VA_NULL);
+}
+
 const char *
 svn_fs_fs__path_min_unpacked_rev(svn_fs_t *fs,
                                  apr_pool_t *pool)
@@ -492,6 +506,27 @@ svn_fs_fs__read_current(svn_revnum_t *rev,
   return SVN_NO_ERROR;
 }
 
+const char *
+svn_fs_fs__unparse_current(svn_fs_t *fs,
+                           svn_revnum_t rev,
+                           apr_uint64_t next_node_id,
+                           apr_uint64_t next_copy_id,
+                           apr_pool_t *result_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  char node_id_str[SVN_INT64_BUFFER_SIZE];
+  char copy_id_str[SVN_INT64_BUFFER_SIZE];
+
+  if (ffd->format >= SVN_FS_FS__MIN_NO_GLOBAL_IDS_FORMAT)
+    return apr_psprintf(result_pool, "%ld\n", rev);
+
+  svn__ui64tobase36(node_id_str, next_node_id);
+  svn__ui64tobase36(copy_id_str, next_copy_id);
+
+  return apr_psprintf(result_pool, "%ld %s %s\n", rev, node_id_str,
+                      copy_id_str);
+}
+
 svn_error_t *
 svn_fs_fs__write_current(svn_fs_t *fs,
                          svn_revnum_t rev,
@@ -499,25 +534,13 @@ svn_fs_fs__write_current(svn_fs_t *fs,
                          apr_uint64_t next_copy_id,
                          apr_pool_t *pool)
 {
-  char *buf;
+  const char *buf;
   const char *name;
   fs_fs_data_t *ffd = fs->fsap_data;
 
   /* Now we can just write out this line. */
-  if (ffd->format >= SVN_FS_FS__MIN_NO_GLOBAL_IDS_FORMAT)
-    {
-      buf = apr_psprintf(pool, "%ld\n", rev);
-    }
-  else
-    {
-      char node_id_str[SVN_INT64_BUFFER_SIZE];
-      char copy_id_str[SVN_INT64_BUFFER_SIZE];
-      svn__ui64tobase36(node_id_str, next_node_id);
-      svn__ui64tobase36(copy_id_str, next_copy_id);
-
-      buf = apr_psprintf(pool, "%ld %s %s\n", rev, node_id_str, copy_id_str);
-    }
-
+  buf = svn_fs_fs__unparse_current(fs, rev, next_node_id, next_copy_id,
+                                   pool);
   name = svn_fs_fs__path_current(fs, pool);
   SVN_ERR(svn_io_write_atomic2(name, buf, strlen(buf),
                                name /* copy_perms_path */,
@@ -287,6 +287,14 @@ svn_fs_fs__path_node_origin(svn_fs_t *fs,
                             const svn_fs_fs__id_part_t *node_id,
                             apr_pool_t *pool);
 
+/* Return the path of the changed paths index file covering the shard
+ * that contains revision REV in FS.  The result will be allocated in POOL.
+ */
+const char *
+svn_fs_fs__path_changed_paths_index(svn_fs_t *fs,
+                                    svn_revnum_t rev,
+                                    apr_pool_t *pool);
+
 /* Set *MIN_UNPACKED_REV to the integer value read from the file returned
  * by #svn_fs_fs__path_min_unpacked_rev() for FS.
  * Use POOL for temporary allocations.
@@ -336,6 +344,17 @@ svn_fs_fs__read_current(svn_revnum_t *rev,
                         svn_fs_t *fs,
                         apr_pool_t *pool);
 
+/* Return the contents of the 'current' file in FS for the specified REV,
+   NEXT_NODE_ID, and NEXT_COPY_ID, allocated in RESULT_POOL.  (The two
+   next-ID parameters are ignored and may be 0 if the FS format does not
+   use them.) */
+const char *
+svn_fs_fs__unparse_current(svn_fs_t *fs,
+                           svn_revnum_t rev,
+                           apr_uint64_t next_node_id,
+                           apr_uint64_t next_copy_id,
+                           apr_pool_t *result_pool);
+
 /* Atomically update the 'current' file to hold the specifed REV,
    NEXT_NODE_ID, and NEXT_COPY_ID.  (The two next-ID parameters are
    ignored and may be 0 if the FS format does not use them.)
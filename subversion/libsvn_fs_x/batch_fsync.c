@@ -22,10 +22,30 @@
 
 #include <apr_thread_pool.h>
 #include <apr_thread_cond.h>
+#include <apr_portable.h>
+
+#if defined(HAVE_SYNCFS) || defined(HAVE_LINUX_IO_URING_H)
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+#if defined(HAVE_LINUX_IO_URING_H) && defined(__GNUC__)
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+/* We talk to the kernel directly and need the respective syscalls. */
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define SVN_FS_X__HAVE_IO_URING
+#endif
+#endif
 
 #include "batch_fsync.h"
 #include "svn_pools.h"
 #include "svn_hash.h"
+#include "svn_sorts.h"
 #include "svn_dirent_uri.h"
 #include "svn_private_config.h"
 
@@ -206,6 +226,9 @@ struct svn_fs_x__batch_fsync_t
 
   /* Perform fsyncs only if this flag has been set. */
   svn_boolean_t flush_to_disk;
+
+  /* How to perform the fsyncs. */
+  svn_fs_x__fsync_method_t method;
 };
 
 /* Data structures for concurrent fsync execution are only available if
@@ -303,11 +326,13 @@ fsync_batch_cleanup(void *data)
 svn_error_t *
 svn_fs_x__batch_fsync_create(svn_fs_x__batch_fsync_t **result_p,
                              svn_boolean_t flush_to_disk,
+                             svn_fs_x__fsync_method_t method,
                              apr_pool_t *result_pool)
 {
   svn_fs_x__batch_fsync_t *result = apr_pcalloc(result_pool, sizeof(*result));
   result->files = svn_hash__make(result_pool);
   result->flush_to_disk = flush_to_disk;
+  result->method = method;
 
   SVN_ERR(waitable_counter__create(&result->counter, result_pool));
   apr_pool_cleanup_register(result_pool, result, fsync_batch_cleanup,
@@ -467,6 +492,340 @@ flush_task(apr_thread_t *tid,
   return NULL;
 }
 
+#if defined(HAVE_SYNCFS) || defined(SVN_FS_X__HAVE_IO_URING)
+
+/* Return an error object describing the failure of the fsync for TO_SYNC
+ * with the system error STATUS.  Return SVN_NO_ERROR for EINVAL, i.e. for
+ * files in memory filesystems, just as svn_io_file_flush_to_disk does.
+ * Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+flush_error(to_sync_t *to_sync,
+            apr_status_t status,
+            apr_pool_t *scratch_pool)
+{
+  const char *fname;
+
+  if (APR_STATUS_IS_EINVAL(status))
+    return SVN_NO_ERROR;
+
+  if (apr_file_name_get(&fname, to_sync->file))
+    fname = "";
+
+  return svn_error_wrap_apr(status, _("Can't flush file '%s' to disk"),
+                            svn_dirent_local_style(fname, scratch_pool));
+}
+
+#endif
+
+#ifdef HAVE_SYNCFS
+
+/* Flush all files in TO_SYNCS, an array of to_sync_t *, to disk by calling
+ * syncfs() once for every filesystem that contains any of them.  Store
+ * the results in the respective to_sync_t.  Use SCRATCH_POOL for
+ * temporaries. */
+static void
+flush_with_syncfs(apr_array_header_t *to_syncs,
+                  apr_pool_t *scratch_pool)
+{
+  /* Devices of the filesystems that we already synced. */
+  apr_array_header_t *devices
+    = apr_array_make(scratch_pool, 4, sizeof(dev_t));
+  int i, k;
+
+  for (i = 0; i < to_syncs->nelts; ++i)
+    {
+      to_sync_t *to_sync = APR_ARRAY_IDX(to_syncs, i, to_sync_t *);
+      apr_os_file_t fd;
+      struct stat info;
+      int rv;
+
+      apr_os_file_get(&fd, to_sync->file);
+      if (fstat(fd, &info) == -1)
+        {
+          to_sync->result
+            = svn_error_compose_create(to_sync->result,
+                                       flush_error(to_sync,
+                                                   apr_get_os_error(),
+                                                   scratch_pool));
+          continue;
+        }
+
+      for (k = 0; k < devices->nelts; ++k)
+        if (APR_ARRAY_IDX(devices, k, dev_t) == info.st_dev)
+          break;
+
+      if (k < devices->nelts)
+        continue;
+
+      do
+        rv = syncfs(fd);
+      while (rv == -1 && APR_STATUS_IS_EINTR(apr_get_os_error()));
+
+      /* Retry with the next file on that device upon failure. */
+      if (rv == -1)
+        to_sync->result
+          = svn_error_compose_create(to_sync->result,
+                                     flush_error(to_sync,
+                                                 apr_get_os_error(),
+                                                 scratch_pool));
+      else
+        APR_ARRAY_PUSH(devices, dev_t) = info.st_dev;
+    }
+}
+
+#endif
+
+#ifdef SVN_FS_X__HAVE_IO_URING
+
+/* Maximum number of fsync requests in flight per io_uring. */
+#define URING_ENTRIES 256
+
+/* A minimal io_uring, mapped into our address space. */
+typedef struct uring_t
+{
+  /* The ring's file descriptor. */
+  int fd;
+
+  /* Shared submission and completion queue rings. */
+  char *ring;
+  size_t ring_size;
+
+  /* Submission queue entries. */
+  struct io_uring_sqe *sqes;
+  size_t sqes_size;
+  unsigned sq_entries;
+
+  /* Pointers into RING. */
+  unsigned *sq_tail;
+  unsigned *sq_mask;
+  unsigned *sq_array;
+  unsigned *cq_head;
+  unsigned *cq_tail;
+  unsigned *cq_mask;
+  struct io_uring_cqe *cqes;
+} uring_t;
+
+/* Initialize URING for up to ENTRIES concurrent requests.  Return FALSE
+ * if io_uring is not available, e.g. because the kernel is too old
+ * or a security policy prevents its use. */
+static svn_boolean_t
+uring_setup(uring_t *uring,
+            unsigned entries)
+{
+  struct io_uring_params params;
+  size_t sq_size, cq_size;
+
+  memset(&params, 0, sizeof(params));
+  uring->fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+  if (uring->fd < 0)
+    return FALSE;
+
+  /* Keep it simple and only support kernels that map both queues at once
+   * (Linux 5.4+). */
+  if (!(params.features & IORING_FEAT_SINGLE_MMAP))
+    {
+      close(uring->fd);
+      return FALSE;
+    }
+
+  sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_size = params.cq_off.cqes
+          + params.cq_entries * sizeof(struct io_uring_cqe);
+  uring->ring_size = MAX(sq_size, cq_size);
+  uring->ring = mmap(NULL, uring->ring_size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, uring->fd,
+                     IORING_OFF_SQ_RING);
+  if (uring->ring == MAP_FAILED)
+    {
+      close(uring->fd);
+      return FALSE;
+    }
+
+  uring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+  uring->sqes = mmap(NULL, uring->sqes_size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_SQES);
+  if (uring->sqes == MAP_FAILED)
+    {
+      munmap(uring->ring, uring->ring_size);
+      close(uring->fd);
+      return FALSE;
+    }
+
+  uring->sq_entries = params.sq_entries;
+  uring->sq_tail = (unsigned *)(uring->ring + params.sq_off.tail);
+  uring->sq_mask = (unsigned *)(uring->ring + params.sq_off.ring_mask);
+  uring->sq_array = (unsigned *)(uring->ring + params.sq_off.array);
+  uring->cq_head = (unsigned *)(uring->ring + params.cq_off.head);
+  uring->cq_tail = (unsigned *)(uring->ring + params.cq_off.tail);
+  uring->cq_mask = (unsigned *)(uring->ring + params.cq_off.ring_mask);
+  uring->cqes = (struct io_uring_cqe *)(uring->ring + params.cq_off.cqes);
+
+  return TRUE;
+}
+
+/* Release all resources held by URING. */
+static void
+uring_teardown(uring_t *uring)
+{
+  munmap(uring->sqes, uring->sqes_size);
+  munmap(uring->ring, uring->ring_size);
+  close(uring->fd);
+}
+
+/* Flush the COUNT files in TO_SYNCS to disk using URING.  The number of
+ * files must not exceed the ring size.  Store the results in the
+ * respective to_sync_t.  Use SCRATCH_POOL for temporaries. */
+static void
+uring_flush(uring_t *uring,
+            to_sync_t **to_syncs,
+            unsigned count,
+            apr_pool_t *scratch_pool)
+{
+  unsigned tail = *uring->sq_tail;
+  unsigned submitted = 0;
+  unsigned completed = 0;
+  unsigned i;
+
+  /* Queue one fsync request per file. */
+  for (i = 0; i < count; ++i)
+    {
+      unsigned idx = tail & *uring->sq_mask;
+      struct io_uring_sqe *sqe = &uring->sqes[idx];
+      apr_os_file_t fd;
+
+      apr_os_file_get(&fd, to_syncs[i]->file);
+      memset(sqe, 0, sizeof(*sqe));
+      sqe->opcode = IORING_OP_FSYNC;
+      sqe->fd = fd;
+      sqe->user_data = (apr_uint64_t)(apr_uintptr_t)to_syncs[i];
+
+      uring->sq_array[idx] = idx;
+      ++tail;
+    }
+
+  __atomic_store_n(uring->sq_tail, tail, __ATOMIC_RELEASE);
+
+  /* Hand them to the kernel with as few syscalls as possible. */
+  while (submitted < count)
+    {
+      int rv = (int)syscall(__NR_io_uring_enter, uring->fd,
+                            count - submitted, 0, 0, NULL, 0);
+      if (rv > 0)
+        submitted += rv;
+      else if (rv == 0 || errno != EINTR)
+        break;
+    }
+
+  /* Reap the results of everything that we submitted. */
+  while (completed < submitted)
+    {
+      unsigned head = *uring->cq_head;
+      unsigned cq_tail = __atomic_load_n(uring->cq_tail, __ATOMIC_ACQUIRE);
+
+      if (head == cq_tail)
+        {
+          /* Nothing to reap, yet.  Wait for it.  Spurious errors like
+           * EINTR will simply make us try again. */
+          syscall(__NR_io_uring_enter, uring->fd, 0, 1,
+                  IORING_ENTER_GETEVENTS, NULL, 0);
+          continue;
+        }
+
+      for (; head != cq_tail; ++head, ++completed)
+        {
+          struct io_uring_cqe *cqe = &uring->cqes[head & *uring->cq_mask];
+          to_sync_t *to_sync = (to_sync_t *)(apr_uintptr_t)cqe->user_data;
+
+          if (cqe->res < 0)
+            to_sync->result
+              = svn_error_compose_create(to_sync->result,
+                                         flush_error(to_sync, -cqe->res,
+                                                     scratch_pool));
+        }
+
+      __atomic_store_n(uring->cq_head, head, __ATOMIC_RELEASE);
+    }
+
+  /* Whatever the kernel did not accept, we flush the traditional way. */
+  for (i = submitted; i < count; ++i)
+    to_syncs[i]->result
+      = svn_error_compose_create(to_syncs[i]->result,
+                                 svn_io_file_flush_to_disk(to_syncs[i]->file,
+                                                           to_syncs[i]->pool));
+}
+
+/* Flush all files in TO_SYNCS, an array of to_sync_t *, to disk by
+ * submitting batches of fsync requests to an io_uring.  Store the results
+ * in the respective to_sync_t.  Return FALSE without flushing anything if
+ * io_uring is not available.  Use SCRATCH_POOL for temporaries. */
+static svn_boolean_t
+flush_with_io_uring(apr_array_header_t *to_syncs,
+                    apr_pool_t *scratch_pool)
+{
+  uring_t uring;
+  int i;
+
+  if (!uring_setup(&uring, MIN(to_syncs->nelts, URING_ENTRIES)))
+    return FALSE;
+
+  for (i = 0; i < to_syncs->nelts; i += uring.sq_entries)
+    uring_flush(&uring, &APR_ARRAY_IDX(to_syncs, i, to_sync_t *),
+                MIN(to_syncs->nelts - i, uring.sq_entries), scratch_pool);
+
+  uring_teardown(&uring);
+
+  return TRUE;
+}
+
+#endif
+
+/* Flush all files in BATCH to disk using the specialized method selected
+ * for BATCH.  Return FALSE if that method is not available, in which case
+ * the caller must use the thread pool instead.  Use SCRATCH_POOL for
+ * temporaries. */
+static svn_boolean_t
+flush_with_method(svn_fs_x__batch_fsync_t *batch,
+                  apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *to_syncs;
+  apr_hash_index_t *hi;
+
+  if (batch->method == svn_fs_x__fsync_threads)
+    return FALSE;
+
+#ifndef HAVE_SYNCFS
+  if (batch->method == svn_fs_x__fsync_syncfs)
+    return FALSE;
+#endif
+
+#ifndef SVN_FS_X__HAVE_IO_URING
+  if (batch->method == svn_fs_x__fsync_io_uring)
+    return FALSE;
+#endif
+
+  to_syncs = apr_array_make(scratch_pool, apr_hash_count(batch->files),
+                            sizeof(to_sync_t *));
+  for (hi = apr_hash_first(scratch_pool, batch->files);
+       hi;
+       hi = apr_hash_next(hi))
+    APR_ARRAY_PUSH(to_syncs, to_sync_t *) = apr_hash_this_val(hi);
+
+#ifdef HAVE_SYNCFS
+  if (batch->method == svn_fs_x__fsync_syncfs)
+    {
+      flush_with_syncfs(to_syncs, scratch_pool);
+      return TRUE;
+    }
+#endif
+
+#ifdef SVN_FS_X__HAVE_IO_URING
+  if (batch->method == svn_fs_x__fsync_io_uring)
+    return flush_with_io_uring(to_syncs, scratch_pool);
+#endif
+
+  return FALSE;
+}
+
 svn_error_t *
 svn_fs_x__batch_fsync_run(svn_fs_x__batch_fsync_t *batch,
                           apr_pool_t *scratch_pool)
@@ -499,8 +858,9 @@ svn_fs_x__batch_fsync_run(svn_fs_x__batch_fsync_t *batch,
   chain = svn_error_compose_create(chain,
                                    waitable_counter__reset(batch->counter));
 
-  /* Start the actual fsyncing process. */
-  if (batch->flush_to_disk)
+  /* Start the actual fsyncing process.  Try the method selected for
+   * BATCH first and fall back to the thread pool if not available. */
+  if (batch->flush_to_disk && !flush_with_method(batch, scratch_pool))
     {
       for (hi = apr_hash_first(scratch_pool, batch->files);
            hi;
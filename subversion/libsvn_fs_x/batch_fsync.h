@@ -37,9 +37,30 @@
  * be closed and the container is ready for reuse.
  *
  * To minimize the delay caused by the batch flush, run all fsync calls
- * concurrently - if the OS supports multi-threading.
+ * concurrently - if the OS supports multi-threading.  On Linux, all fsync
+ * requests may alternatively be submitted in one go through an io_uring,
+ * or whole filesystems be sync'ed with syncfs().
  */
 
+/* Methods to flush a batch of files to disk.
+ */
+typedef enum svn_fs_x__fsync_method_t
+{
+  /* Call fsync on all files concurrently using a thread pool. */
+  svn_fs_x__fsync_threads,
+
+  /* Submit all fsyncs to an io_uring at once and reap the results without
+   * any thread hand-offs.  Falls back to svn_fs_x__fsync_threads if not
+   * supported by the OS. */
+  svn_fs_x__fsync_io_uring,
+
+  /* Call syncfs once per filesystem that contains any of the files.
+   * This flushes all pending changes on that filesystem, so it is only
+   * efficient for filesystems dedicated to the repository.  Falls back to
+   * svn_fs_x__fsync_threads if not supported by the OS. */
+  svn_fs_x__fsync_syncfs
+} svn_fs_x__fsync_method_t;
+
 /* Opaque container type.
  */
 typedef struct svn_fs_x__batch_fsync_t svn_fs_x__batch_fsync_t;
@@ -54,10 +75,11 @@ svn_fs_x__batch_fsync_init(void);
 
 /* Set *RESULT_P to a new batch fsync structure, allocated in RESULT_POOL.
  * If FLUSH_TO_DISK is not set, the resulting struct will not actually use
- * fsync. */
+ * fsync.  Otherwise, flush the files using METHOD. */
 svn_error_t *
 svn_fs_x__batch_fsync_create(svn_fs_x__batch_fsync_t **result_p,
                              svn_boolean_t flush_to_disk,
+                             svn_fs_x__fsync_method_t method,
                              apr_pool_t *result_pool);
 
 /* Open the file at FILENAME for read and write access.  Return it in *FILE
@@ -1427,7 +1427,7 @@ static svn_error_t *
 get_combined_window(svn_stringbuf_t **result,
                     rep_read_baton_t *rb)
 {
-  apr_pool_t *pool, *new_pool, *window_pool;
+  apr_pool_t *pool, *new_pool, *spare_pool = NULL, *window_pool;
   int i;
   apr_array_header_t *windows;
   svn_stringbuf_t *source, *buf = rb->base_window;
@@ -1479,8 +1479,18 @@ get_combined_window(svn_stringbuf_t **result,
         SVN_ERR(read_container_window(&source, rb->src_state,
                                       window->sview_len, pool, iterpool));
 
-      /* Combine this window with the current one. */
-      new_pool = svn_pool_create(rb->scratch_pool);
+      /* Combine this window with the current one.  Reuse the pool of
+         the window before the previous one, which nobody refers to now. */
+      if (spare_pool)
+        {
+          new_pool = spare_pool;
+          svn_pool_clear(new_pool);
+        }
+      else
+        {
+          new_pool = svn_pool_create(rb->scratch_pool);
+        }
+
       buf = svn_stringbuf_create_ensure(window->tview_len, new_pool);
       buf->len = window->tview_len;
 
@@ -1501,10 +1511,12 @@ get_combined_window(svn_stringbuf_t **result,
       rs->chunk_index++;
 
       /* Cycle pools so that we only need to hold three windows at a time. */
-      svn_pool_destroy(pool);
+      spare_pool = pool;
       pool = new_pool;
     }
   svn_pool_destroy(iterpool);
+  if (spare_pool)
+    svn_pool_destroy(spare_pool);
 
   svn_pool_destroy(window_pool);
 
@@ -1567,7 +1579,7 @@ init_rep_state(rep_state_t *rs,
   rs->start = entry->offset + rs->header_size;
   rs->current = 4;
   rs->size = entry->size - rep_header->header_size - 7;
-  rs->ver = 1;
+  rs->ver = -1;
   rs->chunk_index = 0;
   rs->window_cache = ffd->txdelta_window_cache;
   rs->combined_cache = ffd->combined_window_cache;
@@ -1589,9 +1601,14 @@ cache_windows(svn_filesize_t *fulltext_len,
               apr_off_t max_offset,
               apr_pool_t *scratch_pool)
 {
-  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_pool_t *iterpool;
   *fulltext_len = 0;
 
+  /* The svndiff version depends on the repository configuration at the
+   * time the representation got written. */
+  SVN_ERR(auto_read_diff_version(rs, scratch_pool));
+
+  iterpool = svn_pool_create(scratch_pool);
   while (rs->current < rs->size)
     {
       svn_boolean_t is_cached = FALSE;
@@ -3079,6 +3096,7 @@ block_read_changes_container(apr_array_header_t **changes,
   svn_fs_x__changes_t *container;
   svn_fs_x__pair_cache_key_t key;
   svn_stream_t *stream;
+  const svn_packed__compression_t *compression;
   svn_revnum_t revision = svn_fs_x__get_revnum(entry->items[0].change_set);
 
   key.revision = svn_fs_x__packed_base_rev(fs, revision);
@@ -3098,8 +3116,10 @@ block_read_changes_container(apr_array_header_t **changes,
 
   /* read changes from revision file */
 
-  SVN_ERR(svn_fs_x__read_changes_container(&container, stream, scratch_pool,
-                                           scratch_pool));
+  SVN_ERR(svn_fs_x__container_compression(&compression, fs, scratch_pool,
+                                          scratch_pool));
+  SVN_ERR(svn_fs_x__read_changes_container(&container, stream, compression,
+                                           scratch_pool, scratch_pool));
 
   /* extract requested data */
 
@@ -3176,6 +3196,7 @@ block_read_noderevs_container(svn_fs_x__noderev_t **noderev_p,
   svn_fs_x__noderevs_t *container;
   svn_stream_t *stream;
   svn_fs_x__pair_cache_key_t key;
+  const svn_packed__compression_t *compression;
   svn_revnum_t revision = svn_fs_x__get_revnum(entry->items[0].change_set);
 
   key.revision = svn_fs_x__packed_base_rev(fs, revision);
@@ -3194,8 +3215,10 @@ block_read_noderevs_container(svn_fs_x__noderev_t **noderev_p,
   SVN_ERR(read_item(&stream, fs, rev_file, entry, scratch_pool));
 
   /* read noderevs from revision file */
-  SVN_ERR(svn_fs_x__read_noderevs_container(&container, stream, scratch_pool,
-                                            scratch_pool));
+  SVN_ERR(svn_fs_x__container_compression(&compression, fs, scratch_pool,
+                                          scratch_pool));
+  SVN_ERR(svn_fs_x__read_noderevs_container(&container, stream, compression,
+                                            scratch_pool, scratch_pool));
 
   /* extract requested data */
   if (must_read)
@@ -3208,6 +3231,38 @@ block_read_noderevs_container(svn_fs_x__noderev_t **noderev_p,
   return SVN_NO_ERROR;
 }
 
+/* Read the representation container addressed by ENTRY in FS from
+ * REV_FILE, which must already be positioned at the start of the item.
+ * Return it in *CONTAINER and put it into the cache under KEY.  Allocate
+ * *CONTAINER in RESULT_POOL and all temporaries in SCRATCH_POOL.
+ */
+static svn_error_t *
+read_reps_container(svn_fs_x__reps_t **container,
+                    svn_fs_t *fs,
+                    svn_fs_x__revision_file_t *rev_file,
+                    svn_fs_x__p2l_entry_t *entry,
+                    svn_fs_x__pair_cache_key_t *key,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  svn_fs_x__data_t *ffd = fs->fsap_data;
+  svn_stream_t *stream;
+  const svn_packed__compression_t *compression;
+
+  SVN_ERR(read_item(&stream, fs, rev_file, entry, scratch_pool));
+
+  /* read reps from revision file */
+  SVN_ERR(svn_fs_x__container_compression(&compression, fs, scratch_pool,
+                                          scratch_pool));
+  SVN_ERR(svn_fs_x__read_reps_container(container, stream, compression,
+                                        result_pool, scratch_pool));
+
+  SVN_ERR(svn_cache__set(ffd->reps_container_cache, key, *container,
+                         scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* If not already cached or if MUST_READ is set, read the representation
  * container addressed by ENTRY in FS.  Return an extractor object for the
  * item identified by SUB_ITEM in *EXTRACTOR.  Read the data from REV_FILE
@@ -3226,7 +3281,6 @@ block_read_reps_container(svn_fs_x__rep_extractor_t **extractor,
 {
   svn_fs_x__data_t *ffd = fs->fsap_data;
   svn_fs_x__reps_t *container;
-  svn_stream_t *stream;
   svn_fs_x__pair_cache_key_t key;
   svn_revnum_t revision = svn_fs_x__get_revnum(entry->items[0].change_set);
 
@@ -3243,11 +3297,8 @@ block_read_reps_container(svn_fs_x__rep_extractor_t **extractor,
         return SVN_NO_ERROR;
     }
 
-  SVN_ERR(read_item(&stream, fs, rev_file, entry, scratch_pool));
-
-  /* read noderevs from revision file */
-  SVN_ERR(svn_fs_x__read_reps_container(&container, stream, result_pool,
-                                        scratch_pool));
+  SVN_ERR(read_reps_container(&container, fs, rev_file, entry, &key,
+                              result_pool, scratch_pool));
 
   /* extract requested data */
 
@@ -3255,9 +3306,6 @@ block_read_reps_container(svn_fs_x__rep_extractor_t **extractor,
     SVN_ERR(svn_fs_x__reps_get(extractor, fs, container, sub_item,
                                result_pool));
 
-  SVN_ERR(svn_cache__set(ffd->reps_container_cache, &key, container,
-                         scratch_pool));
-
   return SVN_NO_ERROR;
 }
 
@@ -3424,3 +3472,205 @@ block_read(void **result,
 
   return SVN_NO_ERROR;
 }
+
+/* A batch of fulltexts to extract from the same representation container.
+ */
+typedef struct container_batch_t
+{
+  /* Cache key of the container. */
+  svn_fs_x__pair_cache_key_t key;
+
+  /* The container's P2L entry and the rev / pack file it lives in. */
+  svn_fs_x__p2l_entry_t *entry;
+  svn_fs_x__revision_file_t *rev_file;
+
+  /* Sub-item indexes (apr_size_t) of the requested fulltexts. */
+  apr_array_header_t *indexes;
+
+  /* Positions (int) of the requested fulltexts in the result array. */
+  apr_array_header_t *positions;
+} container_batch_t;
+
+/* If the committed representation REP in FS is stored in a representation
+ * container, add it to the respective batch in BATCHES, creating the batch
+ * as needed, and remember POSITION for it.  BATCH_MAP maps container
+ * locations to the container_batch_t * in BATCHES and FILES maps packed
+ * base revisions to their open svn_fs_x__revision_file_t *.  Set *ADDED
+ * to TRUE iff REP got added to a batch.  Allocate new batches and files
+ * in RESULT_POOL.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+add_to_container_batch(svn_boolean_t *added,
+                       apr_array_header_t *batches,
+                       apr_hash_t *batch_map,
+                       apr_hash_t *files,
+                       svn_fs_t *fs,
+                       svn_fs_x__representation_t *rep,
+                       int position,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool)
+{
+  svn_revnum_t revision = svn_fs_x__get_revnum(rep->id.change_set);
+  svn_revnum_t base_rev = svn_fs_x__packed_base_rev(fs, revision);
+  const char *file_key = apr_psprintf(scratch_pool, "%ld", base_rev);
+  const char *batch_key;
+  svn_fs_x__revision_file_t *rev_file = svn_hash_gets(files, file_key);
+  svn_fs_x__p2l_entry_t *entry;
+  container_batch_t *batch;
+  apr_off_t offset;
+  apr_uint32_t sub_item;
+
+  if (rev_file == NULL)
+    {
+      SVN_ERR(svn_fs_x__rev_file_init(&rev_file, fs, revision, result_pool));
+      svn_hash_sets(files, apr_pstrdup(result_pool, file_key), rev_file);
+    }
+
+  /* Same check as in create_rep_state_body(). */
+  SVN_ERR(svn_fs_x__item_offset(&offset, &sub_item, fs, rev_file, &rep->id,
+                                scratch_pool));
+  batch_key = apr_psprintf(scratch_pool, "%ld:%" APR_OFF_T_FMT,
+                           base_rev, offset);
+  batch = svn_hash_gets(batch_map, batch_key);
+  if (batch == NULL)
+    {
+      SVN_ERR(svn_fs_x__p2l_entry_lookup(&entry, fs, rev_file, revision,
+                                         offset, result_pool, scratch_pool));
+      if (   entry == NULL
+          || entry->type != SVN_FS_X__ITEM_TYPE_REPS_CONT)
+        {
+          *added = FALSE;
+          return SVN_NO_ERROR;
+        }
+
+      batch = apr_pcalloc(result_pool, sizeof(*batch));
+      batch->key.revision = base_rev;
+      batch->key.second = offset;
+      batch->entry = entry;
+      batch->rev_file = rev_file;
+      batch->indexes = apr_array_make(result_pool, 4, sizeof(apr_size_t));
+      batch->positions = apr_array_make(result_pool, 4, sizeof(int));
+
+      APR_ARRAY_PUSH(batches, container_batch_t *) = batch;
+      svn_hash_sets(batch_map, apr_pstrdup(result_pool, batch_key), batch);
+    }
+
+  APR_ARRAY_PUSH(batch->indexes, apr_size_t) = sub_item;
+  APR_ARRAY_PUSH(batch->positions, int) = position;
+  *added = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Extract all fulltexts requested by BATCH in FS from the cached container
+ * or, if it is not cached, from a single read of the container.  Store
+ * them in TEXTS at the respective positions.  Allocate the fulltexts in
+ * RESULT_POOL and use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+extract_container_batch(apr_array_header_t *texts,
+                        svn_fs_t *fs,
+                        container_batch_t *batch,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool)
+{
+  svn_fs_x__data_t *ffd = fs->fsap_data;
+  apr_array_header_t *extractors = NULL;
+  svn_boolean_t is_cached = FALSE;
+  svn_fs_x__reps_many_baton_t baton;
+  int i;
+
+  baton.fs = fs;
+  baton.indexes = batch->indexes;
+  SVN_ERR(svn_cache__get_partial((void **)&extractors, &is_cached,
+                                 ffd->reps_container_cache, &batch->key,
+                                 svn_fs_x__reps_get_many_func, &baton,
+                                 scratch_pool));
+
+  /* read from disk, if necessary */
+  if (extractors == NULL)
+    {
+      svn_fs_x__reps_t *container;
+
+      SVN_ERR(svn_fs_x__rev_file_seek(batch->rev_file, NULL,
+                                      batch->entry->offset));
+      SVN_ERR(read_reps_container(&container, fs, batch->rev_file,
+                                  batch->entry, &batch->key,
+                                  scratch_pool, scratch_pool));
+      SVN_ERR(svn_fs_x__reps_get_many(&extractors, fs, container,
+                                      batch->indexes, scratch_pool));
+    }
+
+  for (i = 0; i < extractors->nelts; ++i)
+    SVN_ERR(svn_fs_x__extractor_drive(
+              &APR_ARRAY_IDX(texts, APR_ARRAY_IDX(batch->positions, i, int),
+                             svn_stringbuf_t *),
+              APR_ARRAY_IDX(extractors, i, svn_fs_x__rep_extractor_t *),
+              0, 0, result_pool, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_x__get_contents_many(apr_array_header_t **texts,
+                            svn_fs_t *fs,
+                            const apr_array_header_t *reps,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *batches = apr_array_make(scratch_pool, 4,
+                                               sizeof(container_batch_t *));
+  apr_hash_t *batch_map = svn_hash__make(scratch_pool);
+  apr_hash_t *files = svn_hash__make(scratch_pool);
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  *texts = apr_array_make(result_pool, reps->nelts,
+                          sizeof(svn_stringbuf_t *));
+
+  /* Group the containered reps by container and read all others
+   * directly. */
+  for (i = 0; i < reps->nelts; ++i)
+    {
+      svn_fs_x__representation_t *rep
+        = APR_ARRAY_IDX(reps, i, svn_fs_x__representation_t *);
+      svn_boolean_t added = FALSE;
+
+      svn_pool_clear(iterpool);
+      APR_ARRAY_PUSH(*texts, svn_stringbuf_t *) = NULL;
+
+      if (svn_fs_x__is_revision(rep->id.change_set))
+        SVN_ERR(add_to_container_batch(&added, batches, batch_map, files,
+                                       fs, rep, i, scratch_pool, iterpool));
+
+      if (!added)
+        {
+          svn_stream_t *stream;
+          svn_stringbuf_t *text
+            = svn_stringbuf_create_ensure((apr_size_t)rep->expanded_size,
+                                          result_pool);
+
+          SVN_ERR(svn_fs_x__get_contents(&stream, fs, rep, TRUE, iterpool));
+          text->len = (apr_size_t)rep->expanded_size;
+          SVN_ERR(svn_stream_read_full(stream, text->data, &text->len));
+          text->data[text->len] = '\0';
+          SVN_ERR(svn_stream_close(stream));
+
+          APR_ARRAY_IDX(*texts, i, svn_stringbuf_t *) = text;
+        }
+    }
+
+  /* Process each container only once. */
+  for (i = 0; i < batches->nelts; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(extract_container_batch(*texts, fs,
+                                      APR_ARRAY_IDX(batches, i,
+                                                    container_batch_t *),
+                                      result_pool, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
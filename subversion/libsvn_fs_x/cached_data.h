@@ -79,6 +79,19 @@ svn_fs_x__get_contents(svn_stream_t **contents_p,
                        svn_boolean_t cache_fulltext,
                        apr_pool_t *result_pool);
 
+/* Set *TEXTS to an array of svn_stringbuf_t * holding the fulltexts of
+   the svn_fs_x__representation_t * in REPS as seen in filesystem FS, in
+   the same order.  Representations stored in the same representation
+   container get extracted with a single container lookup or read.  All
+   others are read like svn_fs_x__get_contents does.  Allocate *TEXTS in
+   RESULT_POOL and use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_x__get_contents_many(apr_array_header_t **texts,
+                            svn_fs_t *fs,
+                            const apr_array_header_t *reps,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool);
+
 /* Determine on-disk and expanded sizes of the representation identified
  * by ENTRY in FS and return the result in PACKED_LEN and EXPANDED_LEN,
  * respectively.  FILE must point to the start of the representation and
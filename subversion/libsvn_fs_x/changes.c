@@ -208,6 +208,44 @@ svn_fs_x__changes_estimate_size(const svn_fs_x__changes_t *changes)
        + 100;
 }
 
+/* Extract the paths and copy-from paths of the COUNT elements in CHANGES
+ * from the string table PATHS in one go.  Return them in *STRINGS with
+ * the lengths in *LENGTHS: the first COUNT entries are the paths, followed
+ * by the copy-from paths for those changes that have a valid copy-from
+ * revision, in order.  If SERIALIZED is set, PATHS is the cache serialized
+ * representation of the string table.  Allocate the result in RESULT_POOL.
+ */
+static void
+get_change_paths(const char ***strings,
+                 apr_size_t **lengths,
+                 const string_table_t *paths,
+                 svn_boolean_t serialized,
+                 const binary_change_t *changes,
+                 int count,
+                 apr_pool_t *result_pool)
+{
+  apr_size_t *indexes = apr_palloc(result_pool,
+                                   2 * count * sizeof(*indexes));
+  apr_size_t index_count = count;
+  int i;
+
+  for (i = 0; i < count; ++i)
+    {
+      indexes[i] = changes[i].path;
+      if (SVN_IS_VALID_REVNUM(changes[i].copyfrom_rev))
+        indexes[index_count++] = changes[i].copyfrom_path;
+    }
+
+  *strings = apr_palloc(result_pool, index_count * sizeof(**strings));
+  *lengths = apr_palloc(result_pool, index_count * sizeof(**lengths));
+  if (serialized)
+    svn_fs_x__string_table_get_many_func(*strings, *lengths, paths, indexes,
+                                         index_count, result_pool);
+  else
+    svn_fs_x__string_table_get_many(*strings, *lengths, paths, indexes,
+                                    index_count, result_pool);
+}
+
 svn_error_t *
 svn_fs_x__changes_get_list(apr_array_header_t **list,
                            const svn_fs_x__changes_t *changes,
@@ -220,6 +258,9 @@ svn_fs_x__changes_get_list(apr_array_header_t **list,
   int first;
   int last;
   int i;
+  int copyfrom_idx;
+  const char **strings;
+  apr_size_t *lengths;
 
   /* CHANGES must be in 'finalized' mode */
   SVN_ERR_ASSERT(changes->builder == NULL);
@@ -249,6 +290,11 @@ svn_fs_x__changes_get_list(apr_array_header_t **list,
   /* construct result */
   *list = apr_array_make(result_pool, last - first,
                          sizeof(svn_fs_x__change_t*));
+  get_change_paths(&strings, &lengths, changes->paths, FALSE,
+                   &APR_ARRAY_IDX(changes->changes, first, binary_change_t),
+                   last - first, result_pool);
+  copyfrom_idx = last - first;
+
   for (i = first; i < last; ++i)
     {
       const binary_change_t *binary_change
@@ -256,10 +302,8 @@ svn_fs_x__changes_get_list(apr_array_header_t **list,
 
       /* convert BINARY_CHANGE into a standard FSX svn_fs_x__change_t */
       svn_fs_x__change_t *change = apr_pcalloc(result_pool, sizeof(*change));
-      change->path.data = svn_fs_x__string_table_get(changes->paths,
-                                                     binary_change->path,
-                                                     &change->path.len,
-                                                     result_pool);
+      change->path.data = strings[i - first];
+      change->path.len = lengths[i - first];
 
       change->change_kind = (svn_fs_path_change_kind_t)
         ((binary_change->flags & CHANGE_KIND_MASK) >> CHANGE_KIND_SHIFT);
@@ -274,11 +318,7 @@ svn_fs_x__changes_get_list(apr_array_header_t **list,
       change->copyfrom_rev = binary_change->copyfrom_rev;
       change->copyfrom_known = TRUE;
       if (SVN_IS_VALID_REVNUM(binary_change->copyfrom_rev))
-        change->copyfrom_path
-          = svn_fs_x__string_table_get(changes->paths,
-                                        binary_change->copyfrom_path,
-                                        NULL,
-                                        result_pool);
+        change->copyfrom_path = strings[copyfrom_idx++];
 
       /* add it to the result */
       APR_ARRAY_PUSH(*list, svn_fs_x__change_t*) = change;
@@ -290,6 +330,7 @@ svn_fs_x__changes_get_list(apr_array_header_t **list,
 svn_error_t *
 svn_fs_x__write_changes_container(svn_stream_t *stream,
                                   const svn_fs_x__changes_t *changes,
+                                  const svn_packed__compression_t *compression,
                                   apr_pool_t *scratch_pool)
 {
   int i;
@@ -333,8 +374,9 @@ svn_fs_x__write_changes_container(svn_stream_t *stream,
     }
 
   /* write to disk */
-  SVN_ERR(svn_fs_x__write_string_table(stream, paths, scratch_pool));
-  SVN_ERR(svn_packed__data_write(stream, root, scratch_pool));
+  SVN_ERR(svn_fs_x__write_string_table(stream, paths, compression,
+                                       scratch_pool));
+  SVN_ERR(svn_packed__data_write2(stream, root, compression, scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -342,6 +384,7 @@ svn_fs_x__write_changes_container(svn_stream_t *stream,
 svn_error_t *
 svn_fs_x__read_changes_container(svn_fs_x__changes_t **changes_p,
                                  svn_stream_t *stream,
+                                 const svn_packed__compression_t *compression,
                                  apr_pool_t *result_pool,
                                  apr_pool_t *scratch_pool)
 {
@@ -355,10 +398,11 @@ svn_fs_x__read_changes_container(svn_fs_x__changes_t **changes_p,
   svn_packed__int_stream_t *changes_stream;
 
   /* read from disk */
-  SVN_ERR(svn_fs_x__read_string_table(&changes->paths, stream,
+  SVN_ERR(svn_fs_x__read_string_table(&changes->paths, stream, compression,
                                       result_pool, scratch_pool));
 
-  SVN_ERR(svn_packed__data_read(&root, stream, result_pool, scratch_pool));
+  SVN_ERR(svn_packed__data_read2(&root, stream, compression, result_pool,
+                                 scratch_pool));
   offsets_stream = svn_packed__first_int_stream(root);
   changes_stream = svn_packed__next_int_stream(offsets_stream);
 
@@ -456,6 +500,9 @@ svn_fs_x__changes_get_list_func(void **out,
   int first;
   int last;
   int i;
+  int copyfrom_idx;
+  const char **strings;
+  apr_size_t *lengths;
   apr_array_header_t *list;
 
   svn_fs_x__changes_get_list_baton_t *b = baton;
@@ -498,6 +545,9 @@ svn_fs_x__changes_get_list_func(void **out,
 
   /* construct result */
   list = apr_array_make(pool, last - first, sizeof(svn_fs_x__change_t*));
+  get_change_paths(&strings, &lengths, paths, TRUE, changes + first,
+                   last - first, pool);
+  copyfrom_idx = last - first;
 
   for (i = first; i < last; ++i)
     {
@@ -505,9 +555,8 @@ svn_fs_x__changes_get_list_func(void **out,
 
       /* convert BINARY_CHANGE into a standard FSX svn_fs_x__change_t */
       svn_fs_x__change_t *change = apr_pcalloc(pool, sizeof(*change));
-      change->path.data
-        = svn_fs_x__string_table_get_func(paths, binary_change->path,
-                                          &change->path.len, pool);
+      change->path.data = strings[i - first];
+      change->path.len = lengths[i - first];
 
       change->change_kind = (svn_fs_path_change_kind_t)
         ((binary_change->flags & CHANGE_KIND_MASK) >> CHANGE_KIND_SHIFT);
@@ -519,11 +568,7 @@ svn_fs_x__changes_get_list_func(void **out,
       change->copyfrom_rev = binary_change->copyfrom_rev;
       change->copyfrom_known = TRUE;
       if (SVN_IS_VALID_REVNUM(binary_change->copyfrom_rev))
-        change->copyfrom_path
-          = svn_fs_x__string_table_get_func(paths,
-                                            binary_change->copyfrom_path,
-                                            NULL,
-                                            pool);
+        change->copyfrom_path = strings[copyfrom_idx++];
 
       /* add it to the result */
       APR_ARRAY_PUSH(list, svn_fs_x__change_t*) = change;
@@ -25,6 +25,7 @@
 
 #include "svn_io.h"
 #include "fs.h"
+#include "private/svn_packed_data.h"
 
 /* Entries in a revision's change list tend to be widely redundant (similar
  * changes to similar paths).  Even more so, change lists from a larger
@@ -84,21 +85,25 @@ svn_fs_x__changes_get_list(apr_array_header_t **list,
 
 /* I/O interface. */
 
-/* Write a serialized representation of CHANGES to STREAM.
+/* Write a serialized representation of CHANGES to STREAM using the
+ * COMPRESSION settings, which may be NULL.
  * Use SCRATCH_POOL for temporary allocations.
  */
 svn_error_t *
 svn_fs_x__write_changes_container(svn_stream_t *stream,
                                   const svn_fs_x__changes_t *changes,
+                                  const svn_packed__compression_t *compression,
                                   apr_pool_t *scratch_pool);
 
 /* Read a changes container from its serialized representation in STREAM.
+ * COMPRESSION, if not NULL, provides the compression dictionary.
  * Allocate the result in RESULT_POOL and return it in *CHANGES_P.  Use
  * SCRATCH_POOL for temporary allocations.
  */
 svn_error_t *
 svn_fs_x__read_changes_container(svn_fs_x__changes_t **changes_p,
                                  svn_stream_t *stream,
+                                 const svn_packed__compression_t *compression,
                                  apr_pool_t *result_pool,
                                  apr_pool_t *scratch_pool);
 
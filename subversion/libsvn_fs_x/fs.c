@@ -310,7 +310,10 @@ static fs_vtable_t fs_vtable = {
   x_info,
   svn_fs_x__verify_root,
   x_freeze,
-  x_set_errcall
+  x_set_errcall,
+  NULL /* changed_revisions */,
+  NULL /* revision_files */,
+  NULL /* build_rep_cache */
 };
 
 
@@ -397,6 +400,34 @@ x_open(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_x__open_instance(svn_fs_t **instance_p,
+                        svn_fs_t *fs,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool)
+{
+  svn_fs_x__data_t *ffd = fs->fsap_data;
+  svn_fs_t *instance = apr_pcalloc(result_pool, sizeof(*instance));
+
+  instance->pool = result_pool;
+  instance->warning = fs->warning;
+  instance->warning_baton = fs->warning_baton;
+  instance->config = fs->config ? apr_hash_copy(result_pool, fs->config)
+                                : NULL;
+
+  SVN_ERR(initialize_fs_struct(instance));
+  SVN_ERR(svn_fs_x__open(instance, fs->path, scratch_pool));
+  SVN_ERR(svn_fs_x__initialize_caches(instance, scratch_pool));
+
+  /* No need to look up the shared data again; it is the same for all
+     instances of this repository. */
+  ((svn_fs_x__data_t *)instance->fsap_data)->shared = ffd->shared;
+
+  *instance_p = instance;
+
+  return SVN_NO_ERROR;
+}
+
 
 
 /* This implements the fs_library_vtable_t.open_for_recovery() API. */
@@ -499,6 +530,7 @@ x_verify(svn_fs_t *fs,
 static svn_error_t *
 x_pack(svn_fs_t *fs,
        const char *path,
+       int jobs,
        svn_fs_pack_notify_t notify_func,
        void *notify_baton,
        svn_cancel_func_t cancel_func,
@@ -508,7 +540,7 @@ x_pack(svn_fs_t *fs,
        apr_pool_t *common_pool)
 {
   SVN_ERR(x_open(fs, path, common_pool_lock, scratch_pool, common_pool));
-  return svn_fs_x__pack(fs, notify_func, notify_baton,
+  return svn_fs_x__pack(fs, jobs, notify_func, notify_baton,
                         cancel_func, cancel_baton, scratch_pool);
 }
 
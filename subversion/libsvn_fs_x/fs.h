@@ -36,7 +36,9 @@
 #include "private/svn_fs_private.h"
 #include "private/svn_sqlite.h"
 #include "private/svn_mutex.h"
+#include "private/svn_subr_private.h"
 
+#include "batch_fsync.h"
 #include "rev_file.h"
 
 #ifdef __cplusplus
@@ -76,6 +78,8 @@ extern "C" {
                                                     to-log index */
 /* If you change this, look at tests/svn_test_fs.c(maybe_install_fsx_conf) */
 #define PATH_CONFIG           "fsx.conf"         /* Configuration */
+#define PATH_CONTAINER_DICT   "container-dict"   /* zstd dictionary for
+                                                    packed containers */
 
 /* Names of special files and file extensions for transactions */
 #define PATH_CHANGES       "changes"       /* Records changes made so far */
@@ -104,13 +108,18 @@ extern "C" {
 #define CONFIG_OPTION_MAX_DELTIFICATION_WALK     "max-deltification-walk"
 #define CONFIG_OPTION_MAX_LINEAR_DELTIFICATION   "max-linear-deltification"
 #define CONFIG_OPTION_COMPRESSION_LEVEL  "compression-level"
+#define CONFIG_OPTION_COMPRESSION        "compression"
+#define CONFIG_OPTION_CONTENT_DEFINED_WINDOWS "content-defined-windows"
 #define CONFIG_SECTION_PACKED_REVPROPS   "packed-revprops"
 #define CONFIG_OPTION_REVPROP_PACK_SIZE  "revprop-pack-size"
 #define CONFIG_OPTION_COMPRESS_PACKED_REVPROPS  "compress-packed-revprops"
+#define CONFIG_SECTION_CONTAINERS        "containers"
+#define CONFIG_OPTION_CONTAINER_COMPRESSION "compression"
 #define CONFIG_SECTION_IO                "io"
 #define CONFIG_OPTION_BLOCK_SIZE         "block-size"
 #define CONFIG_OPTION_L2P_PAGE_SIZE      "l2p-page-size"
 #define CONFIG_OPTION_P2L_PAGE_SIZE      "p2l-page-size"
+#define CONFIG_OPTION_FSYNC_METHOD       "fsync-method"
 #define CONFIG_SECTION_DEBUG             "debug"
 #define CONFIG_OPTION_PACK_AFTER_COMMIT  "pack-after-commit"
 
@@ -274,6 +283,9 @@ typedef struct svn_fs_x__data_t
   /* Rev / pack file granularity covered by phys-to-log index pages */
   apr_int64_t p2l_page_size;
 
+  /* How to flush batches of files to disk. */
+  svn_fs_x__fsync_method_t fsync_method;
+
   /* The revision that was youngest, last time we checked. */
   svn_revnum_t youngest_rev_cache;
 
@@ -394,6 +406,20 @@ typedef struct svn_fs_x__data_t
   /* Compression level to use with txdelta storage format in new revs. */
   int delta_compression_level;
 
+  /* Svndiff version to use for deltas in new revs.  2 selects LZ4,
+   * 1 selects zlib with DELTA_COMPRESSION_LEVEL. */
+  int delta_svndiff_version;
+
+  /* Whether to choose delta window boundaries by content. */
+  svn_boolean_t content_defined_windows;
+
+  /* Whether to compress containers in packed shards with zstd. */
+  svn_boolean_t zstd_containers;
+
+  /* zstd dictionary used by container data in this repository.  NULL
+   * until it has been read from disk or if there is no such dictionary. */
+  svn__compress_dict_t *container_dict;
+
   /* Pack after every commit. */
   svn_boolean_t pack_after_commit;
 
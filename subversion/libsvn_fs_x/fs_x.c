@@ -262,6 +262,8 @@ read_config(svn_fs_x__data_t *ffd,
 {
   svn_config_t *config;
   apr_int64_t compression_level;
+  const char *compression;
+  const char *fsync_method;
 
   SVN_ERR(svn_config_read3(&config,
                            svn_dirent_join(fs_path, PATH_CONFIG, scratch_pool),
@@ -289,6 +291,40 @@ read_config(svn_fs_x__data_t *ffd,
     = (int)MIN(MAX(SVN_DELTA_COMPRESSION_LEVEL_NONE, compression_level),
                 SVN_DELTA_COMPRESSION_LEVEL_MAX);
 
+  /* LZ4 falls back to zlib if this build does not support it. */
+  svn_config_get(config, &compression, CONFIG_SECTION_DELTIFICATION,
+                 CONFIG_OPTION_COMPRESSION, "zlib");
+  ffd->delta_svndiff_version = 1;
+  if (svn_cstring_casecmp(compression, "none") == 0)
+    ffd->delta_compression_level = SVN_DELTA_COMPRESSION_LEVEL_NONE;
+  else if (svn_cstring_casecmp(compression, "lz4") == 0)
+    ffd->delta_svndiff_version = svn_lz4__compiled_version() ? 2 : 1;
+  else if (svn_cstring_casecmp(compression, "zlib") != 0)
+    return svn_error_createf(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                             _("'%s' is not a valid value for fsx.conf "
+                               "setting '%s'."),
+                             compression, CONFIG_OPTION_COMPRESSION);
+
+  SVN_ERR(svn_config_get_bool(config, &ffd->content_defined_windows,
+                              CONFIG_SECTION_DELTIFICATION,
+                              CONFIG_OPTION_CONTENT_DEFINED_WINDOWS,
+                              FALSE));
+
+  /* zstd container compression falls back to zlib if not supported. */
+  svn_config_get(config, &compression, CONFIG_SECTION_CONTAINERS,
+                 CONFIG_OPTION_CONTAINER_COMPRESSION, "zlib");
+  if (svn_cstring_casecmp(compression, "zstd") == 0)
+    ffd->zstd_containers = svn_zstd__compiled_version() != NULL;
+  else if (svn_cstring_casecmp(compression, "zlib") == 0)
+    ffd->zstd_containers = FALSE;
+  else
+    return svn_error_createf(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                             _("'%s' is not a valid value for fsx.conf "
+                               "setting '%s' in section '%s'."),
+                             compression,
+                             CONFIG_OPTION_CONTAINER_COMPRESSION,
+                             CONFIG_SECTION_CONTAINERS);
+
   /* Initialize revprop packing settings in ffd. */
   SVN_ERR(svn_config_get_bool(config, &ffd->compress_packed_revprops,
                               CONFIG_SECTION_PACKED_REVPROPS,
@@ -317,6 +353,22 @@ read_config(svn_fs_x__data_t *ffd,
                                CONFIG_OPTION_P2L_PAGE_SIZE,
                                0x400));
 
+  /* Unsupported methods fall back to "threads" at runtime. */
+  svn_config_get(config, &fsync_method, CONFIG_SECTION_IO,
+                 CONFIG_OPTION_FSYNC_METHOD, "threads");
+  if (svn_cstring_casecmp(fsync_method, "threads") == 0)
+    ffd->fsync_method = svn_fs_x__fsync_threads;
+  else if (svn_cstring_casecmp(fsync_method, "io-uring") == 0)
+    ffd->fsync_method = svn_fs_x__fsync_io_uring;
+  else if (svn_cstring_casecmp(fsync_method, "syncfs") == 0)
+    ffd->fsync_method = svn_fs_x__fsync_syncfs;
+  else
+    return svn_error_createf(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                             _("'%s' is not a valid value for fsx.conf "
+                               "setting '%s' in section '%s'."),
+                             fsync_method, CONFIG_OPTION_FSYNC_METHOD,
+                             CONFIG_SECTION_IO);
+
   /* Don't accept unreasonable or illegal values.
    * Block size and P2L page size are in kbytes;
    * L2P blocks are arrays of apr_off_t. */
@@ -457,6 +509,42 @@ write_config(svn_fs_t *fs,
 "### and 0 disabling it altogether."                                         NL
 "### The default value is 5."                                                NL
 "# " CONFIG_OPTION_COMPRESSION_LEVEL " = 5"                                  NL
+"###"                                                                        NL
+"### This setting selects the compression method used for deltas in future"  NL
+"### revisions.  Valid values are 'zlib', 'lz4' and 'none'.  'zlib' uses the" NL
+"### compression level given above.  'lz4' compresses a bit worse but is"   NL
+"### much faster, which mostly helps when cpu time rather than disk or"      NL
+"### network throughput limits commits and checkouts.  It requires an"       NL
+"### LZ4-enabled build; otherwise 'zlib' will be used instead."             NL
+"### Repositories that use LZ4 can only be read by LZ4-enabled servers."     NL
+"### The default value is 'zlib'."                                           NL
+"# " CONFIG_OPTION_COMPRESSION " = zlib"                                     NL
+"###"                                                                        NL
+"### Deltas are computed in windows of about 100 kB.  By default, the target" NL
+"### is cut into windows at fixed offsets, and each window is compared with"  NL
+"### the respective range of the delta base.  If data gets inserted or"       NL
+"### removed near the start of a large file, as in VM images or archives,"   NL
+"### all later windows are off by that amount and the delta may become"      NL
+"### almost as large as the file itself.  With this setting enabled, window" NL
+"### boundaries are placed where the content has certain patterns and the"   NL
+"### respective window of the delta base starts at the same pattern."        NL
+"### Deltas then stay small despite shifted content, for a slightly higher"  NL
+"### commit time.  The setting only affects data written in the future and"  NL
+"### the resulting deltas can be read by all versions."                       NL
+"### Content-defined windows are disabled by default."                       NL
+"# " CONFIG_OPTION_CONTENT_DEFINED_WINDOWS " = false"                        NL
+""                                                                           NL
+"[" CONFIG_SECTION_CONTAINERS "]"                                            NL
+"### Packing combines node revisions, changed paths lists and small"         NL
+"### representations of many revisions into containers.  This setting"       NL
+"### selects their compression method.  Valid values are 'zlib' and 'zstd'." NL
+"### With 'zstd', 'svnadmin pack' trains a compression dictionary on the"    NL
+"### first shard that it packs and uses it for all shards packed later."     NL
+"### That is faster and gives much better compression for these small"       NL
+"### items but requires a zstd-enabled build to read the packed shards."     NL
+"### Without zstd support, 'zlib' will be used instead."                     NL
+"### The default value is 'zlib'."                                           NL
+"# " CONFIG_OPTION_CONTAINER_COMPRESSION " = zlib"                           NL
 ""                                                                           NL
 "[" CONFIG_SECTION_PACKED_REVPROPS "]"                                       NL
 "### This parameter controls the size (in kBytes) of packed revprop files."  NL
@@ -528,6 +616,16 @@ write_config(svn_fs_t *fs,
 "### Must be a power of 2."                                                  NL
 "### p2l-page-size is given in kBytes and with a default of 1024 kBytes."    NL
 "# " CONFIG_OPTION_P2L_PAGE_SIZE " = 1024"                                   NL
+"###"                                                                        NL
+"### fsync-method selects how commits and other write operations flush all"  NL
+"### files they touched to disk.  \"threads\" runs the fsyncs concurrently"  NL
+"### in a thread pool.  \"io-uring\" submits them all at once through"       NL
+"### io_uring on Linux, avoiding thread wake-ups.  \"syncfs\" flushes the"   NL
+"### whole filesystem(s) containing the files on Linux and should only be"   NL
+"### used if the repository has a filesystem of its own.  Methods not"       NL
+"### supported by the OS fall back to \"threads\", which is also the"        NL
+"### default."                                                               NL
+"# " CONFIG_OPTION_FSYNC_METHOD " = threads"                                 NL
 ;
 #undef NL
   return svn_io_file_create(svn_dirent_join(fs->path, PATH_CONFIG,
@@ -625,6 +723,53 @@ svn_fs_x__open(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_x__container_compression(const svn_packed__compression_t **compression,
+                                svn_fs_t *fs,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool)
+{
+  svn_fs_x__data_t *ffd = fs->fsap_data;
+  svn_packed__compression_t *result;
+
+  /* The dictionary never changes once it has been written.  So, we only
+   * need to look for it until we found it. */
+  if (!ffd->container_dict && svn_zstd__compiled_version())
+    {
+      svn_stringbuf_t *content;
+      svn_error_t *err
+        = svn_stringbuf_from_file2(&content,
+                                   svn_fs_x__path_container_dict(fs,
+                                                                 scratch_pool),
+                                   scratch_pool);
+
+      if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+        {
+          svn_error_clear(err);
+          *compression = NULL;
+          return SVN_NO_ERROR;
+        }
+
+      SVN_ERR(err);
+      SVN_ERR(svn__compress_dict_create(&ffd->container_dict,
+                                        content->data, content->len,
+                                        SVN__COMPRESSION_ZSTD_DEFAULT,
+                                        fs->pool));
+    }
+
+  if (!ffd->container_dict)
+    {
+      *compression = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  result = apr_pcalloc(result_pool, sizeof(*result));
+  result->dict = ffd->container_dict;
+  *compression = result;
+
+  return SVN_NO_ERROR;
+}
+
 /* Baton type bridging svn_fs_x__upgrade and upgrade_body carrying
  * parameters over between them. */
 typedef struct upgrade_baton_t
@@ -24,6 +24,7 @@
 #define SVN_LIBSVN_FS_X_FS_X_H
 
 #include "fs.h"
+#include "private/svn_packed_data.h"
 
 /* Read the 'format' file of fsx filesystem FS and store its info in FS.
  * Use SCRATCH_POOL for temporary allocations. */
@@ -41,6 +42,17 @@ svn_fs_x__open(svn_fs_t *fs,
                const char *path,
                apr_pool_t *scratch_pool);
 
+/* Set *COMPRESSION to the settings required to read and write containers
+ * in FS.  Load the zstd container dictionary, if FS has one.  Otherwise,
+ * set *COMPRESSION to NULL, i.e. plain zlib.  Allocate the result in
+ * RESULT_POOL and use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs_x__container_compression(const svn_packed__compression_t **compression,
+                                svn_fs_t *fs,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool);
+
 /* Initialize parts of the FS data that are being shared across multiple
    filesystem objects.  Use COMMON_POOL for process-wide and SCRATCH_POOL
    for temporary allocations.  Use COMMON_POOL_LOCK to ensure that the
@@ -51,6 +63,17 @@ svn_fs_x__initialize_shared_data(svn_fs_t *fs,
                                  apr_pool_t *scratch_pool,
                                  apr_pool_t *common_pool);
 
+/* Set *INSTANCE_P to another filesystem object for the already open FS,
+   with its own caches and file handles but otherwise configured like FS.
+   This allows for accessing the repository from multiple threads.
+   Allocate the result in RESULT_POOL and use SCRATCH_POOL for temporary
+   allocations. */
+svn_error_t *
+svn_fs_x__open_instance(svn_fs_t **instance_p,
+                        svn_fs_t *fs,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool);
+
 /* Upgrade the fsx filesystem FS.  Indicate progress via the optional
  * NOTIFY_FUNC callback using NOTIFY_BATON.  The optional CANCEL_FUNC
  * will periodically be called with CANCEL_BATON to allow for preemption.
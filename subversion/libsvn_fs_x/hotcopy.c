@@ -593,6 +593,15 @@ hotcopy_body(void *baton,
   SVN_ERR(svn_io_dir_file_copy(src_fs->path, dst_fs->path, PATH_CONFIG,
                                scratch_pool));
 
+  /* Packed containers may need the zstd dictionary.  Copy it before any
+   * pack file that may use it. */
+  SVN_ERR(svn_io_check_path(svn_fs_x__path_container_dict(src_fs,
+                                                          scratch_pool),
+                            &kind, scratch_pool));
+  if (kind == svn_node_file)
+    SVN_ERR(svn_io_dir_file_copy(src_fs->path, dst_fs->path,
+                                 PATH_CONTAINER_DICT, scratch_pool));
+
   if (cancel_func)
     SVN_ERR(cancel_func(cancel_baton));
 
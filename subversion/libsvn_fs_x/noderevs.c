@@ -500,6 +500,7 @@ write_reps(svn_packed__int_stream_t *rep_stream,
 svn_error_t *
 svn_fs_x__write_noderevs_container(svn_stream_t *stream,
                                    const svn_fs_x__noderevs_t *container,
+                                   const svn_packed__compression_t *compression,
                                    apr_pool_t *scratch_pool)
 {
   int i;
@@ -572,8 +573,9 @@ svn_fs_x__write_noderevs_container(svn_stream_t *stream,
     }
 
   /* write to disk */
-  SVN_ERR(svn_fs_x__write_string_table(stream, paths, scratch_pool));
-  SVN_ERR(svn_packed__data_write(stream, root, scratch_pool));
+  SVN_ERR(svn_fs_x__write_string_table(stream, paths, compression,
+                                       scratch_pool));
+  SVN_ERR(svn_packed__data_write2(stream, root, compression, scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -646,6 +648,7 @@ read_reps(apr_array_header_t **reps_p,
 svn_error_t *
 svn_fs_x__read_noderevs_container(svn_fs_x__noderevs_t **container,
                                   svn_stream_t *stream,
+                                  const svn_packed__compression_t *compression,
                                   apr_pool_t *result_pool,
                                   apr_pool_t *scratch_pool)
 {
@@ -663,9 +666,10 @@ svn_fs_x__read_noderevs_container(svn_fs_x__noderevs_t **container,
   svn_packed__byte_stream_t *digests_stream;
 
   /* read everything from disk */
-  SVN_ERR(svn_fs_x__read_string_table(&noderevs->paths, stream,
+  SVN_ERR(svn_fs_x__read_string_table(&noderevs->paths, stream, compression,
                                       result_pool, scratch_pool));
-  SVN_ERR(svn_packed__data_read(&root, stream, result_pool, scratch_pool));
+  SVN_ERR(svn_packed__data_read2(&root, stream, compression, result_pool,
+                                 scratch_pool));
 
   /* get streams */
   structs_stream = svn_packed__first_int_stream(root);
@@ -25,6 +25,7 @@
 
 #include "svn_io.h"
 #include "fs.h"
+#include "private/svn_packed_data.h"
 
 /* A collection of related noderevs tends to be widely redundant (similar
  * paths, predecessor ID matching anothers ID, shared representations etc.)
@@ -80,21 +81,25 @@ svn_fs_x__noderevs_get(svn_fs_x__noderev_t **noderev_p,
 
 /* I/O interface. */
 
-/* Write a serialized representation of CONTAINER to STREAM.
+/* Write a serialized representation of CONTAINER to STREAM using the
+ * COMPRESSION settings, which may be NULL.
  * Use SCRATCH_POOL for temporary allocations.
  */
 svn_error_t *
 svn_fs_x__write_noderevs_container(svn_stream_t *stream,
                                    const svn_fs_x__noderevs_t *container,
+                                   const svn_packed__compression_t *compression,
                                    apr_pool_t *scratch_pool);
 
 /* Read a noderev container from its serialized representation in STREAM.
+ * COMPRESSION, if not NULL, provides the compression dictionary.
  * Allocate the result in RESULT_POOL and return it in *CONTAINER.  Use
  * SCRATCH_POOL for temporary allocations.
  */
 svn_error_t *
 svn_fs_x__read_noderevs_container(svn_fs_x__noderevs_t **container,
                                    svn_stream_t *stream,
+                                   const svn_packed__compression_t *compression,
                                    apr_pool_t *result_pool,
                                    apr_pool_t *scratch_pool);
 
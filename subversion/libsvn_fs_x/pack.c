@@ -21,6 +21,9 @@
  */
 #include <assert.h>
 
+#include <apr_thread_proc.h>
+#include <apr_thread_cond.h>
+
 #include "svn_pools.h"
 #include "svn_dirent_uri.h"
 #include "svn_sorts.h"
@@ -28,6 +31,8 @@
 #include "private/svn_subr_private.h"
 #include "private/svn_string_private.h"
 #include "private/svn_temp_serializer.h"
+#include "private/svn_atomic.h"
+#include "private/svn_mutex.h"
 
 #include "fs_x.h"
 #include "pack.h"
@@ -90,6 +95,11 @@
  */
 #define DEFAULT_MAX_MEM (64 * 1024 * 1024)
 
+/* Maximum size of the zstd container dictionary and of the container data
+ * that we sample to train it. */
+#define CONTAINER_DICT_SIZE (64 * 1024)
+#define MAX_DICT_SAMPLES_SIZE (100 * CONTAINER_DICT_SIZE)
+
 /* Data structure describing a node change at PATH, REVISION.
  * We will sort these instances by PATH and NODE_ID such that we can combine
  * similar nodes in the same reps container and store containers in path
@@ -126,6 +136,14 @@ typedef struct reference_t
   svn_fs_x__id_t from;
 } reference_t;
 
+/* Threads reading representation fulltexts ahead of them being added to
+ * reps containers.  Only available with threading support.
+ */
+typedef struct rep_reader_worker_t rep_reader_worker_t;
+
+/* Shared state of all reader threads for one sequence of reps. */
+typedef struct rep_reader_t rep_reader_t;
+
 /* This structure keeps track of all the temporary data and status that
  * needs to be kept around during the creation of one pack file.  After
  * each revision range (in case we can't process all revs at once due to
@@ -228,13 +246,117 @@ typedef struct pack_context_t
   /* pool used for temporary data structures that will be cleaned up when
    * the next range of revisions is being processed */
   apr_pool_t *info_pool;
+
+  /* compression settings for the containers written to the pack file.
+   * May be NULL.  If it collects samples, we will train a container
+   * dictionary from them once the shard has been packed. */
+  svn_packed__compression_t *compression;
+
+  /* same as COMPRESSION but without sampling.  Use this when serializing
+   * containers just to estimate their size. */
+  svn_packed__compression_t *probe_compression;
+
+  /* total size of the samples in COMPRESSION */
+  apr_size_t samples_size;
+
+  /* READER_COUNT workers reading fulltexts while the main thread builds
+   * reps containers from them.  May be NULL / 0. */
+  rep_reader_worker_t *readers;
+  int reader_count;
 } pack_context_t;
 
+#if APR_HAS_THREADS
+
+/* Number of fulltexts per reader thread that may be read ahead of the
+ * one currently being added to a reps container. */
+#define READ_AHEAD_PER_THREAD 4
+
+struct rep_reader_worker_t
+{
+  /* The shared state while the thread is running.  NULL otherwise. */
+  rep_reader_t *reader;
+
+  /* Private filesystem instance. */
+  svn_fs_t *fs;
+
+  /* Root pool used only by this thread. */
+  apr_pool_t *pool;
+
+  /* The running thread or NULL. */
+  apr_thread_t *thread;
+};
+
+/* Destructor for the reader threads' state in the pack_context_t * DATA.
+ * All threads must have been stopped already. */
+static apr_status_t
+readers_cleanup(void *data)
+{
+  pack_context_t *context = data;
+  int i;
+
+  for (i = 0; i < context->reader_count; ++i)
+    svn_pool_destroy(context->readers[i].pool);
+
+  return APR_SUCCESS;
+}
+
+#endif
+
+/* Set up to JOBS - 1 reader threads' filesystem instances in CONTEXT,
+ * i.e. do nothing unless JOBS is at least 2.  Allocate the state in POOL
+ * and release it when POOL gets cleaned up.
+ */
+static void
+initialize_readers(pack_context_t *context,
+                   int jobs,
+                   apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  apr_pool_t *iterpool;
+  int i;
+
+  if (jobs < 2)
+    return;
+
+  iterpool = svn_pool_create(pool);
+  context->readers = apr_pcalloc(pool,
+                                 (jobs - 1) * sizeof(*context->readers));
+  for (i = 0; i < jobs - 1; ++i)
+    {
+      rep_reader_worker_t *worker = &context->readers[context->reader_count];
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+      worker->pool
+        = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+
+      /* FS objects must not be shared between threads.  If we can't get
+         another one, we simply use fewer threads. */
+      err = svn_fs_x__open_instance(&worker->fs, context->fs, worker->pool,
+                                    iterpool);
+      if (err)
+        {
+          svn_error_clear(err);
+          svn_pool_destroy(worker->pool);
+        }
+      else
+        {
+          context->reader_count++;
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  apr_pool_cleanup_register(pool, context, readers_cleanup,
+                            apr_pool_cleanup_null);
+#endif
+}
+
 /* Create and initialize a new pack context for packing shard SHARD_REV in
  * SHARD_DIR into PACK_FILE_DIR within filesystem FS.  Allocate it in POOL
  * and return the structure in *CONTEXT.
  *
  * Limit the number of items being copied per iteration to MAX_ITEMS.
+ * Use up to JOBS threads when building containers.
  * Set CANCEL_FUNC and CANCEL_BATON as well.
  */
 static svn_error_t *
@@ -244,6 +366,7 @@ initialize_pack_context(pack_context_t *context,
                         const char *shard_dir,
                         svn_revnum_t shard_rev,
                         int max_items,
+                        int jobs,
                         svn_fs_x__batch_fsync_t *batch,
                         svn_cancel_func_t cancel_func,
                         void *cancel_baton,
@@ -320,6 +443,73 @@ initialize_pack_context(pack_context_t *context,
   context->info_pool = svn_pool_create(pool);
   context->paths = svn_prefix_tree__create(context->info_pool);
 
+  /* zstd containers need a dictionary.  If we don't have one, yet, pack
+   * this shard with zlib and collect the data to train one. */
+  if (ffd->zstd_containers)
+    {
+      const svn_packed__compression_t *compression;
+      SVN_ERR(svn_fs_x__container_compression(&compression, fs, pool, pool));
+
+      context->compression = apr_pcalloc(pool,
+                                         sizeof(*context->compression));
+      if (compression)
+        {
+          *context->compression = *compression;
+        }
+      else
+        {
+          context->compression->samples
+            = apr_array_make(pool, 256, sizeof(svn_stringbuf_t *));
+          context->compression->samples_size = &context->samples_size;
+          context->compression->max_samples_size = MAX_DICT_SAMPLES_SIZE;
+        }
+
+      context->probe_compression
+        = apr_pmemdup(pool, context->compression,
+                      sizeof(*context->compression));
+      context->probe_compression->samples = NULL;
+    }
+
+  initialize_readers(context, jobs, pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* If CONTEXT collected samples of container data, train a zstd dictionary
+ * from them and store it in the repository.  Future packs will then use it.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+write_container_dict(pack_context_t *context,
+                     apr_pool_t *scratch_pool)
+{
+  svn_fs_x__data_t *ffd = context->fs->fsap_data;
+  svn_stringbuf_t *dict_data;
+
+  if (!context->compression || !context->compression->samples)
+    return SVN_NO_ERROR;
+
+  /* Too few or too uniform samples are not an error.  We will simply
+   * try again with the next shard. */
+  SVN_ERR(svn__compress_dict_train(&dict_data,
+                                   context->compression->samples,
+                                   CONTAINER_DICT_SIZE,
+                                   scratch_pool, scratch_pool));
+  if (!dict_data)
+    return SVN_NO_ERROR;
+
+  /* The dictionary must be on disk before we write any data using it. */
+  SVN_ERR(svn_io_write_atomic2(svn_fs_x__path_container_dict(context->fs,
+                                                             scratch_pool),
+                               dict_data->data, dict_data->len,
+                               svn_fs_x__path_current(context->fs,
+                                                      scratch_pool),
+                               ffd->flush_to_disk, scratch_pool));
+  SVN_ERR(svn__compress_dict_create(&ffd->container_dict,
+                                    dict_data->data, dict_data->len,
+                                    SVN__COMPRESSION_ZSTD_DEFAULT,
+                                    context->fs->pool));
+
   return SVN_NO_ERROR;
 }
 
@@ -1031,6 +1221,7 @@ write_nodes_container(pack_context_t *context,
                                                           TRUE, scratch_pool),
                                  scratch_pool);
   SVN_ERR(svn_fs_x__write_noderevs_container(pack_stream, *container,
+                                             context->compression,
                                              scratch_pool));
   SVN_ERR(svn_stream_close(pack_stream));
   SVN_ERR(svn_io_file_seek(context->pack_file, APR_CUR, &offset,
@@ -1119,7 +1310,8 @@ store_nodes(pack_context_t *context,
             = svn_stream_from_stringbuf(serialized, iterpool);
 
           SVN_ERR(svn_fs_x__write_noderevs_container(temp_stream, *container,
-                                                     iterpool));
+                                                context->probe_compression,
+                                                iterpool));
           SVN_ERR(svn_stream_close(temp_stream));
 
           last_container_size = container_size;
@@ -1163,6 +1355,328 @@ store_nodes(pack_context_t *context,
 }
 
 
+/* Set *CONTENTS to the fulltext of REPRESENTATION in FS, allocated in
+ * RESULT_POOL.
+ */
+static svn_error_t *
+read_rep_fulltext(svn_stringbuf_t **contents,
+                  svn_fs_t *fs,
+                  svn_fs_x__representation_t *representation,
+                  apr_pool_t *result_pool)
+{
+  svn_stream_t *stream;
+
+  SVN_ERR(svn_fs_x__get_contents(&stream, fs, representation, FALSE,
+                                 result_pool));
+  *contents = svn_stringbuf_create_ensure(representation->expanded_size,
+                                          result_pool);
+  (*contents)->len = representation->expanded_size;
+
+  /* The representation is immutable.  Read it normally. */
+  SVN_ERR(svn_stream_read_full(stream, (*contents)->data, &(*contents)->len));
+  SVN_ERR(svn_stream_close(stream));
+
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS
+
+/* A fulltext to be read by some reader thread. */
+typedef struct rep_text_t
+{
+  /* The representation to read. */
+  svn_fs_x__representation_t representation;
+
+  /* Root pool owned by this fulltext and containing TEXT.  Thread-safe.
+   * NULL until DONE is set. */
+  apr_pool_t *pool;
+
+  /* The fulltext.  Only valid if DONE is set and ERR is SVN_NO_ERROR. */
+  svn_stringbuf_t *text;
+
+  /* Result of the read operation. */
+  svn_error_t *err;
+
+  /* Set once the text has been read. */
+  svn_boolean_t done;
+} rep_text_t;
+
+struct rep_reader_t
+{
+  /* Protects all members but TEXTS[].REPRESENTATION.  Used with COND. */
+  svn_mutex__t *mutex;
+
+  /* Signaled whenever a text has been read or consumed and when a worker
+     terminates. */
+  apr_thread_cond_t *cond;
+
+  /* The fulltexts to read, in the order of consumption. */
+  rep_text_t *texts;
+  int count;
+
+  /* The next text to be claimed by a worker. */
+  int next;
+
+  /* Number of texts consumed so far.  Workers don't claim texts WINDOW or
+     more ahead of the next one to consume. */
+  int consumed;
+  int window;
+
+  /* Number of worker threads that have not terminated yet. */
+  volatile svn_atomic_t running;
+
+  /* Non-zero once the workers shall stop. */
+  volatile svn_atomic_t aborted;
+
+  /* The workers. */
+  rep_reader_worker_t *workers;
+  int worker_count;
+};
+
+/* Set *INDEX to the next text to read for READER.  Wait until it is within
+   the read-ahead window.  Set it to -1 if there is nothing left to do. */
+static svn_error_t *
+claim_rep_text(int *index,
+               rep_reader_t *reader)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+
+  SVN_ERR(svn_mutex__lock(reader->mutex));
+
+  /* This loop implicitly handles spurious wake-ups. */
+  while (!svn_atomic_read(&reader->aborted)
+         && reader->next < reader->count
+         && reader->next - reader->consumed >= reader->window)
+    {
+      apr_status_t status
+        = apr_thread_cond_wait(reader->cond, svn_mutex__get(reader->mutex));
+      if (status)
+        {
+          err = svn_error_wrap_apr(status,
+                                   _("Can't wait for condition variable"));
+          break;
+        }
+    }
+
+  if (err
+      || svn_atomic_read(&reader->aborted)
+      || reader->next >= reader->count)
+    *index = -1;
+  else
+    *index = reader->next++;
+
+  return svn_error_trace(svn_mutex__unlock(reader->mutex, err));
+}
+
+/* Thread function.  Read fulltexts for the rep_reader_worker_t given by
+   DATA until there are no more or reading got aborted. */
+static void * APR_THREAD_FUNC
+rep_reader_thread(apr_thread_t *tid,
+                  void *data)
+{
+  rep_reader_worker_t *worker = data;
+  rep_reader_t *reader = worker->reader;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  while (!err)
+    {
+      rep_text_t *text;
+      svn_stringbuf_t *contents = NULL;
+      svn_error_t *read_err;
+      apr_pool_t *pool;
+      int index;
+
+      err = claim_rep_text(&index, reader);
+      if (err || index < 0)
+        break;
+
+      /* The main thread will release the text, so it needs a pool that
+         is not tied to this thread. */
+      text = &reader->texts[index];
+      pool = svn_pool_create(NULL);
+      read_err = read_rep_fulltext(&contents, worker->fs,
+                                   &text->representation, pool);
+
+      /* Once claimed, the main thread waits for this text.  So, hand it
+         over even if we could not get the lock. */
+      err = svn_mutex__lock(reader->mutex);
+      text->pool = pool;
+      text->text = contents;
+      text->err = read_err;
+      text->done = TRUE;
+      if (!err)
+        {
+          apr_thread_cond_broadcast(reader->cond);
+          err = svn_mutex__unlock(reader->mutex, SVN_NO_ERROR);
+        }
+    }
+
+  svn_error_clear(err);
+
+  /* Texts that no worker is left for will be read by the main thread. */
+  err = svn_mutex__lock(reader->mutex);
+  svn_atomic_dec(&reader->running);
+  if (!err)
+    {
+      apr_thread_cond_broadcast(reader->cond);
+      err = svn_mutex__unlock(reader->mutex, SVN_NO_ERROR);
+    }
+
+  svn_error_clear(err);
+
+  return NULL;
+}
+
+/* Start the reader threads of CONTEXT to read the fulltexts of the COUNT
+ * representations in TEXTS.  Only their REPRESENTATION members must have
+ * been initialized.  Set *READER_P to the shared state, allocated in POOL.
+ */
+static svn_error_t *
+start_rep_reader(rep_reader_t **reader_p,
+                 pack_context_t *context,
+                 rep_text_t *texts,
+                 int count,
+                 apr_pool_t *pool)
+{
+  rep_reader_t *reader = apr_pcalloc(pool, sizeof(*reader));
+  apr_status_t status;
+  int i;
+
+  SVN_ERR(svn_mutex__init(&reader->mutex, TRUE, pool));
+  status = apr_thread_cond_create(&reader->cond, pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create condition variable"));
+
+  reader->texts = texts;
+  reader->count = count;
+  reader->window = context->reader_count * READ_AHEAD_PER_THREAD;
+  reader->workers = context->readers;
+
+  for (i = 0; i < context->reader_count; ++i)
+    {
+      rep_reader_worker_t *worker = &context->readers[i];
+      worker->reader = reader;
+
+      svn_atomic_inc(&reader->running);
+      status = apr_thread_create(&worker->thread, NULL, rep_reader_thread,
+                                 worker, worker->pool);
+      if (status)
+        {
+          svn_atomic_dec(&reader->running);
+          worker->reader = NULL;
+          break;
+        }
+
+      reader->worker_count++;
+    }
+
+  *reader_p = reader;
+
+  return SVN_NO_ERROR;
+}
+
+/* Stop all worker threads of READER and discard the texts that have not
+ * been consumed, yet. */
+static svn_error_t *
+stop_rep_reader(rep_reader_t *reader)
+{
+  svn_error_t *err;
+  int i;
+
+  svn_atomic_set(&reader->aborted, TRUE);
+  err = svn_mutex__lock(reader->mutex);
+  apr_thread_cond_broadcast(reader->cond);
+  err = svn_mutex__unlock(reader->mutex, err);
+
+  for (i = 0; i < reader->worker_count; i++)
+    {
+      apr_status_t retval;
+      apr_status_t status = apr_thread_join(&retval,
+                                            reader->workers[i].thread);
+      if (status)
+        err = svn_error_compose_create(
+                err, svn_error_wrap_apr(status, _("Can't join read thread")));
+
+      reader->workers[i].reader = NULL;
+      reader->workers[i].thread = NULL;
+    }
+
+  for (i = reader->consumed; i < reader->count; i++)
+    if (reader->texts[i].done)
+      {
+        svn_error_clear(reader->texts[i].err);
+        svn_pool_destroy(reader->texts[i].pool);
+      }
+
+  return svn_error_trace(err);
+}
+
+/* Set *CONTENTS to the INDEX-th fulltext of READER, allocated in
+ * RESULT_POOL.  The fulltexts must be consumed strictly in order.
+ * Read it in this thread if no worker is left to do it.  CONTEXT is
+ * the pack context that READER belongs to.
+ */
+static svn_error_t *
+consume_rep_text(svn_stringbuf_t **contents,
+                 pack_context_t *context,
+                 rep_reader_t *reader,
+                 int index,
+                 apr_pool_t *result_pool)
+{
+  rep_text_t *text = &reader->texts[index];
+  svn_error_t *err = SVN_NO_ERROR;
+  svn_boolean_t claimed;
+
+  SVN_ERR_ASSERT(index == reader->consumed);
+  SVN_ERR(svn_mutex__lock(reader->mutex));
+
+  /* This loop implicitly handles spurious wake-ups. */
+  while (!text->done
+         && index < reader->next
+         && svn_atomic_read(&reader->running))
+    {
+      apr_status_t status
+        = apr_thread_cond_wait(reader->cond, svn_mutex__get(reader->mutex));
+      if (status)
+        {
+          err = svn_error_wrap_apr(status,
+                                   _("Can't wait for condition variable"));
+          break;
+        }
+    }
+
+  /* Don't let any worker claim that text anymore. */
+  claimed = index < reader->next;
+  if (!claimed)
+    reader->next = index + 1;
+
+  if (!err)
+    {
+      reader->consumed = index + 1;
+      apr_thread_cond_broadcast(reader->cond);
+    }
+
+  SVN_ERR(svn_mutex__unlock(reader->mutex, err));
+
+  /* No worker is left to read this one. */
+  if (!claimed)
+    return svn_error_trace(read_rep_fulltext(contents, context->fs,
+                                             &text->representation,
+                                             result_pool));
+
+  /* Take over the text.  Containers keep a copy of their own. */
+  err = text->err;
+  if (!err)
+    *contents = svn_stringbuf_dup(text->text, result_pool);
+
+  svn_pool_destroy(text->pool);
+  text->done = FALSE;
+
+  return svn_error_trace(err);
+}
+
+#endif /* APR_HAS_THREADS */
+
 /* Finalize CONTAINER and write it to CONTEXT's pack file.
  * Append an P2L entry containing the given SUB_ITEMS to NEW_ENTRIES.
  * Use SCRATCH_POOL for temporary allocations.
@@ -1185,6 +1699,7 @@ write_reps_container(pack_context_t *context,
                                  scratch_pool);
 
   SVN_ERR(svn_fs_x__write_reps_container(pack_stream, container,
+                                         context->compression,
                                          scratch_pool));
   SVN_ERR(svn_stream_close(pack_stream));
   SVN_ERR(svn_io_file_seek(context->pack_file, APR_CUR, &offset,
@@ -1206,16 +1721,45 @@ write_reps_container(pack_context_t *context,
   return SVN_NO_ERROR;
 }
 
+/* Set *REPRESENTATION to the representation described by ENTRY in
+ * TEMP_FILE, which FILE wraps.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+get_temp_representation(svn_fs_x__representation_t *representation,
+                        pack_context_t *context,
+                        apr_file_t *temp_file,
+                        svn_fs_x__revision_file_t *file,
+                        svn_fs_x__p2l_entry_t *entry,
+                        apr_pool_t *scratch_pool)
+{
+  assert(entry->item_count == 1);
+  memset(representation, 0, sizeof(*representation));
+  representation->id = entry->items[0];
+
+  SVN_ERR(svn_io_file_seek(temp_file, APR_SET, &entry->offset,
+                           scratch_pool));
+  SVN_ERR(svn_fs_x__get_representation_length(&representation->size,
+                                         &representation->expanded_size,
+                                         context->fs, file,
+                                         entry, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Read the (property) representations identified by svn_fs_x__p2l_entry_t
  * elements in ENTRIES from TEMP_FILE, aggregate them and write them into
- * CONTEXT->PACK_FILE.  Use SCRATCH_POOL for temporary allocations.
+ * CONTEXT->PACK_FILE.  If READER is not NULL, take the fulltexts from it
+ * instead of reading them here.  Use SCRATCH_POOL for temporary
+ * allocations.
  */
 static svn_error_t *
-write_reps_containers(pack_context_t *context,
-                      apr_array_header_t *entries,
-                      apr_file_t *temp_file,
-                      apr_array_header_t *new_entries,
-                      apr_pool_t *scratch_pool)
+fill_reps_containers(pack_context_t *context,
+                     apr_array_header_t *entries,
+                     apr_file_t *temp_file,
+                     svn_fs_x__revision_file_t *file,
+                     rep_reader_t *reader,
+                     apr_array_header_t *new_entries,
+                     apr_pool_t *scratch_pool)
 {
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
   apr_pool_t *container_pool = svn_pool_create(scratch_pool);
@@ -1227,17 +1771,11 @@ write_reps_containers(pack_context_t *context,
     = svn_fs_x__reps_builder_create(context->fs, container_pool);
   apr_array_header_t *sub_items
     = apr_array_make(scratch_pool, 64, sizeof(svn_fs_x__id_t));
-  svn_fs_x__revision_file_t *file;
-
-  SVN_ERR(svn_fs_x__rev_file_wrap_temp(&file, context->fs, temp_file,
-                                       scratch_pool));
 
   /* copy all items in strict order */
   for (i = entries->nelts-1; i >= 0; --i)
     {
-      svn_fs_x__representation_t representation = { 0 };
       svn_stringbuf_t *contents;
-      svn_stream_t *stream;
       apr_size_t list_index;
       svn_fs_x__p2l_entry_t *entry
         = APR_ARRAY_IDX(entries, i, svn_fs_x__p2l_entry_t *);
@@ -1267,26 +1805,23 @@ write_reps_containers(pack_context_t *context,
           block_left = get_block_left(context);
         }
 
-      assert(entry->item_count == 1);
-      representation.id = entry->items[0];
-
-      /* select the change list in the source file, parse it and add it to
-       * the container */
-      SVN_ERR(svn_io_file_seek(temp_file, APR_SET, &entry->offset,
-                               iterpool));
-      SVN_ERR(svn_fs_x__get_representation_length(&representation.size,
-                                             &representation.expanded_size,
-                                             context->fs, file,
-                                             entry, iterpool));
-      SVN_ERR(svn_fs_x__get_contents(&stream, context->fs, &representation,
-                                     FALSE, iterpool));
-      contents = svn_stringbuf_create_ensure(representation.expanded_size,
-                                             iterpool);
-      contents->len = representation.expanded_size;
-
-      /* The representation is immutable.  Read it normally. */
-      SVN_ERR(svn_stream_read_full(stream, contents->data, &contents->len));
-      SVN_ERR(svn_stream_close(stream));
+      /* get the representation's fulltext and add it to the container */
+#if APR_HAS_THREADS
+      if (reader)
+        {
+          SVN_ERR(consume_rep_text(&contents, context, reader,
+                                   entries->nelts - 1 - i, iterpool));
+        }
+      else
+#endif
+        {
+          svn_fs_x__representation_t representation;
+          SVN_ERR(get_temp_representation(&representation, context,
+                                          temp_file, file, entry,
+                                          iterpool));
+          SVN_ERR(read_rep_fulltext(&contents, context->fs, &representation,
+                                    iterpool));
+        }
 
       SVN_ERR(svn_fs_x__reps_add(&list_index, container,
                                  svn_stringbuf__morph_into_string(contents)));
@@ -1308,6 +1843,66 @@ write_reps_containers(pack_context_t *context,
   return SVN_NO_ERROR;
 }
 
+/* Read the (property) representations identified by svn_fs_x__p2l_entry_t
+ * elements in ENTRIES from TEMP_FILE, aggregate them and write them into
+ * CONTEXT->PACK_FILE.  Let the reader threads in CONTEXT, if any, read the
+ * fulltexts while we add them to the containers.  The result does not
+ * depend on the number of threads.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+static svn_error_t *
+write_reps_containers(pack_context_t *context,
+                      apr_array_header_t *entries,
+                      apr_file_t *temp_file,
+                      apr_array_header_t *new_entries,
+                      apr_pool_t *scratch_pool)
+{
+  svn_fs_x__revision_file_t *file;
+  rep_reader_t *reader = NULL;
+  svn_error_t *err;
+
+  SVN_ERR(svn_fs_x__rev_file_wrap_temp(&file, context->fs, temp_file,
+                                       scratch_pool));
+
+#if APR_HAS_THREADS
+  /* Determine all representations in order of consumption up-front
+   * and let the workers read their fulltexts. */
+  if (context->reader_count && entries->nelts > 1)
+    {
+      apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+      rep_text_t *texts = apr_pcalloc(scratch_pool,
+                                      entries->nelts * sizeof(*texts));
+      int i;
+
+      for (i = 0; i < entries->nelts; ++i)
+        {
+          svn_fs_x__p2l_entry_t *entry
+            = APR_ARRAY_IDX(entries, entries->nelts - 1 - i,
+                            svn_fs_x__p2l_entry_t *);
+
+          svn_pool_clear(iterpool);
+          SVN_ERR(get_temp_representation(&texts[i].representation,
+                                          context, temp_file, file, entry,
+                                          iterpool));
+        }
+
+      svn_pool_destroy(iterpool);
+      SVN_ERR(start_rep_reader(&reader, context, texts, entries->nelts,
+                               scratch_pool));
+    }
+#endif
+
+  err = fill_reps_containers(context, entries, temp_file, file, reader,
+                             new_entries, scratch_pool);
+
+#if APR_HAS_THREADS
+  if (reader)
+    err = svn_error_compose_create(err, stop_rep_reader(reader));
+#endif
+
+  return svn_error_trace(err);
+}
+
 /* Return TRUE if the estimated size of the NODES_IN_CONTAINER plus the
  * representations given as svn_fs_x__p2l_entry_t * in ENTRIES may exceed
  * the space left in the current block.
@@ -1502,6 +2097,7 @@ write_changes_container(pack_context_t *context,
 
   SVN_ERR(svn_fs_x__write_changes_container(pack_stream,
                                              container,
+                                             context->compression,
                                              scratch_pool));
   SVN_ERR(svn_stream_close(pack_stream));
   SVN_ERR(svn_io_file_seek(context->pack_file, APR_CUR, &offset,
@@ -1573,7 +2169,9 @@ write_changes_containers(pack_context_t *context,
             = svn_stream_from_stringbuf(serialized, iterpool);
 
           SVN_ERR(svn_fs_x__write_changes_container(memory_stream,
-                                                     container, iterpool));
+                                                container,
+                                                context->probe_compression,
+                                                iterpool));
           SVN_ERR(svn_stream_close(temp_stream));
 
           block_left = get_block_left(context) - serialized->len;
@@ -1907,6 +2505,7 @@ append_revision(pack_context_t *context,
  * Pack the revision shard starting at SHARD_REV in filesystem FS from
  * SHARD_DIR into the PACK_FILE_DIR, using SCRATCH_POOL for temporary
  * allocations.  Limit the extra memory consumption to MAX_MEM bytes.
+ * Use up to JOBS threads.
  * CANCEL_FUNC and CANCEL_BATON are what you think they are.
  * Schedule necessary fsync calls in BATCH.
  */
@@ -1916,6 +2515,7 @@ pack_log_addressed(svn_fs_t *fs,
                    const char *shard_dir,
                    svn_revnum_t shard_rev,
                    apr_size_t max_mem,
+                   int jobs,
                    svn_fs_x__batch_fsync_t *batch,
                    svn_cancel_func_t cancel_func,
                    void *cancel_baton,
@@ -1943,8 +2543,8 @@ pack_log_addressed(svn_fs_t *fs,
 
   /* set up a pack context */
   SVN_ERR(initialize_pack_context(&context, fs, pack_file_dir, shard_dir,
-                                  shard_rev, max_items, batch, cancel_func,
-                                  cancel_baton, scratch_pool));
+                                  shard_rev, max_items, jobs, batch,
+                                  cancel_func, cancel_baton, scratch_pool));
 
   /* phase 1: determine the size of the revisions to pack */
   SVN_ERR(svn_fs_x__l2p_get_max_ids(&max_ids, fs, shard_rev,
@@ -1992,6 +2592,7 @@ pack_log_addressed(svn_fs_t *fs,
   /* last phase: finalize indexes and clean up */
   SVN_ERR(reset_pack_context(&context, iterpool));
   SVN_ERR(close_pack_context(&context, iterpool));
+  SVN_ERR(write_container_dict(&context, iterpool));
   svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
@@ -2000,8 +2601,9 @@ pack_log_addressed(svn_fs_t *fs,
 /* In filesystem FS, pack the revision SHARD containing exactly
  * MAX_FILES_PER_DIR revisions from SHARD_PATH into the PACK_FILE_DIR,
  * using SCRATCH_POOL for temporary allocations.  Try to limit the amount of
- * temporary memory needed to MAX_MEM bytes.  CANCEL_FUNC and CANCEL_BATON
- * are what you think they are.  Schedule necessary fsync calls in BATCH.
+ * temporary memory needed to MAX_MEM bytes.  Use up to JOBS threads.
+ * CANCEL_FUNC and CANCEL_BATON are what you think they are.  Schedule
+ * necessary fsync calls in BATCH.
  *
  * If for some reason we detect a partial packing already performed, we
  * remove the pack file and start again.
@@ -2015,6 +2617,7 @@ pack_rev_shard(svn_fs_t *fs,
                apr_int64_t shard,
                int max_files_per_dir,
                apr_size_t max_mem,
+               int jobs,
                svn_fs_x__batch_fsync_t *batch,
                svn_cancel_func_t cancel_func,
                void *cancel_baton,
@@ -2036,8 +2639,8 @@ pack_rev_shard(svn_fs_t *fs,
 
   /* Index information files */
   SVN_ERR(pack_log_addressed(fs, pack_file_dir, shard_path, shard_rev,
-                             max_mem, batch, cancel_func, cancel_baton,
-                             scratch_pool));
+                             max_mem, jobs, batch, cancel_func,
+                             cancel_baton, scratch_pool));
 
   SVN_ERR(svn_io_copy_perms(shard_path, pack_file_dir, scratch_pool));
   SVN_ERR(svn_io_set_file_read_only(pack_file_path, FALSE, scratch_pool));
@@ -2045,9 +2648,453 @@ pack_rev_shard(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
+/* Set *PACK_FILE_DIR and *SHARD_PATH to the directories of the packed
+ * and the non-packed revision SHARD in DIR, respectively.  Allocate
+ * them in POOL.
+ */
+static void
+get_shard_paths(const char **pack_file_dir,
+                const char **shard_path,
+                const char *dir,
+                apr_int64_t shard,
+                apr_pool_t *pool)
+{
+  *pack_file_dir = svn_dirent_join(dir,
+                  apr_psprintf(pool,
+                               "%" APR_INT64_T_FMT PATH_EXT_PACKED_SHARD,
+                               shard),
+                  pool);
+  *shard_path = svn_dirent_join(dir,
+                                apr_psprintf(pool, "%" APR_INT64_T_FMT, shard),
+                                pool);
+}
+
+/* In the file system FS, pack the rev and revprop files of SHARD in DIR
+ * containing exactly MAX_FILES_PER_DIR revisions into the pack directory
+ * without publishing it.  The revprop packs will not exceed MAX_PACK_SIZE
+ * bytes and use COMPRESSION_LEVEL.  Use up to JOBS threads.  Don't return
+ * before all data has been made persistent, if FS is configured that way.
+ * Use SCRATCH_POOL for temporary allocations.
+ *
+ * CANCEL_FUNC and CANCEL_BATON are what you think they are.
+ *
+ * If for some reason we detect a partial packing already performed, we
+ * remove the pack file and start again.
+ */
+static svn_error_t *
+pack_shard_content(const char *dir,
+                   svn_fs_t *fs,
+                   apr_int64_t shard,
+                   int max_files_per_dir,
+                   apr_off_t max_pack_size,
+                   int compression_level,
+                   int jobs,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *scratch_pool)
+{
+  svn_fs_x__data_t *ffd = fs->fsap_data;
+  const char *shard_path, *pack_file_dir;
+  svn_fs_x__batch_fsync_t *batch;
+
+  /* Perform all fsyncs through this instance. */
+  SVN_ERR(svn_fs_x__batch_fsync_create(&batch, ffd->flush_to_disk,
+                                       ffd->fsync_method, scratch_pool));
+
+  /* Some useful paths. */
+  get_shard_paths(&pack_file_dir, &shard_path, dir, shard, scratch_pool);
+
+  /* pack the revision content */
+  SVN_ERR(pack_rev_shard(fs, pack_file_dir, shard_path,
+                         shard, max_files_per_dir, DEFAULT_MAX_MEM, jobs,
+                         batch, cancel_func, cancel_baton, scratch_pool));
+
+  /* pack the revprops in an equivalent way */
+  SVN_ERR(svn_fs_x__pack_revprops_shard(fs,
+                                        pack_file_dir,
+                                        shard_path,
+                                        shard, max_files_per_dir,
+                                        (int)(0.9 * max_pack_size),
+                                        compression_level, batch,
+                                        cancel_func, cancel_baton,
+                                        scratch_pool));
+
+  /* Ensure that packed file is written to disk.*/
+  SVN_ERR(svn_fs_x__batch_fsync_run(batch, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* State of the worker threads that pack shards ahead of the one
+ * currently being processed by pack_body().  Publishing the packed shards
+ * still happens in strict shard order in the thread that runs pack_body().
+ */
+typedef struct shard_packer_t shard_packer_t;
+
+#if APR_HAS_THREADS
+
+/* Number of shards per worker thread that may be packed ahead of the
+   oldest one not published yet. */
+#define PACK_WINDOW_PER_THREAD 2
+
+/* Check for cancellation that often while waiting for a worker. */
+#define PACK_WAIT_INTERVAL apr_time_from_msec(100)
+
+/* Outcome of packing a single shard in a worker thread. */
+typedef struct pack_job_t
+{
+  /* The shard that has been packed. */
+  apr_int64_t shard;
+
+  /* The error returned by pack_shard_content(). */
+  svn_error_t *err;
+} pack_job_t;
+
+/* Per-thread data of a pack worker. */
+typedef struct pack_worker_t
+{
+  /* The shared state. */
+  shard_packer_t *packer;
+
+  /* Private filesystem instance. */
+  svn_fs_t *fs;
+
+  /* Root pool used only by this thread. */
+  apr_pool_t *pool;
+
+  /* The thread itself or NULL if it could not be started. */
+  apr_thread_t *thread;
+} pack_worker_t;
+
+struct shard_packer_t
+{
+  /* Protects NEXT_SHARD, FIRST_SHARD and JOBS.  Used with COND. */
+  svn_mutex__t *mutex;
+
+  /* Signaled whenever a job completes, a worker terminates or a shard
+     has been published. */
+  apr_thread_cond_t *cond;
+
+  /* The next shard to be claimed by a worker. */
+  apr_int64_t next_shard;
+
+  /* The oldest shard that has not been published yet. */
+  apr_int64_t first_shard;
+
+  /* One past the last shard to pack. */
+  apr_int64_t end_shard;
+
+  /* Completed jobs, indexed by shard modulo MAX_JOBS.  Workers don't
+     claim shards MAX_JOBS or more ahead of FIRST_SHARD. */
+  pack_job_t *jobs;
+  svn_boolean_t *done;
+  int max_jobs;
+
+  /* Number of worker threads that have not terminated yet. */
+  volatile svn_atomic_t running;
+
+  /* Non-zero once the workers shall stop. */
+  volatile svn_atomic_t aborted;
+
+  /* Parameters for pack_shard_content().  Read-only. */
+  const char *dir;
+  int max_files_per_dir;
+  apr_off_t max_pack_size;
+  int compression_level;
+
+  /* All worker threads. */
+  pack_worker_t *workers;
+  int worker_count;
+};
+
+/* Implements svn_cancel_func_t for the shard_packer_t BATON.
+   Workers must not call the caller's cancellation function. */
+static svn_error_t *
+check_pack_aborted(void *baton)
+{
+  shard_packer_t *packer = baton;
+
+  if (svn_atomic_read(&packer->aborted))
+    return svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *SHARD to the next shard to pack for PACKER.  Wait until it is
+   within the job window.  Set it to -1 if there is nothing left to do. */
+static svn_error_t *
+claim_shard(apr_int64_t *shard,
+            shard_packer_t *packer)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+
+  SVN_ERR(svn_mutex__lock(packer->mutex));
+
+  /* This loop implicitly handles spurious wake-ups. */
+  while (!svn_atomic_read(&packer->aborted)
+         && packer->next_shard < packer->end_shard
+         && packer->next_shard - packer->first_shard >= packer->max_jobs)
+    {
+      apr_status_t status
+        = apr_thread_cond_wait(packer->cond, svn_mutex__get(packer->mutex));
+      if (status)
+        {
+          err = svn_error_wrap_apr(status,
+                                   _("Can't wait for condition variable"));
+          break;
+        }
+    }
+
+  if (err
+      || svn_atomic_read(&packer->aborted)
+      || packer->next_shard >= packer->end_shard)
+    *shard = -1;
+  else
+    *shard = packer->next_shard++;
+
+  return svn_error_trace(svn_mutex__unlock(packer->mutex, err));
+}
+
+/* Thread function.  Pack shards for the pack_worker_t given by DATA until
+   there are no more or packing got aborted. */
+static void * APR_THREAD_FUNC
+pack_thread(apr_thread_t *tid,
+            void *data)
+{
+  pack_worker_t *worker = data;
+  shard_packer_t *packer = worker->packer;
+  apr_pool_t *iterpool = svn_pool_create(worker->pool);
+  svn_error_t *err = SVN_NO_ERROR;
+
+  while (!err)
+    {
+      apr_int64_t shard;
+      svn_error_t *pack_err;
+      int slot;
+
+      svn_pool_clear(iterpool);
+
+      err = claim_shard(&shard, packer);
+      if (err || shard < 0)
+        break;
+
+      /* Our FS instance does not know about the shards that got packed
+         since we opened it.  Nothing beyond those changes, though. */
+      pack_err = pack_shard_content(packer->dir, worker->fs, shard,
+                                    packer->max_files_per_dir,
+                                    packer->max_pack_size,
+                                    packer->compression_level, 1,
+                                    check_pack_aborted, packer, iterpool);
+
+      /* Once claimed, the main thread waits for this shard.  So, hand it
+         over even if we could not get the lock. */
+      err = svn_mutex__lock(packer->mutex);
+      slot = (int)(shard % packer->max_jobs);
+      packer->jobs[slot].shard = shard;
+      packer->jobs[slot].err = pack_err;
+      packer->done[slot] = TRUE;
+      if (!err)
+        {
+          apr_thread_cond_broadcast(packer->cond);
+          err = svn_mutex__unlock(packer->mutex, SVN_NO_ERROR);
+        }
+    }
+
+  svn_error_clear(err);
+  svn_pool_destroy(iterpool);
+
+  /* Shards that no worker is left for will be packed by the main
+     thread. */
+  err = svn_mutex__lock(packer->mutex);
+  svn_atomic_dec(&packer->running);
+  if (!err)
+    {
+      apr_thread_cond_broadcast(packer->cond);
+      err = svn_mutex__unlock(packer->mutex, SVN_NO_ERROR);
+    }
+
+  svn_error_clear(err);
+
+  return NULL;
+}
+
+/* Wait for the worker threads of PACKER to pack SHARD,
+   which is the oldest shard not published yet.  Check for cancellation
+   through CANCEL_FUNC and CANCEL_BATON periodically.  Set *PACKED to FALSE
+   if no worker is left to pack SHARD.  Otherwise, set it to TRUE and
+   return the error that packing SHARD returned. */
+static svn_error_t *
+wait_for_shard(svn_boolean_t *packed,
+               shard_packer_t *packer,
+               apr_int64_t shard,
+               svn_cancel_func_t cancel_func,
+               void *cancel_baton)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+  int slot = (int)(shard % packer->max_jobs);
+
+  SVN_ERR(svn_mutex__lock(packer->mutex));
+
+  while (!packer->done[slot] && svn_atomic_read(&packer->running))
+    {
+      apr_status_t status;
+
+      if (cancel_func)
+        {
+          err = cancel_func(cancel_baton);
+          if (err)
+            break;
+        }
+
+      status = apr_thread_cond_timedwait(packer->cond,
+                                         svn_mutex__get(packer->mutex),
+                                         PACK_WAIT_INTERVAL);
+      if (status && !APR_STATUS_IS_TIMEUP(status))
+        {
+          err = svn_error_wrap_apr(status,
+                                   _("Can't wait for condition variable"));
+          break;
+        }
+    }
+
+  if (!err)
+    {
+      *packed = packer->done[slot];
+      if (*packed)
+        {
+          SVN_ERR_ASSERT_NO_RETURN(packer->jobs[slot].shard == shard);
+          err = packer->jobs[slot].err;
+          packer->jobs[slot].err = SVN_NO_ERROR;
+          packer->done[slot] = FALSE;
+        }
+
+      /* Free the slot for the next shard. */
+      packer->first_shard = shard + 1;
+      apr_thread_cond_broadcast(packer->cond);
+    }
+
+  return svn_error_trace(svn_mutex__unlock(packer->mutex, err));
+}
+
+/* Start up to JOBS worker threads in *PACKER that pack the shards
+   FIRST_SHARD up to but not including END_SHARD in FS.  The workers
+   write to the pack directories in DIR but never publish the result.
+   MAX_PACK_SIZE and COMPRESSION_LEVEL are as for pack_shard_content().
+   Use POOL for the shared state. */
+static svn_error_t *
+start_shard_packer(shard_packer_t **packer_p,
+                   svn_fs_t *fs,
+                   const char *dir,
+                   apr_int64_t first_shard,
+                   apr_int64_t end_shard,
+                   int jobs,
+                   apr_off_t max_pack_size,
+                   int compression_level,
+                   apr_pool_t *pool)
+{
+  svn_fs_x__data_t *ffd = fs->fsap_data;
+  shard_packer_t *packer = apr_pcalloc(pool, sizeof(*packer));
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_status_t status;
+  int i;
+
+  SVN_ERR(svn_mutex__init(&packer->mutex, TRUE, pool));
+  status = apr_thread_cond_create(&packer->cond, pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create condition variable"));
+
+  if (end_shard - first_shard < jobs)
+    jobs = (int)(end_shard - first_shard);
+
+  packer->next_shard = first_shard;
+  packer->first_shard = first_shard;
+  packer->end_shard = end_shard;
+  packer->max_jobs = jobs * PACK_WINDOW_PER_THREAD;
+  packer->jobs = apr_pcalloc(pool, packer->max_jobs * sizeof(*packer->jobs));
+  packer->done = apr_pcalloc(pool, packer->max_jobs * sizeof(*packer->done));
+  packer->dir = dir;
+  packer->max_files_per_dir = ffd->max_files_per_dir;
+  packer->max_pack_size = max_pack_size;
+  packer->compression_level = compression_level;
+  packer->workers = apr_pcalloc(pool, jobs * sizeof(*packer->workers));
+
+  for (i = 0; i < jobs; i++)
+    {
+      pack_worker_t *worker = &packer->workers[packer->worker_count];
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+
+      worker->packer = packer;
+      worker->pool
+        = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+
+      /* FS objects must not be shared between threads.  Leave the work
+         to the other workers or to the main thread if we can't get one. */
+      err = svn_fs_x__open_instance(&worker->fs, fs, worker->pool,
+                                     iterpool);
+      if (!err)
+        {
+          svn_atomic_inc(&packer->running);
+          status = apr_thread_create(&worker->thread, NULL, pack_thread,
+                                     worker, worker->pool);
+          if (status)
+            svn_atomic_dec(&packer->running);
+          else
+            packer->worker_count++;
+        }
+
+      if (err || status)
+        {
+          svn_error_clear(err);
+          svn_pool_destroy(worker->pool);
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  *packer_p = packer;
+
+  return SVN_NO_ERROR;
+}
+
+/* Stop all worker threads of PACKER and discard their results. */
+static svn_error_t *
+stop_shard_packer(shard_packer_t *packer)
+{
+  svn_error_t *err;
+  int i;
+
+  svn_atomic_set(&packer->aborted, TRUE);
+  err = svn_mutex__lock(packer->mutex);
+  apr_thread_cond_broadcast(packer->cond);
+  err = svn_mutex__unlock(packer->mutex, err);
+
+  for (i = 0; i < packer->worker_count; i++)
+    {
+      apr_status_t retval;
+      apr_status_t status = apr_thread_join(&retval,
+                                            packer->workers[i].thread);
+      if (status)
+        err = svn_error_compose_create(
+                err, svn_error_wrap_apr(status, _("Can't join pack thread")));
+
+      svn_pool_destroy(packer->workers[i].pool);
+    }
+
+  for (i = 0; i < packer->max_jobs; i++)
+    if (packer->done[i])
+      svn_error_clear(packer->jobs[i].err);
+
+  return svn_error_trace(err);
+}
+
+#endif /* APR_HAS_THREADS */
+
 /* In the file system at FS_PATH, pack the SHARD in DIR containing exactly
  * MAX_FILES_PER_DIR revisions, using SCRATCH_POOL temporary for allocations.
  * COMPRESSION_LEVEL and MAX_PACK_SIZE will be ignored in that case.
+ * If PACKER is not NULL, let its worker threads do the actual packing.
+ * Otherwise, use up to JOBS threads for packing the shard.
  *
  * CANCEL_FUNC and CANCEL_BATON are what you think they are; similarly
  * NOTIFY_FUNC and NOTIFY_BATON.
@@ -2062,6 +3109,8 @@ pack_shard(const char *dir,
            int max_files_per_dir,
            apr_off_t max_pack_size,
            int compression_level,
+           shard_packer_t *packer,
+           int jobs,
            svn_fs_pack_notify_t notify_func,
            void *notify_baton,
            svn_cancel_func_t cancel_func,
@@ -2070,41 +3119,25 @@ pack_shard(const char *dir,
 {
   svn_fs_x__data_t *ffd = fs->fsap_data;
   const char *shard_path, *pack_file_dir;
-  svn_fs_x__batch_fsync_t *batch;
+  svn_boolean_t packed = FALSE;
 
   /* Notify caller we're starting to pack this shard. */
   if (notify_func)
     SVN_ERR(notify_func(notify_baton, shard, svn_fs_pack_notify_start,
                         scratch_pool));
 
-  /* Perform all fsyncs through this instance. */
-  SVN_ERR(svn_fs_x__batch_fsync_create(&batch, ffd->flush_to_disk,
-                                       scratch_pool));
-
-  /* Some useful paths. */
-  pack_file_dir = svn_dirent_join(dir,
-                  apr_psprintf(scratch_pool,
-                               "%" APR_INT64_T_FMT PATH_EXT_PACKED_SHARD,
-                               shard),
-                  scratch_pool);
-  shard_path = svn_dirent_join(dir,
-                      apr_psprintf(scratch_pool, "%" APR_INT64_T_FMT, shard),
-                      scratch_pool);
+  /* pack the shard contents, unless some worker thread did it already */
+#if APR_HAS_THREADS
+  if (packer)
+    SVN_ERR(wait_for_shard(&packed, packer, shard,
+                           cancel_func, cancel_baton));
+#endif
 
-  /* pack the revision content */
-  SVN_ERR(pack_rev_shard(fs, pack_file_dir, shard_path,
-                         shard, max_files_per_dir, DEFAULT_MAX_MEM, batch,
-                         cancel_func, cancel_baton, scratch_pool));
-
-  /* pack the revprops in an equivalent way */
-  SVN_ERR(svn_fs_x__pack_revprops_shard(fs,
-                                        pack_file_dir,
-                                        shard_path,
-                                        shard, max_files_per_dir,
-                                        (int)(0.9 * max_pack_size),
-                                        compression_level, batch,
-                                        cancel_func, cancel_baton,
-                                        scratch_pool));
+  if (!packed)
+    SVN_ERR(pack_shard_content(dir, fs, shard, max_files_per_dir,
+                               max_pack_size, compression_level,
+                               packer ? 1 : jobs,
+                               cancel_func, cancel_baton, scratch_pool));
 
   /* Update the min-unpacked-rev file to reflect our newly packed shard. */
   SVN_ERR(svn_fs_x__write_min_unpacked_rev(fs,
@@ -2112,10 +3145,8 @@ pack_shard(const char *dir,
                           scratch_pool));
   ffd->min_unpacked_rev = (svn_revnum_t)((shard + 1) * max_files_per_dir);
 
-  /* Ensure that packed file is written to disk.*/
-  SVN_ERR(svn_fs_x__batch_fsync_run(batch, scratch_pool));
-
   /* Finally, remove the existing shard directories. */
+  get_shard_paths(&pack_file_dir, &shard_path, dir, shard, scratch_pool);
   SVN_ERR(svn_io_remove_dir2(shard_path, TRUE,
                              cancel_func, cancel_baton, scratch_pool));
 
@@ -2162,6 +3193,7 @@ typedef struct pack_baton_t
   void *notify_baton;
   svn_cancel_func_t cancel_func;
   void *cancel_baton;
+  int jobs;
 } pack_baton_t;
 
 
@@ -2186,10 +3218,16 @@ pack_body(void *baton,
   pack_baton_t *pb = baton;
   svn_fs_x__data_t *ffd = pb->fs->fsap_data;
   apr_int64_t completed_shards;
+  apr_int64_t first_shard;
   apr_int64_t i;
   apr_pool_t *iterpool;
   const char *data_path;
   svn_boolean_t fully_packed;
+  int compression_level = ffd->compress_packed_revprops
+                        ? SVN__COMPRESSION_ZLIB_DEFAULT
+                        : SVN__COMPRESSION_NONE;
+  shard_packer_t *packer = NULL;
+  svn_error_t *err = SVN_NO_ERROR;
 
   /* Since another process might have already packed the repo,
      we need to re-read the pack status. */
@@ -2207,32 +3245,47 @@ pack_body(void *baton,
   completed_shards = (ffd->youngest_rev_cache + 1) / ffd->max_files_per_dir;
   data_path = svn_dirent_join(pb->fs->path, PATH_REVS_DIR, scratch_pool);
 
+  first_shard = ffd->min_unpacked_rev / ffd->max_files_per_dir;
+
+#if APR_HAS_THREADS
+  /* Let worker threads pack the upcoming shards while we publish them
+     one by one. */
+  if (pb->jobs > 1 && completed_shards - first_shard > 1)
+    SVN_ERR(start_shard_packer(&packer, pb->fs, data_path, first_shard,
+                               completed_shards, pb->jobs,
+                               ffd->revprop_pack_size, compression_level,
+                               scratch_pool));
+#endif
+
   iterpool = svn_pool_create(scratch_pool);
-  for (i = ffd->min_unpacked_rev / ffd->max_files_per_dir;
-       i < completed_shards;
-       i++)
+  for (i = first_shard; !err && i < completed_shards; i++)
     {
       svn_pool_clear(iterpool);
 
       if (pb->cancel_func)
-        SVN_ERR(pb->cancel_func(pb->cancel_baton));
+        err = pb->cancel_func(pb->cancel_baton);
 
-      SVN_ERR(pack_shard(data_path,
+      if (!err)
+        err = pack_shard(data_path,
                          pb->fs, i, ffd->max_files_per_dir,
-                         ffd->revprop_pack_size,
-                         ffd->compress_packed_revprops
-                           ? SVN__COMPRESSION_ZLIB_DEFAULT
-                           : SVN__COMPRESSION_NONE,
+                         ffd->revprop_pack_size, compression_level, packer,
+                         pb->jobs,
                          pb->notify_func, pb->notify_baton,
-                         pb->cancel_func, pb->cancel_baton, iterpool));
+                         pb->cancel_func, pb->cancel_baton, iterpool);
     }
 
+#if APR_HAS_THREADS
+  if (packer)
+    err = svn_error_compose_create(err, stop_shard_packer(packer));
+#endif
+
   svn_pool_destroy(iterpool);
-  return SVN_NO_ERROR;
+  return svn_error_trace(err);
 }
 
 svn_error_t *
 svn_fs_x__pack(svn_fs_t *fs,
+               int jobs,
                svn_fs_pack_notify_t notify_func,
                void *notify_baton,
                svn_cancel_func_t cancel_func,
@@ -2262,5 +3315,6 @@ svn_fs_x__pack(svn_fs_t *fs,
   pb.notify_baton = notify_baton;
   pb.cancel_func = cancel_func;
   pb.cancel_baton = cancel_baton;
+  pb.jobs = jobs;
   return svn_fs_x__with_pack_lock(fs, pack_body, &pb, scratch_pool);
 }
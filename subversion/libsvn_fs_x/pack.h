@@ -27,12 +27,16 @@
 
 /* Possibly pack the repository at PATH.  This just take full shards, and
    combines all the revision files into a single one, with a manifest header.
-   Use optional CANCEL_FUNC/CANCEL_BATON for cancellation support.
+   Pack up to JOBS shards concurrently; values below 2 pack one shard after
+   the other.  If given, NOTIFY_FUNC will be called with NOTIFY_BATON to
+   report progress.  Use optional CANCEL_FUNC/CANCEL_BATON for cancellation
+   support.
    Use SCRATCH_POOL for temporary allocations.
 
    Existing filesystem references need not change.  */
 svn_error_t *
 svn_fs_x__pack(svn_fs_t *fs,
+               int jobs,
                svn_fs_pack_notify_t notify_func,
                void *notify_baton,
                svn_cancel_func_t cancel_func,
@@ -660,6 +660,34 @@ svn_fs_x__reps_get(svn_fs_x__rep_extractor_t **extractor,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_x__reps_get_many(apr_array_header_t **extractors,
+                        svn_fs_t *fs,
+                        const svn_fs_x__reps_t *container,
+                        const apr_array_header_t *indexes,
+                        apr_pool_t *result_pool)
+{
+  int i;
+
+  *extractors = apr_array_make(result_pool, indexes->nelts,
+                               sizeof(svn_fs_x__rep_extractor_t *));
+  for (i = 0; i < indexes->nelts; ++i)
+    {
+      apr_size_t idx = APR_ARRAY_IDX(indexes, i, apr_size_t);
+      if (idx >= container->rep_count)
+        return svn_error_createf(SVN_ERR_FS_CONTAINER_INDEX, NULL,
+                                 _("Representation index %ld exceeds "
+                                   "container size %ld"),
+                                 (long)idx, (long)container->rep_count);
+
+      SVN_ERR(svn_fs_x__reps_get(&APR_ARRAY_PUSH(*extractors,
+                                                 svn_fs_x__rep_extractor_t *),
+                                 fs, container, idx, result_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_x__extractor_drive(svn_stringbuf_t **contents,
                           svn_fs_x__rep_extractor_t *extractor,
@@ -694,6 +722,7 @@ svn_fs_x__extractor_drive(svn_stringbuf_t **contents,
 svn_error_t *
 svn_fs_x__write_reps_container(svn_stream_t *stream,
                                const svn_fs_x__reps_builder_t *builder,
+                               const svn_packed__compression_t *compression,
                                apr_pool_t *scratch_pool)
 {
   int i;
@@ -760,7 +789,7 @@ svn_fs_x__write_reps_container(svn_stream_t *stream,
   svn_packed__add_uint(misc_stream, 0);
 
   /* write to stream */
-  SVN_ERR(svn_packed__data_write(stream, root, scratch_pool));
+  SVN_ERR(svn_packed__data_write2(stream, root, compression, scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -768,6 +797,7 @@ svn_fs_x__write_reps_container(svn_stream_t *stream,
 svn_error_t *
 svn_fs_x__read_reps_container(svn_fs_x__reps_t **container,
                               svn_stream_t *stream,
+                              const svn_packed__compression_t *compression,
                               apr_pool_t *result_pool,
                               apr_pool_t *scratch_pool)
 {
@@ -787,7 +817,8 @@ svn_fs_x__read_reps_container(svn_fs_x__reps_t **container,
   svn_packed__byte_stream_t *text_stream;
 
   /* read from disk */
-  SVN_ERR(svn_packed__data_read(&root, stream, result_pool, scratch_pool));
+  SVN_ERR(svn_packed__data_read2(&root, stream, compression, result_pool,
+                                 scratch_pool));
 
   bases_stream = svn_packed__first_int_stream(root);
   reps_stream = svn_packed__next_int_stream(bases_stream);
@@ -917,16 +948,14 @@ svn_fs_x__deserialize_reps_container(void **out,
   return SVN_NO_ERROR;
 }
 
-svn_error_t *
-svn_fs_x__reps_get_func(void **out,
-                        const void *data,
-                        apr_size_t data_len,
-                        void *baton,
-                        apr_pool_t *pool)
+/* Return a copy of the svn_fs_x__reps_t header of the cache serialized
+ * container DATA, allocated in POOL, with its pointers referring to the
+ * arrays within DATA.
+ */
+static const svn_fs_x__reps_t *
+get_cached_reps(const void *data,
+                apr_pool_t *pool)
 {
-  svn_fs_x__reps_baton_t *reps_baton = baton;
-
-  /* get a usable reps structure  */
   const svn_fs_x__reps_t *cached = data;
   svn_fs_x__reps_t *reps = apr_pmemdup(pool, cached, sizeof(*reps));
 
@@ -941,9 +970,42 @@ svn_fs_x__reps_get_func(void **out,
     = svn_temp_deserializer__ptr(cached,
                                  (const void **)&cached->instructions);
 
+  return reps;
+}
+
+svn_error_t *
+svn_fs_x__reps_get_func(void **out,
+                        const void *data,
+                        apr_size_t data_len,
+                        void *baton,
+                        apr_pool_t *pool)
+{
+  svn_fs_x__reps_baton_t *reps_baton = baton;
+
+  /* get a usable reps structure  */
+  const svn_fs_x__reps_t *reps = get_cached_reps(data, pool);
+
   /* return an extractor for the selected item */
   SVN_ERR(svn_fs_x__reps_get((svn_fs_x__rep_extractor_t **)out,
                              reps_baton->fs, reps, reps_baton->idx, pool));
 
   return SVN_NO_ERROR;
 }
+
+svn_error_t *
+svn_fs_x__reps_get_many_func(void **out,
+                             const void *data,
+                             apr_size_t data_len,
+                             void *baton,
+                             apr_pool_t *pool)
+{
+  svn_fs_x__reps_many_baton_t *reps_baton = baton;
+  const svn_fs_x__reps_t *reps = get_cached_reps(data, pool);
+
+  /* return extractors for all selected items */
+  SVN_ERR(svn_fs_x__reps_get_many((apr_array_header_t **)out,
+                                  reps_baton->fs, reps, reps_baton->indexes,
+                                  pool));
+
+  return SVN_NO_ERROR;
+}
@@ -25,6 +25,7 @@
 
 #include "svn_io.h"
 #include "fs.h"
+#include "private/svn_packed_data.h"
 
 /* This container type implements the start-delta (aka pick lists) data
  * structure plus functions to create it and read data from it.  The key
@@ -69,6 +70,17 @@ typedef struct svn_fs_x__reps_baton_t
   apr_size_t idx;
 } svn_fs_x__reps_baton_t;
 
+/* Baton type to be passed to svn_fs_x__reps_get_many_func.
+ */
+typedef struct svn_fs_x__reps_many_baton_t
+{
+  /* filesystem the resulting extractors shall operate on */
+  svn_fs_t *fs;
+
+  /* element indexes (apr_size_t) of the items to extract */
+  const apr_array_header_t *indexes;
+} svn_fs_x__reps_many_baton_t;
+
 /* Create and populate noderev containers. */
 
 /* Create and return a new builder object, allocated in RESULT_POOL.
@@ -121,6 +133,19 @@ svn_fs_x__reps_get(svn_fs_x__rep_extractor_t **extractor,
                    apr_size_t idx,
                    apr_pool_t *result_pool);
 
+/* Like svn_fs_x__reps_get but create extractors for all fulltexts in
+ * CONTAINER whose apr_size_t indexes are given in INDEXES.  Return them
+ * as an array of svn_fs_x__rep_extractor_t * in *EXTRACTORS, in the same
+ * order as INDEXES.  This processes CONTAINER only once for the whole
+ * batch.  Allocate the result in RESULT_POOL.
+ */
+svn_error_t *
+svn_fs_x__reps_get_many(apr_array_header_t **extractors,
+                        svn_fs_t *fs,
+                        const svn_fs_x__reps_t *container,
+                        const apr_array_header_t *indexes,
+                        apr_pool_t *result_pool);
+
 /* Let the EXTRACTOR object fetch all parts of the desired fulltext and
  * return the latter in *CONTENTS.  If SIZE is not 0, return SIZE bytes
  * starting at offset START_OFFSET of the full contents.  If that range
@@ -141,20 +166,24 @@ svn_fs_x__extractor_drive(svn_stringbuf_t** contents,
 /* I/O interface. */
 
 /* Write a serialized representation of the final container described by
- * BUILDER to STREAM.  Use SCRATCH_POOL for temporary allocations.
+ * BUILDER to STREAM using the COMPRESSION settings, which may be NULL.
+ * Use SCRATCH_POOL for temporary allocations.
  */
 svn_error_t *
 svn_fs_x__write_reps_container(svn_stream_t *stream,
                                const svn_fs_x__reps_builder_t *builder,
+                               const svn_packed__compression_t *compression,
                                apr_pool_t *scratch_pool);
 
 /* Read a representations container from its serialized representation in
- * STREAM.  Allocate the result in RESULT_POOL and return it in *CONTAINER.
+ * STREAM.  COMPRESSION, if not NULL, provides the compression dictionary.
+ * Allocate the result in RESULT_POOL and return it in *CONTAINER.
  * Use SCRATCH_POOL for temporary allocations.
  */
 svn_error_t *
 svn_fs_x__read_reps_container(svn_fs_x__reps_t **container,
                               svn_stream_t *stream,
+                              const svn_packed__compression_t *compression,
                               apr_pool_t *result_pool,
                               apr_pool_t *scratch_pool);
 
@@ -187,4 +216,17 @@ svn_fs_x__reps_get_func(void **out,
                         void *baton,
                         apr_pool_t *pool);
 
+/* Implements svn_cache__partial_getter_func_t for svn_fs_x__reps_t,
+ * setting *OUT to an array of svn_fs_x__rep_extractor_t objects defined
+ * by the svn_fs_x__reps_many_baton_t passed in as *BATON.  This function
+ * is similar to svn_fs_x__reps_get_many but operates on the cache
+ * serialized representation of the container.
+ */
+svn_error_t *
+svn_fs_x__reps_get_many_func(void **out,
+                             const void *data,
+                             apr_size_t data_len,
+                             void *baton,
+                             apr_pool_t *pool);
+
 #endif
@@ -1396,7 +1396,7 @@ svn_fs_x__set_revision_proplist(svn_fs_t *fs,
 
   /* Perform all fsyncs through this instance. */
   SVN_ERR(svn_fs_x__batch_fsync_create(&batch, ffd->flush_to_disk,
-                                       scratch_pool));
+                                       ffd->fsync_method, scratch_pool));
 
   /* this info will not change while we hold the global FS write lock */
   is_packed = svn_fs_x__is_packed_revprop(fs, rev);
@@ -24,6 +24,7 @@
 #include <string.h>
 #include <apr_tables.h>
 
+#include "svn_pools.h"
 #include "svn_string.h"
 #include "svn_sorts.h"
 #include "private/svn_dep_compat.h"
@@ -584,9 +585,277 @@ svn_fs_x__string_table_get(const string_table_t *table,
   return apr_pstrmemdup(result_pool, "", 0);
 }
 
+/* Bulk extraction state for a single sub-table.
+ */
+typedef struct bulk_sub_table_t
+{
+  /* copy of the sub-table with DATA, SHORT_STRINGS and LONG_STRINGS
+     pointers resolved.  The LONG_STRINGS[].DATA pointers may still be
+     serialized, see LONG_STRINGS_SERIALIZED. */
+  string_sub_table_t table;
+
+  /* whether LONG_STRINGS[].DATA need to be resolved before use */
+  svn_boolean_t long_strings_serialized;
+
+  /* NEEDED[I] is set if short string I needs to be reconstructed. */
+  svn_boolean_t *needed;
+
+  /* DECODED[I] is short string I, once reconstructed. */
+  const char **decoded;
+
+  /* stack of short string indexes waiting for their head to be
+     reconstructed */
+  apr_size_t *stack;
+} bulk_sub_table_t;
+
+/* Return the bulk extraction state for sub-table TABLE_NUMBER of TABLE
+ * from BULK.  Create it in SCRATCH_POOL if it does not exist, yet.
+ * SERIALIZED indicates that TABLE is the cache serialized representation.
+ */
+static bulk_sub_table_t *
+get_bulk_sub_table(bulk_sub_table_t **bulk,
+                   const string_table_t *table,
+                   apr_size_t table_number,
+                   svn_boolean_t serialized,
+                   apr_pool_t *scratch_pool)
+{
+  bulk_sub_table_t *result = bulk[table_number];
+  if (result)
+    return result;
+
+  result = apr_pcalloc(scratch_pool, sizeof(*result));
+  if (serialized)
+    {
+      const string_sub_table_t *sub_tables
+        = svn_temp_deserializer__ptr(table,
+                                     (const void *const *)&table->sub_tables);
+      const string_sub_table_t *sub_table = sub_tables + table_number;
+
+      result->table = *sub_table;
+      result->table.data
+        = svn_temp_deserializer__ptr(sub_tables,
+                                     (const void *const *)&sub_table->data);
+      result->table.short_strings
+        = (string_header_t *)svn_temp_deserializer__ptr(sub_tables,
+                            (const void *const *)&sub_table->short_strings);
+      result->table.long_strings
+        = (svn_string_t *)svn_temp_deserializer__ptr(sub_table,
+                             (const void *const *)&sub_table->long_strings);
+      result->long_strings_serialized = TRUE;
+    }
+  else
+    {
+      result->table = table->sub_tables[table_number];
+    }
+
+  result->needed = apr_pcalloc(scratch_pool,
+                               result->table.short_string_count
+                                 * sizeof(*result->needed));
+  result->decoded = apr_pcalloc(scratch_pool,
+                                result->table.short_string_count
+                                  * sizeof(*result->decoded));
+  result->stack = apr_palloc(scratch_pool,
+                             result->table.short_string_count
+                               * sizeof(*result->stack));
+
+  bulk[table_number] = result;
+  return result;
+}
+
+/* Mark short string SUB_INDEX in BULK and all strings that its head
+ * gets copied from as needed.  Return the number of bytes required to
+ * store the strings that were not marked before, including their
+ * terminating NULs.
+ */
+static apr_size_t
+mark_needed(bulk_sub_table_t *bulk,
+            apr_size_t sub_index)
+{
+  apr_size_t size = 0;
+  while (!bulk->needed[sub_index])
+    {
+      const string_header_t *header
+        = &bulk->table.short_strings[sub_index];
+
+      bulk->needed[sub_index] = TRUE;
+      size += header->head_length + header->tail_length + 1;
+      if (header->head_length == 0)
+        break;
+
+      sub_index = header->head_string;
+    }
+
+  return size;
+}
+
+/* Reconstruct short string SUB_INDEX in BULK at *BUFFER, unless that
+ * has already happened, and return it.  The heads of strings are copied
+ * from already reconstructed strings, so every string needs only two
+ * memcpy() calls.  Strings reconstructed in the process get appended to
+ * *BUFFER, which gets advanced accordingly.  It must provide enough room
+ * for them, see mark_needed().
+ */
+static const char *
+decode_short_string(bulk_sub_table_t *bulk,
+                    apr_size_t sub_index,
+                    char **buffer)
+{
+  apr_size_t depth = 0;
+
+  /* Find the strings that we need to reconstruct first. */
+  while (!bulk->decoded[sub_index])
+    {
+      const string_header_t *header
+        = &bulk->table.short_strings[sub_index];
+
+      bulk->stack[depth++] = sub_index;
+      if (header->head_length == 0)
+        break;
+
+      sub_index = header->head_string;
+    }
+
+  /* Reconstruct them, heads first. */
+  while (depth)
+    {
+      const string_header_t *header;
+      char *target = *buffer;
+
+      sub_index = bulk->stack[--depth];
+      header = &bulk->table.short_strings[sub_index];
+
+      if (header->head_length)
+        memcpy(target, bulk->decoded[header->head_string],
+               header->head_length);
+      memcpy(target + header->head_length,
+             bulk->table.data + header->tail_start,
+             header->tail_length);
+      target[header->head_length + header->tail_length] = '\0';
+
+      bulk->decoded[sub_index] = target;
+      *buffer += header->head_length + header->tail_length + 1;
+    }
+
+  return bulk->decoded[sub_index];
+}
+
+/* Implement svn_fs_x__string_table_get_many and
+ * svn_fs_x__string_table_get_many_func.  SERIALIZED indicates that TABLE
+ * is the cache serialized representation of the string table.
+ */
+static void
+table_get_many(const char **strings,
+               apr_size_t *lengths,
+               const string_table_t *table,
+               svn_boolean_t serialized,
+               const apr_size_t *indexes,
+               apr_size_t count,
+               apr_pool_t *result_pool)
+{
+  apr_pool_t *scratch_pool = svn_pool_create(result_pool);
+  bulk_sub_table_t **bulk = apr_pcalloc(scratch_pool,
+                                        table->size * sizeof(*bulk));
+  apr_size_t total = 0;
+  apr_size_t i;
+  char *buffer;
+  const char *empty;
+
+  /* Determine which strings need to be reconstructed and how much space
+   * that will take. */
+  for (i = 0; i < count; ++i)
+    {
+      apr_size_t idx = indexes[i];
+      apr_size_t table_number = idx >> TABLE_SHIFT;
+      apr_size_t sub_index = idx & STRING_INDEX_MASK;
+      bulk_sub_table_t *sub_table;
+
+      if (table_number >= table->size)
+        continue;
+
+      sub_table = get_bulk_sub_table(bulk, table, table_number, serialized,
+                                     scratch_pool);
+      if (idx & LONG_STRING_MASK)
+        {
+          if (sub_index < sub_table->table.long_string_count)
+            total += sub_table->table.long_strings[sub_index].len + 1;
+        }
+      else if (sub_index < sub_table->table.short_string_count)
+        {
+          total += mark_needed(sub_table, sub_index);
+        }
+    }
+
+  /* One buffer for all of them, with an extra byte for the empty string
+   * that we return for invalid indexes. */
+  buffer = apr_palloc(result_pool, total + 1);
+  empty = buffer + total;
+  buffer[total] = '\0';
+
+  for (i = 0; i < count; ++i)
+    {
+      apr_size_t idx = indexes[i];
+      apr_size_t table_number = idx >> TABLE_SHIFT;
+      apr_size_t sub_index = idx & STRING_INDEX_MASK;
+      bulk_sub_table_t *sub_table
+        = table_number < table->size ? bulk[table_number] : NULL;
+      const char *result = empty;
+      apr_size_t len = 0;
+
+      if (sub_table == NULL)
+        {
+          /* invalid index */
+        }
+      else if (idx & LONG_STRING_MASK)
+        {
+          if (sub_index < sub_table->table.long_string_count)
+            {
+              const svn_string_t *long_string
+                = &sub_table->table.long_strings[sub_index];
+              const char *data = sub_table->long_strings_serialized
+                ? svn_temp_deserializer__ptr(sub_table->table.long_strings,
+                                       (const void *const *)&long_string->data)
+                : long_string->data;
+
+              len = long_string->len;
+              memcpy(buffer, data, len);
+              buffer[len] = '\0';
+              result = buffer;
+              buffer += len + 1;
+            }
+        }
+      else if (sub_index < sub_table->table.short_string_count)
+        {
+          const string_header_t *header
+            = &sub_table->table.short_strings[sub_index];
+
+          len = header->head_length + header->tail_length;
+          result = decode_short_string(sub_table, sub_index, &buffer);
+        }
+
+      strings[i] = result;
+      if (lengths)
+        lengths[i] = len;
+    }
+
+  svn_pool_destroy(scratch_pool);
+}
+
+void
+svn_fs_x__string_table_get_many(const char **strings,
+                                apr_size_t *lengths,
+                                const string_table_t *table,
+                                const apr_size_t *indexes,
+                                apr_size_t count,
+                                apr_pool_t *result_pool)
+{
+  table_get_many(strings, lengths, table, FALSE, indexes, count,
+                 result_pool);
+}
+
 svn_error_t *
 svn_fs_x__write_string_table(svn_stream_t *stream,
                              const string_table_t *table,
+                             const svn_packed__compression_t *compression,
                              apr_pool_t *scratch_pool)
 {
   apr_size_t i, k;
@@ -648,7 +917,7 @@ svn_fs_x__write_string_table(svn_stream_t *stream,
 
   /* write to target stream */
 
-  SVN_ERR(svn_packed__data_write(stream, root, scratch_pool));
+  SVN_ERR(svn_packed__data_write2(stream, root, compression, scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -656,6 +925,7 @@ svn_fs_x__write_string_table(svn_stream_t *stream,
 svn_error_t *
 svn_fs_x__read_string_table(string_table_t **table_p,
                             svn_stream_t *stream,
+                            const svn_packed__compression_t *compression,
                             apr_pool_t *result_pool,
                             apr_pool_t *scratch_pool)
 {
@@ -669,7 +939,8 @@ svn_fs_x__read_string_table(string_table_t **table_p,
   svn_packed__byte_stream_t *small_strings_data;
   svn_packed__int_stream_t *headers;
 
-  SVN_ERR(svn_packed__data_read(&root, stream, result_pool, scratch_pool));
+  SVN_ERR(svn_packed__data_read2(&root, stream, compression, result_pool,
+                                 scratch_pool));
   table_sizes = svn_packed__first_int_stream(root);
   headers = svn_packed__next_int_stream(table_sizes);
   large_strings = svn_packed__first_byte_stream(root);
@@ -904,3 +1175,15 @@ svn_fs_x__string_table_get_func(const string_table_t *table,
 
   return "";
 }
+
+void
+svn_fs_x__string_table_get_many_func(const char **strings,
+                                     apr_size_t *lengths,
+                                     const string_table_t *table,
+                                     const apr_size_t *indexes,
+                                     apr_size_t count,
+                                     apr_pool_t *result_pool)
+{
+  table_get_many(strings, lengths, table, TRUE, indexes, count,
+                 result_pool);
+}
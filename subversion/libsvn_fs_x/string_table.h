@@ -25,6 +25,7 @@
 
 #include "svn_io.h"
 #include "private/svn_temp_serializer.h"
+#include "private/svn_packed_data.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -85,21 +86,39 @@ svn_fs_x__string_table_get(const string_table_t *table,
                            apr_size_t *length,
                            apr_pool_t *result_pool);
 
-/* Write a serialized representation of the string table TABLE to STREAM.
+/* Extract the COUNT strings with the numbers given in INDEXES from TABLE.
+ * Set STRINGS[I] to string number INDEXES[I] and, if LENGTHS is not NULL,
+ * LENGTHS[I] to its strlen().  All strings get reconstructed into a
+ * single buffer allocated in RESULT_POOL, with heads shared between them
+ * reconstructed only once.  Returns empty strings for invalid indexes.
+ */
+void
+svn_fs_x__string_table_get_many(const char **strings,
+                                apr_size_t *lengths,
+                                const string_table_t *table,
+                                const apr_size_t *indexes,
+                                apr_size_t count,
+                                apr_pool_t *result_pool);
+
+/* Write a serialized representation of the string table TABLE to STREAM
+ * using the COMPRESSION settings, which may be NULL.
  * Use SCRATCH_POOL for temporary allocations.
  */
 svn_error_t *
 svn_fs_x__write_string_table(svn_stream_t *stream,
                              const string_table_t *table,
+                             const svn_packed__compression_t *compression,
                              apr_pool_t *scratch_pool);
 
 /* Read the serialized string table representation from STREAM and return
- * the resulting runtime representation in *TABLE_P.  Allocate it in
+ * the resulting runtime representation in *TABLE_P.  COMPRESSION, if not
+ * NULL, provides the compression dictionary.  Allocate it in
  * RESULT_POOL and use SCRATCH_POOL for temporary allocations.
  */
 svn_error_t *
 svn_fs_x__read_string_table(string_table_t **table_p,
                             svn_stream_t *stream,
+                            const svn_packed__compression_t *compression,
                             apr_pool_t *result_pool,
                             apr_pool_t *scratch_pool);
 
@@ -126,6 +145,17 @@ svn_fs_x__string_table_get_func(const string_table_t *table,
                                 apr_size_t *length,
                                 apr_pool_t *result_pool);
 
+/* Like svn_fs_x__string_table_get_many but operating on the cache
+ * serialized representation at TABLE.
+ */
+void
+svn_fs_x__string_table_get_many_func(const char **strings,
+                                     apr_size_t *lengths,
+                                     const string_table_t *table,
+                                     const apr_size_t *indexes,
+                                     apr_size_t count,
+                                     apr_pool_t *result_pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
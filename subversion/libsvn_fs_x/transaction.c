@@ -45,6 +45,7 @@
 #include "batch_fsync.h"
 #include "revprops.h"
 
+#include "private/svn_delta_private.h"
 #include "private/svn_fs_util.h"
 #include "private/svn_fspath.h"
 #include "private/svn_sorts_private.h"
@@ -2006,8 +2007,8 @@ typedef struct rep_write_baton_t
      writing to it. */
   void *lockcookie;
 
-  svn_checksum_ctx_t *md5_checksum_ctx;
-  svn_checksum_ctx_t *sha1_checksum_ctx;
+  /* MD5 and SHA1 checksums of the fulltext. */
+  svn_checksum__md5_sha1_ctx_t *checksum_ctx;
 
   /* Receives the low-level checksum when closing REP_STREAM. */
   apr_uint32_t fnv1a_checksum;
@@ -2030,8 +2031,7 @@ rep_write_contents(void *baton,
 {
   rep_write_baton_t *b = baton;
 
-  SVN_ERR(svn_checksum_update(b->md5_checksum_ctx, data, *len));
-  SVN_ERR(svn_checksum_update(b->sha1_checksum_ctx, data, *len));
+  SVN_ERR(svn_checksum__md5_sha1_update(b->checksum_ctx, data, *len));
   b->rep_size += *len;
 
   return svn_stream_write(b->delta_stream, data, len);
@@ -2249,17 +2249,13 @@ rep_write_get_baton(rep_write_baton_t **wb_p,
   svn_stream_t *source;
   svn_txdelta_window_handler_t wh;
   void *whb;
-  int diff_version = 1;
   svn_fs_x__rep_header_t header = { 0 };
   svn_fs_x__txn_id_t txn_id
     = svn_fs_x__get_txn_id(noderev->noderev_id.change_set);
 
   b = apr_pcalloc(result_pool, sizeof(*b));
 
-  b->sha1_checksum_ctx = svn_checksum_ctx_create(svn_checksum_sha1,
-                                                 result_pool);
-  b->md5_checksum_ctx = svn_checksum_ctx_create(svn_checksum_md5,
-                                                result_pool);
+  b->checksum_ctx = svn_checksum__md5_sha1_ctx_create(result_pool);
 
   b->fs = fs;
   b->result_pool = result_pool;
@@ -2311,12 +2307,16 @@ rep_write_get_baton(rep_write_baton_t **wb_p,
   svn_txdelta_to_svndiff3(&wh,
                           &whb,
                           svn_stream_disown(b->rep_stream, b->result_pool),
-                          diff_version,
+                          ffd->delta_svndiff_version,
                           ffd->delta_compression_level,
                           result_pool);
 
-  b->delta_stream = svn_txdelta_target_push(wh, whb, source,
-                                            b->result_pool);
+  if (ffd->content_defined_windows)
+    b->delta_stream = svn_txdelta__target_push_cdc(wh, whb, source,
+                                                   b->result_pool);
+  else
+    b->delta_stream = svn_txdelta_target_push(wh, whb, source,
+                                              b->result_pool);
 
   *wb_p = b;
 
@@ -2494,6 +2494,24 @@ digests_final(svn_fs_x__representation_t *rep,
   return SVN_NO_ERROR;
 }
 
+/* Set the MD5 and SHA1 digests in REP to those calculated by CTX.
+ * Use SCRATCH_POOL for allocations.
+ */
+static svn_error_t *
+md5_sha1_digests_final(svn_fs_x__representation_t *rep,
+                       const svn_checksum__md5_sha1_ctx_t *ctx,
+                       apr_pool_t *scratch_pool)
+{
+  svn_checksum_t *md5, *sha1;
+
+  SVN_ERR(svn_checksum__md5_sha1_final(&md5, &sha1, ctx, scratch_pool));
+  memcpy(rep->md5_digest, md5->digest, svn_checksum_size(md5));
+  memcpy(rep->sha1_digest, sha1->digest, svn_checksum_size(sha1));
+  rep->has_sha1 = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
 /* Close handler for the representation write stream.  BATON is a
    rep_write_baton_t.  Writes out a new node-rev that correctly
    references the representation we just finished writing. */
@@ -2522,8 +2540,7 @@ rep_write_contents_close(void *baton)
   rep->id.change_set = svn_fs_x__change_set_by_txn(txn_id);
 
   /* Finalize the checksum. */
-  SVN_ERR(digests_final(rep, b->md5_checksum_ctx, b->sha1_checksum_ctx,
-                        b->result_pool));
+  SVN_ERR(md5_sha1_digests_final(rep, b->checksum_ctx, b->result_pool));
 
   /* Check and see if we already have a representation somewhere that's
      identical to the one we just wrote out. */
@@ -2796,7 +2813,6 @@ write_container_delta_rep(svn_fs_x__representation_t *rep,
   apr_off_t offset = 0;
 
   write_container_baton_t *whb;
-  int diff_version = 1;
   svn_boolean_t is_props = (item_type == SVN_FS_X__ITEM_TYPE_FILE_PROPS)
                         || (item_type == SVN_FS_X__ITEM_TYPE_DIR_PROPS);
 
@@ -2831,7 +2847,7 @@ write_container_delta_rep(svn_fs_x__representation_t *rep,
   svn_txdelta_to_svndiff3(&diff_wh,
                           &diff_whb,
                           svn_stream_disown(file_stream, scratch_pool),
-                          diff_version,
+                          ffd->delta_svndiff_version,
                           ffd->delta_compression_level,
                           scratch_pool);
 
@@ -3731,7 +3747,7 @@ commit_body(void *baton,
   /* Use this to force all data to be flushed to physical storage
      (to the degree our environment will allow). */
   SVN_ERR(svn_fs_x__batch_fsync_create(&batch, ffd->flush_to_disk,
-                                       scratch_pool));
+                                       ffd->fsync_method, scratch_pool));
 
   /* Set up the target directory. */
   SVN_ERR(auto_create_shard(cb->fs, new_rev, batch, subpool));
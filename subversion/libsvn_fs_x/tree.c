@@ -1251,7 +1251,7 @@ svn_fs_x__commit_txn(const char **conflict_p,
 
   if (ffd->pack_after_commit)
     {
-      SVN_ERR(svn_fs_x__pack(fs, NULL, NULL, NULL, NULL, pool));
+      SVN_ERR(svn_fs_x__pack(fs, 1, NULL, NULL, NULL, NULL, pool));
     }
 
   return SVN_NO_ERROR;
@@ -3220,13 +3220,16 @@ static root_vtable_t root_vtable = {
   x_change_node_prop,
   x_props_changed,
   x_dir_entries,
+  NULL,
   x_dir_optimal_order,
   x_make_dir,
   x_file_length,
   x_file_checksum,
   x_file_contents,
   x_try_process_file_contents,
+  NULL,
   x_make_file,
+  NULL,
   x_apply_textdelta,
   x_apply_text,
   x_contents_changed,
@@ -373,6 +373,13 @@ svn_fs_x__path_min_unpacked_rev(svn_fs_t *fs,
   return svn_dirent_join(fs->path, PATH_MIN_UNPACKED_REV, result_pool);
 }
 
+const char *
+svn_fs_x__path_container_dict(svn_fs_t *fs,
+                              apr_pool_t *result_pool)
+{
+  return svn_dirent_join(fs->path, PATH_CONTAINER_DICT, result_pool);
+}
+
 const char *
 svn_fs_x__path_txn_proto_revs(svn_fs_t *fs,
                               apr_pool_t *result_pool)
@@ -300,6 +300,13 @@ const char *
 svn_fs_x__path_min_unpacked_rev(svn_fs_t *fs,
                                 apr_pool_t *result_pool);
 
+/* Return the path of the zstd dictionary file used for packed containers
+ * in FS.  The result will be allocated in RESULT_POOL.
+ */
+const char *
+svn_fs_x__path_container_dict(svn_fs_t *fs,
+                              apr_pool_t *result_pool);
+
 /* Return the path of the file containing item_index counter for
  * the transaction identified by TXN_ID in FS.
  * The result will be allocated in RESULT_POOL.
@@ -0,0 +1,245 @@
+/*
+ * histcache.c :  on-disk cache of repository history
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include <apr_pools.h>
+#include <apr_time.h>
+
+#include "svn_checksum.h"
+#include "svn_dirent_uri.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+#include "svn_types.h"
+
+#include "private/svn_sorts_private.h"
+
+#include "histcache.h"
+
+struct svn_ra__histcache_t
+{
+  /* Directory holding one file per entry. */
+  const char *dirpath;
+
+  /* Maximum total size of the entries in bytes. */
+  apr_int64_t max_size;
+
+  /* Total size of the entries as far as we know, or -1 if we haven't
+   * looked at the directory yet.  Other processes may add entries as
+   * well, so this is only used to decide when to look again.
+   */
+  apr_int64_t size;
+};
+
+/* Shrink the cache to this part of its maximum size when it is full,
+ * so that we don't have to scan the directory on every store. */
+#define SHRINK_PERCENTAGE 75
+
+/* Remove temporary files left behind by crashed processes after this
+ * time. */
+#define STALE_TMP_AGE apr_time_from_sec(24 * 60 * 60)
+
+/* Return the path of the file for entry KEY of repository UUID in
+ * HISTCACHE, allocated in RESULT_POOL.
+ */
+static const char *
+entry_path(svn_ra__histcache_t *histcache,
+           const char *uuid,
+           const char *key,
+           apr_pool_t *result_pool)
+{
+  const char *id = apr_pstrcat(result_pool, uuid, "\n", key, SVN_VA_NULL);
+  svn_checksum_t *checksum;
+
+  svn_error_clear(svn_checksum(&checksum, svn_checksum_sha1, id, strlen(id),
+                               result_pool));
+
+  return svn_dirent_join(histcache->dirpath,
+                         svn_checksum_to_cstring_display(checksum,
+                                                         result_pool),
+                         result_pool);
+}
+
+/* Sort items by the modification time of their svn_io_dirent2_t values,
+ * oldest first. */
+static int
+compare_mtime(const svn_sort__item_t *a,
+              const svn_sort__item_t *b)
+{
+  const svn_io_dirent2_t *dirent_a = a->value;
+  const svn_io_dirent2_t *dirent_b = b->value;
+
+  if (dirent_a->mtime == dirent_b->mtime)
+    return 0;
+
+  return dirent_a->mtime < dirent_b->mtime ? -1 : 1;
+}
+
+/* Remove the least recently used entries of HISTCACHE until its total
+ * size is below SHRINK_PERCENTAGE of the maximum, and update
+ * HISTCACHE->SIZE.
+ */
+static svn_error_t *
+shrink_cache(svn_ra__histcache_t *histcache,
+             apr_pool_t *scratch_pool)
+{
+  apr_hash_t *dirents;
+  apr_array_header_t *sorted;
+  apr_int64_t limit = histcache->max_size / 100 * SHRINK_PERCENTAGE;
+  apr_int64_t size = 0;
+  apr_time_t now = apr_time_now();
+  apr_pool_t *iterpool;
+  int i;
+
+  SVN_ERR(svn_io_get_dirents3(&dirents, histcache->dirpath, FALSE,
+                              scratch_pool, scratch_pool));
+  sorted = svn_sort__hash(dirents, compare_mtime, scratch_pool);
+
+  for (i = 0; i < sorted->nelts; i++)
+    {
+      const svn_io_dirent2_t *dirent
+        = APR_ARRAY_IDX(sorted, i, svn_sort__item_t).value;
+
+      size += dirent->filesize;
+    }
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < sorted->nelts; i++)
+    {
+      const svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i,
+                                                    svn_sort__item_t);
+      const svn_io_dirent2_t *dirent = item->value;
+      svn_error_t *err;
+
+      if (dirent->kind != svn_node_file)
+        continue;
+
+      /* Entries that are still being written have a temporary name,
+         while the names of complete entries are plain checksums. */
+      if (strchr(item->key, '.'))
+        {
+          if (now - dirent->mtime < STALE_TMP_AGE)
+            continue;
+        }
+      else if (size <= limit)
+        continue;
+
+      svn_pool_clear(iterpool);
+
+      /* Another process may have removed the entry already. */
+      err = svn_io_remove_file2(svn_dirent_join(histcache->dirpath,
+                                                item->key, iterpool),
+                                TRUE, iterpool);
+      if (err)
+        svn_error_clear(err);
+      else
+        size -= dirent->filesize;
+    }
+  svn_pool_destroy(iterpool);
+
+  histcache->size = size;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra__histcache_create(svn_ra__histcache_t **histcache_p,
+                         const char *dirpath,
+                         apr_int64_t max_size,
+                         apr_pool_t *pool)
+{
+  svn_ra__histcache_t *histcache = apr_pcalloc(pool, sizeof(*histcache));
+
+  SVN_ERR(svn_io_make_dir_recursively(dirpath, pool));
+
+  histcache->dirpath = apr_pstrdup(pool, dirpath);
+  histcache->max_size = max_size;
+  histcache->size = -1;
+
+  *histcache_p = histcache;
+
+  return SVN_NO_ERROR;
+}
+
+svn_ra__histcache_t *
+svn_ra__histcache_dup(const svn_ra__histcache_t *histcache,
+                      apr_pool_t *pool)
+{
+  svn_ra__histcache_t *new_cache = apr_pmemdup(pool, histcache,
+                                               sizeof(*histcache));
+
+  new_cache->dirpath = apr_pstrdup(pool, histcache->dirpath);
+
+  return new_cache;
+}
+
+svn_error_t *
+svn_ra__histcache_get(svn_stringbuf_t **contents_p,
+                      svn_ra__histcache_t *histcache,
+                      const char *uuid,
+                      const char *key,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  const char *path = entry_path(histcache, uuid, key, scratch_pool);
+  svn_error_t *err;
+
+  err = svn_stringbuf_from_file2(contents_p, path, result_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      *contents_p = NULL;
+
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  /* Mark the entry as recently used. */
+  svn_error_clear(svn_io_set_file_affected_time(apr_time_now(), path,
+                                                scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra__histcache_set(svn_ra__histcache_t *histcache,
+                      const char *uuid,
+                      const char *key,
+                      const svn_stringbuf_t *contents,
+                      apr_pool_t *scratch_pool)
+{
+  /* The temporary file is created next to the entry and moved in place,
+     so readers in other processes never see partial entries. */
+  SVN_ERR(svn_io_write_atomic2(entry_path(histcache, uuid, key,
+                                          scratch_pool),
+                               contents->data, contents->len,
+                               NULL, FALSE, scratch_pool));
+
+  if (histcache->size >= 0)
+    histcache->size += contents->len;
+
+  if (histcache->size < 0 || histcache->size > histcache->max_size)
+    SVN_ERR(shrink_cache(histcache, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
@@ -0,0 +1,91 @@
+/*
+ * histcache.h :  on-disk cache of repository history
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_RA_HISTCACHE_H
+#define SVN_LIBSVN_RA_HISTCACHE_H
+
+#include <apr_pools.h>
+
+#include "svn_types.h"
+#include "svn_string.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* History cache.  The answers to some history queries, such as the
+ * location segments or the mergeinfo of a path in a given revision,
+ * never change once that revision exists.  They can be kept on disk and
+ * reused by all sessions (and processes) configured with the same cache
+ * directory, e.g. by repeated merges between long-lived branches.
+ *
+ * Entries are identified by the repository UUID and a KEY string that
+ * describes the query.  The cache is bounded in size; the least recently
+ * used entries are removed first.
+ */
+typedef struct svn_ra__histcache_t svn_ra__histcache_t;
+
+/* Set *HISTCACHE_P to a new history cache, allocated in POOL, storing up
+ * to MAX_SIZE bytes in files below DIRPATH, which is created if it
+ * doesn't exist yet.
+ */
+svn_error_t *
+svn_ra__histcache_create(svn_ra__histcache_t **histcache_p,
+                         const char *dirpath,
+                         apr_int64_t max_size,
+                         apr_pool_t *pool);
+
+/* Return a new instance, allocated in POOL, that uses the same directory
+ * and size limit as HISTCACHE.
+ */
+svn_ra__histcache_t *
+svn_ra__histcache_dup(const svn_ra__histcache_t *histcache,
+                      apr_pool_t *pool);
+
+/* Set *CONTENTS_P to the cached entry KEY of the repository UUID,
+ * allocated in RESULT_POOL, or to NULL if the cache doesn't have such
+ * an entry.
+ */
+svn_error_t *
+svn_ra__histcache_get(svn_stringbuf_t **contents_p,
+                      svn_ra__histcache_t *histcache,
+                      const char *uuid,
+                      const char *key,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool);
+
+/* Store CONTENTS as the entry KEY of the repository UUID, removing the
+ * least recently used entries if the cache grows too big.
+ */
+svn_error_t *
+svn_ra__histcache_set(svn_ra__histcache_t *histcache,
+                      const char *uuid,
+                      const char *key,
+                      const svn_stringbuf_t *contents,
+                      apr_pool_t *scratch_pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_RA_HISTCACHE_H */
@@ -0,0 +1,697 @@
+/*
+ * logcache.c :  answering log requests from the history cache
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include <apr_pools.h>
+#include <apr_hash.h>
+
+#include "svn_dirent_uri.h"
+#include "svn_error.h"
+#include "svn_hash.h"
+#include "svn_pools.h"
+#include "svn_props.h"
+#include "svn_ra.h"
+#include "svn_sorts.h"
+#include "svn_string.h"
+#include "svn_types.h"
+
+#include "private/svn_fspath.h"
+#include "private/svn_skel.h"
+#include "private/svn_sorts_private.h"
+
+#include "ra_loader.h"
+#include "logcache.h"
+
+#include "svn_private_config.h"
+
+/* Number of consecutive revisions kept in one history cache entry. */
+#define LOG_BLOCK_SIZE 1000
+
+typedef struct log_cache_t
+{
+  /* The session we answer for, with its URL and repository. */
+  svn_ra_session_t *session;
+  const char *session_url;
+  const char *root_url;
+  const char *uuid;
+
+  /* The first revision of the block that is currently loaded. */
+  svn_revnum_t first;
+
+  /* The root log entries of the revisions FIRST up to FIRST +
+     LOG_BLOCK_SIZE - 1, or NULL for the ones we don't know yet.
+     Revisions that the server didn't report at all have an entry
+     without REVPROPS, while the others always have them. */
+  svn_log_entry_t **entries;
+
+  /* Pool for ENTRIES. */
+  apr_pool_t *block_pool;
+} log_cache_t;
+
+/* Return the history cache key of the block starting at FIRST. */
+static const char *
+block_key(svn_revnum_t first,
+          apr_pool_t *result_pool)
+{
+  return apr_psprintf(result_pool, "log\n%ld", first / LOG_BLOCK_SIZE);
+}
+
+/* Return the word for TRISTATE that svn_tristate__from_word() reads
+   back. */
+static const char *
+tristate_word(svn_tristate_t tristate)
+{
+  const char *word = svn_tristate__to_word(tristate);
+
+  return word ? word : "unknown";
+}
+
+/* Set *CONTENTS to the serialized form of the cached entries of LC,
+ * which is a list of "(REV)" for the revisions the server didn't report
+ * and "(REV PROPLIST (CHANGE...))" for the others, where each CHANGE is
+ * "(PATH ACTION KIND TEXT-MOD PROPS-MOD [COPYFROM-PATH COPYFROM-REV])".
+ */
+static svn_error_t *
+serialize_block(svn_stringbuf_t **contents,
+                const log_cache_t *lc,
+                apr_pool_t *pool)
+{
+  svn_skel_t *block_skel = svn_skel__make_empty_list(pool);
+  int i;
+
+  for (i = LOG_BLOCK_SIZE - 1; i >= 0; i--)
+    {
+      const svn_log_entry_t *entry = lc->entries[i];
+      svn_skel_t *entry_skel;
+
+      if (!entry)
+        continue;
+
+      entry_skel = svn_skel__make_empty_list(pool);
+
+      if (entry->revprops)
+        {
+          svn_skel_t *changes_skel = svn_skel__make_empty_list(pool);
+          svn_skel_t *props_skel;
+
+          if (entry->changed_paths2)
+            {
+              apr_hash_index_t *hi;
+
+              for (hi = apr_hash_first(pool, entry->changed_paths2);
+                   hi;
+                   hi = apr_hash_next(hi))
+                {
+                  const svn_log_changed_path2_t *change
+                    = apr_hash_this_val(hi);
+                  svn_skel_t *change_skel = svn_skel__make_empty_list(pool);
+
+                  if (change->copyfrom_path)
+                    {
+                      svn_skel__prepend_int(change->copyfrom_rev,
+                                            change_skel, pool);
+                      svn_skel__prepend_str(change->copyfrom_path,
+                                            change_skel, pool);
+                    }
+                  svn_skel__prepend_str(tristate_word(change->props_modified),
+                                        change_skel, pool);
+                  svn_skel__prepend_str(tristate_word(change->text_modified),
+                                        change_skel, pool);
+                  svn_skel__prepend_str(svn_node_kind_to_word(
+                                          change->node_kind),
+                                        change_skel, pool);
+                  svn_skel__prepend(svn_skel__mem_atom(&change->action, 1,
+                                                       pool),
+                                    change_skel);
+                  svn_skel__prepend_str(apr_hash_this_key(hi), change_skel,
+                                        pool);
+
+                  svn_skel__prepend(change_skel, changes_skel);
+                }
+            }
+
+          SVN_ERR(svn_skel__unparse_proplist(&props_skel, entry->revprops,
+                                             pool));
+          svn_skel__prepend(changes_skel, entry_skel);
+          svn_skel__prepend(props_skel, entry_skel);
+        }
+
+      svn_skel__prepend_int(entry->revision, entry_skel, pool);
+      svn_skel__prepend(entry_skel, block_skel);
+    }
+
+  *contents = svn_skel__unparse(block_skel, pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return an error about a malformed log cache entry. */
+static svn_error_t *
+malformed_block(void)
+{
+  return svn_error_create(SVN_ERR_FS_MALFORMED_SKEL, NULL,
+                          _("Malformed log cache entry"));
+}
+
+/* Return the contents of the atom SKEL as a C string allocated in
+   RESULT_POOL. */
+static const char *
+atom_cstring(const svn_skel_t *skel,
+             apr_pool_t *result_pool)
+{
+  return apr_pstrmemdup(result_pool, skel->data, skel->len);
+}
+
+/* Parse the CHANGE_SKEL of a log cache entry into a new change in
+ * CHANGED_PATHS, allocated in RESULT_POOL.
+ */
+static svn_error_t *
+parse_change(apr_hash_t *changed_paths,
+             const svn_skel_t *change_skel,
+             apr_pool_t *result_pool)
+{
+  int len = svn_skel__list_length(change_skel);
+  svn_log_changed_path2_t *change;
+  const svn_skel_t *atom;
+  const char *path;
+
+  if (len != 5 && len != 7)
+    return malformed_block();
+  for (atom = change_skel->children; atom; atom = atom->next)
+    if (!atom->is_atom)
+      return malformed_block();
+
+  change = svn_log_changed_path2_create(result_pool);
+
+  atom = change_skel->children;
+  path = atom_cstring(atom, result_pool);
+
+  atom = atom->next;
+  if (atom->len != 1)
+    return malformed_block();
+  change->action = atom->data[0];
+
+  atom = atom->next;
+  change->node_kind = svn_node_kind_from_word(atom_cstring(atom,
+                                                           result_pool));
+  atom = atom->next;
+  change->text_modified = svn_tristate__from_word(atom_cstring(atom,
+                                                               result_pool));
+  atom = atom->next;
+  change->props_modified = svn_tristate__from_word(atom_cstring(atom,
+                                                                result_pool));
+
+  if (len == 7)
+    {
+      apr_int64_t copyfrom_rev;
+
+      atom = atom->next;
+      change->copyfrom_path = atom_cstring(atom, result_pool);
+
+      atom = atom->next;
+      SVN_ERR(svn_skel__parse_int(&copyfrom_rev, atom, result_pool));
+      change->copyfrom_rev = (svn_revnum_t)copyfrom_rev;
+    }
+
+  svn_hash_sets(changed_paths, path, change);
+
+  return SVN_NO_ERROR;
+}
+
+/* Parse BLOCK_SKEL, as written by serialize_block(), into the entries
+ * of LC, allocated in LC->BLOCK_POOL.
+ */
+static svn_error_t *
+parse_block(log_cache_t *lc,
+            const svn_skel_t *block_skel)
+{
+  const svn_skel_t *entry_skel;
+
+  if (svn_skel__list_length(block_skel) < 0)
+    return malformed_block();
+
+  for (entry_skel = block_skel->children;
+       entry_skel;
+       entry_skel = entry_skel->next)
+    {
+      int len = svn_skel__list_length(entry_skel);
+      svn_log_entry_t *entry;
+      apr_int64_t rev;
+
+      if (len != 1 && len != 3)
+        return malformed_block();
+      if (!entry_skel->children->is_atom)
+        return malformed_block();
+
+      SVN_ERR(svn_skel__parse_int(&rev, entry_skel->children,
+                                  lc->block_pool));
+      if (rev < lc->first || rev >= lc->first + LOG_BLOCK_SIZE)
+        return malformed_block();
+
+      entry = svn_log_entry_create(lc->block_pool);
+      entry->revision = (svn_revnum_t)rev;
+
+      if (len == 3)
+        {
+          const svn_skel_t *props_skel = entry_skel->children->next;
+          const svn_skel_t *changes_skel = props_skel->next;
+          const svn_skel_t *change_skel;
+
+          if (svn_skel__list_length(changes_skel) < 0)
+            return malformed_block();
+
+          SVN_ERR(svn_skel__parse_proplist(&entry->revprops, props_skel,
+                                           lc->block_pool));
+
+          entry->changed_paths2 = apr_hash_make(lc->block_pool);
+          for (change_skel = changes_skel->children;
+               change_skel;
+               change_skel = change_skel->next)
+            SVN_ERR(parse_change(entry->changed_paths2, change_skel,
+                                 lc->block_pool));
+          entry->changed_paths = entry->changed_paths2;
+        }
+
+      lc->entries[rev - lc->first] = entry;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Make the block containing REV the current block of LC, reading it
+ * from the history cache if necessary.
+ */
+static svn_error_t *
+load_block(log_cache_t *lc,
+           svn_revnum_t rev,
+           apr_pool_t *scratch_pool)
+{
+  svn_revnum_t first = rev - rev % LOG_BLOCK_SIZE;
+  svn_stringbuf_t *contents;
+  svn_error_t *err;
+
+  if (lc->entries && lc->first == first)
+    return SVN_NO_ERROR;
+
+  svn_pool_clear(lc->block_pool);
+  lc->first = first;
+  lc->entries = apr_pcalloc(lc->block_pool,
+                            LOG_BLOCK_SIZE * sizeof(*lc->entries));
+
+  SVN_ERR(svn_ra__histcache_get(&contents, lc->session->histcache,
+                                lc->uuid, block_key(first, scratch_pool),
+                                lc->block_pool, scratch_pool));
+  if (!contents)
+    return SVN_NO_ERROR;
+
+  /* A damaged entry is just refetched. */
+  {
+    svn_skel_t *block_skel = svn_skel__parse(contents->data, contents->len,
+                                             lc->block_pool);
+
+    err = block_skel ? parse_block(lc, block_skel) : malformed_block();
+  }
+  if (err)
+    {
+      svn_error_clear(err);
+      memset(lc->entries, 0, LOG_BLOCK_SIZE * sizeof(*lc->entries));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_log_entry_receiver_t, storing LOG_ENTRY in the current
+   block of the log_cache_t BATON. */
+static svn_error_t *
+store_entry(void *baton,
+            svn_log_entry_t *log_entry,
+            apr_pool_t *pool)
+{
+  log_cache_t *lc = baton;
+  svn_log_entry_t *entry;
+
+  if (log_entry->revision < lc->first
+      || log_entry->revision >= lc->first + LOG_BLOCK_SIZE)
+    return SVN_NO_ERROR;
+
+  entry = svn_log_entry_dup(log_entry, lc->block_pool);
+  if (!entry->revprops)
+    entry->revprops = apr_hash_make(lc->block_pool);
+
+  lc->entries[entry->revision - lc->first] = entry;
+
+  return SVN_NO_ERROR;
+}
+
+/* Fetch the root log entries of REV, which must be in the current block
+ * of LC, and of the older revisions in that block that LC doesn't know
+ * yet, down to OLDEST.  Store them in the history cache.
+ */
+static svn_error_t *
+fill_block(log_cache_t *lc,
+           svn_revnum_t rev,
+           svn_revnum_t oldest,
+           apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *paths = apr_array_make(scratch_pool, 1,
+                                             sizeof(const char *));
+  svn_revnum_t fill_start = rev;
+  svn_stringbuf_t *contents;
+  svn_error_t *err;
+
+  while (fill_start > oldest && fill_start > lc->first
+         && !lc->entries[fill_start - 1 - lc->first])
+    fill_start--;
+
+  APR_ARRAY_PUSH(paths, const char *) = "";
+
+  SVN_ERR(svn_ra_reparent(lc->session, lc->root_url, scratch_pool));
+  err = lc->session->vtable->get_log(lc->session, paths, rev, fill_start,
+                                     0 /* limit */,
+                                     TRUE /* discover_changed_paths */,
+                                     FALSE /* strict_node_history */,
+                                     FALSE /* include_merged_revisions */,
+                                     NULL /* all revprops */,
+                                     store_entry, lc, scratch_pool);
+  SVN_ERR(svn_error_compose_create(
+            err,
+            svn_ra_reparent(lc->session, lc->session_url, scratch_pool)));
+
+  /* Every change bubbles up to the root, so the server reports every
+     revision that changed anything. */
+  for (; fill_start <= rev; fill_start++)
+    if (!lc->entries[fill_start - lc->first])
+      {
+        svn_log_entry_t *entry = svn_log_entry_create(lc->block_pool);
+
+        entry->revision = fill_start;
+        lc->entries[fill_start - lc->first] = entry;
+      }
+
+  SVN_ERR(serialize_block(&contents, lc, scratch_pool));
+  svn_error_clear(svn_ra__histcache_set(lc->session->histcache, lc->uuid,
+                                        block_key(lc->first, scratch_pool),
+                                        contents, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *ENTRY to the root log entry of REV, fetching it and the unknown
+ * older revisions of its block down to OLDEST from the server if LC
+ * doesn't know it yet.  *ENTRY lives until another block is loaded.
+ */
+static svn_error_t *
+get_entry(const svn_log_entry_t **entry,
+          log_cache_t *lc,
+          svn_revnum_t rev,
+          svn_revnum_t oldest,
+          apr_pool_t *scratch_pool)
+{
+  SVN_ERR(load_block(lc, rev, scratch_pool));
+
+  if (!lc->entries[rev - lc->first])
+    SVN_ERR(fill_block(lc, rev, oldest, scratch_pool));
+
+  *entry = lc->entries[rev - lc->first];
+
+  return SVN_NO_ERROR;
+}
+
+/* Append the revisions from YOUNGEST down to OLDEST in which the node at
+ * FSPATH in YOUNGEST or one of its predecessors changed to REVS, youngest
+ * first, the way the server's log would find them.  Stop after LIMIT
+ * revisions if LIMIT is positive, and at the first copy if
+ * STRICT_NODE_HISTORY is set.
+ */
+static svn_error_t *
+find_revisions(apr_array_header_t *revs,
+               log_cache_t *lc,
+               const char *fspath,
+               svn_revnum_t youngest,
+               svn_revnum_t oldest,
+               int limit,
+               svn_boolean_t strict_node_history,
+               apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_revnum_t rev = youngest;
+
+  while (rev >= oldest && (limit <= 0 || revs->nelts < limit))
+    {
+      const svn_log_entry_t *entry;
+      const svn_log_changed_path2_t *created = NULL;
+      const char *created_relpath = NULL;
+      svn_boolean_t changed;
+
+      svn_pool_clear(iterpool);
+
+      if (lc->session->cancel_func)
+        SVN_ERR(lc->session->cancel_func(lc->session->cancel_baton));
+
+      SVN_ERR(get_entry(&entry, lc, rev, oldest, iterpool));
+
+      /* The root changes in every revision that the server reports. */
+      changed = (entry->revprops != NULL
+                 && svn_fspath__is_root(fspath, strlen(fspath)));
+
+      if (entry->changed_paths2)
+        {
+          apr_hash_index_t *hi;
+
+          for (hi = apr_hash_first(iterpool, entry->changed_paths2);
+               hi;
+               hi = apr_hash_next(hi))
+            {
+              const char *changed_path = apr_hash_this_key(hi);
+              const svn_log_changed_path2_t *change = apr_hash_this_val(hi);
+              const char *relpath;
+
+              if (svn_fspath__skip_ancestor(fspath, changed_path))
+                changed = TRUE;
+
+              /* The node was created here if it, or the closest of its
+                 parents, was added or replaced. */
+              relpath = svn_fspath__skip_ancestor(changed_path, fspath);
+              if (relpath
+                  && (change->action == 'A' || change->action == 'R')
+                  && (!created_relpath
+                      || strlen(relpath) < strlen(created_relpath)))
+                {
+                  created = change;
+                  created_relpath = relpath;
+                  changed = TRUE;
+                }
+            }
+        }
+
+      if (changed)
+        APR_ARRAY_PUSH(revs, svn_revnum_t) = rev;
+
+      if (created)
+        {
+          if (strict_node_history || !created->copyfrom_path
+              || !SVN_IS_VALID_REVNUM(created->copyfrom_rev)
+              || created->copyfrom_rev >= rev)
+            break;
+
+          fspath = svn_fspath__join(created->copyfrom_path, created_relpath,
+                                    scratch_pool);
+          rev = created->copyfrom_rev;
+        }
+      else
+        rev--;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *REVS to the revisions to report for the log request described by
+ * the arguments of svn_ra__logcache_get_log(), in the order of the
+ * answer, or to NULL if the request must be sent to the server.
+ */
+static svn_error_t *
+find_log_revisions(apr_array_header_t **revs,
+                   log_cache_t *lc,
+                   const char *path,
+                   svn_revnum_t start,
+                   svn_revnum_t end,
+                   int limit,
+                   svn_boolean_t strict_node_history,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  svn_ra_session_t *session = lc->session;
+  const char *session_relpath;
+  svn_revnum_t youngest;
+  svn_revnum_t oldest;
+  svn_node_kind_t kind;
+
+  *revs = NULL;
+
+  SVN_ERR(svn_ra_get_uuid2(session, &lc->uuid, result_pool));
+  SVN_ERR(svn_ra_get_session_url(session, &lc->session_url, result_pool));
+  SVN_ERR(svn_ra_get_repos_root2(session, &lc->root_url, result_pool));
+
+  session_relpath = svn_uri_skip_ancestor(lc->root_url, lc->session_url,
+                                          scratch_pool);
+  if (!session_relpath)
+    return SVN_NO_ERROR;
+
+  if (!SVN_IS_VALID_REVNUM(start) || !SVN_IS_VALID_REVNUM(end))
+    {
+      svn_revnum_t head;
+
+      SVN_ERR(svn_ra_get_latest_revnum(session, &head, scratch_pool));
+      if (!SVN_IS_VALID_REVNUM(start))
+        start = head;
+      if (!SVN_IS_VALID_REVNUM(end))
+        end = head;
+    }
+
+  youngest = MAX(start, end);
+  oldest = MIN(start, end);
+
+  /* Leave the errors for paths that don't exist to the server. */
+  SVN_ERR(svn_ra_check_path(session, path, youngest, &kind, scratch_pool));
+  if (kind == svn_node_none)
+    return SVN_NO_ERROR;
+
+  /* The server applies LIMIT in the order of the answer, so without a
+     descending order we need all the revisions. */
+  *revs = apr_array_make(result_pool, 16, sizeof(svn_revnum_t));
+  SVN_ERR(find_revisions(*revs, lc,
+                         svn_fspath__canonicalize(
+                           svn_relpath_join(session_relpath, path,
+                                            scratch_pool),
+                           scratch_pool),
+                         youngest, oldest, start >= end ? limit : 0,
+                         strict_node_history, scratch_pool));
+
+  if (start < end)
+    svn_sort__array_reverse(*revs, scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the revision properties in ALL_REVPROPS that are listed in
+   REVPROPS, or all of them if REVPROPS is NULL. */
+static apr_hash_t *
+filter_revprops(apr_hash_t *all_revprops,
+                const apr_array_header_t *revprops,
+                apr_pool_t *result_pool)
+{
+  apr_hash_t *result;
+  int i;
+
+  if (!revprops)
+    return all_revprops;
+
+  result = apr_hash_make(result_pool);
+  for (i = 0; i < revprops->nelts; i++)
+    {
+      const char *name = APR_ARRAY_IDX(revprops, i, const char *);
+      svn_string_t *value = svn_hash_gets(all_revprops, name);
+
+      if (value)
+        svn_hash_sets(result, name, value);
+    }
+
+  return result;
+}
+
+svn_error_t *
+svn_ra__logcache_get_log(svn_boolean_t *handled,
+                         svn_ra_session_t *session,
+                         const char *path,
+                         svn_revnum_t start,
+                         svn_revnum_t end,
+                         int limit,
+                         svn_boolean_t discover_changed_paths,
+                         svn_boolean_t strict_node_history,
+                         const apr_array_header_t *revprops,
+                         svn_log_entry_receiver_t receiver,
+                         void *receiver_baton,
+                         apr_pool_t *pool)
+{
+  log_cache_t lc = { 0 };
+  apr_array_header_t *revs;
+  apr_pool_t *iterpool;
+  svn_error_t *err;
+  int count;
+  int i;
+
+  *handled = FALSE;
+
+  lc.session = session;
+  lc.block_pool = svn_pool_create(pool);
+
+  /* Problems with the cache and with filling it are not fatal; the server
+     will then answer the request, or report the error. */
+  err = find_log_revisions(&revs, &lc, path, start, end, limit,
+                           strict_node_history, pool, pool);
+  if (err && err->apr_err == SVN_ERR_CANCELLED)
+    return svn_error_trace(err);
+  if (err || !revs)
+    {
+      svn_error_clear(err);
+      svn_pool_destroy(lc.block_pool);
+      return SVN_NO_ERROR;
+    }
+
+  *handled = TRUE;
+
+  count = revs->nelts;
+  if (limit > 0 && limit < count)
+    count = limit;
+
+  iterpool = svn_pool_create(pool);
+  for (i = 0; i < count; i++)
+    {
+      svn_revnum_t rev = APR_ARRAY_IDX(revs, i, svn_revnum_t);
+      const svn_log_entry_t *cached;
+      svn_log_entry_t *entry;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(get_entry(&cached, &lc, rev, rev, iterpool));
+
+      entry = svn_log_entry_create(iterpool);
+      entry->revision = rev;
+      entry->revprops = filter_revprops(cached->revprops, revprops,
+                                        iterpool);
+      if (discover_changed_paths)
+        {
+          entry->changed_paths2 = cached->changed_paths2;
+          entry->changed_paths = entry->changed_paths2;
+        }
+
+      SVN_ERR(receiver(receiver_baton, entry, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+  svn_pool_destroy(lc.block_pool);
+
+  return SVN_NO_ERROR;
+}
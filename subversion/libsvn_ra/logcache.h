@@ -0,0 +1,71 @@
+/*
+ * logcache.h :  answering log requests from the history cache
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_RA_LOGCACHE_H
+#define SVN_LIBSVN_RA_LOGCACHE_H
+
+#include <apr_pools.h>
+
+#include "svn_types.h"
+#include "svn_ra.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Log cache.  The revision properties and changed paths of every
+ * revision of a repository are kept in the history cache of the session,
+ * in blocks of consecutive revisions.  Blocks are filled from log
+ * requests for the repository root covering just the revisions that are
+ * missing, and the history of a single path is then followed locally
+ * through the changed paths of each revision.
+ */
+
+/* Try to answer the svn_ra_get_log2() request described by the arguments
+ * from the log cache of SESSION, which must have a history cache.  PATH
+ * is the single path of the request, relative to the session URL.
+ *
+ * Set *HANDLED to FALSE, without invoking RECEIVER, if the request must
+ * be sent to the server instead.  Problems with the cache cause that as
+ * well, so apart from cancellation, errors are only returned once
+ * *HANDLED is TRUE.
+ */
+svn_error_t *
+svn_ra__logcache_get_log(svn_boolean_t *handled,
+                         svn_ra_session_t *session,
+                         const char *path,
+                         svn_revnum_t start,
+                         svn_revnum_t end,
+                         int limit,
+                         svn_boolean_t discover_changed_paths,
+                         svn_boolean_t strict_node_history,
+                         const apr_array_header_t *revprops,
+                         svn_log_entry_receiver_t receiver,
+                         void *receiver_baton,
+                         apr_pool_t *pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_RA_LOGCACHE_H */
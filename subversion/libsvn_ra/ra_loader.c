@@ -34,6 +34,10 @@
 #include <apr_uri.h>
 
 #include "svn_hash.h"
+#include "svn_dirent_uri.h"
+#include "svn_io.h"
+#include "svn_mergeinfo.h"
+#include "svn_string.h"
 #include "svn_version.h"
 #include "svn_time.h"
 #include "svn_types.h"
@@ -50,6 +54,7 @@
 
 #include "svn_config.h"
 #include "ra_loader.h"
+#include "logcache.h"
 #include "deprecated.h"
 
 #include "private/svn_auth_private.h"
@@ -256,6 +261,51 @@ svn_ra_create_callbacks(svn_ra_callbacks2_t **callbacks,
   return SVN_NO_ERROR;
 }
 
+/* Set SESSION->HISTCACHE according to the history cache options in the
+   client CONFIG, which may be NULL. */
+static svn_error_t *
+open_histcache(svn_ra_session_t *session,
+               apr_hash_t *config,
+               apr_pool_t *scratch_pool)
+{
+  svn_config_t *cfg = config ? svn_hash_gets(config,
+                                             SVN_CONFIG_CATEGORY_CONFIG)
+                             : NULL;
+  const char *cache_dir;
+  apr_int64_t cache_size;
+  svn_error_t *err;
+
+  svn_config_get(cfg, &cache_dir, SVN_CONFIG_SECTION_MISCELLANY,
+                 SVN_CONFIG_OPTION_HISTORY_CACHE_DIRECTORY, NULL);
+  SVN_ERR(svn_config_get_int64(cfg, &cache_size,
+                               SVN_CONFIG_SECTION_MISCELLANY,
+                               SVN_CONFIG_OPTION_HISTORY_CACHE_SIZE,
+                               SVN_CONFIG_DEFAULT_OPTION_HISTORY_CACHE_SIZE));
+
+  if (!cache_dir || !*cache_dir || cache_size <= 0)
+    return SVN_NO_ERROR;
+
+  /* The cache is an optimization, so don't fail the session if it
+     can't be used. */
+  err = svn_ra__histcache_create(&session->histcache,
+                                 svn_dirent_internal_style(cache_dir,
+                                                           scratch_pool),
+                                 cache_size * 1024 * 1024,
+                                 session->pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      session->histcache = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_config_get_bool(cfg, &session->use_logcache,
+                              SVN_CONFIG_SECTION_MISCELLANY,
+                              SVN_CONFIG_OPTION_LOG_CACHE, FALSE));
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *svn_ra_open4(svn_ra_session_t **session_p,
                           const char **corrected_url_p,
                           const char *repos_URL,
@@ -431,6 +481,8 @@ svn_error_t *svn_ra_open4(svn_ra_session_t **session_p,
         }
     }
 
+  SVN_ERR(open_histcache(session, config, scratch_pool));
+
   svn_pool_destroy(scratch_pool);
   *session_p = session;
   return SVN_NO_ERROR;
@@ -465,6 +517,11 @@ svn_ra__dup_session(svn_ra_session_t **new_session,
   session->vtable = old_session->vtable;
   session->pool = result_pool;
 
+  if (old_session->histcache)
+    session->histcache = svn_ra__histcache_dup(old_session->histcache,
+                                               result_pool);
+  session->use_logcache = old_session->use_logcache;
+
   SVN_ERR(old_session->vtable->dup_session(session,
                                            old_session,
                                            session_url,
@@ -478,6 +535,26 @@ svn_ra__dup_session(svn_ra_session_t **new_session,
   return SVN_NO_ERROR;
 }
 
+/* Return ERR, the result of an operation on SESSION that streams a
+   response to the caller, after marking SESSION as failed if it is an
+   error.  The caller or a cancellation may have broken off the response
+   half way. */
+static svn_error_t *
+remember_failure(svn_ra_session_t *session,
+                 svn_error_t *err)
+{
+  if (err)
+    session->failed = TRUE;
+
+  return err;
+}
+
+svn_boolean_t
+svn_ra__session_failed(svn_ra_session_t *session)
+{
+  return session->failed;
+}
+
 svn_error_t *svn_ra_reparent(svn_ra_session_t *session,
                              const char *url,
                              apr_pool_t *pool)
@@ -626,9 +703,13 @@ svn_error_t *svn_ra_get_file(svn_ra_session_t *session,
                              apr_hash_t **props,
                              apr_pool_t *pool)
 {
+  svn_error_t *err;
+
   SVN_ERR_ASSERT(svn_relpath_is_canonical(path));
-  return session->vtable->get_file(session, path, revision, stream,
-                                   fetched_rev, props, pool);
+  err = session->vtable->get_file(session, path, revision, stream,
+                                  fetched_rev, props, pool);
+
+  return svn_error_trace(remember_failure(session, err));
 }
 
 svn_error_t *svn_ra_get_dir2(svn_ra_session_t *session,
@@ -656,6 +737,8 @@ svn_ra_list(svn_ra_session_t *session,
             void *receiver_baton,
             apr_pool_t *scratch_pool)
 {
+  svn_error_t *err;
+
   SVN_ERR_ASSERT(svn_relpath_is_canonical(path));
   if (!session->vtable->list)
     return svn_error_create(SVN_ERR_RA_NOT_IMPLEMENTED, NULL, NULL);
@@ -663,9 +746,194 @@ svn_ra_list(svn_ra_session_t *session,
   SVN_ERR(svn_ra__assert_capable_server(session, SVN_RA_CAPABILITY_LIST,
                                         NULL, scratch_pool));
 
-  return session->vtable->list(session, path, revision, patterns, depth,
-                               dirent_fields, receiver, receiver_baton,
-                               scratch_pool);
+  err = session->vtable->list(session, path, revision, patterns, depth,
+                              dirent_fields, receiver, receiver_baton,
+                              scratch_pool);
+
+  return svn_error_trace(remember_failure(session, err));
+}
+
+svn_error_t *
+svn_ra_blame(svn_ra_session_t *session,
+             const char *path,
+             svn_revnum_t start,
+             svn_revnum_t end,
+             const svn_diff_file_options_t *diff_options,
+             svn_ra_blame_receiver_t receiver,
+             void *receiver_baton,
+             apr_pool_t *scratch_pool)
+{
+  svn_error_t *err;
+
+  SVN_ERR_ASSERT(svn_relpath_is_canonical(path));
+  SVN_ERR_ASSERT(SVN_IS_VALID_REVNUM(start) && SVN_IS_VALID_REVNUM(end));
+  SVN_ERR_ASSERT(start <= end);
+  if (!session->vtable->blame)
+    return svn_error_create(SVN_ERR_RA_NOT_IMPLEMENTED, NULL, NULL);
+
+  SVN_ERR(svn_ra__assert_capable_server(session, SVN_RA_CAPABILITY_BLAME,
+                                        NULL, scratch_pool));
+
+  err = session->vtable->blame(session, path, start, end, diff_options,
+                               receiver, receiver_baton, scratch_pool);
+
+  return svn_error_trace(remember_failure(session, err));
+}
+
+/* Set *UUID and *KEY to identify the history query KIND with PARAMS,
+   relative to the session URL of SESSION, in the history cache.  Set
+   *KEY to NULL if the query can't be cached. */
+static svn_error_t *
+get_histcache_key(const char **uuid,
+                  const char **key,
+                  svn_ra_session_t *session,
+                  const char *kind,
+                  const char *params,
+                  apr_pool_t *pool)
+{
+  const char *session_url;
+  const char *root_url;
+  const char *session_relpath;
+
+  SVN_ERR(svn_ra_get_uuid2(session, uuid, pool));
+  SVN_ERR(svn_ra_get_session_url(session, &session_url, pool));
+  SVN_ERR(svn_ra_get_repos_root2(session, &root_url, pool));
+
+  session_relpath = svn_uri_skip_ancestor(root_url, session_url, pool);
+  if (session_relpath)
+    *key = apr_pstrcat(pool, kind, "\n", session_relpath, "\n", params,
+                       SVN_VA_NULL);
+  else
+    *key = NULL;
+
+  return SVN_NO_ERROR;
+}
+
+svn_boolean_t
+svn_ra__has_history_cache(svn_ra_session_t *session)
+{
+  return session->histcache != NULL;
+}
+
+svn_error_t *
+svn_ra__get_cached_history(svn_stringbuf_t **contents_p,
+                           svn_ra_session_t *session,
+                           const char *kind,
+                           const char *params,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool)
+{
+  const char *uuid;
+  const char *key;
+  svn_error_t *err;
+
+  *contents_p = NULL;
+  if (!session->histcache)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(get_histcache_key(&uuid, &key, session, kind, params,
+                            scratch_pool));
+  if (!key)
+    return SVN_NO_ERROR;
+
+  /* Problems with the cache are not fatal; it's just a miss. */
+  err = svn_ra__histcache_get(contents_p, session->histcache, uuid, key,
+                              result_pool, scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      *contents_p = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra__set_cached_history(svn_ra_session_t *session,
+                           const char *kind,
+                           const char *params,
+                           const svn_stringbuf_t *contents,
+                           apr_pool_t *scratch_pool)
+{
+  const char *uuid;
+  const char *key;
+
+  if (!session->histcache)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(get_histcache_key(&uuid, &key, session, kind, params,
+                            scratch_pool));
+  if (key)
+    svn_error_clear(svn_ra__histcache_set(session->histcache, uuid, key,
+                                          contents, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *CONTENTS to a history cache entry holding CATALOG. */
+static svn_error_t *
+serialize_catalog(svn_stringbuf_t **contents,
+                  svn_mergeinfo_catalog_t catalog,
+                  apr_pool_t *pool)
+{
+  apr_hash_t *hash = apr_hash_make(pool);
+  apr_hash_index_t *hi;
+
+  /* Keep "no mergeinfo" apart from an empty catalog. */
+  *contents = svn_stringbuf_create(catalog ? "C\n" : "N\n", pool);
+  if (!catalog)
+    return SVN_NO_ERROR;
+
+  for (hi = apr_hash_first(pool, catalog); hi; hi = apr_hash_next(hi))
+    {
+      svn_string_t *mergeinfo_string;
+
+      SVN_ERR(svn_mergeinfo_to_string(&mergeinfo_string,
+                                      apr_hash_this_val(hi), pool));
+      svn_hash_sets(hash, apr_hash_this_key(hi), mergeinfo_string);
+    }
+
+  return svn_error_trace(svn_hash_write2(hash,
+                                         svn_stream_from_stringbuf(*contents,
+                                                                   pool),
+                                         SVN_HASH_TERMINATOR, pool));
+}
+
+/* Parse the history cache entry CONTENTS written by serialize_catalog()
+   into *CATALOG, allocated in POOL. */
+static svn_error_t *
+parse_catalog(svn_mergeinfo_catalog_t *catalog,
+              svn_stringbuf_t *contents,
+              apr_pool_t *pool)
+{
+  svn_stream_t *stream;
+  apr_hash_t *hash = apr_hash_make(pool);
+  apr_hash_index_t *hi;
+
+  if (strcmp(contents->data, "N\n") == 0)
+    {
+      *catalog = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  if (strncmp(contents->data, "C\n", 2) != 0)
+    return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL, NULL);
+
+  stream = svn_stream_from_stringbuf(contents, pool);
+  SVN_ERR(svn_stream_skip(stream, 2));
+  SVN_ERR(svn_hash_read2(hash, stream, SVN_HASH_TERMINATOR, pool));
+
+  *catalog = apr_hash_make(pool);
+  for (hi = apr_hash_first(pool, hash); hi; hi = apr_hash_next(hi))
+    {
+      const svn_string_t *mergeinfo_string = apr_hash_this_val(hi);
+      svn_mergeinfo_t mergeinfo;
+
+      SVN_ERR(svn_mergeinfo_parse(&mergeinfo, mergeinfo_string->data, pool));
+      svn_hash_sets(*catalog, apr_hash_this_key(hi), mergeinfo);
+    }
+
+  return SVN_NO_ERROR;
 }
 
 svn_error_t *svn_ra_get_mergeinfo(svn_ra_session_t *session,
@@ -677,6 +945,8 @@ svn_error_t *svn_ra_get_mergeinfo(svn_ra_session_t *session,
                                   apr_pool_t *pool)
 {
   svn_error_t *err;
+  const char *uuid = NULL;
+  const char *key = NULL;
   int i;
 
   /* Validate path format. */
@@ -694,9 +964,166 @@ svn_error_t *svn_ra_get_mergeinfo(svn_ra_session_t *session,
       return err;
     }
 
-  return session->vtable->get_mergeinfo(session, catalog, paths,
-                                        revision, inherit,
-                                        include_descendants, pool);
+  /* Mergeinfo is versioned, so its value in an existing revision never
+     changes. */
+  if (session->histcache && SVN_IS_VALID_REVNUM(revision))
+    {
+      svn_stringbuf_t *params = svn_stringbuf_createf(pool, "%ld %d %d",
+                                                      revision, inherit,
+                                                      include_descendants);
+
+      for (i = 0; i < paths->nelts; i++)
+        {
+          svn_stringbuf_appendbyte(params, '\n');
+          svn_stringbuf_appendcstr(params,
+                                   APR_ARRAY_IDX(paths, i, const char *));
+        }
+
+      SVN_ERR(get_histcache_key(&uuid, &key, session, "mergeinfo",
+                                params->data, pool));
+    }
+
+  if (key)
+    {
+      svn_stringbuf_t *contents;
+
+      /* Problems with the cache are not fatal; just ask the server. */
+      err = svn_ra__histcache_get(&contents, session->histcache, uuid, key,
+                                  pool, pool);
+      if (!err && contents)
+        err = parse_catalog(catalog, contents, pool);
+      if (!err && contents)
+        return SVN_NO_ERROR;
+      svn_error_clear(err);
+    }
+
+  SVN_ERR(session->vtable->get_mergeinfo(session, catalog, paths,
+                                         revision, inherit,
+                                         include_descendants, pool));
+
+  if (key)
+    {
+      svn_stringbuf_t *contents;
+
+      err = serialize_catalog(&contents, *catalog, pool);
+      if (!err)
+        err = svn_ra__histcache_set(session->histcache, uuid, key, contents,
+                                    pool);
+      svn_error_clear(err);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* A reporter that passes everything on to another one and remembers in
+   the session whether that failed. */
+typedef struct failure_report_baton_t
+{
+  const svn_ra_reporter3_t *reporter;
+  void *report_baton;
+  svn_ra_session_t *session;
+} failure_report_baton_t;
+
+static svn_error_t *
+failure_set_path(void *report_baton,
+                 const char *path,
+                 svn_revnum_t revision,
+                 svn_depth_t depth,
+                 svn_boolean_t start_empty,
+                 const char *lock_token,
+                 apr_pool_t *pool)
+{
+  failure_report_baton_t *b = report_baton;
+  svn_error_t *err = b->reporter->set_path(b->report_baton, path, revision,
+                                           depth, start_empty, lock_token,
+                                           pool);
+
+  return svn_error_trace(remember_failure(b->session, err));
+}
+
+static svn_error_t *
+failure_delete_path(void *report_baton,
+                    const char *path,
+                    apr_pool_t *pool)
+{
+  failure_report_baton_t *b = report_baton;
+  svn_error_t *err = b->reporter->delete_path(b->report_baton, path, pool);
+
+  return svn_error_trace(remember_failure(b->session, err));
+}
+
+static svn_error_t *
+failure_link_path(void *report_baton,
+                  const char *path,
+                  const char *url,
+                  svn_revnum_t revision,
+                  svn_depth_t depth,
+                  svn_boolean_t start_empty,
+                  const char *lock_token,
+                  apr_pool_t *pool)
+{
+  failure_report_baton_t *b = report_baton;
+  svn_error_t *err = b->reporter->link_path(b->report_baton, path, url,
+                                            revision, depth, start_empty,
+                                            lock_token, pool);
+
+  return svn_error_trace(remember_failure(b->session, err));
+}
+
+static svn_error_t *
+failure_finish_report(void *report_baton,
+                      apr_pool_t *pool)
+{
+  failure_report_baton_t *b = report_baton;
+  svn_error_t *err = b->reporter->finish_report(b->report_baton, pool);
+
+  return svn_error_trace(remember_failure(b->session, err));
+}
+
+/* An aborted report never leaves the session clean. */
+static svn_error_t *
+failure_abort_report(void *report_baton,
+                     apr_pool_t *pool)
+{
+  failure_report_baton_t *b = report_baton;
+
+  b->session->failed = TRUE;
+  return svn_error_trace(b->reporter->abort_report(b->report_baton, pool));
+}
+
+static const svn_ra_reporter3_t failure_reporter =
+{
+  failure_set_path,
+  failure_delete_path,
+  failure_link_path,
+  failure_finish_report,
+  failure_abort_report
+};
+
+/* Wrap *REPORTER and *REPORT_BATON, the result ERR of asking SESSION for
+   a reporter, such that failures while driving the report and the
+   editor it drives mark SESSION as failed.  Allocate in POOL. */
+static svn_error_t *
+wrap_reporter(const svn_ra_reporter3_t **reporter,
+              void **report_baton,
+              svn_ra_session_t *session,
+              svn_error_t *err,
+              apr_pool_t *pool)
+{
+  failure_report_baton_t *b;
+
+  if (err)
+    return svn_error_trace(remember_failure(session, err));
+
+  b = apr_palloc(pool, sizeof(*b));
+  b->reporter = *reporter;
+  b->report_baton = *report_baton;
+  b->session = session;
+
+  *reporter = &failure_reporter;
+  *report_baton = b;
+
+  return SVN_NO_ERROR;
 }
 
 svn_error_t *
@@ -713,15 +1140,20 @@ svn_ra_do_update3(svn_ra_session_t *session,
                   apr_pool_t *result_pool,
                   apr_pool_t *scratch_pool)
 {
+  svn_error_t *err;
+
   SVN_ERR_ASSERT(svn_path_is_empty(update_target)
                  || svn_path_is_single_path_component(update_target));
-  return session->vtable->do_update(session,
-                                    reporter, report_baton,
-                                    revision_to_update_to, update_target,
-                                    depth, send_copyfrom_args,
-                                    ignore_ancestry,
-                                    update_editor, update_baton,
-                                    result_pool, scratch_pool);
+  err = session->vtable->do_update(session,
+                                   reporter, report_baton,
+                                   revision_to_update_to, update_target,
+                                   depth, send_copyfrom_args,
+                                   ignore_ancestry,
+                                   update_editor, update_baton,
+                                   result_pool, scratch_pool);
+
+  return svn_error_trace(wrap_reporter(reporter, report_baton, session,
+                                       err, result_pool));
 }
 
 svn_error_t *
@@ -739,17 +1171,22 @@ svn_ra_do_switch3(svn_ra_session_t *session,
                   apr_pool_t *result_pool,
                   apr_pool_t *scratch_pool)
 {
+  svn_error_t *err;
+
   SVN_ERR_ASSERT(svn_path_is_empty(switch_target)
                  || svn_path_is_single_path_component(switch_target));
-  return session->vtable->do_switch(session,
-                                    reporter, report_baton,
-                                    revision_to_switch_to, switch_target,
-                                    depth, switch_url,
-                                    send_copyfrom_args,
-                                    ignore_ancestry,
-                                    switch_editor,
-                                    switch_baton,
-                                    result_pool, scratch_pool);
+  err = session->vtable->do_switch(session,
+                                   reporter, report_baton,
+                                   revision_to_switch_to, switch_target,
+                                   depth, switch_url,
+                                   send_copyfrom_args,
+                                   ignore_ancestry,
+                                   switch_editor,
+                                   switch_baton,
+                                   result_pool, scratch_pool);
+
+  return svn_error_trace(wrap_reporter(reporter, report_baton, session,
+                                       err, result_pool));
 }
 
 svn_error_t *svn_ra_do_status2(svn_ra_session_t *session,
@@ -762,12 +1199,17 @@ svn_error_t *svn_ra_do_status2(svn_ra_session_t *session,
                                void *status_baton,
                                apr_pool_t *pool)
 {
+  svn_error_t *err;
+
   SVN_ERR_ASSERT(svn_path_is_empty(status_target)
                  || svn_path_is_single_path_component(status_target));
-  return session->vtable->do_status(session,
-                                    reporter, report_baton,
-                                    status_target, revision, depth,
-                                    status_editor, status_baton, pool);
+  err = session->vtable->do_status(session,
+                                   reporter, report_baton,
+                                   status_target, revision, depth,
+                                   status_editor, status_baton, pool);
+
+  return svn_error_trace(wrap_reporter(reporter, report_baton, session,
+                                       err, pool));
 }
 
 svn_error_t *svn_ra_do_diff3(svn_ra_session_t *session,
@@ -783,14 +1225,19 @@ svn_error_t *svn_ra_do_diff3(svn_ra_session_t *session,
                              void *diff_baton,
                              apr_pool_t *pool)
 {
+  svn_error_t *err;
+
   SVN_ERR_ASSERT(svn_path_is_empty(diff_target)
                  || svn_path_is_single_path_component(diff_target));
-  return session->vtable->do_diff(session,
-                                  reporter, report_baton,
-                                  revision, diff_target,
-                                  depth, ignore_ancestry,
-                                  text_deltas, versus_url, diff_editor,
-                                  diff_baton, pool);
+  err = session->vtable->do_diff(session,
+                                 reporter, report_baton,
+                                 revision, diff_target,
+                                 depth, ignore_ancestry,
+                                 text_deltas, versus_url, diff_editor,
+                                 diff_baton, pool);
+
+  return svn_error_trace(wrap_reporter(reporter, report_baton, session,
+                                       err, pool));
 }
 
 svn_error_t *svn_ra_get_log2(svn_ra_session_t *session,
@@ -806,6 +1253,8 @@ svn_error_t *svn_ra_get_log2(svn_ra_session_t *session,
                              void *receiver_baton,
                              apr_pool_t *pool)
 {
+  svn_error_t *err;
+
   if (paths)
     {
       int i;
@@ -819,10 +1268,32 @@ svn_error_t *svn_ra_get_log2(svn_ra_session_t *session,
   if (include_merged_revisions)
     SVN_ERR(svn_ra__assert_mergeinfo_capable_server(session, NULL, pool));
 
-  return session->vtable->get_log(session, paths, start, end, limit,
-                                  discover_changed_paths, strict_node_history,
-                                  include_merged_revisions, revprops,
-                                  receiver, receiver_baton, pool);
+  /* The log cache follows the history of a single path through the
+     changed paths of each revision, which doesn't tell about merges. */
+  if (session->use_logcache && !include_merged_revisions
+      && (!paths || paths->nelts <= 1))
+    {
+      svn_boolean_t handled;
+
+      SVN_ERR(svn_ra__logcache_get_log(&handled, session,
+                                       (paths && paths->nelts)
+                                         ? APR_ARRAY_IDX(paths, 0,
+                                                         const char *)
+                                         : "",
+                                       start, end, limit,
+                                       discover_changed_paths,
+                                       strict_node_history, revprops,
+                                       receiver, receiver_baton, pool));
+      if (handled)
+        return SVN_NO_ERROR;
+    }
+
+  err = session->vtable->get_log(session, paths, start, end, limit,
+                                 discover_changed_paths, strict_node_history,
+                                 include_merged_revisions, revprops,
+                                 receiver, receiver_baton, pool);
+
+  return svn_error_trace(remember_failure(session, err));
 }
 
 svn_error_t *svn_ra_check_path(svn_ra_session_t *session,
@@ -941,6 +1412,44 @@ svn_error_t *svn_ra_stat(svn_ra_session_t *session,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_ra_stat_many(svn_ra_session_t *session,
+                 const apr_array_header_t *paths,
+                 svn_revnum_t revision,
+                 apr_hash_t **dirents,
+                 apr_pool_t *pool)
+{
+  int i;
+
+  for (i = 0; i < paths->nelts; i++)
+    SVN_ERR_ASSERT(svn_relpath_is_canonical(APR_ARRAY_IDX(paths, i,
+                                                          const char *)));
+
+  if (session->vtable->stat_many)
+    {
+      svn_error_t *err = session->vtable->stat_many(session, paths, revision,
+                                                    dirents, pool);
+
+      if (!err || err->apr_err != SVN_ERR_RA_NOT_IMPLEMENTED)
+        return svn_error_trace(err);
+
+      svn_error_clear(err);
+    }
+
+  *dirents = apr_hash_make(pool);
+  for (i = 0; i < paths->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      svn_dirent_t *dirent;
+
+      SVN_ERR(svn_ra_stat(session, path, revision, &dirent, pool));
+      if (dirent)
+        svn_hash_sets(*dirents, apr_pstrdup(pool, path), dirent);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *svn_ra_get_uuid2(svn_ra_session_t *session,
                               const char **uuid,
                               apr_pool_t *pool)
@@ -998,6 +1507,75 @@ svn_error_t *svn_ra_get_locations(svn_ra_session_t *session,
   return err;
 }
 
+/* Baton for record_segment(). */
+typedef struct record_segments_baton_t
+{
+  svn_location_segment_receiver_t receiver;
+  void *receiver_baton;
+
+  /* The history cache entry being built. */
+  svn_stringbuf_t *contents;
+} record_segments_baton_t;
+
+/* Implements svn_location_segment_receiver_t.  Add SEGMENT to the
+   history cache entry being built, then pass it on. */
+static svn_error_t *
+record_segment(svn_location_segment_t *segment,
+               void *baton,
+               apr_pool_t *pool)
+{
+  record_segments_baton_t *b = baton;
+
+  svn_stringbuf_appendcstr(b->contents,
+                           apr_psprintf(pool, "%ld %ld %s%s\n",
+                                        segment->range_start,
+                                        segment->range_end,
+                                        segment->path ? "/" : "-",
+                                        segment->path ? segment->path : ""));
+
+  return svn_error_trace(b->receiver(segment, b->receiver_baton, pool));
+}
+
+/* Return the segments in the history cache entry CONTENTS written by
+   record_segment(), allocated in POOL, or NULL if CONTENTS is malformed. */
+static apr_array_header_t *
+parse_segments(svn_stringbuf_t *contents,
+               apr_pool_t *pool)
+{
+  apr_array_header_t *lines = svn_cstring_split(contents->data, "\n", FALSE,
+                                                pool);
+  apr_array_header_t *segments
+    = apr_array_make(pool, lines->nelts, sizeof(svn_location_segment_t *));
+  int i;
+
+  for (i = 0; i < lines->nelts; i++)
+    {
+      const char *line = APR_ARRAY_IDX(lines, i, const char *);
+      svn_location_segment_t *segment = apr_pcalloc(pool, sizeof(*segment));
+      const char *next;
+      svn_error_t *err;
+
+      err = svn_revnum_parse(&segment->range_start, line, &next);
+      if (!err && *next == ' ')
+        err = svn_revnum_parse(&segment->range_end, next + 1, &next);
+      if (err || *next != ' ')
+        {
+          svn_error_clear(err);
+          return NULL;
+        }
+
+      next++;
+      if (*next == '/')
+        segment->path = next + 1;
+      else if (strcmp(next, "-") != 0)
+        return NULL;
+
+      APR_ARRAY_PUSH(segments, svn_location_segment_t *) = segment;
+    }
+
+  return segments;
+}
+
 svn_error_t *
 svn_ra_get_location_segments(svn_ra_session_t *session,
                              const char *path,
@@ -1009,8 +1587,57 @@ svn_ra_get_location_segments(svn_ra_session_t *session,
                              apr_pool_t *pool)
 {
   svn_error_t *err;
+  const char *uuid = NULL;
+  const char *key = NULL;
+  record_segments_baton_t rsb;
 
   SVN_ERR_ASSERT(svn_relpath_is_canonical(path));
+
+  /* The history of a node up to an existing revision never changes. */
+  if (session->histcache && SVN_IS_VALID_REVNUM(peg_revision))
+    SVN_ERR(get_histcache_key(&uuid, &key, session, "location-segments",
+                              apr_psprintf(pool, "%ld %ld %ld\n%s",
+                                           peg_revision, start_rev, end_rev,
+                                           path),
+                              pool));
+
+  if (key)
+    {
+      svn_stringbuf_t *contents;
+      apr_array_header_t *segments = NULL;
+
+      /* Problems with the cache are not fatal; just ask the server. */
+      err = svn_ra__histcache_get(&contents, session->histcache, uuid, key,
+                                  pool, pool);
+      if (err)
+        svn_error_clear(err);
+      else if (contents)
+        segments = parse_segments(contents, pool);
+
+      if (segments)
+        {
+          apr_pool_t *iterpool = svn_pool_create(pool);
+          int i;
+
+          for (i = 0; i < segments->nelts; i++)
+            {
+              svn_pool_clear(iterpool);
+              SVN_ERR(receiver(APR_ARRAY_IDX(segments, i,
+                                             svn_location_segment_t *),
+                               receiver_baton, iterpool));
+            }
+          svn_pool_destroy(iterpool);
+
+          return SVN_NO_ERROR;
+        }
+
+      rsb.receiver = receiver;
+      rsb.receiver_baton = receiver_baton;
+      rsb.contents = svn_stringbuf_create_empty(pool);
+      receiver = record_segment;
+      receiver_baton = &rsb;
+    }
+
   err = session->vtable->get_location_segments(session, path, peg_revision,
                                                start_rev, end_rev,
                                                receiver, receiver_baton, pool);
@@ -1024,7 +1651,13 @@ svn_ra_get_location_segments(svn_ra_session_t *session,
                                                end_rev, receiver,
                                                receiver_baton, pool);
     }
-  return err;
+
+  /* Only complete answers may be cached. */
+  if (!err && key)
+    svn_error_clear(svn_ra__histcache_set(session->histcache, uuid, key,
+                                          rsb.contents, pool));
+
+  return remember_failure(session, err);
 }
 
 svn_error_t *svn_ra_get_file_revs2(svn_ra_session_t *session,
@@ -1062,7 +1695,7 @@ svn_error_t *svn_ra_get_file_revs2(svn_ra_session_t *session,
       err = svn_ra__file_revs_from_log(session, path, start, end,
                                        handler, handler_baton, pool);
     }
-  return svn_error_trace(err);
+  return svn_error_trace(remember_failure(session, err));
 }
 
 svn_error_t *svn_ra_lock(svn_ra_session_t *session,
@@ -1150,10 +1783,14 @@ svn_error_t *svn_ra_replay(svn_ra_session_t *session,
                            void *edit_baton,
                            apr_pool_t *pool)
 {
+  svn_error_t *err;
+
   SVN_ERR_ASSERT(SVN_IS_VALID_REVNUM(revision)
                  && SVN_IS_VALID_REVNUM(low_water_mark));
-  return session->vtable->replay(session, revision, low_water_mark,
-                                 text_deltas, editor, edit_baton, pool);
+  err = session->vtable->replay(session, revision, low_water_mark,
+                                text_deltas, editor, edit_baton, pool);
+
+  return svn_error_trace(remember_failure(session, err));
 }
 
 svn_error_t *
@@ -1233,7 +1870,7 @@ svn_ra_replay_range(svn_ra_session_t *session,
                                   replay_baton, pool);
 
   if (!err || (err && (err->apr_err != SVN_ERR_RA_NOT_IMPLEMENTED)))
-    return svn_error_trace(err);
+    return svn_error_trace(remember_failure(session, err));
 
   svn_error_clear(err);
   return svn_error_trace(replay_range_from_replays(session, start_revision,
@@ -1335,6 +1972,66 @@ svn_ra_get_deleted_rev(svn_ra_session_t *session,
   return err;
 }
 
+/* Set *CONTENTS to a history cache entry holding IPROPS, an array of
+   svn_prop_inherited_item_t *. */
+static svn_error_t *
+serialize_iprops(svn_stringbuf_t **contents,
+                 const apr_array_header_t *iprops,
+                 apr_pool_t *pool)
+{
+  svn_stream_t *stream;
+  int i;
+
+  *contents = svn_stringbuf_create_empty(pool);
+  stream = svn_stream_from_stringbuf(*contents, pool);
+
+  for (i = 0; i < iprops->nelts; i++)
+    {
+      const svn_prop_inherited_item_t *item
+        = APR_ARRAY_IDX(iprops, i, const svn_prop_inherited_item_t *);
+
+      SVN_ERR(svn_stream_printf(stream, pool, "%s\n", item->path_or_url));
+      SVN_ERR(svn_hash_write2(item->prop_hash, stream, SVN_HASH_TERMINATOR,
+                              pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Parse the history cache entry CONTENTS written by serialize_iprops()
+   into *IPROPS, allocated in RESULT_POOL. */
+static svn_error_t *
+parse_iprops(apr_array_header_t **iprops,
+             svn_stringbuf_t *contents,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  svn_stream_t *stream = svn_stream_from_stringbuf(contents, scratch_pool);
+
+  *iprops = apr_array_make(result_pool, 1,
+                           sizeof(svn_prop_inherited_item_t *));
+  while (TRUE)
+    {
+      svn_prop_inherited_item_t *item;
+      svn_stringbuf_t *line;
+      svn_boolean_t eof;
+
+      SVN_ERR(svn_stream_readline(stream, &line, "\n", &eof, result_pool));
+      if (eof)
+        break;
+
+      item = apr_palloc(result_pool, sizeof(*item));
+      item->path_or_url = line->data;
+      item->prop_hash = apr_hash_make(result_pool);
+      SVN_ERR(svn_hash_read2(item->prop_hash, stream, SVN_HASH_TERMINATOR,
+                             result_pool));
+
+      APR_ARRAY_PUSH(*iprops, svn_prop_inherited_item_t *) = item;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_ra_get_inherited_props(svn_ra_session_t *session,
                            apr_array_header_t **iprops,
@@ -1344,9 +2041,35 @@ svn_ra_get_inherited_props(svn_ra_session_t *session,
                            apr_pool_t *scratch_pool)
 {
   svn_error_t *err;
+  const char *uuid = NULL;
+  const char *key = NULL;
+
   /* Path must be relative. */
   SVN_ERR_ASSERT(svn_relpath_is_canonical(path));
 
+  /* Like mergeinfo, the properties of the parents of a path in an
+     existing revision never change.  A revision that doesn't exist yet
+     fails below and is not cached. */
+  if (session->histcache && SVN_IS_VALID_REVNUM(revision))
+    SVN_ERR(get_histcache_key(&uuid, &key, session, "inherited-props",
+                              apr_psprintf(scratch_pool, "%ld\n%s",
+                                           revision, path),
+                              scratch_pool));
+
+  if (key)
+    {
+      svn_stringbuf_t *contents;
+
+      /* Problems with the cache are not fatal; just ask the server. */
+      err = svn_ra__histcache_get(&contents, session->histcache, uuid, key,
+                                  scratch_pool, scratch_pool);
+      if (!err && contents)
+        err = parse_iprops(iprops, contents, result_pool, scratch_pool);
+      if (!err && contents)
+        return SVN_NO_ERROR;
+      svn_error_clear(err);
+    }
+
   err = session->vtable->get_inherited_props(session, iprops, path,
                                              revision, result_pool,
                                              scratch_pool);
@@ -1362,6 +2085,17 @@ svn_ra_get_inherited_props(svn_ra_session_t *session,
   else
     SVN_ERR(err);
 
+  if (key)
+    {
+      svn_stringbuf_t *contents;
+
+      err = serialize_iprops(&contents, *iprops, scratch_pool);
+      if (!err)
+        err = svn_ra__histcache_set(session->histcache, uuid, key, contents,
+                                    scratch_pool);
+      svn_error_clear(err);
+    }
+
   return SVN_NO_ERROR;
 }
 
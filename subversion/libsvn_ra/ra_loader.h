@@ -34,6 +34,8 @@
 
 #include "private/svn_ra_private.h"
 
+#include "histcache.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -343,6 +345,23 @@ typedef struct svn_ra__vtable_t {
                        void *receiver_baton,
                        apr_pool_t *scratch_pool);
 
+  /* See svn_ra_blame(). */
+  svn_error_t *(*blame)(svn_ra_session_t *session,
+                        const char *path,
+                        svn_revnum_t start,
+                        svn_revnum_t end,
+                        const svn_diff_file_options_t *diff_options,
+                        svn_ra_blame_receiver_t receiver,
+                        void *receiver_baton,
+                        apr_pool_t *scratch_pool);
+
+  /* See svn_ra_stat_many(). */
+  svn_error_t *(*stat_many)(svn_ra_session_t *session,
+                            const apr_array_header_t *paths,
+                            svn_revnum_t revision,
+                            apr_hash_t **dirents,
+                            apr_pool_t *pool);
+
   /* Experimental support below here */
 
   /* See svn_ra__register_editor_shim_callbacks() */
@@ -393,6 +412,16 @@ struct svn_ra_session_t {
 
   /* Private data for the RA implementation. */
   void *priv;
+
+  /* Cache of immutable history answers, or NULL. */
+  svn_ra__histcache_t *histcache;
+
+  /* Whether svn_ra_get_log2() may answer from HISTCACHE. */
+  svn_boolean_t use_logcache;
+
+  /* Whether an operation that streams its response failed, which may
+     have left the connection in the middle of that response. */
+  svn_boolean_t failed;
 };
 
 /* Each libsvn_ra_foo defines a function named svn_ra_foo__init of this type.
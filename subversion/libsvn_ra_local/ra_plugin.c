@@ -369,6 +369,10 @@ make_reporter(svn_ra_session_t *session,
                                         additional details. */
                                   result_pool));
 
+  /* The editor applies the text deltas right away.  So, don't spend time
+     on deltifying added files against the empty stream. */
+  svn_repos__report_send_fulltexts(rbaton, TRUE);
+
   /* Wrap the report baton given us by the repos layer with our own
      reporter baton. */
   *report_baton = make_reporter_baton(sess, rbaton, result_pool);
@@ -1649,6 +1653,7 @@ svn_ra_local__has_capability(svn_ra_session_t *session,
       || strcmp(capability, SVN_RA_CAPABILITY_EPHEMERAL_TXNPROPS) == 0
       || strcmp(capability, SVN_RA_CAPABILITY_GET_FILE_REVS_REVERSE) == 0
       || strcmp(capability, SVN_RA_CAPABILITY_LIST) == 0
+      || strcmp(capability, SVN_RA_CAPABILITY_BLAME) == 0
       )
     {
       *has = TRUE;
@@ -1831,7 +1836,7 @@ svn_ra_local__list(svn_ra_session_t *session,
   SVN_ERR(svn_fs_revision_root(&root, sess->fs, revision, pool));
   path = svn_dirent_join(sess->fs_path->data, path, pool);
   return svn_error_trace(svn_repos_list(root, path, patterns, depth,
-                                        path_info_only, NULL, NULL,
+                                        path_info_only, 1, FALSE, NULL, NULL,
                                         dirent_receiver, &baton,
                                         sess->callbacks
                                           ? sess->callbacks->cancel_func
@@ -1839,6 +1844,28 @@ svn_ra_local__list(svn_ra_session_t *session,
                                         sess->callback_baton, pool));
 }
 
+static svn_error_t *
+svn_ra_local__blame(svn_ra_session_t *session,
+                    const char *path,
+                    svn_revnum_t start,
+                    svn_revnum_t end,
+                    const svn_diff_file_options_t *diff_options,
+                    svn_ra_blame_receiver_t receiver,
+                    void *receiver_baton,
+                    apr_pool_t *pool)
+{
+  svn_ra_local__session_baton_t *sess = session->priv;
+  const char *abs_path = svn_fspath__join(sess->fs_path->data, path, pool);
+
+  return svn_error_trace(svn_repos_blame(sess->repos, abs_path, start, end,
+                                         diff_options, NULL, NULL,
+                                         receiver, receiver_baton,
+                                         sess->callbacks
+                                           ? sess->callbacks->cancel_func
+                                           : NULL,
+                                         sess->callback_baton, pool));
+}
+
 /*----------------------------------------------------------------*/
 
 static const svn_version_t *
@@ -1890,6 +1917,8 @@ static const svn_ra__vtable_t ra_local_vtable =
   svn_ra_local__get_inherited_props,
   NULL /* set_svn_ra_open */,
   svn_ra_local__list ,
+  svn_ra_local__blame,
+  NULL /* stat_many */,
   svn_ra_local__register_editor_shim_callbacks,
   svn_ra_local__get_commit_ev2,
   NULL /* replay_range_ev2 */
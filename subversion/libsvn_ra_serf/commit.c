@@ -72,10 +72,18 @@ typedef struct commit_context_t {
   const char *vcc_url;           /* vcc url */
 
   int open_batons;               /* Number of open batons */
+
+  /* HTTP v2 file uploads still in flight (see queue_put()) */
+  int pending_puts;
+  int put_conn;                  /* Connection used for the last upload */
 } commit_context_t;
 
 #define USING_HTTPV2_COMMIT_SUPPORT(commit_ctx) ((commit_ctx)->txn_url != NULL)
 
+/* Maximum number of file uploads in flight before close_file() waits for
+   some of them to complete. */
+#define MAX_PENDING_PUTS 32
+
 /* Structure associated with a PROPPATCH request. */
 typedef struct proppatch_context_t {
   apr_pool_t *pool;
@@ -188,8 +196,30 @@ typedef struct file_context_t {
   /* URL to PUT the file at. */
   const char *url;
 
+  /* Pool holding SVNDIFF when the upload may outlive the file baton,
+     or NULL. */
+  apr_pool_t *put_pool;
+
 } file_context_t;
 
+/* A file upload sent while the editor drive continues. */
+typedef struct put_context_t {
+  /* Pool holding everything below; destroyed when PENDING reaches 0. */
+  apr_pool_t *pool;
+
+  /* Copy of the fields of the file baton needed by the requests. */
+  file_context_t *file;
+
+  svn_ra_serf__handler_t *put_handler;
+  int expected_result;
+
+  /* PROPPATCH sent after the PUT on the same connection, or NULL. */
+  svn_ra_serf__handler_t *proppatch_handler;
+
+  /* Number of requests (PUT and optional PROPPATCH) not done yet. */
+  int pending;
+} put_context_t;
+
 
 /* Setup routines and handlers for various requests we'll invoke. */
 
@@ -823,13 +853,32 @@ create_proppatch_body(serf_bucket_t **bkt,
   return SVN_NO_ERROR;
 }
 
-static svn_error_t*
-proppatch_resource(svn_ra_serf__session_t *session,
-                   proppatch_context_t *proppatch,
-                   apr_pool_t *pool)
+/* Use specific error code for property handling errors in ERR.
+   Use loop to provide the right result with tracing */
+static svn_error_t *
+proppatch_error(svn_error_t *err)
+{
+  if (err && err->apr_err == SVN_ERR_RA_DAV_REQUEST_FAILED)
+    {
+      svn_error_t *e = err;
+
+      while (e && e->apr_err == SVN_ERR_RA_DAV_REQUEST_FAILED)
+        {
+          e->apr_err = SVN_ERR_RA_DAV_PROPPATCH_FAILED;
+          e = e->child;
+        }
+    }
+
+  return err;
+}
+
+/* Create a handler in POOL for PROPPATCH in SESSION. */
+static svn_ra_serf__handler_t *
+create_proppatch_handler(svn_ra_serf__session_t *session,
+                         proppatch_context_t *proppatch,
+                         apr_pool_t *pool)
 {
   svn_ra_serf__handler_t *handler;
-  svn_error_t *err;
 
   handler = svn_ra_serf__create_handler(session, pool);
 
@@ -846,25 +895,25 @@ proppatch_resource(svn_ra_serf__session_t *session,
   handler->response_handler = svn_ra_serf__handle_multistatus_only;
   handler->response_baton = handler;
 
+  return handler;
+}
+
+static svn_error_t*
+proppatch_resource(svn_ra_serf__session_t *session,
+                   proppatch_context_t *proppatch,
+                   apr_pool_t *pool)
+{
+  svn_ra_serf__handler_t *handler;
+  svn_error_t *err;
+
+  handler = create_proppatch_handler(session, proppatch, pool);
+
   err = svn_ra_serf__context_run_one(handler, pool);
 
   if (!err && handler->sline.code != 207)
     err = svn_error_trace(svn_ra_serf__unexpected_status(handler));
 
-  /* Use specific error code for property handling errors.
-     Use loop to provide the right result with tracing */
-  if (err && err->apr_err == SVN_ERR_RA_DAV_REQUEST_FAILED)
-    {
-      svn_error_t *e = err;
-
-      while (e && e->apr_err == SVN_ERR_RA_DAV_REQUEST_FAILED)
-        {
-          e->apr_err = SVN_ERR_RA_DAV_PROPPATCH_FAILED;
-          e = e->child;
-        }
-    }
-
-  return svn_error_trace(err);
+  return svn_error_trace(proppatch_error(err));
 }
 
 /* Implements svn_ra_serf__request_body_delegate_t */
@@ -911,6 +960,235 @@ setup_put_headers(serf_bucket_t *headers,
   return APR_SUCCESS;
 }
 
+/* Create a handler in POOL for the PUT of FILE, sending an empty body
+   if PUT_EMPTY_FILE is TRUE and FILE->SVNDIFF otherwise. */
+static svn_ra_serf__handler_t *
+create_put_handler(file_context_t *file,
+                   svn_boolean_t put_empty_file,
+                   apr_pool_t *pool)
+{
+  svn_ra_serf__handler_t *handler;
+
+  handler = svn_ra_serf__create_handler(file->commit_ctx->session, pool);
+
+  handler->method = "PUT";
+  handler->path = file->url;
+
+  handler->response_handler = svn_ra_serf__expect_empty_body;
+  handler->response_baton = handler;
+
+  if (put_empty_file)
+    {
+      handler->body_delegate = create_empty_put_body;
+      handler->body_delegate_baton = file;
+      handler->body_type = "text/plain";
+    }
+  else
+    {
+      svn_ra_serf__request_body_get_delegate(&handler->body_delegate,
+                                             &handler->body_delegate_baton,
+                                             file->svndiff);
+      handler->body_type = SVN_SVNDIFF_MIME_TYPE;
+    }
+
+  handler->header_delegate = setup_put_headers;
+  handler->header_delegate_baton = file;
+
+  return handler;
+}
+
+/* Note that one of the requests of PUT is done, and release PUT after
+   the last one. */
+static void
+put_request_done(put_context_t *put)
+{
+  if (--put->pending == 0)
+    {
+      put->file->commit_ctx->pending_puts--;
+      svn_pool_destroy(put->pool);
+    }
+}
+
+/* Implements svn_ra_serf__response_done_delegate_t */
+static svn_error_t *
+put_done(serf_request_t *request,
+         void *baton,
+         apr_pool_t *scratch_pool)
+{
+  put_context_t *put = baton;
+  svn_ra_serf__handler_t *handler = put->put_handler;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  if (handler->server_error)
+    err = svn_ra_serf__server_error_create(handler, scratch_pool);
+  else if (handler->sline.code != put->expected_result)
+    err = svn_ra_serf__unexpected_status(handler);
+
+  put_request_done(put);
+
+  return svn_error_trace(err);
+}
+
+/* Implements svn_ra_serf__response_done_delegate_t */
+static svn_error_t *
+put_proppatch_done(serf_request_t *request,
+                   void *baton,
+                   apr_pool_t *scratch_pool)
+{
+  put_context_t *put = baton;
+  svn_ra_serf__handler_t *handler = put->proppatch_handler;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  if (handler->server_error)
+    err = svn_ra_serf__server_error_create(handler, scratch_pool);
+  else if (handler->sline.code != 207)
+    err = svn_ra_serf__unexpected_status(handler);
+
+  put_request_done(put);
+
+  return svn_error_trace(proppatch_error(err));
+}
+
+/* Run the context of CTX until no more than MAX_PENDING file uploads
+   are in flight. */
+static svn_error_t *
+wait_for_puts(commit_context_t *ctx,
+              int max_pending,
+              apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool;
+  apr_interval_time_t waittime_left = ctx->session->timeout;
+
+  if (ctx->pending_puts <= max_pending)
+    return SVN_NO_ERROR;
+
+  iterpool = svn_pool_create(scratch_pool);
+  while (ctx->pending_puts > max_pending)
+    {
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_ra_serf__context_run(ctx->session, &waittime_left,
+                                       iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Queue the PUT of FILE, and the PROPPATCH of its property changes, on
+   one of the connections of the session without waiting for the result.
+
+   Requests on a single connection are handled in order, so the
+   PROPPATCH always follows the PUT of the same file.  All uploads must
+   be complete before the MERGE; see close_edit(). */
+static svn_error_t *
+queue_put(file_context_t *file,
+          svn_boolean_t put_empty_file,
+          apr_pool_t *scratch_pool)
+{
+  commit_context_t *commit_ctx = file->commit_ctx;
+  svn_ra_serf__session_t *session = commit_ctx->session;
+  svn_ra_serf__connection_t *conn;
+  put_context_t *put;
+  apr_pool_t *pool;
+
+  SVN_ERR(wait_for_puts(commit_ctx, MAX_PENDING_PUTS - 1, scratch_pool));
+
+  /* Keep conns[0] for the requests of the editor drive itself and
+     spread the uploads over up to MAX_CONNECTIONS - 1 others. A http/2
+     connection multiplexes all requests anyway. */
+  if (session->http20)
+    conn = session->conns[0];
+  else
+    {
+      if (session->num_conns == 1
+          || (session->num_conns <= commit_ctx->pending_puts
+              && session->num_conns < session->max_connections))
+        SVN_ERR(svn_ra_serf__open_connection(session));
+
+      commit_ctx->put_conn = (commit_ctx->put_conn
+                              % (session->num_conns - 1)) + 1;
+      conn = session->conns[commit_ctx->put_conn];
+    }
+
+  if (file->put_pool)
+    pool = file->put_pool;
+  else
+    pool = svn_pool_create(commit_ctx->pool);
+  file->put_pool = NULL;
+
+  put = apr_pcalloc(pool, sizeof(*put));
+  put->pool = pool;
+
+  /* The file baton dies with the file pool, so copy what the
+     requests need. */
+  put->file = apr_pcalloc(pool, sizeof(*put->file));
+  put->file->pool = pool;
+  put->file->commit_ctx = commit_ctx;
+  put->file->added = file->added;
+  put->file->relpath = apr_pstrdup(pool, file->relpath);
+  put->file->base_revision = file->base_revision;
+  put->file->copy_path = apr_pstrdup(pool, file->copy_path);
+  put->file->copy_revision = file->copy_revision;
+  put->file->svndiff = file->svndiff;
+  put->file->base_checksum = apr_pstrdup(pool, file->base_checksum);
+  put->file->result_checksum = apr_pstrdup(pool, file->result_checksum);
+  put->file->url = apr_pstrdup(pool, file->url);
+
+  if (file->added && ! file->copy_path)
+    put->expected_result = 201; /* Created */
+  else
+    put->expected_result = 204; /* Updated */
+
+  put->put_handler = create_put_handler(put->file, put_empty_file, pool);
+  put->put_handler->conn = conn;
+  put->put_handler->done_delegate = put_done;
+  put->put_handler->done_delegate_baton = put;
+  put->pending++;
+
+  if (apr_hash_count(file->prop_changes))
+    {
+      proppatch_context_t *proppatch;
+      apr_hash_index_t *hi;
+
+      proppatch = apr_pcalloc(pool, sizeof(*proppatch));
+      proppatch->pool = pool;
+      proppatch->relpath = put->file->relpath;
+      proppatch->path = put->file->url;
+      proppatch->commit_ctx = commit_ctx;
+      proppatch->prop_changes = apr_hash_make(pool);
+      proppatch->base_revision = file->base_revision;
+
+      for (hi = apr_hash_first(scratch_pool, file->prop_changes);
+           hi;
+           hi = apr_hash_next(hi))
+        {
+          const svn_prop_t *prop = apr_hash_this_val(hi);
+          svn_prop_t *prop_dup = apr_palloc(pool, sizeof(*prop_dup));
+
+          prop_dup->name = apr_pstrdup(pool, prop->name);
+          prop_dup->value = svn_string_dup(prop->value, pool);
+
+          svn_hash_sets(proppatch->prop_changes, prop_dup->name, prop_dup);
+        }
+
+      put->proppatch_handler = create_proppatch_handler(session, proppatch,
+                                                        pool);
+      put->proppatch_handler->conn = conn;
+      put->proppatch_handler->done_delegate = put_proppatch_done;
+      put->proppatch_handler->done_delegate_baton = put;
+      put->pending++;
+    }
+
+  commit_ctx->pending_puts++;
+
+  svn_ra_serf__request_create(put->put_handler);
+  if (put->proppatch_handler)
+    svn_ra_serf__request_create(put->proppatch_handler);
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 setup_copy_file_headers(serf_bucket_t *headers,
                         void *baton,
@@ -1888,13 +2166,28 @@ apply_textdelta(void *file_baton,
    *     for sure after the request is completely available.
    */
 
+  /* With HTTP v2 the PUT may still be in flight after close_file(), so
+     keep the svndiff in a pool of its own. */
+  if (USING_HTTPV2_COMMIT_SUPPORT(ctx->commit_ctx))
+    ctx->put_pool = svn_pool_create(ctx->commit_ctx->pool);
+
   ctx->svndiff =
     svn_ra_serf__request_body_create(SVN_RA_SERF__REQUEST_BODY_IN_MEM_SIZE,
-                                     ctx->pool);
+                                     ctx->put_pool ? ctx->put_pool
+                                                   : ctx->pool);
   ctx->stream = svn_ra_serf__request_body_get_stream(ctx->svndiff);
 
-  if (ctx->commit_ctx->session->supports_svndiff1 &&
-      ctx->commit_ctx->session->using_compression)
+  if (ctx->commit_ctx->session->supports_svndiff2 &&
+      ctx->commit_ctx->session->using_compression &&
+      svn_lz4__compiled_version())
+    {
+      /* Use LZ4 compressed svndiff2 format, which is much cheaper to
+         produce and to decode than svndiff1. */
+      svndiff_version = 2;
+      compression_level = SVN_DELTA_COMPRESSION_LEVEL_DEFAULT;
+    }
+  else if (ctx->commit_ctx->session->supports_svndiff1 &&
+           ctx->commit_ctx->session->using_compression)
     {
       /* Use compressed svndiff1 format, if possible. */
       svndiff_version = 1;
@@ -1962,39 +2255,31 @@ close_file(void *file_baton,
   if ((!ctx->svndiff) && ctx->added && (!ctx->copy_path))
     put_empty_file = TRUE;
 
+  if (ctx->svndiff)
+    SVN_ERR(svn_stream_close(ctx->stream));
+
+  /* Within a HTTP v2 transaction nothing but the MERGE depends on the
+     file contents, so don't wait for the upload.  Over http/2 the
+     PROPPATCH might overtake the PUT, so send those files in order. */
+  if (USING_HTTPV2_COMMIT_SUPPORT(ctx->commit_ctx)
+      && (ctx->svndiff || put_empty_file)
+      && !(ctx->commit_ctx->session->http20
+           && apr_hash_count(ctx->prop_changes)))
+    {
+      SVN_ERR(queue_put(ctx, put_empty_file, scratch_pool));
+
+      ctx->commit_ctx->open_batons--;
+
+      return SVN_NO_ERROR;
+    }
+
   /* If we had a stream of changes, push them to the server... */
   if (ctx->svndiff || put_empty_file)
     {
       svn_ra_serf__handler_t *handler;
       int expected_result;
 
-      handler = svn_ra_serf__create_handler(ctx->commit_ctx->session,
-                                            scratch_pool);
-
-      handler->method = "PUT";
-      handler->path = ctx->url;
-
-      handler->response_handler = svn_ra_serf__expect_empty_body;
-      handler->response_baton = handler;
-
-      if (put_empty_file)
-        {
-          handler->body_delegate = create_empty_put_body;
-          handler->body_delegate_baton = ctx;
-          handler->body_type = "text/plain";
-        }
-      else
-        {
-          SVN_ERR(svn_stream_close(ctx->stream));
-
-          svn_ra_serf__request_body_get_delegate(&handler->body_delegate,
-                                                 &handler->body_delegate_baton,
-                                                 ctx->svndiff);
-          handler->body_type = SVN_SVNDIFF_MIME_TYPE;
-        }
-
-      handler->header_delegate = setup_put_headers;
-      handler->header_delegate_baton = ctx;
+      handler = create_put_handler(ctx, put_empty_file, scratch_pool);
 
       SVN_ERR(svn_ra_serf__context_run_one(handler, scratch_pool));
 
@@ -2011,6 +2296,12 @@ close_file(void *file_baton,
   if (ctx->svndiff)
     SVN_ERR(svn_ra_serf__request_body_cleanup(ctx->svndiff, scratch_pool));
 
+  if (ctx->put_pool)
+    {
+      svn_pool_destroy(ctx->put_pool);
+      ctx->put_pool = NULL;
+    }
+
   /* If we had any prop changes, push them via PROPPATCH. */
   if (apr_hash_count(ctx->prop_changes))
     {
@@ -2048,6 +2339,9 @@ close_edit(void *edit_baton,
               SVN_ERR_FS_INCORRECT_EDITOR_COMPLETION, NULL,
               _("Closing editor with directories or files open"));
 
+  /* All file contents must be in the transaction before the MERGE */
+  SVN_ERR(wait_for_puts(ctx, 0, pool));
+
   /* MERGE our activity */
   SVN_ERR(svn_ra_serf__run_merge(&commit_info,
                                  ctx->session,
@@ -2102,6 +2396,10 @@ abort_edit(void *edit_baton,
   if (! (ctx->activity_url || ctx->txn_url))
     return SVN_NO_ERROR;
 
+  /* Let file uploads that are still in flight complete before the
+     transaction is removed below; their errors don't matter anymore. */
+  svn_error_clear(wait_for_puts(ctx, 0, pool));
+
   /* An error occurred on conns[0]. serf 0.4.0 remembers that the connection
      had a problem. We need to reset it, in order to use it again.  */
   serf_connection_reset(ctx->session->conns[0]->conn);
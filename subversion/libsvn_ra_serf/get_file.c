@@ -187,6 +187,65 @@ try_get_wc_contents(svn_boolean_t *found_p,
   return SVN_NO_ERROR;
 }
 
+/* Helper svn_ra_serf__get_file(). Attempts to fetch the contents of the
+ * file at FETCH_URL from the revision cache of SESSION.
+ *
+ * Sets *FOUND_P to TRUE if file contents was successfully fetched.
+ * Otherwise sets *CACHE_ENTRY_P and *CACHE_STREAM_P to a new cache entry
+ * and the stream to write the contents to, or to NULL if the contents
+ * can't be cached.
+ *
+ * Performs all allocations in POOL.
+ */
+static svn_error_t *
+try_get_cached_contents(svn_boolean_t *found_p,
+                        svn_ra_serf__revcache_entry_t **cache_entry_p,
+                        svn_stream_t **cache_stream_p,
+                        svn_ra_serf__session_t *session,
+                        const char *fetch_url,
+                        svn_stream_t *dst_stream,
+                        apr_pool_t *pool)
+{
+  const char *key = apr_pstrcat(pool, "GET\n", fetch_url, SVN_VA_NULL);
+  svn_stream_t *cached;
+  svn_error_t *err;
+
+  *found_p = FALSE;
+  *cache_entry_p = NULL;
+  *cache_stream_p = NULL;
+
+  /* Problems with the cache are not fatal; just ask the server. */
+  err = svn_ra_serf__revcache_get(&cached, session->revcache, session->uuid,
+                                  key, pool, pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  if (cached)
+    {
+      SVN_ERR(svn_stream_copy3(cached, svn_stream_disown(dst_stream, pool),
+                               session->cancel_func, session->cancel_baton,
+                               pool));
+      *found_p = TRUE;
+
+      return SVN_NO_ERROR;
+    }
+
+  err = svn_ra_serf__revcache_put_begin(cache_entry_p, cache_stream_p,
+                                        session->revcache, session->uuid,
+                                        key, pool, pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      *cache_entry_p = NULL;
+      *cache_stream_p = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* -----------------------------------------------------------------------
    svn_ra_get_file() specific */
 
@@ -326,7 +385,6 @@ svn_ra_serf__get_file(svn_ra_session_t *ra_session,
   svn_ra_serf__session_t *session = ra_session->priv;
   const char *fetch_url;
   const svn_ra_serf__dav_props_t *which_props;
-  svn_ra_serf__handler_t *propfind_handler;
   apr_pool_t *scratch_pool = svn_pool_create(result_pool);
   struct file_prop_baton_t fb;
 
@@ -363,13 +421,9 @@ svn_ra_serf__get_file(svn_ra_session_t *ra_session,
   fb.kind = svn_node_unknown;
   fb.sha1_checksum = NULL;
 
-  SVN_ERR(svn_ra_serf__create_propfind_handler(&propfind_handler, session,
-                                               fetch_url, SVN_INVALID_REVNUM,
-                                               "0", which_props,
-                                               get_file_prop_cb, &fb,
-                                               scratch_pool));
-
-  SVN_ERR(svn_ra_serf__context_run_one(propfind_handler, scratch_pool));
+  SVN_ERR(svn_ra_serf__run_cached_propfind(session, fetch_url, which_props,
+                                           get_file_prop_cb, &fb,
+                                           scratch_pool));
 
   /* Verify that resource type is not collection. */
   if (fb.kind != svn_node_file)
@@ -384,10 +438,19 @@ svn_ra_serf__get_file(svn_ra_session_t *ra_session,
   if (stream)
     {
       svn_boolean_t found;
+      svn_ra_serf__revcache_entry_t *cache_entry = NULL;
+      svn_stream_t *cache_stream = NULL;
+
       SVN_ERR(try_get_wc_contents(&found, session, fb.sha1_checksum, stream,
                                   scratch_pool));
 
-      /* No contents found in the WC, let's fetch from server. */
+      if (!found && svn_ra_serf__use_revcache(session, fetch_url))
+        SVN_ERR(try_get_cached_contents(&found, &cache_entry, &cache_stream,
+                                        session, fetch_url, stream,
+                                        scratch_pool));
+
+      /* No contents found in the WC or the cache, let's fetch from
+         server. */
       if (!found)
         {
           stream_ctx_t *stream_ctx;
@@ -395,7 +458,11 @@ svn_ra_serf__get_file(svn_ra_session_t *ra_session,
 
           /* Create the fetch context. */
           stream_ctx = apr_pcalloc(scratch_pool, sizeof(*stream_ctx));
-          stream_ctx->result_stream = stream;
+          if (cache_stream)
+            stream_ctx->result_stream = svn_stream_tee(stream, cache_stream,
+                                                       scratch_pool);
+          else
+            stream_ctx->result_stream = stream;
           stream_ctx->using_compression = session->using_compression;
 
           handler = svn_ra_serf__create_handler(session, scratch_pool);
@@ -421,6 +488,10 @@ svn_ra_serf__get_file(svn_ra_session_t *ra_session,
 
           if (handler->sline.code != 200)
             return svn_error_trace(svn_ra_serf__unexpected_status(handler));
+
+          if (cache_entry)
+            svn_error_clear(svn_ra_serf__revcache_put_end(cache_entry,
+                                                          scratch_pool));
         }
     }
 
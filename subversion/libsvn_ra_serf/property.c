@@ -563,6 +563,165 @@ deliver_node_props(void *baton,
   return SVN_NO_ERROR;
 }
 
+svn_boolean_t
+svn_ra_serf__use_revcache(svn_ra_serf__session_t *session,
+                          const char *url)
+{
+  apr_size_t len;
+
+  if (!session->revcache || !session->uuid || !session->rev_root_stub)
+    return FALSE;
+
+  /* Only REV/PATH pairs are immutable; revision properties are not. */
+  len = strlen(session->rev_root_stub);
+
+  return (strncmp(url, session->rev_root_stub, len) == 0
+          && url[len] == '/');
+}
+
+/* Baton for record_prop */
+typedef struct record_prop_baton_t
+{
+  svn_ra_serf__prop_func_t prop_func;
+  void *prop_func_baton;
+
+  /* "NS\nNAME" -> svn_string_t * */
+  apr_hash_t *props;
+} record_prop_baton_t;
+
+/* Implements svn_ra_serf__prop_func_t, storing all properties in
+   BATON->PROPS before passing them on to BATON->PROP_FUNC. */
+static svn_error_t *
+record_prop(void *baton,
+            const char *path,
+            const char *ns,
+            const char *name,
+            const svn_string_t *value,
+            apr_pool_t *scratch_pool)
+{
+  record_prop_baton_t *rpb = baton;
+  apr_pool_t *result_pool = apr_hash_pool_get(rpb->props);
+
+  svn_hash_sets(rpb->props,
+                apr_pstrcat(result_pool, ns, "\n", name, SVN_VA_NULL),
+                svn_string_dup(value, result_pool));
+
+  return svn_error_trace(rpb->prop_func(rpb->prop_func_baton, path,
+                                        ns, name, value, scratch_pool));
+}
+
+/* Deliver the properties read from the revision cache STREAM for URL
+   to PROP_FUNC with PROP_FUNC_BATON. */
+static svn_error_t *
+replay_cached_props(svn_stream_t *stream,
+                    const char *url,
+                    svn_ra_serf__prop_func_t prop_func,
+                    void *prop_func_baton,
+                    apr_pool_t *scratch_pool)
+{
+  apr_hash_t *props = apr_hash_make(scratch_pool);
+  apr_hash_index_t *hi;
+  apr_pool_t *iterpool;
+
+  SVN_ERR(svn_hash_read2(props, stream, SVN_HASH_TERMINATOR, scratch_pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (hi = apr_hash_first(scratch_pool, props); hi; hi = apr_hash_next(hi))
+    {
+      const char *key = apr_hash_this_key(hi);
+      const char *name = strchr(key, '\n');
+
+      if (!name)
+        return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL, NULL);
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(prop_func(prop_func_baton, url,
+                        apr_pstrmemdup(iterpool, key, name - key),
+                        name + 1, apr_hash_this_val(hi), iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra_serf__run_cached_propfind(svn_ra_serf__session_t *session,
+                                 const char *url,
+                                 const svn_ra_serf__dav_props_t *find_props,
+                                 svn_ra_serf__prop_func_t prop_func,
+                                 void *prop_func_baton,
+                                 apr_pool_t *scratch_pool)
+{
+  svn_ra_serf__handler_t *handler;
+  const svn_ra_serf__dav_props_t *prop;
+  svn_stringbuf_t *key;
+  svn_stream_t *stream;
+  svn_ra_serf__revcache_entry_t *entry;
+  record_prop_baton_t rpb;
+  svn_error_t *err;
+
+  if (!svn_ra_serf__use_revcache(session, url))
+    {
+      SVN_ERR(svn_ra_serf__create_propfind_handler(&handler, session, url,
+                                                   SVN_INVALID_REVNUM, "0",
+                                                   find_props,
+                                                   prop_func,
+                                                   prop_func_baton,
+                                                   scratch_pool));
+
+      return svn_error_trace(svn_ra_serf__context_run_one(handler,
+                                                          scratch_pool));
+    }
+
+  /* Different sets of properties are cached separately. */
+  key = svn_stringbuf_create("PROPFIND", scratch_pool);
+  for (prop = find_props; prop->xmlns; prop++)
+    {
+      svn_stringbuf_appendbyte(key, ' ');
+      svn_stringbuf_appendcstr(key, prop->xmlns);
+      svn_stringbuf_appendbyte(key, ' ');
+      svn_stringbuf_appendcstr(key, prop->name);
+    }
+  svn_stringbuf_appendbyte(key, '\n');
+  svn_stringbuf_appendcstr(key, url);
+
+  /* Problems with the cache are not fatal; just ask the server. */
+  err = svn_ra_serf__revcache_get(&stream, session->revcache, session->uuid,
+                                  key->data, scratch_pool, scratch_pool);
+  if (!err && stream)
+    err = replay_cached_props(stream, url, prop_func, prop_func_baton,
+                              scratch_pool);
+  if (!err && stream)
+    return SVN_NO_ERROR;
+  svn_error_clear(err);
+
+  rpb.prop_func = prop_func;
+  rpb.prop_func_baton = prop_func_baton;
+  rpb.props = apr_hash_make(scratch_pool);
+
+  SVN_ERR(svn_ra_serf__create_propfind_handler(&handler, session, url,
+                                               SVN_INVALID_REVNUM, "0",
+                                               find_props,
+                                               record_prop, &rpb,
+                                               scratch_pool));
+
+  SVN_ERR(svn_ra_serf__context_run_one(handler, scratch_pool));
+
+  err = svn_ra_serf__revcache_put_begin(&entry, &stream, session->revcache,
+                                        session->uuid, key->data,
+                                        scratch_pool, scratch_pool);
+  if (!err)
+    err = svn_hash_write2(rpb.props, stream, SVN_HASH_TERMINATOR,
+                          scratch_pool);
+  if (!err)
+    err = svn_ra_serf__revcache_put_end(entry, scratch_pool);
+  svn_error_clear(err);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_ra_serf__fetch_node_props(apr_hash_t **results,
                               svn_ra_serf__session_t *session,
@@ -577,12 +736,20 @@ svn_ra_serf__fetch_node_props(apr_hash_t **results,
 
   props = apr_hash_make(result_pool);
 
-  SVN_ERR(svn_ra_serf__create_propfind_handler(&handler, session,
-                                               url, revision, "0", which_props,
-                                               deliver_node_props,
-                                               props, scratch_pool));
+  if (SVN_IS_VALID_REVNUM(revision))
+    {
+      SVN_ERR(svn_ra_serf__create_propfind_handler(&handler, session,
+                                                   url, revision, "0",
+                                                   which_props,
+                                                   deliver_node_props,
+                                                   props, scratch_pool));
 
-  SVN_ERR(svn_ra_serf__context_run_one(handler, scratch_pool));
+      SVN_ERR(svn_ra_serf__context_run_one(handler, scratch_pool));
+    }
+  else
+    SVN_ERR(svn_ra_serf__run_cached_propfind(session, url, which_props,
+                                             deliver_node_props, props,
+                                             scratch_pool));
 
   *results = props;
   return SVN_NO_ERROR;
@@ -42,6 +42,7 @@
 #include "private/svn_editor.h"
 
 #include "blncache.h"
+#include "revcache.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -119,6 +120,10 @@ struct svn_ra_serf__session_t {
   /* The user agent string */
   const char *useragent;
 
+  /* Value of the SVN_DAV_TRACE_ID_HEADER sent with every request,
+     or NULL. */
+  const char *trace_id;
+
   /* The current connection */
   svn_ra_serf__connection_t *conns[SVN_RA_SERF__MAX_CONNECTIONS_LIMIT];
   int num_conns;
@@ -140,6 +145,9 @@ struct svn_ra_serf__session_t {
      requests may come in any order */
   svn_boolean_t http20;
 
+  /* Should we offer http/2 when negotiating TLS.  */
+  svn_boolean_t enable_http2;
+
   /* Should we use Transfer-Encoding: chunked for HTTP/1.1 servers. */
   svn_boolean_t using_chunked_requests;
 
@@ -239,6 +247,16 @@ struct svn_ra_serf__session_t {
 
   svn_ra_serf__blncache_t *blncache;
 
+  /* On-disk cache of revision resources, or NULL if not configured. */
+  svn_ra_serf__revcache_t *revcache;
+
+  /* Dirents of the children listed by svn_ra_serf__get_dir() in a
+     specific revision, mapping const char * stable URLs to
+     svn_dirent_t *, so that stat and check_path calls on them don't need
+     a PROPFIND.  Allocated lazily in DIRENT_CACHE_POOL.  */
+  apr_hash_t *dirent_cache;
+  apr_pool_t *dirent_cache_pool;
+
   /* Trisate flag that indicates user preference for using bulk updates
      (svn_tristate_true) with all the properties and content in the
      update-report response. If svn_tristate_false, request a skelta
@@ -261,6 +279,9 @@ struct svn_ra_serf__session_t {
 
   /* Indicates whether the server can understand svndiff version 1. */
   svn_boolean_t supports_svndiff1;
+
+  /* Indicates whether the server can understand svndiff version 2. */
+  svn_boolean_t supports_svndiff2;
 };
 
 #define SVN_RA_SERF__HAVE_HTTPV2_SUPPORT(sess) ((sess)->me_resource != NULL)
@@ -336,6 +357,20 @@ svn_ra_serf__conn_closed(serf_connection_t *conn,
                          apr_status_t why,
                          apr_pool_t *pool);
 
+/* Open an additional connection to the server in SESS and add it to
+   SESS->CONNS.  The caller must ensure that SESS->NUM_CONNS is below
+   SVN_RA_SERF__MAX_CONNECTIONS_LIMIT. */
+svn_error_t *
+svn_ra_serf__open_connection(svn_ra_serf__session_t *sess);
+
+/* Return the value of the Accept-Encoding header for requests that may
+   receive svndiff data.  If USING_COMPRESSION, the compressed svndiff
+   formats are preferred; the cheapest one (svndiff2, if we have LZ4)
+   first.  If WITH_GZIP, gzip transport compression is accepted too. */
+const char *
+svn_ra_serf__svndiff_accept_encoding(svn_boolean_t using_compression,
+                                     svn_boolean_t with_gzip);
+
 
 /* Helper function to provide SSL client certificates.
  *
@@ -973,6 +1008,31 @@ svn_ra_serf__create_propfind_handler(svn_ra_serf__handler_t **handler,
                                      apr_pool_t *result_pool);
 
 
+/* Return TRUE if the resource at URL in SESSION can't change (such as a
+   path in a specific revision in HTTP v2) and SESSION has a revision
+   cache to store it in. */
+svn_boolean_t
+svn_ra_serf__use_revcache(svn_ra_serf__session_t *session,
+                          const char *url);
+
+/* Using SESSION, fetch the properties specified by FIND_PROPS of the
+   resource at URL (at depth "0") and deliver them to PROP_FUNC with
+   PROP_FUNC_BATON, like a PROPFIND created by
+   svn_ra_serf__create_propfind_handler().  If svn_ra_serf__use_revcache()
+   allows it, the properties are taken from and stored in the revision
+   cache; the path passed to PROP_FUNC is then always URL.
+
+   This function performs the request synchronously.
+
+   Temporary allocations are made in SCRATCH_POOL.  */
+svn_error_t *
+svn_ra_serf__run_cached_propfind(svn_ra_serf__session_t *session,
+                                 const char *url,
+                                 const svn_ra_serf__dav_props_t *find_props,
+                                 svn_ra_serf__prop_func_t prop_func,
+                                 void *prop_func_baton,
+                                 apr_pool_t *scratch_pool);
+
 /* Using SESSION, fetch the properties specified by WHICH_PROPS using CONN
    for URL at REVISION. The resulting properties are placed into a 2-level
    hash in RESULTS, mapping NAMESPACE -> hash<PROPNAME, PROPVALUE>, which
@@ -1583,6 +1643,15 @@ svn_ra_serf__request_body_t *
 svn_ra_serf__request_body_create(apr_size_t in_memory_size,
                                  apr_pool_t *result_pool);
 
+/* Like svn_ra_serf__request_body_create(), but the body can be sent
+   while it is still being written: the bucket created by its delegate
+   returns APR_EAGAIN when it has caught up with the writer, and APR_EOF
+   only after the stream has been closed.  Such a body must be sent with
+   chunked transfer encoding until it has been closed. */
+svn_ra_serf__request_body_t *
+svn_ra_serf__request_body_create_streaming(apr_size_t in_memory_size,
+                                           apr_pool_t *result_pool);
+
 /* Get the writable stream associated with BODY. */
 svn_stream_t *
 svn_ra_serf__request_body_get_stream(svn_ra_serf__request_body_t *body);
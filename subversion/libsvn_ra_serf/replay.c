@@ -470,6 +470,23 @@ replay_cdata(svn_ra_serf__xml_estate_t *xes,
   return SVN_NO_ERROR;
 }
 
+/* Implements svn_ra_serf__request_header_delegate_t */
+static svn_error_t *
+setup_replay_headers(serf_bucket_t *headers,
+                     void *baton,
+                     apr_pool_t *pool /* request pool */,
+                     apr_pool_t *scratch_pool)
+{
+  svn_ra_serf__session_t *session = baton;
+
+  serf_bucket_headers_setn(headers, "Accept-Encoding",
+                           svn_ra_serf__svndiff_accept_encoding(
+                                    session->using_compression,
+                                    session->using_compression));
+
+  return SVN_NO_ERROR;
+}
+
 /* Implements svn_ra_serf__request_body_delegate_t */
 static svn_error_t *
 create_replay_body(serf_bucket_t **bkt,
@@ -561,6 +578,9 @@ svn_ra_serf__replay(svn_ra_session_t *ra_session,
   handler->body_delegate = create_replay_body;
   handler->body_delegate_baton = &ctx;
   handler->body_type = "text/xml";
+  handler->header_delegate = setup_replay_headers;
+  handler->header_delegate_baton = session;
+  handler->custom_accept_encoding = TRUE;
 
   /* Not setting up done handler as we don't use a global context */
 
@@ -777,6 +797,9 @@ svn_ra_serf__replay_range(svn_ra_session_t *ra_session,
           handler->body_delegate = create_replay_body;
           handler->body_delegate_baton = rev_ctx;
           handler->body_type = "text/xml";
+          handler->header_delegate = setup_replay_headers;
+          handler->header_delegate_baton = session;
+          handler->custom_accept_encoding = TRUE;
 
           handler->done_delegate = replay_done;
           handler->done_delegate_baton = rev_ctx;
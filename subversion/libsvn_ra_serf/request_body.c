@@ -22,6 +22,9 @@
  */
 
 #include <serf.h>
+#include <serf_bucket_util.h>
+
+#include "svn_sorts.h"
 
 #include "ra_serf.h"
 
@@ -36,8 +39,32 @@ struct svn_ra_serf__request_body_t
   apr_file_t *file;
   apr_pool_t *result_pool;
   apr_pool_t *scratch_pool;
+
+  /* For streaming bodies: the first MEM_BYTES bytes of the body live in
+     MEM, the rest in FILE.  CLOSED is set once the writer is done, and
+     FILE_AT_END is cleared when a reader moves the file position. */
+  svn_boolean_t streaming;
+  svn_boolean_t closed;
+  char *mem;
+  apr_size_t mem_bytes;
+  svn_boolean_t file_at_end;
 };
 
+/* The maximum amount of data returned from a streaming body file at once. */
+#define STREAMING_READ_SIZE (16 * 1024)
+
+/* Baton for a bucket reading a streaming body. */
+typedef struct streaming_bucket_ctx_t
+{
+  svn_ra_serf__request_body_t *body;
+
+  /* Offset of the next byte to return. */
+  apr_size_t offset;
+
+  /* Buffer for data read from BODY->FILE. */
+  char *buffer;
+} streaming_bucket_ctx_t;
+
 /* Fold all previously collected data in a single buffer allocated in
    RESULT_POOL and clear all intermediate state. */
 static const char *
@@ -86,7 +113,45 @@ request_body_stream_write(void *baton,
   if (!b->scratch_pool)
     b->scratch_pool = svn_pool_create(b->result_pool);
 
-  if (b->file)
+  if (b->streaming)
+    {
+      /* Data handed out to serf must stay where it is, so fill a fixed
+         buffer first and append everything else to the file. */
+      if (!b->file && *len + b->total_bytes <= b->in_memory_size)
+        {
+          if (!b->mem)
+            b->mem = apr_palloc(b->result_pool, b->in_memory_size);
+
+          memcpy(b->mem + b->total_bytes, data, *len);
+          b->total_bytes += *len;
+          b->mem_bytes = b->total_bytes;
+
+          return SVN_NO_ERROR;
+        }
+
+      if (!b->file)
+        {
+          SVN_ERR(svn_io_open_unique_file3(&b->file, NULL, NULL,
+                                           svn_io_file_del_on_pool_cleanup,
+                                           b->result_pool, b->scratch_pool));
+          b->file_at_end = TRUE;
+        }
+      else if (!b->file_at_end)
+        {
+          apr_off_t offset = 0;
+
+          SVN_ERR(svn_io_file_seek(b->file, APR_END, &offset,
+                                   b->scratch_pool));
+          b->file_at_end = TRUE;
+        }
+
+      SVN_ERR(svn_io_file_write_full(b->file, data, *len, NULL,
+                                     b->scratch_pool));
+      svn_pool_clear(b->scratch_pool);
+
+      b->total_bytes += *len;
+    }
+  else if (b->file)
     {
       SVN_ERR(svn_io_file_write_full(b->file, data, *len, NULL,
                                      b->scratch_pool));
@@ -137,7 +202,14 @@ request_body_stream_close(void *baton)
 {
   svn_ra_serf__request_body_t *b = baton;
 
-  if (b->file)
+  if (b->streaming)
+    {
+      if (b->file)
+        SVN_ERR(svn_io_file_flush(b->file, b->scratch_pool));
+
+      b->closed = TRUE;
+    }
+  else if (b->file)
     {
       /* We need to flush the file, make it unbuffered (so that it can be
        * zero-copied via mmap), and reset the position before attempting
@@ -161,6 +233,135 @@ request_body_stream_close(void *baton)
   return SVN_NO_ERROR;
 }
 
+/* Implements serf_bucket_t.read for streaming bodies.  Returns
+   APR_EAGAIN when all data written so far has been read but the body
+   has not been closed yet. */
+static apr_status_t
+streaming_bucket_read(serf_bucket_t *bucket,
+                      apr_size_t requested,
+                      const char **data,
+                      apr_size_t *len)
+{
+  streaming_bucket_ctx_t *ctx = bucket->data;
+  svn_ra_serf__request_body_t *b = ctx->body;
+  apr_size_t available = b->total_bytes - ctx->offset;
+
+  *data = NULL;
+  *len = 0;
+
+  if (available == 0)
+    return b->closed ? APR_EOF : APR_EAGAIN;
+
+  if (requested == SERF_READ_ALL_AVAIL || requested > available)
+    requested = available;
+
+  if (ctx->offset < b->mem_bytes)
+    {
+      *data = b->mem + ctx->offset;
+      *len = MIN(requested, b->mem_bytes - ctx->offset);
+    }
+  else
+    {
+      apr_off_t offset = ctx->offset - b->mem_bytes;
+      apr_status_t status;
+
+      /* The writer only flushes when the body gets closed, so make
+         everything written so far visible. */
+      if (b->file_at_end)
+        {
+          status = apr_file_flush(b->file);
+          if (status)
+            return status;
+        }
+
+      status = apr_file_seek(b->file, APR_SET, &offset);
+      if (status)
+        return status;
+      b->file_at_end = FALSE;
+
+      if (!ctx->buffer)
+        ctx->buffer = serf_bucket_mem_alloc(bucket->allocator,
+                                            STREAMING_READ_SIZE);
+
+      *len = MIN(requested, STREAMING_READ_SIZE);
+      status = apr_file_read(b->file, ctx->buffer, len);
+      if (status && !APR_STATUS_IS_EOF(status))
+        return status;
+
+      *data = ctx->buffer;
+    }
+
+  ctx->offset += *len;
+
+  return (b->closed && ctx->offset == b->total_bytes) ? APR_EOF
+                                                      : APR_SUCCESS;
+}
+
+#if !SERF_VERSION_AT_LEAST(1, 4, 0)
+/* Implements serf_bucket_t.readline for streaming bodies. */
+static apr_status_t
+streaming_bucket_readline(serf_bucket_t *bucket,
+                          int acceptable,
+                          int *found,
+                          const char **data,
+                          apr_size_t *len)
+{
+  /* Not implemented.  */
+  return APR_ENOTIMPL;
+}
+#endif
+
+/* Implements serf_bucket_t.peek for streaming bodies. */
+static apr_status_t
+streaming_bucket_peek(serf_bucket_t *bucket,
+                      const char **data,
+                      apr_size_t *len)
+{
+  streaming_bucket_ctx_t *ctx = bucket->data;
+  svn_ra_serf__request_body_t *b = ctx->body;
+
+  *data = NULL;
+  *len = 0;
+
+  if (ctx->offset == b->total_bytes)
+    return b->closed ? APR_EOF : APR_EAGAIN;
+
+  if (ctx->offset < b->mem_bytes)
+    {
+      *data = b->mem + ctx->offset;
+      *len = b->mem_bytes - ctx->offset;
+    }
+
+  return APR_SUCCESS;
+}
+
+/* Implements serf_bucket_t.destroy for streaming bodies. */
+static void
+streaming_bucket_destroy(serf_bucket_t *bucket)
+{
+  streaming_bucket_ctx_t *ctx = bucket->data;
+
+  if (ctx->buffer)
+    serf_bucket_mem_free(bucket->allocator, ctx->buffer);
+
+  serf_default_destroy_and_data(bucket);
+}
+
+static const serf_bucket_type_t streaming_bucket_vtable = {
+    "SVN-STREAMING-BODY",
+    streaming_bucket_read,
+#if SERF_VERSION_AT_LEAST(1, 4, 0)
+    serf_default_readline,
+#else
+    streaming_bucket_readline,
+#endif
+    serf_default_read_iovec,
+    serf_default_read_for_sendfile,
+    serf_default_read_bucket,
+    streaming_bucket_peek,
+    streaming_bucket_destroy,
+};
+
 /* Implements svn_ra_serf__request_body_delegate_t. */
 static svn_error_t *
 request_body_delegate(serf_bucket_t **body_bkt,
@@ -171,7 +372,19 @@ request_body_delegate(serf_bucket_t **body_bkt,
 {
   svn_ra_serf__request_body_t *b = baton;
 
-  if (b->file)
+  if (b->streaming)
+    {
+      /* Always start from the beginning, so that the body can be sent
+         again, e.g. after an authentication challenge. */
+      streaming_bucket_ctx_t *ctx = serf_bucket_mem_alloc(alloc,
+                                                          sizeof(*ctx));
+
+      ctx->body = b;
+      ctx->offset = 0;
+      ctx->buffer = NULL;
+      *body_bkt = serf_bucket_create(&streaming_bucket_vtable, alloc, ctx);
+    }
+  else if (b->file)
     {
       apr_off_t offset;
 
@@ -206,6 +419,18 @@ svn_ra_serf__request_body_create(apr_size_t in_memory_size,
   return body;
 }
 
+svn_ra_serf__request_body_t *
+svn_ra_serf__request_body_create_streaming(apr_size_t in_memory_size,
+                                           apr_pool_t *result_pool)
+{
+  svn_ra_serf__request_body_t *body
+    = svn_ra_serf__request_body_create(in_memory_size, result_pool);
+
+  body->streaming = TRUE;
+
+  return body;
+}
+
 svn_stream_t *
 svn_ra_serf__request_body_get_stream(svn_ra_serf__request_body_t *body)
 {
@@ -0,0 +1,289 @@
+/*
+ * revcache.c: On-disk cache of immutable revision resources.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_pools.h>
+#include <apr_time.h>
+
+#include "svn_hash.h"
+#include "svn_checksum.h"
+#include "svn_dirent_uri.h"
+#include "svn_io.h"
+#include "svn_types.h"
+#include "svn_pools.h"
+
+#include "private/svn_sorts_private.h"
+
+#include "revcache.h"
+
+/* Module-private structure used to hold the cache settings. */
+struct svn_ra_serf__revcache_t
+{
+  /* Directory holding one file per entry. */
+  const char *dirpath;
+
+  /* Maximum total size of the entries in bytes. */
+  apr_int64_t max_size;
+
+  /* Total size of the entries as far as we know, or -1 if we haven't
+   * looked at the directory yet.  Other processes may add entries as
+   * well, so this is only used to decide when to look again.
+   */
+  apr_int64_t size;
+};
+
+struct svn_ra_serf__revcache_entry_t
+{
+  svn_ra_serf__revcache_t *revcache;
+
+  /* Stream writing to TMP_PATH. */
+  svn_stream_t *stream;
+  const char *tmp_path;
+
+  /* Path of the entry once stored. */
+  const char *path;
+};
+
+/* Shrink the cache to this part of its maximum size when it is full,
+ * so that we don't have to scan the directory on every store. */
+#define SHRINK_PERCENTAGE 75
+
+/* Remove temporary files left behind by crashed processes after this
+ * time. */
+#define STALE_TMP_AGE apr_time_from_sec(24 * 60 * 60)
+
+/* Return the path of the file for entry KEY of repository UUID in
+ * REVCACHE, allocated in RESULT_POOL.
+ */
+static const char *
+entry_path(svn_ra_serf__revcache_t *revcache,
+           const char *uuid,
+           const char *key,
+           apr_pool_t *result_pool)
+{
+  const char *id = apr_pstrcat(result_pool, uuid, "\n", key, SVN_VA_NULL);
+  svn_checksum_t *checksum;
+
+  svn_error_clear(svn_checksum(&checksum, svn_checksum_sha1, id, strlen(id),
+                               result_pool));
+
+  return svn_dirent_join(revcache->dirpath,
+                         svn_checksum_to_cstring_display(checksum,
+                                                         result_pool),
+                         result_pool);
+}
+
+/* Sort items by the modification time of their svn_io_dirent2_t values,
+ * oldest first. */
+static int
+compare_mtime(const svn_sort__item_t *a,
+              const svn_sort__item_t *b)
+{
+  const svn_io_dirent2_t *dirent_a = a->value;
+  const svn_io_dirent2_t *dirent_b = b->value;
+
+  if (dirent_a->mtime == dirent_b->mtime)
+    return 0;
+
+  return dirent_a->mtime < dirent_b->mtime ? -1 : 1;
+}
+
+/* Remove the least recently used entries of REVCACHE until its total
+ * size is below SHRINK_PERCENTAGE of the maximum, and update
+ * REVCACHE->SIZE.
+ */
+static svn_error_t *
+shrink_cache(svn_ra_serf__revcache_t *revcache,
+             apr_pool_t *scratch_pool)
+{
+  apr_hash_t *dirents;
+  apr_array_header_t *sorted;
+  apr_int64_t limit = revcache->max_size / 100 * SHRINK_PERCENTAGE;
+  apr_int64_t size = 0;
+  apr_time_t now = apr_time_now();
+  apr_pool_t *iterpool;
+  int i;
+
+  SVN_ERR(svn_io_get_dirents3(&dirents, revcache->dirpath, FALSE,
+                              scratch_pool, scratch_pool));
+  sorted = svn_sort__hash(dirents, compare_mtime, scratch_pool);
+
+  for (i = 0; i < sorted->nelts; i++)
+    {
+      const svn_io_dirent2_t *dirent
+        = APR_ARRAY_IDX(sorted, i, svn_sort__item_t).value;
+
+      size += dirent->filesize;
+    }
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < sorted->nelts; i++)
+    {
+      const svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i,
+                                                    svn_sort__item_t);
+      const svn_io_dirent2_t *dirent = item->value;
+      svn_error_t *err;
+
+      if (dirent->kind != svn_node_file)
+        continue;
+
+      /* Entries that are still being written have a temporary name,
+         while the names of complete entries are plain checksums. */
+      if (strchr(item->key, '.'))
+        {
+          if (now - dirent->mtime < STALE_TMP_AGE)
+            continue;
+        }
+      else if (size <= limit)
+        continue;
+
+      svn_pool_clear(iterpool);
+
+      /* Another process may have removed the entry already, or may
+         still be reading it on a platform that doesn't allow removing
+         open files.  Either way it will go away eventually. */
+      err = svn_io_remove_file2(svn_dirent_join(revcache->dirpath,
+                                                item->key, iterpool),
+                                TRUE, iterpool);
+      if (err)
+        svn_error_clear(err);
+      else
+        size -= dirent->filesize;
+    }
+  svn_pool_destroy(iterpool);
+
+  revcache->size = size;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra_serf__revcache_create(svn_ra_serf__revcache_t **revcache_p,
+                             const char *dirpath,
+                             apr_int64_t max_size,
+                             apr_pool_t *pool)
+{
+  svn_ra_serf__revcache_t *revcache = apr_pcalloc(pool, sizeof(*revcache));
+
+  SVN_ERR(svn_io_make_dir_recursively(dirpath, pool));
+
+  revcache->dirpath = apr_pstrdup(pool, dirpath);
+  revcache->max_size = max_size;
+  revcache->size = -1;
+
+  *revcache_p = revcache;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra_serf__revcache_dup(svn_ra_serf__revcache_t **revcache_p,
+                          const svn_ra_serf__revcache_t *revcache,
+                          apr_pool_t *pool)
+{
+  svn_ra_serf__revcache_t *new_cache = apr_pmemdup(pool, revcache,
+                                                   sizeof(*revcache));
+
+  new_cache->dirpath = apr_pstrdup(pool, revcache->dirpath);
+
+  *revcache_p = new_cache;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra_serf__revcache_get(svn_stream_t **stream_p,
+                          svn_ra_serf__revcache_t *revcache,
+                          const char *uuid,
+                          const char *key,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
+{
+  const char *path = entry_path(revcache, uuid, key, scratch_pool);
+  svn_error_t *err;
+
+  err = svn_stream_open_readonly(stream_p, path, result_pool, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      *stream_p = NULL;
+
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  /* Mark the entry as recently used. */
+  svn_error_clear(svn_io_set_file_affected_time(apr_time_now(), path,
+                                                scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra_serf__revcache_put_begin(svn_ra_serf__revcache_entry_t **entry_p,
+                                svn_stream_t **stream_p,
+                                svn_ra_serf__revcache_t *revcache,
+                                const char *uuid,
+                                const char *key,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool)
+{
+  svn_ra_serf__revcache_entry_t *entry = apr_pcalloc(result_pool,
+                                                     sizeof(*entry));
+
+  entry->revcache = revcache;
+  entry->path = entry_path(revcache, uuid, key, result_pool);
+
+  /* Write to a temporary file in the same directory, so that the
+     complete entry can be moved in place atomically. */
+  SVN_ERR(svn_stream_open_unique(&entry->stream, &entry->tmp_path,
+                                 revcache->dirpath,
+                                 svn_io_file_del_on_pool_cleanup,
+                                 result_pool, scratch_pool));
+
+  *entry_p = entry;
+  *stream_p = entry->stream;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra_serf__revcache_put_end(svn_ra_serf__revcache_entry_t *entry,
+                              apr_pool_t *scratch_pool)
+{
+  svn_ra_serf__revcache_t *revcache = entry->revcache;
+  apr_finfo_t finfo;
+
+  SVN_ERR(svn_stream_close(entry->stream));
+  SVN_ERR(svn_io_stat(&finfo, entry->tmp_path, APR_FINFO_SIZE,
+                      scratch_pool));
+  SVN_ERR(svn_io_file_rename2(entry->tmp_path, entry->path, FALSE,
+                              scratch_pool));
+
+  if (revcache->size >= 0)
+    revcache->size += finfo.size;
+
+  if (revcache->size < 0 || revcache->size > revcache->max_size)
+    SVN_ERR(shrink_cache(revcache, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
@@ -0,0 +1,106 @@
+/*
+ * revcache.h: On-disk cache of immutable revision resources.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_RA_SERF_REVCACHE_H
+#define SVN_LIBSVN_RA_SERF_REVCACHE_H
+
+#include <apr_pools.h>
+
+#include "svn_types.h"
+#include "svn_io.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Revision resource cache. Resources addressing a path in a specific
+ * revision (e.g. '!svn/rvr/REV/PATH') never change, so their contents
+ * and properties can be kept on disk and shared by all sessions (and
+ * processes) configured to use the same cache directory.
+ *
+ * Entries are identified by the repository UUID and a KEY string that
+ * includes the resource URL.  The cache is bounded in size; the least
+ * recently used entries are removed first.
+ */
+typedef struct svn_ra_serf__revcache_t svn_ra_serf__revcache_t;
+
+/* An entry that is being written to the cache. */
+typedef struct svn_ra_serf__revcache_entry_t svn_ra_serf__revcache_entry_t;
+
+/* Creates new instance of revision cache storing up to MAX_SIZE bytes
+ * in files below DIRPATH, which is created if it doesn't exist yet.
+ * Sets REVCACHE_P with a pointer to new instance, allocated in POOL.
+ */
+svn_error_t *
+svn_ra_serf__revcache_create(svn_ra_serf__revcache_t **revcache_p,
+                             const char *dirpath,
+                             apr_int64_t max_size,
+                             apr_pool_t *pool);
+
+/* Sets *REVCACHE_P with a new instance, allocated in POOL, that uses
+ * the same directory and size limit as REVCACHE.
+ */
+svn_error_t *
+svn_ra_serf__revcache_dup(svn_ra_serf__revcache_t **revcache_p,
+                          const svn_ra_serf__revcache_t *revcache,
+                          apr_pool_t *pool);
+
+/* Sets *STREAM_P with a readable stream, allocated in RESULT_POOL, for
+ * the cached entry KEY of the repository UUID.  *STREAM_P will be NULL
+ * if the cache doesn't have such an entry.
+ */
+svn_error_t *
+svn_ra_serf__revcache_get(svn_stream_t **stream_p,
+                          svn_ra_serf__revcache_t *revcache,
+                          const char *uuid,
+                          const char *key,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool);
+
+/* Start writing the entry KEY of the repository UUID.  Sets *ENTRY_P
+ * with the new entry and *STREAM_P with a stream to write its data to,
+ * both allocated in RESULT_POOL.  The entry is only stored when
+ * svn_ra_serf__revcache_put_end() is called; otherwise the data is
+ * discarded when RESULT_POOL is cleared.
+ */
+svn_error_t *
+svn_ra_serf__revcache_put_begin(svn_ra_serf__revcache_entry_t **entry_p,
+                                svn_stream_t **stream_p,
+                                svn_ra_serf__revcache_t *revcache,
+                                const char *uuid,
+                                const char *key,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool);
+
+/* Close the stream of ENTRY and store it in the cache, removing the
+ * least recently used entries if the cache grows too big.
+ */
+svn_error_t *
+svn_ra_serf__revcache_put_end(svn_ra_serf__revcache_entry_t *entry,
+                              apr_pool_t *scratch_pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_RA_SERF_REVCACHE_H*/
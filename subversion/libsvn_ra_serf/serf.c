@@ -164,6 +164,8 @@ load_config(svn_ra_serf__session_t *session,
   const char *exceptions;
   apr_port_t proxy_port;
   svn_tristate_t chunked_requests;
+  const char *cache_dir;
+  apr_int64_t cache_size;
 #if SERF_VERSION_AT_LEAST(1, 4, 0) && !defined(SVN_SERF_NO_LOGGING)
   apr_int64_t log_components;
   apr_int64_t log_level;
@@ -250,6 +252,19 @@ load_config(svn_ra_serf__session_t *session,
                                   SVN_CONFIG_OPTION_HTTP_CHUNKED_REQUESTS,
                                   "auto", svn_tristate_unknown));
 
+  /* Should we offer http/2 to the server. */
+  SVN_ERR(svn_config_get_bool(config, &session->enable_http2,
+                              SVN_CONFIG_SECTION_GLOBAL,
+                              SVN_CONFIG_OPTION_HTTP_HTTP2, FALSE));
+
+  /* Where and how much to cache of past revisions. */
+  svn_config_get(config, &cache_dir, SVN_CONFIG_SECTION_GLOBAL,
+                 SVN_CONFIG_OPTION_HTTP_CACHE_DIRECTORY, NULL);
+  SVN_ERR(svn_config_get_int64(config, &cache_size,
+                               SVN_CONFIG_SECTION_GLOBAL,
+                               SVN_CONFIG_OPTION_HTTP_CACHE_SIZE,
+                               SVN_CONFIG_DEFAULT_OPTION_HTTP_CACHE_SIZE));
+
 #if SERF_VERSION_AT_LEAST(1, 4, 0) && !defined(SVN_SERF_NO_LOGGING)
   SVN_ERR(svn_config_get_int64(config, &log_components,
                                SVN_CONFIG_SECTION_GLOBAL,
@@ -317,6 +332,20 @@ load_config(svn_ra_serf__session_t *session,
                                       SVN_CONFIG_OPTION_HTTP_CHUNKED_REQUESTS,
                                       "auto", chunked_requests));
 
+      /* Should we offer http/2 to the server. */
+      SVN_ERR(svn_config_get_bool(config, &session->enable_http2,
+                                  server_group,
+                                  SVN_CONFIG_OPTION_HTTP_HTTP2,
+                                  session->enable_http2));
+
+      /* Load the group cache settings. */
+      svn_config_get(config, &cache_dir, server_group,
+                     SVN_CONFIG_OPTION_HTTP_CACHE_DIRECTORY, cache_dir);
+      SVN_ERR(svn_config_get_int64(config, &cache_size,
+                                   server_group,
+                                   SVN_CONFIG_OPTION_HTTP_CACHE_SIZE,
+                                   cache_size));
+
 #if SERF_VERSION_AT_LEAST(1, 4, 0) && !defined(SVN_SERF_NO_LOGGING)
       SVN_ERR(svn_config_get_int64(config, &log_components,
                                    server_group,
@@ -356,6 +385,24 @@ load_config(svn_ra_serf__session_t *session,
   if (session->max_connections < 2)
     session->max_connections = 2;
 
+  /* The cache is an optimization, so don't fail the session if it
+     can't be used. */
+  if (cache_dir && *cache_dir && cache_size > 0)
+    {
+      svn_error_t *err;
+
+      err = svn_ra_serf__revcache_create(&session->revcache,
+                                         svn_dirent_internal_style(
+                                                cache_dir, scratch_pool),
+                                         cache_size * 1024 * 1024,
+                                         result_pool);
+      if (err)
+        {
+          svn_error_clear(err);
+          session->revcache = NULL;
+        }
+    }
+
   /* Parse the connection timeout value, if any. */
   session->timeout = apr_time_from_sec(DEFAULT_HTTP_TIMEOUT);
   if (timeout_str)
@@ -558,6 +605,9 @@ svn_ra_serf__open(svn_ra_session_t *session,
   else
     serf_sess->useragent = get_user_agent_string(result_pool);
 
+  if (callbacks->trace_id)
+    serf_sess->trace_id = apr_pstrdup(result_pool, callbacks->trace_id);
+
   /* go ahead and tell serf about the connection. */
   status =
     serf_connection_create2(&serf_sess->conns[0]->conn,
@@ -638,12 +688,16 @@ ra_serf_dup_session(svn_ra_session_t *new_session,
   /* using_compression */
   /* http10 */
   /* http20 */
+  /* enable_http2 */
   /* using_chunked_requests */
   /* detect_chunking */
 
   if (new_sess->useragent)
     new_sess->useragent = apr_pstrdup(result_pool, new_sess->useragent);
 
+  if (new_sess->trace_id)
+    new_sess->trace_id = apr_pstrdup(result_pool, new_sess->trace_id);
+
   if (new_sess->vcc_url)
     new_sess->vcc_url = apr_pstrdup(result_pool, new_sess->vcc_url);
 
@@ -730,6 +784,14 @@ ra_serf_dup_session(svn_ra_session_t *new_session,
   SVN_ERR(svn_ra_serf__blncache_create(&new_sess->blncache,
                                        new_sess->pool));
 
+  if (new_sess->revcache)
+    SVN_ERR(svn_ra_serf__revcache_dup(&new_sess->revcache,
+                                      new_sess->revcache, result_pool));
+
+  /* The dirent cache lives in the pool of the original session. */
+  new_sess->dirent_cache = NULL;
+  new_sess->dirent_cache_pool = NULL;
+
   if (new_sess->server_allows_bulk)
     new_sess->server_allows_bulk = apr_pstrdup(result_pool,
                                                new_sess->server_allows_bulk);
@@ -752,6 +814,7 @@ ra_serf_dup_session(svn_ra_session_t *new_session,
   /* svn_boolean_t supports_inline_props */
   /* supports_rev_rsrc_replay */
   /* supports_svndiff1 */
+  /* supports_svndiff2 */
 
   new_sess->context = serf_context_create(result_pool);
 
@@ -1056,6 +1119,8 @@ static const svn_ra__vtable_t serf_vtable = {
   svn_ra_serf__get_inherited_props,
   NULL /* set_svn_ra_open */,
   NULL /* svn_ra_list */,
+  NULL /* svn_ra_blame */,
+  NULL /* svn_ra_stat_many */,
   svn_ra_serf__register_editor_shim_callbacks,
   NULL /* commit_ev2 */,
   NULL /* replay_range_ev2 */
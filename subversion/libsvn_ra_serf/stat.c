@@ -47,6 +47,63 @@
 #include "ra_serf.h"
 
 
+/* The dirent fields filled in by svn_ra_serf__stat().  Listings that
+   include all of these can answer later stat calls on their children. */
+#define STAT_DIRENT_FIELDS (SVN_DIRENT_KIND | SVN_DIRENT_SIZE \
+                            | SVN_DIRENT_HAS_PROPS | SVN_DIRENT_CREATED_REV \
+                            | SVN_DIRENT_TIME | SVN_DIRENT_LAST_AUTHOR)
+
+/* Don't keep more than this many dirents in the session's dirent cache. */
+#define MAX_CACHED_DIRENTS 16384
+
+/* Return the dirent cached for STABLE_URL in SESSION, or NULL. */
+static const svn_dirent_t *
+get_cached_dirent(svn_ra_serf__session_t *session,
+                  const char *stable_url)
+{
+  if (! session->dirent_cache)
+    return NULL;
+
+  return svn_hash_gets(session->dirent_cache, stable_url);
+}
+
+/* Remember DIRENTS (mapping names to svn_dirent_t *), the children of
+   the directory at STABLE_URL, in the dirent cache of SESSION. */
+static void
+cache_dirents(svn_ra_serf__session_t *session,
+              const char *stable_url,
+              apr_hash_t *dirents)
+{
+  apr_hash_index_t *hi;
+  unsigned int count = apr_hash_count(dirents);
+
+  if (count > MAX_CACHED_DIRENTS)
+    return;
+
+  if (! session->dirent_cache_pool)
+    session->dirent_cache_pool = svn_pool_create(session->pool);
+  else if (apr_hash_count(session->dirent_cache) + count > MAX_CACHED_DIRENTS)
+    {
+      /* Just start over; listings are usually walked in order, so the
+         most recent one is the most interesting. */
+      svn_pool_clear(session->dirent_cache_pool);
+      session->dirent_cache = NULL;
+    }
+
+  if (! session->dirent_cache)
+    session->dirent_cache = apr_hash_make(session->dirent_cache_pool);
+
+  for (hi = apr_hash_first(NULL, dirents); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = apr_hash_this_key(hi);
+      const svn_dirent_t *dirent = apr_hash_this_val(hi);
+
+      svn_hash_sets(session->dirent_cache,
+                    svn_path_url_add_component2(stable_url, name,
+                                                session->dirent_cache_pool),
+                    svn_dirent_dup(dirent, session->dirent_cache_pool));
+    }
+}
 
 /* Implements svn_ra__vtable_t.check_path(). */
 svn_error_t *
@@ -71,10 +128,19 @@ svn_ra_serf__check_path(svn_ra_session_t *ra_session,
      specific revision (rather than floating with HEAD).  */
   if (SVN_IS_VALID_REVNUM(revision))
     {
+      const svn_dirent_t *cached;
+
       SVN_ERR(svn_ra_serf__get_stable_url(&url, NULL /* latest_revnum */,
                                           session,
                                           url, revision,
                                           scratch_pool, scratch_pool));
+
+      cached = get_cached_dirent(session, url);
+      if (cached)
+        {
+          *kind = cached->kind;
+          return SVN_NO_ERROR;
+        }
     }
 
   /* URL is stable, so we use SVN_INVALID_REVNUM since it is now irrelevant.
@@ -307,10 +373,20 @@ svn_ra_serf__stat(svn_ra_session_t *ra_session,
      specific revision (rather than floating with HEAD).  */
   if (SVN_IS_VALID_REVNUM(revision))
     {
+      const svn_dirent_t *cached;
+
       SVN_ERR(svn_ra_serf__get_stable_url(&url, NULL /* latest_revnum */,
                                           session,
                                           url, revision,
                                           pool, pool));
+
+      /* A listing of the parent may have told us already. */
+      cached = get_cached_dirent(session, url);
+      if (cached)
+        {
+          *dirent = svn_dirent_dup(cached, pool);
+          return SVN_NO_ERROR;
+        }
     }
 
   fdb.entry = svn_dirent_create(pool);
@@ -475,6 +551,7 @@ svn_ra_serf__get_dir(svn_ra_session_t *ra_session,
   svn_ra_serf__handler_t *props_handler = NULL;
   const char *path;
   struct get_dir_baton_t gdb;
+  svn_boolean_t stable = FALSE;
   svn_error_t *err = SVN_NO_ERROR;
 
   gdb.result_pool = result_pool;
@@ -499,6 +576,7 @@ svn_ra_serf__get_dir(svn_ra_session_t *ra_session,
                                           path, revision,
                                           scratch_pool, scratch_pool));
       revision = SVN_INVALID_REVNUM;
+      stable = TRUE;
     }
   /* REVISION is always SVN_INVALID_REVNUM  */
   SVN_ERR_ASSERT(!SVN_IS_VALID_REVNUM(revision));
@@ -600,6 +678,12 @@ svn_ra_serf__get_dir(svn_ra_session_t *ra_session,
   if (!err && gdb.supports_deadprop_count != svn_tristate_unknown)
     session->supports_deadprop_count = gdb.supports_deadprop_count;
 
+  /* The children of a stable URL don't change, so keep their dirents
+     for later stat and check_path calls when we have all the fields. */
+  if (!err && stable && dirents && gdb.is_directory
+      && (dirent_fields & STAT_DIRENT_FIELDS) == STAT_DIRENT_FIELDS)
+    cache_dirents(session, path, gdb.dirents);
+
   svn_pool_destroy(scratch_pool); /* Unregisters outstanding requests */
 
   SVN_ERR(err);
@@ -45,6 +45,7 @@
 #include "private/svn_dep_compat.h"
 #include "private/svn_fspath.h"
 #include "private/svn_string_private.h"
+#include "private/svn_debug.h"
 
 #include "ra_serf.h"
 #include "../libsvn_ra/ra_loader.h"
@@ -255,11 +256,41 @@ static const svn_ra_serf__xml_transition_t update_ttable[] = {
 #define REQUEST_COUNT_TO_PAUSE 50
 #define REQUEST_COUNT_TO_RESUME 40
 
+/* With http/2 all requests are multiplexed over a single connection, so
+   there is no connection to keep busy and we may keep many more requests
+   in flight.  Servers commonly allow 100 concurrent streams. */
+#define REQUEST_COUNT_TO_RESUME_HTTP2 100
+
+/* The numbers above are only the initial values of the request window.
+   While fetching, update_request_window() measures the round trip time
+   of GET requests and the rate at which requests complete.  Similar to
+   TCP BBR, it then sets the window to twice the estimated number of
+   requests "in flight" (maximum completion rate times minimum round
+   trip), within these bounds.  It also stops opening new connections
+   once an additional connection did not improve the completion rate.
+
+   A step is taken every WINDOW_PERIOD_REQUESTS completed requests, but
+   no more often than WINDOW_PERIOD_MIN. */
+#define REQUEST_WINDOW_MIN 8
+#define REQUEST_WINDOW_MAX 400
+#define WINDOW_PERIOD_REQUESTS 32
+#define WINDOW_PERIOD_MIN apr_time_from_msec(100)
+
+/* Define to report the decisions of update_request_window() through
+   SVN_DBG in debug builds. */
+/* #define SVN_RA_SERF__DEBUG_WINDOW */
+
 #define SPILLBUF_BLOCKSIZE 4096
 #define SPILLBUF_MAXBUFFSIZE 131072
 
 #define PARSE_CHUNK_SIZE 8000 /* Copied from xml.c ### Needs tuning */
 
+/* When the server accepts chunked requests, the REPORT request is sent
+   as soon as this much of its body has been written, and the rest of the
+   body follows in pieces of this size while the caller is still crawling
+   the working copy. */
+#define REPORT_BODY_SEND_SIZE (64 * 1024)
+
 /* Forward-declare our report context. */
 typedef struct report_context_t report_context_t;
 typedef struct body_create_baton_t body_create_baton_t;
@@ -388,6 +419,9 @@ typedef struct fetch_ctx_t {
   /* The base-rev header  */
   const char *delta_base;
 
+  /* When the GET request was created. */
+  apr_time_t start_time;
+
 } fetch_ctx_t;
 
 /*
@@ -439,12 +473,38 @@ struct report_context_t {
   /* Buffer holding request body for the REPORT (can spill to disk). */
   svn_ra_serf__request_body_t *body;
 
+  /* Can the body be sent while it is being written?  If so, the number
+     of bytes written since serf last got a chance to send them and the
+     REPORT request, once it has been started. */
+  svn_boolean_t stream_body;
+  apr_size_t unsent_bytes;
+  svn_ra_serf__handler_t *report_handler;
+
   /* number of pending GET requests */
   unsigned int num_active_fetches;
 
   /* number of pending PROPFIND requests */
   unsigned int num_active_propfinds;
 
+  /* Resume parsing the REPORT below this many pending requests. */
+  unsigned int request_window;
+
+  /* Measurements of the current period of update_request_window(): its
+     start, the number of requests completed and the minimum round trip
+     time of a GET request (0 if none yet). */
+  apr_time_t period_start;
+  unsigned int period_completed;
+  apr_interval_time_t min_rtt;
+
+  /* Decaying maximum of the completion rate (requests per second), the
+     rate of the previous period and the number of connections then. */
+  double max_rate;
+  double last_rate;
+  int last_num_conns;
+
+  /* Set once an additional connection did not pay off. */
+  svn_boolean_t conns_saturated;
+
   /* Are we done parsing the REPORT response? */
   svn_boolean_t done;
 
@@ -544,6 +604,70 @@ create_file_baton(file_baton_t **new_file,
   return SVN_NO_ERROR;
 }
 
+/* Account for a completed GET or PROPFIND request of CTX.  RTT is the
+   round trip time of a GET request or 0 for other requests.  At the end
+   of a measurement period, adjust the request window and decide whether
+   further connections are worth opening. */
+static void
+update_request_window(report_context_t *ctx,
+                      apr_interval_time_t rtt)
+{
+  apr_time_t now;
+  apr_interval_time_t elapsed;
+  double rate;
+
+  if (rtt > 0 && (ctx->min_rtt == 0 || rtt < ctx->min_rtt))
+    ctx->min_rtt = rtt;
+
+  if (++ctx->period_completed < WINDOW_PERIOD_REQUESTS)
+    return;
+
+  now = apr_time_now();
+  elapsed = now - ctx->period_start;
+  if (elapsed < WINDOW_PERIOD_MIN)
+    return;
+
+  /* Completion rate of this period and its decaying maximum, our
+     estimate of the bottleneck bandwidth. */
+  rate = ctx->period_completed * (double)APR_USEC_PER_SEC / elapsed;
+  ctx->max_rate = ctx->max_rate * 7 / 8;
+  if (rate > ctx->max_rate)
+    ctx->max_rate = rate;
+
+  /* Keep twice the bandwidth-delay product in flight. */
+  if (ctx->min_rtt > 0)
+    {
+      double bdp = ctx->max_rate * ctx->min_rtt / APR_USEC_PER_SEC;
+      double window = 2 * bdp;
+
+      if (window < REQUEST_WINDOW_MIN)
+        window = REQUEST_WINDOW_MIN;
+      else if (window > REQUEST_WINDOW_MAX)
+        window = REQUEST_WINDOW_MAX;
+
+      ctx->request_window = (unsigned int)window;
+    }
+
+  /* Did the connection opened during the last period pay off? */
+  if (ctx->last_num_conns && ctx->sess->num_conns > ctx->last_num_conns
+      && rate < ctx->last_rate * 1.1)
+    ctx->conns_saturated = TRUE;
+
+#if defined(SVN_DEBUG) && defined(SVN_RA_SERF__DEBUG_WINDOW)
+  SVN_DBG(("update window: %.1f req/s (max %.1f), min rtt %" APR_TIME_T_FMT
+           "us, window %u, %d conns%s\n",
+           rate, ctx->max_rate, ctx->min_rtt, ctx->request_window,
+           ctx->sess->num_conns,
+           ctx->conns_saturated ? " (saturated)" : ""));
+#endif
+
+  ctx->last_rate = rate;
+  ctx->last_num_conns = ctx->sess->num_conns;
+  ctx->period_start = now;
+  ctx->period_completed = 0;
+  ctx->min_rtt = 0;
+}
+
 /** Minimum nr. of outstanding requests needed before a new connection is
  *  opened. */
 #define REQS_PER_CONN 8
@@ -559,28 +683,7 @@ open_connection_if_needed(svn_ra_serf__session_t *sess, int num_active_reqs)
    * a minimum of 1 extra connection. */
   if (sess->num_conns == 1 ||
       ((num_active_reqs / REQS_PER_CONN) > sess->num_conns))
-    {
-      int cur = sess->num_conns;
-      apr_status_t status;
-
-      sess->conns[cur] = apr_pcalloc(sess->pool, sizeof(*sess->conns[cur]));
-      sess->conns[cur]->bkt_alloc = serf_bucket_allocator_create(sess->pool,
-                                                                 NULL, NULL);
-      sess->conns[cur]->last_status_code = -1;
-      sess->conns[cur]->session = sess;
-      status = serf_connection_create2(&sess->conns[cur]->conn,
-                                       sess->context,
-                                       sess->session_url,
-                                       svn_ra_serf__conn_setup,
-                                       sess->conns[cur],
-                                       svn_ra_serf__conn_closed,
-                                       sess->conns[cur],
-                                       sess->pool);
-      if (status)
-        return svn_ra_serf__wrap_err(status, NULL);
-
-      sess->num_conns++;
-    }
+    SVN_ERR(svn_ra_serf__open_connection(sess));
 
   return SVN_NO_ERROR;
 }
@@ -592,6 +695,10 @@ get_best_connection(report_context_t *ctx)
   svn_ra_serf__connection_t *conn;
   int first_conn = 1;
 
+  /* With http/2 the REPORT response doesn't block the connection. */
+  if (ctx->sess->http20)
+    return ctx->sess->conns[0];
+
   /* Skip the first connection if the REPORT response hasn't been completely
      received yet or if we're being told to limit our connections to
      2 (because this could be an attempt to ensure that we do all our
@@ -797,17 +904,9 @@ headers_fetch(serf_bucket_t *headers,
     {
       serf_bucket_headers_setn(headers, SVN_DAV_DELTA_BASE_HEADER,
                                fetch_ctx->delta_base);
-      if (fetch_ctx->using_compression)
-        {
-          serf_bucket_headers_setn(headers, "Accept-Encoding",
-                                   "svndiff1;q=0.9,svndiff;q=0.8");
-        }
-      else
-        {
-          /* Do not advertise svndiff1 support if we're not interested in
-             compression. */
-          serf_bucket_headers_setn(headers, "Accept-Encoding", "svndiff");
-        }
+      serf_bucket_headers_setn(headers, "Accept-Encoding",
+                               svn_ra_serf__svndiff_accept_encoding(
+                                        fetch_ctx->using_compression, FALSE));
     }
   else if (fetch_ctx->using_compression)
     {
@@ -1168,6 +1267,7 @@ file_props_done(serf_request_t *request,
     return svn_error_trace(svn_ra_serf__unexpected_status(handler));
 
   file->parent_dir->ctx->num_active_propfinds--;
+  update_request_window(file->parent_dir->ctx, 0);
 
   file->fetch_props = FALSE;
 
@@ -1200,6 +1300,8 @@ file_fetch_done(serf_request_t *request,
     return svn_error_trace(svn_ra_serf__unexpected_status(handler));
 
   file->parent_dir->ctx->num_active_fetches--;
+  update_request_window(file->parent_dir->ctx,
+                        apr_time_now() - fetch_ctx->start_time);
 
   file->fetch_file = FALSE;
 
@@ -1225,8 +1327,10 @@ fetch_for_file(file_baton_t *file,
   svn_ra_serf__connection_t *conn;
   svn_ra_serf__handler_t *handler;
 
-  /* Open extra connections if we have enough requests to send. */
-  if (ctx->sess->num_conns < ctx->sess->max_connections)
+  /* Open extra connections if we have enough requests to send and they
+     did help so far.  Http/2 multiplexes all requests over the first one. */
+  if (!ctx->sess->http20 && !ctx->conns_saturated
+      && ctx->sess->num_conns < ctx->sess->max_connections)
     SVN_ERR(open_connection_if_needed(ctx->sess, ctx->num_active_fetches +
                                                  ctx->num_active_propfinds));
 
@@ -1356,6 +1460,7 @@ fetch_for_file(file_baton_t *file,
           handler->done_delegate_baton = fetch_ctx;
 
           fetch_ctx->handler = handler;
+          fetch_ctx->start_time = apr_time_now();
 
           svn_ra_serf__request_create(handler);
 
@@ -1434,6 +1539,7 @@ dir_props_done(serf_request_t *request,
     return svn_error_trace(svn_ra_serf__unexpected_status(handler));
 
   dir->ctx->num_active_propfinds--;
+  update_request_window(dir->ctx, 0);
 
   /* Closing the directory will automatically deliver the propfind props.
    *
@@ -1453,8 +1559,10 @@ fetch_for_dir(dir_baton_t *dir,
   report_context_t *ctx = dir->ctx;
   svn_ra_serf__connection_t *conn;
 
-  /* Open extra connections if we have enough requests to send. */
-  if (ctx->sess->num_conns < ctx->sess->max_connections)
+  /* Open extra connections if we have enough requests to send and they
+     did help so far.  Http/2 multiplexes all requests over the first one. */
+  if (!ctx->sess->http20 && !ctx->conns_saturated
+      && ctx->sess->num_conns < ctx->sess->max_connections)
     SVN_ERR(open_connection_if_needed(ctx->sess, ctx->num_active_fetches +
                                                  ctx->num_active_propfinds));
 
@@ -2068,6 +2176,99 @@ make_simple_xml_tag(svn_stringbuf_t **buf_p,
   svn_xml_make_close_tag(buf_p, pool, tagname);
 }
 
+/* Serf callback to setup update request headers. */
+static svn_error_t *
+setup_update_report_headers(serf_bucket_t *headers,
+                            void *baton,
+                            apr_pool_t *pool /* request pool */,
+                            apr_pool_t *scratch_pool)
+{
+  report_context_t *report = baton;
+
+  serf_bucket_headers_setn(headers, "Accept-Encoding",
+                           svn_ra_serf__svndiff_accept_encoding(
+                                    report->sess->using_compression,
+                                    report->sess->using_compression));
+
+  return SVN_NO_ERROR;
+}
+
+/* Create the handler for the REPORT request of REPORT in RESULT_POOL and
+   schedule it. */
+static svn_error_t *
+start_report_request(svn_ra_serf__handler_t **handler_p,
+                     report_context_t *report,
+                     apr_pool_t *result_pool)
+{
+  svn_ra_serf__handler_t *handler;
+  svn_ra_serf__xml_context_t *xmlctx;
+  const char *report_target;
+
+  SVN_ERR(svn_ra_serf__report_resource(&report_target, report->sess,
+                                       result_pool));
+
+  xmlctx = svn_ra_serf__xml_context_create(update_ttable,
+                                           update_opened, update_closed,
+                                           update_cdata,
+                                           report,
+                                           result_pool);
+  handler = svn_ra_serf__create_expat_handler(report->sess, xmlctx, NULL,
+                                              result_pool);
+
+  svn_ra_serf__request_body_get_delegate(&handler->body_delegate,
+                                         &handler->body_delegate_baton,
+                                         report->body);
+  handler->method = "REPORT";
+  handler->path = report_target;
+  handler->body_type = "text/xml";
+  handler->custom_accept_encoding = TRUE;
+  handler->header_delegate = setup_update_report_headers;
+  handler->header_delegate_baton = report;
+
+  svn_ra_serf__request_create(handler);
+
+  *handler_p = handler;
+  return SVN_NO_ERROR;
+}
+
+/* Append BUF to the body of REPORT.  If the body can be streamed and
+   enough of it has been written, start the REPORT request if necessary
+   and let serf send what it can without waiting. */
+static svn_error_t *
+write_report_body(report_context_t *report,
+                  svn_stringbuf_t *buf,
+                  apr_pool_t *scratch_pool)
+{
+  svn_ra_serf__session_t *sess = report->sess;
+  apr_status_t status;
+  svn_error_t *err;
+
+  SVN_ERR(svn_stream_write(report->body_template, buf->data, &buf->len));
+
+  if (!report->stream_body)
+    return SVN_NO_ERROR;
+
+  report->unsent_bytes += buf->len;
+  if (report->unsent_bytes < REPORT_BODY_SEND_SIZE)
+    return SVN_NO_ERROR;
+  report->unsent_bytes = 0;
+
+  if (!report->report_handler)
+    SVN_ERR(start_report_request(&report->report_handler, report,
+                                 report->pool));
+
+  status = serf_context_run(sess->context, 0, scratch_pool);
+
+  err = sess->pending_error;
+  sess->pending_error = SVN_NO_ERROR;
+  SVN_ERR(err);
+
+  if (status && !APR_STATUS_IS_TIMEUP(status))
+    return svn_ra_serf__wrap_err(status, _("Error running context"));
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 set_path(void *report_baton,
          const char *path,
@@ -2089,7 +2290,7 @@ set_path(void *report_baton,
   svn_xml_escape_cdata_cstring(&buf, path, pool);
   svn_xml_make_close_tag(&buf, pool, "S:entry");
 
-  SVN_ERR(svn_stream_write(report->body_template, buf->data, &buf->len));
+  SVN_ERR(write_report_body(report, buf, pool));
 
   return SVN_NO_ERROR;
 }
@@ -2104,7 +2305,7 @@ delete_path(void *report_baton,
 
   make_simple_xml_tag(&buf, "S:missing", path, pool);
 
-  SVN_ERR(svn_stream_write(report->body_template, buf->data, &buf->len));
+  SVN_ERR(write_report_body(report, buf, pool));
 
   return SVN_NO_ERROR;
 }
@@ -2151,7 +2352,7 @@ link_path(void *report_baton,
   svn_xml_escape_cdata_cstring(&buf, path, pool);
   svn_xml_make_close_tag(&buf, pool, "S:entry");
 
-  SVN_ERR(svn_stream_write(report->body_template, buf->data, &buf->len));
+  SVN_ERR(write_report_body(report, buf, pool));
 
   /* Store the switch roots to allow generating repos_relpaths from just
      the working copy paths. (Needed for HTTPv2) */
@@ -2169,30 +2370,6 @@ link_path(void *report_baton,
   return APR_SUCCESS;
 }
 
-/* Serf callback to setup update request headers. */
-static svn_error_t *
-setup_update_report_headers(serf_bucket_t *headers,
-                            void *baton,
-                            apr_pool_t *pool /* request pool */,
-                            apr_pool_t *scratch_pool)
-{
-  report_context_t *report = baton;
-
-  if (report->sess->using_compression)
-    {
-      serf_bucket_headers_setn(headers, "Accept-Encoding",
-                               "gzip,svndiff1;q=0.9,svndiff;q=0.8");
-    }
-  else
-    {
-      /* Do not advertise svndiff1 support if we're not interested in
-         compression. */
-      serf_bucket_headers_setn(headers, "Accept-Encoding", "svndiff");
-    }
-
-  return SVN_NO_ERROR;
-}
-
 /* Baton for update_delay_handler */
 typedef struct update_delay_baton_t
 {
@@ -2202,6 +2379,14 @@ typedef struct update_delay_baton_t
   void *inner_handler_baton;
 } update_delay_baton_t;
 
+/* Return the number of outstanding requests in REPORT below which we
+   continue parsing the update report. */
+static unsigned int
+request_count_to_resume(report_context_t *report)
+{
+  return report->request_window;
+}
+
 /* Helper for update_delay_handler() and process_pending() to
    call UDB->INNER_HANDLER with buffer pointed by DATA. */
 static svn_error_t *
@@ -2271,7 +2456,7 @@ update_delay_handler(serf_request_t *request,
         }
 
       while ((udb->report->num_active_fetches + udb->report->num_active_propfinds)
-                 < REQUEST_COUNT_TO_RESUME)
+                 < request_count_to_resume(udb->report))
         {
           const char *data;
           apr_size_t len;
@@ -2355,7 +2540,7 @@ process_pending(update_delay_baton_t *udb,
   serf_bucket_alloc_t *alloc = NULL;
 
   while ((udb->report->num_active_fetches + udb->report->num_active_propfinds)
-            < REQUEST_COUNT_TO_RESUME)
+            < request_count_to_resume(udb->report))
     {
       const char *data;
       apr_size_t len;
@@ -2487,10 +2672,7 @@ finish_report(void *report_baton,
               apr_pool_t *pool)
 {
   report_context_t *report = report_baton;
-  svn_ra_serf__session_t *sess = report->sess;
   svn_ra_serf__handler_t *handler;
-  svn_ra_serf__xml_context_t *xmlctx;
-  const char *report_target;
   svn_stringbuf_t *buf = NULL;
   apr_pool_t *scratch_pool = svn_pool_create(pool);
   svn_error_t *err;
@@ -2499,27 +2681,12 @@ finish_report(void *report_baton,
   SVN_ERR(svn_stream_write(report->body_template, buf->data, &buf->len));
   SVN_ERR(svn_stream_close(report->body_template));
 
-  SVN_ERR(svn_ra_serf__report_resource(&report_target, sess,  scratch_pool));
-
-  xmlctx = svn_ra_serf__xml_context_create(update_ttable,
-                                           update_opened, update_closed,
-                                           update_cdata,
-                                           report,
-                                           scratch_pool);
-  handler = svn_ra_serf__create_expat_handler(sess, xmlctx, NULL,
-                                              scratch_pool);
-
-  svn_ra_serf__request_body_get_delegate(&handler->body_delegate,
-                                         &handler->body_delegate_baton,
-                                         report->body);
-  handler->method = "REPORT";
-  handler->path = report_target;
-  handler->body_type = "text/xml";
-  handler->custom_accept_encoding = TRUE;
-  handler->header_delegate = setup_update_report_headers;
-  handler->header_delegate_baton = report;
-
-  svn_ra_serf__request_create(handler);
+  /* The request may already be on its way, waiting for the rest of its
+     body. */
+  if (report->report_handler)
+    handler = report->report_handler;
+  else
+    SVN_ERR(start_report_request(&handler, report, scratch_pool));
 
   err = process_editor_report(report, handler, scratch_pool);
 
@@ -2543,11 +2710,15 @@ static svn_error_t *
 abort_report(void *report_baton,
              apr_pool_t *pool)
 {
-#if 0
   report_context_t *report = report_baton;
-#endif
 
-  /* Should we perform some cleanup here? */
+  /* A REPORT request that was started early would wait forever for the
+     rest of its body. */
+  if (report->report_handler)
+    {
+      svn_ra_serf__unschedule_handler(report->report_handler);
+      report->report_handler = NULL;
+    }
 
   return SVN_NO_ERROR;
 }
@@ -2616,6 +2787,9 @@ make_update_reporter(svn_ra_session_t *ra_session,
   report->send_copyfrom_args = send_copyfrom_args;
   report->text_deltas = text_deltas;
   report->switched_paths = apr_hash_make(report->pool);
+  report->request_window = sess->http20 ? REQUEST_COUNT_TO_RESUME_HTTP2
+                                        : REQUEST_COUNT_TO_RESUME;
+  report->period_start = apr_time_now();
 
   report->source = src_path;
   report->destination = dest_path;
@@ -2628,9 +2802,19 @@ make_update_reporter(svn_ra_session_t *ra_session,
   *reporter = &ra_serf_reporter;
   *report_baton = report;
 
-  report->body =
-    svn_ra_serf__request_body_create(SVN_RA_SERF__REQUEST_BODY_IN_MEM_SIZE,
-                                     report->pool);
+  /* An incomplete body can only be sent with chunked encoding, so only
+     stream it to servers known to accept that. */
+  report->stream_body = (sess->using_chunked_requests
+                         && !sess->detect_chunking
+                         && !sess->http10);
+  if (report->stream_body)
+    report->body = svn_ra_serf__request_body_create_streaming(
+                            SVN_RA_SERF__REQUEST_BODY_IN_MEM_SIZE,
+                            report->pool);
+  else
+    report->body =
+      svn_ra_serf__request_body_create(SVN_RA_SERF__REQUEST_BODY_IN_MEM_SIZE,
+                                       report->pool);
   report->body_template = svn_ra_serf__request_body_get_stream(report->body);
 
   if (sess->bulk_updates == svn_tristate_true)
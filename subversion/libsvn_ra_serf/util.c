@@ -480,7 +480,7 @@ load_authorities(svn_ra_serf__connection_t *conn, const char *authorities,
   return SVN_NO_ERROR;
 }
 
-#if SERF_VERSION_AT_LEAST(1, 4, 0) && defined(SVN__SERF_TEST_HTTP2)
+#if SERF_VERSION_AT_LEAST(1, 4, 0)
 /* Implements serf_ssl_protocol_result_cb_t */
 static apr_status_t
 conn_negotiate_protocol(void *data,
@@ -557,8 +557,10 @@ conn_setup(apr_socket_t *sock,
               SVN_ERR(load_authorities(conn, conn->session->ssl_authorities,
                                        conn->session->pool));
             }
-#if SERF_VERSION_AT_LEAST(1, 4, 0) && defined(SVN__SERF_TEST_HTTP2)
-          if (APR_SUCCESS ==
+#if SERF_VERSION_AT_LEAST(1, 4, 0)
+          /* Let the server choose http/2 via ALPN, if configured. */
+          if (conn->session->enable_http2
+              && APR_SUCCESS ==
                 serf_ssl_negotiate_protocol(conn->ssl_context, "h2,http/1.1",
                                             conn_negotiate_protocol, conn))
             {
@@ -670,6 +672,54 @@ svn_ra_serf__conn_closed(serf_connection_t *conn,
   (void) save_error(ra_conn->session, err);
 }
 
+svn_error_t *
+svn_ra_serf__open_connection(svn_ra_serf__session_t *sess)
+{
+  int cur = sess->num_conns;
+  apr_status_t status;
+
+  SVN_ERR_ASSERT(cur < SVN_RA_SERF__MAX_CONNECTIONS_LIMIT);
+
+  sess->conns[cur] = apr_pcalloc(sess->pool, sizeof(*sess->conns[cur]));
+  sess->conns[cur]->bkt_alloc = serf_bucket_allocator_create(sess->pool,
+                                                             NULL, NULL);
+  sess->conns[cur]->last_status_code = -1;
+  sess->conns[cur]->session = sess;
+  status = serf_connection_create2(&sess->conns[cur]->conn,
+                                   sess->context,
+                                   sess->session_url,
+                                   svn_ra_serf__conn_setup,
+                                   sess->conns[cur],
+                                   svn_ra_serf__conn_closed,
+                                   sess->conns[cur],
+                                   sess->pool);
+  if (status)
+    return svn_ra_serf__wrap_err(status, NULL);
+
+  sess->num_conns++;
+
+  return SVN_NO_ERROR;
+}
+
+
+const char *
+svn_ra_serf__svndiff_accept_encoding(svn_boolean_t using_compression,
+                                     svn_boolean_t with_gzip)
+{
+  /* Do not advertise compressed svndiff support if we're not interested
+     in compression. */
+  if (!using_compression)
+    return "svndiff";
+
+  if (svn_lz4__compiled_version())
+    return with_gzip
+             ? "gzip,svndiff2;q=0.95,svndiff1;q=0.9,svndiff;q=0.8"
+             : "svndiff2;q=0.95,svndiff1;q=0.9,svndiff;q=0.8";
+  else
+    return with_gzip
+             ? "gzip,svndiff1;q=0.9,svndiff;q=0.8"
+             : "svndiff1;q=0.9,svndiff;q=0.8";
+}
 
 /* Implementation of svn_ra_serf__handle_client_cert */
 static svn_error_t *
@@ -862,6 +912,10 @@ setup_serf_req(serf_request_t *request,
      the header values.  */
   serf_bucket_headers_setn(*hdrs_bkt, "User-Agent", session->useragent);
 
+  if (session->trace_id)
+    serf_bucket_headers_setn(*hdrs_bkt, SVN_DAV_TRACE_ID_HEADER,
+                             session->trace_id);
+
   if (content_type)
     {
       serf_bucket_headers_setn(*hdrs_bkt, "Content-Type", content_type);
@@ -65,8 +65,8 @@ struct svn_ra_serf__xml_context_t {
   svn_ra_serf__xml_cdata_t cdata_cb;
   void *baton;
 
-  /* Linked list of free states.  */
-  svn_ra_serf__xml_estate_t *free_states;
+  /* Has any state been pushed yet?  */
+  svn_boolean_t pushed_state;
 
 #ifdef SVN_DEBUG
   /* Used to verify we are not re-entering a callback, specifically to
@@ -128,6 +128,19 @@ struct svn_ra_serf__xml_estate_t {
   /* Previous/outer state.  */
   svn_ra_serf__xml_estate_t *prev;
 
+  /* The state in whose STATE_POOL this structure was allocated, or NULL
+     if it lives in its own STATE_POOL.  */
+  svn_ra_serf__xml_estate_t *alloc_owner;
+
+  /* A cleared subpool of STATE_POOL, kept for the next child state that
+     needs a pool, so that large responses with many sibling elements
+     don't create and destroy a pool per element.  */
+  apr_pool_t *spare_pool;
+
+  /* Linked list (through PREV) of closed states allocated in
+     STATE_POOL, ready for reuse by the next child state.  */
+  svn_ra_serf__xml_estate_t *spare_states;
+
 };
 
 struct expat_ctx_t {
@@ -442,23 +455,60 @@ void svn_ra_serf__add_tag_buckets(serf_bucket_t *agg_bucket, const char *tag,
   svn_ra_serf__add_close_tag_buckets(agg_bucket, bkt_alloc, tag);
 }
 
-/* Return a pool for XES to use for self-alloc (and other specifics).  */
-static apr_pool_t *
-xes_pool(const svn_ra_serf__xml_estate_t *xes)
+/* Return the nearest state, starting at XES, that has a pool.  */
+static svn_ra_serf__xml_estate_t *
+pool_owner(svn_ra_serf__xml_estate_t *xes)
 {
   /* Move up through parent states looking for one with a pool. This
      will always terminate since the initial state has a pool.  */
   while (xes->state_pool == NULL)
     xes = xes->prev;
-  return xes->state_pool;
+  return xes;
 }
 
+/* Return a new subpool of the pool of XES (or of its parents), reusing
+   a spare one if available.  */
+static apr_pool_t *
+create_state_pool(svn_ra_serf__xml_estate_t *xes)
+{
+  svn_ra_serf__xml_estate_t *owner = pool_owner(xes);
+  apr_pool_t *pool = owner->spare_pool;
+
+  if (pool)
+    {
+      owner->spare_pool = NULL;
+      return pool;
+    }
+
+  return svn_pool_create(owner->state_pool);
+}
+
+/* Release the STATE_POOL of XES, which is being popped.  Keep it as the
+   spare pool of its parent, if possible.  Note that XES itself may live
+   in this pool.  */
+static void
+release_state_pool(svn_ra_serf__xml_estate_t *xes)
+{
+  svn_ra_serf__xml_estate_t *owner = pool_owner(xes->prev);
+  apr_pool_t *pool = xes->state_pool;
+
+  /* A parent may have constructed a pool of its own after this pool
+     was created.  Only keep pools that will die with OWNER.  */
+  if (owner->spare_pool == NULL
+      && apr_pool_parent_get(pool) == owner->state_pool)
+    {
+      svn_pool_clear(pool);
+      owner->spare_pool = pool;
+    }
+  else
+    svn_pool_destroy(pool);
+}
 
 static void
 ensure_pool(svn_ra_serf__xml_estate_t *xes)
 {
   if (xes->state_pool == NULL)
-    xes->state_pool = svn_pool_create(xes_pool(xes));
+    xes->state_pool = create_state_pool(xes);
 }
 
 
@@ -483,10 +533,9 @@ svn_ra_serf__xml_context_done(svn_ra_serf__xml_context_t *xmlctx)
                                _("XML stream truncated: closing '%s' missing"),
                                xmlctx->current->tag.name);
     }
-  else if (! xmlctx->free_states)
+  else if (! xmlctx->pushed_state)
     {
-      /* If we have no items on the free_states list, we didn't push anything,
-         which tells us that we found an empty xml body */
+      /* If we didn't push anything, we found an empty xml body */
       const svn_ra_serf__xml_transition_t *scan;
       const svn_ra_serf__xml_transition_t *document = NULL;
       const char *msg;
@@ -690,18 +739,14 @@ xml_cb_start(svn_ra_serf__xml_context_t *xmlctx,
 
   /* Found a transition. Make it happen.  */
 
-  /* ### todo. push state  */
-
-  /* ### how to use free states?  */
   /* This state should be allocated in the extent pool. If we will be
      collecting information for this state, then construct a subpool.
 
      ### potentially optimize away the subpool if none of the
      ### attributes are present. subpools are cheap, tho...  */
-  new_pool = xes_pool(current);
   if (scan->collect_cdata || scan->collect_attrs[0])
     {
-      new_pool = svn_pool_create(new_pool);
+      new_pool = create_state_pool(current);
 
       /* Prep the new state.  */
       new_xes = apr_pcalloc(new_pool, sizeof(*new_xes));
@@ -748,15 +793,38 @@ xml_cb_start(svn_ra_serf__xml_context_t *xmlctx,
     }
   else
     {
-      /* Prep the new state.  */
-      new_xes = apr_pcalloc(new_pool, sizeof(*new_xes));
+      svn_ra_serf__xml_estate_t *owner = pool_owner(current);
+
+      /* Prep the new state, reusing a closed sibling if possible.  */
+      new_pool = owner->state_pool;
+      new_xes = owner->spare_states;
+      if (new_xes)
+        {
+          owner->spare_states = new_xes->prev;
+          memset(new_xes, 0, sizeof(*new_xes));
+        }
+      else
+        new_xes = apr_pcalloc(new_pool, sizeof(*new_xes));
+
+      new_xes->alloc_owner = owner;
       /* STATE_POOL remains NULL.  */
     }
 
-  /* Some basic copies to set up the new estate.  */
+  /* Some basic copies to set up the new estate.  The names in the
+     transition table are constants, so only a wildcard match needs a
+     copy of the element name.  The namespace URL lives in the pool of
+     the state that defined it, which outlives this state.  */
   new_xes->state = scan->to_state;
-  new_xes->tag.name = apr_pstrdup(new_pool, elemname.name);
-  new_xes->tag.xmlns = apr_pstrdup(new_pool, elemname.xmlns);
+  if (*scan->name == '*')
+    {
+      new_xes->tag.name = apr_pstrdup(new_pool, elemname.name);
+      new_xes->tag.xmlns = elemname.xmlns;
+    }
+  else
+    {
+      new_xes->tag.name = scan->name;
+      new_xes->tag.xmlns = scan->ns;
+    }
   new_xes->custom_close = scan->custom_close;
 
   /* Start with the parent's namespace set.  */
@@ -765,6 +833,7 @@ xml_cb_start(svn_ra_serf__xml_context_t *xmlctx,
   /* The new state is prepared. Make it current.  */
   new_xes->prev = current;
   xmlctx->current = new_xes;
+  xmlctx->pushed_state = TRUE;
 
   if (xmlctx->opened_cb)
     {
@@ -785,6 +854,7 @@ xml_cb_end(svn_ra_serf__xml_context_t *xmlctx,
            const char *raw_name)
 {
   svn_ra_serf__xml_estate_t *xes = xmlctx->current;
+  svn_ra_serf__xml_estate_t *owner;
 
   if (xmlctx->waiting > 0)
     {
@@ -819,17 +889,20 @@ xml_cb_end(svn_ra_serf__xml_context_t *xmlctx,
 
   /* Pop the state.  */
   xmlctx->current = xes->prev;
-
-  /* ### not everything should go on the free state list. XES may go
-     ### away with the state pool.  */
-  xes->prev = xmlctx->free_states;
-  xmlctx->free_states = xes;
+  owner = xes->alloc_owner;
 
   /* If there is a STATE_POOL, then toss it. This will get rid of as much
      memory as possible. Potentially the XES (if we didn't create a pool
      right away, then XES may be in a parent pool).  */
   if (xes->state_pool)
-    svn_pool_destroy(xes->state_pool);
+    release_state_pool(xes);
+
+  /* If XES lives in a parent pool, keep it around for reuse.  */
+  if (owner)
+    {
+      xes->prev = owner->spare_states;
+      owner->spare_states = xes;
+    }
 
   return SVN_NO_ERROR;
 }
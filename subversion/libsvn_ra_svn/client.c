@@ -715,6 +715,32 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
   sess->conn = conn;
   conn->session = sess;
 
+  /* In protocol version 2, we send back our protocol version, our
+   * capability list, and the URL, and subsequently there is an auth
+   * request.
+   *
+   * None of that depends on the server's greeting: we only support
+   * version 2 servers with edit pipelining and fail below otherwise.
+   * So, queue our response right away.  It will go out together with
+   * whatever we need to send before reading the greeting, i.e. the
+   * server will find it waiting when it wants to read it and can send
+   * the auth request immediately after the greeting.  This saves one
+   * network round trip per session. */
+  /* Client-side capabilities list: */
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "n(wwwwww?w)cc(?c)?c",
+                                  (apr_uint64_t) 2,
+                                  SVN_RA_SVN_CAP_EDIT_PIPELINE,
+                                  SVN_RA_SVN_CAP_SVNDIFF1,
+                                  SVN_RA_SVN_CAP_ABSENT_ENTRIES,
+                                  SVN_RA_SVN_CAP_DEPTH,
+                                  SVN_RA_SVN_CAP_MERGEINFO,
+                                  SVN_RA_SVN_CAP_LOG_REVPROPS,
+                                  svn_ra_svn__svndiff2_capability(),
+                                  url,
+                                  SVN_RA_SVN__DEFAULT_USERAGENT,
+                                  client_string,
+                                  callbacks->trace_id));
+
   /* Read server's greeting. */
   SVN_ERR(svn_ra_svn__read_cmd_response(conn, pool, "nnll", &minver, &maxver,
                                         &mechlist, &server_caplist));
@@ -736,21 +762,6 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
     return svn_error_create(SVN_ERR_RA_SVN_BAD_VERSION, NULL,
                             _("Server does not support edit pipelining"));
 
-  /* In protocol version 2, we send back our protocol version, our
-   * capability list, and the URL, and subsequently there is an auth
-   * request. */
-  /* Client-side capabilities list: */
-  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "n(wwwwww)cc(?c)",
-                                  (apr_uint64_t) 2,
-                                  SVN_RA_SVN_CAP_EDIT_PIPELINE,
-                                  SVN_RA_SVN_CAP_SVNDIFF1,
-                                  SVN_RA_SVN_CAP_ABSENT_ENTRIES,
-                                  SVN_RA_SVN_CAP_DEPTH,
-                                  SVN_RA_SVN_CAP_MERGEINFO,
-                                  SVN_RA_SVN_CAP_LOG_REVPROPS,
-                                  url,
-                                  SVN_RA_SVN__DEFAULT_USERAGENT,
-                                  client_string));
   SVN_ERR(handle_auth_request(sess, pool));
 
   /* This is where the security layer would go into effect if we
@@ -1914,18 +1925,15 @@ static svn_error_t *handle_unsupported_cmd(svn_error_t *err,
 }
 
 
-static svn_error_t *ra_svn_stat(svn_ra_session_t *session,
-                                const char *path, svn_revnum_t rev,
-                                svn_dirent_t **dirent, apr_pool_t *pool)
+/* Read the response to a "stat" command from CONN, after the auth
+   request, into *DIRENT, allocated in POOL. */
+static svn_error_t *read_stat_response(svn_ra_svn_conn_t *conn,
+                                       svn_dirent_t **dirent,
+                                       apr_pool_t *pool)
 {
-  svn_ra_svn__session_baton_t *sess_baton = session->priv;
-  svn_ra_svn_conn_t *conn = sess_baton->conn;
   svn_ra_svn__list_t *list = NULL;
   svn_dirent_t *the_dirent;
 
-  SVN_ERR(svn_ra_svn__write_cmd_stat(conn, pool, path, rev));
-  SVN_ERR(handle_unsupported_cmd(handle_auth_request(sess_baton, pool),
-                                 N_("'stat' not implemented")));
   SVN_ERR(svn_ra_svn__read_cmd_response(conn, pool, "(?l)", &list));
 
   if (! list)
@@ -1957,6 +1965,103 @@ static svn_error_t *ra_svn_stat(svn_ra_session_t *session,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *ra_svn_stat(svn_ra_session_t *session,
+                                const char *path, svn_revnum_t rev,
+                                svn_dirent_t **dirent, apr_pool_t *pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+
+  SVN_ERR(svn_ra_svn__write_cmd_stat(conn, pool, path, rev));
+  SVN_ERR(handle_unsupported_cmd(handle_auth_request(sess_baton, pool),
+                                 N_("'stat' not implemented")));
+  SVN_ERR(read_stat_response(conn, dirent, pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *ra_svn_stat_many(svn_ra_session_t *session,
+                                     const apr_array_header_t *paths,
+                                     svn_revnum_t rev,
+                                     apr_hash_t **dirents,
+                                     apr_pool_t *pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+  apr_array_header_t *retry;
+  apr_pool_t *iterpool;
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  /* Let the RA loader stat the paths one by one. */
+  if (! svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_BATCH))
+    return svn_error_create(SVN_ERR_RA_NOT_IMPLEMENTED, NULL, NULL);
+
+  *dirents = apr_hash_make(pool);
+  retry = apr_array_make(pool, 0, sizeof(const char *));
+  iterpool = svn_pool_create(pool);
+
+  /* Send all stat commands in one batch and read the responses in order,
+     saving one round trip per path. */
+
+  SVN_ERR(svn_ra_svn__write_cmd_batch_start(conn, pool));
+  for (i = 0; i < paths->nelts; i++)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_ra_svn__write_cmd_stat(conn, iterpool,
+                                         APR_ARRAY_IDX(paths, i,
+                                                       const char *),
+                                         rev));
+    }
+  SVN_ERR(svn_ra_svn__write_cmd_batch_end(conn, pool));
+
+  /* Read every response, even after a failure, to keep the connection
+     in sync. */
+  for (i = 0; i < paths->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      svn_dirent_t *dirent;
+      svn_error_t *item_err;
+
+      svn_pool_clear(iterpool);
+
+      item_err = handle_auth_request(sess_baton, iterpool);
+      if (! item_err)
+        item_err = read_stat_response(conn, &dirent, pool);
+
+      if (! item_err)
+        {
+          if (dirent)
+            svn_hash_sets(*dirents, apr_pstrdup(pool, path), dirent);
+        }
+      else if (svn_error_find_cause(item_err, SVN_ERR_RA_NOT_AUTHORIZED))
+        {
+          /* The server doesn't authenticate within a batch.  Try this
+             one again by itself. */
+          svn_error_clear(item_err);
+          APR_ARRAY_PUSH(retry, const char *) = path;
+        }
+      else
+        err = svn_error_compose_create(err, item_err);
+    }
+  SVN_ERR(err);
+
+  for (i = 0; i < retry->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(retry, i, const char *);
+      svn_dirent_t *dirent;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(ra_svn_stat(session, path, rev, &dirent, pool));
+      if (dirent)
+        svn_hash_sets(*dirents, apr_pstrdup(pool, path), dirent);
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
 
 static svn_error_t *ra_svn_get_locations(svn_ra_session_t *session,
                                          apr_hash_t **locations,
@@ -2839,6 +2944,7 @@ ra_svn_has_capability(svn_ra_session_t *session,
       {SVN_RA_CAPABILITY_GET_FILE_REVS_REVERSE,
                                        SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE},
       {SVN_RA_CAPABILITY_LIST, SVN_RA_SVN_CAP_LIST},
+      {SVN_RA_CAPABILITY_BLAME, SVN_RA_SVN_CAP_BLAME},
 
       {NULL, NULL} /* End of list marker */
   };
@@ -2888,11 +2994,8 @@ static svn_error_t *
 ra_svn_register_editor_shim_callbacks(svn_ra_session_t *session,
                                       svn_delta_shim_callbacks_t *callbacks)
 {
-  svn_ra_svn__session_baton_t *sess_baton = session->priv;
-  svn_ra_svn_conn_t *conn = sess_baton->conn;
-
-  conn->shim_callbacks = callbacks;
-
+  /* This is a no-op.  Our editors go straight onto the wire, so there
+     is nothing to gain from routing them through the Ev2 shims. */
   return SVN_NO_ERROR;
 }
 
@@ -2999,6 +3102,98 @@ ra_svn_list(svn_ra_session_t *session,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+ra_svn_blame(svn_ra_session_t *session,
+             const char *path,
+             svn_revnum_t start,
+             svn_revnum_t end,
+             const svn_diff_file_options_t *diff_options,
+             svn_ra_blame_receiver_t receiver,
+             void *receiver_baton,
+             apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+  apr_hash_t *rev_props_cache = apr_hash_make(scratch_pool);
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  const char *ignore_space = "none";
+  svn_boolean_t ignore_eol_style = FALSE;
+  const char *algorithm = "lcs";
+
+  if (diff_options)
+    {
+      if (diff_options->ignore_space == svn_diff_file_ignore_space_change)
+        ignore_space = "change";
+      else if (diff_options->ignore_space == svn_diff_file_ignore_space_all)
+        ignore_space = "all";
+
+      ignore_eol_style = diff_options->ignore_eol_style;
+
+      if (diff_options->algorithm == svn_diff_algorithm_histogram)
+        algorithm = "histogram";
+    }
+
+  /* Send the blame request. */
+  SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "w(c(?r)(?r)wbw)",
+                                  "blame", path, start, end, ignore_space,
+                                  ignore_eol_style, algorithm));
+
+  /* Handle auth request by server */
+  SVN_ERR(handle_auth_request(sess_baton, scratch_pool));
+
+  /* Read and process the blame chunks. */
+  while (1)
+    {
+      svn_ra_svn__item_t *item;
+      svn_ra_svn__list_t *rev_proplist;
+      apr_uint64_t start_line;
+      svn_revnum_t rev;
+      apr_hash_t *rev_props = NULL;
+
+      svn_pool_clear(iterpool);
+
+      /* Read the next chunk or bail out on "done", respectively */
+      SVN_ERR(svn_ra_svn__read_item(conn, iterpool, &item));
+      if (is_done_response(item))
+        break;
+      if (item->kind != SVN_RA_SVN_LIST)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Blame chunk not a list"));
+      SVN_ERR(svn_ra_svn__parse_tuple(&item->u.list, "n(?r)(?l)",
+                                      &start_line, &rev, &rev_proplist));
+
+      /* The server sends the revision props only with the first chunk
+         of each revision. */
+      if (SVN_IS_VALID_REVNUM(rev))
+        {
+          if (rev_proplist)
+            {
+              svn_revnum_t *key = apr_pmemdup(scratch_pool, &rev,
+                                              sizeof(rev));
+              SVN_ERR(svn_ra_svn__parse_proplist(rev_proplist, scratch_pool,
+                                                 &rev_props));
+              apr_hash_set(rev_props_cache, key, sizeof(*key), rev_props);
+            }
+          else
+            {
+              rev_props = apr_hash_get(rev_props_cache, &rev, sizeof(rev));
+              if (!rev_props)
+                return svn_error_createf(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                         _("Missing revision properties "
+                                           "for r%ld"), rev);
+            }
+        }
+
+      SVN_ERR(receiver(receiver_baton, (apr_int64_t)start_line, rev,
+                       rev_props, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  /* Read the actual command response. */
+  SVN_ERR(svn_ra_svn__read_cmd_response(conn, scratch_pool, ""));
+  return SVN_NO_ERROR;
+}
+
 static const svn_ra__vtable_t ra_svn_vtable = {
   svn_ra_svn_version,
   ra_svn_get_description,
@@ -3039,6 +3234,8 @@ static const svn_ra__vtable_t ra_svn_vtable = {
   ra_svn_get_inherited_props,
   NULL /* ra_set_svn_ra_open */,
   ra_svn_list,
+  ra_svn_blame,
+  ra_svn_stat_many,
   ra_svn_register_editor_shim_callbacks,
   NULL /* commit_ev2 */,
   NULL /* replay_range_ev2 */
@@ -37,11 +37,11 @@
 #include "svn_ra_svn.h"
 #include "svn_path.h"
 #include "svn_pools.h"
+#include "svn_props.h"
 #include "svn_private_config.h"
 
 #include "private/svn_atomic.h"
 #include "private/svn_fspath.h"
-#include "private/svn_editor.h"
 #include "private/svn_string_private.h"
 #include "private/svn_subr_private.h"
 
@@ -70,6 +70,9 @@ typedef struct ra_svn_baton_t {
   apr_pool_t *pool;
   ra_svn_edit_baton_t *eb;
   svn_string_t *token;
+  /* Set if the file's mime-type says its contents are compressed already.
+     Only known if the mime-type gets sent before the contents. */
+  svn_boolean_t precompressed;
 } ra_svn_baton_t;
 
 /* Forward declaration. */
@@ -134,9 +137,33 @@ static ra_svn_baton_t *ra_svn_make_baton(svn_ra_svn_conn_t *conn,
   b->pool = pool;
   b->eb = eb;
   b->token = token;
+  b->precompressed = FALSE;
   return b;
 }
 
+/* Return TRUE if files of MIME_TYPE are typically stored in a compressed
+ * format such that compressing them again would be a waste of time. */
+static svn_boolean_t
+is_precompressed_mime_type(const char *mime_type)
+{
+  static const char *const prefixes[] = {
+    "image/jpeg", "image/png", "image/gif", "image/webp",
+    "audio/", "video/",
+    "application/zip", "application/gzip", "application/x-gzip",
+    "application/x-bzip2", "application/x-xz", "application/x-7z-compressed",
+    "application/x-rar-compressed", "application/java-archive",
+    "application/vnd.openxmlformats-officedocument.",
+    "application/vnd.oasis.opendocument."
+  };
+  apr_size_t i;
+
+  for (i = 0; i < sizeof(prefixes) / sizeof(prefixes[0]); ++i)
+    if (strncmp(mime_type, prefixes[i], strlen(prefixes[i])) == 0)
+      return TRUE;
+
+  return FALSE;
+}
+
 /* Check for an early error status report from the consumer.  If we
  * get one, abort the edit and return the error. */
 static svn_error_t *
@@ -351,15 +378,16 @@ static svn_error_t *ra_svn_apply_textdelta(void *file_baton,
   svn_stream_set_write(diff_stream, ra_svn_svndiff_handler);
   svn_stream_set_close(diff_stream, ra_svn_svndiff_close_handler);
 
-  /* If the connection does not support SVNDIFF1 or if we don't want to use
-   * compression, use the non-compressing "version 0" implementation */
-  if (   svn_ra_svn_compression_level(b->conn) > 0
-      && svn_ra_svn_has_capability(b->conn, SVN_RA_SVN_CAP_SVNDIFF1))
-    svn_txdelta_to_svndiff3(wh, wh_baton, diff_stream, 1,
-                            b->conn->compression_level, pool);
-  else
+  /* Use the fastest compressing svndiff version supported by both sides,
+   * or the non-compressing "version 0" if we don't want to compress.
+   * With adaptive compression, send pre-compressed contents as they are. */
+  if (b->precompressed && b->conn->adaptive_compression)
     svn_txdelta_to_svndiff3(wh, wh_baton, diff_stream, 0,
-                            b->conn->compression_level, pool);
+                            SVN_DELTA_COMPRESSION_LEVEL_NONE, pool);
+  else
+    svn_txdelta_to_svndiff3(wh, wh_baton, diff_stream,
+                            svn_ra_svn__svndiff_version(b->conn),
+                            svn_ra_svn__compression_level(b->conn), pool);
   return SVN_NO_ERROR;
 }
 
@@ -370,6 +398,9 @@ static svn_error_t *ra_svn_change_file_prop(void *file_baton,
 {
   ra_svn_baton_t *b = file_baton;
 
+  if (strcmp(name, SVN_PROP_MIME_TYPE) == 0)
+    b->precompressed = value && is_precompressed_mime_type(value->data);
+
   SVN_ERR(check_for_error(b->eb, pool));
   SVN_ERR(svn_ra_svn__write_cmd_change_file_prop(b->conn, pool,
                                                  b->token, name, value));
@@ -470,11 +501,6 @@ void svn_ra_svn_get_editor(const svn_delta_editor_t **editor,
 
   *editor = ra_svn_editor;
   *edit_baton = eb;
-
-  svn_error_clear(svn_editor__insert_shims(editor, edit_baton, *editor,
-                                           *edit_baton, NULL, NULL,
-                                           conn->shim_callbacks,
-                                           pool, pool));
 }
 
 /* --- DRIVING AN EDITOR --- */
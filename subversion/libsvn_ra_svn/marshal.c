@@ -34,6 +34,7 @@
 
 #include "svn_hash.h"
 #include "svn_types.h"
+#include "svn_delta.h"
 #include "svn_string.h"
 #include "svn_error.h"
 #include "svn_pools.h"
@@ -48,6 +49,7 @@
 #include "private/svn_string_private.h"
 #include "private/svn_dep_compat.h"
 #include "private/svn_error_private.h"
+#include "private/svn_probes.h"
 #include "private/svn_subr_private.h"
 
 #define svn_iswhitespace(c) ((c) == ' ' || (c) == '\n')
@@ -72,6 +74,15 @@
  */
 #define ITEM_NESTING_LIMIT 64
 
+/* Adaptive compression re-estimates the network throughput after each
+ * ADAPTIVE_SAMPLE_SIZE bytes sent.  Links faster than ADAPTIVE_FAST_RATE
+ * bytes per second would be slowed down by zlib.  Below
+ * ADAPTIVE_SLOW_RATE, maximum compression pays off.
+ */
+#define ADAPTIVE_SAMPLE_SIZE (0x100000)
+#define ADAPTIVE_FAST_RATE (32 * 0x100000)
+#define ADAPTIVE_SLOW_RATE (0x100000)
+
 /* The protocol words for booleans. */
 static const svn_string_t str_true = SVN__STATIC_STRING("true");
 static const svn_string_t str_false = SVN__STATIC_STRING("false");
@@ -210,11 +221,17 @@ svn_ra_svn_conn_t *svn_ra_svn_create_conn5(apr_socket_t *sock,
   conn->current_in = 0;
   conn->max_out = max_out;
   conn->current_out = 0;
+  conn->current_cmdname = NULL;
+  conn->current_cmd_started = 0;
   conn->block_handler = NULL;
   conn->block_baton = NULL;
   conn->capabilities = apr_hash_make(result_pool);
   conn->compression_level = compression_level;
   conn->zero_copy_limit = zero_copy_limit;
+  conn->adaptive_compression = FALSE;
+  conn->sample_bytes = 0;
+  conn->sample_time = 0;
+  conn->out_rate = 0;
   conn->pool = result_pool;
 
   if (sock != NULL)
@@ -271,14 +288,6 @@ svn_ra_svn__get_pool(svn_ra_svn_conn_t *conn)
   return conn->pool;
 }
 
-svn_error_t *
-svn_ra_svn__set_shim_callbacks(svn_ra_svn_conn_t *conn,
-                               svn_delta_shim_callbacks_t *shim_callbacks)
-{
-  conn->shim_callbacks = shim_callbacks;
-  return SVN_NO_ERROR;
-}
-
 svn_boolean_t svn_ra_svn_has_capability(svn_ra_svn_conn_t *conn,
                                         const char *capability)
 {
@@ -291,6 +300,80 @@ svn_ra_svn_compression_level(svn_ra_svn_conn_t *conn)
   return conn->compression_level;
 }
 
+void
+svn_ra_svn__set_adaptive_compression(svn_ra_svn_conn_t *conn,
+                                     svn_boolean_t enable)
+{
+  conn->adaptive_compression = enable;
+}
+
+/* Return TRUE if we may send svndiff2 (LZ4) over CONN. */
+static svn_boolean_t
+can_use_lz4(svn_ra_svn_conn_t *conn)
+{
+  return svn_lz4__compiled_version()
+      && svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_SVNDIFF2_ACCEPTED);
+}
+
+/* Return TRUE if adaptive compression is enabled for CONN and we know
+   its output rate to be below ADAPTIVE_FAST_RATE. */
+static svn_boolean_t
+is_slow_link(svn_ra_svn_conn_t *conn)
+{
+  return conn->adaptive_compression
+      && conn->out_rate
+      && conn->out_rate < ADAPTIVE_FAST_RATE;
+}
+
+int
+svn_ra_svn__compression_level(svn_ra_svn_conn_t *conn)
+{
+  if (   conn->compression_level <= 0
+      || !conn->adaptive_compression
+      || conn->out_rate == 0)
+    return conn->compression_level;
+
+  /* zlib would become the bottleneck on fast links.  LZ4 is cheap enough
+   * to keep up. */
+  if (conn->out_rate >= ADAPTIVE_FAST_RATE)
+    return can_use_lz4(conn) ? conn->compression_level
+                             : SVN_DELTA_COMPRESSION_LEVEL_NONE;
+
+  /* On really slow links, every byte saved counts. */
+  if (conn->out_rate < ADAPTIVE_SLOW_RATE)
+    return SVN_DELTA_COMPRESSION_LEVEL_MAX;
+
+  return conn->compression_level;
+}
+
+int
+svn_ra_svn__svndiff_version(svn_ra_svn_conn_t *conn)
+{
+  if (svn_ra_svn__compression_level(conn) <= 0)
+    return 0;
+
+  /* If the network is slower than zlib, its better compression ratio
+   * beats the speed of LZ4. */
+  if (   is_slow_link(conn)
+      && svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_SVNDIFF1))
+    return 1;
+
+  if (can_use_lz4(conn))
+    return 2;
+
+  if (svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_SVNDIFF1))
+    return 1;
+
+  return 0;
+}
+
+const char *
+svn_ra_svn__svndiff2_capability(void)
+{
+  return svn_lz4__compiled_version() ? SVN_RA_SVN_CAP_SVNDIFF2_ACCEPTED
+                                     : NULL;
+}
+
 apr_size_t
 svn_ra_svn_zero_copy_limit(svn_ra_svn_conn_t *conn)
 {
@@ -345,11 +428,38 @@ check_io_limits(svn_ra_svn_conn_t *conn)
   return SVN_NO_ERROR;
 }
 
-/* Write data to socket or output file as appropriate. */
+/* Account for COUNT bytes having been written to CONN's stream within
+   DURATION.  Once a full sample has been collected, update the output
+   rate estimate of CONN.
+
+   Writes that fit into the OS buffers return early and will make the
+   link look faster than it is.  That leads to less compression, i.e.
+   more data to send, and the next sample will show the actual rate. */
+static void
+sample_output_rate(svn_ra_svn_conn_t *conn,
+                   apr_size_t count,
+                   apr_interval_time_t duration)
+{
+  conn->sample_bytes += count;
+  conn->sample_time += duration;
+
+  if (conn->sample_bytes >= ADAPTIVE_SAMPLE_SIZE)
+    {
+      conn->out_rate = conn->sample_bytes * APR_USEC_PER_SEC
+                     / MAX(conn->sample_time, 1);
+      conn->sample_bytes = 0;
+      conn->sample_time = 0;
+    }
+}
+
+/* Write HEAD_LEN bytes from HEAD followed by LEN bytes from DATA to
+   socket or output file as appropriate.  Both are passed on by reference,
+   using a single vectored write where the stream supports it. */
 static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
+                                    const char *head, apr_size_t head_len,
                                     const char *data, apr_size_t len)
 {
-  const char *end = data + len;
+  apr_size_t total = head_len + len;
   apr_size_t count;
   apr_pool_t *subpool = NULL;
   svn_ra_svn__session_baton_t *session = conn->session;
@@ -357,17 +467,42 @@ static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
   /* Limit the size of the response, if a limit has been configured.
    * This is to limit the server load in case users e.g. accidentally ran
    * an export on the root folder. */
-  conn->current_out += len;
+  conn->current_out += total;
   SVN_ERR(check_io_limits(conn));
 
-  while (data < end)
+  while (head_len + len > 0)
     {
-      count = end - data;
+      struct iovec vec[2];
+      int nvec = 0;
+
+      if (head_len)
+        {
+          vec[nvec].iov_base = (void *)head;
+          vec[nvec].iov_len = head_len;
+          nvec++;
+        }
+      if (len)
+        {
+          vec[nvec].iov_base = (void *)data;
+          vec[nvec].iov_len = len;
+          nvec++;
+        }
 
       if (session && session->callbacks && session->callbacks->cancel_func)
         SVN_ERR((session->callbacks->cancel_func)(session->callbacks_baton));
 
-      SVN_ERR(svn_ra_svn__stream_write(conn->stream, data, &count));
+      if (conn->adaptive_compression)
+        {
+          apr_time_t start = apr_time_now();
+          SVN_ERR(svn_ra_svn__stream_writev(conn->stream, vec, nvec,
+                                            &count));
+          sample_output_rate(conn, count, apr_time_now() - start);
+        }
+      else
+        {
+          SVN_ERR(svn_ra_svn__stream_writev(conn->stream, vec, nvec,
+                                            &count));
+        }
       if (count == 0)
         {
           if (!subpool)
@@ -376,7 +511,18 @@ static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
             svn_pool_clear(subpool);
           SVN_ERR(conn->block_handler(conn, subpool, conn->block_baton));
         }
-      data += count;
+
+      if (count < head_len)
+        {
+          head += count;
+          head_len -= count;
+        }
+      else
+        {
+          data += count - head_len;
+          len -= count - head_len;
+          head_len = 0;
+        }
 
       if (session)
         {
@@ -389,7 +535,7 @@ static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
         }
     }
 
-  conn->written_since_error_check += len;
+  conn->written_since_error_check += total;
   conn->may_check_for_error
     = conn->written_since_error_check >= conn->error_check_interval;
 
@@ -405,20 +551,23 @@ static svn_error_t *writebuf_flush(svn_ra_svn_conn_t *conn, apr_pool_t *pool)
 
   /* Clear conn->write_pos first in case the block handler does a read. */
   conn->write_pos = 0;
-  SVN_ERR(writebuf_output(conn, pool, conn->write_buf, write_pos));
+  SVN_ERR(writebuf_output(conn, pool, conn->write_buf, write_pos, NULL, 0));
   return SVN_NO_ERROR;
 }
 
 static svn_error_t *writebuf_write(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
                                    const char *data, apr_size_t len)
 {
-  /* data >= 8k is sent immediately */
+  /* data >= 8k is sent immediately, together with what we have buffered
+     so far but without copying it into the buffer */
   if (len >= sizeof(conn->write_buf) / 2)
     {
-      if (conn->write_pos > 0)
-        SVN_ERR(writebuf_flush(conn, pool));
+      apr_size_t write_pos = conn->write_pos;
 
-      return writebuf_output(conn, pool, data, len);
+      /* Clear conn->write_pos first in case the block handler does a read. */
+      conn->write_pos = 0;
+      return writebuf_output(conn, pool, conn->write_buf, write_pos,
+                             data, len);
     }
 
   /* ensure room for the data to add */
@@ -1895,6 +2044,7 @@ svn_ra_svn__handle_command(svn_boolean_t *terminate,
 
   /* Limit I/O for every command separately. */
   svn_ra_svn__reset_command_io_counters(conn);
+  conn->current_cmdname = NULL;
 
   err = svn_ra_svn__read_tuple(conn, pool, "wl", &cmdname, &params);
   if (err)
@@ -1912,6 +2062,10 @@ svn_ra_svn__handle_command(svn_boolean_t *terminate,
   command = svn_hash_gets(cmd_hash, cmdname);
   if (command)
     {
+      conn->current_cmdname = command->cmdname;
+      conn->current_cmd_started = apr_time_now();
+      SVN_PROBE1(ra_svn__command__start, command->cmdname);
+
       /* Call the standard command handler.
        * If that is not set, then this is a lecagy API call and we invoke
        * the legacy command handler. */
@@ -1933,6 +2087,8 @@ svn_ra_svn__handle_command(svn_boolean_t *terminate,
        * So, check again for the limit violations and exit the command
        * processing quickly if we may have truncated data. */
       err = svn_error_compose_create(check_io_limits(conn), err);
+      SVN_PROBE2(ra_svn__command__done, command->cmdname,
+                 err ? err->apr_err : 0);
 
       *terminate = command->terminate;
     }
@@ -1955,6 +2111,95 @@ svn_ra_svn__handle_command(svn_boolean_t *terminate,
   return err;
 }
 
+void
+svn_ra_svn__get_command_info(const char **cmdname,
+                             apr_time_t *started,
+                             apr_uint64_t *bytes_in,
+                             apr_uint64_t *bytes_out,
+                             svn_ra_svn_conn_t *conn)
+{
+  *cmdname = conn->current_cmdname;
+  *started = conn->current_cmd_started;
+  *bytes_in = conn->current_in;
+  *bytes_out = conn->current_out;
+}
+
+svn_error_t *
+svn_ra_svn__handle_batch(svn_ra_svn_conn_t *conn,
+                         apr_pool_t *pool,
+                         svn_ra_svn__list_t *params,
+                         const svn_ra_svn__cmd_entry_t *commands,
+                         void *baton)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  for (i = 0; i < params->nelts; i++)
+    {
+      svn_ra_svn__item_t *elt = &SVN_RA_SVN__LIST_ITEM(params, i);
+      const svn_ra_svn__cmd_entry_t *command;
+      const char *cmdname;
+      svn_ra_svn__list_t *cmd_params;
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+
+      if (elt->kind == SVN_RA_SVN_LIST)
+        {
+          err = svn_ra_svn__parse_tuple(&elt->u.list, "wl",
+                                        &cmdname, &cmd_params);
+          if (err)
+            err = svn_error_create(SVN_ERR_RA_SVN_CMD_ERR, err, NULL);
+        }
+      else
+        err = svn_error_create(SVN_ERR_RA_SVN_CMD_ERR,
+                               svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA,
+                                                NULL,
+                                                _("Batch item is not a list")),
+                               NULL);
+
+      if (!err)
+        {
+          for (command = commands; command->cmdname; command++)
+            if (strcmp(command->cmdname, cmdname) == 0)
+              break;
+
+          if (command->cmdname && command->handler)
+            {
+              err = (*command->handler)(conn, iterpool, cmd_params, baton);
+              err = svn_error_compose_create(check_io_limits(conn), err);
+            }
+          else
+            err = svn_error_create(
+                    SVN_ERR_RA_SVN_CMD_ERR,
+                    svn_error_createf(SVN_ERR_RA_SVN_UNKNOWN_CMD, NULL,
+                                      _("Unknown batch command '%s'"),
+                                      cmdname),
+                    NULL);
+        }
+
+      /* Every command gets exactly one response, so that the client can
+         match them up. */
+      if (err && err->apr_err == SVN_ERR_RA_SVN_CMD_ERR)
+        {
+          svn_error_t *write_err = svn_ra_svn__write_cmd_failure(
+                                     conn, iterpool,
+                                     svn_ra_svn__locate_real_error_child(err));
+          svn_error_clear(err);
+          err = write_err;
+        }
+
+      if (err)
+        {
+          svn_pool_destroy(iterpool);
+          return svn_error_trace(err);
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_ra_svn__handle_commands2(svn_ra_svn_conn_t *conn,
                              apr_pool_t *pool,
@@ -2558,6 +2803,20 @@ svn_ra_svn__write_cmd_stat(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_ra_svn__write_cmd_batch_start(svn_ra_svn_conn_t *conn,
+                                  apr_pool_t *pool)
+{
+  return writebuf_write_literal(conn, pool, "( batch ( ");
+}
+
+svn_error_t *
+svn_ra_svn__write_cmd_batch_end(svn_ra_svn_conn_t *conn,
+                                apr_pool_t *pool)
+{
+  return writebuf_write_literal(conn, pool, ") ) ");
+}
+
 svn_error_t *
 svn_ra_svn__write_cmd_get_file_revs(svn_ra_svn_conn_t *conn,
                                     apr_pool_t *pool,
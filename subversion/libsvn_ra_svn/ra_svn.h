@@ -102,6 +102,10 @@ struct svn_ra_svn_conn_st {
   apr_uint64_t max_out;
   apr_uint64_t current_out;
 
+  /* name and start time of the command being handled, for statistics */
+  const char *current_cmdname;
+  apr_time_t current_cmd_started;
+
   /* repository info */
   const char *uuid;
   const char *repos_root;
@@ -115,12 +119,17 @@ struct svn_ra_svn_conn_st {
   int compression_level;
   apr_size_t zero_copy_limit;
 
+  /* adaptive compression: if enabled, pick the svndiff version and
+     compression level based on the measured network throughput.
+     OUT_RATE is 0 until the first sample has been completed. */
+  svn_boolean_t adaptive_compression;
+  apr_uint64_t sample_bytes;
+  apr_interval_time_t sample_time;
+  apr_uint64_t out_rate;
+
   /* who's on the other side of the connection? */
   char *remote_ip;
 
-  /* EV2 support*/
-  svn_delta_shim_callbacks_t *shim_callbacks;
-
   /* our pool */
   apr_pool_t *pool;
 };
@@ -204,6 +213,14 @@ svn_ra_svn__stream_t *svn_ra_svn__stream_create(svn_stream_t *in_stream,
 svn_error_t *svn_ra_svn__stream_write(svn_ra_svn__stream_t *stream,
                                       const char *data, apr_size_t *len);
 
+/* Write the NVEC buffers in VEC to STREAM, in order, returning the total
+ * number of bytes written in *LEN.  Socket backed streams send them with
+ * a single vectored write; other streams may write only the first buffer.
+ */
+svn_error_t *svn_ra_svn__stream_writev(svn_ra_svn__stream_t *stream,
+                                       const struct iovec *vec, int nvec,
+                                       apr_size_t *len);
+
 /* Read *LEN bytes from STREAM into DATA, returning the number of bytes
  * read in *LEN.
  */
@@ -40,6 +40,7 @@
 struct svn_ra_svn__stream_st {
   svn_stream_t *in_stream;
   svn_stream_t *out_stream;
+  apr_socket_t *sock;   /* If OUT_STREAM writes directly to a socket */
   void *timeout_baton;
   ra_svn_timeout_fn_t timeout_fn;
 };
@@ -167,6 +168,7 @@ svn_ra_svn__stream_from_sock(apr_socket_t *sock,
 {
   sock_baton_t *b = apr_palloc(result_pool, sizeof(*b));
   svn_stream_t *sock_stream;
+  svn_ra_svn__stream_t *s;
 
   b->sock = sock;
   b->pool = svn_pool_create(result_pool);
@@ -177,8 +179,11 @@ svn_ra_svn__stream_from_sock(apr_socket_t *sock,
   svn_stream_set_write(sock_stream, sock_write_cb);
   svn_stream_set_data_available(sock_stream, sock_pending_cb);
 
-  return svn_ra_svn__stream_create(sock_stream, sock_stream,
-                                   b, sock_timeout_cb, result_pool);
+  s = svn_ra_svn__stream_create(sock_stream, sock_stream,
+                                b, sock_timeout_cb, result_pool);
+  s->sock = sock;
+
+  return s;
 }
 
 svn_ra_svn__stream_t *
@@ -191,6 +196,7 @@ svn_ra_svn__stream_create(svn_stream_t *in_stream,
   svn_ra_svn__stream_t *s = apr_palloc(pool, sizeof(*s));
   s->in_stream = in_stream;
   s->out_stream = out_stream;
+  s->sock = NULL;
   s->timeout_baton = timeout_baton;
   s->timeout_fn = timeout_cb;
   return s;
@@ -203,6 +209,32 @@ svn_ra_svn__stream_write(svn_ra_svn__stream_t *stream,
   return svn_error_trace(svn_stream_write(stream->out_stream, data, len));
 }
 
+svn_error_t *
+svn_ra_svn__stream_writev(svn_ra_svn__stream_t *stream,
+                          const struct iovec *vec, int nvec,
+                          apr_size_t *len)
+{
+  apr_status_t status;
+
+  if (!stream->sock)
+    {
+      /* Generic streams have no vectored write.  Let the caller come back
+         for the rest. */
+      for (; nvec > 1 && vec->iov_len == 0; vec++, nvec--)
+        ;
+
+      *len = vec->iov_len;
+      return svn_error_trace(svn_stream_write(stream->out_stream,
+                                              vec->iov_base, len));
+    }
+
+  status = apr_socket_sendv(stream->sock, vec, nvec, len);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't write to connection"));
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_ra_svn__stream_read(svn_ra_svn__stream_t *stream, char *data,
                         apr_size_t *len)
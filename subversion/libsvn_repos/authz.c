@@ -34,15 +34,23 @@
 #include "svn_repos.h"
 #include "svn_config.h"
 #include "svn_ctype.h"
+#include "private/svn_cache.h"
 #include "private/svn_fspath.h"
+#include "private/svn_mutex.h"
 #include "private/svn_repos_private.h"
+#include "private/svn_sorts_private.h"
+#include "private/svn_temp_serializer.h"
 #include "repos.h"
 
 
 /*** Structures. ***/
 
-/* Information for the config enumerators called during authz
-   lookup. */
+/* Maximum number of access decisions memoized per user.  The memo gets
+   cleared once it is full. */
+#define AUTHZ_MEMO_SIZE 1024
+
+/* Information for the config enumerators called while compiling the
+   rules of one user. */
 struct authz_lookup_baton {
   /* The authz configuration. */
   svn_config_t *config;
@@ -50,23 +58,17 @@ struct authz_lookup_baton {
   /* The user to authorize. */
   const char *user;
 
+  /* Group name -> "" if USER is a member of it, "-" otherwise.  Each
+     group will be resolved only once per user. */
+  apr_hash_t *groups;
+
   /* Explicitly granted rights. */
   svn_repos_authz_access_t allow;
   /* Explicitly denied rights. */
   svn_repos_authz_access_t deny;
 
-  /* The rights required by the caller of the lookup. */
-  svn_repos_authz_access_t required_access;
-
-  /* The following are used exclusively in recursive lookups. */
-
-  /* The path in the repository (an fspath) to authorize. */
-  const char *repos_path;
-  /* repos_path prefixed by the repository name and a colon. */
-  const char *qualified_repos_path;
-
-  /* Whether, at the end of a recursive lookup, access is granted. */
-  svn_boolean_t access;
+  /* The rules being compiled. */
+  struct authz_user_rules_t *rules;
 };
 
 /* Information for the config enumeration functions called during the
@@ -77,15 +79,72 @@ struct authz_validate_baton {
                            enumerator, if any. */
 };
 
-/* Currently this structure is just a wrapper around a svn_config_t.
-   Please update authz_pool if you modify this structure. */
+/* The rights that the rules of one authz section grant to and deny from
+   a specific user. */
+typedef struct authz_rights_t
+{
+  svn_repos_authz_access_t allow;
+  svn_repos_authz_access_t deny;
+} authz_rights_t;
+
+/* The authz configuration compiled for one specific user.  Except for the
+   memo, this is immutable once created. */
+typedef struct authz_user_rules_t
+{
+  /* Section name -> authz_rights_t *.  Sections without any rule that
+     applies to the user are not included; they never determine access. */
+  apr_hash_t *sections;
+
+  /* Recent access decisions: the key constructed by memo_key() ->
+     pointer to the svn_boolean_t result.  Allocated in MEMO_POOL. */
+  apr_hash_t *memo;
+  apr_pool_t *memo_pool;
+} authz_user_rules_t;
+
+/* The rights of one section as stored in the shared rules cache. */
+typedef struct authz_section_image_t
+{
+  const char *name;
+  authz_rights_t rights;
+} authz_section_image_t;
+
+/* Flat representation of the SECTIONS of an authz_user_rules_t as stored
+   in the shared rules cache. */
+typedef struct authz_rules_image_t
+{
+  /* Number of elements in SECTIONS. */
+  int count;
+  authz_section_image_t *sections;
+} authz_rules_image_t;
+
+/* Instances get created by svn_repos__authz_create(). */
 struct svn_authz_t
 {
   svn_config_t *cfg;
+
+  /* Serializes access to the members below and to the memos, since authz
+     objects may be shared between threads. */
+  svn_mutex__t *mutex;
+
+  /* User name -> authz_user_rules_t *, created on demand.  The rules for
+     anonymous access are in ANONYMOUS_RULES. */
+  apr_hash_t *user_rules;
+  authz_user_rules_t *anonymous_rules;
+
+  /* Pool used only for the compiled rules, while holding MUTEX. */
+  apr_pool_t *rules_pool;
+
+  /* If not NULL, compiled rules get shared through this cache with other
+     authz objects using the same configuration - in this or, if the cache
+     lives in shared memory, in other processes.  RULES_KEY identifies the
+     configuration contents in that cache.  Only used while holding MUTEX
+     and allocated in RULES_POOL. */
+  svn_cache__t *rules_cache;
+  const char *rules_key;
 };
 
 
-
+
 /*** Checking access. ***/
 
 /* Determine whether the REQUIRED access is granted given what authz
@@ -153,49 +212,50 @@ authz_alias_is_user(svn_config_t *cfg,
 }
 
 
-/* Return TRUE if USER is in GROUP.  The group definitions are in the
-   "groups" section of CFG.  Use POOL for temporary allocations during
-   the lookup. */
+/* Return TRUE if the user given by B is in GROUP.  The group definitions
+   are in the "groups" section of B->CONFIG.  Remember the result for
+   GROUP and all its sub-groups in B->GROUPS.  Use POOL for temporary
+   allocations during the lookup. */
 static svn_boolean_t
-authz_group_contains_user(svn_config_t *cfg,
+authz_group_contains_user(struct authz_lookup_baton *b,
                           const char *group,
-                          const char *user,
                           apr_pool_t *pool)
 {
   const char *value;
+  const char *known;
   apr_array_header_t *list;
+  svn_boolean_t contained = FALSE;
   int i;
 
-  svn_config_get(cfg, &value, "groups", group, NULL);
+  known = svn_hash_gets(b->groups, group);
+  if (known)
+    return *known == '\0';
+
+  svn_config_get(b->config, &value, "groups", group, NULL);
 
   list = svn_cstring_split(value, ",", TRUE, pool);
 
-  for (i = 0; i < list->nelts; i++)
+  for (i = 0; i < list->nelts && !contained; i++)
     {
       const char *group_user = APR_ARRAY_IDX(list, i, char *);
 
       /* If the 'user' is a subgroup, recurse into it. */
       if (*group_user == '@')
-        {
-          if (authz_group_contains_user(cfg, &group_user[1],
-                                        user, pool))
-            return TRUE;
-        }
+        contained = authz_group_contains_user(b, &group_user[1], pool);
 
       /* If the 'user' is an alias, verify it. */
       else if (*group_user == '&')
-        {
-          if (authz_alias_is_user(cfg, &group_user[1],
-                                  user, pool))
-            return TRUE;
-        }
+        contained = authz_alias_is_user(b->config, &group_user[1],
+                                        b->user, pool);
 
       /* If the user matches, stop. */
-      else if (strcmp(user, group_user) == 0)
-        return TRUE;
+      else
+        contained = strcmp(b->user, group_user) == 0;
     }
 
-  return FALSE;
+  svn_hash_sets(b->groups, apr_pstrdup(pool, group), contained ? "" : "-");
+
+  return contained;
 }
 
 
@@ -241,8 +301,7 @@ authz_line_applies_to_user(const char *rule_match_string,
    * a user, alias or group rule.
    */
   if (rule_match_string[0] == '@')
-    return authz_group_contains_user(
-      b->config, &rule_match_string[1], b->user, pool);
+    return authz_group_contains_user(b, &rule_match_string[1], pool);
   else if (rule_match_string[0] == '&')
     return authz_alias_is_user(
       b->config, &rule_match_string[1], b->user, pool);
@@ -279,201 +338,408 @@ authz_parse_line(const char *name, const char *value,
 }
 
 
-/* Return TRUE iff the access rules in SECTION_NAME apply to PATH_SPEC
- * (which is a repository name, colon, and repository fspath, such as
- * "myrepos:/trunk/foo").
+/* Callback to compile the rules of the section SECTION_NAME for the user
+ * given by the authz_lookup_baton BATON.  Implements the
+ * svn_config_section_enumerator2_t interface.
  */
 static svn_boolean_t
-is_applicable_section(const char *path_spec,
-                      const char *section_name)
+authz_compile_section(const char *section_name, void *baton,
+                      apr_pool_t *pool)
 {
-  apr_size_t path_spec_len = strlen(path_spec);
+  struct authz_lookup_baton *b = baton;
+  apr_pool_t *result_pool = apr_hash_pool_get(b->rules->sections);
+  authz_rights_t *rights;
 
-  return ((strncmp(path_spec, section_name, path_spec_len) == 0)
-          && (path_spec[path_spec_len - 1] == '/'
-              || section_name[path_spec_len] == '/'
-              || section_name[path_spec_len] == '\0'));
+  /* These don't contain access rules. */
+  if (   strcmp(section_name, SVN_CONFIG_SECTION_GROUPS) == 0
+      || strcmp(section_name, "aliases") == 0)
+    return TRUE;
+
+  /* Work out what this section grants. */
+  b->allow = b->deny = svn_authz_none;
+  svn_config_enumerate2(b->config, section_name, authz_parse_line, b, pool);
+
+  if (b->allow == svn_authz_none && b->deny == svn_authz_none)
+    return TRUE;
+
+  rights = apr_palloc(result_pool, sizeof(*rights));
+  rights->allow = b->allow;
+  rights->deny = b->deny;
+  svn_hash_sets(b->rules->sections, apr_pstrdup(result_pool, section_name),
+                rights);
+
+  return TRUE;
 }
 
 
-/* Callback to parse a section and update the authz_baton if the
- * section denies access to the subtree the baton describes.
+/* Implements svn_cache__serialize_func_t for authz_rules_image_t.
  */
-static svn_boolean_t
-authz_parse_section(const char *section_name, void *baton, apr_pool_t *pool)
+static svn_error_t *
+serialize_rules_image(void **data,
+                      apr_size_t *data_len,
+                      void *in,
+                      apr_pool_t *pool)
 {
-  struct authz_lookup_baton *b = baton;
-  svn_boolean_t conclusive;
+  authz_rules_image_t *image = in;
+  svn_temp_serializer__context_t *context;
+  svn_stringbuf_t *serialized;
+  int i;
 
-  /* Does the section apply to us? */
-  if (!is_applicable_section(b->qualified_repos_path, section_name)
-      && !is_applicable_section(b->repos_path, section_name))
-    return TRUE;
+  context = svn_temp_serializer__init(image, sizeof(*image),
+                                      image->count * 64 + 64, pool);
 
-  /* Work out what this section grants. */
-  b->allow = b->deny = 0;
-  svn_config_enumerate2(b->config, section_name,
-                        authz_parse_line, b, pool);
+  svn_temp_serializer__push(context,
+                            (const void * const *)&image->sections,
+                            image->count * sizeof(*image->sections));
+  for (i = 0; i < image->count; ++i)
+    svn_temp_serializer__add_string(context, &image->sections[i].name);
+  svn_temp_serializer__pop(context);
 
-  /* Has the section explicitly determined an access? */
-  conclusive = authz_access_is_determined(b->allow, b->deny,
-                                          b->required_access);
+  serialized = svn_temp_serializer__get(context);
+  *data = serialized->data;
+  *data_len = serialized->len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_cache__deserialize_func_t for authz_rules_image_t.
+ */
+static svn_error_t *
+deserialize_rules_image(void **out,
+                        void *data,
+                        apr_size_t data_len,
+                        apr_pool_t *pool)
+{
+  authz_rules_image_t *image = data;
+  int i;
 
-  /* Is access granted OR inconclusive? */
-  b->access = authz_access_is_granted(b->allow, b->deny,
-                                      b->required_access)
-    || !conclusive;
+  svn_temp_deserializer__resolve(image, (void **)&image->sections);
+  for (i = 0; i < image->count; ++i)
+    svn_temp_deserializer__resolve(image->sections,
+                                   (void **)&image->sections[i].name);
 
-  /* As long as access isn't conclusively denied, carry on. */
-  return b->access;
+  *out = image;
+  return SVN_NO_ERROR;
+}
+
+/* Return the key under which the rules of AUTHZ for USER, which may be
+ * NULL for anonymous access, are stored in AUTHZ->RULES_CACHE.  Allocate
+ * the result in POOL.
+ */
+static const char *
+rules_cache_key(svn_authz_t *authz,
+                const char *user,
+                apr_pool_t *pool)
+{
+  /* RULES_KEY is a hex string, so the separator is unambiguous. */
+  return user ? apr_pstrcat(pool, authz->rules_key, ":", user, SVN_VA_NULL)
+              : authz->rules_key;
+}
+
+/* Set *RULES to the compiled rules of AUTHZ for USER, which may be NULL
+ * for anonymous access.  Compile them if they are not known, yet, and not
+ * found in AUTHZ->RULES_CACHE, either.  The caller must hold AUTHZ->MUTEX.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+get_user_rules_locked(authz_user_rules_t **rules,
+                      svn_authz_t *authz,
+                      const char *user,
+                      apr_pool_t *scratch_pool)
+{
+  struct authz_lookup_baton baton = { 0 };
+  authz_rules_image_t *image = NULL;
+  const char *cache_key = NULL;
+  svn_boolean_t found = FALSE;
+
+  *rules = user ? svn_hash_gets(authz->user_rules, user)
+                : authz->anonymous_rules;
+  if (*rules)
+    return SVN_NO_ERROR;
+
+  baton.rules = apr_pcalloc(authz->rules_pool, sizeof(*baton.rules));
+  baton.rules->sections = apr_hash_make(authz->rules_pool);
+  baton.rules->memo_pool = svn_pool_create(authz->rules_pool);
+  baton.rules->memo = apr_hash_make(baton.rules->memo_pool);
+
+  /* Someone else using the same configuration may have done the work
+     for us already. */
+  if (authz->rules_cache)
+    {
+      cache_key = rules_cache_key(authz, user, scratch_pool);
+      SVN_ERR(svn_cache__get((void **)&image, &found, authz->rules_cache,
+                             cache_key, scratch_pool));
+    }
+
+  if (found)
+    {
+      int i;
+      for (i = 0; i < image->count; ++i)
+        {
+          authz_rights_t *rights = apr_pmemdup(authz->rules_pool,
+                                               &image->sections[i].rights,
+                                               sizeof(*rights));
+          svn_hash_sets(baton.rules->sections,
+                        apr_pstrdup(authz->rules_pool,
+                                    image->sections[i].name),
+                        rights);
+        }
+    }
+  else
+    {
+      baton.config = authz->cfg;
+      baton.user = user;
+      baton.groups = apr_hash_make(scratch_pool);
+
+      svn_config_enumerate_sections2(authz->cfg, authz_compile_section,
+                                     &baton, scratch_pool);
+
+      if (authz->rules_cache)
+        {
+          apr_hash_index_t *hi;
+          int i = 0;
+
+          image = apr_palloc(scratch_pool, sizeof(*image));
+          image->count = apr_hash_count(baton.rules->sections);
+          image->sections = apr_palloc(scratch_pool,
+                                       image->count
+                                         * sizeof(*image->sections));
+          for (hi = apr_hash_first(scratch_pool, baton.rules->sections);
+               hi;
+               hi = apr_hash_next(hi), ++i)
+            {
+              const authz_rights_t *rights = apr_hash_this_val(hi);
+              image->sections[i].name = apr_hash_this_key(hi);
+              image->sections[i].rights = *rights;
+            }
+
+          SVN_ERR(svn_cache__set(authz->rules_cache, cache_key, image,
+                                 scratch_pool));
+        }
+    }
+
+  if (user)
+    svn_hash_sets(authz->user_rules, apr_pstrdup(authz->rules_pool, user),
+                  baton.rules);
+  else
+    authz->anonymous_rules = baton.rules;
+
+  *rules = baton.rules;
+  return SVN_NO_ERROR;
+}
+
+/* Return the key under which the access decision for the parameters of
+ * svn_repos_authz_check_access() gets memoized.  Allocate it in POOL.
+ */
+static const char *
+memo_key(const char *repos_name,
+         const char *path,
+         svn_repos_authz_access_t required_access,
+         apr_pool_t *pool)
+{
+  /* Repository names may contain anything, so include its length. */
+  return apr_psprintf(pool, "%d %" APR_SIZE_T_FMT " %s%s",
+                      (int)required_access, strlen(repos_name), repos_name,
+                      path ? path : "");
+}
+
+/* Set *RULES to the compiled rules of AUTHZ for USER.  If the decision
+ * for KEY has been memoized, set *FOUND and *ACCESS_GRANTED accordingly.
+ * The caller must hold AUTHZ->MUTEX.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+static svn_error_t *
+memo_lookup_locked(authz_user_rules_t **rules,
+                   svn_boolean_t *found,
+                   svn_boolean_t *access_granted,
+                   svn_authz_t *authz,
+                   const char *user,
+                   const char *key,
+                   apr_pool_t *scratch_pool)
+{
+  const svn_boolean_t *memo;
+
+  SVN_ERR(get_user_rules_locked(rules, authz, user, scratch_pool));
+
+  memo = svn_hash_gets((*rules)->memo, key);
+  *found = memo != NULL;
+  if (memo)
+    *access_granted = *memo;
+
+  return SVN_NO_ERROR;
+}
+
+/* Memoize ACCESS_GRANTED as the decision for KEY in RULES.  The caller
+ * must hold the mutex of the authz object that RULES belong to.
+ */
+static svn_error_t *
+memo_store_locked(authz_user_rules_t *rules,
+                  const char *key,
+                  svn_boolean_t access_granted)
+{
+  static const svn_boolean_t decisions[2] = { FALSE, TRUE };
+
+  if (apr_hash_count(rules->memo) >= AUTHZ_MEMO_SIZE)
+    {
+      svn_pool_clear(rules->memo_pool);
+      rules->memo = apr_hash_make(rules->memo_pool);
+    }
+
+  svn_hash_sets(rules->memo, apr_pstrdup(rules->memo_pool, key),
+                &decisions[access_granted ? 1 : 0]);
+
+  return SVN_NO_ERROR;
 }
 
+/* Add RULES' rights for section SECTION_NAME to *ALLOW and *DENY. */
+static void
+add_section_rights(svn_repos_authz_access_t *allow,
+                   svn_repos_authz_access_t *deny,
+                   authz_user_rules_t *rules,
+                   const char *section_name)
+{
+  const authz_rights_t *rights = svn_hash_gets(rules->sections,
+                                               section_name);
+  if (rights)
+    {
+      *allow |= rights->allow;
+      *deny |= rights->deny;
+    }
+}
 
-/* Validate access to the given user for the given path.  This
- * function checks rules for exactly the given path, and first tries
- * to access a section specific to the given repository before falling
- * back to pan-repository rules.
+/* Return TRUE iff the access rules in SECTION_NAME apply to PATH_SPEC
+ * (which is a repository name, colon, and repository fspath, such as
+ * "myrepos:/trunk/foo").
+ */
+static svn_boolean_t
+is_applicable_section(const char *path_spec,
+                      const char *section_name)
+{
+  apr_size_t path_spec_len = strlen(path_spec);
+
+  return ((strncmp(path_spec, section_name, path_spec_len) == 0)
+          && (path_spec[path_spec_len - 1] == '/'
+              || section_name[path_spec_len] == '/'
+              || section_name[path_spec_len] == '\0'));
+}
+
+
+/* Validate access to the given user for the given path, using the
+ * user's compiled RULES.  This function checks rules for exactly the
+ * given path, and first tries to access a section specific to the given
+ * repository before falling back to pan-repository rules.
  *
  * Update *access_granted to inform the caller of the outcome of the
  * lookup.  Return a boolean indicating whether the access rights were
  * successfully determined.
  */
 static svn_boolean_t
-authz_get_path_access(svn_config_t *cfg, const char *repos_name,
-                      const char *path, const char *user,
+authz_get_path_access(authz_user_rules_t *rules, const char *repos_name,
+                      const char *path,
                       svn_repos_authz_access_t required_access,
                       svn_boolean_t *access_granted,
                       apr_pool_t *pool)
 {
-  const char *qualified_path;
-  struct authz_lookup_baton baton = { 0 };
-
-  baton.config = cfg;
-  baton.user = user;
+  svn_repos_authz_access_t allow = svn_authz_none;
+  svn_repos_authz_access_t deny = svn_authz_none;
 
   /* Try to locate a repository-specific block first. */
-  qualified_path = apr_pstrcat(pool, repos_name, ":", path, SVN_VA_NULL);
-  svn_config_enumerate2(cfg, qualified_path,
-                        authz_parse_line, &baton, pool);
+  add_section_rights(&allow, &deny, rules,
+                     apr_pstrcat(pool, repos_name, ":", path, SVN_VA_NULL));
 
-  *access_granted = authz_access_is_granted(baton.allow, baton.deny,
-                                            required_access);
+  *access_granted = authz_access_is_granted(allow, deny, required_access);
 
   /* If the first test has determined access, stop now. */
-  if (authz_access_is_determined(baton.allow, baton.deny,
-                                 required_access))
+  if (authz_access_is_determined(allow, deny, required_access))
     return TRUE;
 
   /* No repository specific rule, try pan-repository rules. */
-  svn_config_enumerate2(cfg, path, authz_parse_line, &baton, pool);
+  add_section_rights(&allow, &deny, rules, path);
 
-  *access_granted = authz_access_is_granted(baton.allow, baton.deny,
-                                            required_access);
-  return authz_access_is_determined(baton.allow, baton.deny,
-                                    required_access);
+  *access_granted = authz_access_is_granted(allow, deny, required_access);
+  return authz_access_is_determined(allow, deny, required_access);
 }
 
 
 /* Validate access to the given user for the subtree starting at the
- * given path.  This function walks the whole authz file in search of
- * rules applying to paths in the requested subtree which deny the
- * requested access.
+ * given path, using the user's compiled RULES.  Look for rules applying
+ * to paths in the requested subtree which deny the requested access.
  *
- * As soon as one is found, or else when the whole ACL file has been
- * searched, return the updated authorization status.
+ * As soon as one is found, or else when all rules have been searched,
+ * return the updated authorization status.
  */
 static svn_boolean_t
-authz_get_tree_access(svn_config_t *cfg, const char *repos_name,
-                      const char *path, const char *user,
+authz_get_tree_access(authz_user_rules_t *rules, const char *repos_name,
+                      const char *path,
                       svn_repos_authz_access_t required_access,
                       apr_pool_t *pool)
 {
-  struct authz_lookup_baton baton = { 0 };
-
-  baton.config = cfg;
-  baton.user = user;
-  baton.required_access = required_access;
-  baton.repos_path = path;
-  baton.qualified_repos_path = apr_pstrcat(pool, repos_name,
-                                           ":", path, SVN_VA_NULL);
-  /* Default to access granted if no rules say otherwise. */
-  baton.access = TRUE;
-
-  svn_config_enumerate_sections2(cfg, authz_parse_section,
-                                 &baton, pool);
-
-  return baton.access;
-}
-
-
-/* Callback to parse sections of the configuration file, looking for
-   any kind of granted access.  Implements the
-   svn_config_section_enumerator2_t interface. */
-static svn_boolean_t
-authz_get_any_access_parser_cb(const char *section_name, void *baton,
-                               apr_pool_t *pool)
-{
-  struct authz_lookup_baton *b = baton;
+  const char *qualified_path = apr_pstrcat(pool, repos_name, ":", path,
+                                           SVN_VA_NULL);
+  apr_hash_index_t *hi;
 
-  /* Does the section apply to the query? */
-  if (section_name[0] == '/'
-      || strncmp(section_name, b->qualified_repos_path,
-                 strlen(b->qualified_repos_path)) == 0)
+  for (hi = apr_hash_first(pool, rules->sections); hi; hi = apr_hash_next(hi))
     {
-      b->allow = b->deny = svn_authz_none;
-
-      svn_config_enumerate2(b->config, section_name,
-                            authz_parse_line, baton, pool);
-      b->access = authz_access_is_granted(b->allow, b->deny,
-                                          b->required_access);
-
-      /* Continue as long as we don't find a determined, granted access. */
-      return !(b->access
-               && authz_access_is_determined(b->allow, b->deny,
-                                             b->required_access));
+      const char *section_name = apr_hash_this_key(hi);
+      const authz_rights_t *rights = apr_hash_this_val(hi);
+
+      /* Does the section apply to us? */
+      if (!is_applicable_section(qualified_path, section_name)
+          && !is_applicable_section(path, section_name))
+        continue;
+
+      /* Stop if access is conclusively denied. */
+      if (authz_access_is_determined(rights->allow, rights->deny,
+                                     required_access)
+          && !authz_access_is_granted(rights->allow, rights->deny,
+                                      required_access))
+        return FALSE;
     }
 
+  /* Default to access granted if no rules say otherwise. */
   return TRUE;
 }
 
 
-/* Walk through the authz CFG to check if USER has the REQUIRED_ACCESS
+/* Check whether the user of the compiled RULES has the REQUIRED_ACCESS
  * to any path within the REPOSITORY.  Return TRUE if so.  Use POOL
  * for temporary allocations. */
 static svn_boolean_t
-authz_get_any_access(svn_config_t *cfg, const char *repos_name,
-                     const char *user,
+authz_get_any_access(authz_user_rules_t *rules, const char *repos_name,
                      svn_repos_authz_access_t required_access,
                      apr_pool_t *pool)
 {
-  struct authz_lookup_baton baton = { 0 };
-
-  baton.config = cfg;
-  baton.user = user;
-  baton.required_access = required_access;
-  baton.access = FALSE; /* Deny access by default. */
-  baton.repos_path = "/";
-  baton.qualified_repos_path = apr_pstrcat(pool, repos_name,
-                                           ":/", SVN_VA_NULL);
-
-  /* We could have used svn_config_enumerate2 for "repos_name:/".
-   * However, this requires access for root explicitly (which the user
-   * may not always have). So we end up enumerating the sections in
-   * the authz CFG and stop on the first match with some access for
-   * this user. */
-  svn_config_enumerate_sections2(cfg, authz_get_any_access_parser_cb,
-                                 &baton, pool);
-
-  /* If walking the configuration was inconclusive, deny access. */
-  if (!authz_access_is_determined(baton.allow,
-                                  baton.deny, baton.required_access))
-    return FALSE;
+  const char *qualified_root = apr_pstrcat(pool, repos_name, ":/",
+                                           SVN_VA_NULL);
+  apr_size_t qualified_root_len = strlen(qualified_root);
+  apr_hash_index_t *hi;
+
+  /* Looking up "repos_name:/" would require access for root explicitly
+   * (which the user may not always have).  So, look for any section in
+   * the repository that explicitly grants some access to this user. */
+  for (hi = apr_hash_first(pool, rules->sections); hi; hi = apr_hash_next(hi))
+    {
+      const char *section_name = apr_hash_this_key(hi);
+      const authz_rights_t *rights = apr_hash_this_val(hi);
+
+      /* Does the section apply to the query? */
+      if (section_name[0] != '/'
+          && strncmp(section_name, qualified_root, qualified_root_len) != 0)
+        continue;
+
+      if (authz_access_is_granted(rights->allow, rights->deny,
+                                  required_access)
+          && authz_access_is_determined(rights->allow, rights->deny,
+                                        required_access))
+        return TRUE;
+    }
 
-  return baton.access;
+  /* If no rule was conclusive, deny access. */
+  return FALSE;
 }
 
 
-
+
 /*** Validating the authz file. ***/
 
 /* Check for errors in GROUP's definition of CFG.  The errors
@@ -930,12 +1196,73 @@ authz_copy_groups(svn_authz_t *authz, svn_config_t *groups_cfg,
   return SVN_NO_ERROR;
 }
 
+/* Pool cleanup handler destroying the pool given by DATA. */
+static apr_status_t
+destroy_rules_pool(void *data)
+{
+  svn_pool_destroy(data);
+  return APR_SUCCESS;
+}
+
+svn_error_t *
+svn_repos__authz_create(svn_authz_t **authz_p,
+                        svn_config_t *cfg,
+                        const svn_membuf_t *key,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool)
+{
+  svn_authz_t *authz = apr_pcalloc(result_pool, sizeof(*authz));
+  svn_membuffer_t *membuffer = svn_cache__get_global_membuffer_cache();
+
+  authz->cfg = cfg;
+  SVN_ERR(svn_mutex__init(&authz->mutex, TRUE, result_pool));
+
+  /* Rules get compiled while AUTHZ may be shared between threads, so they
+     can't be allocated in RESULT_POOL.  Give them a pool of their own that
+     is only used while holding the mutex. */
+  authz->rules_pool
+    = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  apr_pool_cleanup_register(result_pool, authz->rules_pool,
+                            destroy_rules_pool, apr_pool_cleanup_null);
+  authz->user_rules = apr_hash_make(authz->rules_pool);
+
+  /* Without a key identifying the contents of CFG, we can't tell whether
+     cached rules would apply. */
+  if (key && key->size && membuffer)
+    {
+      static const char hex[] = "0123456789abcdef";
+      const unsigned char *data = key->data;
+      char *rules_key = apr_palloc(authz->rules_pool, 2 * key->size + 1);
+      apr_size_t i;
+
+      for (i = 0; i < key->size; ++i)
+        {
+          rules_key[2 * i] = hex[data[i] >> 4];
+          rules_key[2 * i + 1] = hex[data[i] & 0xf];
+        }
+      rules_key[2 * key->size] = '\0';
+      authz->rules_key = rules_key;
+
+      SVN_ERR(svn_cache__create_membuffer_cache(
+                &authz->rules_cache, membuffer,
+                serialize_rules_image, deserialize_rules_image,
+                APR_HASH_KEY_STRING, "AUTHZ_RULES",
+                SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                FALSE, FALSE, authz->rules_pool, scratch_pool));
+    }
+
+  *authz_p = authz;
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_repos__authz_read(svn_authz_t **authz_p, const char *path,
                       const char *groups_path, svn_boolean_t must_exist,
                       svn_boolean_t accept_urls, apr_pool_t *pool)
 {
-  svn_authz_t *authz = apr_palloc(pool, sizeof(*authz));
+  svn_authz_t *authz;
+
+  SVN_ERR(svn_repos__authz_create(&authz, NULL, NULL, pool, pool));
 
   /* Load the authz file */
   if (accept_urls)
@@ -994,7 +1321,9 @@ svn_error_t *
 svn_repos_authz_parse(svn_authz_t **authz_p, svn_stream_t *stream,
                       svn_stream_t *groups_stream, apr_pool_t *pool)
 {
-  svn_authz_t *authz = apr_palloc(pool, sizeof(*authz));
+  svn_authz_t *authz;
+
+  SVN_ERR(svn_repos__authz_create(&authz, NULL, NULL, pool, pool));
 
   /* Parse the authz stream */
   SVN_ERR(svn_config_parse(&authz->cfg, stream, TRUE, TRUE, pool));
@@ -1024,16 +1353,29 @@ svn_repos_authz_check_access(svn_authz_t *authz, const char *repos_name,
                              svn_boolean_t *access_granted,
                              apr_pool_t *pool)
 {
+  authz_user_rules_t *rules;
   const char *current_path;
+  const char *key;
+  svn_boolean_t found;
 
   if (!repos_name)
     repos_name = "";
 
+  /* Repeated checks are common, e.g. while walking a tree. */
+  key = memo_key(repos_name, path, required_access, pool);
+  SVN_MUTEX__WITH_LOCK(authz->mutex,
+                       memo_lookup_locked(&rules, &found, access_granted,
+                                          authz, user, key, pool));
+  if (found)
+    return SVN_NO_ERROR;
+
   /* If PATH is NULL, check if the user has *any* access. */
   if (!path)
     {
-      *access_granted = authz_get_any_access(authz->cfg, repos_name,
-                                             user, required_access, pool);
+      *access_granted = authz_get_any_access(rules, repos_name,
+                                             required_access, pool);
+      SVN_MUTEX__WITH_LOCK(authz->mutex,
+                           memo_store_locked(rules, key, *access_granted));
       return SVN_NO_ERROR;
     }
 
@@ -1044,8 +1386,8 @@ svn_repos_authz_check_access(svn_authz_t *authz, const char *repos_name,
   path = svn_fspath__canonicalize(path, pool);
   current_path = path;
 
-  while (!authz_get_path_access(authz->cfg, repos_name,
-                                current_path, user,
+  while (!authz_get_path_access(rules, repos_name,
+                                current_path,
                                 required_access,
                                 access_granted,
                                 pool))
@@ -1056,7 +1398,7 @@ svn_repos_authz_check_access(svn_authz_t *authz, const char *repos_name,
         {
           /* Deny access by default. */
           *access_granted = FALSE;
-          return SVN_NO_ERROR;
+          break;
         }
 
       /* Work back to the parent path. */
@@ -1064,11 +1406,236 @@ svn_repos_authz_check_access(svn_authz_t *authz, const char *repos_name,
     }
 
   /* If the caller requested recursive access, we need to walk through
-     the entire authz config to see whether any child paths are denied
-     to the requested user. */
+     all rules of the user to see whether any child paths are denied
+     to them. */
   if (*access_granted && (required_access & svn_authz_recursive))
-    *access_granted = authz_get_tree_access(authz->cfg, repos_name, path,
-                                            user, required_access, pool);
+    *access_granted = authz_get_tree_access(rules, repos_name, path,
+                                            required_access, pool);
+
+  SVN_MUTEX__WITH_LOCK(authz->mutex,
+                       memo_store_locked(rules, key, *access_granted));
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_repos_authz_check_access_batch(svn_authz_t *authz,
+                                   const char *repos_name,
+                                   const apr_array_header_t *paths,
+                                   const char *user,
+                                   svn_repos_authz_access_t required_access,
+                                   svn_boolean_t *access_granted,
+                                   apr_pool_t *pool)
+{
+  static const svn_boolean_t decisions[2] = { FALSE, TRUE };
+  authz_user_rules_t *rules;
+  apr_hash_t *decided = apr_hash_make(pool);
+  apr_array_header_t *undecided = apr_array_make(pool, 8,
+                                                 sizeof(const char *));
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i, k;
+
+  if (!repos_name)
+    repos_name = "";
+
+  SVN_MUTEX__WITH_LOCK(authz->mutex,
+                       get_user_rules_locked(&rules, authz, user, pool));
+
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      const char *current_path;
+      const svn_boolean_t *known;
+      svn_boolean_t granted;
+
+      svn_pool_clear(iterpool);
+
+      /* Sanity check. */
+      SVN_ERR_ASSERT(path && path[0] == '/');
+
+      /* Walk up like svn_repos_authz_check_access() but stop at the first
+         path decided before.  A path without applicable rules gets the
+         same decision as its parent, so everything walked through gets
+         the final decision.  Siblings will thus share the work for their
+         common parents. */
+      path = svn_fspath__canonicalize(path, pool);
+      current_path = path;
+      apr_array_clear(undecided);
+
+      while (TRUE)
+        {
+          known = svn_hash_gets(decided, current_path);
+          if (known)
+            {
+              granted = *known;
+              break;
+            }
+
+          APR_ARRAY_PUSH(undecided, const char *) = current_path;
+          if (authz_get_path_access(rules, repos_name, current_path,
+                                    required_access, &granted, iterpool))
+            break;
+
+          /* Deny access by default. */
+          if (current_path[0] == '/' && current_path[1] == '\0')
+            {
+              granted = FALSE;
+              break;
+            }
+
+          current_path = svn_fspath__dirname(current_path, pool);
+        }
+
+      for (k = 0; k < undecided->nelts; ++k)
+        svn_hash_sets(decided, APR_ARRAY_IDX(undecided, k, const char *),
+                      &decisions[granted ? 1 : 0]);
+
+      /* The recursive part depends on the rules below PATH and can't be
+         shared. */
+      if (granted && (required_access & svn_authz_recursive))
+        granted = authz_get_tree_access(rules, repos_name, path,
+                                        required_access, iterpool);
+
+      access_granted[i] = granted;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+
+
+/*** Batched read authorization callbacks. ***/
+
+/* Baton type created by svn_repos__authz_batch_wrap(). */
+typedef struct authz_batch_baton_t
+{
+  svn_repos_authz_func_t authz_read_func;
+  svn_repos__authz_batch_func_t batch_func;
+  void *baton;
+} authz_batch_baton_t;
+
+/* An element of the array that svn_repos__authz_read_paths() sorts. */
+typedef struct indexed_path_t
+{
+  const char *path;
+  int index;
+} indexed_path_t;
+
+/* Implements svn_repos_authz_func_t for the authz_batch_baton_t BATON
+ * by forwarding to the single path callback.
+ */
+static svn_error_t *
+authz_batch_read_func(svn_boolean_t *allowed,
+                      svn_fs_root_t *root,
+                      const char *path,
+                      void *baton,
+                      apr_pool_t *pool)
+{
+  authz_batch_baton_t *b = baton;
+
+  return svn_error_trace(b->authz_read_func(allowed, root, path, b->baton,
+                                            pool));
+}
+
+/* Sort function for indexed_path_t elements, ordering by path. */
+static int
+compare_indexed_paths(const void *lhs,
+                      const void *rhs)
+{
+  const indexed_path_t *a = lhs;
+  const indexed_path_t *b = rhs;
+
+  return svn_path_compare_paths(a->path, b->path);
+}
+
+void
+svn_repos__authz_batch_wrap(svn_repos_authz_func_t *authz_func,
+                            void **authz_baton,
+                            svn_repos_authz_func_t authz_read_func,
+                            svn_repos__authz_batch_func_t batch_func,
+                            void *baton,
+                            apr_pool_t *result_pool)
+{
+  authz_batch_baton_t *b;
+
+  if (!authz_read_func)
+    {
+      *authz_func = NULL;
+      *authz_baton = baton;
+      return;
+    }
+
+  b = apr_palloc(result_pool, sizeof(*b));
+  b->authz_read_func = authz_read_func;
+  b->batch_func = batch_func;
+  b->baton = baton;
+
+  *authz_func = authz_batch_read_func;
+  *authz_baton = b;
+}
+
+svn_error_t *
+svn_repos__authz_read_paths(svn_boolean_t *allowed,
+                            svn_fs_root_t *root,
+                            const apr_array_header_t *paths,
+                            svn_repos_authz_func_t authz_read_func,
+                            void *authz_read_baton,
+                            apr_pool_t *scratch_pool)
+{
+  int i;
+
+  if (authz_read_func == authz_batch_read_func)
+    {
+      authz_batch_baton_t *b = authz_read_baton;
+      apr_array_header_t *sorted;
+      apr_array_header_t *sorted_paths;
+      svn_boolean_t *sorted_allowed;
+
+      if (paths->nelts == 0)
+        return SVN_NO_ERROR;
+
+      sorted = apr_array_make(scratch_pool, paths->nelts,
+                              sizeof(indexed_path_t));
+      for (i = 0; i < paths->nelts; ++i)
+        {
+          indexed_path_t *entry = apr_array_push(sorted);
+          entry->path = APR_ARRAY_IDX(paths, i, const char *);
+          entry->index = i;
+        }
+      svn_sort__array(sorted, compare_indexed_paths);
+
+      sorted_paths = apr_array_make(scratch_pool, paths->nelts,
+                                    sizeof(const char *));
+      for (i = 0; i < sorted->nelts; ++i)
+        APR_ARRAY_PUSH(sorted_paths, const char *)
+          = APR_ARRAY_IDX(sorted, i, indexed_path_t).path;
+
+      sorted_allowed = apr_palloc(scratch_pool,
+                                  paths->nelts * sizeof(*sorted_allowed));
+      SVN_ERR(b->batch_func(sorted_allowed, root, sorted_paths, b->baton,
+                            scratch_pool));
+
+      for (i = 0; i < sorted->nelts; ++i)
+        allowed[APR_ARRAY_IDX(sorted, i, indexed_path_t).index]
+          = sorted_allowed[i];
+    }
+  else
+    {
+      apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+      for (i = 0; i < paths->nelts; ++i)
+        {
+          svn_pool_clear(iterpool);
+          SVN_ERR(authz_read_func(&allowed[i], root,
+                                  APR_ARRAY_IDX(paths, i, const char *),
+                                  authz_read_baton, iterpool));
+        }
+
+      svn_pool_destroy(iterpool);
+    }
 
   return SVN_NO_ERROR;
 }
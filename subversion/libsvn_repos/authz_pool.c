@@ -38,13 +38,6 @@
 
 #include "repos.h"
 
-/* Currently this structure is just a wrapper around a svn_config_t.
- */
-struct svn_authz_t
-{
-  svn_config_t *cfg;
-};
-
 /* The wrapper object structure that we store in the object pool.  It
  * combines the authz with the underlying config structures and their
  * identifying keys.
@@ -192,14 +185,16 @@ svn_repos__authz_pool_get(svn_authz_t **authz_p,
       return SVN_NO_ERROR;
     }
 
-  authz_ref->authz = apr_palloc(authz_ref_pool, sizeof(*authz_ref->authz));
-  authz_ref->authz->cfg = authz_ref->authz_cfg;
+  /* The key covers the groups file as well, so the compiled rules can
+     be shared with other processes using the same files. */
+  SVN_ERR(svn_repos__authz_create(&authz_ref->authz, authz_ref->authz_cfg,
+                                  authz_ref->key, authz_ref_pool, pool));
 
   if (groups_path)
     {
       /* Easy out: we prohibit local groups in the authz file when global
          groups are being used. */
-      if (svn_config_has_section(authz_ref->authz->cfg,
+      if (svn_config_has_section(authz_ref->authz_cfg,
                                  SVN_CONFIG_SECTION_GROUPS))
         return svn_error_createf(SVN_ERR_AUTHZ_INVALID_CONFIG, NULL,
                                  "Error reading authz file '%s' with "
@@ -210,7 +205,7 @@ svn_repos__authz_pool_get(svn_authz_t **authz_p,
 
       /* We simply need to add the [Groups] section to the authz config.
        */
-      svn_config__shallow_replace_section(authz_ref->authz->cfg,
+      svn_config__shallow_replace_section(authz_ref->authz_cfg,
                                           authz_ref->groups_cfg,
                                           SVN_CONFIG_SECTION_GROUPS);
     }
@@ -0,0 +1,773 @@
+/* blame.c : calculating line attribution in the repository
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include <apr_pools.h>
+#include <apr_strings.h>
+
+#include "svn_pools.h"
+#include "svn_error.h"
+#include "svn_dirent_uri.h"
+#include "svn_diff.h"
+#include "svn_fs.h"
+#include "svn_io.h"
+#include "svn_repos.h"
+
+#include "private/svn_cache.h"
+#include "private/svn_temp_serializer.h"
+#include "svn_private_config.h"
+
+#include "repos.h"
+
+
+
+/* The blame chain below works like the one in libsvn_client/blame.c.
+ * It is kept in sync with it, so that both sides attribute lines the
+ * same way. */
+
+/* One chunk of blame */
+typedef struct blame_t
+{
+  svn_revnum_t revision;    /* the responsible revision */
+  apr_off_t start;          /* the starting diff-token (line) */
+  struct blame_t *next;     /* the next chunk */
+} blame_t;
+
+/* A chain of blame chunks */
+typedef struct blame_chain_t
+{
+  blame_t *blame;           /* linked list of blame chunks */
+  blame_t *avail;           /* linked list of free blame chunks */
+  apr_pool_t *pool;         /* Allocate members from this pool. */
+} blame_chain_t;
+
+/* The baton use for the diff output routine. */
+typedef struct diff_baton_t
+{
+  blame_chain_t *chain;
+  svn_revnum_t revision;
+} diff_baton_t;
+
+/* Return a blame chunk associated with REVISION for a change starting
+   at token START, and allocated in CHAIN->pool. */
+static blame_t *
+blame_create(blame_chain_t *chain,
+             svn_revnum_t revision,
+             apr_off_t start)
+{
+  blame_t *blame;
+  if (chain->avail)
+    {
+      blame = chain->avail;
+      chain->avail = blame->next;
+    }
+  else
+    blame = apr_palloc(chain->pool, sizeof(*blame));
+  blame->revision = revision;
+  blame->start = start;
+  blame->next = NULL;
+  return blame;
+}
+
+/* Destroy a blame chunk. */
+static void
+blame_destroy(blame_chain_t *chain,
+              blame_t *blame)
+{
+  blame->next = chain->avail;
+  chain->avail = blame;
+}
+
+/* Return the blame chunk that contains token OFF, starting the search at
+   BLAME. */
+static blame_t *
+blame_find(blame_t *blame, apr_off_t off)
+{
+  blame_t *prev = NULL;
+  while (blame)
+    {
+      if (blame->start > off) break;
+      prev = blame;
+      blame = blame->next;
+    }
+  return prev;
+}
+
+/* Shift the start-point of BLAME and all subsequence blame-chunks
+   by ADJUST tokens */
+static void
+blame_adjust(blame_t *blame, apr_off_t adjust)
+{
+  while (blame)
+    {
+      blame->start += adjust;
+      blame = blame->next;
+    }
+}
+
+/* Delete the blame associated with the region from token START to
+   START + LENGTH */
+static void
+blame_delete_range(blame_chain_t *chain,
+                   apr_off_t start,
+                   apr_off_t length)
+{
+  blame_t *first = blame_find(chain->blame, start);
+  blame_t *last = blame_find(chain->blame, start + length);
+  blame_t *tail = last->next;
+
+  if (first != last)
+    {
+      blame_t *walk = first->next;
+      while (walk != last)
+        {
+          blame_t *next = walk->next;
+          blame_destroy(chain, walk);
+          walk = next;
+        }
+      first->next = last;
+      last->start = start;
+      if (first->start == start)
+        {
+          *first = *last;
+          blame_destroy(chain, last);
+          last = first;
+        }
+    }
+
+  if (tail && tail->start == last->start + length)
+    {
+      *last = *tail;
+      blame_destroy(chain, tail);
+      tail = last->next;
+    }
+
+  blame_adjust(tail, -length);
+}
+
+/* Insert a chunk of blame associated with REVISION starting
+   at token START and continuing for LENGTH tokens */
+static void
+blame_insert_range(blame_chain_t *chain,
+                   svn_revnum_t revision,
+                   apr_off_t start,
+                   apr_off_t length)
+{
+  blame_t *head = chain->blame;
+  blame_t *point = blame_find(head, start);
+  blame_t *insert;
+
+  if (point->start == start)
+    {
+      insert = blame_create(chain, point->revision, point->start + length);
+      point->revision = revision;
+      insert->next = point->next;
+      point->next = insert;
+    }
+  else
+    {
+      blame_t *middle;
+      middle = blame_create(chain, revision, start);
+      insert = blame_create(chain, point->revision, start + length);
+      middle->next = insert;
+      insert->next = point->next;
+      point->next = middle;
+    }
+  blame_adjust(insert->next, length);
+}
+
+/* Callback for diff between subsequent revisions */
+static svn_error_t *
+output_diff_modified(void *baton,
+                     apr_off_t original_start,
+                     apr_off_t original_length,
+                     apr_off_t modified_start,
+                     apr_off_t modified_length,
+                     apr_off_t latest_start,
+                     apr_off_t latest_length)
+{
+  diff_baton_t *db = baton;
+
+  if (original_length)
+    blame_delete_range(db->chain, modified_start, original_length);
+
+  if (modified_length)
+    blame_insert_range(db->chain, db->revision, modified_start,
+                       modified_length);
+
+  return SVN_NO_ERROR;
+}
+
+static const svn_diff_output_fns_t output_fns = {
+        NULL,
+        output_diff_modified
+};
+
+
+
+/* One range of lines, starting at line START, last changed in REVISION. */
+typedef struct blame_chunk_t
+{
+  apr_int64_t start;
+  svn_revnum_t revision;
+} blame_chunk_t;
+
+/* An interesting location in the history of the blamed file. */
+typedef struct blame_location_t
+{
+  svn_revnum_t revision;
+  const char *path;
+} blame_location_t;
+
+/* The line attribution of a file as stored in the blame cache. */
+typedef struct blame_result_t
+{
+  /* Number of elements in CHUNKS. */
+  int chunk_count;
+
+  /* The ranges of lines in ascending order. */
+  blame_chunk_t *chunks;
+
+  /* Number of elements in LOCATIONS. */
+  int location_count;
+
+  /* The history of the file that the result has been calculated from,
+     youngest first.  A user may only see the result if all of these
+     are readable to them. */
+  blame_location_t *locations;
+} blame_result_t;
+
+/* Implements svn_cache__serialize_func_t for blame_result_t.
+ */
+static svn_error_t *
+serialize_blame_result(void **data,
+                       apr_size_t *data_len,
+                       void *in,
+                       apr_pool_t *pool)
+{
+  blame_result_t *result = in;
+  svn_temp_serializer__context_t *context;
+  svn_stringbuf_t *serialized;
+  int i;
+
+  context = svn_temp_serializer__init(result, sizeof(*result),
+                                      result->chunk_count
+                                        * sizeof(*result->chunks)
+                                      + result->location_count * 64 + 64,
+                                      pool);
+
+  svn_temp_serializer__add_leaf(context,
+                                (const void * const *)&result->chunks,
+                                result->chunk_count
+                                  * sizeof(*result->chunks));
+
+  svn_temp_serializer__push(context,
+                            (const void * const *)&result->locations,
+                            result->location_count
+                              * sizeof(*result->locations));
+  for (i = 0; i < result->location_count; ++i)
+    svn_temp_serializer__add_string(context, &result->locations[i].path);
+  svn_temp_serializer__pop(context);
+
+  serialized = svn_temp_serializer__get(context);
+  *data = serialized->data;
+  *data_len = serialized->len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_cache__deserialize_func_t for blame_result_t.
+ */
+static svn_error_t *
+deserialize_blame_result(void **out,
+                         void *data,
+                         apr_size_t data_len,
+                         apr_pool_t *pool)
+{
+  blame_result_t *result = data;
+  int i;
+
+  svn_temp_deserializer__resolve(result, (void **)&result->chunks);
+  svn_temp_deserializer__resolve(result, (void **)&result->locations);
+  for (i = 0; i < result->location_count; ++i)
+    svn_temp_deserializer__resolve(result->locations,
+                                   (void **)&result->locations[i].path);
+
+  *out = result;
+  return SVN_NO_ERROR;
+}
+
+/* Set *CACHE to the cache of blame results in the global membuffer cache
+ * and *KEY to the key of the blame of PATH in REPOS for the revision range
+ * START to END and the given DIFF_OPTIONS.  If there is no global cache,
+ * set *CACHE to NULL.  Allocate the results in POOL.
+ */
+static svn_error_t *
+get_blame_cache(svn_cache__t **cache,
+                const char **key,
+                svn_repos_t *repos,
+                const char *path,
+                svn_revnum_t start,
+                svn_revnum_t end,
+                const svn_diff_file_options_t *diff_options,
+                apr_pool_t *pool)
+{
+  svn_membuffer_t *membuffer = svn_cache__get_global_membuffer_cache();
+  const char *uuid;
+  const char *repos_abspath;
+
+  *cache = NULL;
+  if (!membuffer)
+    return SVN_NO_ERROR;
+
+  /* Revisions are immutable, so the repository, the file and the options
+     identify the result.  The length of the repository path keeps it
+     apart from PATH. */
+  SVN_ERR(svn_fs_get_uuid(repos->fs, &uuid, pool));
+  SVN_ERR(svn_dirent_get_absolute(&repos_abspath, repos->path, pool));
+  *key = apr_psprintf(pool, "%s:%ld:%ld:%d:%d:%d:%" APR_SIZE_T_FMT ":%s%s",
+                      uuid, start, end, (int)diff_options->ignore_space,
+                      diff_options->ignore_eol_style,
+                      (int)diff_options->algorithm,
+                      strlen(repos_abspath), repos_abspath, path);
+
+  SVN_ERR(svn_cache__create_membuffer_cache(
+            cache, membuffer,
+            serialize_blame_result, deserialize_blame_result,
+            APR_HASH_KEY_STRING, "REPOS_BLAME",
+            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+            FALSE, FALSE, pool, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *READABLE to TRUE if AUTHZ_READ_FUNC with AUTHZ_READ_BATON allows
+ * access to all locations in RESULT.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+static svn_error_t *
+check_locations(svn_boolean_t *readable,
+                svn_repos_t *repos,
+                const blame_result_t *result,
+                svn_repos_authz_func_t authz_read_func,
+                void *authz_read_baton,
+                apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  *readable = TRUE;
+  for (i = 0; i < result->location_count && *readable; ++i)
+    {
+      svn_fs_root_t *root;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_revision_root(&root, repos->fs,
+                                   result->locations[i].revision, iterpool));
+      SVN_ERR(authz_read_func(readable, root, result->locations[i].path,
+                              authz_read_baton, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* Walk the history of PATH in REPOS from END back to the youngest
+ * interesting revision before START and return the locations, youngest
+ * first, as blame_location_t in *LOCATIONS.  Stop at the first location
+ * that AUTHZ_READ_FUNC, if not NULL, rejects and set *COMPLETE to FALSE
+ * in that case; otherwise set it to TRUE.  This is the same walk that
+ * svn_repos_get_file_revs2() does without merged revisions.
+ *
+ * Allocate the result in RESULT_POOL and use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+find_history(apr_array_header_t **locations,
+             svn_boolean_t *complete,
+             svn_repos_t *repos,
+             const char *path,
+             svn_revnum_t start,
+             svn_revnum_t end,
+             svn_repos_authz_func_t authz_read_func,
+             void *authz_read_baton,
+             svn_cancel_func_t cancel_func,
+             void *cancel_baton,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool, *last_pool;
+  svn_fs_history_t *history;
+  svn_fs_root_t *root;
+  svn_node_kind_t kind;
+
+  *locations = apr_array_make(result_pool, 16, sizeof(blame_location_t));
+  *complete = TRUE;
+
+  /* We switch between two pools while looping, since we need information from
+     the last iteration to be available. */
+  iterpool = svn_pool_create(scratch_pool);
+  last_pool = svn_pool_create(scratch_pool);
+
+  /* The path had better be a file in this revision. */
+  SVN_ERR(svn_fs_revision_root(&root, repos->fs, end, scratch_pool));
+  SVN_ERR(svn_fs_check_path(&kind, root, path, scratch_pool));
+  if (kind != svn_node_file)
+    return svn_error_createf
+      (SVN_ERR_FS_NOT_FILE, NULL, _("'%s' is not a file in revision %ld"),
+       path, end);
+
+  SVN_ERR(svn_fs_node_history2(&history, root, path, scratch_pool,
+                               scratch_pool));
+  while (1)
+    {
+      blame_location_t *location;
+      svn_revnum_t tmp_revnum;
+      const char *tmp_path;
+      apr_pool_t *tmp_pool;
+
+      svn_pool_clear(iterpool);
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(svn_fs_history_prev2(&history, history, TRUE, iterpool,
+                                   iterpool));
+      if (!history)
+        break;
+      SVN_ERR(svn_fs_history_location(&tmp_path, &tmp_revnum,
+                                      history, iterpool));
+
+      if (authz_read_func)
+        {
+          svn_boolean_t readable;
+          svn_fs_root_t *tmp_root;
+
+          SVN_ERR(svn_fs_revision_root(&tmp_root, repos->fs, tmp_revnum,
+                                       iterpool));
+          SVN_ERR(authz_read_func(&readable, tmp_root, tmp_path,
+                                  authz_read_baton, iterpool));
+          if (! readable)
+            {
+              *complete = FALSE;
+              break;
+            }
+        }
+
+      location = apr_array_push(*locations);
+      location->revision = tmp_revnum;
+      location->path = apr_pstrdup(result_pool, tmp_path);
+
+      /* The first revision before START tells us which lines already
+         existed at START. */
+      if (tmp_revnum < start)
+        break;
+
+      /* Swap pools. */
+      tmp_pool = iterpool;
+      iterpool = last_pool;
+      last_pool = tmp_pool;
+    }
+
+  svn_pool_destroy(iterpool);
+  svn_pool_destroy(last_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *LINES to the number of lines in the file FILENAME, counting lines
+ * the same way svn_diff_file_diff_2() does.  Use SCRATCH_POOL for
+ * temporary allocations.
+ */
+static svn_error_t *
+count_lines(apr_int64_t *lines,
+            const char *filename,
+            apr_pool_t *scratch_pool)
+{
+  svn_stream_t *stream;
+  char *buffer = apr_palloc(scratch_pool, SVN__STREAM_CHUNK_SIZE);
+  char last = '\n';
+  apr_size_t len;
+
+  *lines = 0;
+  SVN_ERR(svn_stream_open_readonly(&stream, filename, scratch_pool,
+                                   scratch_pool));
+  do
+    {
+      apr_size_t i;
+
+      len = SVN__STREAM_CHUNK_SIZE;
+      SVN_ERR(svn_stream_read_full(stream, buffer, &len));
+
+      /* CR, LF and CRLF all end a line. */
+      for (i = 0; i < len; ++i)
+        {
+          if (buffer[i] == '\r'
+              || (buffer[i] == '\n' && last != '\r'))
+            ++*lines;
+          last = buffer[i];
+        }
+    }
+  while (len == SVN__STREAM_CHUNK_SIZE);
+
+  /* A last line without EOL counts, too. */
+  if (last != '\n' && last != '\r')
+    ++*lines;
+
+  return svn_error_trace(svn_stream_close(stream));
+}
+
+/* Calculate the blame for the history LOCATIONS of a file in REPOS as
+ * returned by find_history() for START and return it in *RESULT.  Compare
+ * revisions using DIFF_OPTIONS.
+ *
+ * Allocate the result in RESULT_POOL and use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+calculate_blame(blame_result_t **result,
+                svn_repos_t *repos,
+                apr_array_header_t *locations,
+                svn_revnum_t start,
+                const svn_diff_file_options_t *diff_options,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  blame_chain_t chain = { NULL };
+  svn_fs_root_t *last_root = NULL;
+  const char *last_path = NULL;
+  const char *last_filename = NULL;
+  apr_pool_t *last_pool = svn_pool_create(scratch_pool);
+  apr_pool_t *curr_pool = svn_pool_create(scratch_pool);
+  blame_t *walk;
+  apr_int64_t lines;
+  int count;
+  int i;
+
+  chain.pool = scratch_pool;
+
+  /* Diff the revisions from oldest to youngest. */
+  for (i = locations->nelts - 1; i >= 0; --i)
+    {
+      const blame_location_t *location
+        = &APR_ARRAY_IDX(locations, i, blame_location_t);
+      svn_revnum_t revision = location->revision >= start
+                            ? location->revision
+                            : SVN_INVALID_REVNUM;
+      svn_fs_root_t *root;
+      svn_stream_t *contents, *file;
+      const char *filename;
+
+      svn_pool_clear(curr_pool);
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(svn_fs_revision_root(&root, repos->fs, location->revision,
+                                   curr_pool));
+
+      /* Revisions that did not touch the contents can't change the
+         attribution of any line. */
+      if (last_root)
+        {
+          svn_boolean_t different;
+          SVN_ERR(svn_fs_contents_different(&different, last_root, last_path,
+                                            root, location->path,
+                                            curr_pool));
+          if (!different)
+            continue;
+        }
+
+      SVN_ERR(svn_fs_file_contents(&contents, root, location->path,
+                                   curr_pool));
+      SVN_ERR(svn_stream_open_unique(&file, &filename, NULL,
+                                     svn_io_file_del_on_pool_cleanup,
+                                     curr_pool, curr_pool));
+      SVN_ERR(svn_stream_copy3(contents, file, cancel_func, cancel_baton,
+                               curr_pool));
+
+      if (!last_filename)
+        {
+          chain.blame = blame_create(&chain, revision, 0);
+        }
+      else
+        {
+          svn_diff_t *diff;
+          diff_baton_t diff_baton;
+
+          diff_baton.chain = &chain;
+          diff_baton.revision = revision;
+
+          SVN_ERR(svn_diff_file_diff_2(&diff, last_filename, filename,
+                                       diff_options, curr_pool));
+          SVN_ERR(svn_diff_output2(diff, &diff_baton, &output_fns,
+                                   cancel_func, cancel_baton));
+        }
+
+      last_root = root;
+      last_path = location->path;
+      last_filename = filename;
+
+      /* Keep the current file and root around for the next revision. */
+      {
+        apr_pool_t *tmp_pool = last_pool;
+        last_pool = curr_pool;
+        curr_pool = tmp_pool;
+      }
+    }
+
+  /* Flatten the chain.  Chunks behind the last line are of no interest. */
+  SVN_ERR(count_lines(&lines, last_filename, scratch_pool));
+  *result = apr_pcalloc(result_pool, sizeof(**result));
+
+  for (count = 0, walk = chain.blame;
+       walk && walk->start < lines;
+       walk = walk->next)
+    ++count;
+
+  (*result)->chunk_count = count;
+  (*result)->chunks = apr_palloc(result_pool,
+                                 count * sizeof(*(*result)->chunks));
+  for (i = 0, walk = chain.blame; i < count; walk = walk->next, ++i)
+    {
+      (*result)->chunks[i].start = walk->start;
+      (*result)->chunks[i].revision = walk->revision;
+    }
+
+  (*result)->location_count = locations->nelts;
+  (*result)->locations = (blame_location_t *)locations->elts;
+
+  svn_pool_destroy(last_pool);
+  svn_pool_destroy(curr_pool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos_blame(svn_repos_t *repos,
+                const char *path,
+                svn_revnum_t start,
+                svn_revnum_t end,
+                const svn_diff_file_options_t *diff_options,
+                svn_repos_authz_func_t authz_read_func,
+                void *authz_read_baton,
+                svn_repos_blame_receiver_t receiver,
+                void *receiver_baton,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *scratch_pool)
+{
+  svn_cache__t *cache;
+  const char *key;
+  blame_result_t *result = NULL;
+  svn_boolean_t found = FALSE;
+  apr_hash_t *rev_props_cache;
+  apr_pool_t *iterpool;
+  int i;
+
+  if (!SVN_IS_VALID_REVNUM(end))
+    SVN_ERR(svn_fs_youngest_rev(&end, repos->fs, scratch_pool));
+  if (!SVN_IS_VALID_REVNUM(start))
+    start = 0;
+  if (start > end)
+    return svn_error_createf(SVN_ERR_INCORRECT_PARAMS, NULL,
+                             _("Start revision %ld is greater than "
+                               "end revision %ld"), start, end);
+
+  if (!diff_options)
+    diff_options = svn_diff_file_options_create(scratch_pool);
+
+  /* Make sure we catch up on the latest revprop changes. */
+  SVN_ERR(svn_fs_refresh_revision_props(repos->fs, scratch_pool));
+
+  SVN_ERR(get_blame_cache(&cache, &key, repos, path, start, end,
+                          diff_options, scratch_pool));
+  if (cache)
+    SVN_ERR(svn_cache__get((void **)&result, &found, cache, key,
+                           scratch_pool));
+
+  /* A cached result is only valid for users that can see all of the
+     history it has been calculated from.  Others get to see less. */
+  if (found && authz_read_func)
+    SVN_ERR(check_locations(&found, repos, result, authz_read_func,
+                            authz_read_baton, scratch_pool));
+
+  if (!found)
+    {
+      apr_array_header_t *locations;
+      svn_boolean_t complete;
+
+      SVN_ERR(find_history(&locations, &complete, repos, path, start, end,
+                           authz_read_func, authz_read_baton,
+                           cancel_func, cancel_baton,
+                           scratch_pool, scratch_pool));
+      if (locations->nelts == 0)
+        return svn_error_createf(SVN_ERR_AUTHZ_UNREADABLE, NULL,
+                                 _("Unreadable path encountered; "
+                                   "access denied"));
+
+      SVN_ERR(calculate_blame(&result, repos, locations, start,
+                              diff_options, cancel_func, cancel_baton,
+                              scratch_pool, scratch_pool));
+
+      /* Incomplete results depend on the user. */
+      if (cache && complete)
+        SVN_ERR(svn_cache__set(cache, key, result, scratch_pool));
+    }
+
+  /* Report the chunks with the revision props of their revisions.
+     Typically, many chunks belong to the same revision. */
+  rev_props_cache = apr_hash_make(scratch_pool);
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < result->chunk_count; ++i)
+    {
+      svn_revnum_t revision = result->chunks[i].revision;
+      apr_hash_t *rev_props = NULL;
+
+      svn_pool_clear(iterpool);
+
+      if (SVN_IS_VALID_REVNUM(revision))
+        {
+          rev_props = apr_hash_get(rev_props_cache, &revision,
+                                   sizeof(revision));
+          if (!rev_props)
+            {
+              svn_revnum_t *rev_key = apr_pmemdup(scratch_pool, &revision,
+                                                  sizeof(revision));
+              SVN_ERR(svn_repos_fs_revision_proplist(&rev_props, repos,
+                                                     revision,
+                                                     authz_read_func,
+                                                     authz_read_baton,
+                                                     scratch_pool));
+              apr_hash_set(rev_props_cache, rev_key, sizeof(*rev_key),
+                           rev_props);
+            }
+        }
+
+      SVN_ERR(receiver(receiver_baton, result->chunks[i].start, revision,
+                       rev_props, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
@@ -23,6 +23,8 @@
 
 
 #include <apr_hash.h>
+#include <apr_thread_proc.h>
+#include <apr_thread_cond.h>
 
 #include "svn_hash.h"
 #include "svn_types.h"
@@ -33,6 +35,7 @@
 #include "svn_repos.h"
 #include "svn_pools.h"
 #include "svn_props.h"
+#include "private/svn_mutex.h"
 #include "svn_private_config.h"
 #include "repos.h"
 
@@ -46,6 +49,17 @@
 /* Some datatypes and declarations used throughout the file.  */
 
 
+/* Change flags of a node that exists in both trees, determined ahead of
+   the editor drive.  */
+typedef struct node_changes_t
+{
+  svn_boolean_t props_changed;
+  svn_boolean_t contents_changed;
+} node_changes_t;
+
+/* The state of a parallel delta.  Only defined with thread support.  */
+typedef struct parallel_delta_t parallel_delta_t;
+
 /* Parameters which remain constant throughout a delta traversal.
    At the top of the recursion, we initialize one of these structures.
    Then we pass it down to every call.  This way, functions invoked
@@ -61,6 +75,7 @@ struct context {
   svn_boolean_t text_deltas;
   svn_boolean_t entry_props;
   svn_boolean_t ignore_ancestry;
+  parallel_delta_t *parallel;
 };
 
 
@@ -104,6 +119,7 @@ static svn_error_t *change_file_prop(struct context *c,
 static svn_error_t *delta_proplists(struct context *c,
                                     const char *source_path,
                                     const char *target_path,
+                                    const node_changes_t *changes,
                                     proplist_change_fn_t *change_fn,
                                     void *object,
                                     apr_pool_t *pool);
@@ -120,6 +136,7 @@ static svn_error_t *delta_files(struct context *c,
                                 void *file_baton,
                                 const char *source_path,
                                 const char *target_path,
+                                const node_changes_t *changes,
                                 apr_pool_t *pool);
 
 
@@ -144,6 +161,7 @@ static svn_error_t *replace_file_or_dir(struct context *c,
                                         const char *target_path,
                                         const char *edit_path,
                                         svn_node_kind_t tgt_kind,
+                                        const node_changes_t *changes,
                                         apr_pool_t *pool);
 
 static svn_error_t *absent_file_or_dir(struct context *c,
@@ -158,6 +176,7 @@ static svn_error_t *delta_dirs(struct context *c,
                                const char *source_path,
                                const char *target_path,
                                const char *edit_path,
+                               const node_changes_t *changes,
                                apr_pool_t *pool);
 
 
@@ -196,9 +215,542 @@ authz_root_check(svn_fs_root_t *root,
 }
 
 
+/* Checking nodes for changes on worker threads.  */
+
+
+#if APR_HAS_THREADS
+
+/* Set *CHANGES to the property and, for files of KIND, content changes
+   between SOURCE_PATH in SOURCE_ROOT and TARGET_PATH in TARGET_ROOT.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+compare_nodes(node_changes_t *changes,
+              svn_fs_root_t *source_root,
+              const char *source_path,
+              svn_fs_root_t *target_root,
+              const char *target_path,
+              svn_node_kind_t kind,
+              apr_pool_t *scratch_pool)
+{
+  SVN_ERR(svn_fs_props_different(&changes->props_changed,
+                                 target_root, target_path,
+                                 source_root, source_path, scratch_pool));
+
+  if (kind == svn_node_file)
+    SVN_ERR(svn_fs_contents_different(&changes->contents_changed,
+                                      target_root, target_path,
+                                      source_root, source_path,
+                                      scratch_pool));
+  else
+    changes->contents_changed = FALSE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Don't bother the workers with directories that have fewer entries
+   to compare than this. */
+#define DELTA_MIN_BATCH 4
+
+/* A pair of nodes to be compared by a parallel_delta_t. */
+typedef struct compare_job_t
+{
+  /* Name of the directory entry. */
+  const char *name;
+
+  /* The nodes to compare and their common kind. */
+  const char *source_path;
+  const char *target_path;
+  svn_node_kind_t kind;
+
+  /* Result and error of compare_nodes. */
+  node_changes_t changes;
+  svn_error_t *err;
+} compare_job_t;
+
+struct parallel_delta_t
+{
+  /* Protects all mutable members below.  Used with COND. */
+  svn_mutex__t *mutex;
+
+  /* Signaled whenever a batch gets posted or completed or the workers
+     shall terminate. */
+  apr_thread_cond_t *cond;
+
+  /* The current batch of COUNT jobs, the index of the next job to pick
+     up and the number of completed jobs.  JOBS is owned by the caller
+     and only valid while a batch is being processed. */
+  compare_job_t *jobs;
+  int count;
+  int next;
+  int completed;
+
+  /* Once set, the workers shall terminate. */
+  svn_boolean_t shutdown;
+
+  /* Read-only parameters of the delta. */
+  const char *source_fs_path;
+  apr_hash_t *source_fs_config;
+  svn_revnum_t source_rev;
+  const char *target_fs_path;
+  apr_hash_t *target_fs_config;
+  svn_revnum_t target_rev;
+};
+
+/* Per-thread data of a delta worker. */
+typedef struct delta_worker_t
+{
+  /* The shared state. */
+  parallel_delta_t *delta;
+
+  /* Root pool used only by this thread. */
+  apr_pool_t *pool;
+
+  /* The thread itself or NULL if it could not be started. */
+  apr_thread_t *thread;
+} delta_worker_t;
+
+/* Implements svn_fs_warning_callback_t.  The filesystems of the workers
+   only report cache failures, which don't affect the delta. */
+static void
+delta_worker_warning_func(void *baton,
+                          svn_error_t *err)
+{
+}
+
+/* Open revision REVISION of the filesystem at FS_PATH with FS_CONFIG
+   and return its root in *ROOT.  Allocate the result in RESULT_POOL and
+   use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+open_worker_root(svn_fs_root_t **root,
+                 const char *fs_path,
+                 apr_hash_t *fs_config,
+                 svn_revnum_t revision,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  svn_fs_t *fs;
+
+  SVN_ERR(svn_fs_open2(&fs, fs_path, fs_config, result_pool, scratch_pool));
+  svn_fs_set_warning_func(fs, delta_worker_warning_func, NULL);
+
+  return svn_error_trace(svn_fs_revision_root(root, fs, revision,
+                                              result_pool));
+}
+
+/* Thread function.  Compare nodes for the delta_worker_t given by DATA
+   until the delta terminates. */
+static void * APR_THREAD_FUNC
+delta_thread(apr_thread_t *tid,
+             void *data)
+{
+  delta_worker_t *worker = data;
+  parallel_delta_t *delta = worker->delta;
+  apr_pool_t *iterpool = svn_pool_create(worker->pool);
+  svn_fs_root_t *source_root = NULL;
+  svn_fs_root_t *target_root = NULL;
+  svn_error_t *err;
+
+  /* FS objects must not be shared between threads.  If we can't open our
+     own, leave the work to the others or to the caller. */
+  err = open_worker_root(&source_root, delta->source_fs_path,
+                         delta->source_fs_config, delta->source_rev,
+                         worker->pool, iterpool);
+  if (!err)
+    {
+      if (strcmp(delta->source_fs_path, delta->target_fs_path) == 0)
+        err = svn_fs_revision_root(&target_root,
+                                   svn_fs_root_fs(source_root),
+                                   delta->target_rev, worker->pool);
+      else
+        err = open_worker_root(&target_root, delta->target_fs_path,
+                               delta->target_fs_config, delta->target_rev,
+                               worker->pool, iterpool);
+    }
+
+  while (!err)
+    {
+      compare_job_t *job = NULL;
+
+      svn_pool_clear(iterpool);
+
+      err = svn_mutex__lock(delta->mutex);
+      if (err)
+        break;
+
+      while (!delta->shutdown && delta->next >= delta->count)
+        {
+          apr_status_t status
+            = apr_thread_cond_wait(delta->cond,
+                                   svn_mutex__get(delta->mutex));
+          if (status)
+            {
+              err = svn_error_wrap_apr(status,
+                                       _("Can't wait for condition variable"));
+              break;
+            }
+        }
+
+      if (!err && !delta->shutdown)
+        job = &delta->jobs[delta->next++];
+
+      err = svn_mutex__unlock(delta->mutex, err);
+      if (!job)
+        break;
+
+      job->err = compare_nodes(&job->changes, source_root, job->source_path,
+                               target_root, job->target_path, job->kind,
+                               iterpool);
+
+      /* The caller waits for this job.  So, hand it over even if we could
+         not get the lock. */
+      err = svn_error_compose_create(err, svn_mutex__lock(delta->mutex));
+      if (++delta->completed == delta->count)
+        apr_thread_cond_broadcast(delta->cond);
+      err = svn_mutex__unlock(delta->mutex, err);
+    }
+
+  svn_error_clear(err);
+  svn_pool_destroy(iterpool);
+
+  return NULL;
+}
+
+/* Compare the COUNT JOBS using the workers of DELTA and the roots in C.
+   The calling thread takes its share of the jobs as well.  Return once
+   all jobs have been completed.  Use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+compare_batch(parallel_delta_t *delta,
+              compare_job_t *jobs,
+              int count,
+              struct context *c,
+              apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_error_t *err;
+
+  SVN_ERR(svn_mutex__lock(delta->mutex));
+  delta->jobs = jobs;
+  delta->count = count;
+  delta->next = 0;
+  delta->completed = 0;
+  apr_thread_cond_broadcast(delta->cond);
+
+  err = SVN_NO_ERROR;
+  while (!err && delta->next < delta->count)
+    {
+      compare_job_t *job = &delta->jobs[delta->next++];
+
+      err = svn_mutex__unlock(delta->mutex, SVN_NO_ERROR);
+
+      svn_pool_clear(iterpool);
+      job->err = compare_nodes(&job->changes,
+                               c->source_root, job->source_path,
+                               c->target_root, job->target_path, job->kind,
+                               iterpool);
+
+      err = svn_error_compose_create(err, svn_mutex__lock(delta->mutex));
+      ++delta->completed;
+    }
+
+  while (!err && delta->completed < delta->count)
+    {
+      apr_status_t status
+        = apr_thread_cond_wait(delta->cond,
+                               svn_mutex__get(delta->mutex));
+      if (status)
+        err = svn_error_wrap_apr(status,
+                                 _("Can't wait for condition variable"));
+    }
+
+  /* JOBS may go away once we return. */
+  delta->jobs = NULL;
+  delta->count = 0;
+  delta->next = 0;
+  delta->completed = 0;
+
+  err = svn_mutex__unlock(delta->mutex, err);
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(err);
+}
+
+/* Determine the changes of all entries of directory TARGET_PATH with
+   entries T_ENTRIES that delta_dirs will replace with respect to the
+   entries S_ENTRIES of SOURCE_PATH, using the parallel delta in C.
+   Return a hash mapping entry names to node_changes_t * in *CHANGES,
+   or NULL if the directory is not worth the overhead.  Entries whose
+   comparison failed are not included; the caller will redo them and
+   report the error.  DEPTH is the depth of TARGET_PATH.  Allocate the
+   result in POOL. */
+static svn_error_t *
+prefetch_changes(apr_hash_t **changes,
+                 struct context *c,
+                 svn_depth_t depth,
+                 const char *source_path,
+                 const char *target_path,
+                 apr_hash_t *s_entries,
+                 apr_hash_t *t_entries,
+                 apr_pool_t *pool)
+{
+  apr_array_header_t *jobs = apr_array_make(pool, apr_hash_count(t_entries),
+                                            sizeof(compare_job_t));
+  apr_hash_index_t *hi;
+  int i;
+
+  *changes = NULL;
+
+  /* This mirrors the selection in delta_dirs. */
+  for (hi = apr_hash_first(pool, t_entries); hi; hi = apr_hash_next(hi))
+    {
+      const svn_fs_dirent_t *t_entry = apr_hash_this_val(hi);
+      const svn_fs_dirent_t *s_entry = svn_hash_gets(s_entries,
+                                                     t_entry->name);
+      compare_job_t *job;
+      int distance;
+
+      if (   !s_entry
+          || s_entry->kind != t_entry->kind
+          || (   depth != svn_depth_infinity
+              && t_entry->kind == svn_node_dir
+              && depth != svn_depth_immediates))
+        continue;
+
+      distance = svn_fs_compare_ids(s_entry->id, t_entry->id);
+      if (distance == 0 || (distance == -1 && !c->ignore_ancestry))
+        continue;
+
+      job = apr_array_push(jobs);
+      memset(job, 0, sizeof(*job));
+      job->name = t_entry->name;
+      job->source_path = svn_relpath_join(source_path, t_entry->name, pool);
+      job->target_path = svn_relpath_join(target_path, t_entry->name, pool);
+      job->kind = t_entry->kind;
+    }
+
+  if (jobs->nelts < DELTA_MIN_BATCH)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(compare_batch(c->parallel, (compare_job_t *)jobs->elts,
+                        jobs->nelts, c, pool));
+
+  *changes = apr_hash_make(pool);
+  for (i = 0; i < jobs->nelts; i++)
+    {
+      compare_job_t *job = &APR_ARRAY_IDX(jobs, i, compare_job_t);
+
+      if (job->err)
+        svn_error_clear(job->err);
+      else
+        svn_hash_sets(*changes, job->name, &job->changes);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Create a parallel delta with JOBS worker threads comparing nodes
+ * between SOURCE_ROOT and TARGET_ROOT.  Return it in *DELTA and the
+ * workers in *WORKERS.  Set *DELTA to NULL if the roots can't be opened
+ * by the workers.  Allocate everything in POOL.
+ */
+static svn_error_t *
+start_parallel_delta(parallel_delta_t **delta,
+                     delta_worker_t **workers,
+                     int jobs,
+                     svn_fs_root_t *source_root,
+                     svn_fs_root_t *target_root,
+                     apr_pool_t *pool)
+{
+  parallel_delta_t *result;
+  apr_status_t status;
+  int i;
+
+  *delta = NULL;
+
+  /* Transactions may be modified while we run. */
+  if (   !svn_fs_is_revision_root(source_root)
+      || !svn_fs_is_revision_root(target_root))
+    return SVN_NO_ERROR;
+
+  result = apr_pcalloc(pool, sizeof(*result));
+  SVN_ERR(svn_mutex__init(&result->mutex, TRUE, pool));
+  status = apr_thread_cond_create(&result->cond, pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create condition variable"));
+
+  result->source_fs_path = svn_fs_path(svn_fs_root_fs(source_root), pool);
+  result->source_fs_config = svn_fs_config(svn_fs_root_fs(source_root),
+                                           pool);
+  result->source_rev = svn_fs_revision_root_revision(source_root);
+  result->target_fs_path = svn_fs_path(svn_fs_root_fs(target_root), pool);
+  result->target_fs_config = svn_fs_config(svn_fs_root_fs(target_root),
+                                           pool);
+  result->target_rev = svn_fs_revision_root_revision(target_root);
+
+  *workers = apr_pcalloc(pool, jobs * sizeof(**workers));
+  for (i = 0; i < jobs; i++)
+    {
+      delta_worker_t *worker = &(*workers)[i];
+
+      worker->delta = result;
+      worker->pool
+        = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+
+      status = apr_thread_create(&worker->thread, NULL, delta_thread,
+                                 worker, worker->pool);
+      if (status)
+        worker->thread = NULL;
+    }
+
+  *delta = result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Terminate the JOBS WORKERS of DELTA and release their resources.
+ * Compose any error with ERR and return it. */
+static svn_error_t *
+stop_parallel_delta(parallel_delta_t *delta,
+                    delta_worker_t *workers,
+                    int jobs,
+                    svn_error_t *err)
+{
+  apr_status_t status;
+  int i;
+
+  err = svn_error_compose_create(err, svn_mutex__lock(delta->mutex));
+  delta->shutdown = TRUE;
+  apr_thread_cond_broadcast(delta->cond);
+  err = svn_error_compose_create(err, svn_mutex__unlock(delta->mutex,
+                                                        SVN_NO_ERROR));
+
+  for (i = 0; i < jobs; i++)
+    {
+      if (workers[i].thread)
+        {
+          apr_status_t retval;
+
+          status = apr_thread_join(&retval, workers[i].thread);
+          if (status)
+            err = svn_error_compose_create(
+                    err, svn_error_wrap_apr(status,
+                                            _("Can't join delta thread")));
+        }
+
+      svn_pool_destroy(workers[i].pool);
+    }
+
+  return svn_error_trace(err);
+}
+
+#endif /* APR_HAS_THREADS */
+
+
+/* Drive C->editor with EDIT_BATON to turn SRC_ENTRY in SRC_PARENT_DIR
+   into TGT_FULLPATH, starting with open_root() on AUTHZ_ROOT_PATH.
+   SRC_FULLPATH, SRC_KIND and TGT_KIND are as determined by
+   svn_repos_dir_delta3, DEPTH is as passed to it.  Return the root
+   directory baton in *ROOT_BATON if the root has been opened. */
+static svn_error_t *
+drive_delta(struct context *c,
+            void *edit_baton,
+            void **root_baton,
+            const char *src_parent_dir,
+            const char *src_entry,
+            const char *src_fullpath,
+            svn_node_kind_t src_kind,
+            const char *tgt_fullpath,
+            svn_node_kind_t tgt_kind,
+            const char *authz_root_path,
+            svn_depth_t depth,
+            apr_pool_t *pool)
+{
+  const svn_delta_editor_t *editor = c->editor;
+  svn_fs_root_t *src_root = c->source_root;
+  svn_fs_root_t *tgt_root = c->target_root;
+  svn_repos_authz_func_t authz_read_func = c->authz_read_func;
+  void *authz_read_baton = c->authz_read_baton;
+  svn_revnum_t rootrev;
+  svn_fs_node_relation_t relation;
+
+  /* Get our editor root's revision. */
+  rootrev = get_path_revision(src_root, src_parent_dir, pool);
+
+  /* If one or the other of our paths doesn't exist, we have to handle
+     those cases specially. */
+  if (tgt_kind == svn_node_none)
+    {
+      /* Caller thinks that target still exists, but it doesn't.
+         So transform their source path to "nothing" by deleting it. */
+      SVN_ERR(authz_root_check(tgt_root, authz_root_path,
+                               authz_read_func, authz_read_baton, pool));
+      SVN_ERR(editor->open_root(edit_baton, rootrev, pool, root_baton));
+      return svn_error_trace(delete(c, *root_baton, src_entry, pool));
+    }
+  if (src_kind == svn_node_none)
+    {
+      /* The source path no longer exists, but the target does.
+         So transform "nothing" into "something" by adding. */
+      SVN_ERR(authz_root_check(tgt_root, authz_root_path,
+                               authz_read_func, authz_read_baton, pool));
+      SVN_ERR(editor->open_root(edit_baton, rootrev, pool, root_baton));
+      return svn_error_trace(add_file_or_dir(c, *root_baton, depth,
+                                             tgt_fullpath, src_entry,
+                                             tgt_kind, pool));
+    }
+
+  /* Get and compare the node IDs for the source and target. */
+  SVN_ERR(svn_fs_node_relation(&relation, tgt_root, tgt_fullpath,
+                               src_root, src_fullpath, pool));
+
+  if (relation == svn_fs_node_unchanged)
+    {
+      /* They are the same node!  No-op (you gotta love those). */
+      return SVN_NO_ERROR;
+    }
+  else if (*src_entry)
+    {
+      /* If the nodes have different kinds, we must delete the one and
+         add the other.  Also, if they are completely unrelated and
+         our caller is interested in relatedness, we do the same thing. */
+      if ((src_kind != tgt_kind)
+          || ((relation == svn_fs_node_unrelated) && (! c->ignore_ancestry)))
+        {
+          SVN_ERR(authz_root_check(tgt_root, authz_root_path,
+                                   authz_read_func, authz_read_baton, pool));
+          SVN_ERR(editor->open_root(edit_baton, rootrev, pool, root_baton));
+          SVN_ERR(delete(c, *root_baton, src_entry, pool));
+          SVN_ERR(add_file_or_dir(c, *root_baton, depth, tgt_fullpath,
+                                  src_entry, tgt_kind, pool));
+        }
+      /* Otherwise, we just replace the one with the other. */
+      else
+        {
+          SVN_ERR(authz_root_check(tgt_root, authz_root_path,
+                                   authz_read_func, authz_read_baton, pool));
+          SVN_ERR(editor->open_root(edit_baton, rootrev, pool, root_baton));
+          SVN_ERR(replace_file_or_dir(c, *root_baton, depth, src_fullpath,
+                                      tgt_fullpath, src_entry,
+                                      tgt_kind, NULL, pool));
+        }
+    }
+  else
+    {
+      /* There is no entry given, so delta the whole parent directory. */
+      SVN_ERR(authz_root_check(tgt_root, authz_root_path,
+                               authz_read_func, authz_read_baton, pool));
+      SVN_ERR(editor->open_root(edit_baton, rootrev, pool, root_baton));
+      SVN_ERR(delta_dirs(c, *root_baton, depth, src_fullpath,
+                         tgt_fullpath, "", NULL, pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
 /* Public interface to computing directory deltas.  */
 svn_error_t *
-svn_repos_dir_delta2(svn_fs_root_t *src_root,
+svn_repos_dir_delta3(svn_fs_root_t *src_root,
                      const char *src_parent_dir,
                      const char *src_entry,
                      svn_fs_root_t *tgt_root,
@@ -211,15 +763,18 @@ svn_repos_dir_delta2(svn_fs_root_t *src_root,
                      svn_depth_t depth,
                      svn_boolean_t entry_props,
                      svn_boolean_t ignore_ancestry,
+                     int jobs,
                      apr_pool_t *pool)
 {
   void *root_baton = NULL;
   struct context c;
   const char *src_fullpath;
   svn_node_kind_t src_kind, tgt_kind;
-  svn_revnum_t rootrev;
-  svn_fs_node_relation_t relation;
   const char *authz_root_path;
+  svn_error_t *err;
+#if APR_HAS_THREADS
+  delta_worker_t *workers = NULL;
+#endif
 
   /* SRC_PARENT_DIR must be valid. */
   if (src_parent_dir)
@@ -296,78 +851,25 @@ svn_repos_dir_delta2(svn_fs_root_t *src_root,
   c.text_deltas = text_deltas;
   c.entry_props = entry_props;
   c.ignore_ancestry = ignore_ancestry;
+  c.parallel = NULL;
 
-  /* Get our editor root's revision. */
-  rootrev = get_path_revision(src_root, src_parent_dir, pool);
+#if APR_HAS_THREADS
+  /* Let worker threads check nodes for changes if requested. */
+  if (jobs > 1)
+    SVN_ERR(start_parallel_delta(&c.parallel, &workers, jobs,
+                                 src_root, tgt_root, pool));
+#endif
 
-  /* If one or the other of our paths doesn't exist, we have to handle
-     those cases specially. */
-  if (tgt_kind == svn_node_none)
-    {
-      /* Caller thinks that target still exists, but it doesn't.
-         So transform their source path to "nothing" by deleting it. */
-      SVN_ERR(authz_root_check(tgt_root, authz_root_path,
-                               authz_read_func, authz_read_baton, pool));
-      SVN_ERR(editor->open_root(edit_baton, rootrev, pool, &root_baton));
-      SVN_ERR(delete(&c, root_baton, src_entry, pool));
-      goto cleanup;
-    }
-  if (src_kind == svn_node_none)
-    {
-      /* The source path no longer exists, but the target does.
-         So transform "nothing" into "something" by adding. */
-      SVN_ERR(authz_root_check(tgt_root, authz_root_path,
-                               authz_read_func, authz_read_baton, pool));
-      SVN_ERR(editor->open_root(edit_baton, rootrev, pool, &root_baton));
-      SVN_ERR(add_file_or_dir(&c, root_baton, depth, tgt_fullpath,
-                              src_entry, tgt_kind, pool));
-      goto cleanup;
-    }
+  err = drive_delta(&c, edit_baton, &root_baton, src_parent_dir, src_entry,
+                    src_fullpath, src_kind, tgt_fullpath, tgt_kind,
+                    authz_root_path, depth, pool);
 
-  /* Get and compare the node IDs for the source and target. */
-  SVN_ERR(svn_fs_node_relation(&relation, tgt_root, tgt_fullpath,
-                               src_root, src_fullpath, pool));
+#if APR_HAS_THREADS
+  if (c.parallel)
+    err = stop_parallel_delta(c.parallel, workers, jobs, err);
+#endif
 
-  if (relation == svn_fs_node_unchanged)
-    {
-      /* They are the same node!  No-op (you gotta love those). */
-      goto cleanup;
-    }
-  else if (*src_entry)
-    {
-      /* If the nodes have different kinds, we must delete the one and
-         add the other.  Also, if they are completely unrelated and
-         our caller is interested in relatedness, we do the same thing. */
-      if ((src_kind != tgt_kind)
-          || ((relation == svn_fs_node_unrelated) && (! ignore_ancestry)))
-        {
-          SVN_ERR(authz_root_check(tgt_root, authz_root_path,
-                                   authz_read_func, authz_read_baton, pool));
-          SVN_ERR(editor->open_root(edit_baton, rootrev, pool, &root_baton));
-          SVN_ERR(delete(&c, root_baton, src_entry, pool));
-          SVN_ERR(add_file_or_dir(&c, root_baton, depth, tgt_fullpath,
-                                  src_entry, tgt_kind, pool));
-        }
-      /* Otherwise, we just replace the one with the other. */
-      else
-        {
-          SVN_ERR(authz_root_check(tgt_root, authz_root_path,
-                                   authz_read_func, authz_read_baton, pool));
-          SVN_ERR(editor->open_root(edit_baton, rootrev, pool, &root_baton));
-          SVN_ERR(replace_file_or_dir(&c, root_baton, depth, src_fullpath,
-                                      tgt_fullpath, src_entry,
-                                      tgt_kind, pool));
-        }
-    }
-  else
-    {
-      /* There is no entry given, so delta the whole parent directory. */
-      SVN_ERR(authz_root_check(tgt_root, authz_root_path,
-                               authz_read_func, authz_read_baton, pool));
-      SVN_ERR(editor->open_root(edit_baton, rootrev, pool, &root_baton));
-      SVN_ERR(delta_dirs(&c, root_baton, depth, src_fullpath,
-                         tgt_fullpath, "", pool));
-    }
+  SVN_ERR(err);
 
  cleanup:
 
@@ -379,7 +881,7 @@ svn_repos_dir_delta2(svn_fs_root_t *src_root,
   return editor->close_edit(edit_baton, pool);
 }
 
-
+
 /* Retrieving the base revision from the path/revision hash.  */
 
 
@@ -453,12 +955,14 @@ change_file_prop(struct context *c,
 /* Generate the appropriate property editing calls to turn the
    properties of SOURCE_PATH into those of TARGET_PATH.  If
    SOURCE_PATH is NULL, this is an add, so assume the target starts
-   with no properties.  Pass OBJECT on to the editor function wrapper
+   with no properties.  If CHANGES is not NULL, it tells whether the
+   properties differ.  Pass OBJECT on to the editor function wrapper
    CHANGE_FN. */
 static svn_error_t *
 delta_proplists(struct context *c,
                 const char *source_path,
                 const char *target_path,
+                const node_changes_t *changes,
                 proplist_change_fn_t *change_fn,
                 void *object,
                 apr_pool_t *pool)
@@ -530,8 +1034,13 @@ delta_proplists(struct context *c,
       svn_boolean_t changed;
 
       /* Is this deltification worth our time? */
-      SVN_ERR(svn_fs_props_different(&changed, c->target_root, target_path,
-                                     c->source_root, source_path, subpool));
+      if (changes)
+        changed = changes->props_changed;
+      else
+        SVN_ERR(svn_fs_props_different(&changed,
+                                       c->target_root, target_path,
+                                       c->source_root, source_path,
+                                       subpool));
       if (! changed)
         goto cleanup;
 
@@ -604,12 +1113,14 @@ send_text_delta(struct context *c,
 }
 
 /* Make the appropriate edits on FILE_BATON to change its contents and
-   properties from those in SOURCE_PATH to those in TARGET_PATH. */
+   properties from those in SOURCE_PATH to those in TARGET_PATH.  If
+   CHANGES is not NULL, it tells which of them differ. */
 static svn_error_t *
 delta_files(struct context *c,
             void *file_baton,
             const char *source_path,
             const char *target_path,
+            const node_changes_t *changes,
             apr_pool_t *pool)
 {
   apr_pool_t *subpool;
@@ -621,10 +1132,14 @@ delta_files(struct context *c,
   subpool = svn_pool_create(pool);
 
   /* Compare the files' property lists.  */
-  SVN_ERR(delta_proplists(c, source_path, target_path,
+  SVN_ERR(delta_proplists(c, source_path, target_path, changes,
                           change_file_prop, file_baton, subpool));
 
-  if (source_path)
+  if (source_path && changes)
+    {
+      changed = changes->contents_changed;
+    }
+  else if (source_path)
     {
       SVN_ERR(svn_fs_contents_different(&changed,
                                         c->target_root, target_path,
@@ -727,7 +1242,7 @@ add_file_or_dir(struct context *c, void *dir_baton,
                                              SVN_INVALID_REVNUM, pool,
                                              &subdir_baton));
       SVN_ERR(delta_dirs(context, subdir_baton, MAYBE_DEMOTE_DEPTH(depth),
-                         NULL, target_path, edit_path, pool));
+                         NULL, target_path, edit_path, NULL, pool));
       return context->editor->close_directory(subdir_baton, pool);
     }
   else
@@ -738,7 +1253,8 @@ add_file_or_dir(struct context *c, void *dir_baton,
       SVN_ERR(context->editor->add_file(edit_path, dir_baton,
                                         NULL, SVN_INVALID_REVNUM, pool,
                                         &file_baton));
-      SVN_ERR(delta_files(context, file_baton, NULL, target_path, pool));
+      SVN_ERR(delta_files(context, file_baton, NULL, target_path, NULL,
+                          pool));
       SVN_ERR(svn_fs_file_checksum(&checksum, svn_checksum_md5,
                                    context->target_root, target_path,
                                    TRUE, pool));
@@ -751,7 +1267,8 @@ add_file_or_dir(struct context *c, void *dir_baton,
 /* If authorized, emit a delta to modify EDIT_PATH with the changes
    from SOURCE_PATH to TARGET_PATH.  If not authorized, indicate that
    EDIT_PATH is absent.  Pass DIR_BATON through to editor functions
-   that require it.  DEPTH is the depth from this point downward. */
+   that require it.  DEPTH is the depth from this point downward.
+   CHANGES, if not NULL, are the precomputed changes of EDIT_PATH. */
 static svn_error_t *
 replace_file_or_dir(struct context *c,
                     void *dir_baton,
@@ -760,6 +1277,7 @@ replace_file_or_dir(struct context *c,
                     const char *target_path,
                     const char *edit_path,
                     svn_node_kind_t tgt_kind,
+                    const node_changes_t *changes,
                     apr_pool_t *pool)
 {
   svn_revnum_t base_revision = SVN_INVALID_REVNUM;
@@ -786,7 +1304,8 @@ replace_file_or_dir(struct context *c,
                                         base_revision, pool,
                                         &subdir_baton));
       SVN_ERR(delta_dirs(c, subdir_baton, MAYBE_DEMOTE_DEPTH(depth),
-                         source_path, target_path, edit_path, pool));
+                         source_path, target_path, edit_path, changes,
+                         pool));
       return c->editor->close_directory(subdir_baton, pool);
     }
   else
@@ -796,7 +1315,8 @@ replace_file_or_dir(struct context *c,
 
       SVN_ERR(c->editor->open_file(edit_path, dir_baton, base_revision,
                                    pool, &file_baton));
-      SVN_ERR(delta_files(c, file_baton, source_path, target_path, pool));
+      SVN_ERR(delta_files(c, file_baton, source_path, target_path, changes,
+                          pool));
       SVN_ERR(svn_fs_file_checksum(&checksum, svn_checksum_md5,
                                    c->target_root, target_path, TRUE,
                                    pool));
@@ -827,7 +1347,8 @@ absent_file_or_dir(struct context *c,
 
 /* Emit deltas to turn SOURCE_PATH into TARGET_PATH.  Assume that
    DIR_BATON represents the directory we're constructing to the editor
-   in the context C.  */
+   in the context C.  CHANGES, if not NULL, are the precomputed changes
+   of the directory itself.  */
 static svn_error_t *
 delta_dirs(struct context *c,
            void *dir_baton,
@@ -835,16 +1356,18 @@ delta_dirs(struct context *c,
            const char *source_path,
            const char *target_path,
            const char *edit_path,
+           const node_changes_t *changes,
            apr_pool_t *pool)
 {
   apr_hash_t *s_entries = 0, *t_entries = 0;
+  apr_hash_t *entry_changes = NULL;
   apr_hash_index_t *hi;
   apr_pool_t *subpool;
 
   SVN_ERR_ASSERT(target_path);
 
   /* Compare the property lists.  */
-  SVN_ERR(delta_proplists(c, source_path, target_path,
+  SVN_ERR(delta_proplists(c, source_path, target_path, changes,
                           change_dir_prop, dir_baton, pool));
 
   /* Get the list of entries in each of source and target.  */
@@ -854,6 +1377,13 @@ delta_dirs(struct context *c,
     SVN_ERR(svn_fs_dir_entries(&s_entries, c->source_root,
                                source_path, pool));
 
+#if APR_HAS_THREADS
+  /* Check the entries that we are going to replace on worker threads. */
+  if (c->parallel && s_entries)
+    SVN_ERR(prefetch_changes(&entry_changes, c, depth, source_path,
+                             target_path, s_entries, t_entries, pool));
+#endif
+
   /* Make a subpool for local allocations. */
   subpool = svn_pool_create(pool);
 
@@ -923,11 +1453,16 @@ delta_dirs(struct context *c,
                 }
               else
                 {
+                  const node_changes_t *t_changes = NULL;
+
+                  if (entry_changes)
+                    t_changes = apr_hash_get(entry_changes, key, klen);
+
                   SVN_ERR(replace_file_or_dir(c, dir_baton,
                                               MAYBE_DEMOTE_DEPTH(depth),
                                               s_fullpath, t_fullpath,
                                               e_fullpath, tgt_kind,
-                                              subpool));
+                                              t_changes, subpool));
                 }
             }
 
@@ -357,6 +357,39 @@ svn_repos_link_path(void *baton, const char *path, const char *link_path,
 }
 
 /*** From dir-delta.c ***/
+svn_error_t *
+svn_repos_dir_delta2(svn_fs_root_t *src_root,
+                     const char *src_parent_dir,
+                     const char *src_entry,
+                     svn_fs_root_t *tgt_root,
+                     const char *tgt_fullpath,
+                     const svn_delta_editor_t *editor,
+                     void *edit_baton,
+                     svn_repos_authz_func_t authz_read_func,
+                     void *authz_read_baton,
+                     svn_boolean_t text_deltas,
+                     svn_depth_t depth,
+                     svn_boolean_t entry_props,
+                     svn_boolean_t ignore_ancestry,
+                     apr_pool_t *pool)
+{
+  return svn_repos_dir_delta3(src_root,
+                              src_parent_dir,
+                              src_entry,
+                              tgt_root,
+                              tgt_fullpath,
+                              editor,
+                              edit_baton,
+                              authz_read_func,
+                              authz_read_baton,
+                              text_deltas,
+                              depth,
+                              entry_props,
+                              ignore_ancestry,
+                              1,
+                              pool);
+}
+
 svn_error_t *
 svn_repos_dir_delta(svn_fs_root_t *src_root,
                     const char *src_parent_dir,
@@ -486,10 +519,24 @@ svn_repos_fs_pack(svn_repos_t *repos,
   pnwb.notify_func = notify_func;
   pnwb.notify_baton = notify_baton;
 
-  return svn_repos_fs_pack2(repos, pack_notify_wrapper_func, &pnwb,
+  return svn_repos_fs_pack3(repos, 1, pack_notify_wrapper_func, &pnwb,
                             cancel_func, cancel_baton, pool);
 }
 
+svn_error_t *
+svn_repos_fs_pack2(svn_repos_t *repos,
+                   svn_repos_notify_func_t notify_func,
+                   void *notify_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *pool)
+{
+  return svn_error_trace(svn_repos_fs_pack3(repos, 1,
+                                            notify_func, notify_baton,
+                                            cancel_func, cancel_baton,
+                                            pool));
+}
+
 
 svn_error_t *
 svn_repos_fs_get_locks(apr_hash_t **locks,
@@ -812,6 +859,36 @@ svn_repos_dump_fs2(svn_repos_t *repos,
                                             pool));
 }
 
+svn_error_t *
+svn_repos_verify_fs3(svn_repos_t *repos,
+                     svn_revnum_t start_rev,
+                     svn_revnum_t end_rev,
+                     svn_boolean_t check_normalization,
+                     svn_boolean_t metadata_only,
+                     svn_repos_notify_func_t notify_func,
+                     void *notify_baton,
+                     svn_repos_verify_callback_t verify_callback,
+                     void *verify_baton,
+                     svn_cancel_func_t cancel_func,
+                     void *cancel_baton,
+                     apr_pool_t *pool)
+{
+  return svn_error_trace(svn_repos_verify_fs4(repos,
+                                              start_rev,
+                                              end_rev,
+                                              check_normalization,
+                                              metadata_only,
+                                              FALSE,
+                                              1,
+                                              notify_func,
+                                              notify_baton,
+                                              verify_callback,
+                                              verify_baton,
+                                              cancel_func,
+                                              cancel_baton,
+                                              pool));
+}
+
 svn_error_t *
 svn_repos_verify_fs2(svn_repos_t *repos,
                      svn_revnum_t start_rev,
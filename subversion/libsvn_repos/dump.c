@@ -23,6 +23,9 @@
 
 #include <stdarg.h>
 
+#include <apr_thread_proc.h>
+#include <apr_thread_cond.h>
+
 #include "svn_private_config.h"
 #include "svn_pools.h"
 #include "svn_error.h"
@@ -37,6 +40,8 @@
 #include "svn_checksum.h"
 #include "svn_props.h"
 #include "svn_sorts.h"
+#include "svn_io.h"
+#include "svn_version.h"
 
 #include "private/svn_repos_private.h"
 #include "private/svn_mergeinfo_private.h"
@@ -44,6 +49,10 @@
 #include "private/svn_sorts_private.h"
 #include "private/svn_utf_private.h"
 #include "private/svn_cache.h"
+#include "private/svn_atomic.h"
+#include "private/svn_mutex.h"
+
+#include "repos.h"
 
 #define ARE_VALID_COPY_ARGS(p,r) ((p) && SVN_IS_VALID_REVNUM(r))
 
@@ -1963,63 +1972,59 @@ write_revision_record(svn_stream_t *stream,
 
 
 
-/* The main dumper. */
-svn_error_t *
-svn_repos_dump_fs4(svn_repos_t *repos,
-                   svn_stream_t *stream,
-                   svn_revnum_t start_rev,
-                   svn_revnum_t end_rev,
-                   svn_boolean_t incremental,
-                   svn_boolean_t use_deltas,
-                   svn_boolean_t include_revprops,
-                   svn_boolean_t include_changes,
-                   svn_repos_notify_func_t notify_func,
-                   void *notify_baton,
-                   svn_cancel_func_t cancel_func,
-                   void *cancel_baton,
-                   apr_pool_t *pool)
+/* Refresh the revprops of FS and resolve the *START_REV and *END_REV given
+   to the dump functions to actual revision numbers.  Validate them.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+resolve_dump_range(svn_revnum_t *start_rev,
+                   svn_revnum_t *end_rev,
+                   svn_fs_t *fs,
+                   apr_pool_t *scratch_pool)
 {
-  const svn_delta_editor_t *dump_editor;
-  void *dump_edit_baton = NULL;
-  svn_revnum_t rev;
-  svn_fs_t *fs = svn_repos_fs(repos);
-  apr_pool_t *iterpool = svn_pool_create(pool);
   svn_revnum_t youngest;
-  const char *uuid;
-  int version;
-  svn_boolean_t found_old_reference = FALSE;
-  svn_boolean_t found_old_mergeinfo = FALSE;
-  svn_repos_notify_t *notify;
 
   /* Make sure we catch up on the latest revprop changes.  This is the only
    * time we will refresh the revprop data in this query. */
-  SVN_ERR(svn_fs_refresh_revision_props(fs, pool));
+  SVN_ERR(svn_fs_refresh_revision_props(fs, scratch_pool));
 
   /* Determine the current youngest revision of the filesystem. */
-  SVN_ERR(svn_fs_youngest_rev(&youngest, fs, pool));
+  SVN_ERR(svn_fs_youngest_rev(&youngest, fs, scratch_pool));
 
   /* Use default vals if necessary. */
-  if (! SVN_IS_VALID_REVNUM(start_rev))
-    start_rev = 0;
-  if (! SVN_IS_VALID_REVNUM(end_rev))
-    end_rev = youngest;
-  if (! stream)
-    stream = svn_stream_empty(pool);
+  if (! SVN_IS_VALID_REVNUM(*start_rev))
+    *start_rev = 0;
+  if (! SVN_IS_VALID_REVNUM(*end_rev))
+    *end_rev = youngest;
 
   /* Validate the revisions. */
-  if (start_rev > end_rev)
+  if (*start_rev > *end_rev)
     return svn_error_createf(SVN_ERR_REPOS_BAD_ARGS, NULL,
                              _("Start revision %ld"
                                " is greater than end revision %ld"),
-                             start_rev, end_rev);
-  if (end_rev > youngest)
+                             *start_rev, *end_rev);
+  if (*end_rev > youngest)
     return svn_error_createf(SVN_ERR_REPOS_BAD_ARGS, NULL,
                              _("End revision %ld is invalid "
                                "(youngest revision is %ld)"),
-                             end_rev, youngest);
+                             *end_rev, youngest);
+
+  return SVN_NO_ERROR;
+}
+
+/* Write the "general" metadata for a dumpfile of FS to STREAM, i.e. the
+   magic header followed by the dumpfile format version and the UUID.
+   Use the older format version if USE_DELTAS is not set.  Use
+   SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+write_dumpfile_header(svn_stream_t *stream,
+                      svn_fs_t *fs,
+                      svn_boolean_t use_deltas,
+                      apr_pool_t *scratch_pool)
+{
+  const char *uuid;
+  int version;
 
-  /* Write out the UUID. */
-  SVN_ERR(svn_fs_get_uuid(fs, &uuid, pool));
+  SVN_ERR(svn_fs_get_uuid(fs, &uuid, scratch_pool));
 
   /* If we're not using deltas, use the previous version, for
      compatibility with svn 1.0.x. */
@@ -2027,242 +2032,908 @@ svn_repos_dump_fs4(svn_repos_t *repos,
   if (!use_deltas)
     version--;
 
-  /* Write out "general" metadata for the dumpfile.  In this case, a
-     magic header followed by a dumpfile format version. */
-  SVN_ERR(svn_stream_printf(stream, pool,
+  SVN_ERR(svn_stream_printf(stream, scratch_pool,
                             SVN_REPOS_DUMPFILE_MAGIC_HEADER ": %d\n\n",
                             version));
-  SVN_ERR(svn_stream_printf(stream, pool, SVN_REPOS_DUMPFILE_UUID
+  SVN_ERR(svn_stream_printf(stream, scratch_pool, SVN_REPOS_DUMPFILE_UUID
                             ": %s\n\n", uuid));
 
-  /* Create a notify object that we can reuse in the loop. */
+  return SVN_NO_ERROR;
+}
+
+/* Dump revision REV of FS to STREAM exactly like svn_repos_dump_fs4()
+   does as part of a dump that begins at START_REV.  Set
+   *FOUND_OLD_REFERENCE and *FOUND_OLD_MERGEINFO if REV refers to
+   revisions before START_REV.  Send the revision's warnings and its
+   svn_repos_notify_dump_rev_end notification to NOTIFY_FUNC with
+   NOTIFY_BATON.  The other parameters are as for svn_repos_dump_fs4().
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+dump_revision(svn_stream_t *stream,
+              svn_fs_t *fs,
+              svn_revnum_t rev,
+              svn_revnum_t start_rev,
+              svn_boolean_t incremental,
+              svn_boolean_t use_deltas,
+              svn_boolean_t include_revprops,
+              svn_boolean_t include_changes,
+              svn_boolean_t *found_old_reference,
+              svn_boolean_t *found_old_mergeinfo,
+              svn_repos_notify_func_t notify_func,
+              void *notify_baton,
+              apr_pool_t *scratch_pool)
+{
+  const svn_delta_editor_t *dump_editor;
+  void *dump_edit_baton = NULL;
+  svn_fs_root_t *to_root;
+  svn_boolean_t use_deltas_for_rev;
+
+  /* Write the revision record. */
+  SVN_ERR(write_revision_record(stream, fs, rev, include_revprops,
+                                scratch_pool));
+
+  /* When dumping revision 0, we just write out the revision record.
+     The parser might want to use its properties.
+     If we don't want revision changes at all, skip in any case. */
+  if (rev == 0 || !include_changes)
+    goto done;
+
+  /* Fetch the editor which dumps nodes to a file.  Regardless of
+     what we've been told, don't use deltas for the first rev of a
+     non-incremental dump. */
+  use_deltas_for_rev = use_deltas && (incremental || rev != start_rev);
+  SVN_ERR(get_dump_editor(&dump_editor, &dump_edit_baton, fs, rev,
+                          "", stream, found_old_reference,
+                          found_old_mergeinfo, NULL,
+                          notify_func, notify_baton,
+                          start_rev, use_deltas_for_rev, FALSE, FALSE,
+                          scratch_pool));
+
+  /* Drive the editor in one way or another. */
+  SVN_ERR(svn_fs_revision_root(&to_root, fs, rev, scratch_pool));
+
+  /* If this is the first revision of a non-incremental dump,
+     we're in for a full tree dump.  Otherwise, we want to simply
+     replay the revision.  */
+  if ((rev == start_rev) && (! incremental))
+    {
+      /* Compare against revision 0, so everything appears to be added. */
+      svn_fs_root_t *from_root;
+      SVN_ERR(svn_fs_revision_root(&from_root, fs, 0, scratch_pool));
+      SVN_ERR(svn_repos_dir_delta3(from_root, "", "",
+                                   to_root, "",
+                                   dump_editor, dump_edit_baton,
+                                   NULL,
+                                   NULL,
+                                   FALSE, /* don't send text-deltas */
+                                   svn_depth_infinity,
+                                   FALSE, /* don't send entry props */
+                                   FALSE, /* don't ignore ancestry */
+                                   1,     /* everything is an add */
+                                   scratch_pool));
+    }
+  else
+    {
+      /* The normal case: compare consecutive revs. */
+      SVN_ERR(svn_repos_replay2(to_root, "", SVN_INVALID_REVNUM, FALSE,
+                                dump_editor, dump_edit_baton,
+                                NULL, NULL, scratch_pool));
+
+      /* While our editor close_edit implementation is a no-op, we still
+         do this for completeness. */
+      SVN_ERR(dump_editor->close_edit(dump_edit_baton, scratch_pool));
+    }
+
+ done:
   if (notify_func)
-    notify = svn_repos_notify_create(svn_repos_notify_dump_rev_end,
-                                     pool);
+    {
+      svn_repos_notify_t *notify
+        = svn_repos_notify_create(svn_repos_notify_dump_rev_end,
+                                  scratch_pool);
+
+      notify->revision = rev;
+      notify_func(notify_baton, notify, scratch_pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Write a complete dumpfile of revisions SEGMENT_START to SEGMENT_END of
+   FS to STREAM, as part of a dump beginning at START_REV.  Dumpfiles
+   written for consecutive segments can be concatenated into the dumpfile
+   that svn_repos_dump_fs4() would produce for the whole range.  The other
+   parameters are as for dump_revision() and svn_repos_dump_fs4().  An
+   empty segment, i.e. SEGMENT_START > SEGMENT_END, results in just the
+   dumpfile header.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+dump_segment(svn_stream_t *stream,
+             svn_fs_t *fs,
+             svn_revnum_t segment_start,
+             svn_revnum_t segment_end,
+             svn_revnum_t start_rev,
+             svn_boolean_t incremental,
+             svn_boolean_t use_deltas,
+             svn_boolean_t include_revprops,
+             svn_boolean_t include_changes,
+             svn_boolean_t *found_old_reference,
+             svn_boolean_t *found_old_mergeinfo,
+             svn_repos_notify_func_t notify_func,
+             void *notify_baton,
+             svn_cancel_func_t cancel_func,
+             void *cancel_baton,
+             apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_revnum_t rev;
+
+  SVN_ERR(write_dumpfile_header(stream, fs, use_deltas, scratch_pool));
 
   /* Main loop:  we're going to dump revision REV.  */
-  for (rev = start_rev; rev <= end_rev; rev++)
+  for (rev = segment_start; rev <= segment_end; rev++)
     {
-      svn_fs_root_t *to_root;
-      svn_boolean_t use_deltas_for_rev;
-
       svn_pool_clear(iterpool);
 
       /* Check for cancellation. */
       if (cancel_func)
         SVN_ERR(cancel_func(cancel_baton));
 
-      /* Write the revision record. */
-      SVN_ERR(write_revision_record(stream, fs, rev, include_revprops,
-                                    iterpool));
+      SVN_ERR(dump_revision(stream, fs, rev, start_rev, incremental,
+                            use_deltas, include_revprops, include_changes,
+                            found_old_reference, found_old_mergeinfo,
+                            notify_func, notify_baton, iterpool));
+    }
 
-      /* When dumping revision 0, we just write out the revision record.
-         The parser might want to use its properties.
-         If we don't want revision changes at all, skip in any case. */
-      if (rev == 0 || !include_changes)
-        goto loop_end;
-
-      /* Fetch the editor which dumps nodes to a file.  Regardless of
-         what we've been told, don't use deltas for the first rev of a
-         non-incremental dump. */
-      use_deltas_for_rev = use_deltas && (incremental || rev != start_rev);
-      SVN_ERR(get_dump_editor(&dump_editor, &dump_edit_baton, fs, rev,
-                              "", stream, &found_old_reference,
-                              &found_old_mergeinfo, NULL,
-                              notify_func, notify_baton,
-                              start_rev, use_deltas_for_rev, FALSE, FALSE,
-                              iterpool));
-
-      /* Drive the editor in one way or another. */
-      SVN_ERR(svn_fs_revision_root(&to_root, fs, rev, iterpool));
-
-      /* If this is the first revision of a non-incremental dump,
-         we're in for a full tree dump.  Otherwise, we want to simply
-         replay the revision.  */
-      if ((rev == start_rev) && (! incremental))
-        {
-          /* Compare against revision 0, so everything appears to be added. */
-          svn_fs_root_t *from_root;
-          SVN_ERR(svn_fs_revision_root(&from_root, fs, 0, iterpool));
-          SVN_ERR(svn_repos_dir_delta2(from_root, "", "",
-                                       to_root, "",
-                                       dump_editor, dump_edit_baton,
-                                       NULL,
-                                       NULL,
-                                       FALSE, /* don't send text-deltas */
-                                       svn_depth_infinity,
-                                       FALSE, /* don't send entry props */
-                                       FALSE, /* don't ignore ancestry */
-                                       iterpool));
-        }
-      else
-        {
-          /* The normal case: compare consecutive revs. */
-          SVN_ERR(svn_repos_replay2(to_root, "", SVN_INVALID_REVNUM, FALSE,
-                                    dump_editor, dump_edit_baton,
-                                    NULL, NULL, iterpool));
-
-          /* While our editor close_edit implementation is a no-op, we still
-             do this for completeness. */
-          SVN_ERR(dump_editor->close_edit(dump_edit_baton, iterpool));
-        }
+  svn_pool_destroy(iterpool);
 
-    loop_end:
-      if (notify_func)
-        {
-          notify->revision = rev;
-          notify_func(notify_baton, notify, iterpool);
-        }
+  return SVN_NO_ERROR;
+}
+
+/* Send the notifications that conclude a dump to NOTIFY_FUNC with
+   NOTIFY_BATON, if that is not NULL.  FOUND_OLD_REFERENCE and
+   FOUND_OLD_MERGEINFO tell whether respective warnings had been issued
+   during the dump.  Use SCRATCH_POOL for temporary allocations. */
+static void
+notify_dump_end(svn_boolean_t found_old_reference,
+                svn_boolean_t found_old_mergeinfo,
+                svn_repos_notify_func_t notify_func,
+                void *notify_baton,
+                apr_pool_t *scratch_pool)
+{
+  svn_repos_notify_t *notify;
+
+  if (!notify_func)
+    return;
+
+  /* Did we issue any warnings about references to revisions older than
+     the oldest dumped revision?  If so, then issue a final generic
+     warning, since the inline warnings already issued might easily be
+     missed. */
+
+  notify = svn_repos_notify_create(svn_repos_notify_dump_end, scratch_pool);
+  notify_func(notify_baton, notify, scratch_pool);
+
+  if (found_old_reference)
+    {
+      notify_warning(scratch_pool, notify_func, notify_baton,
+                     svn_repos_notify_warning_found_old_reference,
+                     _("The range of revisions dumped "
+                       "contained references to "
+                       "copy sources outside that "
+                       "range."));
     }
 
-  if (notify_func)
+  /* Ditto if we issued any warnings about old revisions referenced
+     in dumped mergeinfo. */
+  if (found_old_mergeinfo)
     {
-      /* Did we issue any warnings about references to revisions older than
-         the oldest dumped revision?  If so, then issue a final generic
-         warning, since the inline warnings already issued might easily be
-         missed. */
+      notify_warning(scratch_pool, notify_func, notify_baton,
+                     svn_repos_notify_warning_found_old_mergeinfo,
+                     _("The range of revisions dumped "
+                       "contained mergeinfo "
+                       "which reference revisions outside "
+                       "that range."));
+    }
+}
 
-      notify = svn_repos_notify_create(svn_repos_notify_dump_end, iterpool);
-      notify_func(notify_baton, notify, iterpool);
+/* The main dumper. */
+svn_error_t *
+svn_repos_dump_fs4(svn_repos_t *repos,
+                   svn_stream_t *stream,
+                   svn_revnum_t start_rev,
+                   svn_revnum_t end_rev,
+                   svn_boolean_t incremental,
+                   svn_boolean_t use_deltas,
+                   svn_boolean_t include_revprops,
+                   svn_boolean_t include_changes,
+                   svn_repos_notify_func_t notify_func,
+                   void *notify_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *pool)
+{
+  svn_fs_t *fs = svn_repos_fs(repos);
+  svn_boolean_t found_old_reference = FALSE;
+  svn_boolean_t found_old_mergeinfo = FALSE;
 
-      if (found_old_reference)
-        {
-          notify_warning(iterpool, notify_func, notify_baton,
-                         svn_repos_notify_warning_found_old_reference,
-                         _("The range of revisions dumped "
-                           "contained references to "
-                           "copy sources outside that "
-                           "range."));
-        }
+  SVN_ERR(resolve_dump_range(&start_rev, &end_rev, fs, pool));
+  if (! stream)
+    stream = svn_stream_empty(pool);
 
-      /* Ditto if we issued any warnings about old revisions referenced
-         in dumped mergeinfo. */
-      if (found_old_mergeinfo)
-        {
-          notify_warning(iterpool, notify_func, notify_baton,
-                         svn_repos_notify_warning_found_old_mergeinfo,
-                         _("The range of revisions dumped "
-                           "contained mergeinfo "
-                           "which reference revisions outside "
-                           "that range."));
-        }
-    }
+  SVN_ERR(dump_segment(stream, fs, start_rev, end_rev, start_rev,
+                       incremental, use_deltas, include_revprops,
+                       include_changes, &found_old_reference,
+                       &found_old_mergeinfo, notify_func, notify_baton,
+                       cancel_func, cancel_baton, pool));
 
-  svn_pool_destroy(iterpool);
+  notify_dump_end(found_old_reference, found_old_mergeinfo,
+                  notify_func, notify_baton, pool);
 
   return SVN_NO_ERROR;
 }
 
+void
+svn_repos_dump_segment_range(svn_revnum_t *segment_start,
+                             svn_revnum_t *segment_end,
+                             svn_revnum_t start_rev,
+                             svn_revnum_t end_rev,
+                             int segment,
+                             int segment_count)
+{
+  apr_int64_t count = end_rev - start_rev + 1;
 
-/*----------------------------------------------------------------------*/
-
-/* verify, based on dump */
+  *segment_start = start_rev
+                 + (svn_revnum_t)(count * segment / segment_count);
+  *segment_end = start_rev
+               + (svn_revnum_t)(count * (segment + 1) / segment_count) - 1;
+}
 
+#if APR_HAS_THREADS
 
-/* Creating a new revision that changes /A/B/E/bravo means creating new
-   directory listings for /, /A, /A/B, and /A/B/E in the new revision, with
-   each entry not changed in the new revision a link back to the entry in a
-   previous revision.  svn_repos_replay()ing a revision does not verify that
-   those links are correct.
+/* Interval at which the main thread checks for cancellation while
+   waiting for the workers of a parallel dump. */
+#define DUMP_WAIT_INTERVAL apr_time_from_msec(100)
 
-   For paths actually changed in the revision we verify, we get directory
-   contents or file length twice: once in the dump editor, and once here.
-   We could create a new verify baton, store in it the changed paths, and
-   skip those here, but that means building an entire wrapper editor and
-   managing two levels of batons.  The impact from checking these entries
-   twice should be minimal, while the code to avoid it is not.
-*/
+/* Outcome of dumping one segment in a worker thread. */
+typedef struct dump_segment_job_t
+{
+  /* The dump error or SVN_NO_ERROR. */
+  svn_error_t *err;
 
-static svn_error_t *
-verify_directory_entry(void *baton, const void *key, apr_ssize_t klen,
-                       void *val, apr_pool_t *pool)
+  /* The svn_repos_notify_t * sent while dumping, in order.  To keep this
+     small, svn_repos_notify_dump_rev_end notifications are recorded as
+     NULL entries; they refer to the revisions of the segment in order.
+     NULL if there were no notifications. */
+  apr_array_header_t *notifications;
+
+  /* Whether warnings about references to revisions outside the dumped
+     range have been issued. */
+  svn_boolean_t found_old_reference;
+  svn_boolean_t found_old_mergeinfo;
+
+  /* Private pool containing this job. */
+  apr_pool_t *pool;
+} dump_segment_job_t;
+
+/* State shared between the main thread and the worker threads of
+   dump_segments_parallel().  The workers claim segments in ascending
+   order and the main thread reports their outcome in that order. */
+typedef struct parallel_dump_t
 {
-  struct dir_baton *db = baton;
-  svn_fs_dirent_t *dirent = (svn_fs_dirent_t *)val;
-  char *path;
-  svn_boolean_t right_kind;
+  /* Protects NEXT_SEGMENT and JOBS.  Used with COND. */
+  svn_mutex__t *mutex;
 
-  path = svn_relpath_join(db->path, (const char *)key, pool);
+  /* Signaled whenever a segment completes or a worker terminates. */
+  apr_thread_cond_t *cond;
 
-  /* since we can't access the directory entries directly by their ID,
-     we need to navigate from the FS_ROOT to them (relatively expensive
-     because we may start at a never rev than the last change to node).
-     We check that the node kind stored in the noderev matches the dir
-     entry.  This also ensures that all entries point to valid noderevs.
-   */
-  switch (dirent->kind) {
-  case svn_node_dir:
-    SVN_ERR(svn_fs_is_dir(&right_kind, db->edit_baton->fs_root, path, pool));
-    if (!right_kind)
-      return svn_error_createf(SVN_ERR_NODE_UNEXPECTED_KIND, NULL,
-                               _("Node '%s' is not a directory."),
-                               path);
+  /* The next segment to be claimed by a worker. */
+  int next_segment;
 
-    break;
-  case svn_node_file:
-    SVN_ERR(svn_fs_is_file(&right_kind, db->edit_baton->fs_root, path, pool));
-    if (!right_kind)
-      return svn_error_createf(SVN_ERR_NODE_UNEXPECTED_KIND, NULL,
-                               _("Node '%s' is not a file."),
-                               path);
-    break;
-  default:
-    return svn_error_createf(SVN_ERR_NODE_UNEXPECTED_KIND, NULL,
-                             _("Unexpected node kind %d for '%s'"),
-                             dirent->kind, path);
-  }
+  /* Completed jobs, indexed by segment. */
+  dump_segment_job_t **jobs;
 
-  return SVN_NO_ERROR;
-}
+  /* Number of worker threads that have not terminated yet. */
+  volatile svn_atomic_t running;
 
-/* Baton used by the check_name_collision hash iterator. */
-struct check_name_collision_baton
-{
-  struct dir_baton *dir_baton;
-  apr_hash_t *normalized;
-  svn_membuf_t buffer;
-};
+  /* Non-zero once the workers shall stop. */
+  volatile svn_atomic_t aborted;
 
-/* Scan the directory and report all entry names that differ only in
-   Unicode character representation. */
-static svn_error_t *
-check_name_collision(void *baton, const void *key, apr_ssize_t klen,
-                     void *val, apr_pool_t *iterpool)
+  /* Parameters of the dump.  Read-only. */
+  const char *repos_path;
+  const apr_array_header_t *streams;
+  svn_revnum_t start_rev;
+  svn_revnum_t end_rev;
+  svn_boolean_t incremental;
+  svn_boolean_t use_deltas;
+  svn_boolean_t include_revprops;
+  svn_boolean_t include_changes;
+  svn_boolean_t notify;
+
+  /* Thread-safe root pool that all job pools are created in. */
+  apr_pool_t *jobs_pool;
+} parallel_dump_t;
+
+/* Per-thread data of a dump worker. */
+typedef struct dump_worker_t
 {
-  struct check_name_collision_baton *const cb = baton;
-  const char *name;
-  const char *found;
+  /* The shared state. */
+  parallel_dump_t *dumper;
 
-  SVN_ERR(svn_utf__normalize(&name, key, klen, &cb->buffer));
+  /* Private copy of the FS config to open the repository with. */
+  apr_hash_t *fs_config;
 
-  found = svn_hash_gets(cb->normalized, name);
-  if (!found)
-    svn_hash_sets(cb->normalized, apr_pstrdup(cb->buffer.pool, name),
-                  normalized_unique);
-  else if (found == normalized_collision)
-    /* Skip already reported collision */;
-  else
-    {
-      struct dir_baton *const db = cb->dir_baton;
-      struct edit_baton *const eb = db->edit_baton;
-      const char* normpath;
+  /* Root pool used only by this thread. */
+  apr_pool_t *pool;
 
-      svn_hash_sets(cb->normalized, apr_pstrdup(cb->buffer.pool, name),
-                    normalized_collision);
+  /* The thread itself or NULL if it could not be started. */
+  apr_thread_t *thread;
+} dump_worker_t;
 
-      SVN_ERR(svn_utf__normalize(
-                  &normpath, svn_relpath_join(db->path, name, iterpool),
-                  SVN_UTF__UNKNOWN_LENGTH, &cb->buffer));
-      notify_warning(iterpool, eb->notify_func, eb->notify_baton,
-                     svn_repos_notify_warning_name_collision,
-                     _("Duplicate representation of path '%s'"), normpath);
+/* Implements svn_repos_notify_func_t.  Append a copy of NOTIFY to the
+   notifications of the dump_segment_job_t BATON. */
+static void
+collect_dump_notification(void *baton,
+                          const svn_repos_notify_t *notify,
+                          apr_pool_t *scratch_pool)
+{
+  dump_segment_job_t *job = baton;
+  svn_repos_notify_t *copy = NULL;
+
+  if (notify->action != svn_repos_notify_dump_rev_end)
+    {
+      copy = apr_pmemdup(job->pool, notify, sizeof(*copy));
+      copy->warning_str = apr_pstrdup(job->pool, notify->warning_str);
+      copy->path = apr_pstrdup(job->pool, notify->path);
     }
+
+  if (job->notifications == NULL)
+    job->notifications = apr_array_make(job->pool, 16, sizeof(copy));
+
+  APR_ARRAY_PUSH(job->notifications, svn_repos_notify_t *) = copy;
+}
+
+/* Implements svn_cancel_func_t for the parallel_dump_t BATON.
+   Workers must not call the caller's cancellation function. */
+static svn_error_t *
+check_dump_aborted(void *baton)
+{
+  parallel_dump_t *dumper = baton;
+
+  if (svn_atomic_read(&dumper->aborted))
+    return svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+
   return SVN_NO_ERROR;
 }
 
+/* Implements svn_fs_warning_callback_t.  The filesystems of the workers
+   only report cache failures, which don't affect the dump. */
+static void
+dump_worker_warning_func(void *baton,
+                         svn_error_t *err)
+{
+}
 
+/* Set *SEGMENT to the next segment to dump for DUMPER.  Set it to -1 if
+   there is nothing left to do. */
 static svn_error_t *
-verify_close_directory(void *dir_baton, apr_pool_t *pool)
+claim_segment(int *segment,
+              parallel_dump_t *dumper)
+{
+  SVN_ERR(svn_mutex__lock(dumper->mutex));
+
+  if (   svn_atomic_read(&dumper->aborted)
+      || dumper->next_segment >= dumper->streams->nelts)
+    *segment = -1;
+  else
+    *segment = dumper->next_segment++;
+
+  return svn_error_trace(svn_mutex__unlock(dumper->mutex, SVN_NO_ERROR));
+}
+
+/* Thread function.  Dump segments for the dump_worker_t given by DATA
+   until there are no more or the dump got aborted. */
+static void * APR_THREAD_FUNC
+dump_thread(apr_thread_t *tid,
+            void *data)
+{
+  dump_worker_t *worker = data;
+  parallel_dump_t *dumper = worker->dumper;
+  apr_pool_t *iterpool = svn_pool_create(worker->pool);
+  svn_repos_t *repos;
+  svn_error_t *err;
+
+  /* FS objects must not be shared between threads.  If we can't open our
+     own, leave the work to the others or to the main thread. */
+  err = svn_repos_open3(&repos, dumper->repos_path, worker->fs_config,
+                        worker->pool, iterpool);
+  if (!err)
+    svn_fs_set_warning_func(svn_repos_fs(repos), dump_worker_warning_func,
+                            NULL);
+
+  while (!err)
+    {
+      svn_revnum_t segment_start, segment_end;
+      dump_segment_job_t *job;
+      apr_pool_t *job_pool;
+      int segment;
+
+      svn_pool_clear(iterpool);
+
+      err = claim_segment(&segment, dumper);
+      if (err || segment < 0)
+        break;
+
+      svn_repos_dump_segment_range(&segment_start, &segment_end,
+                                   dumper->start_rev, dumper->end_rev,
+                                   segment, dumper->streams->nelts);
+
+      job_pool = svn_pool_create(dumper->jobs_pool);
+      job = apr_pcalloc(job_pool, sizeof(*job));
+      job->pool = job_pool;
+      job->err = dump_segment(APR_ARRAY_IDX(dumper->streams, segment,
+                                            svn_stream_t *),
+                              svn_repos_fs(repos), segment_start,
+                              segment_end, dumper->start_rev,
+                              dumper->incremental, dumper->use_deltas,
+                              dumper->include_revprops,
+                              dumper->include_changes,
+                              &job->found_old_reference,
+                              &job->found_old_mergeinfo,
+                              dumper->notify
+                                ? collect_dump_notification
+                                : NULL,
+                              job, check_dump_aborted, dumper, iterpool);
+
+      /* Once claimed, the main thread waits for this segment.  So, hand
+         it over even if we could not get the lock. */
+      err = svn_mutex__lock(dumper->mutex);
+      dumper->jobs[segment] = job;
+      if (!err)
+        {
+          apr_thread_cond_broadcast(dumper->cond);
+          err = svn_mutex__unlock(dumper->mutex, SVN_NO_ERROR);
+        }
+    }
+
+  svn_error_clear(err);
+  svn_pool_destroy(iterpool);
+
+  /* The main thread dumps the remaining segments itself once all workers
+     are gone. */
+  err = svn_mutex__lock(dumper->mutex);
+  svn_atomic_dec(&dumper->running);
+  if (!err)
+    {
+      apr_thread_cond_broadcast(dumper->cond);
+      err = svn_mutex__unlock(dumper->mutex, SVN_NO_ERROR);
+    }
+
+  svn_error_clear(err);
+
+  return NULL;
+}
+
+/* Set *JOB to the outcome of dumping SEGMENT of DUMPER.  Wait for it but
+   check for cancellation through CANCEL_FUNC and CANCEL_BATON
+   periodically.  Set *JOB to NULL if no worker is left to dump SEGMENT;
+   the caller must then dump it itself. */
+static svn_error_t *
+wait_for_segment(dump_segment_job_t **job,
+                 parallel_dump_t *dumper,
+                 int segment,
+                 svn_cancel_func_t cancel_func,
+                 void *cancel_baton)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+
+  SVN_ERR(svn_mutex__lock(dumper->mutex));
+
+  while (!dumper->jobs[segment] && svn_atomic_read(&dumper->running))
+    {
+      apr_status_t status;
+
+      if (cancel_func)
+        {
+          err = cancel_func(cancel_baton);
+          if (err)
+            break;
+        }
+
+      status = apr_thread_cond_timedwait(dumper->cond,
+                                         svn_mutex__get(dumper->mutex),
+                                         DUMP_WAIT_INTERVAL);
+      if (status && !APR_STATUS_IS_TIMEUP(status))
+        {
+          err = svn_error_wrap_apr(status,
+                                   _("Can't wait for condition variable"));
+          break;
+        }
+    }
+
+  if (!err)
+    {
+      *job = dumper->jobs[segment];
+      dumper->jobs[segment] = NULL;
+
+      /* Once all workers are gone, nobody will claim it anymore. */
+      if (*job == NULL && dumper->next_segment <= segment)
+        dumper->next_segment = segment + 1;
+    }
+
+  return svn_error_trace(svn_mutex__unlock(dumper->mutex, err));
+}
+
+/* Report the dump of all segments of DUMPER, in order, as they become
+   available.  Dump the segments of FS that no worker is left for
+   ourselves.  The other parameters are as for
+   svn_repos_dump_fs_segments(). */
+static svn_error_t *
+report_parallel_dump(parallel_dump_t *dumper,
+                     svn_fs_t *fs,
+                     svn_repos_notify_func_t notify_func,
+                     void *notify_baton,
+                     svn_cancel_func_t cancel_func,
+                     void *cancel_baton,
+                     apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_boolean_t found_old_reference = FALSE;
+  svn_boolean_t found_old_mergeinfo = FALSE;
+  int segment;
+
+  for (segment = 0; segment < dumper->streams->nelts; segment++)
+    {
+      svn_revnum_t segment_start, segment_end;
+      dump_segment_job_t *job;
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      svn_repos_dump_segment_range(&segment_start, &segment_end,
+                                   dumper->start_rev, dumper->end_rev,
+                                   segment, dumper->streams->nelts);
+
+      SVN_ERR(wait_for_segment(&job, dumper, segment,
+                               cancel_func, cancel_baton));
+      if (job)
+        {
+          if (job->notifications)
+            {
+              svn_revnum_t rev = segment_start;
+              int i;
+
+              for (i = 0; i < job->notifications->nelts; i++)
+                {
+                  svn_repos_notify_t *notify
+                    = APR_ARRAY_IDX(job->notifications, i,
+                                    svn_repos_notify_t *);
+
+                  if (notify == NULL)
+                    {
+                      notify
+                        = svn_repos_notify_create(
+                            svn_repos_notify_dump_rev_end, iterpool);
+                      notify->revision = rev++;
+                    }
+
+                  notify_func(notify_baton, notify, iterpool);
+                }
+            }
+
+          found_old_reference |= job->found_old_reference;
+          found_old_mergeinfo |= job->found_old_mergeinfo;
+          err = job->err;
+          svn_pool_destroy(job->pool);
+        }
+      else
+        {
+          err = dump_segment(APR_ARRAY_IDX(dumper->streams, segment,
+                                           svn_stream_t *),
+                             fs, segment_start, segment_end,
+                             dumper->start_rev, dumper->incremental,
+                             dumper->use_deltas, dumper->include_revprops,
+                             dumper->include_changes,
+                             &found_old_reference, &found_old_mergeinfo,
+                             notify_func, notify_baton,
+                             cancel_func, cancel_baton, iterpool);
+        }
+
+      SVN_ERR(err);
+    }
+
+  notify_dump_end(found_old_reference, found_old_mergeinfo,
+                  notify_func, notify_baton, iterpool);
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Dump revisions START_REV to END_REV of REPOS into the segment STREAMS
+   using up to JOBS worker threads with their own filesystem objects.
+   Notifications are sent in the same order as the serial code does.
+   The other parameters are as for svn_repos_dump_fs_segments(). */
+static svn_error_t *
+dump_segments_parallel(svn_repos_t *repos,
+                       const apr_array_header_t *streams,
+                       svn_revnum_t start_rev,
+                       svn_revnum_t end_rev,
+                       svn_boolean_t incremental,
+                       svn_boolean_t use_deltas,
+                       svn_boolean_t include_revprops,
+                       svn_boolean_t include_changes,
+                       int jobs,
+                       svn_repos_notify_func_t notify_func,
+                       void *notify_baton,
+                       svn_cancel_func_t cancel_func,
+                       void *cancel_baton,
+                       apr_pool_t *scratch_pool)
+{
+  svn_fs_t *fs = svn_repos_fs(repos);
+  apr_hash_t *fs_config = svn_fs_config(fs, scratch_pool);
+  parallel_dump_t *dumper;
+  dump_worker_t *workers;
+  svn_error_t *err;
+  apr_status_t status;
+  int i;
+
+  if (streams->nelts < jobs)
+    jobs = streams->nelts;
+
+  dumper = apr_pcalloc(scratch_pool, sizeof(*dumper));
+  SVN_ERR(svn_mutex__init(&dumper->mutex, TRUE, scratch_pool));
+  status = apr_thread_cond_create(&dumper->cond, scratch_pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create condition variable"));
+
+  dumper->jobs = apr_pcalloc(scratch_pool,
+                             streams->nelts * sizeof(*dumper->jobs));
+  dumper->repos_path = svn_repos_path(repos, scratch_pool);
+  dumper->streams = streams;
+  dumper->start_rev = start_rev;
+  dumper->end_rev = end_rev;
+  dumper->incremental = incremental;
+  dumper->use_deltas = use_deltas;
+  dumper->include_revprops = include_revprops;
+  dumper->include_changes = include_changes;
+  dumper->notify = notify_func != NULL;
+  dumper->jobs_pool
+    = apr_allocator_owner_get(svn_pool_create_allocator(TRUE));
+
+  workers = apr_pcalloc(scratch_pool, jobs * sizeof(*workers));
+  for (i = 0; i < jobs; i++)
+    {
+      dump_worker_t *worker = &workers[i];
+
+      worker->dumper = dumper;
+      worker->pool
+        = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+      worker->fs_config = fs_config ? apr_hash_copy(worker->pool, fs_config)
+                                    : NULL;
+
+      svn_atomic_inc(&dumper->running);
+      status = apr_thread_create(&worker->thread, NULL, dump_thread,
+                                 worker, worker->pool);
+      if (status)
+        {
+          worker->thread = NULL;
+          svn_atomic_dec(&dumper->running);
+        }
+    }
+
+  err = report_parallel_dump(dumper, fs, notify_func, notify_baton,
+                             cancel_func, cancel_baton, scratch_pool);
+
+  /* Stop all workers and discard whatever they did not hand over. */
+  svn_atomic_set(&dumper->aborted, TRUE);
+  err = svn_error_compose_create(err, svn_mutex__lock(dumper->mutex));
+  apr_thread_cond_broadcast(dumper->cond);
+  err = svn_error_compose_create(err, svn_mutex__unlock(dumper->mutex,
+                                                        SVN_NO_ERROR));
+
+  for (i = 0; i < jobs; i++)
+    {
+      if (workers[i].thread)
+        {
+          apr_status_t retval;
+
+          status = apr_thread_join(&retval, workers[i].thread);
+          if (status)
+            err = svn_error_compose_create(
+                    err, svn_error_wrap_apr(status,
+                                            _("Can't join dump thread")));
+        }
+
+      svn_pool_destroy(workers[i].pool);
+    }
+
+  for (i = 0; i < streams->nelts; i++)
+    if (dumper->jobs[i])
+      svn_error_clear(dumper->jobs[i]->err);
+
+  svn_pool_destroy(dumper->jobs_pool);
+
+  return svn_error_trace(err);
+}
+
+#endif /* APR_HAS_THREADS */
+
+svn_error_t *
+svn_repos_dump_fs_segments(svn_repos_t *repos,
+                           const apr_array_header_t *streams,
+                           svn_revnum_t start_rev,
+                           svn_revnum_t end_rev,
+                           svn_boolean_t incremental,
+                           svn_boolean_t use_deltas,
+                           svn_boolean_t include_revprops,
+                           svn_boolean_t include_changes,
+                           int jobs,
+                           svn_repos_notify_func_t notify_func,
+                           void *notify_baton,
+                           svn_cancel_func_t cancel_func,
+                           void *cancel_baton,
+                           apr_pool_t *scratch_pool)
+{
+  svn_fs_t *fs = svn_repos_fs(repos);
+  apr_pool_t *iterpool;
+  svn_boolean_t found_old_reference = FALSE;
+  svn_boolean_t found_old_mergeinfo = FALSE;
+  int segment;
+
+  if (streams->nelts < 1)
+    return svn_error_create(SVN_ERR_REPOS_BAD_ARGS, NULL,
+                            _("No dump segments given"));
+
+  SVN_ERR(resolve_dump_range(&start_rev, &end_rev, fs, scratch_pool));
+
+#if APR_HAS_THREADS
+  if (jobs > 1 && streams->nelts > 1)
+    return svn_error_trace(dump_segments_parallel(repos, streams,
+                                                  start_rev, end_rev,
+                                                  incremental, use_deltas,
+                                                  include_revprops,
+                                                  include_changes, jobs,
+                                                  notify_func, notify_baton,
+                                                  cancel_func, cancel_baton,
+                                                  scratch_pool));
+#endif
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (segment = 0; segment < streams->nelts; segment++)
+    {
+      svn_revnum_t segment_start, segment_end;
+
+      svn_pool_clear(iterpool);
+      svn_repos_dump_segment_range(&segment_start, &segment_end,
+                                   start_rev, end_rev,
+                                   segment, streams->nelts);
+      SVN_ERR(dump_segment(APR_ARRAY_IDX(streams, segment, svn_stream_t *),
+                           fs, segment_start, segment_end, start_rev,
+                           incremental, use_deltas, include_revprops,
+                           include_changes, &found_old_reference,
+                           &found_old_mergeinfo, notify_func, notify_baton,
+                           cancel_func, cancel_baton, iterpool));
+    }
+
+  notify_dump_end(found_old_reference, found_old_mergeinfo,
+                  notify_func, notify_baton, iterpool);
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+
+/*----------------------------------------------------------------------*/
+
+/* verify, based on dump */
+
+
+/* Creating a new revision that changes /A/B/E/bravo means creating new
+   directory listings for /, /A, /A/B, and /A/B/E in the new revision, with
+   each entry not changed in the new revision a link back to the entry in a
+   previous revision.  svn_repos_replay()ing a revision does not verify that
+   those links are correct.
+
+   For paths actually changed in the revision we verify, we get directory
+   contents or file length twice: once in the dump editor, and once here.
+   We could create a new verify baton, store in it the changed paths, and
+   skip those here, but that means building an entire wrapper editor and
+   managing two levels of batons.  The impact from checking these entries
+   twice should be minimal, while the code to avoid it is not.
+*/
+
+static svn_error_t *
+verify_directory_entry(void *baton, const void *key, apr_ssize_t klen,
+                       void *val, apr_pool_t *pool)
+{
+  struct dir_baton *db = baton;
+  svn_fs_dirent_t *dirent = (svn_fs_dirent_t *)val;
+  char *path;
+  svn_boolean_t right_kind;
+
+  path = svn_relpath_join(db->path, (const char *)key, pool);
+
+  /* since we can't access the directory entries directly by their ID,
+     we need to navigate from the FS_ROOT to them (relatively expensive
+     because we may start at a never rev than the last change to node).
+     We check that the node kind stored in the noderev matches the dir
+     entry.  This also ensures that all entries point to valid noderevs.
+   */
+  switch (dirent->kind) {
+  case svn_node_dir:
+    SVN_ERR(svn_fs_is_dir(&right_kind, db->edit_baton->fs_root, path, pool));
+    if (!right_kind)
+      return svn_error_createf(SVN_ERR_NODE_UNEXPECTED_KIND, NULL,
+                               _("Node '%s' is not a directory."),
+                               path);
+
+    break;
+  case svn_node_file:
+    SVN_ERR(svn_fs_is_file(&right_kind, db->edit_baton->fs_root, path, pool));
+    if (!right_kind)
+      return svn_error_createf(SVN_ERR_NODE_UNEXPECTED_KIND, NULL,
+                               _("Node '%s' is not a file."),
+                               path);
+    break;
+  default:
+    return svn_error_createf(SVN_ERR_NODE_UNEXPECTED_KIND, NULL,
+                             _("Unexpected node kind %d for '%s'"),
+                             dirent->kind, path);
+  }
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton used by the check_name_collision hash iterator. */
+struct check_name_collision_baton
+{
+  struct dir_baton *dir_baton;
+  apr_hash_t *normalized;
+  svn_membuf_t buffer;
+};
+
+/* Scan the directory and report all entry names that differ only in
+   Unicode character representation. */
+static svn_error_t *
+check_name_collision(void *baton, const void *key, apr_ssize_t klen,
+                     void *val, apr_pool_t *iterpool)
+{
+  struct check_name_collision_baton *const cb = baton;
+  const char *name;
+  const char *found;
+
+  SVN_ERR(svn_utf__normalize(&name, key, klen, &cb->buffer));
+
+  found = svn_hash_gets(cb->normalized, name);
+  if (!found)
+    svn_hash_sets(cb->normalized, apr_pstrdup(cb->buffer.pool, name),
+                  normalized_unique);
+  else if (found == normalized_collision)
+    /* Skip already reported collision */;
+  else
+    {
+      struct dir_baton *const db = cb->dir_baton;
+      struct edit_baton *const eb = db->edit_baton;
+      const char* normpath;
+
+      svn_hash_sets(cb->normalized, apr_pstrdup(cb->buffer.pool, name),
+                    normalized_collision);
+
+      SVN_ERR(svn_utf__normalize(
+                  &normpath, svn_relpath_join(db->path, name, iterpool),
+                  SVN_UTF__UNKNOWN_LENGTH, &cb->buffer));
+      notify_warning(iterpool, eb->notify_func, eb->notify_baton,
+                     svn_repos_notify_warning_name_collision,
+                     _("Duplicate representation of path '%s'"), normpath);
+    }
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+verify_close_directory(void *dir_baton, apr_pool_t *pool)
 {
   struct dir_baton *db = dir_baton;
   apr_hash_t *dirents;
@@ -2387,73 +3058,576 @@ report_error(svn_revnum_t revision,
     }
 }
 
-svn_error_t *
-svn_repos_verify_fs3(svn_repos_t *repos,
-                     svn_revnum_t start_rev,
-                     svn_revnum_t end_rev,
-                     svn_boolean_t check_normalization,
-                     svn_boolean_t metadata_only,
-                     svn_repos_notify_func_t notify_func,
-                     void *notify_baton,
-                     svn_repos_verify_callback_t verify_callback,
-                     void *verify_baton,
-                     svn_cancel_func_t cancel_func,
-                     void *cancel_baton,
-                     apr_pool_t *pool)
+/* Report the outcome ERR of verifying revision REV the way
+   svn_repos_verify_fs4() documents it.  Return errors that shall stop
+   the verification. */
+static svn_error_t *
+report_revision(svn_revnum_t rev,
+                svn_error_t *err,
+                svn_repos_notify_func_t notify_func,
+                void *notify_baton,
+                svn_repos_verify_callback_t verify_callback,
+                void *verify_baton,
+                apr_pool_t *scratch_pool)
 {
-  svn_fs_t *fs = svn_repos_fs(repos);
-  svn_revnum_t youngest;
+  if (err && err->apr_err == SVN_ERR_CANCELLED)
+    {
+      return svn_error_trace(err);
+    }
+  else if (err)
+    {
+      SVN_ERR(report_error(rev, err, verify_callback, verify_baton,
+                           scratch_pool));
+    }
+  else if (notify_func)
+    {
+      /* Tell the caller that we're done with this revision. */
+      svn_repos_notify_t *notify
+        = svn_repos_notify_create(svn_repos_notify_verify_rev_end,
+                                  scratch_pool);
+
+      notify->revision = rev;
+      notify_func(notify_baton, notify, scratch_pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Verify revisions START_REV to END_REV of FS one after another and
+   report their outcome.  The other parameters are as for
+   svn_repos_verify_fs4(). */
+static svn_error_t *
+verify_revisions(svn_fs_t *fs,
+                 svn_revnum_t start_rev,
+                 svn_revnum_t end_rev,
+                 svn_boolean_t check_normalization,
+                 svn_repos_notify_func_t notify_func,
+                 void *notify_baton,
+                 svn_repos_verify_callback_t verify_callback,
+                 void *verify_baton,
+                 svn_cancel_func_t cancel_func,
+                 void *cancel_baton,
+                 apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
   svn_revnum_t rev;
-  apr_pool_t *iterpool = svn_pool_create(pool);
-  svn_repos_notify_t *notify;
-  svn_fs_progress_notify_func_t verify_notify = NULL;
-  struct verify_fs_notify_func_baton_t *verify_notify_baton = NULL;
+
+  for (rev = start_rev; rev <= end_rev; rev++)
+    {
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+
+      /* Wrapper function to catch the possible errors. */
+      err = verify_one_revision(fs, rev, notify_func, notify_baton,
+                                start_rev, check_normalization,
+                                cancel_func, cancel_baton,
+                                iterpool);
+
+      SVN_ERR(report_revision(rev, err, notify_func, notify_baton,
+                              verify_callback, verify_baton, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS
+
+/* Number of revisions per worker thread that may be verified ahead of
+   the oldest revision not reported yet. */
+#define VERIFY_WINDOW_PER_THREAD 8
+
+/* Check for cancellation that often while waiting for a worker. */
+#define VERIFY_WAIT_INTERVAL apr_time_from_msec(100)
+
+/* Outcome of verifying a single revision in a worker thread. */
+typedef struct verify_job_t
+{
+  /* The verification error or SVN_NO_ERROR. */
   svn_error_t *err;
 
-  /* Make sure we catch up on the latest revprop changes.  This is the only
-   * time we will refresh the revprop data in this query. */
-  SVN_ERR(svn_fs_refresh_revision_props(fs, pool));
+  /* The svn_repos_notify_t * sent during the verification, in order.
+     NULL if there were none. */
+  apr_array_header_t *notifications;
 
-  /* Determine the current youngest revision of the filesystem. */
-  SVN_ERR(svn_fs_youngest_rev(&youngest, fs, pool));
+  /* Private pool containing this job. */
+  apr_pool_t *pool;
+} verify_job_t;
 
-  /* Use default vals if necessary. */
-  if (! SVN_IS_VALID_REVNUM(start_rev))
-    start_rev = 0;
-  if (! SVN_IS_VALID_REVNUM(end_rev))
-    end_rev = youngest;
+/* State shared between the main thread and the worker threads of
+   verify_revisions_parallel().  The workers claim revisions in ascending
+   order and the main thread reports their outcome strictly in that
+   order. */
+typedef struct parallel_verify_t
+{
+  /* Protects NEXT_REV, FIRST_REV and JOBS.  Used with COND. */
+  svn_mutex__t *mutex;
 
-  /* Validate the revisions. */
-  if (start_rev > end_rev)
-    return svn_error_createf(SVN_ERR_REPOS_BAD_ARGS, NULL,
-                             _("Start revision %ld"
-                               " is greater than end revision %ld"),
-                             start_rev, end_rev);
-  if (end_rev > youngest)
-    return svn_error_createf(SVN_ERR_REPOS_BAD_ARGS, NULL,
-                             _("End revision %ld is invalid "
-                               "(youngest revision is %ld)"),
-                             end_rev, youngest);
+  /* Signaled whenever a job completes, a worker terminates or the main
+     thread has consumed a job. */
+  apr_thread_cond_t *cond;
 
-  /* Create a notify object that we can reuse within the loop and a
-     forwarding structure for notifications from inside svn_fs_verify(). */
-  if (notify_func)
+  /* The next revision to be claimed by a worker. */
+  svn_revnum_t next_rev;
+
+  /* The oldest revision whose outcome has not been reported yet. */
+  svn_revnum_t first_rev;
+
+  /* Completed jobs, indexed by revision modulo MAX_JOBS.  Workers don't
+     claim revisions MAX_JOBS or more ahead of FIRST_REV. */
+  verify_job_t **jobs;
+  int max_jobs;
+
+  /* Number of worker threads that have not terminated yet. */
+  volatile svn_atomic_t running;
+
+  /* Non-zero once the workers shall stop. */
+  volatile svn_atomic_t aborted;
+
+  /* Parameters of the verification.  Read-only. */
+  const char *repos_path;
+  svn_revnum_t start_rev;
+  svn_revnum_t end_rev;
+  svn_boolean_t check_normalization;
+  svn_boolean_t notify;
+
+  /* Thread-safe root pool that all job pools are created in. */
+  apr_pool_t *jobs_pool;
+} parallel_verify_t;
+
+/* Per-thread data of a verification worker. */
+typedef struct verify_worker_t
+{
+  /* The shared state. */
+  parallel_verify_t *verifier;
+
+  /* Private copy of the FS config to open the repository with. */
+  apr_hash_t *fs_config;
+
+  /* Root pool used only by this thread. */
+  apr_pool_t *pool;
+
+  /* The thread itself or NULL if it could not be started. */
+  apr_thread_t *thread;
+} verify_worker_t;
+
+/* Implements svn_repos_notify_func_t.  Append a copy of NOTIFY to the
+   notifications of the verify_job_t BATON. */
+static void
+collect_notification(void *baton,
+                     const svn_repos_notify_t *notify,
+                     apr_pool_t *scratch_pool)
+{
+  verify_job_t *job = baton;
+  svn_repos_notify_t *copy = apr_pmemdup(job->pool, notify, sizeof(*copy));
+
+  copy->warning_str = apr_pstrdup(job->pool, notify->warning_str);
+  copy->path = apr_pstrdup(job->pool, notify->path);
+
+  if (job->notifications == NULL)
+    job->notifications = apr_array_make(job->pool, 4, sizeof(copy));
+
+  APR_ARRAY_PUSH(job->notifications, svn_repos_notify_t *) = copy;
+}
+
+/* Implements svn_cancel_func_t for the parallel_verify_t BATON.
+   Workers must not call the caller's cancellation function. */
+static svn_error_t *
+check_verify_aborted(void *baton)
+{
+  parallel_verify_t *verifier = baton;
+
+  if (svn_atomic_read(&verifier->aborted))
+    return svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_fs_warning_callback_t.  The filesystems of the workers
+   only report cache failures, which don't affect the verification. */
+static void
+verify_worker_warning_func(void *baton,
+                           svn_error_t *err)
+{
+}
+
+/* Set *REV to the next revision to verify for VERIFIER.  Wait until it
+   is within the job window.  Set it to SVN_INVALID_REVNUM if there is
+   nothing left to do. */
+static svn_error_t *
+claim_revision(svn_revnum_t *rev,
+               parallel_verify_t *verifier)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+
+  SVN_ERR(svn_mutex__lock(verifier->mutex));
+
+  /* This loop implicitly handles spurious wake-ups. */
+  while (!svn_atomic_read(&verifier->aborted)
+         && verifier->next_rev <= verifier->end_rev
+         && verifier->next_rev - verifier->first_rev >= verifier->max_jobs)
     {
-      notify = svn_repos_notify_create(svn_repos_notify_verify_rev_end, pool);
+      apr_status_t status
+        = apr_thread_cond_wait(verifier->cond,
+                               svn_mutex__get(verifier->mutex));
+      if (status)
+        {
+          err = svn_error_wrap_apr(status,
+                                   _("Can't wait for condition variable"));
+          break;
+        }
+    }
+
+  if (err
+      || svn_atomic_read(&verifier->aborted)
+      || verifier->next_rev > verifier->end_rev)
+    *rev = SVN_INVALID_REVNUM;
+  else
+    *rev = verifier->next_rev++;
 
+  return svn_error_trace(svn_mutex__unlock(verifier->mutex, err));
+}
+
+/* Thread function.  Verify revisions for the verify_worker_t given by
+   DATA until there are no more or the verification got aborted. */
+static void * APR_THREAD_FUNC
+verify_thread(apr_thread_t *tid,
+              void *data)
+{
+  verify_worker_t *worker = data;
+  parallel_verify_t *verifier = worker->verifier;
+  apr_pool_t *iterpool = svn_pool_create(worker->pool);
+  svn_repos_t *repos;
+  svn_error_t *err;
+
+  /* FS objects must not be shared between threads.  If we can't open our
+     own, leave the work to the others or to the main thread. */
+  err = svn_repos_open3(&repos, verifier->repos_path, worker->fs_config,
+                        worker->pool, iterpool);
+  if (!err)
+    svn_fs_set_warning_func(svn_repos_fs(repos), verify_worker_warning_func,
+                            NULL);
+
+  while (!err)
+    {
+      svn_revnum_t rev;
+      verify_job_t *job;
+      apr_pool_t *job_pool;
+
+      svn_pool_clear(iterpool);
+
+      err = claim_revision(&rev, verifier);
+      if (err || !SVN_IS_VALID_REVNUM(rev))
+        break;
+
+      job_pool = svn_pool_create(verifier->jobs_pool);
+      job = apr_pcalloc(job_pool, sizeof(*job));
+      job->pool = job_pool;
+      job->err = verify_one_revision(svn_repos_fs(repos), rev,
+                                     verifier->notify
+                                       ? collect_notification
+                                       : NULL,
+                                     job, verifier->start_rev,
+                                     verifier->check_normalization,
+                                     check_verify_aborted, verifier,
+                                     iterpool);
+
+      /* Once claimed, the main thread waits for this revision.  So, hand
+         it over even if we could not get the lock. */
+      err = svn_mutex__lock(verifier->mutex);
+      verifier->jobs[rev % verifier->max_jobs] = job;
+      if (!err)
+        {
+          apr_thread_cond_broadcast(verifier->cond);
+          err = svn_mutex__unlock(verifier->mutex, SVN_NO_ERROR);
+        }
+    }
+
+  svn_error_clear(err);
+  svn_pool_destroy(iterpool);
+
+  /* The main thread verifies the remaining revisions itself once all
+     workers are gone. */
+  err = svn_mutex__lock(verifier->mutex);
+  svn_atomic_dec(&verifier->running);
+  if (!err)
+    {
+      apr_thread_cond_broadcast(verifier->cond);
+      err = svn_mutex__unlock(verifier->mutex, SVN_NO_ERROR);
+    }
+
+  svn_error_clear(err);
+
+  return NULL;
+}
+
+/* Set *JOB to the outcome of verifying revision REV, which is
+   VERIFIER->FIRST_REV.  Wait for it but check for cancellation through
+   CANCEL_FUNC and CANCEL_BATON periodically.  Set *JOB to NULL if no
+   worker is left to verify REV. */
+static svn_error_t *
+wait_for_revision(verify_job_t **job,
+                  parallel_verify_t *verifier,
+                  svn_revnum_t rev,
+                  svn_cancel_func_t cancel_func,
+                  void *cancel_baton)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+  int slot = (int)(rev % verifier->max_jobs);
+
+  SVN_ERR(svn_mutex__lock(verifier->mutex));
+
+  while (!verifier->jobs[slot] && svn_atomic_read(&verifier->running))
+    {
+      apr_status_t status;
+
+      if (cancel_func)
+        {
+          err = cancel_func(cancel_baton);
+          if (err)
+            break;
+        }
+
+      status = apr_thread_cond_timedwait(verifier->cond,
+                                         svn_mutex__get(verifier->mutex),
+                                         VERIFY_WAIT_INTERVAL);
+      if (status && !APR_STATUS_IS_TIMEUP(status))
+        {
+          err = svn_error_wrap_apr(status,
+                                   _("Can't wait for condition variable"));
+          break;
+        }
+    }
+
+  if (!err)
+    {
+      *job = verifier->jobs[slot];
+      verifier->jobs[slot] = NULL;
+
+      /* Free the slot for the next revision. */
+      verifier->first_rev = rev + 1;
+      apr_thread_cond_broadcast(verifier->cond);
+    }
+
+  return svn_error_trace(svn_mutex__unlock(verifier->mutex, err));
+}
+
+/* Report the verification of all revisions of VERIFIER, in order, as
+   they become available.  Verify revisions of FS that no worker is left
+   for ourselves.  The other parameters are as for svn_repos_verify_fs4().
+ */
+static svn_error_t *
+report_parallel_verification(parallel_verify_t *verifier,
+                             svn_fs_t *fs,
+                             svn_repos_notify_func_t notify_func,
+                             void *notify_baton,
+                             svn_repos_verify_callback_t verify_callback,
+                             void *verify_baton,
+                             svn_cancel_func_t cancel_func,
+                             void *cancel_baton,
+                             apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_revnum_t rev;
+
+  for (rev = verifier->start_rev; rev <= verifier->end_rev; rev++)
+    {
+      verify_job_t *job;
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(wait_for_revision(&job, verifier, rev,
+                                cancel_func, cancel_baton));
+      if (job)
+        {
+          if (job->notifications)
+            {
+              int i;
+
+              for (i = 0; i < job->notifications->nelts; i++)
+                notify_func(notify_baton,
+                            APR_ARRAY_IDX(job->notifications, i,
+                                          svn_repos_notify_t *),
+                            iterpool);
+            }
+
+          err = job->err;
+          svn_pool_destroy(job->pool);
+        }
+      else
+        {
+          err = verify_one_revision(fs, rev, notify_func, notify_baton,
+                                    verifier->start_rev,
+                                    verifier->check_normalization,
+                                    cancel_func, cancel_baton,
+                                    iterpool);
+        }
+
+      SVN_ERR(report_revision(rev, err, notify_func, notify_baton,
+                              verify_callback, verify_baton, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Verify revisions START_REV to END_REV in REPOS using up to JOBS worker
+   threads with their own filesystem objects.  Notifications and errors
+   are reported in the same order as the serial code does.  The other
+   parameters are as for svn_repos_verify_fs4(). */
+static svn_error_t *
+verify_revisions_parallel(svn_repos_t *repos,
+                          svn_revnum_t start_rev,
+                          svn_revnum_t end_rev,
+                          svn_boolean_t check_normalization,
+                          int jobs,
+                          svn_repos_notify_func_t notify_func,
+                          void *notify_baton,
+                          svn_repos_verify_callback_t verify_callback,
+                          void *verify_baton,
+                          svn_cancel_func_t cancel_func,
+                          void *cancel_baton,
+                          apr_pool_t *scratch_pool)
+{
+  svn_fs_t *fs = svn_repos_fs(repos);
+  apr_hash_t *fs_config = svn_fs_config(fs, scratch_pool);
+  parallel_verify_t *verifier;
+  verify_worker_t *workers;
+  svn_error_t *err;
+  apr_status_t status;
+  int i;
+
+  if (end_rev - start_rev + 1 < jobs)
+    jobs = (int)(end_rev - start_rev + 1);
+
+  verifier = apr_pcalloc(scratch_pool, sizeof(*verifier));
+  SVN_ERR(svn_mutex__init(&verifier->mutex, TRUE, scratch_pool));
+  status = apr_thread_cond_create(&verifier->cond, scratch_pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create condition variable"));
+
+  verifier->next_rev = start_rev;
+  verifier->first_rev = start_rev;
+  verifier->max_jobs = jobs * VERIFY_WINDOW_PER_THREAD;
+  verifier->jobs = apr_pcalloc(scratch_pool,
+                               verifier->max_jobs * sizeof(*verifier->jobs));
+  verifier->repos_path = svn_repos_path(repos, scratch_pool);
+  verifier->start_rev = start_rev;
+  verifier->end_rev = end_rev;
+  verifier->check_normalization = check_normalization;
+  verifier->notify = notify_func != NULL;
+  verifier->jobs_pool
+    = apr_allocator_owner_get(svn_pool_create_allocator(TRUE));
+
+  workers = apr_pcalloc(scratch_pool, jobs * sizeof(*workers));
+  for (i = 0; i < jobs; i++)
+    {
+      verify_worker_t *worker = &workers[i];
+
+      worker->verifier = verifier;
+      worker->pool
+        = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+      worker->fs_config = fs_config ? apr_hash_copy(worker->pool, fs_config)
+                                    : NULL;
+
+      svn_atomic_inc(&verifier->running);
+      status = apr_thread_create(&worker->thread, NULL, verify_thread,
+                                 worker, worker->pool);
+      if (status)
+        {
+          worker->thread = NULL;
+          svn_atomic_dec(&verifier->running);
+        }
+    }
+
+  err = report_parallel_verification(verifier, fs, notify_func, notify_baton,
+                                     verify_callback, verify_baton,
+                                     cancel_func, cancel_baton, scratch_pool);
+
+  /* Stop all workers and discard whatever they did not hand over. */
+  svn_atomic_set(&verifier->aborted, TRUE);
+  err = svn_error_compose_create(err, svn_mutex__lock(verifier->mutex));
+  apr_thread_cond_broadcast(verifier->cond);
+  err = svn_error_compose_create(err, svn_mutex__unlock(verifier->mutex,
+                                                        SVN_NO_ERROR));
+
+  for (i = 0; i < jobs; i++)
+    {
+      if (workers[i].thread)
+        {
+          apr_status_t retval;
+
+          status = apr_thread_join(&retval, workers[i].thread);
+          if (status)
+            err = svn_error_compose_create(
+                    err, svn_error_wrap_apr(status,
+                                            _("Can't join verify thread")));
+        }
+
+      svn_pool_destroy(workers[i].pool);
+    }
+
+  for (i = 0; i < verifier->max_jobs; i++)
+    if (verifier->jobs[i])
+      svn_error_clear(verifier->jobs[i]->err);
+
+  svn_pool_destroy(verifier->jobs_pool);
+
+  return svn_error_trace(err);
+}
+
+#endif /* APR_HAS_THREADS */
+
+/* Verify global metadata of REPOS' filesystem for revisions START_REV to
+   END_REV and, unless METADATA_ONLY is set, those revisions themselves.
+   The other parameters are as for svn_repos_verify_fs4(). */
+static svn_error_t *
+verify_range(svn_repos_t *repos,
+             svn_revnum_t start_rev,
+             svn_revnum_t end_rev,
+             svn_boolean_t check_normalization,
+             svn_boolean_t metadata_only,
+             int jobs,
+             svn_repos_notify_func_t notify_func,
+             void *notify_baton,
+             svn_repos_verify_callback_t verify_callback,
+             void *verify_baton,
+             svn_cancel_func_t cancel_func,
+             void *cancel_baton,
+             apr_pool_t *scratch_pool)
+{
+  svn_fs_t *fs = svn_repos_fs(repos);
+  svn_fs_progress_notify_func_t verify_notify = NULL;
+  struct verify_fs_notify_func_baton_t *verify_notify_baton = NULL;
+  svn_error_t *err;
+
+  /* Create a forwarding structure for notifications from inside
+     svn_fs_verify(). */
+  if (notify_func)
+    {
       verify_notify = verify_fs_notify_func;
-      verify_notify_baton = apr_palloc(pool, sizeof(*verify_notify_baton));
+      verify_notify_baton = apr_palloc(scratch_pool,
+                                       sizeof(*verify_notify_baton));
       verify_notify_baton->notify_func = notify_func;
       verify_notify_baton->notify_baton = notify_baton;
       verify_notify_baton->notify
-        = svn_repos_notify_create(svn_repos_notify_verify_rev_structure, pool);
+        = svn_repos_notify_create(svn_repos_notify_verify_rev_structure,
+                                  scratch_pool);
     }
 
   /* Verify global metadata and backend-specific data first. */
-  err = svn_fs_verify(svn_fs_path(fs, pool), svn_fs_config(fs, pool),
+  err = svn_fs_verify(svn_fs_path(fs, scratch_pool),
+                      svn_fs_config(fs, scratch_pool),
                       start_rev, end_rev,
                       verify_notify, verify_notify_baton,
-                      cancel_func, cancel_baton, pool);
+                      cancel_func, cancel_baton, scratch_pool);
 
   if (err && err->apr_err == SVN_ERR_CANCELLED)
     {
@@ -2462,36 +3636,511 @@ svn_repos_verify_fs3(svn_repos_t *repos,
   else if (err)
     {
       SVN_ERR(report_error(SVN_INVALID_REVNUM, err, verify_callback,
-                           verify_baton, iterpool));
+                           verify_baton, scratch_pool));
     }
 
   if (!metadata_only)
-    for (rev = start_rev; rev <= end_rev; rev++)
-      {
-        svn_pool_clear(iterpool);
-
-        /* Wrapper function to catch the possible errors. */
-        err = verify_one_revision(fs, rev, notify_func, notify_baton,
-                                  start_rev, check_normalization,
-                                  cancel_func, cancel_baton,
-                                  iterpool);
-
-        if (err && err->apr_err == SVN_ERR_CANCELLED)
-          {
+    {
+#if APR_HAS_THREADS
+      /* Revisions can be verified independently of each other. */
+      if (jobs > 1 && start_rev < end_rev)
+        SVN_ERR(verify_revisions_parallel(repos, start_rev, end_rev,
+                                          check_normalization, jobs,
+                                          notify_func, notify_baton,
+                                          verify_callback, verify_baton,
+                                          cancel_func, cancel_baton,
+                                          scratch_pool));
+      else
+#endif
+        SVN_ERR(verify_revisions(fs, start_rev, end_rev,
+                                 check_normalization,
+                                 notify_func, notify_baton,
+                                 verify_callback, verify_baton,
+                                 cancel_func, cancel_baton,
+                                 scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* One line of the verification journal: revisions START_REV to END_REV
+   have been verified successfully by library VERSION while being stored
+   in files with the combined FINGERPRINT. */
+typedef struct journal_entry_t
+{
+  svn_revnum_t start_rev;
+  svn_revnum_t end_rev;
+  const char *fingerprint;
+  const char *version;
+} journal_entry_t;
+
+/* A group of revisions that are stored in the same set of files, i.e.
+   that will only ever change together. */
+typedef struct verify_unit_t
+{
+  svn_revnum_t start_rev;
+  svn_revnum_t end_rev;
+
+  /* Fingerprint of the files.  NULL, if the unit can't be recorded. */
+  const char *fingerprint;
+
+  /* Whether the journal says that this unit has been verified before. */
+  svn_boolean_t unchanged;
+} verify_unit_t;
+
+/* Baton type for verify_failure_func. */
+typedef struct verify_failures_baton_t
+{
+  /* Revisions (svn_revnum_t) that failed verification.
+     SVN_INVALID_REVNUM is used for global metadata. */
+  apr_array_header_t *failed;
+
+  /* The caller's callback.  May be NULL. */
+  svn_repos_verify_callback_t verify_callback;
+  void *verify_baton;
+} verify_failures_baton_t;
+
+/* Implements svn_repos_verify_callback_t.  Remember the failed REVISION
+   in BATON, a verify_failures_baton_t, and forward VERIFY_ERR. */
+static svn_error_t *
+verify_failure_func(void *baton,
+                    svn_revnum_t revision,
+                    svn_error_t *verify_err,
+                    apr_pool_t *scratch_pool)
+{
+  verify_failures_baton_t *b = baton;
+
+  APR_ARRAY_PUSH(b->failed, svn_revnum_t) = revision;
+
+  /* Without a callback, the first failure ends the verification. */
+  if (b->verify_callback)
+    return b->verify_callback(b->verify_baton, revision, verify_err,
+                              scratch_pool);
+
+  return svn_error_dup(verify_err);
+}
+
+/* Return the path of REPOS' verification journal, allocated in
+   RESULT_POOL. */
+static const char *
+verify_journal_path(svn_repos_t *repos,
+                    apr_pool_t *result_pool)
+{
+  return svn_dirent_join(repos->path, SVN_REPOS__VERIFY_JOURNAL,
+                         result_pool);
+}
+
+/* Set *JOURNAL to the entries (journal_entry_t *) read from REPOS'
+   verification journal.  A missing journal is empty and malformed lines
+   are being ignored.  Allocate the result in RESULT_POOL. */
+static svn_error_t *
+read_verify_journal(apr_array_header_t **journal,
+                    svn_repos_t *repos,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *content;
+  apr_array_header_t *lines;
+  svn_error_t *err;
+  int i;
+
+  *journal = apr_array_make(result_pool, 16, sizeof(journal_entry_t *));
+
+  err = svn_stringbuf_from_file2(&content,
+                                 verify_journal_path(repos, scratch_pool),
+                                 scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  lines = svn_cstring_split(content->data, "\n", TRUE, scratch_pool);
+  for (i = 0; i < lines->nelts; ++i)
+    {
+      const char *line = APR_ARRAY_IDX(lines, i, const char *);
+      apr_array_header_t *fields;
+      journal_entry_t *entry;
+
+      if (*line == '#')
+        continue;
+
+      fields = svn_cstring_split(line, " ", TRUE, scratch_pool);
+      if (fields->nelts != 4)
+        continue;
+
+      entry = apr_pcalloc(result_pool, sizeof(*entry));
+      err = svn_error_compose_create(
+              svn_revnum_parse(&entry->start_rev,
+                               APR_ARRAY_IDX(fields, 0, const char *),
+                               NULL),
+              svn_revnum_parse(&entry->end_rev,
+                               APR_ARRAY_IDX(fields, 1, const char *),
+                               NULL));
+      if (err || entry->start_rev > entry->end_rev)
+        {
+          svn_error_clear(err);
+          continue;
+        }
+
+      entry->fingerprint = apr_pstrdup(result_pool,
+                                       APR_ARRAY_IDX(fields, 2,
+                                                     const char *));
+      entry->version = apr_pstrdup(result_pool,
+                                   APR_ARRAY_IDX(fields, 3, const char *));
+      APR_ARRAY_PUSH(*journal, journal_entry_t *) = entry;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Sort callback ordering journal_entry_t * by start revision. */
+static int
+compare_journal_entries(const void *lhs,
+                        const void *rhs)
+{
+  const journal_entry_t *lhs_entry = *(const journal_entry_t * const *)lhs;
+  const journal_entry_t *rhs_entry = *(const journal_entry_t * const *)rhs;
+
+  if (lhs_entry->start_rev == rhs_entry->start_rev)
+    return 0;
+
+  return lhs_entry->start_rev < rhs_entry->start_rev ? -1 : 1;
+}
+
+/* Atomically replace REPOS' verification journal with JOURNAL. */
+static svn_error_t *
+write_verify_journal(svn_repos_t *repos,
+                     apr_array_header_t *journal,
+                     apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *content
+    = svn_stringbuf_create("# Revisions verified by"
+                           " 'svnadmin verify --incremental'.\n"
+                           "# START END FINGERPRINT VERSION\n",
+                           scratch_pool);
+  int i;
+
+  svn_sort__array(journal, compare_journal_entries);
+  for (i = 0; i < journal->nelts; ++i)
+    {
+      const journal_entry_t *entry
+        = APR_ARRAY_IDX(journal, i, const journal_entry_t *);
+
+      svn_stringbuf_appendcstr(content,
+                               apr_psprintf(scratch_pool, "%ld %ld %s %s\n",
+                                            entry->start_rev,
+                                            entry->end_rev,
+                                            entry->fingerprint,
+                                            entry->version));
+    }
+
+  return svn_error_trace(svn_io_write_atomic2(
+                           verify_journal_path(repos, scratch_pool),
+                           content->data, content->len,
+                           NULL, FALSE, scratch_pool));
+}
+
+/* Set *FINGERPRINT to a SHA1 digest over the paths relative to FS_PATH
+   and the contents of all FILES.  Allocate it in RESULT_POOL. */
+static svn_error_t *
+compute_fingerprint(const char **fingerprint,
+                    const char *fs_path,
+                    const apr_array_header_t *files,
+                    svn_cancel_func_t cancel_func,
+                    void *cancel_baton,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_checksum_ctx_t *context
+    = svn_checksum_ctx_create(svn_checksum_sha1, scratch_pool);
+  svn_checksum_t *checksum;
+  int i;
+
+  for (i = 0; i < files->nelts; ++i)
+    {
+      const char *file = APR_ARRAY_IDX(files, i, const char *);
+      const char *name = svn_dirent_skip_ancestor(fs_path, file);
+
+      svn_pool_clear(iterpool);
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      if (name == NULL)
+        name = file;
+
+      SVN_ERR(svn_io_file_checksum2(&checksum, file, svn_checksum_sha1,
+                                    iterpool));
+      SVN_ERR(svn_checksum_update(context, name, strlen(name) + 1));
+      SVN_ERR(svn_checksum_update(context, checksum->digest,
+                                  svn_checksum_size(checksum)));
+    }
+
+  SVN_ERR(svn_checksum_final(&checksum, context, scratch_pool));
+  *fingerprint = svn_checksum_to_cstring_display(checksum, result_pool);
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return TRUE if JOURNAL contains an entry matching UNIT. */
+static svn_boolean_t
+is_journaled(const apr_array_header_t *journal,
+             const verify_unit_t *unit)
+{
+  int i;
+
+  for (i = 0; i < journal->nelts; ++i)
+    {
+      const journal_entry_t *entry
+        = APR_ARRAY_IDX(journal, i, const journal_entry_t *);
+
+      if (   entry->start_rev == unit->start_rev
+          && entry->end_rev == unit->end_rev
+          && strcmp(entry->fingerprint, unit->fingerprint) == 0
+          && strcmp(entry->version, SVN_VER_NUMBER) == 0)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+/* Record UNIT in JOURNAL, replacing all entries that overlap with it. */
+static void
+journal_unit(apr_array_header_t *journal,
+             const verify_unit_t *unit)
+{
+  journal_entry_t *entry;
+  int i;
+
+  for (i = journal->nelts - 1; i >= 0; --i)
+    {
+      entry = APR_ARRAY_IDX(journal, i, journal_entry_t *);
+      if (entry->start_rev <= unit->end_rev
+          && entry->end_rev >= unit->start_rev)
+        svn_sort__array_delete(journal, i, 1);
+    }
+
+  entry = apr_pcalloc(journal->pool, sizeof(*entry));
+  entry->start_rev = unit->start_rev;
+  entry->end_rev = unit->end_rev;
+  entry->fingerprint = apr_pstrdup(journal->pool, unit->fingerprint);
+  entry->version = SVN_VER_NUMBER;
+  APR_ARRAY_PUSH(journal, journal_entry_t *) = entry;
+}
+
+/* Like verify_range() but skip all revisions that the verification
+   journal of REPOS lists as unchanged since their last successful
+   verification.  Record the newly verified ones in the journal. */
+static svn_error_t *
+verify_incremental(svn_repos_t *repos,
+                   svn_revnum_t start_rev,
+                   svn_revnum_t end_rev,
+                   svn_boolean_t check_normalization,
+                   int jobs,
+                   svn_repos_notify_func_t notify_func,
+                   void *notify_baton,
+                   svn_repos_verify_callback_t verify_callback,
+                   void *verify_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *scratch_pool)
+{
+  svn_fs_t *fs = svn_repos_fs(repos);
+  const char *fs_path = svn_fs_path(fs, scratch_pool);
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_array_header_t *journal;
+  apr_array_header_t *units
+    = apr_array_make(scratch_pool, 16, sizeof(verify_unit_t));
+  verify_failures_baton_t failures;
+  svn_revnum_t rev;
+  int i;
+
+  SVN_ERR(read_verify_journal(&journal, repos, scratch_pool, iterpool));
+
+  /* Split the range into units and find those that need verification. */
+  for (rev = start_rev; rev <= end_rev; )
+    {
+      verify_unit_t *unit;
+      apr_array_header_t *files;
+      svn_revnum_t unit_start, unit_end;
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_fs__get_revision_files(&files, &unit_start, &unit_end,
+                                         fs, rev, iterpool, iterpool));
+
+      /* The backend can't tell.  Verify everything. */
+      if (files == NULL)
+        {
+          svn_pool_destroy(iterpool);
+          return svn_error_trace(verify_range(repos, start_rev, end_rev,
+                                              check_normalization, FALSE,
+                                              jobs, notify_func,
+                                              notify_baton, verify_callback,
+                                              verify_baton, cancel_func,
+                                              cancel_baton, scratch_pool));
+        }
+
+      unit = apr_array_push(units);
+      unit->start_rev = unit_start;
+      unit->end_rev = unit_end;
+      unit->fingerprint = NULL;
+      unit->unchanged = FALSE;
+
+      /* Units that we only partially verify can't be recorded.
+         Unreadable files will be reported by the verification itself. */
+      if (unit_start >= start_rev && unit_end <= end_rev)
+        {
+          err = compute_fingerprint(&unit->fingerprint, fs_path, files,
+                                    cancel_func, cancel_baton,
+                                    scratch_pool, iterpool);
+          if (err && err->apr_err == SVN_ERR_CANCELLED)
             return svn_error_trace(err);
-          }
-        else if (err)
-          {
-            SVN_ERR(report_error(rev, err, verify_callback, verify_baton,
-                                 iterpool));
-          }
-        else if (notify_func)
-          {
-            /* Tell the caller that we're done with this revision. */
-            notify->revision = rev;
-            notify_func(notify_baton, notify, iterpool);
-          }
-      }
+
+          svn_error_clear(err);
+          unit->unchanged = unit->fingerprint
+                         && is_journaled(journal, unit);
+        }
+
+      rev = unit_end + 1;
+    }
+
+  failures.failed = apr_array_make(scratch_pool, 4, sizeof(svn_revnum_t));
+  failures.verify_callback = verify_callback;
+  failures.verify_baton = verify_baton;
+
+  /* Verify consecutive changed units in one go. */
+  for (i = 0; i < units->nelts; )
+    {
+      verify_unit_t *unit = &APR_ARRAY_IDX(units, i, verify_unit_t);
+      svn_revnum_t run_start, run_end;
+      int first = i;
+      int k;
+
+      svn_pool_clear(iterpool);
+
+      if (unit->unchanged)
+        {
+          if (notify_func)
+            {
+              svn_repos_notify_t *notify
+                = svn_repos_notify_create(
+                    svn_repos_notify_verify_rev_range_unchanged, iterpool);
+
+              notify->start_revision = unit->start_rev;
+              notify->end_revision = unit->end_rev;
+              notify_func(notify_baton, notify, iterpool);
+            }
+
+          ++i;
+          continue;
+        }
+
+      while (i < units->nelts
+             && !APR_ARRAY_IDX(units, i, verify_unit_t).unchanged)
+        ++i;
+
+      run_start = MAX(unit->start_rev, start_rev);
+      run_end = MIN(APR_ARRAY_IDX(units, i - 1, verify_unit_t).end_rev,
+                    end_rev);
+
+      apr_array_clear(failures.failed);
+      SVN_ERR(verify_range(repos, run_start, run_end, check_normalization,
+                           FALSE, jobs, notify_func, notify_baton,
+                           verify_failure_func, &failures,
+                           cancel_func, cancel_baton, iterpool));
+
+      /* Remember what passed, so an interrupted run won't be wasted. */
+      for (k = first; k < i; ++k)
+        {
+          verify_unit_t *verified = &APR_ARRAY_IDX(units, k, verify_unit_t);
+          svn_boolean_t failed = FALSE;
+          int f;
+
+          for (f = 0; f < failures.failed->nelts && !failed; ++f)
+            {
+              svn_revnum_t failed_rev
+                = APR_ARRAY_IDX(failures.failed, f, svn_revnum_t);
+
+              failed = !SVN_IS_VALID_REVNUM(failed_rev)
+                    || (   failed_rev >= verified->start_rev
+                        && failed_rev <= verified->end_rev);
+            }
+
+          if (verified->fingerprint && !failed)
+            journal_unit(journal, verified);
+        }
+
+      SVN_ERR(write_verify_journal(repos, journal, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos_verify_fs4(svn_repos_t *repos,
+                     svn_revnum_t start_rev,
+                     svn_revnum_t end_rev,
+                     svn_boolean_t check_normalization,
+                     svn_boolean_t metadata_only,
+                     svn_boolean_t incremental,
+                     int jobs,
+                     svn_repos_notify_func_t notify_func,
+                     void *notify_baton,
+                     svn_repos_verify_callback_t verify_callback,
+                     void *verify_baton,
+                     svn_cancel_func_t cancel_func,
+                     void *cancel_baton,
+                     apr_pool_t *pool)
+{
+  svn_fs_t *fs = svn_repos_fs(repos);
+  svn_revnum_t youngest;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_repos_notify_t *notify;
+
+  /* Make sure we catch up on the latest revprop changes.  This is the only
+   * time we will refresh the revprop data in this query. */
+  SVN_ERR(svn_fs_refresh_revision_props(fs, pool));
+
+  /* Determine the current youngest revision of the filesystem. */
+  SVN_ERR(svn_fs_youngest_rev(&youngest, fs, pool));
+
+  /* Use default vals if necessary. */
+  if (! SVN_IS_VALID_REVNUM(start_rev))
+    start_rev = 0;
+  if (! SVN_IS_VALID_REVNUM(end_rev))
+    end_rev = youngest;
+
+  /* Validate the revisions. */
+  if (start_rev > end_rev)
+    return svn_error_createf(SVN_ERR_REPOS_BAD_ARGS, NULL,
+                             _("Start revision %ld"
+                               " is greater than end revision %ld"),
+                             start_rev, end_rev);
+  if (end_rev > youngest)
+    return svn_error_createf(SVN_ERR_REPOS_BAD_ARGS, NULL,
+                             _("End revision %ld is invalid "
+                               "(youngest revision is %ld)"),
+                             end_rev, youngest);
+
+  if (incremental && !metadata_only)
+    SVN_ERR(verify_incremental(repos, start_rev, end_rev,
+                               check_normalization, jobs,
+                               notify_func, notify_baton,
+                               verify_callback, verify_baton,
+                               cancel_func, cancel_baton, iterpool));
+  else
+    SVN_ERR(verify_range(repos, start_rev, end_rev, check_normalization,
+                         metadata_only, jobs, notify_func, notify_baton,
+                         verify_callback, verify_baton,
+                         cancel_func, cancel_baton, iterpool));
 
   /* We're done. */
   if (notify_func)
@@ -44,11 +44,13 @@
 /*** Commit wrappers ***/
 
 svn_error_t *
-svn_repos_fs_commit_txn(const char **conflict_p,
-                        svn_repos_t *repos,
-                        svn_revnum_t *new_rev,
-                        svn_fs_txn_t *txn,
-                        apr_pool_t *pool)
+svn_repos__fs_commit_txn_timed(const char **conflict_p,
+                               svn_repos_t *repos,
+                               svn_revnum_t *new_rev,
+                               svn_fs_txn_t *txn,
+                               apr_interval_time_t *hooks_time,
+                               apr_interval_time_t *fs_time,
+                               apr_pool_t *pool)
 {
   svn_error_t *err, *err2;
   const char *txn_name;
@@ -56,10 +58,15 @@ svn_repos_fs_commit_txn(const char **conflict_p,
   apr_pool_t *iterpool;
   apr_hash_index_t *hi;
   apr_hash_t *hooks_env;
+  apr_time_t start;
 
   *new_rev = SVN_INVALID_REVNUM;
   if (conflict_p)
     *conflict_p = NULL;
+  if (hooks_time)
+    *hooks_time = 0;
+  if (fs_time)
+    *fs_time = 0;
 
   /* Parse the hooks-env file (if any). */
   SVN_ERR(svn_repos__parse_hooks_env(&hooks_env, repos->hooks_env_path,
@@ -67,7 +74,11 @@ svn_repos_fs_commit_txn(const char **conflict_p,
 
   /* Run pre-commit hooks. */
   SVN_ERR(svn_fs_txn_name(&txn_name, txn, pool));
-  SVN_ERR(svn_repos__hooks_pre_commit(repos, hooks_env, txn_name, pool));
+  start = apr_time_now();
+  err = svn_repos__hooks_pre_commit(repos, hooks_env, txn_name, pool);
+  if (hooks_time)
+    *hooks_time += apr_time_now() - start;
+  SVN_ERR(err);
 
   /* Remove any ephemeral transaction properties.  If the commit fails
      we will attempt to restore the properties but if that fails, or
@@ -89,7 +100,10 @@ svn_repos_fs_commit_txn(const char **conflict_p,
   svn_pool_destroy(iterpool);
 
   /* Commit. */
+  start = apr_time_now();
   err = svn_fs_commit_txn(conflict_p, new_rev, txn, pool);
+  if (fs_time)
+    *fs_time = apr_time_now() - start;
   if (! SVN_IS_VALID_REVNUM(*new_rev))
     {
       /* The commit failed, try to restore the ephemeral properties. */
@@ -111,8 +125,12 @@ svn_repos_fs_commit_txn(const char **conflict_p,
     }
 
   /* Run post-commit hooks. */
-  if ((err2 = svn_repos__hooks_post_commit(repos, hooks_env,
-                                           *new_rev, txn_name, pool)))
+  start = apr_time_now();
+  err2 = svn_repos__hooks_post_commit(repos, hooks_env,
+                                      *new_rev, txn_name, pool);
+  if (hooks_time)
+    *hooks_time += apr_time_now() - start;
+  if (err2)
     {
       err2 = svn_error_create
                (SVN_ERR_REPOS_POST_COMMIT_HOOK_FAILED, err2,
@@ -122,6 +140,18 @@ svn_repos_fs_commit_txn(const char **conflict_p,
   return svn_error_compose_create(err, err2);
 }
 
+svn_error_t *
+svn_repos_fs_commit_txn(const char **conflict_p,
+                        svn_repos_t *repos,
+                        svn_revnum_t *new_rev,
+                        svn_fs_txn_t *txn,
+                        apr_pool_t *pool)
+{
+  return svn_error_trace(svn_repos__fs_commit_txn_timed(conflict_p, repos,
+                                                        new_rev, txn,
+                                                        NULL, NULL, pool));
+}
+
 
 
 /*** Transaction creation wrappers. ***/
@@ -1000,7 +1030,8 @@ pack_notify_func(void *baton,
 }
 
 svn_error_t *
-svn_repos_fs_pack2(svn_repos_t *repos,
+svn_repos_fs_pack3(svn_repos_t *repos,
+                   int jobs,
                    svn_repos_notify_func_t notify_func,
                    void *notify_baton,
                    svn_cancel_func_t cancel_func,
@@ -1012,10 +1043,12 @@ svn_repos_fs_pack2(svn_repos_t *repos,
   pnb.notify_func = notify_func;
   pnb.notify_baton = notify_baton;
 
-  return svn_fs_pack(repos->db_path,
-                     notify_func ? pack_notify_func : NULL,
-                     notify_func ? &pnb : NULL,
-                     cancel_func, cancel_baton, pool);
+  /* Pack with the same FS configuration that REPOS has been opened with. */
+  return svn_fs_pack2(repos->db_path, jobs,
+                      svn_fs_config(repos->fs, pool),
+                      notify_func ? pack_notify_func : NULL,
+                      notify_func ? &pnb : NULL,
+                      cancel_func, cancel_baton, pool);
 }
 
 svn_error_t *
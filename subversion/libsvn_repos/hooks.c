@@ -26,6 +26,8 @@
 
 #include <apr_pools.h>
 #include <apr_file_io.h>
+#include <apr_thread_proc.h>
+#include <apr_thread_cond.h>
 
 #include "svn_config.h"
 #include "svn_hash.h"
@@ -38,6 +40,7 @@
 #include "repos.h"
 #include "svn_private_config.h"
 #include "private/svn_fs_private.h"
+#include "private/svn_mutex.h"
 #include "private/svn_repos_private.h"
 #include "private/svn_string_private.h"
 
@@ -193,6 +196,26 @@ env_from_env_hash(apr_hash_t *env_hash,
   return env;
 }
 
+/* Return the environment for the hook NAME from HOOKS_ENV, i.e. the
+   custom environment defined for this hook, or else the default
+   environment.  Return NULL if neither is defined. */
+static apr_hash_t *
+get_hook_env(apr_hash_t *hooks_env,
+             const char *name)
+{
+  apr_hash_t *hook_env = NULL;
+
+  if (hooks_env)
+    {
+      hook_env = svn_hash_gets(hooks_env, name);
+      if (hook_env == NULL)
+        hook_env = svn_hash_gets(hooks_env,
+                                 SVN_REPOS__HOOKS_ENV_DEFAULT_SECTION);
+    }
+
+  return hook_env;
+}
+
 /* NAME, CMD and ARGS are the name, path to and arguments for the hook
    program that is to be run.  The hook's exit status will be checked,
    and if an error occurred the hook's stderr output will be added to
@@ -217,7 +240,7 @@ run_hook_cmd(svn_string_t **result,
   svn_error_t *err;
   apr_proc_t cmd_proc = {0};
   apr_pool_t *cmd_pool;
-  apr_hash_t *hook_env = NULL;
+  apr_hash_t *hook_env;
 
   if (result)
     {
@@ -237,15 +260,7 @@ run_hook_cmd(svn_string_t **result,
    * destroy in order to clean up the stderr pipe opened for the process. */
   cmd_pool = svn_pool_create(pool);
 
-  /* Check if a custom environment is defined for this hook, or else
-   * whether a default environment is defined. */
-  if (hooks_env)
-    {
-      hook_env = svn_hash_gets(hooks_env, name);
-      if (hook_env == NULL)
-        hook_env = svn_hash_gets(hooks_env,
-                                 SVN_REPOS__HOOKS_ENV_DEFAULT_SECTION);
-    }
+  hook_env = get_hook_env(hooks_env, name);
 
   err = svn_io_start_cmd3(&cmd_proc, ".", cmd, args,
                           env_from_env_hash(hook_env, pool, pool),
@@ -301,6 +316,400 @@ create_temp_file(apr_file_t **f, const svn_string_t *value, apr_pool_t *pool)
   return svn_io_file_seek(*f, APR_SET, &offset, pool);
 }
 
+/*** Asynchronous execution of post-event hooks. ***/
+
+#if APR_HAS_THREADS
+
+/* A hook invocation waiting in the queue.  All members are allocated
+   in POOL, which the worker destroys after running the hook. */
+typedef struct hook_job_t
+{
+  /* Parameters as for run_hook_cmd(). */
+  const char *name;
+  const char *cmd;
+  const char **args;
+  apr_hash_t *hooks_env;
+
+  /* Contents to pass as the hook's stdin or NULL to pass no stdin. */
+  svn_string_t *stdin_value;
+
+  /* Next job in the queue. */
+  struct hook_job_t *next;
+
+  apr_pool_t *pool;
+} hook_job_t;
+
+/* A bounded FIFO of hook invocations served by a fixed set of worker
+   threads. */
+typedef struct hook_queue_t
+{
+  /* Protects all members below.  Used with JOB_ADDED and JOB_TAKEN. */
+  svn_mutex__t *mutex;
+
+  /* Signaled when a job has been added or the queue is shutting down. */
+  apr_thread_cond_t *job_added;
+
+  /* Signaled when a worker took a job off the queue. */
+  apr_thread_cond_t *job_taken;
+
+  /* The queued jobs, oldest first.  NULL if the queue is empty. */
+  hook_job_t *first;
+  hook_job_t *last;
+
+  /* Number of jobs in the queue and the limit for it. */
+  apr_size_t depth;
+  apr_size_t max_depth;
+
+  /* Once set, the workers terminate as soon as the queue is empty. */
+  svn_boolean_t shutdown;
+
+  /* The worker threads.  Entries are NULL for threads that could not
+     be started. */
+  apr_thread_t **threads;
+  int thread_count;
+
+  /* Where to report hook failures. */
+  svn_repos__hook_error_func_t error_func;
+  void *error_baton;
+
+  /* Thread-safe root pool containing this structure and all jobs. */
+  apr_pool_t *pool;
+} hook_queue_t;
+
+/* The queue used by all post-event hooks or NULL if those shall run
+   synchronously. */
+static hook_queue_t *hook_queue = NULL;
+
+/* Run the hook described by JOB and wait for it to finish. */
+static svn_error_t *
+run_hook_job(hook_job_t *job)
+{
+  apr_file_t *stdin_handle = NULL;
+
+  if (job->stdin_value)
+    SVN_ERR(create_temp_file(&stdin_handle, job->stdin_value, job->pool));
+
+  SVN_ERR(run_hook_cmd(NULL, job->name, job->cmd, job->args, job->hooks_env,
+                       stdin_handle, job->pool));
+
+  if (stdin_handle)
+    SVN_ERR(svn_io_file_close(stdin_handle, job->pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *JOB to the next job from QUEUE, waiting for one if necessary.
+   Set it to NULL if the queue is empty and shutting down. */
+static svn_error_t *
+take_hook_job(hook_job_t **job,
+              hook_queue_t *queue)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+
+  SVN_ERR(svn_mutex__lock(queue->mutex));
+
+  while (!queue->first && !queue->shutdown)
+    {
+      apr_status_t status
+        = apr_thread_cond_wait(queue->job_added,
+                               svn_mutex__get(queue->mutex));
+      if (status)
+        {
+          err = svn_error_wrap_apr(status,
+                                   _("Can't wait for condition variable"));
+          break;
+        }
+    }
+
+  *job = queue->first;
+  if (*job)
+    {
+      queue->first = (*job)->next;
+      if (!queue->first)
+        queue->last = NULL;
+
+      --queue->depth;
+      apr_thread_cond_signal(queue->job_taken);
+    }
+
+  return svn_error_trace(svn_mutex__unlock(queue->mutex, err));
+}
+
+/* Thread function.  Run the hooks queued in the hook_queue_t given by
+   DATA until the queue has been shut down and drained. */
+static void * APR_THREAD_FUNC
+hook_thread(apr_thread_t *tid,
+            void *data)
+{
+  hook_queue_t *queue = data;
+
+  while (TRUE)
+    {
+      hook_job_t *job = NULL;
+      svn_error_t *err = take_hook_job(&job, queue);
+
+      /* Don't drop a job that we already took off the queue. */
+      if (job)
+        err = svn_error_compose_create(err, run_hook_job(job));
+
+      if (err && queue->error_func)
+        queue->error_func(queue->error_baton, err);
+      svn_error_clear(err);
+
+      if (!job)
+        break;
+
+      svn_pool_destroy(job->pool);
+    }
+
+  return NULL;
+}
+
+/* If post-event hooks shall run asynchronously, queue the hook NAME
+   with the parameters CMD, ARGS and HOOKS_ENV as for run_hook_cmd() to
+   be run by a worker of HOOK_QUEUE and set *QUEUED to TRUE.  Pass
+   STDIN_VALUE to the hook's stdin unless that is NULL.  Block while the
+   queue is full.
+
+   Otherwise, set *QUEUED to FALSE and leave running the hook to the
+   caller. */
+static svn_error_t *
+maybe_queue_hook_cmd(svn_boolean_t *queued,
+                     const char *name,
+                     const char *cmd,
+                     const char **args,
+                     apr_hash_t *hooks_env,
+                     const svn_string_t *stdin_value,
+                     apr_pool_t *scratch_pool)
+{
+  hook_queue_t *queue = hook_queue;
+  apr_pool_t *job_pool;
+  hook_job_t *job;
+  apr_hash_t *hook_env;
+  svn_error_t *err;
+  int count, i;
+
+  *queued = FALSE;
+  if (queue == NULL)
+    return SVN_NO_ERROR;
+
+  job_pool = svn_pool_create(queue->pool);
+  job = apr_pcalloc(job_pool, sizeof(*job));
+  hook_env = get_hook_env(hooks_env, name);
+
+  /* The job will outlive the caller's pools, so copy everything. */
+  job->pool = job_pool;
+  job->name = apr_pstrdup(job_pool, name);
+  job->cmd = apr_pstrdup(job_pool, cmd);
+
+  for (count = 0; args[count]; ++count)
+    ;
+  job->args = apr_palloc(job_pool, (count + 1) * sizeof(*job->args));
+  for (i = 0; i < count; ++i)
+    job->args[i] = apr_pstrdup(job_pool, args[i]);
+  job->args[count] = NULL;
+
+  if (hook_env)
+    {
+      apr_hash_t *env_copy = apr_hash_make(job_pool);
+      apr_hash_index_t *hi;
+
+      for (hi = apr_hash_first(scratch_pool, hook_env); hi;
+           hi = apr_hash_next(hi))
+        svn_hash_sets(env_copy,
+                      apr_pstrdup(job_pool, apr_hash_this_key(hi)),
+                      apr_pstrdup(job_pool, apr_hash_this_val(hi)));
+
+      job->hooks_env = apr_hash_make(job_pool);
+      svn_hash_sets(job->hooks_env, job->name, env_copy);
+    }
+
+  if (stdin_value)
+    job->stdin_value = svn_string_dup(stdin_value, job_pool);
+
+  err = svn_mutex__lock(queue->mutex);
+  if (err)
+    {
+      svn_pool_destroy(job_pool);
+      return svn_error_trace(err);
+    }
+
+  /* Backpressure: wait for the workers to catch up. */
+  while (queue->depth >= queue->max_depth && !queue->shutdown)
+    {
+      apr_status_t status
+        = apr_thread_cond_wait(queue->job_taken,
+                               svn_mutex__get(queue->mutex));
+      if (status)
+        {
+          err = svn_error_wrap_apr(status,
+                                   _("Can't wait for condition variable"));
+          break;
+        }
+    }
+
+  if (!err && queue->shutdown)
+    err = svn_error_createf(SVN_ERR_REPOS_HOOK_FAILURE, NULL,
+                            _("Can't queue '%s' hook during shutdown"),
+                            name);
+
+  if (!err)
+    {
+      if (queue->last)
+        queue->last->next = job;
+      else
+        queue->first = job;
+
+      queue->last = job;
+      ++queue->depth;
+      *queued = TRUE;
+
+      apr_thread_cond_signal(queue->job_added);
+    }
+
+  err = svn_mutex__unlock(queue->mutex, err);
+
+  /* Once queued, the job belongs to the workers. */
+  if (!*queued)
+    svn_pool_destroy(job_pool);
+
+  return svn_error_trace(err);
+}
+
+/* Pool cleanup function.  Shut down the hook_queue_t given by DATA
+   after all queued hooks have been run. */
+static apr_status_t
+hook_queue_cleanup(void *data)
+{
+  hook_queue_t *queue = data;
+  svn_error_t *err;
+  int i;
+
+  /* Even if we can't get the lock, the workers need to terminate. */
+  err = svn_mutex__lock(queue->mutex);
+  queue->shutdown = TRUE;
+  apr_thread_cond_broadcast(queue->job_added);
+  apr_thread_cond_broadcast(queue->job_taken);
+  if (!err)
+    err = svn_mutex__unlock(queue->mutex, SVN_NO_ERROR);
+  svn_error_clear(err);
+
+  for (i = 0; i < queue->thread_count; ++i)
+    if (queue->threads[i])
+      {
+        apr_status_t retval;
+        apr_thread_join(&retval, queue->threads[i]);
+      }
+
+  hook_queue = NULL;
+  svn_pool_destroy(queue->pool);
+
+  return APR_SUCCESS;
+}
+
+#else
+
+/* Without thread support, hooks always run synchronously. */
+static svn_error_t *
+maybe_queue_hook_cmd(svn_boolean_t *queued,
+                     const char *name,
+                     const char *cmd,
+                     const char **args,
+                     apr_hash_t *hooks_env,
+                     const svn_string_t *stdin_value,
+                     apr_pool_t *scratch_pool)
+{
+  *queued = FALSE;
+  return SVN_NO_ERROR;
+}
+
+#endif /* APR_HAS_THREADS */
+
+svn_error_t *
+svn_repos__hooks_async_init(int thread_count,
+                            apr_size_t max_queue_depth,
+                            svn_repos__hook_error_func_t error_func,
+                            void *error_baton,
+                            apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  apr_pool_t *queue_pool;
+  hook_queue_t *queue;
+  apr_status_t status;
+  int i, started = 0;
+
+  SVN_ERR_ASSERT(hook_queue == NULL);
+  SVN_ERR_ASSERT(thread_count > 0 && max_queue_depth > 0);
+
+  queue_pool = apr_allocator_owner_get(svn_pool_create_allocator(TRUE));
+  queue = apr_pcalloc(queue_pool, sizeof(*queue));
+  queue->pool = queue_pool;
+  queue->max_depth = max_queue_depth;
+  queue->error_func = error_func;
+  queue->error_baton = error_baton;
+  queue->thread_count = thread_count;
+  queue->threads = apr_pcalloc(queue_pool,
+                               thread_count * sizeof(*queue->threads));
+
+  SVN_ERR(svn_mutex__init(&queue->mutex, TRUE, queue_pool));
+  status = apr_thread_cond_create(&queue->job_added, queue_pool);
+  if (!status)
+    status = apr_thread_cond_create(&queue->job_taken, queue_pool);
+  if (status)
+    {
+      svn_pool_destroy(queue_pool);
+      return svn_error_wrap_apr(status,
+                                _("Can't create condition variable"));
+    }
+
+  for (i = 0; i < thread_count; ++i)
+    {
+      status = apr_thread_create(&queue->threads[i], NULL, hook_thread,
+                                 queue, queue_pool);
+      if (status)
+        queue->threads[i] = NULL;
+      else
+        ++started;
+    }
+
+  /* Without any worker, queued hooks would never run. */
+  if (started == 0)
+    {
+      svn_pool_destroy(queue_pool);
+      return svn_error_wrap_apr(status, _("Can't create hook thread"));
+    }
+
+  /* Drain the queue before POOL's subpools and the caller's state that
+     the error function may depend on go away. */
+  apr_pool_pre_cleanup_register(pool, queue, hook_queue_cleanup);
+  hook_queue = queue;
+
+  return SVN_NO_ERROR;
+#else
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("Asynchronous hooks require thread support"));
+#endif
+}
+
+svn_error_t *
+svn_repos__hooks_async_queue_depth(apr_size_t *depth)
+{
+#if APR_HAS_THREADS
+  hook_queue_t *queue = hook_queue;
+
+  *depth = 0;
+  if (queue)
+    {
+      SVN_ERR(svn_mutex__lock(queue->mutex));
+      *depth = queue->depth;
+      SVN_ERR(svn_mutex__unlock(queue->mutex, SVN_NO_ERROR));
+    }
+#else
+  *depth = 0;
+#endif
+
+  return SVN_NO_ERROR;
+}
 
 /* Check if the HOOK program exists and is a file or a symbolic link, using
    POOL for temporary allocations.
@@ -606,6 +1015,7 @@ svn_repos__hooks_post_commit(svn_repos_t *repos,
   else if (hook)
     {
       const char *args[5];
+      svn_boolean_t queued;
 
       args[0] = hook;
       args[1] = svn_dirent_local_style(svn_repos_path(repos, pool), pool);
@@ -613,8 +1023,11 @@ svn_repos__hooks_post_commit(svn_repos_t *repos,
       args[3] = txn_name;
       args[4] = NULL;
 
-      SVN_ERR(run_hook_cmd(NULL, SVN_REPOS__HOOK_POST_COMMIT, hook, args,
-                           hooks_env, NULL, pool));
+      SVN_ERR(maybe_queue_hook_cmd(&queued, SVN_REPOS__HOOK_POST_COMMIT,
+                                   hook, args, hooks_env, NULL, pool));
+      if (!queued)
+        SVN_ERR(run_hook_cmd(NULL, SVN_REPOS__HOOK_POST_COMMIT, hook, args,
+                             hooks_env, NULL, pool));
     }
 
   return SVN_NO_ERROR;
@@ -706,13 +1119,7 @@ svn_repos__hooks_post_revprop_change(svn_repos_t *repos,
       const char *args[7];
       apr_file_t *stdin_handle = NULL;
       char action_string[2];
-
-      /* Pass the old value as stdin to hook */
-      if (old_value)
-        SVN_ERR(create_temp_file(&stdin_handle, old_value, pool));
-      else
-        SVN_ERR(svn_io_file_open(&stdin_handle, SVN_NULL_DEVICE_NAME,
-                                 APR_READ, APR_OS_DEFAULT, pool));
+      svn_boolean_t queued;
 
       action_string[0] = action;
       action_string[1] = '\0';
@@ -725,6 +1132,23 @@ svn_repos__hooks_post_revprop_change(svn_repos_t *repos,
       args[5] = action_string;
       args[6] = NULL;
 
+      /* An empty stdin is as good as the null device. */
+      SVN_ERR(maybe_queue_hook_cmd(&queued,
+                                   SVN_REPOS__HOOK_POST_REVPROP_CHANGE,
+                                   hook, args, hooks_env,
+                                   old_value ? old_value
+                                             : svn_string_create_empty(pool),
+                                   pool));
+      if (queued)
+        return SVN_NO_ERROR;
+
+      /* Pass the old value as stdin to hook */
+      if (old_value)
+        SVN_ERR(create_temp_file(&stdin_handle, old_value, pool));
+      else
+        SVN_ERR(svn_io_file_open(&stdin_handle, SVN_NULL_DEVICE_NAME,
+                                 APR_READ, APR_OS_DEFAULT, pool));
+
       SVN_ERR(run_hook_cmd(NULL, SVN_REPOS__HOOK_POST_REVPROP_CHANGE, hook,
                            args, hooks_env, stdin_handle, pool));
 
@@ -802,8 +1226,7 @@ svn_repos__hooks_post_lock(svn_repos_t *repos,
       svn_string_t *paths_str = svn_string_create(svn_cstring_join
                                                   (paths, "\n", pool),
                                                   pool);
-
-      SVN_ERR(create_temp_file(&stdin_handle, paths_str, pool));
+      svn_boolean_t queued;
 
       args[0] = hook;
       args[1] = svn_dirent_local_style(svn_repos_path(repos, pool), pool);
@@ -811,6 +1234,13 @@ svn_repos__hooks_post_lock(svn_repos_t *repos,
       args[3] = NULL;
       args[4] = NULL;
 
+      SVN_ERR(maybe_queue_hook_cmd(&queued, SVN_REPOS__HOOK_POST_LOCK, hook,
+                                   args, hooks_env, paths_str, pool));
+      if (queued)
+        return SVN_NO_ERROR;
+
+      SVN_ERR(create_temp_file(&stdin_handle, paths_str, pool));
+
       SVN_ERR(run_hook_cmd(NULL, SVN_REPOS__HOOK_POST_LOCK, hook, args,
                            hooks_env, stdin_handle, pool));
 
@@ -878,8 +1308,7 @@ svn_repos__hooks_post_unlock(svn_repos_t *repos,
       svn_string_t *paths_str = svn_string_create(svn_cstring_join
                                                   (paths, "\n", pool),
                                                   pool);
-
-      SVN_ERR(create_temp_file(&stdin_handle, paths_str, pool));
+      svn_boolean_t queued;
 
       args[0] = hook;
       args[1] = svn_dirent_local_style(svn_repos_path(repos, pool), pool);
@@ -887,6 +1316,13 @@ svn_repos__hooks_post_unlock(svn_repos_t *repos,
       args[3] = NULL;
       args[4] = NULL;
 
+      SVN_ERR(maybe_queue_hook_cmd(&queued, SVN_REPOS__HOOK_POST_UNLOCK, hook,
+                                   args, hooks_env, paths_str, pool));
+      if (queued)
+        return SVN_NO_ERROR;
+
+      SVN_ERR(create_temp_file(&stdin_handle, paths_str, pool));
+
       SVN_ERR(run_hook_cmd(NULL, SVN_REPOS__HOOK_POST_UNLOCK, hook, args,
                            hooks_env, stdin_handle, pool));
 
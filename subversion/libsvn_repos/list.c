@@ -22,12 +22,15 @@
 
 #include <apr_pools.h>
 #include <apr_fnmatch.h>
+#include <apr_thread_proc.h>
+#include <apr_thread_cond.h>
 
 #include "svn_pools.h"
 #include "svn_error.h"
 #include "svn_dirent_uri.h"
 #include "svn_time.h"
 
+#include "private/svn_mutex.h"
 #include "private/svn_repos_private.h"
 #include "private/svn_sorts_private.h"
 #include "svn_private_config.h" /* for SVN_TEMPLATE_ROOT_DIR */
@@ -110,11 +113,90 @@ matches_any(const char *dirname,
   return FALSE;
 }
 
+/* Return TRUE if the glob PATTERN requires a literal '/' in the name it
+ * matches, i.e. if it contains a '/' outside of a bracket expression.
+ * A '/' in a bracket expression like "[!/]" is only one of the choices.
+ */
+static svn_boolean_t
+requires_slash(const char *pattern)
+{
+  const char *p;
+
+  for (p = pattern; *p; ++p)
+    {
+      if (*p == '/')
+        return TRUE;
+
+      if (*p == '\\' && p[1])
+        {
+          /* An escaped '/' is still a literal '/'. */
+          ++p;
+          if (*p == '/')
+            return TRUE;
+        }
+      else if (*p == '[')
+        {
+          /* Skip the bracket expression, if it is complete.  A ']' right
+             after the opening bracket or its negation is literal. */
+          const char *q = p + 1;
+
+          if (*q == '!' || *q == '^')
+            ++q;
+          if (*q == ']')
+            ++q;
+          while (*q && *q != ']')
+            ++q;
+
+          if (*q)
+            p = q;
+        }
+    }
+
+  return FALSE;
+}
+
+/* Return the sub-set of PATTERNS that may match a directory entry name,
+ * allocated in RESULT_POOL.  Because we match single path segments only,
+ * patterns that require a literal '/' can never match.  If all patterns
+ * are of that kind, set *NO_MATCHES and return PATTERNS unchanged.
+ */
+static apr_array_header_t *
+usable_patterns(svn_boolean_t *no_matches,
+                apr_array_header_t *patterns,
+                apr_pool_t *result_pool)
+{
+  apr_array_header_t *usable;
+  int i;
+
+  *no_matches = FALSE;
+  if (!patterns->nelts)
+    return patterns;
+
+  usable = apr_array_make(result_pool, patterns->nelts,
+                          sizeof(const char *));
+  for (i = 0; i < patterns->nelts; ++i)
+    {
+      const char *pattern = APR_ARRAY_IDX(patterns, i, const char *);
+      if (!requires_slash(pattern))
+        APR_ARRAY_PUSH(usable, const char *) = pattern;
+    }
+
+  /* An empty list would match everything. */
+  if (!usable->nelts)
+    {
+      *no_matches = TRUE;
+      return patterns;
+    }
+
+  return usable;
+}
+
 /* Utility to prevent code duplication.
  *
  * Construct a svn_dirent_t for PATH of type KIND under ROOT and, if
- * PATH_INFO_ONLY is not set, fill it.  Call RECEIVER with the result
- * and RECEIVER_BATON.
+ * PATH_INFO_ONLY is not set, fill it.  If DETAILS is not NULL, it has
+ * been filled already and is being used instead.  Call RECEIVER with the
+ * result and RECEIVER_BATON.
  *
  * Use SCRATCH_POOL for temporary allocations.
  */
@@ -123,6 +205,7 @@ report_dirent(svn_fs_root_t *root,
               const char *path,
               svn_node_kind_t kind,
               svn_boolean_t path_info_only,
+              const svn_dirent_t *details,
               svn_repos_dirent_receiver_t receiver,
               void *receiver_baton,
               apr_pool_t *scratch_pool)
@@ -130,9 +213,16 @@ report_dirent(svn_fs_root_t *root,
   svn_dirent_t dirent = { 0 };
 
   /* Fetch the details to report - if required. */
-  dirent.kind = kind;
-  if (!path_info_only)
-    SVN_ERR(fill_dirent(&dirent, root, path, scratch_pool));
+  if (details)
+    {
+      dirent = *details;
+    }
+  else
+    {
+      dirent.kind = kind;
+      if (!path_info_only)
+        SVN_ERR(fill_dirent(&dirent, root, path, scratch_pool));
+    }
 
   /* Report the entry. */
   SVN_ERR(receiver(path, &dirent, receiver_baton, scratch_pool));
@@ -148,46 +238,34 @@ typedef struct filtered_dirent_t
 
   /* DIRENT passed the filter. */
   svn_boolean_t is_match;
-} filtered_dirent_t;
-
-/* Implement a standard sort function for filtered_dirent_t *, sorting them
- * by entry name. */
-static int
-compare_filtered_dirent(const void *lhs,
-                        const void *rhs)
-{
-  const filtered_dirent_t *lhs_dirent = (const filtered_dirent_t *)lhs;
-  const filtered_dirent_t *rhs_dirent = (const filtered_dirent_t *)rhs;
 
-  return strcmp(lhs_dirent->dirent->name, rhs_dirent->dirent->name);
-}
+  /* Details to report for a matching DIRENT, if they have been fetched
+   * in advance.  NULL otherwise. */
+  svn_dirent_t *details;
+} filtered_dirent_t;
 
-/* Core of svn_repos_list with the same parameter list.
+/* Set *SORTED to the entries of directory PATH under ROOT that pass the
+ * DEPTH and PATTERNS filters, as filtered_dirent_t sorted by name.  If
+ * FETCH_DETAILS is set, fill in the details of all matching entries.
  *
- * However, DEPTH is not svn_depth_empty and PATH has already been reported.
- * Therefore, we can call this recursively.
+ * Allocate the result in RESULT_POOL and use SCRATCH_POOL for temporary
+ * allocations.
  */
 static svn_error_t *
-do_list(svn_fs_root_t *root,
-        const char *path,
-        apr_array_header_t *patterns,
-        svn_depth_t depth,
-        svn_boolean_t path_info_only,
-        svn_repos_authz_func_t authz_read_func,
-        void *authz_read_baton,
-        svn_repos_dirent_receiver_t receiver,
-        void *receiver_baton,
-        svn_cancel_func_t cancel_func,
-        void *cancel_baton,
-        apr_pool_t *scratch_pool)
+read_entries(apr_array_header_t **sorted,
+             svn_fs_root_t *root,
+             const char *path,
+             apr_array_header_t *patterns,
+             svn_depth_t depth,
+             svn_boolean_t fetch_details,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
 {
-  apr_hash_t *entries;
-  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
-  apr_hash_index_t *hi;
-  apr_array_header_t *sorted;
+  apr_array_header_t *entries;
+  apr_pool_t *iterpool;
   int i;
 
-  /* Fetch all directory entries, filter and sort them.
+  /* Fetch all directory entries in sorted order and filter them.
    *
    * Performance trade-off:
    * Constructing a full path vs. faster sort due to authz filtering.
@@ -195,15 +273,15 @@ do_list(svn_fs_root_t *root,
    * the full path required for authz is somewhat expensive and we don't
    * want to do this twice while authz will rarely filter paths out.
    */
-  SVN_ERR(svn_fs_dir_entries(&entries, root, path, scratch_pool));
-  sorted = apr_array_make(scratch_pool, apr_hash_count(entries),
-                          sizeof(filtered_dirent_t));
-  for (hi = apr_hash_first(scratch_pool, entries); hi; hi = apr_hash_next(hi))
+  SVN_ERR(svn_fs_dir_entries_sorted(&entries, root, path, result_pool,
+                                    scratch_pool));
+  *sorted = apr_array_make(result_pool, entries->nelts,
+                           sizeof(filtered_dirent_t));
+  for (i = 0; i < entries->nelts; ++i)
     {
-      filtered_dirent_t filtered;
-      svn_pool_clear(iterpool);
+      filtered_dirent_t filtered = { 0 };
 
-      filtered.dirent = apr_hash_this_val(hi);
+      filtered.dirent = APR_ARRAY_IDX(entries, i, svn_fs_dirent_t *);
 
       /* Skip directories if we want to report files only. */
       if (filtered.dirent->kind == svn_node_dir && depth == svn_depth_files)
@@ -214,26 +292,594 @@ do_list(svn_fs_root_t *root,
       if (!filtered.is_match && filtered.dirent->kind == svn_node_file)
         continue;
 
-      APR_ARRAY_PUSH(sorted, filtered_dirent_t) = filtered;
+      APR_ARRAY_PUSH(*sorted, filtered_dirent_t) = filtered;
     }
 
-  svn_sort__array(sorted, compare_filtered_dirent);
+  if (!fetch_details)
+    return SVN_NO_ERROR;
 
-  /* Iterate over all remaining directory entries and report them.
-   * Recurse into sub-directories if requested. */
-  for (i = 0; i < sorted->nelts; ++i)
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < (*sorted)->nelts; ++i)
     {
-      const char *sub_path;
-      filtered_dirent_t *filtered;
-      svn_fs_dirent_t *dirent;
+      filtered_dirent_t *filtered = &APR_ARRAY_IDX(*sorted, i,
+                                                   filtered_dirent_t);
+      if (!filtered->is_match)
+        continue;
 
       svn_pool_clear(iterpool);
+      filtered->details = svn_dirent_create(result_pool);
+      filtered->details->kind = filtered->dirent->kind;
+      SVN_ERR(fill_dirent(filtered->details, root,
+                          svn_dirent_join(path, filtered->dirent->name,
+                                          iterpool),
+                          result_pool));
+    }
+  svn_pool_destroy(iterpool);
 
-      filtered = &APR_ARRAY_IDX(sorted, i, filtered_dirent_t);
-      dirent = filtered->dirent;
+  return SVN_NO_ERROR;
+}
+
+/* The state of a parallel listing.  Only defined with thread support. */
+typedef struct parallel_list_t parallel_list_t;
+
+/* A directory to be read by a worker of a parallel_list_t. */
+typedef struct list_job_t list_job_t;
+
+#if APR_HAS_THREADS
+
+/* Maximum number of directories that workers read ahead of the caller,
+ * per worker thread. */
+#define LIST_READ_AHEAD 64
+
+/* Lifecycle of a list_job_t. */
+typedef enum list_job_state_t
+{
+  /* Waiting for a worker. */
+  list_job_queued,
+
+  /* Being read by a worker. */
+  list_job_running,
+
+  /* Read by a worker and waiting to be picked up by the caller. */
+  list_job_done
+} list_job_state_t;
+
+struct list_job_t
+{
+  /* The directory to read. */
+  const char *path;
+
+  /* Filtered and sorted entries as returned by read_entries.  Only valid
+   * in state list_job_done. */
+  apr_array_header_t *entries;
+
+  /* Error returned by read_entries. */
+  svn_error_t *err;
+
+  /* Current state.  Protected by the parallel_list_t mutex. */
+  list_job_state_t state;
+
+  /* Neighbours in the list of completed jobs. */
+  list_job_t *prev;
+  list_job_t *next;
+
+  /* Private pool containing this job. */
+  apr_pool_t *pool;
+};
+
+struct parallel_list_t
+{
+  /* Protects all mutable members below.  Used with COND. */
+  svn_mutex__t *mutex;
+
+  /* Signaled whenever a job gets queued or completed, the caller picked
+   * up a job or the workers shall terminate. */
+  apr_thread_cond_t *cond;
+
+  /* Stack of list_job_t * in state list_job_queued.  Directories are
+   * being pushed in reverse order of their reporting, so that the top
+   * is the directory that we will need next. */
+  apr_array_header_t *queue;
+
+  /* List of jobs in state list_job_done, oldest first. */
+  list_job_t *first_done;
+  list_job_t *last_done;
+  int done_count;
+
+  /* Don't start new jobs while DONE_COUNT is at this limit. */
+  int max_done;
+
+  /* Number of jobs in state list_job_running. */
+  int running;
+
+  /* Once set, the workers shall terminate. */
+  svn_boolean_t shutdown;
+
+  /* Read-only parameters of the listing. */
+  const char *fs_path;
+  apr_hash_t *fs_config;
+  svn_revnum_t revision;
+  apr_array_header_t *patterns;
+  svn_depth_t depth;
+  svn_boolean_t path_info_only;
+
+  /* Thread-safe root pool that all job pools are created in. */
+  apr_pool_t *jobs_pool;
+};
+
+/* Per-thread data of a list worker. */
+typedef struct list_worker_t
+{
+  /* The shared state. */
+  parallel_list_t *lister;
+
+  /* Root pool used only by this thread. */
+  apr_pool_t *pool;
+
+  /* The thread itself or NULL if it could not be started. */
+  apr_thread_t *thread;
+} list_worker_t;
+
+/* Implements svn_fs_warning_callback_t.  The filesystems of the workers
+   only report cache failures, which don't affect the listing. */
+static void
+list_worker_warning_func(void *baton,
+                         svn_error_t *err)
+{
+}
+
+/* Append JOB to the list of completed jobs in LISTER.
+ * The caller must hold the lock. */
+static void
+append_done(parallel_list_t *lister,
+            list_job_t *job)
+{
+  job->state = list_job_done;
+  job->prev = lister->last_done;
+  job->next = NULL;
+  if (lister->last_done)
+    lister->last_done->next = job;
+  else
+    lister->first_done = job;
+
+  lister->last_done = job;
+  ++lister->done_count;
+}
+
+/* Remove JOB from the list of completed jobs in LISTER.
+ * The caller must hold the lock. */
+static void
+remove_done(parallel_list_t *lister,
+            list_job_t *job)
+{
+  if (job->prev)
+    job->prev->next = job->next;
+  else
+    lister->first_done = job->next;
+
+  if (job->next)
+    job->next->prev = job->prev;
+  else
+    lister->last_done = job->prev;
+
+  job->prev = NULL;
+  job->next = NULL;
+  --lister->done_count;
+}
+
+/* Remove JOB, which is in state list_job_queued, from the queue in
+ * LISTER.  The caller must hold the lock. */
+static void
+remove_queued(parallel_list_t *lister,
+              list_job_t *job)
+{
+  int i;
+
+  /* We usually need the job at the top of the stack. */
+  for (i = lister->queue->nelts - 1; i >= 0; --i)
+    if (APR_ARRAY_IDX(lister->queue, i, list_job_t *) == job)
+      {
+        svn_sort__array_delete(lister->queue, i, 1);
+        break;
+      }
+}
+
+/* Thread function.  Read directories for the list_worker_t given by DATA
+   until the listing terminates. */
+static void * APR_THREAD_FUNC
+list_thread(apr_thread_t *tid,
+            void *data)
+{
+  list_worker_t *worker = data;
+  parallel_list_t *lister = worker->lister;
+  apr_pool_t *iterpool = svn_pool_create(worker->pool);
+  svn_fs_t *fs;
+  svn_fs_root_t *root = NULL;
+  svn_error_t *err;
+
+  /* FS objects must not be shared between threads.  If we can't open our
+     own, leave the work to the others or to the caller. */
+  err = svn_fs_open2(&fs, lister->fs_path, lister->fs_config, worker->pool,
+                     iterpool);
+  if (!err)
+    {
+      svn_fs_set_warning_func(fs, list_worker_warning_func, NULL);
+      err = svn_fs_revision_root(&root, fs, lister->revision, worker->pool);
+    }
+
+  while (!err)
+    {
+      list_job_t *job = NULL;
+
+      svn_pool_clear(iterpool);
+
+      err = svn_mutex__lock(lister->mutex);
+      if (err)
+        break;
+
+      while (   !lister->shutdown
+             && (   lister->queue->nelts == 0
+                 || lister->done_count >= lister->max_done))
+        {
+          apr_status_t status
+            = apr_thread_cond_wait(lister->cond,
+                                   svn_mutex__get(lister->mutex));
+          if (status)
+            {
+              err = svn_error_wrap_apr(status,
+                                       _("Can't wait for condition variable"));
+              break;
+            }
+        }
+
+      if (!err && !lister->shutdown)
+        {
+          job = *(list_job_t **)apr_array_pop(lister->queue);
+          job->state = list_job_running;
+          ++lister->running;
+        }
+
+      err = svn_mutex__unlock(lister->mutex, err);
+      if (!job)
+        break;
+
+      job->err = read_entries(&job->entries, root, job->path,
+                              lister->patterns, lister->depth,
+                              !lister->path_info_only, job->pool, iterpool);
+
+      /* Once claimed, the caller may wait for this job.  So, hand it over
+         even if we could not get the lock. */
+      err = svn_error_compose_create(err, svn_mutex__lock(lister->mutex));
+      append_done(lister, job);
+      --lister->running;
+      apr_thread_cond_broadcast(lister->cond);
+      err = svn_mutex__unlock(lister->mutex, err);
+    }
+
+  svn_error_clear(err);
+  svn_pool_destroy(iterpool);
+
+  return NULL;
+}
+
+/* Queue the directory PATH to be read by the workers of LISTER and
+ * return the new job in *JOB. */
+static svn_error_t *
+queue_job(list_job_t **job,
+          parallel_list_t *lister,
+          const char *path)
+{
+  apr_pool_t *job_pool = svn_pool_create(lister->jobs_pool);
+
+  *job = apr_pcalloc(job_pool, sizeof(**job));
+  (*job)->path = apr_pstrdup(job_pool, path);
+  (*job)->state = list_job_queued;
+  (*job)->pool = job_pool;
+
+  SVN_ERR(svn_mutex__lock(lister->mutex));
+  APR_ARRAY_PUSH(lister->queue, list_job_t *) = *job;
+  apr_thread_cond_signal(lister->cond);
+
+  return svn_error_trace(svn_mutex__unlock(lister->mutex, SVN_NO_ERROR));
+}
+
+/* Wait for JOB in LISTER to complete, unless it has not been picked up
+ * by a worker yet.  In the latter case, remove it from the queue and set
+ * *CLAIMED.  Otherwise, remove JOB from the list of completed jobs and
+ * clear *CLAIMED.
+ */
+static svn_error_t *
+claim_or_wait(svn_boolean_t *claimed,
+              parallel_list_t *lister,
+              list_job_t *job)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+
+  SVN_ERR(svn_mutex__lock(lister->mutex));
+
+  while (job->state == list_job_running)
+    {
+      apr_status_t status
+        = apr_thread_cond_wait(lister->cond,
+                               svn_mutex__get(lister->mutex));
+      if (status)
+        {
+          err = svn_error_wrap_apr(status,
+                                   _("Can't wait for condition variable"));
+          break;
+        }
+    }
+
+  *claimed = FALSE;
+  if (!err)
+    {
+      if (job->state == list_job_queued)
+        {
+          remove_queued(lister, job);
+          *claimed = TRUE;
+        }
+      else
+        {
+          remove_done(lister, job);
+
+          /* There is room for the workers to read ahead again. */
+          apr_thread_cond_broadcast(lister->cond);
+        }
+    }
+
+  return svn_error_trace(svn_mutex__unlock(lister->mutex, err));
+}
+
+/* Set *JOB to a job from LISTER that the caller shall process next.
+ * Prefer completed jobs, then queued ones and wait for a worker to
+ * complete a job if neither exists.  Set *CLAIMED as for claim_or_wait.
+ * Set *JOB to NULL if there are no jobs left.
+ */
+static svn_error_t *
+next_job(list_job_t **job,
+         svn_boolean_t *claimed,
+         parallel_list_t *lister)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+
+  SVN_ERR(svn_mutex__lock(lister->mutex));
+
+  while (   !lister->first_done
+         && lister->queue->nelts == 0
+         && lister->running > 0)
+    {
+      apr_status_t status
+        = apr_thread_cond_wait(lister->cond,
+                               svn_mutex__get(lister->mutex));
+      if (status)
+        {
+          err = svn_error_wrap_apr(status,
+                                   _("Can't wait for condition variable"));
+          break;
+        }
+    }
+
+  *job = NULL;
+  *claimed = FALSE;
+  if (!err)
+    {
+      if (lister->first_done)
+        {
+          *job = lister->first_done;
+          remove_done(lister, *job);
+          apr_thread_cond_broadcast(lister->cond);
+        }
+      else if (lister->queue->nelts)
+        {
+          *job = *(list_job_t **)apr_array_pop(lister->queue);
+          *claimed = TRUE;
+        }
+    }
+
+  return svn_error_trace(svn_mutex__unlock(lister->mutex, err));
+}
+
+/* Make JOB's listing in LISTER available in *SORTED: either the result
+ * of a worker or, if the caller claimed it, by reading it from ROOT.
+ * The result will be allocated in the JOB's pool.  Use SCRATCH_POOL for
+ * temporary allocations.
+ */
+static svn_error_t *
+job_entries(apr_array_header_t **sorted,
+            parallel_list_t *lister,
+            list_job_t *job,
+            svn_boolean_t claimed,
+            svn_fs_root_t *root,
+            apr_pool_t *scratch_pool)
+{
+  svn_error_t *err;
+
+  /* Details will be fetched after the authz check. */
+  if (claimed)
+    return svn_error_trace(read_entries(sorted, root, job->path,
+                                        lister->patterns, lister->depth,
+                                        FALSE, job->pool, scratch_pool));
+
+  err = job->err;
+  job->err = SVN_NO_ERROR;
+  *sorted = job->entries;
+
+  return svn_error_trace(err);
+}
+
+/* Create a parallel listing with JOBS worker threads reading directories
+ * below ROOT according to PATTERNS, DEPTH and PATH_INFO_ONLY.  Return it
+ * in *LISTER and the workers in *WORKERS.  Set *LISTER to NULL if ROOT
+ * can't be opened by the workers.  Allocate everything in POOL.
+ */
+static svn_error_t *
+start_parallel_list(parallel_list_t **lister,
+                    list_worker_t **workers,
+                    int jobs,
+                    svn_fs_root_t *root,
+                    apr_array_header_t *patterns,
+                    svn_depth_t depth,
+                    svn_boolean_t path_info_only,
+                    apr_pool_t *pool)
+{
+  svn_fs_t *fs = svn_fs_root_fs(root);
+  parallel_list_t *result;
+  apr_status_t status;
+  int i;
+
+  *lister = NULL;
+
+  /* Transaction roots are not worth the trouble. */
+  if (!svn_fs_is_revision_root(root))
+    return SVN_NO_ERROR;
+
+  result = apr_pcalloc(pool, sizeof(*result));
+  SVN_ERR(svn_mutex__init(&result->mutex, TRUE, pool));
+  status = apr_thread_cond_create(&result->cond, pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create condition variable"));
+
+  result->queue = apr_array_make(pool, 16, sizeof(list_job_t *));
+  result->max_done = jobs * LIST_READ_AHEAD;
+  result->fs_path = svn_fs_path(fs, pool);
+  result->fs_config = svn_fs_config(fs, pool);
+  result->revision = svn_fs_revision_root_revision(root);
+  result->patterns = patterns;
+  result->depth = depth;
+  result->path_info_only = path_info_only;
+  result->jobs_pool
+    = apr_allocator_owner_get(svn_pool_create_allocator(TRUE));
+
+  *workers = apr_pcalloc(pool, jobs * sizeof(**workers));
+  for (i = 0; i < jobs; i++)
+    {
+      list_worker_t *worker = &(*workers)[i];
+
+      worker->lister = result;
+      worker->pool
+        = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+
+      status = apr_thread_create(&worker->thread, NULL, list_thread,
+                                 worker, worker->pool);
+      if (status)
+        worker->thread = NULL;
+    }
+
+  *lister = result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Terminate the JOBS WORKERS of LISTER and release all its resources.
+ * Compose any error with ERR and return it. */
+static svn_error_t *
+stop_parallel_list(parallel_list_t *lister,
+                   list_worker_t *workers,
+                   int jobs,
+                   svn_error_t *err)
+{
+  list_job_t *job;
+  apr_status_t status;
+  int i;
+
+  err = svn_error_compose_create(err, svn_mutex__lock(lister->mutex));
+  lister->shutdown = TRUE;
+  apr_thread_cond_broadcast(lister->cond);
+  err = svn_error_compose_create(err, svn_mutex__unlock(lister->mutex,
+                                                        SVN_NO_ERROR));
+
+  for (i = 0; i < jobs; i++)
+    {
+      if (workers[i].thread)
+        {
+          apr_status_t retval;
+
+          status = apr_thread_join(&retval, workers[i].thread);
+          if (status)
+            err = svn_error_compose_create(
+                    err, svn_error_wrap_apr(status,
+                                            _("Can't join list thread")));
+        }
+
+      svn_pool_destroy(workers[i].pool);
+    }
+
+  /* Discard whatever the caller did not pick up. */
+  for (job = lister->first_done; job; job = job->next)
+    svn_error_clear(job->err);
+
+  svn_pool_destroy(lister->jobs_pool);
+
+  return svn_error_trace(err);
+}
+
+#endif /* APR_HAS_THREADS */
+
+/* Fetch the filtered and sorted entries of directory PATH under ROOT as
+ * for read_entries and return them in *SORTED.  If JOB is not NULL, get
+ * them through LISTER.
+ *
+ * Allocate the result in RESULT_POOL, unless it comes from JOB.  Use
+ * SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+get_entries(apr_array_header_t **sorted,
+            parallel_list_t *lister,
+            list_job_t *job,
+            svn_fs_root_t *root,
+            const char *path,
+            apr_array_header_t *patterns,
+            svn_depth_t depth,
+            apr_pool_t *result_pool,
+            apr_pool_t *scratch_pool)
+{
+#if APR_HAS_THREADS
+  if (job)
+    {
+      svn_boolean_t claimed;
+
+      SVN_ERR(claim_or_wait(&claimed, lister, job));
+      return svn_error_trace(job_entries(sorted, lister, job, claimed, root,
+                                         scratch_pool));
+    }
+#endif
+
+  /* Details will be fetched after the authz check. */
+  return svn_error_trace(read_entries(sorted, root, path, patterns, depth,
+                                      FALSE, result_pool, scratch_pool));
+}
+
+/* Check authz for the entries in SORTED of directory PATH and set the
+ * respective elements in the returned array of const char * to their
+ * full paths.  The elements for inaccessible entries will be NULL.
+ * Parameters are as for svn_repos_list.  Allocate the result in
+ * RESULT_POOL and use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+get_accessible_paths(const char ***sub_paths,
+                     svn_fs_root_t *root,
+                     const char *path,
+                     apr_array_header_t *sorted,
+                     svn_repos_authz_func_t authz_read_func,
+                     void *authz_read_baton,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  *sub_paths = apr_pcalloc(result_pool,
+                           sorted->nelts * sizeof(**sub_paths));
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      svn_fs_dirent_t *dirent
+        = APR_ARRAY_IDX(sorted, i, filtered_dirent_t).dirent;
+      const char *sub_path = svn_dirent_join(path, dirent->name,
+                                             result_pool);
+
+      svn_pool_clear(iterpool);
 
       /* Skip paths that we don't have access to? */
-      sub_path = svn_dirent_join(path, dirent->name, iterpool);
       if (authz_read_func)
         {
           svn_boolean_t has_access;
@@ -243,9 +889,85 @@ do_list(svn_fs_root_t *root,
             continue;
         }
 
+      (*sub_paths)[i] = sub_path;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Core of svn_repos_list with the same parameter list.
+ *
+ * However, DEPTH is not svn_depth_empty and PATH has already been reported.
+ * Therefore, we can call this recursively.
+ *
+ * If LISTER is not NULL, JOB is the job that reads PATH.  Sub-directories
+ * will then be read ahead through LISTER.
+ */
+static svn_error_t *
+do_list(parallel_list_t *lister,
+        list_job_t *job,
+        svn_fs_root_t *root,
+        const char *path,
+        apr_array_header_t *patterns,
+        svn_depth_t depth,
+        svn_boolean_t path_info_only,
+        svn_repos_authz_func_t authz_read_func,
+        void *authz_read_baton,
+        svn_repos_dirent_receiver_t receiver,
+        void *receiver_baton,
+        svn_cancel_func_t cancel_func,
+        void *cancel_baton,
+        apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_array_header_t *sorted;
+  const char **sub_paths;
+  list_job_t **sub_jobs = NULL;
+  int i;
+
+  SVN_ERR(get_entries(&sorted, lister, job, root, path, patterns, depth,
+                      scratch_pool, iterpool));
+  SVN_ERR(get_accessible_paths(&sub_paths, root, path, sorted,
+                               authz_read_func, authz_read_baton,
+                               scratch_pool, iterpool));
+
+#if APR_HAS_THREADS
+  /* Let the workers read the sub-directories that we will recurse into.
+   * Queue them in reverse order such that the first one ends up on top. */
+  if (lister && depth == svn_depth_infinity)
+    {
+      sub_jobs = apr_pcalloc(scratch_pool,
+                             sorted->nelts * sizeof(*sub_jobs));
+      for (i = sorted->nelts - 1; i >= 0; --i)
+        if (   sub_paths[i]
+            && APR_ARRAY_IDX(sorted, i, filtered_dirent_t).dirent->kind
+                 == svn_node_dir)
+          SVN_ERR(queue_job(&sub_jobs[i], lister, sub_paths[i]));
+    }
+#endif
+
+  /* Iterate over all remaining directory entries and report them.
+   * Recurse into sub-directories if requested. */
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      filtered_dirent_t *filtered;
+      svn_fs_dirent_t *dirent;
+
+      svn_pool_clear(iterpool);
+
+      /* Skip paths that we don't have access to. */
+      if (!sub_paths[i])
+        continue;
+
+      filtered = &APR_ARRAY_IDX(sorted, i, filtered_dirent_t);
+      dirent = filtered->dirent;
+
       /* Report entry, if it passed the filter. */
       if (filtered->is_match)
-        SVN_ERR(report_dirent(root, sub_path, dirent->kind, path_info_only,
+        SVN_ERR(report_dirent(root, sub_paths[i], dirent->kind,
+                              path_info_only, filtered->details,
                               receiver, receiver_baton, iterpool));
 
       /* Check for cancellation before recursing down.  This should be
@@ -255,7 +977,8 @@ do_list(svn_fs_root_t *root,
 
       /* Recurse on directories. */
       if (depth == svn_depth_infinity && dirent->kind == svn_node_dir)
-        SVN_ERR(do_list(root, sub_path, patterns, svn_depth_infinity,
+        SVN_ERR(do_list(lister, sub_jobs ? sub_jobs[i] : NULL, root,
+                        sub_paths[i], patterns, svn_depth_infinity,
                         path_info_only, authz_read_func, authz_read_baton,
                         receiver, receiver_baton, cancel_func,
                         cancel_baton, iterpool));
@@ -263,15 +986,101 @@ do_list(svn_fs_root_t *root,
 
   svn_pool_destroy(iterpool);
 
+#if APR_HAS_THREADS
+  /* We are done with the entries. */
+  if (job)
+    svn_pool_destroy(job->pool);
+#endif
+
   return SVN_NO_ERROR;
 }
 
+#if APR_HAS_THREADS
+
+/* Like do_list but report directories in whatever order LISTER reads
+ * them, starting with the already queued JOB for PATH.  Entries within
+ * a directory are still being reported in order and every directory is
+ * being reported before its contents.
+ */
+static svn_error_t *
+do_list_unordered(parallel_list_t *lister,
+                  list_job_t *job,
+                  svn_fs_root_t *root,
+                  svn_boolean_t path_info_only,
+                  svn_repos_authz_func_t authz_read_func,
+                  void *authz_read_baton,
+                  svn_repos_dirent_receiver_t receiver,
+                  void *receiver_baton,
+                  svn_cancel_func_t cancel_func,
+                  void *cancel_baton,
+                  apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_pool_t *entrypool = svn_pool_create(scratch_pool);
+  svn_boolean_t claimed;
+
+  SVN_ERR(claim_or_wait(&claimed, lister, job));
+  while (job)
+    {
+      apr_array_header_t *sorted;
+      const char **sub_paths;
+      int i;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(job_entries(&sorted, lister, job, claimed, root, iterpool));
+      SVN_ERR(get_accessible_paths(&sub_paths, root, job->path, sorted,
+                                   authz_read_func, authz_read_baton,
+                                   iterpool, iterpool));
+
+      for (i = 0; i < sorted->nelts; ++i)
+        {
+          filtered_dirent_t *filtered;
+          svn_fs_dirent_t *dirent;
+
+          svn_pool_clear(entrypool);
+
+          if (!sub_paths[i])
+            continue;
+
+          filtered = &APR_ARRAY_IDX(sorted, i, filtered_dirent_t);
+          dirent = filtered->dirent;
+
+          if (filtered->is_match)
+            SVN_ERR(report_dirent(root, sub_paths[i], dirent->kind,
+                                  path_info_only, filtered->details,
+                                  receiver, receiver_baton, entrypool));
+
+          if (cancel_func)
+            SVN_ERR(cancel_func(cancel_baton));
+
+          if (dirent->kind == svn_node_dir)
+            {
+              list_job_t *sub_job;
+              SVN_ERR(queue_job(&sub_job, lister, sub_paths[i]));
+            }
+        }
+
+      svn_pool_destroy(job->pool);
+      SVN_ERR(next_job(&job, &claimed, lister));
+    }
+
+  svn_pool_destroy(entrypool);
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#endif /* APR_HAS_THREADS */
+
 svn_error_t *
 svn_repos_list(svn_fs_root_t *root,
                const char *path,
                apr_array_header_t *patterns,
                svn_depth_t depth,
                svn_boolean_t path_info_only,
+               int jobs,
+               svn_boolean_t unordered,
                svn_repos_authz_func_t authz_read_func,
                void *authz_read_baton,
                svn_repos_dirent_receiver_t receiver,
@@ -282,6 +1091,7 @@ svn_repos_list(svn_fs_root_t *root,
 {
   /* Parameter check. */
   svn_node_kind_t kind;
+  svn_boolean_t no_matches;
   if (depth < svn_depth_empty)
     return svn_error_createf(SVN_ERR_REPOS_BAD_ARGS, NULL,
                              "Invalid depth '%d' in svn_repos_list", depth);
@@ -314,12 +1124,49 @@ svn_repos_list(svn_fs_root_t *root,
 
   /* Actually report PATH, if it passes the filters. */
   if (matches_any(svn_dirent_dirname(path, scratch_pool), patterns))
-    SVN_ERR(report_dirent(root, path, kind, path_info_only,
+    SVN_ERR(report_dirent(root, path, kind, path_info_only, NULL,
                           receiver, receiver_baton, scratch_pool));
 
+  /* Nothing below PATH can match PATTERNS? */
+  patterns = usable_patterns(&no_matches, patterns, scratch_pool);
+  if (no_matches)
+    return SVN_NO_ERROR;
+
+#if APR_HAS_THREADS
+  /* Read sub-directories in parallel if requested. */
+  if (jobs > 1 && depth == svn_depth_infinity)
+    {
+      parallel_list_t *lister;
+      list_worker_t *workers;
+
+      SVN_ERR(start_parallel_list(&lister, &workers, jobs, root, patterns,
+                                  depth, path_info_only, scratch_pool));
+      if (lister)
+        {
+          list_job_t *job;
+          svn_error_t *err = queue_job(&job, lister, path);
+
+          if (!err && unordered)
+            err = do_list_unordered(lister, job, root, path_info_only,
+                                    authz_read_func, authz_read_baton,
+                                    receiver, receiver_baton,
+                                    cancel_func, cancel_baton,
+                                    scratch_pool);
+          else if (!err)
+            err = do_list(lister, job, root, path, patterns, depth,
+                          path_info_only, authz_read_func,
+                          authz_read_baton, receiver, receiver_baton,
+                          cancel_func, cancel_baton, scratch_pool);
+
+          return svn_error_trace(stop_parallel_list(lister, workers, jobs,
+                                                    err));
+        }
+    }
+#endif
+
   /* Report directory contents if requested. */
   if (depth > svn_depth_empty)
-    SVN_ERR(do_list(root, path, patterns, depth,
+    SVN_ERR(do_list(NULL, NULL, root, path, patterns, depth,
                     path_info_only, authz_read_func, authz_read_baton,
                     receiver, receiver_baton, cancel_func, cancel_baton,
                     scratch_pool));
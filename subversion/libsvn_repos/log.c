@@ -41,11 +41,17 @@
 #include "private/svn_fspath.h"
 #include "private/svn_fs_private.h"
 #include "private/svn_mergeinfo_private.h"
+#include "private/svn_probes.h"
+#include "private/svn_repos_private.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_string_private.h"
 
 
+/* Number of changed paths whose readability detect_changed() checks
+   with a single authz callback invocation. */
+#define LOG_AUTHZ_BATCH_SIZE 256
+
 /* This is a mere convenience struct such that we don't need to pass that
    many parameters around individually. */
 typedef struct log_callbacks_t
@@ -170,6 +176,112 @@ svn_repos_check_revision_access(svn_repos_revision_access_level_t *access_level,
 }
 
 
+/* Complete the information in the readable CHANGE under ROOT in FS and
+ * report it to CALLBACKS->PATH_CHANGE_RECEIVER, if not NULL.  Set
+ * *FOUND_UNREADABLE if its copy source is not readable according to
+ * CALLBACKS->AUTHZ_READ_FUNC; it will be omitted from the report then.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+report_change(svn_boolean_t *found_unreadable,
+              svn_fs_path_change3_t *change,
+              svn_fs_root_t *root,
+              svn_fs_t *fs,
+              const log_callbacks_t *callbacks,
+              apr_pool_t *scratch_pool)
+{
+  const char *path = change->path.data;
+
+  /* Pre-1.6 revision files don't store the change path kind, so fetch
+     it manually. */
+  if (change->node_kind == svn_node_unknown)
+    {
+      svn_fs_root_t *check_root = root;
+      const char *check_path = path;
+
+      /* Deleted items don't exist so check earlier revision.  We
+         know the parent must exist and could be a copy */
+      if (change->change_kind == svn_fs_path_change_delete)
+        {
+          svn_fs_history_t *history;
+          svn_revnum_t prev_rev;
+          const char *parent_path, *name;
+
+          svn_fspath__split(&parent_path, &name, path, scratch_pool);
+
+          SVN_ERR(svn_fs_node_history2(&history, root, parent_path,
+                                       scratch_pool, scratch_pool));
+
+          /* Two calls because the first call returns the original
+             revision as the deleted child means it is 'interesting' */
+          SVN_ERR(svn_fs_history_prev2(&history, history, TRUE, scratch_pool,
+                                       scratch_pool));
+          SVN_ERR(svn_fs_history_prev2(&history, history, TRUE, scratch_pool,
+                                       scratch_pool));
+
+          SVN_ERR(svn_fs_history_location(&parent_path, &prev_rev,
+                                          history, scratch_pool));
+          SVN_ERR(svn_fs_revision_root(&check_root, fs, prev_rev,
+                                       scratch_pool));
+          check_path = svn_fspath__join(parent_path, name, scratch_pool);
+        }
+
+      SVN_ERR(svn_fs_check_path(&change->node_kind, check_root, check_path,
+                                scratch_pool));
+    }
+
+  if (   (change->change_kind == svn_fs_path_change_add)
+      || (change->change_kind == svn_fs_path_change_replace))
+    {
+      const char *copyfrom_path = change->copyfrom_path;
+      svn_revnum_t copyfrom_rev = change->copyfrom_rev;
+
+      /* the following is a potentially expensive operation since on FSFS
+         we will follow the DAG from ROOT to PATH and that requires
+         actually reading the directories along the way. */
+      if (!change->copyfrom_known)
+        {
+          SVN_ERR(svn_fs_copied_from(&copyfrom_rev, &copyfrom_path,
+                                    root, path, scratch_pool));
+          change->copyfrom_known = TRUE;
+        }
+
+      if (copyfrom_path && SVN_IS_VALID_REVNUM(copyfrom_rev))
+        {
+          svn_boolean_t readable = TRUE;
+
+          if (callbacks->authz_read_func)
+            {
+              svn_fs_root_t *copyfrom_root;
+
+              SVN_ERR(svn_fs_revision_root(&copyfrom_root, fs,
+                                           copyfrom_rev, scratch_pool));
+              SVN_ERR(callbacks->authz_read_func(&readable,
+                                                 copyfrom_root,
+                                                 copyfrom_path,
+                                                 callbacks->authz_read_baton,
+                                                 scratch_pool));
+              if (! readable)
+                *found_unreadable = TRUE;
+            }
+
+          if (readable)
+            {
+              change->copyfrom_path = copyfrom_path;
+              change->copyfrom_rev = copyfrom_rev;
+            }
+        }
+    }
+
+  if (callbacks->path_change_receiver)
+    SVN_ERR(callbacks->path_change_receiver(
+                                 callbacks->path_change_receiver_baton,
+                                 change,
+                                 scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Find all significant changes under ROOT and, if not NULL, report them
  * to the CALLBACKS->PATH_CHANGE_RECEIVER.  "Significant" means that the
  * text or properties of the node were changed, or that the node was added
@@ -203,6 +315,7 @@ detect_changed(svn_repos_revision_access_level_t *access_level,
   svn_fs_path_change_iterator_t *iterator;
   svn_fs_path_change3_t *change;
   apr_pool_t *iterpool;
+  apr_pool_t *batch_pool;
   svn_boolean_t found_readable = FALSE;
   svn_boolean_t found_unreadable = FALSE;
 
@@ -219,123 +332,65 @@ detect_changed(svn_repos_revision_access_level_t *access_level,
     }
 
   iterpool = svn_pool_create(scratch_pool);
+  batch_pool = svn_pool_create(scratch_pool);
   while (change)
     {
       /* NOTE:  Much of this loop is going to look quite similar to
          svn_repos_check_revision_access(), but we have to do more things
          here, so we'll live with the duplication. */
-      const char *path = change->path.data;
-      svn_pool_clear(iterpool);
-
-      /* Skip path if unreadable. */
-      if (callbacks->authz_read_func)
-        {
-          svn_boolean_t readable;
-          SVN_ERR(callbacks->authz_read_func(&readable, root, path,
-                                             callbacks->authz_read_baton,
-                                             iterpool));
-          if (! readable)
-            {
-              found_unreadable = TRUE;
-              SVN_ERR(svn_fs_path_change_get(&change, iterator));
-              continue;
-            }
-        }
+      apr_array_header_t *changes;
+      apr_array_header_t *paths;
+      svn_boolean_t *readable = NULL;
+      int i;
 
-      /* At least one changed-path was readable. */
-      found_readable = TRUE;
+      svn_pool_clear(batch_pool);
 
-      /* Pre-1.6 revision files don't store the change path kind, so fetch
-         it manually. */
-      if (change->node_kind == svn_node_unknown)
+      /* Collect the next batch of changes, such that the authz callback
+         may check their paths all at once. */
+      changes = apr_array_make(batch_pool, LOG_AUTHZ_BATCH_SIZE,
+                               sizeof(svn_fs_path_change3_t *));
+      paths = apr_array_make(batch_pool, LOG_AUTHZ_BATCH_SIZE,
+                             sizeof(const char *));
+      while (change && changes->nelts < LOG_AUTHZ_BATCH_SIZE)
         {
-          svn_fs_root_t *check_root = root;
-          const char *check_path = path;
+          change = svn_fs_path_change3_dup(change, batch_pool);
+          APR_ARRAY_PUSH(changes, svn_fs_path_change3_t *) = change;
+          APR_ARRAY_PUSH(paths, const char *) = change->path.data;
 
-          /* Deleted items don't exist so check earlier revision.  We
-             know the parent must exist and could be a copy */
-          if (change->change_kind == svn_fs_path_change_delete)
-            {
-              svn_fs_history_t *history;
-              svn_revnum_t prev_rev;
-              const char *parent_path, *name;
-
-              svn_fspath__split(&parent_path, &name, path, iterpool);
-
-              SVN_ERR(svn_fs_node_history2(&history, root, parent_path,
-                                           iterpool, iterpool));
-
-              /* Two calls because the first call returns the original
-                 revision as the deleted child means it is 'interesting' */
-              SVN_ERR(svn_fs_history_prev2(&history, history, TRUE, iterpool,
-                                           iterpool));
-              SVN_ERR(svn_fs_history_prev2(&history, history, TRUE, iterpool,
-                                           iterpool));
-
-              SVN_ERR(svn_fs_history_location(&parent_path, &prev_rev,
-                                              history, iterpool));
-              SVN_ERR(svn_fs_revision_root(&check_root, fs, prev_rev,
-                                           iterpool));
-              check_path = svn_fspath__join(parent_path, name, iterpool);
-            }
+          SVN_ERR(svn_fs_path_change_get(&change, iterator));
+        }
 
-          SVN_ERR(svn_fs_check_path(&change->node_kind, check_root, check_path,
-                                    iterpool));
+      if (callbacks->authz_read_func)
+        {
+          readable = apr_palloc(batch_pool, paths->nelts * sizeof(*readable));
+          SVN_ERR(svn_repos__authz_read_paths(readable, root, paths,
+                                              callbacks->authz_read_func,
+                                              callbacks->authz_read_baton,
+                                              batch_pool));
         }
 
-      if (   (change->change_kind == svn_fs_path_change_add)
-          || (change->change_kind == svn_fs_path_change_replace))
+      for (i = 0; i < changes->nelts; ++i)
         {
-          const char *copyfrom_path = change->copyfrom_path;
-          svn_revnum_t copyfrom_rev = change->copyfrom_rev;
+          svn_pool_clear(iterpool);
 
-          /* the following is a potentially expensive operation since on FSFS
-             we will follow the DAG from ROOT to PATH and that requires
-             actually reading the directories along the way. */
-          if (!change->copyfrom_known)
+          /* Skip path if unreadable. */
+          if (readable && !readable[i])
             {
-              SVN_ERR(svn_fs_copied_from(&copyfrom_rev, &copyfrom_path,
-                                        root, path, iterpool));
-              change->copyfrom_known = TRUE;
+              found_unreadable = TRUE;
+              continue;
             }
 
-          if (copyfrom_path && SVN_IS_VALID_REVNUM(copyfrom_rev))
-            {
-              svn_boolean_t readable = TRUE;
-
-              if (callbacks->authz_read_func)
-                {
-                  svn_fs_root_t *copyfrom_root;
-
-                  SVN_ERR(svn_fs_revision_root(&copyfrom_root, fs,
-                                               copyfrom_rev, iterpool));
-                  SVN_ERR(callbacks->authz_read_func(&readable,
-                                                     copyfrom_root,
-                                                     copyfrom_path,
-                                                     callbacks->authz_read_baton,
-                                                     iterpool));
-                  if (! readable)
-                    found_unreadable = TRUE;
-                }
+          /* At least one changed-path was readable. */
+          found_readable = TRUE;
 
-              if (readable)
-                {
-                  change->copyfrom_path = copyfrom_path;
-                  change->copyfrom_rev = copyfrom_rev;
-                }
-            }
+          SVN_ERR(report_change(&found_unreadable,
+                                APR_ARRAY_IDX(changes, i,
+                                              svn_fs_path_change3_t *),
+                                root, fs, callbacks, iterpool));
         }
-
-      if (callbacks->path_change_receiver)
-        SVN_ERR(callbacks->path_change_receiver(
-                                     callbacks->path_change_receiver_baton,
-                                     change,
-                                     iterpool));
-
-      /* Next changed path. */
-      SVN_ERR(svn_fs_path_change_get(&change, iterator));
     }
 
+  svn_pool_destroy(batch_pool);
   svn_pool_destroy(iterpool);
 
   if (! found_readable)
@@ -1336,10 +1391,48 @@ send_log(svn_revnum_t rev,
    memory. */
 #define MAX_OPEN_HISTORIES 32
 
+/* Set *UNCHANGED to TRUE if the FS backend of ROOT can tell that PATH,
+   which exists in ROOT, has no history between HIST_START and the
+   revision of ROOT.  Otherwise, set it to FALSE.  Use SCRATCH_POOL for
+   temporary allocations. */
+static svn_error_t *
+path_unchanged(svn_boolean_t *unchanged,
+               svn_fs_root_t *root,
+               const char *path,
+               svn_revnum_t hist_start,
+               apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *changed_revs;
+  svn_node_kind_t kind;
+
+  *unchanged = FALSE;
+  SVN_ERR(svn_fs__get_changed_revisions(&changed_revs,
+                                        svn_fs_root_fs(root),
+                                        svn_fspath__canonicalize(path,
+                                                                 scratch_pool),
+                                        hist_start,
+                                        svn_fs_revision_root_revision(root),
+                                        scratch_pool, scratch_pool));
+  if (!changed_revs || changed_revs->nelts)
+    return SVN_NO_ERROR;
+
+  /* Missing paths must still be reported by the history code. */
+  SVN_ERR(svn_fs_check_path(&kind, root, path, scratch_pool));
+  *unchanged = (kind != svn_node_none);
+
+  return SVN_NO_ERROR;
+}
+
 /* Get the histories for PATHS, and store them in *HISTORIES.
 
    If IGNORE_MISSING_LOCATIONS is set, don't treat requests for bogus
-   repository locations as fatal -- just ignore them.  */
+   repository locations as fatal -- just ignore them.
+
+   If USE_CHANGED_PATHS_INDEX is set, paths that the FS backend knows
+   to be unchanged in the range are added to *HISTORIES as being done,
+   without ever opening their history.  Since their INFO->PATH will then
+   not be adjusted to an earlier location, don't set this flag if those
+   paths get evaluated afterwards.  */
 static svn_error_t *
 get_path_histories(apr_array_header_t **histories,
                    svn_fs_t *fs,
@@ -1348,6 +1441,7 @@ get_path_histories(apr_array_header_t **histories,
                    svn_revnum_t hist_end,
                    svn_boolean_t strict_node_history,
                    svn_boolean_t ignore_missing_locations,
+                   svn_boolean_t use_changed_paths_index,
                    svn_repos_authz_func_t authz_read_func,
                    void *authz_read_baton,
                    apr_pool_t *pool)
@@ -1392,6 +1486,20 @@ get_path_histories(apr_array_header_t **histories,
       info->history_rev = hist_end;
       info->first_time = TRUE;
 
+      if (use_changed_paths_index)
+        {
+          SVN_ERR(path_unchanged(&info->done, root, this_path, hist_start,
+                                 iterpool));
+          if (info->done)
+            {
+              info->hist = NULL;
+              info->oldpool = NULL;
+              info->newpool = NULL;
+              APR_ARRAY_PUSH(*histories, struct path_info *) = info;
+              continue;
+            }
+        }
+
       if (i < MAX_OPEN_HISTORIES)
         {
           err = svn_fs_node_history2(&info->hist, root, this_path, pool,
@@ -1963,6 +2071,7 @@ do_logs(svn_fs_t *fs,
      revisions contain real changes to at least one of our paths.  */
   SVN_ERR(get_path_histories(&histories, fs, paths, hist_start, hist_end,
                              strict_node_history, ignore_missing_locations,
+                             ! include_merged_revisions,
                              callbacks->authz_read_func,
                              callbacks->authz_read_baton, pool));
 
@@ -2252,22 +2361,23 @@ get_paths_history_as_mergeinfo(svn_mergeinfo_t *paths_history_mergeinfo,
   return SVN_NO_ERROR;
 }
 
-svn_error_t *
-svn_repos_get_logs5(svn_repos_t *repos,
-                    const apr_array_header_t *paths,
-                    svn_revnum_t start,
-                    svn_revnum_t end,
-                    int limit,
-                    svn_boolean_t strict_node_history,
-                    svn_boolean_t include_merged_revisions,
-                    const apr_array_header_t *revprops,
-                    svn_repos_authz_func_t authz_read_func,
-                    void *authz_read_baton,
-                    svn_repos_path_change_receiver_t path_change_receiver,
-                    void *path_change_receiver_baton,
-                    svn_repos_log_entry_receiver_t revision_receiver,
-                    void *revision_receiver_baton,
-                    apr_pool_t *scratch_pool)
+/* Implement svn_repos_get_logs5 with the same parameters. */
+static svn_error_t *
+get_logs(svn_repos_t *repos,
+         const apr_array_header_t *paths,
+         svn_revnum_t start,
+         svn_revnum_t end,
+         int limit,
+         svn_boolean_t strict_node_history,
+         svn_boolean_t include_merged_revisions,
+         const apr_array_header_t *revprops,
+         svn_repos_authz_func_t authz_read_func,
+         void *authz_read_baton,
+         svn_repos_path_change_receiver_t path_change_receiver,
+         void *path_change_receiver_baton,
+         svn_repos_log_entry_receiver_t revision_receiver,
+         void *revision_receiver_baton,
+         apr_pool_t *scratch_pool)
 {
   svn_revnum_t head = SVN_INVALID_REVNUM;
   svn_fs_t *fs = repos->fs;
@@ -2414,3 +2524,34 @@ svn_repos_get_logs5(svn_repos_t *repos,
                  include_merged_revisions, FALSE, FALSE, FALSE,
                  revprops, descending_order, &callbacks, scratch_pool);
 }
+
+svn_error_t *
+svn_repos_get_logs5(svn_repos_t *repos,
+                    const apr_array_header_t *paths,
+                    svn_revnum_t start,
+                    svn_revnum_t end,
+                    int limit,
+                    svn_boolean_t strict_node_history,
+                    svn_boolean_t include_merged_revisions,
+                    const apr_array_header_t *revprops,
+                    svn_repos_authz_func_t authz_read_func,
+                    void *authz_read_baton,
+                    svn_repos_path_change_receiver_t path_change_receiver,
+                    void *path_change_receiver_baton,
+                    svn_repos_log_entry_receiver_t revision_receiver,
+                    void *revision_receiver_baton,
+                    apr_pool_t *scratch_pool)
+{
+  svn_error_t *err;
+
+  SVN_PROBE4(repos__get_logs__start, repos->path, start, end,
+             paths ? paths->nelts : 0);
+  err = get_logs(repos, paths, start, end, limit, strict_node_history,
+                 include_merged_revisions, revprops,
+                 authz_read_func, authz_read_baton,
+                 path_change_receiver, path_change_receiver_baton,
+                 revision_receiver, revision_receiver_baton, scratch_pool);
+  SVN_PROBE2(repos__get_logs__done, repos->path, err ? err->apr_err : 0);
+
+  return svn_error_trace(err);
+}
@@ -864,56 +864,74 @@ get_relevant_changes(apr_hash_t **changed_paths,
 {
   svn_fs_path_change_iterator_t *iterator;
   svn_fs_path_change3_t *change;
-  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_array_header_t *changes;
+  apr_array_header_t *check_paths;
+  svn_boolean_t *allowed = NULL;
+  int i;
 
   /* Fetch the paths changed under ROOT. */
   SVN_ERR(svn_fs_paths_changed3(&iterator, root, scratch_pool, scratch_pool));
   SVN_ERR(svn_fs_path_change_get(&change, iterator));
 
-  /* Make an array from the keys of our CHANGED_PATHS hash, and copy
-     the values into a new hash whose keys have no leading slashes. */
-  *paths = apr_array_make(result_pool, 16, sizeof(const char *));
-  *changed_paths = apr_hash_make(result_pool);
+  /* Collect the changes relevant to BASE_RELPATH first, so the authz
+     callback can check them all at once. */
+  changes = apr_array_make(scratch_pool, 16, sizeof(change));
+  check_paths = apr_array_make(scratch_pool, 16, sizeof(const char *));
   while (change)
     {
       const char *path = change->path.data;
-      apr_ssize_t keylen = change->path.len;
-      svn_boolean_t allowed = TRUE;
+      if (path[0] == '/')
+        path++;
+
+      /* If the base_path doesn't match the top directory of this path
+         we don't want anything to do with it... 
+         ...unless this was a change to one of the parent directories of
+         base_path. */
+      if (   svn_relpath_skip_ancestor(base_relpath, path)
+          || svn_relpath_skip_ancestor(path, base_relpath))
+        {
+          change = svn_fs_path_change3_dup(change, result_pool);
+          APR_ARRAY_PUSH(changes, svn_fs_path_change3_t *) = change;
+          APR_ARRAY_PUSH(check_paths, const char *) = change->path.data;
+        }
 
-      svn_pool_clear(iterpool);
-      if (authz_read_func)
-        SVN_ERR(authz_read_func(&allowed, root, path, authz_read_baton,
-                                iterpool));
+      SVN_ERR(svn_fs_path_change_get(&change, iterator));
+    }
 
-      if (allowed)
-        {
-          if (path[0] == '/')
-            {
-              path++;
-              keylen--;
-            }
+  if (authz_read_func)
+    {
+      allowed = apr_palloc(scratch_pool,
+                           changes->nelts * sizeof(*allowed));
+      SVN_ERR(svn_repos__authz_read_paths(allowed, root, check_paths,
+                                          authz_read_func, authz_read_baton,
+                                          scratch_pool));
+    }
 
-          /* If the base_path doesn't match the top directory of this path
-             we don't want anything to do with it... 
-             ...unless this was a change to one of the parent directories of
-             base_path. */
-          if (   svn_relpath_skip_ancestor(base_relpath, path)
-              || svn_relpath_skip_ancestor(path, base_relpath))
-            {
-              change = svn_fs_path_change3_dup(change, result_pool);
-              path = change->path.data;
-              if (path[0] == '/')
-                path++;
+  /* Make an array from the paths of the readable changes, and put the
+     changes into a new hash whose keys have no leading slashes. */
+  *paths = apr_array_make(result_pool, changes->nelts, sizeof(const char *));
+  *changed_paths = apr_hash_make(result_pool);
+  for (i = 0; i < changes->nelts; ++i)
+    {
+      const char *path;
+      apr_ssize_t keylen;
 
-              APR_ARRAY_PUSH(*paths, const char *) = path;
-              apr_hash_set(*changed_paths, path, keylen, change);
-            }
+      if (allowed && !allowed[i])
+        continue;
+
+      change = APR_ARRAY_IDX(changes, i, svn_fs_path_change3_t *);
+      path = change->path.data;
+      keylen = change->path.len;
+      if (path[0] == '/')
+        {
+          path++;
+          keylen--;
         }
 
-      SVN_ERR(svn_fs_path_change_get(&change, iterator));
+      APR_ARRAY_PUSH(*paths, const char *) = path;
+      apr_hash_set(*changed_paths, path, keylen, change);
     }
 
-  svn_pool_destroy(iterpool);
   return SVN_NO_ERROR;
 }
 
@@ -0,0 +1,1208 @@
+/* replay_cache.c : on-disk cache of revision replays
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_hash.h>
+
+#include "svn_types.h"
+#include "svn_delta.h"
+#include "svn_hash.h"
+#include "svn_fs.h"
+#include "svn_io.h"
+#include "svn_repos.h"
+#include "svn_pools.h"
+#include "svn_dirent_uri.h"
+#include "svn_private_config.h"
+#include "private/svn_repos_private.h"
+#include "private/svn_skel.h"
+
+#include "repos.h"
+
+
+/*** Overview ***/
+
+/* Mirrors tend to replay the same revisions over and over again, e.g.
+   once per svnsync destination.  The editor drive that svn_repos_replay2
+   produces for a whole revision only depends on the revision itself and
+   on the answers of the read authz callback.  So, we record the drive
+   once, using a callback that allows everything, and play it back for
+   every later request.
+
+   While recording, we also remember all questions asked to the authz
+   callback.  Before playing a recorded drive back to a user with
+   restricted access, we ask the user's authz callback the same
+   questions.  If all paths are readable, the live replay would have
+   made the very same decisions and produced the very same drive.
+   Otherwise, we fall back to a live replay that filters the revision
+   for the user.
+
+   A cache file is a sequence of records.  Each record is a skel whose
+   length is given as 16 hex digits directly in front of it.  The first
+   record is the file header, followed by one record per editor call and
+   an "end" record.  Text deltas are stored as svndiff, split into
+   "chunk" records.  After the "end" record follows the list of authz
+   questions and, in the last 16 bytes of the file, the offset of that
+   list in hex digits. */
+
+/* Version of the cache file format. */
+#define REPLAY_CACHE_FORMAT 1
+
+/* Number of hex digits in record length prefixes and in the trailer. */
+#define SIZE_DIGITS 16
+
+/* Number of revisions per sub-directory of the cache. */
+#define REPLAY_CACHE_SHARD_SIZE 1000
+
+
+/*** Writing records ***/
+
+/* Return a new record list for a KIND record, allocated in POOL. */
+static svn_skel_t *
+make_record(const char *kind,
+            apr_pool_t *pool)
+{
+  svn_skel_t *record = svn_skel__make_empty_list(pool);
+  svn_skel__append(record, svn_skel__str_atom(kind, pool));
+
+  return record;
+}
+
+/* Append the integer VALUE to RECORD. */
+static void
+append_int(svn_skel_t *record,
+           apr_int64_t value,
+           apr_pool_t *pool)
+{
+  svn_skel__append(record,
+                   svn_skel__str_atom(apr_psprintf(pool, "%" APR_INT64_T_FMT,
+                                                   value),
+                                      pool));
+}
+
+/* Append the C string VALUE to RECORD, unless it is NULL. */
+static void
+append_cstring(svn_skel_t *record,
+               const char *value,
+               apr_pool_t *pool)
+{
+  if (value)
+    svn_skel__append(record, svn_skel__str_atom(value, pool));
+}
+
+/* Append the LEN bytes at DATA to RECORD. */
+static void
+append_mem(svn_skel_t *record,
+           const char *data,
+           apr_size_t len,
+           apr_pool_t *pool)
+{
+  svn_skel__append(record, svn_skel__mem_atom(data, len, pool));
+}
+
+/* Baton for the recording editor and its authz callback. */
+typedef struct record_baton_t
+{
+  /* Where the records go. */
+  svn_stream_t *stream;
+
+  /* Number of bytes written to STREAM so far. */
+  apr_uint64_t offset;
+
+  /* Next token to hand out to a directory or file baton. */
+  apr_int64_t next_token;
+
+  /* The authz questions asked so far, as a list of (REV PATH) skels,
+     and a hash of "REV PATH" strings for de-duplication. */
+  svn_skel_t *authz_checks;
+  apr_hash_t *authz_seen;
+
+  /* FALSE, if the drive depends on anything we cannot record. */
+  svn_boolean_t cacheable;
+
+  apr_pool_t *pool;
+} record_baton_t;
+
+/* Baton for the directories and files of the recording editor. */
+typedef struct record_node_t
+{
+  record_baton_t *rb;
+  apr_int64_t token;
+} record_node_t;
+
+/* Write RECORD to RB->stream.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+write_record(record_baton_t *rb,
+             const svn_skel_t *record,
+             apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *data = svn_skel__unparse(record, scratch_pool);
+  const char *size = apr_psprintf(scratch_pool,
+                                  "%016" APR_UINT64_T_HEX_FMT,
+                                  (apr_uint64_t)data->len);
+
+  SVN_ERR(svn_stream_puts(rb->stream, size));
+  SVN_ERR(svn_stream_write(rb->stream, data->data, &data->len));
+  rb->offset += SIZE_DIGITS + data->len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return a new node baton in RB, allocated in POOL. */
+static record_node_t *
+make_node(record_baton_t *rb,
+          apr_pool_t *pool)
+{
+  record_node_t *node = apr_pcalloc(pool, sizeof(*node));
+  node->rb = rb;
+  node->token = rb->next_token++;
+
+  return node;
+}
+
+/* An svn_repos_authz_func_t that allows everything and records the
+   question in BATON, a record_baton_t. */
+static svn_error_t *
+record_authz_func(svn_boolean_t *allowed,
+                  svn_fs_root_t *root,
+                  const char *path,
+                  void *baton,
+                  apr_pool_t *pool)
+{
+  record_baton_t *rb = baton;
+  *allowed = TRUE;
+
+  if (svn_fs_is_revision_root(root))
+    {
+      svn_revnum_t rev = svn_fs_revision_root_revision(root);
+      const char *key = apr_psprintf(pool, "%ld %s", rev, path);
+
+      if (!svn_hash_gets(rb->authz_seen, key))
+        {
+          svn_skel_t *check = svn_skel__make_empty_list(rb->pool);
+
+          svn_hash_sets(rb->authz_seen, apr_pstrdup(rb->pool, key), "");
+          append_int(check, rev, rb->pool);
+          append_cstring(check, apr_pstrdup(rb->pool, path), rb->pool);
+          svn_skel__prepend(check, rb->authz_checks);
+        }
+    }
+  else
+    {
+      rb->cacheable = FALSE;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_set_target_revision(void *edit_baton,
+                           svn_revnum_t target_revision,
+                           apr_pool_t *pool)
+{
+  record_baton_t *rb = edit_baton;
+  svn_skel_t *record = make_record("target-rev", pool);
+
+  append_int(record, target_revision, pool);
+  return svn_error_trace(write_record(rb, record, pool));
+}
+
+static svn_error_t *
+record_open_root(void *edit_baton,
+                 svn_revnum_t base_revision,
+                 apr_pool_t *pool,
+                 void **root_baton)
+{
+  record_baton_t *rb = edit_baton;
+  record_node_t *node = make_node(rb, pool);
+  svn_skel_t *record = make_record("open-root", pool);
+
+  append_int(record, base_revision, pool);
+  append_int(record, node->token, pool);
+  *root_baton = node;
+
+  return svn_error_trace(write_record(rb, record, pool));
+}
+
+static svn_error_t *
+record_delete_entry(const char *path,
+                    svn_revnum_t revision,
+                    void *parent_baton,
+                    apr_pool_t *pool)
+{
+  record_node_t *parent = parent_baton;
+  svn_skel_t *record = make_record("delete", pool);
+
+  append_int(record, parent->token, pool);
+  append_int(record, revision, pool);
+  append_cstring(record, path, pool);
+
+  return svn_error_trace(write_record(parent->rb, record, pool));
+}
+
+/* Record an "add-dir" or "add-file" call, as given by KIND. */
+static svn_error_t *
+record_add(const char *kind,
+           const char *path,
+           void *parent_baton,
+           const char *copyfrom_path,
+           svn_revnum_t copyfrom_revision,
+           apr_pool_t *pool,
+           void **child_baton)
+{
+  record_node_t *parent = parent_baton;
+  record_node_t *node = make_node(parent->rb, pool);
+  svn_skel_t *record = make_record(kind, pool);
+
+  append_int(record, parent->token, pool);
+  append_int(record, node->token, pool);
+  append_int(record, copyfrom_revision, pool);
+  append_cstring(record, path, pool);
+  append_cstring(record, copyfrom_path, pool);
+  *child_baton = node;
+
+  return svn_error_trace(write_record(parent->rb, record, pool));
+}
+
+/* Record an "open-dir" or "open-file" call, as given by KIND. */
+static svn_error_t *
+record_open(const char *kind,
+            const char *path,
+            void *parent_baton,
+            svn_revnum_t base_revision,
+            apr_pool_t *pool,
+            void **child_baton)
+{
+  record_node_t *parent = parent_baton;
+  record_node_t *node = make_node(parent->rb, pool);
+  svn_skel_t *record = make_record(kind, pool);
+
+  append_int(record, parent->token, pool);
+  append_int(record, node->token, pool);
+  append_int(record, base_revision, pool);
+  append_cstring(record, path, pool);
+  *child_baton = node;
+
+  return svn_error_trace(write_record(parent->rb, record, pool));
+}
+
+/* Record a property change of KIND "dir-prop" or "file-prop". */
+static svn_error_t *
+record_prop(const char *kind,
+            void *baton,
+            const char *name,
+            const svn_string_t *value,
+            apr_pool_t *pool)
+{
+  record_node_t *node = baton;
+  svn_skel_t *record = make_record(kind, pool);
+
+  append_int(record, node->token, pool);
+  append_cstring(record, name, pool);
+  if (value)
+    append_mem(record, value->data, value->len, pool);
+
+  return svn_error_trace(write_record(node->rb, record, pool));
+}
+
+/* Record a call of KIND "close-dir" or "close-file".  CHECKSUM may be
+   NULL. */
+static svn_error_t *
+record_close(const char *kind,
+             void *baton,
+             const char *checksum,
+             apr_pool_t *pool)
+{
+  record_node_t *node = baton;
+  svn_skel_t *record = make_record(kind, pool);
+
+  append_int(record, node->token, pool);
+  append_cstring(record, checksum, pool);
+
+  return svn_error_trace(write_record(node->rb, record, pool));
+}
+
+/* Record an "absent-dir" or "absent-file" call, as given by KIND. */
+static svn_error_t *
+record_absent(const char *kind,
+              const char *path,
+              void *parent_baton,
+              apr_pool_t *pool)
+{
+  record_node_t *parent = parent_baton;
+  svn_skel_t *record = make_record(kind, pool);
+
+  append_int(record, parent->token, pool);
+  append_cstring(record, path, pool);
+
+  return svn_error_trace(write_record(parent->rb, record, pool));
+}
+
+static svn_error_t *
+record_add_directory(const char *path,
+                     void *parent_baton,
+                     const char *copyfrom_path,
+                     svn_revnum_t copyfrom_revision,
+                     apr_pool_t *pool,
+                     void **child_baton)
+{
+  return svn_error_trace(record_add("add-dir", path, parent_baton,
+                                    copyfrom_path, copyfrom_revision,
+                                    pool, child_baton));
+}
+
+static svn_error_t *
+record_open_directory(const char *path,
+                      void *parent_baton,
+                      svn_revnum_t base_revision,
+                      apr_pool_t *pool,
+                      void **child_baton)
+{
+  return svn_error_trace(record_open("open-dir", path, parent_baton,
+                                     base_revision, pool, child_baton));
+}
+
+static svn_error_t *
+record_change_dir_prop(void *dir_baton,
+                       const char *name,
+                       const svn_string_t *value,
+                       apr_pool_t *pool)
+{
+  return svn_error_trace(record_prop("dir-prop", dir_baton, name, value,
+                                     pool));
+}
+
+static svn_error_t *
+record_close_directory(void *dir_baton,
+                       apr_pool_t *pool)
+{
+  return svn_error_trace(record_close("close-dir", dir_baton, NULL, pool));
+}
+
+static svn_error_t *
+record_absent_directory(const char *path,
+                        void *parent_baton,
+                        apr_pool_t *pool)
+{
+  return svn_error_trace(record_absent("absent-dir", path, parent_baton,
+                                       pool));
+}
+
+static svn_error_t *
+record_add_file(const char *path,
+                void *parent_baton,
+                const char *copyfrom_path,
+                svn_revnum_t copyfrom_revision,
+                apr_pool_t *pool,
+                void **file_baton)
+{
+  return svn_error_trace(record_add("add-file", path, parent_baton,
+                                    copyfrom_path, copyfrom_revision,
+                                    pool, file_baton));
+}
+
+static svn_error_t *
+record_open_file(const char *path,
+                 void *parent_baton,
+                 svn_revnum_t base_revision,
+                 apr_pool_t *pool,
+                 void **file_baton)
+{
+  return svn_error_trace(record_open("open-file", path, parent_baton,
+                                     base_revision, pool, file_baton));
+}
+
+/* Implements svn_write_fn_t.  Record the svndiff data in DATA as a
+   "chunk" for BATON, a record_node_t. */
+static svn_error_t *
+record_delta_chunk(void *baton,
+                   const char *data,
+                   apr_size_t *len)
+{
+  record_node_t *node = baton;
+  apr_pool_t *scratch_pool = svn_pool_create(node->rb->pool);
+  svn_skel_t *record = make_record("chunk", scratch_pool);
+
+  append_int(record, node->token, scratch_pool);
+  append_mem(record, data, *len, scratch_pool);
+  SVN_ERR(write_record(node->rb, record, scratch_pool));
+  svn_pool_destroy(scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_close_fn_t.  Record the end of the text delta for
+   BATON, a record_node_t. */
+static svn_error_t *
+record_delta_end(void *baton)
+{
+  record_node_t *node = baton;
+  apr_pool_t *scratch_pool = svn_pool_create(node->rb->pool);
+  svn_skel_t *record = make_record("delta-end", scratch_pool);
+
+  append_int(record, node->token, scratch_pool);
+  SVN_ERR(write_record(node->rb, record, scratch_pool));
+  svn_pool_destroy(scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_apply_textdelta(void *file_baton,
+                       const char *base_checksum,
+                       apr_pool_t *pool,
+                       svn_txdelta_window_handler_t *handler,
+                       void **handler_baton)
+{
+  record_node_t *node = file_baton;
+  svn_skel_t *record = make_record("textdelta", pool);
+  svn_stream_t *svndiff;
+
+  append_int(record, node->token, pool);
+  append_cstring(record, base_checksum, pool);
+  SVN_ERR(write_record(node->rb, record, pool));
+
+  svndiff = svn_stream_create(node, pool);
+  svn_stream_set_write(svndiff, record_delta_chunk);
+  svn_stream_set_close(svndiff, record_delta_end);
+  svn_txdelta_to_svndiff3(handler, handler_baton, svndiff, 1,
+                          SVN_DELTA_COMPRESSION_LEVEL_DEFAULT, pool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_change_file_prop(void *file_baton,
+                        const char *name,
+                        const svn_string_t *value,
+                        apr_pool_t *pool)
+{
+  return svn_error_trace(record_prop("file-prop", file_baton, name, value,
+                                     pool));
+}
+
+static svn_error_t *
+record_close_file(void *file_baton,
+                  const char *text_checksum,
+                  apr_pool_t *pool)
+{
+  return svn_error_trace(record_close("close-file", file_baton,
+                                      text_checksum, pool));
+}
+
+static svn_error_t *
+record_absent_file(const char *path,
+                   void *parent_baton,
+                   apr_pool_t *pool)
+{
+  return svn_error_trace(record_absent("absent-file", path, parent_baton,
+                                       pool));
+}
+
+/* Return the recording editor, allocated in POOL. */
+static const svn_delta_editor_t *
+get_record_editor(apr_pool_t *pool)
+{
+  svn_delta_editor_t *editor = svn_delta_default_editor(pool);
+
+  editor->set_target_revision = record_set_target_revision;
+  editor->open_root = record_open_root;
+  editor->delete_entry = record_delete_entry;
+  editor->add_directory = record_add_directory;
+  editor->open_directory = record_open_directory;
+  editor->change_dir_prop = record_change_dir_prop;
+  editor->close_directory = record_close_directory;
+  editor->absent_directory = record_absent_directory;
+  editor->add_file = record_add_file;
+  editor->open_file = record_open_file;
+  editor->apply_textdelta = record_apply_textdelta;
+  editor->change_file_prop = record_change_file_prop;
+  editor->close_file = record_close_file;
+  editor->absent_file = record_absent_file;
+
+  return editor;
+}
+
+/* Replay ROOT into a new cache file at PATH, using SEND_DELTAS as in
+   svn_repos_replay2.  Leave PATH untouched, if the replay cannot be
+   cached.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+write_cache_file(const char *path,
+                 svn_fs_root_t *root,
+                 svn_boolean_t send_deltas,
+                 apr_pool_t *scratch_pool)
+{
+  record_baton_t rb = { 0 };
+  apr_file_t *file;
+  const char *tmp_path;
+  svn_skel_t *record;
+  apr_uint64_t checks_offset;
+  svn_error_t *err;
+
+  SVN_ERR(svn_io_make_dir_recursively(svn_dirent_dirname(path,
+                                                         scratch_pool),
+                                      scratch_pool));
+  SVN_ERR(svn_io_open_unique_file3(&file, &tmp_path,
+                                   svn_dirent_dirname(path, scratch_pool),
+                                   svn_io_file_del_none,
+                                   scratch_pool, scratch_pool));
+
+  rb.stream = svn_stream_from_aprfile2(file, FALSE, scratch_pool);
+  rb.authz_checks = svn_skel__make_empty_list(scratch_pool);
+  rb.authz_seen = apr_hash_make(scratch_pool);
+  rb.cacheable = TRUE;
+  rb.pool = scratch_pool;
+
+  record = make_record("replay-cache", scratch_pool);
+  append_int(record, REPLAY_CACHE_FORMAT, scratch_pool);
+  append_int(record, send_deltas, scratch_pool);
+  err = write_record(&rb, record, scratch_pool);
+
+  if (!err)
+    err = svn_repos_replay2(root, "", SVN_INVALID_REVNUM, send_deltas,
+                            get_record_editor(scratch_pool), &rb,
+                            record_authz_func, &rb, scratch_pool);
+
+  if (!err)
+    err = write_record(&rb, make_record("end", scratch_pool), scratch_pool);
+
+  /* Append the authz questions and their offset. */
+  checks_offset = rb.offset;
+  if (!err)
+    err = write_record(&rb, rb.authz_checks, scratch_pool);
+  if (!err)
+    err = svn_stream_puts(rb.stream,
+                          apr_psprintf(scratch_pool,
+                                       "%016" APR_UINT64_T_HEX_FMT,
+                                       checks_offset));
+
+  err = svn_error_compose_create(err, svn_stream_close(rb.stream));
+  if (!err && rb.cacheable)
+    err = svn_io_file_rename2(tmp_path, path, FALSE, scratch_pool);
+  else
+    err = svn_error_compose_create(err,
+                                   svn_io_remove_file2(tmp_path, TRUE,
+                                                       scratch_pool));
+
+  return svn_error_trace(err);
+}
+
+
+/*** Reading records ***/
+
+/* Return an error about the corrupt cache file at PATH. */
+static svn_error_t *
+corrupt_cache_file(const char *path,
+                   apr_pool_t *scratch_pool)
+{
+  return svn_error_createf(SVN_ERR_MALFORMED_FILE, NULL,
+                           _("Corrupt replay cache file '%s'"),
+                           svn_dirent_local_style(path, scratch_pool));
+}
+
+/* An open cache file. */
+typedef struct cache_file_t
+{
+  const char *path;
+  apr_file_t *file;
+  svn_stream_t *stream;
+} cache_file_t;
+
+/* Parse the SIZE_DIGITS hex digits at DIGITS into *VALUE. */
+static svn_error_t *
+parse_size(apr_uint64_t *value,
+           const char *digits,
+           cache_file_t *cache,
+           apr_pool_t *scratch_pool)
+{
+  svn_error_t *err;
+
+  err = svn_cstring_strtoui64(value,
+                              apr_pstrmemdup(scratch_pool, digits,
+                                             SIZE_DIGITS),
+                              0, APR_UINT64_MAX, 16);
+  if (err)
+    return svn_error_compose_create(corrupt_cache_file(cache->path,
+                                                       scratch_pool),
+                                    err);
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the next record from CACHE into *RECORD, allocated in
+   RESULT_POOL.  Verify that it is a list. */
+static svn_error_t *
+read_record(svn_skel_t **record,
+            cache_file_t *cache,
+            apr_pool_t *result_pool)
+{
+  char digits[SIZE_DIGITS];
+  apr_size_t len = sizeof(digits);
+  apr_uint64_t size;
+  char *data;
+
+  SVN_ERR(svn_stream_read_full(cache->stream, digits, &len));
+  if (len != sizeof(digits))
+    return svn_error_trace(corrupt_cache_file(cache->path, result_pool));
+
+  SVN_ERR(parse_size(&size, digits, cache, result_pool));
+  if (size > APR_SIZE_MAX)
+    return svn_error_trace(corrupt_cache_file(cache->path, result_pool));
+
+  len = (apr_size_t)size;
+  data = apr_palloc(result_pool, len);
+  SVN_ERR(svn_stream_read_full(cache->stream, data, &len));
+  if (len != size)
+    return svn_error_trace(corrupt_cache_file(cache->path, result_pool));
+
+  *record = svn_skel__parse(data, len, result_pool);
+  if (!*record || (*record)->is_atom)
+    return svn_error_trace(corrupt_cache_file(cache->path, result_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the list of authz questions of the open CACHE into *CHECKS,
+   allocated in RESULT_POOL.  Verify that the header has been written for
+   SEND_DELTAS and leave CACHE positioned at the first editor call. */
+static svn_error_t *
+read_cache_header(svn_skel_t **checks,
+                  cache_file_t *cache,
+                  svn_boolean_t send_deltas,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  svn_skel_t *record;
+  char digits[SIZE_DIGITS];
+  apr_off_t offset = 0;
+  apr_uint64_t checks_offset;
+  apr_int64_t format, deltas;
+
+  /* Read the trailer and the authz questions it points to. */
+  SVN_ERR(svn_io_file_seek(cache->file, APR_END, &offset, scratch_pool));
+  if (offset < 2 * SIZE_DIGITS)
+    return svn_error_trace(corrupt_cache_file(cache->path, scratch_pool));
+
+  offset -= SIZE_DIGITS;
+  SVN_ERR(svn_io_file_seek(cache->file, APR_SET, &offset, scratch_pool));
+  SVN_ERR(svn_io_file_read_full2(cache->file, digits, sizeof(digits),
+                                 NULL, NULL, scratch_pool));
+  SVN_ERR(parse_size(&checks_offset, digits, cache, scratch_pool));
+  if (checks_offset >= (apr_uint64_t)offset)
+    return svn_error_trace(corrupt_cache_file(cache->path, scratch_pool));
+
+  offset = (apr_off_t)checks_offset;
+  SVN_ERR(svn_io_file_seek(cache->file, APR_SET, &offset, scratch_pool));
+  SVN_ERR(read_record(checks, cache, result_pool));
+
+  /* Verify the header. */
+  offset = 0;
+  SVN_ERR(svn_io_file_seek(cache->file, APR_SET, &offset, scratch_pool));
+  SVN_ERR(read_record(&record, cache, scratch_pool));
+  if (svn_skel__list_length(record) != 3
+      || !svn_skel__matches_atom(record->children, "replay-cache"))
+    return svn_error_trace(corrupt_cache_file(cache->path, scratch_pool));
+
+  SVN_ERR(svn_skel__parse_int(&format, record->children->next,
+                              scratch_pool));
+  SVN_ERR(svn_skel__parse_int(&deltas, record->children->next->next,
+                              scratch_pool));
+  if (format != REPLAY_CACHE_FORMAT || deltas != send_deltas)
+    return svn_error_trace(corrupt_cache_file(cache->path, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Open the cache file at PATH and verify its header as written for
+   SEND_DELTAS.  Set *CACHE to NULL, if there is no such file.  Set
+   *CHECKS to the list of authz questions of the file.  Allocate the
+   results in RESULT_POOL. */
+static svn_error_t *
+open_cache_file(cache_file_t **cache,
+                svn_skel_t **checks,
+                const char *path,
+                svn_boolean_t send_deltas,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  cache_file_t *result;
+  svn_error_t *err;
+
+  *cache = NULL;
+  result = apr_pcalloc(result_pool, sizeof(*result));
+  result->path = path;
+
+  err = svn_io_file_open(&result->file, path, APR_READ | APR_BUFFERED,
+                         APR_OS_DEFAULT, result_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  result->stream = svn_stream_from_aprfile2(result->file, TRUE,
+                                            result_pool);
+
+  /* Don't keep a broken file open, so that it can be replaced. */
+  err = read_cache_header(checks, result, send_deltas, result_pool,
+                          scratch_pool);
+  if (err)
+    return svn_error_compose_create(err,
+                                    svn_io_file_close(result->file,
+                                                      scratch_pool));
+
+  *cache = result;
+  return SVN_NO_ERROR;
+}
+
+/* Set *ALLOWED to TRUE if AUTHZ_READ_FUNC with AUTHZ_READ_BATON allows
+   all paths in CHECKS, a list of (REV PATH) skels of FS.  Use
+   SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+check_authz(svn_boolean_t *allowed,
+            svn_fs_t *fs,
+            const svn_skel_t *checks,
+            svn_repos_authz_func_t authz_read_func,
+            void *authz_read_baton,
+            apr_pool_t *scratch_pool)
+{
+  apr_hash_t *paths_by_rev = apr_hash_make(scratch_pool);
+  apr_hash_index_t *hi;
+  apr_pool_t *iterpool;
+  const svn_skel_t *check;
+
+  *allowed = TRUE;
+  if (!authz_read_func)
+    return SVN_NO_ERROR;
+
+  /* Group the paths by revision, so we can check them in batches. */
+  for (check = checks->children; check; check = check->next)
+    {
+      apr_array_header_t *paths;
+      apr_int64_t rev;
+
+      if (svn_skel__list_length(check) != 2
+          || !check->children->next->is_atom)
+        return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                                _("Corrupt replay cache authz list"));
+
+      SVN_ERR(svn_skel__parse_int(&rev, check->children, scratch_pool));
+      paths = apr_hash_get(paths_by_rev, &rev, sizeof(rev));
+      if (!paths)
+        {
+          svn_revnum_t *key = apr_palloc(scratch_pool, sizeof(*key));
+
+          *key = (svn_revnum_t)rev;
+          paths = apr_array_make(scratch_pool, 16, sizeof(const char *));
+          apr_hash_set(paths_by_rev, key, sizeof(*key), paths);
+        }
+
+      APR_ARRAY_PUSH(paths, const char *)
+        = apr_pstrmemdup(scratch_pool, check->children->next->data,
+                         check->children->next->len);
+    }
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (hi = apr_hash_first(scratch_pool, paths_by_rev);
+       hi && *allowed;
+       hi = apr_hash_next(hi))
+    {
+      const svn_revnum_t *rev = apr_hash_this_key(hi);
+      apr_array_header_t *paths = apr_hash_this_val(hi);
+      svn_boolean_t *readable;
+      svn_fs_root_t *root;
+      int i;
+
+      svn_pool_clear(iterpool);
+
+      readable = apr_palloc(iterpool, paths->nelts * sizeof(*readable));
+      SVN_ERR(svn_fs_revision_root(&root, fs, *rev, iterpool));
+      SVN_ERR(svn_repos__authz_read_paths(readable, root, paths,
+                                          authz_read_func, authz_read_baton,
+                                          iterpool));
+
+      for (i = 0; i < paths->nelts; ++i)
+        if (!readable[i])
+          *allowed = FALSE;
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+
+/*** Playing back ***/
+
+/* A directory or file opened during playback. */
+typedef struct play_node_t
+{
+  /* The editor's baton for this node, NULL once closed. */
+  void *baton;
+
+  /* Pool of this node, destroyed when the node gets closed. */
+  apr_pool_t *pool;
+
+  /* The svndiff parser for the current text delta or NULL. */
+  svn_stream_t *delta;
+} play_node_t;
+
+/* Return the string in the atom ARG, allocated in POOL. */
+static const char *
+arg_cstring(const svn_skel_t *arg,
+            apr_pool_t *pool)
+{
+  return apr_pstrmemdup(pool, arg->data, arg->len);
+}
+
+/* Set *NODE to the open node in NODES identified by the integer atom
+   ARG.  Use CACHE for error messages. */
+static svn_error_t *
+arg_node(play_node_t **node,
+         const apr_array_header_t *nodes,
+         const svn_skel_t *arg,
+         cache_file_t *cache,
+         apr_pool_t *scratch_pool)
+{
+  apr_int64_t token;
+
+  SVN_ERR(svn_skel__parse_int(&token, arg, scratch_pool));
+  if (token < 0 || token >= nodes->nelts
+      || !APR_ARRAY_IDX(nodes, token, play_node_t *)->baton)
+    return svn_error_trace(corrupt_cache_file(cache->path, scratch_pool));
+
+  *node = APR_ARRAY_IDX(nodes, token, play_node_t *);
+  return SVN_NO_ERROR;
+}
+
+/* Add a new node to NODES, to be identified by the integer atom ARG,
+   and return it in *NODE.  Give it a sub-pool of PARENT_POOL.  The node
+   itself lives in the pool of NODES, so that it can be identified as
+   closed after its own pool is gone. */
+static svn_error_t *
+new_node(play_node_t **node,
+         apr_array_header_t *nodes,
+         const svn_skel_t *arg,
+         apr_pool_t *parent_pool,
+         cache_file_t *cache,
+         apr_pool_t *scratch_pool)
+{
+  apr_int64_t token;
+  apr_pool_t *pool;
+
+  SVN_ERR(svn_skel__parse_int(&token, arg, scratch_pool));
+  if (token != nodes->nelts)
+    return svn_error_trace(corrupt_cache_file(cache->path, scratch_pool));
+
+  pool = svn_pool_create(parent_pool);
+  *node = apr_pcalloc(nodes->pool, sizeof(**node));
+  (*node)->pool = pool;
+  APR_ARRAY_PUSH(nodes, play_node_t *) = *node;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the value of the optional string atom ARG, allocated in POOL,
+   or NULL if ARG does not exist. */
+static const svn_string_t *
+arg_optional_string(const svn_skel_t *arg,
+                    apr_pool_t *pool)
+{
+  return arg ? svn_string_ncreate(arg->data, arg->len, pool) : NULL;
+}
+
+/* Drive EDITOR and EDIT_BATON with the records of CACHE, up to its
+   "end" record.  Use POOL for the editor drive. */
+static svn_error_t *
+play_cache_file(cache_file_t *cache,
+                const svn_delta_editor_t *editor,
+                void *edit_baton,
+                apr_pool_t *pool)
+{
+  apr_array_header_t *nodes = apr_array_make(pool, 16,
+                                             sizeof(play_node_t *));
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  while (TRUE)
+    {
+      svn_skel_t *record;
+      const svn_skel_t *args[6] = { NULL };
+      const svn_skel_t *arg;
+      play_node_t *parent, *node;
+      apr_int64_t rev;
+      int count = 0;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(read_record(&record, cache, iterpool));
+
+      for (arg = record->children; arg && count < 6; arg = arg->next)
+        {
+          if (!arg->is_atom)
+            return svn_error_trace(corrupt_cache_file(cache->path, iterpool));
+          args[count++] = arg;
+        }
+      if (count == 0)
+        return svn_error_trace(corrupt_cache_file(cache->path, iterpool));
+
+#define RECORD_IS(kind, min_args) \
+        (svn_skel__matches_atom(args[0], kind) && count >= (min_args) + 1)
+
+      if (RECORD_IS("end", 0))
+        {
+          break;
+        }
+      else if (RECORD_IS("target-rev", 1))
+        {
+          SVN_ERR(svn_skel__parse_int(&rev, args[1], iterpool));
+          SVN_ERR(editor->set_target_revision(edit_baton, (svn_revnum_t)rev,
+                                              iterpool));
+        }
+      else if (RECORD_IS("open-root", 2))
+        {
+          SVN_ERR(svn_skel__parse_int(&rev, args[1], iterpool));
+          SVN_ERR(new_node(&node, nodes, args[2], pool, cache, iterpool));
+          SVN_ERR(editor->open_root(edit_baton, (svn_revnum_t)rev,
+                                    node->pool, &node->baton));
+        }
+      else if (RECORD_IS("delete", 3))
+        {
+          SVN_ERR(arg_node(&parent, nodes, args[1], cache, iterpool));
+          SVN_ERR(svn_skel__parse_int(&rev, args[2], iterpool));
+          SVN_ERR(editor->delete_entry(arg_cstring(args[3], iterpool),
+                                       (svn_revnum_t)rev, parent->baton,
+                                       iterpool));
+        }
+      else if (RECORD_IS("add-dir", 4) || RECORD_IS("add-file", 4))
+        {
+          const char *path, *copyfrom_path;
+
+          SVN_ERR(arg_node(&parent, nodes, args[1], cache, iterpool));
+          SVN_ERR(new_node(&node, nodes, args[2], parent->pool, cache,
+                           iterpool));
+          SVN_ERR(svn_skel__parse_int(&rev, args[3], iterpool));
+          path = arg_cstring(args[4], node->pool);
+          copyfrom_path = args[5] ? arg_cstring(args[5], node->pool) : NULL;
+
+          if (svn_skel__matches_atom(args[0], "add-dir"))
+            SVN_ERR(editor->add_directory(path, parent->baton, copyfrom_path,
+                                          (svn_revnum_t)rev, node->pool,
+                                          &node->baton));
+          else
+            SVN_ERR(editor->add_file(path, parent->baton, copyfrom_path,
+                                     (svn_revnum_t)rev, node->pool,
+                                     &node->baton));
+        }
+      else if (RECORD_IS("open-dir", 4) || RECORD_IS("open-file", 4))
+        {
+          const char *path;
+
+          SVN_ERR(arg_node(&parent, nodes, args[1], cache, iterpool));
+          SVN_ERR(new_node(&node, nodes, args[2], parent->pool, cache,
+                           iterpool));
+          SVN_ERR(svn_skel__parse_int(&rev, args[3], iterpool));
+          path = arg_cstring(args[4], node->pool);
+
+          if (svn_skel__matches_atom(args[0], "open-dir"))
+            SVN_ERR(editor->open_directory(path, parent->baton,
+                                           (svn_revnum_t)rev, node->pool,
+                                           &node->baton));
+          else
+            SVN_ERR(editor->open_file(path, parent->baton,
+                                      (svn_revnum_t)rev, node->pool,
+                                      &node->baton));
+        }
+      else if (RECORD_IS("dir-prop", 2))
+        {
+          SVN_ERR(arg_node(&node, nodes, args[1], cache, iterpool));
+          SVN_ERR(editor->change_dir_prop(node->baton,
+                                          arg_cstring(args[2], iterpool),
+                                          arg_optional_string(args[3],
+                                                              iterpool),
+                                          iterpool));
+        }
+      else if (RECORD_IS("file-prop", 2))
+        {
+          SVN_ERR(arg_node(&node, nodes, args[1], cache, iterpool));
+          SVN_ERR(editor->change_file_prop(node->baton,
+                                           arg_cstring(args[2], iterpool),
+                                           arg_optional_string(args[3],
+                                                               iterpool),
+                                           iterpool));
+        }
+      else if (RECORD_IS("textdelta", 1))
+        {
+          svn_txdelta_window_handler_t handler;
+          void *handler_baton;
+
+          SVN_ERR(arg_node(&node, nodes, args[1], cache, iterpool));
+          SVN_ERR(editor->apply_textdelta(node->baton,
+                                          args[2]
+                                            ? arg_cstring(args[2], iterpool)
+                                            : NULL,
+                                          node->pool,
+                                          &handler, &handler_baton));
+          node->delta = svn_txdelta_parse_svndiff(handler, handler_baton,
+                                                  TRUE, node->pool);
+        }
+      else if (RECORD_IS("chunk", 2))
+        {
+          apr_size_t len = args[2]->len;
+
+          SVN_ERR(arg_node(&node, nodes, args[1], cache, iterpool));
+          if (!node->delta)
+            return svn_error_trace(corrupt_cache_file(cache->path, iterpool));
+          SVN_ERR(svn_stream_write(node->delta, args[2]->data, &len));
+        }
+      else if (RECORD_IS("delta-end", 1))
+        {
+          SVN_ERR(arg_node(&node, nodes, args[1], cache, iterpool));
+          if (!node->delta)
+            return svn_error_trace(corrupt_cache_file(cache->path, iterpool));
+          SVN_ERR(svn_stream_close(node->delta));
+          node->delta = NULL;
+        }
+      else if (RECORD_IS("close-dir", 1) || RECORD_IS("close-file", 1))
+        {
+          SVN_ERR(arg_node(&node, nodes, args[1], cache, iterpool));
+          if (svn_skel__matches_atom(args[0], "close-dir"))
+            SVN_ERR(editor->close_directory(node->baton, node->pool));
+          else
+            SVN_ERR(editor->close_file(node->baton,
+                                       args[2]
+                                         ? arg_cstring(args[2], iterpool)
+                                         : NULL,
+                                       node->pool));
+
+          node->baton = NULL;
+          svn_pool_destroy(node->pool);
+        }
+      else if (RECORD_IS("absent-dir", 2) || RECORD_IS("absent-file", 2))
+        {
+          SVN_ERR(arg_node(&parent, nodes, args[1], cache, iterpool));
+          if (svn_skel__matches_atom(args[0], "absent-dir"))
+            SVN_ERR(editor->absent_directory(arg_cstring(args[2], iterpool),
+                                             parent->baton, iterpool));
+          else
+            SVN_ERR(editor->absent_file(arg_cstring(args[2], iterpool),
+                                        parent->baton, iterpool));
+        }
+      else
+        {
+          return svn_error_trace(corrupt_cache_file(cache->path, iterpool));
+        }
+
+#undef RECORD_IS
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* Return the path of the cache file for REVISION of REPOS, replayed
+   with SEND_DELTAS.  Allocate it in POOL. */
+static const char *
+cache_file_path(svn_repos_t *repos,
+                svn_revnum_t revision,
+                svn_boolean_t send_deltas,
+                apr_pool_t *pool)
+{
+  return svn_dirent_join_many(pool, repos->path,
+                              SVN_REPOS__REPLAY_CACHE_DIR,
+                              apr_psprintf(pool, "%ld",
+                                           revision
+                                             / REPLAY_CACHE_SHARD_SIZE),
+                              apr_psprintf(pool, "%ld.%s", revision,
+                                           send_deltas ? "d" : "n"),
+                              SVN_VA_NULL);
+}
+
+svn_error_t *
+svn_repos__replay_cached(svn_repos_t *repos,
+                         svn_fs_root_t *root,
+                         const char *base_dir,
+                         svn_revnum_t low_water_mark,
+                         svn_boolean_t send_deltas,
+                         const svn_delta_editor_t *editor,
+                         void *edit_baton,
+                         svn_repos_authz_func_t authz_read_func,
+                         void *authz_read_baton,
+                         apr_pool_t *pool)
+{
+  const char *path;
+  cache_file_t *cache;
+  svn_skel_t *checks;
+  svn_boolean_t allowed = FALSE;
+  svn_error_t *err;
+  apr_pool_t *scratch_pool;
+
+  if (base_dir && base_dir[0] == '/')
+    ++base_dir;
+
+  /* We only cache whole-tree replays of revisions. */
+  if (!svn_fs_is_revision_root(root)
+      || svn_fs_revision_root_revision(root) == 0
+      || (base_dir && *base_dir)
+      || (SVN_IS_VALID_REVNUM(low_water_mark) && low_water_mark > 0))
+    return svn_error_trace(svn_repos_replay2(root, base_dir, low_water_mark,
+                                             send_deltas, editor, edit_baton,
+                                             authz_read_func,
+                                             authz_read_baton, pool));
+
+  scratch_pool = svn_pool_create(pool);
+  path = cache_file_path(repos, svn_fs_revision_root_revision(root),
+                         send_deltas, scratch_pool);
+
+  /* Problems with the cache are no reason to fail the replay.  Record
+     the revision again or fall back to a live replay. */
+  err = open_cache_file(&cache, &checks, path, send_deltas,
+                        scratch_pool, scratch_pool);
+  if (err || !cache)
+    {
+      svn_error_clear(err);
+      err = write_cache_file(path, root, send_deltas, scratch_pool);
+      if (!err)
+        err = open_cache_file(&cache, &checks, path, send_deltas,
+                              scratch_pool, scratch_pool);
+    }
+
+  if (!err && cache)
+    err = check_authz(&allowed, svn_fs_root_fs(root), checks,
+                      authz_read_func, authz_read_baton, scratch_pool);
+
+  if (err || !cache || !allowed)
+    {
+      svn_error_clear(err);
+      if (cache)
+        SVN_ERR(svn_io_file_close(cache->file, scratch_pool));
+      svn_pool_destroy(scratch_pool);
+
+      return svn_error_trace(svn_repos_replay2(root, base_dir,
+                                               low_water_mark, send_deltas,
+                                               editor, edit_baton,
+                                               authz_read_func,
+                                               authz_read_baton, pool));
+    }
+
+  SVN_ERR(play_cache_file(cache, editor, edit_baton, scratch_pool));
+  SVN_ERR(svn_io_file_close(cache->file, scratch_pool));
+  svn_pool_destroy(scratch_pool);
+
+  return SVN_NO_ERROR;
+}
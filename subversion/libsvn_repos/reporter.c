@@ -31,11 +31,17 @@
 #include "svn_repos.h"
 #include "svn_pools.h"
 #include "svn_props.h"
+#include "svn_sorts.h"
 #include "repos.h"
 #include "svn_private_config.h"
 
+#include <apr_thread_proc.h>
+#include <apr_thread_cond.h>
+
 #include "private/svn_dep_compat.h"
 #include "private/svn_fspath.h"
+#include "private/svn_mutex.h"
+#include "private/svn_repos_private.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_string_private.h"
 
@@ -141,9 +147,22 @@ typedef struct report_baton_t
      revprop fetching. */
   apr_hash_t *revision_infos;
 
+  /* Pairs of source and target node-rev IDs (see node_pair_key) that we
+     already found to have the same contents.  This spares us repeated
+     property and text comparisons while driving the editor. */
+  apr_hash_t *unchanged_nodes;
+
   /* This will not change. So, fetch it once and reuse it. */
   svn_string_t *repos_uuid;
   apr_pool_t *pool;
+
+  /* Number of files to compute text deltas for ahead of the editor drive
+     and the state of that computation while driving the editor. */
+  int prefetch_count;
+  struct prefetch_t *prefetch;
+
+  /* Send added files as plain fulltext windows instead of self-deltas. */
+  svn_boolean_t send_fulltexts;
 } report_baton_t;
 
 /* The type of a function that accepts changes to an object's property
@@ -662,6 +681,540 @@ send_zero_copy_delta(const unsigned char *contents,
 }
 
 
+/* --- COMPUTING TEXT DELTAS AHEAD --- */
+
+/* While the editor sends the text delta of one file, worker threads may
+   already compute the deltas of the next files of the same directory.
+   The results are buffered in memory and replayed to the editor once it
+   gets to those files.  Any file that the editor does not process in the
+   predicted way simply gets its delta computed by the driver itself. */
+
+#if APR_HAS_THREADS
+
+/* Maximum number of worker threads used for computing deltas ahead. */
+#define MAX_PREFETCH_THREADS 4
+
+/* Deltas larger than this will not be buffered but be computed by the
+   editor driver itself. */
+#define MAX_PREFETCH_SIZE 0x100000
+
+/* States of a prefetch_job_t. */
+typedef enum prefetch_state_t
+{
+  prefetch_queued,
+  prefetch_running,
+  prefetch_done
+} prefetch_state_t;
+
+/* A text delta to compute ahead.  Everything is allocated in POOL. */
+typedef struct prefetch_job_t
+{
+  /* The source and target file.  S_PATH is NULL for deltas against the
+     empty file. */
+  svn_revnum_t s_rev;
+  const char *s_path;
+  const char *t_path;
+
+  prefetch_state_t state;
+
+  /* Set when the driver lost interest in a running job.  The worker will
+     then destroy it once it has completed. */
+  svn_boolean_t abandoned;
+
+  /* The delta windows (svn_txdelta_window_t *) once completed.  NULL if
+     the job failed or the delta was too large to be buffered. */
+  apr_array_header_t *windows;
+
+  /* Root pool of the job, using its own allocator. */
+  apr_pool_t *pool;
+
+  /* Next job in the queue. */
+  struct prefetch_job_t *next;
+} prefetch_job_t;
+
+struct prefetch_t
+{
+  /* Protects all mutable members below.  Used with COND. */
+  svn_mutex__t *mutex;
+
+  /* Signaled whenever a job gets queued or completed or the workers
+     shall terminate. */
+  apr_thread_cond_t *cond;
+
+  /* Jobs in the order they have been queued and their number. */
+  prefetch_job_t *first;
+  prefetch_job_t *last;
+  int count;
+
+  /* Maximum value of COUNT. */
+  int max_count;
+
+  /* Once set, the workers shall terminate. */
+  svn_boolean_t shutdown;
+
+  /* Read-only parameters of the report. */
+  const char *fs_path;
+  apr_hash_t *fs_config;
+  svn_revnum_t t_rev;
+
+  /* The worker threads.  Unused entries are NULL. */
+  apr_thread_t **threads;
+  int thread_count;
+};
+
+/* Destroy JOB. */
+static void
+destroy_prefetch_job(prefetch_job_t *job)
+{
+  svn_pool_destroy(job->pool);
+}
+
+/* Implements svn_fs_warning_callback_t.  The filesystems of the workers
+   only report cache failures, which don't affect the deltas. */
+static void
+prefetch_warning_func(void *baton,
+                      svn_error_t *err)
+{
+}
+
+/* Compute the delta of JOB between the files in S_ROOT and T_ROOT.  Use
+   SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+run_prefetch_job(prefetch_job_t *job,
+                 svn_fs_root_t *s_root,
+                 svn_fs_root_t *t_root,
+                 apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_txdelta_stream_t *dstream;
+  svn_txdelta_window_t *window;
+  apr_array_header_t *windows;
+  apr_size_t size = 0;
+
+  /* The driver won't send deltas for files with unchanged contents. */
+  if (job->s_path)
+    {
+      svn_boolean_t changed;
+
+      SVN_ERR(svn_fs_contents_different(&changed, t_root, job->t_path,
+                                        s_root, job->s_path, scratch_pool));
+      if (!changed)
+        return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_fs_get_file_delta_stream(&dstream, s_root, job->s_path,
+                                       t_root, job->t_path, scratch_pool));
+
+  windows = apr_array_make(job->pool, 4, sizeof(window));
+  do
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_txdelta_next_window(&window, dstream, iterpool));
+      if (window)
+        {
+          size += window->num_ops * sizeof(*window->ops);
+          if (window->new_data)
+            size += window->new_data->len;
+
+          /* Leave large deltas to the driver. */
+          if (size > MAX_PREFETCH_SIZE)
+            break;
+
+          APR_ARRAY_PUSH(windows, svn_txdelta_window_t *)
+            = svn_txdelta_window_dup(window, job->pool);
+        }
+      else
+        {
+          job->windows = windows;
+        }
+    }
+  while (window);
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread function.  Run the jobs of the prefetch_t given by DATA until
+   the report terminates. */
+static void * APR_THREAD_FUNC
+prefetch_thread(apr_thread_t *tid,
+                void *data)
+{
+  struct prefetch_t *prefetch = data;
+  apr_pool_t *pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  apr_pool_t *s_root_pool = svn_pool_create(pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_fs_root_t *s_root = NULL;
+  svn_fs_root_t *t_root = NULL;
+  svn_fs_t *fs;
+  svn_error_t *err;
+
+  /* FS objects must not be shared between threads.  If we can't open our
+     own, leave the work to the others or to the driver. */
+  err = svn_fs_open2(&fs, prefetch->fs_path, prefetch->fs_config, pool,
+                     iterpool);
+  if (!err)
+    {
+      svn_fs_set_warning_func(fs, prefetch_warning_func, NULL);
+      err = svn_fs_revision_root(&t_root, fs, prefetch->t_rev, pool);
+    }
+
+  while (!err)
+    {
+      prefetch_job_t *job = NULL;
+
+      svn_pool_clear(iterpool);
+
+      err = svn_mutex__lock(prefetch->mutex);
+      if (err)
+        break;
+
+      while (!prefetch->shutdown && !job)
+        {
+          for (job = prefetch->first; job; job = job->next)
+            if (job->state == prefetch_queued)
+              break;
+
+          if (!job)
+            {
+              apr_status_t status
+                = apr_thread_cond_wait(prefetch->cond,
+                                       svn_mutex__get(prefetch->mutex));
+              if (status)
+                {
+                  err = svn_error_wrap_apr(status,
+                                  _("Can't wait for condition variable"));
+                  break;
+                }
+            }
+        }
+
+      if (job && !prefetch->shutdown)
+        job->state = prefetch_running;
+      else
+        job = NULL;
+
+      err = svn_mutex__unlock(prefetch->mutex, err);
+      if (!job)
+        break;
+
+      /* Reuse the source root from the previous job if possible. */
+      if (job->s_path
+          && (!s_root || svn_fs_revision_root_revision(s_root) != job->s_rev))
+        {
+          svn_pool_clear(s_root_pool);
+          s_root = NULL;
+          svn_error_clear(svn_fs_revision_root(&s_root, fs, job->s_rev,
+                                               s_root_pool));
+        }
+
+      /* Failed jobs are simply redone by the driver. */
+      if (!job->s_path || s_root)
+        svn_error_clear(run_prefetch_job(job, job->s_path ? s_root : NULL,
+                                         t_root, iterpool));
+
+      /* The driver may wait for this job.  So, hand it over even if we
+         could not get the lock. */
+      err = svn_mutex__lock(prefetch->mutex);
+      job->state = prefetch_done;
+      if (job->abandoned)
+        destroy_prefetch_job(job);
+      apr_thread_cond_broadcast(prefetch->cond);
+      err = svn_mutex__unlock(prefetch->mutex, err);
+    }
+
+  svn_error_clear(err);
+  svn_pool_destroy(pool);
+
+  return NULL;
+}
+
+/* Unlink JOB from the queue of PREFETCH and dispose of it unless it is
+   still running.  Must be called while holding the mutex. */
+static void
+drop_prefetch_job(struct prefetch_t *prefetch,
+                  prefetch_job_t *job)
+{
+  prefetch_job_t **link = &prefetch->first;
+  prefetch_job_t *previous = NULL;
+
+  while (*link != job)
+    {
+      previous = *link;
+      link = &(*link)->next;
+    }
+
+  *link = job->next;
+  if (prefetch->last == job)
+    prefetch->last = previous;
+  prefetch->count--;
+
+  if (job->state == prefetch_running)
+    job->abandoned = TRUE;
+  else
+    destroy_prefetch_job(job);
+}
+
+/* Start computing deltas ahead for report B on up to MAX_COUNT files,
+   using a few worker threads.  Return the state in *PREFETCH or NULL if
+   it can't be used for B.  Allocate everything in POOL. */
+static svn_error_t *
+start_prefetch(struct prefetch_t **prefetch,
+               report_baton_t *b,
+               int max_count,
+               apr_pool_t *pool)
+{
+  struct prefetch_t *result;
+  apr_status_t status;
+  int i;
+
+  *prefetch = NULL;
+  if (max_count <= 0 || !b->text_deltas)
+    return SVN_NO_ERROR;
+
+  result = apr_pcalloc(pool, sizeof(*result));
+  SVN_ERR(svn_mutex__init(&result->mutex, TRUE, pool));
+  status = apr_thread_cond_create(&result->cond, pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create condition variable"));
+
+  result->max_count = max_count;
+  result->fs_path = svn_fs_path(b->repos->fs, pool);
+  result->fs_config = svn_fs_config(b->repos->fs, pool);
+  result->t_rev = b->t_rev;
+
+  result->thread_count = MIN(max_count, MAX_PREFETCH_THREADS);
+  result->threads = apr_pcalloc(pool,
+                                result->thread_count
+                                  * sizeof(*result->threads));
+  for (i = 0; i < result->thread_count; i++)
+    {
+      status = apr_thread_create(&result->threads[i], NULL, prefetch_thread,
+                                 result, pool);
+      if (status)
+        result->threads[i] = NULL;
+    }
+
+  *prefetch = result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Terminate the workers of PREFETCH and release all jobs.  Compose any
+   error with ERR and return it. */
+static svn_error_t *
+stop_prefetch(struct prefetch_t *prefetch,
+              svn_error_t *err)
+{
+  int i;
+
+  err = svn_error_compose_create(err, svn_mutex__lock(prefetch->mutex));
+  prefetch->shutdown = TRUE;
+  apr_thread_cond_broadcast(prefetch->cond);
+  err = svn_error_compose_create(err, svn_mutex__unlock(prefetch->mutex,
+                                                        SVN_NO_ERROR));
+
+  for (i = 0; i < prefetch->thread_count; i++)
+    if (prefetch->threads[i])
+      {
+        apr_status_t retval;
+        apr_status_t status = apr_thread_join(&retval, prefetch->threads[i]);
+        if (status)
+          err = svn_error_compose_create(
+                  err, svn_error_wrap_apr(status,
+                                          _("Can't join prefetch thread")));
+      }
+
+  /* No job is running anymore. */
+  while (prefetch->first)
+    drop_prefetch_job(prefetch, prefetch->first);
+
+  return err;
+}
+
+/* Queue the computation of the delta between S_PATH@S_REV and T_PATH in
+   PREFETCH.  Set *QUEUED to FALSE if the queue is full. */
+static svn_error_t *
+queue_prefetch_job(svn_boolean_t *queued,
+                   struct prefetch_t *prefetch,
+                   svn_revnum_t s_rev,
+                   const char *s_path,
+                   const char *t_path)
+{
+  prefetch_job_t *job;
+  apr_pool_t *pool;
+
+  *queued = FALSE;
+  if (prefetch->count >= prefetch->max_count)
+    return SVN_NO_ERROR;
+
+  pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  job = apr_pcalloc(pool, sizeof(*job));
+  job->pool = pool;
+  job->s_rev = s_rev;
+  job->s_path = s_path ? apr_pstrdup(pool, s_path) : NULL;
+  job->t_path = apr_pstrdup(pool, t_path);
+  job->state = prefetch_queued;
+
+  SVN_ERR(svn_mutex__lock(prefetch->mutex));
+  if (prefetch->last)
+    prefetch->last->next = job;
+  else
+    prefetch->first = job;
+  prefetch->last = job;
+  prefetch->count++;
+  apr_thread_cond_broadcast(prefetch->cond);
+  SVN_ERR(svn_mutex__unlock(prefetch->mutex, SVN_NO_ERROR));
+
+  *queued = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Drop all jobs queued in PREFETCH. */
+static svn_error_t *
+discard_prefetch_jobs(struct prefetch_t *prefetch)
+{
+  SVN_ERR(svn_mutex__lock(prefetch->mutex));
+  while (prefetch->first)
+    drop_prefetch_job(prefetch, prefetch->first);
+
+  return svn_error_trace(svn_mutex__unlock(prefetch->mutex, SVN_NO_ERROR));
+}
+
+/* If PREFETCH has computed the delta between S_PATH@S_REV and T_PATH,
+   send it to DHANDLER / DBATON and set *SENT.  Otherwise, set *SENT to
+   FALSE.  Jobs queued before the matching one are dropped because the
+   driver has passed them. */
+static svn_error_t *
+send_prefetched_delta(svn_boolean_t *sent,
+                      struct prefetch_t *prefetch,
+                      svn_revnum_t s_rev,
+                      const char *s_path,
+                      const char *t_path,
+                      svn_txdelta_window_handler_t dhandler,
+                      void *dbaton)
+{
+  prefetch_job_t *job;
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  *sent = FALSE;
+
+  SVN_ERR(svn_mutex__lock(prefetch->mutex));
+  for (job = prefetch->first; job; job = job->next)
+    if (   strcmp(job->t_path, t_path) == 0
+        && (s_path
+            ? job->s_path && job->s_rev == s_rev
+                          && strcmp(job->s_path, s_path) == 0
+            : job->s_path == NULL))
+      break;
+
+  if (job)
+    {
+      while (prefetch->first != job)
+        drop_prefetch_job(prefetch, prefetch->first);
+
+      /* Don't wait for a job that has not been started, yet. */
+      while (!err && job->state == prefetch_running)
+        {
+          apr_status_t status
+            = apr_thread_cond_wait(prefetch->cond,
+                                   svn_mutex__get(prefetch->mutex));
+          if (status)
+            err = svn_error_wrap_apr(status,
+                                     _("Can't wait for condition variable"));
+        }
+
+      /* Take ownership of completed jobs. */
+      if (!err && job->state == prefetch_done)
+        {
+          prefetch->first = job->next;
+          if (prefetch->last == job)
+            prefetch->last = NULL;
+          prefetch->count--;
+        }
+      else
+        {
+          if (!err)
+            drop_prefetch_job(prefetch, job);
+          job = NULL;
+        }
+    }
+
+  SVN_ERR(svn_mutex__unlock(prefetch->mutex, err));
+  if (!job)
+    return SVN_NO_ERROR;
+
+  if (job->windows)
+    {
+      for (i = 0; !err && i < job->windows->nelts; i++)
+        err = dhandler(APR_ARRAY_IDX(job->windows, i, svn_txdelta_window_t *),
+                       dbaton);
+      if (!err)
+        err = dhandler(NULL, dbaton);
+
+      *sent = TRUE;
+    }
+
+  destroy_prefetch_job(job);
+
+  return svn_error_trace(err);
+}
+
+#else
+
+static svn_error_t *
+start_prefetch(struct prefetch_t **prefetch,
+               report_baton_t *b,
+               int max_count,
+               apr_pool_t *pool)
+{
+  *prefetch = NULL;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+stop_prefetch(struct prefetch_t *prefetch,
+              svn_error_t *err)
+{
+  return err;
+}
+
+static svn_error_t *
+queue_prefetch_job(svn_boolean_t *queued,
+                   struct prefetch_t *prefetch,
+                   svn_revnum_t s_rev,
+                   const char *s_path,
+                   const char *t_path)
+{
+  *queued = FALSE;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+discard_prefetch_jobs(struct prefetch_t *prefetch)
+{
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+send_prefetched_delta(svn_boolean_t *sent,
+                      struct prefetch_t *prefetch,
+                      svn_revnum_t s_rev,
+                      const char *s_path,
+                      const char *t_path,
+                      svn_txdelta_window_handler_t dhandler,
+                      void *dbaton)
+{
+  *sent = FALSE;
+  return SVN_NO_ERROR;
+}
+
+#endif /* APR_HAS_THREADS */
+
+
 /* Make the appropriate edits on FILE_BATON to change its contents and
    properties from those in S_REV/S_PATH to those in B->t_root/T_PATH,
    possibly using LOCK_TOKEN to determine if the client's lock on the file
@@ -710,6 +1263,18 @@ delta_files(report_baton_t *b, void *file_baton, svn_revnum_t s_rev,
     {
       if (b->text_deltas)
         {
+          /* A worker thread may have computed the delta already. */
+          if (b->prefetch)
+            {
+              svn_boolean_t sent;
+
+              SVN_ERR(send_prefetched_delta(&sent, b->prefetch, s_rev,
+                                            s_path, t_path, dhandler,
+                                            dbaton));
+              if (sent)
+                return SVN_NO_ERROR;
+            }
+
           /* if we send deltas against empty streams, we may use our
              zero-copy code. */
           if (b->zero_copy_limit > 0 && s_path == NULL)
@@ -732,6 +1297,20 @@ delta_files(report_baton_t *b, void *file_baton, svn_revnum_t s_rev,
                 return SVN_NO_ERROR;
             }
 
+          /* There is nothing to gain from computing a self-delta if the
+             editor is going to apply it right away. */
+          if (b->send_fulltexts && s_path == NULL)
+            {
+              svn_stream_t *contents;
+
+              SVN_ERR(svn_fs_file_contents(&contents, b->t_root, t_path,
+                                           pool));
+              return svn_error_trace(svn_txdelta_send_stream(contents,
+                                                             dhandler,
+                                                             dbaton, NULL,
+                                                             pool));
+            }
+
           SVN_ERR(svn_fs_get_file_delta_stream(&dstream, s_root, s_path,
                                                b->t_root, t_path, pool));
           SVN_ERR(svn_txdelta_send_txstream(dstream, dhandler, dbaton, pool));
@@ -743,6 +1322,16 @@ delta_files(report_baton_t *b, void *file_baton, svn_revnum_t s_rev,
   return SVN_NO_ERROR;
 }
 
+/* Return the key under which B->unchanged_nodes records that node-revs
+   S_ID and T_ID have the same contents, allocated in POOL. */
+static const char *
+node_pair_key(const svn_fs_id_t *s_id, const svn_fs_id_t *t_id,
+              apr_pool_t *pool)
+{
+  return apr_pstrcat(pool, svn_fs_unparse_id(s_id, pool)->data, " ",
+                     svn_fs_unparse_id(t_id, pool)->data, SVN_VA_NULL);
+}
+
 /* Determine if the user is authorized to view B->t_root/PATH. */
 static svn_error_t *
 check_auth(report_baton_t *b, svn_boolean_t *allowed, const char *path,
@@ -970,14 +1559,26 @@ update_entry(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
       if (!b->ignore_ancestry && t_entry->kind == svn_node_file &&
           distance == 1)
         {
-          if (s_root == NULL)
-            SVN_ERR(get_source_root(b, &s_root, s_rev));
-
-          SVN_ERR(svn_fs_props_different(&changed, s_root, s_path,
-                                         b->t_root, t_path, pool));
-          if (!changed)
-            SVN_ERR(svn_fs_contents_different(&changed, s_root, s_path,
-                                              b->t_root, t_path, pool));
+          const char *key = node_pair_key(s_entry->id, t_entry->id, pool);
+
+          if (svn_hash_gets(b->unchanged_nodes, key))
+            {
+              changed = FALSE;
+            }
+          else
+            {
+              if (s_root == NULL)
+                SVN_ERR(get_source_root(b, &s_root, s_rev));
+
+              SVN_ERR(svn_fs_props_different(&changed, s_root, s_path,
+                                             b->t_root, t_path, pool));
+              if (!changed)
+                SVN_ERR(svn_fs_contents_different(&changed, s_root, s_path,
+                                                  b->t_root, t_path, pool));
+              if (!changed)
+                svn_hash_sets(b->unchanged_nodes,
+                              apr_pstrdup(b->pool, key), "");
+            }
         }
 
       if ((distance == 0 || !changed) && !any_path_info(b, e_path)
@@ -1099,6 +1700,107 @@ update_entry(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
 #define DEPTH_BELOW_HERE(depth) ((depth) == svn_depth_immediates) ? \
                                  svn_depth_empty : (depth)
 
+/* Determine how delta_dirs treats the unreported target entry T_ENTRY of
+   a directory whose source is S_PATH with entries S_ENTRIES.  Return
+   FALSE if the entry shall be skipped.  Otherwise, set *S_ENTRY and
+   *S_FULLPATH to the source to compare with, which may be NULL, allocated
+   in POOL.  WC_DEPTH and REQUESTED_DEPTH are as for delta_dirs. */
+static svn_boolean_t
+get_entry_source(const svn_fs_dirent_t **s_entry,
+                 const char **s_fullpath,
+                 const svn_fs_dirent_t *t_entry,
+                 const char *s_path,
+                 apr_hash_t *s_entries,
+                 svn_depth_t wc_depth,
+                 svn_depth_t requested_depth,
+                 apr_pool_t *pool)
+{
+  if (is_depth_upgrade(wc_depth, requested_depth, t_entry->kind))
+    {
+      /* We're making the working copy deeper, pretend the source
+         doesn't exist. */
+      *s_entry = NULL;
+      *s_fullpath = NULL;
+      return TRUE;
+    }
+
+  if (t_entry->kind == svn_node_file
+      && requested_depth == svn_depth_unknown
+      && wc_depth < svn_depth_files)
+    return FALSE;
+
+  if (t_entry->kind == svn_node_dir
+      && (wc_depth < svn_depth_immediates
+          || requested_depth == svn_depth_files))
+    return FALSE;
+
+  /* Look for an entry with the same name in the source dirents. */
+  *s_entry = s_entries ? svn_hash_gets(s_entries, t_entry->name) : NULL;
+  *s_fullpath = *s_entry ? svn_fspath__join(s_path, t_entry->name, pool)
+                         : NULL;
+
+  return TRUE;
+}
+
+/* Queue the computation of text deltas for the files in T_ORDERED_ENTRIES
+   following index CURRENT in B->PREFETCH.  *PREFETCHED is the index of the
+   first entry that has not been considered, yet, and will be updated.
+   T_PATH is the path of the target directory.
+   Stop at the next directory because the editor drive will recurse into
+   it before getting to the files behind it.  The other parameters are
+   as for delta_dirs.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+prefetch_entries(int *prefetched,
+                 report_baton_t *b,
+                 apr_array_header_t *t_ordered_entries,
+                 int current,
+                 svn_revnum_t s_rev,
+                 const char *s_path,
+                 apr_hash_t *s_entries,
+                 const char *t_path,
+                 svn_depth_t wc_depth,
+                 svn_depth_t requested_depth,
+                 apr_pool_t *scratch_pool)
+{
+  int i;
+
+  for (i = MAX(*prefetched, current); i < t_ordered_entries->nelts; i++)
+    {
+      const svn_fs_dirent_t *t_entry
+        = APR_ARRAY_IDX(t_ordered_entries, i, svn_fs_dirent_t *);
+      const svn_fs_dirent_t *s_entry;
+      const char *s_fullpath;
+
+      if (t_entry->kind != svn_node_file)
+        break;
+
+      if (get_entry_source(&s_entry, &s_fullpath, t_entry, s_path,
+                           s_entries, wc_depth, requested_depth,
+                           scratch_pool))
+        {
+          svn_boolean_t queued;
+
+          /* Unchanged files won't get a delta and files replacing other
+             kinds of nodes get added. */
+          if (s_entry && svn_fs_compare_ids(s_entry->id, t_entry->id) == 0)
+            continue;
+          if (s_entry && s_entry->kind != svn_node_file)
+            s_fullpath = NULL;
+
+          SVN_ERR(queue_prefetch_job(&queued, b->prefetch, s_rev,
+                                     s_fullpath,
+                                     svn_fspath__join(t_path, t_entry->name,
+                                                      scratch_pool)));
+          if (!queued)
+            break;
+        }
+    }
+
+  *prefetched = i;
+
+  return SVN_NO_ERROR;
+}
+
 /* Emit edits within directory DIR_BATON (with corresponding path
    E_PATH) with the changes from the directory S_REV/S_PATH to the
    directory B->t_rev/T_PATH.  S_PATH may be NULL if the entry does
@@ -1153,6 +1855,12 @@ update_entry(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
 
    These rules are enforced by the is_depth_upgrade() function and by
    various other checks below.
+
+   If the source and target directories are the same node-rev and the
+   drive does not make the working copy deeper, all entries not touched
+   by the report are unchanged.  We then only process the reported
+   entries, so that the cost of this function is proportional to the
+   report rather than to the size of the directory.
 */
 static svn_error_t *
 delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
@@ -1164,7 +1872,8 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
   apr_hash_index_t *hi;
   apr_pool_t *subpool = svn_pool_create(pool);
   apr_array_header_t *t_ordered_entries = NULL;
-  int i;
+  svn_boolean_t same_node = FALSE;
+  int i, prefetched;
 
   /* Compare the property lists.  If we're starting empty, pass a NULL
      source path so that we add all the properties.
@@ -1178,16 +1887,30 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
       || requested_depth == svn_depth_unknown)
     {
       apr_pool_t *iterpool;
+      svn_fs_root_t *s_root = NULL;
 
-      /* Get the list of entries in each of source and target. */
-      if (s_path && !start_empty)
+      /* Is the source directory the very same node as the target? */
+      if (s_path && !start_empty && requested_depth <= wc_depth)
         {
-          svn_fs_root_t *s_root;
+          const svn_fs_id_t *s_id, *t_id;
 
           SVN_ERR(get_source_root(b, &s_root, s_rev));
-          SVN_ERR(svn_fs_dir_entries(&s_entries, s_root, s_path, subpool));
+          SVN_ERR(svn_fs_node_id(&s_id, s_root, s_path, subpool));
+          SVN_ERR(svn_fs_node_id(&t_id, b->t_root, t_path, subpool));
+          same_node = (svn_fs_compare_ids(s_id, t_id) == 0);
         }
+
+      /* Get the list of entries in each of source and target. */
       SVN_ERR(svn_fs_dir_entries(&t_entries, b->t_root, t_path, subpool));
+      if (same_node)
+        {
+          s_entries = apr_hash_copy(subpool, t_entries);
+        }
+      else if (s_path && !start_empty)
+        {
+          SVN_ERR(get_source_root(b, &s_root, s_rev));
+          SVN_ERR(svn_fs_dir_entries(&s_entries, s_root, s_path, subpool));
+        }
 
       /* Iterate over the report information for this directory. */
       iterpool = svn_pool_create(subpool);
@@ -1260,8 +1983,9 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
         }
 
       /* Remove any deleted entries.  Do this before processing the
-         target, for graceful handling of case-only renames. */
-      if (s_entries)
+         target, for graceful handling of case-only renames.  If the
+         directories are the same node, there is nothing to delete. */
+      if (s_entries && !same_node)
         {
           for (hi = apr_hash_first(subpool, s_entries);
                hi;
@@ -1301,9 +2025,25 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
             }
         }
 
+      /* The unreported entries of an unchanged directory are unchanged
+         as well.  Only those that the report deleted must be sent. */
+      if (same_node)
+        {
+          for (hi = apr_hash_first(subpool, t_entries);
+               hi;
+               hi = apr_hash_next(hi))
+            {
+              const char *name = apr_hash_this_key(hi);
+
+              if (svn_hash_gets(s_entries, name))
+                svn_hash_sets(t_entries, name, NULL);
+            }
+        }
+
       /* Loop over the dirents in the target. */
       SVN_ERR(svn_fs_dir_optimal_order(&t_ordered_entries, b->t_root,
                                        t_entries, subpool, iterpool));
+      prefetched = 0;
       for (i = 0; i < t_ordered_entries->nelts; ++i)
         {
           const svn_fs_dirent_t *t_entry
@@ -1313,31 +2053,16 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
 
           svn_pool_clear(iterpool);
 
-          if (is_depth_upgrade(wc_depth, requested_depth, t_entry->kind))
-            {
-              /* We're making the working copy deeper, pretend the source
-                 doesn't exist. */
-              s_entry = NULL;
-              s_fullpath = NULL;
-            }
-          else
-            {
-              if (t_entry->kind == svn_node_file
-                  && requested_depth == svn_depth_unknown
-                  && wc_depth < svn_depth_files)
-                continue;
-
-              if (t_entry->kind == svn_node_dir
-                  && (wc_depth < svn_depth_immediates
-                      || requested_depth == svn_depth_files))
-                continue;
-
-              /* Look for an entry with the same name in the source dirents. */
-              s_entry = s_entries ?
-                  svn_hash_gets(s_entries, t_entry->name) : NULL;
-              s_fullpath = s_entry ?
-                  svn_fspath__join(s_path, t_entry->name, iterpool) : NULL;
-            }
+          /* Let the workers compute the deltas of the next files. */
+          if (b->prefetch)
+            SVN_ERR(prefetch_entries(&prefetched, b, t_ordered_entries, i,
+                                     s_rev, s_path, s_entries, t_path,
+                                     wc_depth, requested_depth, iterpool));
+
+          if (!get_entry_source(&s_entry, &s_fullpath, t_entry, s_path,
+                                s_entries, wc_depth, requested_depth,
+                                iterpool))
+            continue;
 
           /* Compose the report, editor, and target paths for this entry. */
           e_fullpath = svn_relpath_join(e_path, t_entry->name, iterpool);
@@ -1350,6 +2075,10 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
                                iterpool));
         }
 
+      /* Deltas that the editor drive did not pick up won't be used. */
+      if (b->prefetch)
+        SVN_ERR(discard_prefetch_jobs(b->prefetch));
+
       /* iterpool is destroyed by destroying its parent (subpool) below */
     }
 
@@ -1472,7 +2201,15 @@ finish_report(report_baton_t *b, apr_pool_t *pool)
     b->s_roots[i] = NULL;
 
   {
-    svn_error_t *err = svn_error_trace(drive(b, s_rev, info, pool));
+    svn_error_t *err;
+
+    SVN_ERR(start_prefetch(&b->prefetch, b, b->prefetch_count, pool));
+    err = svn_error_trace(drive(b, s_rev, info, pool));
+    if (b->prefetch)
+      {
+        err = stop_prefetch(b->prefetch, err);
+        b->prefetch = NULL;
+      }
 
     if (err == SVN_NO_ERROR)
       return svn_error_trace(b->editor->close_edit(b->edit_baton, pool));
@@ -1629,13 +2366,35 @@ svn_repos_begin_report3(void **report_baton,
   b->authz_read_func = authz_read_func;
   b->authz_read_baton = authz_read_baton;
   b->revision_infos = apr_hash_make(pool);
+  b->unchanged_nodes = apr_hash_make(pool);
   b->pool = pool;
   b->reader = svn_spillbuf__reader_create(1000 /* blocksize */,
                                           1000000 /* maxsize */,
                                           pool);
   b->repos_uuid = svn_string_create(uuid, pool);
+  b->prefetch_count = 0;
+  b->prefetch = NULL;
+  b->send_fulltexts = FALSE;
 
   /* Hand reporter back to client. */
   *report_baton = b;
   return SVN_NO_ERROR;
 }
+
+void
+svn_repos__report_prefetch_deltas(void *report_baton,
+                                  int count)
+{
+  report_baton_t *b = report_baton;
+
+  b->prefetch_count = count;
+}
+
+void
+svn_repos__report_send_fulltexts(void *report_baton,
+                                 svn_boolean_t send_fulltexts)
+{
+  report_baton_t *b = report_baton;
+
+  b->send_fulltexts = send_fulltexts;
+}
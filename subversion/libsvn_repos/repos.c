@@ -878,6 +878,21 @@ create_conf(svn_repos_t *repos, apr_pool_t *pool)
 "### Unless you specify an absolute path, the file's location is relative"   NL
 "### to the directory containing this file."                                 NL
 "# hooks-env = " SVN_REPOS__CONF_HOOKS_ENV                                   NL
+"### The replay-cache option makes svnserve record the replay of each"       NL
+"### revision in the replay-cache directory of the repository and answer"   NL
+"### later replay requests, e.g. from svnsync, from there.  svnserve must"  NL
+"### be able to write to that directory.  Default is false."                 NL
+"# replay-cache = false"                                                     NL
+"### The location-segments-cache option makes svnserve record the history"  NL
+"### of copy sources in the segments-cache directory of the repository and" NL
+"### reuse it when asked for the location segments of a node, e.g. during"  NL
+"### merges.  svnserve must be able to write to that directory.  Default"   NL
+"### is false."                                                              NL
+"# location-segments-cache = false"                                          NL
+"### The list-jobs option makes svnserve read up to that many directories"   NL
+"### in parallel when listing a tree recursively, e.g. for 'svn ls -R'."     NL
+"### It only takes effect if svnserve runs with --threads.  Default is 1."   NL
+"# list-jobs = 1"                                                            NL
 ""                                                                           NL
 "[sasl]"                                                                     NL
 "### This option specifies whether you want to use the Cyrus SASL"           NL
@@ -26,8 +26,11 @@
 #include <apr_pools.h>
 #include <apr_hash.h>
 
+#include "svn_config.h"
 #include "svn_fs.h"
 
+#include "private/svn_string_private.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -64,6 +67,9 @@ extern "C" {
 #define SVN_REPOS__LOCK_DIR    "locks"      /* Lock files live here. */
 #define SVN_REPOS__HOOK_DIR    "hooks"      /* Hook programs. */
 #define SVN_REPOS__CONF_DIR    "conf"       /* Configuration files. */
+#define SVN_REPOS__REPLAY_CACHE_DIR "replay-cache" /* Recorded replays. */
+#define SVN_REPOS__VERIFY_JOURNAL "verify-journal" /* Verified revisions. */
+#define SVN_REPOS__SEGMENTS_CACHE_DIR "segments-cache" /* Location segments. */
 
 /* Things for which we keep lockfiles. */
 #define SVN_REPOS__DB_LOCKFILE "db.lock" /* Our Berkeley lockfile. */
@@ -382,12 +388,46 @@ svn_repos__authz_read(svn_authz_t **authz_p,
                       svn_boolean_t accept_urls,
                       apr_pool_t *pool);
 
+/* Set *AUTHZ_P to a new authz object for the authz configuration CFG,
+   allocated in RESULT_POOL.  CFG may also be set later but before the
+   first access check.  The rules will be compiled per user on demand.
+
+   If KEY is not NULL, it must uniquely identify the contents of CFG,
+   e.g. by checksum, and the compiled rules will be shared with all other
+   authz objects created with the same KEY through the global membuffer
+   cache.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_repos__authz_create(svn_authz_t **authz_p,
+                        svn_config_t *cfg,
+                        const svn_membuf_t *key,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool);
+
 /* Walk the configuration in AUTHZ looking for any errors. */
 svn_error_t *
 svn_repos__authz_validate(svn_authz_t *authz,
                           apr_pool_t *pool);
 
 
+/*** Location Segments Cache ***/
+
+/* Set *SEGMENTS to all location segments (svn_location_segment_t *) of
+   PATH@PEG_REVISION in REPOS, youngest first and including gaps, as
+   svn_repos_node_location_segments() reports them for the revision range
+   PEG_REVISION:0 without read authz restrictions.  PATH must be absolute.
+
+   Take them from the on-disk cache in REPOS if possible.  Otherwise,
+   determine them and record them in the cache.  Allocate *SEGMENTS in
+   RESULT_POOL and use SCRATCH_POOL for temporaries. */
+svn_error_t *
+svn_repos__get_cached_segments(apr_array_header_t **segments,
+                               svn_repos_t *repos,
+                               const char *path,
+                               svn_revnum_t peg_revision,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool);
+
+
 /*** Utility Functions ***/
 
 /* Set *PREV_PATH and *PREV_REV to the path and revision which
@@ -36,9 +36,12 @@
 #include "svn_sorts.h"
 #include "svn_props.h"
 #include "svn_mergeinfo.h"
+#include "svn_dirent_uri.h"
 #include "repos.h"
+#include "private/svn_cache.h"
 #include "private/svn_fspath.h"
 #include "private/svn_fs_private.h"
+#include "private/svn_repos_private.h"
 #include "private/svn_sorts_private.h"
 
 
@@ -821,18 +824,82 @@ maybe_crop_and_send_segment(svn_location_segment_t *segment,
   return SVN_NO_ERROR;
 }
 
+/* Play back the location segments SEGMENTS, as returned by
+   svn_repos__get_cached_segments(), the same way the walk in
+   node_location_segments() would have reported them for the range
+   START_REV:END_REV.  All other parameters are as for
+   svn_repos_node_location_segments(). */
+static svn_error_t *
+send_cached_segments(const apr_array_header_t *segments,
+                     svn_fs_t *fs,
+                     svn_revnum_t start_rev,
+                     svn_revnum_t end_rev,
+                     svn_location_segment_receiver_t receiver,
+                     void *receiver_baton,
+                     svn_repos_authz_func_t authz_read_func,
+                     void *authz_read_baton,
+                     apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
 
-svn_error_t *
-svn_repos_node_location_segments(svn_repos_t *repos,
-                                 const char *path,
-                                 svn_revnum_t peg_revision,
-                                 svn_revnum_t start_rev,
-                                 svn_revnum_t end_rev,
-                                 svn_location_segment_receiver_t receiver,
-                                 void *receiver_baton,
-                                 svn_repos_authz_func_t authz_read_func,
-                                 void *authz_read_baton,
-                                 apr_pool_t *pool)
+  for (i = 0; i < segments->nelts; ++i)
+    {
+      svn_location_segment_t *segment
+        = APR_ARRAY_IDX(segments, i, svn_location_segment_t *);
+
+      svn_pool_clear(iterpool);
+
+      /* Cropping modifies the segment, so work on a copy. */
+      segment = svn_location_segment_dup(segment, iterpool);
+
+      /* Gaps don't need any authz checks. */
+      if (segment->path)
+        {
+          /* The walk would have stopped before reaching this segment. */
+          if (segment->range_end < end_rev)
+            break;
+
+          if (authz_read_func)
+            {
+              svn_boolean_t readable;
+              svn_fs_root_t *rev_root;
+              const char *abs_path = apr_pstrcat(iterpool, "/",
+                                                 segment->path,
+                                                 SVN_VA_NULL);
+
+              SVN_ERR(svn_fs_revision_root(&rev_root, fs,
+                                           segment->range_end, iterpool));
+              SVN_ERR(authz_read_func(&readable, rev_root, abs_path,
+                                      authz_read_baton, iterpool));
+              if (! readable)
+                break;
+            }
+        }
+
+      SVN_ERR(maybe_crop_and_send_segment(segment, start_rev, end_rev,
+                                          receiver, receiver_baton,
+                                          iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_repos_node_location_segments().  If USE_CACHE is set,
+   take the segments behind the youngest copy from the segments cache. */
+static svn_error_t *
+node_location_segments(svn_repos_t *repos,
+                       const char *path,
+                       svn_revnum_t peg_revision,
+                       svn_revnum_t start_rev,
+                       svn_revnum_t end_rev,
+                       svn_location_segment_receiver_t receiver,
+                       void *receiver_baton,
+                       svn_repos_authz_func_t authz_read_func,
+                       void *authz_read_baton,
+                       svn_boolean_t use_cache,
+                       apr_pool_t *pool)
 {
   svn_fs_t *fs = svn_repos_fs(repos);
   svn_stringbuf_t *current_path;
@@ -967,11 +1034,69 @@ svn_repos_node_location_segments(svn_repos_t *repos,
                                               receiver, receiver_baton,
                                               subpool));
         }
+
+      /* The remainder of the walk is the same as the one starting at
+         the copy source, which other requests will share. */
+      if (use_cache && current_rev >= end_rev)
+        {
+          apr_array_header_t *segments;
+
+          SVN_ERR(svn_repos__get_cached_segments(&segments, repos,
+                                                 current_path->data,
+                                                 current_rev,
+                                                 subpool, subpool));
+          SVN_ERR(send_cached_segments(segments, fs, start_rev, end_rev,
+                                       receiver, receiver_baton,
+                                       authz_read_func, authz_read_baton,
+                                       subpool));
+          break;
+        }
     }
   svn_pool_destroy(subpool);
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_repos_node_location_segments(svn_repos_t *repos,
+                                 const char *path,
+                                 svn_revnum_t peg_revision,
+                                 svn_revnum_t start_rev,
+                                 svn_revnum_t end_rev,
+                                 svn_location_segment_receiver_t receiver,
+                                 void *receiver_baton,
+                                 svn_repos_authz_func_t authz_read_func,
+                                 void *authz_read_baton,
+                                 apr_pool_t *pool)
+{
+  return svn_error_trace(node_location_segments(repos, path, peg_revision,
+                                                start_rev, end_rev,
+                                                receiver, receiver_baton,
+                                                authz_read_func,
+                                                authz_read_baton,
+                                                FALSE, pool));
+}
+
+svn_error_t *
+svn_repos__node_location_segments_cached(
+                               svn_repos_t *repos,
+                               const char *path,
+                               svn_revnum_t peg_revision,
+                               svn_revnum_t start_rev,
+                               svn_revnum_t end_rev,
+                               svn_location_segment_receiver_t receiver,
+                               void *receiver_baton,
+                               svn_repos_authz_func_t authz_read_func,
+                               void *authz_read_baton,
+                               apr_pool_t *pool)
+{
+  return svn_error_trace(node_location_segments(repos, path, peg_revision,
+                                                start_rev, end_rev,
+                                                receiver, receiver_baton,
+                                                authz_read_func,
+                                                authz_read_baton,
+                                                TRUE, pool));
+}
+
 static APR_INLINE svn_boolean_t
 is_path_in_hash(apr_hash_t *duplicate_path_revs,
                 const char *path,
@@ -1107,6 +1232,109 @@ get_merged_mergeinfo(apr_hash_t **merged_mergeinfo,
   return SVN_NO_ERROR;
 }
 
+/* Memoizes the results of get_merged_mergeinfo() across requests. */
+typedef struct merged_mergeinfo_cache_t
+{
+  /* Maps keys to the svn_stringbuf_t * representation of the merged
+     mergeinfo, which is empty if there has been no merge. */
+  svn_cache__t *cache;
+
+  /* Identifies the repository within the keys. */
+  const char *prefix;
+} merged_mergeinfo_cache_t;
+
+/* Set *CACHE to the merged mergeinfo cache for REPOS in the global
+   membuffer cache.  If there is no global cache, set *CACHE to NULL.
+   Allocate the result in POOL. */
+static svn_error_t *
+get_merged_mergeinfo_cache(merged_mergeinfo_cache_t **cache,
+                           svn_repos_t *repos,
+                           apr_pool_t *pool)
+{
+  svn_membuffer_t *membuffer = svn_cache__get_global_membuffer_cache();
+  const char *uuid;
+  const char *repos_abspath;
+
+  *cache = NULL;
+  if (!membuffer)
+    return SVN_NO_ERROR;
+
+  *cache = apr_pcalloc(pool, sizeof(**cache));
+
+  /* Revisions are immutable, so the repository, the revision and the
+     path identify the result.  The length of the repository path keeps
+     it apart from the revision and path. */
+  SVN_ERR(svn_fs_get_uuid(repos->fs, &uuid, pool));
+  SVN_ERR(svn_dirent_get_absolute(&repos_abspath, repos->path, pool));
+  (*cache)->prefix = apr_psprintf(pool, "%s:%" APR_SIZE_T_FMT ":%s:",
+                                  uuid, strlen(repos_abspath),
+                                  repos_abspath);
+
+  /* NULL serializers make the cache store svn_stringbuf_t. */
+  SVN_ERR(svn_cache__create_membuffer_cache(
+            &(*cache)->cache, membuffer, NULL, NULL,
+            APR_HASH_KEY_STRING, "REPOS_MERGED_MERGEINFO",
+            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+            FALSE, FALSE, pool, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Like get_merged_mergeinfo() but take the result from CACHE, if it has
+   been calculated before, and store newly calculated results in CACHE.
+   CACHE may be NULL. */
+static svn_error_t *
+get_merged_mergeinfo_cached(apr_hash_t **merged_mergeinfo,
+                            svn_repos_t *repos,
+                            const merged_mergeinfo_cache_t *cache,
+                            struct path_revision *old_path_rev,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *value;
+  svn_boolean_t found;
+  const char *key;
+
+  if (!cache)
+    return svn_error_trace(get_merged_mergeinfo(merged_mergeinfo, repos,
+                                                old_path_rev, result_pool,
+                                                scratch_pool));
+
+  key = apr_psprintf(scratch_pool, "%s%ld:%s", cache->prefix,
+                     old_path_rev->revnum, old_path_rev->path);
+  SVN_ERR(svn_cache__get((void **)&value, &found, cache->cache, key,
+                         scratch_pool));
+  if (found)
+    {
+      if (value->len)
+        SVN_ERR(svn_mergeinfo_parse(merged_mergeinfo, value->data,
+                                    result_pool));
+      else
+        *merged_mergeinfo = NULL;
+
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(get_merged_mergeinfo(merged_mergeinfo, repos, old_path_rev,
+                               result_pool, scratch_pool));
+  if (*merged_mergeinfo)
+    {
+      svn_string_t *mergeinfo_string;
+
+      SVN_ERR(svn_mergeinfo_to_string(&mergeinfo_string, *merged_mergeinfo,
+                                      scratch_pool));
+      value = svn_stringbuf_create_from_string(mergeinfo_string,
+                                               scratch_pool);
+    }
+  else
+    {
+      value = svn_stringbuf_create_empty(scratch_pool);
+    }
+
+  return svn_error_trace(svn_cache__set(cache->cache, key, value,
+                                        scratch_pool));
+}
+
 static svn_error_t *
 find_interesting_revisions(apr_array_header_t *path_revisions,
                            svn_repos_t *repos,
@@ -1116,6 +1344,7 @@ find_interesting_revisions(apr_array_header_t *path_revisions,
                            svn_boolean_t include_merged_revisions,
                            svn_boolean_t mark_as_merged,
                            apr_hash_t *duplicate_path_revs,
+                           const merged_mergeinfo_cache_t *cache,
                            svn_repos_authz_func_t authz_read_func,
                            void *authz_read_baton,
                            apr_pool_t *result_pool,
@@ -1187,8 +1416,9 @@ find_interesting_revisions(apr_array_header_t *path_revisions,
       APR_ARRAY_PUSH(path_revisions, struct path_revision *) = path_rev;
 
       if (include_merged_revisions)
-        SVN_ERR(get_merged_mergeinfo(&path_rev->merged_mergeinfo, repos,
-                                     path_rev, result_pool, iterpool));
+        SVN_ERR(get_merged_mergeinfo_cached(&path_rev->merged_mergeinfo,
+                                            repos, cache, path_rev,
+                                            result_pool, iterpool));
       else
         path_rev->merged_mergeinfo = NULL;
 
@@ -1234,6 +1464,7 @@ find_merged_revisions(apr_array_header_t **merged_path_revisions_out,
                       const apr_array_header_t *mainline_path_revisions,
                       svn_repos_t *repos,
                       apr_hash_t *duplicate_path_revs,
+                      const merged_mergeinfo_cache_t *cache,
                       svn_repos_authz_func_t authz_read_func,
                       void *authz_read_baton,
                       apr_pool_t *result_pool,
@@ -1307,6 +1538,7 @@ find_merged_revisions(apr_array_header_t **merged_path_revisions_out,
                                                      range->start, range->end,
                                                      TRUE, TRUE,
                                                      duplicate_path_revs,
+                                                     cache,
                                                      authz_read_func,
                                                      authz_read_baton,
                                                      result_pool, iterpool3));
@@ -1620,6 +1852,7 @@ svn_repos_get_file_revs2(svn_repos_t *repos,
 {
   apr_array_header_t *mainline_path_revisions, *merged_path_revisions;
   apr_hash_t *duplicate_path_revs;
+  merged_mergeinfo_cache_t *cache = NULL;
   struct send_baton sb;
   int mainline_pos, merged_pos;
 
@@ -1670,13 +1903,17 @@ svn_repos_get_file_revs2(svn_repos_t *repos,
    * may be needed. */
   sb.include_merged_revisions = include_merged_revisions;
 
+  /* Expanding merges is expensive and its result never changes. */
+  if (include_merged_revisions)
+    SVN_ERR(get_merged_mergeinfo_cache(&cache, repos, scratch_pool));
+
   /* Get the revisions we are interested in. */
   duplicate_path_revs = apr_hash_make(scratch_pool);
   mainline_path_revisions = apr_array_make(scratch_pool, 100,
                                            sizeof(struct path_revision *));
   SVN_ERR(find_interesting_revisions(mainline_path_revisions, repos, path,
                                      start, end, include_merged_revisions,
-                                     FALSE, duplicate_path_revs,
+                                     FALSE, duplicate_path_revs, cache,
                                      authz_read_func, authz_read_baton,
                                      scratch_pool, sb.iterpool));
 
@@ -1684,7 +1921,8 @@ svn_repos_get_file_revs2(svn_repos_t *repos,
   if (include_merged_revisions)
     SVN_ERR(find_merged_revisions(&merged_path_revisions, start,
                                   mainline_path_revisions, repos,
-                                  duplicate_path_revs, authz_read_func,
+                                  duplicate_path_revs, cache,
+                                  authz_read_func,
                                   authz_read_baton,
                                   scratch_pool, sb.iterpool));
   else
@@ -0,0 +1,270 @@
+/* segments_cache.c : on-disk cache of node location segments
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_strings.h>
+
+#include "svn_types.h"
+#include "svn_checksum.h"
+#include "svn_fs.h"
+#include "svn_io.h"
+#include "svn_repos.h"
+#include "svn_pools.h"
+#include "svn_dirent_uri.h"
+#include "svn_private_config.h"
+#include "private/svn_repos_private.h"
+#include "private/svn_skel.h"
+
+#include "repos.h"
+
+
+/*** Overview ***/
+
+/* Merge tracking and blame keep asking for the location segments of the
+   same few lines of history, e.g. of branch roots.  The segments of
+   PATH@PEG_REVISION only depend on committed history, so they never
+   change.  Moreover, once the walk reached the source of the youngest
+   copy, it continues exactly like a walk starting there.  Copy sources
+   are shared by all later revisions of a branch, so we record the full
+   list of segments per copy source and only compute the youngest segment
+   of each request live.
+
+   Recorded lists are neither cropped to a revision range nor filtered by
+   authz.  Both are done when playing them back.
+
+   A cache file contains a single skel:
+     ("location-segments" FORMAT PATH ((START END [SEGMENT-PATH]) ...))
+   where segments without a SEGMENT-PATH are gaps in the history. */
+
+/* Version of the cache file format. */
+#define SEGMENTS_CACHE_FORMAT 1
+
+/* Number of peg revisions per sub-directory of the cache. */
+#define SEGMENTS_CACHE_SHARD_SIZE 1000
+
+
+/* Return the path of the cache file for PATH@PEG_REVISION in REPOS.
+   Allocate it in POOL. */
+static const char *
+cache_file_path(svn_repos_t *repos,
+                const char *path,
+                svn_revnum_t peg_revision,
+                apr_pool_t *pool)
+{
+  svn_checksum_t *checksum;
+
+  svn_error_clear(svn_checksum(&checksum, svn_checksum_sha1, path,
+                               strlen(path), pool));
+
+  return svn_dirent_join_many(pool, repos->path,
+                              SVN_REPOS__SEGMENTS_CACHE_DIR,
+                              apr_psprintf(pool, "%ld",
+                                           peg_revision
+                                             / SEGMENTS_CACHE_SHARD_SIZE),
+                              apr_psprintf(pool, "%ld.%s", peg_revision,
+                                           svn_checksum_to_cstring(checksum,
+                                                                   pool)),
+                              SVN_VA_NULL);
+}
+
+/* Return an error about the corrupt cache file at FILE_PATH. */
+static svn_error_t *
+corrupt_cache_file(const char *file_path,
+                   apr_pool_t *scratch_pool)
+{
+  return svn_error_createf(SVN_ERR_MALFORMED_FILE, NULL,
+                           _("Corrupt location segments cache file '%s'"),
+                           svn_dirent_local_style(file_path, scratch_pool));
+}
+
+/* Parse the revision number atom SKEL into *REV. */
+static svn_error_t *
+parse_rev(svn_revnum_t *rev,
+          const svn_skel_t *skel,
+          apr_pool_t *scratch_pool)
+{
+  apr_int64_t value;
+
+  SVN_ERR(svn_skel__parse_int(&value, skel, scratch_pool));
+  *rev = (svn_revnum_t)value;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *SEGMENTS to the segments recorded for PATH in the cache file at
+   FILE_PATH, or to NULL if there is no such file.  Allocate the result
+   in RESULT_POOL. */
+static svn_error_t *
+read_cache_file(apr_array_header_t **segments,
+                const char *file_path,
+                const char *path,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *contents;
+  svn_skel_t *skel, *item;
+  apr_int64_t format;
+  svn_error_t *err;
+
+  *segments = NULL;
+
+  err = svn_stringbuf_from_file2(&contents, file_path, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  skel = svn_skel__parse(contents->data, contents->len, scratch_pool);
+  if (   skel == NULL
+      || svn_skel__list_length(skel) != 4
+      || !svn_skel__matches_atom(skel->children, "location-segments")
+      || !skel->children->next->is_atom
+      || !skel->children->next->next->is_atom
+      || skel->children->next->next->next->is_atom)
+    return svn_error_trace(corrupt_cache_file(file_path, scratch_pool));
+
+  SVN_ERR(svn_skel__parse_int(&format, skel->children->next, scratch_pool));
+  if (format != SEGMENTS_CACHE_FORMAT)
+    return svn_error_trace(corrupt_cache_file(file_path, scratch_pool));
+
+  /* Guard against hash collisions. */
+  if (!svn_skel__matches_atom(skel->children->next->next, path))
+    return SVN_NO_ERROR;
+
+  *segments = apr_array_make(result_pool, 4,
+                             sizeof(svn_location_segment_t *));
+  for (item = skel->children->next->next->next->children;
+       item;
+       item = item->next)
+    {
+      svn_location_segment_t *segment;
+      int len = svn_skel__list_length(item);
+
+      if (len < 2 || len > 3)
+        return svn_error_trace(corrupt_cache_file(file_path, scratch_pool));
+
+      segment = apr_pcalloc(result_pool, sizeof(*segment));
+      SVN_ERR(parse_rev(&segment->range_start, item->children,
+                        scratch_pool));
+      SVN_ERR(parse_rev(&segment->range_end, item->children->next,
+                        scratch_pool));
+      if (len == 3)
+        segment->path = apr_pstrmemdup(result_pool,
+                                       item->children->next->next->data,
+                                       item->children->next->next->len);
+
+      APR_ARRAY_PUSH(*segments, svn_location_segment_t *) = segment;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Atomically write SEGMENTS of PATH to the cache file at FILE_PATH. */
+static svn_error_t *
+write_cache_file(const char *file_path,
+                 const char *path,
+                 const apr_array_header_t *segments,
+                 apr_pool_t *scratch_pool)
+{
+  svn_skel_t *skel = svn_skel__make_empty_list(scratch_pool);
+  svn_skel_t *list = svn_skel__make_empty_list(scratch_pool);
+  svn_stringbuf_t *contents;
+  int i;
+
+  for (i = segments->nelts - 1; i >= 0; --i)
+    {
+      const svn_location_segment_t *segment
+        = APR_ARRAY_IDX(segments, i, const svn_location_segment_t *);
+      svn_skel_t *item = svn_skel__make_empty_list(scratch_pool);
+
+      if (segment->path)
+        svn_skel__prepend_str(segment->path, item, scratch_pool);
+      svn_skel__prepend_int(segment->range_end, item, scratch_pool);
+      svn_skel__prepend_int(segment->range_start, item, scratch_pool);
+      svn_skel__prepend(item, list);
+    }
+
+  svn_skel__prepend(list, skel);
+  svn_skel__prepend_str(path, skel, scratch_pool);
+  svn_skel__prepend_int(SEGMENTS_CACHE_FORMAT, skel, scratch_pool);
+  svn_skel__prepend_str("location-segments", skel, scratch_pool);
+  contents = svn_skel__unparse(skel, scratch_pool);
+
+  SVN_ERR(svn_io_make_dir_recursively(svn_dirent_dirname(file_path,
+                                                         scratch_pool),
+                                      scratch_pool));
+
+  return svn_error_trace(svn_io_write_atomic2(file_path, contents->data,
+                                              contents->len, NULL, FALSE,
+                                              scratch_pool));
+}
+
+/* Implements svn_location_segment_receiver_t.  Append a copy of SEGMENT
+   to BATON, an array of svn_location_segment_t *. */
+static svn_error_t *
+collect_segment(svn_location_segment_t *segment,
+                void *baton,
+                apr_pool_t *pool)
+{
+  apr_array_header_t *segments = baton;
+
+  APR_ARRAY_PUSH(segments, svn_location_segment_t *)
+    = svn_location_segment_dup(segment, segments->pool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__get_cached_segments(apr_array_header_t **segments,
+                               svn_repos_t *repos,
+                               const char *path,
+                               svn_revnum_t peg_revision,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool)
+{
+  const char *file_path = cache_file_path(repos, path, peg_revision,
+                                          scratch_pool);
+  svn_error_t *err;
+
+  /* Problems with the cache are no reason to fail the request. */
+  err = read_cache_file(segments, file_path, path, result_pool,
+                        scratch_pool);
+  if (!err && *segments)
+    return SVN_NO_ERROR;
+
+  svn_error_clear(err);
+
+  *segments = apr_array_make(result_pool, 4,
+                             sizeof(svn_location_segment_t *));
+  SVN_ERR(svn_repos__node_location_segments_cached(repos, path,
+                                                   peg_revision,
+                                                   peg_revision, 0,
+                                                   collect_segment,
+                                                   *segments, NULL, NULL,
+                                                   scratch_pool));
+
+  svn_error_clear(write_cache_file(file_path, path, *segments,
+                                   scratch_pool));
+
+  return SVN_NO_ERROR;
+}
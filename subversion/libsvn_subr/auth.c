@@ -37,6 +37,7 @@
 #include "svn_version.h"
 #include "private/svn_auth_private.h"
 #include "private/svn_dep_compat.h"
+#include "private/svn_mutex.h"
 
 #include "auth.h"
 
@@ -113,6 +114,11 @@ struct svn_auth_baton_t
 
   /* run-time credentials cache. */
   apr_hash_t *creds_cache;
+
+  /* serializes access to CREDS_CACHE and to the providers, which
+     allocate in POOL.  Shared with all session batons made from this
+     one.  May be NULL. */
+  svn_mutex__t *mutex;
 };
 
 /* Abstracted iteration baton */
@@ -147,6 +153,10 @@ svn_auth_open(svn_auth_baton_t **auth_baton,
   ab->creds_cache = apr_hash_make(pool);
   ab->pool = pool;
 
+  /* Without a mutex, the baton simply must not be shared between
+     threads. */
+  svn_error_clear(svn_mutex__init(&ab->mutex, TRUE, pool));
+
   /* Register each provider in order.  Providers of different
      credentials will be automatically sorted into different tables by
      register_provider(). */
@@ -223,13 +233,15 @@ make_cache_key(const char *cred_kind,
   return apr_pstrcat(pool, cred_kind, ":", realmstring, SVN_VA_NULL);
 }
 
-svn_error_t *
-svn_auth_first_credentials(void **credentials,
-                           svn_auth_iterstate_t **state,
-                           const char *cred_kind,
-                           const char *realmstring,
-                           svn_auth_baton_t *auth_baton,
-                           apr_pool_t *pool)
+/* Implement svn_auth_first_credentials() while holding the mutex of
+   AUTH_BATON. */
+static svn_error_t *
+first_credentials(void **credentials,
+                  svn_auth_iterstate_t **state,
+                  const char *cred_kind,
+                  const char *realmstring,
+                  svn_auth_baton_t *auth_baton,
+                  apr_pool_t *pool)
 {
   int i = 0;
   provider_set_t *table;
@@ -241,10 +253,6 @@ svn_auth_first_credentials(void **credentials,
   const char *cache_key;
   apr_hash_t *parameters;
 
-  if (! auth_baton)
-    return svn_error_create(SVN_ERR_AUTHN_NO_PROVIDER, NULL,
-                            _("No authentication providers registered"));
-
   /* Get the appropriate table of providers for CRED_KIND. */
   table = svn_hash_gets(auth_baton->tables, cred_kind);
   if (! table)
@@ -330,11 +338,32 @@ svn_auth_first_credentials(void **credentials,
   return SVN_NO_ERROR;
 }
 
-
 svn_error_t *
-svn_auth_next_credentials(void **credentials,
-                          svn_auth_iterstate_t *state,
-                          apr_pool_t *pool)
+svn_auth_first_credentials(void **credentials,
+                           svn_auth_iterstate_t **state,
+                           const char *cred_kind,
+                           const char *realmstring,
+                           svn_auth_baton_t *auth_baton,
+                           apr_pool_t *pool)
+{
+  if (! auth_baton)
+    return svn_error_create(SVN_ERR_AUTHN_NO_PROVIDER, NULL,
+                            _("No authentication providers registered"));
+
+  SVN_MUTEX__WITH_LOCK(auth_baton->mutex,
+                       first_credentials(credentials, state, cred_kind,
+                                         realmstring, auth_baton, pool));
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Implement svn_auth_next_credentials() while holding the mutex of the
+   auth baton of STATE. */
+static svn_error_t *
+next_credentials(void **credentials,
+                 svn_auth_iterstate_t *state,
+                 apr_pool_t *pool)
 {
   svn_auth_baton_t *auth_baton = state->auth_baton;
   svn_auth_provider_object_t *provider;
@@ -384,10 +413,23 @@ svn_auth_next_credentials(void **credentials,
   return SVN_NO_ERROR;
 }
 
-
 svn_error_t *
-svn_auth_save_credentials(svn_auth_iterstate_t *state,
+svn_auth_next_credentials(void **credentials,
+                          svn_auth_iterstate_t *state,
                           apr_pool_t *pool)
+{
+  SVN_MUTEX__WITH_LOCK(state->auth_baton->mutex,
+                       next_credentials(credentials, state, pool));
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Implement svn_auth_save_credentials() while holding the mutex of the
+   auth baton of STATE. */
+static svn_error_t *
+save_credentials(svn_auth_iterstate_t *state,
+                 apr_pool_t *pool)
 {
   int i;
   svn_auth_provider_object_t *provider;
@@ -395,9 +437,6 @@ svn_auth_save_credentials(svn_auth_iterstate_t *state,
   const char *no_auth_cache;
   void *creds;
 
-  if (! state || state->table->providers->nelts <= state->provider_idx)
-    return SVN_NO_ERROR;
-
   creds = svn_hash_gets(state->auth_baton->creds_cache, state->cache_key);
   if (! creds)
     return SVN_NO_ERROR;
@@ -446,6 +485,19 @@ svn_auth_save_credentials(svn_auth_iterstate_t *state,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_auth_save_credentials(svn_auth_iterstate_t *state,
+                          apr_pool_t *pool)
+{
+  if (! state || state->table->providers->nelts <= state->provider_idx)
+    return SVN_NO_ERROR;
+
+  SVN_MUTEX__WITH_LOCK(state->auth_baton->mutex,
+                       save_credentials(state, pool));
+
+  return SVN_NO_ERROR;
+}
+
 
 svn_error_t *
 svn_auth_forget_credentials(svn_auth_baton_t *auth_baton,
@@ -455,6 +507,8 @@ svn_auth_forget_credentials(svn_auth_baton_t *auth_baton,
 {
   SVN_ERR_ASSERT((cred_kind && realmstring) || (!cred_kind && !realmstring));
 
+  SVN_ERR(svn_mutex__lock(auth_baton->mutex));
+
   /* If we have a CRED_KIND and REALMSTRING, we clear out just the
      cached item (if any).  Otherwise, empty the whole hash. */
   if (cred_kind)
@@ -468,6 +522,8 @@ svn_auth_forget_credentials(svn_auth_baton_t *auth_baton,
       apr_hash_clear(auth_baton->creds_cache);
     }
 
+  SVN_ERR(svn_mutex__unlock(auth_baton->mutex, SVN_NO_ERROR));
+
   return SVN_NO_ERROR;
 }
 
@@ -35,6 +35,24 @@
 #include "svn_base64.h"
 #include "private/svn_string_private.h"
 #include "private/svn_subr_private.h"
+#include "private/svn_atomic.h"
+
+/* Compile-time selection of the vectorized line codecs.  As for the UTF-8
+ * validator, the x86 variants use function-specific target attributes
+ * such that they can be built with default compiler flags; the CPU
+ * features are checked at runtime.  NEON is part of the base AArch64 ISA.
+ */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) \
+    && (__GNUC__ >= 5 || defined(__clang__))
+#  define BASE64_X86 1
+#  include <cpuid.h>
+#  include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#  define BASE64_NEON 1
+#  include <arm_neon.h>
+#endif
 
 /* When asked to format the base64-encoded output as multiple lines,
    we put this many chars in each line (plus one new line char) unless
@@ -50,6 +68,329 @@
 static const char base64tab[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ" \
                                 "abcdefghijklmnopqrstuvwxyz0123456789+/";
 
+/* Lookup table for base64 characters; reverse_base64[ch] gives a
+   negative value if ch is not a valid base64 character, or otherwise
+   the value of the byte represented; 'A' => 0 etc. */
+static const signed char reverse_base64[256] = {
+-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 62, -1, -1, -1, 63,
+52, 53, 54, 55, 56, 57, 58, 59, 60, 61, -1, -1, -1, -1, -1, -1,
+-1,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, -1,
+-1, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, -1, -1, -1, -1, -1,
+-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
+
+/* Vectorized line codecs */
+
+/* The kernels below process the leading part of a full line, i.e. of
+   BYTES_PER_LINE input bytes when encoding and of BASE64_LINELEN chars
+   when decoding.  They return how much of the input they consumed; the
+   scalar code takes care of the rest.  Line breaks are not their
+   concern, so the output is exactly the same as without them. */
+
+/* Encode the leading part of the BYTES_PER_LINE bytes at IN into OUT.
+   Return the number of bytes consumed, a multiple of 3. */
+typedef apr_size_t (*encode_kernel_t)(char *out, const unsigned char *in);
+
+/* Decode the leading part of the BASE64_LINELEN chars at IN into OUT,
+   stopping before the first block that contains anything but base64
+   chars.  Return the number of chars consumed, a multiple of 4. */
+typedef apr_size_t (*decode_kernel_t)(char *out, const unsigned char *in);
+
+#ifdef BASE64_X86
+
+#define BASE64_AVX2_TARGET __attribute__((target("avx2")))
+
+/* Split the first 12 bytes of each 128 bit lane of IN into four 6 bit
+   values per 3 bytes, each in the low bits of a separate byte. */
+BASE64_AVX2_TARGET static __m256i
+encode_reshuffle_avx2(__m256i in)
+{
+  __m256i t0, t1, t2, t3;
+
+  in = _mm256_shuffle_epi8(in, _mm256_setr_epi8(
+         1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+         1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+
+  t0 = _mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00));
+  t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+  t2 = _mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0));
+  t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+
+  return _mm256_or_si256(t1, t3);
+}
+
+/* Map the 6 bit values in IN to base64tab chars.  The alphabet consists
+   of five ranges, each of which needs a constant offset. */
+BASE64_AVX2_TARGET static __m256i
+encode_translate_avx2(__m256i in)
+{
+  const __m256i offsets = _mm256_setr_epi8(
+         65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0,
+         65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0);
+
+  /* 0 for 'A'..'Z', 1 for 'a'..'z', 2..11 for digits, 12 for '+' and
+     13 for '/'. */
+  __m256i index = _mm256_subs_epu8(in, _mm256_set1_epi8(51));
+  index = _mm256_sub_epi8(index,
+                          _mm256_cmpgt_epi8(in, _mm256_set1_epi8(25)));
+
+  return _mm256_add_epi8(in, _mm256_shuffle_epi8(offsets, index));
+}
+
+/* AVX2 implementation of encode_kernel_t.  Encodes 24 bytes per step. */
+BASE64_AVX2_TARGET static apr_size_t
+encode_kernel_avx2(char *out, const unsigned char *in)
+{
+  apr_size_t i;
+
+  /* Each lane loads 16 bytes but uses only 12 of them. */
+  for (i = 0; i + 28 <= BYTES_PER_LINE; i += 24, out += 32)
+    {
+      __m256i data = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)(in + i))),
+        _mm_loadu_si128((const __m128i *)(in + i + 12)), 1);
+
+      data = encode_translate_avx2(encode_reshuffle_avx2(data));
+      _mm256_storeu_si256((__m256i *)out, data);
+    }
+
+  return i;
+}
+
+/* AVX2 implementation of decode_kernel_t.  Decodes 32 chars per step. */
+BASE64_AVX2_TARGET static apr_size_t
+decode_kernel_avx2(char *out, const unsigned char *in)
+{
+  /* Valid chars have no bit in common between the entries for their
+     low and their high nibble. */
+  const __m256i lo_table = _mm256_setr_epi8(
+         0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+         0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a,
+         0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+         0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+  const __m256i hi_table = _mm256_setr_epi8(
+         0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+         0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+         0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+         0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+
+  /* Offsets to get from the chars to their values, indexed by the high
+     nibble; '/' shares its nibble with '+' and uses index 1 instead. */
+  const __m256i offsets = _mm256_setr_epi8(
+         0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+         0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m256i slash = _mm256_set1_epi8(0x2f);
+  apr_size_t i;
+
+  for (i = 0; i + 32 <= BASE64_LINELEN; i += 32, out += 24)
+    {
+      __m256i data = _mm256_loadu_si256((const __m256i *)(in + i));
+      __m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(data, 4),
+                                            slash);
+      __m256i lo_nibbles = _mm256_and_si256(data, slash);
+      __m256i hi = _mm256_shuffle_epi8(hi_table, hi_nibbles);
+      __m256i lo = _mm256_shuffle_epi8(lo_table, lo_nibbles);
+      __m256i is_slash = _mm256_cmpeq_epi8(data, slash);
+
+      if (!_mm256_testz_si256(lo, hi))
+        break;
+
+      data = _mm256_add_epi8(data, _mm256_shuffle_epi8(
+                                     offsets,
+                                     _mm256_add_epi8(is_slash, hi_nibbles)));
+
+      /* Pack 4 x 6 bits into 3 bytes, then compact them to the low 24
+         bytes of the register. */
+      data = _mm256_maddubs_epi16(data, _mm256_set1_epi32(0x01400140));
+      data = _mm256_madd_epi16(data, _mm256_set1_epi32(0x00011000));
+      data = _mm256_shuffle_epi8(data, _mm256_setr_epi8(
+               2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+               2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+      data = _mm256_permutevar8x32_epi32(data,
+                                         _mm256_setr_epi32(0, 1, 2, 4, 5, 6,
+                                                           -1, -1));
+
+      _mm_storeu_si128((__m128i *)out, _mm256_castsi256_si128(data));
+      _mm_storel_epi64((__m128i *)(out + 16),
+                       _mm256_extracti128_si256(data, 1));
+    }
+
+  return i;
+}
+
+/* Return TRUE if the CPU and the OS support AVX2.
+ */
+static svn_boolean_t
+have_x86_avx2(void)
+{
+  unsigned int eax, ebx, ecx, edx;
+  unsigned int xcr0_lo, xcr0_hi;
+
+  if (__get_cpuid_max(0, NULL) < 7)
+    return FALSE;
+
+  /* The OS must save the YMM registers across context switches. */
+  __cpuid(1, eax, ebx, ecx, edx);
+  if (!(ecx & bit_OSXSAVE) || !(ecx & bit_AVX))
+    return FALSE;
+
+  __asm__ ("xgetbv" : "=a" (xcr0_lo), "=d" (xcr0_hi) : "c" (0));
+  if ((xcr0_lo & 6) != 6)
+    return FALSE;
+
+  __cpuid_count(7, 0, eax, ebx, ecx, edx);
+  return (ebx & bit_AVX2) != 0;
+}
+
+#endif /* BASE64_X86 */
+
+#ifdef BASE64_NEON
+
+/* Load the 64 byte TABLE into a table register set. */
+static uint8x16x4_t
+load_table_neon(const void *table)
+{
+  const uint8_t *p = table;
+  uint8x16x4_t result;
+
+  result.val[0] = vld1q_u8(p);
+  result.val[1] = vld1q_u8(p + 16);
+  result.val[2] = vld1q_u8(p + 32);
+  result.val[3] = vld1q_u8(p + 48);
+
+  return result;
+}
+
+/* NEON implementation of encode_kernel_t.  Encodes 48 bytes per step. */
+static apr_size_t
+encode_kernel_neon(char *out, const unsigned char *in)
+{
+  const uint8x16x4_t table = load_table_neon(base64tab);
+  apr_size_t i;
+
+  for (i = 0; i + 48 <= BYTES_PER_LINE; i += 48, out += 64)
+    {
+      uint8x16x3_t data = vld3q_u8(in + i);
+      uint8x16x4_t values;
+
+      values.val[0] = vshrq_n_u8(data.val[0], 2);
+      values.val[1] = vorrq_u8(vshrq_n_u8(data.val[1], 4),
+                               vandq_u8(vshlq_n_u8(data.val[0], 4),
+                                        vdupq_n_u8(0x30)));
+      values.val[2] = vorrq_u8(vshrq_n_u8(data.val[2], 6),
+                               vandq_u8(vshlq_n_u8(data.val[1], 2),
+                                        vdupq_n_u8(0x3c)));
+      values.val[3] = vandq_u8(data.val[2], vdupq_n_u8(0x3f));
+
+      values.val[0] = vqtbl4q_u8(table, values.val[0]);
+      values.val[1] = vqtbl4q_u8(table, values.val[1]);
+      values.val[2] = vqtbl4q_u8(table, values.val[2]);
+      values.val[3] = vqtbl4q_u8(table, values.val[3]);
+
+      vst4q_u8((uint8_t *)out, values);
+    }
+
+  return i;
+}
+
+/* Translate the chars in DATA to their 6 bit values using the lower and
+   upper half of the ASCII part of reverse_base64 in LOWER and UPPER.
+   Invalid chars get the top bit set. */
+static uint8x16_t
+decode_translate_neon(uint8x16_t data,
+                      uint8x16x4_t lower,
+                      uint8x16x4_t upper)
+{
+  uint8x16_t result = vqtbl4q_u8(lower, data);
+  result = vqtbx4q_u8(result, upper, vsubq_u8(data, vdupq_n_u8(64)));
+
+  /* Non-ASCII chars are out of range for both tables. */
+  return vorrq_u8(result, vandq_u8(data, vdupq_n_u8(0x80)));
+}
+
+/* NEON implementation of decode_kernel_t.  Decodes 64 chars per step. */
+static apr_size_t
+decode_kernel_neon(char *out, const unsigned char *in)
+{
+  const uint8x16x4_t lower = load_table_neon(reverse_base64);
+  const uint8x16x4_t upper = load_table_neon(reverse_base64 + 64);
+  apr_size_t i;
+
+  for (i = 0; i + 64 <= BASE64_LINELEN; i += 64, out += 48)
+    {
+      uint8x16x4_t data = vld4q_u8(in + i);
+      uint8x16x3_t result;
+
+      data.val[0] = decode_translate_neon(data.val[0], lower, upper);
+      data.val[1] = decode_translate_neon(data.val[1], lower, upper);
+      data.val[2] = decode_translate_neon(data.val[2], lower, upper);
+      data.val[3] = decode_translate_neon(data.val[3], lower, upper);
+
+      if (vmaxvq_u8(vorrq_u8(vorrq_u8(data.val[0], data.val[1]),
+                             vorrq_u8(data.val[2], data.val[3]))) & 0x80)
+        break;
+
+      result.val[0] = vorrq_u8(vshlq_n_u8(data.val[0], 2),
+                               vshrq_n_u8(data.val[1], 4));
+      result.val[1] = vorrq_u8(vshlq_n_u8(data.val[1], 4),
+                               vshrq_n_u8(data.val[2], 2));
+      result.val[2] = vorrq_u8(vshlq_n_u8(data.val[2], 6), data.val[3]);
+
+      vst3q_u8((uint8_t *)out, result);
+    }
+
+  return i;
+}
+
+#endif /* BASE64_NEON */
+
+/* The vectorized codecs selected for the current CPU or NULL. */
+static encode_kernel_t encode_kernel = NULL;
+static decode_kernel_t decode_kernel = NULL;
+
+/* Implements svn_atomic__str_init_func_t.
+ * Pick the fastest codecs supported by the current CPU.
+ */
+static const char *
+select_implementation(void *baton)
+{
+#ifdef BASE64_X86
+  if (have_x86_avx2())
+    {
+      encode_kernel = encode_kernel_avx2;
+      decode_kernel = decode_kernel_avx2;
+    }
+#endif
+#ifdef BASE64_NEON
+  encode_kernel = encode_kernel_neon;
+  decode_kernel = decode_kernel_neon;
+#endif
+
+  return NULL;
+}
+
+/* Make sure the codecs have been selected.
+ */
+static void
+init_implementation(void)
+{
+  static volatile svn_atomic_t init_state = 0;
+  (void)svn_atomic__init_once_no_error(&init_state, select_implementation,
+                                       NULL);
+}
+
 
 /* Binary input --> base64-encoded output */
 
@@ -101,6 +442,15 @@ encode_line(svn_stringbuf_t *str, const char *data)
   char *out = str->data + str->len;
   char *end = out + BASE64_LINELEN;
 
+  /* Let the vector unit do the bulk of the work, if available. */
+  init_implementation();
+  if (encode_kernel)
+    {
+      apr_size_t consumed = encode_kernel(out, in);
+      in += consumed;
+      out += consumed / 3 * 4;
+    }
+
   /* We assume that BYTES_PER_LINE is a multiple of 3 and BASE64_LINELEN
      a multiple of 4. */
   for ( ; out != end; in += 3, out += 4)
@@ -317,28 +667,6 @@ decode_group(const unsigned char *in, char *out)
   out[2] = (char)(((in[2] & 0x3) << 6) | in[3]);
 }
 
-/* Lookup table for base64 characters; reverse_base64[ch] gives a
-   negative value if ch is not a valid base64 character, or otherwise
-   the value of the byte represented; 'A' => 0 etc. */
-static const signed char reverse_base64[256] = {
--1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
--1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
--1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 62, -1, -1, -1, 63,
-52, 53, 54, 55, 56, 57, 58, 59, 60, 61, -1, -1, -1, -1, -1, -1,
--1,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
-15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, -1,
--1, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
-41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, -1, -1, -1, -1, -1,
--1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
--1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
--1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
--1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
--1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
--1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
--1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
--1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
-};
-
 /* Similar to decode_group but this function also translates the
    6-bit values from the IN buffer before translating them.
    Return FALSE if a non-base64 char (e.g. '=' or new line)
@@ -379,6 +707,16 @@ decode_line(svn_stringbuf_t *str, const char **data)
   char *out = str->data + str->len;
   char *end = out + BYTES_PER_LINE;
 
+  /* Let the vector unit do the bulk of the work, if available.  It stops
+     before any special char and leaves that to the code below. */
+  init_implementation();
+  if (decode_kernel)
+    {
+      apr_size_t consumed = decode_kernel(out, p);
+      p += consumed;
+      out += consumed / 4 * 3;
+    }
+
   /* We assume that BYTES_PER_LINE is a multiple of 3 and BASE64_LINELEN
      a multiple of 4.  Stop translation as soon as we encounter a special
      char.  Leave the entire group untouched in that case. */
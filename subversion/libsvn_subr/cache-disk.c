@@ -0,0 +1,828 @@
+/*
+ * cache-disk.c: persistent second cache tier in a local directory
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include <apr_md5.h>
+
+#include "svn_pools.h"
+#include "svn_checksum.h"
+#include "svn_ctype.h"
+#include "svn_dirent_uri.h"
+#include "svn_hash.h"
+#include "svn_io.h"
+#include "svn_sorts.h"
+
+#include "svn_private_config.h"
+#include "private/svn_atomic.h"
+#include "private/svn_cache.h"
+#include "private/svn_mutex.h"
+#include "private/svn_sorts_private.h"
+#include "private/svn_subr_private.h"
+
+#include "cache.h"
+
+/* The disk tier stores every item in a file of its own.  The file name is
+ * the hex MD5 of the cache prefix and the item key, so caches using the
+ * same prefix will find the same data even after a process restart.
+ *
+ * Every file starts with a small header containing the FNV-1a checksum
+ * of the serialized item.  Files are written to a temporary name and then
+ * renamed into place but never fsync'ed; a file that has been damaged
+ * by a system crash simply reads as a cache miss.
+ *
+ * All caches using the same directory share one disk_store_t.  It tracks
+ * the files in LRU order and removes the least recently used ones when
+ * their total size exceeds the configured limit.  Since every process has
+ * its own disk_store_t, the limit is enforced per process.
+ *
+ * Errors accessing the disk tier are never reported to the caller.  The
+ * data can always be reconstructed and a full or failing disk should not
+ * take the server down with it.
+ */
+
+/* Size of the file header.  Keep the serialized data that follows it
+ * aligned to pointer size in memory. */
+#define HEADER_SIZE 8
+
+/* Length of the hex MD5 file names. */
+#define NAME_LEN (2 * APR_MD5_DIGESTSIZE)
+
+/* Only cache items up to this fraction of the store size. */
+#define MAX_ITEM_SIZE_RATIO 16
+
+/* A file in the disk_store_t LRU list.
+ */
+typedef struct disk_entry_t
+{
+  /* The file name, i.e. the hex MD5 of prefix and key. */
+  char name[NAME_LEN + 1];
+
+  /* Size of the file in bytes. */
+  apr_uint64_t size;
+
+  /* Neighbours in the LRU list. */
+  struct disk_entry_t *older;
+  struct disk_entry_t *newer;
+} disk_entry_t;
+
+/* A directory of cache files, shared by all caches using it.
+ */
+typedef struct disk_store_t
+{
+  /* Absolute path of the directory holding the cache files. */
+  const char *directory;
+
+  /* Remove files once their total size exceeds this many bytes. */
+  apr_uint64_t max_size;
+
+  /* Total size of all files in ENTRIES. */
+  apr_uint64_t used_size;
+
+  /* const char * file name -> disk_entry_t *. */
+  apr_hash_t *entries;
+
+  /* Ends of the LRU list. */
+  disk_entry_t *oldest;
+  disk_entry_t *newest;
+
+  /* Entries removed from the list, available for re-use. */
+  disk_entry_t *unused;
+
+  /* Serializes all access to this structure. */
+  svn_mutex__t *mutex;
+
+  /* Lives as long as the process. */
+  apr_pool_t *pool;
+} disk_store_t;
+
+/* The disk tier cache instance.
+ */
+typedef struct disk_cache_t
+{
+  /* The first (memory) tier. */
+  svn_cache__t *first;
+
+  /* Where the second tier's files live. */
+  disk_store_t *store;
+
+  /* Serializer / deserializer for the cached values. */
+  svn_cache__serialize_func_t serializer;
+  svn_cache__deserialize_func_t deserializer;
+
+  /* Key length and prefix, as passed to svn_cache__create_disk_tier(). */
+  apr_ssize_t klen;
+  const char *prefix;
+} disk_cache_t;
+
+/* Process-wide directory -> disk_store_t map.
+ */
+typedef struct store_registry_t
+{
+  /* Serializes access to STORES. */
+  svn_mutex__t *mutex;
+
+  /* const char * directory -> disk_store_t *.  Allocated in POOL. */
+  apr_hash_t *stores;
+  apr_pool_t *pool;
+} store_registry_t;
+
+/* Initialization state of REGISTRY. */
+static volatile svn_atomic_t registry_init_state = 0;
+
+/* The registry of all disk stores. */
+static store_registry_t *registry = NULL;
+
+/* Implements svn_atomic__err_init_func_t.  Create REGISTRY. */
+static svn_error_t *
+init_registry(void *baton,
+              apr_pool_t *unused_pool)
+{
+  /* The registry lives as long as the process. */
+  apr_pool_t *pool = svn_pool_create(NULL);
+  store_registry_t *result = apr_pcalloc(pool, sizeof(*result));
+
+  SVN_ERR(svn_mutex__init(&result->mutex, TRUE, pool));
+  result->stores = apr_hash_make(pool);
+  result->pool = pool;
+
+  registry = result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Unlink ENTRY from the LRU list of STORE. */
+static void
+unlink_entry(disk_store_t *store,
+             disk_entry_t *entry)
+{
+  if (entry->older)
+    entry->older->newer = entry->newer;
+  else
+    store->oldest = entry->newer;
+
+  if (entry->newer)
+    entry->newer->older = entry->older;
+  else
+    store->newest = entry->older;
+
+  entry->older = NULL;
+  entry->newer = NULL;
+}
+
+/* Append ENTRY as the most recently used one to STORE's LRU list. */
+static void
+append_entry(disk_store_t *store,
+             disk_entry_t *entry)
+{
+  entry->older = store->newest;
+  entry->newer = NULL;
+
+  if (store->newest)
+    store->newest->newer = entry;
+  else
+    store->oldest = entry;
+
+  store->newest = entry;
+}
+
+/* Remove ENTRY from STORE and put it into the list of unused entries. */
+static void
+drop_entry(disk_store_t *store,
+           disk_entry_t *entry)
+{
+  unlink_entry(store, entry);
+  svn_hash_sets(store->entries, entry->name, NULL);
+  store->used_size -= entry->size;
+
+  entry->newer = store->unused;
+  store->unused = entry;
+}
+
+/* Record the file NAME of SIZE bytes as the most recently used one in
+ * STORE.  Then, append the names of all files that need to be removed to
+ * keep STORE within its size limit to VICTIMS.  The caller must hold
+ * STORE->MUTEX. */
+static svn_error_t *
+touch_entry(disk_store_t *store,
+            const char *name,
+            apr_uint64_t size,
+            apr_array_header_t *victims)
+{
+  disk_entry_t *entry = svn_hash_gets(store->entries, name);
+
+  if (entry)
+    {
+      unlink_entry(store, entry);
+      store->used_size -= entry->size;
+    }
+  else
+    {
+      if (store->unused)
+        {
+          entry = store->unused;
+          store->unused = entry->newer;
+        }
+      else
+        {
+          entry = apr_palloc(store->pool, sizeof(*entry));
+        }
+
+      apr_cpystrn(entry->name, name, sizeof(entry->name));
+      svn_hash_sets(store->entries, entry->name, entry);
+    }
+
+  entry->size = size;
+  store->used_size += size;
+  append_entry(store, entry);
+
+  while (store->used_size > store->max_size && store->oldest != entry)
+    {
+      disk_entry_t *victim = store->oldest;
+
+      APR_ARRAY_PUSH(victims, const char *)
+        = apr_pstrdup(victims->pool, victim->name);
+      drop_entry(store, victim);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Forget about the file NAME in STORE.  The caller must hold
+ * STORE->MUTEX. */
+static svn_error_t *
+forget_entry(disk_store_t *store,
+             const char *name)
+{
+  disk_entry_t *entry = svn_hash_gets(store->entries, name);
+  if (entry)
+    drop_entry(store, entry);
+
+  return SVN_NO_ERROR;
+}
+
+/* Remove the files named in VICTIMS from STORE's directory.  Use
+ * SCRATCH_POOL for temporary allocations. */
+static void
+remove_files(disk_store_t *store,
+             const apr_array_header_t *victims,
+             apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  for (i = 0; i < victims->nelts; ++i)
+    {
+      const char *name = APR_ARRAY_IDX(victims, i, const char *);
+
+      svn_pool_clear(iterpool);
+      svn_error_clear(svn_io_remove_file2(svn_dirent_join(store->directory,
+                                                          name, iterpool),
+                                          TRUE, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+}
+
+/* Return TRUE if NAME looks like one of our cache file names. */
+static svn_boolean_t
+is_cache_file_name(const char *name)
+{
+  apr_size_t i;
+
+  for (i = 0; i < NAME_LEN; ++i)
+    if (!svn_ctype_isxdigit(name[i]))
+      return FALSE;
+
+  return name[NAME_LEN] == '\0';
+}
+
+/* Sort svn_sort__item_t with svn_io_dirent2_t values by mtime.
+ * Implements the comparison function for svn_sort__hash(). */
+static int
+compare_mtimes(const svn_sort__item_t *a,
+               const svn_sort__item_t *b)
+{
+  const svn_io_dirent2_t *lhs = a->value;
+  const svn_io_dirent2_t *rhs = b->value;
+
+  if (lhs->mtime == rhs->mtime)
+    return 0;
+
+  return lhs->mtime < rhs->mtime ? -1 : 1;
+}
+
+/* Create a new disk store in *STORE_P for DIRECTORY with MAX_SIZE bytes
+ * and allocate it in POOL.  Pick up existing cache files in DIRECTORY,
+ * ordered by their modification time, and remove stale temporaries.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+create_store(disk_store_t **store_p,
+             const char *directory,
+             apr_uint64_t max_size,
+             apr_pool_t *pool,
+             apr_pool_t *scratch_pool)
+{
+  disk_store_t *store = apr_pcalloc(pool, sizeof(*store));
+  apr_array_header_t *victims = apr_array_make(scratch_pool, 16,
+                                               sizeof(const char *));
+  apr_hash_t *dirents;
+  apr_array_header_t *sorted;
+  int i;
+
+  store->directory = apr_pstrdup(pool, directory);
+  store->max_size = max_size;
+  store->entries = apr_hash_make(pool);
+  store->pool = pool;
+  SVN_ERR(svn_mutex__init(&store->mutex, TRUE, pool));
+
+  SVN_ERR(svn_io_make_dir_recursively(directory, scratch_pool));
+  SVN_ERR(svn_io_get_dirents3(&dirents, directory, FALSE,
+                              scratch_pool, scratch_pool));
+
+  sorted = svn_sort__hash(dirents, compare_mtimes, scratch_pool);
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      const svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i,
+                                                    svn_sort__item_t);
+      const char *name = item->key;
+      const svn_io_dirent2_t *dirent = item->value;
+
+      if (dirent->kind != svn_node_file)
+        continue;
+
+      if (is_cache_file_name(name))
+        SVN_ERR(touch_entry(store, name, dirent->filesize, victims));
+      else
+        APR_ARRAY_PUSH(victims, const char *) = name;
+    }
+
+  remove_files(store, victims, scratch_pool);
+
+  *store_p = store;
+  return SVN_NO_ERROR;
+}
+
+/* Set *STORE_P to the disk store for DIRECTORY, creating it with MAX_SIZE
+ * bytes if necessary.  The caller must hold REGISTRY->MUTEX. */
+static svn_error_t *
+get_store(disk_store_t **store_p,
+          const char *directory,
+          apr_uint64_t max_size,
+          apr_pool_t *scratch_pool)
+{
+  disk_store_t *store = svn_hash_gets(registry->stores, directory);
+
+  if (store == NULL)
+    {
+      SVN_ERR(create_store(&store, directory, max_size,
+                           svn_pool_create(registry->pool), scratch_pool));
+      svn_hash_sets(registry->stores, store->directory, store);
+    }
+
+  *store_p = store;
+  return SVN_NO_ERROR;
+}
+
+/* Return the file name for KEY in CACHE, allocated in RESULT_POOL. */
+static const char *
+file_name(disk_cache_t *cache,
+          const void *key,
+          apr_pool_t *result_pool)
+{
+  unsigned char digest[APR_MD5_DIGESTSIZE];
+  svn_checksum_t checksum;
+  apr_md5_ctx_t context;
+  apr_size_t klen = cache->klen == APR_HASH_KEY_STRING
+                  ? strlen(key)
+                  : (apr_size_t)cache->klen;
+
+  /* Include the terminating NUL of the prefix to separate it from the
+   * key. */
+  apr_md5_init(&context);
+  apr_md5_update(&context, cache->prefix, strlen(cache->prefix) + 1);
+  apr_md5_update(&context, key, klen);
+  apr_md5_final(digest, &context);
+
+  checksum.digest = digest;
+  checksum.kind = svn_checksum_md5;
+
+  return svn_checksum_to_cstring_display(&checksum, result_pool);
+}
+
+/* Read the file for KEY in CACHE.  If it exists and is intact, set *DATA
+ * to its contents, excluding the header, allocated in RESULT_POOL.  Set
+ * *DATA to NULL otherwise.  Use SCRATCH_POOL for temporary allocations. */
+static void
+read_file(svn_stringbuf_t **data,
+          disk_cache_t *cache,
+          const void *key,
+          apr_pool_t *result_pool,
+          apr_pool_t *scratch_pool)
+{
+  disk_store_t *store = cache->store;
+  const char *name = file_name(cache, key, scratch_pool);
+  svn_stringbuf_t *contents;
+  svn_error_t *err;
+
+  *data = NULL;
+
+  err = svn_stringbuf_from_file2(&contents,
+                                 svn_dirent_join(store->directory, name,
+                                                 scratch_pool),
+                                 result_pool);
+  if (!err && contents->len >= HEADER_SIZE)
+    {
+      apr_uint32_t checksum;
+      memcpy(&checksum, contents->data, sizeof(checksum));
+
+      if (checksum == svn__fnv1a_32(contents->data + HEADER_SIZE,
+                                    contents->len - HEADER_SIZE))
+        {
+          /* Hit.  Also pick up files written by other processes. */
+          apr_array_header_t *victims
+            = apr_array_make(scratch_pool, 4, sizeof(const char *));
+          err = svn_mutex__lock(store->mutex);
+          if (!err)
+            err = svn_mutex__unlock(store->mutex,
+                                    touch_entry(store, name, contents->len,
+                                                victims));
+          remove_files(store, victims, scratch_pool);
+          svn_error_clear(err);
+
+          svn_stringbuf_remove(contents, 0, HEADER_SIZE);
+          *data = contents;
+
+          return;
+        }
+    }
+
+  /* Missing or damaged file. */
+  svn_error_clear(err);
+  err = svn_mutex__lock(store->mutex);
+  if (!err)
+    err = svn_mutex__unlock(store->mutex, forget_entry(store, name));
+  svn_error_clear(err);
+}
+
+/* Write the serialized item DATA of LEN bytes for KEY in CACHE to disk.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+write_file(disk_cache_t *cache,
+           const void *key,
+           const void *data,
+           apr_size_t len,
+           apr_pool_t *scratch_pool)
+{
+  disk_store_t *store = cache->store;
+  const char *name = file_name(cache, key, scratch_pool);
+  apr_array_header_t *victims = apr_array_make(scratch_pool, 4,
+                                               sizeof(const char *));
+  char header[HEADER_SIZE] = { 0 };
+  apr_uint32_t checksum = svn__fnv1a_32(data, len);
+  const char *temp_path;
+  apr_file_t *file;
+
+  memcpy(header, &checksum, sizeof(checksum));
+
+  SVN_ERR(svn_io_open_unique_file3(&file, &temp_path, store->directory,
+                                   svn_io_file_del_none,
+                                   scratch_pool, scratch_pool));
+  SVN_ERR(svn_io_file_write_full(file, header, sizeof(header), NULL,
+                                 scratch_pool));
+  SVN_ERR(svn_io_file_write_full(file, data, len, NULL, scratch_pool));
+  SVN_ERR(svn_io_file_close(file, scratch_pool));
+  SVN_ERR(svn_io_file_rename2(temp_path,
+                              svn_dirent_join(store->directory, name,
+                                              scratch_pool),
+                              FALSE, scratch_pool));
+
+  SVN_MUTEX__WITH_LOCK(store->mutex,
+                       touch_entry(store, name, len + HEADER_SIZE, victims));
+  remove_files(store, victims, scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Remove the file for KEY in CACHE.  Use SCRATCH_POOL for temporary
+ * allocations. */
+static svn_error_t *
+remove_file(disk_cache_t *cache,
+            const void *key,
+            apr_pool_t *scratch_pool)
+{
+  disk_store_t *store = cache->store;
+  const char *name = file_name(cache, key, scratch_pool);
+
+  SVN_MUTEX__WITH_LOCK(store->mutex, forget_entry(store, name));
+  SVN_ERR(svn_io_remove_file2(svn_dirent_join(store->directory, name,
+                                              scratch_pool),
+                              TRUE, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Return TRUE if items of SIZE bytes shall be written to CACHE's disk
+ * tier. */
+static svn_boolean_t
+disk_is_cachable(disk_cache_t *cache,
+                 apr_size_t size)
+{
+  return size <= cache->store->max_size / MAX_ITEM_SIZE_RATIO;
+}
+
+/* Copy the deserialized VALUE for KEY from CACHE's disk tier into its
+ * first tier.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+promote(disk_cache_t *cache,
+        const void *key,
+        void *value,
+        apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(svn_cache__set(cache->first, key, value,
+                                        scratch_pool));
+}
+
+/* standard serialization function for svn_stringbuf_t items.
+ * Implements svn_cache__serialize_func_t.
+ */
+static svn_error_t *
+serialize_svn_stringbuf(void **buffer,
+                        apr_size_t *buffer_size,
+                        void *item,
+                        apr_pool_t *result_pool)
+{
+  svn_stringbuf_t *value_str = item;
+
+  *buffer = value_str->data;
+  *buffer_size = value_str->len + 1;
+
+  return SVN_NO_ERROR;
+}
+
+/* standard de-serialization function for svn_stringbuf_t items.
+ * Implements svn_cache__deserialize_func_t.
+ */
+static svn_error_t *
+deserialize_svn_stringbuf(void **item,
+                          void *buffer,
+                          apr_size_t buffer_size,
+                          apr_pool_t *result_pool)
+{
+  svn_stringbuf_t *value_str = apr_palloc(result_pool, sizeof(svn_stringbuf_t));
+
+  value_str->pool = result_pool;
+  value_str->blocksize = buffer_size;
+  value_str->data = buffer;
+  value_str->len = buffer_size-1;
+  *item = value_str;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+disk_cache_get(void **value_p,
+               svn_boolean_t *found,
+               void *cache_void,
+               const void *key,
+               apr_pool_t *result_pool)
+{
+  disk_cache_t *cache = cache_void;
+  apr_pool_t *scratch_pool;
+  svn_stringbuf_t *data;
+
+  SVN_ERR(svn_cache__get(value_p, found, cache->first, key, result_pool));
+  if (*found)
+    return SVN_NO_ERROR;
+
+  scratch_pool = svn_pool_create(result_pool);
+  read_file(&data, cache, key, result_pool, scratch_pool);
+  if (data)
+    {
+      SVN_ERR(cache->deserializer(value_p, data->data, data->len,
+                                  result_pool));
+      *found = TRUE;
+
+      SVN_ERR(promote(cache, key, *value_p, scratch_pool));
+    }
+
+  svn_pool_destroy(scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+disk_cache_has_key(svn_boolean_t *found,
+                   void *cache_void,
+                   const void *key,
+                   apr_pool_t *scratch_pool)
+{
+  disk_cache_t *cache = cache_void;
+  svn_node_kind_t kind;
+
+  SVN_ERR(svn_cache__has_key(found, cache->first, key, scratch_pool));
+  if (*found)
+    return SVN_NO_ERROR;
+
+  /* Don't report I/O problems as errors, just as misses. */
+  svn_error_clear(svn_io_check_path(
+                    svn_dirent_join(cache->store->directory,
+                                    file_name(cache, key, scratch_pool),
+                                    scratch_pool),
+                    &kind, scratch_pool));
+  *found = kind == svn_node_file;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+disk_cache_set(void *cache_void,
+               const void *key,
+               void *value,
+               apr_pool_t *scratch_pool)
+{
+  disk_cache_t *cache = cache_void;
+  void *data;
+  apr_size_t len;
+
+  SVN_ERR(svn_cache__set(cache->first, key, value, scratch_pool));
+
+  SVN_ERR(cache->serializer(&data, &len, value, scratch_pool));
+  if (disk_is_cachable(cache, len))
+    svn_error_clear(write_file(cache, key, data, len, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+disk_cache_iter(svn_boolean_t *completed,
+                void *cache_void,
+                svn_iter_apr_hash_cb_t user_cb,
+                void *user_baton,
+                apr_pool_t *scratch_pool)
+{
+  disk_cache_t *cache = cache_void;
+
+  /* Only the first tier can be enumerated. */
+  return svn_error_trace(svn_cache__iter(completed, cache->first,
+                                         user_cb, user_baton,
+                                         scratch_pool));
+}
+
+static svn_boolean_t
+disk_cache_is_cachable(void *cache_void,
+                       apr_size_t size)
+{
+  disk_cache_t *cache = cache_void;
+
+  return svn_cache__is_cachable(cache->first, size)
+      || disk_is_cachable(cache, size);
+}
+
+static svn_error_t *
+disk_cache_get_partial(void **value_p,
+                       svn_boolean_t *found,
+                       void *cache_void,
+                       const void *key,
+                       svn_cache__partial_getter_func_t func,
+                       void *baton,
+                       apr_pool_t *result_pool)
+{
+  disk_cache_t *cache = cache_void;
+  apr_pool_t *scratch_pool;
+  svn_stringbuf_t *data;
+
+  SVN_ERR(svn_cache__get_partial(value_p, found, cache->first, key,
+                                 func, baton, result_pool));
+  if (*found)
+    return SVN_NO_ERROR;
+
+  /* The serialized data can be handed to FUNC directly.  Promote the
+   * whole item afterwards because deserializing it modifies the buffer. */
+  scratch_pool = svn_pool_create(result_pool);
+  read_file(&data, cache, key, scratch_pool, scratch_pool);
+  if (data)
+    {
+      void *value;
+
+      SVN_ERR(func(value_p, data->data, data->len, baton, result_pool));
+      *found = TRUE;
+
+      SVN_ERR(cache->deserializer(&value, data->data, data->len,
+                                  scratch_pool));
+      SVN_ERR(promote(cache, key, value, scratch_pool));
+    }
+
+  svn_pool_destroy(scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+disk_cache_set_partial(void *cache_void,
+                       const void *key,
+                       svn_cache__partial_setter_func_t func,
+                       void *baton,
+                       apr_pool_t *scratch_pool)
+{
+  disk_cache_t *cache = cache_void;
+
+  /* The disk copy would be outdated now. */
+  SVN_ERR(svn_cache__set_partial(cache->first, key, func, baton,
+                                 scratch_pool));
+  svn_error_clear(remove_file(cache, key, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+disk_cache_get_info(void *cache_void,
+                    svn_cache__info_t *info,
+                    svn_boolean_t reset,
+                    apr_pool_t *result_pool)
+{
+  disk_cache_t *cache = cache_void;
+
+  /* The first tier's size and fill level are the interesting ones.
+   * The access counters are maintained for this wrapper by cache.c. */
+  return svn_error_trace(cache->first->vtable->get_info(
+                           cache->first->cache_internal, info, reset,
+                           result_pool));
+}
+
+static svn_cache__vtable_t disk_cache_vtable = {
+  disk_cache_get,
+  disk_cache_has_key,
+  disk_cache_set,
+  disk_cache_iter,
+  disk_cache_is_cachable,
+  disk_cache_get_partial,
+  disk_cache_set_partial,
+  disk_cache_get_info,
+  NULL,                   /* use the generic get_multi */
+  NULL                    /* use the generic set_multi */
+};
+
+svn_error_t *
+svn_cache__create_disk_tier(svn_cache__t **cache_p,
+                            svn_cache__t *first,
+                            const char *directory,
+                            apr_uint64_t max_size,
+                            svn_cache__serialize_func_t serialize_func,
+                            svn_cache__deserialize_func_t deserialize_func,
+                            apr_ssize_t klen,
+                            const char *prefix,
+                            apr_pool_t *result_pool)
+{
+  svn_cache__t *wrapper = apr_pcalloc(result_pool, sizeof(*wrapper));
+  disk_cache_t *cache = apr_pcalloc(result_pool, sizeof(*cache));
+  apr_pool_t *scratch_pool = svn_pool_create(result_pool);
+  const char *abspath;
+
+  SVN_ERR(svn_atomic__init_once(&registry_init_state, init_registry, NULL,
+                                scratch_pool));
+  SVN_ERR(svn_dirent_get_absolute(&abspath, directory, scratch_pool));
+  SVN_MUTEX__WITH_LOCK(registry->mutex,
+                       get_store(&cache->store, abspath, max_size,
+                                 scratch_pool));
+  svn_pool_destroy(scratch_pool);
+
+  cache->first = first;
+  cache->serializer = serialize_func
+                    ? serialize_func
+                    : serialize_svn_stringbuf;
+  cache->deserializer = deserialize_func
+                      ? deserialize_func
+                      : deserialize_svn_stringbuf;
+  cache->klen = klen;
+  cache->prefix = apr_pstrdup(result_pool, prefix);
+
+  wrapper->vtable = &disk_cache_vtable;
+  wrapper->cache_internal = cache;
+  wrapper->error_handler = 0;
+  wrapper->error_baton = 0;
+  wrapper->pretend_empty = !!getenv("SVN_X_DOES_NOT_MARK_THE_SPOT");
+
+  *cache_p = wrapper;
+  return SVN_NO_ERROR;
+}
@@ -640,7 +640,9 @@ static svn_cache__vtable_t inprocess_cache_vtable = {
   inprocess_cache_is_cachable,
   inprocess_cache_get_partial,
   inprocess_cache_set_partial,
-  inprocess_cache_get_info
+  inprocess_cache_get_info,
+  NULL,                   /* use the generic get_multi */
+  NULL                    /* use the generic set_multi */
 };
 
 svn_error_t *
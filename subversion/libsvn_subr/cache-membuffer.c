@@ -24,17 +24,23 @@
 #include <assert.h>
 #include <apr_md5.h>
 #include <apr_thread_rwlock.h>
+#include <apr_shm.h>
+#include <apr_global_mutex.h>
 
 #include "svn_pools.h"
 #include "svn_checksum.h"
+#include "svn_dirent_uri.h"
+#include "svn_io.h"
 #include "svn_private_config.h"
 #include "svn_hash.h"
 #include "svn_string.h"
 #include "svn_sorts.h"  /* get the MIN macro */
+#include "svn_version.h"
 
 #include "private/svn_atomic.h"
 #include "private/svn_dep_compat.h"
 #include "private/svn_mutex.h"
+#include "private/svn_sorts_private.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_string_private.h"
 
@@ -63,8 +69,13 @@
  * Only the start address of these two data parts are given as a native
  * pointer. All other references are expressed as offsets to these pointers.
  * With that design, it is relatively easy to share the same data structure
- * between different processes and / or to persist them on disk. These
- * out-of-process features have not been implemented, yet.
+ * between different processes and / or to persist them on disk.
+ *
+ * Sharing is supported for caches that get created in a parent process
+ * before it forks its workers (see svn_cache__membuffer_cache_create_shared).
+ * All segment data then lives in an anonymous shared memory region that
+ * the children inherit at the same address.  Because key prefix indexes
+ * are process-local, those caches always store full keys.
  *
  * Superficially, cache levels are being used as usual: insertion happens
  * into L1 and evictions will promote items to L2.  But their whole point
@@ -146,6 +157,60 @@
 #  define USE_SIMPLE_MUTEX 0
 #endif
 
+/* Readers may bypass the segment lock entirely and run optimistically
+ * against a per-segment version counter (seqlock-style): Every writer
+ * increments the counter once before and once after modifying the segment
+ * such that an odd value indicates an ongoing write.  A reader samples the
+ * counter, performs a bounds-checked lookup and copy, and then re-checks
+ * the counter.  If it changed, the result is discarded and the lookup gets
+ * retried a few times before we fall back to taking the read lock.
+ * Optimistic readers never write to the segment; in particular, their
+ * hits count neither towards the entries' hit counters nor towards the
+ * segment's statistics, because the entry may get dropped concurrently.
+ *
+ * This requires r/w locks (segments are still write-locked) and a full
+ * memory barrier primitive.  Consistency checks in debug builds need
+ * stable data, so we don't use optimistic reads in that case.
+ */
+#if (   APR_HAS_THREADS && !USE_SIMPLE_MUTEX \
+     && defined(SVN_HAS_ATOMIC_BUILTINS) \
+     && !defined(SVN_DEBUG_CACHE_MEMBUFFER))
+#  define OPTIMISTIC_READS_SUPPORTED 1
+#  define MEMORY_BARRIER() __sync_synchronize()
+#else
+#  define OPTIMISTIC_READS_SUPPORTED 0
+#  define MEMORY_BARRIER()
+#endif
+
+/* Sharing a cache between processes requires shared memory that child
+ * processes inherit at the same address, i.e. we need fork().  Locking
+ * will then use a cross-process mutex per segment.
+ */
+#if APR_HAS_SHARED_MEMORY && APR_HAS_FORK
+#  define SHARED_CACHE_SUPPORTED 1
+#else
+#  define SHARED_CACHE_SUPPORTED 0
+#endif
+
+/* A child process dying while it holds a cross-process lock must not
+ * block all the others forever.  The kernel releases fcntl() locks when
+ * their owner exits.  APR creates and unlinks the lock file itself and
+ * the children inherit its descriptor, so no permissions need to be
+ * adjusted for them either.  Other mechanisms are only used where there
+ * is no fcntl() locking; see svn_cache__membuffer_get_global_locks().
+ */
+#if APR_HAS_FCNTL_SERIALIZE
+#  define SHARED_CACHE_LOCK_MECH APR_LOCK_FCNTL
+#else
+#  define SHARED_CACHE_LOCK_MECH APR_LOCK_DEFAULT
+#endif
+
+/* Number of lock-free attempts a reader makes before falling back to
+ * acquiring the read lock.  Lookups are short, so collisions with writers
+ * are rare and a failed attempt typically means a burst of writes.
+ */
+#define MAX_OPTIMISTIC_READ_ATTEMPTS 4
+
 /* For more efficient copy operations, let's align all data items properly.
  * Since we can't portably align pointers, this is rather the item size
  * granularity which ensures *relative* alignment within the cache - still
@@ -164,6 +229,12 @@
  */
 #define MIN_SEGMENT_SIZE APR_UINT64_C(0x10000)
 
+/* Shrinking a cache will not reduce the data buffer of any segment below
+ * this size.  It must be a multiple of ITEM_ALIGNMENT large enough to
+ * give both cache levels a non-empty buffer.
+ */
+#define MIN_DATA_SIZE (4 * ITEM_ALIGNMENT)
+
 /* The maximum number of segments allowed. Larger numbers reduce the size
  * of each segment, in turn reducing the max size of a cachable item.
  * Also, each segment gets its own lock object. The actual number supported
@@ -197,6 +268,22 @@
  */
 #define MAX_ITEM_SIZE ((apr_uint32_t)(0 - ITEM_ALIGNMENT))
 
+/* Number of rows in the count-min sketch used by the optional admission
+ * filter.  Each row uses a different hash of the entry key.
+ */
+#define SKETCH_DEPTH 4
+
+/* The sketch counters saturate at this value.  That is enough to tell
+ * frequently used entries from one-off accesses.
+ */
+#define SKETCH_MAX_COUNT 15
+
+/* All sketch counters get halved after this many increments per counter
+ * in a row, i.e. SKETCH_WIDTH * SKETCH_AGING_PERIOD total increments.
+ * This keeps the sketch biased towards recent access patterns.
+ */
+#define SKETCH_AGING_PERIOD 10
+
 /* We use this structure to identify cache entries. There cannot be two
  * entries with the same entry key. However unlikely, though, two different
  * full keys (see full_key_t) may have the same entry key.  That is a
@@ -220,6 +307,11 @@ typedef struct entry_key_t
    * prefix pool (see prefix_pool_t).  NO_INDEX if the key prefix is not
    * shared, otherwise KEY_LEN==0 is implied. */
   apr_uint32_t prefix_idx;
+
+  /* Index of the per-prefix statistics (see prefix_stats_t) to attribute
+   * evictions to, or NO_INDEX.  This is not part of the key's identity
+   * and simply uses what would otherwise be padding. */
+  apr_uint32_t stats_idx;
 } entry_key_t;
 
 /* A full key, i.e. the combination of the cache's key prefix with some
@@ -391,6 +483,35 @@ prefix_pool_get(apr_uint32_t *prefix_idx,
   return SVN_NO_ERROR;
 }
 
+/* Maximum number of bytes used to keep track of the prefixes that we
+ * collect per-prefix statistics for (see prefix_stats_t).
+ */
+#define STATS_PREFIX_POOL_SIZE 0x40000
+
+/* Access statistics accumulated over all front-end cache instances with
+ * the same key prefix.  Since these instances are often short-lived, e.g.
+ * per FS session, the per-instance counters of svn_cache__t are of little
+ * use to e.g. tune the cache size.
+ *
+ * Purely statistical information that may be used for profiling only.
+ * Updates are not synchronized and values may be nonsensicle on some
+ * platforms.
+ */
+typedef struct prefix_stats_t
+{
+  /* Number of lookups. */
+  apr_uint64_t gets;
+
+  /* Number of lookups that found the requested item. */
+  apr_uint64_t hits;
+
+  /* Number of items written. */
+  apr_uint64_t sets;
+
+  /* Number of items removed to make room for others. */
+  apr_uint64_t evictions;
+} prefix_stats_t;
+
 /* Debugging / corruption detection support.
  * If you define this macro, the getter functions will performed expensive
  * checks on the item data, requested keys and entry types. If there is
@@ -707,6 +828,14 @@ struct svn_membuffer_t
    * use the one stored in this pool. */
   prefix_pool_t *prefix_pool;
 
+  /* Prefixes of all front-end cache instances created for this cache,
+   * mapped to per-prefix statistics slots in PREFIX_STATS.  Shared among
+   * all segments and always process-local. */
+  prefix_pool_t *stats_prefixes;
+
+  /* Per-prefix statistics, indexed like STATS_PREFIXES->VALUES. */
+  prefix_stats_t *prefix_stats;
+
   /* The dictionary, GROUP_SIZE * (group_count + spare_group_count)
    * entries long.  Never NULL.
    */
@@ -748,6 +877,28 @@ struct svn_membuffer_t
    */
   apr_uint64_t max_entry_size;
 
+  /* Number of bytes allocated for DATA.  L1 and L2 together may cover
+   * less than that if the cache has been shrunk.
+   * See svn_cache__membuffer_resize().
+   */
+  apr_uint64_t data_capacity;
+
+  /* The total size that the cache had been created with.  Resizing to
+   * any smaller total reduces the data buffer size accordingly.
+   */
+  apr_uint64_t reserved_size;
+
+  /* Maximum number of data buffer bytes that the entries of any single
+   * key prefix may use in this segment.  0 if there is no such limit.
+   */
+  apr_uint64_t prefix_quota;
+
+  /* Number of data buffer bytes used by the entries of each key prefix
+   * in this segment, indexed like STATS_PREFIXES->VALUES.  NULL until
+   * prefix quotas get enabled.  See svn_cache__membuffer_set_prefix_quota.
+   */
+  apr_uint64_t *prefix_used;
+
   /* The cache levels, organized as sub-buffers.  Since entries in the
    * DIRECTORY use offsets in DATA for addressing, a cache lookup does
    * not need to know the cache level of a specific item.  Cache levels
@@ -796,6 +947,32 @@ struct svn_membuffer_t
    */
   apr_uint64_t total_hits;
 
+  /* Optional TinyLFU-style admission filter: a count-min sketch with
+   * SKETCH_DEPTH rows of SKETCH_WIDTH saturating access counters each,
+   * indexed by entry key fingerprints.  It remembers access frequencies
+   * even for keys that are no longer cached, so that one-off scans will
+   * not evict frequently used entries from L2.  NULL if the filter is
+   * disabled, in which case the per-entry hit counts are used instead.
+   * Updates are not synchronized, i.e. counts are approximate.
+   */
+  unsigned char *sketch;
+
+  /* Number of counters per SKETCH row.  A power of 2.  0 if SKETCH is NULL.
+   */
+  apr_uint32_t sketch_width;
+
+  /* Number of SKETCH increments since the counters were aged last.
+   */
+  apr_uint32_t sketch_samples;
+
+  /* Number of items that have been admitted to resp. rejected from L2.
+   * Purely statistical information that may be used for profiling only.
+   * Updates are not synchronized and values may be nonsensicle on some
+   * platforms.
+   */
+  apr_uint64_t l2_admissions;
+  apr_uint64_t l2_rejections;
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
   /* A lock for intra-process synchronization to the cache, or NULL if
    * the cache's creator doesn't feel the cache needs to be
@@ -812,8 +989,40 @@ struct svn_membuffer_t
    */
   svn_boolean_t allow_blocking_writes;
 #endif
+
+#if SHARED_CACHE_SUPPORTED
+  /* If not NULL, this segment lives in shared memory and may be accessed
+   * from multiple processes.  All locking uses *GLOBAL_LOCK exclusively
+   * instead of LOCK in that case.  Note that the pointer to the mutex is
+   * process-local (child processes need to re-initialize it) while the
+   * segment structure itself is shared.
+   */
+  apr_global_mutex_t **global_lock;
+#endif
+
+#if OPTIMISTIC_READS_SUPPORTED
+  /* Seqlock-style version counter.  Incremented by every writer right
+   * after acquiring and right before releasing the write lock, i.e. odd
+   * values indicate that the segment is currently being modified.
+   */
+  volatile svn_atomic_t version;
+
+  /* If set, lookups will first try to read the data without acquiring
+   * LOCK and verify the result against VERSION afterwards.
+   */
+  svn_boolean_t optimistic_reads;
+#endif
+
+  /* While lock statistics are being collected, the time at which the
+   * current write lock has been acquired.  0 otherwise.
+   */
+  apr_time_t write_locked_at;
 };
 
+/* Name of the segment locks in the lock statistics.
+ */
+#define LOCK_STATS_NAME "cache-membuffer-segment"
+
 /* Align integer VALUE to the next ITEM_ALIGNMENT boundary.
  */
 #define ALIGN_VALUE(value) (((value) + ITEM_ALIGNMENT-1) & -ITEM_ALIGNMENT)
@@ -821,8 +1030,19 @@ struct svn_membuffer_t
 /* If locking is supported for CACHE, acquire a read lock for it.
  */
 static svn_error_t *
-read_lock_cache(svn_membuffer_t *cache)
+acquire_read_lock(svn_membuffer_t *cache)
 {
+#if SHARED_CACHE_SUPPORTED
+  if (cache->global_lock)
+    {
+      apr_status_t status = apr_global_mutex_lock(*cache->global_lock);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't lock cache mutex"));
+
+      return SVN_NO_ERROR;
+    }
+#endif
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
   return svn_mutex__lock(cache->lock);
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
@@ -844,8 +1064,36 @@ read_lock_cache(svn_membuffer_t *cache)
  * leave it untouched otherwise.
  */
 static svn_error_t *
-write_lock_cache(svn_membuffer_t *cache, svn_boolean_t *success)
+acquire_write_lock(svn_membuffer_t *cache, svn_boolean_t *success)
 {
+#if SHARED_CACHE_SUPPORTED
+  if (cache->global_lock)
+    {
+      apr_status_t status;
+#if (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
+      if (!cache->allow_blocking_writes)
+        {
+          status = apr_global_mutex_trylock(*cache->global_lock);
+          if (SVN_LOCK_IS_BUSY(status))
+            {
+              *success = FALSE;
+              status = APR_SUCCESS;
+            }
+        }
+      else
+#endif
+        {
+          status = apr_global_mutex_lock(*cache->global_lock);
+        }
+
+      if (status)
+        return svn_error_wrap_apr(status,
+                                  _("Can't write-lock cache mutex"));
+
+      return SVN_NO_ERROR;
+    }
+#endif
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
   return svn_mutex__lock(cache->lock);
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
@@ -881,12 +1129,28 @@ write_lock_cache(svn_membuffer_t *cache, svn_boolean_t *success)
  * for it.
  */
 static svn_error_t *
-force_write_lock_cache(svn_membuffer_t *cache)
+acquire_forced_write_lock(svn_membuffer_t *cache)
 {
+#if SHARED_CACHE_SUPPORTED || (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
+  apr_status_t status;
+#endif
+
+#if SHARED_CACHE_SUPPORTED
+  if (cache->global_lock)
+    {
+      status = apr_global_mutex_lock(*cache->global_lock);
+      if (status)
+        return svn_error_wrap_apr(status,
+                                  _("Can't write-lock cache mutex"));
+
+      return SVN_NO_ERROR;
+    }
+#endif
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
   return svn_mutex__lock(cache->lock);
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
-  apr_status_t status = apr_thread_rwlock_wrlock(cache->lock);
+  status = apr_thread_rwlock_wrlock(cache->lock);
   if (status)
     return svn_error_wrap_apr(status,
                               _("Can't write-lock cache mutex"));
@@ -901,8 +1165,22 @@ force_write_lock_cache(svn_membuffer_t *cache)
  * (read or write).  Return ERR upon success.
  */
 static svn_error_t *
-unlock_cache(svn_membuffer_t *cache, svn_error_t *err)
+release_lock(svn_membuffer_t *cache, svn_error_t *err)
 {
+#if SHARED_CACHE_SUPPORTED
+  if (cache->global_lock)
+    {
+      apr_status_t status = apr_global_mutex_unlock(*cache->global_lock);
+      if (err)
+        return err;
+
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't unlock cache mutex"));
+
+      return SVN_NO_ERROR;
+    }
+#endif
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
   return svn_mutex__unlock(cache->lock, err);
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
@@ -922,6 +1200,102 @@ unlock_cache(svn_membuffer_t *cache, svn_error_t *err)
 #endif
 }
 
+/* The following wrap the lock functions above and add lock statistics,
+ * if enabled.  Hold times can only be measured for write locks.
+ */
+
+/* Like acquire_read_lock. */
+static svn_error_t *
+read_lock_cache(svn_membuffer_t *cache)
+{
+  apr_time_t start = svn_mutex__stats_enabled() ? apr_time_now() : 0;
+
+  SVN_ERR(acquire_read_lock(cache));
+  if (start)
+    svn_mutex__stats_add_wait(LOCK_STATS_NAME, apr_time_now() - start);
+
+  return SVN_NO_ERROR;
+}
+
+/* Like acquire_write_lock. */
+static svn_error_t *
+write_lock_cache(svn_membuffer_t *cache, svn_boolean_t *success)
+{
+  apr_time_t start = svn_mutex__stats_enabled() ? apr_time_now() : 0;
+  svn_boolean_t got_lock = TRUE;
+
+  SVN_ERR(acquire_write_lock(cache, &got_lock));
+  if (!got_lock)
+    {
+      *success = FALSE;
+    }
+  else if (start)
+    {
+      cache->write_locked_at = apr_time_now();
+      svn_mutex__stats_add_wait(LOCK_STATS_NAME,
+                                cache->write_locked_at - start);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Like acquire_forced_write_lock. */
+static svn_error_t *
+force_write_lock_cache(svn_membuffer_t *cache)
+{
+  apr_time_t start = svn_mutex__stats_enabled() ? apr_time_now() : 0;
+
+  SVN_ERR(acquire_forced_write_lock(cache));
+  if (start)
+    {
+      cache->write_locked_at = apr_time_now();
+      svn_mutex__stats_add_wait(LOCK_STATS_NAME,
+                                cache->write_locked_at - start);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Like release_lock. */
+static svn_error_t *
+unlock_cache(svn_membuffer_t *cache, svn_error_t *err)
+{
+  if (cache->write_locked_at)
+    {
+      svn_mutex__stats_add_hold(LOCK_STATS_NAME,
+                                apr_time_now() - cache->write_locked_at);
+      cache->write_locked_at = 0;
+    }
+
+  return release_lock(cache, err);
+}
+
+/* Tell optimistic readers that CACHE is about to be modified.
+ * The caller must hold the write lock.
+ */
+static APR_INLINE void
+begin_write(svn_membuffer_t *cache)
+{
+#if OPTIMISTIC_READS_SUPPORTED
+  svn_atomic_inc(&cache->version);
+  MEMORY_BARRIER();
+#endif
+}
+
+/* Tell optimistic readers that the modification of CACHE started by
+ * begin_write() has been completed.  Return ERR.
+ */
+static APR_INLINE svn_error_t *
+end_write(svn_membuffer_t *cache, svn_error_t *err)
+{
+#if OPTIMISTIC_READS_SUPPORTED
+  MEMORY_BARRIER();
+  svn_atomic_inc(&cache->version);
+#endif
+
+  return err;
+}
+
 /* If supported, guard the execution of EXPR with a read lock to CACHE.
  * The macro has been modeled after SVN_MUTEX__WITH_LOCK.
  */
@@ -954,7 +1328,8 @@ do {                                                            \
       else                                                      \
         break;                                                  \
     }                                                           \
-  SVN_ERR(unlock_cache(cache, (expr)));                         \
+  begin_write(cache);                                           \
+  SVN_ERR(unlock_cache(cache, end_write(cache, (expr))));       \
 } while (0)
 
 /* Returns 0 if the entry group identified by GROUP_INDEX in CACHE has not
@@ -1216,6 +1591,8 @@ drop_entry(svn_membuffer_t *cache, entry_t *entry)
    */
   cache->used_entries--;
   cache->data_used -= entry->size;
+  if (cache->prefix_used && entry->key.stats_idx != NO_INDEX)
+    cache->prefix_used[entry->key.stats_idx] -= entry->size;
 
   /* extend the insertion window, if the entry happens to border it
    */
@@ -1284,6 +1661,18 @@ drop_entry(svn_membuffer_t *cache, entry_t *entry)
     free_spare_group(cache, last_group);
 }
 
+/* Remove the used ENTRY from the CACHE to make room for other entries.
+ * Same as drop_entry but counted as an eviction.
+ */
+static void
+evict_entry(svn_membuffer_t *cache, entry_t *entry)
+{
+  if (entry->key.stats_idx != NO_INDEX)
+    cache->prefix_stats[entry->key.stats_idx].evictions++;
+
+  drop_entry(cache, entry);
+}
+
 /* Insert ENTRY into the chain of used dictionary entries. The entry's
  * offset and size members must already have been initialized. Also,
  * the offset must match the beginning of the insertion window.
@@ -1309,6 +1698,8 @@ insert_entry(svn_membuffer_t *cache, entry_t *entry)
    */
   cache->used_entries++;
   cache->data_used += entry->size;
+  if (cache->prefix_used && entry->key.stats_idx != NO_INDEX)
+    cache->prefix_used[entry->key.stats_idx] += entry->size;
   entry->hit_count = 0;
   group->header.used++;
 
@@ -1533,7 +1924,7 @@ find_entry(svn_membuffer_t *cache,
             if (entry != &to_shrink->entries[i])
               let_entry_age(cache, &to_shrink->entries[i]);
 
-          drop_entry(cache, entry);
+          evict_entry(cache, entry);
         }
 
       /* initialize entry for the new key
@@ -1545,6 +1936,82 @@ find_entry(svn_membuffer_t *cache,
   return entry;
 }
 
+#if OPTIMISTIC_READS_SUPPORTED
+
+/* Lock-free variant of find_entry with FIND_EMPTY==FALSE.  Look for the
+ * entry in group GROUP_INDEX of CACHE that matches TO_FIND, return it and
+ * copy its current contents into *SNAPSHOT.  Return NULL if none could be
+ * found.
+ *
+ * Because writers may modify CACHE concurrently, no directory contents
+ * can be trusted: never follow group links outside the directory, never
+ * walk more than MAX_GROUP_CHAIN_LENGTH groups and never report an entry
+ * whose data would lie outside the data buffer.  The result is only valid
+ * if the segment's VERSION has not changed in the meantime.
+ */
+static entry_t *
+find_entry_optimistic(svn_membuffer_t *cache,
+                      apr_uint32_t group_index,
+                      const full_key_t *to_find,
+                      entry_t *snapshot)
+{
+  apr_uint32_t group_limit = cache->group_count + cache->spare_group_count;
+  apr_uint64_t data_size = cache->l2.start_offset + cache->l2.size;
+  entry_group_t *group = &cache->directory[group_index];
+  apr_uint32_t chain_length;
+
+  /* If the entry group has not been initialized, yet, there is no data.
+   */
+  if (! is_group_initialized(cache, group_index))
+    return NULL;
+
+  for (chain_length = 0;
+       chain_length < MAX_GROUP_CHAIN_LENGTH;
+       ++chain_length)
+    {
+      apr_uint32_t used = MIN(group->header.used, (apr_uint32_t)GROUP_SIZE);
+      apr_uint32_t next;
+      apr_size_t i;
+
+      for (i = 0; i < used; ++i)
+        {
+          *snapshot = group->entries[i];
+          if (!entry_keys_match(&snapshot->key, &to_find->entry_key))
+            continue;
+
+          /* This is the only entry that _may_ contain the correct data.
+           * Make sure that we will not access memory outside our buffer
+           * even if the snapshot has been torn by some writer. */
+          if (   snapshot->size < snapshot->key.key_len
+              || snapshot->offset > data_size
+              || ALIGN_VALUE(snapshot->size) > data_size - snapshot->offset)
+            return NULL;
+
+          /* If the full key is fully defined in prefix_id & mangeled
+           * key, we are done.  Otherwise, compare the full key. */
+          if (   !snapshot->key.key_len
+              || memcmp(to_find->full_key.data,
+                        cache->data + snapshot->offset,
+                        snapshot->key.key_len) == 0)
+            return &group->entries[i];
+
+          /* Key conflict. The entry to find cannot be anywhere else. */
+          return NULL;
+        }
+
+      /* end of chain? */
+      next = group->header.next;
+      if (next == NO_INDEX || next >= group_limit)
+        break;
+
+      group = &cache->directory[next];
+    }
+
+  return NULL;
+}
+
+#endif
+
 /* Move a surviving ENTRY from just behind the insertion window to
  * its beginning and move the insertion window up accordingly.
  */
@@ -1612,6 +2079,79 @@ promote_entry(svn_membuffer_t *cache, entry_t *entry)
   chain_entry(cache, &cache->l2, entry, idx);
 }
 
+/* Return the counter index in row ROW of the sketch in CACHE for KEY.
+ */
+static APR_INLINE apr_size_t
+get_sketch_index(svn_membuffer_t *cache,
+                 const entry_key_t *key,
+                 apr_size_t row)
+{
+  /* Derive the row hashes from the two fingerprint halves. */
+  apr_uint64_t hash = key->fingerprint[0] + row * key->fingerprint[1];
+  hash ^= hash >> 29;
+
+  return row * cache->sketch_width
+       + (apr_size_t)(hash & (cache->sketch_width - 1));
+}
+
+/* Halve all sketch counters in CACHE.
+ */
+static void
+age_sketch(svn_membuffer_t *cache)
+{
+  apr_size_t i;
+  apr_size_t count = SKETCH_DEPTH * (apr_size_t)cache->sketch_width;
+
+  for (i = 0; i < count; ++i)
+    cache->sketch[i] >>= 1;
+
+  cache->sketch_samples = 0;
+}
+
+/* Count an access to KEY in the admission filter of CACHE, if enabled.
+ */
+static void
+record_access(svn_membuffer_t *cache,
+              const entry_key_t *key)
+{
+  apr_size_t row;
+
+  if (cache->sketch == NULL)
+    return;
+
+  for (row = 0; row < SKETCH_DEPTH; ++row)
+    {
+      unsigned char *counter = &cache->sketch[get_sketch_index(cache, key,
+                                                                row)];
+      if (*counter < SKETCH_MAX_COUNT)
+        ++*counter;
+    }
+
+  if (++cache->sketch_samples / SKETCH_AGING_PERIOD >= cache->sketch_width)
+    age_sketch(cache);
+}
+
+/* Return the number of hits that we expect for ENTRY in CACHE.  If the
+ * admission filter is enabled, this is the access frequency estimated by
+ * the sketch.  Otherwise, use the ENTRY's hit counter.
+ */
+static apr_uint32_t
+get_entry_hits(svn_membuffer_t *cache,
+               const entry_t *entry)
+{
+  apr_size_t row;
+  apr_uint32_t result = SKETCH_MAX_COUNT;
+
+  if (cache->sketch == NULL)
+    return entry->hit_count;
+
+  for (row = 0; row < SKETCH_DEPTH; ++row)
+    result = MIN(result,
+                 cache->sketch[get_sketch_index(cache, &entry->key, row)]);
+
+  return result;
+}
+
 /* This function implements the cache insertion / eviction strategy for L2.
  *
  * If necessary, enlarge the insertion window of CACHE->L2 until it is at
@@ -1641,8 +2181,11 @@ ensure_data_insertable_l2(svn_membuffer_t *cache,
   /* accumulated "worth" of items dropped so far */
   apr_uint64_t drop_hits = 0;
 
+  /* (expected) hits of the new entry */
+  apr_uint32_t to_fit_in_hits = get_entry_hits(cache, to_fit_in);
+
   /* estimated "worth" of the new entry */
-  apr_uint64_t drop_hits_limit = (to_fit_in->hit_count + 1)
+  apr_uint64_t drop_hits_limit = (to_fit_in_hits + 1)
                                * (apr_uint64_t)to_fit_in->priority;
 
   /* This loop will eventually terminate because every cache entry
@@ -1697,7 +2240,9 @@ ensure_data_insertable_l2(svn_membuffer_t *cache,
       else
         {
           svn_boolean_t keep;
+          apr_uint32_t entry_hits;
           entry = get_entry(cache, cache->l2.next);
+          entry_hits = get_entry_hits(cache, entry);
 
           if (to_fit_in->priority < SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY)
             {
@@ -1705,7 +2250,7 @@ ensure_data_insertable_l2(svn_membuffer_t *cache,
                * entry is of even lower prio and has fewer hits.
                */
               if (   entry->priority > to_fit_in->priority
-                  || entry->hit_count > to_fit_in->hit_count)
+                  || entry_hits > to_fit_in_hits)
                 return FALSE;
             }
 
@@ -1726,7 +2271,7 @@ ensure_data_insertable_l2(svn_membuffer_t *cache,
                * The new entry may still find room by ousting other entries.
                */
               keep = to_fit_in->priority == entry->priority
-                   ? entry->hit_count >= to_fit_in->hit_count
+                   ? entry_hits >= to_fit_in_hits
                    : entry->priority > to_fit_in->priority;
             }
 
@@ -1748,9 +2293,9 @@ ensure_data_insertable_l2(svn_membuffer_t *cache,
                * provide the same data but in a further stage of processing.
                */
               if (entry->priority > SVN_CACHE__MEMBUFFER_LOW_PRIORITY)
-                drop_hits += entry->hit_count * (apr_uint64_t)entry->priority;
+                drop_hits += entry_hits * (apr_uint64_t)entry->priority;
 
-              drop_entry(cache, entry);
+              evict_entry(cache, entry);
             }
         }
     }
@@ -1816,9 +2361,15 @@ ensure_data_insertable_l1(svn_membuffer_t *cache, apr_size_t size)
           if (entry_index == cache->l1.next)
             {
               if (keep)
-                promote_entry(cache, entry);
+                {
+                  promote_entry(cache, entry);
+                  cache->l2_admissions++;
+                }
               else
-                drop_entry(cache, entry);
+                {
+                  evict_entry(cache, entry);
+                  cache->l2_rejections++;
+                }
             }
         }
     }
@@ -1827,17 +2378,82 @@ ensure_data_insertable_l1(svn_membuffer_t *cache, apr_size_t size)
    * right answer. */
 }
 
-svn_error_t *
-svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
-                                  apr_size_t total_size,
-                                  apr_size_t directory_size,
-                                  apr_size_t segment_count,
-                                  svn_boolean_t thread_safe,
-                                  svn_boolean_t allow_blocking_writes,
-                                  apr_pool_t *pool)
+/* Return SIZE bytes of uninitialized memory from POOL or - if *SHM_DATA
+ * is not NULL - from the pre-allocated shared memory block that it points
+ * to, in which case *SHM_DATA will be moved behind the allocated block.
+ */
+static void *
+segment_alloc(unsigned char **shm_data,
+              apr_size_t size,
+              apr_pool_t *pool)
 {
-  svn_membuffer_t *c;
+  void *result;
+  if (*shm_data == NULL)
+    return apr_palloc(pool, size);
+
+  result = *shm_data;
+  *shm_data += APR_ALIGN_DEFAULT(size);
+
+  return result;
+}
+
+/* Let the cache levels of segment CACHE use the first DATA_SIZE bytes of
+ * its data buffer and mark them as empty.  DATA_SIZE must be a multiple
+ * of ITEM_ALIGNMENT and at least MIN_DATA_SIZE.
+ */
+static void
+init_levels(svn_membuffer_t *cache,
+            apr_uint64_t data_size)
+{
+  /* Allocate 1/4th of the data buffer to L1
+   */
+  cache->l1.first = NO_INDEX;
+  cache->l1.last = NO_INDEX;
+  cache->l1.next = NO_INDEX;
+  cache->l1.start_offset = 0;
+  cache->l1.size = ALIGN_VALUE(data_size / 4);
+  cache->l1.current_data = 0;
+
+  /* The remaining 3/4th will be used as L2
+   */
+  cache->l2.first = NO_INDEX;
+  cache->l2.last = NO_INDEX;
+  cache->l2.next = NO_INDEX;
+  cache->l2.start_offset = cache->l1.size;
+  cache->l2.size = data_size - cache->l1.size;
+  cache->l2.current_data = cache->l2.start_offset;
+
+  /* For cache sizes > 16TB, individual cache segments will be larger
+   * than 32GB allowing for >4GB entries.  But caching chunks larger
+   * than 4GB are simply not supported.
+   */
+  cache->max_entry_size = data_size / 8 > MAX_ITEM_SIZE
+                        ? MAX_ITEM_SIZE
+                        : data_size / 8;
+}
+
+/* Implement svn_cache__membuffer_cache_create and
+ * svn_cache__membuffer_cache_create_shared.  The parameters are the same
+ * as for the latter with SHARED selecting between them.
+ */
+static svn_error_t *
+create_membuffer_cache(svn_membuffer_t **cache,
+                       apr_size_t total_size,
+                       apr_size_t directory_size,
+                       apr_size_t segment_count,
+                       svn_boolean_t thread_safe,
+                       svn_boolean_t allow_blocking_writes,
+                       svn_boolean_t shared,
+                       apr_pool_t *pool)
+{
+  svn_membuffer_t *c;
   prefix_pool_t *prefix_pool;
+  prefix_pool_t *stats_prefixes;
+  prefix_stats_t *prefix_stats;
+  unsigned char *shm_data = NULL;
+#if SHARED_CACHE_SUPPORTED
+  apr_global_mutex_t **global_locks = NULL;
+#endif
 
   apr_uint32_t seg;
   apr_uint32_t group_count;
@@ -1845,13 +2461,28 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
   apr_uint32_t spare_group_count;
   apr_uint32_t group_init_size;
   apr_uint64_t data_size;
-  apr_uint64_t max_entry_size;
+  apr_uint64_t reserved_size = total_size;
 
   /* Allocate 1% of the cache capacity to the prefix string pool.
+   * Prefix indexes are only valid within the current process, so caches
+   * shared between processes must not use them.
    */
-  SVN_ERR(prefix_pool_create(&prefix_pool, total_size / 100, thread_safe,
-                             pool));
-  total_size -= total_size / 100;
+  if (shared)
+    {
+      SVN_ERR(prefix_pool_create(&prefix_pool, 0, thread_safe, pool));
+    }
+  else
+    {
+      SVN_ERR(prefix_pool_create(&prefix_pool, total_size / 100, thread_safe,
+                                 pool));
+      total_size -= total_size / 100;
+    }
+
+  /* Statistics are always per process. */
+  SVN_ERR(prefix_pool_create(&stats_prefixes, STATS_PREFIX_POOL_SIZE,
+                             thread_safe, pool));
+  prefix_stats = apr_pcalloc(pool, stats_prefixes->values_max
+                                     * sizeof(*prefix_stats));
 
   /* Limit the total size (only relevant if we can address > 4GB)
    */
@@ -1905,9 +2536,6 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
          && segment_count < MAX_SEGMENT_COUNT)
     segment_count *= 2;
 
-  /* allocate cache as an array of segments / cache objects */
-  c = apr_palloc(pool, segment_count * sizeof(*c));
-
   /* Split total cache size into segments of equal size
    */
   total_size /= segment_count;
@@ -1933,14 +2561,6 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
    */
   data_size = ALIGN_VALUE(total_size - directory_size + 1) - ITEM_ALIGNMENT;
 
-  /* For cache sizes > 16TB, individual cache segments will be larger
-   * than 32GB allowing for >4GB entries.  But caching chunks larger
-   * than 4GB are simply not supported.
-   */
-  max_entry_size = data_size / 8 > MAX_ITEM_SIZE
-                 ? MAX_ITEM_SIZE
-                 : data_size / 8;
-
   /* to keep the entries small, we use 32 bit indexes only
    * -> we need to ensure that no more than 4G entries exist.
    *
@@ -1958,12 +2578,48 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
   assert(spare_group_count > 0 && main_group_count > 0);
 
   group_init_size = 1 + group_count / (8 * GROUP_INIT_GRANULARITY);
+
+  /* For shared caches, everything but the per-process lock objects must
+   * be allocated from a single shared memory block. */
+  if (shared)
+    {
+#if SHARED_CACHE_SUPPORTED
+      apr_shm_t *shm;
+      apr_status_t status;
+      apr_size_t segment_size
+        = APR_ALIGN_DEFAULT(group_count * sizeof(entry_group_t))
+        + APR_ALIGN_DEFAULT(group_init_size)
+        + APR_ALIGN_DEFAULT((apr_size_t)ALIGN_VALUE(data_size));
+
+      /* Anonymous shared memory will be inherited by child processes. */
+      status = apr_shm_create(&shm,
+                              APR_ALIGN_DEFAULT(segment_count * sizeof(*c))
+                                + segment_count * segment_size,
+                              NULL, pool);
+      if (status)
+        return svn_error_wrap_apr(status,
+                                  _("Can't create shared memory for cache"));
+
+      shm_data = apr_shm_baseaddr_get(shm);
+      global_locks = apr_pcalloc(pool, segment_count * sizeof(*global_locks));
+#else
+      return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                              _("Shared memory caches are not supported "
+                                "on this platform"));
+#endif
+    }
+
+  /* allocate cache as an array of segments / cache objects */
+  c = segment_alloc(&shm_data, segment_count * sizeof(*c), pool);
+
   for (seg = 0; seg < segment_count; ++seg)
     {
       /* allocate buffers and initialize cache members
        */
       c[seg].segment_count = (apr_uint32_t)segment_count;
       c[seg].prefix_pool = prefix_pool;
+      c[seg].stats_prefixes = stats_prefixes;
+      c[seg].prefix_stats = prefix_stats;
 
       c[seg].group_count = main_group_count;
       c[seg].spare_group_count = spare_group_count;
@@ -1973,41 +2629,41 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
       /* Allocate but don't clear / zero the directory because it would add
          significantly to the server start-up time if the caches are large.
          Group initialization will take care of that in stead. */
-      c[seg].directory = apr_palloc(pool,
-                                    group_count * sizeof(entry_group_t));
+      c[seg].directory = segment_alloc(&shm_data,
+                                       group_count * sizeof(entry_group_t),
+                                       pool);
 
       /* Allocate and initialize directory entries as "not initialized",
          hence "unused" */
-      c[seg].group_initialized = apr_pcalloc(pool, group_init_size);
+      c[seg].group_initialized = segment_alloc(&shm_data, group_init_size,
+                                               pool);
+      if (c[seg].group_initialized)
+        memset(c[seg].group_initialized, 0, group_init_size);
 
-      /* Allocate 1/4th of the data buffer to L1
-       */
-      c[seg].l1.first = NO_INDEX;
-      c[seg].l1.last = NO_INDEX;
-      c[seg].l1.next = NO_INDEX;
-      c[seg].l1.start_offset = 0;
-      c[seg].l1.size = ALIGN_VALUE(data_size / 4);
-      c[seg].l1.current_data = 0;
-
-      /* The remaining 3/4th will be used as L2
+      /* Initially, the cache levels use the whole data buffer.
        */
-      c[seg].l2.first = NO_INDEX;
-      c[seg].l2.last = NO_INDEX;
-      c[seg].l2.next = NO_INDEX;
-      c[seg].l2.start_offset = c[seg].l1.size;
-      c[seg].l2.size = ALIGN_VALUE(data_size) - c[seg].l1.size;
-      c[seg].l2.current_data = c[seg].l2.start_offset;
+      init_levels(&c[seg], ALIGN_VALUE(data_size));
 
       /* This cast is safe because DATA_SIZE <= MAX_SEGMENT_SIZE. */
-      c[seg].data = apr_palloc(pool, (apr_size_t)ALIGN_VALUE(data_size));
+      c[seg].data = segment_alloc(&shm_data,
+                                  (apr_size_t)ALIGN_VALUE(data_size), pool);
       c[seg].data_used = 0;
-      c[seg].max_entry_size = max_entry_size;
+      c[seg].data_capacity = ALIGN_VALUE(data_size);
+      c[seg].reserved_size = reserved_size;
+      c[seg].prefix_quota = 0;
+      c[seg].prefix_used = NULL;
 
       c[seg].used_entries = 0;
       c[seg].total_reads = 0;
       c[seg].total_writes = 0;
       c[seg].total_hits = 0;
 
+      c[seg].sketch = NULL;
+      c[seg].sketch_width = 0;
+      c[seg].sketch_samples = 0;
+      c[seg].l2_admissions = 0;
+      c[seg].l2_rejections = 0;
+
       /* were allocations successful?
        * If not, initialize a minimal cache structure.
        */
@@ -2027,7 +2683,7 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
       /* Same for read-write lock. */
       c[seg].lock = NULL;
-      if (thread_safe)
+      if (thread_safe && !shared)
         {
           apr_status_t status =
               apr_thread_rwlock_create(&(c[seg].lock), pool);
@@ -2039,6 +2695,29 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
        */
       c[seg].allow_blocking_writes = allow_blocking_writes;
 #endif
+
+#if SHARED_CACHE_SUPPORTED
+      /* Shared segments need a cross-process lock.  It replaces the
+       * intra-process lock created above.
+       */
+      c[seg].global_lock = NULL;
+      if (shared)
+        {
+          apr_status_t status
+            = apr_global_mutex_create(&global_locks[seg], NULL,
+                                      SHARED_CACHE_LOCK_MECH, pool);
+          if (status)
+            return svn_error_wrap_apr(status, _("Can't create cache mutex"));
+
+          c[seg].global_lock = &global_locks[seg];
+        }
+#endif
+
+#if OPTIMISTIC_READS_SUPPORTED
+      /* Lock-free lookups are only meaningful if there is a lock. */
+      c[seg].version = 0;
+      c[seg].optimistic_reads = thread_safe || shared;
+#endif
     }
 
   /* done here
@@ -2048,17 +2727,124 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
 }
 
 svn_error_t *
-svn_cache__membuffer_clear(svn_membuffer_t *cache)
+svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
+                                  apr_size_t total_size,
+                                  apr_size_t directory_size,
+                                  apr_size_t segment_count,
+                                  svn_boolean_t thread_safe,
+                                  svn_boolean_t allow_blocking_writes,
+                                  apr_pool_t *pool)
 {
-  apr_size_t seg;
-  apr_size_t segment_count = cache->segment_count;
+  return svn_error_trace(create_membuffer_cache(cache, total_size,
+                                                directory_size,
+                                                segment_count, thread_safe,
+                                                allow_blocking_writes,
+                                                FALSE, pool));
+}
 
+svn_error_t *
+svn_cache__membuffer_cache_create_shared(svn_membuffer_t **cache,
+                                         apr_size_t total_size,
+                                         apr_size_t directory_size,
+                                         apr_size_t segment_count,
+                                         svn_boolean_t thread_safe,
+                                         svn_boolean_t allow_blocking_writes,
+                                         apr_pool_t *pool)
+{
+  return svn_error_trace(create_membuffer_cache(cache, total_size,
+                                                directory_size,
+                                                segment_count, thread_safe,
+                                                allow_blocking_writes,
+                                                TRUE, pool));
+}
+
+svn_error_t *
+svn_cache__membuffer_child_init(svn_membuffer_t *cache,
+                                apr_pool_t *pool)
+{
+#if SHARED_CACHE_SUPPORTED
+  apr_uint32_t seg;
+  apr_uint32_t segment_count = cache->segment_count;
+
+  /* Only the lock object pointers are process-local. */
+  for (seg = 0; seg < segment_count; ++seg)
+    if (cache[seg].global_lock)
+      {
+        apr_status_t status
+          = apr_global_mutex_child_init(cache[seg].global_lock, NULL, pool);
+        if (status)
+          return svn_error_wrap_apr(status,
+                                    _("Can't re-open cache mutex"));
+      }
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+apr_array_header_t *
+svn_cache__membuffer_get_global_locks(svn_membuffer_t *cache,
+                                      apr_pool_t *result_pool)
+{
+  apr_array_header_t *locks
+    = apr_array_make(result_pool, 0, sizeof(apr_global_mutex_t *));
+
+#if SHARED_CACHE_SUPPORTED
+  apr_uint32_t seg;
+  apr_uint32_t segment_count = cache->segment_count;
+
+  for (seg = 0; seg < segment_count; ++seg)
+    if (cache[seg].global_lock)
+      APR_ARRAY_PUSH(locks, apr_global_mutex_t *) = *cache[seg].global_lock;
+#endif
+
+  return locks;
+}
+
+/* Remove all entries from segment CACHE.
+ *
+ * Note: This function requires the caller to hold the write lock.
+ */
+static void
+reset_segment(svn_membuffer_t *cache)
+{
   /* Length of the group_initialized array in bytes.
      See also svn_cache__membuffer_cache_create(). */
   apr_size_t group_init_size
     = 1 + (cache->group_count + cache->spare_group_count)
             / (8 * GROUP_INIT_GRANULARITY);
 
+  /* Mark all groups as "not initialized", which implies "empty". */
+  cache->first_spare_group = NO_INDEX;
+  cache->max_spare_used = 0;
+
+  memset(cache->group_initialized, 0, group_init_size);
+
+  /* Unlink L1 contents. */
+  cache->l1.first = NO_INDEX;
+  cache->l1.last = NO_INDEX;
+  cache->l1.next = NO_INDEX;
+  cache->l1.current_data = cache->l1.start_offset;
+
+  /* Unlink L2 contents. */
+  cache->l2.first = NO_INDEX;
+  cache->l2.last = NO_INDEX;
+  cache->l2.next = NO_INDEX;
+  cache->l2.current_data = cache->l2.start_offset;
+
+  /* Reset content counters. */
+  cache->data_used = 0;
+  cache->used_entries = 0;
+  if (cache->prefix_used)
+    memset(cache->prefix_used, 0,
+           cache->stats_prefixes->values_max * sizeof(*cache->prefix_used));
+}
+
+svn_error_t *
+svn_cache__membuffer_clear(svn_membuffer_t *cache)
+{
+  apr_size_t seg;
+  apr_size_t segment_count = cache->segment_count;
+
   /* Clear segment by segment.  This implies that other thread may read
      and write to other segments after we cleared them and before the
      last segment is done.
@@ -2071,34 +2857,201 @@ svn_cache__membuffer_clear(svn_membuffer_t *cache)
     {
       /* Unconditionally acquire the write lock. */
       SVN_ERR(force_write_lock_cache(&cache[seg]));
+      begin_write(&cache[seg]);
 
-      /* Mark all groups as "not initialized", which implies "empty". */
-      cache[seg].first_spare_group = NO_INDEX;
-      cache[seg].max_spare_used = 0;
+      reset_segment(&cache[seg]);
 
-      memset(cache[seg].group_initialized, 0, group_init_size);
+      /* Segment may be used again. */
+      SVN_ERR(unlock_cache(&cache[seg], end_write(&cache[seg],
+                                                  SVN_NO_ERROR)));
+    }
 
-      /* Unlink L1 contents. */
-      cache[seg].l1.first = NO_INDEX;
-      cache[seg].l1.last = NO_INDEX;
-      cache[seg].l1.next = NO_INDEX;
-      cache[seg].l1.current_data = cache[seg].l1.start_offset;
+  /* done here */
+  return SVN_NO_ERROR;
+}
 
-      /* Unlink L2 contents. */
-      cache[seg].l2.first = NO_INDEX;
-      cache[seg].l2.last = NO_INDEX;
-      cache[seg].l2.next = NO_INDEX;
-      cache[seg].l2.current_data = cache[seg].l2.start_offset;
+/* Return the data buffer size that segment CACHE shall use if the whole
+ * cache were limited to TOTAL_SIZE bytes.
+ */
+static apr_uint64_t
+get_resized_data_size(svn_membuffer_t *cache,
+                      apr_uint64_t total_size)
+{
+  apr_uint64_t shortfall;
 
-      /* Reset content counters. */
-      cache[seg].data_used = 0;
-      cache[seg].used_entries = 0;
+  /* We can't grow beyond what has been allocated. */
+  if (total_size >= cache->reserved_size)
+    return cache->data_capacity;
 
-      /* Segment may be used again. */
-      SVN_ERR(unlock_cache(&cache[seg], SVN_NO_ERROR));
+  /* The directory has a fixed size.  Hence, the data buffer has to absorb
+   * the whole difference. */
+  shortfall = ALIGN_VALUE((cache->reserved_size - total_size)
+                          / cache->segment_count);
+  if (shortfall + MIN_DATA_SIZE >= cache->data_capacity)
+    return MIN_DATA_SIZE;
+
+  return cache->data_capacity - shortfall;
+}
+
+svn_error_t *
+svn_cache__membuffer_resize(svn_membuffer_t *cache,
+                            apr_uint64_t total_size)
+{
+  apr_uint32_t seg;
+  apr_uint32_t segment_count = cache->segment_count;
+
+  /* Like svn_cache__membuffer_clear, handle one segment at a time. */
+  for (seg = 0; seg < segment_count; ++seg)
+    {
+      svn_membuffer_t *segment = &cache[seg];
+      apr_uint64_t data_size = get_resized_data_size(segment, total_size);
+
+      /* Keep the contents of segments whose size does not change. */
+      if (data_size == segment->l1.size + segment->l2.size)
+        continue;
+
+      SVN_ERR(force_write_lock_cache(segment));
+      begin_write(segment);
+
+      /* Entries may be anywhere in the data buffer, so we can't keep any
+       * of them when moving the level boundaries. */
+      reset_segment(segment);
+      init_levels(segment, data_size);
+
+      SVN_ERR(unlock_cache(segment, end_write(segment, SVN_NO_ERROR)));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Add the sizes of all entries in LEVEL of segment CACHE to the usage
+ * counters of their respective prefixes.
+ *
+ * Note: This function requires the caller to hold the write lock.
+ */
+static void
+count_prefix_usage(svn_membuffer_t *cache,
+                   cache_level_t *level)
+{
+  apr_uint32_t idx;
+  for (idx = level->first; idx != NO_INDEX; idx = get_entry(cache, idx)->next)
+    {
+      entry_t *entry = get_entry(cache, idx);
+      if (entry->key.stats_idx != NO_INDEX)
+        cache->prefix_used[entry->key.stats_idx] += entry->size;
+    }
+}
+
+svn_error_t *
+svn_cache__membuffer_set_prefix_quota(svn_membuffer_t *cache,
+                                      apr_uint64_t quota,
+                                      apr_pool_t *result_pool)
+{
+  apr_uint32_t seg;
+  apr_uint32_t segment_count = cache->segment_count;
+
+  /* Keys are evenly distributed over all segments, and so should be the
+   * quota.  Make sure that a non-zero quota does not become "unlimited". */
+  apr_uint64_t segment_quota = quota / segment_count;
+  if (quota && segment_quota == 0)
+    segment_quota = 1;
+
+#if SHARED_CACHE_SUPPORTED
+  /* Prefixes are only known per process. */
+  if (cache->global_lock)
+    return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                            _("Prefix quotas are not supported for "
+                              "shared caches"));
+#endif
+
+  for (seg = 0; seg < segment_count; ++seg)
+    {
+      svn_membuffer_t *segment = &cache[seg];
+
+      /* Allocate outside the lock.  Usage tracking, once enabled, stays
+       * enabled such that quotas may be changed at any time. */
+      apr_uint64_t *prefix_used
+        = segment->prefix_used
+        ? NULL
+        : apr_pcalloc(result_pool, segment->stats_prefixes->values_max
+                                     * sizeof(*prefix_used));
+
+      SVN_ERR(force_write_lock_cache(segment));
+      begin_write(segment);
+
+      if (segment->prefix_used == NULL)
+        {
+          segment->prefix_used = prefix_used;
+          count_prefix_usage(segment, &segment->l1);
+          count_prefix_usage(segment, &segment->l2);
+        }
+
+      segment->prefix_quota = segment_quota;
+
+      SVN_ERR(unlock_cache(segment, end_write(segment, SVN_NO_ERROR)));
     }
 
-  /* done here */
+  return SVN_NO_ERROR;
+}
+
+svn_boolean_t
+svn_cache__membuffer_set_optimistic_reads(svn_membuffer_t *cache,
+                                          svn_boolean_t enabled)
+{
+#if OPTIMISTIC_READS_SUPPORTED
+  apr_uint32_t seg;
+  apr_uint32_t segment_count = cache->segment_count;
+
+  /* Without a lock, there is nothing to bypass. */
+  if (   cache->lock == NULL
+#if SHARED_CACHE_SUPPORTED
+      && cache->global_lock == NULL
+#endif
+     )
+    return FALSE;
+
+  /* Writers maintain the segment versions unconditionally, so readers
+   * may switch between both modes at any time. */
+  for (seg = 0; seg < segment_count; ++seg)
+    cache[seg].optimistic_reads = enabled;
+
+  return enabled;
+#else
+  return FALSE;
+#endif
+}
+
+svn_error_t *
+svn_cache__membuffer_enable_admission_filter(svn_membuffer_t *cache,
+                                             apr_pool_t *result_pool)
+{
+  apr_uint32_t seg;
+  apr_uint32_t segment_count = cache->segment_count;
+
+  /* Make the sketch about as wide as there are entries per segment.
+   * More counters per row would not improve the estimates much. */
+  apr_uint32_t width = 1;
+  while (width < (cache->group_count + cache->spare_group_count) * GROUP_SIZE
+         && width < APR_UINT32_MAX / 2 / SKETCH_AGING_PERIOD)
+    width *= 2;
+
+#if SHARED_CACHE_SUPPORTED
+  /* The sketch would have to be in shared memory as well. */
+  if (cache->global_lock)
+    return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                            _("Admission filters are not supported for "
+                              "shared caches"));
+#endif
+
+  for (seg = 0; seg < segment_count; ++seg)
+    if (cache[seg].sketch == NULL)
+      {
+        cache[seg].sketch_width = width;
+        cache[seg].sketch_samples = 0;
+        cache[seg].sketch = apr_pcalloc(result_pool,
+                                        SKETCH_DEPTH * (apr_size_t)width);
+      }
+
   return SVN_NO_ERROR;
 }
 
@@ -2136,12 +3089,13 @@ entry_exists(svn_membuffer_t *cache,
   return SVN_NO_ERROR;
 }
 
-/* Given the SIZE and PRIORITY of a new item, return the cache level
+/* Given the KEY, SIZE and PRIORITY of a new item, return the cache level
    (L1 or L2) in fragment CACHE that this item shall be inserted into.
    If we can't find nor make enough room for the item, return NULL.
  */
 static cache_level_t *
 select_level(svn_membuffer_t *cache,
+             const entry_key_t *key,
              apr_size_t size,
              apr_uint32_t priority)
 {
@@ -2158,18 +3112,38 @@ select_level(svn_membuffer_t *cache,
     {
       /* Large but important items go into L2. */
       entry_t dummy_entry = { { { 0 } } };
+      dummy_entry.key = *key;
       dummy_entry.priority = priority;
       dummy_entry.size = size;
 
-      return ensure_data_insertable_l2(cache, &dummy_entry)
-           ? &cache->l2
-           : NULL;
+      if (ensure_data_insertable_l2(cache, &dummy_entry))
+        {
+          cache->l2_admissions++;
+          return &cache->l2;
+        }
+
+      cache->l2_rejections++;
+      return NULL;
     }
 
   /* Don't cache large, unimportant items. */
   return NULL;
 }
 
+/* Return TRUE if adding another SIZE bytes for KEY to segment CACHE
+ * would exceed the quota of KEY's prefix.
+ */
+static svn_boolean_t
+exceeds_prefix_quota(svn_membuffer_t *cache,
+                     const entry_key_t *key,
+                     apr_size_t size)
+{
+  return cache->prefix_quota
+      && cache->prefix_used
+      && key->stats_idx != NO_INDEX
+      && cache->prefix_used[key->stats_idx] + size > cache->prefix_quota;
+}
+
 /* Try to insert the serialized item given in BUFFER with ITEM_SIZE
  * into the group GROUP_INDEX of CACHE and uniquely identify it by
  * hash value TO_FIND.
@@ -2217,6 +3191,9 @@ membuffer_cache_set_internal(svn_membuffer_t *cache,
        * negative value.
        */
       cache->data_used += (apr_uint64_t)size - entry->size;
+      if (cache->prefix_used && entry->key.stats_idx != NO_INDEX)
+        cache->prefix_used[entry->key.stats_idx]
+          += (apr_uint64_t)size - entry->size;
       entry->size = size;
       entry->priority = priority;
 
@@ -2240,9 +3217,16 @@ membuffer_cache_set_internal(svn_membuffer_t *cache,
       return SVN_NO_ERROR;
     }
 
+  /* Prefixes that already use up their quota must not grow any further.
+   * Their old entries will still be evicted and replaced in due time.
+   */
+  if (buffer && exceeds_prefix_quota(cache, &to_find->entry_key, size))
+    buffer = NULL;
+
   /* if necessary, enlarge the insertion window.
    */
-  level = buffer ? select_level(cache, size, priority) : NULL;
+  level = buffer ? select_level(cache, &to_find->entry_key, size, priority)
+                 : NULL;
   if (level)
     {
       /* Remove old data for this key, if that exists.
@@ -2415,6 +3399,115 @@ membuffer_cache_get_internal(svn_membuffer_t *cache,
   return SVN_NO_ERROR;
 }
 
+#if OPTIMISTIC_READS_SUPPORTED
+
+/* Try to do what membuffer_cache_get_internal does but without holding
+ * the segment lock and without counting the read.  Return TRUE if a
+ * consistent result could be obtained and has been returned in *BUFFER
+ * and *ITEM_SIZE.  Otherwise, return FALSE and the caller should retry
+ * the lookup with the read lock being held.
+ */
+static svn_boolean_t
+membuffer_cache_get_optimistic(svn_membuffer_t *cache,
+                               apr_uint32_t group_index,
+                               const full_key_t *to_find,
+                               char **buffer,
+                               apr_size_t *item_size,
+                               apr_pool_t *result_pool)
+{
+  char *copy = NULL;
+  apr_size_t capacity = 0;
+  int attempt;
+
+  for (attempt = 0; attempt < MAX_OPTIMISTIC_READ_ATTEMPTS; ++attempt)
+    {
+      entry_t snapshot;
+      entry_t *entry;
+      apr_size_t size;
+
+      /* Odd versions indicate an ongoing write. */
+      svn_atomic_t version = svn_atomic_read(&cache->version);
+      if (version & 1)
+        continue;
+
+      MEMORY_BARRIER();
+      entry = find_entry_optimistic(cache, group_index, to_find, &snapshot);
+
+      /* Never allocate memory based on a torn entry. */
+      MEMORY_BARRIER();
+      if (svn_atomic_read(&cache->version) != version)
+        continue;
+
+      if (entry == NULL)
+        {
+          *buffer = NULL;
+          *item_size = 0;
+
+          return TRUE;
+        }
+
+      size = ALIGN_VALUE(snapshot.size) - snapshot.key.key_len;
+      if (size > capacity || copy == NULL)
+        {
+          copy = apr_palloc(result_pool, size);
+          capacity = size;
+        }
+
+      memcpy(copy, cache->data + snapshot.offset + snapshot.key.key_len, size);
+
+      /* Did a writer interfere with our copy operation? */
+      MEMORY_BARRIER();
+      if (svn_atomic_read(&cache->version) != version)
+        continue;
+
+      *buffer = copy;
+      *item_size = snapshot.size - snapshot.key.key_len;
+
+      return TRUE;
+    }
+
+  return FALSE;
+}
+
+/* Try to do what membuffer_cache_has_key_internal does but without holding
+ * the segment lock and without counting a hit.  Return TRUE if a consistent
+ * result could be obtained and has been returned in *FOUND.  Otherwise,
+ * return FALSE and the caller should retry the lookup with the read lock
+ * being held.
+ */
+static svn_boolean_t
+membuffer_cache_has_key_optimistic(svn_membuffer_t *cache,
+                                   apr_uint32_t group_index,
+                                   const full_key_t *to_find,
+                                   svn_boolean_t *found)
+{
+  int attempt;
+
+  for (attempt = 0; attempt < MAX_OPTIMISTIC_READ_ATTEMPTS; ++attempt)
+    {
+      entry_t snapshot;
+      entry_t *entry;
+
+      svn_atomic_t version = svn_atomic_read(&cache->version);
+      if (version & 1)
+        continue;
+
+      MEMORY_BARRIER();
+      entry = find_entry_optimistic(cache, group_index, to_find, &snapshot);
+
+      MEMORY_BARRIER();
+      if (svn_atomic_read(&cache->version) != version)
+        continue;
+
+      *found = entry != NULL;
+      return TRUE;
+    }
+
+  return FALSE;
+}
+
+#endif
+
 /* Look for the *ITEM identified by KEY. If no item has been stored
  * for KEY, *ITEM will be NULL. Otherwise, the DESERIALIZER is called
  * to re-construct the proper object from the serialized data.
@@ -2435,14 +3528,22 @@ membuffer_cache_get(svn_membuffer_t *cache,
   /* find the entry group that will hold the key.
    */
   group_index = get_group_index(&cache, &key->entry_key);
-  WITH_READ_LOCK(cache,
-                 membuffer_cache_get_internal(cache,
-                                              group_index,
-                                              key,
-                                              &buffer,
-                                              &size,
-                                              DEBUG_CACHE_MEMBUFFER_TAG
-                                              result_pool));
+  record_access(cache, &key->entry_key);
+
+#if OPTIMISTIC_READS_SUPPORTED
+  /* Try without locking first. */
+  if (   !cache->optimistic_reads
+      || !membuffer_cache_get_optimistic(cache, group_index, key,
+                                         &buffer, &size, result_pool))
+#endif
+    WITH_READ_LOCK(cache,
+                   membuffer_cache_get_internal(cache,
+                                                group_index,
+                                                key,
+                                                &buffer,
+                                                &size,
+                                                DEBUG_CACHE_MEMBUFFER_TAG
+                                                result_pool));
 
   /* re-construct the original data object from its serialized form.
    */
@@ -2499,11 +3600,16 @@ membuffer_cache_has_key(svn_membuffer_t *cache,
   apr_uint32_t group_index = get_group_index(&cache, &key->entry_key);
   cache->total_reads++;
 
-  WITH_READ_LOCK(cache,
-                 membuffer_cache_has_key_internal(cache,
-                                                  group_index,
-                                                  key,
-                                                  found));
+#if OPTIMISTIC_READS_SUPPORTED
+  /* Try without locking first. */
+  if (   !cache->optimistic_reads
+      || !membuffer_cache_has_key_optimistic(cache, group_index, key, found))
+#endif
+    WITH_READ_LOCK(cache,
+                   membuffer_cache_has_key_internal(cache,
+                                                    group_index,
+                                                    key,
+                                                    found));
 
   return SVN_NO_ERROR;
 }
@@ -2582,6 +3688,7 @@ membuffer_cache_get_partial(svn_membuffer_t *cache,
                             apr_pool_t *result_pool)
 {
   apr_uint32_t group_index = get_group_index(&cache, &key->entry_key);
+  record_access(cache, &key->entry_key);
 
   WITH_READ_LOCK(cache,
                  membuffer_cache_get_partial_internal
@@ -2735,6 +3842,343 @@ membuffer_cache_set_partial(svn_membuffer_t *cache,
   return SVN_NO_ERROR;
 }
 
+/* Snapshot file support.
+ *
+ * A snapshot starts with SNAPSHOT_MAGIC, followed by the SVN_VERSION
+ * string of the writer and the SNAPSHOT_LAYOUT_CHECK value in native
+ * byte order.  Serialized items are only valid for the exact same build
+ * on the same platform, so any difference in that header makes us ignore
+ * the whole file.
+ *
+ * The header is followed by a sequence of snapshot_record_t, each one
+ * followed by the PREFIX_LEN bytes of the shared key prefix (no NUL), the
+ * KEY_LEN bytes of the full key and ITEM_SIZE bytes of serialized data.
+ * A record with both, PREFIX_LEN and KEY_LEN, being 0 terminates the
+ * sequence.
+ *
+ * All keys contain the respective cache's prefix in full, which e.g. for
+ * FSFS contains the repository UUID and instance ID, while the variable
+ * key parts identify the revision.  Hence, entries of other repositories
+ * or those of a repository that got replaced will never be hit.
+ */
+#define SNAPSHOT_MAGIC "SVN membuffer snapshot 1\n"
+
+/* Changes with byte order and pointer size. */
+#define SNAPSHOT_LAYOUT_CHECK \
+  ((apr_uint32_t)(0x01020300 + sizeof(void *)))
+
+/* Per-item header within a snapshot file.  See above.
+ */
+typedef struct snapshot_record_t
+{
+  /* The entry key's fingerprint. */
+  apr_uint64_t fingerprint[2];
+
+  /* Length of the full key, 0 if the entry uses a shared prefix. */
+  apr_uint64_t key_len;
+
+  /* Size of the serialized item in bytes, excluding the key. */
+  apr_uint64_t item_size;
+
+  /* Length of the shared prefix, 0 if the full key gets stored. */
+  apr_uint32_t prefix_len;
+
+  /* Priority of the entry. */
+  apr_uint32_t priority;
+} snapshot_record_t;
+
+/* Write all entries in LEVEL of segment CACHE to FILE, oldest first.
+ *
+ * Note: This function requires the caller to hold a read lock on CACHE.
+ */
+static svn_error_t *
+write_snapshot_level(svn_membuffer_t *cache,
+                     cache_level_t *level,
+                     apr_file_t *file,
+                     apr_pool_t *scratch_pool)
+{
+  apr_uint32_t idx;
+  for (idx = level->first; idx != NO_INDEX; idx = get_entry(cache, idx)->next)
+    {
+      entry_t *entry = get_entry(cache, idx);
+      snapshot_record_t record = { { 0 } };
+      const char *prefix = NULL;
+
+      record.fingerprint[0] = entry->key.fingerprint[0];
+      record.fingerprint[1] = entry->key.fingerprint[1];
+      record.key_len = entry->key.key_len;
+      record.item_size = entry->size - entry->key.key_len;
+      record.priority = entry->priority;
+
+      if (entry->key.key_len == 0)
+        {
+          prefix = cache->prefix_pool->values[entry->key.prefix_idx];
+          record.prefix_len = (apr_uint32_t)strlen(prefix);
+        }
+
+      SVN_ERR(svn_io_file_write_full(file, &record, sizeof(record), NULL,
+                                     scratch_pool));
+      if (prefix)
+        SVN_ERR(svn_io_file_write_full(file, prefix, record.prefix_len,
+                                       NULL, scratch_pool));
+
+      /* The full key is immediately followed by the serialized item. */
+      SVN_ERR(svn_io_file_write_full(file, cache->data + entry->offset,
+                                     entry->size, NULL, scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Write all entries of segment CACHE to FILE.  L2 contents get written
+ * first such that the most recent L1 contents will be inserted last upon
+ * reload.
+ *
+ * Note: This function requires the caller to hold a read lock on CACHE.
+ */
+static svn_error_t *
+write_snapshot_segment(svn_membuffer_t *cache,
+                       apr_file_t *file,
+                       apr_pool_t *scratch_pool)
+{
+  SVN_ERR(write_snapshot_level(cache, &cache->l2, file, scratch_pool));
+  SVN_ERR(write_snapshot_level(cache, &cache->l1, file, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Write the snapshot header to FILE.  Use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+write_snapshot_header(apr_file_t *file,
+                      apr_pool_t *scratch_pool)
+{
+  apr_uint32_t layout = SNAPSHOT_LAYOUT_CHECK;
+  const char *version = SVN_VERSION "\n";
+
+  SVN_ERR(svn_io_file_write_full(file, SNAPSHOT_MAGIC,
+                                 sizeof(SNAPSHOT_MAGIC) - 1, NULL,
+                                 scratch_pool));
+  SVN_ERR(svn_io_file_write_full(file, version, strlen(version), NULL,
+                                 scratch_pool));
+  SVN_ERR(svn_io_file_write_full(file, &layout, sizeof(layout), NULL,
+                                 scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the snapshot header from FILE and set *VALID to FALSE if it does
+ * not match what write_snapshot_header() would produce in this process.
+ * Use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+read_snapshot_header(svn_boolean_t *valid,
+                     apr_file_t *file,
+                     apr_pool_t *scratch_pool)
+{
+  const char *version = SVN_VERSION "\n";
+  apr_size_t magic_len = sizeof(SNAPSHOT_MAGIC) - 1;
+  apr_size_t version_len = strlen(version);
+  apr_size_t len = magic_len + version_len + sizeof(apr_uint32_t);
+  char *buffer = apr_palloc(scratch_pool, len);
+  apr_uint32_t layout;
+  svn_boolean_t eof;
+
+  SVN_ERR(svn_io_file_read_full2(file, buffer, len, NULL, &eof,
+                                 scratch_pool));
+  memcpy(&layout, buffer + magic_len + version_len, sizeof(layout));
+
+  *valid = !eof
+        && !memcmp(buffer, SNAPSHOT_MAGIC, magic_len)
+        && !memcmp(buffer + magic_len, version, version_len)
+        && layout == SNAPSHOT_LAYOUT_CHECK;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_cache__membuffer_save(svn_membuffer_t *cache,
+                          const char *path,
+                          apr_pool_t *scratch_pool)
+{
+  apr_uint32_t seg;
+  apr_file_t *file;
+  const char *temp_path;
+  snapshot_record_t end_marker = { { 0 } };
+  svn_error_t *err;
+
+  /* Write to a temporary file first and move it into place only when
+   * complete.  That way, readers won't see partial snapshots. */
+  SVN_ERR(svn_io_open_unique_file3(&file, &temp_path,
+                                   svn_dirent_dirname(path, scratch_pool),
+                                   svn_io_file_del_none,
+                                   scratch_pool, scratch_pool));
+
+  err = write_snapshot_header(file, scratch_pool);
+  for (seg = 0; seg < cache->segment_count && !err; ++seg)
+    {
+      svn_membuffer_t *segment = &cache[seg];
+      err = read_lock_cache(segment);
+      if (!err)
+        err = unlock_cache(segment,
+                           write_snapshot_segment(segment, file,
+                                                  scratch_pool));
+    }
+
+  if (!err)
+    err = svn_io_file_write_full(file, &end_marker, sizeof(end_marker),
+                                 NULL, scratch_pool);
+
+  err = svn_error_compose_create(err, svn_io_file_close(file, scratch_pool));
+  if (!err)
+    err = svn_io_file_rename2(temp_path, path, FALSE, scratch_pool);
+
+  if (err)
+    return svn_error_compose_create(err,
+                                    svn_io_remove_file2(temp_path, TRUE,
+                                                        scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the next entry from the snapshot FILE and store it in CACHE.
+ * If the end marker has been reached, set *DONE.  Use KEY_BUFFER,
+ * PREFIX_BUFFER and ITEM_BUFFER as growable buffers for the respective
+ * record parts.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+load_snapshot_record(svn_boolean_t *done,
+                     svn_membuffer_t *cache,
+                     apr_file_t *file,
+                     full_key_t *key,
+                     svn_membuf_t *prefix_buffer,
+                     svn_membuf_t *item_buffer,
+                     apr_pool_t *scratch_pool)
+{
+  snapshot_record_t record;
+#ifndef SVN_DEBUG_CACHE_MEMBUFFER
+  apr_uint32_t group_index;
+  svn_membuffer_t *segment = cache;
+#endif
+
+  SVN_ERR(svn_io_file_read_full2(file, &record, sizeof(record), NULL, NULL,
+                                 scratch_pool));
+
+  *done = record.key_len == 0 && record.prefix_len == 0;
+  if (*done)
+    return SVN_NO_ERROR;
+
+  /* Each entry has either a full key or a shared prefix.  Sizes must be
+   * within the limits that we would accept upon insertion. */
+  if (   (record.key_len != 0 && record.prefix_len != 0)
+      || record.key_len != ALIGN_VALUE(record.key_len)
+      || record.key_len >= SVN_MAX_OBJECT_SIZE
+      || record.prefix_len >= SVN_MAX_OBJECT_SIZE
+      || record.item_size > MAX_ITEM_SIZE)
+    return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                            _("Corrupt cache snapshot entry"));
+
+  key->entry_key.fingerprint[0] = record.fingerprint[0];
+  key->entry_key.fingerprint[1] = record.fingerprint[1];
+  key->entry_key.key_len = (apr_size_t)record.key_len;
+  key->entry_key.prefix_idx = NO_INDEX;
+  key->entry_key.stats_idx = NO_INDEX;
+
+  if (record.prefix_len)
+    {
+      svn_membuf__ensure(prefix_buffer, record.prefix_len + 1);
+      SVN_ERR(svn_io_file_read_full2(file, prefix_buffer->data,
+                                     record.prefix_len, NULL, NULL,
+                                     scratch_pool));
+      ((char *)prefix_buffer->data)[record.prefix_len] = '\0';
+
+      /* The prefix index is process-specific.  If this cache won't
+       * accept any more shared prefixes, we can't store this item. */
+      SVN_ERR(prefix_pool_get(&key->entry_key.prefix_idx,
+                              cache->prefix_pool, prefix_buffer->data));
+    }
+  else
+    {
+      svn_membuf__ensure(&key->full_key, (apr_size_t)record.key_len);
+      SVN_ERR(svn_io_file_read_full2(file, key->full_key.data,
+                                     (apr_size_t)record.key_len, NULL, NULL,
+                                     scratch_pool));
+    }
+
+  svn_membuf__ensure(item_buffer, (apr_size_t)record.item_size);
+  SVN_ERR(svn_io_file_read_full2(file, item_buffer->data,
+                                 (apr_size_t)record.item_size, NULL, NULL,
+                                 scratch_pool));
+
+  /* Skip entries whose key we cannot represent in this cache. */
+  if (record.prefix_len && key->entry_key.prefix_idx == NO_INDEX)
+    return SVN_NO_ERROR;
+
+#ifndef SVN_DEBUG_CACHE_MEMBUFFER
+  /* With consistency checks enabled, we don't load anything because we
+   * don't have the original key and type information to construct the
+   * entry tags from. */
+  group_index = get_group_index(&segment, &key->entry_key);
+  WITH_WRITE_LOCK(segment,
+                  membuffer_cache_set_internal(segment,
+                                               key,
+                                               group_index,
+                                               item_buffer->data,
+                                               (apr_size_t)record.item_size,
+                                               record.priority,
+                                               scratch_pool));
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_cache__membuffer_load(svn_membuffer_t *cache,
+                          const char *path,
+                          apr_pool_t *scratch_pool)
+{
+  apr_file_t *file;
+  svn_boolean_t valid;
+  svn_boolean_t done = FALSE;
+  full_key_t key;
+  svn_membuf_t prefix_buffer;
+  svn_membuf_t item_buffer;
+  apr_pool_t *iterpool;
+  svn_error_t *err;
+
+  err = svn_io_file_open(&file, path, APR_READ | APR_BUFFERED,
+                         APR_OS_DEFAULT, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      /* No snapshot, start cold. */
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  /* Snapshots from other builds are simply ignored. */
+  SVN_ERR(read_snapshot_header(&valid, file, scratch_pool));
+  if (!valid)
+    return svn_error_trace(svn_io_file_close(file, scratch_pool));
+
+  svn_membuf__create(&key.full_key, 256, scratch_pool);
+  svn_membuf__create(&prefix_buffer, 256, scratch_pool);
+  svn_membuf__create(&item_buffer, 0x10000, scratch_pool);
+
+  iterpool = svn_pool_create(scratch_pool);
+  while (!done && !err)
+    {
+      svn_pool_clear(iterpool);
+      err = load_snapshot_record(&done, cache, file, &key, &prefix_buffer,
+                                 &item_buffer, iterpool);
+    }
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(
+           svn_error_compose_create(err,
+                                    svn_io_file_close(file, scratch_pool)));
+}
+
 /* Implement the svn_cache__t interface on top of a shared membuffer cache.
  *
  * Because membuffer caches tend to be very large, there will be rather few
@@ -2785,6 +4229,11 @@ typedef struct svn_membuffer_cache_t
    */
   full_key_t combined_key;
 
+  /* Statistics shared with all other instances using the same prefix.
+   * May be NULL if the membuffer cache can't track any more prefixes.
+   */
+  prefix_stats_t *stats;
+
   /* if enabled, this will serialize the access to this instance.
    */
   svn_mutex__t *mutex;
@@ -2936,6 +4385,12 @@ svn_membuffer_cache_get(void **value_p,
 
   /* return result */
   *found = *value_p != NULL;
+  if (cache->stats)
+    {
+      cache->stats->gets++;
+      if (*found)
+        cache->stats->hits++;
+    }
 
   return SVN_NO_ERROR;
 }
@@ -2992,6 +4447,8 @@ svn_membuffer_cache_set(void *cache_void,
    * this cache instances' prefix
    */
   combine_key(cache, key, cache->key_len);
+  if (cache->stats)
+    cache->stats->sets++;
 
   /* (probably) add the item to the cache. But there is no real guarantee
    * that the item will actually be cached afterwards.
@@ -3050,6 +4507,12 @@ svn_membuffer_cache_get_partial(void **value_p,
                                       baton,
                                       DEBUG_CACHE_MEMBUFFER_TAG
                                       result_pool));
+  if (cache->stats)
+    {
+      cache->stats->gets++;
+      if (*found)
+        cache->stats->hits++;
+    }
 
   return SVN_NO_ERROR;
 }
@@ -3114,6 +4577,9 @@ svn_membuffer_get_segment_info(svn_membuffer_t *segment,
   info->used_entries += segment->used_entries;
   info->total_entries += segment->group_count * GROUP_SIZE;
 
+  info->l2_admissions += segment->l2_admissions;
+  info->l2_rejections += segment->l2_rejections;
+
   if (include_histogram)
     for (i = 0; i < segment->group_count; ++i)
       if (is_group_initialized(segment, i))
@@ -3168,7 +4634,9 @@ static svn_cache__vtable_t membuffer_cache_vtable = {
   svn_membuffer_cache_is_cachable,
   svn_membuffer_cache_get_partial,
   svn_membuffer_cache_set_partial,
-  svn_membuffer_cache_get_info
+  svn_membuffer_cache_get_info,
+  NULL,                   /* use the generic get_multi */
+  NULL                    /* use the generic set_multi */
 };
 
 /* Implement svn_cache__vtable_t.get and serialize all cache access.
@@ -3281,7 +4749,9 @@ static svn_cache__vtable_t membuffer_cache_synced_vtable = {
   svn_membuffer_cache_is_cachable,        /* no sync required */
   svn_membuffer_cache_get_partial_synced,
   svn_membuffer_cache_set_partial_synced,
-  svn_membuffer_cache_get_info            /* no sync required */
+  svn_membuffer_cache_get_info,           /* no sync required */
+  NULL,                                   /* use the generic get_multi */
+  NULL                                    /* use the generic set_multi */
 };
 
 /* standard serialization function for svn_stringbuf_t items.
@@ -3389,6 +4859,19 @@ svn_cache__create_membuffer_cache(svn_cache__t **cache_p,
   else
     cache->prefix.prefix_idx = NO_INDEX;
 
+  /* Attribute accesses and evictions to this prefix.  Entries in caches
+   * shared between processes may be evicted by any process, so we can't
+   * use process-specific indexes for them. */
+  SVN_ERR(prefix_pool_get(&cache->prefix.stats_idx,
+                          membuffer->stats_prefixes,
+                          prefix));
+  if (cache->prefix.stats_idx != NO_INDEX)
+    cache->stats = &membuffer->prefix_stats[cache->prefix.stats_idx];
+#if SHARED_CACHE_SUPPORTED
+  if (membuffer->global_lock)
+    cache->prefix.stats_idx = NO_INDEX;
+#endif
+
   /* If key combining is not guaranteed to produce unique results, we have
    * to handle full keys.  Otherwise, leave it NULL. */
   if (cache->prefix.prefix_idx == NO_INDEX)
@@ -3410,6 +4893,7 @@ svn_cache__create_membuffer_cache(svn_cache__t **cache_p,
        * it.  Keep the fingerprint 0 as well b/c it will always be set anew
        * by combine_key(). */
       cache->combined_key.entry_key.prefix_idx = cache->prefix.prefix_idx;
+      cache->combined_key.entry_key.stats_idx = cache->prefix.stats_idx;
       cache->combined_key.entry_key.key_len = 0;
     }
 
@@ -3460,3 +4944,129 @@ svn_cache__membuffer_get_global_info(apr_pool_t *pool)
 
   return info;
 }
+
+/* Return the element for PREFIX in HASH, mapping prefixes to
+ * svn_cache__prefix_info_t.  Create a new element in RESULT_POOL if
+ * necessary.
+ */
+static svn_cache__prefix_info_t *
+get_prefix_info_entry(apr_hash_t *hash,
+                      const char *prefix,
+                      apr_pool_t *result_pool)
+{
+  svn_cache__prefix_info_t *entry = svn_hash_gets(hash, prefix);
+  if (entry == NULL)
+    {
+      entry = apr_pcalloc(result_pool, sizeof(*entry));
+      entry->prefix = apr_pstrdup(result_pool, prefix);
+      svn_hash_sets(hash, entry->prefix, entry);
+    }
+
+  return entry;
+}
+
+/* Add the access counters of all prefixes registered with the membuffer
+ * CACHE to HASH, mapping prefixes to svn_cache__prefix_info_t allocated
+ * in RESULT_POOL.
+ *
+ * Note: This function requires the caller to hold the lock on
+ * CACHE->STATS_PREFIXES.
+ */
+static svn_error_t *
+get_registered_prefix_info(svn_membuffer_t *cache,
+                           apr_hash_t *hash,
+                           apr_pool_t *result_pool)
+{
+  apr_uint32_t i;
+  for (i = 0; i < cache->stats_prefixes->values_used; ++i)
+    {
+      const prefix_stats_t *stats = &cache->prefix_stats[i];
+      svn_cache__prefix_info_t *entry
+        = get_prefix_info_entry(hash, cache->stats_prefixes->values[i],
+                                result_pool);
+
+      entry->gets = stats->gets;
+      entry->hits = stats->hits;
+      entry->sets = stats->sets;
+      entry->evictions = stats->evictions;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Add the number and size of all entries in LEVEL of segment CACHE to
+ * their respective prefix in HASH, mapping prefixes to
+ * svn_cache__prefix_info_t allocated in RESULT_POOL.
+ *
+ * Note: This function requires the caller to hold a read lock on CACHE.
+ */
+static void
+get_level_prefix_info(svn_membuffer_t *cache,
+                      cache_level_t *level,
+                      apr_hash_t *hash,
+                      apr_pool_t *result_pool)
+{
+  apr_uint32_t idx;
+  for (idx = level->first; idx != NO_INDEX; idx = get_entry(cache, idx)->next)
+    {
+      entry_t *entry = get_entry(cache, idx);
+      svn_cache__prefix_info_t *info;
+
+      /* Full keys start with the NUL-terminated prefix. */
+      const char *prefix = entry->key.key_len
+                         ? (const char *)cache->data + entry->offset
+                         : cache->prefix_pool->values[entry->key.prefix_idx];
+
+      info = get_prefix_info_entry(hash, prefix, result_pool);
+      info->used_entries++;
+      info->used_size += entry->size;
+    }
+}
+
+/* Call get_level_prefix_info for both levels of segment CACHE.
+ *
+ * Note: This function requires the caller to hold a read lock on CACHE.
+ */
+static svn_error_t *
+get_segment_prefix_info(svn_membuffer_t *cache,
+                        apr_hash_t *hash,
+                        apr_pool_t *result_pool)
+{
+  get_level_prefix_info(cache, &cache->l1, hash, result_pool);
+  get_level_prefix_info(cache, &cache->l2, hash, result_pool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_cache__membuffer_get_prefix_info(apr_array_header_t **info,
+                                     svn_membuffer_t *cache,
+                                     apr_pool_t *result_pool,
+                                     apr_pool_t *scratch_pool)
+{
+  apr_uint32_t seg;
+  apr_uint32_t segment_count = cache->segment_count;
+  apr_hash_t *hash = svn_hash__make(scratch_pool);
+  apr_array_header_t *sorted;
+  int i;
+
+  SVN_MUTEX__WITH_LOCK(cache->stats_prefixes->mutex,
+                       get_registered_prefix_info(cache, hash, result_pool));
+
+  for (seg = 0; seg < segment_count; ++seg)
+    {
+      svn_membuffer_t *segment = cache + seg;
+      WITH_READ_LOCK(segment,
+                     get_segment_prefix_info(segment, hash, result_pool));
+    }
+
+  sorted = svn_sort__hash(hash, svn_sort_compare_items_lexically,
+                          scratch_pool);
+  *info = apr_array_make(result_pool, sorted->nelts,
+                         sizeof(svn_cache__prefix_info_t *));
+  for (i = 0; i < sorted->nelts; ++i)
+    APR_ARRAY_PUSH(*info, svn_cache__prefix_info_t *)
+      = APR_ARRAY_IDX(sorted, i, svn_sort__item_t).value;
+
+  return SVN_NO_ERROR;
+}
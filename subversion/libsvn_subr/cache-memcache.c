@@ -176,6 +176,34 @@ memcache_internal_get(char **data,
 }
 
 
+/* De-serialize the DATA_LEN bytes of DATA read from CACHE into *VALUE_P.
+ * DATA must have been allocated in RESULT_POOL, which will also be used
+ * for the result.
+ */
+static svn_error_t *
+deserialize_value(void **value_p,
+                  memcache_t *cache,
+                  char *data,
+                  apr_size_t data_len,
+                  apr_pool_t *result_pool)
+{
+  if (cache->deserialize_func)
+    {
+      SVN_ERR((cache->deserialize_func)(value_p, data, data_len,
+                                        result_pool));
+    }
+  else
+    {
+      svn_stringbuf_t *value = svn_stringbuf_create_empty(result_pool);
+      value->data = data;
+      value->blocksize = data_len;
+      value->len = data_len - 1; /* account for trailing NUL */
+      *value_p = value;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 memcache_get(void **value_p,
              svn_boolean_t *found,
@@ -195,22 +223,63 @@ memcache_get(void **value_p,
 
   /* If we found it, de-serialize it. */
   if (*found)
+    SVN_ERR(deserialize_value(value_p, cache, data, data_len, result_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement vtable.get_multi using a single memcached multi-get request.
+ */
+static svn_error_t *
+memcache_get_multi(void **values,
+                   svn_boolean_t *found,
+                   void *cache_void,
+                   const void *const *keys,
+                   int count,
+                   apr_pool_t *result_pool)
+{
+  memcache_t *cache = cache_void;
+  apr_pool_t *subpool = svn_pool_create(result_pool);
+  const char **mc_keys = apr_pcalloc(subpool, count * sizeof(*mc_keys));
+  apr_hash_t *mc_values = apr_hash_make(subpool);
+  apr_status_t apr_err;
+  int i;
+
+  for (i = 0; i < count; ++i)
+    if (keys[i])
+      {
+        SVN_ERR(build_key(&mc_keys[i], cache, keys[i], subpool));
+        apr_memcache_add_multget_key(subpool, mc_keys[i], &mc_values);
+      }
+
+  if (apr_hash_count(mc_values) == 0)
     {
-      if (cache->deserialize_func)
-        {
-          SVN_ERR((cache->deserialize_func)(value_p, data, data_len,
-                                            result_pool));
-        }
-      else
-        {
-          svn_stringbuf_t *value = svn_stringbuf_create_empty(result_pool);
-          value->data = data;
-          value->blocksize = data_len;
-          value->len = data_len - 1; /* account for trailing NUL */
-          *value_p = value;
-        }
+      svn_pool_destroy(subpool);
+      return SVN_NO_ERROR;
     }
 
+  /* Values will be allocated in RESULT_POOL such that we can
+   * de-serialize them in-place. */
+  apr_err = apr_memcache_multgetp(cache->memcache, subpool, result_pool,
+                                  mc_values);
+  if (apr_err != APR_SUCCESS)
+    return svn_error_wrap_apr(apr_err,
+                              _("Unknown memcached error while reading"));
+
+  for (i = 0; i < count; ++i)
+    if (mc_keys[i])
+      {
+        apr_memcache_value_t *value = apr_hash_get(mc_values, mc_keys[i],
+                                                   APR_HASH_KEY_STRING);
+        if (value && value->status == APR_SUCCESS && value->data)
+          {
+            SVN_ERR(deserialize_value(&values[i], cache, value->data,
+                                      value->len, result_pool));
+            found[i] = TRUE;
+          }
+      }
+
+  svn_pool_destroy(subpool);
   return SVN_NO_ERROR;
 }
 
@@ -293,6 +362,29 @@ memcache_set(void *cache_void,
   return err;
 }
 
+/* Implement vtable.set_multi.  apr_memcache has no way to pipeline
+ * requests, so this only saves on the temporary allocations.
+ */
+static svn_error_t *
+memcache_set_multi(void *cache_void,
+                   const void *const *keys,
+                   void *const *values,
+                   int count,
+                   apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  for (i = 0; i < count; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(memcache_set(cache_void, keys[i], values[i], iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 memcache_get_partial(void **value_p,
                      svn_boolean_t *found,
@@ -398,7 +490,9 @@ static svn_cache__vtable_t memcache_vtable = {
   memcache_is_cachable,
   memcache_get_partial,
   memcache_set_partial,
-  memcache_get_info
+  memcache_get_info,
+  memcache_get_multi,
+  memcache_set_multi
 };
 
 svn_error_t *
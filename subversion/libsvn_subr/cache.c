@@ -23,6 +23,8 @@
 
 #include "cache.h"
 
+#include "private/svn_probes.h"
+
 svn_error_t *
 svn_cache__set_error_handler(svn_cache__t *cache,
                              svn_cache__error_handler_t handler,
@@ -81,6 +83,7 @@ svn_cache__get(void **value_p,
 #endif
 
   cache->reads++;
+  SVN_PROBE1(cache__get__start, cache);
   err = handle_error(cache,
                      (cache->vtable->get)(value_p,
                                           found,
@@ -91,6 +94,7 @@ svn_cache__get(void **value_p,
 
   if (*found)
     cache->hits++;
+  SVN_PROBE2(cache__get__done, cache, *found);
 
   return err;
 }
@@ -121,13 +125,19 @@ svn_cache__set(svn_cache__t *cache,
                void *value,
                apr_pool_t *scratch_pool)
 {
+  svn_error_t *err;
+
   cache->writes++;
-  return handle_error(cache,
-                      (cache->vtable->set)(cache->cache_internal,
-                                           key,
-                                           value,
-                                           scratch_pool),
-                      scratch_pool);
+  SVN_PROBE1(cache__set__start, cache);
+  err = handle_error(cache,
+                     (cache->vtable->set)(cache->cache_internal,
+                                          key,
+                                          value,
+                                          scratch_pool),
+                     scratch_pool);
+  SVN_PROBE1(cache__set__done, cache);
+
+  return err;
 }
 
 
@@ -204,6 +214,113 @@ svn_cache__set_partial(svn_cache__t *cache,
                       scratch_pool);
 }
 
+/* Implement svn_cache__vtable_t.get_multi in terms of repeated calls
+   to the GET function of CACHE.  The parameters are the same as for
+   svn_cache__get_multi(). */
+static svn_error_t *
+generic_get_multi(void **values,
+                  svn_boolean_t *found,
+                  svn_cache__t *cache,
+                  const void *const *keys,
+                  int count,
+                  apr_pool_t *result_pool)
+{
+  int i;
+  for (i = 0; i < count; ++i)
+    if (keys[i])
+      SVN_ERR((cache->vtable->get)(&values[i],
+                                   &found[i],
+                                   cache->cache_internal,
+                                   keys[i],
+                                   result_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_cache__vtable_t.set_multi in terms of repeated calls
+   to the SET function of CACHE.  The parameters are the same as for
+   svn_cache__set_multi(). */
+static svn_error_t *
+generic_set_multi(svn_cache__t *cache,
+                  const void *const *keys,
+                  void *const *values,
+                  int count,
+                  apr_pool_t *scratch_pool)
+{
+  int i;
+  for (i = 0; i < count; ++i)
+    if (keys[i])
+      SVN_ERR((cache->vtable->set)(cache->cache_internal,
+                                   keys[i],
+                                   values[i],
+                                   scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_cache__get_multi(void **values,
+                     svn_boolean_t *found,
+                     svn_cache__t *cache,
+                     const void *const *keys,
+                     int count,
+                     apr_pool_t *result_pool)
+{
+  svn_error_t *err;
+  int i;
+
+  /* In case any errors happen and are quelched, make sure we start
+     out with FOUND set to false. */
+  for (i = 0; i < count; ++i)
+    {
+      values[i] = NULL;
+      found[i] = FALSE;
+    }
+#ifdef SVN_DEBUG
+  if (cache->pretend_empty)
+    return SVN_NO_ERROR;
+#endif
+
+  cache->reads += count;
+  err = handle_error(cache,
+                     cache->vtable->get_multi
+                       ? (cache->vtable->get_multi)(values,
+                                                    found,
+                                                    cache->cache_internal,
+                                                    keys,
+                                                    count,
+                                                    result_pool)
+                       : generic_get_multi(values, found, cache, keys, count,
+                                           result_pool),
+                     result_pool);
+
+  for (i = 0; i < count; ++i)
+    if (found[i])
+      cache->hits++;
+
+  return err;
+}
+
+svn_error_t *
+svn_cache__set_multi(svn_cache__t *cache,
+                     const void *const *keys,
+                     void *const *values,
+                     int count,
+                     apr_pool_t *scratch_pool)
+{
+  cache->writes += count;
+  return handle_error(cache,
+                      cache->vtable->set_multi
+                        ? (cache->vtable->set_multi)(cache->cache_internal,
+                                                     keys,
+                                                     values,
+                                                     count,
+                                                     scratch_pool)
+                        : generic_set_multi(cache, keys, values, count,
+                                            scratch_pool),
+                      scratch_pool);
+}
+
 svn_error_t *
 svn_cache__get_info(svn_cache__t *cache,
                     svn_cache__info_t *info,
@@ -300,7 +417,9 @@ svn_cache__format_info(const svn_cache__info_t *info,
                             " of %" APR_UINT64_T_FMT " MB data cache"
                             " / %" APR_UINT64_T_FMT " MB total cache memory\n"
                             "          %" APR_UINT64_T_FMT " entries (%5.2f%%)"
-                            " of %" APR_UINT64_T_FMT " total\n%s",
+                            " of %" APR_UINT64_T_FMT " total\n"
+                            "L2      : %" APR_UINT64_T_FMT " admitted, %"
+                            APR_UINT64_T_FMT " rejected\n%s",
 
                             info->id,
 
@@ -315,5 +434,52 @@ svn_cache__format_info(const svn_cache__info_t *info,
 
                             info->used_entries, data_entry_rate,
                             info->total_entries,
+                            info->l2_admissions, info->l2_rejections,
                             histogram);
 }
+
+/* Append PREFIX to TEXT, escaping all characters that would break the
+ * tab-separated format.
+ */
+static void
+append_escaped_prefix(svn_stringbuf_t *text,
+                      const char *prefix)
+{
+  for (; *prefix; ++prefix)
+    switch (*prefix)
+      {
+        case '\\': svn_stringbuf_appendcstr(text, "\\\\"); break;
+        case '\t': svn_stringbuf_appendcstr(text, "\\t"); break;
+        case '\n': svn_stringbuf_appendcstr(text, "\\n"); break;
+        default:   svn_stringbuf_appendbyte(text, *prefix); break;
+      }
+}
+
+svn_string_t *
+svn_cache__format_prefix_info(const apr_array_header_t *info,
+                              apr_pool_t *result_pool)
+{
+  svn_stringbuf_t *text
+    = svn_stringbuf_create("prefix\tgets\thits\tmisses\tsets\tevictions"
+                           "\tentries\tbytes\n", result_pool);
+  int i;
+
+  for (i = 0; i < info->nelts; ++i)
+    {
+      const svn_cache__prefix_info_t *entry
+        = APR_ARRAY_IDX(info, i, const svn_cache__prefix_info_t *);
+
+      append_escaped_prefix(text, entry->prefix);
+      svn_stringbuf_appendcstr(text,
+        apr_psprintf(result_pool,
+                     "\t%" APR_UINT64_T_FMT "\t%" APR_UINT64_T_FMT
+                     "\t%" APR_UINT64_T_FMT "\t%" APR_UINT64_T_FMT
+                     "\t%" APR_UINT64_T_FMT "\t%" APR_UINT64_T_FMT
+                     "\t%" APR_UINT64_T_FMT "\n",
+                     entry->gets, entry->hits, entry->gets - entry->hits,
+                     entry->sets, entry->evictions,
+                     entry->used_entries, entry->used_size));
+    }
+
+  return svn_string_create_from_buf(text, result_pool);
+}
@@ -82,6 +82,23 @@ typedef struct svn_cache__vtable_t {
                            svn_cache__info_t *info,
                            svn_boolean_t reset,
                            apr_pool_t *result_pool);
+
+  /* See svn_cache__get_multi().  May be NULL, in which case get() will
+     be called for each key. */
+  svn_error_t *(*get_multi)(void **values,
+                            svn_boolean_t *found,
+                            void *cache_implementation,
+                            const void *const *keys,
+                            int count,
+                            apr_pool_t *result_pool);
+
+  /* See svn_cache__set_multi().  May be NULL, in which case set() will
+     be called for each key. */
+  svn_error_t *(*set_multi)(void *cache_implementation,
+                            const void *const *keys,
+                            void *const *values,
+                            int count,
+                            apr_pool_t *scratch_pool);
 } svn_cache__vtable_t;
 
 struct svn_cache__t {
@@ -64,6 +64,34 @@ static svn_cache_config_t cache_settings =
 #endif
 };
 
+/* If set, the global membuffer cache will be allocated in shared memory.
+ */
+static svn_boolean_t use_shared_memory = FALSE;
+
+/* If set, the global membuffer cache will use the admission filter.
+ */
+static svn_boolean_t use_admission_filter = FALSE;
+
+/* Minimum capacity to allocate for the global membuffer cache, allowing
+ * it to grow up to that size later.
+ */
+static apr_uint64_t max_cache_size = 0;
+
+/* Data limit per key prefix in the global membuffer cache.  0 if there
+ * is no limit.
+ */
+static apr_uint64_t prefix_quota = 0;
+
+/* The process-global (singleton) membuffer cache and its initialization
+ * state as used with svn_atomic__init_once.
+ */
+static svn_membuffer_t *global_membuffer = NULL;
+static svn_atomic_t global_membuffer_initialized = 0;
+
+/* The pool that the process-global membuffer cache has been allocated in.
+ */
+static apr_pool_t *global_membuffer_pool = NULL;
+
 /* Get the current FSFS cache configuration. */
 const svn_cache_config_t *
 svn_cache_config_get(void)
@@ -87,6 +115,10 @@ initialize_cache(void *baton, apr_pool_t *unused_pool)
   apr_uint64_t cache_size = MIN(cache_settings.cache_size,
                                 (apr_uint64_t)SVN_MAX_OBJECT_SIZE / 2);
 
+  /* Reserve room for growing the cache later. */
+  apr_uint64_t reserved_size = MIN(MAX(cache_size, max_cache_size),
+                                   (apr_uint64_t)SVN_MAX_OBJECT_SIZE / 2);
+
   /* Create caches at all? */
   if (cache_size)
     {
@@ -120,14 +152,28 @@ initialize_cache(void *baton, apr_pool_t *unused_pool)
         return SVN_NO_ERROR;
       apr_allocator_owner_set(allocator, pool);
 
-      err = svn_cache__membuffer_cache_create(
-          &cache,
-          (apr_size_t)cache_size,
-          (apr_size_t)(cache_size / 5),
-          0,
-          ! svn_cache_config_get()->single_threaded,
-          FALSE,
-          pool);
+      if (use_shared_memory)
+        err = svn_cache__membuffer_cache_create_shared(
+            &cache,
+            (apr_size_t)reserved_size,
+            (apr_size_t)(reserved_size / 5),
+            0,
+            ! svn_cache_config_get()->single_threaded,
+            FALSE,
+            pool);
+      else
+        err = svn_cache__membuffer_cache_create(
+            &cache,
+            (apr_size_t)reserved_size,
+            (apr_size_t)(reserved_size / 5),
+            0,
+            ! svn_cache_config_get()->single_threaded,
+            FALSE,
+            pool);
+
+      /* Start with the configured size. */
+      if (!err && reserved_size > cache_size)
+        err = svn_cache__membuffer_resize(cache, cache_size);
 
       /* Some error occurred. Most likely it's an OOM error but we don't
        * really care. Simply release all cache memory and disable caching
@@ -143,8 +189,21 @@ initialize_cache(void *baton, apr_pool_t *unused_pool)
           return svn_error_trace(err);
         }
 
+      /* The admission filter is optional and not available for all
+       * configurations.  Simply continue without it. */
+      if (use_admission_filter)
+        svn_error_clear(svn_cache__membuffer_enable_admission_filter(cache,
+                                                                     pool));
+
+      /* Same for the prefix quotas. */
+      if (prefix_quota)
+        svn_error_clear(svn_cache__membuffer_set_prefix_quota(cache,
+                                                              prefix_quota,
+                                                              pool));
+
       /* done */
       *cache_p = cache;
+      global_membuffer_pool = pool;
     }
 
   return SVN_NO_ERROR;
@@ -158,11 +217,9 @@ initialize_cache(void *baton, apr_pool_t *unused_pool)
 svn_membuffer_t *
 svn_cache__get_global_membuffer_cache(void)
 {
-  static svn_membuffer_t *cache = NULL;
-  static svn_atomic_t initialized = 0;
-
   svn_error_t *err
-    = svn_atomic__init_once(&initialized, initialize_cache, &cache, NULL);
+    = svn_atomic__init_once(&global_membuffer_initialized, initialize_cache,
+                            &global_membuffer, NULL);
   if (err)
     {
       /* no caches today ... */
@@ -170,12 +227,94 @@ svn_cache__get_global_membuffer_cache(void)
       return NULL;
     }
 
-  return cache;
+  return global_membuffer;
+}
+
+svn_error_t *
+svn_cache__create_shared_global_membuffer_cache(apr_pool_t *scratch_pool)
+{
+  use_shared_memory = TRUE;
+
+  return svn_error_trace(svn_atomic__init_once(&global_membuffer_initialized,
+                                               initialize_cache,
+                                               &global_membuffer,
+                                               scratch_pool));
+}
+
+void
+svn_cache__set_global_membuffer_admission_filter(svn_boolean_t enabled)
+{
+  use_admission_filter = enabled;
+}
+
+void
+svn_cache__set_global_membuffer_max_size(apr_uint64_t max_size)
+{
+  max_cache_size = max_size;
+}
+
+void
+svn_cache__set_global_membuffer_prefix_quota(apr_uint64_t quota)
+{
+  prefix_quota = quota;
+
+  /* Apply it to an existing cache right away. */
+  if (global_membuffer)
+    svn_error_clear(svn_cache__membuffer_set_prefix_quota(
+                        global_membuffer, quota, global_membuffer_pool));
+}
+
+svn_error_t *
+svn_cache__global_membuffer_child_init(apr_pool_t *result_pool)
+{
+  if (global_membuffer)
+    SVN_ERR(svn_cache__membuffer_child_init(global_membuffer, result_pool));
+
+  return SVN_NO_ERROR;
+}
+
+apr_array_header_t *
+svn_cache__get_global_membuffer_locks(apr_pool_t *result_pool)
+{
+  if (global_membuffer)
+    return svn_cache__membuffer_get_global_locks(global_membuffer,
+                                                 result_pool);
+
+  return apr_array_make(result_pool, 0, sizeof(void *));
+}
+
+svn_error_t *
+svn_cache__save_global_membuffer_cache(const char *path,
+                                       apr_pool_t *scratch_pool)
+{
+  svn_membuffer_t *membuffer = svn_cache__get_global_membuffer_cache();
+  if (membuffer)
+    SVN_ERR(svn_cache__membuffer_save(membuffer, path, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_cache__load_global_membuffer_cache(const char *path,
+                                       apr_pool_t *scratch_pool)
+{
+  svn_membuffer_t *membuffer = svn_cache__get_global_membuffer_cache();
+  if (membuffer)
+    SVN_ERR(svn_cache__membuffer_load(membuffer, path, scratch_pool));
+
+  return SVN_NO_ERROR;
 }
 
 void
 svn_cache_config_set(const svn_cache_config_t *settings)
 {
   cache_settings = *settings;
+
+  /* An existing cache can still be resized within its allocated size. */
+  if (global_membuffer)
+    svn_error_clear(svn_cache__membuffer_resize(
+                        global_membuffer,
+                        MIN(cache_settings.cache_size,
+                            (apr_uint64_t)SVN_MAX_OBJECT_SIZE / 2)));
 }
 
@@ -35,6 +35,8 @@
 
 #include "checksum.h"
 #include "fnv1a.h"
+#include "md5.h"
+#include "sha1.h"
 
 #include "private/svn_subr_private.h"
 
@@ -475,21 +477,17 @@ svn_checksum(svn_checksum_t **checksum,
              apr_size_t len,
              apr_pool_t *pool)
 {
-  apr_sha1_ctx_t sha1_ctx;
-
   SVN_ERR(validate_kind(kind));
   *checksum = svn_checksum_create(kind, pool);
 
   switch (kind)
     {
       case svn_checksum_md5:
-        apr_md5((unsigned char *)(*checksum)->digest, data, len);
+        svn__md5((unsigned char *)(*checksum)->digest, data, len);
         break;
 
       case svn_checksum_sha1:
-        apr_sha1_init(&sha1_ctx);
-        apr_sha1_update(&sha1_ctx, data, (unsigned int)len);
-        apr_sha1_final((unsigned char *)(*checksum)->digest, &sha1_ctx);
+        svn__sha1((unsigned char *)(*checksum)->digest, data, len);
         break;
 
       case svn_checksum_fnv1a_32:
@@ -545,13 +543,11 @@ svn_checksum_ctx_create(svn_checksum_kind_t kind,
   switch (kind)
     {
       case svn_checksum_md5:
-        ctx->apr_ctx = apr_palloc(pool, sizeof(apr_md5_ctx_t));
-        apr_md5_init(ctx->apr_ctx);
+        ctx->apr_ctx = svn_md5__context_create(pool);
         break;
 
       case svn_checksum_sha1:
-        ctx->apr_ctx = apr_palloc(pool, sizeof(apr_sha1_ctx_t));
-        apr_sha1_init(ctx->apr_ctx);
+        ctx->apr_ctx = svn_sha1__context_create(pool);
         break;
 
       case svn_checksum_fnv1a_32:
@@ -577,11 +573,11 @@ svn_checksum_update(svn_checksum_ctx_t *ctx,
   switch (ctx->kind)
     {
       case svn_checksum_md5:
-        apr_md5_update(ctx->apr_ctx, data, len);
+        svn_md5__update(ctx->apr_ctx, data, len);
         break;
 
       case svn_checksum_sha1:
-        apr_sha1_update(ctx->apr_ctx, data, (unsigned int)len);
+        svn_sha1__update(ctx->apr_ctx, data, len);
         break;
 
       case svn_checksum_fnv1a_32:
@@ -610,11 +606,12 @@ svn_checksum_final(svn_checksum_t **checksum,
   switch (ctx->kind)
     {
       case svn_checksum_md5:
-        apr_md5_final((unsigned char *)(*checksum)->digest, ctx->apr_ctx);
+        svn_md5__finalize((unsigned char *)(*checksum)->digest, ctx->apr_ctx);
         break;
 
       case svn_checksum_sha1:
-        apr_sha1_final((unsigned char *)(*checksum)->digest, ctx->apr_ctx);
+        svn_sha1__finalize((unsigned char *)(*checksum)->digest,
+                           ctx->apr_ctx);
         break;
 
       case svn_checksum_fnv1a_32:
@@ -635,6 +632,68 @@ svn_checksum_final(svn_checksum_t **checksum,
   return SVN_NO_ERROR;
 }
 
+/* Process data for svn_checksum__md5_sha1_ctx_t in chunks of this size.
+ * They should fit into the L1 cache such that the second checksum reads
+ * the data from there.
+ */
+#define MD5_SHA1_CHUNK_SIZE 0x2000
+
+struct svn_checksum__md5_sha1_ctx_t
+{
+  svn_md5__context_t *md5;
+  svn_sha1__context_t *sha1;
+};
+
+svn_checksum__md5_sha1_ctx_t *
+svn_checksum__md5_sha1_ctx_create(apr_pool_t *pool)
+{
+  svn_checksum__md5_sha1_ctx_t *ctx = apr_palloc(pool, sizeof(*ctx));
+  ctx->md5 = svn_md5__context_create(pool);
+  ctx->sha1 = svn_sha1__context_create(pool);
+
+  return ctx;
+}
+
+svn_error_t *
+svn_checksum__md5_sha1_update(svn_checksum__md5_sha1_ctx_t *ctx,
+                              const void *data,
+                              apr_size_t len)
+{
+  const char *input = data;
+  while (len > 0)
+    {
+      apr_size_t chunk = MIN(len, MD5_SHA1_CHUNK_SIZE);
+      svn_md5__update(ctx->md5, input, chunk);
+      svn_sha1__update(ctx->sha1, input, chunk);
+
+      input += chunk;
+      len -= chunk;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_checksum__md5_sha1_final(svn_checksum_t **md5,
+                             svn_checksum_t **sha1,
+                             const svn_checksum__md5_sha1_ctx_t *ctx,
+                             apr_pool_t *pool)
+{
+  if (md5)
+    {
+      *md5 = svn_checksum_create(svn_checksum_md5, pool);
+      svn_md5__finalize((unsigned char *)(*md5)->digest, ctx->md5);
+    }
+
+  if (sha1)
+    {
+      *sha1 = svn_checksum_create(svn_checksum_sha1, pool);
+      svn_sha1__finalize((unsigned char *)(*sha1)->digest, ctx->sha1);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 apr_size_t
 svn_checksum_size(const svn_checksum_t *checksum)
 {
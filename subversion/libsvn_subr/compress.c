@@ -25,6 +25,16 @@
 #include <string.h>
 #include <assert.h>
 #include <zlib.h>
+#include <apr_general.h>
+
+#ifdef SVN_HAVE_LZ4
+#include <lz4.h>
+#endif
+
+#ifdef SVN_HAVE_ZSTD
+#include <zstd.h>
+#include <zdict.h>
+#endif
 
 #include "private/svn_subr_private.h"
 #include "private/svn_error_private.h"
@@ -45,6 +55,56 @@ svn_zlib__runtime_version(void)
   return zlibVersion();
 }
 
+const char *
+svn_lz4__compiled_version(void)
+{
+#ifdef SVN_HAVE_LZ4
+  static const char lz4_version_str[]
+    = APR_STRINGIFY(LZ4_VERSION_MAJOR) "."
+      APR_STRINGIFY(LZ4_VERSION_MINOR) "."
+      APR_STRINGIFY(LZ4_VERSION_RELEASE);
+
+  return lz4_version_str;
+#else
+  return NULL;
+#endif
+}
+
+const char *
+svn_lz4__runtime_version(void)
+{
+#if defined(SVN_HAVE_LZ4) && LZ4_VERSION_NUMBER >= 10703
+  return LZ4_versionString();
+#else
+  return svn_lz4__compiled_version();
+#endif
+}
+
+
+const char *
+svn_zstd__compiled_version(void)
+{
+#ifdef SVN_HAVE_ZSTD
+  static const char zstd_version_str[]
+    = APR_STRINGIFY(ZSTD_VERSION_MAJOR) "."
+      APR_STRINGIFY(ZSTD_VERSION_MINOR) "."
+      APR_STRINGIFY(ZSTD_VERSION_RELEASE);
+
+  return zstd_version_str;
+#else
+  return NULL;
+#endif
+}
+
+const char *
+svn_zstd__runtime_version(void)
+{
+#if defined(SVN_HAVE_ZSTD) && ZSTD_VERSION_NUMBER >= 10300
+  return ZSTD_versionString();
+#else
+  return svn_zstd__compiled_version();
+#endif
+}
 
 /* The zlib compressBound function was not exported until 1.2.0. */
 #if ZLIB_VERNUM >= 0x1200
@@ -196,6 +256,103 @@ zlib_encode(const char *data,
   return SVN_NO_ERROR;
 }
 
+/* The zstd frame magic number, in the byte order of the frame header.
+   No zlib stream can start with it: 0x28 0xB5 fails the zlib header check
+   (CMF * 256 + FLG must be a multiple of 31). */
+static const unsigned char zstd_magic[4] = { 0x28, 0xB5, 0x2F, 0xFD };
+
+/* Return TRUE, if the LEN bytes at IN start a zstd frame. */
+static svn_boolean_t
+is_zstd_frame(const unsigned char *in, apr_size_t len)
+{
+  return len >= sizeof(zstd_magic)
+      && memcmp(in, zstd_magic, sizeof(zstd_magic)) == 0;
+}
+
+struct svn__compress_dict_t
+{
+  /* The raw dictionary contents. */
+  svn_string_t *data;
+
+#ifdef SVN_HAVE_ZSTD
+  /* Pre-digested forms of DATA for either direction.  Both are immutable
+     and may be used by multiple threads at once. */
+  ZSTD_CDict *cdict;
+  ZSTD_DDict *ddict;
+#endif
+};
+
+#ifdef SVN_HAVE_ZSTD
+/* Return an error object for zstd error code CODE returned by FUNCTION. */
+static svn_error_t *
+wrap_zstd_error(size_t code, const char *function, const char *message)
+{
+  return svn_error_createf(SVN_ERR_SVNDIFF_INVALID_COMPRESSED_DATA, NULL,
+                           "%s (%s: %s)", message, function,
+                           ZSTD_getErrorName(code));
+}
+
+/* Pool cleanup function releasing the zstd structures of the
+   svn__compress_dict_t in DATA. */
+static apr_status_t
+free_compress_dict(void *data)
+{
+  svn__compress_dict_t *dict = data;
+  ZSTD_freeCDict(dict->cdict);
+  ZSTD_freeDDict(dict->ddict);
+
+  return APR_SUCCESS;
+}
+#endif
+
+/* Write the zstd compressed LEN bytes of IN into OUT, which is expected
+   to hold ORIG_LEN bytes after decompression.  Use DICT if not NULL. */
+static svn_error_t *
+zstd_decode(const unsigned char *in, apr_size_t inLen, svn_stringbuf_t *out,
+            apr_size_t orig_len, const svn__compress_dict_t *dict)
+{
+#ifdef SVN_HAVE_ZSTD
+  ZSTD_DCtx *dctx;
+  size_t result;
+
+  svn_stringbuf_ensure(out, orig_len);
+
+  dctx = ZSTD_createDCtx();
+  if (dctx == NULL)
+    return svn_error_create(SVN_ERR_SVNDIFF_INVALID_COMPRESSED_DATA, NULL,
+                            _("Could not allocate zstd decompression "
+                              "context"));
+
+  if (dict)
+    result = ZSTD_decompress_usingDDict(dctx, out->data, orig_len,
+                                        in, inLen, dict->ddict);
+  else
+    result = ZSTD_decompressDCtx(dctx, out->data, orig_len, in, inLen);
+
+  ZSTD_freeDCtx(dctx);
+
+  if (ZSTD_isError(result))
+    return wrap_zstd_error(result, "ZSTD_decompress",
+                           _("Decompression of zstd compressed data "
+                             "failed"));
+
+  if (result != orig_len)
+    return svn_error_create(SVN_ERR_SVNDIFF_INVALID_COMPRESSED_DATA,
+                            NULL,
+                            _("Size of uncompressed data "
+                              "does not match stored original length"));
+
+  out->data[orig_len] = 0;
+  out->len = orig_len;
+
+  return SVN_NO_ERROR;
+#else
+  return svn_error_create(SVN_ERR_BAD_COMPRESSION_METHOD, NULL,
+                          _("Zstd compression is not supported in this "
+                            "build"));
+#endif
+}
+
 /* Decode the possibly-zlib compressed string of length INLEN that is in
    IN, into OUT.  We expect an integer is prepended to IN that specifies
    the original size, and that if encoded size == original size, that the
@@ -204,10 +361,12 @@ zlib_encode(const char *data,
    OUT, COPYLESS_ALLOWED has been set.  The, the caller is expected not to
    modify the contents of OUT.
    An error is returned if the decoded length exceeds the given LIMIT.
+   Data compressed by svn__compress_zstd is recognized by its frame magic
+   and will be decoded using DICT, which may be NULL.
  */
 static svn_error_t *
 zlib_decode(const unsigned char *in, apr_size_t inLen, svn_stringbuf_t *out,
-            apr_size_t limit)
+            apr_size_t limit, const svn__compress_dict_t *dict)
 {
   apr_size_t len;
   apr_uint64_t size;
@@ -236,6 +395,10 @@ zlib_decode(const unsigned char *in, apr_size_t inLen, svn_stringbuf_t *out,
 
       return SVN_NO_ERROR;
     }
+  else if (is_zstd_frame(in, inLen))
+    {
+      return svn_error_trace(zstd_decode(in, inLen, out, len, dict));
+    }
   else
     {
       unsigned long zlen = len;
@@ -280,5 +443,265 @@ svn__decompress(const void *data, apr_size_t len,
                 svn_stringbuf_t *out,
                 apr_size_t limit)
 {
-  return zlib_decode(data, len, out, limit);
+  return zlib_decode(data, len, out, limit, NULL);
+}
+
+svn_error_t *
+svn__decompress2(const void *data, apr_size_t len,
+                 svn_stringbuf_t *out,
+                 apr_size_t limit,
+                 const svn__compress_dict_t *dict)
+{
+  return zlib_decode(data, len, out, limit, dict);
+}
+
+svn_error_t *
+svn__compress_dict_create(svn__compress_dict_t **dict_p,
+                          const void *data,
+                          apr_size_t len,
+                          int compression_level,
+                          apr_pool_t *result_pool)
+{
+#ifdef SVN_HAVE_ZSTD
+  svn__compress_dict_t *dict = apr_pcalloc(result_pool, sizeof(*dict));
+  dict->data = svn_string_ncreate(data, len, result_pool);
+
+  dict->cdict = ZSTD_createCDict(dict->data->data, len, compression_level);
+  dict->ddict = ZSTD_createDDict(dict->data->data, len);
+  apr_pool_cleanup_register(result_pool, dict, free_compress_dict,
+                            apr_pool_cleanup_null);
+
+  if (dict->cdict == NULL || dict->ddict == NULL)
+    return svn_error_create(SVN_ERR_BAD_COMPRESSION_METHOD, NULL,
+                            _("Invalid zstd compression dictionary"));
+
+  *dict_p = dict;
+  return SVN_NO_ERROR;
+#else
+  return svn_error_create(SVN_ERR_BAD_COMPRESSION_METHOD, NULL,
+                          _("Zstd compression is not supported in this "
+                            "build"));
+#endif
+}
+
+svn_error_t *
+svn__compress_dict_train(svn_stringbuf_t **dict_data,
+                         const apr_array_header_t *samples,
+                         apr_size_t max_size,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+#ifdef SVN_HAVE_ZSTD
+  svn_stringbuf_t *buffer = svn_stringbuf_create_empty(scratch_pool);
+  size_t *sizes = apr_palloc(scratch_pool,
+                             (samples->nelts + 1) * sizeof(*sizes));
+  svn_stringbuf_t *result;
+  size_t dict_size;
+  int i;
+
+  for (i = 0; i < samples->nelts; ++i)
+    {
+      const svn_stringbuf_t *sample
+        = APR_ARRAY_IDX(samples, i, const svn_stringbuf_t *);
+      svn_stringbuf_appendbytes(buffer, sample->data, sample->len);
+      sizes[i] = sample->len;
+    }
+
+  result = svn_stringbuf_create_ensure(max_size, result_pool);
+  dict_size = ZDICT_trainFromBuffer(result->data, max_size,
+                                    buffer->data, sizes, samples->nelts);
+
+  /* Training fails if there is too little or too uniform input.
+     That is not an error; we simply can't provide a dictionary yet. */
+  if (ZDICT_isError(dict_size))
+    {
+      *dict_data = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  result->len = dict_size;
+  result->data[dict_size] = 0;
+  *dict_data = result;
+
+  return SVN_NO_ERROR;
+#else
+  return svn_error_create(SVN_ERR_BAD_COMPRESSION_METHOD, NULL,
+                          _("Zstd compression is not supported in this "
+                            "build"));
+#endif
+}
+
+const svn_string_t *
+svn__compress_dict_data(const svn__compress_dict_t *dict)
+{
+  return dict->data;
+}
+
+svn_error_t *
+svn__compress_zstd(const void *data, apr_size_t len,
+                   svn_stringbuf_t *out,
+                   int compression_level,
+                   const svn__compress_dict_t *dict)
+{
+#ifdef SVN_HAVE_ZSTD
+  unsigned char buf[SVN__MAX_ENCODED_UINT_LEN], *p;
+  apr_size_t hdrlen;
+  ZSTD_CCtx *cctx;
+  size_t result;
+
+  svn_stringbuf_setempty(out);
+  p = svn__encode_uint(buf, (apr_uint64_t)len);
+  hdrlen = p - buf;
+  svn_stringbuf_appendbytes(out, (const char *)buf, hdrlen);
+
+  /* Without a dictionary, short buffers are not worth the effort. */
+  if (len == 0 || (dict == NULL && len < MIN_COMPRESS_SIZE))
+    {
+      svn_stringbuf_appendbytes(out, data, len);
+      return SVN_NO_ERROR;
+    }
+
+  cctx = ZSTD_createCCtx();
+  if (cctx == NULL)
+    return svn_error_create(SVN_ERR_BAD_COMPRESSION_METHOD, NULL,
+                            _("Could not allocate zstd compression "
+                              "context"));
+
+  svn_stringbuf_ensure(out, hdrlen + ZSTD_compressBound(len));
+  if (dict)
+    result = ZSTD_compress_usingCDict(cctx, out->data + hdrlen,
+                                      out->blocksize - hdrlen, data, len,
+                                      dict->cdict);
+  else
+    result = ZSTD_compressCCtx(cctx, out->data + hdrlen,
+                               out->blocksize - hdrlen, data, len,
+                               compression_level);
+
+  ZSTD_freeCCtx(cctx);
+
+  /* Compression failed or didn't help.  Just append the original text. */
+  if (ZSTD_isError(result) || result >= len)
+    {
+      svn_stringbuf_appendbytes(out, data, len);
+      return SVN_NO_ERROR;
+    }
+
+  out->len = hdrlen + result;
+  out->data[out->len] = 0;
+
+  return SVN_NO_ERROR;
+#else
+  return svn_error_create(SVN_ERR_BAD_COMPRESSION_METHOD, NULL,
+                          _("Zstd compression is not supported in this "
+                            "build"));
+#endif
+}
+
+svn_error_t *
+svn__compress_lz4(const void *data, apr_size_t len,
+                  svn_stringbuf_t *out)
+{
+#ifdef SVN_HAVE_LZ4
+  unsigned char buf[SVN__MAX_ENCODED_UINT_LEN], *p;
+  apr_size_t hdrlen;
+  int compressed_len;
+
+  svn_stringbuf_setempty(out);
+  p = svn__encode_uint(buf, (apr_uint64_t)len);
+  hdrlen = p - buf;
+  svn_stringbuf_appendbytes(out, (const char *)buf, hdrlen);
+
+  /* LZ4 is cheap enough to be tried even on short buffers but it operates
+     on int-sized blocks only.  Store anything it can't handle verbatim. */
+  if (len > LZ4_MAX_INPUT_SIZE)
+    {
+      svn_stringbuf_appendbytes(out, data, len);
+      return SVN_NO_ERROR;
+    }
+
+  svn_stringbuf_ensure(out, hdrlen + LZ4_compressBound((int)len));
+  compressed_len = LZ4_compress_default(data, out->data + hdrlen, (int)len,
+                                        (int)(out->blocksize - hdrlen));
+
+  /* Compression failed or didn't help.  Just append the original text. */
+  if (compressed_len <= 0 || (apr_size_t)compressed_len >= len)
+    {
+      svn_stringbuf_appendbytes(out, data, len);
+      return SVN_NO_ERROR;
+    }
+
+  out->len = hdrlen + compressed_len;
+  out->data[out->len] = 0;
+
+  return SVN_NO_ERROR;
+#else
+  return svn_error_create(SVN_ERR_BAD_COMPRESSION_METHOD, NULL,
+                          _("LZ4 compression is not supported in this "
+                            "build"));
+#endif
+}
+
+svn_error_t *
+svn__decompress_lz4(const void *data, apr_size_t len,
+                    svn_stringbuf_t *out,
+                    apr_size_t limit)
+{
+#ifdef SVN_HAVE_LZ4
+  apr_size_t orig_len;
+  apr_uint64_t size;
+  const unsigned char *in = data;
+  const unsigned char *end = in + len;
+  int decompressed_len;
+
+  /* First thing in the string is the original length.  */
+  in = svn__decode_uint(&size, in, end);
+  orig_len = (apr_size_t)size;
+  if (in == NULL || orig_len != size)
+    return svn_error_create(SVN_ERR_SVNDIFF_INVALID_COMPRESSED_DATA, NULL,
+                            _("Decompression of LZ4 compressed data failed: "
+                              "no size"));
+  if (orig_len > limit)
+    return svn_error_create(SVN_ERR_SVNDIFF_INVALID_COMPRESSED_DATA, NULL,
+                            _("Decompression of LZ4 compressed data failed: "
+                              "size too large"));
+
+  svn_stringbuf_ensure(out, orig_len);
+
+  /* Uncompressible data has been stored verbatim. */
+  if ((apr_size_t)(end - in) == orig_len)
+    {
+      memcpy(out->data, in, orig_len);
+      out->data[orig_len] = 0;
+      out->len = orig_len;
+
+      return SVN_NO_ERROR;
+    }
+
+  if (orig_len > LZ4_MAX_INPUT_SIZE || end - in > LZ4_MAX_INPUT_SIZE)
+    return svn_error_create(SVN_ERR_SVNDIFF_INVALID_COMPRESSED_DATA, NULL,
+                            _("Decompression of LZ4 compressed data failed: "
+                              "size too large"));
+
+  decompressed_len = LZ4_decompress_safe((const char *)in, out->data,
+                                         (int)(end - in), (int)orig_len);
+  if (decompressed_len < 0)
+    return svn_error_create(SVN_ERR_SVNDIFF_INVALID_COMPRESSED_DATA, NULL,
+                            _("Decompression of LZ4 compressed data failed"));
+
+  /* LZ4 should not produce something that has a different size than the
+     original length we stored. */
+  if ((apr_size_t)decompressed_len != orig_len)
+    return svn_error_create(SVN_ERR_SVNDIFF_INVALID_COMPRESSED_DATA, NULL,
+                            _("Size of uncompressed data "
+                              "does not match stored original length"));
+
+  out->data[orig_len] = 0;
+  out->len = orig_len;
+
+  return SVN_NO_ERROR;
+#else
+  return svn_error_create(SVN_ERR_BAD_COMPRESSION_METHOD, NULL,
+                          _("LZ4 compression is not supported in this "
+                            "build"));
+#endif
 }
@@ -950,6 +950,14 @@ svn_config_ensure(const char *config_dir, apr_pool_t *pool)
         "###                              HTTP operation."                   NL
         "###   http-chunked-requests      Whether to use chunked transfer"   NL
         "###                              encoding for HTTP requests body."  NL
+        "###   http-http2                 Whether to offer HTTP/2 to https"  NL
+        "###                              servers and multiplex all requests"NL
+        "###                              over a single connection."         NL
+        "###   http-cache-directory       Directory in which to cache file"  NL
+        "###                              contents and properties of past"   NL
+        "###                              revisions (default: no cache)."    NL
+        "###   http-cache-size            Maximum size of that cache in"     NL
+        "###                              megabytes (default: 256)."         NL
         "###   ssl-authority-files        List of files, each of a trusted CA"
                                                                              NL
         "###   ssl-trust-default-ca       Trust the system 'default' CAs"    NL
@@ -1308,6 +1316,54 @@ svn_config_ensure(const char *config_dir, apr_pool_t *pool)
         "### to show meaningful differences for binary file formats.  [New"  NL
         "### in 1.9]"                                                        NL
         "# diff-ignore-content-type = no"                                    NL
+        "### Set externals-jobs to the number of directory externals that"   NL
+        "### 'svn checkout', 'svn update' and 'svn switch' may fetch at the" NL
+        "### same time, each with its own connection to the repository."    NL
+        "### Their output is shown in the usual order.  Set it to 1 to"      NL
+        "### handle one external after the other."                           NL
+        "# externals-jobs = 4"                                               NL
+        "### Set merge-jobs to the number of connections to the repository"  NL
+        "### that 'svn merge' may use at the same time to look up the"       NL
+        "### history of the merge target and of its switched subtrees."      NL
+        "### Set it to 1 to use a single connection."                        NL
+        "# merge-jobs = 4"                                                   NL
+        "### Set export-jobs to the number of connections 'svn export'"      NL
+        "### may use at the same time to fetch the files of a repository"    NL
+        "### directory, which are then written by as many threads.  Set it"  NL
+        "### to 1 to use a single connection."                               NL
+        "# export-jobs = 4"                                                  NL
+        "### Set diff-jobs to the number of connections 'svn diff' between"  NL
+        "### two repository directories may use at the same time.  Each of"  NL
+        "### the subdirectories they share is then compared by a thread of"  NL
+        "### its own, and the output is shown in the order of their names."  NL
+        "### Set it to 1 to compare everything over a single connection."    NL
+        "# diff-jobs = 4"                                                    NL
+        "### Set commit-jobs to the number of threads 'svn commit' may use"  NL
+        "### to compute the text deltas of the files that it sends next,"    NL
+        "### while it sends the current one.  Set it to 1 to compute each"   NL
+        "### delta only when it is sent."                                    NL
+        "# commit-jobs = 4"                                                  NL
+        "### Set import-jobs to the number of threads 'svn import' may use"  NL
+        "### to detect the mime-types and read the contents of the files"    NL
+        "### that it adds next, while it sends the current one.  Set it to"  NL
+        "### 1 to read each file only when it is sent."                      NL
+        "# import-jobs = 4"                                                  NL
+        "### Set history-cache-directory to a directory in which to keep"   NL
+        "### the parts of the repository history that can't change, such"   NL
+        "### as the mergeinfo, the inherited properties and the location"   NL
+        "### segments of paths in past revisions.  This speeds up repeated" NL
+        "### merges and 'svn mergeinfo' between long-lived branches, and"   NL
+        "### updates of working copies below the repository root."          NL
+        "### history-cache-size bounds the cache in megabytes.  By default," NL
+        "### no history is cached."                                          NL
+        "# history-cache-directory ="                                        NL
+        "# history-cache-size = 64"                                          NL
+        "### Set log-cache to 'yes' to also keep the log of the"             NL
+        "### repositories in the history cache, so that 'svn log' of a path" NL
+        "### only asks the server about revisions it hasn't seen yet."       NL
+        "### Changes made to revision properties such as svn:log after a"    NL
+        "### revision has been cached are not seen."                         NL
+        "# log-cache = no"                                                   NL
         ""                                                                   NL
         "### Section for configuring automatic properties."                  NL
         "[auto-props]"                                                       NL
@@ -1349,6 +1405,34 @@ svn_config_ensure(const char *config_dir, apr_pool_t *pool)
         "### returning an error.  The default is 10000, i.e. 10 seconds."    NL
         "### Longer values may be useful when exclusive locking is enabled." NL
         "# busy-timeout = 10000"                                             NL
+        "### Set to true to keep the information read about working copy"    NL
+        "### nodes in memory.  This speeds up operations on large working"   NL
+        "### copies but the client won't notice changes that other"          NL
+        "### processes make to the working copy while it is running."        NL
+        "# node-cache = false"                                               NL
+        "### Set fsmonitor-command to a program that keeps track of changes" NL
+        "### to working copy files, e.g. using inotify, to let 'svn status'" NL
+        "### and 'svn commit' skip directories that haven't changed and to"  NL
+        "### let 'svnversion' reuse its last result if nothing changed.  It" NL
+        "### is run as 'COMMAND WCROOT TOKEN' and must print a new token on" NL
+        "### the first line and then the paths relative to WCROOT changed"   NL
+        "### since TOKEN, one per line, or '/' if it doesn't know.  TOKEN is" NL
+        "### empty on the first run."                                        NL
+        "# fsmonitor-command ="                                              NL
+        "### Set compress-pristines to 'yes' to store new pristine copies of" NL
+        "### files compressed.  This saves disk space at the expense of CPU" NL
+        "### time.  Older clients can't read compressed pristine copies."    NL
+        "# compress-pristines = no"                                          NL
+        "### Set sqlite-cache-size to the size of the page cache of each" NL
+        "### working copy database in kilobytes and sqlite-mmap-size to the" NL
+        "### number of bytes of it that may be accessed using memory mapped" NL
+        "### I/O.  -1 keeps the SQLite defaults."                          NL
+        "# sqlite-cache-size = 8192"                                         NL
+        "# sqlite-mmap-size = 0"                                             NL
+        "### Set sqlite-wal to 'yes' to let the working copy database use" NL
+        "### write-ahead logging, which is faster but must not be used if" NL
+        "### the working copy is accessed from other hosts, e.g. over NFS." NL
+        "# sqlite-wal = no"                                                  NL
         ;
 
       err = svn_io_file_open(&f, path,
@@ -40,6 +40,17 @@
 #include "private/svn_fspath.h"
 #include "private/svn_cert.h"
 
+/* As in eol.c, SSE2 is part of the x86-64 base ISA and NEON is available
+ * on all AArch64 CPUs.  The scan for separators needs no runtime CPU
+ * detection. */
+#if defined(__GNUC__) && defined(__SSE2__)
+#  define DIRENT_SCAN_SSE2 1
+#  include <emmintrin.h>
+#elif defined(__GNUC__) && defined(__aarch64__) && defined(__ARM_NEON)
+#  define DIRENT_SCAN_NEON 1
+#  include <arm_neon.h>
+#endif
+
 /* The canonical empty path.  Can this be changed?  Well, change the empty
    test below and the path library will work, not so sure about the fs/wc
    libraries. */
@@ -75,6 +86,60 @@ relpath_is_canonical(const char *relpath);
 
 /**** Internal implementation functions *****/
 
+/* Return TRUE if the LEN bytes at PATH contain two adjacent '/'. */
+static svn_boolean_t
+has_double_slash(const char *path, apr_size_t len)
+{
+  apr_size_t i = 0;
+  svn_boolean_t prev_slash = FALSE;
+
+#if defined(DIRENT_SCAN_SSE2)
+
+  const __m128i slashes = _mm_set1_epi8('/');
+  for (; len - i >= 16; i += 16)
+    {
+      __m128i chunk = _mm_loadu_si128((const __m128i *)(path + i));
+      unsigned int mask
+        = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, slashes));
+
+      /* Pairs within the chunk and across the chunk boundary. */
+      if ((mask & (mask >> 1)) || (prev_slash && (mask & 1)))
+        return TRUE;
+      prev_slash = (mask >> 15) & 1;
+    }
+
+#elif defined(DIRENT_SCAN_NEON)
+
+  const uint8x16_t slashes = vdupq_n_u8('/');
+  for (; len - i >= 16; i += 16)
+    {
+      uint8x16_t chunk = vld1q_u8((const uint8_t *)(path + i));
+      uint8x16_t hits = vceqq_u8(chunk, slashes);
+
+      /* 4 bits per byte, see match_mask_neon() in eol.c. */
+      apr_uint64_t mask
+        = vget_lane_u64(vreinterpret_u64_u8(
+                          vshrn_n_u16(vreinterpretq_u16_u8(hits), 4)),
+                        0);
+
+      if ((mask & (mask >> 4)) || (prev_slash && (mask & 1)))
+        return TRUE;
+      prev_slash = (mask >> 60) & 1;
+    }
+
+#endif
+
+  for (; i < len; ++i)
+    {
+      svn_boolean_t slash = path[i] == '/';
+      if (slash && prev_slash)
+        return TRUE;
+      prev_slash = slash;
+    }
+
+  return FALSE;
+}
+
 /* Return an internal-style new path based on PATH, allocated in POOL.
  *
  * "Internal-style" means that separators are all '/'.
@@ -1640,22 +1705,41 @@ svn_dirent_get_absolute(const char **pabsolute,
   return SVN_NO_ERROR;
 }
 
+/* Most paths passed to the canonicalize functions are canonical already.
+ * Validating them is much cheaper than rebuilding them in canonicalize(),
+ * so we check first and simply copy canonical input. */
+
 const char *
 svn_uri_canonicalize(const char *uri, apr_pool_t *pool)
 {
+  if (svn_uri_is_canonical(uri, pool))
+    return apr_pstrdup(pool, uri);
+
   return canonicalize(type_uri, uri, pool);
 }
 
 const char *
 svn_relpath_canonicalize(const char *relpath, apr_pool_t *pool)
 {
+  if (relpath_is_canonical(relpath))
+    return apr_pstrdup(pool, relpath);
+
   return canonicalize(type_relpath, relpath, pool);
 }
 
 const char *
 svn_dirent_canonicalize(const char *dirent, apr_pool_t *pool)
 {
-  const char *dst = canonicalize(type_dirent, dirent, pool);
+  const char *dst;
+
+#ifndef SVN_USE_DOS_PATHS
+  /* svn_dirent_is_canonical() falls back to canonicalize() for some
+     Windows paths, so only take the shortcut on other platforms. */
+  if (svn_dirent_is_canonical(dirent, pool))
+    return apr_pstrdup(pool, dirent);
+#endif
+
+  dst = canonicalize(type_dirent, dirent, pool);
 
 #ifdef SVN_USE_DOS_PATHS
   /* Handle a specific case on Windows where path == "X:/". Here we have to
@@ -1719,8 +1803,7 @@ static svn_boolean_t
 relpath_is_canonical(const char *relpath)
 {
   const char *dot_pos, *ptr = relpath;
-  apr_size_t i, len;
-  unsigned pattern = 0;
+  apr_size_t len;
 
   /* RELPATH is canonical if it has:
    *  - no '.' segments
@@ -1755,14 +1838,7 @@ relpath_is_canonical(const char *relpath)
       return FALSE;
 
   /* Now validate the rest of the path. */
-  for (i = 0; i < len - 1; ++i)
-    {
-      pattern = ((pattern & 0xff) << 8) + (unsigned char)ptr[i];
-      if (pattern == 0x101 * (unsigned char)('/'))
-        return FALSE;
-    }
-
-  return TRUE;
+  return !has_double_slash(ptr, len);
 }
 
 svn_boolean_t
@@ -2510,6 +2586,9 @@ svn_fspath__canonicalize(const char *fspath,
   if ((fspath[0] == '/') && (fspath[1] == '\0'))
     return "/";
 
+  if (svn_fspath__is_canonical(fspath))
+    return apr_pstrdup(pool, fspath);
+
   return apr_pstrcat(pool, "/", svn_relpath_canonicalize(fspath, pool),
                      SVN_VA_NULL);
 }
@@ -2582,17 +2661,22 @@ svn_fspath__join(const char *fspath,
                  apr_pool_t *result_pool)
 {
   char *result;
+  apr_size_t fspath_len, relpath_len;
   assert(svn_fspath__is_canonical(fspath));
   assert(svn_relpath_is_canonical(relpath));
 
-  if (relpath[0] == '\0')
-    result = apr_pstrdup(result_pool, fspath);
-  else if (fspath[1] == '\0')
-    result = apr_pstrcat(result_pool, "/", relpath, SVN_VA_NULL);
-  else
-    result = apr_pstrcat(result_pool, fspath, "/", relpath, SVN_VA_NULL);
+  /* Joining two canonical paths always gives a canonical path, so this
+     is a simple concatenation.  Do it with a single allocation. */
+  relpath_len = strlen(relpath);
+  if (relpath_len == 0)
+    return apr_pstrdup(result_pool, fspath);
+
+  fspath_len = fspath[1] == '\0' ? 0 : strlen(fspath);
+  result = apr_palloc(result_pool, fspath_len + relpath_len + 2);
+  memcpy(result, fspath, fspath_len);
+  result[fspath_len] = '/';
+  memcpy(result + fspath_len + 1, relpath, relpath_len + 1);
 
-  assert(svn_fspath__is_canonical(result));
   return result;
 }
 
@@ -30,9 +30,149 @@
 #include "private/svn_eol_private.h"
 #include "private/svn_dep_compat.h"
 
+/* On x86-64, SSE2 is part of the base ISA and NEON is on AArch64.
+ * So, no runtime CPU detection is needed for the vectorized scanners.
+ */
+#if defined(__GNUC__) && defined(__SSE2__)
+#  define EOL_SCAN_SSE2 1
+#  include <emmintrin.h>
+#elif defined(__GNUC__) && defined(__aarch64__) && defined(__ARM_NEON)
+#  define EOL_SCAN_NEON 1
+#  include <arm_neon.h>
+#endif
+
+#ifdef EOL_SCAN_SSE2
+
+/* Return the mask of bytes in the 16 bytes at BUF that match any of
+ * V1, V2 or V3; bit I is set for a match at BUF[I].
+ */
+static APR_INLINE unsigned int
+match_mask_sse2(const char *buf, __m128i v1, __m128i v2, __m128i v3)
+{
+  __m128i chunk = _mm_loadu_si128((const __m128i *)buf);
+  __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, v1),
+                                           _mm_cmpeq_epi8(chunk, v2)),
+                              _mm_cmpeq_epi8(chunk, v3));
+  return (unsigned int)_mm_movemask_epi8(hits);
+}
+
+#endif
+
+#ifdef EOL_SCAN_NEON
+
+/* Return a mask of the bytes in the 16 bytes at BUF that match any of
+ * V1, V2 or V3.  Each byte is represented by 4 bits in the result;
+ * bits 4*I to 4*I+3 are set for a match at BUF[I].
+ */
+static APR_INLINE apr_uint64_t
+match_mask_neon(const char *buf, uint8x16_t v1, uint8x16_t v2, uint8x16_t v3)
+{
+  uint8x16_t chunk = vld1q_u8((const uint8_t *)buf);
+  uint8x16_t hits = vorrq_u8(vorrq_u8(vceqq_u8(chunk, v1),
+                                      vceqq_u8(chunk, v2)),
+                             vceqq_u8(chunk, v3));
+  uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(hits), 4);
+  return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0);
+}
+
+#endif
+
+const char *
+svn_eol__find_first_of3(const char *buf,
+                        apr_size_t len,
+                        char c1,
+                        char c2,
+                        char c3)
+{
+#if defined(EOL_SCAN_SSE2)
+
+  const __m128i v1 = _mm_set1_epi8(c1);
+  const __m128i v2 = _mm_set1_epi8(c2);
+  const __m128i v3 = _mm_set1_epi8(c3);
+
+  /* Classify 32 bytes per iteration; the position of the first match
+   * is the lowest bit set in the combined mask. */
+  for (; len >= 32; buf += 32, len -= 32)
+    {
+      unsigned int mask = match_mask_sse2(buf, v1, v2, v3)
+                        | (match_mask_sse2(buf + 16, v1, v2, v3) << 16);
+      if (mask)
+        return buf + __builtin_ctz(mask);
+    }
+
+  if (len >= 16)
+    {
+      unsigned int mask = match_mask_sse2(buf, v1, v2, v3);
+      if (mask)
+        return buf + __builtin_ctz(mask);
+
+      buf += 16;
+      len -= 16;
+    }
+
+#elif defined(EOL_SCAN_NEON)
+
+  const uint8x16_t v1 = vdupq_n_u8((uint8_t)c1);
+  const uint8x16_t v2 = vdupq_n_u8((uint8_t)c2);
+  const uint8x16_t v3 = vdupq_n_u8((uint8_t)c3);
+
+  for (; len >= 16; buf += 16, len -= 16)
+    {
+      apr_uint64_t mask = match_mask_neon(buf, v1, v2, v3);
+      if (mask)
+        return buf + (__builtin_ctzll(mask) >> 2);
+    }
+
+#elif SVN_UNALIGNED_ACCESS_IS_OK
+
+  const apr_uintptr_t mask1 = (apr_uintptr_t)(unsigned char)c1
+                            * (SVN__LOWER_7BITS_SET / 0x7f);
+  const apr_uintptr_t mask2 = (apr_uintptr_t)(unsigned char)c2
+                            * (SVN__LOWER_7BITS_SET / 0x7f);
+  const apr_uintptr_t mask3 = (apr_uintptr_t)(unsigned char)c3
+                            * (SVN__LOWER_7BITS_SET / 0x7f);
+
+  /* Scan the input one machine word at a time, using the same test as
+   * svn_eol__find_eol_start() for each of the three bytes. */
+  for (; len > sizeof(apr_uintptr_t)
+       ; buf += sizeof(apr_uintptr_t), len -= sizeof(apr_uintptr_t))
+    {
+      apr_uintptr_t chunk = *(const apr_uintptr_t *)buf;
+      apr_uintptr_t test1 = chunk ^ mask1;
+      apr_uintptr_t test2 = chunk ^ mask2;
+      apr_uintptr_t test3 = chunk ^ mask3;
+
+      /* A byte in TESTn can only be < 0x80, iff it has been \0 before
+       * (i.e. matched Cn). */
+      test1 |= (test1 & SVN__LOWER_7BITS_SET) + SVN__LOWER_7BITS_SET;
+      test2 |= (test2 & SVN__LOWER_7BITS_SET) + SVN__LOWER_7BITS_SET;
+      test3 |= (test3 & SVN__LOWER_7BITS_SET) + SVN__LOWER_7BITS_SET;
+
+      if ((test1 & test2 & test3 & SVN__BIT_7_SET) != SVN__BIT_7_SET)
+        break;
+    }
+
+#endif
+
+  /* The remaining odd bytes will be examined the naive way: */
+  for (; len > 0; ++buf, --len)
+    {
+      if (*buf == c1 || *buf == c2 || *buf == c3)
+        return buf;
+    }
+
+  return NULL;
+}
+
 char *
 svn_eol__find_eol_start(char *buf, apr_size_t len)
 {
+#if defined(EOL_SCAN_SSE2) || defined(EOL_SCAN_NEON)
+
+  return (char *)svn_eol__find_first_of3(buf, len, '\r', '\n', '\n');
+
+#else
+
 #if SVN_UNALIGNED_ACCESS_IS_OK
 
   /* Scan the input one machine word at a time. */
@@ -68,6 +208,7 @@ svn_eol__find_eol_start(char *buf, apr_size_t len)
     }
 
   return NULL;
+#endif
 }
 
 const char *
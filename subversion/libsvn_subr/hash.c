@@ -45,6 +45,7 @@
 
 #include "private/svn_dep_compat.h"
 #include "private/svn_sorts_private.h"
+#include "private/svn_string_private.h"
 #include "private/svn_subr_private.h"
 
 #include "svn_private_config.h"
@@ -251,25 +252,166 @@ hash_read(apr_hash_t *hash, svn_stream_t *stream, const char *terminator,
 }
 
 
+/* Parse the length in the "K <len>" or "V <len>" line at *P, which must
+ * start with KIND, and return it in *LEN.  END is the end of the buffer.
+ * On success, make *P point to the start of the next line.  Otherwise,
+ * return an error with MESSAGE.
+ */
+static svn_error_t *
+parse_length_line(apr_size_t *len,
+                  char **p,
+                  const char *end,
+                  char kind,
+                  const char *message)
+{
+  char *s = *p;
+  apr_size_t value = 0;
+
+  if (end - s < 4 || s[0] != kind || s[1] != ' ')
+    return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                            _("Serialized hash malformed"));
+
+  for (s += 2; s < end && *s >= '0' && *s <= '9'; ++s)
+    {
+      apr_size_t digit = *s - '0';
+      if (value > (APR_SIZE_MAX - digit) / 10)
+        return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL, message);
+
+      value = value * 10 + digit;
+    }
+
+  if (s == *p + 2 || s == end || *s != '\n')
+    return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL, message);
+
+  *len = value;
+  *p = s + 1;
+
+  return SVN_NO_ERROR;
+}
+
+/* Make the LEN bytes at *P followed by a newline a 0-terminated string
+ * within the buffer that ends at END and advance *P behind it.  Return an
+ * error with MESSAGE if there is not enough data.
+ */
+static svn_error_t *
+terminate_data(char **p,
+               const char *end,
+               apr_size_t len,
+               const char *message)
+{
+  if ((apr_size_t)(end - *p) <= len || (*p)[len] != '\n')
+    return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL, message);
+
+  (*p)[len] = '\0';
+  *p += len + 1;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_hash__parse(apr_hash_t *hash,
+                char *data,
+                apr_size_t len,
+                const char *terminator,
+                apr_pool_t *pool)
+{
+  const char *end = data + len;
+  apr_size_t terminator_len = terminator ? strlen(terminator) : 0;
+  char *p = data;
+
+  while (TRUE)
+    {
+      svn_string_t *value;
+      char *key;
+      apr_size_t keylen;
+
+      /* Check for the end of the hash. */
+      if (p == end)
+        {
+          if (terminator)
+            return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                                    _("Serialized hash missing terminator"));
+          break;
+        }
+
+      if (   terminator
+          && (apr_size_t)(end - p) >= terminator_len
+          && memcmp(p, terminator, terminator_len) == 0
+          && (p + terminator_len == end || p[terminator_len] == '\n'))
+        break;
+
+      /* Key and value, each with their length line. */
+      SVN_ERR(parse_length_line(&keylen, &p, end, 'K',
+                                _("Serialized hash malformed key length")));
+      key = p;
+      SVN_ERR(terminate_data(&p, end, keylen,
+                             _("Serialized hash malformed key data")));
+
+      value = apr_palloc(pool, sizeof(*value));
+      SVN_ERR(parse_length_line(&value->len, &p, end, 'V',
+                                _("Serialized hash malformed value length")));
+      value->data = p;
+      SVN_ERR(terminate_data(&p, end, value->len,
+                             _("Serialized hash malformed value data")));
+
+      apr_hash_set(hash, key, keylen, value);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Serialized hash data is collected in a buffer of about this size before
+ * being written to the output stream.  Larger values get written directly.
+ */
+#define HASH_WRITE_CHUNK_SIZE 0x4000
+
+/* Append a "<KIND> <LEN>" line to BUF. */
+static void
+append_length_line(svn_stringbuf_t *buf,
+                   char kind,
+                   apr_size_t len)
+{
+  char digits[SVN_INT64_BUFFER_SIZE];
+  apr_size_t digits_len = svn__ui64toa(digits, len);
+
+  svn_stringbuf_appendbyte(buf, kind);
+  svn_stringbuf_appendbyte(buf, ' ');
+  svn_stringbuf_appendbytes(buf, digits, digits_len);
+  svn_stringbuf_appendbyte(buf, '\n');
+}
+
+/* Write the contents of BUF to STREAM and empty BUF. */
+static svn_error_t *
+flush_write_buffer(svn_stream_t *stream,
+                   svn_stringbuf_t *buf)
+{
+  apr_size_t len = buf->len;
+
+  SVN_ERR(svn_stream_write(stream, buf->data, &len));
+  svn_stringbuf_setempty(buf);
+
+  return SVN_NO_ERROR;
+}
+
 /* Implements svn_hash_write2 and svn_hash_write_incremental. */
 static svn_error_t *
 hash_write(apr_hash_t *hash, apr_hash_t *oldhash, svn_stream_t *stream,
            const char *terminator, apr_pool_t *pool)
 {
-  apr_pool_t *subpool;
-  apr_size_t len;
+  svn_stringbuf_t *buf;
   apr_array_header_t *list;
   int i;
 
-  subpool = svn_pool_create(pool);
+  /* Format everything into BUF and write it in larger chunks. */
+  buf = svn_stringbuf_create_ensure(HASH_WRITE_CHUNK_SIZE, pool);
 
   list = svn_sort__hash(hash, svn_sort_compare_items_lexically, pool);
   for (i = 0; i < list->nelts; i++)
     {
       svn_sort__item_t *item = &APR_ARRAY_IDX(list, i, svn_sort__item_t);
       svn_string_t *valstr = item->value;
-
-      svn_pool_clear(subpool);
+      apr_size_t keylen;
 
       /* Don't output entries equal to the ones in oldhash, if present. */
       if (oldhash)
@@ -284,16 +426,29 @@ hash_write(apr_hash_t *hash, apr_hash_t *oldhash, svn_stream_t *stream,
         return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
                                 _("Cannot serialize negative length"));
 
-      /* Write it out. */
-      SVN_ERR(svn_stream_printf(stream, subpool,
-                                "K %" APR_SIZE_T_FMT "\n%s\n"
-                                "V %" APR_SIZE_T_FMT "\n",
-                                (apr_size_t) item->klen,
-                                (const char *) item->key,
-                                valstr->len));
-      len = valstr->len;
-      SVN_ERR(svn_stream_write(stream, valstr->data, &len));
-      SVN_ERR(svn_stream_puts(stream, "\n"));
+      /* Write it out.  Like before, the key gets written up to its
+         first NUL. */
+      keylen = strlen(item->key);
+      append_length_line(buf, 'K', (apr_size_t) item->klen);
+      svn_stringbuf_appendbytes(buf, item->key, keylen);
+      svn_stringbuf_appendbyte(buf, '\n');
+      append_length_line(buf, 'V', valstr->len);
+
+      if (valstr->len >= HASH_WRITE_CHUNK_SIZE)
+        {
+          apr_size_t len = valstr->len;
+
+          SVN_ERR(flush_write_buffer(stream, buf));
+          SVN_ERR(svn_stream_write(stream, valstr->data, &len));
+        }
+      else
+        {
+          svn_stringbuf_appendbytes(buf, valstr->data, valstr->len);
+        }
+
+      svn_stringbuf_appendbyte(buf, '\n');
+      if (buf->len >= HASH_WRITE_CHUNK_SIZE)
+        SVN_ERR(flush_write_buffer(stream, buf));
     }
 
   if (oldhash)
@@ -305,21 +460,25 @@ hash_write(apr_hash_t *hash, apr_hash_t *oldhash, svn_stream_t *stream,
         {
           svn_sort__item_t *item = &APR_ARRAY_IDX(list, i, svn_sort__item_t);
 
-          svn_pool_clear(subpool);
-
           /* If it's not present in the new hash, write out a D entry. */
           if (! apr_hash_get(hash, item->key, item->klen))
-            SVN_ERR(svn_stream_printf(stream, subpool,
-                                      "D %" APR_SSIZE_T_FMT "\n%s\n",
-                                      item->klen, (const char *) item->key));
+            {
+              append_length_line(buf, 'D', (apr_size_t) item->klen);
+              svn_stringbuf_appendcstr(buf, item->key);
+              svn_stringbuf_appendbyte(buf, '\n');
+              if (buf->len >= HASH_WRITE_CHUNK_SIZE)
+                SVN_ERR(flush_write_buffer(stream, buf));
+            }
         }
     }
 
   if (terminator)
-    SVN_ERR(svn_stream_printf(stream, subpool, "%s\n", terminator));
+    {
+      svn_stringbuf_appendcstr(buf, terminator);
+      svn_stringbuf_appendbyte(buf, '\n');
+    }
 
-  svn_pool_destroy(subpool);
-  return SVN_NO_ERROR;
+  return svn_error_trace(flush_write_buffer(stream, buf));
 }
 
 
@@ -51,6 +51,37 @@
 #include <fcntl.h>
 #endif
 
+#ifdef HAVE_LINUX_FS_H
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
+
+#ifdef HAVE_COPY_FILE_RANGE
+#include <errno.h>
+#endif
+
+#ifdef HAVE_CLONEFILE
+#include <sys/attr.h>
+#include <sys/clonefile.h>
+#endif
+
+#if defined(HAVE_LINUX_IO_URING_H) && defined(__GNUC__)
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include <linux/stat.h>
+
+/* IORING_OP_STATX is an enum value; IORING_FEAT_CUR_PERSONALITY came
+   with the same kernel headers (Linux 5.6). */
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) \
+    && defined(IORING_FEAT_CUR_PERSONALITY) && defined(STATX_BASIC_STATS)
+#define SVN_IO__HAVE_URING_STATX
+#endif
+#endif
+
 #include "svn_hash.h"
 #include "svn_types.h"
 #include "svn_dirent_uri.h"
@@ -59,6 +90,7 @@
 #include "svn_error.h"
 #include "svn_io.h"
 #include "svn_pools.h"
+#include "svn_sorts.h"
 #include "svn_utf.h"
 #include "svn_config.h"
 #include "svn_private_config.h"
@@ -824,8 +856,122 @@ svn_io_temp_dir(const char **dir,
 
 /*** Creating, copying and appending files. ***/
 
+#if defined(FICLONE) || defined(HAVE_COPY_FILE_RANGE)
+/* Try to let the kernel transfer the full contents of the unbuffered
+ * FROM_FILE to the empty TO_FILE, both positioned at their start.  Prefer
+ * sharing the data blocks (reflink) over in-kernel copying.  Return FALSE
+ * if the file system does not support either and nothing has been copied.
+ * Otherwise, return TRUE and set *STATUS to the result.
+ */
+static svn_boolean_t
+copy_contents_in_kernel(apr_status_t *status,
+                        apr_file_t *from_file,
+                        apr_file_t *to_file)
+{
+  apr_os_file_t from_fd, to_fd;
+
+  if (   apr_os_file_get(&from_fd, from_file)
+      || apr_os_file_get(&to_fd, to_file))
+    return FALSE;
+
+#ifdef FICLONE
+  if (ioctl(to_fd, FICLONE, from_fd) == 0)
+    {
+      *status = APR_SUCCESS;
+      return TRUE;
+    }
+#endif
+
+#ifdef HAVE_COPY_FILE_RANGE
+  {
+    svn_boolean_t copied_any = FALSE;
+    while (1)
+      {
+        /* Copy in chunks of 1 GB to stay within the range of ssize_t. */
+        ssize_t copied = copy_file_range(from_fd, NULL, to_fd, NULL,
+                                         0x40000000, 0);
+        if (copied == 0)
+          {
+            *status = APR_SUCCESS;
+            return TRUE;
+          }
+
+        if (copied < 0)
+          {
+            /* Not supported for this pair of files?  Then we will simply
+             * read and write the contents ourselves. */
+            if (!copied_any
+                && (   errno == EXDEV || errno == ENOSYS || errno == EINVAL
+                    || errno == EOPNOTSUPP || errno == EBADF))
+              return FALSE;
+
+            *status = APR_FROM_OS_ERROR(errno);
+            return TRUE;
+          }
+
+        copied_any = TRUE;
+      }
+  }
+#else
+  return FALSE;
+#endif
+}
+#endif
+
+#ifdef HAVE_CLONEFILE
+/* Try to create a copy of SRC next to DST that shares its data blocks,
+ * as APFS supports through clonefile().  On success, set *DST_TMP to the
+ * path of the copy.  It has the permissions of SRC if COPY_PERMS is set
+ * and those of a new temporary file otherwise.  Set *DST_TMP to NULL if
+ * SRC can't be cloned.  Use POOL for allocations.
+ */
+static svn_error_t *
+clone_file(const char **dst_tmp,
+           const char *src,
+           const char *dst,
+           svn_boolean_t copy_perms,
+           apr_pool_t *pool)
+{
+  const char *tmp, *src_apr, *tmp_apr;
+  apr_finfo_t finfo;
+
+  *dst_tmp = NULL;
+
+  /* clonefile() insists on creating the target itself.  So reserve a
+     unique name, remember the permissions that it came with and make
+     room for the clone. */
+  SVN_ERR(svn_io_open_unique_file3(NULL, &tmp,
+                                   svn_dirent_dirname(dst, pool),
+                                   svn_io_file_del_none, pool, pool));
+  SVN_ERR(svn_io_stat(&finfo, tmp, APR_FINFO_PROT, pool));
+  SVN_ERR(svn_io_remove_file2(tmp, FALSE, pool));
+
+  SVN_ERR(cstring_from_utf8(&src_apr, src, pool));
+  SVN_ERR(cstring_from_utf8(&tmp_apr, tmp, pool));
+  if (clonefile(src_apr, tmp_apr, 0) != 0)
+    return SVN_NO_ERROR;
+
+  /* The clone comes with the permissions of SRC. */
+  if (!copy_perms)
+    {
+      apr_status_t status = apr_file_perms_set(tmp_apr, finfo.protection);
+
+      if (status && !APR_STATUS_IS_ENOTIMPL(status))
+        return svn_error_compose_create(
+                 svn_error_wrap_apr(status,
+                                    _("Can't set permissions on '%s'"),
+                                    svn_dirent_local_style(tmp, pool)),
+                 svn_io_remove_file2(tmp, TRUE, pool));
+    }
+
+  *dst_tmp = tmp;
+
+  return SVN_NO_ERROR;
+}
+#endif
+
 /* Transfer the contents of FROM_FILE to TO_FILE, using POOL for temporary
- * allocations.
+ * allocations.  FROM_FILE must be unbuffered and TO_FILE must be empty.
  *
  * NOTE: We don't use apr_copy_file() for this, since it takes filenames
  * as parameters.  Since we want to copy to a temporary file
@@ -838,6 +984,12 @@ copy_contents(apr_file_t *from_file,
               apr_file_t *to_file,
               apr_pool_t *pool)
 {
+#if defined(FICLONE) || defined(HAVE_COPY_FILE_RANGE)
+  apr_status_t status;
+  if (copy_contents_in_kernel(&status, from_file, to_file))
+    return status;
+#endif
+
   /* Copy bytes till the cows come home. */
   while (1)
     {
@@ -899,6 +1051,14 @@ svn_io_copy_file(const char *src,
     return SVN_NO_ERROR;
 #endif
 
+#ifdef HAVE_CLONEFILE
+  /* On Linux, copy_contents() takes care of cloning, but APFS can only
+     clone by path. */
+  SVN_ERR(clone_file(&dst_tmp, src, dst, copy_perms, pool));
+  if (dst_tmp)
+    return svn_error_trace(svn_io_file_rename2(dst_tmp, dst, FALSE, pool));
+#endif
+
   SVN_ERR(svn_io_file_open(&from_file, src, APR_READ,
                            APR_OS_DEFAULT, pool));
 
@@ -1313,11 +1473,53 @@ svn_io_set_file_affected_time(apr_time_t apr_time,
 }
 
 
+/* Return TRUE if the filesystem containing PATH appears to have
+   sub-second timestamp resolution. */
+static svn_boolean_t
+has_hi_res_timestamps(const char *path, apr_pool_t *pool)
+{
+  apr_finfo_t finfo;
+  svn_error_t *err;
+
+  err = svn_io_stat(&finfo, path, APR_FINFO_MTIME | APR_FINFO_LINK, pool);
+  if (err)
+    {
+      svn_error_clear(err); /* Fall back on original behavior */
+      return FALSE;
+    }
+
+  /* Very simplistic but safe approach:
+      If the filesystem has < sec mtime we can be reasonably sure
+      that the filesystem has some sub-second resolution.  On Windows
+      it is likely to be sub-millisecond; on Linux systems it depends
+      on the filesystem, ext4 is typically 1ms, 4ms or 10ms resolution.
+
+     ## Perhaps find a better algorithm here. This will fail once
+        in every 1000 cases on a millisecond precision filesystem
+        if the mtime happens to be an exact second.
+
+        But better to fail once in every thousand cases than every
+        time, like we did before.
+
+     Note for further research on algorithm:
+       FAT32 has < 1 sec precision on ctime, but 2 sec on mtime.
+
+       Linux/ext4 with CONFIG_HZ=250 has high resolution
+       apr_time_now and although the filesystem timestamps
+       have similar high precision they are only updated with
+       a coarser 4ms resolution. */
+  return (finfo.mtime % APR_USEC_PER_SEC) != 0;
+}
+
+/* 10 milliseconds after now. */
+#ifndef SVN_HI_RES_SLEEP_MS
+#define SVN_HI_RES_SLEEP_MS 10
+#endif
+
 void
 svn_io_sleep_for_timestamps(const char *path, apr_pool_t *pool)
 {
   apr_time_t now, then;
-  svn_error_t *err;
   char *sleep_env_var;
 
   sleep_env_var = getenv(SVN_SLEEP_ENV_VAR);
@@ -1334,43 +1536,8 @@ svn_io_sleep_for_timestamps(const char *path, apr_pool_t *pool)
      if we can sleep shorter than that */
   if (path)
     {
-      apr_finfo_t finfo;
-
-      err = svn_io_stat(&finfo, path, APR_FINFO_MTIME | APR_FINFO_LINK, pool);
-
-      if (err)
-        {
-          svn_error_clear(err); /* Fall back on original behavior */
-        }
-      else if (finfo.mtime % APR_USEC_PER_SEC)
-        {
-          /* Very simplistic but safe approach:
-              If the filesystem has < sec mtime we can be reasonably sure
-              that the filesystem has some sub-second resolution.  On Windows
-              it is likely to be sub-millisecond; on Linux systems it depends
-              on the filesystem, ext4 is typically 1ms, 4ms or 10ms resolution.
-
-             ## Perhaps find a better algorithm here. This will fail once
-                in every 1000 cases on a millisecond precision filesystem
-                if the mtime happens to be an exact second.
-
-                But better to fail once in every thousand cases than every
-                time, like we did before.
-
-             Note for further research on algorithm:
-               FAT32 has < 1 sec precision on ctime, but 2 sec on mtime.
-
-               Linux/ext4 with CONFIG_HZ=250 has high resolution
-               apr_time_now and although the filesystem timestamps
-               have similar high precision they are only updated with
-               a coarser 4ms resolution. */
-
-          /* 10 milliseconds after now. */
-#ifndef SVN_HI_RES_SLEEP_MS
-#define SVN_HI_RES_SLEEP_MS 10
-#endif
-          then = now + apr_time_from_msec(SVN_HI_RES_SLEEP_MS);
-        }
+      if (has_hi_res_timestamps(path, pool))
+        then = now + apr_time_from_msec(SVN_HI_RES_SLEEP_MS);
 
       /* Remove time taken to do stat() from sleep. */
       now = apr_time_now();
@@ -1386,6 +1553,21 @@ svn_io_sleep_for_timestamps(const char *path, apr_pool_t *pool)
     apr_sleep(then - now);
 }
 
+apr_time_t
+svn_io__racy_timestamp_limit(const char *path, apr_pool_t *scratch_pool)
+{
+  apr_time_t now = apr_time_now();
+
+  /* Mirror svn_io_sleep_for_timestamps(): a file written from now on may
+     get the same timestamp as one written up to SVN_HI_RES_SLEEP_MS ago,
+     or within the current second, give or take the same 0.02 seconds of
+     slack, if we can't tell. */
+  if (path && has_hi_res_timestamps(path, scratch_pool))
+    return now - apr_time_from_msec(SVN_HI_RES_SLEEP_MS);
+
+  return apr_time_make(apr_time_sec(now - APR_USEC_PER_SEC / 50), 0);
+}
+
 
 svn_error_t *
 svn_io_filesizes_different_p(svn_boolean_t *different_p,
@@ -2808,6 +2990,242 @@ svn_io_dirent2_dup(const svn_io_dirent2_t *item,
                      sizeof(*item));
 }
 
+/* A directory entry whose size and mtime are still to be determined. */
+typedef struct stat_request_t
+{
+  /* The entry's name in the native encoding and in UTF-8. */
+  const char *name_native;
+  const char *name;
+
+  /* Receives the results. */
+  svn_io_dirent2_t *dirent;
+
+#ifdef SVN_IO__HAVE_URING_STATX
+  struct statx stx;
+#endif
+
+  /* Set once DIRENT has been filled in. */
+  svn_boolean_t done;
+} stat_request_t;
+
+#ifdef SVN_IO__HAVE_URING_STATX
+
+/* Maximum number of statx requests in flight. */
+#define STAT_URING_ENTRIES 128
+
+/* lstat() the COUNT entries in REQUESTS relative to the directory open
+   as DIRFD by submitting statx requests to an io_uring in batches, so
+   that the kernel can process them without one blocking system call per
+   entry.  Fill in the dirents and set the DONE flag of the requests that
+   succeed and leave the others alone.  If io_uring is not available,
+   e.g. because the kernel is too old or a security policy prevents its
+   use, do nothing. */
+static void
+uring_lstat(int dirfd,
+            stat_request_t *requests,
+            int count)
+{
+  struct io_uring_params params;
+  struct io_uring_sqe *sqes;
+  struct io_uring_cqe *cqes;
+  char *ring;
+  size_t ring_size, sqes_size;
+  unsigned *sq_tail, *sq_mask, *sq_array, *cq_head, *cq_tail, *cq_mask;
+  int fd;
+  int first;
+
+  memset(&params, 0, sizeof(params));
+  fd = (int)syscall(__NR_io_uring_setup, MIN(count, STAT_URING_ENTRIES),
+                    &params);
+  if (fd < 0)
+    return;
+
+  /* Only support kernels that map both queues at once (Linux 5.4+). */
+  if (!(params.features & IORING_FEAT_SINGLE_MMAP))
+    {
+      close(fd);
+      return;
+    }
+
+  ring_size = MAX(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                  params.cq_off.cqes
+                  + params.cq_entries * sizeof(struct io_uring_cqe));
+  ring = mmap(NULL, ring_size, PROT_READ | PROT_WRITE,
+              MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (ring == MAP_FAILED)
+    {
+      close(fd);
+      return;
+    }
+
+  sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+  sqes = mmap(NULL, sqes_size, PROT_READ | PROT_WRITE,
+              MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED)
+    {
+      munmap(ring, ring_size);
+      close(fd);
+      return;
+    }
+
+  sq_tail = (unsigned *)(ring + params.sq_off.tail);
+  sq_mask = (unsigned *)(ring + params.sq_off.ring_mask);
+  sq_array = (unsigned *)(ring + params.sq_off.array);
+  cq_head = (unsigned *)(ring + params.cq_off.head);
+  cq_tail = (unsigned *)(ring + params.cq_off.tail);
+  cq_mask = (unsigned *)(ring + params.cq_off.ring_mask);
+  cqes = (struct io_uring_cqe *)(ring + params.cq_off.cqes);
+
+  for (first = 0; first < count; first += params.sq_entries)
+    {
+      unsigned batch = MIN(count - first, (int)params.sq_entries);
+      unsigned tail = *sq_tail;
+      unsigned submitted = 0;
+      unsigned completed = 0;
+      unsigned i;
+
+      /* Queue one statx request per entry. */
+      for (i = 0; i < batch; ++i)
+        {
+          stat_request_t *request = &requests[first + i];
+          unsigned idx = tail & *sq_mask;
+          struct io_uring_sqe *sqe = &sqes[idx];
+
+          memset(sqe, 0, sizeof(*sqe));
+          sqe->opcode = IORING_OP_STATX;
+          sqe->fd = dirfd;
+          sqe->addr = (apr_uint64_t)(apr_uintptr_t)request->name_native;
+          sqe->len = STATX_TYPE | STATX_MODE | STATX_SIZE | STATX_MTIME;
+          sqe->off = (apr_uint64_t)(apr_uintptr_t)&request->stx;
+          sqe->statx_flags = AT_SYMLINK_NOFOLLOW;
+          sqe->user_data = (apr_uint64_t)(apr_uintptr_t)request;
+
+          sq_array[idx] = idx;
+          ++tail;
+        }
+
+      __atomic_store_n(sq_tail, tail, __ATOMIC_RELEASE);
+
+      while (submitted < batch)
+        {
+          int rv = (int)syscall(__NR_io_uring_enter, fd, batch - submitted,
+                                0, 0, NULL, 0);
+          if (rv > 0)
+            submitted += rv;
+          else if (rv == 0 || errno != EINTR)
+            break;
+        }
+
+      /* Reap the results of everything that we submitted.  Failed
+         requests, e.g. for kernels without IORING_OP_STATX, are left to
+         the caller. */
+      while (completed < submitted)
+        {
+          unsigned head = *cq_head;
+          unsigned ctail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+
+          if (head == ctail)
+            {
+              syscall(__NR_io_uring_enter, fd, 0, 1,
+                      IORING_ENTER_GETEVENTS, NULL, 0);
+              continue;
+            }
+
+          for (; head != ctail; ++head, ++completed)
+            {
+              struct io_uring_cqe *cqe = &cqes[head & *cq_mask];
+              stat_request_t *request
+                = (stat_request_t *)(apr_uintptr_t)cqe->user_data;
+              apr_finfo_t finfo;
+
+              if (cqe->res < 0)
+                continue;
+
+              if (S_ISREG(request->stx.stx_mode))
+                finfo.filetype = APR_REG;
+              else if (S_ISDIR(request->stx.stx_mode))
+                finfo.filetype = APR_DIR;
+              else if (S_ISLNK(request->stx.stx_mode))
+                finfo.filetype = APR_LNK;
+              else
+                finfo.filetype = APR_UNKFILE;
+
+              map_apr_finfo_to_node_kind(&request->dirent->kind,
+                                         &request->dirent->special,
+                                         &finfo);
+              request->dirent->filesize = request->stx.stx_size;
+              request->dirent->mtime
+                = apr_time_make(request->stx.stx_mtime.tv_sec,
+                                request->stx.stx_mtime.tv_nsec / 1000);
+              request->done = TRUE;
+            }
+
+          __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+        }
+
+      /* The kernel refused to take more.  Leave the rest to the caller. */
+      if (submitted < batch)
+        break;
+    }
+
+  munmap(sqes, sqes_size);
+  munmap(ring, ring_size);
+  close(fd);
+}
+
+/* Determine the kind, size and mtime of the COUNT entries in REQUESTS
+   of the directory PATH, the way apr_dir_read() would with
+   APR_FINFO_SIZE and APR_FINFO_MTIME, but with as few blocking system
+   calls as the platform allows.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+lstat_dirents(const char *path,
+              stat_request_t *requests,
+              int count,
+              apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool;
+  const char *path_apr;
+  int dirfd;
+  int i;
+
+  SVN_ERR(cstring_from_utf8(&path_apr, path, scratch_pool));
+  dirfd = open(path_apr[0] ? path_apr : ".",
+               O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (dirfd >= 0)
+    {
+      uring_lstat(dirfd, requests, count);
+      close(dirfd);
+    }
+
+  /* Whatever is left, we stat the traditional way. */
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < count; i++)
+    {
+      stat_request_t *request = &requests[i];
+      apr_finfo_t finfo;
+
+      if (request->done)
+        continue;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_io_stat(&finfo, svn_dirent_join(path, request->name,
+                                                  iterpool),
+                          APR_FINFO_TYPE | APR_FINFO_LINK
+                          | APR_FINFO_SIZE | APR_FINFO_MTIME,
+                          iterpool));
+
+      map_apr_finfo_to_node_kind(&request->dirent->kind,
+                                 &request->dirent->special, &finfo);
+      request->dirent->filesize = finfo.size;
+      request->dirent->mtime = finfo.mtime;
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#endif
+
 svn_error_t *
 svn_io_get_dirents3(apr_hash_t **dirents,
                     const char *path,
@@ -2819,9 +3237,18 @@ svn_io_get_dirents3(apr_hash_t **dirents,
   apr_dir_t *this_dir;
   apr_finfo_t this_entry;
   apr_int32_t flags = APR_FINFO_TYPE | APR_FINFO_NAME;
+  apr_array_header_t *requests = NULL;
 
   if (!only_check_type)
-    flags |= APR_FINFO_SIZE | APR_FINFO_MTIME;
+    {
+#ifdef SVN_IO__HAVE_URING_STATX
+      /* Collect the names only, which needs no stat() per entry, and get
+         the rest for all entries at once below. */
+      requests = apr_array_make(scratch_pool, 64, sizeof(stat_request_t));
+#else
+      flags |= APR_FINFO_SIZE | APR_FINFO_MTIME;
+#endif
+    }
 
   *dirents = apr_hash_make(result_pool);
 
@@ -2849,7 +3276,17 @@ svn_io_get_dirents3(apr_hash_t **dirents,
                                      &(dirent->special),
                                      &this_entry);
 
-          if (!only_check_type)
+          if (requests)
+            {
+              stat_request_t *request = apr_array_push(requests);
+
+              memset(request, 0, sizeof(*request));
+              request->name_native = apr_pstrdup(scratch_pool,
+                                                 this_entry.name);
+              request->name = name;
+              request->dirent = dirent;
+            }
+          else if (!only_check_type)
             {
               dirent->filesize = this_entry.size;
               dirent->mtime = this_entry.mtime;
@@ -2868,6 +3305,12 @@ svn_io_get_dirents3(apr_hash_t **dirents,
     return svn_error_wrap_apr(status, _("Error closing directory '%s'"),
                               svn_dirent_local_style(path, scratch_pool));
 
+#ifdef SVN_IO__HAVE_URING_STATX
+  if (requests && requests->nelts)
+    SVN_ERR(lstat_dirents(path, (stat_request_t *)requests->elts,
+                          requests->nelts, scratch_pool));
+#endif
+
   return SVN_NO_ERROR;
 }
 
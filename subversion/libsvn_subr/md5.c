@@ -22,11 +22,265 @@
  */
 
 
+#include <string.h>
 #include <apr_md5.h>
 
 #include "svn_checksum.h"
 #include "svn_md5.h"
 #include "checksum.h"
+#include "md5.h"
+
+
+/* MD5 processes data in blocks of this many bytes.
+ */
+#define MD5_BLOCK_SIZE 64
+
+struct svn_md5__context_t
+{
+  /* Intermediate hash value A .. D. */
+  apr_uint32_t state[4];
+
+  /* Total number of bytes fed into the context so far. */
+  apr_uint64_t length;
+
+  /* Data of the current, incomplete block.  Only the first
+   * LENGTH % MD5_BLOCK_SIZE bytes are valid. */
+  unsigned char buffer[MD5_BLOCK_SIZE];
+};
+
+/* Return the little-endian 32 bit word at P.
+ */
+static APR_INLINE apr_uint32_t
+load_le32(const unsigned char *p)
+{
+#if SVN_UNALIGNED_ACCESS_IS_OK && !APR_IS_BIGENDIAN
+  apr_uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+#else
+  return (apr_uint32_t)p[0] | ((apr_uint32_t)p[1] << 8)
+       | ((apr_uint32_t)p[2] << 16) | ((apr_uint32_t)p[3] << 24);
+#endif
+}
+
+/* Store VALUE as little-endian 32 bit word at P.
+ */
+static APR_INLINE void
+store_le32(unsigned char *p, apr_uint32_t value)
+{
+  p[0] = (unsigned char)value;
+  p[1] = (unsigned char)(value >> 8);
+  p[2] = (unsigned char)(value >> 16);
+  p[3] = (unsigned char)(value >> 24);
+}
+
+/* The MD5 round functions, using as few operations as possible.
+ * F and G are the "select" functions and save one operation each
+ * compared to RFC 1321. */
+#define MD5_F(x, y, z) ((z) ^ ((x) & ((y) ^ (z))))
+#define MD5_G(x, y, z) ((y) ^ ((z) & ((x) ^ (y))))
+#define MD5_H(x, y, z) ((x) ^ (y) ^ (z))
+#define MD5_I(x, y, z) ((y) ^ ((x) | ~(z)))
+
+/* One MD5 step with function F, message word XK, shift S and constant AC. */
+#define MD5_STEP(F, a, b, c, d, xk, s, ac)          \
+  do {                                              \
+    a += F(b, c, d) + (xk) + (apr_uint32_t)(ac);    \
+    a = ((a) << (s)) | ((a) >> (32 - (s)));         \
+    a += b;                                         \
+  } while (0)
+
+/* Update STATE with COUNT consecutive MD5_BLOCK_SIZE blocks read from
+ * DATA.
+ */
+static void
+md5_blocks(apr_uint32_t state[4],
+           const unsigned char *data,
+           apr_size_t count)
+{
+  apr_uint32_t x[16];
+  apr_uint32_t a, b, c, d;
+  int i;
+
+  for (; count > 0; --count, data += MD5_BLOCK_SIZE)
+    {
+      for (i = 0; i < 16; ++i)
+        x[i] = load_le32(data + 4 * i);
+
+      a = state[0];
+      b = state[1];
+      c = state[2];
+      d = state[3];
+
+      MD5_STEP(MD5_F, a, b, c, d, x[ 0],  7, 0xd76aa478);
+      MD5_STEP(MD5_F, d, a, b, c, x[ 1], 12, 0xe8c7b756);
+      MD5_STEP(MD5_F, c, d, a, b, x[ 2], 17, 0x242070db);
+      MD5_STEP(MD5_F, b, c, d, a, x[ 3], 22, 0xc1bdceee);
+      MD5_STEP(MD5_F, a, b, c, d, x[ 4],  7, 0xf57c0faf);
+      MD5_STEP(MD5_F, d, a, b, c, x[ 5], 12, 0x4787c62a);
+      MD5_STEP(MD5_F, c, d, a, b, x[ 6], 17, 0xa8304613);
+      MD5_STEP(MD5_F, b, c, d, a, x[ 7], 22, 0xfd469501);
+      MD5_STEP(MD5_F, a, b, c, d, x[ 8],  7, 0x698098d8);
+      MD5_STEP(MD5_F, d, a, b, c, x[ 9], 12, 0x8b44f7af);
+      MD5_STEP(MD5_F, c, d, a, b, x[10], 17, 0xffff5bb1);
+      MD5_STEP(MD5_F, b, c, d, a, x[11], 22, 0x895cd7be);
+      MD5_STEP(MD5_F, a, b, c, d, x[12],  7, 0x6b901122);
+      MD5_STEP(MD5_F, d, a, b, c, x[13], 12, 0xfd987193);
+      MD5_STEP(MD5_F, c, d, a, b, x[14], 17, 0xa679438e);
+      MD5_STEP(MD5_F, b, c, d, a, x[15], 22, 0x49b40821);
+
+      MD5_STEP(MD5_G, a, b, c, d, x[ 1],  5, 0xf61e2562);
+      MD5_STEP(MD5_G, d, a, b, c, x[ 6],  9, 0xc040b340);
+      MD5_STEP(MD5_G, c, d, a, b, x[11], 14, 0x265e5a51);
+      MD5_STEP(MD5_G, b, c, d, a, x[ 0], 20, 0xe9b6c7aa);
+      MD5_STEP(MD5_G, a, b, c, d, x[ 5],  5, 0xd62f105d);
+      MD5_STEP(MD5_G, d, a, b, c, x[10],  9, 0x02441453);
+      MD5_STEP(MD5_G, c, d, a, b, x[15], 14, 0xd8a1e681);
+      MD5_STEP(MD5_G, b, c, d, a, x[ 4], 20, 0xe7d3fbc8);
+      MD5_STEP(MD5_G, a, b, c, d, x[ 9],  5, 0x21e1cde6);
+      MD5_STEP(MD5_G, d, a, b, c, x[14],  9, 0xc33707d6);
+      MD5_STEP(MD5_G, c, d, a, b, x[ 3], 14, 0xf4d50d87);
+      MD5_STEP(MD5_G, b, c, d, a, x[ 8], 20, 0x455a14ed);
+      MD5_STEP(MD5_G, a, b, c, d, x[13],  5, 0xa9e3e905);
+      MD5_STEP(MD5_G, d, a, b, c, x[ 2],  9, 0xfcefa3f8);
+      MD5_STEP(MD5_G, c, d, a, b, x[ 7], 14, 0x676f02d9);
+      MD5_STEP(MD5_G, b, c, d, a, x[12], 20, 0x8d2a4c8a);
+
+      MD5_STEP(MD5_H, a, b, c, d, x[ 5],  4, 0xfffa3942);
+      MD5_STEP(MD5_H, d, a, b, c, x[ 8], 11, 0x8771f681);
+      MD5_STEP(MD5_H, c, d, a, b, x[11], 16, 0x6d9d6122);
+      MD5_STEP(MD5_H, b, c, d, a, x[14], 23, 0xfde5380c);
+      MD5_STEP(MD5_H, a, b, c, d, x[ 1],  4, 0xa4beea44);
+      MD5_STEP(MD5_H, d, a, b, c, x[ 4], 11, 0x4bdecfa9);
+      MD5_STEP(MD5_H, c, d, a, b, x[ 7], 16, 0xf6bb4b60);
+      MD5_STEP(MD5_H, b, c, d, a, x[10], 23, 0xbebfbc70);
+      MD5_STEP(MD5_H, a, b, c, d, x[13],  4, 0x289b7ec6);
+      MD5_STEP(MD5_H, d, a, b, c, x[ 0], 11, 0xeaa127fa);
+      MD5_STEP(MD5_H, c, d, a, b, x[ 3], 16, 0xd4ef3085);
+      MD5_STEP(MD5_H, b, c, d, a, x[ 6], 23, 0x04881d05);
+      MD5_STEP(MD5_H, a, b, c, d, x[ 9],  4, 0xd9d4d039);
+      MD5_STEP(MD5_H, d, a, b, c, x[12], 11, 0xe6db99e5);
+      MD5_STEP(MD5_H, c, d, a, b, x[15], 16, 0x1fa27cf8);
+      MD5_STEP(MD5_H, b, c, d, a, x[ 2], 23, 0xc4ac5665);
+
+      MD5_STEP(MD5_I, a, b, c, d, x[ 0],  6, 0xf4292244);
+      MD5_STEP(MD5_I, d, a, b, c, x[ 7], 10, 0x432aff97);
+      MD5_STEP(MD5_I, c, d, a, b, x[14], 15, 0xab9423a7);
+      MD5_STEP(MD5_I, b, c, d, a, x[ 5], 21, 0xfc93a039);
+      MD5_STEP(MD5_I, a, b, c, d, x[12],  6, 0x655b59c3);
+      MD5_STEP(MD5_I, d, a, b, c, x[ 3], 10, 0x8f0ccc92);
+      MD5_STEP(MD5_I, c, d, a, b, x[10], 15, 0xffeff47d);
+      MD5_STEP(MD5_I, b, c, d, a, x[ 1], 21, 0x85845dd1);
+      MD5_STEP(MD5_I, a, b, c, d, x[ 8],  6, 0x6fa87e4f);
+      MD5_STEP(MD5_I, d, a, b, c, x[15], 10, 0xfe2ce6e0);
+      MD5_STEP(MD5_I, c, d, a, b, x[ 6], 15, 0xa3014314);
+      MD5_STEP(MD5_I, b, c, d, a, x[13], 21, 0x4e0811a1);
+      MD5_STEP(MD5_I, a, b, c, d, x[ 4],  6, 0xf7537e82);
+      MD5_STEP(MD5_I, d, a, b, c, x[11], 10, 0xbd3af235);
+      MD5_STEP(MD5_I, c, d, a, b, x[ 2], 15, 0x2ad7d2bb);
+      MD5_STEP(MD5_I, b, c, d, a, x[ 9], 21, 0xeb86d391);
+
+      state[0] += a;
+      state[1] += b;
+      state[2] += c;
+      state[3] += d;
+    }
+}
+
+/* Initialize CONTEXT for a new checksum.
+ */
+static void
+md5_init(svn_md5__context_t *context)
+{
+  context->state[0] = 0x67452301;
+  context->state[1] = 0xefcdab89;
+  context->state[2] = 0x98badcfe;
+  context->state[3] = 0x10325476;
+  context->length = 0;
+}
+
+svn_md5__context_t *
+svn_md5__context_create(apr_pool_t *pool)
+{
+  svn_md5__context_t *context = apr_palloc(pool, sizeof(*context));
+  md5_init(context);
+
+  return context;
+}
+
+void
+svn_md5__update(svn_md5__context_t *context,
+                const void *data,
+                apr_size_t len)
+{
+  const unsigned char *input = data;
+  apr_size_t used = (apr_size_t)(context->length % MD5_BLOCK_SIZE);
+
+  context->length += len;
+
+  /* Complete a partial block from previous calls first. */
+  if (used)
+    {
+      apr_size_t to_copy = MD5_BLOCK_SIZE - used;
+      if (to_copy > len)
+        to_copy = len;
+
+      memcpy(context->buffer + used, input, to_copy);
+      input += to_copy;
+      len -= to_copy;
+
+      if (used + to_copy < MD5_BLOCK_SIZE)
+        return;
+
+      md5_blocks(context->state, context->buffer, 1);
+    }
+
+  /* Process all complete blocks directly from the input. */
+  if (len >= MD5_BLOCK_SIZE)
+    {
+      apr_size_t count = len / MD5_BLOCK_SIZE;
+      md5_blocks(context->state, input, count);
+      input += count * MD5_BLOCK_SIZE;
+      len -= count * MD5_BLOCK_SIZE;
+    }
+
+  /* Keep the remainder for later. */
+  if (len)
+    memcpy(context->buffer, input, len);
+}
+
+void
+svn_md5__finalize(unsigned char digest[APR_MD5_DIGESTSIZE],
+                  const svn_md5__context_t *context)
+{
+  svn_md5__context_t tail = *context;
+  unsigned char padding[2 * MD5_BLOCK_SIZE] = { 0x80 };
+  apr_size_t used = (apr_size_t)(context->length % MD5_BLOCK_SIZE);
+  apr_size_t padding_len = (used < MD5_BLOCK_SIZE - 8 ? 1 : 2)
+                         * MD5_BLOCK_SIZE - used;
+  apr_uint64_t bits = context->length * 8;
+  int i;
+
+  /* Append the 1 bit, zeros and the message length in bits. */
+  store_le32(padding + padding_len - 8, (apr_uint32_t)bits);
+  store_le32(padding + padding_len - 4, (apr_uint32_t)(bits >> 32));
+  svn_md5__update(&tail, padding, padding_len);
+
+  for (i = 0; i < 4; ++i)
+    store_le32(digest + 4 * i, tail.state[i]);
+}
+
+void
+svn__md5(unsigned char digest[APR_MD5_DIGESTSIZE],
+         const void *input,
+         apr_size_t len)
+{
+  svn_md5__context_t context;
+
+  md5_init(&context);
+  svn_md5__update(&context, input, len);
+  svn_md5__finalize(digest, &context);
+}
 
 
 
@@ -0,0 +1,70 @@
+/*
+ * md5.h :  optimized MD5 implementation
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_SUBR_MD5_H
+#define SVN_LIBSVN_SUBR_MD5_H
+
+#include <apr_pools.h>
+#include <apr_md5.h>
+
+#include "svn_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Opaque MD5 checksum creation context type.
+ */
+typedef struct svn_md5__context_t svn_md5__context_t;
+
+/* Return a new MD5 checksum creation context allocated in POOL.
+ */
+svn_md5__context_t *
+svn_md5__context_create(apr_pool_t *pool);
+
+/* Feed LEN bytes from DATA into the MD5 checksum creation CONTEXT.
+ */
+void
+svn_md5__update(svn_md5__context_t *context,
+                const void *data,
+                apr_size_t len);
+
+/* Write the MD5 checksum over all data fed into CONTEXT to DIGEST.
+ * CONTEXT itself remains unchanged.
+ */
+void
+svn_md5__finalize(unsigned char digest[APR_MD5_DIGESTSIZE],
+                  const svn_md5__context_t *context);
+
+/* Write the MD5 checksum over the first LEN bytes in INPUT to DIGEST.
+ */
+void
+svn__md5(unsigned char digest[APR_MD5_DIGESTSIZE],
+         const void *input,
+         apr_size_t len);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_SUBR_MD5_H */
@@ -41,6 +41,78 @@
 #include "svn_hash.h"
 #include "private/svn_dep_compat.h"
 
+/* Hands out svn_merge_range_t structures from blocks allocated in POOL.
+   Building a rangelist this way costs one allocation per block instead
+   of one per range and keeps the ranges of a list next to each other. */
+typedef struct range_arena_t
+{
+  /* The unused part of the current block. */
+  svn_merge_range_t *next;
+  int left;
+
+  /* Number of ranges in the next block. */
+  int block_size;
+
+  apr_pool_t *pool;
+} range_arena_t;
+
+/* Initialize ARENA to allocate from POOL, expecting about SIZE_HINT
+   ranges to be needed. */
+static void
+range_arena_init(range_arena_t *arena,
+                 int size_hint,
+                 apr_pool_t *pool)
+{
+  arena->next = NULL;
+  arena->left = 0;
+  arena->block_size = MAX(size_hint, 4);
+  arena->pool = pool;
+}
+
+/* Return an uninitialized range from ARENA. */
+static svn_merge_range_t *
+range_arena_alloc(range_arena_t *arena)
+{
+  if (arena->left == 0)
+    {
+      arena->next = apr_palloc(arena->pool,
+                               arena->block_size * sizeof(*arena->next));
+      arena->left = arena->block_size;
+
+      /* Grow geometrically if the hint was too low. */
+      arena->block_size *= 2;
+    }
+
+  arena->left--;
+  return arena->next++;
+}
+
+/* Return a copy of RANGE allocated from ARENA. */
+static svn_merge_range_t *
+range_arena_dup(range_arena_t *arena,
+                const svn_merge_range_t *range)
+{
+  svn_merge_range_t *copy = range_arena_alloc(arena);
+
+  *copy = *range;
+  return copy;
+}
+
+/* Return the number of elements of the revision list starting at INPUT
+   and ending at the next newline or END, whichever comes first. */
+static int
+count_rangelist_elements(const char *input,
+                         const char *end)
+{
+  int count = 1;
+
+  for (; input < end && *input != '\n'; input++)
+    if (*input == ',')
+      count++;
+
+  return count;
+}
+
 /* Attempt to combine two ranges, IN1 and IN2. If they are adjacent or
    overlapping, and their inheritability allows them to be combined, put
    the result in OUTPUT and return TRUE, otherwise return FALSE.
@@ -236,15 +308,15 @@ get_type_of_intersection(const svn_merge_range_t *r1,
      -------------        ---------        ----------------
      4-10                 6*               4-10 (Not 4-5, 6, 7-10)
 
-   When replacing the last range in RANGELIST, either allocate a new range in
-   RESULT_POOL or modify the existing range in place.  Any new ranges added
-   to RANGELIST are allocated in RESULT_POOL.
+   When replacing the last range in RANGELIST, either allocate a new range
+   from ARENA or modify the existing range in place.  Any new ranges added
+   to RANGELIST are allocated from ARENA.
 */
 static svn_error_t *
 combine_with_lastrange(const svn_merge_range_t *new_range,
                        svn_rangelist_t *rangelist,
                        svn_boolean_t consider_inheritance,
-                       apr_pool_t *result_pool)
+                       range_arena_t *arena)
 {
   svn_merge_range_t *lastrange;
   svn_merge_range_t combined_range;
@@ -261,7 +333,7 @@ combine_with_lastrange(const svn_merge_range_t *new_range,
     {
       /* No *LASTRANGE so push NEW_RANGE onto RANGELIST and we are done. */
       APR_ARRAY_PUSH(rangelist, svn_merge_range_t *) =
-        svn_merge_range_dup(new_range, result_pool);
+        range_arena_dup(arena, new_range);
     }
   else if (!consider_inheritance)
     {
@@ -275,7 +347,7 @@ combine_with_lastrange(const svn_merge_range_t *new_range,
       else
         {
           APR_ARRAY_PUSH(rangelist, svn_merge_range_t *) =
-            svn_merge_range_dup(new_range, result_pool);
+            range_arena_dup(arena, new_range);
         }
     }
   else /* Considering inheritance */
@@ -303,7 +375,7 @@ combine_with_lastrange(const svn_merge_range_t *new_range,
                 /* NEW_RANGE and *LASTRANGE *really* don't intersect so
                    just push NEW_RANGE onto RANGELIST. */
                 APR_ARRAY_PUSH(rangelist, svn_merge_range_t *) =
-                  svn_merge_range_dup(new_range, result_pool);
+                  range_arena_dup(arena, new_range);
                 sorted = (svn_sort_compare_ranges(&lastrange,
                                                   &new_range) < 0);
                 break;
@@ -319,7 +391,7 @@ combine_with_lastrange(const svn_merge_range_t *new_range,
                 /* They adjoin but don't overlap so just push NEW_RANGE
                    onto RANGELIST. */
                 APR_ARRAY_PUSH(rangelist, svn_merge_range_t *) =
-                  svn_merge_range_dup(new_range, result_pool);
+                  range_arena_dup(arena, new_range);
                 sorted = (svn_sort_compare_ranges(&lastrange,
                                                   &new_range) < 0);
                 break;
@@ -330,10 +402,10 @@ combine_with_lastrange(const svn_merge_range_t *new_range,
                    RANGELIST, the intersecting part and the part unique to
                    NEW_RANGE.*/
                 {
-                  svn_merge_range_t *r1 = svn_merge_range_dup(lastrange,
-                                                              result_pool);
-                  svn_merge_range_t *r2 = svn_merge_range_dup(new_range,
-                                                              result_pool);
+                  svn_merge_range_t *r1 = range_arena_dup(arena,
+                                                              lastrange);
+                  svn_merge_range_t *r2 = range_arena_dup(arena,
+                                                              new_range);
 
                   /* Pop off *LASTRANGE to make our manipulations
                      easier. */
@@ -367,10 +439,10 @@ combine_with_lastrange(const svn_merge_range_t *new_range,
               default: /* svn__proper_subset_intersection */
                 {
                   /* One range is a proper subset of the other. */
-                  svn_merge_range_t *r1 = svn_merge_range_dup(lastrange,
-                                                              result_pool);
-                  svn_merge_range_t *r2 = svn_merge_range_dup(new_range,
-                                                              result_pool);
+                  svn_merge_range_t *r1 = range_arena_dup(arena,
+                                                              lastrange);
+                  svn_merge_range_t *r2 = range_arena_dup(arena,
+                                                              new_range);
                   svn_merge_range_t *r3 = NULL;
 
                   /* Pop off *LASTRANGE to make our manipulations
@@ -415,7 +487,7 @@ combine_with_lastrange(const svn_merge_range_t *new_range,
                     {
                       /* NEW_RANGE and *LASTRANGE share neither start
                          nor end points. */
-                      r3 = apr_pcalloc(result_pool, sizeof(*r3));
+                      r3 = range_arena_alloc(arena);
                       r3->start = r2->end;
                       r3->end = r1->end;
                       r3->inheritable = r1->inheritable;
@@ -478,10 +550,10 @@ range_to_string(const svn_merge_range_t *range,
 }
 
 /* Helper for svn_mergeinfo_parse()
-   Append revision ranges onto the array RANGELIST to represent the range
-   descriptions found in the string *INPUT.  Read only as far as a newline
-   or the position END, whichever comes first.  Set *INPUT to the position
-   after the last character of INPUT that was used.
+   Set *RANGELIST to a new array of revision ranges, allocated in POOL, to
+   represent the range descriptions found in the string *INPUT.  Read only
+   as far as a newline or the position END, whichever comes first.  Set
+   *INPUT to the position after the last character of INPUT that was used.
 
    revisionlist -> (revisionelement)(COMMA revisionelement)*
    revisionrange -> REVISION "-" REVISION("*")
@@ -489,10 +561,13 @@ range_to_string(const svn_merge_range_t *range,
 */
 static svn_error_t *
 parse_rangelist(const char **input, const char *end,
-                svn_rangelist_t *rangelist,
+                svn_rangelist_t **rangelist_p,
                 apr_pool_t *pool)
 {
   const char *curr = *input;
+  svn_rangelist_t *rangelist;
+  range_arena_t arena;
+  int count;
 
   /* Eat any leading horizontal white-space before the rangelist. */
   while (curr < end && *curr != '\n' && isspace(*curr))
@@ -501,14 +576,21 @@ parse_rangelist(const char **input, const char *end,
   if (*curr == '\n' || curr == end)
     {
       /* Empty range list. */
+      *rangelist_p = apr_array_make(pool, 0, sizeof(svn_merge_range_t *));
       *input = curr;
       return SVN_NO_ERROR;
     }
 
+  /* Allocate the list and all of its ranges in one go. */
+  count = count_rangelist_elements(curr, end);
+  rangelist = apr_array_make(pool, count, sizeof(svn_merge_range_t *));
+  range_arena_init(&arena, count, pool);
+  *rangelist_p = rangelist;
+
   while (curr < end && *curr != '\n')
     {
       /* Parse individual revisions or revision ranges. */
-      svn_merge_range_t *mrange = apr_pcalloc(pool, sizeof(*mrange));
+      svn_merge_range_t *mrange = range_arena_alloc(&arena);
       svn_revnum_t firstrev;
 
       SVN_ERR(svn_revnum_parse(&firstrev, curr, &curr));
@@ -603,8 +685,7 @@ svn_rangelist__parse(svn_rangelist_t **rangelist,
 {
   const char *s = str;
 
-  *rangelist = apr_array_make(result_pool, 1, sizeof(svn_merge_range_t *));
-  SVN_ERR(parse_rangelist(&s, s + strlen(s), *rangelist, result_pool));
+  SVN_ERR(parse_rangelist(&s, s + strlen(s), rangelist, result_pool));
   return SVN_NO_ERROR;
 }
 
@@ -704,8 +785,7 @@ parse_revision_line(const char **input, const char *end, svn_mergeinfo_t hash,
   const char *pathname = "";
   apr_ssize_t klen;
   svn_rangelist_t *existing_rangelist;
-  svn_rangelist_t *rangelist = apr_array_make(scratch_pool, 1,
-                                              sizeof(svn_merge_range_t *));
+  svn_rangelist_t *rangelist;
 
   SVN_ERR(parse_pathname(input, end, &pathname, scratch_pool));
 
@@ -715,7 +795,7 @@ parse_revision_line(const char **input, const char *end, svn_mergeinfo_t hash,
 
   *input = *input + 1;
 
-  SVN_ERR(parse_rangelist(input, end, rangelist, scratch_pool));
+  SVN_ERR(parse_rangelist(input, end, &rangelist, scratch_pool));
 
   if (rangelist->nelts == 0)
       return svn_error_createf(SVN_ERR_MERGEINFO_PARSE_ERROR, NULL,
@@ -963,10 +1043,15 @@ svn_rangelist_merge2(svn_rangelist_t *rangelist,
 {
   int i = 0;
   int j = 0;
+  range_arena_t arena;
 
   /* We may modify CHANGES, so make a copy in SCRATCH_POOL. */
   changes = svn_rangelist_dup(changes, scratch_pool);
 
+  /* Most changes are usually absorbed by existing ranges, so start small
+     when allocating copies of them. */
+  range_arena_init(&arena, 0, result_pool);
+
   while (i < rangelist->nelts && j < changes->nelts)
     {
       svn_merge_range_t *range =
@@ -1034,7 +1119,7 @@ svn_rangelist_merge2(svn_rangelist_t *rangelist,
                       /* CHANGE absorbs intersection with RANGE and RANGE
                          is truncated. */
                       svn_merge_range_t *range_copy =
-                        svn_merge_range_dup(range, result_pool);
+                        range_arena_dup(&arena, range);
                       range_copy->end = change->start;
                       range->start = change->start;
                       svn_sort__array_insert(rangelist, &range_copy, i++);
@@ -1058,7 +1143,7 @@ svn_rangelist_merge2(svn_rangelist_t *rangelist,
                  adjoin or overlap, so insert a copy of CHANGE
                  into RANGELIST. */
               svn_merge_range_t *change_copy =
-                svn_merge_range_dup(change, result_pool);
+                range_arena_dup(&arena, change);
               svn_sort__array_insert(rangelist, &change_copy, i++);
               j++;
             }
@@ -1077,7 +1162,7 @@ svn_rangelist_merge2(svn_rangelist_t *rangelist,
                   /* RANGE and CHANGE have different inheritability so insert
                      a copy of CHANGE into RANGELIST. */
                   svn_merge_range_t *change_copy =
-                    svn_merge_range_dup(change, result_pool);
+                    range_arena_dup(&arena, change);
                   svn_sort__array_insert(rangelist, &change_copy, i);
                   j++;
                 }
@@ -1107,7 +1192,7 @@ svn_rangelist_merge2(svn_rangelist_t *rangelist,
                          it overlaps.  CHANGE is truncated and the remainder
                          inserted into RANGELIST. */
                       svn_merge_range_t *change_copy =
-                        svn_merge_range_dup(change, result_pool);
+                        range_arena_dup(&arena, change);
                       change_copy->end = range->start;
                       change->start = range->start;
                       svn_sort__array_insert(rangelist, &change_copy, i++);
@@ -1148,7 +1233,7 @@ svn_rangelist_merge2(svn_rangelist_t *rangelist,
                              intersection with CHANGE and take the remainder
                              of RANGE and insert it into RANGELIST. */
                           svn_merge_range_t *range_copy =
-                            svn_merge_range_dup(range, result_pool);
+                            range_arena_dup(&arena, range);
                           range_copy->start = change->end;
                           range->start = change->start;
                           range->end = change->end;
@@ -1167,7 +1252,7 @@ svn_rangelist_merge2(svn_rangelist_t *rangelist,
                          RANGELIST and then set RANGE to the non-intersecting
                          portion of RANGE. */
                       svn_merge_range_t *range_copy =
-                        svn_merge_range_dup(range, result_pool);
+                        range_arena_dup(&arena, range);
                       range_copy->end = change->end;
                       range_copy->inheritable = TRUE;
                       range->start = change->end;
@@ -1184,8 +1269,7 @@ svn_rangelist_merge2(svn_rangelist_t *rangelist,
     {
       svn_merge_range_t *change =
         APR_ARRAY_IDX(changes, j, svn_merge_range_t *);
-      svn_merge_range_t *change_copy = svn_merge_range_dup(change,
-                                                           result_pool);
+      svn_merge_range_t *change_copy = range_arena_dup(&arena, change);
       svn_sort__array_insert(rangelist, &change_copy, rangelist->nelts);
     }
 
@@ -1328,8 +1412,15 @@ rangelist_intersect_or_remove(svn_rangelist_t **output,
 {
   int i1, i2, lasti2;
   svn_merge_range_t working_elt2;
+  range_arena_t arena;
+  int size_hint;
 
-  *output = apr_array_make(pool, 1, sizeof(svn_merge_range_t *));
+  /* An intersection is usually not longer than the shorter list and what
+     remains after a removal usually not longer than the original list. */
+  size_hint = do_remove ? rangelist2->nelts
+                        : MIN(rangelist1->nelts, rangelist2->nelts);
+  *output = apr_array_make(pool, size_hint, sizeof(svn_merge_range_t *));
+  range_arena_init(&arena, size_hint, pool);
 
   i1 = 0;
   i2 = 0;
@@ -1374,7 +1465,7 @@ rangelist_intersect_or_remove(svn_rangelist_t **output,
                 (elt2->inheritable || elt1->inheritable);
               SVN_ERR(combine_with_lastrange(&tmp_range, *output,
                                              consider_inheritance,
-                                             pool));
+                                             &arena));
             }
 
           i2++;
@@ -1410,7 +1501,7 @@ rangelist_intersect_or_remove(svn_rangelist_t **output,
 
               SVN_ERR(combine_with_lastrange(&tmp_range,
                                              *output, consider_inheritance,
-                                             pool));
+                                             &arena));
             }
 
           /* Set up the rest of the rangelist2 range for further
@@ -1431,7 +1522,7 @@ rangelist_intersect_or_remove(svn_rangelist_t **output,
                   SVN_ERR(combine_with_lastrange(&tmp_range,
                                                  *output,
                                                  consider_inheritance,
-                                                 pool));
+                                                 &arena));
                 }
 
               working_elt2.start = elt1->end;
@@ -1464,7 +1555,7 @@ rangelist_intersect_or_remove(svn_rangelist_t **output,
                                  combine_ranges(lastrange, lastrange, elt2,
                                                 consider_inheritance)))
                 {
-                  lastrange = svn_merge_range_dup(elt2, pool);
+                  lastrange = range_arena_dup(&arena, elt2);
                   APR_ARRAY_PUSH(*output, svn_merge_range_t *) = lastrange;
                 }
               i2++;
@@ -1483,7 +1574,7 @@ rangelist_intersect_or_remove(svn_rangelist_t **output,
       if (i2 == lasti2 && i2 < rangelist2->nelts)
         {
           SVN_ERR(combine_with_lastrange(&working_elt2, *output,
-                                         consider_inheritance, pool));
+                                         consider_inheritance, &arena));
           i2++;
         }
 
@@ -1494,7 +1585,7 @@ rangelist_intersect_or_remove(svn_rangelist_t **output,
                                                  svn_merge_range_t *);
 
           SVN_ERR(combine_with_lastrange(elt, *output,
-                                         consider_inheritance, pool));
+                                         consider_inheritance, &arena));
         }
     }
 
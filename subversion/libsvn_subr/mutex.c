@@ -22,10 +22,16 @@
  */
 
 #include <apr_portable.h>
+#include <apr_hash.h>
+#include <apr_strings.h>
+
+#include "svn_pools.h"
+#include "svn_sorts.h"
 
 #include "svn_private_config.h"
 #include "private/svn_atomic.h"
 #include "private/svn_mutex.h"
+#include "private/svn_sorts_private.h"
 
 /* With CHECKED set to TRUE, LOCKED and OWNER must be set *after* acquiring
  * the MUTEX and be reset *before* releasing it again.  This is sufficient
@@ -39,14 +45,33 @@ struct svn_mutex__t
 
   apr_thread_mutex_t *mutex;
 
-#else
+#endif
 
-  /* Truly empty structs are not allowed. */
-  int dummy;
+  /* Name to record lock statistics under.  NULL for anonymous mutexes. */
+  const char *name;
 
-#endif
+  /* While lock statistics are being collected, the time at which the
+   * current owner acquired the mutex.  0 if not recorded. */
+  apr_time_t acquired;
 };
 
+/* Registry of the lock statistics, created by svn_mutex__enable_stats(). */
+typedef struct stats_registry_t
+{
+  /* Serializes access to STATS. */
+  svn_mutex__t *mutex;
+
+  /* const char * name -> svn_mutex__stats_t *.  Allocated in POOL. */
+  apr_hash_t *stats;
+  apr_pool_t *pool;
+} stats_registry_t;
+
+/* Initialization state of REGISTRY. */
+static volatile svn_atomic_t registry_init_state = 0;
+
+/* The lock statistics.  NULL while they are not being collected. */
+static stats_registry_t * volatile registry = NULL;
+
 svn_error_t *
 svn_mutex__init(svn_mutex__t **mutex_p,
                 svn_boolean_t mutex_required,
@@ -75,15 +100,35 @@ svn_mutex__init(svn_mutex__t **mutex_p,
   return SVN_NO_ERROR;
 }
 
+void
+svn_mutex__set_name(svn_mutex__t *mutex,
+                    const char *name)
+{
+  if (mutex)
+    mutex->name = name;
+}
+
 svn_error_t *
 svn_mutex__lock(svn_mutex__t *mutex)
 {
   if (mutex)
     {
 #if APR_HAS_THREADS
-      apr_status_t status = apr_thread_mutex_lock(mutex->mutex);
+      apr_status_t status;
+      apr_time_t start = 0;
+
+      if (mutex->name && registry)
+        start = apr_time_now();
+
+      status = apr_thread_mutex_lock(mutex->mutex);
       if (status)
         return svn_error_wrap_apr(status, _("Can't lock mutex"));
+
+      if (start)
+        {
+          mutex->acquired = apr_time_now();
+          svn_mutex__stats_add_wait(mutex->name, mutex->acquired - start);
+        }
 #endif
     }
 
@@ -97,7 +142,16 @@ svn_mutex__unlock(svn_mutex__t *mutex,
   if (mutex)
     {
 #if APR_HAS_THREADS
-      apr_status_t status = apr_thread_mutex_unlock(mutex->mutex);
+      apr_status_t status;
+
+      if (mutex->acquired)
+        {
+          svn_mutex__stats_add_hold(mutex->name,
+                                    apr_time_now() - mutex->acquired);
+          mutex->acquired = 0;
+        }
+
+      status = apr_thread_mutex_unlock(mutex->mutex);
       if (status && !err)
         return svn_error_wrap_apr(status, _("Can't unlock mutex"));
 #endif
@@ -106,6 +160,153 @@ svn_mutex__unlock(svn_mutex__t *mutex,
   return err;
 }
 
+/* Implements svn_atomic__err_init_func_t.  Create REGISTRY. */
+static svn_error_t *
+init_registry(void *baton,
+              apr_pool_t *unused_pool)
+{
+  /* The registry lives as long as the process. */
+  apr_pool_t *pool = svn_pool_create(NULL);
+  stats_registry_t *result = apr_pcalloc(pool, sizeof(*result));
+
+  SVN_ERR(svn_mutex__init(&result->mutex, TRUE, pool));
+  result->stats = apr_hash_make(pool);
+  result->pool = pool;
+
+  registry = result;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_mutex__enable_stats(apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(svn_atomic__init_once(&registry_init_state,
+                                               init_registry, NULL,
+                                               scratch_pool));
+}
+
+svn_boolean_t
+svn_mutex__stats_enabled(void)
+{
+  return registry != NULL;
+}
+
+/* Return the statistics entry for NAME in REGISTRY, creating it if
+ * necessary.  The caller must hold REGISTRY->MUTEX. */
+static svn_mutex__stats_t *
+get_stats(const char *name)
+{
+  svn_mutex__stats_t *stats = apr_hash_get(registry->stats, name,
+                                           APR_HASH_KEY_STRING);
+  if (stats == NULL)
+    {
+      stats = apr_pcalloc(registry->pool, sizeof(*stats));
+      stats->name = apr_pstrdup(registry->pool, name);
+      apr_hash_set(registry->stats, stats->name, APR_HASH_KEY_STRING, stats);
+    }
+
+  return stats;
+}
+
+/* Add WAIT or HOLD to the NAME entry in REGISTRY.  Negative values are
+ * ignored.  The caller must hold REGISTRY->MUTEX. */
+static svn_error_t *
+add_stats(const char *name,
+          apr_interval_time_t wait,
+          apr_interval_time_t hold)
+{
+  svn_mutex__stats_t *stats = get_stats(name);
+
+  if (wait >= 0)
+    {
+      ++stats->acquisitions;
+      stats->total_wait += wait;
+      if (wait > stats->max_wait)
+        stats->max_wait = wait;
+    }
+  if (hold >= 0)
+    {
+      ++stats->releases;
+      stats->total_hold += hold;
+      if (hold > stats->max_hold)
+        stats->max_hold = hold;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread-safe wrapper around add_stats().  The registry's own mutex is
+ * anonymous, so locking it does not recurse into here. */
+static svn_error_t *
+add_stats_locked(const char *name,
+                 apr_interval_time_t wait,
+                 apr_interval_time_t hold)
+{
+  SVN_MUTEX__WITH_LOCK(registry->mutex, add_stats(name, wait, hold));
+
+  return SVN_NO_ERROR;
+}
+
+void
+svn_mutex__stats_add_wait(const char *name,
+                          apr_interval_time_t wait)
+{
+  /* Statistics are best-effort. */
+  if (registry)
+    svn_error_clear(add_stats_locked(name, wait, -1));
+}
+
+void
+svn_mutex__stats_add_hold(const char *name,
+                          apr_interval_time_t hold)
+{
+  if (registry)
+    svn_error_clear(add_stats_locked(name, -1, hold));
+}
+
+/* Copy all entries from REGISTRY into *STATS, sorted by name, allocated
+ * in RESULT_POOL.  The caller must hold REGISTRY->MUTEX. */
+static svn_error_t *
+copy_stats(apr_array_header_t **stats,
+           apr_pool_t *result_pool)
+{
+  apr_array_header_t *sorted = svn_sort__hash(registry->stats,
+                                              svn_sort_compare_items_lexically,
+                                              result_pool);
+  int i;
+
+  *stats = apr_array_make(result_pool, sorted->nelts,
+                          sizeof(svn_mutex__stats_t));
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      const svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i,
+                                                    svn_sort__item_t);
+      const svn_mutex__stats_t *entry = item->value;
+
+      APR_ARRAY_PUSH(*stats, svn_mutex__stats_t) = *entry;
+      APR_ARRAY_IDX(*stats, i, svn_mutex__stats_t).name
+        = apr_pstrdup(result_pool, entry->name);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_mutex__get_stats(apr_array_header_t **stats,
+                     apr_pool_t *result_pool)
+{
+  if (registry == NULL)
+    {
+      *stats = apr_array_make(result_pool, 0, sizeof(svn_mutex__stats_t));
+      return SVN_NO_ERROR;
+    }
+
+  SVN_MUTEX__WITH_LOCK(registry->mutex, copy_stats(stats, result_pool));
+
+  return SVN_NO_ERROR;
+}
+
 #if APR_HAS_THREADS
 
 apr_thread_mutex_t *
@@ -31,6 +31,14 @@
 
 #include "svn_private_config.h"
 
+/* On x86-64, SSE2 is part of the base ISA.  So, no runtime CPU detection
+ * is needed to classify the encoded bytes 16 at a time.
+ */
+#if defined(__GNUC__) && defined(__SSE2__)
+#  define PACKED_DATA_SSE2 1
+#  include <emmintrin.h>
+#endif
+
 
 
 /* Private int stream data referenced by svn_packed__int_stream_t.
@@ -555,15 +563,31 @@ append_byte_stream(svn_packed__byte_stream_t *stream,
 /* Take the binary data in UNCOMPRESSED, zip it into COMPRESSED and write
  * it to STREAM.  COMPRESSED simply acts as a re-usable memory buffer.
  * Clear all buffers (COMPRESSED, UNCOMPRESSED) at the end of the function.
+ * COMPRESSION may be NULL and selects the compression method otherwise.
  */
 static svn_error_t *
 write_stream_data(svn_stream_t *stream,
                   svn_stringbuf_t *uncompressed,
-                  svn_stringbuf_t *compressed)
+                  svn_stringbuf_t *compressed,
+                  const svn_packed__compression_t *compression)
 {
-  SVN_ERR(svn__compress(uncompressed->data, uncompressed->len,
-                        compressed,
-                        SVN_DELTA_COMPRESSION_LEVEL_DEFAULT));
+  if (   compression && compression->samples && uncompressed->len
+      && *compression->samples_size < compression->max_samples_size)
+    {
+      apr_array_header_t *samples = compression->samples;
+      APR_ARRAY_PUSH(samples, svn_stringbuf_t *)
+        = svn_stringbuf_dup(uncompressed, samples->pool);
+      *compression->samples_size += uncompressed->len;
+    }
+
+  if (compression && compression->dict)
+    SVN_ERR(svn__compress_zstd(uncompressed->data, uncompressed->len,
+                               compressed, SVN__COMPRESSION_ZSTD_DEFAULT,
+                               compression->dict));
+  else
+    SVN_ERR(svn__compress(uncompressed->data, uncompressed->len,
+                          compressed,
+                          SVN_DELTA_COMPRESSION_LEVEL_DEFAULT));
 
   SVN_ERR(write_stream_uint(stream, compressed->len));
   SVN_ERR(svn_stream_write(stream, compressed->data, &compressed->len));
@@ -578,6 +602,16 @@ svn_error_t *
 svn_packed__data_write(svn_stream_t *stream,
                        svn_packed__data_root_t *root,
                        apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(svn_packed__data_write2(stream, root, NULL,
+                                                 scratch_pool));
+}
+
+svn_error_t *
+svn_packed__data_write2(svn_stream_t *stream,
+                        svn_packed__data_root_t *root,
+                        const svn_packed__compression_t *compression,
+                        apr_pool_t *scratch_pool)
 {
   svn_packed__int_stream_t *int_stream;
   svn_packed__byte_stream_t *byte_stream;
@@ -611,7 +645,8 @@ svn_packed__data_write(svn_stream_t *stream,
       svn_stringbuf_ensure(uncompressed, len);
 
       append_int_stream(int_stream, uncompressed);
-      SVN_ERR(write_stream_data(stream, uncompressed, compressed));
+      SVN_ERR(write_stream_data(stream, uncompressed, compressed,
+                                compression));
     }
 
   for (byte_stream = root->first_byte_stream;
@@ -622,7 +657,8 @@ svn_packed__data_write(svn_stream_t *stream,
       svn_stringbuf_ensure(uncompressed, len);
 
       append_byte_stream(byte_stream, uncompressed);
-      SVN_ERR(write_stream_data(stream, uncompressed, compressed));
+      SVN_ERR(write_stream_data(stream, uncompressed, compressed,
+                                compression));
     }
 
   return SVN_NO_ERROR;
@@ -721,6 +757,31 @@ read_packed_uint_body(unsigned char *p, apr_uint64_t *result)
   return ++p;
 }
 
+/* Return the number of leading bytes at P, up to 16, that have bit 7
+ * cleared, i.e. that are complete 7b/8b encoded numbers < 128 each.
+ * P must point to at least 16 readable bytes.
+ *
+ * Most numbers in packed streams are small, typically deltas, so this
+ * lets us expand whole runs of them without decoding them one-by-one.
+ */
+static APR_INLINE apr_size_t
+count_short_uints(const unsigned char *p)
+{
+#ifdef PACKED_DATA_SSE2
+  unsigned int mask
+    = (unsigned int)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)p));
+
+  /* The sentinel bit makes MASK non-zero. */
+  return __builtin_ctz(mask | 0x10000);
+#else
+  apr_size_t count = 0;
+  while (count < 16 && p[count] < 0x80)
+    ++count;
+
+  return count;
+#endif
+}
+
 /* Read one 7b/8b encoded value from STREAM and return it in *RESULT.
  *
  * Overflows will be detected in the sense that it will end parsing the
@@ -821,10 +882,30 @@ svn_packed__data_fill_buffer(svn_packed__int_stream_t *stream)
       else
         p = (unsigned char *)private_data->packed->data;
 
-      /* unpack numbers */
+      /* unpack numbers.  Note that each of the I numbers still to decode
+         occupies at least one byte in the (padded) input buffer, so we
+         may look 16 bytes ahead as long as I >= 16. */
       start = p;
       for (i = end; i > 0; --i)
-        p = read_packed_uint_body(p, &stream->buffer[i-1]);
+        {
+          if (i >= 16)
+            {
+              apr_size_t count = count_short_uints(p);
+              apr_size_t k;
+
+              /* Expand a run of single-byte numbers at once.  Then decode
+                 the one number that follows the run normally. */
+              for (k = 0; k < count; ++k)
+                stream->buffer[i-1-k] = p[k];
+
+              p += count;
+              i -= count;
+              if (i == 0)
+                break;
+            }
+
+          p = read_packed_uint_body(p, &stream->buffer[i-1]);
+        }
 
       /* adjust remaining packed data buffer */
       packed_read = p - start;
@@ -959,13 +1040,15 @@ read_byte_stream_structure(svn_stringbuf_t *tree_struct,
 
 /* Read a compressed block from STREAM and uncompress it into UNCOMPRESSED.
  * UNCOMPRESSED_LEN is the expected size of the stream.  COMPRESSED is a
- * re-used buffer for temporary data.
+ * re-used buffer for temporary data.  Use the dictionary in COMPRESSION,
+ * if any.
  */
 static svn_error_t *
 read_stream_data(svn_stream_t *stream,
                  apr_size_t uncompressed_len,
                  svn_stringbuf_t *uncompressed,
-                 svn_stringbuf_t *compressed)
+                 svn_stringbuf_t *compressed,
+                 const svn_packed__compression_t *compression)
 {
   apr_uint64_t len;
   apr_size_t compressed_len;
@@ -978,8 +1061,9 @@ read_stream_data(svn_stream_t *stream,
   SVN_ERR(svn_stream_read_full(stream, compressed->data, &compressed->len));
   compressed->data[compressed_len] = '\0';
 
-  SVN_ERR(svn__decompress(compressed->data, compressed->len,
-                          uncompressed, uncompressed_len));
+  SVN_ERR(svn__decompress2(compressed->data, compressed->len,
+                           uncompressed, uncompressed_len,
+                           compression ? compression->dict : NULL));
 
   return SVN_NO_ERROR;
 }
@@ -1037,6 +1121,17 @@ svn_packed__data_read(svn_packed__data_root_t **root_p,
                       svn_stream_t *stream,
                       apr_pool_t *result_pool,
                       apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(svn_packed__data_read2(root_p, stream, NULL,
+                                                result_pool, scratch_pool));
+}
+
+svn_error_t *
+svn_packed__data_read2(svn_packed__data_root_t **root_p,
+                       svn_stream_t *stream,
+                       const svn_packed__compression_t *compression,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool)
 {
   apr_uint64_t i;
   apr_uint64_t count;
@@ -1086,7 +1181,7 @@ svn_packed__data_read(svn_packed__data_root_t **root_p,
       apr_size_t offset = 0;
       SVN_ERR(read_stream_data(stream,
                                packed_int_stream_length(int_stream),
-                               uncompressed, compressed));
+                               uncompressed, compressed, compression));
       unflatten_int_stream(int_stream, uncompressed, &offset);
     }
 
@@ -1097,7 +1192,7 @@ svn_packed__data_read(svn_packed__data_root_t **root_p,
       apr_size_t offset = 0;
       SVN_ERR(read_stream_data(stream,
                                packed_byte_stream_length(byte_stream),
-                               uncompressed, compressed));
+                               uncompressed, compressed, compression));
       unflatten_byte_stream(byte_stream, uncompressed, &offset);
     }
 
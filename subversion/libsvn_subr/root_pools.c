@@ -21,11 +21,17 @@
  * ====================================================================
  */
 
+#include <apr_thread_proc.h>
+
 #include "svn_pools.h"
 
 #include "private/svn_subr_private.h"
 #include "private/svn_mutex.h"
 
+/* Key of the pool userdata that holds the acquisition time (apr_time_t)
+ * of a root pool while profiling is enabled. */
+#define ACQUIRED_KEY "svn-root-pool-acquired"
+
 struct svn_root_pools__t
 {
   /* unused pools.
@@ -33,11 +39,34 @@ struct svn_root_pools__t
    */
   apr_array_header_t *unused_pools;
 
-  /* Mutex to serialize access to UNUSED_POOLS */
+  /* Mutex to serialize access to UNUSED_POOLS and INFO */
   svn_mutex__t *mutex;
 
+#if APR_HAS_THREADS
+  /* Per-thread cache of at most one unused pool.  Threads that keep
+   * acquiring and releasing pools, like the svnserve workers, will get
+   * their previous pool back without touching MUTEX.  UNUSED_POOLS takes
+   * the overflow.  The cached pools get destroyed when their thread
+   * exits. */
+  apr_threadkey_t *thread_pool;
+#endif
+
+  /* If set, collect statistics in INFO. */
+  svn_boolean_t profiling;
+
+  /* Usage statistics, only maintained while PROFILING is set. */
+  svn_root_pools__info_t info;
 };
 
+#if APR_HAS_THREADS
+/* Destructor of svn_root_pools__t.THREAD_POOL. */
+static void
+destroy_thread_pool(void *data)
+{
+  svn_pool_destroy(data);
+}
+#endif
+
 svn_error_t *
 svn_root_pools__create(svn_root_pools__t **pools)
 {
@@ -51,23 +80,116 @@ svn_root_pools__create(svn_root_pools__t **pools)
   SVN_ERR(svn_mutex__init(&result->mutex, TRUE, pool));
   result->unused_pools = apr_array_make(pool, 16, sizeof(apr_pool_t *));
 
+#if APR_HAS_THREADS
+  {
+    apr_status_t status = apr_threadkey_private_create(&result->thread_pool,
+                                                       destroy_thread_pool,
+                                                       pool);
+    if (status)
+      return svn_error_wrap_apr(status,
+                                "Can't allocate thread-specific storage"
+                                " for root pools");
+  }
+#endif
+
   /* done */
   *pools = result;
 
   return SVN_NO_ERROR;
 }
 
+void
+svn_root_pools__enable_profiling(svn_root_pools__t *pools)
+{
+  pools->profiling = TRUE;
+}
+
+svn_error_t *
+svn_root_pools__get_info(svn_root_pools__info_t *info,
+                         svn_root_pools__t *pools)
+{
+  SVN_ERR(svn_mutex__lock(pools->mutex));
+  *info = pools->info;
+
+  return svn_error_trace(svn_mutex__unlock(pools->mutex, SVN_NO_ERROR));
+}
+
+/* Update the statistics in POOLS for the acquisition of POOL.  CREATED
+ * and THREAD_HIT tell where the pool came from.
+ */
+static svn_error_t *
+record_acquisition(svn_root_pools__t *pools,
+                   apr_pool_t *pool,
+                   svn_boolean_t created,
+                   svn_boolean_t thread_hit)
+{
+  svn_root_pools__info_t *info = &pools->info;
+  apr_time_t *acquired = apr_palloc(pool, sizeof(*acquired));
+
+  *acquired = apr_time_now();
+  apr_pool_userdata_setn(acquired, ACQUIRED_KEY, NULL, pool);
+
+  SVN_ERR(svn_mutex__lock(pools->mutex));
+
+  ++info->acquired;
+  if (created)
+    ++info->created;
+  if (thread_hit)
+    ++info->thread_hits;
+  if (++info->in_use > info->max_in_use)
+    info->max_in_use = info->in_use;
+
+  return svn_error_trace(svn_mutex__unlock(pools->mutex, SVN_NO_ERROR));
+}
+
+/* Update the statistics in POOLS for the release of POOL, before it gets
+ * cleared.
+ */
+static svn_error_t *
+record_release(svn_root_pools__t *pools,
+               apr_pool_t *pool)
+{
+  svn_root_pools__info_t *info = &pools->info;
+  apr_interval_time_t lifetime = 0;
+  apr_size_t size = 0;
+  void *acquired;
+
+  /* Pools acquired before profiling got enabled have no timestamp. */
+  apr_pool_userdata_get(&acquired, ACQUIRED_KEY, pool);
+  if (acquired)
+    lifetime = apr_time_now() - *(apr_time_t *)acquired;
+
+#if APR_POOL_DEBUG
+  size = apr_pool_num_bytes(pool, TRUE);
+#endif
+
+  SVN_ERR(svn_mutex__lock(pools->mutex));
+
+  if (info->in_use)
+    --info->in_use;
+  info->total_lifetime += lifetime;
+  if (lifetime > info->max_lifetime)
+    info->max_lifetime = lifetime;
+  if (size > info->max_size)
+    info->max_size = size;
+
+  return svn_error_trace(svn_mutex__unlock(pools->mutex, SVN_NO_ERROR));
+}
+
 /* Return a currently unused connection pool in *POOL. If no such pool
- * exists, create a new root pool and return that in *POOL.
+ * exists, create a new root pool and return that in *POOL and set
+ * *CREATED.
  */
 static svn_error_t *
 acquire_pool_internal(apr_pool_t **pool,
+                      svn_boolean_t *created,
                       svn_root_pools__t *pools)
 {
   SVN_ERR(svn_mutex__lock(pools->mutex));
-  *pool = pools->unused_pools->nelts
-        ? *(apr_pool_t **)apr_array_pop(pools->unused_pools)
-        : apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  *created = pools->unused_pools->nelts == 0;
+  *pool = *created
+        ? apr_allocator_owner_get(svn_pool_create_allocator(FALSE))
+        : *(apr_pool_t **)apr_array_pop(pools->unused_pools);
   SVN_ERR(svn_mutex__unlock(pools->mutex, SVN_NO_ERROR));
 
   return SVN_NO_ERROR;
@@ -76,14 +198,36 @@ acquire_pool_internal(apr_pool_t **pool,
 apr_pool_t *
 svn_root_pools__acquire_pool(svn_root_pools__t *pools)
 {
-  apr_pool_t *pool;
-  svn_error_t *err = acquire_pool_internal(&pool, pools);
-  if (err)
+  apr_pool_t *pool = NULL;
+  svn_boolean_t created = FALSE;
+  svn_boolean_t thread_hit = FALSE;
+
+#if APR_HAS_THREADS
+  /* Try this thread's cached pool first. */
+  void *cached;
+  if (   !apr_threadkey_private_get(&cached, pools->thread_pool)
+      && cached
+      && !apr_threadkey_private_set(NULL, pools->thread_pool))
     {
-      /* Mutex failure?!  Well, try to continue with unrecycled data. */
-      svn_error_clear(err);
-      pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+      pool = cached;
+      thread_hit = TRUE;
     }
+#endif
+
+  if (pool == NULL)
+    {
+      svn_error_t *err = acquire_pool_internal(&pool, &created, pools);
+      if (err)
+        {
+          /* Mutex failure?!  Well, try to continue with unrecycled data. */
+          svn_error_clear(err);
+          pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+          created = TRUE;
+        }
+    }
+
+  if (pools->profiling)
+    svn_error_clear(record_acquisition(pools, pool, created, thread_hit));
 
   return pool;
 }
@@ -94,8 +238,22 @@ svn_root_pools__release_pool(apr_pool_t *pool,
 {
   svn_error_t *err;
 
+  if (pools->profiling)
+    svn_error_clear(record_release(pools, pool));
+
   svn_pool_clear(pool);
 
+#if APR_HAS_THREADS
+  /* Keep the pool for this thread, if it has none cached, yet. */
+  {
+    void *cached;
+    if (   !apr_threadkey_private_get(&cached, pools->thread_pool)
+        && !cached
+        && !apr_threadkey_private_set(pool, pools->thread_pool))
+      return;
+  }
+#endif
+
   err = svn_mutex__lock(pools->mutex);
   if (err)
     {
@@ -0,0 +1,499 @@
+/*
+ * sha1.c :  SHA-1 implementation with hardware acceleration
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+#include <apr.h>
+
+#include "private/svn_atomic.h"
+#include "sha1.h"
+
+/* Compile-time selection of the hardware-accelerated block functions.
+ * For x86, we use function-specific target attributes such that the
+ * code can be built with default compiler flags and the SHA extensions
+ * are only used if the CPU supports them at runtime.  For ARM, we rely
+ * on the compiler targeting the crypto extensions, as e.g. all 64 bit
+ * Apple CPUs do.
+ */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) \
+    && (__GNUC__ >= 5 || defined(__clang__))
+#  define SHA1_X86_SHA_NI 1
+#  include <cpuid.h>
+#  include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) \
+    && (defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_SHA2))
+#  define SHA1_ARM_CRYPTO 1
+#  include <arm_neon.h>
+#endif
+
+/* SHA-1 processes data in blocks of this many bytes.
+ */
+#define SHA1_BLOCK_SIZE 64
+
+/* Round constants, one for each group of 20 rounds.
+ */
+#define SHA1_K0 0x5a827999
+#define SHA1_K1 0x6ed9eba1
+#define SHA1_K2 0x8f1bbcdc
+#define SHA1_K3 0xca62c1d6
+
+struct svn_sha1__context_t
+{
+  /* Intermediate hash value H0 .. H4. */
+  apr_uint32_t state[5];
+
+  /* Total number of bytes fed into the context so far. */
+  apr_uint64_t length;
+
+  /* Data of the current, incomplete block.  Only the first
+   * LENGTH % SHA1_BLOCK_SIZE bytes are valid. */
+  unsigned char buffer[SHA1_BLOCK_SIZE];
+};
+
+/* Signature of the functions that update STATE with COUNT consecutive
+ * SHA1_BLOCK_SIZE blocks read from DATA.
+ */
+typedef void (*sha1_blocks_func_t)(apr_uint32_t state[5],
+                                   const unsigned char *data,
+                                   apr_size_t count);
+
+/* Return the big-endian 32 bit word at P.
+ */
+static APR_INLINE apr_uint32_t
+load_be32(const unsigned char *p)
+{
+  return ((apr_uint32_t)p[0] << 24) | ((apr_uint32_t)p[1] << 16)
+       | ((apr_uint32_t)p[2] << 8) | (apr_uint32_t)p[3];
+}
+
+/* Store VALUE as big-endian 32 bit word at P.
+ */
+static APR_INLINE void
+store_be32(unsigned char *p, apr_uint32_t value)
+{
+  p[0] = (unsigned char)(value >> 24);
+  p[1] = (unsigned char)(value >> 16);
+  p[2] = (unsigned char)(value >> 8);
+  p[3] = (unsigned char)value;
+}
+
+#define ROTL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+/* Message schedule: expand W[I % 16] in place for round I >= 16. */
+#define SHA1_EXPAND(W, i) \
+  (W[(i) & 15] = ROTL32(W[((i) + 13) & 15] ^ W[((i) + 8) & 15] \
+                        ^ W[((i) + 2) & 15] ^ W[(i) & 15], 1))
+
+/* The round functions with the fewest operations possible. */
+#define SHA1_F0(b, c, d) ((d) ^ ((b) & ((c) ^ (d))))
+#define SHA1_F1(b, c, d) ((b) ^ (c) ^ (d))
+#define SHA1_F2(b, c, d) (((b) & (c)) | ((d) & ((b) | (c))))
+#define SHA1_F3(b, c, d) SHA1_F1(b, c, d)
+
+/* One round with function F and constant K, using message word WI. */
+#define SHA1_ROUND(a, b, c, d, e, F, K, WI)                   \
+  do {                                                        \
+    e += ROTL32(a, 5) + F(b, c, d) + (K) + (WI);              \
+    b = ROTL32(b, 30);                                        \
+  } while (0)
+
+/* Five rounds starting at round I, rotating the roles of the variables
+ * instead of moving the values around. */
+#define SHA1_ROUNDS5(F, K, W, i, EXP)                              \
+  do {                                                             \
+    SHA1_ROUND(a, b, c, d, e, F, K, EXP(W, (i) + 0));              \
+    SHA1_ROUND(e, a, b, c, d, F, K, EXP(W, (i) + 1));              \
+    SHA1_ROUND(d, e, a, b, c, F, K, EXP(W, (i) + 2));              \
+    SHA1_ROUND(c, d, e, a, b, F, K, EXP(W, (i) + 3));              \
+    SHA1_ROUND(b, c, d, e, a, F, K, EXP(W, (i) + 4));              \
+  } while (0)
+
+/* Message word access for the first 16 rounds. */
+#define SHA1_PLAIN(W, i) (W[(i)])
+
+/* Portable implementation of sha1_blocks_func_t.
+ */
+static void
+sha1_blocks_portable(apr_uint32_t state[5],
+                     const unsigned char *data,
+                     apr_size_t count)
+{
+  apr_uint32_t W[16];
+  apr_uint32_t a, b, c, d, e;
+  int i;
+
+  for (; count > 0; --count, data += SHA1_BLOCK_SIZE)
+    {
+      for (i = 0; i < 16; ++i)
+        W[i] = load_be32(data + 4 * i);
+
+      a = state[0];
+      b = state[1];
+      c = state[2];
+      d = state[3];
+      e = state[4];
+
+      SHA1_ROUNDS5(SHA1_F0, SHA1_K0, W, 0, SHA1_PLAIN);
+      SHA1_ROUNDS5(SHA1_F0, SHA1_K0, W, 5, SHA1_PLAIN);
+      SHA1_ROUNDS5(SHA1_F0, SHA1_K0, W, 10, SHA1_PLAIN);
+      SHA1_ROUND(a, b, c, d, e, SHA1_F0, SHA1_K0, W[15]);
+      SHA1_ROUND(e, a, b, c, d, SHA1_F0, SHA1_K0, SHA1_EXPAND(W, 16));
+      SHA1_ROUND(d, e, a, b, c, SHA1_F0, SHA1_K0, SHA1_EXPAND(W, 17));
+      SHA1_ROUND(c, d, e, a, b, SHA1_F0, SHA1_K0, SHA1_EXPAND(W, 18));
+      SHA1_ROUND(b, c, d, e, a, SHA1_F0, SHA1_K0, SHA1_EXPAND(W, 19));
+
+      SHA1_ROUNDS5(SHA1_F1, SHA1_K1, W, 20, SHA1_EXPAND);
+      SHA1_ROUNDS5(SHA1_F1, SHA1_K1, W, 25, SHA1_EXPAND);
+      SHA1_ROUNDS5(SHA1_F1, SHA1_K1, W, 30, SHA1_EXPAND);
+      SHA1_ROUNDS5(SHA1_F1, SHA1_K1, W, 35, SHA1_EXPAND);
+
+      SHA1_ROUNDS5(SHA1_F2, SHA1_K2, W, 40, SHA1_EXPAND);
+      SHA1_ROUNDS5(SHA1_F2, SHA1_K2, W, 45, SHA1_EXPAND);
+      SHA1_ROUNDS5(SHA1_F2, SHA1_K2, W, 50, SHA1_EXPAND);
+      SHA1_ROUNDS5(SHA1_F2, SHA1_K2, W, 55, SHA1_EXPAND);
+
+      SHA1_ROUNDS5(SHA1_F3, SHA1_K3, W, 60, SHA1_EXPAND);
+      SHA1_ROUNDS5(SHA1_F3, SHA1_K3, W, 65, SHA1_EXPAND);
+      SHA1_ROUNDS5(SHA1_F3, SHA1_K3, W, 70, SHA1_EXPAND);
+      SHA1_ROUNDS5(SHA1_F3, SHA1_K3, W, 75, SHA1_EXPAND);
+
+      state[0] += a;
+      state[1] += b;
+      state[2] += c;
+      state[3] += d;
+      state[4] += e;
+    }
+}
+
+#ifdef SHA1_X86_SHA_NI
+
+#define SHA1_X86_TARGET __attribute__((target("sha,sse4.1,ssse3")))
+
+/* Process one group of 4 rounds with function number F in the SHA-NI
+ * implementation.  MSG[G % 4] will contain the message words for
+ * group G (0 .. 19) upon return; E contains the value to add to the
+ * next group's message words. */
+#define SHA1_X86_GROUP(G, F)                                                \
+  do {                                                                      \
+    if ((G) >= 4)                                                           \
+      msg[(G) % 4] = _mm_sha1msg2_epu32(                                    \
+                       _mm_xor_si128(_mm_sha1msg1_epu32(msg[(G) % 4],       \
+                                                        msg[((G) + 1) % 4]),\
+                                     msg[((G) + 2) % 4]),                   \
+                       msg[((G) + 3) % 4]);                                 \
+    e = (G) == 0 ? _mm_add_epi32(e, msg[0])                                 \
+                 : _mm_sha1nexte_epu32(e, msg[(G) % 4]);                    \
+    next_e = abcd;                                                          \
+    abcd = _mm_sha1rnds4_epu32(abcd, e, F);                                 \
+    e = next_e;                                                             \
+  } while (0)
+
+/* Implementation of sha1_blocks_func_t using the x86 SHA extensions.
+ */
+static SHA1_X86_TARGET void
+sha1_blocks_x86(apr_uint32_t state[5],
+                const unsigned char *data,
+                apr_size_t count)
+{
+  const __m128i byte_swap = _mm_set_epi64x(0x0001020304050607LL,
+                                           0x08090a0b0c0d0e0fLL);
+  __m128i abcd, e, next_e, abcd_saved, e_saved;
+  __m128i msg[4];
+  int i;
+
+  /* The SHA-NI instructions expect A in the most significant lane. */
+  abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)state), 0x1b);
+  e = _mm_set_epi32((int)state[4], 0, 0, 0);
+
+  for (; count > 0; --count, data += SHA1_BLOCK_SIZE)
+    {
+      abcd_saved = abcd;
+      e_saved = e;
+
+      for (i = 0; i < 4; ++i)
+        msg[i] = _mm_shuffle_epi8(
+                   _mm_loadu_si128((const __m128i *)(data + 16 * i)),
+                   byte_swap);
+
+      SHA1_X86_GROUP(0, 0);
+      SHA1_X86_GROUP(1, 0);
+      SHA1_X86_GROUP(2, 0);
+      SHA1_X86_GROUP(3, 0);
+      SHA1_X86_GROUP(4, 0);
+      SHA1_X86_GROUP(5, 1);
+      SHA1_X86_GROUP(6, 1);
+      SHA1_X86_GROUP(7, 1);
+      SHA1_X86_GROUP(8, 1);
+      SHA1_X86_GROUP(9, 1);
+      SHA1_X86_GROUP(10, 2);
+      SHA1_X86_GROUP(11, 2);
+      SHA1_X86_GROUP(12, 2);
+      SHA1_X86_GROUP(13, 2);
+      SHA1_X86_GROUP(14, 2);
+      SHA1_X86_GROUP(15, 3);
+      SHA1_X86_GROUP(16, 3);
+      SHA1_X86_GROUP(17, 3);
+      SHA1_X86_GROUP(18, 3);
+      SHA1_X86_GROUP(19, 3);
+
+      /* E has been derived from the A before the last group. */
+      e = _mm_sha1nexte_epu32(e, e_saved);
+      abcd = _mm_add_epi32(abcd, abcd_saved);
+    }
+
+  _mm_storeu_si128((__m128i *)state, _mm_shuffle_epi32(abcd, 0x1b));
+  state[4] = (apr_uint32_t)_mm_extract_epi32(e, 3);
+}
+
+/* Return TRUE if the CPU supports all instructions used by
+ * sha1_blocks_x86.
+ */
+static svn_boolean_t
+have_x86_sha_ni(void)
+{
+  unsigned int eax, ebx, ecx, edx;
+
+  if (__get_cpuid_max(0, NULL) < 7)
+    return FALSE;
+
+  __cpuid(1, eax, ebx, ecx, edx);
+  if (!(ecx & bit_SSSE3) || !(ecx & bit_SSE4_1))
+    return FALSE;
+
+  __cpuid_count(7, 0, eax, ebx, ecx, edx);
+  return (ebx & (1u << 29)) != 0;  /* SHA extensions */
+}
+
+#endif /* SHA1_X86_SHA_NI */
+
+#ifdef SHA1_ARM_CRYPTO
+
+/* Process one group of 4 rounds with the intrinsic FUNC in the ARMv8
+ * implementation.  See SHA1_X86_GROUP for the message schedule. */
+#define SHA1_ARM_GROUP(G, FUNC, K)                                          \
+  do {                                                                      \
+    if ((G) >= 4)                                                           \
+      msg[(G) % 4] = vsha1su1q_u32(vsha1su0q_u32(msg[(G) % 4],              \
+                                                 msg[((G) + 1) % 4],        \
+                                                 msg[((G) + 2) % 4]),       \
+                                   msg[((G) + 3) % 4]);                     \
+    next_e = vsha1h_u32(vgetq_lane_u32(abcd, 0));                           \
+    abcd = FUNC(abcd, e, vaddq_u32(msg[(G) % 4], vdupq_n_u32(K)));          \
+    e = next_e;                                                             \
+  } while (0)
+
+/* Implementation of sha1_blocks_func_t using the ARMv8 crypto extensions.
+ */
+static void
+sha1_blocks_arm(apr_uint32_t state[5],
+                const unsigned char *data,
+                apr_size_t count)
+{
+  uint32x4_t abcd, abcd_saved;
+  uint32x4_t msg[4];
+  uint32_t e, next_e, e_saved;
+  int i;
+
+  abcd = vld1q_u32(state);
+  e = state[4];
+
+  for (; count > 0; --count, data += SHA1_BLOCK_SIZE)
+    {
+      abcd_saved = abcd;
+      e_saved = e;
+
+      for (i = 0; i < 4; ++i)
+        msg[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 16 * i)));
+
+      SHA1_ARM_GROUP(0, vsha1cq_u32, SHA1_K0);
+      SHA1_ARM_GROUP(1, vsha1cq_u32, SHA1_K0);
+      SHA1_ARM_GROUP(2, vsha1cq_u32, SHA1_K0);
+      SHA1_ARM_GROUP(3, vsha1cq_u32, SHA1_K0);
+      SHA1_ARM_GROUP(4, vsha1cq_u32, SHA1_K0);
+      SHA1_ARM_GROUP(5, vsha1pq_u32, SHA1_K1);
+      SHA1_ARM_GROUP(6, vsha1pq_u32, SHA1_K1);
+      SHA1_ARM_GROUP(7, vsha1pq_u32, SHA1_K1);
+      SHA1_ARM_GROUP(8, vsha1pq_u32, SHA1_K1);
+      SHA1_ARM_GROUP(9, vsha1pq_u32, SHA1_K1);
+      SHA1_ARM_GROUP(10, vsha1mq_u32, SHA1_K2);
+      SHA1_ARM_GROUP(11, vsha1mq_u32, SHA1_K2);
+      SHA1_ARM_GROUP(12, vsha1mq_u32, SHA1_K2);
+      SHA1_ARM_GROUP(13, vsha1mq_u32, SHA1_K2);
+      SHA1_ARM_GROUP(14, vsha1mq_u32, SHA1_K2);
+      SHA1_ARM_GROUP(15, vsha1pq_u32, SHA1_K3);
+      SHA1_ARM_GROUP(16, vsha1pq_u32, SHA1_K3);
+      SHA1_ARM_GROUP(17, vsha1pq_u32, SHA1_K3);
+      SHA1_ARM_GROUP(18, vsha1pq_u32, SHA1_K3);
+      SHA1_ARM_GROUP(19, vsha1pq_u32, SHA1_K3);
+
+      abcd = vaddq_u32(abcd, abcd_saved);
+      e += e_saved;
+    }
+
+  vst1q_u32(state, abcd);
+  state[4] = e;
+}
+
+#endif /* SHA1_ARM_CRYPTO */
+
+/* The block function selected for the current CPU and its name.
+ * Set by select_implementation. */
+static sha1_blocks_func_t sha1_blocks = sha1_blocks_portable;
+static const char *sha1_blocks_name = "portable";
+
+/* Implements svn_atomic__str_init_func_t.
+ * Pick the fastest block function supported by the current CPU.
+ */
+static const char *
+select_implementation(void *baton)
+{
+#ifdef SHA1_X86_SHA_NI
+  if (have_x86_sha_ni())
+    {
+      sha1_blocks = sha1_blocks_x86;
+      sha1_blocks_name = "x86 SHA-NI";
+    }
+#endif
+#ifdef SHA1_ARM_CRYPTO
+  sha1_blocks = sha1_blocks_arm;
+  sha1_blocks_name = "ARMv8 crypto";
+#endif
+
+  return NULL;
+}
+
+/* Make sure the block function has been selected.
+ */
+static void
+init_implementation(void)
+{
+  static volatile svn_atomic_t init_state = 0;
+  (void)svn_atomic__init_once_no_error(&init_state, select_implementation,
+                                       NULL);
+}
+
+const char *
+svn_sha1__implementation(void)
+{
+  init_implementation();
+  return sha1_blocks_name;
+}
+
+/* Initialize CONTEXT for a new checksum.
+ */
+static void
+sha1_init(svn_sha1__context_t *context)
+{
+  init_implementation();
+
+  context->state[0] = 0x67452301;
+  context->state[1] = 0xefcdab89;
+  context->state[2] = 0x98badcfe;
+  context->state[3] = 0x10325476;
+  context->state[4] = 0xc3d2e1f0;
+  context->length = 0;
+}
+
+svn_sha1__context_t *
+svn_sha1__context_create(apr_pool_t *pool)
+{
+  svn_sha1__context_t *context = apr_palloc(pool, sizeof(*context));
+  sha1_init(context);
+
+  return context;
+}
+
+void
+svn_sha1__update(svn_sha1__context_t *context,
+                 const void *data,
+                 apr_size_t len)
+{
+  const unsigned char *input = data;
+  apr_size_t used = (apr_size_t)(context->length % SHA1_BLOCK_SIZE);
+
+  context->length += len;
+
+  /* Complete a partial block from previous calls first. */
+  if (used)
+    {
+      apr_size_t to_copy = SHA1_BLOCK_SIZE - used;
+      if (to_copy > len)
+        to_copy = len;
+
+      memcpy(context->buffer + used, input, to_copy);
+      input += to_copy;
+      len -= to_copy;
+
+      if (used + to_copy < SHA1_BLOCK_SIZE)
+        return;
+
+      sha1_blocks(context->state, context->buffer, 1);
+    }
+
+  /* Process all complete blocks directly from the input. */
+  if (len >= SHA1_BLOCK_SIZE)
+    {
+      apr_size_t count = len / SHA1_BLOCK_SIZE;
+      sha1_blocks(context->state, input, count);
+      input += count * SHA1_BLOCK_SIZE;
+      len -= count * SHA1_BLOCK_SIZE;
+    }
+
+  /* Keep the remainder for later. */
+  if (len)
+    memcpy(context->buffer, input, len);
+}
+
+void
+svn_sha1__finalize(unsigned char digest[APR_SHA1_DIGESTSIZE],
+                   const svn_sha1__context_t *context)
+{
+  svn_sha1__context_t tail = *context;
+  unsigned char padding[2 * SHA1_BLOCK_SIZE] = { 0x80 };
+  apr_size_t used = (apr_size_t)(context->length % SHA1_BLOCK_SIZE);
+  apr_size_t padding_len = (used < SHA1_BLOCK_SIZE - 8 ? 1 : 2)
+                         * SHA1_BLOCK_SIZE - used;
+  apr_uint64_t bits = context->length * 8;
+  int i;
+
+  /* Append the 1 bit, zeros and the message length in bits. */
+  store_be32(padding + padding_len - 8, (apr_uint32_t)(bits >> 32));
+  store_be32(padding + padding_len - 4, (apr_uint32_t)bits);
+  svn_sha1__update(&tail, padding, padding_len);
+
+  for (i = 0; i < 5; ++i)
+    store_be32(digest + 4 * i, tail.state[i]);
+}
+
+void
+svn__sha1(unsigned char digest[APR_SHA1_DIGESTSIZE],
+          const void *input,
+          apr_size_t len)
+{
+  svn_sha1__context_t context;
+
+  sha1_init(&context);
+  svn_sha1__update(&context, input, len);
+  svn_sha1__finalize(digest, &context);
+}
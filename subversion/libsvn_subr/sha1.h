@@ -0,0 +1,76 @@
+/*
+ * sha1.h :  SHA-1 implementation with hardware acceleration
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_SUBR_SHA1_H
+#define SVN_LIBSVN_SUBR_SHA1_H
+
+#include <apr_pools.h>
+#include <apr_sha1.h>
+
+#include "svn_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Opaque SHA-1 checksum creation context type.
+ */
+typedef struct svn_sha1__context_t svn_sha1__context_t;
+
+/* Return a new SHA-1 checksum creation context allocated in POOL.
+ */
+svn_sha1__context_t *
+svn_sha1__context_create(apr_pool_t *pool);
+
+/* Feed LEN bytes from DATA into the SHA-1 checksum creation CONTEXT.
+ */
+void
+svn_sha1__update(svn_sha1__context_t *context,
+                 const void *data,
+                 apr_size_t len);
+
+/* Write the SHA-1 checksum over all data fed into CONTEXT to DIGEST.
+ * CONTEXT itself remains unchanged.
+ */
+void
+svn_sha1__finalize(unsigned char digest[APR_SHA1_DIGESTSIZE],
+                   const svn_sha1__context_t *context);
+
+/* Write the SHA-1 checksum over the first LEN bytes in INPUT to DIGEST.
+ */
+void
+svn__sha1(unsigned char digest[APR_SHA1_DIGESTSIZE],
+          const void *input,
+          apr_size_t len);
+
+/* Return a short name of the SHA-1 block function that has been selected
+ * for the current CPU, e.g. for diagnostic output.
+ */
+const char *
+svn_sha1__implementation(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_SUBR_SHA1_H */
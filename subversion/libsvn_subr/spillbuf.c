@@ -22,6 +22,7 @@
  */
 
 #include <apr_file_io.h>
+#include <apr_mmap.h>
 
 #include "svn_io.h"
 #include "svn_pools.h"
@@ -87,6 +88,20 @@ struct svn_spillbuf_t {
 
   /* The name of the temporary spill file. */
   const char *filename;
+
+#if APR_HAS_MMAP
+  /* Read-only mapping of the spill file window starting at file offset
+     MAP_START, or NULL.  svn_spillbuf__read() hands out slices of it
+     instead of copying the data into a memblock.  The mapping lives in
+     MAP_POOL and stays valid until the next read or write call, even
+     after the spill file itself has been closed.  */
+  apr_mmap_t *map;
+  apr_off_t map_start;
+  apr_pool_t *map_pool;
+
+  /* Set once mapping the spill file failed; we use plain reads then.  */
+  svn_boolean_t map_failed;
+#endif
 };
 
 
@@ -230,6 +245,100 @@ return_buffer(svn_spillbuf_t *buf,
 }
 
 
+#if APR_HAS_MMAP
+/* Mappings of the spill file begin at multiples of this.  Use 64k, which
+   satisfies the allocation granularity on all relevant platforms.  */
+#define MAP_ALIGNMENT 0x10000
+
+/* Maximum size of a single spill file mapping.  */
+#define MAP_WINDOW_SIZE 0x400000
+
+/* Release the spill file mapping of BUF, if any.  */
+static void
+drop_mapping(svn_spillbuf_t *buf)
+{
+  if (buf->map != NULL)
+    {
+      svn_pool_clear(buf->map_pool);
+      buf->map = NULL;
+    }
+}
+
+/* Try to return the next block of spilled content of BUF in *DATA and
+   *LEN without copying it, by pointing into a mapping of the spill file.
+   Set *DATA to NULL if the content has to be read conventionally.
+
+   The caller must have made sure that BUF->SPILL contains the data, i.e.
+   that no content remains in memory and APR's write buffer is flushed. */
+static svn_error_t *
+read_mapped(const char **data,
+            apr_size_t *len,
+            svn_spillbuf_t *buf,
+            apr_pool_t *scratch_pool)
+{
+  apr_off_t offset;
+
+  *data = NULL;
+  if (buf->map_failed)
+    return SVN_NO_ERROR;
+
+  /* Does the current window cover the next byte to read? */
+  if (buf->map == NULL
+      || buf->spill_start < buf->map_start
+      || buf->spill_start >= buf->map_start + (apr_off_t)buf->map->size)
+    {
+      apr_off_t map_start = buf->spill_start
+                          - buf->spill_start % MAP_ALIGNMENT;
+      apr_off_t map_end = buf->spill_start + buf->spill_size;
+      apr_status_t status;
+
+      if (map_end - map_start > MAP_WINDOW_SIZE)
+        map_end = map_start + MAP_WINDOW_SIZE;
+
+      drop_mapping(buf);
+      if (buf->map_pool == NULL)
+        buf->map_pool = svn_pool_create(buf->pool);
+
+      status = apr_mmap_create(&buf->map, buf->spill, map_start,
+                               (apr_size_t)(map_end - map_start),
+                               APR_MMAP_READ, buf->map_pool);
+      if (status)
+        {
+          /* Not fatal.  We simply keep reading through the file.  */
+          buf->map = NULL;
+          buf->map_failed = TRUE;
+          svn_pool_clear(buf->map_pool);
+          return SVN_NO_ERROR;
+        }
+
+      buf->map_start = map_start;
+    }
+
+  /* Hand out at most one block worth of data, as a read would.  */
+  offset = buf->spill_start - buf->map_start;
+  *data = (const char *)buf->map->mm + offset;
+  *len = buf->map->size - (apr_size_t)offset;
+  if (*len > buf->blocksize)
+    *len = buf->blocksize;
+  if ((apr_uint64_t)*len > (apr_uint64_t)buf->spill_size)
+    *len = (apr_size_t)buf->spill_size;
+
+  buf->spill_start += *len;
+
+  /* Did we consume all the data from the spill file?  The mapping
+     remains valid after closing the file.  */
+  if ((buf->spill_size -= *len) == 0)
+    {
+      SVN_ERR(svn_io_file_close(buf->spill, scratch_pool));
+      buf->spill = NULL;
+      buf->spill_start = 0;
+    }
+
+  return SVN_NO_ERROR;
+}
+#endif
+
+
 svn_error_t *
 svn_spillbuf__write(svn_spillbuf_t *buf,
                     const char *data,
@@ -244,6 +353,12 @@ svn_spillbuf__write(svn_spillbuf_t *buf,
   if (buf->spill == NULL
       && ((buf->maxsize - buf->memory_size) < len))
     {
+#if APR_HAS_MMAP
+      /* A mapping of a previous spill file must not be mistaken for
+         one of the new file.  */
+      drop_mapping(buf);
+#endif
+
       SVN_ERR(svn_io_open_unique_file3(&buf->spill,
                                        &buf->filename,
                                        buf->dirpath,
@@ -451,9 +566,35 @@ svn_spillbuf__read(const char **data,
                    apr_pool_t *scratch_pool)
 {
   struct memblock_t *mem;
+#if APR_HAS_MMAP
+  svn_boolean_t seeked;
 
+  /* The data handed out by the previous call is no longer needed.  */
+  if (buf->spill == NULL)
+    drop_mapping(buf);
+
+  /* Possibly seek.  That also flushes pending writes to the file.  */
+  SVN_ERR(maybe_seek(&seeked, buf, scratch_pool));
+
+  /* Serve spilled content straight from a mapping of the file.  */
+  if (seeked)
+    {
+      SVN_ERR(read_mapped(data, len, buf, scratch_pool));
+      if (*data != NULL)
+        {
+          if (buf->out_for_reading != NULL)
+            {
+              return_buffer(buf, buf->out_for_reading);
+              buf->out_for_reading = NULL;
+            }
+
+          return SVN_NO_ERROR;
+        }
+    }
+#else
   /* Possibly seek... */
   SVN_ERR(maybe_seek(NULL, buf, scratch_pool));
+#endif
 
   SVN_ERR(read_data(&mem, buf, scratch_pool));
   if (mem == NULL)
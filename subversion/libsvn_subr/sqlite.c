@@ -28,6 +28,7 @@
 #include "svn_io.h"
 #include "svn_dirent_uri.h"
 #include "svn_checksum.h"
+#include "svn_string.h"
 
 #include "internal_statements.h"
 
@@ -243,15 +244,25 @@ exec_sql2(svn_sqlite__db_t *db, const char *sql, int ignored_err)
 }
 
 
+/* Prepare the statement TEXT for DB in *STMT, allocated in RESULT_POOL.
+   Set PERSISTENT if the statement will be kept around for the lifetime
+   of DB, which lets SQLite allocate it accordingly. */
 static svn_error_t *
 prepare_statement(svn_sqlite__stmt_t **stmt, svn_sqlite__db_t *db,
-                  const char *text, apr_pool_t *result_pool)
+                  const char *text, svn_boolean_t persistent,
+                  apr_pool_t *result_pool)
 {
   *stmt = apr_palloc(result_pool, sizeof(**stmt));
   (*stmt)->db = db;
   (*stmt)->needs_reset = FALSE;
 
+#if SQLITE_VERSION_NUMBER >= 3020000
+  SQLITE_ERR(sqlite3_prepare_v3(db->db3, text, -1,
+                                persistent ? SQLITE_PREPARE_PERSISTENT : 0,
+                                &(*stmt)->s3stmt, NULL), db);
+#else
   SQLITE_ERR(sqlite3_prepare_v2(db->db3, text, -1, &(*stmt)->s3stmt, NULL), db);
+#endif
 
   return SVN_NO_ERROR;
 }
@@ -274,7 +285,7 @@ svn_sqlite__get_statement(svn_sqlite__stmt_t **stmt, svn_sqlite__db_t *db,
 
   if (db->prepared_stmts[stmt_idx] == NULL)
     SVN_ERR(prepare_statement(&db->prepared_stmts[stmt_idx], db,
-                              db->statement_strings[stmt_idx],
+                              db->statement_strings[stmt_idx], TRUE,
                               db->state_pool));
 
   *stmt = db->prepared_stmts[stmt_idx];
@@ -299,7 +310,7 @@ get_internal_statement(svn_sqlite__stmt_t **stmt, svn_sqlite__db_t *db,
 
   if (db->prepared_stmts[prep_idx] == NULL)
     SVN_ERR(prepare_statement(&db->prepared_stmts[prep_idx], db,
-                              internal_statements[stmt_idx],
+                              internal_statements[stmt_idx], TRUE,
                               db->state_pool));
 
   *stmt = db->prepared_stmts[prep_idx];
@@ -386,6 +397,18 @@ svn_sqlite__update(int *affected_rows, svn_sqlite__stmt_t *stmt)
   return svn_error_trace(svn_sqlite__reset(stmt));
 }
 
+int
+svn_sqlite__total_changes(svn_sqlite__db_t *db)
+{
+  return sqlite3_total_changes(db->db3);
+}
+
+svn_boolean_t
+svn_sqlite__in_transaction(svn_sqlite__db_t *db)
+{
+  return sqlite3_get_autocommit(db->db3) == 0;
+}
+
 
 static svn_error_t *
 vbindf(svn_sqlite__stmt_t *stmt, const char *fmt, va_list ap)
@@ -772,7 +795,8 @@ svn_sqlite__read_schema_version(int *version,
 {
   svn_sqlite__stmt_t *stmt;
 
-  SVN_ERR(prepare_statement(&stmt, db, "PRAGMA user_version;", scratch_pool));
+  SVN_ERR(prepare_statement(&stmt, db, "PRAGMA user_version;", FALSE,
+                            scratch_pool));
   SVN_ERR(svn_sqlite__step_row(stmt));
 
   *version = svn_sqlite__column_int(stmt, 0);
@@ -780,6 +804,25 @@ svn_sqlite__read_schema_version(int *version,
   return svn_error_trace(svn_sqlite__finalize(stmt));
 }
 
+/* Set *WAL to whether DB uses write-ahead logging. */
+static svn_error_t *
+get_journal_mode_wal(svn_boolean_t *wal,
+                     svn_sqlite__db_t *db,
+                     apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  const char *mode;
+
+  SVN_ERR(prepare_statement(&stmt, db, "PRAGMA journal_mode;", FALSE,
+                            scratch_pool));
+  SVN_ERR(svn_sqlite__step_row(stmt));
+
+  mode = svn_sqlite__column_text(stmt, 0, NULL);
+  *wal = (mode && svn_cstring_casecmp(mode, "wal") == 0);
+
+  return svn_error_trace(svn_sqlite__finalize(stmt));
+}
+
 
 static volatile svn_atomic_t sqlite_init_state = 0;
 
@@ -1164,11 +1207,23 @@ svn_sqlite__open(svn_sqlite__db_t **db, const char *path,
                  affects application(read: Subversion) performance/behavior. */
               "PRAGMA foreign_keys=OFF;"      /* SQLITE_DEFAULT_FOREIGN_KEYS*/
               "PRAGMA locking_mode = NORMAL;" /* SQLITE_DEFAULT_LOCKING_MODE */
-              /* Testing shows TRUNCATE is faster than DELETE on Windows. */
-              "PRAGMA journal_mode = TRUNCATE;"
               ),
                 *db);
 
+  /* Testing shows TRUNCATE is faster than DELETE on Windows.  Databases
+     that have been switched to write-ahead logging by svn_sqlite__tune()
+     stay that way, though; switching back and forth on every open would
+     be expensive. */
+  {
+    svn_boolean_t wal;
+
+    SVN_SQLITE__ERR_CLOSE(get_journal_mode_wal(&wal, *db, scratch_pool),
+                          *db);
+    if (!wal)
+      SVN_SQLITE__ERR_CLOSE(exec_sql(*db, "PRAGMA journal_mode = TRUNCATE;"),
+                            *db);
+  }
+
 #if defined(SVN_DEBUG)
   /* When running in debug mode, enable the checking of foreign key
      constraints.  This has possible performance implications, so we don't
@@ -1221,6 +1276,44 @@ svn_sqlite__open(svn_sqlite__db_t **db, const char *path,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_sqlite__tune(svn_sqlite__db_t *db,
+                 apr_int64_t cache_size,
+                 apr_int64_t mmap_size,
+                 svn_boolean_t wal,
+                 apr_pool_t *scratch_pool)
+{
+  svn_boolean_t is_wal;
+
+  /* Negative values tell SQLite to use kibibytes instead of pages. */
+  if (cache_size >= 0)
+    SVN_ERR(exec_sql(db, apr_psprintf(scratch_pool,
+                                      "PRAGMA cache_size = -%" APR_INT64_T_FMT
+                                      ";", cache_size)));
+
+  /* This is a no-op in SQLite versions and builds without memory mapped
+     I/O. */
+  if (mmap_size >= 0)
+    SVN_ERR(exec_sql(db, apr_psprintf(scratch_pool,
+                                      "PRAGMA mmap_size = %" APR_INT64_T_FMT
+                                      ";", mmap_size)));
+
+  SVN_ERR(get_journal_mode_wal(&is_wal, db, scratch_pool));
+  if (wal && !is_wal)
+    {
+      /* SQLite keeps the old journal mode if it can't switch, e.g. on file
+         systems without shared memory support or for read-only
+         connections.  That's fine. */
+      svn_error_clear(exec_sql(db, "PRAGMA journal_mode = WAL;"));
+    }
+  else if (!wal && is_wal)
+    {
+      svn_error_clear(exec_sql(db, "PRAGMA journal_mode = TRUNCATE;"));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_sqlite__close(svn_sqlite__db_t *db)
 {
@@ -31,6 +31,8 @@
 #include <apr_errno.h>
 #include <apr_poll.h>
 #include <apr_portable.h>
+#include <apr_thread_proc.h>
+#include <apr_thread_cond.h>
 
 #include <zlib.h>
 
@@ -47,9 +49,18 @@
 #include "private/svn_error_private.h"
 #include "private/svn_eol_private.h"
 #include "private/svn_io_private.h"
+#include "private/svn_mutex.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_utf_private.h"
 
+#if defined(HAVE_COPY_FILE_RANGE) || defined(HAVE_SENDFILE)
+#include <errno.h>
+#endif
+
+#ifdef HAVE_SENDFILE
+#include <sys/sendfile.h>
+#endif
+
 
 struct svn_stream_t {
   void *baton;
@@ -391,19 +402,176 @@ svn_stream_readline(svn_stream_t *stream,
   return SVN_NO_ERROR;
 }
 
+#if defined(HAVE_COPY_FILE_RANGE) || defined(HAVE_SENDFILE)
+/* Maximum number of bytes that copy_in_kernel() transfers per system
+   call, so it can check for cancellation every now and then. */
+#define KERNEL_COPY_CHUNK_SIZE 0x4000000
+
+/* Return TRUE if ERRNO_VALUE, as set by copy_file_range() or sendfile(),
+   indicates that the system call does not support the given files. */
+static svn_boolean_t
+kernel_copy_unsupported(int errno_value)
+{
+  return errno_value == EXDEV || errno_value == ENOSYS
+      || errno_value == EINVAL || errno_value == EOPNOTSUPP
+      || errno_value == EBADF;
+}
+
+/* Let the kernel transfer up to KERNEL_COPY_CHUNK_SIZE bytes from FROM_FD,
+   starting at *OFFSET, to the current position of TO_FD.  Advance *OFFSET
+   accordingly.  Clear *TRY_COPY_FILE_RANGE once the files turned out not
+   to support copy_file_range().  Return the number of bytes transferred,
+   or -1 with ERRNO set, just like the system calls do. */
+static apr_ssize_t
+kernel_copy_chunk(apr_os_file_t to_fd,
+                  apr_os_file_t from_fd,
+                  apr_off_t *offset,
+                  svn_boolean_t *try_copy_file_range)
+{
+  apr_ssize_t copied = -1;
+
+#ifdef HAVE_COPY_FILE_RANGE
+  if (*try_copy_file_range)
+    {
+      loff_t off = *offset;
+
+      copied = copy_file_range(from_fd, &off, to_fd, NULL,
+                               KERNEL_COPY_CHUNK_SIZE, 0);
+      if (copied >= 0 || !kernel_copy_unsupported(errno))
+        {
+          *offset = off;
+          return copied;
+        }
+
+      /* E.g. a pipe or socket as target.  sendfile() may still work. */
+      *try_copy_file_range = FALSE;
+    }
+#endif
+
+#ifdef HAVE_SENDFILE
+  {
+    off_t off = *offset;
+
+    copied = sendfile(to_fd, from_fd, &off, KERNEL_COPY_CHUNK_SIZE);
+    *offset = off;
+  }
+#endif
+
+  return copied;
+}
+
+/* Try to let the kernel transfer the remaining contents of FROM_FILE to
+   TO_FILE, starting at their current positions, without passing the data
+   through user space.  Set *COPIED to FALSE if that is not supported for
+   this pair of files and nothing has been transferred.  Otherwise, set
+   *COPIED to TRUE and leave both files positioned after the data.
+
+   Call CANCEL_FUNC with CANCEL_BATON between chunks, unless it is NULL.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+copy_in_kernel(svn_boolean_t *copied,
+               apr_file_t *from_file,
+               apr_file_t *to_file,
+               svn_cancel_func_t cancel_func,
+               void *cancel_baton,
+               apr_pool_t *scratch_pool)
+{
+  apr_os_file_t from_fd, to_fd;
+  apr_off_t from_offset, to_offset;
+  apr_off_t total = 0;
+  svn_boolean_t try_copy_file_range = TRUE;
+  svn_error_t *err;
+
+  *copied = FALSE;
+  if (   apr_os_file_get(&from_fd, from_file)
+      || apr_os_file_get(&to_fd, to_file))
+    return SVN_NO_ERROR;
+
+  /* We need to know where to start reading.  Pipes don't tell us; just
+     read and write their data as usual. */
+  err = svn_io_file_get_offset(&from_offset, from_file, scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  /* Buffered output must go before the data we are about to append.
+     Writing to a pipe or socket does not need any offset on our side. */
+  SVN_ERR(svn_io_file_flush(to_file, scratch_pool));
+  err = svn_io_file_get_offset(&to_offset, to_file, scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      to_offset = -1;
+    }
+
+  while (1)
+    {
+      apr_ssize_t chunk;
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      chunk = kernel_copy_chunk(to_fd, from_fd, &from_offset,
+                                &try_copy_file_range);
+      if (chunk == 0)
+        break;
+
+      if (chunk < 0)
+        {
+          if (errno == EINTR)
+            continue;
+
+          /* Not supported for this pair of files?  Then we will simply
+             read and write the contents ourselves. */
+          if (total == 0 && kernel_copy_unsupported(errno))
+            return SVN_NO_ERROR;
+
+          return svn_error_wrap_apr(APR_FROM_OS_ERROR(errno),
+                                    _("Can't copy file contents"));
+        }
+
+      total += chunk;
+    }
+
+  *copied = TRUE;
+
+  /* The kernel did not update APR's idea of the file positions. */
+  SVN_ERR(svn_io_file_seek(from_file, APR_SET, &from_offset, scratch_pool));
+  if (to_offset >= 0)
+    {
+      to_offset += total;
+      SVN_ERR(svn_io_file_seek(to_file, APR_SET, &to_offset, scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+#endif
+
 svn_error_t *svn_stream_copy3(svn_stream_t *from, svn_stream_t *to,
                               svn_cancel_func_t cancel_func,
                               void *cancel_baton,
                               apr_pool_t *scratch_pool)
 {
   char *buf = apr_palloc(scratch_pool, SVN__STREAM_CHUNK_SIZE);
-  svn_error_t *err;
+  svn_error_t *err = SVN_NO_ERROR;
   svn_error_t *err2;
+  svn_boolean_t copied = FALSE;
+
+#if defined(HAVE_COPY_FILE_RANGE) || defined(HAVE_SENDFILE)
+  /* If both ends are plain files, sockets etc., the kernel may move the
+     data directly between them. */
+  if (svn_stream__aprfile(from) && svn_stream__aprfile(to))
+    err = copy_in_kernel(&copied, svn_stream__aprfile(from),
+                         svn_stream__aprfile(to), cancel_func, cancel_baton,
+                         scratch_pool);
+#endif
 
   /* Read and write chunks until we get a short read, indicating the
      end of the stream.  (We can't get a short write without an
      associated error.) */
-  while (1)
+  while (!err && !copied)
     {
       apr_size_t len = SVN__STREAM_CHUNK_SIZE;
 
@@ -2113,6 +2281,424 @@ svn_stream_lazyopen_create(svn_stream_lazyopen_func_t open_func,
   return stream;
 }
 
+/*** Read-ahead streams ***/
+
+#if APR_HAS_THREADS
+
+/* One buffer of a read-ahead stream. */
+typedef struct read_ahead_block_t
+{
+  /* BLOCK_SIZE bytes of buffer space. */
+  char *data;
+
+  /* Number of bytes in DATA that have been read from the source. */
+  apr_size_t len;
+} read_ahead_block_t;
+
+/* Baton for read-ahead streams.  The blocks form a ring buffer that the
+ * reader thread fills and the stream user empties. */
+typedef struct read_ahead_baton_t
+{
+  /* The stream being read by the reader thread. */
+  svn_stream_t *source;
+
+  /* Serializes access to FILLED, CONSUMED, FINISHED and ERR. */
+  svn_mutex__t *mutex;
+
+  /* Signaled whenever a block has been filled or consumed. */
+  apr_thread_cond_t *cond;
+
+  /* The ring buffer.  The N-th block read is BLOCKS[N % BLOCK_COUNT]. */
+  read_ahead_block_t *blocks;
+  int block_count;
+  apr_size_t block_size;
+
+  /* Number of blocks filled by the reader thread and consumed by the
+   * stream user, respectively.  Blocks in between are owned by the user,
+   * all others by the reader thread. */
+  apr_int64_t filled;
+  apr_int64_t consumed;
+
+  /* Set by the reader thread once it won't fill any more blocks. */
+  svn_boolean_t finished;
+
+  /* Error returned by the source.  Reported after the data before it. */
+  svn_error_t *err;
+
+  /* Non-zero once the reader thread shall stop. */
+  volatile svn_atomic_t aborted;
+
+  /* The reader thread.  NULL once it has been joined. */
+  apr_thread_t *thread;
+
+  /* Read position of the stream user within BLOCKS[CONSUMED % BLOCK_COUNT]
+   * if HAVE_BLOCK is set. */
+  svn_boolean_t have_block;
+  apr_size_t pos;
+} read_ahead_baton_t;
+
+/* Wait for COND of baton B, whose mutex must be locked by the caller. */
+static svn_error_t *
+wait_read_ahead(read_ahead_baton_t *b)
+{
+  apr_status_t status = apr_thread_cond_wait(b->cond,
+                                             svn_mutex__get(b->mutex));
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't wait for condition variable"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread function.  Fill the blocks of the read_ahead_baton_t given by
+ * DATA until the source runs out or the stream gets closed. */
+static void * APR_THREAD_FUNC
+read_ahead_thread(apr_thread_t *tid,
+                  void *data)
+{
+  read_ahead_baton_t *b = data;
+  svn_error_t *err = SVN_NO_ERROR;
+  svn_boolean_t done = FALSE;
+
+  while (!done)
+    {
+      read_ahead_block_t *block;
+      svn_error_t *read_err;
+      apr_size_t len;
+
+      /* Wait for an empty block. */
+      err = svn_mutex__lock(b->mutex);
+      if (err)
+        break;
+
+      while (!err
+             && !svn_atomic_read(&b->aborted)
+             && b->filled - b->consumed >= b->block_count)
+        err = wait_read_ahead(b);
+
+      done = svn_atomic_read(&b->aborted);
+      block = &b->blocks[b->filled % b->block_count];
+      err = svn_mutex__unlock(b->mutex, err);
+      if (err || done)
+        break;
+
+      /* The user won't touch BLOCK until we hand it over. */
+      len = b->block_size;
+      read_err = svn_stream_read_full(b->source, block->data, &len);
+      block->len = read_err ? 0 : len;
+      done = read_err || len < b->block_size;
+
+      err = svn_mutex__lock(b->mutex);
+      if (err)
+        {
+          svn_error_clear(read_err);
+          break;
+        }
+
+      b->err = read_err;
+      b->filled++;
+      apr_thread_cond_broadcast(b->cond);
+      err = svn_mutex__unlock(b->mutex, SVN_NO_ERROR);
+      if (err)
+        break;
+    }
+
+  /* The user may be waiting for more data.  Tell them that there is none,
+     even if we could not get the lock. */
+  err = svn_error_compose_create(err, svn_mutex__lock(b->mutex));
+  b->finished = TRUE;
+  if (err && !b->err && !svn_atomic_read(&b->aborted))
+    {
+      b->err = err;
+      err = SVN_NO_ERROR;
+    }
+
+  apr_thread_cond_broadcast(b->cond);
+  svn_error_clear(svn_mutex__unlock(b->mutex, SVN_NO_ERROR));
+  svn_error_clear(err);
+
+  return NULL;
+}
+
+/* Set *BLOCK to the block of B that contains the next unread data.
+ * Wait for the reader thread if necessary.  Set it to NULL at the end
+ * of the source.  Return the source's error after all data before it
+ * has been consumed. */
+static svn_error_t *
+next_read_ahead_block(read_ahead_block_t **block,
+                      read_ahead_baton_t *b)
+{
+  svn_error_t *err;
+
+  if (b->have_block)
+    {
+      read_ahead_block_t *current = &b->blocks[b->consumed % b->block_count];
+      if (b->pos < current->len)
+        {
+          *block = current;
+          return SVN_NO_ERROR;
+        }
+    }
+
+  SVN_ERR(svn_mutex__lock(b->mutex));
+
+  /* Hand the exhausted block back to the reader thread. */
+  if (b->have_block)
+    {
+      b->have_block = FALSE;
+      b->consumed++;
+      apr_thread_cond_broadcast(b->cond);
+    }
+
+  /* Skip empty blocks, i.e. the one holding the EOF or the error. */
+  err = SVN_NO_ERROR;
+  while (!err && !b->have_block)
+    {
+      if (b->consumed < b->filled)
+        {
+          if (b->blocks[b->consumed % b->block_count].len)
+            {
+              b->have_block = TRUE;
+              b->pos = 0;
+            }
+          else
+            {
+              b->consumed++;
+              apr_thread_cond_broadcast(b->cond);
+            }
+        }
+      else if (b->finished)
+        {
+          break;
+        }
+      else
+        {
+          err = wait_read_ahead(b);
+        }
+    }
+
+  /* Report the source's error only once. */
+  if (!err && !b->have_block && b->err)
+    {
+      err = b->err;
+      b->err = NULL;
+    }
+
+  *block = b->have_block ? &b->blocks[b->consumed % b->block_count] : NULL;
+
+  return svn_error_trace(svn_mutex__unlock(b->mutex, err));
+}
+
+/* Implements svn_read_fn_t */
+static svn_error_t *
+read_handler_read_ahead(void *baton,
+                        char *buffer,
+                        apr_size_t *len)
+{
+  read_ahead_baton_t *b = baton;
+  apr_size_t total = 0;
+
+  while (total < *len)
+    {
+      read_ahead_block_t *block;
+      apr_size_t to_copy;
+
+      SVN_ERR(next_read_ahead_block(&block, b));
+      if (block == NULL)
+        break;
+
+      to_copy = MIN(*len - total, block->len - b->pos);
+      memcpy(buffer + total, block->data + b->pos, to_copy);
+      b->pos += to_copy;
+      total += to_copy;
+    }
+
+  *len = total;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_stream_readline_fn_t.  Same result as the default
+ * implementation but scans the read-ahead buffers directly. */
+static svn_error_t *
+readline_handler_read_ahead(void *baton,
+                            svn_stringbuf_t **stringbuf,
+                            const char *eol,
+                            svn_boolean_t *eof,
+                            apr_pool_t *pool)
+{
+  read_ahead_baton_t *b = baton;
+  svn_stringbuf_t *str = svn_stringbuf_create_ensure(SVN__LINE_CHUNK_SIZE,
+                                                     pool);
+  const char *match = eol;
+
+  /* Read into STR up to and including the next EOL sequence. */
+  while (*match)
+    {
+      read_ahead_block_t *block;
+      const char *start;
+      const char *end;
+      const char *p;
+
+      SVN_ERR(next_read_ahead_block(&block, b));
+      if (block == NULL)
+        {
+          *eof = TRUE;
+          *stringbuf = str;
+          return SVN_NO_ERROR;
+        }
+
+      start = block->data + b->pos;
+      end = block->data + block->len;
+      for (p = start; p < end && *match; ++p)
+        {
+          if (*p == *match)
+            match++;
+          else
+            match = eol;
+        }
+
+      svn_stringbuf_appendbytes(str, start, p - start);
+      b->pos += p - start;
+    }
+
+  *eof = FALSE;
+  svn_stringbuf_chop(str, match - eol);
+  *stringbuf = str;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_stream_data_available_fn_t */
+static svn_error_t *
+data_available_handler_read_ahead(void *baton,
+                                  svn_boolean_t *data_available)
+{
+  read_ahead_baton_t *b = baton;
+
+  if (   b->have_block
+      && b->pos < b->blocks[b->consumed % b->block_count].len)
+    {
+      *data_available = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  /* The next block is either there or we would have to wait for it. */
+  SVN_ERR(svn_mutex__lock(b->mutex));
+  *data_available = b->consumed + (b->have_block ? 1 : 0) < b->filled;
+
+  return svn_error_trace(svn_mutex__unlock(b->mutex, SVN_NO_ERROR));
+}
+
+/* Stop and join the reader thread of B, if it is still running. */
+static svn_error_t *
+stop_read_ahead(read_ahead_baton_t *b)
+{
+  svn_error_t *err;
+  apr_status_t retval;
+  apr_status_t status;
+
+  if (b->thread == NULL)
+    return SVN_NO_ERROR;
+
+  svn_atomic_set(&b->aborted, TRUE);
+  err = svn_mutex__lock(b->mutex);
+  apr_thread_cond_broadcast(b->cond);
+  err = svn_mutex__unlock(b->mutex, err);
+
+  status = apr_thread_join(&retval, b->thread);
+  b->thread = NULL;
+  if (status)
+    err = svn_error_compose_create(err,
+                                   svn_error_wrap_apr(status,
+                                               _("Can't join read thread")));
+
+  /* Nobody is going to see them anymore. */
+  svn_error_clear(b->err);
+  b->err = NULL;
+
+  return svn_error_trace(err);
+}
+
+/* Implements svn_close_fn_t */
+static svn_error_t *
+close_handler_read_ahead(void *baton)
+{
+  read_ahead_baton_t *b = baton;
+
+  SVN_ERR(stop_read_ahead(b));
+  return svn_error_trace(svn_stream_close(b->source));
+}
+
+/* Pool pre-cleanup handler, making sure that the reader thread does not
+ * access the buffers of the read_ahead_baton_t in DATA after they got
+ * freed. */
+static apr_status_t
+read_ahead_pre_cleanup(void *data)
+{
+  svn_error_clear(stop_read_ahead(data));
+  return APR_SUCCESS;
+}
+
+#endif
+
+svn_error_t *
+svn_stream__read_ahead(svn_stream_t **stream,
+                       svn_stream_t *source,
+                       apr_size_t block_size,
+                       int block_count,
+                       apr_pool_t *result_pool)
+{
+#if APR_HAS_THREADS
+  read_ahead_baton_t *b;
+  apr_status_t status;
+  int i;
+
+  /* Without buffers, there is nothing to read ahead into. */
+  if (block_size == 0 || block_count <= 0)
+    {
+      *stream = source;
+      return SVN_NO_ERROR;
+    }
+
+  b = apr_pcalloc(result_pool, sizeof(*b));
+  b->source = source;
+  b->block_size = block_size;
+  b->block_count = block_count;
+  b->blocks = apr_pcalloc(result_pool, block_count * sizeof(*b->blocks));
+  for (i = 0; i < block_count; ++i)
+    b->blocks[i].data = apr_palloc(result_pool, block_size);
+
+  SVN_ERR(svn_mutex__init(&b->mutex, TRUE, result_pool));
+  status = apr_thread_cond_create(&b->cond, result_pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create condition variable"));
+
+  /* Reading ahead is only an optimization.  Without a thread, use the
+     source directly. */
+  status = apr_thread_create(&b->thread, NULL, read_ahead_thread, b,
+                             result_pool);
+  if (status)
+    {
+      *stream = source;
+      return SVN_NO_ERROR;
+    }
+
+  apr_pool_pre_cleanup_register(result_pool, b, read_ahead_pre_cleanup);
+
+  *stream = svn_stream_create(b, result_pool);
+  svn_stream_set_read2(*stream, read_handler_read_ahead,
+                       read_handler_read_ahead);
+  svn_stream_set_close(*stream, close_handler_read_ahead);
+  svn_stream_set_data_available(*stream, data_available_handler_read_ahead);
+  svn_stream_set_readline(*stream, readline_handler_read_ahead);
+#else
+  *stream = source;
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+
 /* Baton for install streams */
 struct install_baton_t
 {
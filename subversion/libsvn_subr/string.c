@@ -37,6 +37,14 @@
 
 #include "svn_private_config.h"
 
+/* SSE2 is part of the x86-64 base ISA, so the vectorized match length
+ * functions need no runtime CPU detection.
+ */
+#if defined(__GNUC__) && defined(__SSE2__)
+#  define MATCH_LENGTH_SSE2 1
+#  include <emmintrin.h>
+#endif
+
 
 
 /* Allocate the space for a memory buffer from POOL.
@@ -1413,6 +1421,21 @@ svn_cstring__match_length(const char *a,
 {
   apr_size_t pos = 0;
 
+#ifdef MATCH_LENGTH_SSE2
+
+  /* Compare 16 bytes per step.  The mask has a 0 bit for every mismatch. */
+  for (; max_len - pos >= 16; pos += 16)
+    {
+      unsigned int mask
+        = (unsigned int)_mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(a + pos)),
+                           _mm_loadu_si128((const __m128i *)(b + pos))));
+      if (mask != 0xffff)
+        return pos + __builtin_ctz(~mask);
+    }
+
+#endif
+
 #if SVN_UNALIGNED_ACCESS_IS_OK
 
   /* Chunky processing is so much faster ...
@@ -1441,6 +1464,24 @@ svn_cstring__reverse_match_length(const char *a,
 {
   apr_size_t pos = 0;
 
+#ifdef MATCH_LENGTH_SSE2
+
+  /* Compare 16 bytes per step.  The mask has a 0 bit for every mismatch
+   * and the highest one of these is the mismatch closest to A and B. */
+  for (pos = 16; pos <= max_len; pos += 16)
+    {
+      unsigned int mask
+        = (unsigned int)_mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(a - pos)),
+                           _mm_loadu_si128((const __m128i *)(b - pos))));
+      if (mask != 0xffff)
+        return pos - 16 + __builtin_clz(~mask & 0xffff) - 16;
+    }
+
+  pos -= 16;
+
+#endif
+
 #if SVN_UNALIGNED_ACCESS_IS_OK
 
   /* Chunky processing is so much faster ...
@@ -1449,7 +1490,7 @@ svn_cstring__reverse_match_length(const char *a,
    * because A and B will probably have different alignment. So, skipping
    * the first few chars until alignment is reached is not an option.
    */
-  for (pos = sizeof(apr_size_t); pos <= max_len; pos += sizeof(apr_size_t))
+  for (pos += sizeof(apr_size_t); pos <= max_len; pos += sizeof(apr_size_t))
     if (*(const apr_size_t*)(a - pos) != *(const apr_size_t*)(b - pos))
       break;
 
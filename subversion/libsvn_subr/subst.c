@@ -980,6 +980,41 @@ eol_unchanged(struct translation_baton *b,
   return !b->interesting[(unsigned char)buf[1]] || buf[0] == buf[1];
 }
 
+/* Return a pointer to the first character in BUF of length LEN that may
+ * trigger a translation action according to baton B, i.e. the first
+ * character marked in B->INTERESTING.  Return NULL if there is none.
+ */
+static APR_INLINE const char *
+find_interesting(const struct translation_baton *b,
+                 const char *buf,
+                 apr_size_t len)
+{
+  if (b->keywords)
+    return svn_eol__find_first_of3(buf, len, '$',
+                                   b->eol_str ? '\r' : '$',
+                                   b->eol_str ? '\n' : '$');
+
+  if (b->eol_str)
+    return svn_eol__find_eol_start((char *)buf, len);
+
+  return NULL;
+}
+
+/* Return TRUE if translating BUF of length LEN with baton B would simply
+ * reproduce BUF, i.e. if there is no pending newline or keyword state
+ * in B and BUF contains no interesting characters.  In that case, the
+ * state of B would not change by processing BUF either.
+ */
+static svn_boolean_t
+translation_is_noop(const struct translation_baton *b,
+                    const char *buf,
+                    apr_size_t len)
+{
+  return !b->newline_off
+      && !b->keyword_off
+      && !find_interesting(b, buf, len);
+}
+
 
 /* Translate eols and keywords of a 'chunk' of characters BUF of size BUFLEN
  * according to the settings and state stored in baton B.
@@ -1011,6 +1046,19 @@ translate_chunk(svn_stream_t *dst,
       const char *interesting = b->interesting;
       apr_size_t next_sign_off = 0;
 
+      /* Fast path: without pending state, everything up to the first
+       * interesting character can be passed through as-is.  Quite often,
+       * that is the whole chunk. */
+      if (!b->newline_off && !b->keyword_off)
+        {
+          const char *next = find_interesting(b, buf, buflen);
+          len = (next ? next : end) - buf;
+          if (len)
+            SVN_ERR(translate_write(dst, buf, len));
+
+          buf += len;
+        }
+
       /* At the beginning of this loop, assume that we might be in an
        * interesting state, i.e. with data in the newline or keyword
        * buffer.  First try to get to the boring state so we can copy
@@ -1120,40 +1168,19 @@ translate_chunk(svn_stream_t *dst,
            */
           do
             {
+              const char *start;
+              const char *next;
+
               /* skip current EOL */
               len += b->eol_str_len;
 
-              if (b->keywords)
-                {
-                  /* Check 4 bytes at once to allow for efficient pipelining
-                    and to reduce loop condition overhead. */
-                  while ((end - p) >= (len + 4))
-                    {
-                      if (interesting[(unsigned char)p[len]]
-                          || interesting[(unsigned char)p[len+1]]
-                          || interesting[(unsigned char)p[len+2]]
-                          || interesting[(unsigned char)p[len+3]])
-                        break;
-
-                      len += 4;
-                    }
-
-                  /* Found an interesting char or EOF in the next 4 bytes.
-                     Find its exact position. */
-                  while ((p + len) < end
-                         && !interesting[(unsigned char)p[len]])
-                    ++len;
-                }
-              else
-                {
-                  /* use our optimized sub-routine to find the next EOL */
-                  const char *start = p + len;
-                  const char *eol
-                    = svn_eol__find_eol_start((char *)start, end - start);
+              /* use our vectorized sub-routine to find the next EOL
+                 or keyword start */
+              start = p + len;
+              next = find_interesting(b, start, end - start);
 
-                  /* EOL will be NULL if we did not find a line ending */
-                  len += (eol ? eol : end) - start;
-                }
+              /* NEXT will be NULL if there is nothing to translate */
+              len += (next ? next : end) - start;
             }
           while (b->nl_translation_skippable ==
                    svn_tristate_true &&       /* can potentially skip EOLs */
@@ -1289,12 +1316,28 @@ translated_stream_read(void *baton,
         {
           svn_stream_t *buf_stream;
 
+          /* If the caller wants at least a full chunk, read directly into
+             their buffer.  Should the data not need any translation, we
+             are done without copying it around. */
+          char *chunk = unsatisfied >= SVN__STREAM_CHUNK_SIZE
+                      ? buffer + off
+                      : b->buf;
+
           svn_stringbuf_setempty(b->readbuf);
           b->readbuf_off = 0;
-          SVN_ERR(svn_stream_read_full(b->stream, b->buf, &readlen));
+          SVN_ERR(svn_stream_read_full(b->stream, chunk, &readlen));
+
+          if (chunk != b->buf
+              && translation_is_noop(b->in_baton, chunk, readlen))
+            {
+              off += readlen;
+              unsatisfied -= readlen;
+              continue;
+            }
+
           buf_stream = svn_stream_from_stringbuf(b->readbuf, b->iterpool);
 
-          SVN_ERR(translate_chunk(buf_stream, b->in_baton, b->buf,
+          SVN_ERR(translate_chunk(buf_stream, b->in_baton, chunk,
                                   readlen, b->iterpool));
 
           if (readlen != SVN__STREAM_CHUNK_SIZE)
@@ -59,6 +59,24 @@
 #include "private/svn_utf_private.h"
 #include "private/svn_eol_private.h"
 #include "private/svn_dep_compat.h"
+#include "private/svn_atomic.h"
+
+/* Compile-time selection of the vectorized validators.  As for the SHA-1
+ * code, the x86 variants use function-specific target attributes such
+ * that they can be built with default compiler flags; the CPU features
+ * are checked at runtime.  NEON is part of the base AArch64 ISA.
+ */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) \
+    && (__GNUC__ >= 5 || defined(__clang__))
+#  define UTF_VALIDATE_X86 1
+#  include <cpuid.h>
+#  include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#  define UTF_VALIDATE_NEON 1
+#  include <arm_neon.h>
+#endif
 
 /* Lookup table to categorise each octet in the string. */
 static const char octet_category[256] = {
@@ -276,10 +294,447 @@ first_non_fsm_start_char(const char *data, apr_size_t max_len)
   return data;
 }
 
+/* Inputs shorter than this will not be handed to the vectorized
+ * validators.  The setup cost would not pay off for them.
+ */
+#define SIMD_MIN_LEN 64
+
+/* Error classes detected by the vectorized validators.  They follow
+ * the "lookup" algorithm by Keiser and Lemire: each pair of consecutive
+ * bytes is classified by the high and low nibble of the first byte and
+ * the high nibble of the second byte.  The three table lookups each
+ * return the set of error classes that byte pairs matching that nibble
+ * may belong to.  A pair is invalid if all three sets intersect.
+ * Continuation bytes 3 and 4 of a multi-byte sequence are handled
+ * separately since they cannot be judged from the preceding byte alone.
+ */
+#define UTF_TOO_SHORT      (1 << 0) /* 11______ 0_______ or 11______ 11______ */
+#define UTF_TOO_LONG       (1 << 1) /* 0_______ 10______ */
+#define UTF_OVERLONG_3     (1 << 2) /* 11100000 100_____ */
+#define UTF_TOO_LARGE      (1 << 3) /* 11110100 1001____ and above */
+#define UTF_SURROGATE      (1 << 4) /* 11101101 101_____ */
+#define UTF_OVERLONG_2     (1 << 5) /* 1100000_ 10______ */
+#define UTF_TOO_LARGE_1000 (1 << 6) /* 11110101 1000____ and above */
+#define UTF_OVERLONG_4     (1 << 6) /* 11110000 1000____ */
+#define UTF_TWO_CONTS      (1 << 7) /* 10______ 10______ */
+#define UTF_CARRY          (UTF_TOO_SHORT | UTF_TOO_LONG | UTF_TWO_CONTS)
+
+/* Error classes indexed by the high nibble of the first byte of a pair. */
+static const unsigned char byte_1_high_errors[16] = {
+  /* 0_______ ________ */
+  UTF_TOO_LONG, UTF_TOO_LONG, UTF_TOO_LONG, UTF_TOO_LONG,
+  UTF_TOO_LONG, UTF_TOO_LONG, UTF_TOO_LONG, UTF_TOO_LONG,
+  /* 10______ ________ */
+  UTF_TWO_CONTS, UTF_TWO_CONTS, UTF_TWO_CONTS, UTF_TWO_CONTS,
+  /* 1100____ ________ */
+  UTF_TOO_SHORT | UTF_OVERLONG_2,
+  /* 1101____ ________ */
+  UTF_TOO_SHORT,
+  /* 1110____ ________ */
+  UTF_TOO_SHORT | UTF_OVERLONG_3 | UTF_SURROGATE,
+  /* 1111____ ________ */
+  UTF_TOO_SHORT | UTF_TOO_LARGE | UTF_TOO_LARGE_1000 | UTF_OVERLONG_4
+};
+
+/* Error classes indexed by the low nibble of the first byte of a pair. */
+static const unsigned char byte_1_low_errors[16] = {
+  /* ____0000 ________ */
+  UTF_CARRY | UTF_OVERLONG_3 | UTF_OVERLONG_2 | UTF_OVERLONG_4,
+  /* ____0001 ________ */
+  UTF_CARRY | UTF_OVERLONG_2,
+  /* ____001_ ________ */
+  UTF_CARRY,
+  UTF_CARRY,
+  /* ____0100 ________ */
+  UTF_CARRY | UTF_TOO_LARGE,
+  /* ____0101 ________ and above */
+  UTF_CARRY | UTF_TOO_LARGE | UTF_TOO_LARGE_1000,
+  UTF_CARRY | UTF_TOO_LARGE | UTF_TOO_LARGE_1000,
+  UTF_CARRY | UTF_TOO_LARGE | UTF_TOO_LARGE_1000,
+  UTF_CARRY | UTF_TOO_LARGE | UTF_TOO_LARGE_1000,
+  UTF_CARRY | UTF_TOO_LARGE | UTF_TOO_LARGE_1000,
+  UTF_CARRY | UTF_TOO_LARGE | UTF_TOO_LARGE_1000,
+  UTF_CARRY | UTF_TOO_LARGE | UTF_TOO_LARGE_1000,
+  UTF_CARRY | UTF_TOO_LARGE | UTF_TOO_LARGE_1000,
+  /* ____1101 ________ */
+  UTF_CARRY | UTF_TOO_LARGE | UTF_TOO_LARGE_1000 | UTF_SURROGATE,
+  UTF_CARRY | UTF_TOO_LARGE | UTF_TOO_LARGE_1000,
+  UTF_CARRY | UTF_TOO_LARGE | UTF_TOO_LARGE_1000
+};
+
+/* Error classes indexed by the high nibble of the second byte of a pair. */
+static const unsigned char byte_2_high_errors[16] = {
+  /* ________ 0_______ */
+  UTF_TOO_SHORT, UTF_TOO_SHORT, UTF_TOO_SHORT, UTF_TOO_SHORT,
+  UTF_TOO_SHORT, UTF_TOO_SHORT, UTF_TOO_SHORT, UTF_TOO_SHORT,
+  /* ________ 1000____ */
+  UTF_TOO_LONG | UTF_OVERLONG_2 | UTF_TWO_CONTS | UTF_OVERLONG_3
+    | UTF_TOO_LARGE_1000 | UTF_OVERLONG_4,
+  /* ________ 1001____ */
+  UTF_TOO_LONG | UTF_OVERLONG_2 | UTF_TWO_CONTS | UTF_OVERLONG_3
+    | UTF_TOO_LARGE,
+  /* ________ 101_____ */
+  UTF_TOO_LONG | UTF_OVERLONG_2 | UTF_TWO_CONTS | UTF_SURROGATE
+    | UTF_TOO_LARGE,
+  UTF_TOO_LONG | UTF_OVERLONG_2 | UTF_TWO_CONTS | UTF_SURROGATE
+    | UTF_TOO_LARGE,
+  /* ________ 11______ */
+  UTF_TOO_SHORT, UTF_TOO_SHORT, UTF_TOO_SHORT, UTF_TOO_SHORT
+};
+
+/* The vectorized validators check DATA up to the point where they find
+ * an error or where fewer than a full vector of bytes remains.  All data
+ * before CLEAN_END has been found to be valid except for the last
+ * multi-byte sequence that may extend beyond CLEAN_END.  Return the start
+ * of that sequence or CLEAN_END if there is none.  Either way, all
+ * characters before the result are valid and the result is a character
+ * boundary, i.e. a valid position to start the FSM at.
+ */
+static const char *
+clean_char_boundary(const char *data, const char *clean_end)
+{
+  int i;
+  for (i = 1; i <= 3 && clean_end - i >= data; ++i)
+    {
+      unsigned char octet = (unsigned char)clean_end[-i];
+      if (octet >= 0xC0)
+        return clean_end - i;
+      if (octet < 0x80)
+        break;
+    }
+
+  return clean_end;
+}
+
+#ifdef UTF_VALIDATE_X86
+
+#define UTF_SSSE3_TARGET __attribute__((target("ssse3")))
+#define UTF_AVX2_TARGET __attribute__((target("avx2")))
+
+/* Return a non-zero vector iff the 16 bytes in INPUT are not valid UTF-8,
+ * given that PREV holds the 16 bytes preceding INPUT.  Sequences that are
+ * incomplete at the end of INPUT will not be reported.  The tables are
+ * the nibble lookup tables from above.
+ */
+UTF_SSSE3_TARGET static __m128i
+check_block_ssse3(__m128i input,
+                  __m128i prev,
+                  __m128i byte_1_high,
+                  __m128i byte_1_low,
+                  __m128i byte_2_high)
+{
+  const __m128i nibble = _mm_set1_epi8(0x0f);
+  __m128i prev1 = _mm_alignr_epi8(input, prev, 15);
+  __m128i prev2 = _mm_alignr_epi8(input, prev, 14);
+  __m128i prev3 = _mm_alignr_epi8(input, prev, 13);
+  __m128i special, must_be_23;
+
+  special = _mm_and_si128(
+    _mm_and_si128(
+      _mm_shuffle_epi8(byte_1_high,
+                       _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble)),
+      _mm_shuffle_epi8(byte_1_low, _mm_and_si128(prev1, nibble))),
+    _mm_shuffle_epi8(byte_2_high,
+                     _mm_and_si128(_mm_srli_epi16(input, 4), nibble)));
+
+  /* Bytes following 111_____ by 2 positions or 1111____ by 3 positions
+   * must be continuation bytes -- and no others may follow another
+   * continuation byte. */
+  must_be_23 = _mm_or_si128(_mm_subs_epu8(prev2, _mm_set1_epi8(0xe0 - 0x80)),
+                            _mm_subs_epu8(prev3, _mm_set1_epi8(0xf0 - 0x80)));
+  must_be_23 = _mm_and_si128(must_be_23, _mm_set1_epi8((char)0x80));
+
+  return _mm_xor_si128(must_be_23, special);
+}
+
+/* Return the position in DATA of length LEN from which the FSM must
+ * continue.  All data before it is valid UTF-8.  SSSE3 variant.
+ */
+UTF_SSSE3_TARGET static const char *
+valid_prefix_ssse3(const char *data, apr_size_t len)
+{
+  const __m128i byte_1_high
+    = _mm_loadu_si128((const __m128i *)byte_1_high_errors);
+  const __m128i byte_1_low
+    = _mm_loadu_si128((const __m128i *)byte_1_low_errors);
+  const __m128i byte_2_high
+    = _mm_loadu_si128((const __m128i *)byte_2_high_errors);
+  const char *p = data;
+  const char *end = data + len;
+  __m128i prev = _mm_setzero_si128();
+  svn_boolean_t prev_ascii = TRUE;
+
+  for (; end - p >= 16; p += 16)
+    {
+      __m128i input = _mm_loadu_si128((const __m128i *)p);
+      svn_boolean_t ascii = _mm_movemask_epi8(input) == 0;
+
+      /* ASCII following ASCII cannot contain any error. */
+      if (!ascii || !prev_ascii)
+        {
+          __m128i error = check_block_ssse3(input, prev, byte_1_high,
+                                            byte_1_low, byte_2_high);
+          if (_mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128()))
+              != 0xffff)
+            break;
+        }
+
+      prev = input;
+      prev_ascii = ascii;
+    }
+
+  return clean_char_boundary(data, p);
+}
+
+/* AVX2 equivalent of check_block_ssse3 for 32 byte blocks.
+ */
+UTF_AVX2_TARGET static __m256i
+check_block_avx2(__m256i input,
+                 __m256i prev,
+                 __m256i byte_1_high,
+                 __m256i byte_1_low,
+                 __m256i byte_2_high)
+{
+  const __m256i nibble = _mm256_set1_epi8(0x0f);
+
+  /* The byte shifts operate on 128 bit lanes only.  Combine the upper
+   * half of PREV with the lower half of INPUT to get the bytes that
+   * precede each lane. */
+  __m256i shifted = _mm256_permute2x128_si256(prev, input, 0x21);
+  __m256i prev1 = _mm256_alignr_epi8(input, shifted, 15);
+  __m256i prev2 = _mm256_alignr_epi8(input, shifted, 14);
+  __m256i prev3 = _mm256_alignr_epi8(input, shifted, 13);
+  __m256i special, must_be_23;
+
+  special = _mm256_and_si256(
+    _mm256_and_si256(
+      _mm256_shuffle_epi8(byte_1_high,
+                          _mm256_and_si256(_mm256_srli_epi16(prev1, 4),
+                                           nibble)),
+      _mm256_shuffle_epi8(byte_1_low, _mm256_and_si256(prev1, nibble))),
+    _mm256_shuffle_epi8(byte_2_high,
+                        _mm256_and_si256(_mm256_srli_epi16(input, 4),
+                                         nibble)));
+
+  must_be_23 = _mm256_or_si256(
+                 _mm256_subs_epu8(prev2, _mm256_set1_epi8(0xe0 - 0x80)),
+                 _mm256_subs_epu8(prev3, _mm256_set1_epi8(0xf0 - 0x80)));
+  must_be_23 = _mm256_and_si256(must_be_23, _mm256_set1_epi8((char)0x80));
+
+  return _mm256_xor_si256(must_be_23, special);
+}
+
+/* AVX2 equivalent of valid_prefix_ssse3.
+ */
+UTF_AVX2_TARGET static const char *
+valid_prefix_avx2(const char *data, apr_size_t len)
+{
+  const __m256i byte_1_high = _mm256_broadcastsi128_si256(
+    _mm_loadu_si128((const __m128i *)byte_1_high_errors));
+  const __m256i byte_1_low = _mm256_broadcastsi128_si256(
+    _mm_loadu_si128((const __m128i *)byte_1_low_errors));
+  const __m256i byte_2_high = _mm256_broadcastsi128_si256(
+    _mm_loadu_si128((const __m128i *)byte_2_high_errors));
+  const char *p = data;
+  const char *end = data + len;
+  __m256i prev = _mm256_setzero_si256();
+  svn_boolean_t prev_ascii = TRUE;
+
+  for (; end - p >= 32; p += 32)
+    {
+      __m256i input = _mm256_loadu_si256((const __m256i *)p);
+      svn_boolean_t ascii = _mm256_movemask_epi8(input) == 0;
+
+      if (!ascii || !prev_ascii)
+        {
+          __m256i error = check_block_avx2(input, prev, byte_1_high,
+                                           byte_1_low, byte_2_high);
+          if (!_mm256_testz_si256(error, error))
+            break;
+        }
+
+      prev = input;
+      prev_ascii = ascii;
+    }
+
+  return clean_char_boundary(data, p);
+}
+
+/* Return TRUE if the CPU supports SSSE3.
+ */
+static svn_boolean_t
+have_x86_ssse3(void)
+{
+  unsigned int eax, ebx, ecx, edx;
+
+  if (__get_cpuid_max(0, NULL) < 1)
+    return FALSE;
+
+  __cpuid(1, eax, ebx, ecx, edx);
+  return (ecx & bit_SSSE3) != 0;
+}
+
+/* Return TRUE if the CPU and the OS support AVX2.
+ */
+static svn_boolean_t
+have_x86_avx2(void)
+{
+  unsigned int eax, ebx, ecx, edx;
+  unsigned int xcr0_lo, xcr0_hi;
+
+  if (__get_cpuid_max(0, NULL) < 7)
+    return FALSE;
+
+  /* The OS must save the YMM registers across context switches. */
+  __cpuid(1, eax, ebx, ecx, edx);
+  if (!(ecx & bit_OSXSAVE) || !(ecx & bit_AVX))
+    return FALSE;
+
+  __asm__ ("xgetbv" : "=a" (xcr0_lo), "=d" (xcr0_hi) : "c" (0));
+  if ((xcr0_lo & 6) != 6)
+    return FALSE;
+
+  __cpuid_count(7, 0, eax, ebx, ecx, edx);
+  return (ebx & bit_AVX2) != 0;
+}
+
+#endif /* UTF_VALIDATE_X86 */
+
+#ifdef UTF_VALIDATE_NEON
+
+/* NEON equivalent of check_block_ssse3.
+ */
+static uint8x16_t
+check_block_neon(uint8x16_t input,
+                 uint8x16_t prev,
+                 uint8x16_t byte_1_high,
+                 uint8x16_t byte_1_low,
+                 uint8x16_t byte_2_high)
+{
+  uint8x16_t prev1 = vextq_u8(prev, input, 15);
+  uint8x16_t prev2 = vextq_u8(prev, input, 14);
+  uint8x16_t prev3 = vextq_u8(prev, input, 13);
+  uint8x16_t special, must_be_23;
+
+  special = vandq_u8(vandq_u8(vqtbl1q_u8(byte_1_high, vshrq_n_u8(prev1, 4)),
+                              vqtbl1q_u8(byte_1_low,
+                                         vandq_u8(prev1, vdupq_n_u8(0x0f)))),
+                     vqtbl1q_u8(byte_2_high, vshrq_n_u8(input, 4)));
+
+  must_be_23 = vorrq_u8(vqsubq_u8(prev2, vdupq_n_u8(0xe0 - 0x80)),
+                        vqsubq_u8(prev3, vdupq_n_u8(0xf0 - 0x80)));
+  must_be_23 = vandq_u8(must_be_23, vdupq_n_u8(0x80));
+
+  return veorq_u8(must_be_23, special);
+}
+
+/* NEON equivalent of valid_prefix_ssse3.
+ */
+static const char *
+valid_prefix_neon(const char *data, apr_size_t len)
+{
+  const uint8x16_t byte_1_high = vld1q_u8(byte_1_high_errors);
+  const uint8x16_t byte_1_low = vld1q_u8(byte_1_low_errors);
+  const uint8x16_t byte_2_high = vld1q_u8(byte_2_high_errors);
+  const char *p = data;
+  const char *end = data + len;
+  uint8x16_t prev = vdupq_n_u8(0);
+  svn_boolean_t prev_ascii = TRUE;
+
+  for (; end - p >= 16; p += 16)
+    {
+      uint8x16_t input = vld1q_u8((const uint8_t *)p);
+      svn_boolean_t ascii = vmaxvq_u8(input) < 0x80;
+
+      if (!ascii || !prev_ascii)
+        {
+          uint8x16_t error = check_block_neon(input, prev, byte_1_high,
+                                              byte_1_low, byte_2_high);
+          if (vmaxvq_u8(error))
+            break;
+        }
+
+      prev = input;
+      prev_ascii = ascii;
+    }
+
+  return clean_char_boundary(data, p);
+}
+
+#endif /* UTF_VALIDATE_NEON */
+
+/* Signature of the valid_prefix_* functions. */
+typedef const char *(*valid_prefix_func_t)(const char *data, apr_size_t len);
+
+/* The vectorized validator selected for the current CPU or NULL, plus
+ * its name.  Set by select_implementation. */
+static valid_prefix_func_t valid_prefix = NULL;
+static const char *valid_prefix_name = "scalar";
+
+/* Implements svn_atomic__str_init_func_t.
+ * Pick the fastest validator supported by the current CPU.
+ */
+static const char *
+select_implementation(void *baton)
+{
+#ifdef UTF_VALIDATE_X86
+  if (have_x86_avx2())
+    {
+      valid_prefix = valid_prefix_avx2;
+      valid_prefix_name = "AVX2";
+    }
+  else if (have_x86_ssse3())
+    {
+      valid_prefix = valid_prefix_ssse3;
+      valid_prefix_name = "SSSE3";
+    }
+#endif
+#ifdef UTF_VALIDATE_NEON
+  valid_prefix = valid_prefix_neon;
+  valid_prefix_name = "NEON";
+#endif
+
+  return NULL;
+}
+
+/* Make sure the validator has been selected.
+ */
+static void
+init_implementation(void)
+{
+  static volatile svn_atomic_t init_state = 0;
+  (void)svn_atomic__init_once_no_error(&init_state, select_implementation,
+                                       NULL);
+}
+
+const char *
+svn_utf__validator_implementation(void)
+{
+  init_implementation();
+  return valid_prefix_name;
+}
+
+/* Return the position in DATA of length LEN from which the FSM needs to
+ * take over.  All characters before it are valid and it is a character
+ * boundary.  Use the vectorized validator where available and worthwhile.
+ */
+static const char *
+skip_valid_prefix(const char *data, apr_size_t len)
+{
+  if (len >= SIMD_MIN_LEN)
+    {
+      init_implementation();
+      if (valid_prefix)
+        return valid_prefix(data, len);
+    }
+
+  return first_non_fsm_start_char(data, len);
+}
+
 const char *
 svn_utf__last_valid(const char *data, apr_size_t len)
 {
-  const char *start = first_non_fsm_start_char(data, len);
+  const char *start = skip_valid_prefix(data, len);
   const char *end = data + len;
   int state = FSM_START;
 
@@ -313,7 +768,7 @@ svn_utf__is_valid(const char *data, apr_size_t len)
   if (!data)
     return FALSE;
 
-  data = first_non_fsm_start_char(data, len);
+  data = skip_valid_prefix(data, len);
 
   while (data < end)
     {
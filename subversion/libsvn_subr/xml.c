@@ -36,6 +36,18 @@
 #include "private/svn_utf_private.h"
 #include "private/svn_subr_private.h"
 
+/* On x86-64, SSE2 is part of the base ISA and NEON is on AArch64.
+ * So, as for the EOL scanner, no runtime CPU detection is needed for
+ * the vectorized search for chars to escape.
+ */
+#if defined(__GNUC__) && defined(__SSE2__)
+#  define XML_SCAN_SSE2 1
+#  include <emmintrin.h>
+#elif defined(__GNUC__) && defined(__aarch64__) && defined(__ARM_NEON)
+#  define XML_SCAN_NEON 1
+#  include <arm_neon.h>
+#endif
+
 #ifdef SVN_HAVE_OLD_EXPAT
 #include <xmlparse.h>
 #else
@@ -132,6 +144,102 @@ svn_xml_is_xml_safe(const char *data, apr_size_t len)
 
 /*** XML escaping. ***/
 
+/* Flags in xml_specials telling which escaping functions replace a char
+   by an entity reference. */
+#define XML_SPECIAL_CDATA 1
+#define XML_SPECIAL_ATTR  2
+
+/* The chars with XML_SPECIAL_CDATA resp. XML_SPECIAL_ATTR set below. */
+static const char cdata_specials[] = "&<>\r";
+static const char attr_specials[] = "&<>\"'\r\n\t";
+
+/* XML_SPECIAL_* flags for each char. */
+static const unsigned char xml_specials[256] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 0, 0, 3, 0, 0, /* 0x00 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 2, 0, 0, 0, 3, 2, 0, 0, 0, 0, 0, 0, 0, 0, /* 0x20 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 3, 0, 3, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0x40 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0x60 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0x80 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0xa0 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0xc0 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0xe0 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+/* Return the first char in [P, END) that has the XML_SPECIAL_* flag KIND
+ * set, or END if there is none.  Most strings need no escaping at all,
+ * so make that case fast.
+ */
+static APR_INLINE const char *
+find_special(const char *p, const char *end, int kind)
+{
+#if defined(XML_SCAN_SSE2) || defined(XML_SCAN_NEON)
+  const char *specials = kind == XML_SPECIAL_CDATA ? cdata_specials
+                                                   : attr_specials;
+  const int count = kind == XML_SPECIAL_CDATA ? sizeof(cdata_specials) - 1
+                                              : sizeof(attr_specials) - 1;
+  int i;
+#endif
+
+#if defined(XML_SCAN_SSE2)
+
+  __m128i needles[sizeof(attr_specials) - 1];
+  for (i = 0; i < count; ++i)
+    needles[i] = _mm_set1_epi8(specials[i]);
+
+  for (; end - p >= 16; p += 16)
+    {
+      __m128i chunk = _mm_loadu_si128((const __m128i *)p);
+      __m128i hits = _mm_cmpeq_epi8(chunk, needles[0]);
+      unsigned int mask;
+
+      for (i = 1; i < count; ++i)
+        hits = _mm_or_si128(hits, _mm_cmpeq_epi8(chunk, needles[i]));
+
+      mask = (unsigned int)_mm_movemask_epi8(hits);
+      if (mask)
+        return p + __builtin_ctz(mask);
+    }
+
+#elif defined(XML_SCAN_NEON)
+
+  uint8x16_t needles[sizeof(attr_specials) - 1];
+  for (i = 0; i < count; ++i)
+    needles[i] = vdupq_n_u8((uint8_t)specials[i]);
+
+  for (; end - p >= 16; p += 16)
+    {
+      uint8x16_t chunk = vld1q_u8((const uint8_t *)p);
+      uint8x16_t hits = vceqq_u8(chunk, needles[0]);
+      apr_uint64_t mask;
+
+      for (i = 1; i < count; ++i)
+        hits = vorrq_u8(hits, vceqq_u8(chunk, needles[i]));
+
+      /* 4 bits per byte, see match_mask_neon() in eol.c. */
+      mask = vget_lane_u64(vreinterpret_u64_u8(
+                             vshrn_n_u16(vreinterpretq_u16_u8(hits), 4)),
+                           0);
+      if (mask)
+        return p + (__builtin_ctzll(mask) >> 2);
+    }
+
+#endif
+
+  /* The remaining odd bytes will be examined the naive way: */
+  while (p < end && !(xml_specials[(unsigned char)*p] & kind))
+    p++;
+
+  return p;
+}
+
 /* ### ...?
  *
  * If *OUTSTR is @c NULL, set *OUTSTR to a new stringbuf allocated
@@ -146,24 +254,33 @@ xml_escape_cdata(svn_stringbuf_t **outstr,
   const char *end = data + len;
   const char *p = data, *q;
 
+  /* Find the first character which needs to be quoted.  Strictly
+     speaking, '>' only needs to be quoted if it follows "]]", but it's
+     easier to quote it all the time.
+
+     So, why are we escaping '\r' here?  Well, according to the
+     XML spec, '\r\n' gets converted to '\n' during XML parsing.
+     Also, any '\r' not followed by '\n' is converted to '\n'.  By
+     golly, if we say we want to escape a '\r', we want to make
+     sure it remains a '\r'!  */
+  q = find_special(p, end, XML_SPECIAL_CDATA);
+
+  /* We may already be a winner. */
+  if (q == end)
+    {
+      if (*outstr == NULL)
+        *outstr = svn_stringbuf_ncreate(data, len, pool);
+      else
+        svn_stringbuf_appendbytes(*outstr, data, len);
+      return;
+    }
+
   if (*outstr == NULL)
-    *outstr = svn_stringbuf_create_empty(pool);
+    *outstr = svn_stringbuf_create_ensure(len + 8, pool);
 
   while (1)
     {
-      /* Find a character which needs to be quoted and append bytes up
-         to that point.  Strictly speaking, '>' only needs to be
-         quoted if it follows "]]", but it's easier to quote it all
-         the time.
-
-         So, why are we escaping '\r' here?  Well, according to the
-         XML spec, '\r\n' gets converted to '\n' during XML parsing.
-         Also, any '\r' not followed by '\n' is converted to '\n'.  By
-         golly, if we say we want to escape a '\r', we want to make
-         sure it remains a '\r'!  */
-      q = p;
-      while (q < end && *q != '&' && *q != '<' && *q != '>' && *q != '\r')
-        q++;
+      /* Append bytes up to the character that needs to be quoted. */
       svn_stringbuf_appendbytes(*outstr, p, q - p);
 
       /* We may already be a winner.  */
@@ -181,6 +298,7 @@ xml_escape_cdata(svn_stringbuf_t **outstr,
         svn_stringbuf_appendcstr(*outstr, "&#13;");
 
       p = q + 1;
+      q = find_special(p, end, XML_SPECIAL_CDATA);
     }
 }
 
@@ -195,18 +313,25 @@ xml_escape_attr(svn_stringbuf_t **outstr,
   const char *end = data + len;
   const char *p = data, *q;
 
+  /* Find the first character which needs to be quoted. */
+  q = find_special(p, end, XML_SPECIAL_ATTR);
+
+  /* We may already be a winner. */
+  if (q == end)
+    {
+      if (*outstr == NULL)
+        *outstr = svn_stringbuf_ncreate(data, len, pool);
+      else
+        svn_stringbuf_appendbytes(*outstr, data, len);
+      return;
+    }
+
   if (*outstr == NULL)
-    *outstr = svn_stringbuf_create_ensure(len, pool);
+    *outstr = svn_stringbuf_create_ensure(len + 8, pool);
 
   while (1)
     {
-      /* Find a character which needs to be quoted and append bytes up
-         to that point. */
-      q = p;
-      while (q < end && *q != '&' && *q != '<' && *q != '>'
-             && *q != '"' && *q != '\'' && *q != '\r'
-             && *q != '\n' && *q != '\t')
-        q++;
+      /* Append bytes up to the character that needs to be quoted. */
       svn_stringbuf_appendbytes(*outstr, p, q - p);
 
       /* We may already be a winner.  */
@@ -232,6 +357,7 @@ xml_escape_attr(svn_stringbuf_t **outstr,
         svn_stringbuf_appendcstr(*outstr, "&#9;");
 
       p = q + 1;
+      q = find_special(p, end, XML_SPECIAL_ATTR);
     }
 }
 
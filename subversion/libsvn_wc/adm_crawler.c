@@ -233,6 +233,10 @@ restore_node(svn_wc__db_t *db,
    relative path, the repository root and depth stored on the directory,
    passed here to avoid another database query.
 
+   If BASE_TREE is not NULL, it maps directory paths to their BASE children
+   as returned by svn_wc__db_base_get_descendants_info(); directories not
+   in it are read from the database.
+
    DEPTH_COMPATIBILITY_TRICK means the same thing here as it does
    in svn_wc_crawl_revisions5().
 
@@ -248,6 +252,7 @@ report_revisions_and_depths(svn_wc__db_t *db,
                             const char *dir_repos_relpath,
                             const char *dir_repos_root,
                             svn_depth_t dir_depth,
+                            apr_hash_t *base_tree,
                             const svn_ra_reporter3_t *reporter,
                             void *report_baton,
                             svn_boolean_t restore_files,
@@ -272,8 +277,11 @@ report_revisions_and_depths(svn_wc__db_t *db,
   /* Get both the SVN Entries and the actual on-disk entries.   Also
      notice that we're picking up hidden entries too (read_children never
      hides children). */
-  SVN_ERR(svn_wc__db_base_get_children_info(&base_children, db, dir_abspath,
-                                            scratch_pool, iterpool));
+  base_children = base_tree ? svn_hash_gets(base_tree, dir_abspath) : NULL;
+  if (!base_children)
+    SVN_ERR(svn_wc__db_base_get_children_info(&base_children, db,
+                                              dir_abspath,
+                                              scratch_pool, iterpool));
 
   if (restore_files)
     {
@@ -605,6 +613,7 @@ report_revisions_and_depths(svn_wc__db_t *db,
                                                   repos_relpath,
                                                   dir_repos_root,
                                                   ths->depth,
+                                                  base_tree,
                                                   reporter, report_baton,
                                                   restore_files, depth,
                                                   honor_depth_exclude,
@@ -771,6 +780,21 @@ svn_wc_crawl_revisions5(svn_wc_context_t *wc_ctx,
     {
       if (depth != svn_depth_empty)
         {
+          apr_hash_t *base_tree = NULL;
+
+          /* Read the BASE nodes of the whole tree with a single query
+             instead of one per directory. */
+          if (SVN_DEPTH_IS_RECURSIVE(depth))
+            {
+              err = svn_wc__db_base_get_descendants_info(&base_tree,
+                                                         wc_ctx->db,
+                                                         local_abspath,
+                                                         scratch_pool,
+                                                         scratch_pool);
+              if (err)
+                goto abort_report;
+            }
+
           /* Recursively crawl ROOT_DIRECTORY and report differing
              revisions. */
           err = report_revisions_and_depths(wc_ctx->db,
@@ -780,6 +804,7 @@ svn_wc_crawl_revisions5(svn_wc_context_t *wc_ctx,
                                             repos_relpath,
                                             repos_root_url,
                                             report_depth,
+                                            base_tree,
                                             reporter, report_baton,
                                             restore_files, depth,
                                             honor_depth_exclude,
@@ -1205,6 +1230,190 @@ svn_wc_transmit_text_deltas3(const svn_checksum_t **new_text_base_md5_checksum,
                                                scratch_pool);
 }
 
+struct svn_wc__text_delta_t
+{
+  /* The working file. */
+  const char *local_abspath;
+
+  /* The source and target of the delta, as in
+     svn_wc__internal_transmit_text_deltas(), and their checksums. */
+  svn_stream_t *base_stream;
+  svn_stream_t *local_stream;
+  const svn_checksum_t *expected_md5_checksum;
+  svn_checksum_t *verify_checksum;
+  svn_checksum_t *local_md5_checksum;
+  svn_checksum_t *local_sha1_checksum;
+
+  /* The new pristine text, written while reading LOCAL_STREAM. */
+  svn_wc__db_install_data_t *install_data;
+
+  /* The delta in svndiff format, once it is computed. */
+  const char *svndiff_abspath;
+
+  /* The pool everything above is allocated in. */
+  apr_pool_t *pool;
+};
+
+svn_error_t *
+svn_wc__prepare_text_delta(svn_wc__text_delta_t **delta_p,
+                           svn_wc_context_t *wc_ctx,
+                           const char *local_abspath,
+                           svn_boolean_t fulltext,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool)
+{
+  svn_wc__text_delta_t *delta = apr_pcalloc(result_pool, sizeof(*delta));
+  svn_stream_t *new_pristine_stream;
+
+  delta->local_abspath = apr_pstrdup(result_pool, local_abspath);
+  delta->pool = result_pool;
+
+  SVN_ERR(svn_wc__internal_translated_stream(&delta->local_stream,
+                                             wc_ctx->db,
+                                             local_abspath, local_abspath,
+                                             SVN_WC_TRANSLATE_TO_NF,
+                                             result_pool, scratch_pool));
+
+  SVN_ERR(svn_wc__db_pristine_prepare_install(&new_pristine_stream,
+                                              &delta->install_data,
+                                              &delta->local_sha1_checksum,
+                                              NULL, wc_ctx->db, local_abspath,
+                                              result_pool, scratch_pool));
+  delta->local_stream = copying_stream(delta->local_stream,
+                                       new_pristine_stream, result_pool);
+
+  if (! fulltext)
+    SVN_ERR(read_and_checksum_pristine_text(&delta->base_stream,
+                                            &delta->expected_md5_checksum,
+                                            &delta->verify_checksum,
+                                            wc_ctx->db, local_abspath,
+                                            result_pool, scratch_pool));
+  else
+    delta->base_stream = svn_stream_empty(result_pool);
+
+  *delta_p = delta;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__compute_text_delta(svn_wc__text_delta_t *delta,
+                           apr_pool_t *scratch_pool)
+{
+  svn_txdelta_window_handler_t handler;
+  void *wh_baton;
+  svn_stream_t *svndiff_stream;
+  svn_error_t *err;
+  svn_error_t *err2;
+
+  /* The delta is only kept until it is sent, so don't compress it. */
+  SVN_ERR(svn_stream_open_unique(&svndiff_stream, &delta->svndiff_abspath,
+                                 NULL, svn_io_file_del_on_pool_cleanup,
+                                 delta->pool, scratch_pool));
+  svn_txdelta_to_svndiff3(&handler, &wh_baton, svndiff_stream, 0,
+                          SVN_DELTA_COMPRESSION_LEVEL_NONE, scratch_pool);
+
+  err = svn_txdelta_run(delta->base_stream, delta->local_stream,
+                        handler, wh_baton,
+                        svn_checksum_md5, &delta->local_md5_checksum,
+                        NULL, NULL,
+                        delta->pool, scratch_pool);
+
+  /* Close the two streams to force writing the digest */
+  err2 = svn_stream_close(delta->base_stream);
+  if (err2)
+    {
+      delta->verify_checksum = NULL;
+      err = svn_error_compose_create(err, err2);
+    }
+
+  err = svn_error_compose_create(err, svn_stream_close(delta->local_stream));
+
+  /* A corrupt text base is an error here as well, see
+     svn_wc__internal_transmit_text_deltas(). */
+  if (delta->expected_md5_checksum && delta->verify_checksum
+      && !svn_checksum_match(delta->expected_md5_checksum,
+                             delta->verify_checksum))
+    {
+      err = svn_error_compose_create(
+              svn_checksum_mismatch_err(delta->expected_md5_checksum,
+                                        delta->verify_checksum,
+                                        scratch_pool,
+                            _("Checksum mismatch for text base of '%s'"),
+                            svn_dirent_local_style(delta->local_abspath,
+                                                   scratch_pool)),
+              err);
+
+      return svn_error_create(SVN_ERR_WC_CORRUPT_TEXT_BASE, err, NULL);
+    }
+
+  SVN_ERR_W(err, apr_psprintf(scratch_pool,
+                              _("While preparing '%s' for commit"),
+                              svn_dirent_local_style(delta->local_abspath,
+                                                     scratch_pool)));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__send_text_delta(const svn_checksum_t **new_text_base_md5_checksum,
+                        const svn_checksum_t **new_text_base_sha1_checksum,
+                        svn_wc__text_delta_t *delta,
+                        const svn_delta_editor_t *editor,
+                        void *file_baton,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool)
+{
+  svn_txdelta_window_handler_t handler;
+  void *wh_baton;
+  const char *base_digest_hex = NULL;
+  svn_stream_t *svndiff_stream;
+  svn_error_t *err;
+
+  if (delta->expected_md5_checksum)
+    base_digest_hex = svn_checksum_to_cstring_display(
+                                            delta->expected_md5_checksum,
+                                            scratch_pool);
+
+  SVN_ERR(editor->apply_textdelta(file_baton, base_digest_hex, scratch_pool,
+                                  &handler, &wh_baton));
+
+  /* Throw the windows we computed at the handler. */
+  err = svn_stream_open_readonly(&svndiff_stream, delta->svndiff_abspath,
+                                 scratch_pool, scratch_pool);
+  if (!err)
+    err = svn_stream_copy3(svndiff_stream,
+                           svn_txdelta_parse_svndiff(handler, wh_baton, TRUE,
+                                                     scratch_pool),
+                           NULL, NULL, scratch_pool);
+
+  SVN_ERR_W(err, apr_psprintf(scratch_pool,
+                              _("While preparing '%s' for commit"),
+                              svn_dirent_local_style(delta->local_abspath,
+                                                     scratch_pool)));
+
+  if (new_text_base_md5_checksum)
+    *new_text_base_md5_checksum = svn_checksum_dup(delta->local_md5_checksum,
+                                                   result_pool);
+
+  SVN_ERR(svn_wc__db_pristine_install(delta->install_data,
+                                      delta->local_sha1_checksum,
+                                      delta->local_md5_checksum,
+                                      scratch_pool));
+  if (new_text_base_sha1_checksum)
+    *new_text_base_sha1_checksum = svn_checksum_dup(
+                                            delta->local_sha1_checksum,
+                                            result_pool);
+
+  /* Close the file baton, and get outta here. */
+  return svn_error_trace(
+             editor->close_file(file_baton,
+                                svn_checksum_to_cstring(
+                                            delta->local_md5_checksum,
+                                            scratch_pool),
+                                scratch_pool));
+}
+
 svn_error_t *
 svn_wc__internal_transmit_prop_deltas(svn_wc__db_t *db,
                                      const char *local_abspath,
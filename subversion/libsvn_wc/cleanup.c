@@ -30,12 +30,14 @@
 #include "svn_pools.h"
 #include "svn_io.h"
 #include "svn_dirent_uri.h"
+#include "svn_hash.h"
 
 #include "wc.h"
 #include "adm_files.h"
 #include "lock.h"
 #include "workqueue.h"
 
+#include "private/svn_io_private.h"
 #include "private/svn_wc_private.h"
 #include "svn_private_config.h"
 
@@ -67,13 +69,95 @@ can_be_cleaned(int *wc_format,
   return SVN_NO_ERROR;
 }
 
-/* Dummy svn_wc_status_func4_t implementation */
+/* Repair the recorded timestamps and sizes of the unmodified files in
+   DIR_ABSPATH and below, if their recorded info doesn't match what is
+   on disk.  Directories are read from disk and compared against their
+   pristine texts in bulk, and the results are recorded in one
+   transaction per directory. */
 static svn_error_t *
-status_dummy_callback(void *baton,
-                      const char *local_abspath,
-                      const svn_wc_status3_t *status,
-                      apr_pool_t *scratch_pool)
+fix_recorded_info(svn_wc__db_t *db,
+                  const char *dir_abspath,
+                  svn_cancel_func_t cancel_func,
+                  void *cancel_baton,
+                  apr_pool_t *scratch_pool)
 {
+  apr_hash_t *children, *conflicts, *dirents, *modified;
+  apr_hash_index_t *hi;
+  apr_pool_t *iterpool;
+  svn_error_t *err;
+
+  if (cancel_func)
+    SVN_ERR(cancel_func(cancel_baton));
+
+  err = svn_io_get_dirents3(&dirents, dir_abspath, FALSE,
+                            scratch_pool, scratch_pool);
+  if (err && (APR_STATUS_IS_ENOENT(err->apr_err)
+              || SVN__APR_STATUS_IS_ENOTDIR(err->apr_err)))
+    {
+      /* Nothing on disk, so nothing to repair. */
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  SVN_ERR(svn_wc__db_read_children_info(&children, &conflicts,
+                                        db, dir_abspath, FALSE,
+                                        scratch_pool, scratch_pool));
+
+  SVN_ERR(svn_wc__internal_children_modified(&modified, db, dir_abspath,
+                                             children, dirents, FALSE,
+                                             cancel_func, cancel_baton,
+                                             scratch_pool, scratch_pool));
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (hi = apr_hash_first(scratch_pool, children);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      const char *name = apr_hash_this_key(hi);
+      const struct svn_wc__db_info_t *info = apr_hash_this_val(hi);
+      const svn_io_dirent2_t *dirent = svn_hash_gets(dirents, name);
+      const char *child_abspath;
+
+      svn_pool_clear(iterpool);
+
+      if (!dirent
+          || (info->status != svn_wc__db_status_normal
+              && info->status != svn_wc__db_status_added
+              && info->status != svn_wc__db_status_incomplete))
+        continue;
+
+      child_abspath = svn_dirent_join(dir_abspath, name, iterpool);
+
+      if (info->kind == svn_node_file && dirent->kind == svn_node_file)
+        {
+          svn_boolean_t file_modified;
+
+          if (svn_hash_gets(modified, name)
+              || (info->recorded_size == dirent->filesize
+                  && info->recorded_time == dirent->mtime))
+            continue;
+
+          /* Whatever couldn't be done in bulk; this records the file info
+             as a side effect. */
+          SVN_ERR(svn_wc__internal_file_modified_p(&file_modified, db,
+                                                   child_abspath, FALSE,
+                                                   iterpool));
+        }
+      else if (info->kind == svn_node_dir && dirent->kind == svn_node_dir)
+        {
+          svn_boolean_t is_wcroot;
+
+          /* Leave obstructing working copies alone. */
+          SVN_ERR(svn_wc__db_is_wcroot(&is_wcroot, db, child_abspath,
+                                       iterpool));
+          if (!is_wcroot)
+            SVN_ERR(fix_recorded_info(db, child_abspath,
+                                      cancel_func, cancel_baton, iterpool));
+        }
+    }
+  svn_pool_destroy(iterpool);
+
   return SVN_NO_ERROR;
 }
 
@@ -132,19 +216,8 @@ cleanup_internal(svn_wc__db_t *db,
     }
 
   if (fix_recorded_timestamps)
-    {
-      /* Instead of implementing a separate repair step here, use the standard
-         status walker's optimized implementation, which performs repairs when
-         there is a lock. */
-      SVN_ERR(svn_wc__internal_walk_status(db, dir_abspath, svn_depth_infinity,
-                                           FALSE /* get_all */,
-                                           FALSE /* no_ignore */,
-                                           FALSE /* ignore_text_mods */,
-                                           NULL /* ignore patterns */,
-                                           status_dummy_callback, NULL,
-                                           cancel_func, cancel_baton,
-                                           scratch_pool));
-    }
+    SVN_ERR(fix_recorded_info(db, dir_abspath, cancel_func, cancel_baton,
+                              scratch_pool));
 
   /* All done, toss the lock */
   SVN_ERR(svn_wc__db_wclock_release(db, dir_abspath, scratch_pool));
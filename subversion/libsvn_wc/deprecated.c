@@ -3569,6 +3569,7 @@ svn_wc_get_update_editor4(const svn_delta_editor_t **editor,
                               adds_as_modification,
                               server_performs_filtering,
                               clean_checkout,
+                              FALSE /* lazy_files */,
                               diff3_cmd,
                               preserved_exts,
                               fetch_dirents_func, fetch_dirents_baton,
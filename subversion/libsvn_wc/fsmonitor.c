@@ -0,0 +1,376 @@
+/*
+ * fsmonitor.c :  asking a filesystem monitor which directories changed
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include <apr_pools.h>
+#include <apr_hash.h>
+#include <apr_thread_proc.h>
+
+#include "svn_config.h"
+#include "svn_dirent_uri.h"
+#include "svn_hash.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+#include "svn_string.h"
+#include "svn_utf.h"
+
+#include "wc.h"
+#include "adm_files.h"
+#include "fsmonitor.h"
+
+#include "svn_private_config.h"
+
+
+/* Name of the file in the administrative area holding the token and the
+   dirty directories. */
+#define FSMONITOR_STATE "fsmonitor"
+
+struct svn_wc__fsmonitor_t
+{
+  /* The root of the working copy. */
+  const char *wcroot_abspath;
+
+  /* The token the monitor gave us for the current point in time. */
+  const char *token;
+
+  /* The directories that must be read from disk, as a set of absolute
+     paths, or NULL if all of them must be read. */
+  apr_hash_t *changed_dirs;
+
+  /* The directories found to be dirty during this walk, as a set of
+     absolute paths. */
+  apr_hash_t *dirty_dirs;
+
+  /* Pool for DIRTY_DIRS. */
+  apr_pool_t *pool;
+};
+
+/* Split TEXT into lines, dropping empty lines and trailing CRs. */
+static apr_array_header_t *
+split_lines(const char *text,
+            apr_pool_t *result_pool)
+{
+  apr_array_header_t *lines = svn_cstring_split(text, "\n", FALSE,
+                                                result_pool);
+  int i;
+
+  for (i = 0; i < lines->nelts; i++)
+    {
+      char *line = APR_ARRAY_IDX(lines, i, char *);
+      apr_size_t len = strlen(line);
+
+      if (len && line[len - 1] == '\r')
+        line[len - 1] = '\0';
+    }
+
+  return lines;
+}
+
+/* Read the token and the dirty directories stored for WCROOT_ABSPATH into
+   *TOKEN and the set of absolute paths DIRS.  Set *TOKEN to NULL if there
+   is no stored state. */
+static svn_error_t *
+read_state(const char **token,
+           apr_hash_t *dirs,
+           const char *wcroot_abspath,
+           apr_pool_t *result_pool,
+           apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *contents;
+  apr_array_header_t *lines;
+  svn_error_t *err;
+  int i;
+
+  *token = NULL;
+
+  err = svn_stringbuf_from_file2(&contents,
+                                 svn_wc__adm_child(wcroot_abspath,
+                                                   FSMONITOR_STATE,
+                                                   scratch_pool),
+                                 scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  lines = split_lines(contents->data, scratch_pool);
+  if (lines->nelts == 0)
+    return SVN_NO_ERROR;
+
+  *token = apr_pstrdup(result_pool, APR_ARRAY_IDX(lines, 0, const char *));
+  for (i = 1; i < lines->nelts; i++)
+    {
+      const char *relpath = APR_ARRAY_IDX(lines, i, const char *);
+
+      if (strcmp(relpath, ".") == 0)
+        relpath = "";
+
+      svn_hash_sets(dirs, svn_dirent_join(wcroot_abspath, relpath,
+                                          result_pool), "");
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Run the filesystem monitor COMMAND for WCROOT_ABSPATH and TOKEN, which
+   may be NULL, and return its standard output in *OUTPUT. */
+static svn_error_t *
+run_monitor(const char **output,
+            const char *command,
+            const char *wcroot_abspath,
+            const char *token,
+            apr_pool_t *result_pool,
+            apr_pool_t *scratch_pool)
+{
+  const char *args[4];
+  apr_proc_t cmd_proc = {0};
+  apr_pool_t *cmd_pool = svn_pool_create(scratch_pool);
+  svn_stringbuf_t *native_output = NULL;
+  int exitcode;
+  apr_exit_why_e exitwhy;
+  svn_error_t *err;
+
+  args[0] = command;
+  args[1] = svn_dirent_local_style(wcroot_abspath, scratch_pool);
+  args[2] = token ? token : "";
+  args[3] = NULL;
+
+  SVN_ERR(svn_io_start_cmd3(&cmd_proc, wcroot_abspath, command, args,
+                            NULL, TRUE, FALSE, NULL, TRUE, NULL,
+                            FALSE, NULL, cmd_pool));
+
+  err = svn_stringbuf_from_aprfile(&native_output, cmd_proc.out,
+                                   scratch_pool);
+  err = svn_error_compose_create(
+          err,
+          svn_io_wait_for_cmd(&cmd_proc, command, &exitcode, &exitwhy,
+                              scratch_pool));
+
+  /* Close the pipe. */
+  svn_pool_destroy(cmd_pool);
+  SVN_ERR(err);
+
+  if (!APR_PROC_CHECK_EXIT(exitwhy) || exitcode != 0)
+    return svn_error_createf(SVN_ERR_EXTERNAL_PROGRAM, NULL,
+                             _("Filesystem monitor '%s' failed "
+                               "(exit code %d)"),
+                             command, exitcode);
+
+  return svn_error_trace(svn_utf_cstring_to_utf8(output,
+                                                 native_output->data,
+                                                 result_pool));
+}
+
+svn_error_t *
+svn_wc__fsmonitor_open(svn_wc__fsmonitor_t **monitor,
+                       svn_wc__db_t *db,
+                       const char *local_abspath,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool)
+{
+  svn_wc__fsmonitor_t *result;
+  const char *command;
+  const char *old_token;
+  const char *output;
+  apr_array_header_t *lines;
+  svn_error_t *err;
+  int i;
+
+  *monitor = NULL;
+
+  svn_config_get(svn_wc__db_get_config(db), &command,
+                 SVN_CONFIG_SECTION_WORKING_COPY,
+                 SVN_CONFIG_OPTION_FSMONITOR_COMMAND, NULL);
+  if (!command || !*command)
+    return SVN_NO_ERROR;
+
+  result = apr_pcalloc(result_pool, sizeof(*result));
+  result->pool = result_pool;
+  result->changed_dirs = apr_hash_make(result_pool);
+  result->dirty_dirs = apr_hash_make(result_pool);
+  SVN_ERR(svn_wc__db_get_wcroot(&result->wcroot_abspath, db, local_abspath,
+                                result_pool, scratch_pool));
+
+  SVN_ERR(read_state(&old_token, result->changed_dirs,
+                     result->wcroot_abspath, result_pool, scratch_pool));
+
+  /* The monitor only saves us some work, so don't fail just because it
+     does. */
+  err = run_monitor(&output, command, result->wcroot_abspath, old_token,
+                    scratch_pool, scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  lines = split_lines(output, scratch_pool);
+  if (lines->nelts == 0)
+    return SVN_NO_ERROR;
+
+  result->token = apr_pstrdup(result_pool,
+                              APR_ARRAY_IDX(lines, 0, const char *));
+  if (!old_token)
+    result->changed_dirs = NULL;
+
+  for (i = 1; i < lines->nelts && result->changed_dirs; i++)
+    {
+      const char *relpath = APR_ARRAY_IDX(lines, i, const char *);
+      const char *abspath;
+
+      if (strcmp(relpath, "/") == 0)
+        {
+          result->changed_dirs = NULL;
+          break;
+        }
+
+      abspath = svn_dirent_join(result->wcroot_abspath,
+                                svn_dirent_internal_style(relpath,
+                                                          scratch_pool),
+                                result_pool);
+
+      /* A changed node changes the entries of its parent and, if it is a
+         directory that has just been created, its own ones. */
+      svn_hash_sets(result->changed_dirs, abspath, "");
+      svn_hash_sets(result->changed_dirs,
+                    svn_dirent_dirname(abspath, result_pool), "");
+    }
+
+  *monitor = result;
+
+  return SVN_NO_ERROR;
+}
+
+svn_boolean_t
+svn_wc__fsmonitor_dir_changed(const svn_wc__fsmonitor_t *monitor,
+                              const char *dir_abspath)
+{
+  return (monitor->changed_dirs == NULL
+          || svn_hash_gets(monitor->changed_dirs, dir_abspath) != NULL);
+}
+
+void
+svn_wc__fsmonitor_mark_dirty(svn_wc__fsmonitor_t *monitor,
+                             const char *dir_abspath)
+{
+  if (!svn_hash_gets(monitor->dirty_dirs, dir_abspath))
+    svn_hash_sets(monitor->dirty_dirs,
+                  apr_pstrdup(monitor->pool, dir_abspath), "");
+}
+
+svn_error_t *
+svn_wc__fsmonitor_save(const svn_wc__fsmonitor_t *monitor,
+                       const char *walk_root_abspath,
+                       apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *contents;
+  apr_hash_index_t *hi;
+
+  if (strcmp(walk_root_abspath, monitor->wcroot_abspath) != 0)
+    return SVN_NO_ERROR;
+
+  contents = svn_stringbuf_createf(scratch_pool, "%s\n", monitor->token);
+  for (hi = apr_hash_first(scratch_pool, monitor->dirty_dirs);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      const char *relpath
+        = svn_dirent_skip_ancestor(monitor->wcroot_abspath,
+                                   apr_hash_this_key(hi));
+
+      if (relpath == NULL)
+        continue;
+
+      svn_stringbuf_appendcstr(contents, *relpath ? relpath : ".");
+      svn_stringbuf_appendbyte(contents, '\n');
+    }
+
+  return svn_error_trace(
+           svn_io_write_atomic2(svn_wc__adm_child(monitor->wcroot_abspath,
+                                                  FSMONITOR_STATE,
+                                                  scratch_pool),
+                                contents->data, contents->len,
+                                NULL, FALSE, scratch_pool));
+}
+
+svn_error_t *
+svn_wc__fsmonitor_changed_since(const char **new_token,
+                                svn_boolean_t *changed,
+                                svn_wc__db_t *db,
+                                const char *wcroot_abspath,
+                                const char *token,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool)
+{
+  const char *command;
+  const char *output;
+  const char *adm_dir = svn_wc_get_adm_dir(scratch_pool);
+  apr_array_header_t *lines;
+  svn_error_t *err;
+  int i;
+
+  *new_token = NULL;
+  *changed = TRUE;
+
+  svn_config_get(svn_wc__db_get_config(db), &command,
+                 SVN_CONFIG_SECTION_WORKING_COPY,
+                 SVN_CONFIG_OPTION_FSMONITOR_COMMAND, NULL);
+  if (!command || !*command)
+    return SVN_NO_ERROR;
+
+  err = run_monitor(&output, command, wcroot_abspath, token,
+                    scratch_pool, scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  lines = split_lines(output, scratch_pool);
+  if (lines->nelts == 0)
+    return SVN_NO_ERROR;
+
+  *new_token = apr_pstrdup(result_pool,
+                           APR_ARRAY_IDX(lines, 0, const char *));
+  if (!token)
+    return SVN_NO_ERROR;
+
+  /* Our own bookkeeping in the administrative area doesn't count. */
+  for (i = 1; i < lines->nelts; i++)
+    {
+      const char *relpath
+        = svn_dirent_internal_style(APR_ARRAY_IDX(lines, i, const char *),
+                                    scratch_pool);
+
+      if (   strcmp(relpath, adm_dir) != 0
+          && !svn_dirent_is_ancestor(adm_dir, relpath))
+        return SVN_NO_ERROR;
+    }
+
+  *changed = FALSE;
+
+  return SVN_NO_ERROR;
+}
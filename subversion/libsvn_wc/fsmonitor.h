@@ -0,0 +1,107 @@
+/*
+ * fsmonitor.h :  asking a filesystem monitor which directories changed
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+#ifndef SVN_LIBSVN_WC_FSMONITOR_H
+#define SVN_LIBSVN_WC_FSMONITOR_H
+
+#include <apr_pools.h>
+
+#include "svn_types.h"
+#include "svn_error.h"
+
+#include "wc_db.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+
+/* A filesystem monitor is an external program, configured with the
+   [working-copy] fsmonitor-command option, that keeps track of the paths
+   changed in a working copy, e.g. using inotify, FSEvents or
+   ReadDirectoryChangesW.
+
+   It gets called as "COMMAND WCROOT TOKEN", where TOKEN is the value it
+   printed on an earlier call or the empty string, and must print a new
+   token on the first line, followed by the paths relative to WCROOT that
+   may have changed since TOKEN, one per line.  A line containing just
+   "/" means that it can't tell.
+
+   The administrative area keeps the last token together with the list
+   of directories that were found to contain local modifications or
+   unversioned items at that time.  All other directories are unchanged
+   on disk until the monitor reports otherwise. */
+typedef struct svn_wc__fsmonitor_t svn_wc__fsmonitor_t;
+
+/* Ask the filesystem monitor configured in DB about the working copy that
+   contains the directory LOCAL_ABSPATH and return its answer in *MONITOR,
+   allocated in RESULT_POOL.  Set *MONITOR to NULL if no monitor is
+   configured or if it fails. */
+svn_error_t *
+svn_wc__fsmonitor_open(svn_wc__fsmonitor_t **monitor,
+                       svn_wc__db_t *db,
+                       const char *local_abspath,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool);
+
+/* Return TRUE if the entries of DIR_ABSPATH may differ from what the
+   working copy database says about them and must be read from disk. */
+svn_boolean_t
+svn_wc__fsmonitor_dir_changed(const svn_wc__fsmonitor_t *monitor,
+                              const char *dir_abspath);
+
+/* Record that DIR_ABSPATH contains local modifications or unversioned
+   items. */
+void
+svn_wc__fsmonitor_mark_dirty(svn_wc__fsmonitor_t *monitor,
+                             const char *dir_abspath);
+
+/* Store the state of MONITOR in the administrative area after a complete
+   walk of WALK_ROOT_ABSPATH, which must have marked every dirty directory.
+   Does nothing unless WALK_ROOT_ABSPATH is the working copy root. */
+svn_error_t *
+svn_wc__fsmonitor_save(const svn_wc__fsmonitor_t *monitor,
+                       const char *walk_root_abspath,
+                       apr_pool_t *scratch_pool);
+
+/* Ask the filesystem monitor configured in DB whether anything in the
+   working copy at WCROOT_ABSPATH, apart from its administrative area,
+   changed since TOKEN, which may be NULL.  Set *CHANGED accordingly and
+   return the monitor's current token in *NEW_TOKEN, allocated in
+   RESULT_POOL.  Set *NEW_TOKEN to NULL if no monitor is configured or if
+   it fails.  *CHANGED will be TRUE unless the monitor says otherwise. */
+svn_error_t *
+svn_wc__fsmonitor_changed_since(const char **new_token,
+                                svn_boolean_t *changed,
+                                svn_wc__db_t *db,
+                                const char *wcroot_abspath,
+                                const char *token,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_WC_FSMONITOR_H */
@@ -35,6 +35,7 @@
 #include "workqueue.h"
 
 #include "private/svn_skel.h"
+#include "private/svn_string_private.h"
 
 #include "svn_private_config.h"
 
@@ -79,6 +80,97 @@ get_prop(const apr_array_header_t *prop_diff,
 }
 
 
+/* Set *STYLE, *EOL, *KEYWORDS and *SPECIAL to the settings with which
+   detranslate_wc_file() below detranslates the target of MT, as explained
+   there.  Allocate the results in POOL. */
+static svn_error_t *
+get_detranslation_info(svn_subst_eol_style_t *style,
+                       const char **eol,
+                       apr_hash_t **keywords,
+                       svn_boolean_t *special,
+                       const merge_target_t *mt,
+                       apr_pool_t *pool)
+{
+  svn_boolean_t old_is_binary, new_is_binary;
+
+  {
+    const char *old_mime_value
+      = svn_prop_get_value(mt->old_actual_props, SVN_PROP_MIME_TYPE);
+    const svn_prop_t *prop = get_prop(mt->prop_diff, SVN_PROP_MIME_TYPE);
+    const char *new_mime_value
+      = prop ? (prop->value ? prop->value->data : NULL) : old_mime_value;
+
+    old_is_binary = old_mime_value && svn_mime_type_is_binary(old_mime_value);
+    new_is_binary = new_mime_value && svn_mime_type_is_binary(new_mime_value);
+  }
+
+  /* See what translations we want to do */
+  if (old_is_binary && new_is_binary)
+    {
+      /* Case IV. Old and new props 'binary': detranslate keywords only */
+      SVN_ERR(svn_wc__get_translate_info(NULL, NULL, keywords, NULL,
+                                         mt->db, mt->local_abspath,
+                                         mt->old_actual_props, TRUE,
+                                         pool, pool));
+      /* ### Why override 'special'? Elsewhere it has precedence. */
+      *special = FALSE;
+      *eol = NULL;
+      *style = svn_subst_eol_style_none;
+    }
+  else if (!old_is_binary && new_is_binary)
+    {
+      /* Case II. Old props indicate texty, new props indicate binary:
+         detranslate keywords and old eol-style */
+      SVN_ERR(svn_wc__get_translate_info(style, eol,
+                                         keywords,
+                                         special,
+                                         mt->db, mt->local_abspath,
+                                         mt->old_actual_props, TRUE,
+                                         pool, pool));
+    }
+  else
+    {
+      /* Case I & III. New props indicate texty, regardless of old props */
+
+      /* In case the file used to be special, detranslate specially */
+      SVN_ERR(svn_wc__get_translate_info(style, eol,
+                                         keywords,
+                                         special,
+                                         mt->db, mt->local_abspath,
+                                         mt->old_actual_props, TRUE,
+                                         pool, pool));
+
+      if (*special)
+        {
+          *keywords = NULL;
+          *eol = NULL;
+          *style = svn_subst_eol_style_none;
+        }
+      else
+        {
+          const svn_prop_t *prop;
+
+          /* In case a new eol style was set, use that for detranslation */
+          if ((prop = get_prop(mt->prop_diff, SVN_PROP_EOL_STYLE)) && prop->value)
+            {
+              /* Value added or changed */
+              svn_subst_eol_style_from_value(style, eol, prop->value->data);
+            }
+          else if (!old_is_binary)
+            {
+              /* Already fetched */
+            }
+          else
+            {
+              *eol = NULL;
+              *style = svn_subst_eol_style_none;
+            }
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Detranslate a working copy file MERGE_TARGET to achieve the effect of:
 
    1. Detranslate
@@ -166,86 +258,13 @@ detranslate_wc_file(const char **detranslated_abspath,
                     apr_pool_t *result_pool,
                     apr_pool_t *scratch_pool)
 {
-  svn_boolean_t old_is_binary, new_is_binary;
   svn_subst_eol_style_t style;
   const char *eol;
   apr_hash_t *keywords;
   svn_boolean_t special;
 
-  {
-    const char *old_mime_value
-      = svn_prop_get_value(mt->old_actual_props, SVN_PROP_MIME_TYPE);
-    const svn_prop_t *prop = get_prop(mt->prop_diff, SVN_PROP_MIME_TYPE);
-    const char *new_mime_value
-      = prop ? (prop->value ? prop->value->data : NULL) : old_mime_value;
-
-    old_is_binary = old_mime_value && svn_mime_type_is_binary(old_mime_value);
-    new_is_binary = new_mime_value && svn_mime_type_is_binary(new_mime_value);
-  }
-
-  /* See what translations we want to do */
-  if (old_is_binary && new_is_binary)
-    {
-      /* Case IV. Old and new props 'binary': detranslate keywords only */
-      SVN_ERR(svn_wc__get_translate_info(NULL, NULL, &keywords, NULL,
-                                         mt->db, mt->local_abspath,
-                                         mt->old_actual_props, TRUE,
-                                         scratch_pool, scratch_pool));
-      /* ### Why override 'special'? Elsewhere it has precedence. */
-      special = FALSE;
-      eol = NULL;
-      style = svn_subst_eol_style_none;
-    }
-  else if (!old_is_binary && new_is_binary)
-    {
-      /* Case II. Old props indicate texty, new props indicate binary:
-         detranslate keywords and old eol-style */
-      SVN_ERR(svn_wc__get_translate_info(&style, &eol,
-                                         &keywords,
-                                         &special,
-                                         mt->db, mt->local_abspath,
-                                         mt->old_actual_props, TRUE,
-                                         scratch_pool, scratch_pool));
-    }
-  else
-    {
-      /* Case I & III. New props indicate texty, regardless of old props */
-
-      /* In case the file used to be special, detranslate specially */
-      SVN_ERR(svn_wc__get_translate_info(&style, &eol,
-                                         &keywords,
-                                         &special,
-                                         mt->db, mt->local_abspath,
-                                         mt->old_actual_props, TRUE,
-                                         scratch_pool, scratch_pool));
-
-      if (special)
-        {
-          keywords = NULL;
-          eol = NULL;
-          style = svn_subst_eol_style_none;
-        }
-      else
-        {
-          const svn_prop_t *prop;
-
-          /* In case a new eol style was set, use that for detranslation */
-          if ((prop = get_prop(mt->prop_diff, SVN_PROP_EOL_STYLE)) && prop->value)
-            {
-              /* Value added or changed */
-              svn_subst_eol_style_from_value(&style, &eol, prop->value->data);
-            }
-          else if (!old_is_binary)
-            {
-              /* Already fetched */
-            }
-          else
-            {
-              eol = NULL;
-              style = svn_subst_eol_style_none;
-            }
-        }
-    }
+  SVN_ERR(get_detranslation_info(&style, &eol, &keywords, &special, mt,
+                                 scratch_pool));
 
   /* Now, detranslate with the settings we created above */
 
@@ -342,6 +361,127 @@ maybe_update_target_eols(const char **new_target_abspath,
   return SVN_NO_ERROR;
 }
 
+/* Text files no larger than this are merged in memory. */
+#define MERGE_IN_MEMORY_LIMIT (1024 * 1024)
+
+/* The texts of a merge in repository normal form, read into memory
+   instead of detranslating them into temporary files. */
+typedef struct merge_texts_t
+{
+  svn_string_t *left;
+  svn_string_t *target;
+  svn_string_t *right;
+
+  /* Whether LEFT differs from the left file because the eol-style changed,
+     see maybe_update_target_eols(). */
+  svn_boolean_t left_translated;
+} merge_texts_t;
+
+/* Set *CONTENTS to the contents of the file at LOCAL_ABSPATH of SIZE
+   bytes, read through TRANSLATE_EOL, KEYWORDS and REPAIR as with
+   svn_subst_stream_translated(), unless both are NULL.  Allocate the
+   result in RESULT_POOL. */
+static svn_error_t *
+read_translated(svn_string_t **contents,
+                const char *local_abspath,
+                svn_filesize_t size,
+                const char *translate_eol,
+                apr_hash_t *keywords,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  svn_stream_t *stream;
+  svn_stringbuf_t *buf;
+
+  SVN_ERR(svn_stream_open_readonly(&stream, local_abspath, scratch_pool,
+                                   scratch_pool));
+  if (translate_eol || keywords)
+    stream = svn_subst_stream_translated(stream, translate_eol,
+                                         TRUE /* repair */, keywords,
+                                         FALSE /* expand */, scratch_pool);
+
+  SVN_ERR(svn_stringbuf_from_stream(&buf, stream, (apr_size_t)size,
+                                    result_pool));
+  *contents = svn_stringbuf__morph_into_string(buf);
+
+  return svn_error_trace(svn_stream_close(stream));
+}
+
+/* Set *TEXTS to the LEFT_ABSPATH, RIGHT_ABSPATH and the target of MT in
+ * repository normal form, with LEFT_ABSPATH translated to the new
+ * eol-style like maybe_update_target_eols() and the target detranslated
+ * like detranslate_wc_file() would do.  Set *TEXTS to NULL if any of them
+ * is larger than MERGE_IN_MEMORY_LIMIT or if the target is not a normal
+ * file.
+ *
+ * Allocate the result in RESULT_POOL.
+ */
+static svn_error_t *
+read_merge_texts(merge_texts_t **texts,
+                 const merge_target_t *mt,
+                 const char *left_abspath,
+                 const char *right_abspath,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  const svn_io_dirent2_t *left_dirent, *right_dirent, *target_dirent;
+  svn_subst_eol_style_t style;
+  const char *eol;
+  apr_hash_t *keywords;
+  svn_boolean_t special;
+  const char *left_eol = NULL;
+  const svn_prop_t *prop;
+  merge_texts_t *result;
+
+  *texts = NULL;
+
+  SVN_ERR(svn_io_stat_dirent2(&target_dirent, mt->local_abspath, FALSE,
+                              TRUE, scratch_pool, scratch_pool));
+  if (target_dirent->kind != svn_node_file || target_dirent->special
+      || target_dirent->filesize > MERGE_IN_MEMORY_LIMIT)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_io_stat_dirent2(&left_dirent, left_abspath, FALSE, FALSE,
+                              scratch_pool, scratch_pool));
+  SVN_ERR(svn_io_stat_dirent2(&right_dirent, right_abspath, FALSE, FALSE,
+                              scratch_pool, scratch_pool));
+  if (left_dirent->filesize > MERGE_IN_MEMORY_LIMIT
+      || right_dirent->filesize > MERGE_IN_MEMORY_LIMIT)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(get_detranslation_info(&style, &eol, &keywords, &special, mt,
+                                 scratch_pool));
+
+  /* Special files are detranslated into their link text etc. */
+  if (special)
+    return SVN_NO_ERROR;
+
+  if (style == svn_subst_eol_style_native)
+    eol = SVN_SUBST_NATIVE_EOL_STR;
+  else if ((keywords || eol) && style != svn_subst_eol_style_fixed
+           && style != svn_subst_eol_style_none)
+    return svn_error_create(SVN_ERR_IO_UNKNOWN_EOL, NULL, NULL);
+
+  prop = get_prop(mt->prop_diff, SVN_PROP_EOL_STYLE);
+  if (prop && prop->value)
+    svn_subst_eol_style_from_value(NULL, &left_eol, prop->value->data);
+
+  result = apr_pcalloc(result_pool, sizeof(*result));
+  result->left_translated = (left_eol != NULL);
+  SVN_ERR(read_translated(&result->left, left_abspath, left_dirent->filesize,
+                          left_eol, NULL, result_pool, scratch_pool));
+  SVN_ERR(read_translated(&result->target, mt->local_abspath,
+                          target_dirent->filesize, eol, keywords,
+                          result_pool, scratch_pool));
+  SVN_ERR(read_translated(&result->right, right_abspath,
+                          right_dirent->filesize, NULL, NULL,
+                          result_pool, scratch_pool));
+
+  *texts = result;
+
+  return SVN_NO_ERROR;
+}
+
 
 /* Set *TARGET_MARKER, *LEFT_MARKER and *RIGHT_MARKER to strings suitable
    for delimiting the alternative texts in a text conflict.  Include in each
@@ -434,6 +574,57 @@ do_text_merge(svn_boolean_t *contains_conflicts,
   return SVN_NO_ERROR;
 }
 
+/* Same as do_text_merge() above, but merge the in-memory TEXTS. */
+static svn_error_t *
+do_text_merge_in_memory(svn_boolean_t *contains_conflicts,
+                        apr_file_t *result_f,
+                        const apr_array_header_t *merge_options,
+                        const merge_texts_t *texts,
+                        const char *target_label,
+                        const char *left_label,
+                        const char *right_label,
+                        svn_cancel_func_t cancel_func,
+                        void *cancel_baton,
+                        apr_pool_t *pool)
+{
+  svn_diff_t *diff;
+  svn_stream_t *ostream;
+  const char *target_marker;
+  const char *left_marker;
+  const char *right_marker;
+  svn_diff_file_options_t *diff3_options;
+
+  diff3_options = svn_diff_file_options_create(pool);
+
+  if (merge_options)
+    SVN_ERR(svn_diff_file_options_parse(diff3_options,
+                                        merge_options, pool));
+
+  init_conflict_markers(&target_marker, &left_marker, &right_marker,
+                        target_label, left_label, right_label, pool);
+
+  SVN_ERR(svn_diff_mem_string_diff3(&diff, texts->left, texts->target,
+                                    texts->right, diff3_options, pool));
+
+  ostream = svn_stream_from_aprfile2(result_f, TRUE, pool);
+
+  SVN_ERR(svn_diff_mem_string_output_merge3(ostream, diff,
+                                            texts->left, texts->target,
+                                            texts->right,
+                                            left_marker,
+                                            target_marker,
+                                            right_marker,
+                                            "=======", /* separator */
+                                            svn_diff_conflict_display_modified_original_latest,
+                                            cancel_func, cancel_baton,
+                                            pool));
+  SVN_ERR(svn_stream_close(ostream));
+
+  *contains_conflicts = svn_diff_contains_conflicts(diff);
+
+  return SVN_NO_ERROR;
+}
+
 /* Same as do_text_merge() above, but use the external diff3
  * command DIFF3_CMD to perform the merge.  Pass MERGE_OPTIONS
  * to the diff3 command.  Do all allocations in POOL. */
@@ -650,6 +841,8 @@ preserve_pre_merge_files(svn_skel_t **work_items,
  * 'detranslated' to repository normal form, or may be the target file
  * itself if no translation is necessary.
  *
+ * If TEXTS is not NULL, compare the in-memory texts instead of the files.
+ *
  * When this function updates the target file, it translates to working copy
  * form.
  *
@@ -665,6 +858,7 @@ merge_file_trivial(svn_skel_t **work_items,
                    const char *right_abspath,
                    const char *target_abspath,
                    const char *detranslated_target_abspath,
+                   const merge_texts_t *texts,
                    svn_boolean_t dry_run,
                    svn_wc__db_t *db,
                    svn_cancel_func_t cancel_func,
@@ -689,13 +883,20 @@ merge_file_trivial(svn_skel_t **work_items,
     }
 
   /* Check the files */
-  SVN_ERR(svn_io_files_contents_three_same_p(&same_left_right,
-                                             &same_right_target,
-                                             &same_left_target,
-                                             left_abspath,
-                                             right_abspath,
-                                             detranslated_target_abspath,
-                                             scratch_pool));
+  if (texts)
+    {
+      same_left_right = svn_string_compare(texts->left, texts->right);
+      same_right_target = svn_string_compare(texts->right, texts->target);
+      same_left_target = svn_string_compare(texts->left, texts->target);
+    }
+  else
+    SVN_ERR(svn_io_files_contents_three_same_p(&same_left_right,
+                                               &same_right_target,
+                                               &same_left_target,
+                                               left_abspath,
+                                               right_abspath,
+                                               detranslated_target_abspath,
+                                               scratch_pool));
 
   /* If the LEFT side of the merge is equal to WORKING, then we can
    * copy RIGHT directly. */
@@ -809,6 +1010,8 @@ merge_file_trivial(svn_skel_t **work_items,
  * and copies of the pre-merge files.  See preserve_pre_merge_files()
  * for details.
  *
+ * If TEXTS is not NULL, merge the in-memory TEXTS instead of the files.
+ *
  * On entry, all of the output pointers must be non-null and *CONFLICT_SKEL
  * must either point to an existing conflict skel or be NULL.
  */
@@ -824,6 +1027,7 @@ merge_text_file(svn_skel_t **work_items,
                 const char *target_label,
                 svn_boolean_t dry_run,
                 const char *detranslated_target_abspath,
+                const merge_texts_t *texts,
                 svn_cancel_func_t cancel_func,
                 void *cancel_baton,
                 apr_pool_t *result_pool,
@@ -864,6 +1068,16 @@ merge_text_file(svn_skel_t **work_items,
                                      left_label,
                                      right_label,
                                      pool));
+  else if (texts)
+    SVN_ERR(do_text_merge_in_memory(&contains_conflicts,
+                                    result_f,
+                                    mt->merge_options,
+                                    texts,
+                                    target_label,
+                                    left_label,
+                                    right_label,
+                                    cancel_func, cancel_baton,
+                                    pool));
   else /* Use internal merge. */
     SVN_ERR(do_text_merge(&contains_conflicts,
                           result_f,
@@ -888,6 +1102,14 @@ merge_text_file(svn_skel_t **work_items,
         {
           const char *left_copy, *right_copy, *target_copy;
 
+          /* The in-memory merge did not write out the translated left
+             file, but we preserve it like the file based merge does. */
+          if (texts && texts->left_translated)
+            SVN_ERR(maybe_update_target_eols(&left_abspath, mt->prop_diff,
+                                             left_abspath,
+                                             cancel_func, cancel_baton,
+                                             scratch_pool, scratch_pool));
+
           /* Preserve the three conflict files */
           SVN_ERR(preserve_pre_merge_files(
                     &work_item,
@@ -1101,6 +1323,7 @@ svn_wc__internal_merge(svn_skel_t **work_items,
   const svn_prop_t *mimeprop;
   svn_skel_t *work_item;
   merge_target_t mt;
+  merge_texts_t *texts = NULL;
 
   SVN_ERR_ASSERT(svn_dirent_is_absolute(left_abspath));
   SVN_ERR_ASSERT(svn_dirent_is_absolute(right_abspath));
@@ -1129,23 +1352,37 @@ svn_wc__internal_merge(svn_skel_t **work_items,
       is_binary = value && svn_mime_type_is_binary(value);
     }
 
-  SVN_ERR(detranslate_wc_file(&detranslated_target_abspath, &mt,
-                              (! is_binary) && diff3_cmd != NULL,
-                              target_abspath,
-                              cancel_func, cancel_baton,
-                              scratch_pool, scratch_pool));
+  /* Small text files are merged in memory, which saves writing out
+     detranslated copies of the target and the left file. */
+  if (! is_binary && diff3_cmd == NULL)
+    SVN_ERR(read_merge_texts(&texts, &mt, left_abspath, right_abspath,
+                             scratch_pool, scratch_pool));
 
-  /* We cannot depend on the left file to contain the same eols as the
-     right file. If the merge target has mods, this will mark the entire
-     file as conflicted, so we need to compensate. */
-  SVN_ERR(maybe_update_target_eols(&left_abspath, prop_diff, left_abspath,
-                                   cancel_func, cancel_baton,
-                                   scratch_pool, scratch_pool));
+  if (texts)
+    {
+      detranslated_target_abspath = target_abspath;
+    }
+  else
+    {
+      SVN_ERR(detranslate_wc_file(&detranslated_target_abspath, &mt,
+                                  (! is_binary) && diff3_cmd != NULL,
+                                  target_abspath,
+                                  cancel_func, cancel_baton,
+                                  scratch_pool, scratch_pool));
+
+      /* We cannot depend on the left file to contain the same eols as the
+         right file. If the merge target has mods, this will mark the entire
+         file as conflicted, so we need to compensate. */
+      SVN_ERR(maybe_update_target_eols(&left_abspath, prop_diff,
+                                       left_abspath,
+                                       cancel_func, cancel_baton,
+                                       scratch_pool, scratch_pool));
+    }
 
   SVN_ERR(merge_file_trivial(work_items, merge_outcome,
                              left_abspath, right_abspath,
                              target_abspath, detranslated_target_abspath,
-                             dry_run, db, cancel_func, cancel_baton,
+                             texts, dry_run, db, cancel_func, cancel_baton,
                              result_pool, scratch_pool));
   if (*merge_outcome == svn_wc_merge_no_merge)
     {
@@ -1181,6 +1418,7 @@ svn_wc__internal_merge(svn_skel_t **work_items,
                                   target_label,
                                   dry_run,
                                   detranslated_target_abspath,
+                                  texts,
                                   cancel_func, cancel_baton,
                                   result_pool, scratch_pool));
         }
@@ -26,14 +26,17 @@
 #include <string.h>
 
 #include <apr_pools.h>
+#include <apr_strings.h>
 #include <apr_file_io.h>
 #include <apr_file_info.h>
 #include <apr_time.h>
+#include <apr_thread_proc.h>
 
 #include "svn_pools.h"
 #include "svn_types.h"
 #include "svn_string.h"
 #include "svn_error.h"
+#include "svn_hash.h"
 #include "svn_dirent_uri.h"
 #include "svn_time.h"
 #include "svn_io.h"
@@ -45,7 +48,9 @@
 #include "wc_db.h"
 
 #include "svn_private_config.h"
+#include "private/svn_atomic.h"
 #include "private/svn_wc_private.h"
+#include "private/svn_io_private.h"
 
 
 
@@ -353,6 +358,420 @@ svn_wc__internal_file_modified_p(svn_boolean_t *modified_p,
 }
 
 
+/* Maximum number of additional threads comparing the files of a
+   directory against their pristine texts. */
+#define COMPARE_THREADS 3
+
+/* A file whose text we compare against its pristine text. */
+typedef struct compare_job_t
+{
+  /* What to compare, as prepared by the main thread. */
+  const char *name;
+  const char *local_abspath;
+  const svn_checksum_t *checksum;
+  svn_boolean_t exact_comparison;
+  svn_boolean_t need_translation;
+
+  /* Only set if NEED_TRANSLATION. */
+  const char *pristine_abspath;
+  svn_boolean_t compressed;
+  svn_subst_eol_style_t eol_style;
+  const char *eol_str;
+  apr_hash_t *keywords;
+
+  /* The file info to record if the file turns out to be unmodified. */
+  const svn_io_dirent2_t *dirent;
+
+  /* The results of the comparison. */
+  svn_boolean_t modified;
+  svn_error_t *err;
+} compare_job_t;
+
+/* The jobs of a directory, shared by all threads running them. */
+typedef struct compare_batch_t
+{
+  compare_job_t **jobs;
+  int count;
+
+  /* Index of the next job to run. */
+  volatile svn_atomic_t next;
+} compare_batch_t;
+
+#if APR_HAS_THREADS
+/* A thread running jobs of a compare batch. */
+typedef struct compare_thread_t
+{
+  compare_batch_t *batch;
+  apr_thread_t *thread;
+
+  /* Pool used by this thread only. */
+  apr_pool_t *pool;
+} compare_thread_t;
+#endif
+
+/* Set JOB->MODIFIED like compare_and_verify() does, but without accessing
+   the database, so that this can run on any thread. */
+static svn_error_t *
+perform_compare(compare_job_t *job,
+                apr_pool_t *scratch_pool)
+{
+  apr_file_t *file;
+  svn_stream_t *v_stream;
+  svn_checksum_t *v_checksum;
+  svn_error_t *err;
+
+  err = svn_io_file_open(&file, job->local_abspath, APR_READ,
+                         APR_OS_DEFAULT, scratch_pool);
+  if (err && APR_STATUS_IS_EACCES(err->apr_err))
+    return svn_error_create(SVN_ERR_WC_PATH_ACCESS_DENIED, err, NULL);
+  SVN_ERR(err);
+  v_stream = svn_stream_from_aprfile2(file, FALSE, scratch_pool);
+
+  if (job->need_translation && job->exact_comparison)
+    {
+      svn_stream_t *pristine_stream;
+      svn_boolean_t same;
+
+      SVN_ERR(svn_wc__db_pristine_open_file(&pristine_stream,
+                                            job->pristine_abspath,
+                                            job->compressed,
+                                            scratch_pool, scratch_pool));
+      pristine_stream = svn_subst_stream_translated(pristine_stream,
+                                                    job->eol_str, FALSE,
+                                                    job->keywords, TRUE,
+                                                    scratch_pool);
+      SVN_ERR(svn_stream_contents_same2(&same, pristine_stream, v_stream,
+                                        scratch_pool));
+      job->modified = !same;
+
+      return SVN_NO_ERROR;
+    }
+  else if (job->need_translation)
+    {
+      const char *eol_str = job->eol_str;
+
+      if (job->eol_style == svn_subst_eol_style_native)
+        eol_str = SVN_SUBST_NATIVE_EOL_STR;
+      else if (job->eol_style != svn_subst_eol_style_fixed
+               && job->eol_style != svn_subst_eol_style_none)
+        return svn_error_create(SVN_ERR_IO_UNKNOWN_EOL,
+                                svn_stream_close(v_stream), NULL);
+
+      v_stream = svn_subst_stream_translated(v_stream, eol_str,
+                                             TRUE /* repair */,
+                                             job->keywords,
+                                             FALSE /* expand */,
+                                             scratch_pool);
+    }
+
+  err = svn_stream_contents_checksum(&v_checksum, v_stream,
+                                     job->checksum->kind,
+                                     scratch_pool, scratch_pool);
+  if (err && APR_STATUS_IS_EACCES(err->apr_err))
+    return svn_error_create(SVN_ERR_WC_PATH_ACCESS_DENIED, err, NULL);
+  SVN_ERR(err);
+
+  job->modified = !svn_checksum_match(v_checksum, job->checksum);
+
+  return SVN_NO_ERROR;
+}
+
+/* Run jobs from BATCH until there are none left. */
+static void
+run_compare_jobs(compare_batch_t *batch,
+                 apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  while (TRUE)
+    {
+      int i = (int)svn_atomic_inc(&batch->next);
+      compare_job_t *job;
+
+      if (i >= batch->count)
+        break;
+
+      svn_pool_clear(iterpool);
+      job = batch->jobs[i];
+      job->err = perform_compare(job, iterpool);
+    }
+
+  svn_pool_destroy(iterpool);
+}
+
+#if APR_HAS_THREADS
+/* Thread function running the jobs of the compare_thread_t DATA. */
+static void * APR_THREAD_FUNC
+compare_thread_func(apr_thread_t *tid,
+                    void *data)
+{
+  compare_thread_t *thread = data;
+
+  run_compare_jobs(thread->batch, thread->pool);
+
+  return NULL;
+}
+#endif
+
+/* Prepare the comparison of the file NAME in DIR_ABSPATH, described by
+   INFO and DIRENT, against its pristine text.  Set *JOB to NULL if the
+   file doesn't need a comparison or can't be compared without DB.
+   Allocate *JOB in RESULT_POOL. */
+static svn_error_t *
+prepare_compare(compare_job_t **job,
+                svn_wc__db_t *db,
+                const char *dir_abspath,
+                const char *name,
+                const struct svn_wc__db_info_t *info,
+                const svn_io_dirent2_t *dirent,
+                svn_boolean_t exact_comparison,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  const char *local_abspath;
+  const svn_checksum_t *checksum;
+  svn_subst_eol_style_t eol_style;
+  const char *eol_str;
+  apr_hash_t *keywords;
+  svn_boolean_t special;
+  compare_job_t *new_job;
+
+  *job = NULL;
+
+  if (info->kind != svn_node_file
+      || !info->has_checksum
+      || (info->status != svn_wc__db_status_normal
+          && info->status != svn_wc__db_status_added)
+      || !dirent
+      || dirent->kind != svn_node_file
+      || dirent->special)
+    return SVN_NO_ERROR;
+
+  /* Files that still match their recorded info are unmodified. */
+  if (info->recorded_size != SVN_INVALID_FILESIZE
+      && info->recorded_time != 0
+      && info->recorded_size == dirent->filesize
+      && info->recorded_time == dirent->mtime)
+    return SVN_NO_ERROR;
+
+  local_abspath = svn_dirent_join(dir_abspath, name, result_pool);
+
+  SVN_ERR(svn_wc__db_read_info(NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, &checksum, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL, NULL,
+                               db, local_abspath,
+                               result_pool, scratch_pool));
+  if (!checksum)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_wc__get_translate_info(&eol_style, &eol_str, &keywords,
+                                     &special, db, local_abspath, NULL,
+                                     !exact_comparison,
+                                     result_pool, scratch_pool));
+  if (special)
+    return SVN_NO_ERROR;
+
+  new_job = apr_pcalloc(result_pool, sizeof(*new_job));
+  new_job->name = name;
+  new_job->local_abspath = local_abspath;
+  new_job->checksum = checksum;
+  new_job->exact_comparison = exact_comparison;
+  new_job->dirent = dirent;
+  new_job->need_translation = svn_subst_translation_required(eol_style,
+                                                             eol_str,
+                                                             keywords,
+                                                             special, TRUE);
+
+  if (new_job->need_translation)
+    {
+      new_job->eol_style = eol_style;
+      new_job->eol_str = eol_str;
+      new_job->keywords = keywords;
+      if (exact_comparison)
+        SVN_ERR(svn_wc__db_pristine_get_file(&new_job->pristine_abspath,
+                                             &new_job->compressed,
+                                             db, local_abspath, checksum,
+                                             result_pool, scratch_pool));
+    }
+  else
+    {
+      svn_filesize_t pristine_size;
+
+      SVN_ERR(svn_wc__db_pristine_read(NULL, &pristine_size, db,
+                                       local_abspath, checksum,
+                                       scratch_pool, scratch_pool));
+
+      /* No need to read anything if the sizes differ. */
+      if (dirent->filesize != pristine_size)
+        new_job->modified = TRUE;
+    }
+
+  *job = new_job;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__internal_children_modified(apr_hash_t **modified,
+                                   svn_wc__db_t *db,
+                                   const char *dir_abspath,
+                                   apr_hash_t *children,
+                                   apr_hash_t *dirents,
+                                   svn_boolean_t exact_comparison,
+                                   svn_cancel_func_t cancel_func,
+                                   void *cancel_baton,
+                                   apr_pool_t *result_pool,
+                                   apr_pool_t *scratch_pool)
+{
+#if APR_HAS_THREADS
+  compare_thread_t threads[COMPARE_THREADS];
+  int started = 0;
+#endif
+  compare_batch_t batch = { 0 };
+  apr_hash_t *record_map = NULL;
+  apr_hash_index_t *hi;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  *modified = apr_hash_make(result_pool);
+
+  if (!dirents)
+    {
+      err = svn_io_get_dirents3(&dirents, dir_abspath, FALSE,
+                                scratch_pool, scratch_pool);
+      if (err && (APR_STATUS_IS_ENOENT(err->apr_err)
+                  || SVN__APR_STATUS_IS_ENOTDIR(err->apr_err)))
+        {
+          svn_error_clear(err);
+          return SVN_NO_ERROR;
+        }
+      SVN_ERR(err);
+    }
+
+  batch.jobs = apr_palloc(scratch_pool,
+                          apr_hash_count(children) * sizeof(*batch.jobs));
+
+  for (hi = apr_hash_first(scratch_pool, children);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      const char *name = apr_hash_this_key(hi);
+      compare_job_t *job;
+
+      svn_pool_clear(iterpool);
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(prepare_compare(&job, db, dir_abspath, name,
+                              apr_hash_this_val(hi),
+                              svn_hash_gets(dirents, name),
+                              exact_comparison, scratch_pool, iterpool));
+      if (!job)
+        continue;
+
+      if (job->modified)
+        svn_hash_sets(*modified, apr_pstrdup(result_pool, name),
+                      apr_pmemdup(result_pool, &job->modified,
+                                  sizeof(job->modified)));
+      else
+        batch.jobs[batch.count++] = job;
+    }
+
+  svn_pool_destroy(iterpool);
+
+#if APR_HAS_THREADS
+  /* Run the jobs on up to COMPARE_THREADS additional threads and this
+     one. */
+  for (started = 0;
+       started < COMPARE_THREADS && started < batch.count - 1;
+       started++)
+    {
+      apr_status_t status;
+
+      /* Each thread needs a pool that it does not share with any other
+       * thread, including its allocator. */
+      threads[started].batch = &batch;
+      threads[started].pool = svn_pool_create(NULL);
+      status = apr_thread_create(&threads[started].thread, NULL,
+                                 compare_thread_func, &threads[started],
+                                 threads[started].pool);
+      if (status)
+        {
+          /* Just do with fewer threads. */
+          svn_pool_destroy(threads[started].pool);
+          break;
+        }
+    }
+#endif
+
+  run_compare_jobs(&batch, scratch_pool);
+
+#if APR_HAS_THREADS
+  for (i = 0; i < started; i++)
+    {
+      apr_status_t retval;
+      apr_status_t status = apr_thread_join(&retval, threads[i].thread);
+      if (status)
+        err = svn_error_compose_create(err,
+                       svn_error_wrap_apr(status,
+                                          _("Can't join compare thread")));
+      svn_pool_destroy(threads[i].pool);
+    }
+#endif
+
+  for (i = 0; i < batch.count; i++)
+    {
+      compare_job_t *job = batch.jobs[i];
+
+      /* Leave failed comparisons to the caller, which will report the
+         error in the usual way. */
+      if (job->err || err)
+        {
+          svn_error_clear(job->err);
+          continue;
+        }
+
+      svn_hash_sets(*modified, apr_pstrdup(result_pool, job->name),
+                    apr_pmemdup(result_pool, &job->modified,
+                                sizeof(job->modified)));
+
+      if (!job->modified)
+        {
+          if (!record_map)
+            record_map = apr_hash_make(scratch_pool);
+
+          svn_hash_sets(record_map, job->local_abspath, job->dirent);
+        }
+    }
+  SVN_ERR(err);
+
+  if (record_map)
+    {
+      svn_boolean_t own_lock;
+
+      /* Repair the recorded info like svn_wc__internal_file_modified_p()
+         does, but in a single transaction. */
+      SVN_ERR(svn_wc__db_wclock_owns_lock(&own_lock, db, dir_abspath, FALSE,
+                                          scratch_pool));
+      if (own_lock)
+        {
+          apr_array_header_t *ids;
+          apr_array_header_t *work_items;
+
+          SVN_ERR(svn_wc__db_wq_record_and_fetch_batch(&ids, &work_items, db,
+                                                       dir_abspath, NULL,
+                                                       record_map, 0,
+                                                       scratch_pool,
+                                                       scratch_pool));
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
 svn_error_t *
 svn_wc_text_modified_p2(svn_boolean_t *modified_p,
                         svn_wc_context_t *wc_ctx,
@@ -364,6 +783,87 @@ svn_wc_text_modified_p2(svn_boolean_t *modified_p,
                                           local_abspath, FALSE, scratch_pool);
 }
 
+/* Forget the recorded timestamps at or after LIMIT in the working copy of
+   LOCAL_ABSPATH and in the directory externals below it. */
+static svn_error_t *
+forget_racy_timestamps(svn_wc__db_t *db,
+                       const char *local_abspath,
+                       apr_time_t limit,
+                       apr_pool_t *scratch_pool)
+{
+  apr_hash_t *externals;
+  apr_hash_index_t *hi;
+  apr_pool_t *iterpool;
+
+  SVN_ERR(svn_wc__db_global_forget_racy_timestamps(db, local_abspath, limit,
+                                                   scratch_pool));
+
+  SVN_ERR(svn_wc__db_externals_defined_below(&externals, db, local_abspath,
+                                             scratch_pool, scratch_pool));
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (hi = apr_hash_first(scratch_pool, externals);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      const char *external_abspath = apr_hash_this_key(hi);
+      svn_boolean_t is_wcroot;
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+
+      /* File externals are part of the working copy defining them.
+         Directory externals that failed to check out don't matter. */
+      err = svn_wc__db_is_wcroot(&is_wcroot, db, external_abspath, iterpool);
+      if (err && (err->apr_err == SVN_ERR_WC_NOT_WORKING_COPY
+                  || err->apr_err == SVN_ERR_WC_PATH_NOT_FOUND))
+        {
+          svn_error_clear(err);
+          continue;
+        }
+      SVN_ERR(err);
+
+      if (is_wcroot)
+        SVN_ERR(forget_racy_timestamps(db, external_abspath, limit,
+                                       iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+void
+svn_wc__settle_timestamps(svn_wc_context_t *wc_ctx,
+                          const char *path,
+                          apr_pool_t *scratch_pool)
+{
+  const char *local_abspath;
+  apr_time_t limit;
+  svn_error_t *err;
+
+  if (path == NULL)
+    {
+      svn_io_sleep_for_timestamps(NULL, scratch_pool);
+      return;
+    }
+
+  /* Take the time before looking at the working copy, so that anything
+     written up to now is covered. */
+  limit = svn_io__racy_timestamp_limit(path, scratch_pool);
+
+  err = svn_dirent_get_absolute(&local_abspath, path, scratch_pool);
+  if (!err)
+    err = forget_racy_timestamps(wc_ctx->db, local_abspath, limit,
+                                 scratch_pool);
+
+  if (err)
+    {
+      /* Fall back to waiting until the timestamps are unambiguous. */
+      svn_error_clear(err);
+      svn_io_sleep_for_timestamps(path, scratch_pool);
+    }
+}
+
 
 
 static svn_error_t *
@@ -258,6 +258,7 @@ revert_wc_data(svn_boolean_t *run_wq,
                svn_filesize_t recorded_size,
                apr_time_t recorded_time,
                svn_boolean_t copied_here,
+               svn_tristate_t text_modified,
                svn_boolean_t use_commit_times,
                svn_cancel_func_t cancel_func,
                void *cancel_baton,
@@ -276,6 +277,10 @@ revert_wc_data(svn_boolean_t *run_wq,
 
    If INFO is NULL, LOCAL_ABSPATH doesn't exist in DB. Otherwise INFO
    specifies the state of LOCAL_ABSPATH in DB.
+
+   If TEXT_MODIFIED is not svn_tristate_unknown, it tells whether the
+   text of the file LOCAL_ABSPATH was already found to differ from its
+   pristine text.
  */
 static svn_error_t *
 revert_restore(svn_boolean_t *run_wq,
@@ -286,6 +291,7 @@ revert_restore(svn_boolean_t *run_wq,
                svn_boolean_t use_commit_times,
                svn_boolean_t revert_root,
                const struct svn_wc__db_info_t *info,
+               svn_tristate_t text_modified,
                svn_cancel_func_t cancel_func,
                void *cancel_baton,
                svn_wc_notify_func2_t notify_func,
@@ -377,7 +383,7 @@ revert_restore(svn_boolean_t *run_wq,
                              &notify_required,
                              db, local_abspath, status, kind,
                              reverted_kind, recorded_size, recorded_time,
-                             copied_here, use_commit_times,
+                             copied_here, text_modified, use_commit_times,
                              cancel_func, cancel_baton, scratch_pool));
     }
 
@@ -405,6 +411,7 @@ revert_restore(svn_boolean_t *run_wq,
     {
       apr_pool_t *iterpool = svn_pool_create(scratch_pool);
       apr_hash_t *children, *conflicts;
+      apr_hash_t *compared = NULL;
       apr_hash_index_t *hi;
 
       SVN_ERR(revert_restore_handle_copied_dirs(NULL, db, local_abspath, FALSE,
@@ -415,21 +422,42 @@ revert_restore(svn_boolean_t *run_wq,
                                             db, local_abspath, FALSE,
                                             scratch_pool, iterpool));
 
+      /* Comparing the files with their pristine texts is the expensive
+         part of reverting large trees, so do that for all files of this
+         directory at once. */
+      if (!metadata_only)
+        SVN_ERR(svn_wc__internal_children_modified(&compared, db,
+                                                   local_abspath, children,
+                                                   NULL, TRUE,
+                                                   cancel_func, cancel_baton,
+                                                   scratch_pool, iterpool));
+
       for (hi = apr_hash_first(scratch_pool, children);
            hi;
            hi = apr_hash_next(hi))
         {
           const char *child_name = apr_hash_this_key(hi);
           const char *child_abspath;
+          svn_tristate_t child_modified = svn_tristate_unknown;
 
           svn_pool_clear(iterpool);
 
           child_abspath = svn_dirent_join(local_abspath, child_name, iterpool);
 
+          if (compared)
+            {
+              const svn_boolean_t *modified = svn_hash_gets(compared,
+                                                            child_name);
+
+              if (modified)
+                child_modified = *modified ? svn_tristate_true
+                                           : svn_tristate_false;
+            }
+
           SVN_ERR(revert_restore(run_wq,
                                  db, child_abspath, depth, metadata_only,
                                  use_commit_times, FALSE /* revert root */,
-                                 apr_hash_this_val(hi),
+                                 apr_hash_this_val(hi), child_modified,
                                  cancel_func, cancel_baton,
                                  notify_func, notify_baton,
                                  iterpool));
@@ -453,7 +481,8 @@ revert_restore(svn_boolean_t *run_wq,
   return SVN_NO_ERROR;
 }
 
-/* Perform the in-working copy revert of LOCAL_ABSPATH, to what is stored in DB */
+/* Perform the in-working copy revert of LOCAL_ABSPATH, to what is stored in DB.
+   TEXT_MODIFIED is as for revert_restore(). */
 static svn_error_t *
 revert_wc_data(svn_boolean_t *run_wq,
                svn_boolean_t *notify_required,
@@ -465,6 +494,7 @@ revert_wc_data(svn_boolean_t *run_wq,
                svn_filesize_t recorded_size,
                apr_time_t recorded_time,
                svn_boolean_t copied_here,
+               svn_tristate_t text_modified,
                svn_boolean_t use_commit_times,
                svn_cancel_func_t cancel_func,
                void *cancel_baton,
@@ -604,6 +634,11 @@ revert_wc_data(svn_boolean_t *run_wq,
                 {
                   modified = FALSE;
                 }
+              else if (text_modified != svn_tristate_unknown)
+                {
+                  /* Already compared (and recorded) by our caller. */
+                  modified = (text_modified == svn_tristate_true);
+                }
               else
                 /* Side effect: fixes recorded timestamps */
                 SVN_ERR(svn_wc__internal_file_modified_p(&modified,
@@ -762,7 +797,8 @@ revert(svn_wc__db_t *db,
     err = svn_error_trace(
               revert_restore(&run_queue, db, local_abspath, depth, metadata_only,
                              use_commit_times, TRUE /* revert root */,
-                             info, cancel_func, cancel_baton,
+                             info, svn_tristate_unknown,
+                             cancel_func, cancel_baton,
                              notify_func, notify_baton,
                              scratch_pool));
 
@@ -21,16 +21,193 @@
  * ====================================================================
  */
 
+#include <stdio.h>
+#include <apr_strings.h>
+
 #include "svn_wc.h"
 #include "svn_dirent_uri.h"
+#include "svn_io.h"
+#include "svn_string.h"
 #include "wc_db.h"
 #include "wc.h"
+#include "adm_files.h"
+#include "fsmonitor.h"
 #include "props.h"
 
 #include "private/svn_wc_private.h"
 
 #include "svn_private_config.h"
 
+
+/* Build systems tend to ask for the revision status on every build.
+   Scanning a large working copy for local modifications takes a while,
+   so we keep the last result in the administrative area.  It remains
+   valid as long as wc.db has not been written to and the filesystem
+   monitor reports no changes to the working files since.  Without a
+   monitor, nothing gets cached.
+
+   The cache file consists of these lines:
+     format
+     wc.db stamp
+     fsmonitor token
+     relpath of the target within the working copy ("." for the root)
+     trail URL
+     committed flag
+     min_rev max_rev switched modified sparse_checkout
+ */
+
+/* Name of the cache file in the administrative area. */
+#define REVISION_STATUS_CACHE "revision-status"
+
+/* Version of the cache file format. */
+#define REVISION_STATUS_CACHE_FORMAT "1"
+
+/* Name of the working copy database in the administrative area. */
+#define SDB_FILE "wc.db"
+
+/* Set *STAMP to a string that changes whenever wc.db of WCROOT_ABSPATH
+   gets modified.  It combines the file's size and mtime with the change
+   counter that SQLite increments in the database header with every
+   transaction. */
+static svn_error_t *
+get_db_stamp(const char **stamp,
+             const char *wcroot_abspath,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  const char *db_abspath = svn_wc__adm_child(wcroot_abspath, SDB_FILE,
+                                             scratch_pool);
+  apr_file_t *file;
+  apr_finfo_t finfo;
+  unsigned char header[28];
+  apr_size_t len;
+
+  SVN_ERR(svn_io_file_open(&file, db_abspath, APR_READ, APR_OS_DEFAULT,
+                           scratch_pool));
+  SVN_ERR(svn_io_file_info_get(&finfo, APR_FINFO_SIZE | APR_FINFO_MTIME,
+                               file, scratch_pool));
+  SVN_ERR(svn_io_file_read_full2(file, header, sizeof(header), &len, NULL,
+                                 scratch_pool));
+  SVN_ERR(svn_io_file_close(file, scratch_pool));
+
+  *stamp = apr_psprintf(result_pool,
+                        "%lu %" APR_OFF_T_FMT " %" APR_TIME_T_FMT,
+                        len == sizeof(header)
+                          ? ((unsigned long)header[24] << 24)
+                            | ((unsigned long)header[25] << 16)
+                            | ((unsigned long)header[26] << 8)
+                            | (unsigned long)header[27]
+                          : 0ul,
+                        finfo.size, finfo.mtime);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the key lines identifying a revision status query for RELPATH,
+   TRAIL_URL and COMMITTED in the cache file. */
+static const char *
+cache_key(const char *relpath,
+          const char *trail_url,
+          svn_boolean_t committed,
+          apr_pool_t *result_pool)
+{
+  return apr_psprintf(result_pool, "%s\n%s\n%d",
+                      *relpath ? relpath : ".",
+                      trail_url ? trail_url : "",
+                      committed ? 1 : 0);
+}
+
+/* If the cache file of WCROOT_ABSPATH contains the result for KEY,
+   recorded at DB_STAMP, set *RESULT to it and *TOKEN to the filesystem
+   monitor token recorded with it.  Otherwise, leave both untouched.
+   Allocate *TOKEN in RESULT_POOL. */
+static svn_error_t *
+read_cached_status(svn_wc_revision_status_t *result,
+                   const char **token,
+                   const char *wcroot_abspath,
+                   const char *db_stamp,
+                   const char *key,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *contents;
+  const char *expected;
+  svn_wc_revision_status_t cached = { 0 };
+  int switched, modified, sparse_checkout;
+  const char *line, *eol, *next;
+  svn_error_t *err;
+
+  err = svn_stringbuf_from_file2(&contents,
+                                 svn_wc__adm_child(wcroot_abspath,
+                                                   REVISION_STATUS_CACHE,
+                                                   scratch_pool),
+                                 scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  /* Everything but the token and the result must match exactly. */
+  expected = apr_pstrcat(scratch_pool,
+                         REVISION_STATUS_CACHE_FORMAT "\n", db_stamp, "\n",
+                         SVN_VA_NULL);
+  if (strncmp(contents->data, expected, strlen(expected)) != 0)
+    return SVN_NO_ERROR;
+
+  /* The token is followed by the key and the result. */
+  line = contents->data + strlen(expected);
+  eol = strchr(line, '\n');
+  if (eol == NULL)
+    return SVN_NO_ERROR;
+
+  next = eol + 1;
+  if (strncmp(next, key, strlen(key)) != 0 || next[strlen(key)] != '\n')
+    return SVN_NO_ERROR;
+
+  if (sscanf(next + strlen(key) + 1, "%ld %ld %d %d %d",
+             &cached.min_rev, &cached.max_rev,
+             &switched, &modified, &sparse_checkout) != 5)
+    return SVN_NO_ERROR;
+
+  *token = apr_pstrmemdup(result_pool, line, eol - line);
+  result->min_rev = cached.min_rev;
+  result->max_rev = cached.max_rev;
+  result->switched = switched != 0;
+  result->modified = modified != 0;
+  result->sparse_checkout = sparse_checkout != 0;
+
+  return SVN_NO_ERROR;
+}
+
+/* Store RESULT for KEY, computed at DB_STAMP and the filesystem monitor's
+   TOKEN, in the cache file of WCROOT_ABSPATH. */
+static svn_error_t *
+write_cached_status(const svn_wc_revision_status_t *result,
+                    const char *wcroot_abspath,
+                    const char *db_stamp,
+                    const char *token,
+                    const char *key,
+                    apr_pool_t *scratch_pool)
+{
+  const char *contents
+    = apr_psprintf(scratch_pool,
+                   REVISION_STATUS_CACHE_FORMAT "\n%s\n%s\n%s\n"
+                   "%ld %ld %d %d %d\n",
+                   db_stamp, token, key,
+                   result->min_rev, result->max_rev,
+                   result->switched ? 1 : 0, result->modified ? 1 : 0,
+                   result->sparse_checkout ? 1 : 0);
+
+  return svn_error_trace(
+           svn_io_write_atomic2(svn_wc__adm_child(wcroot_abspath,
+                                                  REVISION_STATUS_CACHE,
+                                                  scratch_pool),
+                                contents, strlen(contents), NULL, FALSE,
+                                scratch_pool));
+}
+
 svn_error_t *
 svn_wc_revision_status2(svn_wc_revision_status_t **result_p,
                         svn_wc_context_t *wc_ctx,
@@ -43,11 +220,49 @@ svn_wc_revision_status2(svn_wc_revision_status_t **result_p,
                         apr_pool_t *scratch_pool)
 {
   svn_wc_revision_status_t *result = apr_pcalloc(result_pool, sizeof(*result));
+  const char *wcroot_abspath;
+  const char *db_stamp = NULL;
+  const char *cached_token = NULL;
+  const char *token = NULL;
+  const char *key = NULL;
+  svn_boolean_t changed = TRUE;
+  svn_error_t *err;
 
   *result_p = result;
 
   SVN_ERR_ASSERT(svn_dirent_is_absolute(local_abspath));
 
+  /* Try the cache first.  Any problem with it just means that we have to
+     do the actual work.  Fetch stamp and token before looking at the
+     working copy such that later changes will invalidate our result. */
+  err = svn_wc__db_get_wcroot(&wcroot_abspath, wc_ctx->db, local_abspath,
+                              scratch_pool, scratch_pool);
+  if (!err)
+    err = get_db_stamp(&db_stamp, wcroot_abspath, scratch_pool,
+                       scratch_pool);
+  if (!err)
+    {
+      key = cache_key(svn_dirent_skip_ancestor(wcroot_abspath,
+                                               local_abspath),
+                      trail_url, committed, scratch_pool);
+      err = read_cached_status(result, &cached_token, wcroot_abspath,
+                               db_stamp, key, scratch_pool, scratch_pool);
+    }
+  if (!err)
+    err = svn_wc__fsmonitor_changed_since(&token, &changed, wc_ctx->db,
+                                          wcroot_abspath, cached_token,
+                                          scratch_pool, scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      token = NULL;
+    }
+  else if (cached_token && token && !changed)
+    {
+      /* Keep the token that the cached result refers to. */
+      return SVN_NO_ERROR;
+    }
+
   /* set result as nil */
   result->min_rev  = SVN_INVALID_REVNUM;
   result->max_rev  = SVN_INVALID_REVNUM;
@@ -69,5 +284,11 @@ svn_wc_revision_status2(svn_wc_revision_status_t **result_p,
                                         cancel_func, cancel_baton,
                                         scratch_pool));
 
+  /* Caching is only an optimization, e.g. for read-only working copies
+     it won't work. */
+  if (token)
+    svn_error_clear(write_cached_status(result, wcroot_abspath, db_stamp,
+                                        token, key, scratch_pool));
+
   return SVN_NO_ERROR;
 }
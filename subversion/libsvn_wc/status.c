@@ -46,6 +46,7 @@
 
 #include "wc.h"
 #include "props.h"
+#include "fsmonitor.h"
 
 #include "private/svn_sorts_private.h"
 #include "private/svn_wc_private.h"
@@ -100,6 +101,15 @@ struct walk_status_baton
 
   /* Repository locks, if set. */
   apr_hash_t *repos_locks;
+
+  /* The filesystem monitor telling which directories must be read from
+     disk, or NULL to read all of them. */
+  svn_wc__fsmonitor_t *fsmonitor;
+
+  /* The children of TARGET_ABSPATH and of the directories below it, as
+     read by svn_wc__db_read_descendants_info(), or NULL. */
+  apr_hash_t *prefetched_nodes;
+  apr_hash_t *prefetched_conflicts;
 };
 
 /*** Editor batons ***/
@@ -1188,6 +1198,53 @@ one_child_status(const struct walk_status_baton *wb,
   return SVN_NO_ERROR;
 }
 
+/* Return a hash mapping the names of the versioned children NODES of an
+   unchanged directory with the conflicts CONFLICTS to the dirents that
+   svn_io_get_dirents3() would find for them on disk, allocated in
+   RESULT_POOL.  Return NULL if that can't be derived from NODES alone,
+   e.g. because there are local additions or deletions. */
+static apr_hash_t *
+dirents_from_nodes(apr_hash_t *nodes,
+                   apr_hash_t *conflicts,
+                   apr_pool_t *result_pool)
+{
+  apr_hash_t *dirents;
+  apr_hash_index_t *hi;
+
+  if (apr_hash_count(conflicts) > 0)
+    return NULL;
+
+  dirents = apr_hash_make(result_pool);
+  for (hi = apr_hash_first(result_pool, nodes); hi; hi = apr_hash_next(hi))
+    {
+      const struct svn_wc__db_info_t *info = apr_hash_this_val(hi);
+      svn_io_dirent2_t *dirent;
+
+      if (info->status == svn_wc__db_status_not_present
+          || info->status == svn_wc__db_status_excluded
+          || info->status == svn_wc__db_status_server_excluded)
+        continue;
+
+      if (info->status != svn_wc__db_status_normal
+          || (info->kind != svn_node_file && info->kind != svn_node_dir
+              && info->kind != svn_node_symlink))
+        return NULL;
+
+      dirent = svn_io_dirent2_create(result_pool);
+      dirent->kind = (info->kind == svn_node_dir) ? svn_node_dir
+                                                   : svn_node_file;
+#ifdef HAVE_SYMLINK
+      dirent->special = info->special;
+#endif /* HAVE_SYMLINK */
+      dirent->filesize = info->recorded_size;
+      dirent->mtime = info->recorded_time;
+
+      svn_hash_sets(dirents, apr_hash_this_key(hi), dirent);
+    }
+
+  return dirents;
+}
+
 /* Send svn_wc_status3_t * structures for the directory LOCAL_ABSPATH and
    for all its child nodes (according to DEPTH) through STATUS_FUNC /
    STATUS_BATON.
@@ -1234,6 +1291,7 @@ get_dir_status(const struct walk_status_baton *wb,
   apr_array_header_t *sorted_children;
   apr_array_header_t *collected_ignore_patterns = NULL;
   apr_pool_t *iterpool;
+  svn_boolean_t dirents_from_disk = FALSE;
   svn_error_t *err;
   int i;
 
@@ -1245,7 +1303,33 @@ get_dir_status(const struct walk_status_baton *wb,
 
   iterpool = svn_pool_create(scratch_pool);
 
-  if (wb->check_working_copy)
+  nodes = NULL;
+  dirents = NULL;
+
+  /* If the filesystem monitor knows that this directory hasn't changed
+     since it was last found clean, the working copy database tells us
+     all we would find on disk. */
+  if (wb->fsmonitor
+      && !svn_wc__fsmonitor_dir_changed(wb->fsmonitor, local_abspath))
+    {
+      if (wb->prefetched_nodes)
+        {
+          nodes = svn_hash_gets(wb->prefetched_nodes, local_abspath);
+          conflicts = svn_hash_gets(wb->prefetched_conflicts, local_abspath);
+        }
+
+      if (!nodes)
+        SVN_ERR(svn_wc__db_read_children_info(&nodes, &conflicts,
+                                              wb->db, local_abspath,
+                                              FALSE /* base_tree_only */,
+                                              scratch_pool, iterpool));
+
+      dirents = dirents_from_nodes(nodes, conflicts, scratch_pool);
+    }
+
+  if (dirents)
+    ;
+  else if (wb->check_working_copy)
     {
       err = svn_io_get_dirents3(&dirents, local_abspath,
                                 wb->ignore_text_mods /* only_check_type*/,
@@ -1259,6 +1343,8 @@ get_dir_status(const struct walk_status_baton *wb,
         }
       else
         SVN_ERR(err);
+
+      dirents_from_disk = TRUE;
     }
   else
     dirents = apr_hash_make(scratch_pool);
@@ -1275,13 +1361,39 @@ get_dir_status(const struct walk_status_baton *wb,
                                      wb->db, local_abspath,
                                      scratch_pool, iterpool));
 
+  /* Use the children we have read in advance, unless this directory is
+     the root of another working copy. */
+  if (!nodes && wb->prefetched_nodes
+      && (strcmp(local_abspath, wb->target_abspath) == 0
+          || !svn_hash_gets(dirents, svn_wc_get_adm_dir(iterpool))))
+    {
+      nodes = svn_hash_gets(wb->prefetched_nodes, local_abspath);
+      conflicts = svn_hash_gets(wb->prefetched_conflicts, local_abspath);
+    }
+
   /* Create a hash containing all children.  The source hashes
      don't all map the same types, but only the keys of the result
      hash are subsequently used. */
-  SVN_ERR(svn_wc__db_read_children_info(&nodes, &conflicts,
-                                        wb->db, local_abspath,
-                                        !wb->check_working_copy,
-                                        scratch_pool, iterpool));
+  if (!nodes)
+    SVN_ERR(svn_wc__db_read_children_info(&nodes, &conflicts,
+                                          wb->db, local_abspath,
+                                          !wb->check_working_copy,
+                                          scratch_pool, iterpool));
+
+  /* Unversioned items, including ignored ones and nested working copies,
+     don't show up in the working copy database, so the filesystem monitor
+     must always have us read their directory. */
+  if (wb->fsmonitor && dirents_from_disk)
+    {
+      apr_hash_index_t *hi;
+
+      for (hi = apr_hash_first(iterpool, dirents); hi; hi = apr_hash_next(hi))
+        if (!svn_hash_gets(nodes, apr_hash_this_key(hi)))
+          {
+            svn_wc__fsmonitor_mark_dirty(wb->fsmonitor, local_abspath);
+            break;
+          }
+    }
 
   all_children = apr_hash_overlay(scratch_pool, nodes, dirents);
   if (apr_hash_count(conflicts) > 0)
@@ -2512,6 +2624,9 @@ svn_wc__get_status_editor(const svn_delta_editor_t **editor,
   eb->wb.ignore_text_mods = !check_working_copy;
   eb->wb.check_working_copy = check_working_copy;
   eb->wb.repos_locks      = NULL;
+  eb->wb.fsmonitor = NULL;
+  eb->wb.prefetched_nodes = NULL;
+  eb->wb.prefetched_conflicts = NULL;
   eb->wb.repos_root       = NULL;
 
   SVN_ERR(svn_wc__db_externals_defined_below(&eb->wb.externals,
@@ -2619,6 +2734,34 @@ stat_wc_dirent_case_sensitive(const svn_io_dirent2_t **dirent,
                                 result_pool, scratch_pool));
 }
 
+/* Baton for fsmonitor_status_func. */
+struct fsmonitor_status_baton_t
+{
+  svn_wc__fsmonitor_t *fsmonitor;
+  svn_wc_status_func4_t status_func;
+  void *status_baton;
+};
+
+/* Implements svn_wc_status_func4_t.  Mark the parent directory of every
+   node that is not unmodified as dirty in BATON->FSMONITOR and pass the
+   status on to BATON->STATUS_FUNC. */
+static svn_error_t *
+fsmonitor_status_func(void *baton,
+                      const char *local_abspath,
+                      const svn_wc_status3_t *status,
+                      apr_pool_t *scratch_pool)
+{
+  struct fsmonitor_status_baton_t *fsb = baton;
+
+  if (status->node_status != svn_wc_status_normal)
+    svn_wc__fsmonitor_mark_dirty(fsb->fsmonitor,
+                                 svn_dirent_dirname(local_abspath,
+                                                    scratch_pool));
+
+  return svn_error_trace(fsb->status_func(fsb->status_baton, local_abspath,
+                                          status, scratch_pool));
+}
+
 svn_error_t *
 svn_wc__internal_walk_status(svn_wc__db_t *db,
                              const char *local_abspath,
@@ -2644,6 +2787,9 @@ svn_wc__internal_walk_status(svn_wc__db_t *db,
   wb.check_working_copy = TRUE;
   wb.repos_root = NULL;
   wb.repos_locks = NULL;
+  wb.fsmonitor = NULL;
+  wb.prefetched_nodes = NULL;
+  wb.prefetched_conflicts = NULL;
 
   /* Use the caller-provided ignore patterns if provided; the build-time
      configured defaults otherwise. */
@@ -2690,6 +2836,35 @@ svn_wc__internal_walk_status(svn_wc__db_t *db,
       && info->status != svn_wc__db_status_excluded
       && info->status != svn_wc__db_status_server_excluded)
     {
+      struct fsmonitor_status_baton_t fsb;
+
+      if (depth == svn_depth_infinity || depth == svn_depth_unknown)
+        {
+          /* Read the whole tree with a single query rather than one query
+             per directory. */
+          SVN_ERR(svn_wc__db_read_descendants_info(&wb.prefetched_nodes,
+                                                   &wb.prefetched_conflicts,
+                                                   db, local_abspath,
+                                                   scratch_pool,
+                                                   scratch_pool));
+
+          /* We can't tell which directories contain ignored items or
+             modified files if we don't look for them. */
+          if (!no_ignore && !ignore_text_mods)
+            SVN_ERR(svn_wc__fsmonitor_open(&wb.fsmonitor, db, local_abspath,
+                                           scratch_pool, scratch_pool));
+        }
+
+      if (wb.fsmonitor)
+        {
+          fsb.fsmonitor = wb.fsmonitor;
+          fsb.status_func = status_func;
+          fsb.status_baton = status_baton;
+
+          status_func = fsmonitor_status_func;
+          status_baton = &fsb;
+        }
+
       SVN_ERR(get_dir_status(&wb,
                              local_abspath,
                              FALSE /* skip_root */,
@@ -2703,6 +2878,10 @@ svn_wc__internal_walk_status(svn_wc__db_t *db,
                              status_func, status_baton,
                              cancel_func, cancel_baton,
                              scratch_pool));
+
+      if (wb.fsmonitor)
+        SVN_ERR(svn_wc__fsmonitor_save(wb.fsmonitor, local_abspath,
+                                       scratch_pool));
     }
   else
     {
@@ -31,6 +31,8 @@
 #include <apr_md5.h>
 #include <apr_tables.h>
 #include <apr_strings.h>
+#include <apr_thread_proc.h>
+#include <apr_thread_cond.h>
 
 #include "svn_types.h"
 #include "svn_pools.h"
@@ -49,6 +51,7 @@
 #include "translate.h"
 #include "workqueue.h"
 
+#include "private/svn_mutex.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_wc_private.h"
 #include "private/svn_editor.h"
@@ -209,6 +212,10 @@ struct edit_baton
      of conflict checks to be omitted. */
   svn_boolean_t clean_checkout;
 
+  /* If set, added files are recorded as excluded instead of being
+     installed, so that their text is only fetched on demand. */
+  svn_boolean_t lazy_files;
+
   /* If this is a 'switch' operation, the new relpath of target_abspath,
      else NULL. */
   const char *switch_repos_relpath;
@@ -261,6 +268,9 @@ struct edit_baton
   /* After closing the root directory a copy of its edited value */
   svn_boolean_t edited;
 
+  /* Number of threads currently applying text deltas. */
+  int apply_workers;
+
   apr_pool_t *pool;
 };
 
@@ -434,6 +444,21 @@ struct handler_baton
   /* A calculated SHA-1 of NEW_TEXT_BASE_TMP_ABSPATH, which we'll use for
      eventually writing the pristine. */
   svn_checksum_t * new_text_base_sha1_checksum;
+
+  /* The source and target streams of the delta application. */
+  svn_stream_t *source;
+  svn_stream_t *target;
+
+  /* Has at least one window been applied? */
+  svn_boolean_t applied_window;
+
+#if APR_HAS_THREADS
+  /* Is POOL a root pool, i.e. can it be used by another thread? */
+  svn_boolean_t own_pool;
+
+  /* If not NULL, the thread applying the remaining windows. */
+  struct apply_worker_t *worker;
+#endif
 };
 
 
@@ -962,6 +987,248 @@ mark_file_edited(struct file_baton *fb, apr_pool_t *scratch_pool)
 }
 
 
+#if APR_HAS_THREADS
+
+/* Files whose text delta arrives in more than one window get their
+ * windows applied, i.e. the pristine text read, the new text hashed and
+ * written to disk, by a separate thread while we receive the next windows
+ * from the network.  These are the number of windows that may be queued
+ * for such a thread and the maximum number of such threads per edit. */
+#define APPLY_QUEUE_SIZE 16
+#define APPLY_WORKERS_MAX 4
+
+/* A thread applying the delta windows of a handler_baton. */
+typedef struct apply_worker_t
+{
+  /* The handler we are working for.  Once the thread has been started,
+     only the thread uses its POOL and its streams. */
+  struct handler_baton *hb;
+
+  /* Pool owned by the editor thread holding this structure. */
+  apr_pool_t *pool;
+
+  /* Protects all members below. */
+  svn_mutex__t *mutex;
+  apr_thread_cond_t *cond;
+
+  /* Ring buffer of COUNT windows to apply, starting at FIRST.  A NULL
+     window marks the end of the delta.  Each window is allocated in the
+     respective WINDOW_POOLS element. */
+  svn_txdelta_window_t *windows[APPLY_QUEUE_SIZE];
+  apr_pool_t *window_pools[APPLY_QUEUE_SIZE];
+  int first;
+  int count;
+
+  /* Set by the editor thread to make the worker stop. */
+  svn_boolean_t aborted;
+
+  /* Set by the worker when it is done, together with its error. */
+  svn_boolean_t done;
+  svn_error_t *err;
+
+  apr_thread_t *thread;
+} apply_worker_t;
+
+/* Wait for COND of WORKER, whose mutex must be locked by the caller. */
+static svn_error_t *
+wait_apply_worker(apply_worker_t *worker)
+{
+  apr_status_t status = apr_thread_cond_wait(worker->cond,
+                                             svn_mutex__get(worker->mutex));
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't wait for condition variable"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread function.  Apply the windows queued for the apply_worker_t DATA
+ * until the end of the delta, an error or until aborted. */
+static void * APR_THREAD_FUNC
+apply_worker_thread(apr_thread_t *tid,
+                    void *data)
+{
+  apply_worker_t *worker = data;
+  struct handler_baton *hb = worker->hb;
+  svn_error_t *err = SVN_NO_ERROR;
+  svn_boolean_t done = FALSE;
+
+  while (!done)
+    {
+      svn_txdelta_window_t *window;
+
+      err = svn_mutex__lock(worker->mutex);
+      if (err)
+        break;
+
+      while (!err && !worker->aborted && worker->count == 0)
+        err = wait_apply_worker(worker);
+
+      done = worker->aborted;
+      window = worker->windows[worker->first];
+      err = svn_mutex__unlock(worker->mutex, err);
+      if (err || done)
+        break;
+
+      /* The editor thread won't touch WINDOW until we hand it back. */
+      err = hb->apply_handler(window, hb->apply_baton);
+      done = (err != NULL || window == NULL);
+
+      err = svn_error_compose_create(err, svn_mutex__lock(worker->mutex));
+      worker->first = (worker->first + 1) % APPLY_QUEUE_SIZE;
+      worker->count--;
+      apr_thread_cond_broadcast(worker->cond);
+      err = svn_mutex__unlock(worker->mutex, err);
+    }
+
+  /* Tell the editor thread, even if we could not get the lock. */
+  err = svn_error_compose_create(err, svn_mutex__lock(worker->mutex));
+  worker->err = err;
+  worker->done = TRUE;
+  apr_thread_cond_broadcast(worker->cond);
+  svn_error_clear(svn_mutex__unlock(worker->mutex, SVN_NO_ERROR));
+
+  return NULL;
+}
+
+/* Start a thread applying the remaining windows of HB.  Leave HB->WORKER
+ * as NULL if no thread could be started. */
+static svn_error_t *
+start_apply_worker(struct handler_baton *hb)
+{
+  struct edit_baton *eb = hb->fb->edit_baton;
+  apply_worker_t *worker;
+  apr_pool_t *pool;
+  apr_status_t status;
+  apr_size_t len = 0;
+  char dummy;
+  int i;
+
+  /* Opening the streams lazily requires DB access, which we can't do
+     from another thread. */
+  SVN_ERR(svn_stream_read_full(hb->source, &dummy, &len));
+  SVN_ERR(svn_stream_write(hb->target, &dummy, &len));
+
+  pool = svn_pool_create(NULL);
+  worker = apr_pcalloc(pool, sizeof(*worker));
+  worker->hb = hb;
+  worker->pool = pool;
+  for (i = 0; i < APPLY_QUEUE_SIZE; i++)
+    worker->window_pools[i] = svn_pool_create(pool);
+
+  SVN_ERR(svn_mutex__init(&worker->mutex, TRUE, pool));
+  status = apr_thread_cond_create(&worker->cond, pool);
+  if (!status)
+    status = apr_thread_create(&worker->thread, NULL, apply_worker_thread,
+                               worker, pool);
+  if (status)
+    {
+      /* Just apply the windows ourselves. */
+      svn_pool_destroy(pool);
+      return SVN_NO_ERROR;
+    }
+
+  hb->worker = worker;
+  eb->apply_workers++;
+
+  return SVN_NO_ERROR;
+}
+
+/* Queue a copy of WINDOW, which may be NULL, for WORKER.  Wait for room
+ * in the queue if necessary.  Set *STOPPED if the worker has already
+ * stopped and the window was not queued. */
+static svn_error_t *
+queue_apply_window(svn_boolean_t *stopped,
+                   apply_worker_t *worker,
+                   svn_txdelta_window_t *window)
+{
+  svn_error_t *err;
+  int slot;
+
+  SVN_ERR(svn_mutex__lock(worker->mutex));
+
+  err = SVN_NO_ERROR;
+  while (!err && !worker->done && worker->count == APPLY_QUEUE_SIZE)
+    err = wait_apply_worker(worker);
+
+  *stopped = worker->done;
+  slot = (worker->first + worker->count) % APPLY_QUEUE_SIZE;
+  SVN_ERR(svn_mutex__unlock(worker->mutex, err));
+
+  if (*stopped)
+    return SVN_NO_ERROR;
+
+  /* The worker won't touch SLOT until we hand it over. */
+  svn_pool_clear(worker->window_pools[slot]);
+  worker->windows[slot]
+    = window ? svn_txdelta_window_dup(window, worker->window_pools[slot])
+             : NULL;
+
+  SVN_ERR(svn_mutex__lock(worker->mutex));
+  worker->count++;
+  apr_thread_cond_broadcast(worker->cond);
+
+  return svn_error_trace(svn_mutex__unlock(worker->mutex, SVN_NO_ERROR));
+}
+
+/* Wait for the worker of HB to finish and return its error.  If ABORT is
+ * set, make it stop before applying the remaining windows and discard
+ * its error. */
+static svn_error_t *
+stop_apply_worker(struct handler_baton *hb,
+                  svn_boolean_t abort)
+{
+  apply_worker_t *worker = hb->worker;
+  svn_error_t *err;
+  apr_status_t retval;
+  apr_status_t status;
+
+  err = svn_mutex__lock(worker->mutex);
+  if (abort)
+    {
+      worker->aborted = TRUE;
+      apr_thread_cond_broadcast(worker->cond);
+    }
+
+  while (!err && !worker->done)
+    err = wait_apply_worker(worker);
+
+  err = svn_mutex__unlock(worker->mutex, err);
+
+  status = apr_thread_join(&retval, worker->thread);
+  if (status)
+    err = svn_error_compose_create(err,
+                                   svn_error_wrap_apr(status,
+                                               _("Can't join apply thread")));
+
+  if (abort)
+    svn_error_clear(worker->err);
+  else
+    err = svn_error_compose_create(worker->err, err);
+
+  hb->worker = NULL;
+  hb->fb->edit_baton->apply_workers--;
+  svn_pool_destroy(worker->pool);
+
+  return svn_error_trace(err);
+}
+
+/* Pool cleanup function for the struct handler_baton DATA whose pool is
+ * a root pool.  Stop its worker, if any, and destroy the pool. */
+static apr_status_t
+cleanup_handler_pool(void *data)
+{
+  struct handler_baton *hb = data;
+
+  if (hb->worker)
+    svn_error_clear(stop_apply_worker(hb, TRUE));
+
+  svn_pool_destroy(hb->pool);
+
+  return APR_SUCCESS;
+}
+
+#endif /* APR_HAS_THREADS */
+
 /* Handle the next delta window of the file described by BATON.  If it is
  * the end (WINDOW == NULL), then check the checksum, store the text in the
  * pristine store and write its details into BATON->fb->new_text_base_*. */
@@ -970,10 +1237,34 @@ window_handler(svn_txdelta_window_t *window, void *baton)
 {
   struct handler_baton *hb = baton;
   struct file_baton *fb = hb->fb;
-  svn_error_t *err;
+  svn_error_t *err = SVN_NO_ERROR;
+
+#if APR_HAS_THREADS
+  /* Leave all but the first window to a worker thread. */
+  if (window != NULL && hb->worker == NULL && hb->own_pool
+      && hb->applied_window
+      && fb->edit_baton->apply_workers < APPLY_WORKERS_MAX)
+    err = start_apply_worker(hb);
+
+  if (hb->worker && !err)
+    {
+      svn_boolean_t stopped;
+
+      err = queue_apply_window(&stopped, hb->worker, window);
+      if (window != NULL && !stopped && !err)
+        return SVN_NO_ERROR;
+
+      err = svn_error_compose_create(err,
+                                     stop_apply_worker(hb, err != NULL));
+    }
+  else if (!err)
+#endif
+    {
+      /* Apply this window.  We may be done at that point.  */
+      err = hb->apply_handler(window, hb->apply_baton);
+      hb->applied_window = TRUE;
+    }
 
-  /* Apply this window.  We may be done at that point.  */
-  err = hb->apply_handler(window, hb->apply_baton);
   if (window != NULL && !err)
     return SVN_NO_ERROR;
 
@@ -1032,7 +1323,12 @@ window_handler(svn_txdelta_window_t *window, void *baton)
                                           hb->pool));
     }
 
-  svn_pool_destroy(hb->pool);
+#if APR_HAS_THREADS
+  if (hb->own_pool)
+    apr_pool_cleanup_run(fb->pool, hb, cleanup_handler_pool);
+  else
+#endif
+    svn_pool_destroy(hb->pool);
 
   return err;
 }
@@ -3207,6 +3503,31 @@ add_file(const char *path,
   else
     versioned_locally_and_present = IS_NODE_PRESENT(status);
 
+  /* In a lazy checkout we only record that the file exists.  A later
+     'svn update --set-depth infinity' on the file installs its text. */
+  if (eb->lazy_files
+      && kind == svn_node_none
+      && !versioned_locally_and_present
+      && !conflicted
+      && !fb->shadowed)
+    {
+      SVN_ERR(svn_wc__db_base_add_excluded_node(eb->db, fb->local_abspath,
+                                                fb->new_repos_relpath,
+                                                eb->repos_root,
+                                                eb->repos_uuid,
+                                                *(eb->target_revision),
+                                                svn_node_file,
+                                                svn_wc__db_status_excluded,
+                                                NULL, NULL,
+                                                scratch_pool));
+      fb->skip_this = TRUE;
+      fb->already_notified = TRUE;
+
+      svn_pool_destroy(scratch_pool);
+
+      return SVN_NO_ERROR;
+    }
+
 
   /* Is this path a conflict victim? */
   if (fb->shadowed)
@@ -3604,8 +3925,8 @@ apply_textdelta(void *file_baton,
                 void **handler_baton)
 {
   struct file_baton *fb = file_baton;
-  apr_pool_t *handler_pool = svn_pool_create(fb->pool);
-  struct handler_baton *hb = apr_pcalloc(handler_pool, sizeof(*hb));
+  apr_pool_t *handler_pool;
+  struct handler_baton *hb;
   struct edit_baton *eb = fb->edit_baton;
   const svn_checksum_t *recorded_base_checksum;
   svn_checksum_t *expected_base_checksum;
@@ -3621,6 +3942,25 @@ apply_textdelta(void *file_baton,
 
   SVN_ERR(mark_file_edited(fb, pool));
 
+#if APR_HAS_THREADS
+  /* If the delta might get applied by a worker thread, the handler needs
+     a pool of its own that does not share the allocator with FB->POOL. */
+  if (eb->apply_workers < APPLY_WORKERS_MAX)
+    {
+      handler_pool = svn_pool_create(NULL);
+      hb = apr_pcalloc(handler_pool, sizeof(*hb));
+      hb->own_pool = TRUE;
+      hb->pool = handler_pool;
+      apr_pool_cleanup_register(fb->pool, hb, cleanup_handler_pool,
+                                apr_pool_cleanup_null);
+    }
+  else
+#endif
+    {
+      handler_pool = svn_pool_create(fb->pool);
+      hb = apr_pcalloc(handler_pool, sizeof(*hb));
+    }
+
   /* Parse checksum or sets expected_base_checksum to NULL */
   SVN_ERR(svn_checksum_parse_hex(&expected_base_checksum, svn_checksum_md5,
                                  expected_checksum, pool));
@@ -3704,6 +4044,8 @@ apply_textdelta(void *file_baton,
     }
 
   target = svn_stream_lazyopen_create(lazy_open_target, hb, TRUE, handler_pool);
+  hb->source = source;
+  hb->target = target;
 
   /* Prepare to apply the delta.  */
   svn_txdelta_apply(source, target,
@@ -4872,6 +5214,7 @@ make_editor(svn_revnum_t *target_revision,
             svn_boolean_t adds_as_modification,
             svn_boolean_t server_performs_filtering,
             svn_boolean_t clean_checkout,
+            svn_boolean_t lazy_files,
             svn_wc_notify_func2_t notify_func,
             void *notify_baton,
             svn_cancel_func_t cancel_func,
@@ -4895,9 +5238,6 @@ make_editor(svn_revnum_t *target_revision,
   svn_delta_editor_t *tree_editor = svn_delta_default_editor(edit_pool);
   const svn_delta_editor_t *inner_editor;
   const char *repos_root, *repos_uuid;
-  struct svn_wc__shim_fetch_baton_t *sfb;
-  svn_delta_shim_callbacks_t *shim_callbacks =
-                                svn_delta_shim_callbacks_default(edit_pool);
 
   /* An unknown depth can't be sticky. */
   if (depth == svn_depth_unknown)
@@ -4962,6 +5302,7 @@ make_editor(svn_revnum_t *target_revision,
   eb->allow_unver_obstructions = allow_unver_obstructions;
   eb->adds_as_modification     = adds_as_modification;
   eb->clean_checkout           = clean_checkout;
+  eb->lazy_files               = lazy_files;
   eb->skipped_trees            = apr_hash_make(edit_pool);
   eb->dir_dirents              = apr_hash_make(edit_pool);
   eb->ext_patterns             = preserved_exts;
@@ -5127,20 +5468,6 @@ make_editor(svn_revnum_t *target_revision,
                                             edit_baton,
                                             result_pool));
 
-  sfb = apr_palloc(result_pool, sizeof(*sfb));
-  sfb->db = db;
-  sfb->base_abspath = eb->anchor_abspath;
-  sfb->fetch_base = TRUE;
-
-  shim_callbacks->fetch_kind_func = svn_wc__fetch_kind_func;
-  shim_callbacks->fetch_props_func = svn_wc__fetch_props_func;
-  shim_callbacks->fetch_base_func = svn_wc__fetch_base_func;
-  shim_callbacks->fetch_baton = sfb;
-
-  SVN_ERR(svn_editor__insert_shims(editor, edit_baton, *editor, *edit_baton,
-                                   NULL, NULL, shim_callbacks,
-                                   result_pool, scratch_pool));
-
   return SVN_NO_ERROR;
 }
 
@@ -5160,6 +5487,7 @@ svn_wc__get_update_editor(const svn_delta_editor_t **editor,
                           svn_boolean_t adds_as_modification,
                           svn_boolean_t server_performs_filtering,
                           svn_boolean_t clean_checkout,
+                          svn_boolean_t lazy_files,
                           const char *diff3_cmd,
                           const apr_array_header_t *preserved_exts,
                           svn_wc_dirents_func_t fetch_dirents_func,
@@ -5179,7 +5507,7 @@ svn_wc__get_update_editor(const svn_delta_editor_t **editor,
                      target_basename, wcroot_iprops, use_commit_times,
                      NULL, depth, depth_is_sticky, allow_unver_obstructions,
                      adds_as_modification, server_performs_filtering,
-                     clean_checkout,
+                     clean_checkout, lazy_files,
                      notify_func, notify_baton,
                      cancel_func, cancel_baton,
                      fetch_dirents_func, fetch_dirents_baton,
@@ -5227,6 +5555,7 @@ svn_wc__get_switch_editor(const svn_delta_editor_t **editor,
                      FALSE /* adds_as_modification */,
                      server_performs_filtering,
                      FALSE /* clean_checkout */,
+                     FALSE /* lazy_files */,
                      notify_func, notify_baton,
                      cancel_func, cancel_baton,
                      fetch_dirents_func, fetch_dirents_baton,
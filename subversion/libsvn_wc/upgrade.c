@@ -22,6 +22,7 @@
  */
 
 #include <apr_pools.h>
+#include <apr_thread_proc.h>
 
 #include "svn_types.h"
 #include "svn_pools.h"
@@ -40,6 +41,7 @@
 #include "token-map.h"
 
 #include "svn_private_config.h"
+#include "private/svn_atomic.h"
 #include "private/svn_wc_private.h"
 #include "private/svn_sqlite.h"
 #include "private/svn_token.h"
@@ -272,24 +274,28 @@ read_wcprops(apr_hash_t **all_wcprops,
 
    If SKIP_MISSING is TRUE, don't add missing or obstructed subdirectories
    to the list of children.
+
+   If ENTRIES is not NULL, it holds the already read entries of
+   DIR_ABSPATH.
    */
 static svn_error_t *
 get_versioned_subdirs(apr_array_header_t **children,
                       svn_boolean_t *delete_dir,
                       const char *dir_abspath,
+                      apr_hash_t *entries,
                       svn_boolean_t skip_missing,
                       apr_pool_t *result_pool,
                       apr_pool_t *scratch_pool)
 {
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
-  apr_hash_t *entries;
   apr_hash_index_t *hi;
   svn_wc_entry_t *this_dir = NULL;
 
   *children = apr_array_make(result_pool, 10, sizeof(const char *));
 
-  SVN_ERR(svn_wc__read_entries_old(&entries, dir_abspath,
-                                   scratch_pool, iterpool));
+  if (!entries)
+    SVN_ERR(svn_wc__read_entries_old(&entries, dir_abspath,
+                                     scratch_pool, iterpool));
   for (hi = apr_hash_first(scratch_pool, entries);
        hi;
        hi = apr_hash_next(hi))
@@ -537,8 +543,8 @@ svn_wc__wipe_postupgrade(const char *dir_abspath,
   if (cancel_func)
     SVN_ERR(cancel_func(cancel_baton));
 
-  err = get_versioned_subdirs(&subdirs, &delete_dir, dir_abspath, TRUE,
-                              scratch_pool, iterpool);
+  err = get_versioned_subdirs(&subdirs, &delete_dir, dir_abspath, NULL,
+                              TRUE, scratch_pool, iterpool);
   if (err)
     {
       if (APR_STATUS_IS_ENOENT(err->apr_err))
@@ -1171,9 +1177,223 @@ remove_suffix(const char *str, const char *suffix, apr_pool_t *result_pool)
   return NULL;
 }
 
+/* Maximum number of additional threads doing the file system work of an
+   upgrade, like copying text-bases and reading entries files. */
+#define UPGRADE_THREADS 3
+
+/* Do the work of an upgrade job for BATON, without accessing the
+   database, so that this can run on any thread.  Allocate the results
+   in RESULT_POOL. */
+typedef svn_error_t *(*upgrade_job_func_t)(void *baton,
+                                           apr_pool_t *result_pool,
+                                           apr_pool_t *scratch_pool);
+
+/* A set of upgrade jobs, shared by all threads running them. */
+typedef struct upgrade_batch_t
+{
+  upgrade_job_func_t func;
+  void **batons;
+  svn_error_t **errs;
+  int count;
+
+  /* Index of the next job to run. */
+  volatile svn_atomic_t next;
+} upgrade_batch_t;
+
+/* Run jobs from BATCH until there are none left.  Allocate the results
+   in RESULT_POOL. */
+static void
+run_upgrade_jobs(upgrade_batch_t *batch,
+                 apr_pool_t *result_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(result_pool);
+
+  while (TRUE)
+    {
+      int i = (int)svn_atomic_inc(&batch->next);
+
+      if (i >= batch->count)
+        break;
+
+      svn_pool_clear(iterpool);
+      batch->errs[i] = batch->func(batch->batons[i], result_pool, iterpool);
+    }
+
+  svn_pool_destroy(iterpool);
+}
+
+#if APR_HAS_THREADS
+/* A thread running jobs of an upgrade batch. */
+typedef struct upgrade_thread_t
+{
+  upgrade_batch_t *batch;
+  apr_thread_t *thread;
+
+  /* Pool used by this thread only, which also holds the results. */
+  apr_pool_t *pool;
+} upgrade_thread_t;
+
+/* Thread function running the jobs of the upgrade_thread_t DATA. */
+static void * APR_THREAD_FUNC
+upgrade_thread_func(apr_thread_t *tid,
+                    void *data)
+{
+  upgrade_thread_t *thread = data;
+
+  run_upgrade_jobs(thread->batch, thread->pool);
+
+  return NULL;
+}
+
+/* Pool cleanup handler destroying the thread pool DATA. */
+static apr_status_t
+destroy_thread_pool(void *data)
+{
+  svn_pool_destroy(data);
+  return APR_SUCCESS;
+}
+#endif
+
+/* Call FUNC for each of the COUNT BATONS, on up to UPGRADE_THREADS
+   additional threads and this one.  Set *ERRS to an array of the COUNT
+   errors returned.  The results remain valid as long as RESULT_POOL. */
+static svn_error_t *
+run_upgrade_batch(svn_error_t ***errs,
+                  upgrade_job_func_t func,
+                  void **batons,
+                  int count,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  upgrade_batch_t batch = { 0 };
+  svn_error_t *err = SVN_NO_ERROR;
+#if APR_HAS_THREADS
+  upgrade_thread_t threads[UPGRADE_THREADS];
+  int started;
+  int i;
+#endif
+
+  batch.func = func;
+  batch.batons = batons;
+  batch.count = count;
+  batch.errs = apr_pcalloc(result_pool, count * sizeof(*batch.errs));
+  *errs = batch.errs;
+
+#if APR_HAS_THREADS
+  for (started = 0;
+       started < UPGRADE_THREADS && started < count - 1;
+       started++)
+    {
+      apr_status_t status;
+
+      /* Each thread needs a pool that it does not share with any other
+       * thread, including its allocator.  It holds results, so keep it
+       * around as long as RESULT_POOL. */
+      threads[started].batch = &batch;
+      threads[started].pool = svn_pool_create(NULL);
+      status = apr_thread_create(&threads[started].thread, NULL,
+                                 upgrade_thread_func, &threads[started],
+                                 threads[started].pool);
+      if (status)
+        {
+          /* Just do with fewer threads. */
+          svn_pool_destroy(threads[started].pool);
+          break;
+        }
+
+      apr_pool_cleanup_register(result_pool, threads[started].pool,
+                                destroy_thread_pool, apr_pool_cleanup_null);
+    }
+#endif
+
+  run_upgrade_jobs(&batch, result_pool);
+
+#if APR_HAS_THREADS
+  for (i = 0; i < started; i++)
+    {
+      apr_status_t retval;
+      apr_status_t status = apr_thread_join(&retval, threads[i].thread);
+      if (status)
+        err = svn_error_compose_create(err,
+                       svn_error_wrap_apr(status,
+                                          _("Can't join upgrade thread")));
+    }
+#endif
+
+  return svn_error_trace(err);
+}
+
+/* An upgrade job copying a text-base into the pristine store. */
+typedef struct text_base_job_t
+{
+  /* What to copy where. */
+  const char *text_base_path;
+  const char *new_wcroot_abspath;
+
+  /* The results of copy_text_base(). */
+  svn_checksum_t *md5_checksum;
+  svn_checksum_t *sha1_checksum;
+  svn_filesize_t size;
+} text_base_job_t;
+
+/* Implements upgrade_job_func_t for text_base_job_t BATON.  Calculate the
+   checksums of the text-base and copy it to the pristine store. */
+static svn_error_t *
+copy_text_base(void *baton,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  text_base_job_t *job = baton;
+  const char *pristine_path;
+  const char *temp_path;
+  apr_finfo_t finfo;
+  svn_stream_t *read_stream;
+  svn_stream_t *result_stream;
+
+  /* Create a copy and calculate a checksum in one step */
+  SVN_ERR(svn_stream_open_unique(&result_stream, &temp_path,
+                                 job->new_wcroot_abspath,
+                                 svn_io_file_del_none,
+                                 scratch_pool, scratch_pool));
+
+  SVN_ERR(svn_stream_open_readonly(&read_stream, job->text_base_path,
+                                   scratch_pool, scratch_pool));
+
+  read_stream = svn_stream_checksummed2(read_stream, &job->md5_checksum,
+                                        NULL, svn_checksum_md5,
+                                        TRUE, result_pool);
+
+  read_stream = svn_stream_checksummed2(read_stream, &job->sha1_checksum,
+                                        NULL, svn_checksum_sha1,
+                                        TRUE, result_pool);
+
+  /* This calculates the hash, creates a copy and closes the stream */
+  SVN_ERR(svn_stream_copy3(read_stream, result_stream,
+                           NULL, NULL, scratch_pool));
+
+  SVN_ERR(svn_io_stat(&finfo, job->text_base_path, APR_FINFO_SIZE,
+                      scratch_pool));
+  job->size = finfo.size;
+
+  SVN_ERR(svn_wc__db_pristine_get_future_path(&pristine_path,
+                                              job->new_wcroot_abspath,
+                                              job->sha1_checksum,
+                                              scratch_pool, scratch_pool));
+
+  /* Ensure any sharding directories exist. */
+  SVN_ERR(svn_wc__ensure_directory(svn_dirent_dirname(pristine_path,
+                                                      scratch_pool),
+                                   scratch_pool));
+
+  /* Now move the file into the pristine store, overwriting
+     existing files with the same checksum. */
+  return svn_error_trace(svn_io_file_move(temp_path, pristine_path,
+                                          scratch_pool));
+}
+
 /* Copy all the text-base files from the administrative area of WC directory
    DIR_ABSPATH into the pristine store of SDB which is located in directory
-   NEW_WCROOT_ABSPATH.
+   NEW_WCROOT_ABSPATH.  The files get copied on multiple threads.
 
    Set *TEXT_BASES_INFO to a new hash, allocated in RESULT_POOL, that maps
    (const char *) name of the versioned file to (svn_wc__text_base_info_t *)
@@ -1192,78 +1412,60 @@ migrate_text_bases(apr_hash_t **text_bases_info,
   const char *text_base_dir = svn_wc__adm_child(dir_abspath,
                                                 TEXT_BASE_SUBDIR,
                                                 scratch_pool);
+  const char **basenames;
+  void **jobs;
+  svn_error_t **errs;
+  svn_error_t *err = SVN_NO_ERROR;
+  int count = 0;
+  int i;
 
   *text_bases_info = apr_hash_make(result_pool);
 
   /* Iterate over the text-base files */
   SVN_ERR(svn_io_get_dirents3(&dirents, text_base_dir, TRUE,
                               scratch_pool, scratch_pool));
+
+  basenames = apr_palloc(scratch_pool,
+                         apr_hash_count(dirents) * sizeof(*basenames));
+  jobs = apr_palloc(scratch_pool, apr_hash_count(dirents) * sizeof(*jobs));
   for (hi = apr_hash_first(scratch_pool, dirents); hi;
        hi = apr_hash_next(hi))
     {
-      const char *text_base_basename = apr_hash_this_key(hi);
-      svn_checksum_t *md5_checksum;
-      svn_checksum_t *sha1_checksum;
-
-      svn_pool_clear(iterpool);
+      text_base_job_t *job = apr_pcalloc(scratch_pool, sizeof(*job));
 
-      /* Calculate its checksums and copy it to the pristine store */
-      {
-        const char *pristine_path;
-        const char *text_base_path;
-        const char *temp_path;
-        svn_sqlite__stmt_t *stmt;
-        apr_finfo_t finfo;
-        svn_stream_t *read_stream;
-        svn_stream_t *result_stream;
-
-        text_base_path = svn_dirent_join(text_base_dir, text_base_basename,
-                                         iterpool);
-
-        /* Create a copy and calculate a checksum in one step */
-        SVN_ERR(svn_stream_open_unique(&result_stream, &temp_path,
-                                       new_wcroot_abspath,
-                                       svn_io_file_del_none,
-                                       iterpool, iterpool));
-
-        SVN_ERR(svn_stream_open_readonly(&read_stream, text_base_path,
-                                           iterpool, iterpool));
+      basenames[count] = apr_hash_this_key(hi);
+      job->text_base_path = svn_dirent_join(text_base_dir, basenames[count],
+                                            scratch_pool);
+      job->new_wcroot_abspath = new_wcroot_abspath;
+      jobs[count++] = job;
+    }
 
-        read_stream = svn_stream_checksummed2(read_stream, &md5_checksum,
-                                              NULL, svn_checksum_md5,
-                                              TRUE, iterpool);
+  /* Calculate their checksums and copy them to the pristine store */
+  SVN_ERR(run_upgrade_batch(&errs, copy_text_base, jobs, count,
+                            scratch_pool, scratch_pool));
+  for (i = 0; i < count; i++)
+    err = svn_error_compose_create(err, errs[i]);
+  SVN_ERR(err);
 
-        read_stream = svn_stream_checksummed2(read_stream, &sha1_checksum,
-                                              NULL, svn_checksum_sha1,
-                                              TRUE, iterpool);
+  for (i = 0; i < count; i++)
+    {
+      const char *text_base_basename = basenames[i];
+      text_base_job_t *job = jobs[i];
 
-        /* This calculates the hash, creates a copy and closes the stream */
-        SVN_ERR(svn_stream_copy3(read_stream, result_stream,
-                                 NULL, NULL, iterpool));
+      svn_pool_clear(iterpool);
 
-        SVN_ERR(svn_io_stat(&finfo, text_base_path, APR_FINFO_SIZE, iterpool));
+      /* Insert a row into the pristine table. */
+      {
+        svn_sqlite__stmt_t *stmt;
 
-        /* Insert a row into the pristine table. */
         SVN_ERR(svn_sqlite__get_statement(&stmt, sdb,
                                           STMT_INSERT_OR_IGNORE_PRISTINE));
-        SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, sha1_checksum, iterpool));
-        SVN_ERR(svn_sqlite__bind_checksum(stmt, 2, md5_checksum, iterpool));
-        SVN_ERR(svn_sqlite__bind_int64(stmt, 3, finfo.size));
+        SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, job->sha1_checksum,
+                                          iterpool));
+        SVN_ERR(svn_sqlite__bind_checksum(stmt, 2, job->md5_checksum,
+                                          iterpool));
+        SVN_ERR(svn_sqlite__bind_int64(stmt, 3, job->size));
         SVN_ERR(svn_sqlite__insert(NULL, stmt));
-
-        SVN_ERR(svn_wc__db_pristine_get_future_path(&pristine_path,
-                                                    new_wcroot_abspath,
-                                                    sha1_checksum,
-                                                    iterpool, iterpool));
-
-        /* Ensure any sharding directories exist. */
-        SVN_ERR(svn_wc__ensure_directory(svn_dirent_dirname(pristine_path,
-                                                            iterpool),
-                                         iterpool));
-
-        /* Now move the file into the pristine store, overwriting
-           existing files with the same checksum. */
-        SVN_ERR(svn_io_file_move(temp_path, pristine_path, iterpool));
       }
 
       /* Add the checksums for this text-base to *TEXT_BASES_INFO. */
@@ -1307,8 +1509,10 @@ migrate_text_bases(apr_hash_t **text_bases_info,
           info = apr_pcalloc(result_pool, sizeof (*info));
         file_info = (is_revert_base ? &info->revert_base : &info->normal_base);
 
-        file_info->sha1_checksum = svn_checksum_dup(sha1_checksum, result_pool);
-        file_info->md5_checksum = svn_checksum_dup(md5_checksum, result_pool);
+        file_info->sha1_checksum = svn_checksum_dup(job->sha1_checksum,
+                                                    result_pool);
+        file_info->md5_checksum = svn_checksum_dup(job->md5_checksum,
+                                                   result_pool);
         svn_hash_sets(*text_bases_info, versioned_file_name, info);
       }
     }
@@ -1911,12 +2115,16 @@ struct upgrade_data_t {
 
    *DATA refers to the single root db.
 
+   If ENTRIES is not NULL, it holds the entries of DIR_ABSPATH, as read
+   by read_locked_entries().
+
    Uses SCRATCH_POOL for all temporary allocation.  */
 static svn_error_t *
 upgrade_to_wcng(void **dir_baton,
                 void *parent_baton,
                 svn_wc__db_t *db,
                 const char *dir_abspath,
+                apr_hash_t *entries,
                 int old_format,
                 apr_int64_t wc_id,
                 svn_wc_upgrade_get_repos_info_t repos_info_func,
@@ -1929,7 +2137,6 @@ upgrade_to_wcng(void **dir_baton,
   const char *logfile_path = svn_wc__adm_child(dir_abspath, ADM_LOG,
                                                scratch_pool);
   svn_node_kind_t logfile_on_disk_kind;
-  apr_hash_t *entries;
   svn_wc_entry_t *this_dir;
   const char *old_wcroot_abspath, *dir_relpath;
   apr_hash_t *text_bases_info;
@@ -1975,8 +2182,9 @@ upgrade_to_wcng(void **dir_baton,
    */
 
   /***** ENTRIES - READ *****/
-  SVN_ERR(svn_wc__read_entries_old(&entries, dir_abspath,
-                                   scratch_pool, scratch_pool));
+  if (!entries)
+    SVN_ERR(svn_wc__read_entries_old(&entries, dir_abspath,
+                                     scratch_pool, scratch_pool));
 
   this_dir = svn_hash_gets(entries, SVN_WC_ENTRY_THIS_DIR);
   SVN_ERR(ensure_repos_info(this_dir, dir_abspath,
@@ -2204,11 +2412,58 @@ svn_wc__upgrade_sdb(int *result_format,
 }
 
 
-/* */
+/* An upgrade job reading the entries of a directory. */
+typedef struct entries_job_t
+{
+  const char *dir_abspath;
+
+  /* The result of read_locked_entries(). */
+  apr_hash_t *entries;
+} entries_job_t;
+
+/* Implements upgrade_job_func_t for entries_job_t BATON.  Lock the
+   directory and read its entries, like upgrade_to_wcng() would.  Leave
+   directories with old log files and wc-ng directories to the serial
+   code, which will report or skip them. */
+static svn_error_t *
+read_locked_entries(void *baton,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  entries_job_t *job = baton;
+  svn_node_kind_t kind;
+
+  SVN_ERR(svn_io_check_path(svn_wc__adm_child(job->dir_abspath, ADM_LOG,
+                                              scratch_pool),
+                            &kind, scratch_pool));
+  if (kind == svn_node_file)
+    return SVN_NO_ERROR;
+
+  /* Don't lock working copies that are already in wc-ng format. */
+  SVN_ERR(svn_io_check_path(svn_wc__adm_child(job->dir_abspath, SDB_FILE,
+                                              scratch_pool),
+                            &kind, scratch_pool));
+  if (kind != svn_node_none)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(create_physical_lock(job->dir_abspath, scratch_pool));
+
+  return svn_error_trace(svn_wc__read_entries_old(&job->entries,
+                                                  job->dir_abspath,
+                                                  result_pool,
+                                                  scratch_pool));
+}
+
+/* Upgrade DIR_ABSPATH and its subdirectories.  If ENTRIES is not NULL,
+   it holds the entries of DIR_ABSPATH, as read by read_locked_entries().
+
+   The entries of the subdirectories get read on multiple threads before
+   descending into them. */
 static svn_error_t *
 upgrade_working_copy(void *parent_baton,
                      svn_wc__db_t *db,
                      const char *dir_abspath,
+                     apr_hash_t *entries,
                      svn_wc_upgrade_get_repos_info_t repos_info_func,
                      void *repos_info_baton,
                      apr_hash_t *repos_cache,
@@ -2224,6 +2479,8 @@ upgrade_working_copy(void *parent_baton,
   int old_format;
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
   apr_array_header_t *subdirs;
+  void **jobs;
+  svn_error_t **errs;
   svn_error_t *err;
   int i;
 
@@ -2244,7 +2501,7 @@ upgrade_working_copy(void *parent_baton,
       return SVN_NO_ERROR;
     }
 
-  err = get_versioned_subdirs(&subdirs, NULL, dir_abspath, FALSE,
+  err = get_versioned_subdirs(&subdirs, NULL, dir_abspath, entries, FALSE,
                               scratch_pool, iterpool);
   if (err)
     {
@@ -2266,7 +2523,7 @@ upgrade_working_copy(void *parent_baton,
 
 
   SVN_ERR(upgrade_to_wcng(&dir_baton, parent_baton, db, dir_abspath,
-                          old_format, data->wc_id,
+                          entries, old_format, data->wc_id,
                           repos_info_func, repos_info_baton,
                           repos_cache, data, scratch_pool, iterpool));
 
@@ -2276,13 +2533,34 @@ upgrade_working_copy(void *parent_baton,
                                      iterpool),
                 iterpool);
 
+  /* Read the entries of all subdirectories at once.  Whatever fails here
+     gets retried and reported in the usual way. */
+  jobs = apr_palloc(scratch_pool, subdirs->nelts * sizeof(*jobs));
+  for (i = 0; i < subdirs->nelts; ++i)
+    {
+      entries_job_t *job = apr_pcalloc(scratch_pool, sizeof(*job));
+
+      job->dir_abspath = APR_ARRAY_IDX(subdirs, i, const char *);
+      jobs[i] = job;
+    }
+  SVN_ERR(run_upgrade_batch(&errs, read_locked_entries, jobs, subdirs->nelts,
+                            scratch_pool, iterpool));
+
   for (i = 0; i < subdirs->nelts; ++i)
     {
       const char *child_abspath = APR_ARRAY_IDX(subdirs, i, const char *);
+      entries_job_t *job = jobs[i];
 
       svn_pool_clear(iterpool);
 
+      if (errs[i])
+        {
+          svn_error_clear(errs[i]);
+          job->entries = NULL;
+        }
+
       SVN_ERR(upgrade_working_copy(dir_baton, db, child_abspath,
+                                   job->entries,
                                    repos_info_func, repos_info_baton,
                                    repos_cache, data,
                                    cancel_func, cancel_baton,
@@ -2483,7 +2761,7 @@ svn_wc_upgrade(svn_wc_context_t *wc_ctx,
                                    scratch_pool));
 
   SVN_SQLITE__WITH_LOCK(
-    upgrade_working_copy(NULL, db, local_abspath,
+    upgrade_working_copy(NULL, db, local_abspath, NULL,
                          repos_info_func, repos_info_baton,
                          repos_cache, &data,
                          cancel_func, cancel_baton,
@@ -80,7 +80,7 @@ CREATE UNIQUE INDEX I_LOCAL_ABSPATH ON WCROOT (local_abspath);
    derived from the 'checksum' column.  Each pristine text is referenced by
    any number of rows in the NODES and ACTUAL_NODE tables.
 
-   In future, the pristine text file may be compressed.
+   The pristine text file may be compressed, see the 'compression' column.
  */
 CREATE TABLE PRISTINE (
   /* The SHA-1 checksum of the pristine text. This is a unique key. The
@@ -88,13 +88,15 @@ CREATE TABLE PRISTINE (
      pristine texts referenced from this database. */
   checksum  TEXT NOT NULL PRIMARY KEY,
 
-  /* Enumerated values specifying type of compression. The only value
-     supported so far is NULL, meaning that no compression has been applied
-     and the pristine text is stored verbatim in the file. */
+  /* Enumerated values specifying type of compression. NULL means that no
+     compression has been applied and the pristine text is stored verbatim
+     in the file. 1 means that the file, which has a different name, holds
+     the text as written by svn_stream_compressed(). */
   compression  INTEGER,
 
   /* The size in bytes of the file in which the pristine text is stored.
-     Used to verify the pristine file is "proper". */
+     Used to verify the pristine file is "proper". For compressed pristine
+     texts, this is the size of the text itself. */
   size  INTEGER NOT NULL,
 
   /* The number of rows in the NODES table that have a 'checksum' column
@@ -85,6 +85,17 @@ LEFT OUTER JOIN lock ON nodes.repos_id = lock.repos_id
   AND nodes.repos_path = lock.repos_relpath
 WHERE wc_id = ?1 AND parent_relpath = ?2 AND op_depth = 0
 
+-- STMT_SELECT_BASE_DESCENDANTS_INFO_LOCK
+/* Like STMT_SELECT_BASE_CHILDREN_INFO_LOCK, but for a whole subtree. */
+SELECT local_relpath, nodes.repos_id, nodes.repos_path, presence, kind,
+  revision, depth, file_external,
+  lock_token, lock_owner, lock_comment, lock_date
+FROM nodes
+LEFT OUTER JOIN lock ON nodes.repos_id = lock.repos_id
+  AND nodes.repos_path = lock.repos_relpath
+WHERE wc_id = ?1 AND IS_STRICT_DESCENDANT_OF(local_relpath, ?2)
+  AND op_depth = 0
+
 
 -- STMT_SELECT_WORKING_NODE
 SELECT op_depth, presence, kind, checksum, translated_size,
@@ -152,6 +163,19 @@ LEFT OUTER JOIN lock ON nodes.repos_id = lock.repos_id
 WHERE wc_id = ?1 AND parent_relpath = ?2 AND op_depth = 0
 ORDER BY local_relpath DESC
 
+-- STMT_SELECT_NODE_DESCENDANTS_INFO
+/* Like STMT_SELECT_NODE_CHILDREN_INFO, but for a whole subtree.  Only the
+   rows of each node have to be together, in the same order. */
+SELECT op_depth, nodes.repos_id, nodes.repos_path, presence, kind, revision,
+  checksum, translated_size, changed_revision, changed_date, changed_author,
+  depth, symlink_target, last_mod_time, properties, lock_token, lock_owner,
+  lock_comment, lock_date, local_relpath, moved_here, moved_to, file_external
+FROM nodes
+LEFT OUTER JOIN lock ON nodes.repos_id = lock.repos_id
+  AND nodes.repos_path = lock.repos_relpath AND nodes.op_depth = 0
+WHERE wc_id = ?1 AND IS_STRICT_DESCENDANT_OF(local_relpath, ?2)
+ORDER BY local_relpath DESC, op_depth DESC
+
 -- STMT_SELECT_NODE_CHILDREN_WALKER_INFO
 SELECT local_relpath, op_depth, presence, kind
 FROM nodes_current
@@ -163,6 +187,11 @@ SELECT local_relpath, changelist, properties, conflict_data
 FROM actual_node
 WHERE wc_id = ?1 AND parent_relpath = ?2
 
+-- STMT_SELECT_ACTUAL_DESCENDANTS_INFO
+SELECT local_relpath, changelist, properties, conflict_data
+FROM actual_node
+WHERE wc_id = ?1 AND IS_STRICT_DESCENDANT_OF(local_relpath, ?2)
+
 -- STMT_SELECT_REPOSITORY_BY_ID
 SELECT root, uuid FROM repository WHERE id = ?1
 
@@ -555,6 +584,13 @@ WHERE wc_id = ?1 AND local_relpath = ?2
   AND op_depth = (SELECT MAX(op_depth) FROM nodes
                   WHERE wc_id = ?1 AND local_relpath = ?2)
 
+-- STMT_CLEAR_RECENT_LAST_MOD_TIMES
+UPDATE nodes SET last_mod_time = NULL
+WHERE wc_id = ?1
+  AND (?2 = '' OR local_relpath = ?2
+       OR IS_STRICT_DESCENDANT_OF(local_relpath, ?2))
+  AND last_mod_time >= ?3
+
 -- STMT_INSERT_ACTUAL_CONFLICT
 INSERT INTO actual_node (wc_id, local_relpath, conflict_data, parent_relpath)
 VALUES (?1, ?2, ?3, ?4)
@@ -869,24 +905,28 @@ INSERT INTO work_queue (work) VALUES (?1)
 -- STMT_SELECT_WORK_ITEM
 SELECT id, work FROM work_queue ORDER BY id LIMIT 1
 
+-- STMT_SELECT_WORK_ITEMS
+SELECT id, work FROM work_queue ORDER BY id LIMIT ?1
+
 -- STMT_DELETE_WORK_ITEM
 DELETE FROM work_queue WHERE id = ?1
 
 -- STMT_INSERT_OR_IGNORE_PRISTINE
-INSERT OR IGNORE INTO pristine (checksum, md5_checksum, size, refcount)
-VALUES (?1, ?2, ?3, 0)
+INSERT OR IGNORE INTO pristine (checksum, md5_checksum, size, refcount,
+                                compression)
+VALUES (?1, ?2, ?3, 0, ?4)
 
 -- STMT_INSERT_PRISTINE
-INSERT INTO pristine (checksum, md5_checksum, size, refcount)
-VALUES (?1, ?2, ?3, 0)
+INSERT INTO pristine (checksum, md5_checksum, size, refcount, compression)
+VALUES (?1, ?2, ?3, 0, ?4)
 
 -- STMT_SELECT_PRISTINE
-SELECT md5_checksum
+SELECT md5_checksum, compression
 FROM pristine
 WHERE checksum = ?1
 
 -- STMT_SELECT_PRISTINE_SIZE
-SELECT size
+SELECT size, compression
 FROM pristine
 WHERE checksum = ?1 LIMIT 1
 
@@ -896,17 +936,21 @@ FROM pristine
 WHERE md5_checksum = ?1
 
 -- STMT_SELECT_UNREFERENCED_PRISTINES
-SELECT checksum
+SELECT checksum, compression
 FROM pristine
 WHERE refcount = 0
 
+-- STMT_DELETE_UNREFERENCED_PRISTINES
+DELETE FROM pristine
+WHERE refcount = 0
+
 -- STMT_DELETE_PRISTINE_IF_UNREFERENCED
 DELETE FROM pristine
 WHERE checksum = ?1 AND refcount = 0
 
 -- STMT_SELECT_COPY_PRISTINES
 /* For the root itself */
-SELECT n.checksum, md5_checksum, size
+SELECT n.checksum, md5_checksum, size, compression
 FROM nodes_current n
 LEFT JOIN pristine p ON n.checksum = p.checksum
 WHERE wc_id = ?1
@@ -914,7 +958,7 @@ WHERE wc_id = ?1
   AND n.checksum IS NOT NULL
 UNION ALL
 /* And all descendants */
-SELECT n.checksum, md5_checksum, size
+SELECT n.checksum, md5_checksum, size, compression
 FROM nodes n
 LEFT JOIN pristine p ON n.checksum = p.checksum
 WHERE wc_id = ?1
@@ -348,6 +348,37 @@ svn_wc__internal_file_modified_p(svn_boolean_t *modified_p,
                                  svn_boolean_t exact_comparison,
                                  apr_pool_t *scratch_pool);
 
+/* Bulk variant of svn_wc__internal_file_modified_p() for the children of
+ * DIR_ABSPATH.  CHILDREN maps names to struct svn_wc__db_info_t *, as
+ * returned by svn_wc__db_read_children_info().  DIRENTS maps names to
+ * svn_io_dirent2_t * for what is on disk, as returned by
+ * svn_io_get_dirents3(); if it is NULL, read it from disk.
+ *
+ * Compare the files among CHILDREN whose size or timestamp differs from
+ * the recorded info against their pristine texts, on multiple threads
+ * where possible.  Set *MODIFIED to a hash mapping the names of the
+ * compared files to svn_boolean_t * telling whether they are modified.
+ * Files that match their recorded info, that can't be compared without
+ * accessing DB on every read (like symlinks) or whose comparison failed
+ * are not in *MODIFIED; use svn_wc__internal_file_modified_p() for them.
+ *
+ * If a write-lock is held, record the file info of the unmodified files
+ * in a single transaction.
+ *
+ * Allocate *MODIFIED in RESULT_POOL.
+ */
+svn_error_t *
+svn_wc__internal_children_modified(apr_hash_t **modified,
+                                   svn_wc__db_t *db,
+                                   const char *dir_abspath,
+                                   apr_hash_t *children,
+                                   apr_hash_t *dirents,
+                                   svn_boolean_t exact_comparison,
+                                   svn_cancel_func_t cancel_func,
+                                   void *cancel_baton,
+                                   apr_pool_t *result_pool,
+                                   apr_pool_t *scratch_pool);
+
 
 /* Prepare to merge a file content change into the working copy.
 
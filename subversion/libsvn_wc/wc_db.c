@@ -1615,6 +1615,12 @@ svn_wc__db_get_wcroot(const char **wcroot_abspath,
   return SVN_NO_ERROR;
 }
 
+svn_config_t *
+svn_wc__db_get_config(svn_wc__db_t *db)
+{
+  return db->config;
+}
+
 
 svn_error_t *
 svn_wc__db_base_add_directory(svn_wc__db_t *db,
@@ -2665,9 +2671,14 @@ svn_wc__db_base_get_info(svn_wc__db_status_t *status,
   return SVN_NO_ERROR;
 }
 
-/* The implementation of svn_wc__db_base_get_children_info */
+/* The implementation of svn_wc__db_base_get_children_info and, if DIRS
+   is not NULL, of svn_wc__db_base_get_descendants_info.  In the latter
+   case, read all BASE nodes below LOCAL_RELPATH and put them into DIRS,
+   which maps the relpath of their parent to a hash like *NODES, instead
+   of into *NODES. */
 static svn_error_t *
 base_get_children_info(apr_hash_t **nodes,
+                       apr_hash_t *dirs,
                        svn_wc__db_wcroot_t *wcroot,
                        const char *local_relpath,
                        svn_boolean_t obtain_locks,
@@ -2679,12 +2690,18 @@ base_get_children_info(apr_hash_t **nodes,
   apr_int64_t last_repos_id = INVALID_REPOS_ID;
   const char *last_repos_root_url = NULL;
 
-  *nodes = apr_hash_make(result_pool);
+  if (dirs)
+    SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                      STMT_SELECT_BASE_DESCENDANTS_INFO_LOCK));
+  else
+    {
+      *nodes = apr_hash_make(result_pool);
 
-  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+      SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
                                     obtain_locks
                                       ? STMT_SELECT_BASE_CHILDREN_INFO_LOCK
                                       : STMT_SELECT_BASE_CHILDREN_INFO));
+    }
   SVN_ERR(svn_sqlite__bindf(stmt, "is", wcroot->wc_id, local_relpath));
 
   SVN_ERR(svn_sqlite__step(&have_row, stmt));
@@ -2696,6 +2713,21 @@ base_get_children_info(apr_hash_t **nodes,
       const char *child_relpath = svn_sqlite__column_text(stmt, 0, NULL);
       const char *name = svn_relpath_basename(child_relpath, result_pool);
 
+      if (dirs)
+        {
+          const char *slash = strrchr(child_relpath, '/');
+          apr_size_t parent_len = slash ? slash - child_relpath : 0;
+
+          *nodes = apr_hash_get(dirs, child_relpath, parent_len);
+          if (*nodes == NULL)
+            {
+              *nodes = apr_hash_make(result_pool);
+              apr_hash_set(dirs, apr_pstrmemdup(result_pool, child_relpath,
+                                                parent_len),
+                           parent_len, *nodes);
+            }
+        }
+
       info = apr_pcalloc(result_pool, sizeof(*info));
 
       repos_id = svn_sqlite__column_int64(stmt, 1);
@@ -2756,7 +2788,7 @@ svn_wc__db_base_get_children_info(apr_hash_t **nodes,
                               dir_abspath, scratch_pool, scratch_pool));
   VERIFY_USABLE_WCROOT(wcroot);
 
-  return svn_error_trace(base_get_children_info(nodes,
+  return svn_error_trace(base_get_children_info(nodes, NULL,
                                                 wcroot,
                                                 local_relpath,
                                                 TRUE /* obtain_locks */,
@@ -2764,6 +2796,44 @@ svn_wc__db_base_get_children_info(apr_hash_t **nodes,
                                                 scratch_pool));
 }
 
+svn_error_t *
+svn_wc__db_base_get_descendants_info(apr_hash_t **nodes_by_dir,
+                                     svn_wc__db_t *db,
+                                     const char *dir_abspath,
+                                     apr_pool_t *result_pool,
+                                     apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *dir_relpath;
+  apr_hash_t *dirs = apr_hash_make(scratch_pool);
+  apr_hash_t *nodes;
+  apr_hash_index_t *hi;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(dir_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &dir_relpath, db,
+                                                dir_abspath,
+                                                scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  /* DIR_ABSPATH itself has an entry even if it has no children. */
+  apr_hash_set(dirs, dir_relpath, APR_HASH_KEY_STRING,
+               apr_hash_make(result_pool));
+
+  SVN_ERR(base_get_children_info(&nodes, dirs, wcroot, dir_relpath,
+                                 TRUE /* obtain_locks */,
+                                 result_pool, scratch_pool));
+
+  *nodes_by_dir = apr_hash_make(result_pool);
+  for (hi = apr_hash_first(scratch_pool, dirs); hi; hi = apr_hash_next(hi))
+    svn_hash_sets(*nodes_by_dir,
+                  svn_dirent_join(wcroot->abspath, apr_hash_this_key(hi),
+                                  result_pool),
+                  apr_hash_this_val(hi));
+
+  return SVN_NO_ERROR;
+}
+
 
 svn_error_t *
 svn_wc__db_base_get_props(apr_hash_t **props,
@@ -6098,6 +6168,35 @@ svn_wc__db_global_record_fileinfo(svn_wc__db_t *db,
 }
 
 
+svn_error_t *
+svn_wc__db_global_forget_racy_timestamps(svn_wc__db_t *db,
+                                         const char *local_abspath,
+                                         apr_time_t limit,
+                                         apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(local_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              local_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_CLEAR_RECENT_LAST_MOD_TIMES));
+  SVN_ERR(svn_sqlite__bindf(stmt, "isi", wcroot->wc_id, local_relpath,
+                            limit));
+  SVN_ERR(svn_sqlite__step_done(stmt));
+
+  SVN_ERR(flush_entries(wcroot, local_abspath, svn_depth_infinity,
+                        scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+
 /* Set the ACTUAL_NODE properties column for (WC_ID, LOCAL_RELPATH) to
  * PROPS.
  *
@@ -9174,6 +9273,174 @@ svn_wc__db_read_info_internal(svn_wc__db_status_t *status,
 }
 
 
+/* Everything svn_wc__db_read_info() can return about a node. */
+typedef struct node_info_t
+{
+  svn_wc__db_status_t status;
+  svn_node_kind_t kind;
+  svn_revnum_t revision;
+  const char *repos_relpath;
+  const char *repos_root_url;
+  const char *repos_uuid;
+  svn_revnum_t changed_rev;
+  apr_time_t changed_date;
+  const char *changed_author;
+  svn_depth_t depth;
+  const svn_checksum_t *checksum;
+  const char *target;
+  const char *original_repos_relpath;
+  const char *original_root_url;
+  const char *original_uuid;
+  svn_revnum_t original_revision;
+  svn_wc__db_lock_t *lock;
+  svn_filesize_t recorded_size;
+  apr_time_t recorded_time;
+  const char *changelist;
+  svn_boolean_t conflicted;
+  svn_boolean_t op_root;
+  svn_boolean_t have_props;
+  svn_boolean_t props_mod;
+  svn_boolean_t have_base;
+  svn_boolean_t have_more_work;
+  svn_boolean_t have_work;
+} node_info_t;
+
+/* Results of svn_wc__db_read_info() for one wcroot.  Only nodes read
+   outside of any transaction get cached and the whole cache gets dropped
+   as soon as this connection has changed anything in the database.
+   Changes made through other connections are not detected, which is why
+   this cache must be enabled explicitly. */
+struct svn_wc__db_node_cache_t
+{
+  /* const char *local_relpath -> node_info_t *info */
+  apr_hash_t *nodes;
+
+  /* svn_sqlite__total_changes() at the time NODES became valid. */
+  int changes;
+
+  /* Pool for NODES and its contents. */
+  apr_pool_t *pool;
+};
+
+/* Drop all cached nodes once there are this many of them. */
+#define NODE_CACHE_MAX_ENTRIES 65536
+
+/* Return the node cache of WCROOT, creating it in DB's state pool, or NULL
+   if DB does not cache nodes or the cache can't be used right now.  Empty
+   the cache if its contents might be outdated. */
+static struct svn_wc__db_node_cache_t *
+get_node_cache(svn_wc__db_t *db,
+               svn_wc__db_wcroot_t *wcroot)
+{
+  struct svn_wc__db_node_cache_t *cache = wcroot->node_cache;
+  int changes;
+
+  /* Whatever we read within a transaction may still get rolled back. */
+  if (!db->cache_nodes || svn_sqlite__in_transaction(wcroot->sdb))
+    return NULL;
+
+  changes = svn_sqlite__total_changes(wcroot->sdb);
+  if (cache == NULL)
+    {
+      cache = apr_pcalloc(db->state_pool, sizeof(*cache));
+      cache->pool = svn_pool_create(db->state_pool);
+      cache->nodes = apr_hash_make(cache->pool);
+      cache->changes = changes;
+      wcroot->node_cache = cache;
+    }
+  else if (cache->changes != changes
+           || apr_hash_count(cache->nodes) >= NODE_CACHE_MAX_ENTRIES)
+    {
+      svn_pool_clear(cache->pool);
+      cache->nodes = apr_hash_make(cache->pool);
+      cache->changes = changes;
+    }
+
+  return cache;
+}
+
+/* Return a copy of LOCK allocated in RESULT_POOL. */
+static svn_wc__db_lock_t *
+dup_lock(const svn_wc__db_lock_t *lock,
+         apr_pool_t *result_pool)
+{
+  svn_wc__db_lock_t *result;
+
+  if (lock == NULL)
+    return NULL;
+
+  result = apr_pmemdup(result_pool, lock, sizeof(*lock));
+  result->token = apr_pstrdup(result_pool, lock->token);
+  result->owner = apr_pstrdup(result_pool, lock->owner);
+  result->comment = apr_pstrdup(result_pool, lock->comment);
+
+  return result;
+}
+
+/* Set *INFO to the cached information about LOCAL_RELPATH in WCROOT,
+   reading it from the database and adding it to CACHE if necessary. */
+static svn_error_t *
+get_cached_node(const node_info_t **info,
+                struct svn_wc__db_node_cache_t *cache,
+                svn_wc__db_wcroot_t *wcroot,
+                const char *local_relpath,
+                apr_pool_t *scratch_pool)
+{
+  node_info_t *tmp;
+  node_info_t *result;
+  apr_int64_t repos_id, original_repos_id;
+
+  *info = svn_hash_gets(cache->nodes, local_relpath);
+  if (*info)
+    return SVN_NO_ERROR;
+
+  /* Read into SCRATCH_POOL first, so that failed lookups don't take up
+     space in the cache. */
+  tmp = apr_pcalloc(scratch_pool, sizeof(*tmp));
+  SVN_WC__DB_WITH_TXN4(
+          read_info(&tmp->status, &tmp->kind, &tmp->revision,
+                    &tmp->repos_relpath, &repos_id,
+                    &tmp->changed_rev, &tmp->changed_date,
+                    &tmp->changed_author, &tmp->depth, &tmp->checksum,
+                    &tmp->target, &tmp->original_repos_relpath,
+                    &original_repos_id, &tmp->original_revision,
+                    &tmp->lock, &tmp->recorded_size, &tmp->recorded_time,
+                    &tmp->changelist, &tmp->conflicted, &tmp->op_root,
+                    &tmp->have_props, &tmp->props_mod, &tmp->have_base,
+                    &tmp->have_more_work, &tmp->have_work,
+                    wcroot, local_relpath, scratch_pool, scratch_pool),
+          svn_wc__db_fetch_repos_info(&tmp->repos_root_url,
+                                      &tmp->repos_uuid,
+                                      wcroot, repos_id, scratch_pool),
+          svn_wc__db_fetch_repos_info(&tmp->original_root_url,
+                                      &tmp->original_uuid,
+                                      wcroot, original_repos_id,
+                                      scratch_pool),
+        SVN_NO_ERROR,
+        wcroot);
+
+  result = apr_pmemdup(cache->pool, tmp, sizeof(*tmp));
+  result->repos_relpath = apr_pstrdup(cache->pool, tmp->repos_relpath);
+  result->repos_root_url = apr_pstrdup(cache->pool, tmp->repos_root_url);
+  result->repos_uuid = apr_pstrdup(cache->pool, tmp->repos_uuid);
+  result->changed_author = apr_pstrdup(cache->pool, tmp->changed_author);
+  result->checksum = svn_checksum_dup(tmp->checksum, cache->pool);
+  result->target = apr_pstrdup(cache->pool, tmp->target);
+  result->original_repos_relpath = apr_pstrdup(cache->pool,
+                                               tmp->original_repos_relpath);
+  result->original_root_url = apr_pstrdup(cache->pool,
+                                          tmp->original_root_url);
+  result->original_uuid = apr_pstrdup(cache->pool, tmp->original_uuid);
+  result->lock = dup_lock(tmp->lock, cache->pool);
+  result->changelist = apr_pstrdup(cache->pool, tmp->changelist);
+
+  svn_hash_sets(cache->nodes, apr_pstrdup(cache->pool, local_relpath),
+                result);
+  *info = result;
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_wc__db_read_info(svn_wc__db_status_t *status,
                      svn_node_kind_t *kind,
@@ -9210,6 +9477,7 @@ svn_wc__db_read_info(svn_wc__db_status_t *status,
   svn_wc__db_wcroot_t *wcroot;
   const char *local_relpath;
   apr_int64_t repos_id, original_repos_id;
+  struct svn_wc__db_node_cache_t *cache;
 
   SVN_ERR_ASSERT(svn_dirent_is_absolute(local_abspath));
 
@@ -9217,6 +9485,74 @@ svn_wc__db_read_info(svn_wc__db_status_t *status,
                               local_abspath, scratch_pool, scratch_pool));
   VERIFY_USABLE_WCROOT(wcroot);
 
+  cache = get_node_cache(db, wcroot);
+  if (cache)
+    {
+      const node_info_t *info;
+
+      SVN_ERR(get_cached_node(&info, cache, wcroot, local_relpath,
+                              scratch_pool));
+
+      if (status)
+        *status = info->status;
+      if (kind)
+        *kind = info->kind;
+      if (revision)
+        *revision = info->revision;
+      if (repos_relpath)
+        *repos_relpath = apr_pstrdup(result_pool, info->repos_relpath);
+      if (repos_root_url)
+        *repos_root_url = apr_pstrdup(result_pool, info->repos_root_url);
+      if (repos_uuid)
+        *repos_uuid = apr_pstrdup(result_pool, info->repos_uuid);
+      if (changed_rev)
+        *changed_rev = info->changed_rev;
+      if (changed_date)
+        *changed_date = info->changed_date;
+      if (changed_author)
+        *changed_author = apr_pstrdup(result_pool, info->changed_author);
+      if (depth)
+        *depth = info->depth;
+      if (checksum)
+        *checksum = svn_checksum_dup(info->checksum, result_pool);
+      if (target)
+        *target = apr_pstrdup(result_pool, info->target);
+      if (original_repos_relpath)
+        *original_repos_relpath = apr_pstrdup(result_pool,
+                                              info->original_repos_relpath);
+      if (original_root_url)
+        *original_root_url = apr_pstrdup(result_pool,
+                                         info->original_root_url);
+      if (original_uuid)
+        *original_uuid = apr_pstrdup(result_pool, info->original_uuid);
+      if (original_revision)
+        *original_revision = info->original_revision;
+      if (lock)
+        *lock = dup_lock(info->lock, result_pool);
+      if (recorded_size)
+        *recorded_size = info->recorded_size;
+      if (recorded_time)
+        *recorded_time = info->recorded_time;
+      if (changelist)
+        *changelist = apr_pstrdup(result_pool, info->changelist);
+      if (conflicted)
+        *conflicted = info->conflicted;
+      if (op_root)
+        *op_root = info->op_root;
+      if (have_props)
+        *have_props = info->have_props;
+      if (props_mod)
+        *props_mod = info->props_mod;
+      if (have_base)
+        *have_base = info->have_base;
+      if (have_more_work)
+        *have_more_work = info->have_more_work;
+      if (have_work)
+        *have_work = info->have_work;
+
+      return SVN_NO_ERROR;
+    }
+
   SVN_WC__DB_WITH_TXN4(
           read_info(status, kind, revision, repos_relpath, &repos_id,
                     changed_rev, changed_date, changed_author,
@@ -9274,12 +9610,58 @@ struct read_children_info_item_t
   svn_boolean_t was_dir;
 };
 
-/* Implementation of svn_wc__db_read_children_info */
+/* The children of one directory found by a recursive read_children_info. */
+typedef struct dir_children_t
+{
+  /* Like the NODES and CONFLICTS of svn_wc__db_read_children_info. */
+  apr_hash_t *nodes;
+  apr_hash_t *conflicts;
+} dir_children_t;
+
+/* Return the entry for the directory whose relpath are the first
+   DIR_RELPATH_LEN bytes of DIR_RELPATH in DIRS, creating it in RESULT_POOL
+   if necessary. */
+static dir_children_t *
+get_dir_children(apr_hash_t *dirs,
+                 const char *dir_relpath,
+                 apr_size_t dir_relpath_len,
+                 apr_pool_t *result_pool)
+{
+  dir_children_t *dir = apr_hash_get(dirs, dir_relpath, dir_relpath_len);
+
+  if (dir == NULL)
+    {
+      dir = apr_palloc(result_pool, sizeof(*dir));
+      dir->nodes = apr_hash_make(result_pool);
+      dir->conflicts = apr_hash_make(result_pool);
+      apr_hash_set(dirs, apr_pstrmemdup(result_pool, dir_relpath,
+                                        dir_relpath_len),
+                   dir_relpath_len, dir);
+    }
+
+  return dir;
+}
+
+/* Return the length of the parent relpath of the non-root LOCAL_RELPATH. */
+static apr_size_t
+parent_relpath_len(const char *local_relpath)
+{
+  const char *slash = strrchr(local_relpath, '/');
+
+  return slash ? slash - local_relpath : 0;
+}
+
+/* Implementation of svn_wc__db_read_children_info and, if DIRS is not
+   NULL, of svn_wc__db_read_descendants_info.  In the latter case, read all
+   nodes below DIR_RELPATH and put them into the dir_children_t entries of
+   DIRS, keyed by the relpath of their parent, instead of into CONFLICTS
+   and NODES. */
 static svn_error_t *
 read_children_info(svn_wc__db_wcroot_t *wcroot,
                    const char *dir_relpath,
                    apr_hash_t *conflicts,
                    apr_hash_t *nodes,
+                   apr_hash_t *dirs,
                    svn_boolean_t base_tree_only,
                    apr_pool_t *result_pool,
                    apr_pool_t *scratch_pool)
@@ -9291,10 +9673,14 @@ read_children_info(svn_wc__db_wcroot_t *wcroot,
   apr_int64_t last_repos_id = INVALID_REPOS_ID;
   const char *last_repos_root_url = NULL;
 
-  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
-                                    (base_tree_only
-                                     ? STMT_SELECT_BASE_NODE_CHILDREN_INFO
-                                     : STMT_SELECT_NODE_CHILDREN_INFO)));
+  if (dirs)
+    SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                      STMT_SELECT_NODE_DESCENDANTS_INFO));
+  else
+    SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                      (base_tree_only
+                                       ? STMT_SELECT_BASE_NODE_CHILDREN_INFO
+                                       : STMT_SELECT_NODE_CHILDREN_INFO)));
   SVN_ERR(svn_sqlite__bindf(stmt, "is", wcroot->wc_id, dir_relpath));
   SVN_ERR(svn_sqlite__step(&have_row, stmt));
 
@@ -9309,6 +9695,17 @@ read_children_info(svn_wc__db_wcroot_t *wcroot,
       int op_depth;
       svn_boolean_t new_child;
 
+      if (dirs)
+        {
+          dir_children_t *dir
+            = get_dir_children(dirs, child_relpath,
+                               parent_relpath_len(child_relpath),
+                               result_pool);
+
+          nodes = dir->nodes;
+          conflicts = dir->conflicts;
+        }
+
       child_item = (base_tree_only ? NULL : svn_hash_gets(nodes, name));
       if (child_item)
         new_child = FALSE;
@@ -9371,7 +9768,9 @@ read_children_info(svn_wc__db_wcroot_t *wcroot,
                                                  svn_sqlite__reset(stmt)));
                 }
 
-              if (last_repos_id == INVALID_REPOS_ID)
+              /* A whole subtree may legitimately contain file externals
+                 from other repositories. */
+              if (last_repos_id == INVALID_REPOS_ID || dirs)
                 last_repos_id = repos_id;
 
               /* Assume working copy is all one repos_id so that a
@@ -9406,6 +9805,12 @@ read_children_info(svn_wc__db_wcroot_t *wcroot,
               child_item->was_dir = TRUE;
               child->depth = svn_sqlite__column_token_null(stmt, 11, depth_map,
                                                            svn_depth_unknown);
+
+              /* Make sure empty directories get an entry as well. */
+              if (dirs)
+                get_dir_children(dirs, child_relpath, strlen(child_relpath),
+                                 result_pool);
+
               if (new_child)
                 {
                   err = is_wclocked(&child->locked, wcroot, child_relpath,
@@ -9521,7 +9926,9 @@ read_children_info(svn_wc__db_wcroot_t *wcroot,
   if (!base_tree_only)
     {
       SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
-                                        STMT_SELECT_ACTUAL_CHILDREN_INFO));
+                                        dirs
+                                        ? STMT_SELECT_ACTUAL_DESCENDANTS_INFO
+                                        : STMT_SELECT_ACTUAL_CHILDREN_INFO));
       SVN_ERR(svn_sqlite__bindf(stmt, "is", wcroot->wc_id, dir_relpath));
       SVN_ERR(svn_sqlite__step(&have_row, stmt));
 
@@ -9532,6 +9939,17 @@ read_children_info(svn_wc__db_wcroot_t *wcroot,
           const char *child_relpath = svn_sqlite__column_text(stmt, 0, NULL);
           const char *name = svn_relpath_basename(child_relpath, NULL);
 
+          if (dirs)
+            {
+              dir_children_t *dir
+                = get_dir_children(dirs, child_relpath,
+                                   parent_relpath_len(child_relpath),
+                                   result_pool);
+
+              nodes = dir->nodes;
+              conflicts = dir->conflicts;
+            }
+
           child_item = svn_hash_gets(nodes, name);
           if (!child_item)
             {
@@ -9596,13 +10014,58 @@ svn_wc__db_read_children_info(apr_hash_t **nodes,
   VERIFY_USABLE_WCROOT(wcroot);
 
   SVN_WC__DB_WITH_TXN(
-    read_children_info(wcroot, dir_relpath, *conflicts, *nodes,
+    read_children_info(wcroot, dir_relpath, *conflicts, *nodes, NULL,
                        base_tree_only, result_pool, scratch_pool),
     wcroot);
 
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_wc__db_read_descendants_info(apr_hash_t **nodes_by_dir,
+                                 apr_hash_t **conflicts_by_dir,
+                                 svn_wc__db_t *db,
+                                 const char *dir_abspath,
+                                 apr_pool_t *result_pool,
+                                 apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *dir_relpath;
+  apr_hash_t *dirs = apr_hash_make(scratch_pool);
+  apr_hash_index_t *hi;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(dir_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &dir_relpath, db,
+                                                dir_abspath,
+                                                scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  /* DIR_ABSPATH itself has an entry even if it has no children. */
+  get_dir_children(dirs, dir_relpath, strlen(dir_relpath), result_pool);
+
+  SVN_WC__DB_WITH_TXN(
+    read_children_info(wcroot, dir_relpath, NULL, NULL, dirs,
+                       FALSE /* base_tree_only */,
+                       result_pool, scratch_pool),
+    wcroot);
+
+  *nodes_by_dir = apr_hash_make(result_pool);
+  *conflicts_by_dir = apr_hash_make(result_pool);
+  for (hi = apr_hash_first(scratch_pool, dirs); hi; hi = apr_hash_next(hi))
+    {
+      const char *relpath = apr_hash_this_key(hi);
+      const dir_children_t *dir = apr_hash_this_val(hi);
+      const char *abspath = svn_dirent_join(wcroot->abspath, relpath,
+                                            result_pool);
+
+      svn_hash_sets(*nodes_by_dir, abspath, dir->nodes);
+      svn_hash_sets(*conflicts_by_dir, abspath, dir->conflicts);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Implementation of svn_wc__db_read_single_info.
 
    ### This function is very similar to a lot of code inside
@@ -12205,7 +12668,7 @@ bump_node_revision(svn_wc__db_wcroot_t *wcroot,
 
   iterpool = svn_pool_create(scratch_pool);
 
-  SVN_ERR(base_get_children_info(&children, wcroot, local_relpath, 0,
+  SVN_ERR(base_get_children_info(&children, NULL, wcroot, local_relpath, 0,
                                  scratch_pool, iterpool));
   for (hi = apr_hash_first(scratch_pool, children); hi; hi = apr_hash_next(hi))
     {
@@ -13599,6 +14062,91 @@ svn_wc__db_wq_record_and_fetch_next(apr_uint64_t *id,
   return SVN_NO_ERROR;
 }
 
+/* Implements svn_wc__db_wq_record_and_fetch_batch(). */
+static svn_error_t *
+wq_record_and_fetch_batch(apr_array_header_t *ids,
+                          apr_array_header_t *work_items,
+                          svn_wc__db_wcroot_t *wcroot,
+                          const apr_array_header_t *completed_ids,
+                          apr_hash_t *record_map,
+                          int max_items,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  int i;
+
+  for (i = 0; completed_ids && i < completed_ids->nelts; i++)
+    {
+      SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                        STMT_DELETE_WORK_ITEM));
+      SVN_ERR(svn_sqlite__bind_int64(stmt, 1,
+                                     APR_ARRAY_IDX(completed_ids, i,
+                                                   apr_uint64_t)));
+      SVN_ERR(svn_sqlite__step_done(stmt));
+    }
+
+  if (record_map)
+    SVN_ERR(wq_record(wcroot, record_map, scratch_pool));
+
+  if (max_items <= 0)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_SELECT_WORK_ITEMS));
+  SVN_ERR(svn_sqlite__bind_int(stmt, 1, max_items));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+
+  while (have_row)
+    {
+      apr_size_t len;
+      const void *val = svn_sqlite__column_blob(stmt, 1, &len, result_pool);
+
+      APR_ARRAY_PUSH(ids, apr_uint64_t) = svn_sqlite__column_int64(stmt, 0);
+      APR_ARRAY_PUSH(work_items, svn_skel_t *) = svn_skel__parse(val, len,
+                                                                 result_pool);
+
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+svn_error_t *
+svn_wc__db_wq_record_and_fetch_batch(apr_array_header_t **ids,
+                                     apr_array_header_t **work_items,
+                                     svn_wc__db_t *db,
+                                     const char *wri_abspath,
+                                     const apr_array_header_t *completed_ids,
+                                     apr_hash_t *record_map,
+                                     int max_items,
+                                     apr_pool_t *result_pool,
+                                     apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              wri_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  *ids = apr_array_make(result_pool, MAX(max_items, 0),
+                        sizeof(apr_uint64_t));
+  *work_items = apr_array_make(result_pool, MAX(max_items, 0),
+                               sizeof(svn_skel_t *));
+
+  SVN_WC__DB_WITH_TXN(
+    wq_record_and_fetch_batch(*ids, *work_items, wcroot, completed_ids,
+                              record_map, max_items,
+                              result_pool, scratch_pool),
+    wcroot);
+
+  return SVN_NO_ERROR;
+}
+
 
 
 /* ### temporary API. remove before release.  */
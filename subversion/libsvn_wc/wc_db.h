@@ -361,6 +361,10 @@ svn_wc__db_get_wcroot(const char **wcroot_abspath,
                       apr_pool_t *result_pool,
                       apr_pool_t *scratch_pool);
 
+/* Return the configuration DB has been opened with, which may be NULL. */
+svn_config_t *
+svn_wc__db_get_config(svn_wc__db_t *db);
+
 
 /* @} */
 
@@ -814,6 +818,22 @@ svn_wc__db_base_get_children_info(apr_hash_t **nodes,
                                   apr_pool_t *result_pool,
                                   apr_pool_t *scratch_pool);
 
+/* Like svn_wc__db_base_get_children_info, but for DIR_ABSPATH and all
+   directories below it in the same working copy at once, using a single
+   query instead of one per directory.
+
+   Return in *NODES_BY_DIR a hash mapping the absolute path of each such
+   directory to its *NODES hash as returned by
+   svn_wc__db_base_get_children_info.  Directories that are not in
+   *NODES_BY_DIR have no BASE children in this working copy.
+ */
+svn_error_t *
+svn_wc__db_base_get_descendants_info(apr_hash_t **nodes_by_dir,
+                                     svn_wc__db_t *db,
+                                     const char *dir_abspath,
+                                     apr_pool_t *result_pool,
+                                     apr_pool_t *scratch_pool);
+
 
 /* Set *PROPS to the properties of the node LOCAL_ABSPATH in the BASE tree.
 
@@ -902,6 +922,10 @@ svn_wc__db_base_get_lock_tokens_recursive(apr_hash_t **lock_tokens,
 /* Set *PRISTINE_ABSPATH to the path to the pristine text file
    identified by SHA1_CHECKSUM.  Error if it does not exist.
 
+   If the pristine text is stored compressed, the path is that of a
+   decompressed copy in the temporary area, which will be removed when
+   RESULT_POOL gets cleaned up.
+
    ### This is temporary - callers should not be looking at the file
    directly.
 
@@ -915,8 +939,8 @@ svn_wc__db_pristine_get_path(const char **pristine_abspath,
                              apr_pool_t *scratch_pool);
 
 /* Set *PRISTINE_ABSPATH to the path under WCROOT_ABSPATH that will be
-   used by the pristine text identified by SHA1_CHECKSUM.  The file
-   need not exist.
+   used by the uncompressed pristine text identified by SHA1_CHECKSUM.
+   The file need not exist.
  */
 svn_error_t *
 svn_wc__db_pristine_get_future_path(const char **pristine_abspath,
@@ -925,6 +949,38 @@ svn_wc__db_pristine_get_future_path(const char **pristine_abspath,
                                     apr_pool_t *result_pool,
                                     apr_pool_t *scratch_pool);
 
+/* Set *PRISTINE_ABSPATH to the path of the file that holds the pristine
+   text identified by SHA1_CHECKSUM within the WC identified by WRI_ABSPATH
+   in DB and set *COMPRESSED to whether the text is stored compressed in it.
+   If the pristine text is not in the store, return the path an
+   uncompressed text would have.
+
+   Use svn_wc__db_pristine_open_file() to read the file.
+
+   Allocate the path in RESULT_POOL. */
+svn_error_t *
+svn_wc__db_pristine_get_file(const char **pristine_abspath,
+                             svn_boolean_t *compressed,
+                             svn_wc__db_t *db,
+                             const char *wri_abspath,
+                             const svn_checksum_t *sha1_checksum,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool);
+
+/* Set *CONTENTS to a readable stream that yields the pristine text stored
+   in the file PRISTINE_ABSPATH, decompressing it if COMPRESSED is set, as
+   returned by svn_wc__db_pristine_get_file().
+
+   This does not access the database and may be called from any thread.
+
+   Allocate the stream in RESULT_POOL. */
+svn_error_t *
+svn_wc__db_pristine_open_file(svn_stream_t **contents,
+                              const char *pristine_abspath,
+                              svn_boolean_t compressed,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool);
+
 
 /* If requested set *CONTENTS to a readable stream that will yield the pristine
    text identified by SHA1_CHECKSUM (must be a SHA-1 checksum) within the WC
@@ -958,6 +1014,9 @@ typedef struct svn_wc__db_install_data_t
    set to the MD-5 and SHA-1 checksums respectively of that file.
    MD5_CHECKSUM and/or SHA1_CHECKSUM may be NULL if not wanted.
 
+   If DB has been opened with the compress-pristines option, the text will
+   be stored compressed.
+
    Allocate the new stream, path and checksums in RESULT_POOL.
  */
 svn_error_t *
@@ -2047,6 +2106,25 @@ svn_wc__db_read_children_info(apr_hash_t **nodes,
                               apr_pool_t *result_pool,
                               apr_pool_t *scratch_pool);
 
+/* Like svn_wc__db_read_children_info, but for DIR_ABSPATH and all
+   directories below it in the same working copy at once, using a single
+   query instead of one per directory.
+
+   Return in *NODES_BY_DIR a hash mapping the absolute path of each such
+   directory to its *NODES hash as returned by
+   svn_wc__db_read_children_info, and in *CONFLICTS_BY_DIR a hash mapping
+   it to its *CONFLICTS hash.  Directories that are not in *NODES_BY_DIR
+   have not been read, e.g. because they are not versioned as directories
+   in this working copy.
+ */
+svn_error_t *
+svn_wc__db_read_descendants_info(apr_hash_t **nodes_by_dir,
+                                 apr_hash_t **conflicts_by_dir,
+                                 svn_wc__db_t *db,
+                                 const char *dir_abspath,
+                                 apr_pool_t *result_pool,
+                                 apr_pool_t *scratch_pool);
+
 /* Like svn_wc__db_read_children_info, but only gets an info node for the root
    element.
 
@@ -2662,6 +2740,19 @@ svn_wc__db_global_record_fileinfo(svn_wc__db_t *db,
                                   apr_time_t recorded_time,
                                   apr_pool_t *scratch_pool);
 
+/* Forget the last modification time recorded for all files at or below
+   LOCAL_ABSPATH in the working copy it is in, if it is LIMIT or later.
+   The files will be compared against their pristine versions the next
+   time svn_wc__internal_file_modified_p() gets asked about them.
+
+   Use this instead of waiting for the filesystem timestamps to tick over
+   after writing files; see svn_io__racy_timestamp_limit(). */
+svn_error_t *
+svn_wc__db_global_forget_racy_timestamps(svn_wc__db_t *db,
+                                         const char *local_abspath,
+                                         apr_time_t limit,
+                                         apr_pool_t *scratch_pool);
+
 
 /* ### post-commit handling.
    ### maybe multiple phases?
@@ -3028,6 +3119,25 @@ svn_wc__db_wq_record_and_fetch_next(apr_uint64_t *id,
                                     apr_pool_t *result_pool,
                                     apr_pool_t *scratch_pool);
 
+/* Batch variant of svn_wc__db_wq_record_and_fetch_next().  In a single
+   transaction, mark the work items whose apr_uint64_t ids are in
+   COMPLETED_IDS as completed, record timestamps and sizes from RECORD_MAP,
+   and return up to MAX_ITEMS of the next work items in *WORK_ITEMS, as
+   svn_skel_t *, with their ids in *IDS.
+
+   COMPLETED_IDS and RECORD_MAP may be NULL.  The work items are returned
+   in the order they must be run. */
+svn_error_t *
+svn_wc__db_wq_record_and_fetch_batch(apr_array_header_t **ids,
+                                     apr_array_header_t **work_items,
+                                     svn_wc__db_t *db,
+                                     const char *wri_abspath,
+                                     const apr_array_header_t *completed_ids,
+                                     apr_hash_t *record_map,
+                                     int max_items,
+                                     apr_pool_t *result_pool,
+                                     apr_pool_t *scratch_pool);
+
 
 /* @} */
 
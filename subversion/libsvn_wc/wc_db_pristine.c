@@ -37,22 +37,31 @@
 #include "wc_db_private.h"
 
 #define PRISTINE_STORAGE_EXT ".svn-base"
+#define PRISTINE_COMPRESSED_EXT ".svn-base.z"
 #define PRISTINE_STORAGE_RELPATH "pristine"
 #define PRISTINE_TEMPDIR_RELPATH "tmp"
 
+/* Value of the PRISTINE.compression column for texts written through
+   svn_stream_compressed().  Such texts get stored under a different file
+   name, so that clients that don't know about compression won't mistake
+   them for verbatim texts. */
+#define PRISTINE_COMPRESSION_ZLIB 1
+
 
 
 /* Returns in PRISTINE_ABSPATH a new string allocated from RESULT_POOL,
    holding the local absolute path to the file location that is dedicated
    to hold CHECKSUM's pristine file, relating to the pristine store
    configured for the working copy indicated by PDH. The returned path
-   does not necessarily currently exist.
+   does not necessarily currently exist.  If COMPRESSED is set, return
+   the path used for the compressed variant of the text.
 
    Any other allocations are made in SCRATCH_POOL. */
 static svn_error_t *
 get_pristine_fname(const char **pristine_abspath,
                    const char *wcroot_abspath,
                    const svn_checksum_t *sha1_checksum,
+                   svn_boolean_t compressed,
                    apr_pool_t *result_pool,
                    apr_pool_t *scratch_pool)
 {
@@ -80,7 +89,9 @@ get_pristine_fname(const char **pristine_abspath,
   subdir[1] = hexdigest[1];
   subdir[2] = '\0';
 
-  hexdigest = apr_pstrcat(scratch_pool, hexdigest, PRISTINE_STORAGE_EXT,
+  hexdigest = apr_pstrcat(scratch_pool, hexdigest,
+                          compressed ? PRISTINE_COMPRESSED_EXT
+                                     : PRISTINE_STORAGE_EXT,
                           SVN_VA_NULL);
 
   /* The file is located at DIR/.svn/pristine/XX/XXYYZZ...svn-base */
@@ -92,6 +103,66 @@ get_pristine_fname(const char **pristine_abspath,
   return SVN_NO_ERROR;
 }
 
+/* Return the absolute path to the temporary directory for pristine text
+   files within WCROOT. */
+static char *
+pristine_get_tempdir(svn_wc__db_wcroot_t *wcroot,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  return svn_dirent_join_many(result_pool, wcroot->abspath,
+                              svn_wc_get_adm_dir(scratch_pool),
+                              PRISTINE_TEMPDIR_RELPATH, SVN_VA_NULL);
+}
+
+/* Set *PRESENT to whether the pristine text SHA1_CHECKSUM has a row in
+ * the PRISTINE table of WCROOT.  If so, set *SIZE, unless SIZE is NULL, to
+ * the size of the text and *COMPRESSED to whether it is stored compressed.
+ */
+static svn_error_t *
+get_pristine_info(svn_boolean_t *present,
+                  svn_filesize_t *size,
+                  svn_boolean_t *compressed,
+                  svn_wc__db_wcroot_t *wcroot,
+                  const svn_checksum_t *sha1_checksum,
+                  apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_SELECT_PRISTINE_SIZE));
+  SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, sha1_checksum, scratch_pool));
+  SVN_ERR(svn_sqlite__step(present, stmt));
+
+  if (size)
+    *size = svn_sqlite__column_int64(stmt, 0);
+  *compressed = (*present && !svn_sqlite__column_is_null(stmt, 1));
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+svn_error_t *
+svn_wc__db_pristine_open_file(svn_stream_t **contents,
+                              const char *pristine_abspath,
+                              svn_boolean_t compressed,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool)
+{
+  apr_file_t *file;
+
+  /* We don't enable APR_BUFFERED on this file to maximize throughput
+   * e.g. for fulltext comparison.  As we use SVN__STREAM_CHUNK_SIZE buffers
+   * where needed in streams, there is no point in having another layer of
+   * buffers. */
+  SVN_ERR(svn_io_file_open(&file, pristine_abspath, APR_READ,
+                           APR_OS_DEFAULT, result_pool));
+  *contents = svn_stream_from_aprfile2(file, FALSE, result_pool);
+
+  if (compressed)
+    *contents = svn_stream_compressed(*contents, result_pool);
+
+  return SVN_NO_ERROR;
+}
 
 svn_error_t *
 svn_wc__db_pristine_get_path(const char **pristine_abspath,
@@ -104,6 +175,7 @@ svn_wc__db_pristine_get_path(const char **pristine_abspath,
   svn_wc__db_wcroot_t *wcroot;
   const char *local_relpath;
   svn_boolean_t present;
+  svn_boolean_t compressed;
 
   SVN_ERR_ASSERT(pristine_abspath != NULL);
   SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
@@ -130,8 +202,37 @@ svn_wc__db_pristine_get_path(const char **pristine_abspath,
                              svn_checksum_to_cstring_display(sha1_checksum,
                                                              scratch_pool));
 
+  SVN_ERR(get_pristine_info(&present, NULL, &compressed, wcroot,
+                            sha1_checksum, scratch_pool));
+
+  if (compressed)
+    {
+      /* Our callers want to read the file directly, so give them a
+         decompressed copy. */
+      const char *compressed_abspath;
+      svn_stream_t *src_stream;
+      svn_stream_t *dst_stream;
+
+      SVN_ERR(get_pristine_fname(&compressed_abspath, wcroot->abspath,
+                                 sha1_checksum, TRUE,
+                                 scratch_pool, scratch_pool));
+      SVN_ERR(svn_wc__db_pristine_open_file(&src_stream, compressed_abspath,
+                                            TRUE, scratch_pool,
+                                            scratch_pool));
+      SVN_ERR(svn_stream_open_unique(&dst_stream, pristine_abspath,
+                                     pristine_get_tempdir(wcroot,
+                                                          scratch_pool,
+                                                          scratch_pool),
+                                     svn_io_file_del_on_pool_cleanup,
+                                     result_pool, scratch_pool));
+      SVN_ERR(svn_stream_copy3(src_stream, dst_stream, NULL, NULL,
+                               scratch_pool));
+
+      return SVN_NO_ERROR;
+    }
+
   SVN_ERR(get_pristine_fname(pristine_abspath, wcroot->abspath,
-                             sha1_checksum,
+                             sha1_checksum, FALSE,
                              result_pool, scratch_pool));
 
   return SVN_NO_ERROR;
@@ -145,14 +246,43 @@ svn_wc__db_pristine_get_future_path(const char **pristine_abspath,
                                     apr_pool_t *scratch_pool)
 {
   SVN_ERR(get_pristine_fname(pristine_abspath, wcroot_abspath,
-                             sha1_checksum,
+                             sha1_checksum, FALSE,
+                             result_pool, scratch_pool));
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__db_pristine_get_file(const char **pristine_abspath,
+                             svn_boolean_t *compressed,
+                             svn_wc__db_t *db,
+                             const char *wri_abspath,
+                             const svn_checksum_t *sha1_checksum,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+  svn_boolean_t present;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
+  SVN_ERR_ASSERT(sha1_checksum->kind == svn_checksum_sha1);
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              wri_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  SVN_ERR(get_pristine_info(&present, NULL, compressed, wcroot,
+                            sha1_checksum, scratch_pool));
+  SVN_ERR(get_pristine_fname(pristine_abspath, wcroot->abspath,
+                             sha1_checksum, *compressed,
                              result_pool, scratch_pool));
+
   return SVN_NO_ERROR;
 }
 
 /* Set *CONTENTS to a readable stream from which the pristine text
- * identified by SHA1_CHECKSUM and PRISTINE_ABSPATH can be read from the
- * pristine store of WCROOT.  If SIZE is not null, set *SIZE to the size
+ * identified by SHA1_CHECKSUM can be read from the pristine store of
+ * WCROOT.  If SIZE is not null, set *SIZE to the size
  * in bytes of that text. If that text is not in the pristine store,
  * return an error.
  *
@@ -170,24 +300,16 @@ pristine_read_txn(svn_stream_t **contents,
                   svn_filesize_t *size,
                   svn_wc__db_wcroot_t *wcroot,
                   const svn_checksum_t *sha1_checksum,
-                  const char *pristine_abspath,
                   apr_pool_t *result_pool,
                   apr_pool_t *scratch_pool)
 {
-  svn_sqlite__stmt_t *stmt;
   svn_boolean_t have_row;
+  svn_boolean_t compressed;
 
   /* Check that this pristine text is present in the store.  (The presence
    * of the file is not sufficient.) */
-  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
-                                    STMT_SELECT_PRISTINE_SIZE));
-  SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, sha1_checksum, scratch_pool));
-  SVN_ERR(svn_sqlite__step(&have_row, stmt));
-
-  if (size)
-    *size = svn_sqlite__column_int64(stmt, 0);
-
-  SVN_ERR(svn_sqlite__reset(stmt));
+  SVN_ERR(get_pristine_info(&have_row, size, &compressed, wcroot,
+                            sha1_checksum, scratch_pool));
   if (! have_row)
     {
       return svn_error_createf(SVN_ERR_WC_PATH_NOT_FOUND, NULL,
@@ -197,18 +319,17 @@ pristine_read_txn(svn_stream_t **contents,
     }
 
   /* Open the file as a readable stream.  It will remain readable even when
-   * deleted from disk; APR guarantees that on Windows as well as Unix.
-   *
-   * We also don't enable APR_BUFFERED on this file to maximize throughput
-   * e.g. for fulltext comparison.  As we use SVN__STREAM_CHUNK_SIZE buffers
-   * where needed in streams, there is no point in having another layer of
-   * buffers. */
+   * deleted from disk; APR guarantees that on Windows as well as Unix. */
   if (contents)
     {
-      apr_file_t *file;
-      SVN_ERR(svn_io_file_open(&file, pristine_abspath, APR_READ,
-                               APR_OS_DEFAULT, result_pool));
-      *contents = svn_stream_from_aprfile2(file, FALSE, result_pool);
+      const char *pristine_abspath;
+
+      SVN_ERR(get_pristine_fname(&pristine_abspath, wcroot->abspath,
+                                 sha1_checksum, compressed,
+                                 scratch_pool, scratch_pool));
+      SVN_ERR(svn_wc__db_pristine_open_file(contents, pristine_abspath,
+                                            compressed, result_pool,
+                                            scratch_pool));
     }
 
   return SVN_NO_ERROR;
@@ -225,7 +346,6 @@ svn_wc__db_pristine_read(svn_stream_t **contents,
 {
   svn_wc__db_wcroot_t *wcroot;
   const char *local_relpath;
-  const char *pristine_abspath;
 
   SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
 
@@ -243,12 +363,9 @@ svn_wc__db_pristine_read(svn_stream_t **contents,
                               wri_abspath, scratch_pool, scratch_pool));
   VERIFY_USABLE_WCROOT(wcroot);
 
-  SVN_ERR(get_pristine_fname(&pristine_abspath, wcroot->abspath,
-                             sha1_checksum,
-                             scratch_pool, scratch_pool));
   SVN_WC__DB_WITH_TXN(
     pristine_read_txn(contents, size,
-                      wcroot, sha1_checksum, pristine_abspath,
+                      wcroot, sha1_checksum,
                       result_pool, scratch_pool),
     wcroot);
 
@@ -256,18 +373,6 @@ svn_wc__db_pristine_read(svn_stream_t **contents,
 }
 
 
-/* Return the absolute path to the temporary directory for pristine text
-   files within WCROOT. */
-static char *
-pristine_get_tempdir(svn_wc__db_wcroot_t *wcroot,
-                     apr_pool_t *result_pool,
-                     apr_pool_t *scratch_pool)
-{
-  return svn_dirent_join_many(result_pool, wcroot->abspath,
-                              svn_wc_get_adm_dir(scratch_pool),
-                              PRISTINE_TEMPDIR_RELPATH, SVN_VA_NULL);
-}
-
 /* Install the pristine text described by BATON into the pristine store of
  * SDB.  If it is already stored then just delete the new file
  * BATON->tempfile_abspath.
@@ -287,23 +392,35 @@ pristine_install_txn(svn_sqlite__db_t *sdb,
                      const svn_checksum_t *sha1_checksum,
                      /* The pristine text's MD-5 checksum. */
                      const svn_checksum_t *md5_checksum,
+                     /* Whether the file is compressed. */
+                     svn_boolean_t compressed,
+                     /* The size of the text, if compressed. */
+                     svn_filesize_t size,
                      apr_pool_t *scratch_pool)
 {
   svn_sqlite__stmt_t *stmt;
   svn_boolean_t have_row;
+#ifdef SVN_DEBUG
+  svn_boolean_t have_compressed;
+#endif
 
   /* If this pristine text is already present in the store, just keep it:
    * delete the new one and return. */
   SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_SELECT_PRISTINE));
   SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, sha1_checksum, scratch_pool));
   SVN_ERR(svn_sqlite__step(&have_row, stmt));
+#ifdef SVN_DEBUG
+  have_compressed = (have_row && !svn_sqlite__column_is_null(stmt, 1));
+#endif
   SVN_ERR(svn_sqlite__reset(stmt));
 
   if (have_row)
     {
 #ifdef SVN_DEBUG
       /* Consistency checks.  Verify both files exist and match.
+       * Compressed files may differ in size, so skip them.
        * ### We could check much more. */
+      if (!compressed && !have_compressed)
       {
         apr_finfo_t finfo1, finfo2;
 
@@ -341,7 +458,9 @@ pristine_install_txn(svn_sqlite__db_t *sdb,
     SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_INSERT_PRISTINE));
     SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, sha1_checksum, scratch_pool));
     SVN_ERR(svn_sqlite__bind_checksum(stmt, 2, md5_checksum, scratch_pool));
-    SVN_ERR(svn_sqlite__bind_int64(stmt, 3, finfo.size));
+    SVN_ERR(svn_sqlite__bind_int64(stmt, 3, compressed ? size : finfo.size));
+    if (compressed)
+      SVN_ERR(svn_sqlite__bind_int(stmt, 4, PRISTINE_COMPRESSION_ZLIB));
     SVN_ERR(svn_sqlite__insert(NULL, stmt));
 
     SVN_ERR(svn_io_set_file_read_only(pristine_abspath, FALSE, scratch_pool));
@@ -354,8 +473,37 @@ struct svn_wc__db_install_data_t
 {
   svn_wc__db_wcroot_t *wcroot;
   svn_stream_t *inner_stream;
+
+  /* If the text gets stored compressed, the stream compressing into
+     INNER_STREAM and the number of bytes written to it. */
+  svn_stream_t *compressed_stream;
+  svn_filesize_t size;
 };
 
+/* Implements svn_write_fn_t, passing the data on to the compressing
+   stream of the svn_wc__db_install_data_t BATON and counting it. */
+static svn_error_t *
+write_handler_install(void *baton,
+                      const char *data,
+                      apr_size_t *len)
+{
+  svn_wc__db_install_data_t *install_data = baton;
+
+  SVN_ERR(svn_stream_write(install_data->compressed_stream, data, len));
+  install_data->size += *len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_close_fn_t for the svn_wc__db_install_data_t BATON. */
+static svn_error_t *
+close_handler_install(void *baton)
+{
+  svn_wc__db_install_data_t *install_data = baton;
+
+  return svn_error_trace(svn_stream_close(install_data->compressed_stream));
+}
+
 svn_error_t *
 svn_wc__db_pristine_prepare_install(svn_stream_t **stream,
                                     svn_wc__db_install_data_t **install_data,
@@ -388,6 +536,16 @@ svn_wc__db_pristine_prepare_install(svn_stream_t **stream,
 
   (*install_data)->inner_stream = *stream;
 
+  if (db->compress_pristines)
+    {
+      (*install_data)->compressed_stream
+        = svn_stream_compressed(*stream, result_pool);
+
+      *stream = svn_stream_create(*install_data, result_pool);
+      svn_stream_set_write(*stream, write_handler_install);
+      svn_stream_set_close(*stream, close_handler_install);
+    }
+
   if (md5_checksum)
     *stream = svn_stream_checksummed2(*stream, NULL, md5_checksum,
                                       svn_checksum_md5, FALSE, result_pool);
@@ -414,6 +572,7 @@ svn_wc__db_pristine_install(svn_wc__db_install_data_t *install_data,
 
   SVN_ERR(get_pristine_fname(&pristine_abspath, wcroot->abspath,
                              sha1_checksum,
+                             install_data->compressed_stream != NULL,
                              scratch_pool, scratch_pool));
 
   /* Ensure the SQL txn has at least a 'RESERVED' lock before we start looking
@@ -422,6 +581,8 @@ svn_wc__db_pristine_install(svn_wc__db_install_data_t *install_data,
     pristine_install_txn(wcroot->sdb,
                          install_data->inner_stream, pristine_abspath,
                          sha1_checksum, md5_checksum,
+                         install_data->compressed_stream != NULL,
+                         install_data->size,
                          scratch_pool),
     wcroot->sdb);
 
@@ -514,13 +675,15 @@ svn_wc__db_pristine_get_sha1(const svn_checksum_t **sha1_checksum,
 }
 
 /* Handle the moving of a pristine from SRC_WCROOT to DST_WCROOT. The existing
-   pristine in SRC_WCROOT is described by CHECKSUM, MD5_CHECKSUM and SIZE */
+   pristine in SRC_WCROOT is described by CHECKSUM, MD5_CHECKSUM, SIZE and
+   COMPRESSED.  The file gets copied as is. */
 static svn_error_t *
 maybe_transfer_one_pristine(svn_wc__db_wcroot_t *src_wcroot,
                             svn_wc__db_wcroot_t *dst_wcroot,
                             const svn_checksum_t *checksum,
                             const svn_checksum_t *md5_checksum,
                             apr_int64_t size,
+                            svn_boolean_t compressed,
                             svn_cancel_func_t cancel_func,
                             void *cancel_baton,
                             apr_pool_t *scratch_pool)
@@ -539,6 +702,8 @@ maybe_transfer_one_pristine(svn_wc__db_wcroot_t *src_wcroot,
   SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, checksum, scratch_pool));
   SVN_ERR(svn_sqlite__bind_checksum(stmt, 2, md5_checksum, scratch_pool));
   SVN_ERR(svn_sqlite__bind_int64(stmt, 3, size));
+  if (compressed)
+    SVN_ERR(svn_sqlite__bind_int(stmt, 4, PRISTINE_COMPRESSION_ZLIB));
 
   SVN_ERR(svn_sqlite__update(&affected_rows, stmt));
 
@@ -553,7 +718,7 @@ maybe_transfer_one_pristine(svn_wc__db_wcroot_t *src_wcroot,
                                  scratch_pool, scratch_pool));
 
   SVN_ERR(get_pristine_fname(&src_abspath, src_wcroot->abspath, checksum,
-                             scratch_pool, scratch_pool));
+                             compressed, scratch_pool, scratch_pool));
 
   SVN_ERR(svn_stream_open_readonly(&src_stream, src_abspath,
                                    scratch_pool, scratch_pool));
@@ -564,7 +729,7 @@ maybe_transfer_one_pristine(svn_wc__db_wcroot_t *src_wcroot,
                            scratch_pool));
 
   SVN_ERR(get_pristine_fname(&pristine_abspath, dst_wcroot->abspath, checksum,
-                             scratch_pool, scratch_pool));
+                             compressed, scratch_pool, scratch_pool));
 
   /* Move the file to its target location.  (If it is already there, it is
    * an orphan file and it doesn't matter if we overwrite it.) */
@@ -623,6 +788,7 @@ pristine_transfer_txn(svn_wc__db_wcroot_t *src_wcroot,
       const svn_checksum_t *checksum;
       const svn_checksum_t *md5_checksum;
       apr_int64_t size;
+      svn_boolean_t compressed;
       svn_error_t *err;
 
       svn_pool_clear(iterpool);
@@ -630,9 +796,11 @@ pristine_transfer_txn(svn_wc__db_wcroot_t *src_wcroot,
       SVN_ERR(svn_sqlite__column_checksum(&checksum, stmt, 0, iterpool));
       SVN_ERR(svn_sqlite__column_checksum(&md5_checksum, stmt, 1, iterpool));
       size = svn_sqlite__column_int64(stmt, 2);
+      compressed = !svn_sqlite__column_is_null(stmt, 3);
 
       err = maybe_transfer_one_pristine(src_wcroot, dst_wcroot,
                                         checksum, md5_checksum, size,
+                                        compressed,
                                         cancel_func, cancel_baton,
                                         iterpool);
 
@@ -687,9 +855,9 @@ svn_wc__db_pristine_transfer(svn_wc__db_t *db,
 
 
 
-/* If the pristine text referenced by SHA1_CHECKSUM in WCROOT/SDB, whose path
- * within the pristine store is PRISTINE_ABSPATH, has a reference count of
- * zero, delete it (both the database row and the disk file).
+/* If the pristine text referenced by SHA1_CHECKSUM in WCROOT/SDB has a
+ * reference count of zero, delete it (both the database row and the disk
+ * file).
  *
  * This function expects to be executed inside a SQLite txn that has already
  * acquired a 'RESERVED' lock.
@@ -698,12 +866,19 @@ static svn_error_t *
 pristine_remove_if_unreferenced_txn(svn_sqlite__db_t *sdb,
                                     svn_wc__db_wcroot_t *wcroot,
                                     const svn_checksum_t *sha1_checksum,
-                                    const char *pristine_abspath,
                                     apr_pool_t *scratch_pool)
 {
   svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  svn_boolean_t compressed;
   int affected_rows;
 
+  /* Which file do we have to remove? */
+  SVN_ERR(get_pristine_info(&have_row, NULL, &compressed, wcroot,
+                            sha1_checksum, scratch_pool));
+  if (! have_row)
+    return SVN_NO_ERROR;
+
   /* Remove the DB row, if refcount is 0. */
   SVN_ERR(svn_sqlite__get_statement(&stmt, sdb,
                                     STMT_DELETE_PRISTINE_IF_UNREFERENCED));
@@ -721,7 +896,11 @@ pristine_remove_if_unreferenced_txn(svn_sqlite__db_t *sdb,
 #else
       svn_boolean_t ignore_enoent = TRUE;
 #endif
+      const char *pristine_abspath;
 
+      SVN_ERR(get_pristine_fname(&pristine_abspath, wcroot->abspath,
+                                 sha1_checksum, compressed,
+                                 scratch_pool, scratch_pool));
       SVN_ERR(svn_io_remove_file2(pristine_abspath, ignore_enoent,
                                   scratch_pool));
     }
@@ -739,16 +918,11 @@ pristine_remove_if_unreferenced(svn_wc__db_wcroot_t *wcroot,
                                 const svn_checksum_t *sha1_checksum,
                                 apr_pool_t *scratch_pool)
 {
-  const char *pristine_abspath;
-
-  SVN_ERR(get_pristine_fname(&pristine_abspath, wcroot->abspath,
-                             sha1_checksum, scratch_pool, scratch_pool));
-
   /* Ensure the SQL txn has at least a 'RESERVED' lock before we start looking
    * at the disk, to ensure no concurrent pristine install/delete txn. */
   SVN_SQLITE__WITH_IMMEDIATE_TXN(
     pristine_remove_if_unreferenced_txn(
-      wcroot->sdb, wcroot, sha1_checksum, pristine_abspath, scratch_pool),
+      wcroot->sdb, wcroot, sha1_checksum, scratch_pool),
     wcroot->sdb);
 
   return SVN_NO_ERROR;
@@ -801,7 +975,10 @@ svn_wc__db_pristine_remove(svn_wc__db_t *db,
 /* Remove all unreferenced pristines in the WC DB in WCROOT.
  *
  * Look for pristine texts whose 'refcount' in the DB is zero, and remove
- * them from the 'pristine' table and from disk.
+ * them from the 'pristine' table and from disk.  This is done in bulk, so
+ * that even large pristine stores get cleaned up quickly.
+ *
+ * This function expects to be executed inside a SQLite txn.
  *
  * TODO: At least check that any zero refcount is really correct, before
  *       using it.  See dev@ email thread "Pristine text missing - cleanup
@@ -834,33 +1011,72 @@ pristine_cleanup_wcroot(svn_wc__db_wcroot_t *wcroot,
                         apr_pool_t *scratch_pool)
 {
   svn_sqlite__stmt_t *stmt;
-  svn_error_t *err = NULL;
-  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_boolean_t have_row;
+  apr_array_header_t *checksums;
+  apr_array_header_t *compressed;
+  int i;
+  apr_pool_t *iterpool;
+#ifdef SVN_DEBUG
+  svn_boolean_t ignore_enoent = FALSE;
+#else
+  svn_boolean_t ignore_enoent = TRUE;
+#endif
+
+  /* Find all unreferenced pristines in the DB ... */
+  checksums = apr_array_make(scratch_pool, 0, sizeof(const svn_checksum_t *));
+  compressed = apr_array_make(scratch_pool, 0, sizeof(svn_boolean_t));
 
-  /* Find each unreferenced pristine in the DB and remove it. */
   SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
                                     STMT_SELECT_UNREFERENCED_PRISTINES));
-  while (! err)
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
     {
-      svn_boolean_t have_row;
       const svn_checksum_t *sha1_checksum;
+      svn_error_t *err;
 
-      svn_pool_clear(iterpool);
+      err = svn_sqlite__column_checksum(&sha1_checksum, stmt, 0,
+                                        scratch_pool);
+      if (err)
+        return svn_error_compose_create(err, svn_sqlite__reset(stmt));
 
-      SVN_ERR(svn_sqlite__step(&have_row, stmt));
-      if (! have_row)
-        break;
+      APR_ARRAY_PUSH(checksums, const svn_checksum_t *) = sha1_checksum;
+      APR_ARRAY_PUSH(compressed, svn_boolean_t)
+        = !svn_sqlite__column_is_null(stmt, 1);
 
-      SVN_ERR(svn_sqlite__column_checksum(&sha1_checksum, stmt, 0,
-                                          iterpool));
-      err = pristine_remove_if_unreferenced(wcroot, sha1_checksum,
-                                            iterpool);
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
     }
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  if (checksums->nelts == 0)
+    return SVN_NO_ERROR;
 
+  /* ... and remove their rows with a single statement. */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_DELETE_UNREFERENCED_PRISTINES));
+  SVN_ERR(svn_sqlite__step_done(stmt));
+
+  /* Then remove their files.  If a file is not present, something has
+   * gone wrong, but at this point it no longer matters.  In a debug
+   * build, raise an error, but in a release build, it is more helpful to
+   * ignore it and continue. */
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < checksums->nelts; i++)
+    {
+      const char *pristine_abspath;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(get_pristine_fname(&pristine_abspath, wcroot->abspath,
+                                 APR_ARRAY_IDX(checksums, i,
+                                               const svn_checksum_t *),
+                                 APR_ARRAY_IDX(compressed, i, svn_boolean_t),
+                                 iterpool, iterpool));
+      SVN_ERR(svn_io_remove_file2(pristine_abspath, ignore_enoent,
+                                  iterpool));
+    }
   svn_pool_destroy(iterpool);
 
-  return svn_error_trace(
-      svn_error_compose_create(err, svn_sqlite__reset(stmt)));
+  return SVN_NO_ERROR;
 }
 
 svn_error_t *
@@ -877,7 +1093,12 @@ svn_wc__db_pristine_cleanup(svn_wc__db_t *db,
                               wri_abspath, scratch_pool, scratch_pool));
   VERIFY_USABLE_WCROOT(wcroot);
 
-  SVN_ERR(pristine_cleanup_wcroot(wcroot, scratch_pool));
+  /* Ensure the SQL txn has at least a 'RESERVED' lock before we start
+   * looking at the disk, to ensure no concurrent pristine install/delete
+   * txn. */
+  SVN_SQLITE__WITH_IMMEDIATE_TXN(pristine_cleanup_wcroot(wcroot,
+                                                         scratch_pool),
+                                 wcroot->sdb);
 
   return SVN_NO_ERROR;
 }
@@ -917,8 +1138,19 @@ svn_wc__db_pristine_check(svn_boolean_t *present,
     svn_error_t *err;
 
     SVN_ERR(get_pristine_fname(&pristine_abspath, wcroot->abspath,
-                               sha1_checksum, scratch_pool, scratch_pool));
+                               sha1_checksum, FALSE,
+                               scratch_pool, scratch_pool));
     err = svn_io_check_path(pristine_abspath, &kind_on_disk, scratch_pool);
+
+    /* Maybe the text is stored compressed. */
+    if (!err && kind_on_disk != svn_node_file)
+      {
+        SVN_ERR(get_pristine_fname(&pristine_abspath, wcroot->abspath,
+                                   sha1_checksum, TRUE,
+                                   scratch_pool, scratch_pool));
+        err = svn_io_check_path(pristine_abspath, &kind_on_disk,
+                                scratch_pool);
+      }
 #ifdef WIN32
     if (err && err->apr_err == APR_FROM_OS_ERROR(ERROR_ACCESS_DENIED))
       {
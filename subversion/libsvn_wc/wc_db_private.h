@@ -32,6 +32,10 @@
 
 #include "wc_db.h"
 
+
+/* Default size of the SQLite page cache of each wc.db in KB. */
+#define SVN_WC__DB_SQLITE_CACHE_SIZE 8192
+
 
 struct svn_wc__db_t {
   /* We need the config whenever we run into a new WC directory, in order
@@ -52,6 +56,19 @@ struct svn_wc__db_t {
   /* Busy timeout in ms., 0 for the libsvn_subr default. */
   apr_int32_t timeout;
 
+  /* Should we keep the results of svn_wc__db_read_info() in memory? */
+  svn_boolean_t cache_nodes;
+
+  /* Should we store new pristine texts compressed? */
+  svn_boolean_t compress_pristines;
+
+  /* SQLite page cache size in KB and memory map size in bytes, negative
+     for the SQLite defaults, and whether to use write-ahead logging.
+     See svn_sqlite__tune(). */
+  apr_int64_t sqlite_cache_size;
+  apr_int64_t sqlite_mmap_size;
+  svn_boolean_t sqlite_wal;
+
   /* Map a given working copy directory to its relevant data.
      const char *local_abspath -> svn_wc__db_wcroot_t *wcroot  */
   apr_hash_t *dir_data;
@@ -107,6 +124,10 @@ typedef struct svn_wc__db_wcroot_t {
      const char *local_abspath -> svn_wc_adm_access_t *adm_access */
   apr_hash_t *access_cache;
 
+  /* Cached results of svn_wc__db_read_info(), see wc_db.c.  NULL until
+     first used. */
+  struct svn_wc__db_node_cache_t *node_cache;
+
 } svn_wc__db_wcroot_t;
 
 
@@ -235,6 +235,9 @@ svn_wc__db_open(svn_wc__db_t **db,
 
   (*db)->state_pool = result_pool;
 
+  (*db)->sqlite_cache_size = SVN_WC__DB_SQLITE_CACHE_SIZE;
+  (*db)->sqlite_mmap_size = 0;
+
   /* Don't need to initialize (*db)->parse_cache, due to the calloc above */
   if (config)
     {
@@ -261,6 +264,56 @@ svn_wc__db_open(svn_wc__db_t **db,
         svn_error_clear(err);
       else
         (*db)->timeout = (apr_int32_t)timeout;
+
+      err = svn_config_get_bool(config, &(*db)->cache_nodes,
+                                SVN_CONFIG_SECTION_WORKING_COPY,
+                                SVN_CONFIG_OPTION_NODE_CACHE,
+                                FALSE);
+      if (err)
+        {
+          svn_error_clear(err);
+          (*db)->cache_nodes = FALSE;
+        }
+
+      err = svn_config_get_bool(config, &(*db)->compress_pristines,
+                                SVN_CONFIG_SECTION_WORKING_COPY,
+                                SVN_CONFIG_OPTION_COMPRESS_PRISTINES,
+                                FALSE);
+      if (err)
+        {
+          svn_error_clear(err);
+          (*db)->compress_pristines = FALSE;
+        }
+
+      err = svn_config_get_int64(config, &(*db)->sqlite_cache_size,
+                                 SVN_CONFIG_SECTION_WORKING_COPY,
+                                 SVN_CONFIG_OPTION_SQLITE_CACHE_SIZE,
+                                 SVN_WC__DB_SQLITE_CACHE_SIZE);
+      if (err)
+        {
+          svn_error_clear(err);
+          (*db)->sqlite_cache_size = SVN_WC__DB_SQLITE_CACHE_SIZE;
+        }
+
+      err = svn_config_get_int64(config, &(*db)->sqlite_mmap_size,
+                                 SVN_CONFIG_SECTION_WORKING_COPY,
+                                 SVN_CONFIG_OPTION_SQLITE_MMAP_SIZE,
+                                 0);
+      if (err)
+        {
+          svn_error_clear(err);
+          (*db)->sqlite_mmap_size = 0;
+        }
+
+      err = svn_config_get_bool(config, &(*db)->sqlite_wal,
+                                SVN_CONFIG_SECTION_WORKING_COPY,
+                                SVN_CONFIG_OPTION_SQLITE_WAL,
+                                FALSE);
+      if (err)
+        {
+          svn_error_clear(err);
+          (*db)->sqlite_wal = FALSE;
+        }
     }
 
   return SVN_NO_ERROR;
@@ -377,6 +430,7 @@ svn_wc__db_pdh_create_wcroot(svn_wc__db_wcroot_t **wcroot,
   (*wcroot)->owned_locks = apr_array_make(result_pool, 8,
                                           sizeof(svn_wc__db_wclock_t));
   (*wcroot)->access_cache = apr_hash_make(result_pool);
+  (*wcroot)->node_cache = NULL;
 
   /* SDB will be NULL for pre-NG working copies. We only need to run a
      cleanup when the SDB is present.  */
@@ -638,6 +692,10 @@ svn_wc__db_wcroot_parse_local_abspath(svn_wc__db_wcroot_t **wcroot,
                                         svn_sqlite__mode_readwrite,
                                         db->exclusive, db->timeout, NULL,
                                         db->state_pool, scratch_pool);
+          if (err == NULL)
+            err = svn_sqlite__tune(sdb, db->sqlite_cache_size,
+                                   db->sqlite_mmap_size, db->sqlite_wal,
+                                   scratch_pool);
           if (err == NULL)
             {
 #ifdef SVN_DEBUG
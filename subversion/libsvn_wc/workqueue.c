@@ -22,6 +22,7 @@
  */
 
 #include <apr_pools.h>
+#include <apr_thread_proc.h>
 
 #include "svn_private_config.h"
 #include "svn_types.h"
@@ -38,6 +39,7 @@
 #include "conflicts.h"
 #include "translate.h"
 
+#include "private/svn_atomic.h"
 #include "private/svn_io_private.h"
 #include "private/svn_skel.h"
 
@@ -84,6 +86,12 @@ get_and_record_fileinfo(work_item_baton_t *wqb,
                         svn_boolean_t ignore_enoent,
                         apr_pool_t *scratch_pool);
 
+/* Forward definition */
+static void
+record_fileinfo(work_item_baton_t *wqb,
+                const char *local_abspath,
+                const svn_io_dirent2_t *dirent);
+
 /* ------------------------------------------------------------------------ */
 /* OP_REMOVE_BASE  */
 
@@ -445,60 +453,76 @@ svn_wc__wq_build_postupgrade(svn_skel_t **work_item,
 
 /* OP_FILE_INSTALL */
 
-/* Process the OP_FILE_INSTALL work item WORK_ITEM.
- * See svn_wc__wq_build_file_install() which generates this work item.
- * Implements (struct work_item_dispatch).func. */
+/* Everything needed to install a file without accessing the working copy
+   database, as determined by prepare_file_install(). */
+typedef struct file_install_t
+{
+  /* The file to install and where to get its normal form from. */
+  const char *local_abspath;
+  const char *source_abspath;
+  svn_boolean_t source_compressed; /* a compressed pristine */
+
+  /* Where to put the temporary file. */
+  const char *temp_dir_abspath;
+
+  /* How to translate the file. */
+  svn_subst_eol_style_t style;
+  const char *eol;
+  apr_hash_t *keywords;
+  svn_boolean_t special;
+
+  /* What to do with the installed file. */
+  svn_boolean_t set_executable;
+  svn_boolean_t set_read_only;
+  apr_time_t affected_time; /* 0 to leave the timestamp alone */
+  svn_boolean_t record_fileinfo;
+} file_install_t;
+
+/* Read everything from DB that is needed to process the OP_FILE_INSTALL
+ * work item WORK_ITEM and return it in *INSTALL, allocated in
+ * RESULT_POOL. */
 static svn_error_t *
-run_file_install(work_item_baton_t *wqb,
-                 svn_wc__db_t *db,
-                 const svn_skel_t *work_item,
-                 const char *wri_abspath,
-                 svn_cancel_func_t cancel_func,
-                 void *cancel_baton,
-                 apr_pool_t *scratch_pool)
+prepare_file_install(file_install_t **install,
+                     svn_wc__db_t *db,
+                     const svn_skel_t *work_item,
+                     const char *wri_abspath,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
 {
   const svn_skel_t *arg1 = work_item->children->next;
   const svn_skel_t *arg4 = arg1->next->next->next;
+  file_install_t *result = apr_pcalloc(result_pool, sizeof(*result));
   const char *local_relpath;
-  const char *local_abspath;
   svn_boolean_t use_commit_times;
-  svn_boolean_t record_fileinfo;
-  svn_boolean_t special;
-  svn_stream_t *src_stream;
-  svn_subst_eol_style_t style;
-  const char *eol;
-  apr_hash_t *keywords;
-  const char *temp_dir_abspath;
-  svn_stream_t *dst_stream;
   apr_int64_t val;
   const char *wcroot_abspath;
-  const char *source_abspath;
   const svn_checksum_t *checksum;
   apr_hash_t *props;
   apr_time_t changed_date;
 
   local_relpath = apr_pstrmemdup(scratch_pool, arg1->data, arg1->len);
-  SVN_ERR(svn_wc__db_from_relpath(&local_abspath, db, wri_abspath,
-                                  local_relpath, scratch_pool, scratch_pool));
+  SVN_ERR(svn_wc__db_from_relpath(&result->local_abspath, db, wri_abspath,
+                                  local_relpath, result_pool, scratch_pool));
 
   SVN_ERR(svn_skel__parse_int(&val, arg1->next, scratch_pool));
   use_commit_times = (val != 0);
   SVN_ERR(svn_skel__parse_int(&val, arg1->next->next, scratch_pool));
-  record_fileinfo = (val != 0);
+  result->record_fileinfo = (val != 0);
 
   SVN_ERR(svn_wc__db_read_node_install_info(&wcroot_abspath,
                                             &checksum, &props,
                                             &changed_date,
-                                            db, local_abspath, wri_abspath,
+                                            db, result->local_abspath,
+                                            wri_abspath,
                                             scratch_pool, scratch_pool));
 
   if (arg4 != NULL)
     {
       /* Use the provided path for the source.  */
       local_relpath = apr_pstrmemdup(scratch_pool, arg4->data, arg4->len);
-      SVN_ERR(svn_wc__db_from_relpath(&source_abspath, db, wri_abspath,
-                                      local_relpath,
-                                      scratch_pool, scratch_pool));
+      SVN_ERR(svn_wc__db_from_relpath(&result->source_abspath, db,
+                                      wri_abspath, local_relpath,
+                                      result_pool, scratch_pool));
     }
   else if (! checksum)
     {
@@ -513,31 +537,92 @@ run_file_install(work_item_baton_t *wqb,
                                _("Can't install '%s' from pristine store, "
                                  "because no checksum is recorded for this "
                                  "file"),
-                               svn_dirent_local_style(local_abspath,
+                               svn_dirent_local_style(result->local_abspath,
                                                       scratch_pool));
     }
   else
     {
-      SVN_ERR(svn_wc__db_pristine_get_future_path(&source_abspath,
-                                                  wcroot_abspath,
-                                                  checksum,
-                                                  scratch_pool, scratch_pool));
+      SVN_ERR(svn_wc__db_pristine_get_file(&result->source_abspath,
+                                           &result->source_compressed,
+                                           db, wri_abspath, checksum,
+                                           result_pool, scratch_pool));
     }
 
-  SVN_ERR(svn_stream_open_readonly(&src_stream, source_abspath,
-                                   scratch_pool, scratch_pool));
-
   /* Fetch all the translation bits.  */
-  SVN_ERR(svn_wc__get_translate_info(&style, &eol,
-                                     &keywords,
-                                     &special, db, local_abspath,
+  SVN_ERR(svn_wc__get_translate_info(&result->style, &result->eol,
+                                     &result->keywords,
+                                     &result->special, db,
+                                     result->local_abspath,
                                      props, FALSE,
+                                     result_pool, scratch_pool));
+
+  /* Where is the Right Place to put a temp file in this working copy?  */
+  SVN_ERR(svn_wc__db_temp_wcroot_tempdir(&result->temp_dir_abspath,
+                                         db, wcroot_abspath,
+                                         result_pool, scratch_pool));
+
+#ifndef WIN32
+  result->set_executable = (props
+                            && svn_hash_gets(props, SVN_PROP_EXECUTABLE));
+#endif
+
+  /* Note that this explicitly checks the pristine properties, to make sure
+     that when the lock is locally set (=modification) it is not read only */
+  if (props && svn_hash_gets(props, SVN_PROP_NEEDS_LOCK))
+    {
+      svn_wc__db_status_t status;
+      svn_wc__db_lock_t *lock;
+      SVN_ERR(svn_wc__db_read_info(&status, NULL, NULL, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, &lock, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, NULL, NULL, NULL, NULL,
+                                   db, result->local_abspath,
+                                   scratch_pool, scratch_pool));
+
+      result->set_read_only = (!lock && status != svn_wc__db_status_added);
+    }
+
+  if (use_commit_times)
+    result->affected_time = changed_date;
+
+  *install = result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Install the file described by INSTALL.  If its file info should be
+ * recorded, set *DIRENT to the installed file's dirent, allocated in
+ * RESULT_POOL, otherwise to NULL.
+ *
+ * This does not access the working copy database, so it can be run on
+ * any thread. */
+static svn_error_t *
+perform_file_install(const svn_io_dirent2_t **dirent,
+                     const file_install_t *install,
+                     svn_cancel_func_t cancel_func,
+                     void *cancel_baton,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  svn_stream_t *src_stream;
+  svn_stream_t *dst_stream;
+
+  *dirent = NULL;
+
+  if (install->source_compressed)
+    SVN_ERR(svn_wc__db_pristine_open_file(&src_stream,
+                                          install->source_abspath, TRUE,
+                                          scratch_pool, scratch_pool));
+  else
+    SVN_ERR(svn_stream_open_readonly(&src_stream, install->source_abspath,
                                      scratch_pool, scratch_pool));
-  if (special)
+
+  if (install->special)
     {
       /* When this stream is closed, the resulting special file will
          atomically be created/moved into place at LOCAL_ABSPATH.  */
-      SVN_ERR(svn_subst_create_specialfile(&dst_stream, local_abspath,
+      SVN_ERR(svn_subst_create_specialfile(&dst_stream,
+                                           install->local_abspath,
                                            scratch_pool, scratch_pool));
 
       /* Copy the "repository normal" form of the special file into the
@@ -552,27 +637,24 @@ run_file_install(work_item_baton_t *wqb,
       return SVN_NO_ERROR;
     }
 
-  if (svn_subst_translation_required(style, eol, keywords,
+  if (svn_subst_translation_required(install->style, install->eol,
+                                     install->keywords,
                                      FALSE /* special */,
                                      TRUE /* force_eol_check */))
     {
       /* Wrap it in a translating (expanding) stream.  */
-      src_stream = svn_subst_stream_translated(src_stream, eol,
+      src_stream = svn_subst_stream_translated(src_stream, install->eol,
                                                TRUE /* repair */,
-                                               keywords,
+                                               install->keywords,
                                                TRUE /* expand */,
                                                scratch_pool);
     }
 
-  /* Where is the Right Place to put a temp file in this working copy?  */
-  SVN_ERR(svn_wc__db_temp_wcroot_tempdir(&temp_dir_abspath,
-                                         db, wcroot_abspath,
-                                         scratch_pool, scratch_pool));
-
   /* Translate to a temporary file. We don't want the user seeing a partial
      file, nor let them muck with it while we translate. We may also need to
      get its TRANSLATED_SIZE before the user can monkey it.  */
-  SVN_ERR(svn_stream__create_for_install(&dst_stream, temp_dir_abspath,
+  SVN_ERR(svn_stream__create_for_install(&dst_stream,
+                                         install->temp_dir_abspath,
                                          scratch_pool, scratch_pool));
 
   /* Copy from the source to the dest, translating as we go. This will also
@@ -585,48 +667,53 @@ run_file_install(work_item_baton_t *wqb,
   /* With a single db we might want to install files in a missing directory.
      Simply trying this scenario on error won't do any harm and at least
      one user reported this problem on IRC. */
-  SVN_ERR(svn_stream__install_stream(dst_stream, local_abspath,
+  SVN_ERR(svn_stream__install_stream(dst_stream, install->local_abspath,
                                      TRUE /* make_parents*/, scratch_pool));
 
   /* Tweak the on-disk file according to its properties.  */
-#ifndef WIN32
-  if (props && svn_hash_gets(props, SVN_PROP_EXECUTABLE))
-    SVN_ERR(svn_io_set_file_executable(local_abspath, TRUE, FALSE,
+  if (install->set_executable)
+    SVN_ERR(svn_io_set_file_executable(install->local_abspath, TRUE, FALSE,
                                        scratch_pool));
-#endif
 
-  /* Note that this explicitly checks the pristine properties, to make sure
-     that when the lock is locally set (=modification) it is not read only */
-  if (props && svn_hash_gets(props, SVN_PROP_NEEDS_LOCK))
-    {
-      svn_wc__db_status_t status;
-      svn_wc__db_lock_t *lock;
-      SVN_ERR(svn_wc__db_read_info(&status, NULL, NULL, NULL, NULL, NULL, NULL,
-                                   NULL, NULL, NULL, NULL, NULL, NULL, NULL,
-                                   NULL, NULL, &lock, NULL, NULL, NULL, NULL,
-                                   NULL, NULL, NULL, NULL, NULL, NULL,
-                                   db, local_abspath,
-                                   scratch_pool, scratch_pool));
-
-      if (!lock && status != svn_wc__db_status_added)
-        SVN_ERR(svn_io_set_file_read_only(local_abspath, FALSE, scratch_pool));
-    }
+  if (install->set_read_only)
+    SVN_ERR(svn_io_set_file_read_only(install->local_abspath, FALSE,
+                                      scratch_pool));
 
-  if (use_commit_times)
-    {
-      if (changed_date)
-        SVN_ERR(svn_io_set_file_affected_time(changed_date,
-                                              local_abspath,
-                                              scratch_pool));
-    }
+  if (install->affected_time)
+    SVN_ERR(svn_io_set_file_affected_time(install->affected_time,
+                                          install->local_abspath,
+                                          scratch_pool));
 
   /* ### this should happen before we rename the file into place.  */
-  if (record_fileinfo)
-    {
-      SVN_ERR(get_and_record_fileinfo(wqb, local_abspath,
-                                      FALSE /* ignore_enoent */,
-                                      scratch_pool));
-    }
+  if (install->record_fileinfo)
+    SVN_ERR(svn_io_stat_dirent2(dirent, install->local_abspath,
+                                FALSE, FALSE, result_pool, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Process the OP_FILE_INSTALL work item WORK_ITEM.
+ * See svn_wc__wq_build_file_install() which generates this work item.
+ * Implements (struct work_item_dispatch).func. */
+static svn_error_t *
+run_file_install(work_item_baton_t *wqb,
+                 svn_wc__db_t *db,
+                 const svn_skel_t *work_item,
+                 const char *wri_abspath,
+                 svn_cancel_func_t cancel_func,
+                 void *cancel_baton,
+                 apr_pool_t *scratch_pool)
+{
+  file_install_t *install;
+  const svn_io_dirent2_t *dirent;
+
+  SVN_ERR(prepare_file_install(&install, db, work_item, wri_abspath,
+                               scratch_pool, scratch_pool));
+  SVN_ERR(perform_file_install(&dirent, install, cancel_func, cancel_baton,
+                               scratch_pool, scratch_pool));
+
+  if (dirent)
+    record_fileinfo(wqb, install->local_abspath, dirent);
 
   return SVN_NO_ERROR;
 }
@@ -1473,6 +1560,257 @@ dispatch_work_item(work_item_baton_t *wqb,
   return SVN_NO_ERROR;
 }
 
+/* Return ERR, which occurred while running WORK_ITEM with id ID in the
+   work queue of WRI_ABSPATH, wrapped into a work queue error. */
+static svn_error_t *
+wrap_work_item_error(svn_error_t *err,
+                     const char *wri_abspath,
+                     apr_uint64_t id,
+                     const svn_skel_t *work_item,
+                     apr_pool_t *scratch_pool)
+{
+  const char *skel = svn_skel__unparse(work_item, scratch_pool)->data;
+
+  return svn_error_createf(SVN_ERR_WC_BAD_ADM_LOG, err,
+                           _("Failed to run the WC DB work queue "
+                             "associated with '%s', work item %d %s"),
+                           svn_dirent_local_style(wri_abspath,
+                                                  scratch_pool),
+                           (int)id, skel);
+}
+
+#if APR_HAS_THREADS
+
+/* Maximum number of consecutive OP_FILE_INSTALL work items that get run
+   together, and the maximum number of additional threads running them. */
+#define INSTALL_BATCH_SIZE 64
+#define INSTALL_THREADS 3
+
+/* One work item of an install batch. */
+typedef struct install_job_t
+{
+  /* What to do, as prepared by the main thread. */
+  const file_install_t *install;
+
+  /* The results of perform_file_install(). */
+  const svn_io_dirent2_t *dirent;
+  svn_error_t *err;
+} install_job_t;
+
+/* The jobs of an install batch, shared by all threads running them. */
+typedef struct install_batch_t
+{
+  install_job_t *jobs;
+  int count;
+
+  /* Index of the next job to run. */
+  volatile svn_atomic_t next;
+} install_batch_t;
+
+/* A thread running jobs of an install batch. */
+typedef struct install_thread_t
+{
+  install_batch_t *batch;
+  apr_thread_t *thread;
+
+  /* Pool used by this thread only, which also holds the results. */
+  apr_pool_t *pool;
+} install_thread_t;
+
+/* Run jobs from BATCH until there are none left.  Allocate the results
+   in RESULT_POOL. */
+static void
+run_install_jobs(install_batch_t *batch,
+                 apr_pool_t *result_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(result_pool);
+
+  while (TRUE)
+    {
+      int i = (int)svn_atomic_inc(&batch->next);
+      install_job_t *job;
+
+      if (i >= batch->count)
+        break;
+
+      svn_pool_clear(iterpool);
+      job = &batch->jobs[i];
+      job->err = perform_file_install(&job->dirent, job->install, NULL, NULL,
+                                      result_pool, iterpool);
+    }
+
+  svn_pool_destroy(iterpool);
+}
+
+/* Thread function running the jobs of the install_thread_t DATA. */
+static void * APR_THREAD_FUNC
+install_thread_func(apr_thread_t *tid,
+                    void *data)
+{
+  install_thread_t *thread = data;
+
+  run_install_jobs(thread->batch, thread->pool);
+
+  return NULL;
+}
+
+/* The next work item in the work queue of WRI_ABSPATH in DB is an
+ * OP_FILE_INSTALL.  Install the files of that item and of the
+ * OP_FILE_INSTALL items directly following it on multiple threads, then
+ * mark the items completed and record their file info in a single
+ * transaction.  Set *COMPLETED to the number of completed work items, or
+ * to 0 if the caller should run the work item itself.
+ *
+ * Only the file system work runs on the other threads; everything that
+ * needs DB gets done up front by this thread. */
+static svn_error_t *
+run_install_batch(int *completed,
+                  svn_wc__db_t *db,
+                  const char *wri_abspath,
+                  apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *ids;
+  apr_array_header_t *work_items;
+  apr_array_header_t *completed_ids;
+  apr_hash_t *targets = apr_hash_make(scratch_pool);
+  apr_hash_t *record_map = NULL;
+  install_thread_t threads[INSTALL_THREADS];
+  install_batch_t batch = { 0 };
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_error_t *err = SVN_NO_ERROR;
+  int started;
+  int i;
+
+  *completed = 0;
+
+  SVN_ERR(svn_wc__db_wq_record_and_fetch_batch(&ids, &work_items, db,
+                                               wri_abspath, NULL, NULL,
+                                               INSTALL_BATCH_SIZE,
+                                               scratch_pool, scratch_pool));
+
+  /* Prepare as many consecutive installations of distinct files as
+     possible.  Whatever we can't prepare gets run on its own later. */
+  batch.jobs = apr_pcalloc(scratch_pool,
+                           work_items->nelts * sizeof(*batch.jobs));
+  for (i = 0; i < work_items->nelts; i++)
+    {
+      const svn_skel_t *work_item = APR_ARRAY_IDX(work_items, i,
+                                                  svn_skel_t *);
+      file_install_t *install;
+
+      svn_pool_clear(iterpool);
+
+      if (!svn_skel__matches_atom(work_item->children, OP_FILE_INSTALL))
+        break;
+
+      err = prepare_file_install(&install, db, work_item, wri_abspath,
+                                 scratch_pool, iterpool);
+      if (err)
+        {
+          svn_error_clear(err);
+          break;
+        }
+
+      if (svn_hash_gets(targets, install->local_abspath))
+        break;
+      svn_hash_sets(targets, install->local_abspath, install);
+
+      batch.jobs[batch.count++].install = install;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  if (batch.count < 2)
+    return SVN_NO_ERROR;
+
+  /* Run the jobs on up to INSTALL_THREADS additional threads and this
+     one. */
+  for (started = 0;
+       started < INSTALL_THREADS && started < batch.count - 1;
+       started++)
+    {
+      apr_status_t status;
+
+      /* Each thread needs a pool that it does not share with any other
+       * thread, including its allocator. */
+      threads[started].batch = &batch;
+      threads[started].pool = svn_pool_create(NULL);
+      status = apr_thread_create(&threads[started].thread, NULL,
+                                 install_thread_func, &threads[started],
+                                 threads[started].pool);
+      if (status)
+        {
+          /* Just do with fewer threads. */
+          svn_pool_destroy(threads[started].pool);
+          break;
+        }
+    }
+
+  run_install_jobs(&batch, scratch_pool);
+
+  for (i = 0; i < started; i++)
+    {
+      apr_status_t retval;
+      apr_status_t status = apr_thread_join(&retval, threads[i].thread);
+      if (status)
+        err = svn_error_compose_create(err,
+                       svn_error_wrap_apr(status,
+                                          _("Can't join install thread")));
+    }
+
+  /* Collect the results of the leading successful jobs and forget about
+     the others.  Their work items will simply run again. */
+  completed_ids = apr_array_make(scratch_pool, batch.count,
+                                 sizeof(apr_uint64_t));
+  for (i = 0; i < batch.count; i++)
+    {
+      install_job_t *job = &batch.jobs[i];
+
+      if (job->err || err)
+        {
+          if (!err)
+            err = wrap_work_item_error(job->err, wri_abspath,
+                                       APR_ARRAY_IDX(ids, i, apr_uint64_t),
+                                       APR_ARRAY_IDX(work_items, i,
+                                                     svn_skel_t *),
+                                       scratch_pool);
+          else
+            svn_error_clear(job->err);
+
+          continue;
+        }
+
+      if (job->dirent && job->dirent->kind == svn_node_file)
+        {
+          if (!record_map)
+            record_map = apr_hash_make(scratch_pool);
+
+          svn_hash_sets(record_map, job->install->local_abspath,
+                        svn_io_dirent2_dup(job->dirent, scratch_pool));
+        }
+
+      APR_ARRAY_PUSH(completed_ids, apr_uint64_t)
+        = APR_ARRAY_IDX(ids, i, apr_uint64_t);
+    }
+
+  for (i = 0; i < started; i++)
+    svn_pool_destroy(threads[i].pool);
+
+  if (completed_ids->nelts)
+    err = svn_error_compose_create(
+            err,
+            svn_wc__db_wq_record_and_fetch_batch(&ids, &work_items, db,
+                                                 wri_abspath, completed_ids,
+                                                 record_map, 0,
+                                                 scratch_pool, scratch_pool));
+
+  *completed = completed_ids->nelts;
+
+  return svn_error_trace(err);
+}
+
+#endif /* APR_HAS_THREADS */
+
 
 svn_error_t *
 svn_wc__wq_run(svn_wc__db_t *db,
@@ -1543,19 +1881,28 @@ svn_wc__wq_run(svn_wc__db_t *db,
       if (work_item == NULL)
         break;
 
+#if APR_HAS_THREADS
+      /* Checkouts and updates queue long runs of file installations,
+         which we can do in parallel. */
+      if (svn_skel__matches_atom(work_item->children, OP_FILE_INSTALL))
+        {
+          int completed;
+
+          SVN_ERR(run_install_batch(&completed, db, wri_abspath, iterpool));
+          if (completed > 0)
+            {
+              last_id = 0;
+              continue;
+            }
+        }
+#endif
+
       err = dispatch_work_item(&wib, db, wri_abspath, work_item,
                                cancel_func, cancel_baton, iterpool);
       if (err)
-        {
-          const char *skel = svn_skel__unparse(work_item, scratch_pool)->data;
-
-          return svn_error_createf(SVN_ERR_WC_BAD_ADM_LOG, err,
-                                   _("Failed to run the WC DB work queue "
-                                     "associated with '%s', work item %d %s"),
-                                   svn_dirent_local_style(wri_abspath,
-                                                          scratch_pool),
-                                   (int)id, skel);
-        }
+        return svn_error_trace(wrap_work_item_error(err, wri_abspath, id,
+                                                    work_item,
+                                                    scratch_pool));
 
       /* The work item finished without error. Mark it completed
          in the next loop.  */
@@ -1626,8 +1973,21 @@ get_and_record_fileinfo(work_item_baton_t *wqb,
   SVN_ERR(svn_io_stat_dirent2(&dirent, local_abspath, FALSE, ignore_enoent,
                               wqb->result_pool, scratch_pool));
 
+  record_fileinfo(wqb, local_abspath, dirent);
+
+  return SVN_NO_ERROR;
+}
+
+/* Remember to record the size and timestamp of LOCAL_ABSPATH given in
+   DIRENT when the current work item has been completed, if it is a
+   file. */
+static void
+record_fileinfo(work_item_baton_t *wqb,
+                const char *local_abspath,
+                const svn_io_dirent2_t *dirent)
+{
   if (dirent->kind != svn_node_file)
-    return SVN_NO_ERROR;
+    return;
 
   wqb->used = TRUE;
 
@@ -1635,7 +1995,5 @@ get_and_record_fileinfo(work_item_baton_t *wqb,
     wqb->record_map = apr_hash_make(wqb->result_pool);
 
   svn_hash_sets(wqb->record_map, apr_pstrdup(wqb->result_pool, local_abspath),
-                dirent);
-
-  return SVN_NO_ERROR;
+                svn_io_dirent2_dup(dirent, wqb->result_pool));
 }
@@ -46,6 +46,7 @@
 #include "svn_repos.h"
 #include "svn_pools.h"
 #include "svn_dirent_uri.h"
+#include "svn_hash.h"
 #include "private/svn_fspath.h"
 
 /* The apache headers define these and they conflict with our definitions. */
@@ -394,12 +395,153 @@ resolve_repos_relative_url(const char **path, const char **repos_url,
   return SVN_NO_ERROR;
 }
 
+/* Maximum number of decisions kept in an authz_memo_t.  Once that is
+ * reached, the memo starts over. */
+#define MAX_MEMO_ENTRIES 4096
+
+/* Memo of the access decisions made with one svn_authz_t.  Lives as long
+ * as the svn_authz_t, i.e. for the connection, and thus covers all
+ * requests and sub-requests on that connection.
+ */
+typedef struct authz_memo_t
+{
+  /* Memo key (see get_memo_key) -> svn_boolean_t * access granted */
+  apr_hash_t *decisions;
+
+  /* Pool for DECISIONS and its contents; cleared when starting over. */
+  apr_pool_t *pool;
+} authz_memo_t;
+
+/* Return the key for the decision whether USER, which may be NULL, has
+ * ACCESS to REPOS_PATH in REPOS_NAME in an authz_memo_t.  Its length will
+ * be returned in *LEN.  Allocate the result in POOL.
+ */
+static const char *
+get_memo_key(apr_size_t *len,
+             const char *user,
+             const char *repos_name,
+             const char *repos_path,
+             svn_repos_authz_access_t access,
+             apr_pool_t *pool)
+{
+  svn_stringbuf_t *key = svn_stringbuf_createf(pool, "%d", (int)access);
+
+  /* Anonymous access is different from access for an empty user name. */
+  svn_stringbuf_appendbyte(key, '\0');
+  if (user)
+    {
+      svn_stringbuf_appendbyte(key, 'u');
+      svn_stringbuf_appendcstr(key, user);
+    }
+
+  svn_stringbuf_appendbyte(key, '\0');
+  svn_stringbuf_appendcstr(key, repos_name ? repos_name : "");
+  svn_stringbuf_appendbyte(key, '\0');
+  svn_stringbuf_appendcstr(key, repos_path);
+
+  *len = key->len;
+  return key->data;
+}
+
+/* Return the decision for KEY of length LEN in MEMO or NULL if there is
+ * none. */
+static const svn_boolean_t *
+lookup_decision(authz_memo_t *memo,
+                const char *key,
+                apr_size_t len)
+{
+  return apr_hash_get(memo->decisions, key, len);
+}
+
+/* Like svn_repos_authz_check_access() but consult MEMO first and record the
+ * result there.  MEMO may be NULL.
+ *
+ * A recursive grant on some path in MEMO implies the same access, with or
+ * without svn_authz_recursive, for all paths below it.  Denials and
+ * non-recursive grants apply to the exact path only because rules for
+ * sub-paths may override them.
+ */
+static svn_error_t *
+check_access_memoized(authz_memo_t *memo,
+                      svn_authz_t *access_conf,
+                      const char *repos_name,
+                      const char *repos_path,
+                      const char *user,
+                      svn_repos_authz_access_t required_access,
+                      svn_boolean_t *access_granted,
+                      apr_pool_t *pool)
+{
+  svn_repos_authz_access_t recursive_access
+    = required_access | svn_authz_recursive;
+  const svn_boolean_t *decision;
+  svn_boolean_t *granted;
+  const char *key;
+  const char *parent_path;
+  apr_size_t len;
+
+  /* Requests without a path are rare and not worth memoizing. */
+  if (memo == NULL || repos_path == NULL)
+    return svn_error_trace(svn_repos_authz_check_access(access_conf,
+                                                        repos_name,
+                                                        repos_path, user,
+                                                        required_access,
+                                                        access_granted,
+                                                        pool));
+
+  key = get_memo_key(&len, user, repos_name, repos_path, required_access,
+                     pool);
+  decision = lookup_decision(memo, key, len);
+  if (decision)
+    {
+      *access_granted = *decision;
+      return SVN_NO_ERROR;
+    }
+
+  /* Look for a recursive grant on this path or any of its parents. */
+  for (parent_path = repos_path; ; )
+    {
+      const char *parent_key = get_memo_key(&len, user, repos_name,
+                                            parent_path, recursive_access,
+                                            pool);
+      decision = lookup_decision(memo, parent_key, len);
+      if (decision && *decision)
+        {
+          *access_granted = TRUE;
+          return SVN_NO_ERROR;
+        }
+
+      if (svn_fspath__is_root(parent_path, strlen(parent_path)))
+        break;
+
+      parent_path = svn_fspath__dirname(parent_path, pool);
+    }
+
+  SVN_ERR(svn_repos_authz_check_access(access_conf, repos_name, repos_path,
+                                       user, required_access,
+                                       access_granted, pool));
+
+  if (apr_hash_count(memo->decisions) >= MAX_MEMO_ENTRIES)
+    {
+      svn_pool_clear(memo->pool);
+      memo->decisions = apr_hash_make(memo->pool);
+    }
+
+  key = get_memo_key(&len, user, repos_name, repos_path, required_access,
+                     memo->pool);
+  granted = apr_palloc(memo->pool, sizeof(*granted));
+  *granted = *access_granted;
+  apr_hash_set(memo->decisions, key, len, granted);
+
+  return SVN_NO_ERROR;
+}
+
 /*
- * Get the, possibly cached, svn_authz_t for this request.
+ * Get the, possibly cached, svn_authz_t for this request and the memo of
+ * access decisions made with it in *MEMO.
  */
 static svn_authz_t *
 get_access_conf(request_rec *r, authz_svn_config_rec *conf,
-                apr_pool_t *scratch_pool)
+                authz_memo_t **memo, apr_pool_t *scratch_pool)
 {
   const char *cache_key = NULL;
   const char *access_file;
@@ -491,6 +633,26 @@ get_access_conf(request_rec *r, authz_svn_config_rec *conf,
                                 NULL, r->connection->pool);
         }
     }
+
+  *memo = NULL;
+  if (access_conf)
+    {
+      cache_key = apr_pstrcat(scratch_pool, cache_key, ":memo", SVN_VA_NULL);
+      apr_pool_userdata_get(&user_data, cache_key, r->connection->pool);
+      *memo = user_data;
+
+      /* The memo is only valid for the svn_authz_t it has been built
+         with. */
+      if (*memo == NULL)
+        {
+          *memo = apr_pcalloc(r->connection->pool, sizeof(**memo));
+          (*memo)->pool = svn_pool_create(r->connection->pool);
+          (*memo)->decisions = apr_hash_make((*memo)->pool);
+          apr_pool_userdata_set(*memo, cache_key,
+                                NULL, r->connection->pool);
+        }
+    }
+
   return access_conf;
 }
 
@@ -549,6 +711,7 @@ req_check_access(request_rec *r,
   svn_repos_authz_access_t authz_svn_type = svn_authz_none;
   svn_boolean_t authz_access_granted = FALSE;
   svn_authz_t *access_conf = NULL;
+  authz_memo_t *memo;
   svn_error_t *svn_err;
   const char *username_to_authorize = get_username_to_authorize(r, conf,
                                                                 r->pool);
@@ -701,7 +864,7 @@ req_check_access(request_rec *r,
     }
 
   /* Retrieve/cache authorization file */
-  access_conf = get_access_conf(r,conf, r->pool);
+  access_conf = get_access_conf(r, conf, &memo, r->pool);
   if (access_conf == NULL)
     return DECLINED;
 
@@ -728,12 +891,12 @@ req_check_access(request_rec *r,
   if (repos_path
       || (!repos_path && (authz_svn_type & svn_authz_write)))
     {
-      svn_err = svn_repos_authz_check_access(access_conf, repos_name,
-                                             repos_path,
-                                             username_to_authorize,
-                                             authz_svn_type,
-                                             &authz_access_granted,
-                                             r->pool);
+      svn_err = check_access_memoized(memo, access_conf, repos_name,
+                                      repos_path,
+                                      username_to_authorize,
+                                      authz_svn_type,
+                                      &authz_access_granted,
+                                      r->pool);
       if (svn_err)
         {
           log_svn_error(APLOG_MARK, r,
@@ -763,14 +926,14 @@ req_check_access(request_rec *r,
      repos_path == NULL (see above for explanations) */
   if (repos_path)
     {
-      svn_err = svn_repos_authz_check_access(access_conf,
-                                             dest_repos_name,
-                                             dest_repos_path,
-                                             username_to_authorize,
-                                             svn_authz_write
-                                             |svn_authz_recursive,
-                                             &authz_access_granted,
-                                             r->pool);
+      svn_err = check_access_memoized(memo, access_conf,
+                                      dest_repos_name,
+                                      dest_repos_path,
+                                      username_to_authorize,
+                                      svn_authz_write
+                                      |svn_authz_recursive,
+                                      &authz_access_granted,
+                                      r->pool);
       if (svn_err)
         {
           log_svn_error(APLOG_MARK, r,
@@ -801,6 +964,7 @@ subreq_bypass2(request_rec *r,
 {
   svn_error_t *svn_err = NULL;
   svn_authz_t *access_conf = NULL;
+  authz_memo_t *memo;
   authz_svn_config_rec *conf = NULL;
   svn_boolean_t authz_access_granted = FALSE;
   const char *username_to_authorize;
@@ -818,7 +982,7 @@ subreq_bypass2(request_rec *r,
     }
 
   /* Retrieve authorization file */
-  access_conf = get_access_conf(r, conf, scratch_pool);
+  access_conf = get_access_conf(r, conf, &memo, scratch_pool);
   if (access_conf == NULL)
     return HTTP_FORBIDDEN;
 
@@ -827,12 +991,12 @@ subreq_bypass2(request_rec *r,
    */
   if (repos_path)
     {
-      svn_err = svn_repos_authz_check_access(access_conf, repos_name,
-                                             repos_path,
-                                             username_to_authorize,
-                                             svn_authz_none|svn_authz_read,
-                                             &authz_access_granted,
-                                             scratch_pool);
+      svn_err = check_access_memoized(memo, access_conf, repos_name,
+                                      repos_path,
+                                      username_to_authorize,
+                                      svn_authz_none|svn_authz_read,
+                                      &authz_access_granted,
+                                      scratch_pool);
       if (svn_err)
         {
           log_svn_error(APLOG_MARK, r,
@@ -152,6 +152,13 @@ typedef struct dav_svn_repos {
   /* Cached yongest revision of the repository. SVN_INVALID_REVNUM if
      youngest revision is not fetched yet. */
   svn_revnum_t youngest_rev;
+
+  /* Cache of liveprop values of nodes in revision roots, shared with
+     other requests through the global membuffer cache.  NULL until first
+     used.  LIVEPROP_CACHE_PREFIX identifies this repository in the
+     cache keys.  See liveprops.c. */
+  struct svn_cache__t *liveprop_cache;
+  const char *liveprop_cache_prefix;
 } dav_svn_repos;
 
 
@@ -300,6 +307,12 @@ struct dav_resource_private {
      (ie: /path/to/item?kw=1)? */
   svn_boolean_t keyword_subst;
 
+  /* the single byte range of the file contents to send in response to a
+     ranged GET request.  RANGE_LENGTH is 0 if the whole contents shall
+     be sent. */
+  svn_filesize_t range_start;
+  svn_filesize_t range_length;
+
   /* whether this resource parameters are fixed and won't change
      between requests. */
   svn_boolean_t idempotent;
@@ -344,6 +357,18 @@ dav_svn__get_nodeprop_cache_flag(request_rec *r);
  * request? */
 svn_boolean_t dav_svn__get_block_read_flag(request_rec *r);
 
+/* shall replays of the repository referred to by this request be served
+ * from the on-disk replay cache? */
+svn_boolean_t dav_svn__get_replay_cache_flag(request_rec *r);
+
+/* shall location segments in the repository referred to by this request
+ * be taken from the on-disk location segments cache? */
+svn_boolean_t dav_svn__get_segments_cache_flag(request_rec *r);
+
+/* for how many files ahead shall bulk update responses for the repository
+ * referred to by this request compute text deltas? */
+int dav_svn__get_update_prefetch(request_rec *r);
+
 /* for the repository referred to by this request, are subrequests bypassed?
  * A function pointer if yes, NULL if not.
  */
@@ -417,6 +442,11 @@ const char *dav_svn__get_master_uri(request_rec *r);
    Comes from the <SVNMasterVersion> directive. */
 svn_version_t *dav_svn__get_master_version(request_rec *r);
 
+/* Return the number of seconds that proxied commits shall wait for the new
+   revision to arrive in the local mirror, or 0 if they shall not wait.
+   Comes from the <SVNMasterCommitWait> directive. */
+int dav_svn__get_master_commit_wait(request_rec *r);
+
 /* Return the disk path to the activities db.
    Comes from the <SVNActivitiesDB> directive. */
 const char *dav_svn__get_activities_db(request_rec *r);
@@ -429,6 +459,14 @@ const char *dav_svn__get_root_dir(request_rec *r);
 /* Return the data compression level to be used over the wire. */
 int dav_svn__get_compression_level(request_rec *r);
 
+/* Return the directory of the persistent second cache tier or NULL if
+   none has been configured. */
+const char *dav_svn__get_disk_cache_path(request_rec *r);
+
+/* Return the size limit of the persistent second cache tier in bytes or
+   0 to use the default. */
+apr_uint64_t dav_svn__get_disk_cache_size(request_rec *r);
+
 /* Return the hook script environment parsed from the configuration. */
 const char *dav_svn__get_hooks_env(request_rec *r);
 
@@ -1036,7 +1074,9 @@ dav_svn__make_base64_output_stream(apr_bucket_brigade *bb,
                                    apr_pool_t *pool);
 
 /* In INFO->r->subprocess_env set "SVN-ACTION" to LINE, "SVN-REPOS" to
- * INFO->repos->fs_path, and "SVN-REPOS-NAME" to INFO->repos->repo_basename. */
+ * INFO->repos->fs_path, and "SVN-REPOS-NAME" to INFO->repos->repo_basename.
+ * Also set "SVN-TRACE-ID" to the SVN_DAV_TRACE_ID_HEADER of the request,
+ * if the client sent one. */
 void
 dav_svn__operational_log(struct dav_resource_private *info, const char *line);
 
@@ -1114,6 +1154,34 @@ dav_svn__get_youngest_rev(svn_revnum_t *youngest_p,
                           dav_svn_repos *repos,
                           apr_pool_t *scratch_pool);
 
+/*** metrics.c ***/
+
+/* Start collecting metrics in this process, allocated in POOL.  Until
+   this has been called, the other metrics functions do nothing. */
+void dav_svn__metrics_init(apr_pool_t *pool);
+
+/* Record a REPORT request with root element NAME that took DURATION.
+   Use SCRATCH_POOL for temporary allocations. */
+void dav_svn__metrics_add_report(const char *name,
+                                 apr_interval_time_t duration,
+                                 apr_pool_t *scratch_pool);
+
+/* Count a repository as open until POOL gets cleaned up. */
+void dav_svn__metrics_repos_opened(apr_pool_t *pool);
+
+/* Like svn_repos_fs_commit_txn() but record the time spent in the hooks
+   and in the filesystem in the metrics. */
+svn_error_t *
+dav_svn__commit_txn(const char **conflict_p,
+                    svn_repos_t *repos,
+                    svn_revnum_t *new_rev,
+                    svn_fs_txn_t *txn,
+                    apr_pool_t *pool);
+
+/* Request handler to GET the metrics in Prometheus text format. */
+int dav_svn__metrics(request_rec *r);
+
+
 /*** mirror.c ***/
 
 /* Perform the fixup hook for the R request.  */
@@ -1138,6 +1206,12 @@ apr_status_t dav_svn__location_header_filter(ap_filter_t *f,
 apr_status_t dav_svn__location_body_filter(ap_filter_t *f,
                                            apr_bucket_brigade *bb);
 
+/* An Apache output filter F which holds back the response BB to a proxied
+ * MERGE request until the new revision has arrived in the local mirror or
+ * the time configured by SVNMasterCommitWait has passed. */
+apr_status_t dav_svn__master_commit_wait_filter(ap_filter_t *f,
+                                                apr_bucket_brigade *bb);
+
 
 #ifdef __cplusplus
 }
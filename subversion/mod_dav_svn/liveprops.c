@@ -38,6 +38,7 @@
 #include "svn_props.h"
 #include "svn_ctype.h"
 
+#include "private/svn_cache.h"
 #include "private/svn_dav_protocol.h"
 
 #include "dav_svn.h"
@@ -273,23 +274,23 @@ get_last_modified_time(const char **datestring,
   return 0;
 }
 
+/* ### TODO proper errors */
+static const char *const error_value = "###error###";
+
+/* Set *VALUE_P to the XML-quoted value of property PROPID of RESOURCE
+   and return DAV_PROP_INSERT_VALUE.  If RESOURCE does not have that
+   property, return DAV_PROP_INSERT_NOTSUPP or DAV_PROP_INSERT_NOTDEF
+   instead.  Allocate *VALUE_P in SCRATCH_POOL. */
 static dav_prop_insert
-insert_prop_internal(const dav_resource *resource,
-                     int propid,
-                     dav_prop_insert what,
-                     apr_text_header *phdr,
-                     apr_pool_t *result_pool,
-                     apr_pool_t *scratch_pool)
+get_prop_value(const char **value_p,
+               const dav_resource *resource,
+               int propid,
+               apr_pool_t *scratch_pool)
 {
   const char *value = NULL;
   const char *s;
-  const dav_liveprop_spec *info;
-  long global_ns;
   svn_error_t *serr;
 
-  /* ### TODO proper errors */
-  static const char *const error_value = "###error###";
-
   /*
   ** Almost none of the SVN provider properties are defined if the
   ** resource does not exist.  We do need to return the one VCC
@@ -831,6 +832,159 @@ insert_prop_internal(const dav_resource *resource,
     }
 
   /* assert: value != NULL */
+  *value_p = value;
+  return DAV_PROP_INSERT_VALUE;
+}
+
+/* Return TRUE if the value of property PROPID of RESOURCE depends on
+   nothing but the node it belongs to, so that it may be cached across
+   requests.  Nodes of revision roots never change.  Neither the request
+   URL nor keyword expansion matter for the values accepted here.  Properties taken from revision properties are subject
+   to path-based authz, so only accept those if that is disabled. */
+static svn_boolean_t
+is_cacheable_prop(const dav_resource *resource,
+                  int propid)
+{
+  if (resource->baselined
+      || !resource->exists
+      || (resource->type != DAV_RESOURCE_TYPE_REGULAR
+          && resource->type != DAV_RESOURCE_TYPE_VERSION)
+      || resource->info->root.root == NULL
+      || !svn_fs_is_revision_root(resource->info->root.root))
+    return FALSE;
+
+  switch (propid)
+    {
+    case DAV_PROPID_getcontentlength:
+    case DAV_PROPID_version_name:
+    case SVN_PROPID_md5_checksum:
+    case SVN_PROPID_sha1_checksum:
+    case SVN_PROPID_deadprop_count:
+      return TRUE;
+
+    case DAV_PROPID_getlastmodified:
+    case DAV_PROPID_creationdate:
+    case DAV_PROPID_creator_displayname:
+      return !dav_svn__get_pathauthz_flag(resource->info->r);
+
+    default:
+      return FALSE;
+    }
+}
+
+/* Set *CACHE to the cache of liveprop values for the repository of
+   RESOURCE and *KEY to the key of property PROPID of RESOURCE in it.
+   If there is no global membuffer cache, set *CACHE to NULL.  The cache
+   itself is kept with the dav_svn_repos and shared by all resources of
+   the request.  Allocate *KEY in SCRATCH_POOL. */
+static svn_error_t *
+get_liveprop_cache(svn_cache__t **cache,
+                   const char **key,
+                   const dav_resource *resource,
+                   int propid,
+                   apr_pool_t *scratch_pool)
+{
+  dav_svn_repos *repos = resource->info->repos;
+  svn_membuffer_t *membuffer = svn_cache__get_global_membuffer_cache();
+
+  *cache = NULL;
+  if (!membuffer)
+    return SVN_NO_ERROR;
+
+  if (!repos->liveprop_cache)
+    {
+      const char *uuid;
+
+      /* Revisions are immutable, so the repository, the revision, the
+         path and the property identify the value.  The length of the
+         repository path keeps it apart from the rest of the key. */
+      SVN_ERR(svn_fs_get_uuid(repos->fs, &uuid, repos->pool));
+      repos->liveprop_cache_prefix
+        = apr_psprintf(repos->pool, "%s:%" APR_SIZE_T_FMT ":%s:",
+                       uuid, strlen(repos->fs_path), repos->fs_path);
+
+      /* NULL serializers make the cache store svn_stringbuf_t. */
+      SVN_ERR(svn_cache__create_membuffer_cache(
+                &repos->liveprop_cache, membuffer, NULL, NULL,
+                APR_HASH_KEY_STRING, "DAV_SVN_LIVEPROPS",
+                SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                FALSE, FALSE, repos->pool, scratch_pool));
+    }
+
+  *cache = repos->liveprop_cache;
+  /* The author is sanitized differently for svn clients. */
+  *key = apr_psprintf(scratch_pool, "%s%ld:%d:%d:%s",
+                      repos->liveprop_cache_prefix,
+                      svn_fs_revision_root_revision(resource->info->root.root),
+                      propid, repos->is_svn_client,
+                      resource->info->repos_path);
+
+  return SVN_NO_ERROR;
+}
+
+/* Like get_prop_value() but take the value from the liveprop cache if
+   possible and add newly computed values to it.  Problems with the cache
+   are not fatal. */
+static dav_prop_insert
+get_prop_value_cached(const char **value,
+                      const dav_resource *resource,
+                      int propid,
+                      apr_pool_t *scratch_pool)
+{
+  svn_cache__t *cache = NULL;
+  const char *key;
+  svn_stringbuf_t *cached;
+  svn_boolean_t found = FALSE;
+  dav_prop_insert rv;
+
+  if (is_cacheable_prop(resource, propid))
+    {
+      svn_error_t *serr = get_liveprop_cache(&cache, &key, resource, propid,
+                                             scratch_pool);
+      if (!serr && cache)
+        serr = svn_cache__get((void **)&cached, &found, cache, key,
+                              scratch_pool);
+      if (serr)
+        {
+          svn_error_clear(serr);
+          cache = NULL;
+        }
+      else if (found)
+        {
+          *value = cached->data;
+          return DAV_PROP_INSERT_VALUE;
+        }
+    }
+
+  rv = get_prop_value(value, resource, propid, scratch_pool);
+
+  /* Don't remember errors. */
+  if (cache && rv == DAV_PROP_INSERT_VALUE && *value != error_value)
+    svn_error_clear(svn_cache__set(cache, key,
+                                   svn_stringbuf_create(*value,
+                                                        scratch_pool),
+                                   scratch_pool));
+
+  return rv;
+}
+
+static dav_prop_insert
+insert_prop_internal(const dav_resource *resource,
+                     int propid,
+                     dav_prop_insert what,
+                     apr_text_header *phdr,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  const char *value;
+  const char *s;
+  const dav_liveprop_spec *info;
+  long global_ns;
+  dav_prop_insert rv;
+
+  rv = get_prop_value_cached(&value, resource, propid, scratch_pool);
+  if (rv != DAV_PROP_INSERT_VALUE)
+    return rv;
 
   /* get the information and global NS index for the property */
   global_ns = dav_get_liveprop_info(propid, &dav_svn__liveprop_group, &info);
@@ -0,0 +1,598 @@
+/*
+ * metrics.c: Request and commit metrics in Prometheus text format
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_strings.h>
+
+#include <httpd.h>
+#include <http_core.h>
+#include <http_log.h>
+#include <http_protocol.h>
+
+#include "svn_hash.h"
+#include "svn_pools.h"
+#include "svn_sorts.h"
+
+#include "private/svn_cache.h"
+#include "private/svn_mutex.h"
+#include "private/svn_repos_private.h"
+#include "private/svn_sorts_private.h"
+
+#include "dav_svn.h"
+
+/* Add a location:
+
+     <Location /svn-metrics>
+       SetHandler svn-metrics
+     </Location>
+
+  and let Prometheus scrape http://server/svn-metrics.  Like svn-status,
+  this reports the values of the httpd process that handles the request
+  only.  Scrapes will therefore reflect a random child process unless
+  httpd runs just one of them.
+*/
+
+/* Upper bounds of the latency histogram buckets in microseconds and as
+ * Prometheus "le" labels.  There is an implicit "+Inf" bucket after them.
+ */
+static const apr_interval_time_t bucket_bounds[] = {
+  5000, 10000, 25000, 50000, 100000, 250000,
+  500000, 1000000, 2500000, 5000000, 10000000
+};
+static const char * const bucket_labels[] = {
+  "0.005", "0.01", "0.025", "0.05", "0.1", "0.25",
+  "0.5", "1", "2.5", "5", "10"
+};
+
+#define BUCKET_COUNT (sizeof(bucket_bounds) / sizeof(bucket_bounds[0]) + 1)
+
+/* A latency histogram. */
+typedef struct histogram_t
+{
+  /* Number of recorded values per bucket, not cumulative. */
+  apr_uint64_t buckets[BUCKET_COUNT];
+
+  /* Number and sum of all recorded values in microseconds. */
+  apr_uint64_t count;
+  apr_uint64_t total_usec;
+} histogram_t;
+
+/* All metrics of this process. */
+typedef struct metrics_t
+{
+  /* const char * report label -> histogram_t * */
+  apr_hash_t *reports;
+
+  /* Hook and FS time of commits. */
+  histogram_t commit_hooks;
+  histogram_t commit_fs;
+
+  /* Number of failed commit attempts. */
+  apr_uint64_t failed_commits;
+
+  /* Number of repositories currently open resp. opened so far. */
+  apr_int64_t open_repositories;
+  apr_uint64_t opened_repositories;
+
+  /* mutex used to serialize access to this structure */
+  svn_mutex__t *mutex;
+
+  /* pool for the hash keys and histograms */
+  apr_pool_t *pool;
+} metrics_t;
+
+/* The metrics of this process.  NULL until dav_svn__metrics_init has been
+ * called. */
+static metrics_t *metrics = NULL;
+
+/* Record DURATION in HISTOGRAM. */
+static void
+add_to_histogram(histogram_t *histogram,
+                 apr_interval_time_t duration)
+{
+  apr_size_t i;
+
+  if (duration < 0)
+    duration = 0;
+
+  for (i = 0; i < BUCKET_COUNT - 1; ++i)
+    if (duration <= bucket_bounds[i])
+      break;
+
+  histogram->buckets[i]++;
+  histogram->count++;
+  histogram->total_usec += duration;
+}
+
+void
+dav_svn__metrics_init(apr_pool_t *pool)
+{
+  metrics_t *result = apr_pcalloc(pool, sizeof(*result));
+  svn_error_t *err;
+
+  result->pool = svn_pool_create(pool);
+  result->reports = apr_hash_make(result->pool);
+
+  /* Without a mutex, we simply don't collect any metrics. */
+  err = svn_mutex__init(&result->mutex, TRUE, pool);
+  if (err)
+    svn_error_clear(err);
+  else
+    metrics = result;
+}
+
+/* Baton type for add_locked. */
+typedef struct add_baton_t
+{
+  /* Label of the report to record.  NULL if this is a commit. */
+  const char *report;
+
+  /* Duration of the report resp. the hooks and FS parts of a commit. */
+  apr_interval_time_t duration;
+  apr_interval_time_t hooks_time;
+  apr_interval_time_t fs_time;
+
+  /* Whether the commit produced a new revision. */
+  svn_boolean_t committed;
+} add_baton_t;
+
+/* Add the request given by the add_baton_t BATON to the metrics while
+ * holding the mutex. */
+static svn_error_t *
+add_locked(add_baton_t *baton)
+{
+  if (baton->report)
+    {
+      histogram_t *histogram = svn_hash_gets(metrics->reports,
+                                             baton->report);
+      if (histogram == NULL)
+        {
+          histogram = apr_pcalloc(metrics->pool, sizeof(*histogram));
+          svn_hash_sets(metrics->reports,
+                        apr_pstrdup(metrics->pool, baton->report),
+                        histogram);
+        }
+
+      add_to_histogram(histogram, baton->duration);
+    }
+  else if (baton->committed)
+    {
+      add_to_histogram(&metrics->commit_hooks, baton->hooks_time);
+      add_to_histogram(&metrics->commit_fs, baton->fs_time);
+    }
+  else
+    {
+      metrics->failed_commits++;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Add the request given by the add_baton_t BATON to the metrics. */
+static svn_error_t *
+add(add_baton_t *baton)
+{
+  SVN_MUTEX__WITH_LOCK(metrics->mutex, add_locked(baton));
+
+  return SVN_NO_ERROR;
+}
+
+void
+dav_svn__metrics_add_report(const char *name,
+                            apr_interval_time_t duration,
+                            apr_pool_t *scratch_pool)
+{
+  add_baton_t baton = { 0 };
+  const dav_report_elem *report;
+  apr_size_t len;
+
+  if (metrics == NULL)
+    return;
+
+  /* Don't let clients create arbitrary labels. */
+  for (report = dav_svn__reports_list; report->name; ++report)
+    if (strcmp(report->name, name) == 0)
+      break;
+
+  /* "update-report" -> "update" */
+  len = strlen(name);
+  if (report->name == NULL)
+    baton.report = "unknown";
+  else if (len > 7 && strcmp(name + len - 7, "-report") == 0)
+    baton.report = apr_pstrmemdup(scratch_pool, name, len - 7);
+  else
+    baton.report = name;
+
+  baton.duration = duration;
+  svn_error_clear(add(&baton));
+}
+
+svn_error_t *
+dav_svn__commit_txn(const char **conflict_p,
+                    svn_repos_t *repos,
+                    svn_revnum_t *new_rev,
+                    svn_fs_txn_t *txn,
+                    apr_pool_t *pool)
+{
+  add_baton_t baton = { 0 };
+  svn_error_t *err;
+
+  err = svn_repos__fs_commit_txn_timed(conflict_p, repos, new_rev, txn,
+                                       &baton.hooks_time, &baton.fs_time,
+                                       pool);
+
+  if (metrics)
+    {
+      baton.committed = SVN_IS_VALID_REVNUM(*new_rev);
+      svn_error_clear(add(&baton));
+    }
+
+  return svn_error_trace(err);
+}
+
+/* Baton type for open_locked. */
+typedef struct open_baton_t
+{
+  /* +1 when opening a repository, -1 when closing it. */
+  int delta;
+} open_baton_t;
+
+/* Count a repository as opened or closed as given by the open_baton_t
+ * BATON while holding the mutex. */
+static svn_error_t *
+open_locked(open_baton_t *baton)
+{
+  metrics->open_repositories += baton->delta;
+  if (baton->delta > 0)
+    metrics->opened_repositories++;
+
+  return SVN_NO_ERROR;
+}
+
+/* Count a repository as opened resp. closed, depending on DELTA. */
+static svn_error_t *
+count_open(int delta)
+{
+  open_baton_t baton;
+  baton.delta = delta;
+
+  SVN_MUTEX__WITH_LOCK(metrics->mutex, open_locked(&baton));
+
+  return SVN_NO_ERROR;
+}
+
+/* Pool cleanup function counting a repository as closed. */
+static apr_status_t
+repos_closed(void *data)
+{
+  svn_error_clear(count_open(-1));
+
+  return APR_SUCCESS;
+}
+
+void
+dav_svn__metrics_repos_opened(apr_pool_t *pool)
+{
+  if (metrics == NULL)
+    return;
+
+  svn_error_clear(count_open(1));
+  apr_pool_cleanup_register(pool, NULL, repos_closed, apr_pool_cleanup_null);
+}
+
+/* Append the HELP and TYPE lines for metric NAME of type TYPE to TEXT. */
+static void
+format_header(svn_stringbuf_t *text,
+              const char *name,
+              const char *type,
+              const char *help,
+              apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_appendcstr(text,
+                           apr_psprintf(scratch_pool,
+                                        "# HELP %s %s\n# TYPE %s %s\n",
+                                        name, help, name, type));
+}
+
+/* Append a single sample of metric NAME with VALUE to TEXT. */
+static void
+format_value(svn_stringbuf_t *text,
+             const char *name,
+             apr_uint64_t value,
+             apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_appendcstr(text,
+                           apr_psprintf(scratch_pool,
+                                        "%s %" APR_UINT64_T_FMT "\n",
+                                        name, value));
+}
+
+/* Append the samples of HISTOGRAM as metric NAME to TEXT.  LABELS are
+ * added to all samples and may be NULL. */
+static void
+format_histogram(svn_stringbuf_t *text,
+                 const char *name,
+                 const char *labels,
+                 const histogram_t *histogram,
+                 apr_pool_t *scratch_pool)
+{
+  const char *prefix = labels ? apr_pstrcat(scratch_pool, labels, ",",
+                                            SVN_VA_NULL)
+                              : "";
+  apr_uint64_t cumulative = 0;
+  apr_size_t i;
+
+  for (i = 0; i < BUCKET_COUNT; ++i)
+    {
+      cumulative += histogram->buckets[i];
+      svn_stringbuf_appendcstr(text,
+        apr_psprintf(scratch_pool,
+                     "%s_bucket{%sle=\"%s\"} %" APR_UINT64_T_FMT "\n",
+                     name, prefix,
+                     i < BUCKET_COUNT - 1 ? bucket_labels[i] : "+Inf",
+                     cumulative));
+    }
+
+  labels = labels ? apr_pstrcat(scratch_pool, "{", labels, "}", SVN_VA_NULL)
+                  : "";
+  svn_stringbuf_appendcstr(text,
+    apr_psprintf(scratch_pool,
+                 "%s_sum%s %.6f\n%s_count%s %" APR_UINT64_T_FMT "\n",
+                 name, labels, histogram->total_usec / 1000000.0,
+                 name, labels, histogram->count));
+}
+
+/* Baton type for format_locked. */
+typedef struct format_baton_t
+{
+  svn_stringbuf_t *text;
+  apr_pool_t *pool;
+} format_baton_t;
+
+/* Format the request metrics into the format_baton_t BATON while holding
+ * the mutex. */
+static svn_error_t *
+format_locked(format_baton_t *baton)
+{
+  svn_stringbuf_t *text = baton->text;
+  apr_pool_t *pool = baton->pool;
+  apr_array_header_t *reports
+    = svn_sort__hash(metrics->reports, svn_sort_compare_items_lexically,
+                     pool);
+  int i;
+
+  format_header(text, "svn_dav_report_duration_seconds", "histogram",
+                "Duration of REPORT requests by report type.", pool);
+  for (i = 0; i < reports->nelts; ++i)
+    {
+      const svn_sort__item_t *item = &APR_ARRAY_IDX(reports, i,
+                                                    svn_sort__item_t);
+      format_histogram(text, "svn_dav_report_duration_seconds",
+                       apr_psprintf(pool, "report=\"%s\"",
+                                    (const char *)item->key),
+                       item->value, pool);
+    }
+
+  format_header(text, "svn_dav_commit_hooks_duration_seconds", "histogram",
+                "Time spent in pre-commit and post-commit hooks by "
+                "successful commits.", pool);
+  format_histogram(text, "svn_dav_commit_hooks_duration_seconds", NULL,
+                   &metrics->commit_hooks, pool);
+
+  format_header(text, "svn_dav_commit_fs_duration_seconds", "histogram",
+                "Time spent writing and syncing new revisions to the "
+                "filesystem by successful commits.", pool);
+  format_histogram(text, "svn_dav_commit_fs_duration_seconds", NULL,
+                   &metrics->commit_fs, pool);
+
+  format_header(text, "svn_dav_commit_failures_total", "counter",
+                "Commits that did not create a new revision.", pool);
+  format_value(text, "svn_dav_commit_failures_total",
+               metrics->failed_commits, pool);
+
+  format_header(text, "svn_dav_open_repositories", "gauge",
+                "Repositories currently open.", pool);
+  format_value(text, "svn_dav_open_repositories",
+               (apr_uint64_t)MAX(metrics->open_repositories, 0), pool);
+
+  format_header(text, "svn_dav_repository_opens_total", "counter",
+                "Repositories opened.", pool);
+  format_value(text, "svn_dav_repository_opens_total",
+               metrics->opened_repositories, pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Append the statistics of the global membuffer cache to TEXT. */
+static void
+format_cache_info(svn_stringbuf_t *text,
+                  apr_pool_t *scratch_pool)
+{
+  svn_cache__info_t *info;
+
+  if (svn_cache__get_global_membuffer_cache() == NULL)
+    return;
+
+  info = svn_cache__membuffer_get_global_info(scratch_pool);
+
+  format_header(text, "svn_fs_cache_gets_total", "counter",
+                "Cache lookups.", scratch_pool);
+  format_value(text, "svn_fs_cache_gets_total", info->gets, scratch_pool);
+  format_header(text, "svn_fs_cache_hits_total", "counter",
+                "Cache lookups that found the data.", scratch_pool);
+  format_value(text, "svn_fs_cache_hits_total", info->hits, scratch_pool);
+  format_header(text, "svn_fs_cache_sets_total", "counter",
+                "Data items written to the cache.", scratch_pool);
+  format_value(text, "svn_fs_cache_sets_total", info->sets, scratch_pool);
+  format_header(text, "svn_fs_cache_failures_total", "counter",
+                "Failed cache accesses.", scratch_pool);
+  format_value(text, "svn_fs_cache_failures_total", info->failures,
+               scratch_pool);
+  format_header(text, "svn_fs_cache_used_bytes", "gauge",
+                "Size of the data currently cached.", scratch_pool);
+  format_value(text, "svn_fs_cache_used_bytes", info->used_size,
+               scratch_pool);
+  format_header(text, "svn_fs_cache_size_bytes", "gauge",
+                "Total size of the cache.", scratch_pool);
+  format_value(text, "svn_fs_cache_size_bytes", info->total_size,
+               scratch_pool);
+  format_header(text, "svn_fs_cache_entries", "gauge",
+                "Number of cached data items.", scratch_pool);
+  format_value(text, "svn_fs_cache_entries", info->used_entries,
+               scratch_pool);
+  format_header(text, "svn_fs_cache_max_entries", "gauge",
+                "Maximum number of cached data items.", scratch_pool);
+  format_value(text, "svn_fs_cache_max_entries", info->total_entries,
+               scratch_pool);
+}
+
+/* Append the samples of metric NAME for all locks in STATS to TEXT.
+ * GET_VALUE selects the value from each lock's statistics. */
+static void
+format_lock_values(svn_stringbuf_t *text,
+                   const char *name,
+                   const apr_array_header_t *stats,
+                   double (*get_value)(const svn_mutex__stats_t *),
+                   apr_pool_t *scratch_pool)
+{
+  int i;
+
+  for (i = 0; i < stats->nelts; ++i)
+    {
+      const svn_mutex__stats_t *lock
+        = &APR_ARRAY_IDX(stats, i, svn_mutex__stats_t);
+      svn_stringbuf_appendcstr(text,
+                               apr_psprintf(scratch_pool,
+                                            "%s{lock=\"%s\"} %.6f\n",
+                                            name, lock->name,
+                                            get_value(lock)));
+    }
+}
+
+/* Value getters for format_lock_values. */
+static double
+lock_acquisitions(const svn_mutex__stats_t *stats)
+{
+  return (double)stats->acquisitions;
+}
+
+static double
+lock_total_wait(const svn_mutex__stats_t *stats)
+{
+  return stats->total_wait / 1000000.0;
+}
+
+static double
+lock_max_wait(const svn_mutex__stats_t *stats)
+{
+  return stats->max_wait / 1000000.0;
+}
+
+static double
+lock_releases(const svn_mutex__stats_t *stats)
+{
+  return (double)stats->releases;
+}
+
+static double
+lock_total_hold(const svn_mutex__stats_t *stats)
+{
+  return stats->total_hold / 1000000.0;
+}
+
+static double
+lock_max_hold(const svn_mutex__stats_t *stats)
+{
+  return stats->max_hold / 1000000.0;
+}
+
+/* Append the lock contention statistics to TEXT, if they are enabled. */
+static svn_error_t *
+format_lock_info(svn_stringbuf_t *text,
+                 apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *stats;
+
+  if (!svn_mutex__stats_enabled())
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_mutex__get_stats(&stats, scratch_pool));
+
+  format_header(text, "svn_lock_acquisitions_total", "counter",
+                "Lock acquisitions.", scratch_pool);
+  format_lock_values(text, "svn_lock_acquisitions_total", stats,
+                     lock_acquisitions, scratch_pool);
+  format_header(text, "svn_lock_wait_seconds_total", "counter",
+                "Time spent waiting for locks.", scratch_pool);
+  format_lock_values(text, "svn_lock_wait_seconds_total", stats,
+                     lock_total_wait, scratch_pool);
+  format_header(text, "svn_lock_wait_seconds_max", "gauge",
+                "Longest time spent waiting for a lock.", scratch_pool);
+  format_lock_values(text, "svn_lock_wait_seconds_max", stats,
+                     lock_max_wait, scratch_pool);
+  format_header(text, "svn_lock_releases_total", "counter",
+                "Lock releases with known hold time.", scratch_pool);
+  format_lock_values(text, "svn_lock_releases_total", stats,
+                     lock_releases, scratch_pool);
+  format_header(text, "svn_lock_hold_seconds_total", "counter",
+                "Time locks have been held.", scratch_pool);
+  format_lock_values(text, "svn_lock_hold_seconds_total", stats,
+                     lock_total_hold, scratch_pool);
+  format_header(text, "svn_lock_hold_seconds_max", "gauge",
+                "Longest time a lock has been held.", scratch_pool);
+  format_lock_values(text, "svn_lock_hold_seconds_max", stats,
+                     lock_max_hold, scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+int dav_svn__metrics(request_rec *r)
+{
+  format_baton_t baton;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  if (r->method_number != M_GET || strcmp(r->handler, "svn-metrics"))
+    return DECLINED;
+
+  baton.text = svn_stringbuf_create_empty(r->pool);
+  baton.pool = r->pool;
+
+  if (metrics)
+    {
+      SVN_MUTEX__WITH_LOCK(metrics->mutex, format_locked(&baton));
+    }
+  format_cache_info(baton.text, r->pool);
+  err = format_lock_info(baton.text, r->pool);
+  if (err)
+    {
+      ap_log_rerror(APLOG_MARK, APLOG_ERR, err->apr_err, r,
+                    "mod_dav_svn: error reading lock statistics: '%s'",
+                    err->message ? err->message : "(no more info)");
+      svn_error_clear(err);
+      return HTTP_INTERNAL_SERVER_ERROR;
+    }
+
+  ap_set_content_type(r, "text/plain; version=0.0.4; charset=utf-8");
+  ap_rputs(baton.text->data, r);
+
+  return 0;
+}
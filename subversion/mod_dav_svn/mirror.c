@@ -27,18 +27,33 @@
 
 #include <httpd.h>
 #include <http_core.h>
+#include <http_log.h>
+
+#include "svn_sorts.h"
 
 #include "private/svn_fspath.h"
 
+#include "mod_dav_svn.h"
 #include "dav_svn.h"
 
+/* Number of bytes at the start of a MERGE response that we search for
+   the new revision number. */
+#define COMMIT_WAIT_SCAN_SIZE 0x2000
+
+/* Interval at which we poll the local mirror for the new revision. */
+#define COMMIT_WAIT_INTERVAL (APR_USEC_PER_SEC / 20)
+
 
 /* Tweak the request record R, and add the necessary filters, so that
    the request is ready to be proxied away.  MASTER_URI is the URI
    specified in the SVNMasterURI Apache configuration value.
    URI_SEGMENT is the URI bits relative to the repository root (but if
    non-empty, *does* have a leading slash delimiter).
-   MASTER_URI and URI_SEGMENT are not URI-encoded. */
+   MASTER_URI and URI_SEGMENT are not URI-encoded.
+
+   mod_proxy keeps persistent connections to the master only if a worker
+   has been defined for MASTER_URI, e.g. with a <Proxy MASTER_URI> section.
+   Otherwise, every proxied request opens a new connection. */
 static int proxy_request_fixup(request_rec *r,
                                const char *master_uri,
                                const char *uri_segment)
@@ -128,6 +143,12 @@ int dav_svn__proxy_request_fixup(request_rec *r)
             seg += strlen(root_dir);
             rv = proxy_request_fixup(r, master_uri, seg);
             if (rv) return rv;
+
+            /* Let the client read its own commit from us right away. */
+            if (r->method_number == M_MERGE
+                && dav_svn__get_master_commit_wait(r) > 0)
+                ap_add_output_filter("MasterCommitWait", NULL, r,
+                                     r->connection);
             return OK;
         }
     }
@@ -340,3 +361,125 @@ apr_status_t dav_svn__location_body_filter(ap_filter_t *f,
     }
     return ap_pass_brigade(f->next, bb);
 }
+
+/* State of dav_svn__master_commit_wait_filter. */
+typedef struct commit_wait_ctx_t
+{
+    /* The response so far, set aside until we have seen all of it. */
+    apr_bucket_brigade *bb;
+
+    /* The first COMMIT_WAIT_SCAN_SIZE bytes of the response body. */
+    svn_stringbuf_t *head;
+} commit_wait_ctx_t;
+
+/* Wait until the local repository of request R contains REVISION or the
+   time configured by SVNMasterCommitWait has passed.  Problems only get
+   logged because the commit itself has already succeeded. */
+static void wait_for_revision(request_rec *r, svn_revnum_t revision)
+{
+    apr_time_t deadline
+      = apr_time_now()
+      + apr_time_from_sec(dav_svn__get_master_commit_wait(r));
+    svn_revnum_t youngest = SVN_INVALID_REVNUM;
+    const char *fs_path;
+    svn_repos_t *repos;
+    svn_error_t *serr;
+    dav_error *derr;
+
+    derr = dav_svn_get_repos_path2(r, dav_svn__get_root_dir(r), &fs_path,
+                                   r->pool);
+    if (derr) {
+        ap_log_rerror(APLOG_MARK, APLOG_WARNING, 0, r,
+                      "Can't wait for r%ld to be mirrored: %s",
+                      revision, derr->desc);
+        return;
+    }
+
+    serr = svn_repos_open3(&repos, fs_path, NULL, r->pool, r->pool);
+    while (!serr) {
+        serr = svn_fs_youngest_rev(&youngest, svn_repos_fs(repos), r->pool);
+        if (serr || youngest >= revision || apr_time_now() >= deadline)
+            break;
+
+        apr_sleep(COMMIT_WAIT_INTERVAL);
+    }
+
+    if (serr) {
+        ap_log_rerror(APLOG_MARK, APLOG_WARNING, 0, r,
+                      "Can't wait for r%ld to be mirrored: %s",
+                      revision, svn_err_best_message(serr, NULL, 0));
+        svn_error_clear(serr);
+    }
+    else if (youngest < revision) {
+        ap_log_rerror(APLOG_MARK, APLOG_INFO, 0, r,
+                      "Timeout waiting for r%ld to be mirrored", revision);
+    }
+}
+
+apr_status_t dav_svn__master_commit_wait_filter(ap_filter_t *f,
+                                                apr_bucket_brigade *bb)
+{
+    request_rec *r = f->r;
+    commit_wait_ctx_t *ctx = f->ctx;
+    svn_boolean_t eos = FALSE;
+    const char *version_name;
+    apr_bucket *bkt;
+
+    if (!ctx) {
+        ctx = f->ctx = apr_pcalloc(r->pool, sizeof(*ctx));
+        ctx->head = svn_stringbuf_create_empty(r->pool);
+    }
+
+    /* Collect the start of the response body. */
+    for (bkt = APR_BRIGADE_FIRST(bb);
+         bkt != APR_BRIGADE_SENTINEL(bb);
+         bkt = APR_BUCKET_NEXT(bkt)) {
+
+        const char *data;
+        apr_size_t len;
+        apr_status_t rv;
+
+        if (APR_BUCKET_IS_EOS(bkt)) {
+            eos = TRUE;
+            break;
+        }
+
+        if (APR_BUCKET_IS_METADATA(bkt)
+            || ctx->head->len >= COMMIT_WAIT_SCAN_SIZE)
+            continue;
+
+        rv = apr_bucket_read(bkt, &data, &len, APR_BLOCK_READ);
+        if (rv)
+            return rv;
+
+        svn_stringbuf_appendbytes(ctx->head, data,
+                                  MIN(len, COMMIT_WAIT_SCAN_SIZE
+                                           - ctx->head->len));
+    }
+
+    /* The client must not see the end of the response before we are
+       done waiting. */
+    if (!eos)
+        return ap_save_brigade(f, &ctx->bb, &bb, r->pool);
+
+    /* The first version-name in a MERGE response is the one of the new
+       baseline, i.e. the new revision number. */
+    version_name = strstr(ctx->head->data, "version-name>");
+    if (r->status == HTTP_OK && version_name) {
+        svn_revnum_t revision;
+        svn_error_t *serr = svn_revnum_parse(&revision,
+                                             version_name
+                                               + strlen("version-name>"),
+                                             NULL);
+        if (serr)
+            svn_error_clear(serr);
+        else
+            wait_for_revision(r, revision);
+    }
+
+    if (ctx->bb)
+        APR_BRIGADE_PREPEND(bb, ctx->bb);
+
+    ap_remove_output_filter(f);
+    return ap_pass_brigade(f->next, bb);
+}
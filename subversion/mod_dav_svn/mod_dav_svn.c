@@ -33,6 +33,9 @@
 #include <http_log.h>
 #include <ap_provider.h>
 #include <mod_dav.h>
+#ifdef AP_NEED_SET_MUTEX_PERMS
+#include <unixd.h>
+#endif
 
 #include "svn_hash.h"
 #include "svn_version.h"
@@ -42,7 +45,9 @@
 #include "svn_dso.h"
 #include "mod_dav_svn.h"
 
+#include "private/svn_cache.h"
 #include "private/svn_fspath.h"
+#include "private/svn_mutex.h"
 #include "private/svn_subr_private.h"
 
 #include "dav_svn.h"
@@ -62,6 +67,23 @@ typedef struct server_conf_t {
   const char *special_uri;
   svn_boolean_t use_utf8;
 
+  /* Whether all server processes shall share a single in-memory cache. */
+  svn_boolean_t shared_cache;
+
+  /* Path of the file to read the cache contents from at startup and to
+   * write them to at shutdown.  NULL if not configured. */
+  const char *cache_snapshot;
+
+  /* Directory to keep the persistent second cache tier in.  NULL if not
+   * configured. */
+  const char *disk_cache_path;
+
+  /* Size limit of DISK_CACHE_PATH in bytes.  0 for the default. */
+  apr_uint64_t disk_cache_size;
+
+  /* Whether to collect lock wait and hold times for the metrics. */
+  svn_boolean_t lock_statistics;
+
   /* The compression level we will pass to svn_txdelta_to_svndiff3()
    * for wire-compression. Negative value used to specify default
      compression level. */
@@ -101,12 +123,17 @@ typedef struct dir_conf_t {
   const char *root_dir;              /* our top-level directory */
   const char *master_uri;            /* URI to the master SVN repos */
   svn_version_t *master_version;     /* version of master server */
+  int master_commit_wait;            /* seconds to wait for proxied commits
+                                        to arrive in the local mirror */
   const char *activities_db;         /* path to activities database(s) */
   enum conf_flag txdelta_cache;      /* whether to enable txdelta caching */
   enum conf_flag fulltext_cache;     /* whether to enable fulltext caching */
   enum conf_flag revprop_cache;      /* whether to enable revprop caching */
   enum conf_flag nodeprop_cache;     /* whether to enable nodeprop caching */
   enum conf_flag block_read;         /* whether to enable block read mode */
+  enum conf_flag replay_cache;       /* whether to cache replays on disk */
+  enum conf_flag segments_cache;     /* whether to cache location segments */
+  int update_prefetch;               /* files to compute deltas ahead for */
   const char *hooks_env;             /* path to hook script env config file */
 } dir_conf_t;
 
@@ -120,6 +147,43 @@ extern module AP_MODULE_DECLARE_DATA dav_svn_module;
 /* The authz_svn provider for bypassing path authz. */
 static authz_svn__subreq_bypass_func_t pathauthz_bypass_func = NULL;
 
+/* Return TRUE if this is the first time this function gets called with
+ * USERDATA_KEY during the life time of the httpd process of server S. */
+static svn_boolean_t
+is_first_post_config_run(server_rec *s, const char *userdata_key)
+{
+  void *data = NULL;
+
+  apr_pool_userdata_get(&data, userdata_key, s->process->pool);
+  if (data != NULL)
+    return FALSE;
+
+  apr_pool_userdata_set((const void *)1, userdata_key,
+                        apr_pool_cleanup_null, s->process->pool);
+  return TRUE;
+}
+
+/* Pool cleanup function writing the global cache contents to the snapshot
+ * file at path DATA.  Errors are logged but otherwise ignored. */
+static apr_status_t
+save_cache_snapshot(void *data)
+{
+  const char *path = data;
+  apr_pool_t *pool = svn_pool_create(NULL);
+  svn_error_t *serr = svn_cache__save_global_membuffer_cache(path, pool);
+
+  if (serr)
+    {
+      ap_log_error(APLOG_MARK, APLOG_WARNING, serr->apr_err, NULL,
+                   "mod_dav_svn: error writing cache snapshot '%s': '%s'",
+                   path, serr->message ? serr->message : "(no more info)");
+      svn_error_clear(serr);
+    }
+
+  svn_pool_destroy(pool);
+  return APR_SUCCESS;
+}
+
 static int
 init(apr_pool_t *p, apr_pool_t *plog, apr_pool_t *ptemp, server_rec *s)
 {
@@ -141,9 +205,111 @@ init(apr_pool_t *p, apr_pool_t *plog, apr_pool_t *ptemp, server_rec *s)
   conf = ap_get_module_config(s->module_config, &dav_svn_module);
   svn_utf_initialize2(conf->use_utf8, p);
 
+  /* httpd runs this hook once for a configuration check before the
+   * actual startup.  Skip the cache setup in that first call to not
+   * waste a full-size cache on it. */
+  if (is_first_post_config_run(s, "mod_dav_svn-cache-init"))
+    return OK;
+
+  /* The shared cache must be allocated here, in the parent process, such
+   * that all children inherit it. */
+  if (conf->shared_cache)
+    {
+      serr = svn_cache__create_shared_global_membuffer_cache(ptemp);
+      if (serr)
+        {
+          ap_log_perror(APLOG_MARK, APLOG_ERR, serr->apr_err, p,
+                        "mod_dav_svn: error creating shared cache: '%s'",
+                        serr->message ? serr->message : "(no more info)");
+          svn_error_clear(serr);
+        }
+#ifdef AP_NEED_SET_MUTEX_PERMS
+      else
+        {
+          /* The children run as the configured user and must be able to
+           * use the cache locks created by root. */
+          apr_array_header_t *locks
+            = svn_cache__get_global_membuffer_locks(ptemp);
+          int i;
+
+          for (i = 0; i < locks->nelts; i++)
+            {
+              apr_status_t status = ap_unixd_set_global_mutex_perms(
+                  APR_ARRAY_IDX(locks, i, apr_global_mutex_t *));
+              if (status)
+                {
+                  ap_log_perror(APLOG_MARK, APLOG_CRIT, status, p,
+                                "mod_dav_svn: can't set permissions of "
+                                "the shared cache mutexes");
+                  return HTTP_INTERNAL_SERVER_ERROR;
+                }
+            }
+        }
+#endif
+    }
+
+  if (conf->cache_snapshot)
+    {
+      /* Populate the cache only once per httpd process.  Upon graceful
+       * restarts, the cache in this process still has those contents. */
+      if (is_first_post_config_run(s, "mod_dav_svn-cache-snapshot"))
+        {
+          serr = svn_cache__load_global_membuffer_cache(conf->cache_snapshot,
+                                                        ptemp);
+          if (serr)
+            {
+              ap_log_perror(APLOG_MARK, APLOG_WARNING, serr->apr_err, p,
+                            "mod_dav_svn: error loading cache snapshot "
+                            "'%s': '%s'", conf->cache_snapshot,
+                            serr->message ? serr->message
+                                          : "(no more info)");
+              svn_error_clear(serr);
+            }
+        }
+
+      /* A shared cache gets written by this process upon shutdown or
+       * restart.  Private caches only live as long as their child process
+       * and there is no single one to write, so they are not saved. */
+      if (conf->shared_cache)
+        apr_pool_cleanup_register(p, conf->cache_snapshot,
+                                  save_cache_snapshot,
+                                  apr_pool_cleanup_null);
+    }
+
   return OK;
 }
 
+/* Implements the #child_init hook: re-attach to the shared cache and
+ * start collecting metrics. */
+static void
+child_init(apr_pool_t *p, server_rec *s)
+{
+  server_conf_t *conf = ap_get_module_config(s->module_config,
+                                             &dav_svn_module);
+  svn_error_t *serr = svn_cache__global_membuffer_child_init(p);
+  if (serr)
+    {
+      ap_log_error(APLOG_MARK, APLOG_ERR, serr->apr_err, s,
+                   "mod_dav_svn: error initializing shared cache: '%s'",
+                   serr->message ? serr->message : "(no more info)");
+      svn_error_clear(serr);
+    }
+
+  dav_svn__metrics_init(p);
+
+  if (conf->lock_statistics)
+    {
+      serr = svn_mutex__enable_stats(p);
+      if (serr)
+        {
+          ap_log_error(APLOG_MARK, APLOG_ERR, serr->apr_err, s,
+                       "mod_dav_svn: error enabling lock statistics: '%s'",
+                       serr->message ? serr->message : "(no more info)");
+          svn_error_clear(serr);
+        }
+    }
+}
+
 static svn_error_t *
 malfunction_handler(svn_boolean_t can_return,
                     const char *file, int line,
@@ -210,6 +376,8 @@ merge_server_config(apr_pool_t *p, void *base, void *overrides)
   newconf = apr_pcalloc(p, sizeof(*newconf));
 
   newconf->special_uri = INHERIT_VALUE(parent, child, special_uri);
+  newconf->disk_cache_path = INHERIT_VALUE(parent, child, disk_cache_path);
+  newconf->disk_cache_size = INHERIT_VALUE(parent, child, disk_cache_size);
 
   if (child->compression_level < 0)
     {
@@ -260,6 +428,8 @@ merge_dir_config(apr_pool_t *p, void *base, void *overrides)
   newconf->fs_path = INHERIT_VALUE(parent, child, fs_path);
   newconf->master_uri = INHERIT_VALUE(parent, child, master_uri);
   newconf->master_version = INHERIT_VALUE(parent, child, master_version);
+  newconf->master_commit_wait = INHERIT_VALUE(parent, child,
+                                              master_commit_wait);
   newconf->activities_db = INHERIT_VALUE(parent, child, activities_db);
   newconf->repo_name = INHERIT_VALUE(parent, child, repo_name);
   newconf->xslt_uri = INHERIT_VALUE(parent, child, xslt_uri);
@@ -274,6 +444,9 @@ merge_dir_config(apr_pool_t *p, void *base, void *overrides)
   newconf->revprop_cache = INHERIT_VALUE(parent, child, revprop_cache);
   newconf->nodeprop_cache = INHERIT_VALUE(parent, child, nodeprop_cache);
   newconf->block_read = INHERIT_VALUE(parent, child, block_read);
+  newconf->replay_cache = INHERIT_VALUE(parent, child, replay_cache);
+  newconf->segments_cache = INHERIT_VALUE(parent, child, segments_cache);
+  newconf->update_prefetch = INHERIT_VALUE(parent, child, update_prefetch);
   newconf->root_dir = INHERIT_VALUE(parent, child, root_dir);
   newconf->hooks_env = INHERIT_VALUE(parent, child, hooks_env);
 
@@ -348,6 +521,27 @@ SVNMasterVersion_cmd(cmd_parms *cmd, void *config, const char *arg1)
 }
 
 
+static const char *
+SVNMasterCommitWait_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  dir_conf_t *conf = config;
+  int value = 0;
+  svn_error_t *err = svn_cstring_atoi(&value, arg1);
+  if (err)
+    {
+      svn_error_clear(err);
+      return "Invalid decimal number for the SVN master commit wait.";
+    }
+
+  if (value < 0)
+    return "The SVN master commit wait must not be negative.";
+
+  conf->master_commit_wait = value;
+
+  return NULL;
+}
+
+
 static const char *
 SVNActivitiesDB_cmd(cmd_parms *cmd, void *config, const char *arg1)
 {
@@ -595,6 +789,52 @@ SVNBlockRead_cmd(cmd_parms *cmd, void *config, int arg)
   return NULL;
 }
 
+static const char *
+SVNReplayCache_cmd(cmd_parms *cmd, void *config, int arg)
+{
+  dir_conf_t *conf = config;
+
+  if (arg)
+    conf->replay_cache = CONF_FLAG_ON;
+  else
+    conf->replay_cache = CONF_FLAG_OFF;
+
+  return NULL;
+}
+
+static const char *
+SVNCacheLocationSegments_cmd(cmd_parms *cmd, void *config, int arg)
+{
+  dir_conf_t *conf = config;
+
+  if (arg)
+    conf->segments_cache = CONF_FLAG_ON;
+  else
+    conf->segments_cache = CONF_FLAG_OFF;
+
+  return NULL;
+}
+
+static const char *
+SVNUpdatePrefetch_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  dir_conf_t *conf = config;
+  int value = 0;
+  svn_error_t *err = svn_cstring_atoi(&value, arg1);
+  if (err)
+    {
+      svn_error_clear(err);
+      return "Invalid decimal number for the SVN update prefetch.";
+    }
+
+  if (value < 0)
+    return "The SVN update prefetch must not be negative.";
+
+  conf->update_prefetch = value;
+
+  return NULL;
+}
+
 static const char *
 SVNInMemoryCacheSize_cmd(cmd_parms *cmd, void *config, const char *arg1)
 {
@@ -615,6 +855,81 @@ SVNInMemoryCacheSize_cmd(cmd_parms *cmd, void *config, const char *arg1)
   return NULL;
 }
 
+static const char *
+SVNInMemoryCacheMaxSize_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  apr_uint64_t value = 0;
+  svn_error_t *err = svn_cstring_atoui64(&value, arg1);
+  if (err)
+    {
+      svn_error_clear(err);
+      return "Invalid decimal number for the SVN maximum cache size.";
+    }
+
+  svn_cache__set_global_membuffer_max_size(value * 0x400);
+
+  return NULL;
+}
+
+static const char *
+SVNInMemoryCachePrefixQuota_cmd(cmd_parms *cmd, void *config,
+                                const char *arg1)
+{
+  apr_uint64_t value = 0;
+  svn_error_t *err = svn_cstring_atoui64(&value, arg1);
+  if (err)
+    {
+      svn_error_clear(err);
+      return "Invalid decimal number for the SVN cache prefix quota.";
+    }
+
+  svn_cache__set_global_membuffer_prefix_quota(value * 0x400);
+
+  return NULL;
+}
+
+static const char *
+SVNInMemoryCacheAdmissionFilter_cmd(cmd_parms *cmd, void *config, int arg)
+{
+  svn_cache__set_global_membuffer_admission_filter(arg);
+
+  return NULL;
+}
+
+static const char *
+SVNOnDiskCachePath_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  server_conf_t *conf;
+
+  conf = ap_get_module_config(cmd->server->module_config,
+                              &dav_svn_module);
+  conf->disk_cache_path = ap_server_root_relative(cmd->pool, arg1);
+  if (conf->disk_cache_path == NULL)
+    return apr_pstrcat(cmd->pool, "Invalid SVNOnDiskCachePath path ",
+                       arg1, SVN_VA_NULL);
+
+  return NULL;
+}
+
+static const char *
+SVNOnDiskCacheSize_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  server_conf_t *conf;
+  apr_uint64_t value = 0;
+  svn_error_t *err = svn_cstring_atoui64(&value, arg1);
+  if (err)
+    {
+      svn_error_clear(err);
+      return "Invalid decimal number for the SVN on-disk cache size.";
+    }
+
+  conf = ap_get_module_config(cmd->server->module_config,
+                              &dav_svn_module);
+  conf->disk_cache_size = value * 0x400;
+
+  return NULL;
+}
+
 static const char *
 SVNCompressionLevel_cmd(cmd_parms *cmd, void *config, const char *arg1)
 {
@@ -655,6 +970,45 @@ SVNUseUTF8_cmd(cmd_parms *cmd, void *config, int arg)
   return NULL;
 }
 
+static const char *
+SVNInMemoryCacheShared_cmd(cmd_parms *cmd, void *config, int arg)
+{
+  server_conf_t *conf;
+
+  conf = ap_get_module_config(cmd->server->module_config,
+                              &dav_svn_module);
+  conf->shared_cache = arg;
+
+  return NULL;
+}
+
+static const char *
+SVNLockStatistics_cmd(cmd_parms *cmd, void *config, int arg)
+{
+  server_conf_t *conf;
+
+  conf = ap_get_module_config(cmd->server->module_config,
+                              &dav_svn_module);
+  conf->lock_statistics = arg;
+
+  return NULL;
+}
+
+static const char *
+SVNInMemoryCacheSnapshot_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  server_conf_t *conf;
+
+  conf = ap_get_module_config(cmd->server->module_config,
+                              &dav_svn_module);
+  conf->cache_snapshot = ap_server_root_relative(cmd->pool, arg1);
+  if (conf->cache_snapshot == NULL)
+    return apr_pstrcat(cmd->pool, "Invalid SVNInMemoryCacheSnapshot path ",
+                       arg1, SVN_VA_NULL);
+
+  return NULL;
+}
+
 static const char *
 SVNHooksEnv_cmd(cmd_parms *cmd, void *config, const char *arg1)
 {
@@ -791,6 +1145,16 @@ dav_svn__get_master_version(request_rec *r)
 }
 
 
+int
+dav_svn__get_master_commit_wait(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+  return conf->master_uri ? conf->master_commit_wait : 0;
+}
+
+
 const char *
 dav_svn__get_xslt_uri(request_rec *r)
 {
@@ -1026,6 +1390,33 @@ dav_svn__get_block_read_flag(request_rec *r)
   return conf->block_read == CONF_FLAG_ON;
 }
 
+svn_boolean_t
+dav_svn__get_replay_cache_flag(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+  return conf->replay_cache == CONF_FLAG_ON;
+}
+
+svn_boolean_t
+dav_svn__get_segments_cache_flag(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+  return conf->segments_cache == CONF_FLAG_ON;
+}
+
+int
+dav_svn__get_update_prefetch(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+  return conf->update_prefetch;
+}
+
 int
 dav_svn__get_compression_level(request_rec *r)
 {
@@ -1044,6 +1435,26 @@ dav_svn__get_compression_level(request_rec *r)
     }
 }
 
+const char *
+dav_svn__get_disk_cache_path(request_rec *r)
+{
+  server_conf_t *conf;
+
+  conf = ap_get_module_config(r->server->module_config,
+                              &dav_svn_module);
+  return conf->disk_cache_path;
+}
+
+apr_uint64_t
+dav_svn__get_disk_cache_size(request_rec *r)
+{
+  server_conf_t *conf;
+
+  conf = ap_get_module_config(r->server->module_config,
+                              &dav_svn_module);
+  return conf->disk_cache_size;
+}
+
 const char *
 dav_svn__get_hooks_env(request_rec *r)
 {
@@ -1326,6 +1737,13 @@ static const command_rec cmds[] =
                 "specifies the Subversion release version of a master "
                 "Subversion server "),
 
+  /* per directory/location */
+  AP_INIT_TAKE1("SVNMasterCommitWait", SVNMasterCommitWait_cmd, NULL,
+                ACCESS_CONF,
+                "specifies for how many seconds a successful proxied commit "
+                "waits for the new revision to arrive in the local mirror "
+                "(default is 0)."),
+
   /* per directory/location */
   AP_INIT_TAKE1("SVNActivitiesDB", SVNActivitiesDB_cmd, NULL, ACCESS_CONF,
                 "specifies the location in the filesystem in which the "
@@ -1381,6 +1799,27 @@ static const command_rec cmds[] =
                "caches (see SVNInMemoryCacheSize) have been configured."
                "(default is Off)."),
 
+  /* per directory/location */
+  AP_INIT_FLAG("SVNReplayCache", SVNReplayCache_cmd, NULL,
+               ACCESS_CONF|RSRC_CONF,
+               "enables recording replays of revisions in the repository's "
+               "replay-cache directory and serving later replays from "
+               "there (default is Off)."),
+
+  /* per directory/location */
+  AP_INIT_FLAG("SVNCacheLocationSegments", SVNCacheLocationSegments_cmd,
+               NULL, ACCESS_CONF|RSRC_CONF,
+               "enables recording the location segments of copy sources in "
+               "the repository's segments-cache directory and reusing them "
+               "(default is Off)."),
+
+  /* per directory/location */
+  AP_INIT_TAKE1("SVNUpdatePrefetch", SVNUpdatePrefetch_cmd, NULL,
+                ACCESS_CONF|RSRC_CONF,
+                "specifies for how many files ahead the text deltas of "
+                "bulk update responses are computed on worker threads "
+                "while the response is being sent (default is 0)."),
+
   /* per server */
   AP_INIT_TAKE1("SVNInMemoryCacheSize", SVNInMemoryCacheSize_cmd, NULL,
                 RSRC_CONF,
@@ -1388,6 +1827,54 @@ static const command_rec cmds[] =
                 "in-memory object cache (default value is 16384; 0 switches "
                 "to dynamically sized caches)."),
   /* per server */
+  AP_INIT_FLAG("SVNInMemoryCacheShared", SVNInMemoryCacheShared_cmd, NULL,
+               RSRC_CONF,
+               "share a single in-memory object cache (see "
+               "SVNInMemoryCacheSize) between all server processes instead "
+               "of using one cache per process (default is Off)."),
+  /* per server */
+  AP_INIT_FLAG("SVNLockStatistics", SVNLockStatistics_cmd, NULL,
+               RSRC_CONF,
+               "enables collecting wait and hold times of internal locks "
+               "for the svn-metrics handler (default is Off)."),
+  /* per server */
+  AP_INIT_TAKE1("SVNInMemoryCacheSnapshot", SVNInMemoryCacheSnapshot_cmd,
+                NULL, RSRC_CONF,
+                "specifies a file to save the in-memory object cache "
+                "contents to upon shutdown and to restore them from upon "
+                "startup (default is none).  The contents are only saved "
+                "if SVNInMemoryCacheShared is on."),
+  /* per server */
+  AP_INIT_TAKE1("SVNOnDiskCachePath", SVNOnDiskCachePath_cmd,
+                NULL, RSRC_CONF,
+                "specifies a directory on fast local storage to keep "
+                "reconstructed file contents in as a second tier below "
+                "the in-memory object cache (default is none)."),
+  /* per server */
+  AP_INIT_TAKE1("SVNOnDiskCacheSize", SVNOnDiskCacheSize_cmd,
+                NULL, RSRC_CONF,
+                "specifies the maximum size in kB of the data kept in "
+                "SVNOnDiskCachePath per server process "
+                "(default is 16777216)."),
+  /* per server */
+  AP_INIT_TAKE1("SVNInMemoryCacheMaxSize", SVNInMemoryCacheMaxSize_cmd,
+                NULL, RSRC_CONF,
+                "specifies the size in kB up to which the in-memory object "
+                "cache may later be grown by changing SVNInMemoryCacheSize "
+                "upon graceful restarts (default is SVNInMemoryCacheSize)."),
+  /* per server */
+  AP_INIT_TAKE1("SVNInMemoryCachePrefixQuota",
+                SVNInMemoryCachePrefixQuota_cmd, NULL, RSRC_CONF,
+                "specifies the maximum size in kB of the data that any "
+                "single repository may keep in each of its in-memory "
+                "caches (default is 0, i.e. unlimited)."),
+  /* per server */
+  AP_INIT_FLAG("SVNInMemoryCacheAdmissionFilter",
+               SVNInMemoryCacheAdmissionFilter_cmd, NULL, RSRC_CONF,
+               "enables a frequency-based admission filter that prevents "
+               "one-off scans from evicting frequently used data from the "
+               "in-memory object cache (default is Off)."),
+  /* per server */
   AP_INIT_TAKE1("SVNCompressionLevel", SVNCompressionLevel_cmd, NULL,
                 RSRC_CONF,
                 "specifies the compression level used before sending file "
@@ -1428,6 +1915,7 @@ register_hooks(apr_pool_t *pconf)
 {
   ap_hook_pre_config(init_dso, NULL, NULL, APR_HOOK_REALLY_FIRST);
   ap_hook_post_config(init, NULL, NULL, APR_HOOK_MIDDLE);
+  ap_hook_child_init(child_init, NULL, NULL, APR_HOOK_MIDDLE);
 
   /* our provider */
   dav_register_provider(pconf, "svn", &provider);
@@ -1444,6 +1932,9 @@ register_hooks(apr_pool_t *pconf)
   /* Handler to GET Subversion's FSFS cache stats, a bit like mod_status. */
   ap_hook_handler(dav_svn__status, NULL, NULL, APR_HOOK_MIDDLE);
 
+  /* Handler to GET request and cache metrics for Prometheus. */
+  ap_hook_handler(dav_svn__metrics, NULL, NULL, APR_HOOK_MIDDLE);
+
   /* live property handling */
   dav_hook_gather_propsets(dav_svn__gather_propsets, NULL, NULL,
                            APR_HOOK_MIDDLE);
@@ -1459,6 +1950,9 @@ register_hooks(apr_pool_t *pconf)
                             NULL, AP_FTYPE_CONTENT_SET);
   ap_register_input_filter("IncomingRewrite", dav_svn__location_in_filter,
                            NULL, AP_FTYPE_CONTENT_SET);
+  ap_register_output_filter("MasterCommitWait",
+                            dav_svn__master_commit_wait_filter,
+                            NULL, AP_FTYPE_CONTENT_SET);
   ap_hook_fixups(dav_svn__proxy_request_fixup, NULL, NULL, APR_HOOK_MIDDLE);
   /* translate_name hook is LAST so that it doesn't interfere with modules
    * like mod_alias that are MIDDLE. */
@@ -41,6 +41,7 @@
 #include "svn_base64.h"
 
 #include "private/svn_fspath.h"
+#include "private/svn_repos_private.h"
 
 #include "../dav_svn.h"
 
@@ -221,13 +222,24 @@ dav_svn__get_location_segments_report(const dav_resource *resource,
   location_segment_baton.sent_opener = FALSE;
   location_segment_baton.output = output;
   location_segment_baton.bb = bb;
-  if ((serr = svn_repos_node_location_segments(resource->info->repos->repos,
+  if (dav_svn__get_segments_cache_flag(resource->info->r))
+    serr = svn_repos__node_location_segments_cached(
+                                               resource->info->repos->repos,
                                                abs_path, peg_revision,
                                                start_rev, end_rev,
                                                location_segment_receiver,
                                                &location_segment_baton,
                                                dav_svn__authz_read_func(&arb),
-                                               &arb, resource->pool)))
+                                               &arb, resource->pool);
+  else
+    serr = svn_repos_node_location_segments(resource->info->repos->repos,
+                                            abs_path, peg_revision,
+                                            start_rev, end_rev,
+                                            location_segment_receiver,
+                                            &location_segment_baton,
+                                            dav_svn__authz_read_func(&arb),
+                                            &arb, resource->pool);
+  if (serr)
     {
       derr = dav_svn__convert_err(serr, HTTP_BAD_REQUEST, NULL,
                                   resource->pool);
@@ -38,6 +38,7 @@
 #include "svn_dav.h"
 #include "svn_props.h"
 #include "private/svn_log.h"
+#include "private/svn_repos_private.h"
 
 #include "../dav_svn.h"
 
@@ -47,6 +48,7 @@ typedef struct edit_baton_t {
   dav_svn__output *output;
   svn_boolean_t started;
   svn_boolean_t sending_textdelta;
+  int svndiff_version;
   int compression_level;
 } edit_baton_t;
 
@@ -326,7 +328,7 @@ apply_textdelta(void *file_baton,
                           dav_svn__make_base64_output_stream(eb->bb,
                                                              eb->output,
                                                              pool),
-                          0,
+                          eb->svndiff_version,
                           eb->compression_level,
                           pool);
 
@@ -368,6 +370,7 @@ make_editor(const svn_delta_editor_t **editor,
             void **edit_baton,
             apr_bucket_brigade *bb,
             dav_svn__output *output,
+            int svndiff_version,
             int compression_level,
             apr_pool_t *pool)
 {
@@ -378,6 +381,7 @@ make_editor(const svn_delta_editor_t **editor,
   eb->output = output;
   eb->started = FALSE;
   eb->sending_textdelta = FALSE;
+  eb->svndiff_version = svndiff_version;
   eb->compression_level = compression_level;
 
   e->set_target_revision = set_target_revision;
@@ -543,13 +547,22 @@ dav_svn__replay_report(const dav_resource *resource,
     }
 
   make_editor(&editor, &edit_baton, bb, output,
+              resource->info->svndiff_version,
               dav_svn__get_compression_level(resource->info->r),
               resource->pool);
 
-  if ((err = svn_repos_replay2(root, base_dir, low_water_mark,
-                               send_deltas, editor, edit_baton,
-                               dav_svn__authz_read_func(&arb), &arb,
-                               resource->pool)))
+  if (dav_svn__get_replay_cache_flag(resource->info->r))
+    err = svn_repos__replay_cached(resource->info->repos->repos, root,
+                                   base_dir, low_water_mark, send_deltas,
+                                   editor, edit_baton,
+                                   dav_svn__authz_read_func(&arb), &arb,
+                                   resource->pool);
+  else
+    err = svn_repos_replay2(root, base_dir, low_water_mark,
+                            send_deltas, editor, edit_baton,
+                            dav_svn__authz_read_func(&arb), &arb,
+                            resource->pool);
+  if (err)
     {
       derr = dav_svn__convert_err(err, HTTP_INTERNAL_SERVER_ERROR,
                                   "Problem replaying revision",
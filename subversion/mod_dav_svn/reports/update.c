@@ -42,6 +42,7 @@
 
 #include "private/svn_log.h"
 #include "private/svn_fspath.h"
+#include "private/svn_repos_private.h"
 
 #include "../dav_svn.h"
 
@@ -1288,6 +1289,12 @@ dav_svn__update_report(const dav_resource *resource,
                                   resource->pool);
     }
 
+  /* Compute the text deltas of the next files while we are busy sending
+     the current one. */
+  if (text_deltas)
+    svn_repos__report_prefetch_deltas(
+      rbaton, dav_svn__get_update_prefetch(resource->info->r));
+
   /* scan the XML doc for state information */
   for (child = doc->root->first_child; child != NULL; child = child->next)
     if (child->ns == ns)
@@ -1514,7 +1521,7 @@ dav_svn__update_report(const dav_resource *resource,
       /* Compare subtree DST_PATH within a pristine revision to
          revision 0.  This should result in nothing but 'add' calls
          to the editor. */
-      serr = svn_repos_dir_delta2(zero_root, "", target,
+      serr = svn_repos_dir_delta3(zero_root, "", target,
                                   uc.rev_root, dst_path,
                                   /* re-use the editor */
                                   editor, &uc,
@@ -1523,6 +1530,7 @@ dav_svn__update_report(const dav_resource *resource,
                                   requested_depth,
                                   TRUE /* entryprops */,
                                   FALSE /* ignore-ancestry */,
+                                  1 /* jobs */,
                                   resource->pool);
 
       if (serr)
@@ -50,13 +50,16 @@
 #include "svn_props.h"
 #include "svn_ctype.h"
 #include "svn_subst.h"
+#include "svn_string.h"
 #include "mod_dav_svn.h"
 #include "svn_ra.h"  /* for SVN_RA_CAPABILITY_* */
 #include "svn_dirent_uri.h"
 #include "private/svn_log.h"
+#include "private/svn_fs_private.h"
 #include "private/svn_fspath.h"
 #include "private/svn_repos_private.h"
 #include "private/svn_sorts_private.h"
+#include "private/svn_subr_private.h"
 
 #include "dav_svn.h"
 
@@ -1768,7 +1771,20 @@ negotiate_encoding_prefs(request_rec *r, int *svndiff_version)
     {
       struct accept_rec rec = APR_ARRAY_IDX(encoding_prefs, i,
                                             struct accept_rec);
-      if (strcmp(rec.name, "svndiff1") == 0)
+      /* LZ4 is much cheaper than zlib for the server, but don't use it
+         if it isn't available or compression has been disabled with
+         'SVNCompressionLevel 0'. */
+      if (strcmp(rec.name, "svndiff2") == 0)
+        {
+          if (svn_lz4__compiled_version()
+              && dav_svn__get_compression_level(r)
+                   != SVN_DELTA_COMPRESSION_LEVEL_NONE)
+            {
+              *svndiff_version = 2;
+              break;
+            }
+        }
+      else if (strcmp(rec.name, "svndiff1") == 0)
         {
           *svndiff_version = 1;
           break;
@@ -2373,6 +2389,16 @@ get_resource(request_rec *r,
                     dav_svn__get_nodeprop_cache_flag(r) ? "1" :"0");
       svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_BLOCK_READ,
                     dav_svn__get_block_read_flag(r) ? "1" :"0");
+      if (dav_svn__get_disk_cache_path(r))
+        {
+          svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_DISK_PATH,
+                        dav_svn__get_disk_cache_path(r));
+          if (dav_svn__get_disk_cache_size(r))
+            svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_DISK_SIZE,
+                          apr_psprintf(r->connection->pool,
+                                       "%" APR_UINT64_T_FMT,
+                                       dav_svn__get_disk_cache_size(r)));
+        }
 
       /* Disallow BDB/event until issue 4157 is fixed. */
       if (!strcmp(ap_show_mpm(), "event"))
@@ -2419,6 +2445,7 @@ get_resource(request_rec *r,
       /* Cache the open repos for the next request on this connection */
       apr_pool_userdata_set(repos->repos, repos_key,
                             NULL, r->connection->pool);
+      dav_svn__metrics_repos_opened(r->connection->pool);
 
       /* Store the capabilities of the current connection, making sure
          to use the same pool repos->repos itself was created in. */
@@ -3049,6 +3076,30 @@ dav_svn__getetag(const dav_resource *resource, apr_pool_t *pool)
 
   /* ### what kind of etag to return for activities, etc.? */
 
+  /* Plain file contents are identified by their checksum.  That makes
+     the etag independent of the URL and revision used to access them and
+     lets caches in front of us share responses across revisions. */
+  if (!resource->collection
+      && !resource->info->keyword_subst
+      && !resource->info->delta_base)
+    {
+      svn_checksum_t *checksum;
+
+      serr = svn_fs_file_checksum(&checksum, svn_checksum_sha1,
+                                  resource->info->root.root,
+                                  resource->info->repos_path, FALSE, pool);
+      if (!serr && !checksum)
+        serr = svn_fs_file_checksum(&checksum, svn_checksum_md5,
+                                    resource->info->root.root,
+                                    resource->info->repos_path, FALSE, pool);
+
+      if (!serr && checksum)
+        return apr_psprintf(pool, "\"%s\"",
+                            svn_checksum_serialize(checksum, pool, pool));
+
+      svn_error_clear(serr);
+    }
+
   if ((serr = svn_fs_node_created_rev(&created_rev, resource->info->root.root,
                                       resource->info->repos_path,
                                       pool)))
@@ -3101,17 +3152,100 @@ is_cacheable(request_rec *r, const dav_resource *resource)
       return FALSE;
 }
 
+/* Helper for set_headers().  If request R asks for a single, satisfiable
+ * byte range of a file that has LENGTH bytes, return TRUE and set *START
+ * and *RANGE_LENGTH to the range to send.  Otherwise, return FALSE and
+ * leave multiple or unsatisfiable ranges to httpd's byterange filter.
+ */
+static svn_boolean_t
+get_single_range(svn_filesize_t *start,
+                 svn_filesize_t *range_length,
+                 request_rec *r,
+                 svn_filesize_t length)
+{
+  const char *range = apr_table_get(r->headers_in, "Range");
+  const char *if_range = apr_table_get(r->headers_in, "If-Range");
+  const char *dash;
+  apr_int64_t first, last;
+  svn_error_t *err;
+
+  if (range == NULL || r->method_number != M_GET || length == 0)
+    return FALSE;
+
+  /* If-Range must match our current (strong) ETag.  We send the whole
+     file for any other validator. */
+  if (if_range
+      && strcmp(if_range, apr_table_get(r->headers_out, "ETag")) != 0)
+    return FALSE;
+
+  if (strncmp(range, "bytes=", 6) != 0 || strchr(range, ','))
+    return FALSE;
+
+  range += 6;
+  dash = strchr(range, '-');
+  if (dash == NULL)
+    return FALSE;
+
+  if (dash == range)
+    {
+      /* "bytes=-N" asks for the last N bytes. */
+      err = svn_cstring_strtoi64(&last, dash + 1, 1, APR_INT64_MAX, 10);
+      if (err)
+        {
+          svn_error_clear(err);
+          return FALSE;
+        }
+
+      first = last < length ? length - last : 0;
+      last = length - 1;
+    }
+  else
+    {
+      err = svn_cstring_strtoi64(&first,
+                                 apr_pstrndup(r->pool, range, dash - range),
+                                 0, APR_INT64_MAX, 10);
+      if (!err)
+        {
+          if (dash[1] == '\0')
+            last = length - 1;
+          else
+            err = svn_cstring_strtoi64(&last, dash + 1, first, APR_INT64_MAX,
+                                       10);
+        }
+
+      if (err)
+        {
+          svn_error_clear(err);
+          return FALSE;
+        }
+
+      if (first >= length)
+        return FALSE;
+
+      if (last >= length)
+        last = length - 1;
+    }
+
+  *start = first;
+  *range_length = last - first + 1;
+
+  return TRUE;
+}
+
 static dav_error *
 set_headers(request_rec *r, const dav_resource *resource)
 {
   svn_error_t *serr;
   svn_filesize_t length;
   const char *mimetype = NULL;
-
-  /* As version resources don't change, encourage caching. */
-  if (is_cacheable(r, resource))
-    /* Cache resource for one week (specified in seconds). */
-    apr_table_setn(r->headers_out, "Cache-Control", "max-age=604800");
+  svn_boolean_t cacheable = is_cacheable(r, resource);
+
+  /* As version resources don't change, encourage caching.  Tell clients
+     and proxies that they never need to revalidate them. */
+  if (cacheable)
+    /* Cache resource for one year (specified in seconds). */
+    apr_table_setn(r->headers_out, "Cache-Control",
+                   "max-age=31536000, immutable");
   else
     apr_table_setn(r->headers_out, "Cache-Control", "max-age=0");
 
@@ -3122,6 +3256,18 @@ set_headers(request_rec *r, const dav_resource *resource)
   apr_table_setn(r->headers_out, "ETag",
                  dav_svn__getetag(resource, resource->pool));
 
+  /* Answer conditional GETs for immutable resources right away.  Setting
+     HEADER_ONLY makes mod_dav skip deliver() and httpd will only send the
+     headers permitted in a 304 response. */
+  if (cacheable
+      && r->method_number == M_GET
+      && ap_meets_conditions(r) == HTTP_NOT_MODIFIED)
+    {
+      r->status = HTTP_NOT_MODIFIED;
+      r->header_only = 1;
+      return NULL;
+    }
+
   /* we accept byte-ranges */
   apr_table_setn(r->headers_out, "Accept-Ranges", "bytes");
 
@@ -3223,6 +3369,25 @@ set_headers(request_rec *r, const dav_resource *resource)
                                           "could not fetch the resource length",
                                           resource->pool);
             }
+
+          /* Serve a single byte range ourselves, so we don't have to
+             reconstruct the parts of the file that won't be sent. */
+          if (get_single_range(&resource->info->range_start,
+                               &resource->info->range_length, r, length))
+            {
+              r->status = HTTP_PARTIAL_CONTENT;
+              apr_table_setn(r->headers_out, "Content-Range",
+                             apr_psprintf(r->pool,
+                                          "bytes %" SVN_FILESIZE_T_FMT
+                                          "-%" SVN_FILESIZE_T_FMT
+                                          "/%" SVN_FILESIZE_T_FMT,
+                                          resource->info->range_start,
+                                          resource->info->range_start
+                                          + resource->info->range_length - 1,
+                                          length));
+              length = resource->info->range_length;
+            }
+
           ap_set_content_length(r, (apr_off_t) length);
         }
     }
@@ -3514,6 +3679,75 @@ emit_collection_tail(const dav_resource *resource,
 }
 
 
+/* If the contents of the file RESOURCE are stored verbatim on disk and
+   need no keyword substitution, send them to OUTPUT straight from the
+   repository file, letting httpd use sendfile() or mmap(), and set
+   *DELIVERED to TRUE.  Otherwise, send nothing and set *DELIVERED to
+   FALSE. */
+static svn_error_t *
+deliver_from_disk(svn_boolean_t *delivered,
+                  const dav_resource *resource,
+                  dav_svn__output *output)
+{
+  const char *file_path;
+  apr_off_t offset;
+  svn_filesize_t length;
+  apr_file_t *file;
+  apr_bucket_brigade *bb;
+  apr_bucket *bkt;
+  svn_error_t *err;
+
+  *delivered = FALSE;
+
+  if (resource->info->keyword_subst)
+    {
+      svn_string_t *keywords;
+
+      SVN_ERR(svn_fs_node_prop(&keywords, resource->info->root.root,
+                               resource->info->repos_path,
+                               SVN_PROP_KEYWORDS, resource->pool));
+      if (keywords)
+        return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_fs__file_contents_location(&file_path, &offset, &length,
+                                         resource->info->root.root,
+                                         resource->info->repos_path,
+                                         resource->pool, resource->pool));
+  if (file_path == NULL)
+    return SVN_NO_ERROR;
+
+  /* The revision may have been packed in the meantime.  Use the regular
+     code path in that case. */
+  err = svn_io_file_open(&file, file_path,
+                         APR_READ | APR_BINARY | APR_SENDFILE_ENABLED,
+                         APR_OS_DEFAULT, resource->pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  /* Send only the requested byte range, if any. */
+  if (resource->info->range_length)
+    {
+      offset += resource->info->range_start;
+      length = resource->info->range_length;
+    }
+
+  bb = apr_brigade_create(resource->pool,
+                          dav_svn__output_get_bucket_alloc(output));
+  apr_brigade_insert_file(bb, file, offset, length, resource->pool);
+  bkt = apr_bucket_eos_create(dav_svn__output_get_bucket_alloc(output));
+  APR_BRIGADE_INSERT_TAIL(bb, bkt);
+
+  *delivered = TRUE;
+  err = dav_svn__output_pass_brigade(output, bb);
+  apr_brigade_destroy(bb);
+
+  return svn_error_trace(err);
+}
+
 static dav_error *
 deliver(const dav_resource *resource, ap_filter_t *unused)
 {
@@ -3538,7 +3772,6 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
   if (resource->collection)
     {
       const int gen_html = !resource->info->repos->xslt_uri;
-      apr_hash_t *entries;
       apr_pool_t *iterpool;
       apr_array_header_t *sorted;
       svn_revnum_t dir_rev = SVN_INVALID_REVNUM;
@@ -3560,6 +3793,8 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
         {
           apr_hash_index_t *hi;
           apr_hash_t *dirents;
+          apr_hash_t *entries;
+          apr_array_header_t *items;
           const char *fs_parent_path =
             dav_svn__get_fs_parent_path(resource->info->r);
 
@@ -3612,12 +3847,22 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
               svn_hash_sets(entries, key, ent);
             }
 
+          /* get a sorted list of the entries */
+          items = svn_sort__hash(entries, svn_sort_compare_items_as_paths,
+                                 resource->pool);
+          sorted = apr_array_make(resource->pool, items->nelts,
+                                  sizeof(svn_fs_dirent_t *));
+          for (i = 0; i < items->nelts; ++i)
+            APR_ARRAY_PUSH(sorted, svn_fs_dirent_t *)
+              = APR_ARRAY_IDX(items, i, svn_sort__item_t).value;
         }
       else
         {
+          /* The filesystem hands out directories sorted by name. */
           dir_rev = svn_fs_revision_root_revision(resource->info->root.root);
-          serr = svn_fs_dir_entries(&entries, resource->info->root.root,
-                                    resource->info->repos_path, resource->pool);
+          serr = svn_fs_dir_entries_sorted(&sorted, resource->info->root.root,
+                                           resource->info->repos_path,
+                                           resource->pool, resource->pool);
           if (serr != NULL)
             return dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
                                         "could not fetch directory entries",
@@ -3634,18 +3879,13 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
                                     "could not output collection",
                                     resource->pool);
 
-      /* get a sorted list of the entries */
-      sorted = svn_sort__hash(entries, svn_sort_compare_items_as_paths,
-                              resource->pool);
-
       iterpool = svn_pool_create(resource->pool);
 
       for (i = 0; i < sorted->nelts; ++i)
         {
-          const svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i,
-                                                        const svn_sort__item_t);
-          const svn_fs_dirent_t *entry = item->value;
-          const char *name = item->key;
+          const svn_fs_dirent_t *entry = APR_ARRAY_IDX(sorted, i,
+                                                       const svn_fs_dirent_t *);
+          const char *name = entry->name;
           const char *repos_relpath = NULL;
 
           svn_pool_clear(iterpool);
@@ -3799,6 +4039,16 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
     {
       svn_stream_t *stream;
       char *block;
+      svn_boolean_t delivered;
+      svn_filesize_t remaining = resource->info->range_length;
+
+      serr = deliver_from_disk(&delivered, resource, output);
+      if (serr != NULL)
+        return dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                    "could not deliver the file contents",
+                                    resource->pool);
+      if (delivered)
+        return NULL;
 
       serr = svn_fs_file_contents(&stream,
                                   resource->info->root.root,
@@ -3882,6 +4132,28 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
             }
         }
 
+      /* Jump to the start of the requested byte range.  Keyword
+         substitution and byte ranges are mutually exclusive. */
+      if (resource->info->range_length)
+        {
+          svn_filesize_t to_skip = resource->info->range_start;
+          while (to_skip > 0 && serr == NULL)
+            {
+              apr_size_t skip_len = to_skip > APR_SIZE_MAX
+                                  ? APR_SIZE_MAX
+                                  : (apr_size_t)to_skip;
+
+              serr = svn_stream_skip(stream, skip_len);
+              to_skip -= skip_len;
+            }
+
+          if (serr != NULL)
+            return dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                        "could not skip to the requested "
+                                        "range of the file contents",
+                                        resource->pool);
+        }
+
       /* ### one day in the future, we can create a custom bucket type
          ### which will read from the FS stream on demand */
 
@@ -3892,6 +4164,15 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
       while (1) {
         apr_size_t bufsize = SVN__STREAM_CHUNK_SIZE;
 
+        /* Don't send more than the requested byte range. */
+        if (resource->info->range_length)
+          {
+            if (remaining == 0)
+              break;
+            if (bufsize > remaining)
+              bufsize = (apr_size_t)remaining;
+          }
+
         /* read from the FS ... */
         serr = svn_stream_read_full(stream, block, &bufsize);
         if (serr != NULL)
@@ -3904,6 +4185,8 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
         if (bufsize == 0)
           break;
 
+        remaining -= bufsize;
+
         /* write to the filter ... */
         bkt = apr_bucket_transient_create(
           block, bufsize, dav_svn__output_get_bucket_alloc(output));
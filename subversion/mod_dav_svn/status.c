@@ -22,6 +22,7 @@
 #include <httpd.h>
 #include <http_core.h>
 #include <http_config.h>
+#include <http_log.h>
 #include <http_request.h>
 #include <http_protocol.h>
 
@@ -65,18 +66,57 @@
        SetHandler svn-status
      </Location>
 
-  and then point a browser at http://server/svn-status.
+  and then point a browser at http://server/svn-status.  As with
+  mod_status, http://server/svn-status?auto returns machine-readable
+  per-prefix statistics as tab-separated values instead.
 */
+
+/* Return the per-prefix statistics of the global membuffer cache,
+   allocated in R->POOL.  Return an empty array if they are not available. */
+static apr_array_header_t *
+get_prefix_info(request_rec *r)
+{
+  apr_array_header_t *prefix_info = NULL;
+  svn_membuffer_t *membuffer = svn_cache__get_global_membuffer_cache();
+  svn_error_t *err = SVN_NO_ERROR;
+
+  if (membuffer)
+    err = svn_cache__membuffer_get_prefix_info(&prefix_info, membuffer,
+                                               r->pool, r->pool);
+  if (err)
+    {
+      ap_log_rerror(APLOG_MARK, APLOG_WARNING, 0, r,
+                    "Can't collect cache statistics: %s",
+                    svn_err_best_message(err, NULL, 0));
+      svn_error_clear(err);
+      prefix_info = NULL;
+    }
+
+  return prefix_info
+       ? prefix_info
+       : apr_array_make(r->pool, 0, sizeof(svn_cache__prefix_info_t *));
+}
+
 int dav_svn__status(request_rec *r)
 {
   svn_cache__info_t *info;
   svn_string_t *text_stats;
   apr_array_header_t *lines;
+  apr_array_header_t *prefix_info;
   int i;
 
   if (r->method_number != M_GET || strcmp(r->handler, "svn-status"))
     return DECLINED;
 
+  prefix_info = get_prefix_info(r);
+  if (r->args && strcmp(r->args, "auto") == 0)
+    {
+      ap_set_content_type(r, "text/plain; charset=UTF-8");
+      ap_rputs(svn_cache__format_prefix_info(prefix_info, r->pool)->data, r);
+
+      return 0;
+    }
+
   info = svn_cache__membuffer_get_global_info(r->pool);
   text_stats = svn_cache__format_info(info, FALSE, r->pool);
   lines = svn_cstring_split(text_stats->data, "\n", FALSE, r->pool);
@@ -113,7 +153,24 @@ int dav_svn__status(request_rec *r)
       ap_rvputs(r, "<dt>", line, "</dt>\n", SVN_VA_NULL);
     }
 
-  ap_rvputs(r, "</dl></body></html>\n", SVN_VA_NULL);
+  ap_rvputs(r, "</dl>\n<table border=\"1\">\n<tr><th>Prefix</th>"
+            "<th>Gets</th><th>Hits</th><th>Sets</th><th>Evictions</th>"
+            "<th>Entries</th><th>Bytes</th></tr>\n", SVN_VA_NULL);
+  for (i = 0; i < prefix_info->nelts; ++i)
+    {
+      const svn_cache__prefix_info_t *entry
+        = APR_ARRAY_IDX(prefix_info, i, const svn_cache__prefix_info_t *);
+      ap_rvputs(r, "<tr><td>", ap_escape_html(r->pool, entry->prefix),
+                "</td>", SVN_VA_NULL);
+      ap_rprintf(r, "<td>%" APR_UINT64_T_FMT "</td><td>%" APR_UINT64_T_FMT
+                 "</td><td>%" APR_UINT64_T_FMT "</td><td>%" APR_UINT64_T_FMT
+                 "</td><td>%" APR_UINT64_T_FMT "</td><td>%" APR_UINT64_T_FMT
+                 "</td></tr>\n",
+                 entry->gets, entry->hits, entry->sets, entry->evictions,
+                 entry->used_entries, entry->used_size);
+    }
+
+  ap_rvputs(r, "</table></body></html>\n", SVN_VA_NULL);
 
   return 0;
 }
@@ -694,11 +694,17 @@ dav_svn__make_base64_output_stream(apr_bucket_brigade *bb,
 void
 dav_svn__operational_log(struct dav_resource_private *info, const char *line)
 {
+  const char *trace_id = apr_table_get(info->r->headers_in,
+                                       SVN_DAV_TRACE_ID_HEADER);
+
   apr_table_set(info->r->subprocess_env, "SVN-ACTION", line);
   apr_table_set(info->r->subprocess_env, "SVN-REPOS",
                 svn_path_uri_encode(info->repos->fs_path, info->r->pool));
   apr_table_set(info->r->subprocess_env, "SVN-REPOS-NAME",
                 svn_path_uri_encode(info->repos->repo_basename, info->r->pool));
+  if (trace_id)
+    apr_table_set(info->r->subprocess_env, "SVN-TRACE-ID",
+                  svn_path_uri_encode(trace_id, info->r->pool));
 }
 
 
@@ -44,6 +44,7 @@
 #include "private/svn_dav_protocol.h"
 #include "private/svn_log.h"
 #include "private/svn_fspath.h"
+#include "private/svn_probes.h"
 
 #include "dav_svn.h"
 
@@ -153,6 +154,8 @@ get_vsn_options(apr_pool_t *p, apr_text_header *phdr)
   apr_text_append(p, phdr, SVN_DAV_NS_DAV_SVN_INLINE_PROPS);
   apr_text_append(p, phdr, SVN_DAV_NS_DAV_SVN_REVERSE_FILE_REVS);
   apr_text_append(p, phdr, SVN_DAV_NS_DAV_SVN_SVNDIFF1);
+  if (svn_lz4__compiled_version())
+    apr_text_append(p, phdr, SVN_DAV_NS_DAV_SVN_SVNDIFF2);
   /* Mergeinfo is a special case: here we merely say that the server
    * knows how to handle mergeinfo -- whether the repository does too
    * is a separate matter.
@@ -964,11 +967,11 @@ dav_svn__checkin(dav_resource *resource,
       if (err)
         return err;
 
-      serr = svn_repos_fs_commit_txn(&conflict_msg,
-                                     resource->info->repos->repos,
-                                     &new_rev,
-                                     resource->info->root.txn,
-                                     resource->pool);
+      serr = dav_svn__commit_txn(&conflict_msg,
+                                 resource->info->repos->repos,
+                                 &new_rev,
+                                 resource->info->root.txn,
+                                 resource->pool);
 
       if (SVN_IS_VALID_REVNUM(new_rev))
         {
@@ -1092,11 +1095,10 @@ report_label_header_allowed(const apr_xml_doc *doc)
 }
 
 
+/* Run the REPORT request for RESOURCE described by DOC. */
 static dav_error *
-deliver_report(request_rec *r,
-               const dav_resource *resource,
-               const apr_xml_doc *doc,
-               ap_filter_t *unused)
+run_report(const dav_resource *resource,
+           const apr_xml_doc *doc)
 {
   int ns = dav_svn__find_ns(doc->namespaces, SVN_XML_NAMESPACE);
 
@@ -1164,6 +1166,27 @@ deliver_report(request_rec *r,
 }
 
 
+static dav_error *
+deliver_report(request_rec *r,
+               const dav_resource *resource,
+               const apr_xml_doc *doc,
+               ap_filter_t *unused)
+{
+  apr_time_t start = apr_time_now();
+  dav_error *derr;
+
+  SVN_PROBE2(dav_svn__report__start, doc->root->name, r->uri);
+  derr = run_report(resource, doc);
+  SVN_PROBE2(dav_svn__report__done, doc->root->name,
+             derr ? derr->status : 0);
+
+  dav_svn__metrics_add_report(doc->root->name, apr_time_now() - start,
+                              resource->pool);
+
+  return derr;
+}
+
+
 static int
 can_be_activity(const dav_resource *resource)
 {
@@ -1481,8 +1504,8 @@ merge(dav_resource *target,
     return err;
 
   /* all righty... commit the bugger. */
-  serr = svn_repos_fs_commit_txn(&conflict, source->info->repos->repos,
-                                 &new_rev, txn, pool);
+  serr = dav_svn__commit_txn(&conflict, source->info->repos->repos,
+                             &new_rev, txn, pool);
 
   /* ### TODO: Figure out if the MERGE response can grow a means by
      which to marshal back both the success of the commit (and its
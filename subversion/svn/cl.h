@@ -250,6 +250,7 @@ typedef struct svn_cl__opt_state_t
   svn_boolean_t pin_externals;     /* pin externals to last-changed revisions */
   const char *show_item;           /* print only the given item */
   svn_boolean_t adds_as_modification; /* update 'add vs add' no tree conflict */
+  svn_boolean_t lazy;              /* check out files on demand only */
 } svn_cl__opt_state_t;
 
 /* Conflict stats for operations such as update and merge. */
@@ -143,7 +143,8 @@ typedef enum svn_cl__longopt_t {
   opt_show_passwords,
   opt_pin_externals,
   opt_show_item,
-  opt_adds_as_modification
+  opt_adds_as_modification,
+  opt_lazy
 } svn_cl__longopt_t;
 
 
@@ -218,7 +219,9 @@ const apr_getopt_option_t svn_cl__options[] =
                        "                             "
                        "  -U ARG, --context ARG: Show ARG lines of context\n"
                        "                             "
-                       "  -p, --show-c-function: Show C function name")},
+                       "  -p, --show-c-function: Show C function name\n"
+                       "                             "
+                       "  --histogram: Use the histogram diff algorithm")},
   {"targets",       opt_targets, 1,
                     N_("pass contents of file ARG as additional args")},
   {"depth",         opt_depth, 1,
@@ -458,6 +461,10 @@ const apr_getopt_option_t svn_cl__options[] =
                        "option is not recommended! Use 'svn resolve' to\n"
                        "                             "
                        "resolve tree conflicts instead.")},
+  {"lazy", opt_lazy, 0,
+                       N_("register files without fetching their content;\n"
+                          "                             "
+                          "use 'svn update --set-depth infinity' to fetch it")},
 
   /* Long-opt Aliases
    *
@@ -600,9 +607,14 @@ const svn_opt_subcommand_desc2_t svn_cl__cmd_table[] =
      "  to the working copy.  All properties from the repository are applied\n"
      "  to the obstructing path.\n"
      "\n"
+     "  If --lazy is used, all directories are checked out but files are only\n"
+     "  registered in the working copy, as if they had been excluded with\n"
+     "  'svn update --set-depth exclude'.  Their content is fetched when\n"
+     "  they are updated with '--set-depth infinity'.\n"
+     "\n"
      "  See also 'svn help update' for a list of possible characters\n"
      "  reporting the action taken.\n"),
-    {'r', 'q', 'N', opt_depth, opt_force, opt_ignore_externals} },
+    {'r', 'q', 'N', opt_depth, opt_force, opt_ignore_externals, opt_lazy} },
 
   { "cleanup", svn_cl__cleanup, {0}, N_
     ("Recursively clean up the working copy, removing write locks, resuming\n"
@@ -2444,6 +2456,9 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       case opt_adds_as_modification:
         opt_state.adds_as_modification = TRUE;
         break;
+      case opt_lazy:
+        opt_state.lazy = TRUE;
+        break;
       default:
         /* Hmmm. Perhaps this would be a good place to squirrel away
            opts that commands like svn diff might need. Hmmm indeed. */
@@ -44,6 +44,7 @@
 #include "svn_xml.h"
 
 #include "private/svn_cmdline_private.h"
+#include "private/svn_io_private.h"
 #include "private/svn_opt_private.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_subr_private.h"
@@ -59,6 +60,12 @@
  * The current threshold is 64MB. */
 #define BLOCK_READ_CACHE_THRESHOLD (0x40 * 0x100000)
 
+/* 'svnadmin load' reads the dump stream on a separate thread, keeping up
+ * to LOAD_READ_AHEAD_BLOCKS blocks of LOAD_READ_AHEAD_BLOCK_SIZE bytes
+ * ahead of the parser and the commits.  The current total is 4MB. */
+#define LOAD_READ_AHEAD_BLOCK_SIZE 0x100000
+#define LOAD_READ_AHEAD_BLOCKS 4
+
 static svn_cancel_func_t check_cancel = NULL;
 
 /* Custom filesystem warning function. */
@@ -94,6 +101,7 @@ check_lib_versions(void)
 /** Subcommands. **/
 
 static svn_opt_subcommand_t
+  subcommand_build_repcache,
   subcommand_crashtest,
   subcommand_create,
   subcommand_delrevprop,
@@ -150,7 +158,12 @@ enum svnadmin__cmdline_options_t
     svnadmin__compatible_version,
     svnadmin__check_normalization,
     svnadmin__metadata_only,
-    svnadmin__no_flush_to_disk
+    svnadmin__no_flush_to_disk,
+    svnadmin__jobs,
+    svnadmin__access_profile,
+    svnadmin__watch,
+    svnadmin__throttle,
+    svnadmin__read_ahead
   };
 
 /* Option codes and descriptions.
@@ -175,7 +188,7 @@ static const apr_getopt_option_t options_table[] =
      N_("specify transaction name ARG")},
 
     {"incremental",   svnadmin__incremental, 0,
-     N_("dump or hotcopy incrementally")},
+     N_("dump, hotcopy or verify incrementally")},
 
     {"deltas",        svnadmin__deltas, 0,
      N_("use deltas in dump output")},
@@ -273,6 +286,31 @@ static const apr_getopt_option_t options_table[] =
      N_("disable flushing to disk during the operation\n"
         "                             (faster, but unsafe on power off)")},
 
+    {"jobs", svnadmin__jobs, 1,
+     N_("process up to ARG revisions, shards or dump\n"
+        "                             segments concurrently\n"
+        "                             [default: 1]")},
+
+    {"access-profile", svnadmin__access_profile, 1,
+     N_("place the items listed in file ARG, one\n"
+        "                             'REVISION ITEM_INDEX' pair per line in\n"
+        "                             order of access, next to each other")},
+
+    {"watch", svnadmin__watch, 1,
+     N_("keep running and check for completed shards\n"
+        "                             every ARG seconds")},
+
+    {"throttle", svnadmin__throttle, 1,
+     N_("spend at most ARG percent of the time packing\n"
+        "                             and pause while revisions are committed\n"
+        "                             [default: 100]")},
+
+    {"read-ahead", svnadmin__read_ahead, 0,
+     N_("read the following data in a background thread\n"
+        "                             while processing the current data; needs\n"
+        "                             a memory cache of more than 64 MB\n"
+        "                             [used for FSFS repositories only]")},
+
     {NULL}
   };
 
@@ -282,6 +320,15 @@ static const apr_getopt_option_t options_table[] =
  */
 static const svn_opt_subcommand_desc2_t cmd_table[] =
 {
+  {"build-repcache", subcommand_build_repcache, {0}, N_
+   ("usage: svnadmin build-repcache REPOS_PATH [-r LOWER[:UPPER]]\n\n"
+    "Add the representations of revisions LOWER through UPPER to the\n"
+    "representation cache, so that future commits can share them.  If no\n"
+    "revisions are given, process all revisions.  If only LOWER is given,\n"
+    "process that one revision.  Use --jobs to read several ranges of\n"
+    "revisions concurrently.  Only FSFS repositories are supported.\n"),
+   {'r', 'q', 'M', svnadmin__jobs} },
+
   {"crashtest", subcommand_crashtest, {0}, N_
    ("usage: svnadmin crashtest REPOS_PATH\n\n"
     "Open the repository at REPOS_PATH, then abort, thus simulating\n"
@@ -329,8 +376,15 @@ static const svn_opt_subcommand_desc2_t cmd_table[] =
     "only the paths changed in that revision; otherwise it will describe\n"
     "every path present in the repository as of that revision.  (In either\n"
     "case, the second and subsequent revisions, if any, describe only paths\n"
-    "changed in those revisions.)\n"),
-  {'r', svnadmin__incremental, svnadmin__deltas, 'q', 'M', 'F'},
+    "changed in those revisions.)\n"
+    "\n"
+    "If --jobs ARG is given with ARG > 1, the dump gets split into ARG\n"
+    "segments of consecutive revisions which are written concurrently to\n"
+    "the files FILE.1, FILE.2 etc., where FILE is given by --file.\n"
+    "Concatenating the segment files in that order gives a valid dump stream\n"
+    "of the same contents as without --jobs.\n"),
+  {'r', svnadmin__incremental, svnadmin__deltas, 'q', 'M', 'F',
+   svnadmin__jobs, svnadmin__read_ahead},
   {{'F', N_("write to file ARG instead of stdout")}} },
 
   {"dump-revprops", subcommand_dump_revprops, {0}, N_
@@ -434,8 +488,17 @@ static const svn_opt_subcommand_desc2_t cmd_table[] =
   {"pack", subcommand_pack, {0}, N_
    ("usage: svnadmin pack REPOS_PATH\n\n"
     "Possibly compact the repository into a more efficient storage model.\n"
-    "This may not apply to all repositories, in which case, exit.\n"),
-   {'q', 'M'} },
+    "This may not apply to all repositories, in which case, exit.\n"
+    "\n"
+    "If --access-profile ARG is given, FSFS repositories using logical\n"
+    "addressing will group the items listed in ARG in front of all other\n"
+    "items of each new pack file, in the order they are listed in.\n"
+    "\n"
+    "With --watch, keep running until interrupted and pack each shard as\n"
+    "soon as it is complete.  --throttle limits the I/O load of packing\n"
+    "on a live server.\n"),
+   {'q', 'M', svnadmin__jobs, svnadmin__access_profile, svnadmin__watch,
+    svnadmin__throttle} },
 
   {"recover", subcommand_recover, {0}, N_
    ("usage: svnadmin recover REPOS_PATH\n\n"
@@ -509,9 +572,12 @@ static const svn_opt_subcommand_desc2_t cmd_table[] =
 
   {"verify", subcommand_verify, {0}, N_
    ("usage: svnadmin verify REPOS_PATH\n\n"
-    "Verify the data stored in the repository.\n"),
+    "Verify the data stored in the repository.\n"
+    "If --incremental is passed, skip revisions that have been verified\n"
+    "successfully before and whose storage did not change since.\n"),
    {'t', 'r', 'q', svnadmin__keep_going, 'M',
-    svnadmin__check_normalization, svnadmin__metadata_only} },
+    svnadmin__check_normalization, svnadmin__metadata_only,
+    svnadmin__incremental, svnadmin__jobs, svnadmin__read_ahead} },
 
   { NULL, NULL, {0}, NULL, {0} }
 };
@@ -548,6 +614,11 @@ struct svnadmin_opt_state
   enum svn_repos_load_uuid uuid_action;             /* --ignore-uuid,
                                                        --force-uuid */
   apr_uint64_t memory_cache_size;                   /* --memory-cache-size M */
+  int jobs;                                         /* --jobs */
+  const char *access_profile;                       /* --access-profile */
+  int watch;                                        /* --watch */
+  int throttle;                                     /* --throttle */
+  svn_boolean_t read_ahead;                         /* --read-ahead */
   const char *parent_dir;                           /* --parent-dir */
   const char *file;                                 /* --file */
 
@@ -577,8 +648,14 @@ open_repos(svn_repos_t **repos,
                            svn_uuid_generate(pool));
   svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_BLOCK_READ,
                            use_block_read ? "1" : "0");
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_READ_AHEAD,
+                           use_block_read && opt_state->read_ahead
+                             ? "1" : "0");
   svn_hash_sets(fs_config, SVN_FS_CONFIG_NO_FLUSH_TO_DISK,
                            opt_state->no_flush_to_disk ? "1" : "0");
+  if (opt_state->access_profile)
+    svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_PACK_ACCESS_PROFILE,
+                             opt_state->access_profile);
 
   /* now, open the requested repository */
   SVN_ERR(svn_repos_open3(repos, path, fs_config, pool, pool));
@@ -879,7 +956,7 @@ struct repos_verify_callback_baton
 };
 
 /* Implementation of svn_repos_verify_callback_t to handle errors coming
-   from svn_repos_verify_fs3(). */
+   from svn_repos_verify_fs4(). */
 static svn_error_t *
 repos_verify_callback(void *baton,
                       svn_revnum_t revision,
@@ -950,6 +1027,19 @@ repos_notify_handler(void *baton,
                                         notify->revision));
       return;
 
+    case svn_repos_notify_verify_rev_range_unchanged:
+      if (notify->start_revision == notify->end_revision)
+        svn_error_clear(svn_stream_printf(feedback_stream, scratch_pool,
+                        _("* Revision %ld unchanged since last "
+                          "verification.\n"),
+                        notify->start_revision));
+      else
+        svn_error_clear(svn_stream_printf(feedback_stream, scratch_pool,
+                        _("* Revisions %ld to %ld unchanged since last "
+                          "verification.\n"),
+                        notify->start_revision, notify->end_revision));
+      return;
+
     case svn_repos_notify_verify_rev_structure:
       if (notify->revision == SVN_INVALID_REVNUM)
         svn_error_clear(svn_stream_puts(feedback_stream,
@@ -1233,6 +1323,106 @@ get_dump_range(svn_revnum_t *lower,
   return SVN_NO_ERROR;
 }
 
+/* Dump revisions LOWER to UPPER of REPOS into OPT_STATE->JOBS segment
+   files named after OPT_STATE->FILE, dumping them concurrently.  Use POOL
+   for allocations. */
+static svn_error_t *
+dump_segments(svn_repos_t *repos,
+              svn_revnum_t lower,
+              svn_revnum_t upper,
+              struct svnadmin_opt_state *opt_state,
+              apr_pool_t *pool)
+{
+  apr_array_header_t *streams;
+  apr_array_header_t *pools;
+  svn_stream_t *feedback_stream = NULL;
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  if (! opt_state->file)
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                            _("Dumping with --jobs requires --file"));
+
+  streams = apr_array_make(pool, opt_state->jobs, sizeof(svn_stream_t *));
+  pools = apr_array_make(pool, opt_state->jobs, sizeof(apr_pool_t *));
+  for (i = 0; i < opt_state->jobs && !err; i++)
+    {
+      /* The streams get written by other threads.  Don't let them share
+         our pool. */
+      apr_pool_t *stream_pool = svn_pool_create(NULL);
+      apr_file_t *file;
+
+      APR_ARRAY_PUSH(pools, apr_pool_t *) = stream_pool;
+
+      /* Overwrite existing files, same as with > redirection. */
+      err = svn_io_file_open(&file,
+                             apr_psprintf(pool, "%s.%d",
+                                          opt_state->file, i + 1),
+                             APR_WRITE | APR_CREATE | APR_TRUNCATE
+                             | APR_BUFFERED, APR_OS_DEFAULT, stream_pool);
+      if (!err)
+        APR_ARRAY_PUSH(streams, svn_stream_t *)
+          = svn_stream_from_aprfile2(file, FALSE, stream_pool);
+    }
+
+  /* Progress feedback goes to STDERR, unless they asked to suppress it. */
+  if (! opt_state->quiet)
+    feedback_stream = recode_stream_create(stderr, pool);
+
+  if (!err)
+      err = svn_repos_dump_fs_segments(repos, streams, lower, upper,
+                                     opt_state->incremental,
+                                     opt_state->use_deltas, TRUE, TRUE,
+                                     opt_state->jobs,
+                                     !opt_state->quiet
+                                       ? repos_notify_handler : NULL,
+                                     feedback_stream, check_cancel, NULL,
+                                     pool);
+
+  for (i = 0; i < streams->nelts; i++)
+    err = svn_error_compose_create(
+            err, svn_stream_close(APR_ARRAY_IDX(streams, i,
+                                                svn_stream_t *)));
+
+  for (i = 0; i < pools->nelts; i++)
+    svn_pool_destroy(APR_ARRAY_IDX(pools, i, apr_pool_t *));
+
+  return svn_error_trace(err);
+}
+
+/* Implements svn_fs_progress_notify_func_t.  Report the completion of
+   REVISION to stdout. */
+static void
+build_repcache_progress(svn_revnum_t revision,
+                        void *baton,
+                        apr_pool_t *pool)
+{
+  svn_error_clear(svn_cmdline_printf(pool, _("* Processed revision %ld.\n"),
+                                     revision));
+}
+
+/* This implements `svn_opt_subcommand_t'. */
+static svn_error_t *
+subcommand_build_repcache(apr_getopt_t *os, void *baton, apr_pool_t *pool)
+{
+  struct svnadmin_opt_state *opt_state = baton;
+  svn_repos_t *repos;
+  svn_revnum_t lower, upper;
+
+  /* Expect no more arguments. */
+  SVN_ERR(parse_args(NULL, os, 0, 0, pool));
+
+  SVN_ERR(open_repos(&repos, opt_state->repository_path, opt_state, pool));
+  SVN_ERR(get_dump_range(&lower, &upper, repos, opt_state, pool));
+
+  return svn_error_trace(
+           svn_fs_build_rep_cache(svn_repos_fs(repos), lower, upper,
+                                  opt_state->jobs,
+                                  opt_state->quiet
+                                    ? NULL : build_repcache_progress,
+                                  NULL, check_cancel, NULL, pool));
+}
+
 /* This implements `svn_opt_subcommand_t'. */
 static svn_error_t *
 subcommand_dump(apr_getopt_t *os, void *baton, apr_pool_t *pool)
@@ -1249,6 +1439,11 @@ subcommand_dump(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   SVN_ERR(open_repos(&repos, opt_state->repository_path, opt_state, pool));
   SVN_ERR(get_dump_range(&lower, &upper, repos, opt_state, pool));
 
+  /* Write segments to separate files. */
+  if (opt_state->jobs > 1)
+    return svn_error_trace(dump_segments(repos, lower, upper, opt_state,
+                                         pool));
+
   /* Open the file or STDOUT, depending on whether -F was specified. */
   if (opt_state->file)
     {
@@ -1515,6 +1710,11 @@ subcommand_load(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   else
     SVN_ERR(svn_stream_for_stdin2(&in_stream, TRUE, pool));
 
+  /* Don't let the commits wait for the dump file I/O. */
+  SVN_ERR(svn_stream__read_ahead(&in_stream, in_stream,
+                                 LOAD_READ_AHEAD_BLOCK_SIZE,
+                                 LOAD_READ_AHEAD_BLOCKS, pool));
+
   /* Progress feedback goes to STDOUT, unless they asked to suppress it. */
   if (! opt_state->quiet)
     feedback_stream = recode_stream_create(stdout, pool);
@@ -1954,6 +2154,81 @@ subcommand_setlog(apr_getopt_t *os, void *baton, apr_pool_t *pool)
 }
 
 
+/* Baton for throttle_pack(). */
+struct pack_throttle_baton_t
+{
+  /* The repository being packed. */
+  svn_fs_t *fs;
+
+  /* Share of the wall clock time that packing may use, in percent. */
+  int percent;
+
+  /* Start of the current slice of packing work. */
+  apr_time_t slice_start;
+
+  /* HEAD when we last checked. */
+  svn_revnum_t youngest;
+
+  /* Scratch pool for the checks. */
+  apr_pool_t *pool;
+};
+
+/* 'svnadmin pack --throttle' lets the packer work in slices of about
+ * PACK_THROTTLE_SLICE microseconds.  When a slice is used up, it pauses
+ * long enough to keep packing at the requested share of the time, and
+ * for at least PACK_COMMIT_BACKOFF microseconds if new revisions have
+ * been committed in the meantime. */
+#define PACK_THROTTLE_SLICE (APR_USEC_PER_SEC / 4)
+#define PACK_COMMIT_BACKOFF apr_time_from_sec(5)
+
+/* Sleep for DURATION microseconds, checking for cancellation at least
+ * every PACK_THROTTLE_SLICE. */
+static svn_error_t *
+cancellable_sleep(apr_interval_time_t duration)
+{
+  while (duration > 0)
+    {
+      apr_interval_time_t step = MIN(duration, PACK_THROTTLE_SLICE);
+
+      apr_sleep(step);
+      duration -= step;
+      SVN_ERR(check_cancel(NULL));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_cancel_func_t.  The packing code calls us often, so
+ * this is where we pause as described for PACK_THROTTLE_SLICE. */
+static svn_error_t *
+throttle_pack(void *baton)
+{
+  struct pack_throttle_baton_t *b = baton;
+  apr_interval_time_t worked = apr_time_now() - b->slice_start;
+  apr_interval_time_t pause;
+  svn_revnum_t youngest;
+
+  SVN_ERR(check_cancel(NULL));
+  if (worked < PACK_THROTTLE_SLICE)
+    return SVN_NO_ERROR;
+
+  pause = worked * (100 - b->percent) / b->percent;
+
+  /* Don't compete with commits and the reads that typically follow. */
+  svn_pool_clear(b->pool);
+  SVN_ERR(svn_fs_youngest_rev(&youngest, b->fs, b->pool));
+  if (youngest != b->youngest)
+    {
+      b->youngest = youngest;
+      pause = MAX(pause, PACK_COMMIT_BACKOFF);
+    }
+
+  SVN_ERR(cancellable_sleep(pause));
+  b->slice_start = apr_time_now();
+
+  return SVN_NO_ERROR;
+}
+
 /* This implements 'svn_opt_subcommand_t'. */
 static svn_error_t *
 subcommand_pack(apr_getopt_t *os, void *baton, apr_pool_t *pool)
@@ -1961,6 +2236,9 @@ subcommand_pack(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   struct svnadmin_opt_state *opt_state = baton;
   svn_repos_t *repos;
   svn_stream_t *feedback_stream = NULL;
+  svn_cancel_func_t cancel_func = check_cancel;
+  void *cancel_baton = NULL;
+  apr_pool_t *iterpool;
 
   /* Expect no more arguments. */
   SVN_ERR(parse_args(NULL, os, 0, 0, pool));
@@ -1971,9 +2249,41 @@ subcommand_pack(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   if (! opt_state->quiet)
     feedback_stream = recode_stream_create(stdout, pool);
 
-  return svn_error_trace(
-    svn_repos_fs_pack2(repos, !opt_state->quiet ? repos_notify_handler : NULL,
-                       feedback_stream, check_cancel, NULL, pool));
+  if (opt_state->throttle < 100)
+    {
+      struct pack_throttle_baton_t *b = apr_pcalloc(pool, sizeof(*b));
+
+      b->fs = svn_repos_fs(repos);
+      b->percent = opt_state->throttle;
+      b->pool = svn_pool_create(pool);
+      SVN_ERR(svn_fs_youngest_rev(&b->youngest, b->fs, pool));
+
+      cancel_func = throttle_pack;
+      cancel_baton = b;
+    }
+
+  iterpool = svn_pool_create(pool);
+  while (TRUE)
+    {
+      svn_pool_clear(iterpool);
+      if (cancel_baton)
+        ((struct pack_throttle_baton_t *)cancel_baton)->slice_start
+          = apr_time_now();
+
+      /* Packing is a no-op if there are no completed shards to pack. */
+      SVN_ERR(svn_repos_fs_pack3(repos, opt_state->jobs,
+                                 !opt_state->quiet ? repos_notify_handler
+                                                   : NULL,
+                                 feedback_stream, cancel_func, cancel_baton,
+                                 iterpool));
+      if (! opt_state->watch)
+        break;
+
+      SVN_ERR(cancellable_sleep(apr_time_from_sec(opt_state->watch)));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
 }
 
 
@@ -2038,9 +2348,11 @@ subcommand_verify(apr_getopt_t *os, void *baton, apr_pool_t *pool)
     apr_array_make(pool, 0, sizeof(struct verification_error *));
   verify_baton.result_pool = pool;
 
-  SVN_ERR(svn_repos_verify_fs3(repos, lower, upper,
+  SVN_ERR(svn_repos_verify_fs4(repos, lower, upper,
                                opt_state->check_normalization,
                                opt_state->metadata_only,
+                               opt_state->incremental,
+                               opt_state->jobs,
                                !opt_state->quiet
                                  ? repos_notify_handler : NULL,
                                feedback_stream,
@@ -2670,6 +2982,8 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   opt_state.start_revision.kind = svn_opt_revision_unspecified;
   opt_state.end_revision.kind = svn_opt_revision_unspecified;
   opt_state.memory_cache_size = svn_cache_config_get()->cache_size;
+  opt_state.jobs = 1;
+  opt_state.throttle = 100;
 
   /* Parse options. */
   SVN_ERR(svn_cmdline__getopt_init(&os, argc, argv, pool));
@@ -2810,6 +3124,14 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       case svnadmin__metadata_only:
         opt_state.metadata_only = TRUE;
         break;
+      case svnadmin__jobs:
+        SVN_ERR(svn_utf_cstring_to_utf8(&utf8_opt_arg, opt_arg, pool));
+        err = svn_cstring_atoi(&opt_state.jobs, utf8_opt_arg);
+        if (err || opt_state.jobs < 1)
+          return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, err,
+                                   _("Invalid number of jobs '%s'"),
+                                   utf8_opt_arg);
+        break;
       case svnadmin__fs_type:
         SVN_ERR(svn_utf_cstring_to_utf8(&opt_state.fs_type, opt_arg, pool));
         break;
@@ -2860,6 +3182,31 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       case svnadmin__no_flush_to_disk:
         opt_state.no_flush_to_disk = TRUE;
         break;
+      case svnadmin__read_ahead:
+        opt_state.read_ahead = TRUE;
+        break;
+      case svnadmin__access_profile:
+        SVN_ERR(svn_utf_cstring_to_utf8(&opt_state.access_profile,
+                                        opt_arg, pool));
+        opt_state.access_profile
+          = svn_dirent_internal_style(opt_state.access_profile, pool);
+        break;
+      case svnadmin__watch:
+        SVN_ERR(svn_utf_cstring_to_utf8(&utf8_opt_arg, opt_arg, pool));
+        err = svn_cstring_atoi(&opt_state.watch, utf8_opt_arg);
+        if (err || opt_state.watch < 1)
+          return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, err,
+                                   _("Invalid watch interval '%s'"),
+                                   utf8_opt_arg);
+        break;
+      case svnadmin__throttle:
+        SVN_ERR(svn_utf_cstring_to_utf8(&utf8_opt_arg, opt_arg, pool));
+        err = svn_cstring_atoi(&opt_state.throttle, utf8_opt_arg);
+        if (err || opt_state.throttle < 1 || opt_state.throttle > 100)
+          return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, err,
+                                   _("Invalid throttle percentage '%s'"),
+                                   utf8_opt_arg);
+        break;
       default:
         {
           SVN_ERR(subcommand_help(NULL, NULL, pool));
@@ -2987,7 +3334,9 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
     svn_cache_config_t settings = *svn_cache_config_get();
 
     settings.cache_size = opt_state.memory_cache_size;
-    settings.single_threaded = TRUE;
+    /* Concurrent verification and packing as well as reading ahead need
+       thread-safe caches. */
+    settings.single_threaded = opt_state.jobs <= 1 && !opt_state.read_ahead;
 
     svn_cache_config_set(&settings);
   }
@@ -31,8 +31,11 @@
 /*** Includes. ***/
 
 #include <apr_tables.h>
+#include <apr_time.h>
 
 #include "svn_client.h"
+#include "svn_delta.h"
+#include "svn_ra.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -96,6 +99,7 @@ typedef struct svn_cl__opt_state_t
   svn_boolean_t trust_server_cert_not_yet_valid;
   svn_boolean_t trust_server_cert_other_failure;
   apr_array_header_t* search_patterns; /* pattern arguments for --search */
+  svn_boolean_t xml;             /* output in xml, e.g., "svnbench null-update --xml" */
 } svn_cl__opt_state_t;
 
 
@@ -113,7 +117,10 @@ svn_opt_subcommand_t
   svn_cl__null_export,
   svn_cl__null_list,
   svn_cl__null_log,
-  svn_cl__null_info;
+  svn_cl__null_info,
+  svn_cl__null_update,
+  svn_cl__null_diff,
+  svn_cl__null_merge;
 
 
 /* See definition in main.c for documentation. */
@@ -196,6 +203,89 @@ svn_cl__local_style_skip_ancestor(const char *parent_path,
                                   const char *path,
                                   apr_pool_t *pool);
 
+
+
+/*** Benchmark statistics of the editor driving commands. ***/
+
+/* What null-update, null-diff and null-merge measure. */
+typedef struct svn_cl__bench_stats_t
+{
+  /* When the measurement started. */
+  apr_time_t start_time;
+
+  /* Bytes transferred over the network, as far as the RA layer tells. */
+  apr_off_t bytes_transferred;
+
+  /* Number of RA calls that talk to the server, not counting the ones
+     needed to open the sessions.  How many network requests each of them
+     takes depends on the RA layer. */
+  apr_int64_t ra_call_count;
+
+  /* What the editor received. */
+  apr_int64_t dir_count;
+  apr_int64_t file_count;
+  apr_int64_t delete_count;
+  apr_int64_t byte_count;
+  apr_int64_t prop_count;
+  apr_int64_t prop_byte_count;
+
+  /* The progress callback of the context that we forward to. */
+  svn_ra_progress_notify_func_t progress_func;
+  void *progress_baton;
+} svn_cl__bench_stats_t;
+
+/* Return new statistics, allocated in POOL, and start measuring the
+ * operations done through CTX.  CTX keeps referring to them until
+ * svn_cl__bench_finish() is called.
+ */
+svn_cl__bench_stats_t *
+svn_cl__bench_start(svn_client_ctx_t *ctx,
+                    apr_pool_t *pool);
+
+/* Stop measuring the operations done through CTX and report STATS of
+ * COMMAND, as XML if XML is set and as plain text otherwise.  Unless
+ * XML is set, don't report anything if QUIET is set.
+ */
+svn_error_t *
+svn_cl__bench_finish(svn_cl__bench_stats_t *stats,
+                     const char *command,
+                     svn_boolean_t quiet,
+                     svn_boolean_t xml,
+                     svn_client_ctx_t *ctx,
+                     apr_pool_t *pool);
+
+/* Set *EDITOR_P and *EDIT_BATON_P to an editor, allocated in POOL, that
+ * only counts what it receives in STATS.  If BASE_SESSION is not NULL,
+ * fetch the BASE_REVISION text of every modified file from it first, the
+ * way a repository diff does.
+ */
+svn_error_t *
+svn_cl__get_counting_editor(const svn_delta_editor_t **editor_p,
+                            void **edit_baton_p,
+                            svn_cl__bench_stats_t *stats,
+                            svn_ra_session_t *base_session,
+                            svn_revnum_t base_revision,
+                            svn_client_ctx_t *ctx,
+                            apr_pool_t *pool);
+
+/* Drive a counting editor with the differences between the tree at the
+ * URL of RA_SESSION in LEFT_REV and the tree at RIGHT_URL in RIGHT_REV,
+ * reporting the left side as a complete tree of DEPTH.  BASE_SESSION,
+ * which must be parented at the same URL as RA_SESSION, is used to fetch
+ * the base texts of modified files.  Add the results to STATS.
+ */
+svn_error_t *
+svn_cl__bench_drive_diff(svn_cl__bench_stats_t *stats,
+                         svn_ra_session_t *ra_session,
+                         svn_ra_session_t *base_session,
+                         svn_revnum_t left_rev,
+                         const char *right_url,
+                         svn_revnum_t right_rev,
+                         svn_depth_t depth,
+                         svn_boolean_t ignore_ancestry,
+                         svn_client_ctx_t *ctx,
+                         apr_pool_t *pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,155 @@
+/*
+ * null-diff-cmd.c -- Diff two repository trees without output
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+/* ==================================================================== */
+
+
+
+/*** Includes. ***/
+
+#include "svn_client.h"
+#include "svn_error.h"
+#include "svn_dirent_uri.h"
+#include "svn_path.h"
+#include "svn_ra.h"
+#include "cl.h"
+
+#include "svn_private_config.h"
+#include "private/svn_client_private.h"
+
+
+/*** Code. ***/
+
+/* This implements the `svn_opt_subcommand_t' interface. */
+svn_error_t *
+svn_cl__null_diff(apr_getopt_t *os,
+                  void *baton,
+                  apr_pool_t *pool)
+{
+  svn_cl__opt_state_t *opt_state = ((svn_cl__cmd_baton_t *) baton)->opt_state;
+  svn_client_ctx_t *ctx = ((svn_cl__cmd_baton_t *) baton)->ctx;
+  apr_array_header_t *targets;
+  const char *url1, *url2;
+  svn_opt_revision_t peg1, peg2;
+  svn_opt_revision_t *revision1, *revision2;
+  svn_client__pathrev_t *loc1, *loc2;
+  svn_ra_session_t *ra_session;
+  svn_ra_session_t *base_session;
+  svn_node_kind_t kind1, kind2;
+  svn_cl__bench_stats_t *stats;
+
+  SVN_ERR(svn_cl__args_to_target_array_print_reserved(&targets, os,
+                                                      opt_state->targets,
+                                                      ctx, FALSE, pool));
+
+  /* We want exactly 1 or 2 targets for this subcommand. */
+  if (targets->nelts < 1)
+    return svn_error_create(SVN_ERR_CL_INSUFFICIENT_ARGS, 0, NULL);
+  if (targets->nelts > 2)
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, 0, NULL);
+
+  SVN_ERR(svn_opt_parse_path(&peg1, &url1,
+                             APR_ARRAY_IDX(targets, 0, const char *), pool));
+
+  if (targets->nelts == 2)
+    {
+      /* URL1[@N] URL2[@M] */
+      if (opt_state->start_revision.kind != svn_opt_revision_unspecified)
+        return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                _("Revisions must be given as peg "
+                                  "revisions when diffing two URLs"));
+
+      SVN_ERR(svn_opt_parse_path(&peg2, &url2,
+                                 APR_ARRAY_IDX(targets, 1, const char *),
+                                 pool));
+      if (peg1.kind == svn_opt_revision_unspecified)
+        peg1.kind = svn_opt_revision_head;
+      if (peg2.kind == svn_opt_revision_unspecified)
+        peg2.kind = svn_opt_revision_head;
+
+      revision1 = &peg1;
+      revision2 = &peg2;
+    }
+  else
+    {
+      /* -r N:M URL[@PEGREV] */
+      if (opt_state->end_revision.kind == svn_opt_revision_unspecified)
+        return svn_error_create(SVN_ERR_CL_INSUFFICIENT_ARGS, NULL,
+                                _("A revision range is required when "
+                                  "diffing a single URL"));
+
+      url2 = url1;
+      if (peg1.kind == svn_opt_revision_unspecified)
+        peg1.kind = svn_opt_revision_head;
+      peg2 = peg1;
+
+      revision1 = &opt_state->start_revision;
+      revision2 = &opt_state->end_revision;
+    }
+
+  if (! svn_path_is_url(url1))
+    return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                             _("'%s' is not a URL"), url1);
+  if (! svn_path_is_url(url2))
+    return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                             _("'%s' is not a URL"), url2);
+
+  if (opt_state->depth == svn_depth_unknown)
+    opt_state->depth = svn_depth_infinity;
+
+  stats = svn_cl__bench_start(ctx, pool);
+
+  /* Like 'svn diff URL1 URL2', use one session for the diff and another
+     one, parented at the left side, for the base texts. */
+  SVN_ERR(svn_client__ra_session_from_path2(&ra_session, &loc1, url1, NULL,
+                                            &peg1, revision1, ctx, pool));
+  SVN_ERR(svn_client__ra_session_from_path2(&base_session, &loc2, url2,
+                                            NULL, &peg2, revision2,
+                                            ctx, pool));
+
+  SVN_ERR(svn_ra_check_path(ra_session, "", loc1->rev, &kind1, pool));
+  SVN_ERR(svn_ra_check_path(base_session, "", loc2->rev, &kind2, pool));
+  stats->ra_call_count += 2;
+
+  if (kind1 != svn_node_dir)
+    return svn_error_createf(SVN_ERR_ILLEGAL_TARGET, NULL,
+                             _("'%s' is not a directory in r%ld"),
+                             loc1->url, loc1->rev);
+  if (kind2 != svn_node_dir)
+    return svn_error_createf(SVN_ERR_ILLEGAL_TARGET, NULL,
+                             _("'%s' is not a directory in r%ld"),
+                             loc2->url, loc2->rev);
+
+  SVN_ERR(svn_ra_reparent(base_session, loc1->url, pool));
+
+  SVN_ERR(svn_cl__bench_drive_diff(stats, ra_session, base_session,
+                                   loc1->rev, loc2->url, loc2->rev,
+                                   opt_state->depth,
+                                   TRUE /* ignore_ancestry */,
+                                   ctx, pool));
+
+  return svn_error_trace(svn_cl__bench_finish(stats, "null-diff",
+                                              opt_state->quiet,
+                                              opt_state->xml, ctx, pool));
+}
@@ -0,0 +1,137 @@
+/*
+ * null-merge-cmd.c -- Drive merge editors without a working copy
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+/* ==================================================================== */
+
+
+
+/*** Includes. ***/
+
+#include "svn_client.h"
+#include "svn_error.h"
+#include "svn_dirent_uri.h"
+#include "svn_path.h"
+#include "svn_pools.h"
+#include "svn_ra.h"
+#include "cl.h"
+
+#include "svn_private_config.h"
+#include "private/svn_client_private.h"
+
+
+/*** Code. ***/
+
+/* This implements the `svn_opt_subcommand_t' interface. */
+svn_error_t *
+svn_cl__null_merge(apr_getopt_t *os,
+                   void *baton,
+                   apr_pool_t *pool)
+{
+  svn_cl__opt_state_t *opt_state = ((svn_cl__cmd_baton_t *) baton)->opt_state;
+  svn_client_ctx_t *ctx = ((svn_cl__cmd_baton_t *) baton)->ctx;
+  apr_array_header_t *targets;
+  const char *url;
+  svn_opt_revision_t peg_revision;
+  svn_client__pathrev_t *loc;
+  svn_ra_session_t *ra_session;
+  svn_ra_session_t *base_session;
+  svn_cl__bench_stats_t *stats;
+  apr_pool_t *iterpool;
+  int i;
+
+  SVN_ERR(svn_cl__args_to_target_array_print_reserved(&targets, os,
+                                                      opt_state->targets,
+                                                      ctx, FALSE, pool));
+
+  /* We want exactly 1 target for this subcommand. */
+  if (targets->nelts < 1)
+    return svn_error_create(SVN_ERR_CL_INSUFFICIENT_ARGS, 0, NULL);
+  if (targets->nelts > 1)
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, 0, NULL);
+
+  SVN_ERR(svn_opt_parse_path(&peg_revision, &url,
+                             APR_ARRAY_IDX(targets, 0, const char *), pool));
+  if (! svn_path_is_url(url))
+    return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                             _("'%s' is not a URL"), url);
+
+  /* Unlike 'svn merge', we don't calculate the eligible revisions. */
+  for (i = 0; i < opt_state->revision_ranges->nelts; i++)
+    {
+      svn_opt_revision_range_t *range
+        = APR_ARRAY_IDX(opt_state->revision_ranges, i,
+                        svn_opt_revision_range_t *);
+
+      if (range->start.kind == svn_opt_revision_unspecified
+          || range->end.kind == svn_opt_revision_unspecified)
+        return svn_error_create(SVN_ERR_CL_INSUFFICIENT_ARGS, NULL,
+                                _("Explicit revision ranges are required"));
+    }
+
+  if (peg_revision.kind == svn_opt_revision_unspecified)
+    peg_revision.kind = svn_opt_revision_head;
+
+  if (opt_state->depth == svn_depth_unknown)
+    opt_state->depth = svn_depth_infinity;
+
+  stats = svn_cl__bench_start(ctx, pool);
+
+  /* Like 'svn merge', keep the two sessions for all ranges. */
+  SVN_ERR(svn_client__ra_session_from_path2(&ra_session, &loc, url, NULL,
+                                            &peg_revision, &peg_revision,
+                                            ctx, pool));
+  SVN_ERR(svn_client_open_ra_session2(&base_session, loc->url, NULL,
+                                      ctx, pool, pool));
+
+  iterpool = svn_pool_create(pool);
+  for (i = 0; i < opt_state->revision_ranges->nelts; i++)
+    {
+      svn_opt_revision_range_t *range
+        = APR_ARRAY_IDX(opt_state->revision_ranges, i,
+                        svn_opt_revision_range_t *);
+      svn_revnum_t left_rev, right_rev;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_client__get_revision_number(&left_rev, NULL, ctx->wc_ctx,
+                                              NULL, ra_session,
+                                              &range->start, iterpool));
+      SVN_ERR(svn_client__get_revision_number(&right_rev, NULL,
+                                              ctx->wc_ctx, NULL, ra_session,
+                                              &range->end, iterpool));
+
+      /* Merges notice ancestry, so replacements arrive as a delete and
+         an add. */
+      SVN_ERR(svn_cl__bench_drive_diff(stats, ra_session, base_session,
+                                       left_rev, loc->url, right_rev,
+                                       opt_state->depth,
+                                       FALSE /* ignore_ancestry */,
+                                       ctx, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(svn_cl__bench_finish(stats, "null-merge",
+                                              opt_state->quiet,
+                                              opt_state->xml, ctx, pool));
+}
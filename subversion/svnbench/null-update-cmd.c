@@ -0,0 +1,163 @@
+/*
+ * null-update-cmd.c -- Update or switch without a working copy
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+/* ==================================================================== */
+
+
+
+/*** Includes. ***/
+
+#include "svn_client.h"
+#include "svn_error.h"
+#include "svn_dirent_uri.h"
+#include "svn_path.h"
+#include "svn_ra.h"
+#include "cl.h"
+
+#include "svn_private_config.h"
+#include "private/svn_client_private.h"
+
+
+/*** Code. ***/
+
+/* This implements the `svn_opt_subcommand_t' interface. */
+svn_error_t *
+svn_cl__null_update(apr_getopt_t *os,
+                    void *baton,
+                    apr_pool_t *pool)
+{
+  svn_cl__opt_state_t *opt_state = ((svn_cl__cmd_baton_t *) baton)->opt_state;
+  svn_client_ctx_t *ctx = ((svn_cl__cmd_baton_t *) baton)->ctx;
+  apr_array_header_t *targets;
+  const char *url;
+  const char *switch_url = NULL;
+  svn_opt_revision_t peg_revision;
+  svn_client__pathrev_t *loc;
+  svn_ra_session_t *ra_session;
+  svn_revnum_t base_rev = SVN_INVALID_REVNUM;
+  svn_revnum_t target_rev;
+  svn_node_kind_t kind;
+  const svn_delta_editor_t *editor;
+  void *edit_baton;
+  const svn_ra_reporter3_t *reporter;
+  void *report_baton;
+  svn_cl__bench_stats_t *stats;
+
+  SVN_ERR(svn_cl__args_to_target_array_print_reserved(&targets, os,
+                                                      opt_state->targets,
+                                                      ctx, FALSE, pool));
+
+  /* We want exactly 1 or 2 targets for this subcommand. */
+  if (targets->nelts < 1)
+    return svn_error_create(SVN_ERR_CL_INSUFFICIENT_ARGS, 0, NULL);
+  if (targets->nelts > 2)
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, 0, NULL);
+
+  SVN_ERR(svn_opt_parse_path(&peg_revision, &url,
+                             APR_ARRAY_IDX(targets, 0, const char *), pool));
+  if (targets->nelts == 2)
+    switch_url = APR_ARRAY_IDX(targets, 1, const char *);
+
+  if (! svn_path_is_url(url))
+    return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                             _("'%s' is not a URL"), url);
+  if (switch_url && ! svn_path_is_url(switch_url))
+    return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                             _("'%s' is not a URL"), switch_url);
+
+  if (peg_revision.kind == svn_opt_revision_unspecified)
+    peg_revision.kind = svn_opt_revision_head;
+
+  if (opt_state->depth == svn_depth_unknown)
+    opt_state->depth = svn_depth_infinity;
+
+  stats = svn_cl__bench_start(ctx, pool);
+
+  SVN_ERR(svn_client__ra_session_from_path2(&ra_session, &loc, url, NULL,
+                                            &peg_revision, &peg_revision,
+                                            ctx, pool));
+
+  /* With -r BASE:REV, the simulated working copy is a complete tree at
+     BASE.  Otherwise, it is empty, like a fresh checkout. */
+  if (opt_state->end_revision.kind != svn_opt_revision_unspecified)
+    {
+      SVN_ERR(svn_client__get_revision_number(&base_rev, NULL, ctx->wc_ctx,
+                                              NULL, ra_session,
+                                              &opt_state->start_revision,
+                                              pool));
+      SVN_ERR(svn_client__get_revision_number(&target_rev, NULL,
+                                              ctx->wc_ctx, NULL, ra_session,
+                                              &opt_state->end_revision,
+                                              pool));
+    }
+  else if (opt_state->start_revision.kind != svn_opt_revision_unspecified)
+    SVN_ERR(svn_client__get_revision_number(&target_rev, NULL, ctx->wc_ctx,
+                                            NULL, ra_session,
+                                            &opt_state->start_revision,
+                                            pool));
+  else
+    target_rev = loc->rev;
+
+  SVN_ERR(svn_ra_check_path(ra_session, "", SVN_IS_VALID_REVNUM(base_rev)
+                                              ? base_rev : target_rev,
+                            &kind, pool));
+  stats->ra_call_count++;
+
+  if (kind != svn_node_dir)
+    return svn_error_createf(SVN_ERR_ILLEGAL_TARGET, NULL,
+                             _("'%s' is not a directory"), url);
+
+  SVN_ERR(svn_cl__get_counting_editor(&editor, &edit_baton, stats,
+                                      NULL, SVN_INVALID_REVNUM, ctx, pool));
+
+  if (switch_url)
+    SVN_ERR(svn_ra_do_switch3(ra_session, &reporter, &report_baton,
+                              target_rev, "", opt_state->depth, switch_url,
+                              FALSE /* send_copyfrom_args */,
+                              FALSE /* ignore_ancestry */,
+                              editor, edit_baton, pool, pool));
+  else
+    SVN_ERR(svn_ra_do_update3(ra_session, &reporter, &report_baton,
+                              target_rev, "", opt_state->depth,
+                              FALSE /* send_copyfrom_args */,
+                              FALSE /* ignore_ancestry */,
+                              editor, edit_baton, pool, pool));
+
+  if (SVN_IS_VALID_REVNUM(base_rev))
+    SVN_ERR(reporter->set_path(report_baton, "", base_rev, opt_state->depth,
+                               FALSE, NULL, pool));
+  else
+    SVN_ERR(reporter->set_path(report_baton, "", target_rev,
+                               /* Depth is irrelevant, as we're
+                                  passing start_empty=TRUE anyway. */
+                               svn_depth_infinity,
+                               TRUE, NULL, pool));
+
+  SVN_ERR(reporter->finish_report(report_baton, pool));
+  stats->ra_call_count++;
+
+  return svn_error_trace(svn_cl__bench_finish(stats, "null-update",
+                                              opt_state->quiet,
+                                              opt_state->xml, ctx, pool));
+}
@@ -69,7 +69,8 @@ typedef enum svn_cl__longopt_t {
   opt_trust_server_cert,
   opt_trust_server_cert_failures,
   opt_changelist,
-  opt_search
+  opt_search,
+  opt_xml
 } svn_cl__longopt_t;
 
 
@@ -168,6 +169,7 @@ const apr_getopt_option_t svn_cl__options[] =
                        "history")},
   {"search", opt_search, 1,
                        N_("use ARG as search pattern (glob syntax)")},
+  {"xml",           opt_xml, 0, N_("output in XML")},
 
   /* Long-opt Aliases
    *
@@ -306,6 +308,46 @@ const svn_opt_subcommand_desc2_t svn_cl__cmd_table[] =
     {'r', 'R', opt_depth, opt_targets, opt_changelist}
   },
 
+  { "null-update", svn_cl__null_update, {0}, N_
+    ("Update or switch a simulated working copy.\n"
+     "usage: null-update [-r [BASE:]REV] URL[@PEGREV] [SWITCH_URL]\n"
+     "\n"
+     "  Report a working copy of the directory URL to the server and\n"
+     "  receive the changes that would bring it to revision REV (default:\n"
+     "  PEGREV, or HEAD), or to SWITCH_URL in REV if that is given.\n"
+     "\n"
+     "  With BASE, the working copy is a complete tree at revision BASE;\n"
+     "  otherwise it is empty, like a fresh checkout.\n"
+     "\n"
+     "  With --xml, report the statistics in XML.\n"),
+    {'r', 'q', opt_depth, opt_xml} },
+
+  { "null-diff", svn_cl__null_diff, {0}, N_
+    ("Receive the differences between two repository trees.\n"
+     "usage: 1. null-diff -r N:M URL[@PEGREV]\n"
+     "       2. null-diff URL1[@N] URL2[@M]\n"
+     "\n"
+     "  1. Diff the directory URL in revisions N and M.\n"
+     "\n"
+     "  2. Diff the directories URL1 in revision N and URL2 in revision M\n"
+     "     (default: HEAD).\n"
+     "\n"
+     "  Fetch the base texts of modified files like 'svn diff' does.\n"
+     "  With --xml, report the statistics in XML.\n"),
+    {'r', 'c', 'q', opt_depth, opt_xml} },
+
+  { "null-merge", svn_cl__null_merge, {0}, N_
+    ("Receive the changes a merge of some revisions would apply.\n"
+     "usage: null-merge [-c M[,N...] | -r N:M ...] SOURCE[@REV]\n"
+     "\n"
+     "  Drive a merge editor with the changes to the directory SOURCE for\n"
+     "  each of the given revision ranges in turn, without consulting or\n"
+     "  recording mergeinfo.\n"
+     "\n"
+     "  With --xml, report the statistics in XML.\n"),
+    {'r', 'c', 'q', opt_depth, opt_xml},
+    {{'c', N_("the change made in revision ARG")}} },
+
   { NULL, NULL, {0}, NULL, {0} }
 };
 
@@ -690,6 +732,9 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
                                  apr_pstrdup(pool, utf8_opt_arg),
                                  pool);
         break;
+      case opt_xml:
+        opt_state.xml = TRUE;
+        break;
       default:
         /* Hmmm. Perhaps this would be a good place to squirrel away
            opts that commands like svn diff might need. Hmmm indeed. */
@@ -989,7 +1034,8 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
 
       return err;
     }
-  else if ((subcommand->cmd_func != svn_cl__help) && !opt_state.quiet)
+  else if ((subcommand->cmd_func != svn_cl__help) && !opt_state.quiet
+           && !opt_state.xml)
     {
       /* This formatting lines up nicely with the output of our sub-commands
        * and gives musec resolution while not overflowing for 30 years. */
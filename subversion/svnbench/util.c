@@ -34,11 +34,16 @@
 #include <assert.h>
 
 #include "svn_private_config.h"
+#include "svn_cmdline.h"
+#include "svn_delta.h"
 #include "svn_error.h"
 #include "svn_path.h"
+#include "svn_xml.h"
 
 #include "cl.h"
 
+#include "private/svn_string_private.h"
+
 
 
 svn_error_t *
@@ -90,3 +95,361 @@ svn_cl__local_style_skip_ancestor(const char *parent_path,
   return svn_dirent_local_style(relpath ? relpath : path, pool);
 }
 
+
+
+
+/*** Benchmark statistics. ***/
+
+/* Implements svn_ra_progress_notify_func_t.  libsvn_client reports the
+ * total over all sessions of the context, so the last value is all we
+ * need. */
+static void
+bench_progress_func(apr_off_t progress,
+                    apr_off_t total,
+                    void *baton,
+                    apr_pool_t *pool)
+{
+  svn_cl__bench_stats_t *stats = baton;
+
+  stats->bytes_transferred = progress;
+  if (stats->progress_func)
+    stats->progress_func(progress, total, stats->progress_baton, pool);
+}
+
+svn_cl__bench_stats_t *
+svn_cl__bench_start(svn_client_ctx_t *ctx,
+                    apr_pool_t *pool)
+{
+  svn_cl__bench_stats_t *stats = apr_pcalloc(pool, sizeof(*stats));
+
+  stats->progress_func = ctx->progress_func;
+  stats->progress_baton = ctx->progress_baton;
+  ctx->progress_func = bench_progress_func;
+  ctx->progress_baton = stats;
+
+  stats->start_time = apr_time_now();
+
+  return stats;
+}
+
+/* Append an element NAME with the decimal VALUE to *SB. */
+static void
+add_xml_counter(svn_stringbuf_t **sb,
+                const char *name,
+                apr_int64_t value,
+                apr_pool_t *pool)
+{
+  svn_xml_make_open_tag(sb, pool, svn_xml_protect_pcdata, name, SVN_VA_NULL);
+  svn_stringbuf_appendcstr(*sb, apr_psprintf(pool, "%" APR_INT64_T_FMT,
+                                             value));
+  svn_xml_make_close_tag(sb, pool, name);
+}
+
+svn_error_t *
+svn_cl__bench_finish(svn_cl__bench_stats_t *stats,
+                     const char *command,
+                     svn_boolean_t quiet,
+                     svn_boolean_t xml,
+                     svn_client_ctx_t *ctx,
+                     apr_pool_t *pool)
+{
+  apr_time_t time_taken = apr_time_now() - stats->start_time;
+
+  ctx->progress_func = stats->progress_func;
+  ctx->progress_baton = stats->progress_baton;
+
+  if (xml)
+    {
+      svn_stringbuf_t *sb = svn_stringbuf_create_empty(pool);
+
+      svn_xml_make_header2(&sb, "UTF-8", pool);
+      svn_xml_make_open_tag(&sb, pool, svn_xml_normal, "bench",
+                            "command", command, SVN_VA_NULL);
+
+      svn_xml_make_open_tag(&sb, pool, svn_xml_protect_pcdata, "seconds",
+                            SVN_VA_NULL);
+      svn_stringbuf_appendcstr(sb, apr_psprintf(pool, "%.6f",
+                                                time_taken / 1.0e6));
+      svn_xml_make_close_tag(&sb, pool, "seconds");
+
+      add_xml_counter(&sb, "bytes-transferred", stats->bytes_transferred,
+                      pool);
+      add_xml_counter(&sb, "ra-calls", stats->ra_call_count, pool);
+      add_xml_counter(&sb, "directories", stats->dir_count, pool);
+      add_xml_counter(&sb, "files", stats->file_count, pool);
+      add_xml_counter(&sb, "deletes", stats->delete_count, pool);
+      add_xml_counter(&sb, "text-bytes", stats->byte_count, pool);
+      add_xml_counter(&sb, "properties", stats->prop_count, pool);
+      add_xml_counter(&sb, "property-bytes", stats->prop_byte_count, pool);
+
+      svn_xml_make_close_tag(&sb, pool, "bench");
+
+      return svn_error_trace(svn_cmdline_fputs(sb->data, stdout, pool));
+    }
+
+  /* The time taken and the bytes transferred are reported by main(). */
+  if (!quiet)
+    SVN_ERR(svn_cmdline_printf(pool,
+                               _("%15s RA calls\n"
+                                 "%15s directories\n"
+                                 "%15s files\n"
+                                 "%15s deletes\n"
+                                 "%15s bytes in files\n"
+                                 "%15s properties\n"
+                                 "%15s bytes in properties\n"),
+                               svn__i64toa_sep(stats->ra_call_count, ',',
+                                               pool),
+                               svn__i64toa_sep(stats->dir_count, ',', pool),
+                               svn__i64toa_sep(stats->file_count, ',', pool),
+                               svn__i64toa_sep(stats->delete_count, ',',
+                                               pool),
+                               svn__i64toa_sep(stats->byte_count, ',', pool),
+                               svn__i64toa_sep(stats->prop_count, ',', pool),
+                               svn__i64toa_sep(stats->prop_byte_count, ',',
+                                               pool)));
+
+  return SVN_NO_ERROR;
+}
+
+
+/*** A counting editor, which does nothing but looking at the data. ***/
+
+typedef struct counting_edit_baton_t
+{
+  svn_cl__bench_stats_t *stats;
+
+  /* Where to fetch the base texts of changed files from, or NULL. */
+  svn_ra_session_t *base_session;
+  svn_revnum_t base_revision;
+} counting_edit_baton_t;
+
+typedef struct counting_file_baton_t
+{
+  counting_edit_baton_t *eb;
+  const char *path;
+  svn_boolean_t added;
+} counting_file_baton_t;
+
+static svn_error_t *
+counting_open_root(void *edit_baton,
+                   svn_revnum_t base_revision,
+                   apr_pool_t *pool,
+                   void **root_baton)
+{
+  *root_baton = edit_baton;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+counting_delete_entry(const char *path,
+                      svn_revnum_t revision,
+                      void *parent_baton,
+                      apr_pool_t *pool)
+{
+  counting_edit_baton_t *eb = parent_baton;
+  eb->stats->delete_count++;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+counting_add_directory(const char *path,
+                       void *parent_baton,
+                       const char *copyfrom_path,
+                       svn_revnum_t copyfrom_revision,
+                       apr_pool_t *pool,
+                       void **child_baton)
+{
+  counting_edit_baton_t *eb = parent_baton;
+  eb->stats->dir_count++;
+
+  *child_baton = eb;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+counting_open_directory(const char *path,
+                        void *parent_baton,
+                        svn_revnum_t base_revision,
+                        apr_pool_t *pool,
+                        void **child_baton)
+{
+  counting_edit_baton_t *eb = parent_baton;
+  eb->stats->dir_count++;
+
+  *child_baton = eb;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+counting_change_dir_prop(void *dir_baton,
+                         const char *name,
+                         const svn_string_t *value,
+                         apr_pool_t *pool)
+{
+  counting_edit_baton_t *eb = dir_baton;
+  eb->stats->prop_count++;
+  if (value)
+    eb->stats->prop_byte_count += value->len;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+make_file_baton(void **file_baton,
+                counting_edit_baton_t *eb,
+                const char *path,
+                svn_boolean_t added,
+                apr_pool_t *pool)
+{
+  counting_file_baton_t *fb = apr_pcalloc(pool, sizeof(*fb));
+
+  fb->eb = eb;
+  fb->path = apr_pstrdup(pool, path);
+  fb->added = added;
+  eb->stats->file_count++;
+
+  *file_baton = fb;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+counting_add_file(const char *path,
+                  void *parent_baton,
+                  const char *copyfrom_path,
+                  svn_revnum_t copyfrom_revision,
+                  apr_pool_t *pool,
+                  void **file_baton)
+{
+  return make_file_baton(file_baton, parent_baton, path, TRUE, pool);
+}
+
+static svn_error_t *
+counting_open_file(const char *path,
+                   void *parent_baton,
+                   svn_revnum_t base_revision,
+                   apr_pool_t *pool,
+                   void **file_baton)
+{
+  return make_file_baton(file_baton, parent_baton, path, FALSE, pool);
+}
+
+static svn_error_t *
+counting_window_handler(svn_txdelta_window_t *window, void *baton)
+{
+  counting_file_baton_t *fb = baton;
+  if (window != NULL)
+    fb->eb->stats->byte_count += window->tview_len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Like the repository diff editor of libsvn_client, fetch the base text
+   of modified files before their delta arrives. */
+static svn_error_t *
+counting_apply_textdelta(void *file_baton,
+                         const char *base_checksum,
+                         apr_pool_t *pool,
+                         svn_txdelta_window_handler_t *handler,
+                         void **handler_baton)
+{
+  counting_file_baton_t *fb = file_baton;
+  counting_edit_baton_t *eb = fb->eb;
+
+  if (eb->base_session && !fb->added)
+    {
+      apr_hash_t *props;
+
+      SVN_ERR(svn_ra_get_file(eb->base_session, fb->path, eb->base_revision,
+                              svn_stream_empty(pool), NULL, &props, pool));
+      eb->stats->ra_call_count++;
+    }
+
+  *handler_baton = fb;
+  *handler = counting_window_handler;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+counting_change_file_prop(void *file_baton,
+                          const char *name,
+                          const svn_string_t *value,
+                          apr_pool_t *pool)
+{
+  counting_file_baton_t *fb = file_baton;
+  fb->eb->stats->prop_count++;
+  if (value)
+    fb->eb->stats->prop_byte_count += value->len;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_cl__get_counting_editor(const svn_delta_editor_t **editor_p,
+                            void **edit_baton_p,
+                            svn_cl__bench_stats_t *stats,
+                            svn_ra_session_t *base_session,
+                            svn_revnum_t base_revision,
+                            svn_client_ctx_t *ctx,
+                            apr_pool_t *pool)
+{
+  svn_delta_editor_t *editor = svn_delta_default_editor(pool);
+  counting_edit_baton_t *eb = apr_pcalloc(pool, sizeof(*eb));
+
+  eb->stats = stats;
+  eb->base_session = base_session;
+  eb->base_revision = base_revision;
+
+  editor->open_root = counting_open_root;
+  editor->delete_entry = counting_delete_entry;
+  editor->add_directory = counting_add_directory;
+  editor->open_directory = counting_open_directory;
+  editor->change_dir_prop = counting_change_dir_prop;
+  editor->add_file = counting_add_file;
+  editor->open_file = counting_open_file;
+  editor->apply_textdelta = counting_apply_textdelta;
+  editor->change_file_prop = counting_change_file_prop;
+
+  return svn_error_trace(svn_delta_get_cancellation_editor(ctx->cancel_func,
+                                                           ctx->cancel_baton,
+                                                           editor, eb,
+                                                           editor_p,
+                                                           edit_baton_p,
+                                                           pool));
+}
+
+svn_error_t *
+svn_cl__bench_drive_diff(svn_cl__bench_stats_t *stats,
+                         svn_ra_session_t *ra_session,
+                         svn_ra_session_t *base_session,
+                         svn_revnum_t left_rev,
+                         const char *right_url,
+                         svn_revnum_t right_rev,
+                         svn_depth_t depth,
+                         svn_boolean_t ignore_ancestry,
+                         svn_client_ctx_t *ctx,
+                         apr_pool_t *pool)
+{
+  const svn_delta_editor_t *editor;
+  void *edit_baton;
+  const svn_ra_reporter3_t *reporter;
+  void *report_baton;
+
+  SVN_ERR(svn_cl__get_counting_editor(&editor, &edit_baton, stats,
+                                      base_session, left_rev, ctx, pool));
+
+  SVN_ERR(svn_ra_do_diff3(ra_session, &reporter, &report_baton,
+                          right_rev, "", depth, ignore_ancestry,
+                          TRUE /* text_deltas */, right_url,
+                          editor, edit_baton, pool));
+
+  /* The left side is a complete tree at LEFT_REV, as a working copy
+     without local modifications would report it. */
+  SVN_ERR(reporter->set_path(report_baton, "", left_rev, depth,
+                             FALSE, NULL, pool));
+  SVN_ERR(reporter->finish_report(report_baton, pool));
+  stats->ra_call_count++;
+
+  return SVN_NO_ERROR;
+}
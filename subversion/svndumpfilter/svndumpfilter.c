@@ -105,46 +105,49 @@ write_propdel_to_stringbuf(svn_stringbuf_t **strbuf,
 }
 
 
-/* Compare the node-path PATH with the (const char *) prefixes in PFXLIST.
- * Return TRUE if any prefix is a prefix of PATH (matching whole path
- * components); FALSE otherwise.
- * PATH starts with a '/', as do the (const char *) paths in PREFIXES. */
-static svn_boolean_t
-ary_prefix_match(const apr_array_header_t *pfxlist, const char *path)
+/* Return a set of the (const char *) prefixes in PFXLIST, for use with
+ * prefix_set_match().  Allocate it in POOL. */
+static apr_hash_t *
+prefix_set_create(const apr_array_header_t *pfxlist, apr_pool_t *pool)
 {
+  apr_hash_t *prefix_set = apr_hash_make(pool);
   int i;
-  size_t path_len = strlen(path);
 
   for (i = 0; i < pfxlist->nelts; i++)
     {
       const char *pfx = APR_ARRAY_IDX(pfxlist, i, const char *);
-      size_t pfx_len = strlen(pfx);
 
-      if (path_len < pfx_len)
-        continue;
-      if (strncmp(path, pfx, pfx_len) == 0
-          && (pfx_len == 1 || path[pfx_len] == '\0' || path[pfx_len] == '/'))
-        return TRUE;
+      apr_hash_set(prefix_set, pfx, APR_HASH_KEY_STRING, pfx);
     }
 
-  return FALSE;
+  return prefix_set;
 }
 
-
-/* Check whether we need to skip this PATH based on its presence in
-   the PREFIXES list, and the DO_EXCLUDE option.
-   PATH starts with a '/', as do the (const char *) paths in PREFIXES. */
-static APR_INLINE svn_boolean_t
-skip_path(const char *path, const apr_array_header_t *prefixes,
-          svn_boolean_t do_exclude, svn_boolean_t glob)
+/* Compare the node-path PATH with the prefixes in PREFIX_SET.
+ * Return TRUE if any prefix is a prefix of PATH (matching whole path
+ * components); FALSE otherwise.
+ * PATH starts with a '/', as do the prefixes in PREFIX_SET.
+ *
+ * Rather than trying every prefix, look up PATH and each of its parents,
+ * so that the cost doesn't grow with the number of prefixes. */
+static svn_boolean_t
+prefix_set_match(apr_hash_t *prefix_set, const char *path)
 {
-  const svn_boolean_t matches =
-    (glob
-     ? svn_cstring_match_glob_list(path, prefixes)
-     : ary_prefix_match(prefixes, path));
+  apr_ssize_t len = strlen(path);
 
-  /* NXOR */
-  return (matches ? do_exclude : !do_exclude);
+  while (len > 0)
+    {
+      if (apr_hash_get(prefix_set, path, len))
+        return TRUE;
+
+      /* Strip the last path component. */
+      do
+        len--;
+      while (len > 0 && path[len] != '/');
+    }
+
+  /* "/" is a prefix of everything. */
+  return apr_hash_get(prefix_set, "/", 1) != NULL;
 }
 
 
@@ -170,6 +173,7 @@ struct revmap_t
 {
   svn_revnum_t rev; /* Last non-dropped revision to which this maps. */
   svn_boolean_t was_dropped; /* Was this revision dropped? */
+  svn_boolean_t was_seen; /* Was this revision in the input at all? */
 };
 
 struct parse_baton_t
@@ -186,6 +190,9 @@ struct parse_baton_t
   svn_boolean_t allow_deltas;
   apr_array_header_t *prefixes;
 
+  /* PREFIXES as a set, unless GLOB is set. */
+  apr_hash_t *prefix_set;
+
   /* Input and output streams. */
   svn_stream_t *in_stream;
   svn_stream_t *out_stream;
@@ -193,7 +200,11 @@ struct parse_baton_t
   /* State for the filtering process. */
   apr_int32_t rev_drop_count;
   apr_hash_t *dropped_nodes;
-  apr_hash_t *renumber_history;  /* svn_revnum_t -> struct revmap_t */
+  /* struct revmap_t, indexed by the original revision number minus
+     RENUMBER_BASE.  Dump streams come in revision order, so this is far
+     more compact than a hash. */
+  apr_array_header_t *renumber_history;
+  svn_revnum_t renumber_base;
   svn_revnum_t last_live_revision;
   /* The oldest original revision, greater than r0, in the input
      stream which was not filtered. */
@@ -259,6 +270,87 @@ struct node_baton_t
 
 
 
+/* Check whether we need to skip this PATH based on its presence in
+   the prefixes of PB, and the DO_EXCLUDE option.
+   PATH starts with a '/', as do the prefixes. */
+static APR_INLINE svn_boolean_t
+skip_path(const char *path, const struct parse_baton_t *pb)
+{
+  const svn_boolean_t matches =
+    (pb->glob
+     ? svn_cstring_match_glob_list(path, pb->prefixes)
+     : prefix_set_match(pb->prefix_set, path));
+
+  /* NXOR */
+  return (matches ? pb->do_exclude : !pb->do_exclude);
+}
+
+/* Record in PB that the original revision REV maps to NEW_REV and
+   whether it WAS_DROPPED. */
+static void
+set_revmap(struct parse_baton_t *pb,
+           svn_revnum_t rev,
+           svn_revnum_t new_rev,
+           svn_boolean_t was_dropped)
+{
+  apr_array_header_t *history = pb->renumber_history;
+  struct revmap_t *revmap;
+
+  if (! SVN_IS_VALID_REVNUM(pb->renumber_base))
+    pb->renumber_base = rev;
+
+  /* Out-of-order input.  Make room at the front. */
+  if (rev < pb->renumber_base)
+    {
+      apr_array_header_t *old_history = history;
+      int gap = (int)(pb->renumber_base - rev);
+
+      history = apr_array_make(apr_array_pool_get(old_history),
+                               old_history->nelts + gap,
+                               sizeof(struct revmap_t));
+      history->nelts = gap;
+      memset(history->elts, 0, gap * sizeof(struct revmap_t));
+      apr_array_cat(history, old_history);
+
+      pb->renumber_history = history;
+      pb->renumber_base = rev;
+    }
+
+  while (history->nelts <= rev - pb->renumber_base)
+    {
+      revmap = apr_array_push(history);
+      revmap->rev = SVN_INVALID_REVNUM;
+      revmap->was_dropped = FALSE;
+      revmap->was_seen = FALSE;
+    }
+
+  revmap = &APR_ARRAY_IDX(history, rev - pb->renumber_base,
+                          struct revmap_t);
+  revmap->rev = new_rev;
+  revmap->was_dropped = was_dropped;
+  revmap->was_seen = TRUE;
+}
+
+/* Return what the original revision REV maps to according to PB, or
+   NULL if REV was not in the input. */
+static const struct revmap_t *
+get_revmap(const struct parse_baton_t *pb,
+           svn_revnum_t rev)
+{
+  const struct revmap_t *revmap;
+
+  if (! SVN_IS_VALID_REVNUM(pb->renumber_base)
+      || rev < pb->renumber_base
+      || rev - pb->renumber_base >= pb->renumber_history->nelts)
+    return NULL;
+
+  revmap = &APR_ARRAY_IDX(pb->renumber_history, rev - pb->renumber_base,
+                          struct revmap_t);
+
+  return revmap->was_seen ? revmap : NULL;
+}
+
+
 /* Filtering vtable members */
 
 /* File-format stamp. */
@@ -394,16 +486,7 @@ output_revision(struct revision_baton_t *rb)
 
       if (rb->pb->do_renumber_revs)
         {
-          svn_revnum_t *rr_key;
-          struct revmap_t *rr_val;
-          apr_pool_t *rr_pool = apr_hash_pool_get(rb->pb->renumber_history);
-          rr_key = apr_palloc(rr_pool, sizeof(*rr_key));
-          rr_val = apr_palloc(rr_pool, sizeof(*rr_val));
-          *rr_key = rb->rev_orig;
-          rr_val->rev = rb->rev_actual;
-          rr_val->was_dropped = FALSE;
-          apr_hash_set(rb->pb->renumber_history, rr_key,
-                       sizeof(*rr_key), rr_val);
+          set_revmap(rb->pb, rb->rev_orig, rb->rev_actual, FALSE);
           rb->pb->last_live_revision = rb->rev_actual;
         }
 
@@ -417,18 +500,7 @@ output_revision(struct revision_baton_t *rb)
       /* We're dropping this revision. */
       rb->pb->rev_drop_count++;
       if (rb->pb->do_renumber_revs)
-        {
-          svn_revnum_t *rr_key;
-          struct revmap_t *rr_val;
-          apr_pool_t *rr_pool = apr_hash_pool_get(rb->pb->renumber_history);
-          rr_key = apr_palloc(rr_pool, sizeof(*rr_key));
-          rr_val = apr_palloc(rr_pool, sizeof(*rr_val));
-          *rr_key = rb->rev_orig;
-          rr_val->rev = rb->pb->last_live_revision;
-          rr_val->was_dropped = TRUE;
-          apr_hash_set(rb->pb->renumber_history, rr_key,
-                       sizeof(*rr_key), rr_val);
-        }
+        set_revmap(rb->pb, rb->rev_orig, rb->pb->last_live_revision, TRUE);
 
       if (! rb->pb->quiet)
         SVN_ERR(svn_cmdline_fprintf(stderr, subpool,
@@ -479,17 +551,18 @@ new_node_record(void **node_baton,
   if (copyfrom_path && copyfrom_path[0] != '/')
     copyfrom_path = apr_pstrcat(pool, "/", copyfrom_path, SVN_VA_NULL);
 
-  nb->do_skip = skip_path(node_path, pb->prefixes,
-                          pb->do_exclude, pb->glob);
+  nb->do_skip = skip_path(node_path, pb);
 
   /* If we're skipping the node, take note of path, discarding the
-     rest.  */
+     rest.  The paths are only needed for the final report, and only
+     once each. */
   if (nb->do_skip)
     {
-      svn_hash_sets(pb->dropped_nodes,
-                    apr_pstrdup(apr_hash_pool_get(pb->dropped_nodes),
-                                node_path),
-                    (void *)1);
+      if (! pb->quiet && ! svn_hash_gets(pb->dropped_nodes, node_path))
+        svn_hash_sets(pb->dropped_nodes,
+                      apr_pstrdup(apr_hash_pool_get(pb->dropped_nodes),
+                                  node_path),
+                      (void *)1);
       nb->rb->had_dropped_nodes = TRUE;
     }
   else
@@ -501,7 +574,7 @@ new_node_record(void **node_baton,
 
       /* Test if this node was copied from dropped source. */
       if (copyfrom_path &&
-          skip_path(copyfrom_path, pb->prefixes, pb->do_exclude, pb->glob))
+          skip_path(copyfrom_path, pb))
         {
           /* This node was copied from a dropped source.
              We have a problem, since we did not want to drop this node too.
@@ -601,12 +674,10 @@ new_node_record(void **node_baton,
               && (!strcmp(key, SVN_REPOS_DUMPFILE_NODE_COPYFROM_REV)))
             {
               svn_revnum_t cf_orig_rev;
-              struct revmap_t *cf_renum_val;
+              const struct revmap_t *cf_renum_val;
 
               cf_orig_rev = SVN_STR_TO_REV(val);
-              cf_renum_val = apr_hash_get(pb->renumber_history,
-                                          &cf_orig_rev,
-                                          sizeof(cf_orig_rev));
+              cf_renum_val = get_revmap(pb, cf_orig_rev);
               if (! (cf_renum_val && SVN_IS_VALID_REVNUM(cf_renum_val->rev)))
                 return svn_error_createf
                   (SVN_ERR_NODE_UNEXPECTED_KIND, NULL,
@@ -672,7 +743,7 @@ adjust_mergeinfo(svn_string_t **final_val, const svn_string_t *initial_val,
       struct parse_baton_t *pb = rb->pb;
 
       /* Determine whether the merge_source is a part of the prefix. */
-      if (skip_path(merge_source, pb->prefixes, pb->do_exclude, pb->glob))
+      if (skip_path(merge_source, pb))
         {
           if (pb->skip_missing_merge_sources)
             continue;
@@ -690,20 +761,18 @@ adjust_mergeinfo(svn_string_t **final_val, const svn_string_t *initial_val,
 
           for (i = 0; i < rangelist->nelts; i++)
             {
-              struct revmap_t *revmap_start;
-              struct revmap_t *revmap_end;
+              const struct revmap_t *revmap_start;
+              const struct revmap_t *revmap_end;
               svn_merge_range_t *range = APR_ARRAY_IDX(rangelist, i,
                                                        svn_merge_range_t *);
 
-              revmap_start = apr_hash_get(pb->renumber_history,
-                                          &range->start, sizeof(range->start));
+              revmap_start = get_revmap(pb, range->start);
               if (! (revmap_start && SVN_IS_VALID_REVNUM(revmap_start->rev)))
                 return svn_error_createf
                   (SVN_ERR_NODE_UNEXPECTED_KIND, NULL,
                    _("No valid revision range 'start' in filtered stream"));
 
-              revmap_end = apr_hash_get(pb->renumber_history,
-                                        &range->end, sizeof(range->end));
+              revmap_end = get_revmap(pb, range->end);
               if (! (revmap_end && SVN_IS_VALID_REVNUM(revmap_end->rev)))
                 return svn_error_createf
                   (SVN_ERR_NODE_UNEXPECTED_KIND, NULL,
@@ -1050,10 +1119,14 @@ parse_baton_initialize(struct parse_baton_t **pb,
   baton->quiet = opt_state->quiet;
   baton->glob = opt_state->glob;
   baton->prefixes = opt_state->prefixes;
+  baton->prefix_set = opt_state->glob
+                        ? NULL
+                        : prefix_set_create(opt_state->prefixes, pool);
   baton->skip_missing_merge_sources = opt_state->skip_missing_merge_sources;
   baton->rev_drop_count = 0; /* used to shift revnums while filtering */
   baton->dropped_nodes = apr_hash_make(pool);
-  baton->renumber_history = apr_hash_make(pool);
+  baton->renumber_history = apr_array_make(pool, 0, sizeof(struct revmap_t));
+  baton->renumber_base = SVN_INVALID_REVNUM;
   baton->last_live_revision = SVN_INVALID_REVNUM;
   baton->oldest_original_rev = SVN_INVALID_REVNUM;
   baton->allow_deltas = FALSE;
@@ -1188,28 +1261,17 @@ do_filter(apr_getopt_t *os,
       SVN_ERR(svn_cmdline_fputs(_("Revisions renumbered as follows:\n"),
                                 stderr, subpool));
 
-      /* Get the keys of the hash, sort them, then print the hash keys
-         and values, sorted by keys. */
-      num_keys = apr_hash_count(pb->renumber_history);
-      keys = apr_array_make(pool, num_keys + 1, sizeof(svn_revnum_t));
-      for (hi = apr_hash_first(pool, pb->renumber_history);
-           hi;
-           hi = apr_hash_next(hi))
+      /* The history is sorted by original revision already. */
+      for (i = 0; i < pb->renumber_history->nelts; i++)
         {
-          const svn_revnum_t *revnum = apr_hash_this_key(hi);
+          svn_revnum_t this_key = pb->renumber_base + i;
+          const struct revmap_t *this_val
+            = &APR_ARRAY_IDX(pb->renumber_history, i, struct revmap_t);
 
-          APR_ARRAY_PUSH(keys, svn_revnum_t) = *revnum;
-        }
-      svn_sort__array(keys, svn_sort_compare_revisions);
-      for (i = 0; i < keys->nelts; i++)
-        {
-          svn_revnum_t this_key;
-          struct revmap_t *this_val;
+          if (! this_val->was_seen)
+            continue;
 
           svn_pool_clear(subpool);
-          this_key = APR_ARRAY_IDX(keys, i, svn_revnum_t);
-          this_val = apr_hash_get(pb->renumber_history, &this_key,
-                                  sizeof(this_key));
           if (this_val->was_dropped)
             SVN_ERR(svn_cmdline_fprintf(stderr, subpool,
                                         _("   %ld => (dropped)\n"),
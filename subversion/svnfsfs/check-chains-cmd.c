@@ -0,0 +1,101 @@
+/* check-chains-cmd.c -- Report representations with long delta chains
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+#include "svn_fs.h"
+#include "svn_pools.h"
+#include "private/svn_fs_fs_private.h"
+
+#include "svn_private_config.h"
+#include "svnfsfs.h"
+
+/* Baton type to be used with report_long_chain. */
+typedef struct check_chains_baton_t
+{
+  /* Number of representations reported so far. */
+  apr_int64_t count;
+
+  /* Longest chain reported so far. */
+  int longest;
+} check_chains_baton_t;
+
+/* Implements svn_fs_fs__long_chain_func_t as printing one line for the
+ * representation to the console and updating the check_chains_baton_t
+ * in BATON.
+ */
+static svn_error_t *
+report_long_chain(void *baton,
+                  svn_revnum_t revision,
+                  const char *path,
+                  svn_boolean_t is_props,
+                  int chain_length,
+                  apr_pool_t *scratch_pool)
+{
+  check_chains_baton_t *b = baton;
+
+  printf(_("r%ld %s (%s): delta chain length %d\n"), revision, path,
+         is_props ? _("props") : _("text"), chain_length);
+
+  ++b->count;
+  if (chain_length > b->longest)
+    b->longest = chain_length;
+
+  return SVN_NO_ERROR;
+}
+
+/* This implements `svn_opt_subcommand_t'. */
+svn_error_t *
+subcommand__check_chains(apr_getopt_t *os, void *baton, apr_pool_t *pool)
+{
+  svnfsfs__opt_state *opt_state = baton;
+  check_chains_baton_t chains_baton = { 0 };
+  svn_revnum_t youngest, start, end;
+  svn_fs_t *fs;
+
+  SVN_ERR(open_fs(&fs, opt_state->repository_path, pool));
+  SVN_ERR(svn_fs_youngest_rev(&youngest, fs, pool));
+
+  /* Default to the whole repository, a single revision or the range
+   * given on the command line. */
+  SVN_ERR(get_revnum(&start, &opt_state->start_revision, 0, fs, pool));
+  SVN_ERR(get_revnum(&end, &opt_state->end_revision,
+                     opt_state->start_revision.kind
+                       == svn_opt_revision_unspecified ? youngest : start,
+                     fs, pool));
+  if (start > end)
+    return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                             _("First revision %ld must not be younger "
+                               "than the last revision %ld"),
+                             start, end);
+
+  SVN_ERR(svn_fs_fs__find_long_delta_chains(fs, start, end,
+                                            opt_state->max_chain_length,
+                                            report_long_chain, &chains_baton,
+                                            check_cancel, NULL, pool));
+
+  if (!opt_state->quiet)
+    printf(_("%" APR_INT64_T_FMT " representations with long delta chains "
+             "in r%ld:%ld, longest %d\n"),
+           chains_baton.count, start, end, chains_baton.longest);
+
+  return SVN_NO_ERROR;
+}
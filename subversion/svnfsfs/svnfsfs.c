@@ -76,7 +76,12 @@ check_lib_versions(void)
 
 enum svnfsfs__cmdline_options_t
   {
-    svnfsfs__version = SVN_OPT_FIRST_LONGOPT_ID
+    svnfsfs__version = SVN_OPT_FIRST_LONGOPT_ID,
+    svnfsfs__max_chain_length,
+    svnfsfs__jobs,
+    svnfsfs__profile,
+    svnfsfs__latest,
+    svnfsfs__snapshot
   };
 
 /* Option codes and descriptions.
@@ -104,6 +109,23 @@ static const apr_getopt_option_t options_table[] =
      N_("size of the extra in-memory cache in MB used to\n"
         "                             minimize redundant operations. Default: 16.")},
 
+    {"max-chain-length", svnfsfs__max_chain_length, 1,
+     N_("report delta chains longer than ARG.  Default:\n"
+        "                             the limit applied to new commits.")},
+
+    {"jobs",          svnfsfs__jobs, 1,
+     N_("read up to ARG shards concurrently.  Default: 1.")},
+
+    {"profile",       svnfsfs__profile, 1,
+     N_("read the paths to process from file ARG")},
+
+    {"latest",        svnfsfs__latest, 1,
+     N_("process the ARG latest changes of each path.\n"
+        "                             Default: 1.")},
+
+    {"snapshot",      svnfsfs__snapshot, 1,
+     N_("save the in-memory cache contents to file ARG")},
+
     {NULL}
   };
 
@@ -118,6 +140,17 @@ static const svn_opt_subcommand_desc2_t cmd_table[] =
     "Describe the usage of this program or its subcommands.\n"),
    {0} },
 
+  {"check-chains", subcommand__check_chains, {0}, N_
+   ("usage: svnfsfs check-chains REPOS_PATH [-r LOWER[:UPPER]]\n\n"
+    "List all representations created in the given revisions, or all revisions\n"
+    "if -r is omitted, whose delta chains are longer than the limit.  Reading\n"
+    "those requires combining a large number of deltas.  Use -r to process the\n"
+    "repository one shard at a time.\n\n"
+    "Existing representations are never modified.  Future commits will not\n"
+    "create chains longer than the configured maximum.  To shorten existing\n"
+    "chains, dump and load the repository.\n"),
+   {'r', 'q', svnfsfs__max_chain_length, 'M'} },
+
   {"dump-index", subcommand__dump_index, {0}, N_
    ("usage: svnfsfs dump-index REPOS_PATH -r REV\n\n"
     "Dump the index contents for the revision / pack file containing revision REV\n"
@@ -155,7 +188,20 @@ static const svn_opt_subcommand_desc2_t cmd_table[] =
   {"stats", subcommand__stats, {0}, N_
    ("usage: svnfsfs stats REPOS_PATH\n\n"
     "Write object size statistics to console.\n"),
-   {'M'} },
+   {'M', svnfsfs__jobs} },
+
+  {"warm", subcommand__warm, {0}, N_
+   ("usage: svnfsfs warm REPOS_PATH [PATH[@REV]...]\n\n"
+    "Read the given paths, the paths listed in the --profile file, or both, as\n"
+    "of revision REV or the -r revision (default: HEAD).  Follow each path's\n"
+    "history back through its --latest changes and read the nodes, directories,\n"
+    "properties and file contents there, including everything below them.\n\n"
+    "The profile file lists one PATH or PATH@REV per line; blank lines and lines\n"
+    "starting with '#' are ignored.\n\n"
+    "This pulls the data into the OS file cache.  Use --snapshot to also save\n"
+    "the in-memory cache for a server to load at startup.  In that case, -M\n"
+    "and the repository path should match the server's configuration.\n"),
+   {'r', 'q', 'M', svnfsfs__profile, svnfsfs__latest, svnfsfs__snapshot} },
 
   { NULL, NULL, {0}, NULL, {0} }
 };
@@ -183,6 +229,31 @@ open_fs(svn_fs_t **fs,
   return SVN_NO_ERROR;
 }
 
+/* Set *REVISION to the revision number specified by OPT_REVISION in FS,
+ * using DEFAULT_REVISION if it has not been specified at all.
+ * Use POOL for temporary allocations.
+ */
+svn_error_t *
+get_revnum(svn_revnum_t *revision,
+           const svn_opt_revision_t *opt_revision,
+           svn_revnum_t default_revision,
+           svn_fs_t *fs,
+           apr_pool_t *pool)
+{
+  if (opt_revision->kind == svn_opt_revision_unspecified)
+    *revision = default_revision;
+  else if (opt_revision->kind == svn_opt_revision_number)
+    *revision = opt_revision->value.number;
+  else if (opt_revision->kind == svn_opt_revision_head)
+    SVN_ERR(svn_fs_youngest_rev(revision, fs, pool));
+  else
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                            _("Only revision numbers and HEAD are "
+                              "supported"));
+
+  return SVN_NO_ERROR;
+}
+
 /* This implements `svn_opt_subcommand_t'. */
 svn_error_t *
 subcommand__help(apr_getopt_t *os, void *baton, apr_pool_t *pool)
@@ -247,6 +318,8 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   opt_state.start_revision.kind = svn_opt_revision_unspecified;
   opt_state.end_revision.kind = svn_opt_revision_unspecified;
   opt_state.memory_cache_size = svn_cache_config_get()->cache_size;
+  opt_state.jobs = 1;
+  opt_state.latest = 1;
 
   /* Parse options. */
   SVN_ERR(svn_cmdline__getopt_init(&os, argc, argv, pool));
@@ -307,6 +380,47 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       case svnfsfs__version:
         opt_state.version = TRUE;
         break;
+      case svnfsfs__max_chain_length:
+        {
+          apr_int64_t value;
+          SVN_ERR(svn_cstring_atoi64(&value, opt_arg));
+          if (value < 1 || value > APR_INT32_MAX)
+            return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                     _("Invalid maximum chain length '%s'"),
+                                     opt_arg);
+          opt_state.max_chain_length = (int)value;
+        }
+        break;
+      case svnfsfs__jobs:
+        {
+          apr_int64_t value;
+          SVN_ERR(svn_cstring_atoi64(&value, opt_arg));
+          if (value < 1 || value > APR_INT32_MAX)
+            return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                     _("Invalid number of jobs '%s'"),
+                                     opt_arg);
+          opt_state.jobs = (int)value;
+        }
+        break;
+      case svnfsfs__profile:
+        SVN_ERR(svn_utf_cstring_to_utf8(&utf8_opt_arg, opt_arg, pool));
+        opt_state.profile = svn_dirent_internal_style(utf8_opt_arg, pool);
+        break;
+      case svnfsfs__latest:
+        {
+          apr_int64_t value;
+          SVN_ERR(svn_cstring_atoi64(&value, opt_arg));
+          if (value < 1 || value > APR_INT32_MAX)
+            return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                     _("Invalid number of changes '%s'"),
+                                     opt_arg);
+          opt_state.latest = (int)value;
+        }
+        break;
+      case svnfsfs__snapshot:
+        SVN_ERR(svn_utf_cstring_to_utf8(&utf8_opt_arg, opt_arg, pool));
+        opt_state.snapshot = svn_dirent_internal_style(utf8_opt_arg, pool);
+        break;
       default:
         {
           SVN_ERR(subcommand__help(NULL, NULL, pool));
@@ -45,14 +45,21 @@ typedef struct svnfsfs__opt_state
   svn_boolean_t version;                            /* --version */
   svn_boolean_t quiet;                              /* --quiet */
   apr_uint64_t memory_cache_size;                   /* --memory-cache-size M */
+  int max_chain_length;                             /* --max-chain-length */
+  int jobs;                                         /* --jobs */
+  const char *profile;                              /* --profile */
+  int latest;                                       /* --latest */
+  const char *snapshot;                             /* --snapshot */
 } svnfsfs__opt_state;
 
 /* Declare all the command procedures */
 svn_opt_subcommand_t
   subcommand__help,
+  subcommand__check_chains,
   subcommand__dump_index,
   subcommand__load_index,
-  subcommand__stats;
+  subcommand__stats,
+  subcommand__warm;
 
 
 /* Check that the filesystem at PATH is an FSFS repository and then open it.
@@ -62,6 +69,16 @@ open_fs(svn_fs_t **fs,
         const char *path,
         apr_pool_t *pool);
 
+/* Set *REVISION to the revision number specified by OPT_REVISION in FS,
+ * using DEFAULT_REVISION if it has not been specified at all.
+ * Use POOL for temporary allocations. */
+svn_error_t *
+get_revnum(svn_revnum_t *revision,
+           const svn_opt_revision_t *opt_revision,
+           svn_revnum_t default_revision,
+           svn_fs_t *fs,
+           apr_pool_t *pool);
+
 /* Our cancellation callback. */
 extern svn_cancel_func_t check_cancel;
 
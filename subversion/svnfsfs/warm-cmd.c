@@ -0,0 +1,303 @@
+/* warm-cmd.c -- Pre-populate caches with the data of hot paths
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include "svn_dirent_uri.h"
+#include "svn_fs.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+#include "svn_sorts.h"
+#include "svn_string.h"
+
+#include "private/svn_cache.h"
+#include "private/svn_fspath.h"
+#include "private/svn_sorts_private.h"
+
+#include "svn_private_config.h"
+#include "svnfsfs.h"
+
+/* Baton type used while warming the caches. */
+typedef struct warm_baton_t
+{
+  /* The repository being read. */
+  svn_fs_t *fs;
+
+  /* Number of most recent changes to read per path. */
+  int latest;
+
+  /* Number of nodes and directories read and of profile entries that
+   * could not be found. */
+  apr_int64_t node_count;
+  apr_int64_t dir_count;
+  apr_int64_t missing_count;
+
+  /* Total size of the file contents read, in bytes. */
+  svn_filesize_t text_size;
+} warm_baton_t;
+
+/* Read the node at PATH in ROOT, its properties and contents.  Descend
+ * into sub-directories.  Update the counters in BATON.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+warm_node(warm_baton_t *baton,
+          svn_fs_root_t *root,
+          const char *path,
+          svn_node_kind_t kind,
+          apr_pool_t *scratch_pool)
+{
+  apr_hash_t *props;
+
+  SVN_ERR(check_cancel(NULL));
+  SVN_ERR(svn_fs_node_proplist(&props, root, path, scratch_pool));
+  ++baton->node_count;
+
+  if (kind == svn_node_dir)
+    {
+      apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+      apr_hash_t *entries;
+      apr_array_header_t *sorted;
+      int i;
+
+      SVN_ERR(svn_fs_dir_entries(&entries, root, path, scratch_pool));
+      ++baton->dir_count;
+
+      /* Process the entries in a repeatable order. */
+      sorted = svn_sort__hash(entries, svn_sort_compare_items_lexically,
+                              scratch_pool);
+      for (i = 0; i < sorted->nelts; ++i)
+        {
+          svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i,
+                                                  svn_sort__item_t);
+          svn_fs_dirent_t *dirent = item->value;
+
+          svn_pool_clear(iterpool);
+          SVN_ERR(warm_node(baton, root,
+                            svn_fspath__join(path, dirent->name, iterpool),
+                            dirent->kind, iterpool));
+        }
+
+      svn_pool_destroy(iterpool);
+    }
+  else
+    {
+      svn_stream_t *contents;
+      svn_filesize_t length;
+
+      /* Reading the whole text pulls all delta windows through the
+       * caches and the rev / pack file blocks into the page cache. */
+      SVN_ERR(svn_fs_file_contents(&contents, root, path, scratch_pool));
+      SVN_ERR(svn_stream_copy3(contents, svn_stream_empty(scratch_pool),
+                               check_cancel, NULL, scratch_pool));
+      SVN_ERR(svn_fs_file_length(&length, root, path, scratch_pool));
+      baton->text_size += length;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the BATON->LATEST most recent versions of PATH as of REVISION
+ * and everything below them.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+warm_path(warm_baton_t *baton,
+          const char *path,
+          svn_revnum_t revision,
+          apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_fs_root_t *root;
+  svn_fs_history_t *history;
+  svn_node_kind_t kind;
+  int i;
+
+  SVN_ERR(svn_fs_revision_root(&root, baton->fs, revision, scratch_pool));
+  SVN_ERR(svn_fs_check_path(&kind, root, path, scratch_pool));
+
+  /* Profiles may list paths that got deleted in the meantime. */
+  if (kind == svn_node_none)
+    {
+      ++baton->missing_count;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_fs_node_history2(&history, root, path, scratch_pool,
+                               scratch_pool));
+  for (i = 0; i < baton->latest; ++i)
+    {
+      const char *history_path;
+      svn_revnum_t history_rev;
+      svn_fs_root_t *history_root;
+
+      svn_pool_clear(iterpool);
+
+      /* The history objects must survive this iteration. */
+      SVN_ERR(svn_fs_history_prev2(&history, history, TRUE, scratch_pool,
+                                   iterpool));
+      if (history == NULL)
+        break;
+
+      SVN_ERR(svn_fs_history_location(&history_path, &history_rev, history,
+                                      iterpool));
+      SVN_ERR(svn_fs_revision_root(&history_root, baton->fs, history_rev,
+                                   iterpool));
+      SVN_ERR(svn_fs_check_path(&kind, history_root, history_path,
+                                iterpool));
+      SVN_ERR(warm_node(baton, history_root, history_path, kind, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Split the profile ENTRY of the form PATH[@REV] into *PATH and *REVISION,
+ * using DEFAULT_REVISION if no revision has been given.  Allocate *PATH in
+ * RESULT_POOL.
+ */
+static svn_error_t *
+parse_entry(const char **path,
+            svn_revnum_t *revision,
+            const char *entry,
+            svn_revnum_t default_revision,
+            apr_pool_t *result_pool)
+{
+  const char *at = strrchr(entry, '@');
+
+  *revision = default_revision;
+  if (at)
+    {
+      if (strcmp(at + 1, "HEAD") != 0)
+        {
+          apr_int64_t value;
+          svn_error_t *err = svn_cstring_atoi64(&value, at + 1);
+          if (err || value < 0 || value > default_revision)
+            return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, err,
+                                     _("Invalid revision in '%s'"), entry);
+
+          *revision = (svn_revnum_t)value;
+        }
+
+      entry = apr_pstrmemdup(result_pool, entry, at - entry);
+    }
+
+  *path = svn_fspath__canonicalize(entry, result_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Append all entries of the profile file at PROFILE_PATH to ENTRIES.
+ * Allocate them in RESULT_POOL and use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+read_profile(apr_array_header_t *entries,
+             const char *profile_path,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *contents;
+  apr_array_header_t *lines;
+  int i;
+
+  SVN_ERR(svn_stringbuf_from_file2(&contents, profile_path, scratch_pool));
+  lines = svn_cstring_split(contents->data, "\r\n", TRUE, result_pool);
+
+  /* Skip comments. */
+  for (i = 0; i < lines->nelts; ++i)
+    {
+      const char *line = APR_ARRAY_IDX(lines, i, const char *);
+      if (*line != '#')
+        APR_ARRAY_PUSH(entries, const char *) = line;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* This implements `svn_opt_subcommand_t'. */
+svn_error_t *
+subcommand__warm(apr_getopt_t *os, void *baton, apr_pool_t *pool)
+{
+  svnfsfs__opt_state *opt_state = baton;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  warm_baton_t warm_baton = { 0 };
+  apr_array_header_t *entries;
+  const char *repos_path;
+  svn_revnum_t youngest, revision;
+  int i;
+
+  SVN_ERR(svn_opt_parse_all_args(&entries, os, pool));
+  if (opt_state->profile)
+    SVN_ERR(read_profile(entries, opt_state->profile, pool, pool));
+  if (entries->nelts == 0)
+    return svn_error_create(SVN_ERR_CL_INSUFFICIENT_ARGS, NULL,
+                            _("No paths to warm up given"));
+
+  /* Cache keys contain the repository path.  Use the same absolute path
+   * that the server will use. */
+  SVN_ERR(svn_dirent_get_absolute(&repos_path, opt_state->repository_path,
+                                  pool));
+  SVN_ERR(open_fs(&warm_baton.fs, repos_path, pool));
+  SVN_ERR(svn_fs_youngest_rev(&youngest, warm_baton.fs, pool));
+  SVN_ERR(get_revnum(&revision, &opt_state->start_revision, youngest,
+                     warm_baton.fs, pool));
+  if (revision > youngest)
+    return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                             _("Revision %ld does not exist"), revision);
+
+  warm_baton.latest = opt_state->latest;
+
+  for (i = 0; i < entries->nelts; ++i)
+    {
+      const char *path;
+      svn_revnum_t path_revision;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(parse_entry(&path, &path_revision,
+                          APR_ARRAY_IDX(entries, i, const char *),
+                          revision, iterpool));
+      SVN_ERR(warm_path(&warm_baton, path, path_revision, iterpool));
+
+      if (!opt_state->quiet)
+        {
+          printf(_("Warmed up %s@%ld\n"), path, path_revision);
+          fflush(stdout);
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  /* Hand the cache contents over to the server. */
+  if (opt_state->snapshot)
+    SVN_ERR(svn_cache__save_global_membuffer_cache(opt_state->snapshot,
+                                                   pool));
+
+  if (!opt_state->quiet)
+    printf(_("Read %" APR_INT64_T_FMT " nodes, %" APR_INT64_T_FMT
+             " directories and %" SVN_FILESIZE_T_FMT " bytes of file "
+             "contents; %" APR_INT64_T_FMT " paths not found\n"),
+           warm_baton.node_count, warm_baton.dir_count,
+           warm_baton.text_size, warm_baton.missing_count);
+
+  return SVN_NO_ERROR;
+}
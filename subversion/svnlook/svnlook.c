@@ -200,7 +200,9 @@ static const apr_getopt_option_t options_table[] =
       "                             "
       "  -U ARG, --context ARG: Show ARG lines of context\n"
       "                             "
-      "  -p, --show-c-function: Show C function name")},
+      "  -p, --show-c-function: Show C function name\n"
+      "                             "
+      "  --histogram: Use the histogram diff algorithm")},
 
   {"quiet",             'q', 0,
    N_("no progress (only errors) to stderr")},
@@ -485,146 +487,117 @@ generate_delta_tree(svn_repos_node_t **tree,
 
 /*** Tree Printing Routines ***/
 
-/* Recursively print only directory nodes that either a) have property
-   mods, or b) contains files that have changed, or c) has added or deleted
-   children.  NODE is the root node of the tree delta, so every node in it
-   is either changed or is a directory with a changed node somewhere in the
-   subtree below it.
- */
+/* Print the 'svnlook changed' line with STATUS for the node at PATH
+   (UTF-8, without leading slash) of KIND.  If COPYFROM_PATH is not NULL,
+   also print that copy source and COPYFROM_REV. */
 static svn_error_t *
-print_dirs_changed_tree(svn_repos_node_t *node,
-                        const char *path /* UTF-8! */,
-                        apr_pool_t *pool)
+print_changed_line(const char *status,
+                   const char *path,
+                   svn_node_kind_t kind,
+                   const char *copyfrom_path,
+                   svn_revnum_t copyfrom_rev,
+                   apr_pool_t *pool)
 {
-  svn_repos_node_t *tmp_node;
-  svn_boolean_t print_me = FALSE;
-  const char *full_path;
-  apr_pool_t *iterpool;
-
-  SVN_ERR(check_cancel(NULL));
-
-  if (! node)
-    return SVN_NO_ERROR;
-
-  /* Not a directory?  We're not interested. */
-  if (node->kind != svn_node_dir)
-    return SVN_NO_ERROR;
-
-  /* Got prop mods?  Excellent. */
-  if (node->prop_mod)
-    print_me = TRUE;
-
-  /* Fly through the list of children, checking for modified files. */
-  tmp_node = node->child;
-  while (tmp_node && (! print_me))
-    {
-      if ((tmp_node->kind == svn_node_file)
-           || (tmp_node->action == 'A')
-           || (tmp_node->action == 'D'))
-        {
-          print_me = TRUE;
-        }
-      tmp_node = tmp_node->sibling;
-    }
-
-  /* Print the node if it qualifies. */
-  if (print_me)
-    {
-      SVN_ERR(svn_cmdline_printf(pool, "%s/\n", path));
-    }
-
-  /* Return here if the node has no children. */
-  tmp_node = node->child;
-  if (! tmp_node)
-    return SVN_NO_ERROR;
-
-  /* Recursively handle the node's children. */
-  iterpool = svn_pool_create(pool);
-  while (tmp_node)
-    {
-      svn_pool_clear(iterpool);
-      full_path = svn_dirent_join(path, tmp_node->name, iterpool);
-      SVN_ERR(print_dirs_changed_tree(tmp_node, full_path, iterpool));
-      tmp_node = tmp_node->sibling;
-    }
-  svn_pool_destroy(iterpool);
+  SVN_ERR(svn_cmdline_printf(pool, "%s %s%s\n",
+                             status,
+                             path,
+                             kind == svn_node_dir ? "/" : ""));
+  if (copyfrom_path)
+    /* Remove the leading slash from the copyfrom path for consistency
+       with the rest of the output. */
+    SVN_ERR(svn_cmdline_printf(pool, "    (from %s%s:r%ld)\n",
+                               (copyfrom_path[0] == '/'
+                                ? copyfrom_path + 1
+                                : copyfrom_path),
+                               (kind == svn_node_dir ? "/" : ""),
+                               copyfrom_rev));
 
   return SVN_NO_ERROR;
 }
 
-
-/* Recursively print all nodes in the tree that have been modified
-   (do not include directories affected only by "bubble-up"). */
+/* Print CHANGE, as reported for ROOT, unless it has only been affected
+   by "bubble-up".  Deleted nodes are looked up in BASE_ROOT.  If
+   COPY_INFO is set, show copy sources as well.  Use POOL for
+   temporary allocations. */
 static svn_error_t *
-print_changed_tree(svn_repos_node_t *node,
-                   const char *path /* UTF-8! */,
-                   svn_boolean_t copy_info,
-                   apr_pool_t *pool)
+print_change(svn_fs_path_change3_t *change,
+             svn_fs_root_t *root,
+             svn_fs_root_t *base_root,
+             svn_boolean_t copy_info,
+             apr_pool_t *pool)
 {
-  const char *full_path;
-  char status[4] = "_  ";
-  svn_boolean_t print_me = TRUE;
-  apr_pool_t *iterpool;
+  const char *fspath = change->path.data;
+  const char *path = fspath[0] == '/' ? fspath + 1 : fspath;
+  svn_node_kind_t kind = change->node_kind;
 
-  SVN_ERR(check_cancel(NULL));
+  switch (change->change_kind)
+    {
+      case svn_fs_path_change_delete:
+      case svn_fs_path_change_replace:
+        {
+          /* The change's node kind describes the node that replaced
+             the deleted one, if any. */
+          svn_node_kind_t deleted_kind = kind;
+          if (   deleted_kind == svn_node_unknown
+              || change->change_kind == svn_fs_path_change_replace)
+            SVN_ERR(svn_fs_check_path(&deleted_kind, base_root, fspath,
+                                      pool));
+
+          SVN_ERR(print_changed_line("D  ", path, deleted_kind, NULL,
+                                     SVN_INVALID_REVNUM, pool));
+          if (change->change_kind == svn_fs_path_change_delete)
+            break;
+        }
+        /* Fall through to the addition part of the replacement. */
 
-  if (! node)
-    return SVN_NO_ERROR;
+      case svn_fs_path_change_add:
+        {
+          const char *copyfrom_path = NULL;
+          svn_revnum_t copyfrom_rev = SVN_INVALID_REVNUM;
 
-  /* Print the node. */
-  if (node->action == 'A')
-    {
-      status[0] = 'A';
-      if (copy_info && node->copyfrom_path)
-        status[2] = '+';
-    }
-  else if (node->action == 'D')
-    status[0] = 'D';
-  else if (node->action == 'R')
-    {
-      if ((! node->text_mod) && (! node->prop_mod))
-        print_me = FALSE;
-      if (node->text_mod)
-        status[0] = 'U';
-      if (node->prop_mod)
-        status[1] = 'U';
-    }
-  else
-    print_me = FALSE;
+          if (kind == svn_node_unknown)
+            SVN_ERR(svn_fs_check_path(&kind, root, fspath, pool));
 
-  /* Print this node unless told to skip it. */
-  if (print_me)
-    {
-      SVN_ERR(svn_cmdline_printf(pool, "%s %s%s\n",
-                                 status,
-                                 path,
-                                 node->kind == svn_node_dir ? "/" : ""));
-      if (copy_info && node->copyfrom_path)
-        /* Remove the leading slash from the copyfrom path for consistency
-           with the rest of the output. */
-        SVN_ERR(svn_cmdline_printf(pool, "    (from %s%s:r%ld)\n",
-                                   (node->copyfrom_path[0] == '/'
-                                    ? node->copyfrom_path + 1
-                                    : node->copyfrom_path),
-                                   (node->kind == svn_node_dir ? "/" : ""),
-                                   node->copyfrom_rev));
-    }
+          if (copy_info)
+            {
+              if (change->copyfrom_known)
+                {
+                  copyfrom_path = change->copyfrom_path;
+                  copyfrom_rev = change->copyfrom_rev;
+                }
+              else
+                {
+                  SVN_ERR(svn_fs_copied_from(&copyfrom_rev, &copyfrom_path,
+                                             root, fspath, pool));
+                }
+            }
 
-  /* Return here if the node has no children. */
-  node = node->child;
-  if (! node)
-    return SVN_NO_ERROR;
+          SVN_ERR(print_changed_line(copyfrom_path ? "A +" : "A  ", path,
+                                     kind, copyfrom_path, copyfrom_rev,
+                                     pool));
+        }
+        break;
 
-  /* Recursively handle the node's children. */
-  iterpool = svn_pool_create(pool);
-  while (node)
-    {
-      svn_pool_clear(iterpool);
-      full_path = svn_dirent_join(path, node->name, iterpool);
-      SVN_ERR(print_changed_tree(node, full_path, copy_info, iterpool));
-      node = node->sibling;
+      case svn_fs_path_change_modify:
+        {
+          char status[4] = "_  ";
+          if (kind == svn_node_unknown)
+            SVN_ERR(svn_fs_check_path(&kind, root, fspath, pool));
+
+          if (change->text_mod && kind == svn_node_file)
+            status[0] = 'U';
+          if (change->prop_mod)
+            status[1] = 'U';
+
+          if (status[0] == 'U' || status[1] == 'U')
+            SVN_ERR(print_changed_line(status, path, kind, NULL,
+                                       SVN_INVALID_REVNUM, pool));
+        }
+        break;
+
+      default:
+        break;
     }
-  svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
 }
@@ -1366,22 +1339,87 @@ do_author(svnlook_ctxt_t *c, apr_pool_t *pool)
 
 
 /* Print a list of all directories in which files, or directory
-   properties, have been modified. */
+   properties, have been modified.  That is, directories that a) have
+   property mods, or b) contain files that have changed, or c) have
+   added or deleted children.
+
+   Like 'svnlook changed', this works from the changed paths list
+   instead of replaying the whole revision into a delta tree. */
 static svn_error_t *
 do_dirs_changed(svnlook_ctxt_t *c, apr_pool_t *pool)
 {
   svn_fs_root_t *root;
   svn_revnum_t base_rev_id;
-  svn_repos_node_t *tree;
+  svn_fs_path_change_iterator_t *iterator;
+  svn_fs_path_change3_t *change;
+  apr_hash_t *dirs = apr_hash_make(pool);
+  apr_array_header_t *sorted_dirs;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
 
   SVN_ERR(get_root(&root, c, pool));
   SVN_ERR(get_base_rev(&base_rev_id, c, pool));
   if (base_rev_id == SVN_INVALID_REVNUM)
     return SVN_NO_ERROR;
 
-  SVN_ERR(generate_delta_tree(&tree, c->repos, root, base_rev_id, pool));
-  if (tree)
-    SVN_ERR(print_dirs_changed_tree(tree, "", pool));
+  SVN_ERR(svn_fs_paths_changed3(&iterator, root, pool, pool));
+  SVN_ERR(svn_fs_path_change_get(&change, iterator));
+  while (change)
+    {
+      const char *fspath = change->path.data;
+      svn_node_kind_t kind = change->node_kind;
+      svn_boolean_t parent_changed = FALSE;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(check_cancel(NULL));
+
+      if (change->change_kind == svn_fs_path_change_modify)
+        {
+          /* Changes that merely "bubble up" don't count. */
+          if (change->text_mod || change->prop_mod)
+            {
+              if (kind == svn_node_unknown)
+                SVN_ERR(svn_fs_check_path(&kind, root, fspath, iterpool));
+              parent_changed = (kind == svn_node_file);
+            }
+        }
+      else
+        {
+          /* Additions, deletions and replacements of any kind. */
+          parent_changed = TRUE;
+          if (kind == svn_node_unknown
+              && change->change_kind != svn_fs_path_change_delete
+              && change->prop_mod)
+            SVN_ERR(svn_fs_check_path(&kind, root, fspath, iterpool));
+        }
+
+      if (change->prop_mod && kind == svn_node_dir
+          && change->change_kind != svn_fs_path_change_delete)
+        svn_hash_sets(dirs, apr_pstrdup(pool, fspath), "");
+
+      if (parent_changed && !svn_fspath__is_root(fspath, strlen(fspath)))
+        svn_hash_sets(dirs, svn_fspath__dirname(fspath, pool), "");
+
+      SVN_ERR(svn_fs_path_change_get(&change, iterator));
+    }
+
+  /* Print parents before their children, like a depth-first walk of
+     the changed tree would. */
+  sorted_dirs = svn_sort__hash(dirs, svn_sort_compare_items_as_paths, pool);
+  for (i = 0; i < sorted_dirs->nelts; i++)
+    {
+      const char *fspath = APR_ARRAY_IDX(sorted_dirs, i,
+                                         svn_sort__item_t).key;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(check_cancel(NULL));
+
+      /* Same as 'svnlook changed', the paths come without a leading
+         slash, but with a trailing one. */
+      SVN_ERR(svn_cmdline_printf(iterpool, "%s/\n", fspath + 1));
+    }
+
+  svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
 }
@@ -1468,18 +1506,36 @@ do_cat(svnlook_ctxt_t *c, const char *path, apr_pool_t *pool)
 static svn_error_t *
 do_changed(svnlook_ctxt_t *c, apr_pool_t *pool)
 {
-  svn_fs_root_t *root;
+  svn_fs_root_t *root, *base_root;
   svn_revnum_t base_rev_id;
-  svn_repos_node_t *tree;
+  svn_fs_path_change_iterator_t *iterator;
+  svn_fs_path_change3_t *change;
+  apr_pool_t *iterpool = svn_pool_create(pool);
 
   SVN_ERR(get_root(&root, c, pool));
   SVN_ERR(get_base_rev(&base_rev_id, c, pool));
   if (base_rev_id == SVN_INVALID_REVNUM)
     return SVN_NO_ERROR;
 
-  SVN_ERR(generate_delta_tree(&tree, c->repos, root, base_rev_id, pool));
-  if (tree)
-    SVN_ERR(print_changed_tree(tree, "", c->copy_info, pool));
+  SVN_ERR(svn_fs_revision_root(&base_root, c->fs, base_rev_id, pool));
+
+  /* Stream the changes straight from the filesystem, in the order it
+     reports them, instead of building a delta tree of the whole
+     revision.  That keeps the memory usage independent of the size of
+     the change. */
+  SVN_ERR(svn_fs_paths_changed3(&iterator, root, pool, pool));
+  SVN_ERR(svn_fs_path_change_get(&change, iterator));
+  while (change)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(check_cancel(NULL));
+
+      SVN_ERR(print_change(change, root, base_root, c->copy_info,
+                           iterpool));
+      SVN_ERR(svn_fs_path_change_get(&change, iterator));
+    }
+
+  svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
 }
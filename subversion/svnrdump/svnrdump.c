@@ -23,6 +23,7 @@
  */
 
 #include <apr_uri.h>
+#include <apr_thread_proc.h>
 
 #include "svn_pools.h"
 #include "svn_cmdline.h"
@@ -41,6 +42,7 @@
 #include "private/svn_repos_private.h"
 #include "private/svn_cmdline_private.h"
 #include "private/svn_ra_private.h"
+#include "private/svn_atomic.h"
 
 
 
@@ -64,6 +66,7 @@ enum svn_svnrdump__longopt_t
     opt_skip_revprop,
     opt_force_interactive,
     opt_incremental,
+    opt_jobs,
     opt_trust_server_cert,
     opt_trust_server_cert_failures,
     opt_version
@@ -85,8 +88,12 @@ static const svn_opt_subcommand_desc2_t svnrdump__cmd_table[] =
     N_("usage: svnrdump dump URL [-r LOWER[:UPPER]]\n\n"
        "Dump revisions LOWER to UPPER of repository at remote URL to stdout\n"
        "in a 'dumpfile' portable format.  If only LOWER is given, dump that\n"
-       "one revision.\n"),
-    { 'r', 'q', opt_incremental, SVN_SVNRDUMP__BASE_OPTIONS } },
+       "one revision.\n"
+       "\n"
+       "If --jobs ARG is given with ARG > 1, the revisions get split into up\n"
+       "to ARG ranges which are fetched concurrently over separate sessions\n"
+       "and written out in order.  The output is the same as without --jobs.\n"),
+    { 'r', 'q', opt_incremental, opt_jobs, SVN_SVNRDUMP__BASE_OPTIONS } },
   { "load", load_cmd, { 0 },
     N_("usage: svnrdump load URL\n\n"
        "Load a 'dumpfile' given on stdin to a repository at remote URL.\n"),
@@ -106,6 +113,10 @@ static const apr_getopt_option_t svnrdump__options[] =
                       N_("no progress (only errors) to stderr")},
     {"incremental",   opt_incremental, 0,
                       N_("dump incrementally")},
+    {"jobs",          opt_jobs, 1,
+                      N_("fetch up to ARG revision ranges concurrently\n"
+                         "                             "
+                         "[default: 1]")},
     {"skip-revprop",  opt_skip_revprop, 1,
                       N_("skip revision property ARG (e.g., \"svn:author\")")},
     {"config-dir",    opt_config_dir, 1,
@@ -167,6 +178,10 @@ struct replay_baton {
 
   /* Whether to be quiet. */
   svn_boolean_t quiet;
+
+  /* Cancellation callback for the dump editors. */
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
 };
 
 /* Option set */
@@ -180,6 +195,7 @@ typedef struct opt_baton_t {
   svn_opt_revision_t end_revision;
   svn_boolean_t quiet;
   svn_boolean_t incremental;
+  int jobs;
   apr_hash_t *skip_revprops;
 } opt_baton_t;
 
@@ -206,7 +222,8 @@ replay_revstart(svn_revnum_t revision,
 
   SVN_ERR(svn_rdump__get_dump_editor(editor, edit_baton, revision,
                                      rb->stdout_stream, rb->extra_ra_session,
-                                     NULL, check_cancel, NULL, pool));
+                                     NULL, rb->cancel_func, rb->cancel_baton,
+                                     pool));
 
   return SVN_NO_ERROR;
 }
@@ -450,11 +467,221 @@ dump_initial_full_revision(svn_ra_session_t *session,
   return SVN_NO_ERROR;
 }
 
+#if APR_HAS_THREADS && !defined(USE_EV2_IMPL)
+/* A range of revisions that gets replayed on a separate thread into a
+ * temporary file, to be appended to the dump once the revisions before
+ * it have been written.
+ */
+typedef struct dump_segment_t
+{
+  svn_revnum_t start_revision;
+  svn_revnum_t end_revision;
+
+  /* Sessions used by this segment only, like in replay_revisions(). */
+  svn_ra_session_t *session;
+  svn_ra_session_t *extra_ra_session;
+
+  /* The temporary file receiving the dump of the segment. */
+  apr_file_t *file;
+
+  /* Set when the segment is no longer needed. */
+  volatile svn_atomic_t *stop;
+
+  /* The thread replaying the segment, or NULL if it couldn't be started. */
+  apr_thread_t *thread;
+
+  /* How the replay ended. */
+  svn_error_t *err;
+
+  /* Root pool owning everything above.  Used by THREAD only while it
+     is running. */
+  apr_pool_t *pool;
+} dump_segment_t;
+
+/* Cancellation callback for segments.  BATON is the stop flag. */
+static svn_error_t *
+segment_cancel(void *baton)
+{
+  volatile svn_atomic_t *stop = baton;
+
+  if (svn_atomic_read(stop))
+    return svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+
+  return check_cancel ? svn_error_trace(check_cancel(NULL)) : SVN_NO_ERROR;
+}
+
+/* Replay the revisions of SEGMENT into its temporary file. */
+static void
+dump_segment(dump_segment_t *segment)
+{
+  struct replay_baton *rb = apr_pcalloc(segment->pool, sizeof(*rb));
+
+  rb->stdout_stream = svn_stream_from_aprfile2(segment->file, TRUE,
+                                               segment->pool);
+  rb->extra_ra_session = segment->extra_ra_session;
+  rb->quiet = TRUE;
+  rb->cancel_func = segment_cancel;
+  rb->cancel_baton = (void *)segment->stop;
+
+  segment->err = svn_ra_replay_range(segment->session,
+                                     segment->start_revision,
+                                     segment->end_revision,
+                                     0, TRUE, replay_revstart, replay_revend,
+                                     rb, segment->pool);
+  if (! segment->err)
+    segment->err = svn_stream_close(rb->stdout_stream);
+}
+
+/* Thread function.  DATA is the dump_segment_t to replay. */
+static void * APR_THREAD_FUNC
+dump_segment_thread(apr_thread_t *tid,
+                    void *data)
+{
+  dump_segment(data);
+
+  return NULL;
+}
+
+/* Copy the dump of SEGMENT to the output of RB and report progress. */
+static svn_error_t *
+append_segment(struct replay_baton *rb,
+               dump_segment_t *segment,
+               apr_pool_t *pool)
+{
+  apr_off_t offset = 0;
+  svn_revnum_t revision;
+
+  SVN_ERR(svn_io_file_seek(segment->file, APR_SET, &offset, pool));
+  SVN_ERR(svn_stream_copy3(svn_stream_from_aprfile2(segment->file, TRUE,
+                                                    pool),
+                           svn_stream_disown(rb->stdout_stream, pool),
+                           check_cancel, NULL, pool));
+
+  if (! rb->quiet)
+    for (revision = segment->start_revision;
+         revision <= segment->end_revision;
+         revision++)
+      SVN_ERR(svn_cmdline_fprintf(stderr, pool, "* Dumped revision %lu.\n",
+                                  revision));
+
+  return SVN_NO_ERROR;
+}
+
+/* Like svn_ra_replay_range() with the replay_revstart() and replay_revend()
+ * callbacks and RB, but split the revisions into up to JOBS ranges.  The
+ * first range is replayed over SESSION and directly written out, while the
+ * others are replayed concurrently over new sessions opened through CTX
+ * into temporary files, which are then appended in order.
+ */
+static svn_error_t *
+replay_segments(svn_ra_session_t *session,
+                svn_revnum_t start_revision,
+                svn_revnum_t end_revision,
+                struct replay_baton *rb,
+                svn_client_ctx_t *ctx,
+                int jobs,
+                apr_pool_t *pool)
+{
+  volatile svn_atomic_t stop = FALSE;
+  apr_array_header_t *segments;
+  svn_revnum_t count = end_revision - start_revision + 1;
+  svn_revnum_t first_end;
+  const char *url;
+  const char *repos_root;
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  if (jobs > count)
+    jobs = (int)count;
+
+  SVN_ERR(svn_ra_get_session_url(session, &url, pool));
+  SVN_ERR(svn_ra_get_repos_root2(session, &repos_root, pool));
+
+  /* Revisions of the first range, the one we replay ourselves. */
+  first_end = start_revision + count / jobs - 1;
+
+  segments = apr_array_make(pool, jobs, sizeof(dump_segment_t *));
+  for (i = 1; i < jobs && !err; i++)
+    {
+      apr_pool_t *segment_pool = svn_pool_create(NULL);
+      dump_segment_t *segment = apr_pcalloc(segment_pool, sizeof(*segment));
+      apr_status_t status;
+
+      segment->start_revision = start_revision + count * i / jobs;
+      segment->end_revision = start_revision + count * (i + 1) / jobs - 1;
+      segment->stop = &stop;
+      segment->pool = segment_pool;
+      APR_ARRAY_PUSH(segments, dump_segment_t *) = segment;
+
+      /* Open the sessions here; the threads may share nothing but CTX. */
+      err = svn_client_open_ra_session2(&segment->session, url, NULL, ctx,
+                                        segment_pool, segment_pool);
+      if (!err)
+        err = svn_client_open_ra_session2(&segment->extra_ra_session,
+                                          repos_root, NULL, ctx,
+                                          segment_pool, segment_pool);
+      if (!err)
+        err = svn_io_open_unique_file3(&segment->file, NULL, NULL,
+                                       svn_io_file_del_on_pool_cleanup,
+                                       segment_pool, segment_pool);
+      if (err)
+        break;
+
+      /* If we can't start a thread, the segment gets replayed in turn
+         below. */
+      status = apr_thread_create(&segment->thread, NULL,
+                                 dump_segment_thread, segment,
+                                 segment_pool);
+      if (status)
+        segment->thread = NULL;
+    }
+
+  if (!err)
+    err = svn_ra_replay_range(session, start_revision, first_end,
+                              0, TRUE, replay_revstart, replay_revend,
+                              rb, pool);
+
+  for (i = 0; i < segments->nelts; i++)
+    {
+      dump_segment_t *segment = APR_ARRAY_IDX(segments, i, dump_segment_t *);
+
+      /* Let the remaining segments stop early after a failure. */
+      if (err)
+        svn_atomic_set(&stop, TRUE);
+
+      if (segment->thread)
+        {
+          apr_status_t retval;
+
+          apr_thread_join(&retval, segment->thread);
+        }
+      else if (!err && segment->file)
+        dump_segment(segment);
+
+      if (!err)
+        err = segment->err;
+      else
+        svn_error_clear(segment->err);
+
+      if (!err)
+        err = append_segment(rb, segment, pool);
+    }
+
+  /* This also removes the temporary files. */
+  for (i = 0; i < segments->nelts; i++)
+    svn_pool_destroy(APR_ARRAY_IDX(segments, i, dump_segment_t *)->pool);
+
+  return svn_error_trace(err);
+}
+#endif
+
 /* Replay revisions START_REVISION thru END_REVISION (inclusive) of
  * the repository URL at which SESSION is rooted, using callbacks
  * which generate Subversion repository dumpstreams describing the
  * changes made in those revisions.  If QUIET is set, don't generate
- * progress messages.
+ * progress messages.  If JOBS is greater than 1, replay up to JOBS
+ * ranges of revisions concurrently over additional sessions opened
+ * through CTX.
  */
 static svn_error_t *
 replay_revisions(svn_ra_session_t *session,
@@ -463,6 +690,8 @@ replay_revisions(svn_ra_session_t *session,
                  svn_revnum_t end_revision,
                  svn_boolean_t quiet,
                  svn_boolean_t incremental,
+                 svn_client_ctx_t *ctx,
+                 int jobs,
                  apr_pool_t *pool)
 {
   struct replay_baton *replay_baton;
@@ -475,6 +704,7 @@ replay_revisions(svn_ra_session_t *session,
   replay_baton->stdout_stream = stdout_stream;
   replay_baton->extra_ra_session = extra_ra_session;
   replay_baton->quiet = quiet;
+  replay_baton->cancel_func = check_cancel;
 
   /* Write the magic header and UUID */
   SVN_ERR(svn_stream_printf(stdout_stream, pool,
@@ -515,6 +745,12 @@ replay_revisions(svn_ra_session_t *session,
   if (start_revision <= end_revision)
     {
 #ifndef USE_EV2_IMPL
+#if APR_HAS_THREADS
+      if (jobs > 1 && start_revision < end_revision)
+        return svn_error_trace(replay_segments(session, start_revision,
+                                               end_revision, replay_baton,
+                                               ctx, jobs, pool));
+#endif
       SVN_ERR(svn_ra_replay_range(session, start_revision, end_revision,
                                   0, TRUE, replay_revstart, replay_revend,
                                   replay_baton, pool));
@@ -616,7 +852,8 @@ dump_cmd(apr_getopt_t *os,
   return replay_revisions(opt_baton->session, extra_ra_session,
                           opt_baton->start_revision.value.number,
                           opt_baton->end_revision.value.number,
-                          opt_baton->quiet, opt_baton->incremental, pool);
+                          opt_baton->quiet, opt_baton->incremental,
+                          opt_baton->ctx, opt_baton->jobs, pool);
 }
 
 /* Handle the "load" subcommand.  Implements `svn_opt_subcommand_t'.  */
@@ -778,6 +1015,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   opt_baton->start_revision.kind = svn_opt_revision_unspecified;
   opt_baton->end_revision.kind = svn_opt_revision_unspecified;
   opt_baton->url = NULL;
+  opt_baton->jobs = 1;
   opt_baton->skip_revprops = apr_hash_make(pool);
 
   SVN_ERR(svn_cmdline__getopt_init(&os, argc, argv, pool));
@@ -863,6 +1101,16 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
         case opt_incremental:
           opt_baton->incremental = TRUE;
           break;
+        case opt_jobs:
+          {
+            SVN_ERR(svn_utf_cstring_to_utf8(&opt_arg, opt_arg, pool));
+            err = svn_cstring_atoi(&opt_baton->jobs, opt_arg);
+            if (err || opt_baton->jobs < 1)
+              return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, err,
+                                       _("Invalid number of jobs '%s'"),
+                                       opt_arg);
+          }
+          break;
         case opt_skip_revprop:
           SVN_ERR(svn_utf_cstring_to_utf8(&opt_arg, opt_arg, pool));
           svn_hash_sets(opt_baton->skip_revprops, opt_arg, opt_arg);
@@ -0,0 +1,237 @@
+/*
+ * admission.c : Limits on concurrent expensive svnserve commands
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+
+#include <apr_strings.h>
+#include <apr_thread_cond.h>
+
+#include "svn_hash.h"
+#include "svn_pools.h"
+#include "svn_sorts.h"
+
+#include "private/svn_mutex.h"
+
+#include "svn_private_config.h"
+#include "admission.h"
+
+struct admission_t
+{
+  /* Limits per repository and per user; 0 means unlimited. */
+  int max_per_repos;
+  int max_per_user;
+
+  /* const char * name -> int * number of running expensive commands */
+  apr_hash_t *repositories;
+  apr_hash_t *users;
+
+  /* mutex used to serialize access to this structure */
+  svn_mutex__t *mutex;
+
+#if APR_HAS_THREADS
+  /* signaled whenever a command finishes */
+  apr_thread_cond_t *finished;
+#endif
+
+  /* pool for the hash keys and counters */
+  apr_pool_t *pool;
+};
+
+/* A running expensive command. */
+typedef struct slot_t
+{
+  admission_t *admission;
+
+  /* Counters in ADMISSION->REPOSITORIES and ADMISSION->USERS; the latter
+     may be NULL. */
+  int *repos_count;
+  int *user_count;
+} slot_t;
+
+/* Return the counter for KEY in HASH, creating it in POOL if necessary. */
+static int *
+get_counter(apr_hash_t *hash,
+            const char *key,
+            apr_pool_t *pool)
+{
+  int *counter = svn_hash_gets(hash, key);
+  if (counter == NULL)
+    {
+      counter = apr_pcalloc(pool, sizeof(*counter));
+      svn_hash_sets(hash, apr_pstrdup(pool, key), counter);
+    }
+
+  return counter;
+}
+
+/* Return TRUE if SLOT may start running in its admission object. */
+static svn_boolean_t
+may_run(const slot_t *slot)
+{
+  const admission_t *admission = slot->admission;
+
+  if (admission->max_per_repos
+      && *slot->repos_count >= admission->max_per_repos)
+    return FALSE;
+
+  if (admission->max_per_user && slot->user_count
+      && *slot->user_count >= admission->max_per_user)
+    return FALSE;
+
+  return TRUE;
+}
+
+/* Wait for SLOT to be allowed to run and count it as running.  Must be
+ * called while holding the mutex. */
+static svn_error_t *
+acquire_locked(slot_t *slot)
+{
+  admission_t *admission = slot->admission;
+
+  while (!may_run(slot))
+    {
+#if APR_HAS_THREADS
+      apr_status_t status
+        = apr_thread_cond_wait(admission->finished,
+                               svn_mutex__get(admission->mutex));
+      if (status)
+        return svn_error_wrap_apr(status,
+                                  _("Can't wait for condition variable"));
+#else
+      /* Nobody else could ever release a slot. */
+      break;
+#endif
+    }
+
+  ++*slot->repos_count;
+  if (slot->user_count)
+    ++*slot->user_count;
+
+  return SVN_NO_ERROR;
+}
+
+/* Stop counting SLOT as running.  Must be called while holding the
+ * mutex. */
+static svn_error_t *
+release_locked(slot_t *slot)
+{
+  --*slot->repos_count;
+  if (slot->user_count)
+    --*slot->user_count;
+
+#if APR_HAS_THREADS
+  apr_thread_cond_broadcast(slot->admission->finished);
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+/* Pool cleanup function releasing the slot_t DATA. */
+static apr_status_t
+release_slot(void *data)
+{
+  slot_t *slot = data;
+  svn_error_t *err;
+
+  err = svn_mutex__lock(slot->admission->mutex);
+  if (!err)
+    err = svn_mutex__unlock(slot->admission->mutex, release_locked(slot));
+
+  svn_error_clear(err);
+  return APR_SUCCESS;
+}
+
+svn_error_t *
+admission__create(admission_t **admission,
+                  int max_per_repos,
+                  int max_per_user,
+                  apr_pool_t *pool)
+{
+  admission_t *result = apr_pcalloc(pool, sizeof(*result));
+  result->max_per_repos = MAX(max_per_repos, 0);
+  result->max_per_user = MAX(max_per_user, 0);
+  result->pool = svn_pool_create(pool);
+  result->repositories = apr_hash_make(result->pool);
+  result->users = apr_hash_make(result->pool);
+
+  SVN_ERR(svn_mutex__init(&result->mutex, TRUE, pool));
+
+#if APR_HAS_THREADS
+  {
+    apr_status_t status = apr_thread_cond_create(&result->finished, pool);
+    if (status)
+      return svn_error_wrap_apr(status, _("Can't create condition variable"));
+  }
+#endif
+
+  *admission = result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton type for init_slot_locked. */
+typedef struct init_baton_t
+{
+  slot_t *slot;
+  const char *repos_name;
+  const char *user;
+} init_baton_t;
+
+/* Find the counters for the init_baton_t BATON and wait for the slot to
+ * be allowed to run.  Must be called while holding the mutex. */
+static svn_error_t *
+init_slot_locked(init_baton_t *baton)
+{
+  slot_t *slot = baton->slot;
+  admission_t *admission = slot->admission;
+
+  slot->repos_count = get_counter(admission->repositories,
+                                  baton->repos_name, admission->pool);
+  slot->user_count = baton->user
+                   ? get_counter(admission->users, baton->user,
+                                 admission->pool)
+                   : NULL;
+
+  return svn_error_trace(acquire_locked(slot));
+}
+
+svn_error_t *
+admission__acquire(admission_t *admission,
+                   const char *repos_name,
+                   const char *user,
+                   apr_pool_t *pool)
+{
+  init_baton_t baton;
+
+  baton.slot = apr_pcalloc(pool, sizeof(*baton.slot));
+  baton.slot->admission = admission;
+  baton.repos_name = repos_name;
+  baton.user = user;
+
+  SVN_MUTEX__WITH_LOCK(admission->mutex, init_slot_locked(&baton));
+
+  apr_pool_cleanup_register(pool, baton.slot, release_slot,
+                            apr_pool_cleanup_null);
+
+  return SVN_NO_ERROR;
+}
@@ -0,0 +1,66 @@
+/*
+ * admission.h : Limits on concurrent expensive svnserve commands
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef ADMISSION_H
+#define ADMISSION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "svn_types.h"
+
+
+
+/* Opaque admission control data structure.  It counts the expensive
+ * commands currently running per repository and per user within this
+ * process and makes further ones wait while a limit is reached.
+ */
+typedef struct admission_t admission_t;
+
+/* In POOL, create an admission control object that allows at most
+ * MAX_PER_REPOS expensive commands per repository and MAX_PER_USER per
+ * authenticated user to run concurrently, and return it in *ADMISSION.
+ * A limit of 0 means "unlimited".
+ */
+svn_error_t *
+admission__create(admission_t **admission,
+                  int max_per_repos,
+                  int max_per_user,
+                  apr_pool_t *pool);
+
+/* Wait until ADMISSION allows another expensive command on repository
+ * REPOS_NAME for USER, which may be NULL for anonymous access, and count
+ * it as running until POOL gets cleared or destroyed.
+ */
+svn_error_t *
+admission__acquire(admission_t *admission,
+                   const char *repos_name,
+                   const char *user,
+                   apr_pool_t *pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* ADMISSION_H */
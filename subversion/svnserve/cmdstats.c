@@ -0,0 +1,320 @@
+/*
+ * cmdstats.c : Per-command and per-repository request statistics
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+
+#include <apr_strings.h>
+
+#include "svn_hash.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+#include "svn_sorts.h"
+#include "svn_time.h"
+
+#include "private/svn_mutex.h"
+#include "private/svn_sorts_private.h"
+
+#include "svn_private_config.h"
+#include "cmdstats.h"
+
+/* Latencies are recorded in microseconds in log-linear buckets: values
+ * below SUB_BUCKETS get a bucket each; above that, every power of 2 is
+ * split into SUB_BUCKETS equally sized buckets.  That keeps the relative
+ * error of the reported values below 1 / SUB_BUCKETS at all scales.
+ */
+#define SUB_BUCKET_BITS 4
+#define SUB_BUCKETS (1 << SUB_BUCKET_BITS)
+
+/* Latencies at or above 2^MAX_LATENCY_BITS microseconds (about 19 hours)
+ * end up in the last bucket.
+ */
+#define MAX_LATENCY_BITS 36
+#define BUCKET_COUNT ((MAX_LATENCY_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS)
+
+/* Statistics for one command name or repository. */
+typedef struct entry_t
+{
+  /* Number of commands recorded. */
+  apr_uint64_t count;
+
+  /* Sum and maximum of their durations in microseconds. */
+  apr_uint64_t total_usec;
+  apr_uint64_t max_usec;
+
+  /* Bytes received and sent by them. */
+  apr_uint64_t bytes_in;
+  apr_uint64_t bytes_out;
+
+  /* Latency histogram. */
+  apr_uint64_t buckets[BUCKET_COUNT];
+} entry_t;
+
+struct cmdstats_t
+{
+  /* const char * command name -> entry_t * */
+  apr_hash_t *commands;
+
+  /* const char * repository name -> entry_t * */
+  apr_hash_t *repositories;
+
+  /* mutex used to serialize access to this structure */
+  svn_mutex__t *mutex;
+
+  /* pool for the hash keys and entries */
+  apr_pool_t *pool;
+};
+
+/* Return the index of the histogram bucket for USEC microseconds. */
+static int
+bucket_index(apr_uint64_t usec)
+{
+  int shift = 0;
+
+  if (usec < SUB_BUCKETS)
+    return (int)usec;
+
+  while ((usec >> shift) >= 2 * SUB_BUCKETS)
+    ++shift;
+
+  if (shift + SUB_BUCKET_BITS >= MAX_LATENCY_BITS)
+    return BUCKET_COUNT - 1;
+
+  return (shift + 1) * SUB_BUCKETS + (int)((usec >> shift) - SUB_BUCKETS);
+}
+
+/* Return the largest value in microseconds that falls into bucket INDEX. */
+static apr_uint64_t
+bucket_upper_bound(int index)
+{
+  int shift;
+
+  if (index < SUB_BUCKETS)
+    return index;
+
+  shift = index / SUB_BUCKETS - 1;
+  return (((apr_uint64_t)(SUB_BUCKETS + index % SUB_BUCKETS + 1)) << shift)
+         - 1;
+}
+
+/* Return the entry for KEY in HASH, creating it in POOL if necessary. */
+static entry_t *
+get_entry(apr_hash_t *hash,
+          const char *key,
+          apr_pool_t *pool)
+{
+  entry_t *entry = svn_hash_gets(hash, key);
+  if (entry == NULL)
+    {
+      entry = apr_pcalloc(pool, sizeof(*entry));
+      svn_hash_sets(hash, apr_pstrdup(pool, key), entry);
+    }
+
+  return entry;
+}
+
+/* Add a command to ENTRY.  The other parameters are the same as for
+ * cmdstats__add. */
+static void
+add_to_entry(entry_t *entry,
+             apr_uint64_t usec,
+             apr_uint64_t bytes_in,
+             apr_uint64_t bytes_out)
+{
+  entry->count++;
+  entry->total_usec += usec;
+  if (entry->max_usec < usec)
+    entry->max_usec = usec;
+
+  entry->bytes_in += bytes_in;
+  entry->bytes_out += bytes_out;
+  entry->buckets[bucket_index(usec)]++;
+}
+
+/* Baton type for add_locked. */
+typedef struct add_baton_t
+{
+  cmdstats_t *stats;
+  const char *repos_name;
+  const char *command;
+  apr_uint64_t usec;
+  apr_uint64_t bytes_in;
+  apr_uint64_t bytes_out;
+} add_baton_t;
+
+/* Implement cmdstats__add for the add_baton_t BATON while holding the
+ * mutex. */
+static svn_error_t *
+add_locked(add_baton_t *baton)
+{
+  cmdstats_t *stats = baton->stats;
+
+  add_to_entry(get_entry(stats->commands, baton->command, stats->pool),
+               baton->usec, baton->bytes_in, baton->bytes_out);
+  add_to_entry(get_entry(stats->repositories, baton->repos_name,
+                         stats->pool),
+               baton->usec, baton->bytes_in, baton->bytes_out);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the latency in microseconds below which PERMILLE per mille of
+ * the commands in ENTRY completed. */
+static apr_uint64_t
+percentile(const entry_t *entry,
+           int permille)
+{
+  apr_uint64_t threshold = (entry->count * permille + 999) / 1000;
+  apr_uint64_t seen = 0;
+  int i;
+
+  for (i = 0; i < BUCKET_COUNT; ++i)
+    {
+      seen += entry->buckets[i];
+      if (seen >= threshold)
+        break;
+    }
+
+  return MIN(bucket_upper_bound(i), entry->max_usec);
+}
+
+/* Append one line for the entry with KIND and NAME to TEXT. */
+static void
+format_entry(svn_stringbuf_t *text,
+             const char *kind,
+             const char *name,
+             const entry_t *entry,
+             apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_appendcstr(text,
+    apr_psprintf(scratch_pool,
+                 "%s %s count %" APR_UINT64_T_FMT
+                 " in %" APR_UINT64_T_FMT " out %" APR_UINT64_T_FMT
+                 " mean-us %" APR_UINT64_T_FMT
+                 " p50-us %" APR_UINT64_T_FMT
+                 " p90-us %" APR_UINT64_T_FMT
+                 " p99-us %" APR_UINT64_T_FMT
+                 " p999-us %" APR_UINT64_T_FMT
+                 " max-us %" APR_UINT64_T_FMT "\n",
+                 kind, name, entry->count, entry->bytes_in, entry->bytes_out,
+                 entry->count ? entry->total_usec / entry->count : 0,
+                 percentile(entry, 500), percentile(entry, 900),
+                 percentile(entry, 990), percentile(entry, 999),
+                 entry->max_usec));
+}
+
+/* Append the lines for all entries in HASH to TEXT, sorted by name. */
+static void
+format_hash(svn_stringbuf_t *text,
+            const char *kind,
+            apr_hash_t *hash,
+            apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *sorted
+    = svn_sort__hash(hash, svn_sort_compare_items_lexically, scratch_pool);
+  int i;
+
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      const svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i,
+                                                    svn_sort__item_t);
+      format_entry(text, kind, item->key, item->value, scratch_pool);
+    }
+}
+
+/* Baton type for format_locked. */
+typedef struct format_baton_t
+{
+  cmdstats_t *stats;
+  svn_stringbuf_t *text;
+  apr_pool_t *pool;
+} format_baton_t;
+
+/* Format the statistics in the format_baton_t BATON while holding the
+ * mutex. */
+static svn_error_t *
+format_locked(format_baton_t *baton)
+{
+  format_hash(baton->text, "command", baton->stats->commands, baton->pool);
+  format_hash(baton->text, "repository", baton->stats->repositories,
+              baton->pool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+cmdstats__create(cmdstats_t **stats,
+                 apr_pool_t *pool)
+{
+  cmdstats_t *result = apr_pcalloc(pool, sizeof(*result));
+  result->pool = svn_pool_create(pool);
+  result->commands = apr_hash_make(result->pool);
+  result->repositories = apr_hash_make(result->pool);
+
+  SVN_ERR(svn_mutex__init(&result->mutex, TRUE, pool));
+
+  *stats = result;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+cmdstats__add(cmdstats_t *stats,
+              const char *repos_name,
+              const char *command,
+              apr_interval_time_t duration,
+              apr_uint64_t bytes_in,
+              apr_uint64_t bytes_out)
+{
+  add_baton_t baton;
+
+  baton.stats = stats;
+  baton.repos_name = repos_name;
+  baton.command = command;
+  baton.usec = duration > 0 ? (apr_uint64_t)duration : 0;
+  baton.bytes_in = bytes_in;
+  baton.bytes_out = bytes_out;
+
+  SVN_MUTEX__WITH_LOCK(stats->mutex, add_locked(&baton));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+cmdstats__write(cmdstats_t *stats,
+                const char *path,
+                apr_pool_t *scratch_pool)
+{
+  format_baton_t baton;
+
+  baton.stats = stats;
+  baton.text = svn_stringbuf_createf(scratch_pool, "time %s\n",
+                                     svn_time_to_cstring(apr_time_now(),
+                                                         scratch_pool));
+  baton.pool = scratch_pool;
+
+  SVN_MUTEX__WITH_LOCK(stats->mutex, format_locked(&baton));
+  SVN_ERR(svn_io_write_atomic2(path, baton.text->data, baton.text->len,
+                               NULL, FALSE, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
@@ -0,0 +1,74 @@
+/*
+ * cmdstats.h : Per-command and per-repository request statistics
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef CMDSTATS_H
+#define CMDSTATS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <apr_time.h>
+
+#include "svn_types.h"
+
+
+
+/* Opaque collection of latency histograms and byte counters, kept per
+ * ra_svn command name and per repository.  Access will be serialized
+ * among threads within the same process.
+ */
+typedef struct cmdstats_t cmdstats_t;
+
+/* In POOL, create an empty statistics collection and return it in
+ * *STATS.
+ */
+svn_error_t *
+cmdstats__create(cmdstats_t **stats,
+                 apr_pool_t *pool);
+
+/* Add one execution of COMMAND on the repository REPOS_NAME to STATS.
+ * It took DURATION and received BYTES_IN resp. sent BYTES_OUT bytes.
+ */
+svn_error_t *
+cmdstats__add(cmdstats_t *stats,
+              const char *repos_name,
+              const char *command,
+              apr_interval_time_t duration,
+              apr_uint64_t bytes_in,
+              apr_uint64_t bytes_out);
+
+/* Write a human-readable summary of STATS to the file at PATH, replacing
+ * its previous contents atomically.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+svn_error_t *
+cmdstats__write(cmdstats_t *stats,
+                const char *path,
+                apr_pool_t *scratch_pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* CMDSTATS_H */
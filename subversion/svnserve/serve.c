@@ -50,6 +50,8 @@
 #include "svn_props.h"
 #include "svn_mergeinfo.h"
 #include "svn_user.h"
+#include "svn_sorts.h"
+#include "svn_cache_config.h"
 
 #include "private/svn_log.h"
 #include "private/svn_mergeinfo_private.h"
@@ -62,6 +64,8 @@
 
 #include "server.h"
 #include "logger.h"
+#include "cmdstats.h"
+#include "admission.h"
 
 typedef struct commit_callback_baton_t {
   apr_pool_t *pool;
@@ -417,6 +421,29 @@ static void convert_case(char *text, svn_boolean_t to_uppercase)
     }
 }
 
+/* Return the user name to use for authz checks in B.  */
+static const char *get_authz_user(server_baton_t *b)
+{
+  repository_t *repository = b->repository;
+  client_info_t *client_info = b->client_info;
+
+  /* If we have a username, and we've not yet used it + any username
+     case normalization that might be requested to determine "the
+     username we used for authz purposes", do so now. */
+  if (client_info->user && (! client_info->authz_user))
+    {
+      char *authz_user = apr_pstrdup(b->pool, client_info->user);
+      if (repository->username_case == CASE_FORCE_UPPER)
+        convert_case(authz_user, TRUE);
+      else if (repository->username_case == CASE_FORCE_LOWER)
+        convert_case(authz_user, FALSE);
+
+      client_info->authz_user = authz_user;
+    }
+
+  return client_info->authz_user;
+}
+
 /* Set *ALLOWED to TRUE if PATH is accessible in the REQUIRED mode to
    the user described in BATON according to the authz rules in BATON.
    Use POOL for temporary allocations only.  If no authz rules are
@@ -428,7 +455,6 @@ static svn_error_t *authz_check_access(svn_boolean_t *allowed,
                                        apr_pool_t *pool)
 {
   repository_t *repository = b->repository;
-  client_info_t *client_info = b->client_info;
 
   /* If authz cannot be performed, grant access.  This is NOT the same
      as the default policy when authz is performed on a path with no
@@ -449,23 +475,9 @@ static svn_error_t *authz_check_access(svn_boolean_t *allowed,
   if (path)
     path = svn_fspath__canonicalize(path, pool);
 
-  /* If we have a username, and we've not yet used it + any username
-     case normalization that might be requested to determine "the
-     username we used for authz purposes", do so now. */
-  if (client_info->user && (! client_info->authz_user))
-    {
-      char *authz_user = apr_pstrdup(b->pool, client_info->user);
-      if (repository->username_case == CASE_FORCE_UPPER)
-        convert_case(authz_user, TRUE);
-      else if (repository->username_case == CASE_FORCE_LOWER)
-        convert_case(authz_user, FALSE);
-
-      client_info->authz_user = authz_user;
-    }
-
   SVN_ERR(svn_repos_authz_check_access(repository->authzdb,
                                        repository->authz_repos_name,
-                                       path, client_info->authz_user,
+                                       path, get_authz_user(b),
                                        required, allowed, pool));
   if (!*allowed)
     SVN_ERR(log_authz_denied(path, required, b, pool));
@@ -498,6 +510,65 @@ static svn_repos_authz_func_t authz_check_access_cb_func(server_baton_t *baton)
   return NULL;
 }
 
+/* Set ALLOWED[i] to TRUE if the i-th element of PATHS is readable by the
+ * user described in BATON.  Use POOL for temporary allocations only.
+ * ROOT is not used.  Implements the svn_repos__authz_batch_func_t
+ * interface.
+ */
+static svn_error_t *authz_check_access_batch_cb(svn_boolean_t *allowed,
+                                                svn_fs_root_t *root,
+                                                const apr_array_header_t *paths,
+                                                void *baton,
+                                                apr_pool_t *pool)
+{
+  authz_baton_t *sb = baton;
+  server_baton_t *b = sb->server;
+  apr_array_header_t *canonical_paths;
+  int i;
+
+  if (!b->repository->authzdb)
+    {
+      for (i = 0; i < paths->nelts; ++i)
+        allowed[i] = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  /* See authz_check_access() for why the paths need to be canonical. */
+  canonical_paths = apr_array_make(pool, paths->nelts, sizeof(const char *));
+  for (i = 0; i < paths->nelts; ++i)
+    APR_ARRAY_PUSH(canonical_paths, const char *)
+      = svn_fspath__canonicalize(APR_ARRAY_IDX(paths, i, const char *),
+                                 pool);
+
+  SVN_ERR(svn_repos_authz_check_access_batch(b->repository->authzdb,
+                                             b->repository->authz_repos_name,
+                                             canonical_paths,
+                                             get_authz_user(b),
+                                             svn_authz_read, allowed, pool));
+
+  for (i = 0; i < canonical_paths->nelts; ++i)
+    if (!allowed[i])
+      SVN_ERR(log_authz_denied(APR_ARRAY_IDX(canonical_paths, i,
+                                             const char *),
+                               svn_authz_read, b, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *FUNC and *FUNC_BATON to the read authorization callback for AB,
+ * which checks many paths at once where libsvn_repos supports it.
+ * Set *FUNC to NULL if authz is not enabled.  Allocate the result in POOL.
+ */
+static void authz_batch_funcs(svn_repos_authz_func_t *func,
+                              void **func_baton,
+                              authz_baton_t *ab,
+                              apr_pool_t *pool)
+{
+  svn_repos__authz_batch_wrap(func, func_baton,
+                              authz_check_access_cb_func(ab->server),
+                              authz_check_access_batch_cb, ab, pool);
+}
+
 /* Set *ALLOWED to TRUE if the REQUIRED access to PATH is granted,
  * according to the state in BATON.  Use POOL for temporary
  * allocations only.  ROOT is not used.  Implements the
@@ -814,6 +885,7 @@ static svn_error_t *must_have_access(svn_ra_svn_conn_t *conn,
      authz configuration again with a different user credentials than
      the first time round. */
   if (b->client_info->user == NULL
+      && ! b->in_batch
       && b->repository->auth_access >= req
       && (b->client_info->tunnel_user || b->repository->pwdb
           || b->repository->use_sasl))
@@ -833,6 +905,25 @@ static svn_error_t *must_have_access(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+/* Mark the current command of B as expensive and, if admission control
+ * is enabled, wait until the limits for its repository and user allow
+ * another expensive command to run.  It counts as running until POOL
+ * gets cleared.  Handlers of commands whose cost grows with the size of
+ * the repository or of the requested history call this after checking
+ * authorization.
+ */
+static svn_error_t *
+admit_expensive_command(server_baton_t *b,
+                        apr_pool_t *pool)
+{
+  b->expensive_command = TRUE;
+  if (b->admission)
+    SVN_ERR(admission__acquire(b->admission, b->repository->repos_name,
+                               b->client_info->user, pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* --- REPORTER COMMAND SET --- */
 
 /* To allow for pipelining, reporter commands have no reponses.  If we
@@ -1941,6 +2032,7 @@ update(svn_ra_svn_conn_t *conn,
   full_path = svn_fspath__join(b->repository->fs_path->data, target, pool);
   /* Check authorization and authenticate the user if necessary. */
   SVN_ERR(must_have_access(conn, pool, b, svn_authz_read, full_path, FALSE));
+  SVN_ERR(admit_expensive_command(b, pool));
 
   if (!SVN_IS_VALID_REVNUM(rev))
     SVN_CMD_ERR(svn_fs_youngest_rev(&rev, b->repository->fs, pool));
@@ -1998,6 +2090,7 @@ switch_cmd(svn_ra_svn_conn_t *conn,
     depth = SVN_DEPTH_INFINITY_OR_FILES(recurse);
 
   SVN_ERR(trivial_auth_request(conn, pool, b));
+  SVN_ERR(admit_expensive_command(b, pool));
   if (!SVN_IS_VALID_REVNUM(rev))
     SVN_CMD_ERR(svn_fs_youngest_rev(&rev, b->repository->fs, pool));
 
@@ -2046,6 +2139,7 @@ status(svn_ra_svn_conn_t *conn,
     depth = SVN_DEPTH_INFINITY_OR_EMPTY(recurse);
 
   SVN_ERR(trivial_auth_request(conn, pool, b));
+  SVN_ERR(admit_expensive_command(b, pool));
   if (!SVN_IS_VALID_REVNUM(rev))
     SVN_CMD_ERR(svn_fs_youngest_rev(&rev, b->repository->fs, pool));
 
@@ -2100,6 +2194,7 @@ diff(svn_ra_svn_conn_t *conn,
     depth = SVN_DEPTH_INFINITY_OR_FILES(recurse);
 
   SVN_ERR(trivial_auth_request(conn, pool, b));
+  SVN_ERR(admit_expensive_command(b, pool));
 
   if (!SVN_IS_VALID_REVNUM(rev))
     SVN_CMD_ERR(svn_fs_youngest_rev(&rev, b->repository->fs, pool));
@@ -2348,6 +2443,8 @@ log_cmd(svn_ra_svn_conn_t *conn,
   apr_uint64_t limit, include_merged_revs_param;
   log_baton_t lb;
   authz_baton_t ab;
+  svn_repos_authz_func_t authz_func;
+  void *authz_baton;
 
   ab.server = b;
   ab.conn = conn;
@@ -2408,6 +2505,7 @@ log_cmd(svn_ra_svn_conn_t *conn,
       APR_ARRAY_PUSH(full_paths, const char *) = full_path;
     }
   SVN_ERR(trivial_auth_request(conn, pool, b));
+  SVN_ERR(admit_expensive_command(b, pool));
 
   SVN_ERR(log_command(b, conn, pool, "%s",
                       svn_log__log(full_paths, start_rev, end_rev,
@@ -2420,10 +2518,11 @@ log_cmd(svn_ra_svn_conn_t *conn,
   lb.conn = conn;
   lb.stack_depth = 0;
   lb.started = FALSE;
+  authz_batch_funcs(&authz_func, &authz_baton, &ab, pool);
   err = svn_repos_get_logs5(b->repository->repos, full_paths, start_rev,
                             end_rev, (int) limit,
                             strict_node, include_merged_revisions,
-                            revprops, authz_check_access_cb_func(b), &ab,
+                            revprops, authz_func, authz_baton,
                             send_changed_paths ? path_change_receiver : NULL,
                             send_changed_paths ? &lb : NULL,
                             revision_receiver, &lb, pool);
@@ -2706,11 +2805,19 @@ get_location_segments(svn_ra_svn_conn_t *conn,
   /* We store both err and write_err here, so the client will get
    * the "done" even if there was an error in fetching the results. */
 
-  err = svn_repos_node_location_segments(b->repository->repos, abs_path,
+  if (b->repository->use_segments_cache)
+    err = svn_repos__node_location_segments_cached(
+                                         b->repository->repos, abs_path,
                                          peg_revision, start_rev, end_rev,
                                          gls_receiver, (void *)conn,
                                          authz_check_access_cb_func(b), &ab,
                                          pool);
+  else
+    err = svn_repos_node_location_segments(b->repository->repos, abs_path,
+                                           peg_revision, start_rev, end_rev,
+                                           gls_receiver, (void *)conn,
+                                           authz_check_access_cb_func(b), &ab,
+                                           pool);
   write_err = svn_ra_svn__write_word(conn, pool, "done");
   if (write_err)
     {
@@ -2775,15 +2882,12 @@ static svn_error_t *file_rev_handler(void *baton, const char *path,
       svn_stream_set_write(stream, svndiff_handler);
       svn_stream_set_close(stream, svndiff_close_handler);
 
-      /* If the connection does not support SVNDIFF1 or if we don't want to use
-       * compression, use the non-compressing "version 0" implementation */
-      if (   svn_ra_svn_compression_level(frb->conn) > 0
-          && svn_ra_svn_has_capability(frb->conn, SVN_RA_SVN_CAP_SVNDIFF1))
-        svn_txdelta_to_svndiff3(d_handler, d_baton, stream, 1,
-                                svn_ra_svn_compression_level(frb->conn), pool);
-      else
-        svn_txdelta_to_svndiff3(d_handler, d_baton, stream, 0,
-                                svn_ra_svn_compression_level(frb->conn), pool);
+      /* Use the fastest compressing svndiff version supported by both
+       * sides, or the non-compressing "version 0" if we don't want to
+       * compress. */
+      svn_txdelta_to_svndiff3(d_handler, d_baton, stream,
+                              svn_ra_svn__svndiff_version(frb->conn),
+                              svn_ra_svn__compression_level(frb->conn), pool);
     }
   else
     SVN_ERR(svn_ra_svn__write_cstring(frb->conn, pool, ""));
@@ -2816,6 +2920,7 @@ get_file_revs(svn_ra_svn_conn_t *conn,
                                   &include_merged_revs_param));
   path = svn_relpath_canonicalize(path, pool);
   SVN_ERR(trivial_auth_request(conn, pool, b));
+  SVN_ERR(admit_expensive_command(b, pool));
   full_path = svn_fspath__join(b->repository->fs_path->data, path, pool);
 
   if (include_merged_revs_param == SVN_RA_SVN_UNSPECIFIED_NUMBER)
@@ -3365,9 +3470,22 @@ static svn_error_t *replay_one_revision(svn_ra_svn_conn_t *conn,
   err = svn_fs_revision_root(&root, b->repository->fs, rev, pool);
 
   if (! err)
-    err = svn_repos_replay2(root, b->repository->fs_path->data,
-                            low_water_mark, send_deltas, editor, edit_baton,
-                            authz_check_access_cb_func(b), &ab, pool);
+    {
+      svn_repos_authz_func_t authz_func;
+      void *authz_baton;
+
+      authz_batch_funcs(&authz_func, &authz_baton, &ab, pool);
+      if (b->repository->use_replay_cache)
+        err = svn_repos__replay_cached(b->repository->repos, root,
+                                       b->repository->fs_path->data,
+                                       low_water_mark, send_deltas,
+                                       editor, edit_baton,
+                                       authz_func, authz_baton, pool);
+      else
+        err = svn_repos_replay2(root, b->repository->fs_path->data,
+                                low_water_mark, send_deltas, editor,
+                                edit_baton, authz_func, authz_baton, pool);
+    }
 
   if (err)
     svn_error_clear(editor->abort_edit(edit_baton, pool));
@@ -3390,6 +3508,7 @@ replay(svn_ra_svn_conn_t *conn,
                                  &send_deltas));
 
   SVN_ERR(trivial_auth_request(conn, pool, b));
+  SVN_ERR(admit_expensive_command(b, pool));
 
   SVN_ERR(replay_one_revision(conn, b, rev, low_water_mark,
                               send_deltas, pool));
@@ -3419,6 +3538,7 @@ replay_range(svn_ra_svn_conn_t *conn,
                                  &send_deltas));
 
   SVN_ERR(trivial_auth_request(conn, pool, b));
+  SVN_ERR(admit_expensive_command(b, pool));
 
   iterpool = svn_pool_create(pool);
   for (rev = start_rev; rev <= end_rev; rev++)
@@ -3623,6 +3743,7 @@ list(svn_ra_svn_conn_t *conn,
   /* Check authorizations */
   SVN_ERR(must_have_access(conn, pool, b, svn_authz_read,
                            full_path, FALSE));
+  SVN_ERR(admit_expensive_command(b, pool));
 
   if (!SVN_IS_VALID_REVNUM(rev))
     SVN_CMD_ERR(svn_fs_youngest_rev(&rev, b->repository->fs, pool));
@@ -3639,6 +3760,7 @@ list(svn_ra_svn_conn_t *conn,
   rb.path_info_only = (dirent_fields & ~SVN_DIRENT_KIND) == 0;
 
   err = svn_repos_list(root, full_path, patterns, depth, rb.path_info_only,
+                       b->repository->list_jobs, FALSE,
                        authz_check_access_cb_func(b), &ab, list_receiver,
                        &rb, NULL, NULL, pool);
 
@@ -3655,6 +3777,147 @@ list(svn_ra_svn_conn_t *conn,
   return svn_error_trace(svn_ra_svn__write_cmd_response(conn, pool, ""));
 }
 
+/* Baton type to be used with blame_receiver. */
+typedef struct blame_receiver_baton_t
+{
+  /* Send the data through this connection. */
+  svn_ra_svn_conn_t *conn;
+
+  /* Revisions whose revision props have already been sent, as keys of
+     type svn_revnum_t.  Allocated in POOL. */
+  apr_hash_t *sent_revs;
+  apr_pool_t *pool;
+} blame_receiver_baton_t;
+
+/* Implements svn_repos_blame_receiver_t, sending the chunk to the client.
+ * BATON must be a blame_receiver_baton_t. */
+static svn_error_t *
+blame_receiver(void *baton,
+               apr_int64_t start_line,
+               svn_revnum_t revision,
+               apr_hash_t *rev_props,
+               apr_pool_t *pool)
+{
+  blame_receiver_baton_t *b = baton;
+
+  /* Send the revision props only once per revision. */
+  if (rev_props
+      && !apr_hash_get(b->sent_revs, &revision, sizeof(revision)))
+    {
+      svn_revnum_t *key = apr_pmemdup(b->pool, &revision, sizeof(revision));
+      apr_hash_set(b->sent_revs, key, sizeof(*key), key);
+
+      SVN_ERR(svn_ra_svn__write_tuple(b->conn, pool, "n(?r)(!",
+                                      (apr_uint64_t)start_line, revision));
+      SVN_ERR(svn_ra_svn__write_proplist(b->conn, pool, rev_props));
+      SVN_ERR(svn_ra_svn__write_tuple(b->conn, pool, "!))"));
+    }
+  else
+    {
+      SVN_ERR(svn_ra_svn__write_tuple(b->conn, pool, "n(?r)()",
+                                      (apr_uint64_t)start_line, revision));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+blame(svn_ra_svn_conn_t *conn,
+      apr_pool_t *pool,
+      svn_ra_svn__list_t *params,
+      void *baton)
+{
+  server_baton_t *b = baton;
+  const char *path, *full_path;
+  svn_revnum_t start_rev, end_rev;
+  const char *ignore_space, *algorithm;
+  svn_boolean_t ignore_eol_style;
+  svn_diff_file_options_t *diff_options;
+  blame_receiver_baton_t rb;
+  svn_error_t *err, *write_err;
+
+  authz_baton_t ab;
+  ab.server = b;
+  ab.conn = conn;
+
+  /* Read the command parameters. */
+  SVN_ERR(svn_ra_svn__parse_tuple(params, "c(?r)(?r)wbw", &path,
+                                  &start_rev, &end_rev, &ignore_space,
+                                  &ignore_eol_style, &algorithm));
+
+  full_path = svn_fspath__join(b->repository->fs_path->data,
+                               svn_relpath_canonicalize(path, pool), pool);
+
+  diff_options = svn_diff_file_options_create(pool);
+  if (strcmp(ignore_space, "change") == 0)
+    diff_options->ignore_space = svn_diff_file_ignore_space_change;
+  else if (strcmp(ignore_space, "all") == 0)
+    diff_options->ignore_space = svn_diff_file_ignore_space_all;
+  diff_options->ignore_eol_style = ignore_eol_style;
+  if (strcmp(algorithm, "histogram") == 0)
+    diff_options->algorithm = svn_diff_algorithm_histogram;
+
+  /* Check authorizations */
+  SVN_ERR(must_have_access(conn, pool, b, svn_authz_read,
+                           full_path, FALSE));
+
+  SVN_ERR(log_command(b, conn, pool, "%s",
+                      svn_log__blame(full_path, start_rev, end_rev, pool)));
+
+  rb.conn = conn;
+  rb.sent_revs = apr_hash_make(pool);
+  rb.pool = pool;
+
+  err = svn_repos_blame(b->repository->repos, full_path, start_rev, end_rev,
+                        diff_options, authz_check_access_cb_func(b), &ab,
+                        blame_receiver, &rb, NULL, NULL, pool);
+
+  /* Finish response. */
+  write_err = svn_ra_svn__write_word(conn, pool, "done");
+  if (write_err)
+    {
+      svn_error_clear(err);
+      return write_err;
+    }
+  SVN_CMD_ERR(err);
+
+  return svn_error_trace(svn_ra_svn__write_cmd_response(conn, pool, ""));
+}
+
+/* Commands that may be part of a batch.  They must not read any further
+   input from the client. */
+static const svn_ra_svn__cmd_entry_t batch_commands[] = {
+  { "rev-proplist",    rev_proplist },
+  { "rev-prop",        rev_prop },
+  { "get-file",        get_file },
+  { "get-dir",         get_dir },
+  { "check-path",      check_path },
+  { "stat",            stat_cmd },
+  { "get-lock",        get_lock },
+  { "get-iprops",      get_inherited_props },
+  { NULL }
+};
+
+/* Run the commands of a batch in order, sending one response for each.
+ * The client may have sent further commands already, so we must not
+ * start an authentication exchange; commands that require one fail and
+ * the client retries them on their own. */
+static svn_error_t *
+batch(svn_ra_svn_conn_t *conn,
+      apr_pool_t *pool,
+      svn_ra_svn__list_t *params,
+      void *baton)
+{
+  server_baton_t *b = baton;
+  svn_error_t *err;
+
+  b->in_batch = TRUE;
+  err = svn_ra_svn__handle_batch(conn, pool, params, batch_commands, b);
+  b->in_batch = FALSE;
+
+  return svn_error_trace(err);
+}
+
 static const svn_ra_svn__cmd_entry_t main_commands[] = {
   { "reparent",        reparent },
   { "get-latest-rev",  get_latest_rev },
@@ -3688,6 +3951,8 @@ static const svn_ra_svn__cmd_entry_t main_commands[] = {
   { "get-deleted-rev", get_deleted_rev },
   { "get-iprops",      get_inherited_props },
   { "list",            list },
+  { "blame",           blame },
+  { "batch",           batch },
   { NULL }
 };
 
@@ -3769,6 +4034,7 @@ find_repos(const char *url,
 {
   const char *path, *full_path, *fs_path, *hooks_env;
   svn_stringbuf_t *url_buf;
+  apr_int64_t list_jobs;
 
   /* Skip past the scheme and authority part. */
   path = skip_scheme_part(url);
@@ -3881,6 +4147,23 @@ find_repos(const char *url,
 
   repository->hooks_env = apr_pstrdup(result_pool, hooks_env);
 
+  /* Shall we record and reuse replays? */
+  SVN_ERR(svn_config_get_bool(cfg, &repository->use_replay_cache,
+                              SVN_CONFIG_SECTION_GENERAL,
+                              SVN_CONFIG_OPTION_REPLAY_CACHE, FALSE));
+
+  /* Shall we record and reuse location segments? */
+  SVN_ERR(svn_config_get_bool(cfg, &repository->use_segments_cache,
+                              SVN_CONFIG_SECTION_GENERAL,
+                              SVN_CONFIG_OPTION_SEGMENTS_CACHE, FALSE));
+
+  /* Parallel recursive listings need thread-safe caches. */
+  SVN_ERR(svn_config_get_int64(cfg, &list_jobs, SVN_CONFIG_SECTION_GENERAL,
+                               SVN_CONFIG_OPTION_LIST_JOBS, 1));
+  repository->list_jobs = svn_cache_config_get()->single_threaded
+                        ? 1
+                        : (int)MAX(1, MIN(list_jobs, 64));
+
   return SVN_NO_ERROR;
 }
 
@@ -3905,134 +4188,6 @@ fs_warning_func(void *baton, svn_error_t *err)
   log_error(err, b->server);
 }
 
-/* Return the normalized repository-relative path for the given PATH
- * (may be a URL, full path or relative path) and fs contained in the
- * server baton BATON. Allocate the result in POOL.
- */
-static const char *
-get_normalized_repo_rel_path(void *baton,
-                             const char *path,
-                             apr_pool_t *pool)
-{
-  server_baton_t *sb = baton;
-
-  if (svn_path_is_url(path))
-    {
-      /* This is a copyfrom URL. */
-      path = svn_uri_skip_ancestor(sb->repository->repos_url, path, pool);
-      path = svn_fspath__canonicalize(path, pool);
-    }
-  else
-    {
-      /* This is a base-relative path. */
-      if ((path)[0] != '/')
-        /* Get an absolute path for use in the FS. */
-        path = svn_fspath__join(sb->repository->fs_path->data, path, pool);
-    }
-
-  return path;
-}
-
-/* Get the revision root for REVISION in fs given by server baton BATON
- * and return it in *FS_ROOT. Use HEAD if REVISION is SVN_INVALID_REVNUM.
- * Use POOL for allocations.
- */
-static svn_error_t *
-get_revision_root(svn_fs_root_t **fs_root,
-                  void *baton,
-                  svn_revnum_t revision,
-                  apr_pool_t *pool)
-{
-  server_baton_t *sb = baton;
-
-  if (!SVN_IS_VALID_REVNUM(revision))
-    SVN_ERR(svn_fs_youngest_rev(&revision, sb->repository->fs, pool));
-
-  SVN_ERR(svn_fs_revision_root(fs_root, sb->repository->fs, revision, pool));
-
-  return SVN_NO_ERROR;
-}
-
-static svn_error_t *
-fetch_props_func(apr_hash_t **props,
-                 void *baton,
-                 const char *path,
-                 svn_revnum_t base_revision,
-                 apr_pool_t *result_pool,
-                 apr_pool_t *scratch_pool)
-{
-  svn_fs_root_t *fs_root;
-  svn_error_t *err;
-
-  path = get_normalized_repo_rel_path(baton, path, scratch_pool);
-  SVN_ERR(get_revision_root(&fs_root, baton, base_revision, scratch_pool));
-
-  err = svn_fs_node_proplist(props, fs_root, path, result_pool);
-  if (err && err->apr_err == SVN_ERR_FS_NOT_FOUND)
-    {
-      svn_error_clear(err);
-      *props = apr_hash_make(result_pool);
-      return SVN_NO_ERROR;
-    }
-  else if (err)
-    return svn_error_trace(err);
-
-  return SVN_NO_ERROR;
-}
-
-static svn_error_t *
-fetch_kind_func(svn_node_kind_t *kind,
-                void *baton,
-                const char *path,
-                svn_revnum_t base_revision,
-                apr_pool_t *scratch_pool)
-{
-  svn_fs_root_t *fs_root;
-
-  path = get_normalized_repo_rel_path(baton, path, scratch_pool);
-  SVN_ERR(get_revision_root(&fs_root, baton, base_revision, scratch_pool));
-
-  SVN_ERR(svn_fs_check_path(kind, fs_root, path, scratch_pool));
-
-  return SVN_NO_ERROR;
-}
-
-static svn_error_t *
-fetch_base_func(const char **filename,
-                void *baton,
-                const char *path,
-                svn_revnum_t base_revision,
-                apr_pool_t *result_pool,
-                apr_pool_t *scratch_pool)
-{
-  svn_stream_t *contents;
-  svn_stream_t *file_stream;
-  const char *tmp_filename;
-  svn_fs_root_t *fs_root;
-  svn_error_t *err;
-
-  path = get_normalized_repo_rel_path(baton, path, scratch_pool);
-  SVN_ERR(get_revision_root(&fs_root, baton, base_revision, scratch_pool));
-
-  err = svn_fs_file_contents(&contents, fs_root, path, scratch_pool);
-  if (err && err->apr_err == SVN_ERR_FS_NOT_FOUND)
-    {
-      svn_error_clear(err);
-      *filename = NULL;
-      return SVN_NO_ERROR;
-    }
-  else if (err)
-    return svn_error_trace(err);
-  SVN_ERR(svn_stream_open_unique(&file_stream, &tmp_filename, NULL,
-                                 svn_io_file_del_on_pool_cleanup,
-                                 scratch_pool, scratch_pool));
-  SVN_ERR(svn_stream_copy3(contents, file_stream, NULL, NULL, scratch_pool));
-
-  *filename = apr_pstrdup(result_pool, tmp_filename);
-
-  return SVN_NO_ERROR;
-}
-
 client_info_t *
 get_client_info(svn_ra_svn_conn_t *conn,
                 serve_params_t *params,
@@ -4061,6 +4216,7 @@ construct_server_baton(server_baton_t **baton,
   svn_error_t *err, *io_err;
   apr_uint64_t ver;
   const char *client_url, *ra_client_string, *client_string;
+  const char *trace_id = NULL;
   svn_ra_svn__list_t *caplist;
   apr_pool_t *conn_pool = svn_ra_svn__get_pool(conn);
   server_baton_t *b = apr_pcalloc(conn_pool, sizeof(*b));
@@ -4078,15 +4234,18 @@ construct_server_baton(server_baton_t **baton,
   b->read_only = params->read_only;
   b->pool = conn_pool;
   b->vhost = params->vhost;
+  b->admission = params->admission;
 
   b->logger = params->logger;
   b->client_info = get_client_info(conn, params, conn_pool);
 
+  svn_ra_svn__set_adaptive_compression(conn, params->adaptive_compression);
+
   /* Send greeting.  We don't support version 1 any more, so we can
    * send an empty mechlist. */
   if (params->compression_level > 0)
     SVN_ERR(svn_ra_svn__write_cmd_response(conn, scratch_pool,
-                                           "nn()(wwwwwwwwwwww)",
+                                           "nn()(wwwwwwwwwwwwww?w)",
                                            (apr_uint64_t) 2, (apr_uint64_t) 2,
                                            SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                            SVN_RA_SVN_CAP_SVNDIFF1,
@@ -4099,11 +4258,14 @@ construct_server_baton(server_baton_t **baton,
                                            SVN_RA_SVN_CAP_INHERITED_PROPS,
                                            SVN_RA_SVN_CAP_EPHEMERAL_TXNPROPS,
                                            SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE,
-                                           SVN_RA_SVN_CAP_LIST
+                                           SVN_RA_SVN_CAP_LIST,
+                                           SVN_RA_SVN_CAP_BLAME,
+                                           SVN_RA_SVN_CAP_BATCH,
+                                           svn_ra_svn__svndiff2_capability()
                                            ));
   else
     SVN_ERR(svn_ra_svn__write_cmd_response(conn, scratch_pool,
-                                           "nn()(wwwwwwwwwww)",
+                                           "nn()(wwwwwwwwwwwww)",
                                            (apr_uint64_t) 2, (apr_uint64_t) 2,
                                            SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                            SVN_RA_SVN_CAP_ABSENT_ENTRIES,
@@ -4115,16 +4277,18 @@ construct_server_baton(server_baton_t **baton,
                                            SVN_RA_SVN_CAP_INHERITED_PROPS,
                                            SVN_RA_SVN_CAP_EPHEMERAL_TXNPROPS,
                                            SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE,
-                                           SVN_RA_SVN_CAP_LIST
+                                           SVN_RA_SVN_CAP_LIST,
+                                           SVN_RA_SVN_CAP_BLAME,
+                                           SVN_RA_SVN_CAP_BATCH
                                            ));
 
   /* Read client response, which we assume to be in version 2 format:
    * version, capability list, and client URL; then we do an auth
    * request. */
-  SVN_ERR(svn_ra_svn__read_tuple(conn, scratch_pool, "nlc?c(?c)",
+  SVN_ERR(svn_ra_svn__read_tuple(conn, scratch_pool, "nlc?c(?c)?c",
                                  &ver, &caplist, &client_url,
                                  &ra_client_string,
-                                 &client_string));
+                                 &client_string, &trace_id));
   if (ver != 2)
     return SVN_NO_ERROR;
 
@@ -4237,32 +4401,60 @@ construct_server_baton(server_baton_t **baton,
     client_string = "-";
   else
     client_string = svn_path_uri_encode(client_string, scratch_pool);
+  if (trace_id == NULL || trace_id[0] == '\0')
+    trace_id = "-";
+  else
+    trace_id = svn_path_uri_encode(trace_id, scratch_pool);
   SVN_ERR(log_command(b, conn, scratch_pool,
-                      "open %" APR_UINT64_T_FMT " cap=(%s) %s %s %s",
+                      "open %" APR_UINT64_T_FMT " cap=(%s) %s %s %s %s",
                       ver, cap_log->data,
                       svn_path_uri_encode(b->repository->fs_path->data,
                                           scratch_pool),
-                      ra_client_string, client_string));
+                      ra_client_string, client_string, trace_id));
 
   warn_baton = apr_pcalloc(conn_pool, sizeof(*warn_baton));
   warn_baton->server = b;
   warn_baton->conn = conn;
   svn_fs_set_warning_func(b->repository->fs, fs_warning_func, warn_baton);
 
-  /* Set up editor shims. */
-  {
-    svn_delta_shim_callbacks_t *callbacks =
-                                svn_delta_shim_callbacks_default(conn_pool);
+  *baton = b;
 
-    callbacks->fetch_base_func = fetch_base_func;
-    callbacks->fetch_props_func = fetch_props_func;
-    callbacks->fetch_kind_func = fetch_kind_func;
-    callbacks->fetch_baton = b;
+  return SVN_NO_ERROR;
+}
 
-    SVN_ERR(svn_ra_svn__set_shim_callbacks(conn, callbacks));
-  }
+/* Add the command that has just been handled on CONNECTION to the
+   server's statistics and log it if it was slow.  Use SCRATCH_POOL for
+   temporary allocations. */
+static svn_error_t *
+record_command(connection_t *connection,
+               apr_pool_t *scratch_pool)
+{
+  serve_params_t *params = connection->params;
+  server_baton_t *b = connection->baton;
+  const char *cmdname;
+  apr_time_t started;
+  apr_interval_time_t duration;
+  apr_uint64_t bytes_in, bytes_out;
+
+  svn_ra_svn__get_command_info(&cmdname, &started, &bytes_in, &bytes_out,
+                               connection->conn);
+
+  /* Unknown commands have not been executed. */
+  if (cmdname == NULL)
+    return SVN_NO_ERROR;
 
-  *baton = b;
+  duration = apr_time_now() - started;
+  if (params->command_stats)
+    SVN_ERR(cmdstats__add(params->command_stats, b->repository->repos_name,
+                          cmdname, duration, bytes_in, bytes_out));
+
+  if (params->slow_command_threshold
+      && duration >= params->slow_command_threshold)
+    SVN_ERR(log_command(b, connection->conn, scratch_pool,
+                        "slow-command %s %" APR_TIME_T_FMT "ms"
+                        " in %" APR_UINT64_T_FMT " out %" APR_UINT64_T_FMT,
+                        cmdname, apr_time_as_msec(duration),
+                        bytes_in, bytes_out));
 
   return SVN_NO_ERROR;
 }
@@ -4277,6 +4469,9 @@ serve_interruptable(svn_boolean_t *terminate_p,
   svn_error_t *err = NULL;
   const svn_ra_svn__cmd_entry_t *command;
   apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_boolean_t collect_stats
+    = connection->params->command_stats
+      || connection->params->slow_command_threshold;
 
   /* Prepare command parser. */
   apr_hash_t *cmd_hash = apr_hash_make(pool);
@@ -4325,6 +4520,7 @@ serve_interruptable(svn_boolean_t *terminate_p,
   while (!terminate && !err)
     {
       svn_pool_clear(iterpool);
+      connection->baton->expensive_command = FALSE;
       if (is_busy && is_busy(connection))
         {
           svn_boolean_t has_command;
@@ -4335,10 +4531,14 @@ serve_interruptable(svn_boolean_t *terminate_p,
           err = svn_ra_svn__has_command(&has_command, &terminate,
                                         connection->conn, iterpool);
           if (!err && has_command)
-            err = svn_ra_svn__handle_command(&terminate, cmd_hash,
-                                             connection->baton,
-                                             connection->conn,
-                                             FALSE, iterpool);
+            {
+              err = svn_ra_svn__handle_command(&terminate, cmd_hash,
+                                               connection->baton,
+                                               connection->conn,
+                                               FALSE, iterpool);
+              if (!err && collect_stats)
+                err = record_command(connection, iterpool);
+            }
 
           break;
         }
@@ -4353,6 +4553,8 @@ serve_interruptable(svn_boolean_t *terminate_p,
                                            connection->baton,
                                            connection->conn,
                                            FALSE, iterpool);
+          if (!err && collect_stats)
+            err = record_command(connection, iterpool);
         }
     }
 
@@ -27,6 +27,9 @@
 #define SERVER_H
 
 #include <apr_network_io.h>
+#if APR_HAS_THREADS
+#include <apr_thread_pool.h>
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -58,6 +61,9 @@ typedef struct repository_t {
   const char *realm;       /* Authentication realm */
   const char *repos_url;   /* URL to base of repository */
   const char *hooks_env;   /* Path to the hooks environment file or NULL */
+  svn_boolean_t use_replay_cache; /* Serve replays from the replay cache */
+  svn_boolean_t use_segments_cache; /* Cache location segments on disk */
+  int list_jobs;           /* Threads to use for recursive listings */
   const char *uuid;        /* Repository ID */
   apr_array_header_t *capabilities;
                            /* Client capabilities (SVN_RA_CAPABILITY_*) */
@@ -90,6 +96,11 @@ typedef struct server_baton_t {
                               May be NULL even if log_file is not. */
   svn_boolean_t read_only; /* Disallow write access (global flag) */
   svn_boolean_t vhost;     /* Use virtual-host-based path to repo. */
+  svn_boolean_t in_batch;  /* Running a command of a batch; the client
+                              can't answer an authentication request. */
+  struct admission_t *admission; /* Limits on expensive commands;
+                                    possibly NULL. */
+  svn_boolean_t expensive_command; /* The last command was expensive */
   apr_pool_t *pool;
 } server_baton_t;
 
@@ -146,6 +157,10 @@ typedef struct serve_params_t {
      Defaults to SVN_DELTA_COMPRESSION_LEVEL_DEFAULT. */
   int compression_level;
 
+  /* If set, adapt the compression of each connection to its measured
+     throughput and don't compress contents that are compressed already. */
+  svn_boolean_t adaptive_compression;
+
   /* Item size up to which we use the zero-copy code path to transmit
      them over the network.  0 disables that code path. */
   apr_size_t zero_copy_limit;
@@ -162,6 +177,16 @@ typedef struct serve_params_t {
 
   /* Use virtual-host-based path to repo. */
   svn_boolean_t vhost;
+
+  /* Latency and traffic statistics per command and repository;
+     possibly NULL. */
+  struct cmdstats_t *command_stats;
+
+  /* If not 0, log commands that take at least this long. */
+  apr_interval_time_t slow_command_threshold;
+
+  /* Limits on concurrent expensive commands; possibly NULL. */
+  struct admission_t *admission;
 } serve_params_t;
 
 /* This structure contains all data that describes a client / server
@@ -195,6 +220,12 @@ typedef struct connection_t
      released.  */
   svn_atomic_t ref_count;
 
+#if APR_HAS_THREADS
+  /* In threaded mode, the worker threads of the acceptor that accepted
+     this connection. */
+  apr_thread_pool_t *threads;
+#endif
+
 } connection_t;
 
 /* Return a client_info_t structure allocated in POOL and initialize it
@@ -49,17 +49,23 @@
 #include "svn_version.h"
 #include "svn_io.h"
 #include "svn_hash.h"
+#include "svn_sorts.h"
+#include "svn_time.h"
 
 #include "svn_private_config.h"
 
 #include "private/svn_dep_compat.h"
 #include "private/svn_cmdline_private.h"
 #include "private/svn_atomic.h"
+#include "private/svn_cache.h"
 #include "private/svn_mutex.h"
+#include "private/svn_ra_svn_private.h"
+#include "private/svn_repos_private.h"
 #include "private/svn_subr_private.h"
 
 #if APR_HAS_THREADS
 #    include <apr_thread_pool.h>
+#    include <apr_poll.h>
 #endif
 
 #include "winservice.h"
@@ -68,8 +74,20 @@
 #include <unistd.h>   /* For getpid() */
 #endif
 
+#ifdef __linux__
+#include <sched.h>    /* For sched_setaffinity() */
+#endif
+
+/* Several sockets can listen on the same port only with SO_REUSEPORT.
+   Without it, all acceptors share a single socket. */
+#if defined(SO_REUSEPORT) && !defined(WIN32)
+#define HAVE_REUSEPORT
+#endif
+
 #include "server.h"
 #include "logger.h"
+#include "cmdstats.h"
+#include "admission.h"
 
 /* The strategy for handling incoming connections.  Some of these may be
    unavailable due to platform limitations. */
@@ -137,6 +155,10 @@ enum run_mode {
 #define THREADPOOL_MAX_SIZE 256
 #endif
 
+/* Default maximum number of post-event hooks waiting for one of the
+   --async-hooks workers before new invocations get blocked. */
+#define HOOK_QUEUE_SIZE 64
+
 /* Number of microseconds that an unused thread remains in the pool before
  * being terminated.
  *
@@ -145,6 +167,12 @@ enum run_mode {
  */
 #define THREADPOOL_THREAD_IDLE_LIMIT 1000000
 
+/* Maximum number of parked connections handed back to the worker threads
+ * per wake-up of the parking thread.  This is not a limit on the number
+ * of parked connections.
+ */
+#define PARKED_CONNECTIONS_BATCH 1024
+
 /* Number of client to server connections that may concurrently in the
  * TCP 3-way handshake state, i.e. are in the process of being created.
  *
@@ -222,6 +250,20 @@ void winservice_notify_stop(void)
 #define SVNSERVE_OPT_MAX_REQUEST     274
 #define SVNSERVE_OPT_MAX_RESPONSE    275
 #define SVNSERVE_OPT_CACHE_NODEPROPS 276
+#define SVNSERVE_OPT_CACHE_SHARED    277
+#define SVNSERVE_OPT_CACHE_SNAPSHOT  278
+#define SVNSERVE_OPT_CACHE_ADMISSION 279
+#define SVNSERVE_OPT_CACHE_STATS     280
+#define SVNSERVE_OPT_ASYNC_HOOKS     281
+#define SVNSERVE_OPT_HOOK_QUEUE      282
+#define SVNSERVE_OPT_COMMAND_STATS   283
+#define SVNSERVE_OPT_SLOW_COMMAND    284
+#define SVNSERVE_OPT_EXPENSIVE_REPOS 285
+#define SVNSERVE_OPT_EXPENSIVE_USER  286
+#define SVNSERVE_OPT_CACHE_QUOTA     287
+#define SVNSERVE_OPT_ADAPTIVE_COMPRESSION 288
+#define SVNSERVE_OPT_ACCEPTORS       289
+#define SVNSERVE_OPT_PIN_ACCEPTORS   290
 
 /* Text macro because we can't use #ifdef sections inside a N_("...")
    macro expansion. */
@@ -287,6 +329,12 @@ static const apr_getopt_option_t svnserve__options[] =
         "[0 .. no compression, 5 .. default, \n"
         "                             "
         " 9 .. maximum compression]")},
+    {"adaptive-compression", SVNSERVE_OPT_ADAPTIVE_COMPRESSION, 0,
+     N_("adjust the compression of each connection to its\n"
+        "                             "
+        "measured throughput, starting at the --compression\n"
+        "                             "
+        "level, and send already compressed contents as-is")},
     {"memory-cache-size", 'M', 1,
      N_("size of the extra in-memory cache in MB used to\n"
         "                             "
@@ -333,6 +381,28 @@ static const apr_getopt_option_t svnserve__options[] =
         "ARG Mbit/s.\n"
         "                             "
         "Default is 0 (optimizations disabled).")},
+    {"memory-cache-prefix-quota", SVNSERVE_OPT_CACHE_QUOTA, 1,
+     N_("limit the data that a single repository may keep\n"
+        "                             "
+        "in each of its in-memory caches to ARG MB such\n"
+        "                             "
+        "that busy repositories can't evict the data of\n"
+        "                             "
+        "all others.  Not available with\n"
+        "                             "
+        "--memory-cache-shared.\n"
+        "                             "
+        "Default is 0 (unlimited).")},
+    {"cache-admission-filter", SVNSERVE_OPT_CACHE_ADMISSION, 1,
+     N_("prevent one-off scans from evicting frequently\n"
+        "                             "
+        "used data from the cache by estimating access\n"
+        "                             "
+        "frequencies.  Not available with\n"
+        "                             "
+        "--memory-cache-shared.\n"
+        "                             "
+        "Default is no.")},
     {"block-read", SVNSERVE_OPT_BLOCK_READ, 1,
      N_("Parse and cache all data found in block instead\n"
         "                             "
@@ -341,6 +411,50 @@ static const apr_getopt_option_t svnserve__options[] =
         "Default is no.\n"
         "                             "
         "[used for FSFS repositories in 1.9 format only]")},
+    {"memory-cache-shared", SVNSERVE_OPT_CACHE_SHARED, 0,
+     N_("share the in-memory cache between all forked\n"
+        "                             "
+        "connection processes instead of giving each\n"
+        "                             "
+        "process its own, smaller copy.\n"
+        "                             "
+        "[mode: daemon, fork]")},
+    {"memory-cache-snapshot", SVNSERVE_OPT_CACHE_SNAPSHOT, 1,
+     N_("restore the in-memory cache contents from file\n"
+        "                             "
+        "ARG at startup and save them there again when\n"
+        "                             "
+        "terminated by SIGTERM.  In fork mode, this is\n"
+        "                             "
+        "only useful with --memory-cache-shared.\n"
+        "                             "
+        "[mode: daemon]")},
+    {"cache-stats-file", SVNSERVE_OPT_CACHE_STATS, 1,
+     N_("write per-prefix cache statistics as tab-\n"
+        "                             "
+        "separated values to file ARG upon SIGUSR1.\n"
+        "                             "
+        "Access counters cover the main process only,\n"
+        "                             "
+        "i.e. use this with --threads or --foreground.\n"
+        "                             "
+        "[mode: daemon]")},
+    {"command-stats-file", SVNSERVE_OPT_COMMAND_STATS, 1,
+     N_("write latency percentiles and traffic per\n"
+        "                             "
+        "command and per repository to file ARG upon\n"
+        "                             "
+        "SIGUSR1.  Counters cover the main process only,\n"
+        "                             "
+        "i.e. use this with --threads or --single-thread.\n"
+        "                             "
+        "[mode: daemon, listen-once]")},
+    {"slow-command-threshold", SVNSERVE_OPT_SLOW_COMMAND, 1,
+     N_("log commands that take at least ARG milliseconds\n"
+        "                             "
+        "to the --log-file.  Default is 0 (disabled).\n"
+        "                             "
+        "[mode: daemon, listen-once]")},
 #ifdef CONNECTION_HAVE_THREAD_OPTION
     /* ### Making the assumption here that WIN32 never has fork and so
      * ### this option never exists when --service exists. */
@@ -362,6 +476,60 @@ static const apr_getopt_option_t svnserve__options[] =
         "                             "
         "Default is " APR_STRINGIFY(THREADPOOL_MAX_SIZE) "."
         ONLY_AVAILABLE_WITH_THEADS)},
+    {"acceptors",        SVNSERVE_OPT_ACCEPTORS, 1,
+     N_("Accept connections in ARG threads, each with its\n"
+        "                             "
+        "own listening socket (where SO_REUSEPORT is\n"
+        "                             "
+        "available) and its own share of the server\n"
+        "                             "
+        "threads.  Default is 1."
+        ONLY_AVAILABLE_WITH_THEADS)},
+    {"pin-acceptors",    SVNSERVE_OPT_PIN_ACCEPTORS, 0,
+     N_("Bind each acceptor and the server threads it\n"
+        "                             "
+        "starts to a CPU of its own.  [Linux only]"
+        ONLY_AVAILABLE_WITH_THEADS)},
+    {"async-hooks",      SVNSERVE_OPT_ASYNC_HOOKS, 1,
+     N_("run post-commit, post-revprop-change, post-lock\n"
+        "                             "
+        "and post-unlock hooks in ARG background threads\n"
+        "                             "
+        "instead of making the client wait for them.\n"
+        "                             "
+        "Hook failures get logged instead of reported to\n"
+        "                             "
+        "the client.  Default is 0 (disabled).\n"
+        "                             "
+        "[mode: daemon with --threads or --single-thread,\n"
+        "                             "
+        " listen-once]")},
+    {"hook-queue-size",  SVNSERVE_OPT_HOOK_QUEUE, 1,
+     N_("Maximum number of hooks waiting for one of the\n"
+        "                             "
+        "--async-hooks threads.  Further commits block\n"
+        "                             "
+        "until their hook can be queued.  The current\n"
+        "                             "
+        "queue depth gets logged upon SIGUSR1.\n"
+        "                             "
+        "Default is " APR_STRINGIFY(HOOK_QUEUE_SIZE) ".")},
+    {"max-expensive-per-repos", SVNSERVE_OPT_EXPENSIVE_REPOS, 1,
+     N_("Maximum number of expensive commands, like log,\n"
+        "                             "
+        "update or list, running concurrently on the same\n"
+        "                             "
+        "repository.  Further ones wait for their turn.\n"
+        "                             "
+        "Default is 0 (unlimited).\n"
+        "                             "
+        "[mode: daemon with --threads or --single-thread]")},
+    {"max-expensive-per-user", SVNSERVE_OPT_EXPENSIVE_USER, 1,
+     N_("Like --max-expensive-per-repos but for each\n"
+        "                             "
+        "authenticated user.  Default is 0 (unlimited).\n"
+        "                             "
+        "[mode: daemon with --threads or --single-thread]")},
 #endif
     {"max-request-size", SVNSERVE_OPT_MAX_REQUEST, 1,
      N_("Maximum acceptable size of a client request in MB.\n"
@@ -492,6 +660,105 @@ static void sigchld_handler(int signo)
 }
 #endif
 
+/* Set by sigterm_handler to make the daemon leave its accept() loop. */
+static volatile sig_atomic_t shutdown_requested = FALSE;
+
+#ifdef SIGTERM
+static void sigterm_handler(int signo)
+{
+  /* The interrupted accept() will check this flag. */
+  shutdown_requested = TRUE;
+}
+#endif
+
+/* Set by sigusr1_handler to make the daemon write its cache statistics
+   and log its hook queue depth. */
+static volatile sig_atomic_t stats_requested = FALSE;
+
+#ifdef SIGUSR1
+static void sigusr1_handler(int signo)
+{
+  /* The interrupted accept() will check this flag. */
+  stats_requested = TRUE;
+}
+#endif
+
+/* Write the global cache contents to the snapshot file at PATH, if that
+ * is not NULL.  Errors are reported to LOGGER.  Use SCRATCH_POOL for
+ * temporary allocations.
+ */
+static void
+save_cache_snapshot(const char *path,
+                    logger_t *logger,
+                    apr_pool_t *scratch_pool)
+{
+  if (path)
+    {
+      svn_error_t *err = svn_cache__save_global_membuffer_cache(path,
+                                                                scratch_pool);
+      logger__log_error(logger, err, NULL, NULL);
+      svn_error_clear(err);
+    }
+}
+
+/* Write the per-prefix statistics of the global cache to the file at PATH.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+write_cache_stats(const char *path,
+                  apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *info
+    = apr_array_make(scratch_pool, 0, sizeof(svn_cache__prefix_info_t *));
+  svn_membuffer_t *membuffer = svn_cache__get_global_membuffer_cache();
+  svn_string_t *text;
+
+  if (membuffer)
+    SVN_ERR(svn_cache__membuffer_get_prefix_info(&info, membuffer,
+                                                 scratch_pool, scratch_pool));
+
+  text = svn_cache__format_prefix_info(info, scratch_pool);
+  SVN_ERR(svn_io_write_atomic2(path, text->data, text->len, NULL, FALSE,
+                               scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos__hook_error_func_t.  Log the failure ERR of a
+ * background hook to the logger_t BATON.
+ */
+static void
+log_hook_error(void *baton,
+               svn_error_t *err)
+{
+  logger__log_error(baton, err, NULL, NULL);
+}
+
+/* Write the number of hooks waiting for an --async-hooks worker to
+ * LOGGER, if that is not NULL.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+static svn_error_t *
+log_hook_queue_depth(logger_t *logger,
+                     apr_pool_t *scratch_pool)
+{
+  apr_size_t depth;
+  const char *line;
+
+  if (logger == NULL)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_repos__hooks_async_queue_depth(&depth));
+  line = apr_psprintf(scratch_pool, "%" APR_PID_T_FMT
+                      " %s - - - hook-queue-depth %" APR_SIZE_T_FMT
+                      APR_EOL_STR,
+                      getpid(), svn_time_to_cstring(apr_time_now(),
+                                                    scratch_pool),
+                      depth);
+
+  return svn_error_trace(logger__write(logger, line, strlen(line)));
+}
+
 /* Redirect stdout to stderr.  ARG is the pool.
  *
  * In tunnel or inetd mode, we don't want hook scripts corrupting the
@@ -515,7 +782,8 @@ static apr_status_t redirect_stdout(void *arg)
 
 /* Wait for the next client connection to come in from SOCK.  Allocate
  * the connection in a root pool from CONNECTION_POOLS and assign PARAMS.
- * Return the connection object in *CONNECTION.
+ * Return the connection object in *CONNECTION.  If the server shall shut
+ * down or write its statistics, set *CONNECTION to NULL instead.
  *
  * Use HANDLING_MODE for proper internal cleanup.
  */
@@ -557,10 +825,18 @@ accept_connection(connection_t **connection,
             ;
         }
     }
-  while (APR_STATUS_IS_EINTR(status)
+  while ((APR_STATUS_IS_EINTR(status)
+            && !shutdown_requested && !stats_requested)
     || APR_STATUS_IS_ECONNABORTED(status)
     || APR_STATUS_IS_ECONNRESET(status));
 
+  if (shutdown_requested || (stats_requested && status))
+    {
+      svn_pool_destroy(connection_pool);
+      *connection = NULL;
+      return SVN_NO_ERROR;
+    }
+
   return status
        ? svn_error_wrap_apr(status, _("Can't accept client connection"))
        : SVN_NO_ERROR;
@@ -611,25 +887,135 @@ serve_socket(connection_t *connection,
    There should be at most THREADPOOL_MAX_SIZE such pools. */
 static svn_root_pools__t *connection_pools;
 
-/* The global thread pool serving all connections. */
+/* The thread pool serving all connections accepted by the main thread.
+   Additional acceptors have their own. */
 static apr_thread_pool_t *threads;
 
 /* Very simple load determination callback for serve_interruptable:
-   With less than half the threads in THREADS in use, we can afford to
-   wait in the socket read() function.  Otherwise, poll them round-robin. */
+   With less than half the threads serving CONNECTION in use, we can
+   afford to wait in the socket read() function.  Otherwise, poll them
+   round-robin. */
 static svn_boolean_t
 is_busy(connection_t *connection)
 {
-  return apr_thread_pool_threads_count(threads) * 2
-       > apr_thread_pool_thread_max_get(threads);
+  return apr_thread_pool_threads_count(connection->threads) * 2
+       > apr_thread_pool_thread_max_get(connection->threads);
+}
+
+/* Idle connections wait in this pollset for their next command instead
+   of being polled round-robin by the worker threads.  NULL if the platform
+   has no thread-safe pollset implementation (e.g. epoll or kqueue). */
+static apr_pollset_t *parked_connections;
+
+/* The thread waiting for PARKED_CONNECTIONS and the flag telling it to
+   exit. */
+static apr_thread_t *unpark_tid;
+static volatile svn_atomic_t unpark_stop = FALSE;
+
+static void * APR_THREAD_FUNC serve_thread(apr_thread_t *tid, void *data);
+
+/* Return the priority of CONNECTION in THREADS' task queue.  Connections
+   whose last command was expensive queue up behind all others, so that a
+   few large logs or updates can't delay quick commands like stat. */
+static apr_byte_t
+connection_priority(connection_t *connection)
+{
+  return connection->baton && connection->baton->expensive_command
+       ? APR_THREAD_TASK_PRIORITY_LOW
+       : APR_THREAD_TASK_PRIORITY_NORMAL;
+}
+
+/* Put the idle CONNECTION into PARKED_CONNECTIONS.  It will be handed
+   back to THREADS as soon as the client sends data. */
+static void
+park_connection(connection_t *connection)
+{
+  apr_pollfd_t pfd = { 0 };
+
+  pfd.p = connection->pool;
+  pfd.desc_type = APR_POLL_SOCKET;
+  pfd.reqevents = APR_POLLIN;
+  pfd.desc.s = connection->usock;
+  pfd.client_data = connection;
+
+  /* If we can't park it, fall back to polling it. */
+  if (apr_pollset_add(parked_connections, &pfd))
+    apr_thread_pool_push(connection->threads, serve_thread, connection,
+                         connection_priority(connection), NULL);
+}
+
+/* Thread function waiting for activity on PARKED_CONNECTIONS and
+   scheduling the respective connections in THREADS. */
+static void * APR_THREAD_FUNC unpark_thread(apr_thread_t *tid, void *data)
+{
+  while (TRUE)
+    {
+      const apr_pollfd_t *signalled;
+      apr_int32_t count, i;
+      apr_status_t status;
+
+      status = apr_pollset_poll(parked_connections, -1, &count, &signalled);
+      if (svn_atomic_read(&unpark_stop))
+        break;
+
+      if (status)
+        continue;
+
+      for (i = 0; i < count; i++)
+        {
+          connection_t *connection = signalled[i].client_data;
+
+          apr_pollset_remove(parked_connections, &signalled[i]);
+          apr_thread_pool_push(connection->threads, serve_thread, connection,
+                               connection_priority(connection), NULL);
+        }
+    }
+
+  return NULL;
+}
+
+/* Create PARKED_CONNECTIONS and the thread serving it in POOL.  Leave
+   PARKED_CONNECTIONS as NULL if that is not supported. */
+static void
+init_parked_connections(apr_pool_t *pool)
+{
+  /* Only the epoll, kqueue and event port implementations support
+     adding sockets while another thread is waiting for the pollset. */
+  if (apr_pollset_create(&parked_connections, PARKED_CONNECTIONS_BATCH,
+                         pool,
+                         APR_POLLSET_THREADSAFE | APR_POLLSET_WAKEABLE))
+    {
+      parked_connections = NULL;
+      return;
+    }
+
+  if (apr_thread_create(&unpark_tid, NULL, unpark_thread, NULL, pool))
+    parked_connections = NULL;
+}
+
+/* Make the thread serving PARKED_CONNECTIONS exit and wait for it.
+   Must be called before THREADS gets destroyed. */
+static void
+stop_parked_connections(void)
+{
+  apr_status_t retval;
+
+  if (!parked_connections)
+    return;
+
+  svn_atomic_set(&unpark_stop, TRUE);
+  apr_pollset_wakeup(parked_connections);
+  apr_thread_join(&retval, unpark_tid);
 }
 
 /* Serve the connection given by DATA.  Under high load, serve only
    the current command (if any) and then put the connection back into
-   THREAD's task pool. */
+   THREAD's task pool.  Connections without pending commands get parked
+   in PARKED_CONNECTIONS, if available. */
 static void * APR_THREAD_FUNC serve_thread(apr_thread_t *tid, void *data)
 {
   svn_boolean_t done;
+  svn_boolean_t idle = FALSE;
   connection_t *connection = data;
   svn_error_t *err;
 
@@ -637,6 +1023,18 @@ static void * APR_THREAD_FUNC serve_thread(apr_thread_t *tid, void *data)
 
   /* process the actual request and log errors */
   err = serve_interruptable(&done, connection, is_busy, pool);
+
+  /* Data that has already been read into the connection's buffer does
+     not wake up the pollset, so only park connections that have none. */
+  if (!err && !done && parked_connections)
+    {
+      svn_boolean_t has_command;
+
+      err = svn_ra_svn__has_command(&has_command, &done, connection->conn,
+                                    pool);
+      idle = !has_command;
+    }
+
   if (err)
     {
       logger__log_error(connection->params->logger, err, NULL,
@@ -647,17 +1045,306 @@ static void * APR_THREAD_FUNC serve_thread(apr_thread_t *tid, void *data)
     }
   svn_root_pools__release_pool(pool, connection_pools);
 
-  /* Close or re-schedule connection. */
+  /* Close, park or re-schedule connection. */
   if (done)
     close_connection(connection);
+  else if (idle)
+    park_connection(connection);
   else
-    apr_thread_pool_push(threads, serve_thread, connection, 0, NULL);
+    apr_thread_pool_push(connection->threads, serve_thread, connection,
+                         connection_priority(connection), NULL);
+
+  return NULL;
+}
+
+/* Create worker threads for connections in *POOL_P with MIN_THREADS to
+   MAX_THREADS threads.  Allocate them in POOL. */
+static svn_error_t *
+create_worker_threads(apr_thread_pool_t **pool_p,
+                      apr_size_t min_threads,
+                      apr_size_t max_threads,
+                      apr_pool_t *pool)
+{
+  apr_status_t status = apr_thread_pool_create(pool_p, min_threads,
+                                               max_threads, pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create thread pool"));
+
+  /* let idle threads linger for a while in case more requests are
+     coming in */
+  apr_thread_pool_idle_wait_set(*pool_p, THREADPOOL_THREAD_IDLE_LIMIT);
+
+  /* don't queue requests unless we reached the worker thread limit */
+  apr_thread_pool_threshold_set(*pool_p, 0);
+
+  return SVN_NO_ERROR;
+}
+
+/* Bind the calling thread to the CPU with index CPU, modulo the number
+   of CPUs this thread may currently run on.  Threads created later by
+   the calling thread inherit that binding.  Do nothing if CPU is
+   negative or the platform does not support it. */
+static void
+pin_to_cpu(int cpu)
+{
+#if defined(__linux__) && defined(CPU_SET)
+  cpu_set_t available, pinned;
+  int i, count;
+
+  if (cpu < 0 || sched_getaffinity(0, sizeof(available), &available))
+    return;
+
+  count = CPU_COUNT(&available);
+  if (count == 0)
+    return;
+
+  cpu %= count;
+  for (i = 0; i < CPU_SETSIZE; ++i)
+    if (CPU_ISSET(i, &available) && cpu-- == 0)
+      {
+        CPU_ZERO(&pinned);
+        CPU_SET(i, &pinned);
+
+        /* Not being able to pin the thread is no reason to fail. */
+        sched_setaffinity(0, sizeof(pinned), &pinned);
+        return;
+      }
+#endif
+}
+
+/* An additional thread accepting connections in threaded mode and the
+   worker threads serving them. */
+typedef struct acceptor_t
+{
+  /* Socket to accept connections from.  With SO_REUSEPORT, this is the
+     acceptor's own socket.  Otherwise, it is shared with the main
+     thread. */
+  apr_socket_t *sock;
+
+  /* server-global parameters */
+  serve_params_t *params;
+
+  /* Range of worker threads to use. */
+  apr_size_t min_threads;
+  apr_size_t max_threads;
+
+  /* CPU to pin the acceptor to or -1. */
+  int cpu;
+
+  /* The acceptor thread itself and its workers, once it is running. */
+  apr_thread_t *tid;
+  apr_thread_pool_t *threads;
+
+  /* Parent pool of all connections accepted by this acceptor. */
+  apr_pool_t *pool;
+} acceptor_t;
+
+/* All additional acceptors, i.e. an array of acceptor_t *.  NULL unless
+   --acceptors has been given in threaded mode. */
+static apr_array_header_t *acceptors = NULL;
+
+/* Set to tell the acceptors that their sockets are being shut down. */
+static volatile svn_atomic_t acceptors_stop = FALSE;
+
+/* Thread function accepting connections for the acceptor_t given by DATA
+   and scheduling them in its worker threads. */
+static void * APR_THREAD_FUNC acceptor_thread(apr_thread_t *tid, void *data)
+{
+  acceptor_t *acceptor = data;
+  svn_error_t *err;
+
+  /* Pin ourselves before creating workers so they will inherit it. */
+  pin_to_cpu(acceptor->cpu);
+  err = create_worker_threads(&acceptor->threads, acceptor->min_threads,
+                              acceptor->max_threads, acceptor->pool);
+
+  while (!err)
+    {
+      connection_t *connection;
+      apr_status_t status;
+
+      err = accept_connection(&connection, acceptor->sock, acceptor->params,
+                              connection_mode_thread, acceptor->pool);
+      if (svn_atomic_read(&acceptors_stop) || shutdown_requested)
+        {
+          svn_error_clear(err);
+          err = SVN_NO_ERROR;
+          if (connection)
+            close_connection(connection);
+          break;
+        }
+
+      if (err || connection == NULL)
+        continue;
+
+      connection->threads = acceptor->threads;
+      attach_connection(connection);
+
+      status = apr_thread_pool_push(acceptor->threads, serve_thread,
+                                    connection,
+                                    APR_THREAD_TASK_PRIORITY_NORMAL, NULL);
+      if (status)
+        {
+          err = svn_error_wrap_apr(status, _("Can't push task"));
+          close_connection(connection);
+        }
+
+      close_connection(connection);
+    }
+
+  logger__log_error(acceptor->params->logger, err, NULL, NULL);
+  svn_error_clear(err);
 
   return NULL;
 }
 
+/* Forward declaration. */
+static svn_error_t *
+create_listen_socket(apr_socket_t **sock,
+                     apr_sockaddr_t *sa,
+                     svn_boolean_t reuse_port,
+                     apr_pool_t *pool);
+
+/* Start COUNT additional acceptors accepting connections on SA, serving
+   them as configured in PARAMS.  If the platform does not support
+   SO_REUSEPORT, they accept from MAIN_SOCK instead.  Each one gets
+   MIN_THREADS to MAX_THREADS worker threads.  If PIN is set, pin them to
+   consecutive CPUs after the one that the main thread uses.  Allocate
+   everything in POOL. */
+static svn_error_t *
+start_acceptors(int count,
+                apr_socket_t *main_sock,
+                apr_sockaddr_t *sa,
+                serve_params_t *params,
+                apr_size_t min_threads,
+                apr_size_t max_threads,
+                svn_boolean_t pin,
+                apr_pool_t *pool)
+{
+  int i;
+
+  acceptors = apr_array_make(pool, count, sizeof(acceptor_t *));
+  for (i = 1; i <= count; ++i)
+    {
+      acceptor_t *acceptor = apr_pcalloc(pool, sizeof(*acceptor));
+      apr_status_t status;
+
+      acceptor->params = params;
+      acceptor->min_threads = min_threads;
+      acceptor->max_threads = max_threads;
+      acceptor->cpu = pin ? i : -1;
+      acceptor->pool = svn_pool_create(pool);
+
+#ifdef HAVE_REUSEPORT
+      SVN_ERR(create_listen_socket(&acceptor->sock, sa, TRUE,
+                                   acceptor->pool));
+#else
+      acceptor->sock = main_sock;
+#endif
+
+      status = apr_thread_create(&acceptor->tid, NULL, acceptor_thread,
+                                 acceptor, pool);
+      if (status)
+        return svn_error_wrap_apr(status,
+                                  _("Can't create acceptor thread"));
+
+      APR_ARRAY_PUSH(acceptors, acceptor_t *) = acceptor;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Make all additional acceptors exit, wait for them and destroy their
+   worker threads.  Must be called before the sockets get closed. */
+static void
+stop_acceptors(void)
+{
+  int i;
+
+  if (!acceptors)
+    return;
+
+  /* Shutting down the listening sockets wakes up blocked accept calls. */
+  svn_atomic_set(&acceptors_stop, TRUE);
+  for (i = 0; i < acceptors->nelts; ++i)
+    apr_socket_shutdown(APR_ARRAY_IDX(acceptors, i, acceptor_t *)->sock,
+                        APR_SHUTDOWN_READWRITE);
+
+  for (i = 0; i < acceptors->nelts; ++i)
+    {
+      acceptor_t *acceptor = APR_ARRAY_IDX(acceptors, i, acceptor_t *);
+      apr_status_t retval;
+
+      apr_thread_join(&retval, acceptor->tid);
+      if (acceptor->threads)
+        apr_thread_pool_destroy(acceptor->threads);
+    }
+}
+
 #endif
 
+/* Create a socket listening on SA in *SOCK.  Allow other sockets to
+   listen on the same port if REUSE_PORT is set.  Allocate it in POOL. */
+static svn_error_t *
+create_listen_socket(apr_socket_t **sock,
+                     apr_sockaddr_t *sa,
+                     svn_boolean_t reuse_port,
+                     apr_pool_t *pool)
+{
+  apr_status_t status;
+
+#ifdef MAX_SECS_TO_LINGER
+  /* ### old APR interface */
+  status = apr_socket_create(sock, sa->family, SOCK_STREAM, pool);
+#else
+  status = apr_socket_create(sock, sa->family, SOCK_STREAM, APR_PROTO_TCP,
+                             pool);
+#endif
+  if (status)
+    {
+      return svn_error_wrap_apr(status, _("Can't create server socket"));
+    }
+
+  /* Prevents "socket in use" errors when server is killed and quickly
+   * restarted. */
+  status = apr_socket_opt_set(*sock, APR_SO_REUSEADDR, 1);
+  if (status)
+    {
+      return svn_error_wrap_apr(status, _("Can't set options on server socket"));
+    }
+
+#ifdef HAVE_REUSEPORT
+  /* Let the kernel distribute connections among several sockets. */
+  if (reuse_port)
+    {
+      apr_os_sock_t os_sock;
+      int on = 1;
+
+      status = apr_os_sock_get(&os_sock, *sock);
+      if (!status && setsockopt(os_sock, SOL_SOCKET, SO_REUSEPORT,
+                                (void *)&on, sizeof(on)))
+        status = apr_get_netos_error();
+      if (status)
+        return svn_error_wrap_apr(status,
+                                  _("Can't set options on server socket"));
+    }
+#endif
+
+  status = apr_socket_bind(*sock, sa);
+  if (status)
+    {
+      return svn_error_wrap_apr(status, _("Can't bind server socket"));
+    }
+
+  status = apr_socket_listen(*sock, ACCEPT_BACKLOG);
+  if (status)
+    {
+      return svn_error_wrap_apr(status, _("Can't listen on server socket"));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Write the PID of the current process as a decimal number, followed by a
    newline to the file FILENAME, using POOL for temporary allocations. */
 static svn_error_t *write_pid_file(const char *filename, apr_pool_t *pool)
@@ -725,6 +1412,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   svn_boolean_t cache_txdeltas = TRUE;
   svn_boolean_t cache_revprops = FALSE;
   svn_boolean_t use_block_read = FALSE;
+  svn_boolean_t use_shared_cache = FALSE;
   apr_uint16_t port = SVN_RA_SVN_PORT;
   const char *host = NULL;
   int family = APR_INET;
@@ -739,9 +1427,18 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   const char *config_filename = NULL;
   const char *pid_filename = NULL;
   const char *log_filename = NULL;
+  const char *cache_snapshot = NULL;
+  const char *cache_stats_file = NULL;
+  const char *command_stats_file = NULL;
+  int max_expensive_per_repos = 0;
+  int max_expensive_per_user = 0;
   svn_node_kind_t kind;
   apr_size_t min_thread_count = THREADPOOL_MIN_SIZE;
   apr_size_t max_thread_count = THREADPOOL_MAX_SIZE;
+  int async_hook_threads = 0;
+  apr_size_t hook_queue_size = HOOK_QUEUE_SIZE;
+  int acceptor_count = 1;
+  svn_boolean_t pin_acceptors = FALSE;
 #ifdef SVN_HAVE_SASL
   SVN_ERR(cyrus_init(pool));
 #endif
@@ -768,10 +1465,14 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   params.vhost = FALSE;
   params.username_case = CASE_ASIS;
   params.memory_cache_size = (apr_uint64_t)-1;
+  params.adaptive_compression = FALSE;
   params.zero_copy_limit = 0;
   params.error_check_interval = 4096;
   params.max_request_size = MAX_REQUEST_SIZE * 0x100000;
   params.max_response_size = 0;
+  params.command_stats = NULL;
+  params.slow_command_threshold = 0;
+  params.admission = NULL;
 
   while (1)
     {
@@ -898,6 +1599,10 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
             params.compression_level = SVN_DELTA_COMPRESSION_LEVEL_MAX;
           break;
 
+        case SVNSERVE_OPT_ADAPTIVE_COMPRESSION:
+          params.adaptive_compression = TRUE;
+          break;
+
         case 'M':
           params.memory_cache_size = 0x100000 * apr_strtoi64(arg, NULL, 0);
           break;
@@ -922,6 +1627,47 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           use_block_read = svn_tristate__from_word(arg) == svn_tristate_true;
           break;
 
+        case SVNSERVE_OPT_CACHE_SHARED:
+          use_shared_cache = TRUE;
+          break;
+
+        case SVNSERVE_OPT_CACHE_QUOTA:
+          svn_cache__set_global_membuffer_prefix_quota(
+              0x100000 * apr_strtoi64(arg, NULL, 0));
+          break;
+
+        case SVNSERVE_OPT_CACHE_ADMISSION:
+          svn_cache__set_global_membuffer_admission_filter(
+              svn_tristate__from_word(arg) == svn_tristate_true);
+          break;
+
+        case SVNSERVE_OPT_CACHE_SNAPSHOT:
+          SVN_ERR(svn_utf_cstring_to_utf8(&cache_snapshot, arg, pool));
+          cache_snapshot = svn_dirent_internal_style(cache_snapshot, pool);
+          SVN_ERR(svn_dirent_get_absolute(&cache_snapshot, cache_snapshot,
+                                          pool));
+          break;
+
+        case SVNSERVE_OPT_CACHE_STATS:
+          SVN_ERR(svn_utf_cstring_to_utf8(&cache_stats_file, arg, pool));
+          cache_stats_file = svn_dirent_internal_style(cache_stats_file, pool);
+          SVN_ERR(svn_dirent_get_absolute(&cache_stats_file, cache_stats_file,
+                                          pool));
+          break;
+
+        case SVNSERVE_OPT_COMMAND_STATS:
+          SVN_ERR(svn_utf_cstring_to_utf8(&command_stats_file, arg, pool));
+          command_stats_file = svn_dirent_internal_style(command_stats_file,
+                                                         pool);
+          SVN_ERR(svn_dirent_get_absolute(&command_stats_file,
+                                          command_stats_file, pool));
+          break;
+
+        case SVNSERVE_OPT_SLOW_COMMAND:
+          params.slow_command_threshold
+            = apr_time_from_msec(apr_strtoi64(arg, NULL, 0));
+          break;
+
         case SVNSERVE_OPT_CLIENT_SPEED:
           {
             apr_size_t bandwidth = (apr_size_t)apr_strtoi64(arg, NULL, 0);
@@ -955,6 +1701,30 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           max_thread_count = (apr_size_t)apr_strtoi64(arg, NULL, 0);
           break;
 
+        case SVNSERVE_OPT_ASYNC_HOOKS:
+          async_hook_threads = (int)apr_strtoi64(arg, NULL, 0);
+          break;
+
+        case SVNSERVE_OPT_ACCEPTORS:
+          acceptor_count = (int)apr_strtoi64(arg, NULL, 0);
+          break;
+
+        case SVNSERVE_OPT_PIN_ACCEPTORS:
+          pin_acceptors = TRUE;
+          break;
+
+        case SVNSERVE_OPT_HOOK_QUEUE:
+          hook_queue_size = (apr_size_t)apr_strtoi64(arg, NULL, 0);
+          break;
+
+        case SVNSERVE_OPT_EXPENSIVE_REPOS:
+          max_expensive_per_repos = (int)apr_strtoi64(arg, NULL, 0);
+          break;
+
+        case SVNSERVE_OPT_EXPENSIVE_USER:
+          max_expensive_per_user = (int)apr_strtoi64(arg, NULL, 0);
+          break;
+
 #ifdef WIN32
         case SVNSERVE_OPT_SERVICE:
           if (run_mode != run_mode_service)
@@ -1071,12 +1841,32 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   else if (run_mode == run_mode_listen_once)
     SVN_ERR(logger__create_for_stderr(&params.logger, pool));
 
+  if (command_stats_file)
+    SVN_ERR(cmdstats__create(&params.command_stats, pool));
+
+  if (max_expensive_per_repos > 0 || max_expensive_per_user > 0)
+    SVN_ERR(admission__create(&params.admission, max_expensive_per_repos,
+                              max_expensive_per_user, pool));
+
   if (params.tunnel_user && run_mode != run_mode_tunnel)
     {
       return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
                _("Option --tunnel-user is only valid in tunnel mode"));
     }
 
+  /* Forked connection processes terminate without waiting for their
+   * queued hooks, so background hooks need the connections to be served
+   * by this process. */
+  if (async_hook_threads > 0
+      && (   run_mode == run_mode_inetd || run_mode == run_mode_tunnel
+          || (   run_mode != run_mode_listen_once
+              && handling_mode == connection_mode_fork)))
+    {
+      return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+               _("Option --async-hooks requires --threads or "
+                 "--single-thread in daemon mode, or listen-once mode"));
+    }
+
   if (run_mode == run_mode_inetd || run_mode == run_mode_tunnel)
     {
       apr_pool_t *connection_pool;
@@ -1202,37 +1992,10 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
     }
 
 
-#ifdef MAX_SECS_TO_LINGER
-  /* ### old APR interface */
-  status = apr_socket_create(&sock, sa->family, SOCK_STREAM, pool);
-#else
-  status = apr_socket_create(&sock, sa->family, SOCK_STREAM, APR_PROTO_TCP,
-                             pool);
-#endif
-  if (status)
-    {
-      return svn_error_wrap_apr(status, _("Can't create server socket"));
-    }
-
-  /* Prevents "socket in use" errors when server is killed and quickly
-   * restarted. */
-  status = apr_socket_opt_set(sock, APR_SO_REUSEADDR, 1);
-  if (status)
-    {
-      return svn_error_wrap_apr(status, _("Can't set options on server socket"));
-    }
-
-  status = apr_socket_bind(sock, sa);
-  if (status)
-    {
-      return svn_error_wrap_apr(status, _("Can't bind server socket"));
-    }
-
-  status = apr_socket_listen(sock, ACCEPT_BACKLOG);
-  if (status)
-    {
-      return svn_error_wrap_apr(status, _("Can't listen on server socket"));
-    }
+  SVN_ERR(create_listen_socket(&sock, sa,
+                               handling_mode == connection_mode_thread
+                                 && acceptor_count > 1,
+                               pool));
 
 #if APR_HAS_FORK
   if (run_mode != run_mode_listen_once && !foreground)
@@ -1242,6 +2005,18 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   apr_signal(SIGCHLD, sigchld_handler);
 #endif
 
+#ifdef SIGTERM
+  /* Terminate gracefully to be able to write the cache snapshot. */
+  if (cache_snapshot)
+    apr_signal(SIGTERM, sigterm_handler);
+#endif
+
+#ifdef SIGUSR1
+  /* Write cache statistics and log the hook queue depth on demand. */
+  if (cache_stats_file || command_stats_file || async_hook_threads > 0)
+    apr_signal(SIGUSR1, sigusr1_handler);
+#endif
+
 #ifdef SIGPIPE
   /* Disable SIGPIPE generation for the platforms that have it. */
   apr_signal(SIGPIPE, SIG_IGN);
@@ -1293,8 +2068,34 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       }
 
     svn_cache_config_set(&settings);
+
+    /* Forked connection processes may share a single cache that lives
+     * in shared memory.  It must be created before the first fork. */
+    if (use_shared_cache && handling_mode == connection_mode_fork)
+      SVN_ERR(svn_cache__create_shared_global_membuffer_cache(pool));
+
+    /* Warm up the cache.  A broken snapshot should not prevent us from
+     * serving requests, though. */
+    if (cache_snapshot)
+      {
+        err = svn_cache__load_global_membuffer_cache(cache_snapshot, pool);
+        logger__log_error(params.logger, err, NULL, NULL);
+        svn_error_clear(err);
+      }
   }
 
+  /* The workers drain the hook queue when POOL gets destroyed. */
+  if (async_hook_threads > 0)
+    {
+      if (hook_queue_size < 1)
+        hook_queue_size = 1;
+
+      SVN_ERR(svn_repos__hooks_async_init(async_hook_threads,
+                                          hook_queue_size,
+                                          log_hook_error, params.logger,
+                                          pool));
+    }
+
 #if APR_HAS_THREADS
   SVN_ERR(svn_root_pools__create(&connection_pools));
 
@@ -1306,21 +2107,27 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       if (min_thread_count > max_thread_count)
         min_thread_count = max_thread_count;
 
-      status = apr_thread_pool_create(&threads,
-                                      min_thread_count,
-                                      max_thread_count,
-                                      pool);
-      if (status)
-        {
-          return svn_error_wrap_apr(status, _("Can't create thread pool"));
-        }
-
-      /* let idle threads linger for a while in case more requests are
-         coming in */
-      apr_thread_pool_idle_wait_set(threads, THREADPOOL_THREAD_IDLE_LIMIT);
-
-      /* don't queue requests unless we reached the worker thread limit */
-      apr_thread_pool_threshold_set(threads, 0);
+      /* split the threads evenly among the acceptors */
+      if (acceptor_count < 1)
+        acceptor_count = 1;
+      min_thread_count /= acceptor_count;
+      max_thread_count = MAX(max_thread_count / acceptor_count, 1);
+
+      /* park idle connections while busy rather than polling them */
+      init_parked_connections(pool);
+
+      /* the main thread is the first acceptor.  Pin it only after all
+         other threads have been started such that they don't inherit
+         that binding. */
+      if (acceptor_count > 1)
+        SVN_ERR(start_acceptors(acceptor_count - 1, sock, sa, &params,
+                                min_thread_count, max_thread_count,
+                                pin_acceptors, pool));
+      if (pin_acceptors)
+        pin_to_cpu(0);
+
+      SVN_ERR(create_worker_threads(&threads, min_thread_count,
+                                    max_thread_count, pool));
     }
   else
     {
@@ -1333,10 +2140,48 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       connection_t *connection = NULL;
       SVN_ERR(accept_connection(&connection, sock, &params, handling_mode,
                                 pool));
+      if (stats_requested)
+        {
+          apr_pool_t *scratch_pool = svn_pool_create(pool);
+
+          stats_requested = FALSE;
+          if (cache_stats_file)
+            {
+              err = write_cache_stats(cache_stats_file, scratch_pool);
+              logger__log_error(params.logger, err, NULL, NULL);
+              svn_error_clear(err);
+            }
+
+          if (command_stats_file)
+            {
+              err = cmdstats__write(params.command_stats, command_stats_file,
+                                    scratch_pool);
+              logger__log_error(params.logger, err, NULL, NULL);
+              svn_error_clear(err);
+            }
+
+          if (async_hook_threads > 0)
+            {
+              err = log_hook_queue_depth(params.logger, scratch_pool);
+              logger__log_error(params.logger, err, NULL, NULL);
+              svn_error_clear(err);
+            }
+          svn_pool_destroy(scratch_pool);
+        }
+
+      if (connection == NULL)
+        {
+          if (shutdown_requested)
+            break;
+
+          continue;
+        }
+
       if (run_mode == run_mode_listen_once)
         {
           err = serve_socket(connection, connection->pool);
           close_connection(connection);
+          save_cache_snapshot(cache_snapshot, params.logger, pool);
           return err;
         }
 
@@ -1350,6 +2195,24 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
               /* the child would't listen to the main server's socket */
               apr_socket_close(sock);
 
+#ifdef SIGTERM
+              /* only the main server shall handle graceful shutdown */
+              if (cache_snapshot)
+                apr_signal(SIGTERM, SIG_DFL);
+#endif
+#ifdef SIGUSR1
+              if (cache_stats_file || command_stats_file)
+                apr_signal(SIGUSR1, SIG_DFL);
+#endif
+
+              /* re-attach to the shared cache (no-op if there is none) */
+              err = svn_cache__global_membuffer_child_init(connection->pool);
+              if (err)
+                {
+                  logger__log_error(params.logger, err, NULL, NULL);
+                  svn_error_clear(err);
+                }
+
               /* serve_socket() logs any error it returns, so ignore it. */
               svn_error_clear(serve_socket(connection, connection->pool));
               close_connection(connection);
@@ -1369,10 +2232,12 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
              particularly sophisticated strategy for a threaded server, it's
              little different from forking one process per connection. */
 #if APR_HAS_THREADS
+          connection->threads = threads;
           attach_connection(connection);
 
           status = apr_thread_pool_push(threads, serve_thread, connection,
-                                        0, NULL);
+                                        APR_THREAD_TASK_PRIORITY_NORMAL,
+                                        NULL);
           if (status)
             {
               return svn_error_wrap_apr(status, _("Can't push task"));
@@ -1389,7 +2254,10 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       close_connection(connection);
     }
 
-  /* NOTREACHED */
+  /* We only get here upon SIGTERM. */
+  save_cache_snapshot(cache_snapshot, params.logger, pool);
+
+  return SVN_NO_ERROR;
 }
 
 int
@@ -1422,6 +2290,8 @@ main(int argc, const char *argv[])
   /* Explicitly wait for all threads to exit.  As we found out with similar
      code in our C test framework, the memory pool cleanup below cannot be
      trusted to do the right thing. */
+  stop_acceptors();
+  stop_parked_connections();
   if (threads)
     apr_thread_pool_destroy(threads);
 #endif
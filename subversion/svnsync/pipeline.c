@@ -0,0 +1,813 @@
+/*
+ * pipeline.c :  Replay revisions ahead of their commits
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_thread_cond.h>
+#include <apr_thread_proc.h>
+
+#include "svn_delta.h"
+#include "svn_pools.h"
+#include "svn_props.h"
+#include "svn_ra.h"
+
+#include "private/svn_mutex.h"
+
+#include "sync.h"
+
+#include "svn_private_config.h"
+
+/* Don't buffer more than this many revisions ... */
+#define MAX_QUEUED_REVS 32
+
+/* ... or more than this many bytes of text deltas, unless the queue is
+   empty. */
+#define MAX_QUEUED_BYTES (32 * 1024 * 1024)
+
+#if APR_HAS_THREADS
+
+/* The kinds of editor calls that we record. */
+typedef enum op_kind_t
+{
+  op_set_target_revision,
+  op_open_root,
+  op_delete_entry,
+  op_add_directory,
+  op_open_directory,
+  op_change_dir_prop,
+  op_close_directory,
+  op_absent_directory,
+  op_add_file,
+  op_open_file,
+  op_apply_textdelta,
+  op_window,
+  op_change_file_prop,
+  op_close_file,
+  op_absent_file
+} op_kind_t;
+
+/* A recorded editor call.  Directory and file batons are identified by
+   the number of the call that opened them. */
+typedef struct recorded_op_t
+{
+  op_kind_t kind;
+
+  /* The baton that the call opens or works on. */
+  int id;
+
+  /* The parent directory baton, for calls that take one. */
+  int parent_id;
+
+  const char *path;
+  const char *copyfrom_path;
+  svn_revnum_t revision;
+  const char *name;
+  const svn_string_t *value;
+  const char *checksum;
+  svn_txdelta_window_t *window;
+} recorded_op_t;
+
+/* A recorded replay of one revision. */
+typedef struct recorded_rev_t
+{
+  svn_revnum_t revision;
+  apr_hash_t *rev_props;
+
+  /* The editor calls, recorded_op_t. */
+  apr_array_header_t *ops;
+
+  /* Number of batons opened by OPS. */
+  int baton_count;
+
+  /* Approximate size of the text deltas. */
+  apr_size_t size;
+
+  /* Everything above lives in this root pool. */
+  apr_pool_t *pool;
+
+  struct recorded_rev_t *next;
+} recorded_rev_t;
+
+/* Directory and file baton of the recording editor. */
+typedef struct node_baton_t
+{
+  recorded_rev_t *rev;
+  int id;
+} node_baton_t;
+
+/* The state shared by the replaying thread and the committing thread. */
+typedef struct pipeline_t
+{
+  svn_ra_session_t *from_session;
+  svn_revnum_t start_revision;
+  svn_revnum_t end_revision;
+  svn_revnum_t low_water_mark;
+  svn_boolean_t send_deltas;
+  svn_cancel_func_t cancel_func;
+
+  /* The revision being recorded.  Only used by the replaying thread. */
+  recorded_rev_t *current;
+
+  /* Everything below is protected by MUTEX.  Changes are signalled
+     through COND. */
+  svn_mutex__t *mutex;
+  apr_thread_cond_t *cond;
+
+  /* Recorded revisions that haven't been committed yet, oldest first. */
+  recorded_rev_t *first;
+  recorded_rev_t *last;
+  int queued_revs;
+  apr_size_t queued_bytes;
+
+  /* Set when the replay is over, with ERR saying how it ended. */
+  svn_boolean_t done;
+  svn_error_t *err;
+
+  /* Set when the committing thread doesn't take any more revisions. */
+  svn_boolean_t stop;
+} pipeline_t;
+
+
+/*** The recording editor. ***/
+
+/* Append a new operation of KIND on baton ID to REV and return it. */
+static recorded_op_t *
+add_op(recorded_rev_t *rev,
+       op_kind_t kind,
+       int id)
+{
+  recorded_op_t *op = apr_array_push(rev->ops);
+
+  memset(op, 0, sizeof(*op));
+  op->kind = kind;
+  op->id = id;
+  op->revision = SVN_INVALID_REVNUM;
+
+  return op;
+}
+
+/* Open a new baton for REV, record the operation of KIND that opens it
+   below PARENT_ID and set *BATON to it. */
+static recorded_op_t *
+add_open_op(void **baton,
+            recorded_rev_t *rev,
+            op_kind_t kind,
+            int parent_id)
+{
+  node_baton_t *nb = apr_palloc(rev->pool, sizeof(*nb));
+  recorded_op_t *op;
+
+  nb->rev = rev;
+  nb->id = rev->baton_count++;
+  op = add_op(rev, kind, nb->id);
+  op->parent_id = parent_id;
+
+  *baton = nb;
+  return op;
+}
+
+static svn_error_t *
+record_set_target_revision(void *edit_baton,
+                           svn_revnum_t target_revision,
+                           apr_pool_t *pool)
+{
+  recorded_rev_t *rev = edit_baton;
+
+  add_op(rev, op_set_target_revision, 0)->revision = target_revision;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_open_root(void *edit_baton,
+                 svn_revnum_t base_revision,
+                 apr_pool_t *pool,
+                 void **root_baton)
+{
+  recorded_rev_t *rev = edit_baton;
+
+  add_open_op(root_baton, rev, op_open_root, 0)->revision = base_revision;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_delete_entry(const char *path,
+                    svn_revnum_t revision,
+                    void *parent_baton,
+                    apr_pool_t *pool)
+{
+  node_baton_t *pb = parent_baton;
+  recorded_op_t *op = add_op(pb->rev, op_delete_entry, pb->id);
+
+  op->parent_id = pb->id;
+  op->path = apr_pstrdup(pb->rev->pool, path);
+  op->revision = revision;
+
+  return SVN_NO_ERROR;
+}
+
+/* Record adding or opening (KIND) PATH below PARENT_BATON, copied from
+   COPYFROM_PATH, or based on REVISION. */
+static svn_error_t *
+record_add_or_open(op_kind_t kind,
+                   const char *path,
+                   void *parent_baton,
+                   const char *copyfrom_path,
+                   svn_revnum_t revision,
+                   void **child_baton)
+{
+  node_baton_t *pb = parent_baton;
+  recorded_rev_t *rev = pb->rev;
+  recorded_op_t *op = add_open_op(child_baton, rev, kind, pb->id);
+
+  op->path = apr_pstrdup(rev->pool, path);
+  op->copyfrom_path = copyfrom_path ? apr_pstrdup(rev->pool, copyfrom_path)
+                                    : NULL;
+  op->revision = revision;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_add_directory(const char *path,
+                     void *parent_baton,
+                     const char *copyfrom_path,
+                     svn_revnum_t copyfrom_revision,
+                     apr_pool_t *pool,
+                     void **child_baton)
+{
+  return record_add_or_open(op_add_directory, path, parent_baton,
+                            copyfrom_path, copyfrom_revision, child_baton);
+}
+
+static svn_error_t *
+record_open_directory(const char *path,
+                      void *parent_baton,
+                      svn_revnum_t base_revision,
+                      apr_pool_t *pool,
+                      void **child_baton)
+{
+  return record_add_or_open(op_open_directory, path, parent_baton,
+                            NULL, base_revision, child_baton);
+}
+
+static svn_error_t *
+record_add_file(const char *path,
+                void *parent_baton,
+                const char *copyfrom_path,
+                svn_revnum_t copyfrom_revision,
+                apr_pool_t *pool,
+                void **file_baton)
+{
+  return record_add_or_open(op_add_file, path, parent_baton,
+                            copyfrom_path, copyfrom_revision, file_baton);
+}
+
+static svn_error_t *
+record_open_file(const char *path,
+                 void *parent_baton,
+                 svn_revnum_t base_revision,
+                 apr_pool_t *pool,
+                 void **file_baton)
+{
+  return record_add_or_open(op_open_file, path, parent_baton,
+                            NULL, base_revision, file_baton);
+}
+
+/* Record a property change (KIND) of NAME to VALUE on BATON. */
+static svn_error_t *
+record_change_prop(op_kind_t kind,
+                   void *baton,
+                   const char *name,
+                   const svn_string_t *value)
+{
+  node_baton_t *nb = baton;
+  recorded_rev_t *rev = nb->rev;
+  recorded_op_t *op = add_op(rev, kind, nb->id);
+
+  op->name = apr_pstrdup(rev->pool, name);
+  op->value = value ? svn_string_dup(value, rev->pool) : NULL;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_change_dir_prop(void *dir_baton,
+                       const char *name,
+                       const svn_string_t *value,
+                       apr_pool_t *pool)
+{
+  return record_change_prop(op_change_dir_prop, dir_baton, name, value);
+}
+
+static svn_error_t *
+record_change_file_prop(void *file_baton,
+                        const char *name,
+                        const svn_string_t *value,
+                        apr_pool_t *pool)
+{
+  return record_change_prop(op_change_file_prop, file_baton, name, value);
+}
+
+static svn_error_t *
+record_close_directory(void *dir_baton,
+                       apr_pool_t *pool)
+{
+  node_baton_t *nb = dir_baton;
+
+  add_op(nb->rev, op_close_directory, nb->id);
+
+  return SVN_NO_ERROR;
+}
+
+/* Record that PATH below PARENT_BATON is absent (KIND). */
+static svn_error_t *
+record_absent(op_kind_t kind,
+              const char *path,
+              void *parent_baton)
+{
+  node_baton_t *pb = parent_baton;
+  recorded_op_t *op = add_op(pb->rev, kind, pb->id);
+
+  op->parent_id = pb->id;
+  op->path = apr_pstrdup(pb->rev->pool, path);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_absent_directory(const char *path,
+                        void *parent_baton,
+                        apr_pool_t *pool)
+{
+  return record_absent(op_absent_directory, path, parent_baton);
+}
+
+static svn_error_t *
+record_absent_file(const char *path,
+                   void *parent_baton,
+                   apr_pool_t *pool)
+{
+  return record_absent(op_absent_file, path, parent_baton);
+}
+
+/* Implements svn_txdelta_window_handler_t. */
+static svn_error_t *
+record_window(svn_txdelta_window_t *window,
+              void *baton)
+{
+  node_baton_t *fb = baton;
+  recorded_rev_t *rev = fb->rev;
+
+  add_op(rev, op_window, fb->id)->window
+    = window ? svn_txdelta_window_dup(window, rev->pool) : NULL;
+
+  if (window)
+    rev->size += window->num_ops * sizeof(*window->ops)
+               + (window->new_data ? window->new_data->len : 0);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_apply_textdelta(void *file_baton,
+                       const char *base_checksum,
+                       apr_pool_t *pool,
+                       svn_txdelta_window_handler_t *handler,
+                       void **handler_baton)
+{
+  node_baton_t *fb = file_baton;
+  recorded_rev_t *rev = fb->rev;
+
+  add_op(rev, op_apply_textdelta, fb->id)->checksum
+    = base_checksum ? apr_pstrdup(rev->pool, base_checksum) : NULL;
+
+  *handler = record_window;
+  *handler_baton = fb;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_close_file(void *file_baton,
+                  const char *text_checksum,
+                  apr_pool_t *pool)
+{
+  node_baton_t *fb = file_baton;
+  recorded_rev_t *rev = fb->rev;
+
+  add_op(rev, op_close_file, fb->id)->checksum
+    = text_checksum ? apr_pstrdup(rev->pool, text_checksum) : NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_ra_replay_revstart_callback_t.  Start recording
+   REVISION into a new recorded_rev_t. */
+static svn_error_t *
+record_rev_started(svn_revnum_t revision,
+                   void *replay_baton,
+                   const svn_delta_editor_t **editor,
+                   void **edit_baton,
+                   apr_hash_t *rev_props,
+                   apr_pool_t *pool)
+{
+  pipeline_t *pipeline = replay_baton;
+  apr_pool_t *rev_pool = svn_pool_create(NULL);
+  recorded_rev_t *rev = apr_pcalloc(rev_pool, sizeof(*rev));
+  svn_delta_editor_t *recorder = svn_delta_default_editor(rev_pool);
+
+  rev->revision = revision;
+  rev->rev_props = svn_prop_hash_dup(rev_props, rev_pool);
+  rev->ops = apr_array_make(rev_pool, 16, sizeof(recorded_op_t));
+  rev->pool = rev_pool;
+  pipeline->current = rev;
+
+  recorder->set_target_revision = record_set_target_revision;
+  recorder->open_root = record_open_root;
+  recorder->delete_entry = record_delete_entry;
+  recorder->add_directory = record_add_directory;
+  recorder->open_directory = record_open_directory;
+  recorder->change_dir_prop = record_change_dir_prop;
+  recorder->close_directory = record_close_directory;
+  recorder->absent_directory = record_absent_directory;
+  recorder->add_file = record_add_file;
+  recorder->open_file = record_open_file;
+  recorder->apply_textdelta = record_apply_textdelta;
+  recorder->change_file_prop = record_change_file_prop;
+  recorder->close_file = record_close_file;
+  recorder->absent_file = record_absent_file;
+
+  return svn_error_trace(svn_delta_get_cancellation_editor(
+                           pipeline->cancel_func, NULL, recorder, rev,
+                           editor, edit_baton, rev_pool));
+}
+
+/* Wait for a change of the state of PIPELINE.  The caller must hold the
+   mutex of PIPELINE. */
+static svn_error_t *
+wait_for_pipeline(pipeline_t *pipeline)
+{
+  apr_status_t status = apr_thread_cond_wait(pipeline->cond,
+                                             svn_mutex__get(pipeline->mutex));
+
+  if (status)
+    return svn_error_wrap_apr(status,
+                              _("Can't wait for condition variable"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_ra_replay_revfinish_callback_t.  Queue the recorded
+   revision for the committing thread, once there is room for it. */
+static svn_error_t *
+record_rev_finished(svn_revnum_t revision,
+                    void *replay_baton,
+                    const svn_delta_editor_t *editor,
+                    void *edit_baton,
+                    apr_hash_t *rev_props,
+                    apr_pool_t *pool)
+{
+  pipeline_t *pipeline = replay_baton;
+  recorded_rev_t *rev = pipeline->current;
+  svn_error_t *err;
+
+  pipeline->current = NULL;
+
+  err = svn_mutex__lock(pipeline->mutex);
+  if (err)
+    {
+      svn_pool_destroy(rev->pool);
+      return svn_error_trace(err);
+    }
+
+  while (!err && !pipeline->stop && pipeline->first
+         && (pipeline->queued_revs >= MAX_QUEUED_REVS
+             || pipeline->queued_bytes + rev->size > MAX_QUEUED_BYTES))
+    err = wait_for_pipeline(pipeline);
+
+  if (!err && pipeline->stop)
+    err = svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+
+  if (err)
+    {
+      svn_pool_destroy(rev->pool);
+    }
+  else
+    {
+      if (pipeline->last)
+        pipeline->last->next = rev;
+      else
+        pipeline->first = rev;
+      pipeline->last = rev;
+      pipeline->queued_revs++;
+      pipeline->queued_bytes += rev->size;
+
+      apr_thread_cond_broadcast(pipeline->cond);
+    }
+
+  return svn_error_trace(svn_mutex__unlock(pipeline->mutex, err));
+}
+
+/* Thread function.  Replay the revisions of the pipeline_t DATA. */
+static void * APR_THREAD_FUNC
+replay_thread(apr_thread_t *tid,
+              void *data)
+{
+  pipeline_t *pipeline = data;
+  apr_pool_t *pool = svn_pool_create(NULL);
+  svn_error_t *replay_err;
+  svn_error_t *err;
+
+  replay_err = svn_ra_replay_range(pipeline->from_session,
+                                   pipeline->start_revision,
+                                   pipeline->end_revision,
+                                   pipeline->low_water_mark,
+                                   pipeline->send_deltas,
+                                   record_rev_started, record_rev_finished,
+                                   pipeline, pool);
+
+  /* Don't leak a partially recorded revision. */
+  if (pipeline->current)
+    svn_pool_destroy(pipeline->current->pool);
+  svn_pool_destroy(pool);
+
+  err = svn_mutex__lock(pipeline->mutex);
+  pipeline->err = replay_err;
+  pipeline->done = TRUE;
+  if (!err)
+    apr_thread_cond_broadcast(pipeline->cond);
+  svn_error_clear(svn_mutex__unlock(pipeline->mutex, err));
+
+  return NULL;
+}
+
+
+/*** Playing back recorded revisions. ***/
+
+/* Drive EDITOR / EDIT_BATON with the calls recorded in REV.  Allocate
+   the batons in POOL. */
+static svn_error_t *
+play_rev(const recorded_rev_t *rev,
+         const svn_delta_editor_t *editor,
+         void *edit_baton,
+         apr_pool_t *pool)
+{
+  void **batons = apr_pcalloc(pool, (rev->baton_count + 1) * sizeof(void *));
+  svn_txdelta_window_handler_t *handlers
+    = apr_pcalloc(pool, (rev->baton_count + 1) * sizeof(*handlers));
+  void **handler_batons = apr_pcalloc(pool, (rev->baton_count + 1)
+                                              * sizeof(void *));
+  int i;
+
+  for (i = 0; i < rev->ops->nelts; i++)
+    {
+      const recorded_op_t *op = &APR_ARRAY_IDX(rev->ops, i, recorded_op_t);
+      void *parent = batons[op->parent_id];
+
+      switch (op->kind)
+        {
+          case op_set_target_revision:
+            SVN_ERR(editor->set_target_revision(edit_baton, op->revision,
+                                                pool));
+            break;
+
+          case op_open_root:
+            SVN_ERR(editor->open_root(edit_baton, op->revision, pool,
+                                      &batons[op->id]));
+            break;
+
+          case op_delete_entry:
+            SVN_ERR(editor->delete_entry(op->path, op->revision, parent,
+                                         pool));
+            break;
+
+          case op_add_directory:
+            SVN_ERR(editor->add_directory(op->path, parent,
+                                          op->copyfrom_path, op->revision,
+                                          pool, &batons[op->id]));
+            break;
+
+          case op_open_directory:
+            SVN_ERR(editor->open_directory(op->path, parent, op->revision,
+                                           pool, &batons[op->id]));
+            break;
+
+          case op_change_dir_prop:
+            SVN_ERR(editor->change_dir_prop(batons[op->id], op->name,
+                                            op->value, pool));
+            break;
+
+          case op_close_directory:
+            SVN_ERR(editor->close_directory(batons[op->id], pool));
+            break;
+
+          case op_absent_directory:
+            SVN_ERR(editor->absent_directory(op->path, parent, pool));
+            break;
+
+          case op_add_file:
+            SVN_ERR(editor->add_file(op->path, parent, op->copyfrom_path,
+                                     op->revision, pool, &batons[op->id]));
+            break;
+
+          case op_open_file:
+            SVN_ERR(editor->open_file(op->path, parent, op->revision,
+                                      pool, &batons[op->id]));
+            break;
+
+          case op_apply_textdelta:
+            SVN_ERR(editor->apply_textdelta(batons[op->id], op->checksum,
+                                            pool, &handlers[op->id],
+                                            &handler_batons[op->id]));
+            break;
+
+          case op_window:
+            SVN_ERR(handlers[op->id](op->window, handler_batons[op->id]));
+            break;
+
+          case op_change_file_prop:
+            SVN_ERR(editor->change_file_prop(batons[op->id], op->name,
+                                             op->value, pool));
+            break;
+
+          case op_close_file:
+            SVN_ERR(editor->close_file(batons[op->id], op->checksum, pool));
+            break;
+
+          case op_absent_file:
+            SVN_ERR(editor->absent_file(op->path, parent, pool));
+            break;
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Wait for the next recorded revision of PIPELINE and set *REV_P to it,
+   or to NULL if the replay is over. */
+static svn_error_t *
+take_rev(recorded_rev_t **rev_p,
+         pipeline_t *pipeline)
+{
+  recorded_rev_t *rev = NULL;
+  svn_error_t *err;
+
+  SVN_ERR(svn_mutex__lock(pipeline->mutex));
+
+  err = SVN_NO_ERROR;
+  while (!err && !pipeline->first && !pipeline->done)
+    err = wait_for_pipeline(pipeline);
+
+  if (!err && pipeline->first)
+    {
+      rev = pipeline->first;
+      pipeline->first = rev->next;
+      if (!pipeline->first)
+        pipeline->last = NULL;
+      pipeline->queued_revs--;
+      pipeline->queued_bytes -= rev->size;
+
+      apr_thread_cond_broadcast(pipeline->cond);
+    }
+  else if (!err)
+    {
+      /* Hand over the error of the replay, if any. */
+      err = pipeline->err;
+      pipeline->err = SVN_NO_ERROR;
+    }
+
+  *rev_p = rev;
+
+  return svn_error_trace(svn_mutex__unlock(pipeline->mutex, err));
+}
+
+#endif /* APR_HAS_THREADS */
+
+svn_error_t *
+svnsync_replay_range_ahead(svn_boolean_t *handled,
+                           svn_ra_session_t *from_session,
+                           svn_revnum_t start_revision,
+                           svn_revnum_t end_revision,
+                           svn_revnum_t low_water_mark,
+                           svn_boolean_t send_deltas,
+                           svn_ra_replay_revstart_callback_t revstart_func,
+                           svn_ra_replay_revfinish_callback_t revfinish_func,
+                           void *replay_baton,
+                           svn_cancel_func_t cancel_func,
+                           apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  pipeline_t pipeline = { 0 };
+  apr_pool_t *thread_pool;
+  apr_pool_t *iterpool;
+  apr_thread_t *thread;
+  apr_status_t status;
+  svn_error_t *err = SVN_NO_ERROR;
+  svn_error_t *lock_err;
+
+  *handled = FALSE;
+
+  /* There is nothing to overlap for a single revision. */
+  if (end_revision <= start_revision)
+    return SVN_NO_ERROR;
+
+  pipeline.from_session = from_session;
+  pipeline.start_revision = start_revision;
+  pipeline.end_revision = end_revision;
+  pipeline.low_water_mark = low_water_mark;
+  pipeline.send_deltas = send_deltas;
+  pipeline.cancel_func = cancel_func;
+
+  SVN_ERR(svn_mutex__init(&pipeline.mutex, TRUE, pool));
+  status = apr_thread_cond_create(&pipeline.cond, pool);
+  if (status)
+    return SVN_NO_ERROR;
+
+  thread_pool = svn_pool_create(NULL);
+  status = apr_thread_create(&thread, NULL, replay_thread, &pipeline,
+                             thread_pool);
+  if (status)
+    {
+      svn_pool_destroy(thread_pool);
+      return SVN_NO_ERROR;
+    }
+
+  *handled = TRUE;
+
+  /* Commit the revisions as they arrive, while the next ones are being
+     replayed. */
+  iterpool = svn_pool_create(pool);
+  while (!err)
+    {
+      recorded_rev_t *rev;
+      const svn_delta_editor_t *editor;
+      void *edit_baton;
+
+      err = take_rev(&rev, &pipeline);
+      if (err || !rev)
+        break;
+
+      svn_pool_clear(iterpool);
+
+      err = revstart_func(rev->revision, replay_baton, &editor, &edit_baton,
+                          rev->rev_props, iterpool);
+      if (!err)
+        err = play_rev(rev, editor, edit_baton, iterpool);
+      if (!err)
+        err = revfinish_func(rev->revision, replay_baton, editor,
+                             edit_baton, rev->rev_props, iterpool);
+
+      svn_pool_destroy(rev->pool);
+    }
+  svn_pool_destroy(iterpool);
+
+  /* Make the replay stop at the next revision boundary. */
+  lock_err = svn_mutex__lock(pipeline.mutex);
+  pipeline.stop = TRUE;
+  if (!lock_err)
+    {
+      apr_thread_cond_broadcast(pipeline.cond);
+      lock_err = svn_mutex__unlock(pipeline.mutex, SVN_NO_ERROR);
+    }
+  err = svn_error_compose_create(err, lock_err);
+
+  apr_thread_join(&status, thread);
+  svn_pool_destroy(thread_pool);
+
+  /* Drop whatever the replay did after we stopped taking revisions. */
+  while (pipeline.first)
+    {
+      recorded_rev_t *rev = pipeline.first;
+
+      pipeline.first = rev->next;
+      svn_pool_destroy(rev->pool);
+    }
+  svn_error_clear(pipeline.err);
+
+  return svn_error_trace(err);
+#else
+  *handled = FALSE;
+
+  return SVN_NO_ERROR;
+#endif
+}
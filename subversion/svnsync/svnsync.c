@@ -1435,6 +1435,7 @@ do_synchronize(svn_ra_session_t *to_session,
   svn_string_t *currently_copying;
   svn_revnum_t to_latest, copying, last_merged;
   svn_revnum_t start_revision, end_revision;
+  svn_boolean_t replayed;
   replay_baton_t *rb;
   int normalized_rev_props_count = 0;
 
@@ -1551,9 +1552,17 @@ do_synchronize(svn_ra_session_t *to_session,
 
   SVN_ERR(check_cancel(NULL));
 
-  SVN_ERR(svn_ra_replay_range(from_session, start_revision, end_revision,
-                              0, TRUE, replay_rev_started,
-                              replay_rev_finished, rb, pool));
+  /* Fetch the upcoming revisions from the source while we commit the
+     current one to the destination, if we can. */
+  SVN_ERR(svnsync_replay_range_ahead(&replayed, from_session,
+                                     start_revision, end_revision,
+                                     0, TRUE, replay_rev_started,
+                                     replay_rev_finished, rb,
+                                     check_cancel, pool));
+  if (! replayed)
+    SVN_ERR(svn_ra_replay_range(from_session, start_revision, end_revision,
+                                0, TRUE, replay_rev_started,
+                                replay_rev_finished, rb, pool));
 
   SVN_ERR(log_properties_normalized(rb->normalized_rev_props_count
                                       + normalized_rev_props_count,
@@ -31,6 +31,7 @@ extern "C" {
 
 #include "svn_types.h"
 #include "svn_delta.h"
+#include "svn_ra.h"
 
 
 /* Normalize the encoding and line ending style of the values of properties
@@ -78,6 +79,31 @@ svnsync_get_sync_editor(const svn_delta_editor_t *wrapped_editor,
                         apr_pool_t *pool);
 
 
+/* Like svn_ra_replay_range(), but replay the revisions from FROM_SESSION
+ * on a separate thread, buffering a limited number of them ahead, while
+ * REVSTART_FUNC and REVFINISH_FUNC are invoked for each one in order on
+ * the calling thread.  This overlaps fetching the revisions from the
+ * source with committing them to the destination.  CANCEL_FUNC is
+ * checked by the replaying thread and must therefore be thread-safe.
+ *
+ * Set *HANDLED to FALSE, without doing anything, if there is nothing to
+ * overlap or threads aren't available; the caller should then use
+ * svn_ra_replay_range() instead.
+ */
+svn_error_t *
+svnsync_replay_range_ahead(svn_boolean_t *handled,
+                           svn_ra_session_t *from_session,
+                           svn_revnum_t start_revision,
+                           svn_revnum_t end_revision,
+                           svn_revnum_t low_water_mark,
+                           svn_boolean_t send_deltas,
+                           svn_ra_replay_revstart_callback_t revstart_func,
+                           svn_ra_replay_revfinish_callback_t revfinish_func,
+                           void *replay_baton,
+                           svn_cancel_func_t cancel_func,
+                           apr_pool_t *pool);
+
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
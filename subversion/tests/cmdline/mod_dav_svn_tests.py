@@ -206,7 +206,7 @@ def cache_control_header(sbox):
   if r.status != httplib.OK:
     raise svntest.Failure('Request failed: %d %s' % (r.status, r.reason))
   svntest.verify.compare_and_display_lines(None, 'Cache-Control',
-                                           'max-age=604800',
+                                           'max-age=31536000, immutable',
                                            r.getheader('Cache-Control'))
   r.read()
 
@@ -218,7 +218,7 @@ def cache_control_header(sbox):
   if r.status != httplib.OK:
     raise svntest.Failure('Request failed: %d %s' % (r.status, r.reason))
   svntest.verify.compare_and_display_lines(None, 'Cache-Control',
-                                           'max-age=604800',
+                                           'max-age=31536000, immutable',
                                            r.getheader('Cache-Control'))
   r.read()
 
@@ -230,11 +230,63 @@ def cache_control_header(sbox):
   if r.status != httplib.OK:
     raise svntest.Failure('Request failed: %d %s' % (r.status, r.reason))
   svntest.verify.compare_and_display_lines(None, 'Cache-Control',
-                                           'max-age=604800',
+                                           'max-age=31536000, immutable',
                                            r.getheader('Cache-Control'))
   r.read()
 
 
+@SkipUnless(svntest.main.is_ra_type_dav)
+def conditional_get(sbox):
+  "verify conditional GETs of immutable resources"
+
+  sbox.build(create_wc=False, read_only=True)
+
+  headers = {
+    'Authorization': 'Basic ' + base64.b64encode(b'jconstant:rayjandom').decode(),
+  }
+
+  h = svntest.main.create_http_connection(sbox.repo_url)
+
+  # GET /repos/!svn/rvr/1/iota
+  # The ETag is derived from the file contents.
+  h.request('GET', sbox.repo_url + '/!svn/rvr/1/iota', None, headers)
+  r = h.getresponse()
+  if r.status != httplib.OK:
+    raise svntest.Failure('Request failed: %d %s' % (r.status, r.reason))
+  etag = r.getheader('ETag')
+  if not etag or etag.startswith('W/'):
+    raise svntest.Failure('Expected a strong ETag, got %s' % etag)
+  r.read()
+
+  # The same contents have the same ETag in other revisions.
+  h.request('GET', sbox.repo_url + '/iota?p=1', None, headers)
+  r = h.getresponse()
+  if r.status != httplib.OK:
+    raise svntest.Failure('Request failed: %d %s' % (r.status, r.reason))
+  svntest.verify.compare_and_display_lines(None, 'ETag', etag,
+                                           r.getheader('ETag'))
+  r.read()
+
+  # GET /repos/!svn/rvr/1/iota with a matching If-None-Match
+  # Expect 304 Not Modified without a body.
+  cond_headers = dict(headers)
+  cond_headers['If-None-Match'] = etag
+  h.request('GET', sbox.repo_url + '/!svn/rvr/1/iota', None, cond_headers)
+  r = h.getresponse()
+  if r.status != httplib.NOT_MODIFIED:
+    raise svntest.Failure('Unexpected status: %d %s' % (r.status, r.reason))
+  if r.read():
+    raise svntest.Failure('Unexpected body in 304 response')
+
+  # A different ETag gets the full response.
+  cond_headers['If-None-Match'] = '"no-such-etag"'
+  h.request('GET', sbox.repo_url + '/!svn/rvr/1/iota', None, cond_headers)
+  r = h.getresponse()
+  if r.status != httplib.OK:
+    raise svntest.Failure('Request failed: %d %s' % (r.status, r.reason))
+  r.read()
+
+
 @SkipUnless(svntest.main.is_ra_type_dav)
 def simple_propfind(sbox):
   "verify simple PROPFIND responses"
@@ -647,6 +699,7 @@ def propfind_propname(sbox):
 # list all tests here, starting with None:
 test_list = [ None,
               cache_control_header,
+              conditional_get,
               simple_propfind,
               propfind_multiple_props,
               propfind_404,
@@ -3436,6 +3436,214 @@ def load_from_file(sbox):
                                      'update', sbox.wc_dir)
   svntest.actions.verify_disk(sbox.wc_dir, expected_tree, check_props=True)
 
+def verify_jobs(sbox):
+  "svnadmin verify --jobs"
+
+  sbox.build(create_wc = False)
+
+  # Give the workers something to do.
+  for i in range(2, 12):
+    svntest.actions.run_and_verify_svn(None, [],
+                                       'mkdir', '-m', 'log_msg',
+                                       sbox.repo_url + '/dir%d' % i)
+
+  exit_code, expected_output, errput = svntest.main.run_svnadmin(
+                                          "verify", sbox.repo_dir)
+  if errput:
+    raise SVNUnexpectedStderr(errput)
+
+  # Concurrently verified revisions are still reported in order.
+  exit_code, output, errput = svntest.main.run_svnadmin(
+                                 "verify", "--jobs", "3", sbox.repo_dir)
+  if errput:
+    raise SVNUnexpectedStderr(errput)
+
+  svntest.verify.compare_and_display_lines(
+    "Unexpected output of 'svnadmin verify --jobs'.",
+    'STDOUT', expected_output, output)
+
+  svntest.actions.run_and_verify_svnadmin(None,
+                                          '^.*Invalid number of jobs.*$',
+                                          'verify', '--jobs', '0',
+                                          sbox.repo_dir)
+
+def dump_jobs(sbox):
+  "svnadmin dump --jobs"
+
+  sbox.build(create_wc = False)
+
+  # Give the workers something to do.
+  for i in range(2, 12):
+    svntest.actions.run_and_verify_svn(None, [],
+                                       'mkdir', '-m', 'log_msg',
+                                       sbox.repo_url + '/dir%d' % i)
+
+  for args in [[], ['-r', '4:HEAD'], ['-r', '4:HEAD', '--incremental'],
+               ['--deltas']]:
+    exit_code, expected_dump, errput = svntest.main.run_svnadmin(
+                                         'dump', '-q', sbox.repo_dir, *args)
+    if errput:
+      raise SVNUnexpectedStderr(errput)
+
+    # Progress is still reported in order.
+    first = 4 if args else 0
+    expected_progress = ["* Dumped revision %d.\n" % rev
+                         for rev in range(first, 12)]
+
+    file = sbox.get_tempname()
+    svntest.actions.run_and_verify_svnadmin2([], expected_progress, 0,
+                                             'dump', '--jobs', '3',
+                                             '--file', file,
+                                             sbox.repo_dir, *args)
+
+    # Concatenating the segments gives the same dump, except that every
+    # segment starts with the dumpfile header.
+    actual_dump = open(file + '.1', 'rb').readlines()
+    for segment in range(2, 4):
+      actual_dump += open(file + '.%d' % segment, 'rb').readlines()[4:]
+
+    svntest.verify.compare_dump_files(None, None, expected_dump, actual_dump)
+
+  svntest.actions.run_and_verify_svnadmin(None,
+                                          '^.*requires --file.*$',
+                                          'dump', '--jobs', '2',
+                                          sbox.repo_dir)
+
+@SkipUnless(svntest.main.fs_has_pack)
+def pack_jobs(sbox):
+  "svnadmin pack --jobs"
+
+  # Configure two files per shard to trigger packing.
+  sbox.build(create_wc = False)
+  patch_format(sbox.repo_dir, shard_size=2)
+
+  # Give the workers something to do.
+  for i in range(2, 12):
+    svntest.actions.run_and_verify_svn(None, [],
+                                       'mkdir', '-m', 'log_msg',
+                                       sbox.repo_url + '/dir%d' % i)
+
+  if svntest.main.is_fs_type_fsfs and svntest.main.options.fsfs_packing:
+    # With --fsfs-packing, everything is already packed and there is
+    # nothing left to do concurrently.
+    return
+
+  # Concurrently packed shards are still reported in order.
+  expected_output = ["Packing revisions in shard %d...done.\n" % i
+                     for i in range(0, 6)]
+  svntest.actions.run_and_verify_svnadmin(expected_output, [],
+                                          "pack", "--jobs", "3",
+                                          sbox.repo_dir)
+
+  svntest.actions.run_and_verify_svnadmin(None, [],
+                                          "verify", sbox.repo_dir)
+
+@SkipUnless(svntest.main.fs_has_pack)
+def pack_throttle(sbox):
+  "svnadmin pack --throttle"
+
+  sbox.build(create_wc = False)
+  patch_format(sbox.repo_dir, shard_size=2)
+
+  for i in range(2, 6):
+    svntest.actions.run_and_verify_svn(None, [],
+                                       'mkdir', '-m', 'log_msg',
+                                       sbox.repo_url + '/dir%d' % i)
+
+  if svntest.main.is_fs_type_fsfs and svntest.main.options.fsfs_packing:
+    return
+
+  # Throttling slows packing down but does not change the result.
+  expected_output = ["Packing revisions in shard %d...done.\n" % i
+                     for i in range(0, 3)]
+  svntest.actions.run_and_verify_svnadmin(expected_output, [],
+                                          "pack", "--throttle", "50",
+                                          sbox.repo_dir)
+
+  svntest.actions.run_and_verify_svnadmin(None, [],
+                                          "verify", sbox.repo_dir)
+
+  svntest.actions.run_and_verify_svnadmin(None,
+                                          '.*Invalid throttle percentage.*',
+                                          "pack", "--throttle", "0",
+                                          sbox.repo_dir)
+
+@SkipUnless(svntest.main.is_fs_type_fsfs)
+@SkipUnless(svntest.main.fs_has_rep_sharing)
+def build_repcache(sbox):
+  "svnadmin build-repcache"
+
+  sbox.build(create_wc = False)
+  svntest.actions.run_and_verify_svn(None, [],
+                                     'mkdir', '-m', 'log_msg',
+                                     sbox.repo_url + '/dir2')
+
+  # Forget about all reps.
+  rep_cache_path = os.path.join(sbox.repo_dir, 'db', 'rep-cache.db')
+  db = svntest.sqlite3.connect(rep_cache_path)
+  expected_count = db.execute("select count(*) from rep_cache").fetchone()[0]
+  db.execute("delete from rep_cache")
+  db.commit()
+  db.close()
+
+  expected_output = ["* Processed revision %d.\n" % i for i in range(0, 3)]
+  svntest.actions.run_and_verify_svnadmin(expected_output, [],
+                                          "build-repcache", "--jobs", "2",
+                                          sbox.repo_dir)
+
+  # All reps have been added back.
+  db = svntest.sqlite3.connect(rep_cache_path)
+  count = db.execute("select count(*) from rep_cache").fetchone()[0]
+  db.close()
+  if count != expected_count:
+    raise svntest.Failure("rep-cache has %d rows instead of %d"
+                          % (count, expected_count))
+
+  # Running it again is harmless.
+  svntest.actions.run_and_verify_svnadmin([], [],
+                                          "build-repcache", "-q", "-r", "1",
+                                          sbox.repo_dir)
+  svntest.actions.run_and_verify_svnadmin(None, [],
+                                          "verify", sbox.repo_dir)
+
+@SkipUnless(svntest.main.is_fs_type_fsfs)
+def verify_incremental_journal(sbox):
+  "svnadmin verify --incremental skips unchanged revs"
+
+  sbox.build(create_wc = False)
+  svntest.actions.run_and_verify_svn(None, [],
+                                     'mkdir', '-m', 'log_msg',
+                                     sbox.repo_url + '/dir2')
+
+  # The first run has to verify everything.
+  exit_code, output, errput = svntest.main.run_svnadmin(
+                                 "verify", "--incremental", sbox.repo_dir)
+  if errput:
+    raise SVNUnexpectedStderr(errput)
+  if "* Verified revision 2.\n" not in output:
+    raise svntest.Failure("r2 has not been verified")
+
+  # Nothing changed since.
+  exit_code, output, errput = svntest.main.run_svnadmin(
+                                 "verify", "--incremental", sbox.repo_dir)
+  if errput:
+    raise SVNUnexpectedStderr(errput)
+  if [line for line in output if line.startswith("* Verified revision")]:
+    raise svntest.Failure("Unchanged revisions got verified again")
+
+  # Changing a revprop touches the revision's storage.
+  log_file = sbox.get_tempname()
+  svntest.main.file_write(log_file, "new log\n")
+  svntest.actions.run_and_verify_svnadmin([], [],
+                                          "setlog", "--bypass-hooks",
+                                          "-r2", sbox.repo_dir, log_file)
+  exit_code, output, errput = svntest.main.run_svnadmin(
+                                 "verify", "--incremental", sbox.repo_dir)
+  if errput:
+    raise SVNUnexpectedStderr(errput)
+  if "* Verified revision 2.\n" not in output:
+    raise svntest.Failure("Changed r2 has not been verified")
+
 ########################################################################
 # Run the tests
 
@@ -3500,7 +3708,13 @@ test_list = [ None,
               dump_no_op_prop_change,
               load_no_flush_to_disk,
               dump_to_file,
-              load_from_file
+              load_from_file,
+              verify_jobs,
+              pack_jobs,
+              dump_jobs,
+              verify_incremental_journal,
+              pack_throttle,
+              build_repcache
              ]
 
 if __name__ == '__main__':
@@ -388,9 +388,9 @@ test_patch(const svn_test_opts_t *opts,
   rev.kind = svn_opt_revision_head;
   peg_rev.kind = svn_opt_revision_unspecified;
   SVN_ERR(svn_client_create_context(&ctx, pool));
-  SVN_ERR(svn_client_checkout3(NULL, repos_url, wc_path,
+  SVN_ERR(svn_client_checkout4(NULL, repos_url, wc_path,
                                &peg_rev, &rev, svn_depth_infinity,
-                               TRUE, FALSE, ctx, pool));
+                               TRUE, FALSE, FALSE, ctx, pool));
 
   /* Create the patch file. */
   patch_file_path = svn_dirent_join_many(
@@ -462,14 +462,15 @@ test_wc_add_scenarios(const svn_test_opts_t *opts,
   peg_rev.kind = svn_opt_revision_unspecified;
   SVN_ERR(svn_client_create_context(&ctx, pool));
   /* Checkout greek tree as wc_path */
-  SVN_ERR(svn_client_checkout3(NULL, repos_url, wc_path, &peg_rev, &rev,
-                               svn_depth_infinity, FALSE, FALSE, ctx, pool));
+  SVN_ERR(svn_client_checkout4(NULL, repos_url, wc_path, &peg_rev, &rev,
+                               svn_depth_infinity, FALSE, FALSE, FALSE,
+                               ctx, pool));
 
   /* Now checkout again as wc_path/NEW */
   new_dir_path = svn_dirent_join(wc_path, "NEW", pool);
-  SVN_ERR(svn_client_checkout3(NULL, repos_url, new_dir_path, &peg_rev, &rev,
+  SVN_ERR(svn_client_checkout4(NULL, repos_url, new_dir_path, &peg_rev, &rev,
                                svn_depth_infinity, FALSE, FALSE,
-                               ctx, pool));
+                               FALSE, ctx, pool));
 
   ex_dir_path = svn_dirent_join(wc_path, "NEW_add", pool);
   ex2_dir_path = svn_dirent_join(wc_path, "NEW_add2", pool);
@@ -626,9 +627,9 @@ test_16k_add(const svn_test_opts_t *opts,
   rev.kind = svn_opt_revision_head;
   peg_rev.kind = svn_opt_revision_unspecified;
   SVN_ERR(svn_client_create_context(&ctx, pool));
-  SVN_ERR(svn_client_checkout3(NULL, repos_url, wc_path,
+  SVN_ERR(svn_client_checkout4(NULL, repos_url, wc_path,
                                &peg_rev, &rev, svn_depth_infinity,
-                               TRUE, FALSE, ctx, pool));
+                               TRUE, FALSE, FALSE, ctx, pool));
 
   for (i = 0; i < 16384; i++)
     {
@@ -753,8 +754,9 @@ test_foreign_repos_copy(const svn_test_opts_t *opts,
   peg_rev.kind = svn_opt_revision_unspecified;
   SVN_ERR(svn_client_create_context(&ctx, pool));
   /* Checkout greek tree as wc_path */
-  SVN_ERR(svn_client_checkout3(NULL, repos_url, wc_path, &peg_rev, &rev,
-                               svn_depth_infinity, FALSE, FALSE, ctx, pool));
+  SVN_ERR(svn_client_checkout4(NULL, repos_url, wc_path, &peg_rev, &rev,
+                               svn_depth_infinity, FALSE, FALSE, FALSE,
+                               ctx, pool));
 
   SVN_ERR(svn_client__copy_foreign(svn_path_url_add_component2(repos2_url, "A",
                                                                pool),
@@ -811,11 +813,11 @@ test_suggest_mergesources(const svn_test_opts_t *opts,
   SVN_ERR(svn_io_remove_dir2(wc_path, TRUE, NULL, NULL, pool));
 
   head_rev.kind = svn_opt_revision_head;
-  SVN_ERR(svn_client_checkout3(NULL,
+  SVN_ERR(svn_client_checkout4(NULL,
                                svn_path_url_add_component2(repos_url, "AA", pool),
                                wc_path,
                                &head_rev, &head_rev, svn_depth_empty,
-                               FALSE, FALSE, ctx, pool));
+                               FALSE, FALSE, FALSE, ctx, pool));
 
 
   SVN_ERR(svn_client_suggest_merge_sources(&results,
@@ -959,10 +961,10 @@ test_remote_only_status(const svn_test_opts_t *opts, apr_pool_t *pool)
 
   rev.kind = svn_opt_revision_number;
   rev.value.number = 1;
-  SVN_ERR(svn_client_checkout3(NULL,
+  SVN_ERR(svn_client_checkout4(NULL,
                                apr_pstrcat(pool, repos_url, "/A", SVN_VA_NULL),
                                wc_path, &rev, &rev, svn_depth_immediates,
-                               FALSE, FALSE, ctx, pool));
+                               FALSE, FALSE, FALSE, ctx, pool));
 
   /* Add a local file; this is a double-check to make sure that
      remote-only status ignores local changes. */
@@ -1408,6 +1410,111 @@ test_copy_pin_externals_select_subtree(const svn_test_opts_t *opts, apr_pool_t *
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_ra_session_reuse(const svn_test_opts_t *opts,
+                      apr_pool_t *pool)
+{
+  const char *repos_url;
+  const char *repos2_url;
+  const char *url;
+  svn_client_ctx_t *ctx;
+  svn_ra_session_t *session, *session2, *session3;
+  apr_pool_t *subpool = svn_pool_create(pool);
+
+  SVN_ERR(create_greek_repos(&repos_url, "ra-session-reuse", opts, pool));
+  SVN_ERR(create_greek_repos(&repos2_url, "ra-session-reuse2", opts, pool));
+  SVN_ERR(svn_client_create_context(&ctx, pool));
+
+  /* A session released by one operation gets reparented and reused by
+     the next one. */
+  SVN_ERR(svn_client_open_ra_session2(&session, repos_url, NULL, ctx,
+                                      subpool, subpool));
+  svn_pool_clear(subpool);
+
+  SVN_ERR(svn_client_open_ra_session2(&session2,
+                                      svn_path_url_add_component2(repos_url,
+                                                                  "A", pool),
+                                      NULL, ctx, subpool, subpool));
+  SVN_TEST_ASSERT(session2 == session);
+  SVN_ERR(svn_ra_get_session_url(session2, &url, pool));
+  SVN_TEST_STRING_ASSERT(url, svn_path_url_add_component2(repos_url, "A",
+                                                          pool));
+
+  /* Sessions in use don't get handed out twice. */
+  SVN_ERR(svn_client_open_ra_session2(&session3, repos_url, NULL, ctx,
+                                      subpool, subpool));
+  SVN_TEST_ASSERT(session3 != session2);
+  svn_pool_clear(subpool);
+
+  /* Other repositories get their own sessions. */
+  SVN_ERR(svn_client_open_ra_session2(&session3, repos2_url, NULL, ctx,
+                                      subpool, subpool));
+  SVN_TEST_ASSERT(session3 != session && session3 != session2);
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_lazy_checkout(const svn_test_opts_t *opts,
+                   apr_pool_t *pool)
+{
+  const char *repos_url;
+  const char *wc_path;
+  const char *iota_path;
+  const char *gamma_path;
+  svn_client_ctx_t *ctx;
+  svn_opt_revision_t rev, peg_rev;
+  svn_node_kind_t kind;
+  apr_array_header_t *paths;
+
+  SVN_ERR(create_greek_repos(&repos_url, "lazy-checkout", opts, pool));
+
+  wc_path = svn_test_data_path("lazy-checkout-wc", pool);
+  SVN_ERR(svn_io_remove_dir2(wc_path, TRUE, NULL, NULL, pool));
+  svn_test_add_dir_cleanup(wc_path);
+
+  rev.kind = svn_opt_revision_head;
+  peg_rev.kind = svn_opt_revision_unspecified;
+  SVN_ERR(svn_client_create_context(&ctx, pool));
+  SVN_ERR(svn_client_checkout4(NULL, repos_url, wc_path, &peg_rev, &rev,
+                               svn_depth_infinity, TRUE, FALSE, TRUE,
+                               ctx, pool));
+
+  /* Directories are there, files are only known to the working copy. */
+  SVN_ERR(svn_io_check_path(svn_dirent_join(wc_path, "A/D/G", pool),
+                            &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_dir);
+
+  iota_path = svn_dirent_join(wc_path, "iota", pool);
+  gamma_path = svn_dirent_join(wc_path, "A/D/gamma", pool);
+  SVN_ERR(svn_io_check_path(iota_path, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+  SVN_ERR(svn_wc_read_kind2(&kind, ctx->wc_ctx, iota_path, FALSE, TRUE,
+                            pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+
+  /* An update of the whole working copy leaves them alone. */
+  paths = apr_array_make(pool, 1, sizeof(const char *));
+  APR_ARRAY_PUSH(paths, const char *) = wc_path;
+  SVN_ERR(svn_client_update4(NULL, paths, &rev, svn_depth_unknown, FALSE,
+                             TRUE, FALSE, FALSE, FALSE, ctx, pool));
+  SVN_ERR(svn_io_check_path(iota_path, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  /* Files are installed on demand. */
+  apr_array_clear(paths);
+  APR_ARRAY_PUSH(paths, const char *) = iota_path;
+  SVN_ERR(svn_client_update4(NULL, paths, &rev, svn_depth_infinity, TRUE,
+                             TRUE, FALSE, FALSE, FALSE, ctx, pool));
+  SVN_ERR(svn_io_check_path(iota_path, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+  SVN_ERR(svn_io_check_path(gamma_path, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  return SVN_NO_ERROR;
+}
+
 /* ========================================================================== */
 
 
@@ -1436,6 +1543,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test svn_client_copy7 with externals_to_pin"),
     SVN_TEST_OPTS_PASS(test_copy_pin_externals_select_subtree,
                        "pin externals on selected subtrees only"),
+    SVN_TEST_OPTS_PASS(test_ra_session_reuse,
+                       "test reusing RA sessions within a client context"),
+    SVN_TEST_OPTS_PASS(test_lazy_checkout,
+                       "test svn_client_checkout4 with lazy_files"),
     SVN_TEST_NULL
   };
 
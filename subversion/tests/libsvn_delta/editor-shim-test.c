@@ -0,0 +1,247 @@
+/*
+ * editor-shim-test.c:  Measure the cost of the Ev1 <-> Ev2 editor shims.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#define APR_WANT_STDIO
+#include <apr_want.h>
+
+#include "../svn_test.h"
+
+#include "svn_delta.h"
+#include "svn_hash.h"
+#include "svn_pools.h"
+#include "svn_props.h"
+
+#include "private/svn_delta_private.h"
+#include "private/svn_editor.h"
+
+
+/* Receives the edits at the end of the editor chain. */
+typedef struct counting_baton_t
+{
+  int files_added;
+  int props_changed;
+} counting_baton_t;
+
+/* Implements svn_delta_editor_t.add_file. */
+static svn_error_t *
+counting_add_file(const char *path,
+                  void *parent_baton,
+                  const char *copyfrom_path,
+                  svn_revnum_t copyfrom_revision,
+                  apr_pool_t *result_pool,
+                  void **file_baton)
+{
+  counting_baton_t *cb = parent_baton;
+
+  cb->files_added++;
+  *file_baton = cb;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_delta_editor_t.change_file_prop. */
+static svn_error_t *
+counting_change_file_prop(void *file_baton,
+                          const char *name,
+                          const svn_string_t *value,
+                          apr_pool_t *scratch_pool)
+{
+  counting_baton_t *cb = file_baton;
+
+  cb->props_changed++;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_delta_editor_t.open_root. */
+static svn_error_t *
+counting_open_root(void *edit_baton,
+                   svn_revnum_t base_revision,
+                   apr_pool_t *result_pool,
+                   void **root_baton)
+{
+  *root_baton = edit_baton;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_delta_fetch_kind_func_t.  Only the root exists. */
+static svn_error_t *
+fetch_kind(svn_node_kind_t *kind,
+           void *baton,
+           const char *path,
+           svn_revnum_t base_revision,
+           apr_pool_t *scratch_pool)
+{
+  *kind = *path ? svn_node_none : svn_node_dir;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_delta_fetch_props_func_t.  Nothing has properties. */
+static svn_error_t *
+fetch_props(apr_hash_t **props,
+            void *baton,
+            const char *path,
+            svn_revnum_t base_revision,
+            apr_pool_t *result_pool,
+            apr_pool_t *scratch_pool)
+{
+  *props = apr_hash_make(result_pool);
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_delta_fetch_base_func_t.  There are no base texts. */
+static svn_error_t *
+fetch_base(const char **filename,
+           void *baton,
+           const char *path,
+           svn_revnum_t base_revision,
+           apr_pool_t *result_pool,
+           apr_pool_t *scratch_pool)
+{
+  *filename = NULL;
+  return SVN_NO_ERROR;
+}
+
+/* Wrap DEDITOR / DEDIT_BATON into the Ev1 -> Ev2 -> Ev1 shims, just like
+   svn_editor__insert_shims() does in builds with ENABLE_EV2_SHIMS. */
+static svn_error_t *
+wrap_in_shims(const svn_delta_editor_t **deditor_out,
+              void **dedit_baton_out,
+              const svn_delta_editor_t *deditor,
+              void *dedit_baton,
+              apr_pool_t *pool)
+{
+  svn_editor_t *editor;
+  struct svn_delta__extra_baton *exb;
+  svn_delta__unlock_func_t unlock_func;
+  void *unlock_baton;
+  svn_boolean_t *found_abs_paths = apr_pcalloc(pool,
+                                               sizeof(*found_abs_paths));
+
+  SVN_ERR(svn_delta__editor_from_delta(&editor, &exb,
+                                       &unlock_func, &unlock_baton,
+                                       deditor, dedit_baton,
+                                       found_abs_paths, NULL, NULL,
+                                       NULL, NULL,
+                                       fetch_kind, NULL,
+                                       fetch_props, NULL,
+                                       pool, pool));
+  SVN_ERR(svn_delta__delta_from_editor(deditor_out, dedit_baton_out, editor,
+                                       unlock_func, unlock_baton,
+                                       found_abs_paths, NULL, NULL,
+                                       fetch_props, NULL,
+                                       fetch_base, NULL,
+                                       exb, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Add FILE_COUNT files with one property each to the root directory
+   through EDITOR / EDIT_BATON. */
+static svn_error_t *
+drive_adds(const svn_delta_editor_t *editor,
+           void *edit_baton,
+           int file_count,
+           apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  void *root_baton;
+  int i;
+
+  SVN_ERR(editor->open_root(edit_baton, 0, pool, &root_baton));
+  for (i = 0; i < file_count; ++i)
+    {
+      void *file_baton;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(editor->add_file(apr_psprintf(iterpool, "file-%d", i),
+                               root_baton, NULL, SVN_INVALID_REVNUM,
+                               iterpool, &file_baton));
+      SVN_ERR(editor->change_file_prop(file_baton, SVN_PROP_EOL_STYLE,
+                                       svn_string_create("native", iterpool),
+                                       iterpool));
+      SVN_ERR(editor->close_file(file_baton, NULL, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  SVN_ERR(editor->close_directory(root_baton, pool));
+  return svn_error_trace(editor->close_edit(edit_baton, pool));
+}
+
+/* Drive the same adds into a counting editor, once directly and once
+   through the shims.  Verify that both deliver the same edits and report
+   the per-node cost of the shims. */
+static svn_error_t *
+shim_overhead(const svn_test_opts_t *opts,
+              apr_pool_t *pool)
+{
+  const int file_count = 10000;
+  svn_delta_editor_t *counting_editor = svn_delta_default_editor(pool);
+  const svn_delta_editor_t *shimmed_editor;
+  void *shimmed_baton;
+  counting_baton_t direct = { 0 };
+  counting_baton_t shimmed = { 0 };
+  apr_time_t start, direct_duration, shimmed_duration;
+  apr_pool_t *subpool = svn_pool_create(pool);
+
+  counting_editor->open_root = counting_open_root;
+  counting_editor->add_file = counting_add_file;
+  counting_editor->change_file_prop = counting_change_file_prop;
+
+  start = apr_time_now();
+  SVN_ERR(drive_adds(counting_editor, &direct, file_count, subpool));
+  direct_duration = apr_time_now() - start;
+  svn_pool_clear(subpool);
+
+  start = apr_time_now();
+  SVN_ERR(wrap_in_shims(&shimmed_editor, &shimmed_baton,
+                        counting_editor, &shimmed, subpool));
+  SVN_ERR(drive_adds(shimmed_editor, shimmed_baton, file_count, subpool));
+  shimmed_duration = apr_time_now() - start;
+  svn_pool_destroy(subpool);
+
+  SVN_TEST_INT_ASSERT(direct.files_added, file_count);
+  SVN_TEST_INT_ASSERT(shimmed.files_added, file_count);
+  SVN_TEST_INT_ASSERT(shimmed.props_changed, direct.props_changed);
+
+  if (opts->verbose)
+    printf("direct: %.2f us/node, through shims: %.2f us/node\n",
+           (double)direct_duration / file_count,
+           (double)shimmed_duration / file_count);
+
+  return SVN_NO_ERROR;
+}
+
+
+
+/* The test table.  */
+
+static int max_threads = 1;
+
+static struct svn_test_descriptor_t test_funcs[] =
+  {
+    SVN_TEST_NULL,
+    SVN_TEST_OPTS_PASS(shim_overhead,
+                       "per-node cost of the editor shims"),
+    SVN_TEST_NULL
+  };
+
+SVN_TEST_MAIN
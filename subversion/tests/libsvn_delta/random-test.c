@@ -37,6 +37,7 @@
 #include "svn_pools.h"
 #include "svn_error.h"
 
+#include "private/svn_delta_private.h"
 #include "../../libsvn_delta/delta.h"
 #include "delta-window-test.h"
 
@@ -515,6 +516,302 @@ random_combine_test(apr_pool_t *pool)
 }
 
 
+/* Report the throughput of the delta generator for a large, slightly
+   modified file.  This is a benchmark rather than a test; it only fails
+   if the delta cannot be computed. */
+static svn_error_t *
+delta_throughput(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  const apr_size_t len = 4 * 1024 * 1024;
+  const int repeats = 5;
+  apr_uint32_t seed = 42;
+  svn_stringbuf_t *source = svn_stringbuf_create_ensure(len, pool);
+  svn_stringbuf_t *target = svn_stringbuf_create_ensure(len, pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_time_t start, duration;
+  apr_size_t i;
+  int k;
+
+  /* Generated files are mostly repetitive text.  Change every 1000th
+     byte in the target to force the matcher to resynchronize. */
+  for (i = 0; i < len; ++i)
+    svn_stringbuf_appendbyte(source,
+                             (char)('a' + svn_test_rand(&seed) % 26));
+  svn_stringbuf_appendbytes(target, source->data, source->len);
+  for (i = 1000; i < len; i += 1000)
+    target->data[i - svn_test_rand(&seed) % 1000] = '#';
+
+  start = apr_time_now();
+  for (k = 0; k < repeats; ++k)
+    {
+      svn_txdelta_stream_t *txdelta_stream;
+
+      svn_pool_clear(iterpool);
+      svn_txdelta2(&txdelta_stream,
+                   svn_stream_from_stringbuf(source, iterpool),
+                   svn_stream_from_stringbuf(target, iterpool),
+                   FALSE, iterpool);
+      SVN_ERR(svn_txdelta_send_txstream(txdelta_stream,
+                                        svn_delta_noop_window_handler,
+                                        NULL, iterpool));
+    }
+  duration = apr_time_now() - start;
+  svn_pool_destroy(iterpool);
+
+  if (opts->verbose)
+    printf("delta generation: %.0f MB/s\n",
+           (double)len * repeats / (duration ? duration : 1));
+
+  return SVN_NO_ERROR;
+}
+
+/* Read all windows of the delta from SOURCE to TARGET into a new array
+   of svn_txdelta_window_t * allocated in POOL and return it in *WINDOWS. */
+static svn_error_t *
+read_delta_windows(apr_array_header_t **windows,
+                   svn_stringbuf_t *source,
+                   svn_stringbuf_t *target,
+                   apr_pool_t *pool)
+{
+  svn_txdelta_stream_t *txdelta_stream;
+  svn_txdelta_window_t *window;
+
+  *windows = apr_array_make(pool, 16, sizeof(window));
+  svn_txdelta2(&txdelta_stream,
+               svn_stream_from_stringbuf(source, pool),
+               svn_stream_from_stringbuf(target, pool),
+               FALSE, pool);
+  do
+    {
+      SVN_ERR(svn_txdelta_next_window(&window, txdelta_stream, pool));
+      if (window)
+        APR_ARRAY_PUSH(*windows, svn_txdelta_window_t *) = window;
+    }
+  while (window);
+
+  return SVN_NO_ERROR;
+}
+
+/* Compose two multi-window deltas many times through the same context.
+   Verify that the context stops allocating once it has seen all windows
+   and report the timing compared to svn_txdelta_compose_windows().  */
+static svn_error_t *
+compose_allocations(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  const apr_size_t len = 1024 * 1024;
+  const int repeats = 20;
+  apr_uint32_t seed = 4711;
+  svn_stringbuf_t *source = svn_stringbuf_create_ensure(len, pool);
+  svn_stringbuf_t *middle, *target;
+  apr_array_header_t *windows_A, *windows_B;
+  svn_txdelta__compose_ctx_t *ctx = svn_txdelta__compose_ctx_create(pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_size_t i, warm_allocations = 0, composed = 0;
+  apr_time_t start, ctx_duration, plain_duration;
+  int k;
+
+  for (i = 0; i < len; ++i)
+    svn_stringbuf_appendbyte(source,
+                             (char)('a' + svn_test_rand(&seed) % 26));
+  middle = svn_stringbuf_dup(source, pool);
+  for (i = 500; i < len; i += 500)
+    middle->data[i - svn_test_rand(&seed) % 500] = '#';
+  target = svn_stringbuf_dup(middle, pool);
+  for (i = 700; i < len; i += 700)
+    target->data[i - svn_test_rand(&seed) % 700] = '$';
+
+  SVN_ERR(read_delta_windows(&windows_A, source, middle, pool));
+  SVN_ERR(read_delta_windows(&windows_B, middle, target, pool));
+  SVN_TEST_ASSERT(windows_A->nelts == windows_B->nelts);
+  SVN_TEST_ASSERT(windows_A->nelts > 1);
+
+  start = apr_time_now();
+  for (k = 0; k < repeats; ++k)
+    {
+      int w;
+      for (w = 0; w < windows_B->nelts; ++w)
+        {
+          svn_txdelta_window_t *composite;
+
+          svn_pool_clear(iterpool);
+          composite = svn_txdelta__compose_windows(
+                        ctx,
+                        APR_ARRAY_IDX(windows_A, w, svn_txdelta_window_t *),
+                        APR_ARRAY_IDX(windows_B, w, svn_txdelta_window_t *),
+                        iterpool);
+          SVN_TEST_ASSERT(composite->tview_len
+                          == APR_ARRAY_IDX(windows_B, w,
+                                           svn_txdelta_window_t *)->tview_len);
+          ++composed;
+        }
+
+      /* All buffers have reached their final size after the first round. */
+      if (k == 0)
+        warm_allocations = svn_txdelta__compose_ctx_allocations(ctx);
+      else
+        SVN_TEST_ASSERT(svn_txdelta__compose_ctx_allocations(ctx)
+                        == warm_allocations);
+    }
+  ctx_duration = apr_time_now() - start;
+
+  start = apr_time_now();
+  for (k = 0; k < repeats; ++k)
+    {
+      int w;
+      for (w = 0; w < windows_B->nelts; ++w)
+        {
+          svn_pool_clear(iterpool);
+          svn_txdelta_compose_windows(
+            APR_ARRAY_IDX(windows_A, w, svn_txdelta_window_t *),
+            APR_ARRAY_IDX(windows_B, w, svn_txdelta_window_t *),
+            iterpool);
+        }
+    }
+  plain_duration = apr_time_now() - start;
+  svn_pool_destroy(iterpool);
+
+  if (opts->verbose)
+    {
+      printf("composed windows: %" APR_SIZE_T_FMT ", "
+             "allocations: %" APR_SIZE_T_FMT "\n",
+             composed, svn_txdelta__compose_ctx_allocations(ctx));
+      printf("with context: %.1f us/window, without: %.1f us/window\n",
+             (double)ctx_duration / composed,
+             (double)plain_duration / composed);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Apply WINDOW to SBUF one byte at a time into TBUF.  This is the
+   reference for svn_txdelta_apply_instructions(). */
+static void
+apply_bytewise(const svn_txdelta_window_t *window,
+               const char *sbuf,
+               char *tbuf)
+{
+  apr_size_t tpos = 0;
+  int i;
+
+  for (i = 0; i < window->num_ops; ++i)
+    {
+      const svn_txdelta_op_t *op = &window->ops[i];
+      apr_size_t k;
+
+      for (k = 0; k < op->length; ++k, ++tpos)
+        switch (op->action_code)
+          {
+          case svn_txdelta_source:
+            tbuf[tpos] = sbuf[op->offset + k];
+            break;
+          case svn_txdelta_target:
+            tbuf[tpos] = tbuf[op->offset + k];
+            break;
+          default:
+            tbuf[tpos] = window->new_data->data[op->offset + k];
+            break;
+          }
+    }
+}
+
+/* Report the throughput of svn_txdelta_apply_instructions() for a window
+   of many short instructions, including overlapping target copies of
+   short periods, compared to plain memcpy(). */
+static svn_error_t *
+apply_throughput(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  const int repeats = 200;
+  apr_uint32_t seed = 815;
+  char *sbuf = apr_palloc(pool, SVN_DELTA_WINDOW_SIZE);
+  char *tbuf = apr_palloc(pool, SVN_DELTA_WINDOW_SIZE);
+  char *expected = apr_palloc(pool, SVN_DELTA_WINDOW_SIZE);
+  svn_stringbuf_t *new_data = svn_stringbuf_create_empty(pool);
+  apr_array_header_t *ops = apr_array_make(pool, 16384,
+                                           sizeof(svn_txdelta_op_t));
+  svn_txdelta_window_t window = { 0 };
+  apr_size_t i, tpos = 0, tlen;
+  apr_time_t start, apply_duration, memcpy_duration;
+  int k;
+
+  for (i = 0; i < SVN_DELTA_WINDOW_SIZE; ++i)
+    sbuf[i] = (char)svn_test_rand(&seed);
+
+  /* Random mix of short instructions, 1 to 32 bytes each. */
+  while (tpos < SVN_DELTA_WINDOW_SIZE)
+    {
+      svn_txdelta_op_t op;
+
+      op.length = 1 + svn_test_rand(&seed) % 32;
+      if (op.length > SVN_DELTA_WINDOW_SIZE - tpos)
+        op.length = SVN_DELTA_WINDOW_SIZE - tpos;
+
+      switch (tpos ? svn_test_rand(&seed) % 3 : svn_txdelta_new)
+        {
+        case svn_txdelta_source:
+          op.action_code = svn_txdelta_source;
+          op.offset = svn_test_rand(&seed)
+                    % (SVN_DELTA_WINDOW_SIZE - op.length);
+          ++window.src_ops;
+          break;
+
+        case svn_txdelta_target:
+          /* Mostly short periods, which overlap the target position. */
+          op.action_code = svn_txdelta_target;
+          op.offset = tpos - 1 - svn_test_rand(&seed) % (tpos < 8 ? tpos : 8);
+          break;
+
+        default:
+          op.action_code = svn_txdelta_new;
+          op.offset = new_data->len;
+          for (i = 0; i < op.length; ++i)
+            svn_stringbuf_appendbyte(new_data, (char)svn_test_rand(&seed));
+          break;
+        }
+
+      APR_ARRAY_PUSH(ops, svn_txdelta_op_t) = op;
+      tpos += op.length;
+    }
+
+  window.sview_len = SVN_DELTA_WINDOW_SIZE;
+  window.tview_len = SVN_DELTA_WINDOW_SIZE;
+  window.num_ops = ops->nelts;
+  window.ops = (svn_txdelta_op_t *)ops->elts;
+  window.new_data = svn_string_create_from_buf(new_data, pool);
+
+  apply_bytewise(&window, sbuf, expected);
+
+  start = apr_time_now();
+  for (k = 0; k < repeats; ++k)
+    {
+      tlen = SVN_DELTA_WINDOW_SIZE;
+      svn_txdelta_apply_instructions(&window, sbuf, tbuf, &tlen);
+    }
+  apply_duration = apr_time_now() - start;
+
+  SVN_TEST_ASSERT(tlen == SVN_DELTA_WINDOW_SIZE);
+  SVN_TEST_ASSERT(memcmp(tbuf, expected, SVN_DELTA_WINDOW_SIZE) == 0);
+
+  start = apr_time_now();
+  for (k = 0; k < repeats; ++k)
+    memcpy(tbuf, sbuf + (k & 1), SVN_DELTA_WINDOW_SIZE - 1);
+  memcpy_duration = apr_time_now() - start;
+
+  if (opts->verbose)
+    printf("%d instructions: %.0f MB/s, memcpy: %.0f MB/s\n",
+           window.num_ops,
+           (double)SVN_DELTA_WINDOW_SIZE * repeats
+             / (apply_duration ? apply_duration : 1),
+           (double)SVN_DELTA_WINDOW_SIZE * repeats
+             / (memcpy_duration ? memcpy_duration : 1));
+
+  return SVN_NO_ERROR;
+}
+
+
 /* Change to 1 to enable the unit test for the delta combiner's range index: */
 #if 0
 #include "range-index-test.h"
@@ -533,6 +830,12 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "random delta test"),
     SVN_TEST_PASS2(random_combine_test,
                    "random combine delta test"),
+    SVN_TEST_OPTS_PASS(delta_throughput,
+                       "delta generation throughput"),
+    SVN_TEST_OPTS_PASS(compose_allocations,
+                       "reuse buffers when composing windows"),
+    SVN_TEST_OPTS_PASS(apply_throughput,
+                       "delta application throughput"),
 #ifdef SVN_RANGE_INDEX_TEST_H
     SVN_TEST_PASS2(random_range_index_test,
                    "random range index test"),
@@ -30,6 +30,7 @@
 #include "svn_delta.h"
 
 #include "private/svn_subr_private.h"
+#include "private/svn_delta_private.h"
 
 static svn_error_t *
 stream_window_test(apr_pool_t *pool)
@@ -96,6 +97,430 @@ stream_window_test(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Encode the delta between SOURCE and TARGET as svndiff VERSION into
+   *RESULT, using up to THREADS worker threads. */
+static svn_error_t *
+encode_svndiff(svn_stringbuf_t **result,
+               const svn_stringbuf_t *source,
+               const svn_stringbuf_t *target,
+               int version,
+               int threads,
+               apr_pool_t *pool)
+{
+  svn_txdelta_stream_t *txstream;
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+
+  *result = svn_stringbuf_create_empty(pool);
+  svn_delta__set_encoder_threads(threads);
+
+  svn_txdelta2(&txstream,
+               svn_stream_from_string(svn_string_create_from_buf(source,
+                                                                 pool),
+                                      pool),
+               svn_stream_from_string(svn_string_create_from_buf(target,
+                                                                 pool),
+                                      pool),
+               FALSE, pool);
+  svn_txdelta_to_svndiff3(&handler, &handler_baton,
+                          svn_stream_from_stringbuf(*result, pool),
+                          version, SVN_DELTA_COMPRESSION_LEVEL_DEFAULT,
+                          pool);
+  SVN_ERR(svn_txdelta_send_txstream(txstream, handler, handler_baton, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Fill *SOURCE and *TARGET with LEN bytes of somewhat compressible data
+   with a few changes between them. */
+static void
+create_delta_test_data(svn_stringbuf_t **source,
+                       svn_stringbuf_t **target,
+                       apr_size_t len,
+                       apr_pool_t *pool)
+{
+  apr_uint32_t seed = 0;
+
+  *source = svn_stringbuf_create_ensure(len, pool);
+  *target = svn_stringbuf_create_ensure(len, pool);
+  while ((*source)->len < len)
+    {
+      char c = (char)('a' + (svn_test_rand(&seed) % 16));
+      svn_stringbuf_appendbyte(*source, c);
+      svn_stringbuf_appendbyte(*target,
+                               svn_test_rand(&seed) % 100 ? c : 'X');
+    }
+}
+
+/* Return the highest svndiff version supported by this build. */
+static int
+max_svndiff_version(void)
+{
+  return svn_lz4__compiled_version() ? 2 : 1;
+}
+
+/* The pipelined svndiff encoder must produce exactly the same output as
+   the serial one. */
+static svn_error_t *
+parallel_svndiff_test(apr_pool_t *pool)
+{
+  svn_stringbuf_t *source, *target;
+  int version;
+
+  /* Enough data for about 20 delta windows. */
+  create_delta_test_data(&source, &target, 2 * 1024 * 1024 + 1234, pool);
+
+  for (version = 0; version <= max_svndiff_version(); ++version)
+    {
+      svn_stringbuf_t *serial, *parallel;
+
+      SVN_ERR(encode_svndiff(&serial, source, target, version, 0, pool));
+      SVN_ERR(encode_svndiff(&parallel, source, target, version, 4, pool));
+
+      SVN_TEST_ASSERT(serial->len > 0);
+      SVN_TEST_ASSERT(svn_stringbuf_compare(serial, parallel));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Compute the delta between SOURCE and TARGET using up to THREADS worker
+   threads and return it as plain svndiff in *RESULT together with the
+   target's MD5 checksum in *DIGEST.  Use svn_txdelta_run() if RUN is set
+   and a svn_txdelta2() stream otherwise. */
+static svn_error_t *
+compute_delta(svn_stringbuf_t **result,
+              svn_checksum_t **digest,
+              const svn_stringbuf_t *source,
+              const svn_stringbuf_t *target,
+              int threads,
+              svn_boolean_t run,
+              apr_pool_t *pool)
+{
+  svn_stream_t *source_stream
+    = svn_stream_from_string(svn_string_create_from_buf(source, pool), pool);
+  svn_stream_t *target_stream
+    = svn_stream_from_string(svn_string_create_from_buf(target, pool), pool);
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+
+  *result = svn_stringbuf_create_empty(pool);
+  svn_delta__set_delta_threads(threads);
+  svn_delta__set_encoder_threads(0);
+  svn_txdelta_to_svndiff3(&handler, &handler_baton,
+                          svn_stream_from_stringbuf(*result, pool),
+                          0, SVN_DELTA_COMPRESSION_LEVEL_NONE, pool);
+
+  if (run)
+    {
+      SVN_ERR(svn_txdelta_run(source_stream, target_stream,
+                              handler, handler_baton,
+                              svn_checksum_md5, digest,
+                              NULL, NULL, pool, pool));
+    }
+  else
+    {
+      svn_txdelta_stream_t *txstream;
+
+      svn_txdelta2(&txstream, source_stream, target_stream, TRUE, pool);
+      SVN_ERR(svn_txdelta_send_txstream(txstream, handler, handler_baton,
+                                        pool));
+      *digest = svn_checksum__from_digest_md5(svn_txdelta_md5_digest(txstream),
+                                              pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Computing delta windows in parallel must produce exactly the same
+   delta as the serial code. */
+static svn_error_t *
+parallel_delta_test(apr_pool_t *pool)
+{
+  svn_stringbuf_t *source, *target;
+  int run;
+
+  /* Enough data for about 20 delta windows.  Make the target longer than
+     the source to cover windows without source data. */
+  create_delta_test_data(&source, &target, 2 * 1024 * 1024 + 1234, pool);
+  svn_stringbuf_appendbytes(target, source->data, 300 * 1024);
+
+  for (run = 0; run < 2; ++run)
+    {
+      svn_stringbuf_t *serial, *parallel;
+      svn_checksum_t *serial_digest, *parallel_digest;
+
+      SVN_ERR(compute_delta(&serial, &serial_digest, source, target, 0,
+                            run, pool));
+      SVN_ERR(compute_delta(&parallel, &parallel_digest, source, target, 4,
+                            run, pool));
+
+      SVN_TEST_ASSERT(serial->len > 0);
+      SVN_TEST_ASSERT(svn_stringbuf_compare(serial, parallel));
+      SVN_TEST_ASSERT(svn_checksum_match(serial_digest, parallel_digest));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the delta between SOURCE and TARGET with content-defined windows
+   as plain svndiff in *RESULT.  Use the target push variant if PUSH is
+   set and a delta stream otherwise.  Push the target in chunks of varying
+   size to cover partially filled buffers. */
+static svn_error_t *
+compute_cdc_delta(svn_stringbuf_t **result,
+                  const svn_stringbuf_t *source,
+                  const svn_stringbuf_t *target,
+                  svn_boolean_t push,
+                  apr_pool_t *pool)
+{
+  svn_stream_t *source_stream
+    = svn_stream_from_string(svn_string_create_from_buf(source, pool), pool);
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+
+  *result = svn_stringbuf_create_empty(pool);
+  svn_delta__set_encoder_threads(0);
+  svn_txdelta_to_svndiff3(&handler, &handler_baton,
+                          svn_stream_from_stringbuf(*result, pool),
+                          0, SVN_DELTA_COMPRESSION_LEVEL_NONE, pool);
+
+  if (push)
+    {
+      svn_stream_t *stream = svn_txdelta__target_push_cdc(handler,
+                                                          handler_baton,
+                                                          source_stream,
+                                                          pool);
+      apr_size_t offset = 0;
+      apr_uint32_t seed = 0;
+
+      while (offset < target->len)
+        {
+          apr_size_t len = 1 + svn_test_rand(&seed) % 70000;
+          if (len > target->len - offset)
+            len = target->len - offset;
+
+          SVN_ERR(svn_stream_write(stream, target->data + offset, &len));
+          offset += len;
+        }
+
+      SVN_ERR(svn_stream_close(stream));
+    }
+  else
+    {
+      svn_txdelta_stream_t *txstream;
+      svn_stream_t *target_stream
+        = svn_stream_from_string(svn_string_create_from_buf(target, pool),
+                                 pool);
+
+      svn_txdelta__cdc(&txstream, source_stream, target_stream, TRUE, pool);
+      SVN_ERR(svn_txdelta_send_txstream(txstream, handler, handler_baton,
+                                        pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Apply the SVNDIFF against SOURCE and return the result in *TARGET. */
+static svn_error_t *
+apply_svndiff(svn_stringbuf_t **target,
+              const svn_stringbuf_t *source,
+              const svn_stringbuf_t *svndiff,
+              apr_pool_t *pool)
+{
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+  svn_stream_t *parser;
+  apr_size_t len = svndiff->len;
+
+  *target = svn_stringbuf_create_empty(pool);
+  svn_txdelta_apply(svn_stream_from_string(
+                      svn_string_create_from_buf(source, pool), pool),
+                    svn_stream_from_stringbuf(*target, pool),
+                    NULL, NULL, pool, &handler, &handler_baton);
+  parser = svn_txdelta_parse_svndiff(handler, handler_baton, TRUE, pool);
+
+  SVN_ERR(svn_stream_write(parser, svndiff->data, &len));
+  SVN_ERR(svn_stream_close(parser));
+
+  return SVN_NO_ERROR;
+}
+
+/* Content-defined windows must stay in sync with the source after data
+   got inserted or removed near the start of the target. */
+static svn_error_t *
+cdc_delta_test(apr_pool_t *pool)
+{
+  svn_stringbuf_t *source, *modified, *target, *fixed;
+  apr_size_t inserted = 300 * 1024;
+  apr_size_t removed = 500 * 1024;
+  int i, push;
+
+  create_delta_test_data(&source, &modified, 2 * 1024 * 1024 + 1234, pool);
+
+  for (i = 0; i < 2; ++i)
+    {
+      /* Insert modified data resp. remove a chunk close to the start. */
+      target = svn_stringbuf_create_ensure(source->len + inserted, pool);
+      svn_stringbuf_appendbytes(target, source->data, 1000);
+      if (i == 0)
+        {
+          svn_stringbuf_appendbytes(target, modified->data, inserted);
+          svn_stringbuf_appendbytes(target, source->data + 1000,
+                                    source->len - 1000);
+        }
+      else
+        {
+          svn_stringbuf_appendbytes(target, source->data + 1000 + removed,
+                                    source->len - 1000 - removed);
+        }
+
+      SVN_ERR(compute_delta(&fixed, NULL, source, target, 0, TRUE, pool));
+      for (push = 0; push < 2; ++push)
+        {
+          svn_stringbuf_t *svndiff, *result;
+
+          SVN_ERR(compute_cdc_delta(&svndiff, source, target, push, pool));
+          SVN_ERR(apply_svndiff(&result, source, svndiff, pool));
+          SVN_TEST_ASSERT(svn_stringbuf_compare(result, target));
+
+          /* Fixed windows lose almost all matches. */
+          SVN_TEST_ASSERT(svndiff->len < inserted + target->len / 10);
+          SVN_TEST_ASSERT(svndiff->len * 2 < fixed->len);
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Every svndiff version must reproduce the target when applied to the
+   source. */
+static svn_error_t *
+svndiff_roundtrip_test(apr_pool_t *pool)
+{
+  svn_stringbuf_t *source, *target;
+  int version;
+
+  create_delta_test_data(&source, &target, 300 * 1024 + 17, pool);
+
+  for (version = 0; version <= max_svndiff_version(); ++version)
+    {
+      svn_stringbuf_t *svndiff, *result;
+
+      SVN_ERR(encode_svndiff(&svndiff, source, target, version, 0, pool));
+      SVN_TEST_ASSERT(svndiff->len > 4 && svndiff->data[3] == version);
+
+      SVN_ERR(apply_svndiff(&result, source, svndiff, pool));
+      SVN_TEST_ASSERT(svn_stringbuf_compare(result, target));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Apply the SVNDIFF against SOURCE using the in-place buffer parser and
+   return the result in *TARGET. */
+static svn_error_t *
+apply_svndiff_buffer(svn_stringbuf_t **target,
+                     const svn_stringbuf_t *source,
+                     const char *svndiff,
+                     apr_size_t len,
+                     apr_pool_t *pool)
+{
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+
+  *target = svn_stringbuf_create_empty(pool);
+  svn_txdelta_apply(svn_stream_from_string(
+                      svn_string_create_from_buf(source, pool), pool),
+                    svn_stream_from_stringbuf(*target, pool),
+                    NULL, NULL, pool, &handler, &handler_baton);
+
+  return svn_error_trace(svn_txdelta__parse_svndiff_buffer(svndiff, len,
+                                                           handler,
+                                                           handler_baton,
+                                                           pool));
+}
+
+/* Parsing svndiff in-place must give the same result as the streamy
+   parser and detect truncated data. */
+static svn_error_t *
+svndiff_buffer_test(apr_pool_t *pool)
+{
+  svn_stringbuf_t *source, *target;
+  int version;
+
+  create_delta_test_data(&source, &target, 300 * 1024 + 17, pool);
+
+  for (version = 0; version <= max_svndiff_version(); ++version)
+    {
+      svn_stringbuf_t *svndiff, *result;
+
+      SVN_ERR(encode_svndiff(&svndiff, source, target, version, 0, pool));
+      SVN_ERR(apply_svndiff_buffer(&result, source, svndiff->data,
+                                   svndiff->len, pool));
+      SVN_TEST_ASSERT(svn_stringbuf_compare(result, target));
+
+      SVN_TEST_ASSERT_ERROR(apply_svndiff_buffer(&result, source,
+                                                 svndiff->data,
+                                                 svndiff->len - 1, pool),
+                            SVN_ERR_SVNDIFF_UNEXPECTED_END);
+      SVN_TEST_ASSERT_ERROR(apply_svndiff_buffer(&result, source,
+                                                 svndiff->data, 3, pool),
+                            SVN_ERR_SVNDIFF_UNEXPECTED_END);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* LZ4 compression must round-trip and handle incompressible data. */
+static svn_error_t *
+lz4_compression_test(apr_pool_t *pool)
+{
+  svn_stringbuf_t *source, *target;
+  svn_stringbuf_t *compressed = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *decompressed = svn_stringbuf_create_empty(pool);
+  apr_uint32_t seed = 0;
+  apr_size_t i;
+
+  if (!svn_lz4__compiled_version())
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "LZ4 support is not available");
+
+  /* Compressible data must shrink. */
+  create_delta_test_data(&source, &target, 100 * 1024, pool);
+  SVN_ERR(svn__compress_lz4(source->data, source->len, compressed));
+  SVN_TEST_ASSERT(compressed->len < source->len);
+  SVN_ERR(svn__decompress_lz4(compressed->data, compressed->len,
+                              decompressed, source->len));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(decompressed, source));
+
+  /* The LIMIT must be honored. */
+  SVN_TEST_ASSERT_ERROR(svn__decompress_lz4(compressed->data,
+                                            compressed->len,
+                                            decompressed,
+                                            source->len - 1),
+                        SVN_ERR_SVNDIFF_INVALID_COMPRESSED_DATA);
+
+  /* Random data is stored verbatim. */
+  svn_stringbuf_setempty(source);
+  for (i = 0; i < 10000; ++i)
+    svn_stringbuf_appendbyte(source, (char)svn_test_rand(&seed));
+
+  SVN_ERR(svn__compress_lz4(source->data, source->len, compressed));
+  SVN_TEST_ASSERT(compressed->len <= source->len + SVN__MAX_ENCODED_UINT_LEN);
+  SVN_ERR(svn__decompress_lz4(compressed->data, compressed->len,
+                              decompressed, source->len));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(decompressed, source));
+
+  /* Empty input. */
+  SVN_ERR(svn__compress_lz4("", 0, compressed));
+  SVN_ERR(svn__decompress_lz4(compressed->data, compressed->len,
+                              decompressed, 0));
+  SVN_TEST_ASSERT(decompressed->len == 0);
+
+  return SVN_NO_ERROR;
+}
+
 
 
 /* The test table.  */
@@ -107,6 +532,18 @@ static struct svn_test_descriptor_t test_funcs[] =
     SVN_TEST_NULL,
     SVN_TEST_PASS2(stream_window_test,
                    "txdelta stream and windows test"),
+    SVN_TEST_PASS2(parallel_svndiff_test,
+                   "parallel svndiff encoding"),
+    SVN_TEST_PASS2(parallel_delta_test,
+                   "parallel delta computation"),
+    SVN_TEST_PASS2(svndiff_roundtrip_test,
+                   "svndiff round trip for all versions"),
+    SVN_TEST_PASS2(lz4_compression_test,
+                   "LZ4 compression"),
+    SVN_TEST_PASS2(cdc_delta_test,
+                   "content-defined delta windows"),
+    SVN_TEST_PASS2(svndiff_buffer_test,
+                   "parse svndiff in-place"),
     SVN_TEST_NULL
   };
 
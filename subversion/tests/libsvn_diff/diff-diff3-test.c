@@ -28,6 +28,8 @@
 #include "svn_pools.h"
 #include "svn_utf.h"
 
+#include "private/svn_diff_private.h"
+
 /* Used to terminate lines in large multi-line string literals. */
 #define NL APR_EOL_STR
 
@@ -2959,6 +2961,224 @@ two_way_issue_3362_v2(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+two_way_histogram(apr_pool_t *pool)
+{
+  svn_diff_file_options_t *diff_opts = svn_diff_file_options_create(pool);
+  apr_array_header_t *args = apr_array_make(pool, 1, sizeof(const char *));
+
+  APR_ARRAY_PUSH(args, const char *) = "--histogram";
+  SVN_ERR(svn_diff_file_options_parse(diff_opts, args, pool));
+  SVN_TEST_ASSERT(diff_opts->algorithm == svn_diff_algorithm_histogram);
+
+  /* The LCS algorithm keeps the closing brace and the empty line after
+     f1() in place and reports f3() as inserted after them.  The histogram
+     algorithm anchors on the unique lines of f2() and reports the new
+     lines as one block. */
+  SVN_ERR(two_way_diff("histogram-1",
+                       "histogram-2",
+                        /* File 1 */
+                                "void f1(void)\n"
+                                "{\n"
+                                "  a();\n"
+                                "}\n"
+                                "\n"
+                                "void f2(void)\n"
+                                "{\n"
+                                "  b();\n"
+                                "}\n",
+                        /* File 2 */
+                                "void f1(void)\n"
+                                "{\n"
+                                "  a2();\n"
+                                "}\n"
+                                "\n"
+                                "void f3(void)\n"
+                                "{\n"
+                                "  c();\n"
+                                "}\n"
+                                "\n"
+                                "void f2(void)\n"
+                                "{\n"
+                                "  b();\n"
+                                "}\n",
+                        /* Expected */
+                        "--- histogram-1" APR_EOL_STR
+                        "+++ histogram-2" APR_EOL_STR
+                        "@@ -1,6 +1,11 @@" APR_EOL_STR
+                        " void f1(void)\n"
+                        " {\n"
+                        "-  a();\n"
+                        "+  a2();\n"
+                        "+}\n"
+                        "+\n"
+                        "+void f3(void)\n"
+                        "+{\n"
+                        "+  c();\n"
+                        " }\n"
+                        " \n"
+                        " void f2(void)\n",
+                        diff_opts, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Like random_trivial_merge() but use the histogram diff algorithm. */
+static svn_error_t *
+random_histogram_merge(apr_pool_t *pool)
+{
+  int i;
+  apr_pool_t *subpool = svn_pool_create(pool);
+  svn_diff_file_options_t *diff_opts = svn_diff_file_options_create(pool);
+
+  const char *base_filename1 = "histogram-trivial1";
+  const char *base_filename2 = "histogram-trivial2";
+
+  const char *filename1 = svn_test_data_path(base_filename1, pool);
+  const char *filename2 = svn_test_data_path(base_filename2, pool);
+
+  diff_opts->algorithm = svn_diff_algorithm_histogram;
+  seed_val();
+
+  for (i = 0; i < 5; ++i)
+    {
+      int min_lines = 1000;
+      int max_lines = 1100;
+      int var_lines = 50;
+      int block_lines = 10;
+      svn_stringbuf_t *contents1, *contents2;
+
+      SVN_ERR(make_random_file(filename1,
+                               min_lines, max_lines, var_lines, block_lines,
+                               i % 3, subpool));
+      SVN_ERR(make_random_file(filename2,
+                               min_lines, max_lines, var_lines, block_lines,
+                               i % 2, subpool));
+
+      SVN_ERR(svn_stringbuf_from_file2(&contents1, filename1, subpool));
+      SVN_ERR(svn_stringbuf_from_file2(&contents2, filename2, subpool));
+
+      SVN_ERR(three_way_merge(base_filename1, base_filename2, base_filename1,
+                              contents1->data, contents2->data,
+                              contents1->data, contents2->data, diff_opts,
+                              svn_diff_conflict_display_modified_latest,
+                              subpool));
+      SVN_ERR(three_way_merge(base_filename2, base_filename1, base_filename2,
+                              contents2->data, contents1->data,
+                              contents2->data, contents1->data, diff_opts,
+                              svn_diff_conflict_display_modified_latest,
+                              subpool));
+      svn_pool_clear(subpool);
+    }
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Write a file called FILENAME with NUM_LINES lines, where every line
+   whose number is a multiple of CHANGE_EVERY, offset by CHANGE_OFFSET,
+   differs from the default.  Every seventh line has mixed whitespace and
+   CRLF line endings. */
+static svn_error_t *
+make_large_file(const char *filename,
+                int num_lines,
+                int change_every,
+                int change_offset,
+                apr_pool_t *pool)
+{
+  svn_stringbuf_t *contents = svn_stringbuf_create_empty(pool);
+  int i;
+
+  for (i = 0; i < num_lines; i++)
+    {
+      const char *eol = (i % 7) ? "\n" : "\r\n";
+      const char *space = (i % 7) ? " " : " \t ";
+
+      if (i % change_every == change_offset)
+        svn_stringbuf_appendcstr(contents,
+                                 apr_psprintf(pool, "changed%s%d %d%s",
+                                              space, i, change_offset, eol));
+      else
+        svn_stringbuf_appendcstr(contents,
+                                 apr_psprintf(pool, "line%s%d line %d%s",
+                                              space, i % 97, i, eol));
+    }
+
+  return svn_error_trace(make_file(filename, contents->data, pool));
+}
+
+/* Diff and merge the files ORIGINAL, MODIFIED and LATEST with DIFF_OPTS
+   and return the unified diff of ORIGINAL and MODIFIED followed by the
+   merge result in *RESULT. */
+static svn_error_t *
+diff_and_merge_large_files(svn_stringbuf_t **result,
+                           const char *original,
+                           const char *modified,
+                           const char *latest,
+                           const svn_diff_file_options_t *diff_opts,
+                           apr_pool_t *pool)
+{
+  svn_diff_t *diff;
+  svn_stream_t *ostream;
+
+  *result = svn_stringbuf_create_empty(pool);
+  ostream = svn_stream_from_stringbuf(*result, pool);
+
+  SVN_ERR(svn_diff_file_diff_2(&diff, original, modified, diff_opts, pool));
+  SVN_ERR(svn_diff_file_output_unified4(ostream, diff, original, modified,
+                                        NULL, NULL, SVN_APR_LOCALE_CHARSET,
+                                        NULL, FALSE, -1, NULL, NULL, pool));
+
+  SVN_ERR(svn_diff_file_diff3_2(&diff, original, modified, latest,
+                                diff_opts, pool));
+  SVN_ERR(svn_diff_file_output_merge3(ostream, diff, original, modified,
+                                      latest, NULL, NULL, NULL, NULL,
+                                      svn_diff_conflict_display_modified_latest,
+                                      NULL, NULL, pool));
+
+  return svn_error_trace(svn_stream_close(ostream));
+}
+
+/* Check that diffs of files large enough to be tokenized concurrently
+   are the same as when they are tokenized serially. */
+static svn_error_t *
+test_tokenize_threads(apr_pool_t *pool)
+{
+  const char *original = svn_test_data_path("tokenize-threads1", pool);
+  const char *modified = svn_test_data_path("tokenize-threads2", pool);
+  const char *latest = svn_test_data_path("tokenize-threads3", pool);
+  svn_diff_file_options_t *diff_opts = svn_diff_file_options_create(pool);
+  int i;
+
+  /* More than half a megabyte per file. */
+  SVN_ERR(make_large_file(original, 30000, 1000000, -1, pool));
+  SVN_ERR(make_large_file(modified, 30000, 997, 3, pool));
+  SVN_ERR(make_large_file(latest, 30000, 1009, 500, pool));
+
+  for (i = 0; i < 4; i++)
+    {
+      svn_stringbuf_t *serial;
+      svn_stringbuf_t *parallel;
+
+      diff_opts->ignore_space = (i & 1) ? svn_diff_file_ignore_space_all
+                                        : svn_diff_file_ignore_space_none;
+      diff_opts->ignore_eol_style = (i & 2) != 0;
+
+      svn_diff__set_tokenize_threads(0);
+      SVN_ERR(diff_and_merge_large_files(&serial, original, modified, latest,
+                                         diff_opts, pool));
+
+      svn_diff__set_tokenize_threads(4);
+      SVN_ERR(diff_and_merge_large_files(&parallel, original, modified,
+                                         latest, diff_opts, pool));
+
+      SVN_TEST_ASSERT(serial->len > 0);
+      SVN_TEST_STRING_ASSERT(parallel->data, serial->data);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 three_way_double_add(apr_pool_t *pool)
 {
@@ -3121,6 +3341,12 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "2-way issue #3362 test v2"),
     SVN_TEST_PASS2(three_way_double_add,
                    "3-way merge, double add"),
+    SVN_TEST_PASS2(two_way_histogram,
+                   "2-way diff using the histogram algorithm"),
+    SVN_TEST_PASS2(random_histogram_merge,
+                   "random trivial merge using histogram diffs"),
+    SVN_TEST_PASS2(test_tokenize_threads,
+                   "tokenize large files concurrently"),
     SVN_TEST_NULL
   };
 
@@ -1104,6 +1104,84 @@ test_parse_unidiff_with_mergeinfo(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Parse a patch file that is large enough to be memory mapped. */
+static svn_error_t *
+test_parse_large_unidiff(apr_pool_t *pool)
+{
+  svn_stringbuf_t *large_diff = svn_stringbuf_create_empty(pool);
+  svn_patch_file_t *patch_file;
+  svn_patch_t *patch;
+  svn_diff_hunk_t *hunk;
+  apr_pool_t *iterpool;
+  int i;
+
+  for (i = 0; i < 2000; i++)
+    svn_stringbuf_appendcstr(large_diff, apr_psprintf(pool,
+      "Index: file%d"                                                       NL
+      "===================================================================" NL
+      "--- file%d\t(revision 1)"                                            NL
+      "+++ file%d\t(working copy)"                                          NL
+      "@@ -1,2 +1,2 @@"                                                     NL
+      " context %d"                                                         NL
+      "-old line %d"                                                        NL
+      "+new line %d"                                                        NL,
+      i, i, i, i, i, i));
+
+  /* End with a hunk lacking its trailing EOL. */
+  svn_stringbuf_appendcstr(large_diff, unidiff_lacking_trailing_eol);
+  SVN_TEST_ASSERT(large_diff->len > 64 * 1024);
+
+  SVN_ERR(create_patch_file(&patch_file, large_diff->data, pool));
+
+  iterpool = svn_pool_create(pool);
+  for (i = 0; i < 2000; i++)
+    {
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_diff_parse_next_patch(&patch, patch_file, FALSE, FALSE,
+                                        iterpool, iterpool));
+      SVN_TEST_ASSERT(patch);
+      SVN_TEST_STRING_ASSERT(patch->new_filename,
+                             apr_psprintf(iterpool, "file%d", i));
+      SVN_TEST_ASSERT(patch->hunks->nelts == 1);
+
+      hunk = APR_ARRAY_IDX(patch->hunks, 0, svn_diff_hunk_t *);
+      SVN_ERR(check_content(hunk, TRUE,
+                            apr_psprintf(iterpool,
+                                         "context %d" NL
+                                         "old line %d" NL, i, i),
+                            iterpool));
+      SVN_ERR(check_content(hunk, FALSE,
+                            apr_psprintf(iterpool,
+                                         "context %d" NL
+                                         "new line %d" NL, i, i),
+                            iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  SVN_ERR(svn_diff_parse_next_patch(&patch, patch_file, FALSE, FALSE,
+                                    pool, pool));
+  SVN_TEST_ASSERT(patch);
+  SVN_TEST_STRING_ASSERT(patch->new_filename, "A/C/gamma");
+  SVN_TEST_ASSERT(patch->hunks->nelts == 1);
+
+  hunk = APR_ARRAY_IDX(patch->hunks, 0, svn_diff_hunk_t *);
+  SVN_ERR(check_content(hunk, TRUE,
+                        "This is the file 'gamma'." NL,
+                        pool));
+  SVN_ERR(check_content(hunk, FALSE,
+                        "This is the file 'gamma'." NL
+                        "some more bytes to 'gamma'",
+                        pool));
+
+  SVN_ERR(svn_diff_parse_next_patch(&patch, patch_file, FALSE, FALSE,
+                                    pool, pool));
+  SVN_TEST_ASSERT(patch == NULL);
+
+  SVN_ERR(svn_diff_close_patch_file(patch_file, pool));
+  return SVN_NO_ERROR;
+}
+
 /* ========================================================================== */
 
 
@@ -1132,6 +1210,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test parsing unidiffs lacking trailing eol"),
     SVN_TEST_PASS2(test_parse_unidiff_with_mergeinfo,
                    "test parsing unidiffs with mergeinfo"),
+    SVN_TEST_PASS2(test_parse_large_unidiff,
+                   "test parsing a memory mapped unidiff"),
     SVN_TEST_NULL
   };
 
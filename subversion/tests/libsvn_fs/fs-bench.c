@@ -0,0 +1,545 @@
+/* fs-bench.c --- time typical operations of the FS backends
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* This is not a test but a benchmark driver.  For each backend and cache
+ * configuration, it generates synthetic repositories of a few typical
+ * shapes below a scratch directory and times commits, path lookups,
+ * fulltext reads, history walks (the FS part of 'svn log') and packing.
+ *
+ *   deep    a file at the bottom of a deep directory chain, modified by
+ *           every commit;
+ *   wide    a single directory that grows by 100 files per commit;
+ *   deltas  a single file that grows by one line per commit, producing
+ *           long delta chains;
+ *   small   many commits that each add one small file.
+ *
+ * The global membuffer cache is shared by all runs of one process; set
+ * its size with -M.  The per-repository cache options are switched
+ * between the 'all' and 'none' cache configurations.
+ */
+
+#include <string.h>
+#include <apr_getopt.h>
+#include <apr_pools.h>
+#include <apr_time.h>
+
+#include "svn_cache_config.h"
+#include "svn_cmdline.h"
+#include "svn_dirent_uri.h"
+#include "svn_error.h"
+#include "svn_fs.h"
+#include "svn_hash.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+#include "svn_string.h"
+
+#include "private/svn_cmdline_private.h"
+
+#include "svn_private_config.h"
+
+
+/*** Repository shapes. ***/
+
+/* Depth of the directory chain of the 'deep' shape. */
+#define DEEP_LEVELS 32
+
+/* Files added per commit in the 'wide' shape. */
+#define WIDE_FILES_PER_COMMIT 100
+
+/* Number of directories the 'small' shape spreads its files across. */
+#define SMALL_DIRS 10
+
+/* Number of path lookups to time per repository. */
+#define LOOKUPS 10000
+
+/* Maximum number of files to read per repository. */
+#define MAX_READS 100
+
+/* A repository shape.  COMMITS is the number of commits at scale 1. */
+typedef struct shape_t
+{
+  const char *name;
+  int commits;
+} shape_t;
+
+static const shape_t shapes[] =
+{
+  { "deep", 100 },
+  { "wide", 100 },
+  { "deltas", 1000 },
+  { "small", 1000 },
+  { NULL, 0 }
+};
+
+/* A repository being generated and measured. */
+typedef struct bench_repos_t
+{
+  const char *fs_type;
+  const char *cache_name;
+  const char *shape;
+  const char *path;
+  apr_hash_t *fs_config;
+  svn_fs_t *fs;
+
+  /* Files that exist in HEAD, in the order they were added. */
+  apr_array_header_t *files;
+
+  /* Path whose history is walked. */
+  const char *history_path;
+
+  /* Contents of the file of the 'deltas' shape. */
+  svn_stringbuf_t *contents;
+} bench_repos_t;
+
+/* Print the time ELAPSED that OPERATION took on REPOS for OPS calls. */
+static svn_error_t *
+report(bench_repos_t *repos,
+       const char *operation,
+       int ops,
+       apr_time_t elapsed,
+       apr_pool_t *pool)
+{
+  return svn_error_trace(
+           svn_cmdline_printf(pool,
+                              "%-5s %-5s %-7s %-7s %8d ops %12.3f ms "
+                              "%12.3f us/op\n",
+                              repos->fs_type, repos->cache_name,
+                              repos->shape, operation, ops,
+                              elapsed / 1000.0,
+                              ops ? (double)elapsed / ops : 0.0));
+}
+
+/* Set the contents of the file PATH in ROOT to DATA. */
+static svn_error_t *
+set_contents(svn_fs_root_t *root,
+             const char *path,
+             const char *data,
+             apr_size_t len,
+             apr_pool_t *pool)
+{
+  svn_stream_t *stream;
+
+  SVN_ERR(svn_fs_apply_text(&stream, root, path, NULL, pool));
+  SVN_ERR(svn_stream_write(stream, data, &len));
+
+  return svn_error_trace(svn_stream_close(stream));
+}
+
+/* Make the changes of commit number I of REPOS in ROOT. */
+static svn_error_t *
+make_changes(bench_repos_t *repos,
+             svn_fs_root_t *root,
+             int i,
+             apr_pool_t *pool)
+{
+  apr_pool_t *result_pool = repos->files->pool;
+  const char *content = apr_psprintf(pool, "This is change %d.\n", i);
+  const char *path;
+  int k;
+
+  if (strcmp(repos->shape, "deep") == 0)
+    {
+      if (i == 0)
+        {
+          path = "";
+          for (k = 0; k < DEEP_LEVELS; k++)
+            {
+              path = svn_relpath_join(path, apr_psprintf(pool, "d%d", k),
+                                      pool);
+              SVN_ERR(svn_fs_make_dir(root, path, pool));
+            }
+
+          path = svn_relpath_join(path, "file", result_pool);
+          SVN_ERR(svn_fs_make_file(root, path, pool));
+          APR_ARRAY_PUSH(repos->files, const char *) = path;
+          repos->history_path = path;
+        }
+
+      path = APR_ARRAY_IDX(repos->files, 0, const char *);
+      SVN_ERR(set_contents(root, path, content, strlen(content), pool));
+    }
+  else if (strcmp(repos->shape, "wide") == 0)
+    {
+      if (i == 0)
+        {
+          SVN_ERR(svn_fs_make_dir(root, "dir", pool));
+          repos->history_path = "dir";
+        }
+
+      for (k = 0; k < WIDE_FILES_PER_COMMIT; k++)
+        {
+          path = apr_psprintf(result_pool, "dir/file-%d-%d", i, k);
+          SVN_ERR(svn_fs_make_file(root, path, pool));
+          SVN_ERR(set_contents(root, path, content, strlen(content), pool));
+          APR_ARRAY_PUSH(repos->files, const char *) = path;
+        }
+    }
+  else if (strcmp(repos->shape, "deltas") == 0)
+    {
+      if (i == 0)
+        {
+          SVN_ERR(svn_fs_make_file(root, "file", pool));
+          APR_ARRAY_PUSH(repos->files, const char *) = "file";
+          repos->history_path = "file";
+        }
+
+      svn_stringbuf_appendcstr(repos->contents, content);
+      SVN_ERR(set_contents(root, "file", repos->contents->data,
+                           repos->contents->len, pool));
+    }
+  else
+    {
+      if (i == 0)
+        {
+          for (k = 0; k < SMALL_DIRS; k++)
+            SVN_ERR(svn_fs_make_dir(root, apr_psprintf(pool, "dir-%d", k),
+                                    pool));
+          repos->history_path = "";
+        }
+
+      path = apr_psprintf(result_pool, "dir-%d/file-%d", i % SMALL_DIRS, i);
+      SVN_ERR(svn_fs_make_file(root, path, pool));
+      SVN_ERR(set_contents(root, path, content, strlen(content), pool));
+      APR_ARRAY_PUSH(repos->files, const char *) = path;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Create REPOS with COMMITS commits and report the time taken. */
+static svn_error_t *
+bench_commit(bench_repos_t *repos,
+             int commits,
+             apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_time_t elapsed = 0;
+  int i;
+
+  SVN_ERR(svn_fs_create2(&repos->fs, repos->path, repos->fs_config,
+                         pool, pool));
+
+  for (i = 0; i < commits; i++)
+    {
+      svn_fs_txn_t *txn;
+      svn_fs_root_t *root;
+      svn_revnum_t youngest;
+      const char *conflict;
+      apr_time_t start = apr_time_now();
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_fs_youngest_rev(&youngest, repos->fs, iterpool));
+      SVN_ERR(svn_fs_begin_txn2(&txn, repos->fs, youngest, 0, iterpool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, iterpool));
+      SVN_ERR(make_changes(repos, root, i, iterpool));
+      SVN_ERR(svn_fs_commit_txn(&conflict, &youngest, txn, iterpool));
+
+      elapsed += apr_time_now() - start;
+    }
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(report(repos, "commit", commits, elapsed, pool));
+}
+
+/* Time path lookups in the HEAD of REPOS. */
+static svn_error_t *
+bench_lookup(bench_repos_t *repos,
+             apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_fs_root_t *root;
+  svn_revnum_t youngest;
+  apr_time_t start;
+  int i;
+
+  SVN_ERR(svn_fs_youngest_rev(&youngest, repos->fs, pool));
+  SVN_ERR(svn_fs_revision_root(&root, repos->fs, youngest, pool));
+
+  start = apr_time_now();
+  for (i = 0; i < LOOKUPS; i++)
+    {
+      const char *path = APR_ARRAY_IDX(repos->files,
+                                       (i * 7919) % repos->files->nelts,
+                                       const char *);
+      svn_node_kind_t kind;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_check_path(&kind, root, path, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(report(repos, "lookup", LOOKUPS,
+                                apr_time_now() - start, pool));
+}
+
+/* Time reading fulltexts from the HEAD of REPOS. */
+static svn_error_t *
+bench_read(bench_repos_t *repos,
+           apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_fs_root_t *root;
+  svn_revnum_t youngest;
+  apr_time_t start;
+  int step = repos->files->nelts / MAX_READS + 1;
+  int reads = 0;
+  int i;
+
+  SVN_ERR(svn_fs_youngest_rev(&youngest, repos->fs, pool));
+  SVN_ERR(svn_fs_revision_root(&root, repos->fs, youngest, pool));
+
+  start = apr_time_now();
+  for (i = 0; i < repos->files->nelts; i += step)
+    {
+      const char *path = APR_ARRAY_IDX(repos->files, i, const char *);
+      svn_stream_t *contents;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_file_contents(&contents, root, path, iterpool));
+      SVN_ERR(svn_stream_copy3(contents, svn_stream_empty(iterpool),
+                               NULL, NULL, iterpool));
+      reads++;
+    }
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(report(repos, "read", reads,
+                                apr_time_now() - start, pool));
+}
+
+/* Time walking the history of the main path of REPOS. */
+static svn_error_t *
+bench_log(bench_repos_t *repos,
+          apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_pool_t *lastpool = svn_pool_create(pool);
+  svn_fs_root_t *root;
+  svn_fs_history_t *history;
+  svn_revnum_t youngest;
+  apr_time_t start;
+  int entries = 0;
+
+  SVN_ERR(svn_fs_youngest_rev(&youngest, repos->fs, pool));
+  SVN_ERR(svn_fs_revision_root(&root, repos->fs, youngest, pool));
+
+  start = apr_time_now();
+  SVN_ERR(svn_fs_node_history2(&history, root, repos->history_path,
+                               lastpool, iterpool));
+  while (TRUE)
+    {
+      const char *path;
+      svn_revnum_t revision;
+      apr_pool_t *tmppool;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_history_prev2(&history, history, TRUE, iterpool,
+                                   iterpool));
+      if (!history)
+        break;
+
+      SVN_ERR(svn_fs_history_location(&path, &revision, history, iterpool));
+      entries++;
+
+      /* Keep the history object alive until the next iteration. */
+      tmppool = iterpool;
+      iterpool = lastpool;
+      lastpool = tmppool;
+    }
+  svn_pool_destroy(iterpool);
+  svn_pool_destroy(lastpool);
+
+  return svn_error_trace(report(repos, "log", entries,
+                                apr_time_now() - start, pool));
+}
+
+/* Time packing REPOS. */
+static svn_error_t *
+bench_pack(bench_repos_t *repos,
+           apr_pool_t *pool)
+{
+  apr_time_t start = apr_time_now();
+
+  SVN_ERR(svn_fs_pack(repos->path, NULL, NULL, NULL, NULL, pool));
+
+  return svn_error_trace(report(repos, "pack", 1,
+                                apr_time_now() - start, pool));
+}
+
+/* Run all benchmarks for FS_TYPE, CACHE_NAME and SHAPE at SCALE in a
+ * repository below DIR. */
+static svn_error_t *
+run_shape(const char *dir,
+          const char *fs_type,
+          const char *cache_name,
+          const shape_t *shape,
+          int scale,
+          apr_pool_t *pool)
+{
+  bench_repos_t *repos = apr_pcalloc(pool, sizeof(*repos));
+  const char *value = strcmp(cache_name, "all") == 0 ? "1" : "0";
+
+  repos->fs_type = fs_type;
+  repos->cache_name = cache_name;
+  repos->shape = shape->name;
+  repos->path = svn_dirent_join(dir,
+                                apr_psprintf(pool, "%s-%s-%s", fs_type,
+                                             cache_name, shape->name),
+                                pool);
+  repos->files = apr_array_make(pool, 16, sizeof(const char *));
+  repos->contents = svn_stringbuf_create_empty(pool);
+
+  repos->fs_config = apr_hash_make(pool);
+  svn_hash_sets(repos->fs_config, SVN_FS_CONFIG_FS_TYPE, fs_type);
+  svn_hash_sets(repos->fs_config, SVN_FS_CONFIG_FSFS_CACHE_DELTAS, value);
+  svn_hash_sets(repos->fs_config, SVN_FS_CONFIG_FSFS_CACHE_FULLTEXTS, value);
+  svn_hash_sets(repos->fs_config, SVN_FS_CONFIG_FSFS_CACHE_REVPROPS, value);
+  svn_hash_sets(repos->fs_config, SVN_FS_CONFIG_FSFS_CACHE_NODEPROPS, value);
+
+  SVN_ERR(svn_io_remove_dir2(repos->path, TRUE, NULL, NULL, pool));
+  SVN_ERR(bench_commit(repos, shape->commits * scale, pool));
+
+  /* Measure reads through a fresh FS object, like a new server request
+     would.  The global cache may still hold some of the data, though. */
+  SVN_ERR(svn_fs_open2(&repos->fs, repos->path, repos->fs_config,
+                       pool, pool));
+  SVN_ERR(bench_lookup(repos, pool));
+  SVN_ERR(bench_read(repos, pool));
+  SVN_ERR(bench_log(repos, pool));
+  SVN_ERR(bench_pack(repos, pool));
+
+  return svn_error_trace(svn_io_remove_dir2(repos->path, FALSE, NULL, NULL,
+                                            pool));
+}
+
+static svn_error_t *
+sub_main(int argc,
+         const char *argv[],
+         apr_pool_t *pool)
+{
+  static const char *default_fs_types[] = { SVN_FS_TYPE_FSFS,
+                                            SVN_FS_TYPE_FSX, NULL };
+  static const char *default_caches[] = { "all", "none", NULL };
+  apr_array_header_t *fs_types = apr_array_make(pool, 2, sizeof(char *));
+  apr_array_header_t *caches = apr_array_make(pool, 2, sizeof(char *));
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_getopt_t *os;
+  const char *dir;
+  int scale = 1;
+  int i, k, s;
+
+  SVN_ERR(svn_cmdline__getopt_init(&os, argc, argv, pool));
+  while (1)
+    {
+      const char *opt_arg;
+      char opt;
+      apr_status_t status = apr_getopt(os, "t:c:s:M:", &opt, &opt_arg);
+
+      if (APR_STATUS_IS_EOF(status))
+        break;
+      if (status != APR_SUCCESS)
+        return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL, NULL);
+
+      switch (opt)
+        {
+          case 't':
+            APR_ARRAY_PUSH(fs_types, const char *) = opt_arg;
+            break;
+
+          case 'c':
+            if (strcmp(opt_arg, "all") && strcmp(opt_arg, "none"))
+              return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                       _("Unknown cache configuration '%s'"),
+                                       opt_arg);
+            APR_ARRAY_PUSH(caches, const char *) = opt_arg;
+            break;
+
+          case 's':
+            SVN_ERR(svn_cstring_atoi(&scale, opt_arg));
+            break;
+
+          case 'M':
+            {
+              svn_cache_config_t settings = *svn_cache_config_get();
+              apr_uint64_t size;
+
+              SVN_ERR(svn_cstring_atoui64(&size, opt_arg));
+              settings.cache_size = size * 0x100000;
+              svn_cache_config_set(&settings);
+            }
+            break;
+        }
+    }
+
+  if (os->ind + 1 != argc || scale < 1)
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                            _("Usage: fs-bench [-t FS_TYPE]... "
+                              "[-c all|none]... [-s SCALE] [-M CACHE_MB] "
+                              "DIR"));
+
+  SVN_ERR(svn_dirent_get_absolute(&dir, svn_dirent_internal_style(
+                                          argv[os->ind], pool),
+                                  pool));
+  SVN_ERR(svn_io_make_dir_recursively(dir, pool));
+
+  if (fs_types->nelts == 0)
+    for (i = 0; default_fs_types[i]; i++)
+      APR_ARRAY_PUSH(fs_types, const char *) = default_fs_types[i];
+  if (caches->nelts == 0)
+    for (i = 0; default_caches[i]; i++)
+      APR_ARRAY_PUSH(caches, const char *) = default_caches[i];
+
+  SVN_ERR(svn_fs_initialize(pool));
+
+  for (i = 0; i < fs_types->nelts; i++)
+    for (k = 0; k < caches->nelts; k++)
+      for (s = 0; shapes[s].name; s++)
+        {
+          svn_pool_clear(iterpool);
+          SVN_ERR(run_shape(dir, APR_ARRAY_IDX(fs_types, i, const char *),
+                            APR_ARRAY_IDX(caches, k, const char *),
+                            &shapes[s], scale, iterpool));
+        }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+int
+main(int argc, const char *argv[])
+{
+  apr_pool_t *pool;
+  svn_error_t *err;
+
+  if (svn_cmdline_init("fs-bench", stderr) != EXIT_SUCCESS)
+    return EXIT_FAILURE;
+
+  pool = svn_pool_create(NULL);
+
+  err = sub_main(argc, argv, pool);
+  if (err)
+    return svn_cmdline_handle_exit_error(err, pool, "fs-bench: ");
+
+  svn_pool_destroy(pool);
+
+  return EXIT_SUCCESS;
+}
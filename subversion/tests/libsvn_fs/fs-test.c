@@ -44,6 +44,7 @@
 #include "private/svn_fs_private.h"
 #include "private/svn_fspath.h"
 #include "private/svn_sqlite.h"
+#include "private/svn_sorts_private.h"
 
 #include "../svn_test_fs.h"
 
@@ -6805,6 +6806,7 @@ test_modify_txn_being_written(const svn_test_opts_t *opts,
   svn_fs_root_t *txn_root;
   svn_stream_t *foo_contents;
   svn_stream_t *bar_contents;
+  const svn_fs_info_placeholder_t *fs_info;
 
   /* Bail (with success) on known-untestable scenarios */
   if (strcmp(opts->fs_type, SVN_FS_TYPE_BDB) == 0)
@@ -6815,6 +6817,13 @@ test_modify_txn_being_written(const svn_test_opts_t *opts,
   SVN_ERR(svn_test__create_fs(&fs, "test-repo-modify-txn-being-written",
                               opts, pool));
 
+  /* FSFS with logical addressing allows for concurrent writers. */
+  SVN_ERR(svn_fs_info(&fs_info, fs, pool, pool));
+  if (   strcmp(fs_info->fs_type, SVN_FS_TYPE_FSFS) == 0
+      && ((const svn_fs_fsfs_info_t *)fs_info)->log_addressing)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this FSFS repository allows concurrent writers");
+
   /* Create a TXN_ROOT referencing FS. */
   SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
   SVN_ERR(svn_fs_txn_name(&txn_name, txn, pool));
@@ -6848,6 +6857,270 @@ test_modify_txn_being_written(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_concurrent_txn_writers(const svn_test_opts_t *opts,
+                            apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t new_rev;
+  svn_stream_t *foo_contents, *bar_contents, *baz_contents;
+  svn_stringbuf_t *contents;
+  const svn_fs_info_placeholder_t *fs_info;
+  const char *foo_text = "This is the file 'foo'.\n";
+  const char *bar_text = "This is the file 'bar'.\n";
+
+  if (strcmp(opts->fs_type, SVN_FS_TYPE_FSFS) != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  SVN_ERR(svn_test__create_fs(&fs, "test-repo-concurrent-txn-writers",
+                              opts, pool));
+
+  SVN_ERR(svn_fs_info(&fs_info, fs, pool, pool));
+  if (!((const svn_fs_fsfs_info_t *)fs_info)->log_addressing)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test logical addressing only");
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "/foo", pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "/bar", pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "/baz", pool));
+
+  /* Write '/bar' while '/foo' is still being written. */
+  SVN_ERR(svn_fs_apply_text(&foo_contents, txn_root, "/foo", NULL, pool));
+  SVN_ERR(svn_fs_apply_text(&bar_contents, txn_root, "/bar", NULL, pool));
+  SVN_ERR(svn_stream_puts(foo_contents, foo_text));
+  SVN_ERR(svn_stream_puts(bar_contents, bar_text));
+  SVN_ERR(svn_stream_close(bar_contents));
+
+  /* '/baz' has the same contents as '/bar' and will share its rep. */
+  SVN_ERR(svn_fs_apply_text(&baz_contents, txn_root, "/baz", NULL, pool));
+  SVN_ERR(svn_stream_puts(baz_contents, bar_text));
+  SVN_ERR(svn_stream_close(baz_contents));
+
+  /* That rep has not been merged into the proto-rev, yet, but can be
+     read already. */
+  SVN_ERR(svn_test__get_file_contents(txn_root, "/bar", &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, bar_text);
+  SVN_ERR(svn_test__get_file_contents(txn_root, "/baz", &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, bar_text);
+  SVN_ERR(svn_stream_close(foo_contents));
+
+  /* All contents can be read back from the txn ... */
+  SVN_ERR(svn_test__get_file_contents(txn_root, "/foo", &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, foo_text);
+  SVN_ERR(svn_test__get_file_contents(txn_root, "/bar", &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, bar_text);
+  SVN_ERR(svn_test__get_file_contents(txn_root, "/baz", &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, bar_text);
+
+  /* ... and from the new revision. */
+  SVN_ERR(test_commit_txn(&new_rev, txn, NULL, pool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, new_rev, pool));
+  SVN_ERR(svn_test__get_file_contents(rev_root, "/foo", &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, foo_text);
+  SVN_ERR(svn_test__get_file_contents(rev_root, "/bar", &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, bar_text);
+  SVN_ERR(svn_test__get_file_contents(rev_root, "/baz", &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, bar_text);
+
+  SVN_ERR(svn_fs_verify(svn_fs_path(fs, pool), NULL, 0, new_rev,
+                        NULL, NULL, NULL, NULL, pool));
+
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS
+#define CONCURRENT_WRITER_THREADS 4
+#define CONCURRENT_WRITER_FILES 16
+
+struct concurrent_writer_baton_t {
+  const char *fs_path;
+  const char *txn_name;
+  int thread_no;
+  apr_pool_t *pool;
+  svn_error_t *err;
+};
+
+/* Return the path of the FILE_NO-th file written by thread THREAD_NO. */
+static const char *
+concurrent_writer_path(int thread_no, int file_no, apr_pool_t *pool)
+{
+  return apr_psprintf(pool, "/file-%d-%d", thread_no, file_no);
+}
+
+/* Return the contents of the FILE_NO-th file written by thread THREAD_NO.
+   Every other file has the same contents in all threads, so their reps
+   will be shared. */
+static const char *
+concurrent_writer_text(int thread_no, int file_no, apr_pool_t *pool)
+{
+  svn_stringbuf_t *text = svn_stringbuf_create_empty(pool);
+  const char *line = file_no % 2
+                   ? apr_psprintf(pool, "Shared file %d.\n", file_no)
+                   : apr_psprintf(pool, "File %d of thread %d.\n",
+                                  file_no, thread_no);
+  int i;
+
+  /* Make the writes take a while so that they overlap. */
+  for (i = 0; i < 1000; ++i)
+    svn_stringbuf_appendcstr(text, line);
+
+  return text->data;
+}
+
+/* Open the txn given by BATON in a file system object of our own, write
+   our files and read each one back immediately. */
+static svn_error_t *
+concurrent_writer_body(struct concurrent_writer_baton_t *baton)
+{
+  apr_pool_t *iterpool = svn_pool_create(baton->pool);
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_stringbuf_t *contents;
+  int i;
+
+  SVN_ERR(svn_fs_open2(&fs, baton->fs_path, NULL, baton->pool,
+                       baton->pool));
+  SVN_ERR(svn_fs_open_txn(&txn, fs, baton->txn_name, baton->pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, baton->pool));
+
+  for (i = 0; i < CONCURRENT_WRITER_FILES; ++i)
+    {
+      const char *path, *text;
+
+      svn_pool_clear(iterpool);
+      path = concurrent_writer_path(baton->thread_no, i, iterpool);
+      text = concurrent_writer_text(baton->thread_no, i, iterpool);
+      SVN_ERR(svn_test__set_file_contents(txn_root, path, text, iterpool));
+      SVN_ERR(svn_test__get_file_contents(txn_root, path, &contents,
+                                          iterpool));
+      SVN_TEST_STRING_ASSERT(contents->data, text);
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+static void * APR_THREAD_FUNC
+concurrent_writer_thread(apr_thread_t *tid, void *data)
+{
+  struct concurrent_writer_baton_t *baton = data;
+
+  baton->err = concurrent_writer_body(baton);
+  apr_thread_exit(tid, 0);
+  return NULL;
+}
+#endif
+
+static svn_error_t *
+test_concurrent_txn_writer_threads(const svn_test_opts_t *opts,
+                                   apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t new_rev;
+  svn_stringbuf_t *contents;
+  const svn_fs_info_placeholder_t *fs_info;
+  const char *fs_path = "test-repo-concurrent-txn-writer-threads";
+  const char *txn_name;
+  struct concurrent_writer_baton_t batons[CONCURRENT_WRITER_THREADS];
+  apr_thread_t *tids[CONCURRENT_WRITER_THREADS];
+  apr_threadattr_t *tattr;
+  apr_status_t status, child_status;
+  svn_error_t *err = SVN_NO_ERROR;
+  int i, k;
+
+  if (strcmp(opts->fs_type, SVN_FS_TYPE_FSFS) != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  SVN_ERR(svn_test__create_fs(&fs, fs_path, opts, pool));
+
+  SVN_ERR(svn_fs_info(&fs_info, fs, pool, pool));
+  if (!((const svn_fs_fsfs_info_t *)fs_info)->log_addressing)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test logical addressing only");
+
+  /* Tree changes are not thread-safe, so add all files up front. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_name(&txn_name, txn, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  for (i = 0; i < CONCURRENT_WRITER_THREADS; ++i)
+    for (k = 0; k < CONCURRENT_WRITER_FILES; ++k)
+      SVN_ERR(svn_fs_make_file(txn_root, concurrent_writer_path(i, k, pool),
+                               pool));
+
+  /* Let all threads write their file contents into the same txn. */
+  status = apr_threadattr_create(&tattr, pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create threadattr"));
+
+  for (i = 0; i < CONCURRENT_WRITER_THREADS; ++i)
+    {
+      batons[i].fs_path = fs_path;
+      batons[i].txn_name = txn_name;
+      batons[i].thread_no = i;
+      batons[i].pool = svn_pool_create(pool);
+      batons[i].err = SVN_NO_ERROR;
+    }
+
+  for (i = 0; i < CONCURRENT_WRITER_THREADS; ++i)
+    {
+      status = apr_thread_create(&tids[i], tattr, concurrent_writer_thread,
+                                 &batons[i], pool);
+      if (status)
+        break;
+    }
+
+  for (k = 0; k < i; ++k)
+    {
+      apr_status_t join_status = apr_thread_join(&child_status, tids[k]);
+      if (join_status)
+        err = svn_error_compose_create(err,
+                svn_error_wrap_apr(join_status, _("Can't join thread")));
+
+      err = svn_error_compose_create(err, batons[k].err);
+    }
+
+  if (status)
+    err = svn_error_compose_create(err,
+            svn_error_wrap_apr(status, _("Can't create thread")));
+  SVN_ERR(err);
+
+  for (i = 0; i < CONCURRENT_WRITER_THREADS; ++i)
+    svn_pool_destroy(batons[i].pool);
+
+  /* All contents made it into the new revision. */
+  SVN_ERR(test_commit_txn(&new_rev, txn, NULL, pool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, new_rev, pool));
+  for (i = 0; i < CONCURRENT_WRITER_THREADS; ++i)
+    for (k = 0; k < CONCURRENT_WRITER_FILES; ++k)
+      {
+        SVN_ERR(svn_test__get_file_contents(rev_root,
+                                            concurrent_writer_path(i, k,
+                                                                   pool),
+                                            &contents, pool));
+        SVN_TEST_STRING_ASSERT(contents->data,
+                               concurrent_writer_text(i, k, pool));
+      }
+
+  /* Duplicate item indexes would make the index checks fail. */
+  SVN_ERR(svn_fs_verify(svn_fs_path(fs, pool), NULL, 0, new_rev,
+                        NULL, NULL, NULL, NULL, pool));
+
+  return SVN_NO_ERROR;
+#else
+  return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, "no thread support");
+#endif
+}
+
 static svn_error_t *
 test_prop_and_text_rep_sharing_collision(const svn_test_opts_t *opts,
                                          apr_pool_t *pool)
@@ -7187,6 +7460,169 @@ commit_with_locked_rep_cache(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+make_files_batch(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t new_rev;
+  apr_array_header_t *paths;
+  apr_hash_t *entries;
+  svn_stringbuf_t *contents;
+  svn_fs_path_change_iterator_t *iterator;
+  svn_fs_path_change3_t *change;
+  svn_error_t *err;
+  int count = 0;
+  int i;
+
+  SVN_ERR(svn_test__create_fs(&fs, "test-repo-make-files-batch",
+                              opts, pool));
+
+  /* r1: Add files to the root and to a new directory in one batch.
+     "/b" and "/c" are siblings but not adjacent. */
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, 0, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(txn_root, "/A", pool));
+  paths = apr_array_make(pool, 5, sizeof(const char *));
+  APR_ARRAY_PUSH(paths, const char *) = "/A/x";
+  APR_ARRAY_PUSH(paths, const char *) = "/A/y";
+  APR_ARRAY_PUSH(paths, const char *) = "/b";
+  APR_ARRAY_PUSH(paths, const char *) = "/A/z";
+  APR_ARRAY_PUSH(paths, const char *) = "/c";
+  SVN_ERR(svn_fs_make_files(txn_root, paths, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "/A/y", "y", pool));
+  SVN_ERR(test_commit_txn(&new_rev, txn, NULL, pool));
+  SVN_TEST_INT_ASSERT(new_rev, 1);
+
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, new_rev, pool));
+  SVN_ERR(svn_fs_dir_entries(&entries, rev_root, "/A", pool));
+  SVN_TEST_INT_ASSERT(apr_hash_count(entries), 3);
+  SVN_ERR(svn_fs_dir_entries(&entries, rev_root, "/", pool));
+  SVN_TEST_INT_ASSERT(apr_hash_count(entries), 3);
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      svn_node_kind_t kind;
+
+      SVN_ERR(svn_fs_check_path(&kind, rev_root,
+                                APR_ARRAY_IDX(paths, i, const char *),
+                                pool));
+      SVN_TEST_ASSERT(kind == svn_node_file);
+    }
+  SVN_ERR(svn_test__get_file_contents(rev_root, "/A/x", &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "");
+  SVN_ERR(svn_test__get_file_contents(rev_root, "/A/y", &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "y");
+
+  /* Every file has been recorded as added. */
+  SVN_ERR(svn_fs_paths_changed3(&iterator, rev_root, pool, pool));
+  SVN_ERR(svn_fs_path_change_get(&change, iterator));
+  while (change)
+    {
+      if (change->node_kind == svn_node_file)
+        {
+          SVN_TEST_ASSERT(change->change_kind == svn_fs_path_change_add);
+          ++count;
+        }
+      SVN_ERR(svn_fs_path_change_get(&change, iterator));
+    }
+  SVN_TEST_INT_ASSERT(count, paths->nelts);
+
+  /* Existing files and duplicates are rejected. */
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, new_rev, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  apr_array_clear(paths);
+  APR_ARRAY_PUSH(paths, const char *) = "/A/new";
+  APR_ARRAY_PUSH(paths, const char *) = "/A/x";
+  err = svn_fs_make_files(txn_root, paths, pool);
+  SVN_TEST_ASSERT_ERROR(err, SVN_ERR_FS_ALREADY_EXISTS);
+
+  apr_array_clear(paths);
+  APR_ARRAY_PUSH(paths, const char *) = "/d";
+  APR_ARRAY_PUSH(paths, const char *) = "/d";
+  err = svn_fs_make_files(txn_root, paths, pool);
+  SVN_TEST_ASSERT_ERROR(err, SVN_ERR_FS_ALREADY_EXISTS);
+  SVN_ERR(svn_fs_abort_txn(txn, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Compare svn_fs_dir_entries_sorted() on PATH in ROOT with the sorted
+   contents of svn_fs_dir_entries().  Expect EXPECTED_COUNT entries. */
+static svn_error_t *
+verify_sorted_entries(svn_fs_root_t *root,
+                      const char *path,
+                      int expected_count,
+                      apr_pool_t *pool)
+{
+  apr_array_header_t *sorted;
+  apr_array_header_t *expected;
+  apr_hash_t *entries;
+  int i;
+
+  SVN_ERR(svn_fs_dir_entries_sorted(&sorted, root, path, pool, pool));
+  SVN_ERR(svn_fs_dir_entries(&entries, root, path, pool));
+  expected = svn_sort__hash(entries, svn_sort_compare_items_lexically, pool);
+
+  SVN_TEST_INT_ASSERT(sorted->nelts, expected_count);
+  SVN_TEST_INT_ASSERT(sorted->nelts, expected->nelts);
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      const svn_fs_dirent_t *entry
+        = APR_ARRAY_IDX(sorted, i, const svn_fs_dirent_t *);
+      const svn_fs_dirent_t *expected_entry
+        = APR_ARRAY_IDX(expected, i, svn_sort__item_t).value;
+
+      SVN_TEST_STRING_ASSERT(entry->name, expected_entry->name);
+      SVN_TEST_ASSERT(entry->kind == expected_entry->kind);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+dir_entries_sorted(const svn_test_opts_t *opts,
+                   apr_pool_t *pool)
+{
+  static const char * const names[] = {
+    "b", "a-b", "B", "ab", "a", "a.b", "b0", "Z"
+  };
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t new_rev;
+  int i;
+
+  SVN_ERR(svn_test__create_fs(&fs, "test-repo-dir-entries-sorted",
+                              opts, pool));
+
+  /* Add the entries in an order that is neither sorted nor reversed. */
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, 0, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(txn_root, "/A", pool));
+  for (i = 0; i < (int)(sizeof(names) / sizeof(names[0])); ++i)
+    {
+      const char *path = apr_pstrcat(pool, "/A/", names[i], SVN_VA_NULL);
+
+      if (i % 2)
+        SVN_ERR(svn_fs_make_dir(txn_root, path, pool));
+      else
+        SVN_ERR(svn_fs_make_file(txn_root, path, pool));
+    }
+
+  /* Mutable directories are sorted as well. */
+  SVN_ERR(verify_sorted_entries(txn_root, "/A", 8, pool));
+  SVN_ERR(test_commit_txn(&new_rev, txn, NULL, pool));
+
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, new_rev, pool));
+  SVN_ERR(verify_sorted_entries(rev_root, "/A", 8, pool));
+  SVN_ERR(verify_sorted_entries(rev_root, "/A/a-b", 0, pool));
+  SVN_ERR(verify_sorted_entries(rev_root, "/", 1, pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* ------------------------------------------------------------------------ */
 
 /* The test table.  */
@@ -7313,6 +7749,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test pool lifetime dependencies with txn roots"),
     SVN_TEST_OPTS_PASS(test_modify_txn_being_written,
                        "test modify txn being written"),
+    SVN_TEST_OPTS_PASS(test_concurrent_txn_writers,
+                       "test concurrent writers within a txn"),
+    SVN_TEST_OPTS_PASS(test_concurrent_txn_writer_threads,
+                       "test concurrent writer threads within a txn"),
     SVN_TEST_OPTS_PASS(test_prop_and_text_rep_sharing_collision,
                        "test property and text rep-sharing collision"),
     SVN_TEST_OPTS_PASS(test_internal_txn_props,
@@ -7325,6 +7765,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test reading a large changed paths list"),
     SVN_TEST_OPTS_PASS(commit_with_locked_rep_cache,
                        "test commit with locked rep-cache"),
+    SVN_TEST_OPTS_PASS(make_files_batch,
+                       "test svn_fs_make_files"),
+    SVN_TEST_OPTS_PASS(dir_entries_sorted,
+                       "test svn_fs_dir_entries_sorted"),
     SVN_TEST_NULL
   };
 
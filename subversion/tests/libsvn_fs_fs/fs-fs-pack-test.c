@@ -26,16 +26,26 @@
 
 #include "../svn_test.h"
 #include "../../libsvn_fs/fs-loader.h"
+#include "../../libsvn_fs_fs/cached_data.h"
 #include "../../libsvn_fs_fs/fs.h"
 #include "../../libsvn_fs_fs/fs_fs.h"
+#include "../../libsvn_fs_fs/id.h"
+#include "../../libsvn_fs_fs/index.h"
+#include "../../libsvn_fs_fs/lock-index.h"
 #include "../../libsvn_fs_fs/low_level.h"
+#include "../../libsvn_fs_fs/mergeinfo-index.h"
 #include "../../libsvn_fs_fs/pack.h"
+#include "../../libsvn_fs_fs/rev_file.h"
 #include "../../libsvn_fs_fs/util.h"
 
 #include "svn_hash.h"
 #include "svn_pools.h"
 #include "svn_props.h"
+#include "svn_sorts.h"
+#include "svn_mergeinfo.h"
 #include "svn_fs.h"
+#include "private/svn_fs_fs_private.h"
+#include "private/svn_fs_private.h"
 #include "private/svn_string_private.h"
 
 #include "../svn_test_fs.h"
@@ -1269,6 +1279,189 @@ id_parser_test(const svn_test_opts_t *opts,
 
 /* ------------------------------------------------------------------------ */
 
+/* A node-revision using all header fields, followed by an unknown header
+ * and data beyond the end of the header block. */
+static const char noderev_text[] =
+  "id: 2.0.r1/4\n"
+  "type: file\n"
+  "pred: 2.0.r0/3\n"
+  "count: 1\n"
+  "text: 1 3 25 13 0123456789abcdef0123456789abcdef "
+  "0123456789abcdef0123456789abcdef01234567 0-0/_4\n"
+  "props: 1 2 20 0 fedcba9876543210fedcba9876543210\n"
+  "cpath: /A/file\n"
+  "copyfrom: 0 /iota\n"
+  "copyroot: 1 /A/file\n"
+  "minfo-cnt: 3\n"
+  "minfo-here: y\n"
+  "x-unknown: ignored\n"
+  "\n"
+  "id: bogus\n";
+
+/* A changed paths list with and without copy-from info. */
+static const char changes_text[] =
+  "2.0.r1/4 modify-file true false false /A/file\n"
+  "\n"
+  "3.0.r1/5 add-dir false true true /B\n"
+  "0 /A\n"
+  "\n";
+
+/* Verify that the representations LHS and RHS have the same contents. */
+static svn_error_t *
+compare_reps(representation_t *lhs,
+             representation_t *rhs)
+{
+  SVN_TEST_ASSERT((lhs == NULL) == (rhs == NULL));
+  if (lhs == NULL)
+    return SVN_NO_ERROR;
+
+  SVN_TEST_ASSERT(lhs->revision == rhs->revision);
+  SVN_TEST_ASSERT(lhs->item_index == rhs->item_index);
+  SVN_TEST_ASSERT(lhs->size == rhs->size);
+  SVN_TEST_ASSERT(lhs->expanded_size == rhs->expanded_size);
+  SVN_TEST_ASSERT(lhs->has_sha1 == rhs->has_sha1);
+  SVN_TEST_ASSERT(!memcmp(lhs->md5_digest, rhs->md5_digest,
+                          sizeof(lhs->md5_digest)));
+  SVN_TEST_ASSERT(!memcmp(lhs->sha1_digest, rhs->sha1_digest,
+                          sizeof(lhs->sha1_digest)));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+noderev_parser_test(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  enum { REPEATS = 10000 };
+
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  node_revision_t *read, *parsed;
+  apr_array_header_t *read_changes, *parsed_changes;
+  apr_time_t start, read_duration, parse_duration;
+  int i;
+
+  /* Both parsers must agree. */
+  SVN_ERR(svn_fs_fs__read_noderev(&read,
+                                  svn_stream_from_string(
+                                    svn_string_create(noderev_text, pool),
+                                    pool),
+                                  pool, pool));
+  SVN_ERR(svn_fs_fs__parse_noderev(&parsed,
+                                   svn_stringbuf_create(noderev_text, pool),
+                                   pool, pool));
+
+  SVN_TEST_ASSERT(svn_fs_fs__id_eq(read->id, parsed->id));
+  SVN_TEST_ASSERT(svn_fs_fs__id_eq(read->predecessor_id,
+                                   parsed->predecessor_id));
+  SVN_TEST_ASSERT(read->kind == svn_node_file);
+  SVN_TEST_ASSERT(parsed->kind == svn_node_file);
+  SVN_TEST_ASSERT(read->predecessor_count == 1);
+  SVN_TEST_ASSERT(parsed->predecessor_count == 1);
+  SVN_ERR(compare_reps(read->data_rep, parsed->data_rep));
+  SVN_ERR(compare_reps(read->prop_rep, parsed->prop_rep));
+  SVN_TEST_ASSERT(parsed->data_rep->has_sha1);
+  SVN_TEST_ASSERT(!parsed->prop_rep->has_sha1);
+  SVN_TEST_STRING_ASSERT(parsed->created_path, "/A/file");
+  SVN_TEST_STRING_ASSERT(read->created_path, parsed->created_path);
+  SVN_TEST_STRING_ASSERT(parsed->copyfrom_path, "/iota");
+  SVN_TEST_STRING_ASSERT(read->copyfrom_path, parsed->copyfrom_path);
+  SVN_TEST_ASSERT(parsed->copyfrom_rev == 0);
+  SVN_TEST_ASSERT(read->copyfrom_rev == 0);
+  SVN_TEST_STRING_ASSERT(read->copyroot_path, parsed->copyroot_path);
+  SVN_TEST_ASSERT(parsed->copyroot_rev == 1);
+  SVN_TEST_ASSERT(read->copyroot_rev == 1);
+  SVN_TEST_ASSERT(parsed->mergeinfo_count == 3);
+  SVN_TEST_ASSERT(read->mergeinfo_count == 3);
+  SVN_TEST_ASSERT(parsed->has_mergeinfo && read->has_mergeinfo);
+  SVN_TEST_ASSERT(!parsed->is_fresh_txn_root && !read->is_fresh_txn_root);
+
+  /* Malformed headers must be detected. */
+  SVN_TEST_ASSERT_ERROR(svn_fs_fs__parse_noderev(&parsed,
+                          svn_stringbuf_create("id 2.0.r1/4\n\n", pool),
+                          pool, pool),
+                        SVN_ERR_FS_CORRUPT);
+  SVN_TEST_ASSERT_ERROR(svn_fs_fs__parse_noderev(&parsed,
+                          svn_stringbuf_create("type: file\n\n", pool),
+                          pool, pool),
+                        SVN_ERR_FS_CORRUPT);
+
+  /* Same for the changed paths lists. */
+  SVN_ERR(svn_fs_fs__read_changes(&read_changes,
+                                  svn_stream_from_string(
+                                    svn_string_create(changes_text, pool),
+                                    pool),
+                                  100, pool, pool));
+  SVN_ERR(svn_fs_fs__parse_changes(&parsed_changes,
+                                   svn_stringbuf_create(changes_text, pool),
+                                   100, pool));
+
+  SVN_TEST_ASSERT(read_changes->nelts == 2);
+  SVN_TEST_ASSERT(parsed_changes->nelts == 2);
+  for (i = 0; i < parsed_changes->nelts; ++i)
+    {
+      change_t *lhs = APR_ARRAY_IDX(read_changes, i, change_t *);
+      change_t *rhs = APR_ARRAY_IDX(parsed_changes, i, change_t *);
+
+      SVN_TEST_STRING_ASSERT(lhs->path.data, rhs->path.data);
+      SVN_TEST_ASSERT(lhs->path.len == rhs->path.len);
+      SVN_TEST_ASSERT(svn_fs_fs__id_eq(lhs->info.node_rev_id,
+                                       rhs->info.node_rev_id));
+      SVN_TEST_ASSERT(lhs->info.change_kind == rhs->info.change_kind);
+      SVN_TEST_ASSERT(lhs->info.node_kind == rhs->info.node_kind);
+      SVN_TEST_ASSERT(lhs->info.text_mod == rhs->info.text_mod);
+      SVN_TEST_ASSERT(lhs->info.prop_mod == rhs->info.prop_mod);
+      SVN_TEST_ASSERT(lhs->info.mergeinfo_mod == rhs->info.mergeinfo_mod);
+      SVN_TEST_ASSERT(lhs->info.copyfrom_rev == rhs->info.copyfrom_rev);
+      SVN_TEST_STRING_ASSERT(lhs->info.copyfrom_path,
+                             rhs->info.copyfrom_path);
+    }
+
+  SVN_TEST_STRING_ASSERT(APR_ARRAY_IDX(parsed_changes, 1, change_t *)
+                           ->info.copyfrom_path,
+                         "/A");
+
+  /* Limits must be respected. */
+  SVN_ERR(svn_fs_fs__parse_changes(&parsed_changes,
+                                   svn_stringbuf_create(changes_text, pool),
+                                   1, pool));
+  SVN_TEST_ASSERT(parsed_changes->nelts == 1);
+
+  /* Compare the speed of both noderev parsers. */
+  start = apr_time_now();
+  for (i = 0; i < REPEATS; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_fs__read_noderev(&read,
+                                      svn_stream_from_string(
+                                        svn_string_create(noderev_text,
+                                                          iterpool),
+                                        iterpool),
+                                      iterpool, iterpool));
+    }
+  read_duration = apr_time_now() - start;
+
+  start = apr_time_now();
+  for (i = 0; i < REPEATS; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_fs__parse_noderev(&parsed,
+                                       svn_stringbuf_create(noderev_text,
+                                                            iterpool),
+                                       iterpool, iterpool));
+    }
+  parse_duration = apr_time_now() - start;
+  svn_pool_destroy(iterpool);
+
+  if (opts->verbose)
+    printf("noderev parsing: %.2f us from stream, %.2f us in place\n",
+           (double)read_duration / REPEATS,
+           (double)parse_duration / REPEATS);
+
+  return SVN_NO_ERROR;
+}
+
+/* ------------------------------------------------------------------------ */
+
 #define REPO_NAME "test-repo-plain_0_length"
 
 static svn_error_t *
@@ -1562,6 +1755,177 @@ rep_sharing_effectiveness(const svn_test_opts_t *opts,
 
 /* ------------------------------------------------------------------------ */
 
+#define REPO_NAME "test-repo-rep_cache_filter"
+#define FILE_COUNT 1100
+
+static svn_error_t *
+rep_cache_filter(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  int i, count;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+
+  ffd = fs->fsap_data;
+  if (ffd->format < SVN_FS_FS__MIN_REP_SHARING_FORMAT)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  ffd->rep_sharing_allowed = TRUE;
+
+  /* Revision 1: enough new contents to make rep-cache lookups switch
+                 to the filter. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  for (i = 0; i < FILE_COUNT; ++i)
+    {
+      const char *path;
+
+      svn_pool_clear(iterpool);
+      path = apr_psprintf(iterpool, "f%d", i);
+      SVN_ERR(svn_fs_make_file(root, path, iterpool));
+      SVN_ERR(svn_test__set_file_contents(root, path,
+                                          apr_psprintf(iterpool,
+                                                       "file %d\n", i),
+                                          iterpool));
+    }
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  SVN_ERR(count_representations(&count, fs, rev, pool));
+  SVN_TEST_INT_ASSERT(count, FILE_COUNT + 1);
+
+  /* Revision 2: change files to contents that we committed in r1 and
+                 add one new content.  The filter must have picked up
+                 the keys that we added to the rep-cache. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  for (i = 0; i < 10; ++i)
+    {
+      const char *path;
+
+      svn_pool_clear(iterpool);
+      path = apr_psprintf(iterpool, "f%d", i);
+      SVN_ERR(svn_test__set_file_contents(root, path,
+                                          apr_psprintf(iterpool,
+                                                       "file %d\n",
+                                                       FILE_COUNT - 1 - i),
+                                          iterpool));
+    }
+  SVN_ERR(svn_test__set_file_contents(root, "f10", "new\n", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Only the root directory and the new content. */
+  SVN_ERR(count_representations(&count, fs, rev, pool));
+  SVN_TEST_INT_ASSERT(count, 2);
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#undef FILE_COUNT
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-large_directory"
+#define ENTRY_COUNT 3000
+
+static svn_error_t *
+large_directory(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  apr_hash_t *fs_config;
+  apr_hash_t *entries;
+  svn_node_kind_t kind;
+  int i;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  /* r1: a directory that is larger than a single chunk. */
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(root, "big", pool));
+  for (i = 0; i < ENTRY_COUNT; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_make_file(root, apr_psprintf(iterpool, "big/f%05d", i),
+                               iterpool));
+    }
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* r2: modify it a little. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_delete(root, "big/f00000", pool));
+  SVN_ERR(svn_fs_make_file(root, "big/zzz", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Read it through a new instance with empty caches - twice, such that
+   * the second run will use whatever got cached in the first run. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+
+  for (i = 0; i < 2; ++i)
+    {
+      int k;
+
+      SVN_ERR(svn_fs_revision_root(&root, fs, 1, pool));
+      SVN_ERR(svn_fs_dir_entries(&entries, root, "big", pool));
+      SVN_TEST_INT_ASSERT(apr_hash_count(entries), ENTRY_COUNT);
+
+      SVN_ERR(svn_fs_revision_root(&root, fs, 2, pool));
+      SVN_ERR(svn_fs_check_path(&kind, root, "big/f00000", pool));
+      SVN_TEST_ASSERT(kind == svn_node_none);
+      SVN_ERR(svn_fs_check_path(&kind, root, "big/a", pool));
+      SVN_TEST_ASSERT(kind == svn_node_none);
+      SVN_ERR(svn_fs_check_path(&kind, root, "big/f01024x", pool));
+      SVN_TEST_ASSERT(kind == svn_node_none);
+      SVN_ERR(svn_fs_check_path(&kind, root, "big/zzz", pool));
+      SVN_TEST_ASSERT(kind == svn_node_file);
+
+      for (k = 1; k < ENTRY_COUNT; k += 97)
+        {
+          svn_pool_clear(iterpool);
+          SVN_ERR(svn_fs_check_path(&kind, root,
+                                    apr_psprintf(iterpool, "big/f%05d", k),
+                                    iterpool));
+          SVN_TEST_ASSERT(kind == svn_node_file);
+        }
+
+      SVN_ERR(svn_fs_dir_entries(&entries, root, "big", pool));
+      SVN_TEST_INT_ASSERT(apr_hash_count(entries), ENTRY_COUNT);
+      SVN_TEST_ASSERT(svn_hash_gets(entries, "zzz"));
+      SVN_TEST_ASSERT(!svn_hash_gets(entries, "f00000"));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#undef ENTRY_COUNT
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
 #define REPO_NAME "test-repo-delta_chain_with_plain"
 
 static svn_error_t *
@@ -1795,7 +2159,7 @@ pack_with_limited_memory(const svn_test_opts_t *opts,
 
       /* Pack it with a narrow memory budget. */
       SVN_ERR(svn_fs_open2(&fs, dir, NULL, iterpool, iterpool));
-      SVN_ERR(svn_fs_fs__pack(fs, max_mem, NULL, NULL, NULL, NULL,
+      SVN_ERR(svn_fs_fs__pack(fs, max_mem, 1, NULL, NULL, NULL, NULL,
                               iterpool));
 
       /* To be sure: Verify that we didn't break the repo. */
@@ -1887,6 +2251,1443 @@ large_delta_against_plain(const svn_test_opts_t *opts,
 
 #undef REPO_NAME
 
+/* ------------------------------------------------------------------------ */
+#define REPO_NAME "test-repo-pack-concurrently"
+#define SHARD_SIZE 3
+#define MAX_REV 31
+static svn_error_t *
+pack_concurrently(const svn_test_opts_t *opts,
+                  apr_pool_t *pool)
+{
+  struct pack_notify_baton pnb;
+  svn_fs_t *fs;
+  svn_revnum_t i;
+  apr_pool_t *iterpool;
+
+  SVN_ERR(create_non_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                       pool));
+
+  /* Notifications must arrive in shard order, no matter which thread
+     packed the respective shard. */
+  pnb.expected_shard = 0;
+  pnb.expected_action = svn_fs_pack_notify_start;
+  SVN_ERR(svn_fs_pack2(REPO_NAME, 4, NULL, pack_notify, &pnb, NULL, NULL, pool));
+  SVN_TEST_ASSERT(pnb.expected_shard == (MAX_REV + 1) / SHARD_SIZE);
+  SVN_TEST_ASSERT(pnb.expected_action == svn_fs_pack_notify_start);
+
+  /* All contents must still be there. */
+  SVN_ERR(svn_fs_verify(REPO_NAME, NULL, 0, MAX_REV, NULL, NULL, NULL, NULL,
+                        pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+
+  iterpool = svn_pool_create(pool);
+  for (i = 2; i <= MAX_REV; i++)
+    {
+      svn_fs_root_t *rev_root;
+      svn_stream_t *rstream;
+      svn_stringbuf_t *rstring;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_fs_revision_root(&rev_root, fs, i, iterpool));
+      SVN_ERR(svn_fs_file_contents(&rstream, rev_root, "iota", iterpool));
+      SVN_ERR(svn_test__stream_to_string(&rstring, rstream, iterpool));
+      SVN_TEST_STRING_ASSERT(rstring->data, get_rev_contents(i, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
+/* ------------------------------------------------------------------------ */
+#define REPO_NAME "test-repo-read-ahead"
+#define SHARD_SIZE 7
+#define MAX_REV 53
+static svn_error_t *
+read_ahead(const svn_test_opts_t *opts,
+           apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  apr_hash_t *fs_config;
+  svn_revnum_t i;
+  apr_pool_t *iterpool;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if ((strcmp(opts->fs_type, "fsfs") != 0)
+      || (opts->server_minor_version && (opts->server_minor_version < 9)))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.9 SVN doesn't support block read");
+
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                   pool));
+
+  /* Use disjoint caches such that we actually read from disk. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                           svn_uuid_generate(pool));
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_BLOCK_READ, "1");
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_READ_AHEAD, "1");
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+
+  /* Data read by the background thread must be the same. */
+  iterpool = svn_pool_create(pool);
+  for (i = 2; i <= MAX_REV; i++)
+    {
+      svn_fs_root_t *rev_root;
+      svn_stream_t *rstream;
+      svn_stringbuf_t *rstring;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_fs_revision_root(&rev_root, fs, i, iterpool));
+      SVN_ERR(svn_fs_file_contents(&rstream, rev_root, "iota", iterpool));
+      SVN_ERR(svn_test__stream_to_string(&rstring, rstream, iterpool));
+      SVN_TEST_STRING_ASSERT(rstring->data, get_rev_contents(i, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
+/* ------------------------------------------------------------------------ */
+#define REPO_NAME "test-repo-shared-file-handles"
+#define SHARD_SIZE 4
+#define MAX_REV 10
+static svn_error_t *
+shared_file_handles(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_fs_t *fs1, *fs2;
+  apr_hash_t *fs_config;
+  svn_revnum_t i;
+  apr_pool_t *iterpool;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if ((strcmp(opts->fs_type, "fsfs") != 0)
+      || (opts->server_minor_version && (opts->server_minor_version < 9)))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.9 SVN doesn't support log addressing");
+
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                   pool));
+
+  /* Use disjoint caches such that both instances actually read the
+   * pack files, alternating between them. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                           svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(&fs1, REPO_NAME, fs_config, pool, pool));
+
+  fs_config = apr_hash_copy(pool, fs_config);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                           svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(&fs2, REPO_NAME, fs_config, pool, pool));
+
+  iterpool = svn_pool_create(pool);
+  for (i = 2; i <= MAX_REV; i++)
+    {
+      svn_fs_root_t *rev_root;
+      svn_stream_t *rstream;
+      svn_stringbuf_t *rstring;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_fs_revision_root(&rev_root, i % 2 ? fs1 : fs2, i,
+                                   iterpool));
+      SVN_ERR(svn_fs_file_contents(&rstream, rev_root, "iota", iterpool));
+      SVN_ERR(svn_test__stream_to_string(&rstring, rstream, iterpool));
+      SVN_TEST_STRING_ASSERT(rstring->data, get_rev_contents(i, iterpool));
+
+      /* Read it again through the other instance. */
+      SVN_ERR(svn_fs_revision_root(&rev_root, i % 2 ? fs2 : fs1, i,
+                                   iterpool));
+      SVN_ERR(svn_fs_file_contents(&rstream, rev_root, "iota", iterpool));
+      SVN_ERR(svn_test__stream_to_string(&rstring, rstream, iterpool));
+      SVN_TEST_STRING_ASSERT(rstring->data, get_rev_contents(i, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-group-commit"
+#define SHARD_SIZE 2
+#define MAX_REV 5
+static svn_error_t *
+group_commit(const svn_test_opts_t *opts,
+             apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  apr_hash_t *fs_config;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev, youngest;
+  svn_stringbuf_t *current;
+  svn_string_t *date;
+  apr_pool_t *iterpool;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_SHARD_SIZE,
+                apr_itoa(pool, SHARD_SIZE));
+  SVN_ERR(svn_test__create_fs2(&fs, REPO_NAME, opts, fs_config, pool));
+
+  ffd = fs->fsap_data;
+  ffd->group_commit = TRUE;
+
+  /* Commit enough revisions to create new shards along the way. */
+  iterpool = svn_pool_create(pool);
+  for (rev = 1; rev <= MAX_REV; ++rev)
+    {
+      svn_revnum_t new_rev;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, rev - 1, iterpool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, iterpool));
+      if (rev == 1)
+        SVN_ERR(svn_fs_make_file(root, "iota", iterpool));
+      SVN_ERR(svn_test__set_file_contents(root, "iota",
+                                          get_rev_contents(rev, iterpool),
+                                          iterpool));
+      SVN_ERR(svn_fs_commit_txn(NULL, &new_rev, txn, iterpool));
+      SVN_TEST_INT_ASSERT(new_rev, rev);
+
+      SVN_ERR(svn_stringbuf_from_file2(&current,
+                                       svn_fs_fs__path_current(fs, iterpool),
+                                       iterpool));
+      SVN_TEST_INT_ASSERT(atoi(current->data), rev);
+    }
+  svn_pool_destroy(iterpool);
+
+  /* A new instance must see the same, complete data. */
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_youngest_rev(&youngest, fs, pool));
+  SVN_TEST_INT_ASSERT(youngest, MAX_REV);
+  SVN_ERR(svn_fs_verify(REPO_NAME, NULL, 0, MAX_REV, NULL, NULL, NULL, NULL,
+                        pool));
+
+  for (rev = 1; rev <= MAX_REV; ++rev)
+    {
+      svn_stream_t *rstream;
+      svn_stringbuf_t *rstring;
+
+      SVN_ERR(svn_fs_revision_prop2(&date, fs, rev, SVN_PROP_REVISION_DATE,
+                                    TRUE, pool, pool));
+      SVN_TEST_ASSERT(date != NULL);
+
+      SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+      SVN_ERR(svn_fs_file_contents(&rstream, root, "iota", pool));
+      SVN_ERR(svn_test__stream_to_string(&rstring, rstream, pool));
+      SVN_TEST_STRING_ASSERT(rstring->data, get_rev_contents(rev, pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-deep-path-lookup"
+static svn_error_t *
+deep_path_lookup(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  svn_revnum_t created_rev;
+  svn_node_kind_t kind;
+  int i;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  /* r1: a deep path with a few siblings at the bottom. */
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(root, "a", pool));
+  SVN_ERR(svn_fs_make_dir(root, "a/b", pool));
+  SVN_ERR(svn_fs_make_dir(root, "a/b/c", pool));
+  SVN_ERR(svn_fs_make_dir(root, "a/b/c/d", pool));
+  for (i = 0; i < 10; ++i)
+    SVN_ERR(svn_fs_make_file(root, apr_psprintf(pool, "a/b/c/d/f%d", i),
+                             pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* r2: replace one of the intermediate directories by a file. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_delete(root, "a/b/c", pool));
+  SVN_ERR(svn_fs_make_file(root, "a/b/c", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Alternate between revisions and siblings, such that lookups hit
+   * cached parent directories of the "wrong" revision. */
+  for (i = 0; i < 10; ++i)
+    {
+      const char *path;
+
+      svn_pool_clear(iterpool);
+      path = apr_psprintf(iterpool, "/a/b/c/d/f%d", i);
+
+      SVN_ERR(svn_fs_revision_root(&root, fs, 1, iterpool));
+      SVN_ERR(svn_fs_check_path(&kind, root, path, iterpool));
+      SVN_TEST_ASSERT(kind == svn_node_file);
+      SVN_ERR(svn_fs_check_path(&kind, root, "/a/b/c/d/missing", iterpool));
+      SVN_TEST_ASSERT(kind == svn_node_none);
+
+      SVN_ERR(svn_fs_revision_root(&root, fs, 2, iterpool));
+      SVN_ERR(svn_fs_check_path(&kind, root, "/a/b/c", iterpool));
+      SVN_TEST_ASSERT(kind == svn_node_file);
+      SVN_ERR(svn_fs_check_path(&kind, root, path, iterpool));
+      SVN_TEST_ASSERT(kind == svn_node_none);
+
+      /* Walking through a file must fail. */
+      SVN_TEST_ASSERT_ERROR(svn_fs_node_created_rev(&created_rev, root, path,
+                                                    iterpool),
+                            SVN_ERR_FS_NOT_DIRECTORY);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-changed-paths-index"
+#define SHARD_SIZE 2
+
+/* Verify that the changed revisions for PATH between START and END in FS
+ * are EXPECTED, a string of space separated revision numbers, or that the
+ * index cannot tell if EXPECTED is NULL.  Use POOL for allocations. */
+static svn_error_t *
+check_changed_revs(svn_fs_t *fs,
+                   const char *path,
+                   svn_revnum_t start,
+                   svn_revnum_t end,
+                   const char *expected,
+                   apr_pool_t *pool)
+{
+  apr_array_header_t *revs;
+  svn_stringbuf_t *actual;
+  int i;
+
+  SVN_ERR(svn_fs__get_changed_revisions(&revs, fs, path, start, end,
+                                        pool, pool));
+  if (expected == NULL)
+    {
+      SVN_TEST_ASSERT(revs == NULL);
+      return SVN_NO_ERROR;
+    }
+
+  SVN_TEST_ASSERT(revs != NULL);
+  actual = svn_stringbuf_create_empty(pool);
+  for (i = 0; i < revs->nelts; ++i)
+    svn_stringbuf_appendcstr(actual,
+                             apr_psprintf(pool, i ? " %ld" : "%ld",
+                                          APR_ARRAY_IDX(revs, i,
+                                                        svn_revnum_t)));
+
+  SVN_TEST_STRING_ASSERT(actual->data, expected);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+changed_paths_index(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  apr_hash_t *fs_config;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_SHARD_SIZE,
+                apr_itoa(pool, SHARD_SIZE));
+  SVN_ERR(svn_test__create_fs2(&fs, REPO_NAME, opts, fs_config, pool));
+
+  /* Enable the index for all FS instances, including the packer's. */
+  SVN_ERR(svn_io_file_create(svn_dirent_join(REPO_NAME, PATH_CONFIG,
+                                             pool),
+                             "[" CONFIG_SECTION_CHANGED_PATHS "]\n"
+                             CONFIG_OPTION_ENABLE_CHANGED_PATHS_INDEX
+                             " = true\n",
+                             pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+
+  /* r1: A, B */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(root, "A", pool));
+  SVN_ERR(svn_fs_make_dir(root, "B", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* r2: A/f */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_file(root, "A/f", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* r3: B/g */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_file(root, "B/g", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* r4: modify A/f */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(root, "A/f", "modified\n", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* r5: C */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(root, "C", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_INT_ASSERT(rev, 5);
+
+  /* All changes to the path, its parents and its sub-tree count. */
+  SVN_ERR(check_changed_revs(fs, "/A", 0, 5, "1 2 4", pool));
+  SVN_ERR(check_changed_revs(fs, "/A/f", 0, 5, "1 2 4", pool));
+  SVN_ERR(check_changed_revs(fs, "/B/g", 0, 5, "1 3", pool));
+  SVN_ERR(check_changed_revs(fs, "/C", 0, 4, "", pool));
+  SVN_ERR(check_changed_revs(fs, "/C", 3, 5, "5", pool));
+  SVN_ERR(check_changed_revs(fs, "/", 2, 3, "2 3", pool));
+
+  /* Queries touching a shard without index cannot be answered. */
+  SVN_ERR(svn_io_remove_file2(svn_fs_fs__path_changed_paths_index(fs, 2,
+                                                                  pool),
+                              FALSE, pool));
+  SVN_ERR(check_changed_revs(fs, "/A", 0, 5, NULL, pool));
+  SVN_ERR(check_changed_revs(fs, "/A", 4, 5, "4", pool));
+
+  /* Packing restores the missing index. */
+  SVN_ERR(svn_fs_pack(REPO_NAME, NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(check_changed_revs(fs, "/A", 0, 5, "1 2 4", pool));
+  SVN_ERR(check_changed_revs(fs, "/B", 2, 3, "3", pool));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef SHARD_SIZE
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-mergeinfo-index"
+
+/* Return the mergeinfo of PATH in CATALOG as a string allocated in POOL. */
+static const char *
+catalog_entry(svn_mergeinfo_catalog_t catalog,
+              const char *path,
+              apr_pool_t *pool)
+{
+  svn_mergeinfo_t mergeinfo = svn_hash_gets(catalog, path);
+  svn_string_t *mergeinfo_string;
+
+  if (!mergeinfo)
+    return NULL;
+
+  svn_error_clear(svn_mergeinfo_to_string(&mergeinfo_string, mergeinfo,
+                                          pool));
+  return mergeinfo_string->data;
+}
+
+static svn_error_t *
+mergeinfo_index(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root, *rev_root;
+  svn_revnum_t rev;
+  apr_array_header_t *paths;
+  svn_mergeinfo_catalog_t catalog;
+  apr_hash_t *indexed;
+  const svn_fs_id_t *id;
+  int i;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  if (! svn_fs_fs__fs_supports_mergeinfo(fs))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(svn_io_file_create(svn_dirent_join(REPO_NAME, PATH_CONFIG, pool),
+                             "[" CONFIG_SECTION_MERGEINFO_INDEX "]\n"
+                             CONFIG_OPTION_ENABLE_MERGEINFO_INDEX
+                             " = true\n",
+                             pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+
+  /* r1: /A/B with mergeinfo */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(root, "A", pool));
+  SVN_ERR(svn_fs_make_dir(root, "A/B", pool));
+  SVN_ERR(svn_fs_change_node_prop(root, "A/B", SVN_PROP_MERGEINFO,
+                                  svn_string_create("/X:1", pool), pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* r2: copy /A to /C */
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, rev, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_copy(rev_root, "A", root, "C", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* The first query crawls the tree and populates the index, the second
+   * one gets answered from it.  Both must yield the same result. */
+  paths = apr_array_make(pool, 1, sizeof(const char *));
+  APR_ARRAY_PUSH(paths, const char *) = "/";
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  for (i = 0; i < 2; ++i)
+    {
+      SVN_ERR(svn_fs_get_mergeinfo2(&catalog, root, paths,
+                                    svn_mergeinfo_inherited, TRUE, TRUE,
+                                    pool, pool));
+      SVN_TEST_INT_ASSERT(apr_hash_count(catalog), 2);
+      SVN_TEST_STRING_ASSERT(catalog_entry(catalog, "/A/B", pool), "/X:1");
+      SVN_TEST_STRING_ASSERT(catalog_entry(catalog, "/C/B", pool), "/X:1");
+    }
+
+  /* The index entry is relative to the root directory node. */
+  SVN_ERR(svn_fs_node_id(&id, root, "/", pool));
+  SVN_ERR(svn_fs_fs__get_indexed_mergeinfo(&indexed, fs,
+                                           svn_fs_unparse_id(id, pool)->data,
+                                           pool, pool));
+  SVN_TEST_ASSERT(indexed != NULL);
+  SVN_TEST_INT_ASSERT(apr_hash_count(indexed), 2);
+  SVN_TEST_ASSERT(svn_hash_gets(indexed, "A/B") != NULL);
+  SVN_TEST_ASSERT(svn_hash_gets(indexed, "C/B") != NULL);
+
+  /* Sub-tree queries use their own entries. */
+  APR_ARRAY_IDX(paths, 0, const char *) = "/C";
+  SVN_ERR(svn_fs_get_mergeinfo2(&catalog, root, paths,
+                                svn_mergeinfo_inherited, TRUE, TRUE,
+                                pool, pool));
+  SVN_TEST_INT_ASSERT(apr_hash_count(catalog), 1);
+  SVN_TEST_STRING_ASSERT(catalog_entry(catalog, "/C/B", pool), "/X:1");
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-lock-index"
+
+/* Implements svn_fs_get_locks_callback_t, counting the locks in the
+ * int BATON. */
+static svn_error_t *
+count_locks(void *baton,
+            svn_lock_t *lock,
+            apr_pool_t *pool)
+{
+  ++*(int *)baton;
+  return SVN_NO_ERROR;
+}
+
+/* Set *COUNT to the number of locks in and below PATH in FS up to DEPTH.
+ * Use POOL for allocations. */
+static svn_error_t *
+get_lock_count(int *count,
+               svn_fs_t *fs,
+               const char *path,
+               svn_depth_t depth,
+               apr_pool_t *pool)
+{
+  *count = 0;
+  return svn_error_trace(svn_fs_get_locks2(fs, path, depth, count_locks,
+                                           count, pool));
+}
+
+static svn_error_t *
+lock_index(const svn_test_opts_t *opts,
+           apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_fs_access_t *access;
+  svn_revnum_t rev;
+  svn_lock_t *lock, *indexed;
+  svn_boolean_t exists;
+  int count, i;
+  const char *paths[] = { "A/f1", "A/B/f2", "A0", "A-x", "Z" };
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  SVN_ERR(svn_io_file_create(svn_dirent_join(REPO_NAME, PATH_CONFIG, pool),
+                             "[" CONFIG_SECTION_LOCKS "]\n"
+                             CONFIG_OPTION_ENABLE_LOCK_INDEX " = true\n",
+                             pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_create_access(&access, "user", pool));
+  SVN_ERR(svn_fs_set_access(fs, access));
+
+  /* r1: files at and next to the edges of the /A sub-tree range. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(root, "A", pool));
+  SVN_ERR(svn_fs_make_dir(root, "A/B", pool));
+  for (i = 0; i < 5; ++i)
+    SVN_ERR(svn_fs_make_file(root, paths[i], pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* The first lock operation creates the index. */
+  SVN_ERR(svn_fs_fs__exists_lock_index(&exists, fs, pool));
+  SVN_TEST_ASSERT(!exists);
+  for (i = 0; i < 4; ++i)
+    SVN_ERR(svn_fs_lock(&lock, fs, paths[i], NULL, "comment", FALSE, 0,
+                        rev, FALSE, pool));
+  SVN_ERR(svn_fs_fs__exists_lock_index(&exists, fs, pool));
+  SVN_TEST_ASSERT(exists);
+
+  SVN_ERR(svn_fs_fs__get_indexed_lock(&indexed, fs, "/A-x", pool, pool));
+  SVN_TEST_ASSERT(indexed != NULL);
+  SVN_TEST_STRING_ASSERT(indexed->token, lock->token);
+  SVN_TEST_STRING_ASSERT(indexed->owner, "user");
+  SVN_TEST_STRING_ASSERT(indexed->comment, "comment");
+
+  /* Sub-tree queries must neither include /A0 nor /A-x. */
+  SVN_ERR(get_lock_count(&count, fs, "/", svn_depth_infinity, pool));
+  SVN_TEST_INT_ASSERT(count, 4);
+  SVN_ERR(get_lock_count(&count, fs, "/A", svn_depth_infinity, pool));
+  SVN_TEST_INT_ASSERT(count, 2);
+  SVN_ERR(get_lock_count(&count, fs, "/A", svn_depth_immediates, pool));
+  SVN_TEST_INT_ASSERT(count, 1);
+  SVN_ERR(get_lock_count(&count, fs, "/A0", svn_depth_infinity, pool));
+  SVN_TEST_INT_ASSERT(count, 1);
+
+  SVN_ERR(svn_fs_get_lock(&lock, fs, "/A/f1", pool));
+  SVN_TEST_ASSERT(lock != NULL);
+  SVN_ERR(svn_fs_unlock(fs, "/A/f1", lock->token, FALSE, pool));
+  SVN_ERR(svn_fs_fs__get_indexed_lock(&indexed, fs, "/A/f1", pool, pool));
+  SVN_TEST_ASSERT(indexed == NULL);
+  SVN_ERR(get_lock_count(&count, fs, "/A", svn_depth_infinity, pool));
+  SVN_TEST_INT_ASSERT(count, 1);
+
+  /* The digest files are kept up to date, so a deleted index gets
+   * rebuilt from them. */
+  SVN_ERR(svn_io_remove_file2(svn_dirent_join(REPO_NAME, LOCK_INDEX_DB_NAME,
+                                              pool),
+                              FALSE, pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_set_access(fs, access));
+  SVN_ERR(get_lock_count(&count, fs, "/", svn_depth_infinity, pool));
+  SVN_TEST_INT_ASSERT(count, 3);
+
+  SVN_ERR(svn_fs_lock(&lock, fs, "/Z", NULL, NULL, FALSE, 0, rev, FALSE,
+                      pool));
+  SVN_ERR(svn_fs_fs__exists_lock_index(&exists, fs, pool));
+  SVN_TEST_ASSERT(exists);
+  SVN_ERR(get_lock_count(&count, fs, "/", svn_depth_infinity, pool));
+  SVN_TEST_INT_ASSERT(count, 4);
+  SVN_ERR(svn_fs_fs__get_indexed_lock(&indexed, fs, "/A/B/f2", pool, pool));
+  SVN_TEST_ASSERT(indexed != NULL);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-find-long-delta-chains"
+
+/* Baton type for collect_long_chain. */
+typedef struct long_chains_baton_t
+{
+  int count;
+  int longest;
+} long_chains_baton_t;
+
+/* Implements svn_fs_fs__long_chain_func_t, counting the reports in the
+ * long_chains_baton_t BATON. */
+static svn_error_t *
+collect_long_chain(void *baton,
+                   svn_revnum_t revision,
+                   const char *path,
+                   svn_boolean_t is_props,
+                   int chain_length,
+                   apr_pool_t *scratch_pool)
+{
+  long_chains_baton_t *b = baton;
+
+  SVN_TEST_STRING_ASSERT(path, "/f");
+  SVN_TEST_ASSERT(!is_props);
+  SVN_TEST_ASSERT(chain_length == revision);
+
+  ++b->count;
+  b->longest = MAX(b->longest, chain_length);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+find_long_delta_chains(const svn_test_opts_t *opts,
+                       apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev = 0;
+  long_chains_baton_t baton = { 0 };
+  svn_stringbuf_t *contents;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+
+  /* Linear deltification, i.e. the chain length of the file contents
+   * equals the revision number.  Only the file gets deltified. */
+  SVN_ERR(svn_io_file_create(svn_dirent_join(REPO_NAME, PATH_CONFIG, pool),
+                             "[" CONFIG_SECTION_DELTIFICATION "]\n"
+                             CONFIG_OPTION_ENABLE_DIR_DELTIFICATION
+                             " = false\n"
+                             CONFIG_OPTION_MAX_LINEAR_DELTIFICATION
+                             " = 100\n",
+                             pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+
+  contents = svn_stringbuf_create_empty(pool);
+  for (i = 1; i <= 10; ++i)
+    {
+      svn_pool_clear(iterpool);
+
+      /* Make contents large enough to be deltified. */
+      svn_stringbuf_appendcstr(contents,
+                               "This is yet another line of text to be "
+                               "added to the file contents.\n");
+
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, iterpool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, iterpool));
+      if (i == 1)
+        SVN_ERR(svn_fs_make_file(root, "f", iterpool));
+      SVN_ERR(svn_test__set_file_contents(root, "f", contents->data,
+                                          iterpool));
+      SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  /* Only the file contents of r7 to r10 exceed the limit. */
+  SVN_ERR(svn_fs_fs__find_long_delta_chains(fs, 0, rev, 6,
+                                            collect_long_chain, &baton,
+                                            NULL, NULL, pool));
+  SVN_TEST_INT_ASSERT(baton.count, 4);
+  SVN_TEST_INT_ASSERT(baton.longest, 10);
+
+  /* Restricting the range allows for incremental processing. */
+  baton.count = 0;
+  SVN_ERR(svn_fs_fs__find_long_delta_chains(fs, 8, 9, 6,
+                                            collect_long_chain, &baton,
+                                            NULL, NULL, pool));
+  SVN_TEST_INT_ASSERT(baton.count, 2);
+
+  /* Nothing exceeds the limit used for new commits. */
+  baton.count = 0;
+  SVN_ERR(svn_fs_fs__find_long_delta_chains(fs, 0, rev, 0,
+                                            collect_long_chain, &baton,
+                                            NULL, NULL, pool));
+  SVN_TEST_INT_ASSERT(baton.count, 0);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-revprop-manifest-cache"
+#define SHARD_SIZE 4
+#define MAX_REV 10
+
+static svn_error_t *
+revprop_manifest_cache(const svn_test_opts_t *opts,
+                       apr_pool_t *pool)
+{
+  svn_fs_t *fs, *fs2;
+  fs_fs_data_t *ffd;
+  svn_string_t *prop_value;
+  svn_revnum_t rev;
+
+  /* Create the packed FS and open it.  Use a second FS object to modify
+   * the revprops behind the back of the first one. */
+  SVN_ERR(prepare_revprop_repo(&fs, REPO_NAME, MAX_REV, SHARD_SIZE, opts,
+                               pool));
+  SVN_ERR(svn_fs_open2(&fs2, REPO_NAME, NULL, pool, pool));
+  ffd = fs->fsap_data;
+
+  for (rev = 1; rev <= MAX_REV + 1; ++rev)
+    SVN_ERR(svn_fs_change_rev_prop2(fs2, rev, SVN_PROP_REVISION_LOG, NULL,
+                                    default_log(rev, pool), pool));
+
+  /* Reading the revprops without refresh uses the manifest cache,
+   * one entry per packed shard. */
+  for (rev = 1; rev <= MAX_REV + 1; ++rev)
+    {
+      SVN_ERR(svn_fs_revision_prop2(&prop_value, fs, rev,
+                                    SVN_PROP_REVISION_LOG, FALSE,
+                                    pool, pool));
+      SVN_TEST_STRING_ASSERT(prop_value->data,
+                             default_log(rev, pool)->data);
+    }
+
+  if (ffd->format < SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
+    return SVN_NO_ERROR;
+
+  SVN_TEST_ASSERT(ffd->revprop_manifests != NULL);
+  SVN_TEST_INT_ASSERT(apr_hash_count(ffd->revprop_manifests), 3);
+
+  /* Repacking replaces the pack files.  After a refresh, the old
+   * manifests must not be used anymore. */
+  SVN_ERR(svn_fs_change_rev_prop2(fs2, 5, SVN_PROP_REVISION_LOG, NULL,
+                                  svn_string_create("new log", pool),
+                                  pool));
+  SVN_ERR(svn_fs_refresh_revision_props(fs, pool));
+
+  SVN_ERR(svn_fs_revision_prop2(&prop_value, fs, 5, SVN_PROP_REVISION_LOG,
+                                FALSE, pool, pool));
+  SVN_TEST_STRING_ASSERT(prop_value->data, "new log");
+  SVN_ERR(svn_fs_revision_prop2(&prop_value, fs, 6, SVN_PROP_REVISION_LOG,
+                                FALSE, pool, pool));
+  SVN_TEST_STRING_ASSERT(prop_value->data, default_log(6, pool)->data);
+  SVN_TEST_INT_ASSERT(apr_hash_count(ffd->revprop_manifests), 1);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef MAX_REV
+#undef SHARD_SIZE
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-parallel-hotcopy"
+#define SHARD_SIZE 2
+#define MAX_REV 10
+
+/* Implements svn_fs_hotcopy_notify_t, appending "START:END " to the
+ * svn_stringbuf_t BATON. */
+static void
+hotcopy_notify(void *baton,
+               svn_revnum_t start_revision,
+               svn_revnum_t end_revision,
+               apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *ranges = baton;
+  svn_stringbuf_appendcstr(ranges, apr_psprintf(scratch_pool, "%ld:%ld ",
+                                                start_revision,
+                                                end_revision));
+}
+
+static svn_error_t *
+parallel_hotcopy(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  const char *dst_name = REPO_NAME "-copy";
+  svn_stringbuf_t *ranges = svn_stringbuf_create_empty(pool);
+  svn_fs_t *fs;
+  svn_revnum_t youngest;
+  svn_revnum_t min_unpacked_rev;
+
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                   pool));
+
+  /* Copy up to 3 packed shards at a time. */
+  SVN_ERR(svn_io_file_create(svn_dirent_join(REPO_NAME, PATH_CONFIG, pool),
+                             "[" CONFIG_SECTION_IO "]\n"
+                             CONFIG_OPTION_HOTCOPY_THREADS " = 3\n",
+                             pool));
+
+  SVN_ERR(svn_io_remove_dir2(dst_name, TRUE, NULL, NULL, pool));
+  svn_test_add_dir_cleanup(dst_name);
+  SVN_ERR(svn_fs_hotcopy3(REPO_NAME, dst_name, FALSE, FALSE,
+                          hotcopy_notify, ranges, NULL, NULL, pool));
+
+  /* Progress is still being reported in revision order. */
+  SVN_TEST_STRING_ASSERT(ranges->data, "0:1 2:3 4:5 6:7 8:9 10:10 ");
+
+  SVN_ERR(svn_fs_open2(&fs, dst_name, NULL, pool, pool));
+  SVN_ERR(svn_fs_youngest_rev(&youngest, fs, pool));
+  SVN_TEST_INT_ASSERT(youngest, MAX_REV);
+  SVN_ERR(svn_fs_fs__read_min_unpacked_rev(&min_unpacked_rev, fs, pool));
+  SVN_TEST_INT_ASSERT(min_unpacked_rev, MAX_REV);
+  SVN_ERR(svn_fs_verify(dst_name, NULL, 0, MAX_REV, NULL, NULL, NULL, NULL,
+                        pool));
+
+  /* An incremental hotcopy has nothing left to copy. */
+  svn_stringbuf_setempty(ranges);
+  SVN_ERR(svn_fs_hotcopy3(REPO_NAME, dst_name, FALSE, TRUE,
+                          hotcopy_notify, ranges, NULL, NULL, pool));
+  SVN_TEST_STRING_ASSERT(ranges->data, "");
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef MAX_REV
+#undef SHARD_SIZE
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-txn-changes-order"
+
+/* Verify that ROOT reports its changes sorted by path and that it
+ * reports COUNT changes in total. */
+static svn_error_t *
+verify_changes_order(svn_fs_root_t *root,
+                     int count,
+                     apr_pool_t *pool)
+{
+  svn_fs_path_change_iterator_t *iterator;
+  svn_fs_path_change3_t *change;
+  const char *last_path = NULL;
+  int found = 0;
+
+  SVN_ERR(svn_fs_paths_changed3(&iterator, root, pool, pool));
+  SVN_ERR(svn_fs_path_change_get(&change, iterator));
+  while (change)
+    {
+      if (last_path)
+        SVN_TEST_ASSERT(strcmp(last_path, change->path.data) < 0);
+
+      last_path = apr_pstrmemdup(pool, change->path.data, change->path.len);
+      ++found;
+
+      SVN_ERR(svn_fs_path_change_get(&change, iterator));
+    }
+
+  SVN_TEST_INT_ASSERT(found, count);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+txn_changes_in_path_order(const svn_test_opts_t *opts,
+                          apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+
+  /* Names that sort differently as paths and as plain strings. */
+  static const char *files[] = { "A-b", "A/x", "A/x.c", "A.c", "B", "0" };
+  apr_size_t i;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(root, "A", pool));
+  for (i = 0; i < sizeof(files) / sizeof(files[0]); ++i)
+    SVN_ERR(svn_fs_make_file(root, files[i], pool));
+
+  /* In-txn change lists get reported in the same order as the ones
+   * stored in revisions. */
+  SVN_ERR(verify_changes_order(root, 7, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(verify_changes_order(root, 7, pool));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-max-delta-base-size"
+
+/* Implements svn_fs_fs__long_chain_func_t, counting the reports in the
+ * long_chains_baton_t BATON. */
+static svn_error_t *
+count_long_chain(void *baton,
+                 svn_revnum_t revision,
+                 const char *path,
+                 svn_boolean_t is_props,
+                 int chain_length,
+                 apr_pool_t *scratch_pool)
+{
+  long_chains_baton_t *b = baton;
+
+  ++b->count;
+  b->longest = MAX(b->longest, chain_length);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+max_delta_base_size(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev = 0;
+  long_chains_baton_t baton = { 0 };
+  svn_stringbuf_t *contents, *actual;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+
+  /* Linear deltification against bases of up to 1 kB. */
+  SVN_ERR(svn_io_file_create(svn_dirent_join(REPO_NAME, PATH_CONFIG, pool),
+                             "[" CONFIG_SECTION_DELTIFICATION "]\n"
+                             CONFIG_OPTION_ENABLE_DIR_DELTIFICATION
+                             " = false\n"
+                             CONFIG_OPTION_MAX_LINEAR_DELTIFICATION
+                             " = 100\n"
+                             CONFIG_OPTION_MAX_DELTA_BASE_SIZE
+                             " = 1\n",
+                             pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+
+  /* Grow the file by 67 bytes per revision. */
+  contents = svn_stringbuf_create_empty(pool);
+  for (i = 1; i <= 20; ++i)
+    {
+      svn_pool_clear(iterpool);
+
+      svn_stringbuf_appendcstr(contents,
+                               "This is yet another line of text to be "
+                               "added to the file contents.\n");
+
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, iterpool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, iterpool));
+      if (i == 1)
+        SVN_ERR(svn_fs_make_file(root, "f", iterpool));
+      SVN_ERR(svn_test__set_file_contents(root, "f", contents->data,
+                                          iterpool));
+      SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  /* r2 to r16 got deltified against their predecessors of up to 1005
+   * bytes.  From r17 on, the predecessor would be too large and all
+   * contents are fulltexts. */
+  SVN_ERR(svn_fs_fs__find_long_delta_chains(fs, 0, rev, 1,
+                                            count_long_chain, &baton,
+                                            NULL, NULL, pool));
+  SVN_TEST_INT_ASSERT(baton.count, 15);
+  SVN_TEST_INT_ASSERT(baton.longest, 16);
+
+  /* The contents are still intact. */
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(svn_test__get_file_contents(root, "f", &actual, pool));
+  SVN_TEST_STRING_ASSERT(actual->data, contents->data);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-open-data-cache"
+
+/* Set the modification time of file NAME in REPO_NAME to well before now,
+ * such that its contents may be cached. */
+static svn_error_t *
+backdate_file(const char *name,
+              apr_pool_t *pool)
+{
+  return svn_error_trace(
+    svn_io_set_file_affected_time(apr_time_now() - apr_time_from_sec(60),
+                                  svn_dirent_join(REPO_NAME, name, pool),
+                                  pool));
+}
+
+/* Open REPO_NAME and return whether rep-sharing is enabled in *ENABLED. */
+static svn_error_t *
+get_rep_sharing(svn_boolean_t *enabled,
+                apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  ffd = fs->fsap_data;
+  *enabled = ffd->rep_sharing_allowed;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+open_data_cache(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  const char *uuid;
+  svn_boolean_t enabled;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  ffd = fs->fsap_data;
+  if (ffd->format < SVN_FS_FS__MIN_REP_SHARING_FORMAT)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(svn_fs_get_uuid(fs, &uuid, pool));
+
+  /* Settled files will be cached upon the first open. */
+  SVN_ERR(svn_io_file_create(svn_dirent_join(REPO_NAME, PATH_CONFIG, pool),
+                             "[" CONFIG_SECTION_REP_SHARING "]\n"
+                             CONFIG_OPTION_ENABLE_REP_SHARING " = false\n",
+                             pool));
+  SVN_ERR(backdate_file(PATH_CONFIG, pool));
+  SVN_ERR(backdate_file(PATH_FORMAT, pool));
+  SVN_ERR(backdate_file(PATH_UUID, pool));
+
+  SVN_ERR(get_rep_sharing(&enabled, pool));
+  SVN_TEST_ASSERT(!enabled);
+
+  /* Cache hit. */
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  ffd = fs->fsap_data;
+  SVN_TEST_ASSERT(!ffd->rep_sharing_allowed);
+  SVN_TEST_STRING_ASSERT(fs->uuid, uuid);
+
+  /* Modified config files must not be served from the cache. */
+  SVN_ERR(svn_io_file_create(svn_dirent_join(REPO_NAME, PATH_CONFIG, pool),
+                             "[" CONFIG_SECTION_REP_SHARING "]\n"
+                             CONFIG_OPTION_ENABLE_REP_SHARING " = true\n",
+                             pool));
+  SVN_ERR(get_rep_sharing(&enabled, pool));
+  SVN_TEST_ASSERT(enabled);
+
+  SVN_ERR(backdate_file(PATH_CONFIG, pool));
+  SVN_ERR(get_rep_sharing(&enabled, pool));
+  SVN_TEST_ASSERT(enabled);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-pack-access-profile"
+
+/* Return the item ID of the noderev of PATH in ROOT in *ID. */
+static svn_error_t *
+get_noderev_item(svn_fs_fs__id_part_t *id,
+                 svn_fs_root_t *root,
+                 const char *path,
+                 apr_pool_t *pool)
+{
+  const svn_fs_id_t *node_id;
+
+  SVN_ERR(svn_fs_node_id(&node_id, root, path, pool));
+  *id = *svn_fs_fs__id_rev_item(node_id);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the pack file offset of item ID in FS in *OFFSET. */
+static svn_error_t *
+get_item_offset(apr_off_t *offset,
+                svn_fs_t *fs,
+                const svn_fs_fs__id_part_t *id,
+                apr_pool_t *pool)
+{
+  svn_fs_fs__revision_file_t *rev_file;
+
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, id->revision,
+                                           pool, pool));
+  SVN_ERR(svn_fs_fs__item_offset(offset, fs, rev_file, id->revision, NULL,
+                                 id->number, pool));
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+pack_access_profile(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_root_t *root;
+  svn_fs_fs__id_part_t mu, lambda;
+  apr_off_t mu_offset, lambda_offset;
+  apr_hash_t *fs_config;
+  const char *profile;
+
+  SVN_ERR(create_non_packed_filesystem(REPO_NAME, opts, 3, 4, pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  ffd = fs->fsap_data;
+  if (!ffd->use_log_addressing)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "access profiles require logical addressing");
+
+  /* Without a profile, pack would place A/B/lambda in front of A/mu. */
+  SVN_ERR(svn_fs_revision_root(&root, fs, 1, pool));
+  SVN_ERR(get_noderev_item(&mu, root, "A/mu", pool));
+  SVN_ERR(get_noderev_item(&lambda, root, "A/B/lambda", pool));
+
+  profile = svn_dirent_join(REPO_NAME, "access-profile", pool);
+  SVN_ERR(svn_io_file_create(profile,
+                             apr_psprintf(pool,
+                                          "# recorded accesses\n"
+                                          "%ld %" APR_UINT64_T_FMT "\n"
+                                          "\n"
+                                          "%ld %" APR_UINT64_T_FMT "\n"
+                                          "%ld %" APR_UINT64_T_FMT "\n",
+                                          mu.revision, mu.number,
+                                          lambda.revision, lambda.number,
+                                          mu.revision, mu.number),
+                             pool));
+
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_PACK_ACCESS_PROFILE, profile);
+  SVN_ERR(svn_fs_pack2(REPO_NAME, 1, fs_config, NULL, NULL, NULL, NULL,
+                       pool));
+
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(get_item_offset(&mu_offset, fs, &mu, pool));
+  SVN_ERR(get_item_offset(&lambda_offset, fs, &lambda, pool));
+  SVN_TEST_ASSERT(mu_offset < lambda_offset);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-skip-file-contents"
+
+/* Read LEN bytes at OFFSET from PATH in ROOT by skipping over the first
+ * OFFSET bytes of the contents stream and compare them with EXPECTED. */
+static svn_error_t *
+check_skipped_contents(svn_fs_root_t *root,
+                       const char *path,
+                       svn_stringbuf_t *expected,
+                       apr_size_t offset,
+                       apr_size_t len,
+                       apr_pool_t *pool)
+{
+  svn_stream_t *stream;
+  char *buffer = apr_palloc(pool, len);
+  apr_size_t read = len;
+
+  SVN_ERR(svn_fs_file_contents(&stream, root, path, pool));
+  SVN_ERR(svn_stream_skip(stream, offset));
+  SVN_ERR(svn_stream_read_full(stream, buffer, &read));
+
+  if (offset >= expected->len)
+    SVN_TEST_ASSERT(read == 0);
+  else
+    SVN_TEST_ASSERT(read == MIN(len, expected->len - offset));
+
+  SVN_TEST_ASSERT(memcmp(buffer, expected->data + offset, read) == 0);
+
+  return svn_error_trace(svn_stream_close(stream));
+}
+
+static svn_error_t *
+skip_file_contents(const svn_test_opts_t *opts,
+                   apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  svn_stringbuf_t *contents;
+  apr_hash_t *fs_config;
+  svn_stream_t *stream;
+  char buffer[100];
+  apr_size_t len;
+  apr_uint32_t seed = 0;
+  apr_size_t i;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+
+  /* A file spanning multiple delta windows. */
+  contents = svn_stringbuf_create_ensure(350000, pool);
+  for (i = 0; i < 350000; ++i)
+    {
+      seed = seed * 1103515245 + 12345;
+      svn_stringbuf_appendbyte(contents, (char)('a' + (seed >> 16) % 26));
+    }
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_file(root, "f", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "f", contents->data, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Modify it such that we get a delta chain. */
+  memcpy(contents->data + 150000, "Hello World", 11);
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(root, "f", contents->data, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Make sure we read from the delta windows. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_FULLTEXTS, "0");
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+
+  /* Start, within and across windows, at the end and beyond. */
+  SVN_ERR(check_skipped_contents(root, "f", contents, 0, 1000, pool));
+  SVN_ERR(check_skipped_contents(root, "f", contents, 5, 1000, pool));
+  SVN_ERR(check_skipped_contents(root, "f", contents, 102400, 1000, pool));
+  SVN_ERR(check_skipped_contents(root, "f", contents, 149995, 1000, pool));
+  SVN_ERR(check_skipped_contents(root, "f", contents, 204000, 1000, pool));
+  SVN_ERR(check_skipped_contents(root, "f", contents, 300000, 60000, pool));
+  SVN_ERR(check_skipped_contents(root, "f", contents, 349990, 1000, pool));
+  SVN_ERR(check_skipped_contents(root, "f", contents, 350000, 1000, pool));
+  SVN_ERR(check_skipped_contents(root, "f", contents, 400000, 1000, pool));
+
+  /* Skip after a partial read, i.e. from within a reconstructed window. */
+  SVN_ERR(svn_fs_file_contents(&stream, root, "f", pool));
+  len = sizeof(buffer);
+  SVN_ERR(svn_stream_read_full(stream, buffer, &len));
+  SVN_ERR(svn_stream_skip(stream, 250000));
+  len = sizeof(buffer);
+  SVN_ERR(svn_stream_read_full(stream, buffer, &len));
+  SVN_TEST_ASSERT(len == sizeof(buffer));
+  SVN_TEST_ASSERT(memcmp(buffer, contents->data + 250100, len) == 0);
+  SVN_ERR(svn_stream_close(stream));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-skip-predecessors"
+
+static svn_error_t *
+skip_predecessors(const svn_test_opts_t *opts,
+                  apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  const svn_fs_id_t *id;
+  node_revision_t *noderev, *pred;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  if (opts->server_minor_version && (opts->server_minor_version < 10))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.10 SVN doesn't support skip links");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+
+  /* r1 adds the file, every later revision modifies it. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_file(root, "f", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  for (i = 1; i <= 40; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, iterpool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, iterpool));
+      SVN_ERR(svn_test__set_file_contents(root, "f",
+                                          apr_psprintf(iterpool, "%d\n", i),
+                                          iterpool));
+      SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, iterpool));
+    }
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(svn_fs_node_id(&id, root, "f", pool));
+  SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, id, pool, pool));
+  SVN_TEST_INT_ASSERT(noderev->predecessor_count, 40);
+
+  /* 40 = 101000b, so the skip link leads to 100000b = 32. */
+  SVN_TEST_ASSERT(noderev->skip_id != NULL);
+  SVN_ERR(svn_fs_fs__get_node_revision(&pred, fs, noderev->skip_id,
+                                       pool, pool));
+  SVN_TEST_INT_ASSERT(pred->predecessor_count, 32);
+
+  /* Odd counts would just duplicate the predecessor link. */
+  SVN_ERR(svn_fs_fs__get_node_revision(&pred, fs, noderev->predecessor_id,
+                                       pool, pool));
+  SVN_TEST_ASSERT(pred->skip_id == NULL);
+
+  /* Every predecessor can be found. */
+  for (i = 0; i <= 40; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_fs__get_predecessor(&pred, fs, noderev, i,
+                                         iterpool, iterpool));
+      SVN_TEST_INT_ASSERT(pred->predecessor_count, i);
+      SVN_TEST_INT_ASSERT(svn_fs_fs__id_rev(pred->id), i + 1);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
 
 
 /* The test table.  */
@@ -1930,10 +3731,16 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "change revprops with enabled and disabled caching"),
     SVN_TEST_OPTS_PASS(id_parser_test,
                        "id parser test"),
+    SVN_TEST_OPTS_PASS(noderev_parser_test,
+                       "noderev and changes parser test"),
     SVN_TEST_OPTS_PASS(plain_0_length,
                        "file with 0 expanded-length, issue #4554"),
     SVN_TEST_OPTS_PASS(rep_sharing_effectiveness,
                        "rep-sharing effectiveness"),
+    SVN_TEST_OPTS_PASS(rep_cache_filter,
+                       "rep-sharing with rep-cache Bloom filter"),
+    SVN_TEST_OPTS_PASS(large_directory,
+                       "read very large directories"),
     SVN_TEST_OPTS_PASS(delta_chain_with_plain,
                        "delta chains starting with PLAIN, issue #4577"),
     SVN_TEST_OPTS_PASS(compare_0_length_rep,
@@ -1942,6 +3749,40 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "pack with limited memory for metadata"),
     SVN_TEST_OPTS_PASS(large_delta_against_plain,
                        "large deltas against PLAIN, issue #4658"),
+    SVN_TEST_OPTS_PASS(pack_concurrently,
+                       "pack multiple shards concurrently"),
+    SVN_TEST_OPTS_PASS(read_ahead,
+                       "read packed FSFS with read-ahead"),
+    SVN_TEST_OPTS_PASS(shared_file_handles,
+                       "share pack file handles between FSFS instances"),
+    SVN_TEST_OPTS_PASS(group_commit,
+                       "commit in group commit mode"),
+    SVN_TEST_OPTS_PASS(deep_path_lookup,
+                       "look up deep paths in revision roots"),
+    SVN_TEST_OPTS_PASS(changed_paths_index,
+                       "changed paths index for path-restricted log"),
+    SVN_TEST_OPTS_PASS(mergeinfo_index,
+                       "answer mergeinfo queries from the index"),
+    SVN_TEST_OPTS_PASS(lock_index,
+                       "answer lock queries from the lock index"),
+    SVN_TEST_OPTS_PASS(find_long_delta_chains,
+                       "find representations with long delta chains"),
+    SVN_TEST_OPTS_PASS(revprop_manifest_cache,
+                       "read packed revprops with cached manifests"),
+    SVN_TEST_OPTS_PASS(parallel_hotcopy,
+                       "hotcopy packed shards concurrently"),
+    SVN_TEST_OPTS_PASS(txn_changes_in_path_order,
+                       "report in-txn changes in path order"),
+    SVN_TEST_OPTS_PASS(max_delta_base_size,
+                       "store fulltexts instead of deltas on large bases"),
+    SVN_TEST_OPTS_PASS(open_data_cache,
+                       "reuse format and config data when opening"),
+    SVN_TEST_OPTS_PASS(pack_access_profile,
+                       "pack with an access profile"),
+    SVN_TEST_OPTS_PASS(skip_file_contents,
+                       "skip parts of the file contents"),
+    SVN_TEST_OPTS_PASS(skip_predecessors,
+                       "skip links into node histories"),
     SVN_TEST_NULL
   };
 
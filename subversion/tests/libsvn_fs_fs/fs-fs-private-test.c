@@ -209,7 +209,7 @@ get_repo_stats(const svn_test_opts_t *opts,
   SVN_ERR(create_greek_repo(&repos, &rev, opts, REPO_NAME, pool, pool));
 
   /* Gather statistics info on that repo. */
-  SVN_ERR(svn_fs_fs__get_stats(&stats, svn_repos_fs(repos), NULL, NULL,
+  SVN_ERR(svn_fs_fs__get_stats(&stats, svn_repos_fs(repos), 1, NULL, NULL,
                                NULL, NULL, pool, pool));
 
   /* Check that the stats make sense. */
@@ -267,6 +267,178 @@ get_repo_stats(const svn_test_opts_t *opts,
 
 /* ------------------------------------------------------------------------ */
 
+#define REPO_NAME "test-repo-get-repo-stats-parallel-test"
+#define SHARD_SIZE 3
+#define MAX_REV 20
+
+/* Verify that the shared and unique reps in STATS add up.
+ */
+static svn_error_t *
+verify_rep_sharing(const svn_fs_fs__representation_stats_t *stats)
+{
+  SVN_TEST_ASSERT(stats->total.count
+                  == stats->uniques.count + stats->shared.count);
+  SVN_TEST_ASSERT(stats->total.packed_size
+                  == stats->uniques.packed_size + stats->shared.packed_size);
+  SVN_TEST_ASSERT(stats->total.overhead_size
+                  == stats->uniques.overhead_size
+                   + stats->shared.overhead_size);
+  SVN_TEST_ASSERT(stats->references
+                  >= stats->uniques.count + 2 * stats->shared.count);
+
+  return SVN_NO_ERROR;
+}
+
+/* Verify that LHS and RHS contain the same information.
+ */
+static svn_error_t *
+compare_stats(const svn_fs_fs__stats_t *lhs,
+              const svn_fs_fs__stats_t *rhs)
+{
+  apr_size_t i;
+
+  SVN_TEST_ASSERT(lhs->total_size == rhs->total_size);
+  SVN_TEST_ASSERT(lhs->revision_count == rhs->revision_count);
+  SVN_TEST_ASSERT(lhs->change_count == rhs->change_count);
+  SVN_TEST_ASSERT(lhs->change_len == rhs->change_len);
+
+#define COMPARE_MEMBER(member) \
+  SVN_TEST_ASSERT(!memcmp(&lhs->member, &rhs->member, sizeof(lhs->member)))
+
+  COMPARE_MEMBER(total_rep_stats);
+  COMPARE_MEMBER(file_rep_stats);
+  COMPARE_MEMBER(dir_rep_stats);
+  COMPARE_MEMBER(file_prop_rep_stats);
+  COMPARE_MEMBER(dir_prop_rep_stats);
+  COMPARE_MEMBER(total_node_stats);
+  COMPARE_MEMBER(file_node_stats);
+  COMPARE_MEMBER(dir_node_stats);
+  COMPARE_MEMBER(rep_size_histogram);
+  COMPARE_MEMBER(node_size_histogram);
+  COMPARE_MEMBER(added_rep_size_histogram);
+  COMPARE_MEMBER(added_node_size_histogram);
+  COMPARE_MEMBER(unused_rep_histogram);
+  COMPARE_MEMBER(file_histogram);
+  COMPARE_MEMBER(file_rep_histogram);
+  COMPARE_MEMBER(file_prop_histogram);
+  COMPARE_MEMBER(file_prop_rep_histogram);
+  COMPARE_MEMBER(dir_histogram);
+  COMPARE_MEMBER(dir_rep_histogram);
+  COMPARE_MEMBER(dir_prop_histogram);
+  COMPARE_MEMBER(dir_prop_rep_histogram);
+
+#undef COMPARE_MEMBER
+
+  SVN_TEST_ASSERT(lhs->largest_changes->min_size
+                  == rhs->largest_changes->min_size);
+  for (i = 0; i < lhs->largest_changes->count; ++i)
+    SVN_TEST_ASSERT(lhs->largest_changes->changes[i]->size
+                    == rhs->largest_changes->changes[i]->size);
+
+  SVN_TEST_ASSERT(apr_hash_count(lhs->by_extension)
+                  == apr_hash_count(rhs->by_extension));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+get_repo_stats_parallel(const svn_test_opts_t *opts,
+                        apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *root;
+  svn_revnum_t rev;
+  apr_hash_t *fs_config;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_fs_fs__stats_t *stats, *parallel_stats;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  if (opts->server_minor_version && (opts->server_minor_version < 6))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.6 SVN doesn't support FSFS packing");
+
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_SHARD_SIZE,
+                apr_itoa(pool, SHARD_SIZE));
+  SVN_ERR(svn_test__create_fs2(&fs, REPO_NAME, opts, fs_config, pool));
+
+  /* r1: the Greek tree */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, iterpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, iterpool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, iterpool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, iterpool));
+
+  /* Deltify iota across several shards and reference old reps from
+   * later ones through property changes and copies. */
+  while (rev < MAX_REV)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, iterpool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, iterpool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, "iota",
+                                          apr_psprintf(iterpool,
+                                                       "iota in r%ld\n",
+                                                       rev + 1),
+                                          iterpool));
+
+      if (rev % 4 == 0)
+        SVN_ERR(svn_fs_change_node_prop(txn_root, "A/mu", "prop",
+                                        svn_string_createf(iterpool,
+                                                           "value %ld", rev),
+                                        iterpool));
+      if (rev % 5 == 0)
+        {
+          SVN_ERR(svn_fs_revision_root(&root, fs, 1, iterpool));
+          SVN_ERR(svn_fs_copy(root, "A/D",  txn_root,
+                              apr_psprintf(iterpool, "D%ld", rev),
+                              iterpool));
+        }
+
+      SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, iterpool));
+    }
+
+  /* Pack all but the last shard. */
+  SVN_ERR(svn_fs_pack(REPO_NAME, NULL, NULL, NULL, NULL, iterpool));
+  svn_pool_destroy(iterpool);
+
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_fs__get_stats(&stats, fs, 1, NULL, NULL, NULL, NULL,
+                               pool, pool));
+  SVN_ERR(svn_fs_fs__get_stats(&parallel_stats, fs, 4, NULL, NULL, NULL,
+                               NULL, pool, pool));
+
+  /* Reading shards concurrently must not change the result. */
+  SVN_ERR(compare_stats(stats, parallel_stats));
+
+  SVN_TEST_ASSERT(stats->revision_count == MAX_REV + 1);
+  SVN_ERR(verify_rep_sharing(&stats->total_rep_stats));
+  SVN_ERR(verify_rep_sharing(&stats->file_rep_stats));
+  SVN_ERR(verify_rep_sharing(&stats->dir_rep_stats));
+  SVN_ERR(verify_rep_sharing(&stats->file_prop_rep_stats));
+  SVN_ERR(verify_rep_sharing(&stats->dir_prop_rep_stats));
+
+  /* A/mu's text and A/D got referenced from later shards. */
+  SVN_TEST_ASSERT(stats->file_rep_stats.shared.count > 0);
+  SVN_TEST_ASSERT(stats->dir_rep_stats.shared.count > 0);
+
+  /* iota forms delta chains across shards. */
+  SVN_TEST_ASSERT(stats->file_rep_stats.chain_len
+                  > stats->file_rep_stats.total.count);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
+/* ------------------------------------------------------------------------ */
+
 #define REPO_NAME "test-repo-dump-index-test"
 
 typedef struct dump_baton_t
@@ -429,6 +601,8 @@ static struct svn_test_descriptor_t test_funcs[] =
     SVN_TEST_NULL,
     SVN_TEST_OPTS_PASS(get_repo_stats,
                        "get statistics on a FSFS filesystem"),
+    SVN_TEST_OPTS_PASS(get_repo_stats_parallel,
+                       "get statistics reading shards concurrently"),
     SVN_TEST_OPTS_PASS(dump_index,
                        "dump the P2L index"),
     SVN_TEST_OPTS_PASS(load_index,
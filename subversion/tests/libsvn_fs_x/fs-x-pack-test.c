@@ -118,15 +118,16 @@ pack_notify(void *baton,
 
 /* Create a packed filesystem in DIR.  Set the shard size to
    SHARD_SIZE and create NUM_REVS number of revisions (in addition to
-   r0).  Use POOL for allocations.  After this function successfully
-   completes, the filesystem's youngest revision number will be the
-   same as NUM_REVS.  */
+   r0).  Pack using JOBS threads.  Use POOL for allocations.  After this
+   function successfully completes, the filesystem's youngest revision
+   number will be the same as NUM_REVS.  */
 static svn_error_t *
-create_packed_filesystem(const char *dir,
-                         const svn_test_opts_t *opts,
-                         int num_revs,
-                         int shard_size,
-                         apr_pool_t *pool)
+create_packed_filesystem_jobs(const char *dir,
+                              const svn_test_opts_t *opts,
+                              int num_revs,
+                              int shard_size,
+                              int jobs,
+                              apr_pool_t *pool)
 {
   svn_fs_t *fs;
   svn_fs_txn_t *txn;
@@ -192,7 +193,19 @@ create_packed_filesystem(const char *dir,
   /* Now pack the FS */
   pnb.expected_shard = 0;
   pnb.expected_action = svn_fs_pack_notify_start;
-  return svn_fs_pack(dir, pack_notify, &pnb, NULL, NULL, pool);
+  return svn_fs_pack2(dir, jobs, NULL, pack_notify, &pnb, NULL, NULL, pool);
+}
+
+/* Like create_packed_filesystem_jobs with JOBS set to 1. */
+static svn_error_t *
+create_packed_filesystem(const char *dir,
+                         const svn_test_opts_t *opts,
+                         int num_revs,
+                         int shard_size,
+                         apr_pool_t *pool)
+{
+  return svn_error_trace(create_packed_filesystem_jobs(dir, opts, num_revs,
+                                                       shard_size, 1, pool));
 }
 
 /* Create a packed FSFS filesystem for revprop tests at REPO_NAME with
@@ -778,6 +791,7 @@ test_reps(const svn_test_opts_t *opts,
   svn_stringbuf_t *serialized;
   svn_stream_t *stream;
   svn_stringbuf_t *contents = svn_stringbuf_create_ensure(10000, pool);
+  apr_array_header_t *indexes, *extractors;
   int i;
 
   for (i = 0; i < 10000; ++i)
@@ -807,12 +821,40 @@ test_reps(const svn_test_opts_t *opts,
 
   serialized = svn_stringbuf_create_empty(pool);
   stream = svn_stream_from_stringbuf(serialized, pool);
-  SVN_ERR(svn_fs_x__write_reps_container(stream, builder, pool));
+  SVN_ERR(svn_fs_x__write_reps_container(stream, builder, NULL, pool));
 
   SVN_ERR(svn_stream_reset(stream));
-  SVN_ERR(svn_fs_x__read_reps_container(&container, stream, pool, pool));
+  SVN_ERR(svn_fs_x__read_reps_container(&container, stream, NULL, pool, pool));
   SVN_ERR(svn_stream_close(stream));
 
+  /* Extract a batch of fulltexts, containing a duplicate, at once. */
+  indexes = apr_array_make(pool, 4, sizeof(apr_size_t));
+  APR_ARRAY_PUSH(indexes, apr_size_t) = 0;
+  APR_ARRAY_PUSH(indexes, apr_size_t) = 100;
+  APR_ARRAY_PUSH(indexes, apr_size_t) = 5;
+  APR_ARRAY_PUSH(indexes, apr_size_t) = 100;
+  SVN_ERR(svn_fs_x__reps_get_many(&extractors, fs, container, indexes, pool));
+  SVN_TEST_INT_ASSERT(extractors->nelts, indexes->nelts);
+
+  for (i = 0; i < extractors->nelts; ++i)
+    {
+      svn_stringbuf_t *text;
+      apr_size_t idx = APR_ARRAY_IDX(indexes, i, apr_size_t);
+
+      SVN_ERR(svn_fs_x__extractor_drive(&text,
+                                        APR_ARRAY_IDX(extractors, i,
+                                                  svn_fs_x__rep_extractor_t *),
+                                        0, 0, pool, pool));
+      SVN_TEST_INT_ASSERT(text->len, 10000 - idx);
+      SVN_TEST_ASSERT(memcmp(text->data, contents->data, text->len) == 0);
+    }
+
+  /* Indexes beyond the end of the container are rejected. */
+  APR_ARRAY_PUSH(indexes, apr_size_t) = 10000;
+  SVN_TEST_ASSERT_ERROR(svn_fs_x__reps_get_many(&extractors, fs, container,
+                                                indexes, pool),
+                        SVN_ERR_FS_CONTAINER_INDEX);
+
   return SVN_NO_ERROR;
 }
 
@@ -845,6 +887,52 @@ pack_shard_size_one(const svn_test_opts_t *opts,
 #undef SHARD_SIZE
 #undef MAX_REV
 /* ------------------------------------------------------------------------ */
+#define REPO_NAME "test-repo-pack-single-shard-jobs"
+#define SHARD_SIZE 20
+#define MAX_REV 19
+static svn_error_t *
+pack_single_shard_jobs(const svn_test_opts_t *opts,
+                       apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_revnum_t i;
+
+  /* A single shard gets packed with multiple threads reading the
+   * representations for the containers. */
+  SVN_ERR(create_packed_filesystem_jobs(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                        4, pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+
+  for (i = 1; i < (MAX_REV + 1); i++)
+    {
+      svn_fs_root_t *rev_root;
+      svn_stream_t *rstream;
+      svn_stringbuf_t *rstring;
+      svn_stringbuf_t *sb;
+
+      SVN_ERR(svn_fs_revision_root(&rev_root, fs, i, pool));
+      SVN_ERR(svn_fs_file_contents(&rstream, rev_root, "iota", pool));
+      SVN_ERR(svn_test__stream_to_string(&rstring, rstream, pool));
+
+      if (i == 1)
+        sb = svn_stringbuf_create("This is the file 'iota'.\n", pool);
+      else
+        sb = svn_stringbuf_create(get_rev_contents(i, pool), pool);
+
+      if (! svn_stringbuf_compare(rstring, sb))
+        return svn_error_createf(SVN_ERR_FS_GENERAL, NULL,
+                                 "Bad data in revision %ld.", i);
+    }
+
+  SVN_ERR(svn_fs_verify(REPO_NAME, NULL, 0, SVN_INVALID_REVNUM, NULL, NULL,
+                        NULL, NULL, pool));
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+/* ------------------------------------------------------------------------ */
 #define REPO_NAME "test-repo-fsx-batch-fsync"
 static svn_error_t *
 test_batch_fsync(const svn_test_opts_t *opts,
@@ -852,7 +940,10 @@ test_batch_fsync(const svn_test_opts_t *opts,
 {
   const char *abspath;
   svn_fs_x__batch_fsync_t *batch;
-  int i;
+  int i, k;
+
+  const svn_fs_x__fsync_method_t methods[] = { svn_fs_x__fsync_io_uring,
+                                               svn_fs_x__fsync_syncfs };
 
   /* Disable this test for non FSX backends because it has no relevance to
    * them. */
@@ -873,7 +964,8 @@ test_batch_fsync(const svn_test_opts_t *opts,
   SVN_ERR(svn_fs_x__batch_fsync_init());
 
   /* We use and re-use the same batch object throughout this test. */
-  SVN_ERR(svn_fs_x__batch_fsync_create(&batch, TRUE, pool));
+  SVN_ERR(svn_fs_x__batch_fsync_create(&batch, TRUE,
+                                       svn_fs_x__fsync_threads, pool));
 
   /* The working directory is new. */
   SVN_ERR(svn_fs_x__batch_fsync_new_path(batch, abspath, pool));
@@ -911,6 +1003,31 @@ test_batch_fsync(const svn_test_opts_t *opts,
 
   SVN_ERR(svn_fs_x__batch_fsync_run(batch, pool));
 
+  /* The alternative flush methods must work or fall back gracefully. */
+  for (k = 0; k < 2; ++k)
+    {
+      svn_fs_x__batch_fsync_t *other_batch;
+      SVN_ERR(svn_fs_x__batch_fsync_create(&other_batch, TRUE, methods[k],
+                                           pool));
+
+      for (i = 0; i < 10; ++i)
+        {
+          apr_file_t *file;
+          const char *path
+            = svn_dirent_join(abspath, apr_psprintf(pool, "method%i-%i",
+                                                    k, i),
+                              pool);
+          apr_size_t len = strlen(path);
+
+          SVN_ERR(svn_fs_x__batch_fsync_open_file(&file, other_batch, path,
+                                                  pool));
+
+          SVN_ERR(svn_io_file_write(file, path, &len, pool));
+        }
+
+      SVN_ERR(svn_fs_x__batch_fsync_run(other_batch, pool));
+    }
+
   /* 3rd run: Schedule but don't execute. POOL cleanup shall not fail. */
   for (i = 0; i < 10; ++i)
     {
@@ -963,6 +1080,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test packing with shard size = 1"),
     SVN_TEST_OPTS_PASS(test_batch_fsync,
                        "test batch fsync"),
+    SVN_TEST_OPTS_PASS(pack_single_shard_jobs,
+                       "pack a single shard with multiple threads"),
     SVN_TEST_NULL
   };
 
@@ -88,13 +88,13 @@ store_and_load_table(string_table_t **table, apr_pool_t *pool)
   svn_stream_t *stream;
 
   stream = svn_stream_from_stringbuf(stream_buffer, pool);
-  SVN_ERR(svn_fs_x__write_string_table(stream, *table, pool));
+  SVN_ERR(svn_fs_x__write_string_table(stream, *table, NULL, pool));
   SVN_ERR(svn_stream_close(stream));
 
   *table = NULL;
 
   stream = svn_stream_from_stringbuf(stream_buffer, pool);
-  SVN_ERR(svn_fs_x__read_string_table(table, stream, pool, pool));
+  SVN_ERR(svn_fs_x__read_string_table(table, stream, NULL, pool, pool));
   SVN_ERR(svn_stream_close(stream));
 
   return SVN_NO_ERROR;
@@ -238,6 +238,60 @@ many_strings_table_body(svn_boolean_t do_load_store,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+get_many_strings(apr_pool_t *pool)
+{
+  /* cover multiple sub-tables, short and long strings */
+  enum { COUNT = 100 };
+
+  svn_stringbuf_t *strings[COUNT] = { 0 };
+  apr_size_t indexes[COUNT + 1] = { 0 };
+  const char *results[COUNT + 1] = { 0 };
+  apr_size_t lengths[COUNT + 1] = { 0 };
+
+  string_table_builder_t *builder;
+  string_table_t *table;
+  int i;
+
+  builder = svn_fs_x__string_table_builder_create(pool);
+  for (i = 0; i < COUNT; ++i)
+    {
+      /* Sharing prefixes between strings. */
+      strings[i] = generate_string(APR_UINT64_C(0x1234567876543210) * (i % 7),
+                                   (i * i) % 23000,  pool);
+      indexes[i] = svn_fs_x__string_table_builder_add(builder,
+                                                      strings[i]->data,
+                                                      strings[i]->len);
+    }
+
+  table = svn_fs_x__string_table_create(builder, pool);
+
+  /* Request the strings in reverse order plus an invalid one. */
+  for (i = 0; i < COUNT / 2; ++i)
+    {
+      apr_size_t temp = indexes[i];
+      indexes[i] = indexes[COUNT - 1 - i];
+      indexes[COUNT - 1 - i] = temp;
+    }
+  indexes[COUNT] = 0x7fffffff;
+
+  svn_fs_x__string_table_get_many(results, lengths, table, indexes,
+                                  COUNT + 1, pool);
+
+  for (i = 0; i < COUNT; ++i)
+    {
+      const svn_stringbuf_t *expected = strings[COUNT - 1 - i];
+
+      SVN_TEST_STRING_ASSERT(results[i], expected->data);
+      SVN_TEST_ASSERT(lengths[i] == expected->len);
+    }
+
+  SVN_TEST_STRING_ASSERT(results[COUNT], "");
+  SVN_TEST_ASSERT(lengths[COUNT] == 0);
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 create_empty_table(apr_pool_t *pool)
 {
@@ -312,6 +366,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "store and load table with large strings only"),
     SVN_TEST_PASS2(store_load_many_strings_table,
                    "store and load string table with many strings"),
+    SVN_TEST_PASS2(get_many_strings,
+                   "extract many strings from a table at once"),
     SVN_TEST_NULL
   };
 
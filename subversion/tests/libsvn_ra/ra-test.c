@@ -29,13 +29,16 @@
 #include <assert.h>
 
 #include "svn_error.h"
+#include "svn_config.h"
 #include "svn_delta.h"
+#include "svn_io.h"
 #include "svn_ra.h"
 #include "svn_time.h"
 #include "svn_pools.h"
 #include "svn_cmdline.h"
 #include "svn_dirent_uri.h"
 #include "svn_hash.h"
+#include "svn_props.h"
 
 #include "../svn_test.h"
 #include "../svn_test_fs.h"
@@ -325,6 +328,96 @@ location_segments_test(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Test that the history cache answers repeated location segment
+   and inherited properties queries. */
+static svn_error_t *
+history_cache_test(const svn_test_opts_t *opts,
+                   apr_pool_t *pool)
+{
+  svn_ra_session_t *session;
+  svn_ra_callbacks2_t *cbtable;
+  apr_hash_t *config = apr_hash_make(pool);
+  svn_config_t *cfg;
+  const char *url;
+  const char *cache_dir = svn_test_data_path("ra-test-histcache", pool);
+  apr_hash_t *dirents;
+  struct gls_receiver_baton_t b;
+  svn_location_segment_t *seg;
+  const svn_delta_editor_t *editor;
+  void *edit_baton, *root_baton;
+  int i;
+
+  SVN_ERR(svn_io_remove_dir2(cache_dir, TRUE, NULL, NULL, pool));
+  svn_test_add_dir_cleanup(cache_dir);
+
+  SVN_ERR(make_and_open_repos(&session, "test-repo-histcache", opts, pool));
+  SVN_ERR(commit_changes(session, pool));
+  SVN_ERR(svn_ra_get_session_url(session, &url, pool));
+
+  /* r2: Set a property on the root for A to inherit. */
+  SVN_ERR(svn_ra_get_commit_editor3(session, &editor, &edit_baton,
+                                    apr_hash_make(pool),
+                                    NULL, NULL, NULL, TRUE, pool));
+  SVN_ERR(editor->open_root(edit_baton, 1, pool, &root_baton));
+  SVN_ERR(editor->change_dir_prop(root_baton, "p",
+                                  svn_string_create("v", pool), pool));
+  SVN_ERR(editor->close_directory(root_baton, pool));
+  SVN_ERR(editor->close_edit(edit_baton, pool));
+
+  SVN_ERR(svn_config_create2(&cfg, FALSE, FALSE, pool));
+  svn_config_set(cfg, SVN_CONFIG_SECTION_MISCELLANY,
+                 SVN_CONFIG_OPTION_HISTORY_CACHE_DIRECTORY, cache_dir);
+  svn_hash_sets(config, SVN_CONFIG_CATEGORY_CONFIG, cfg);
+
+  SVN_ERR(svn_ra_create_callbacks(&cbtable, pool));
+  SVN_ERR(svn_test__init_auth_baton(&cbtable->auth_baton, pool));
+  SVN_ERR(svn_ra_open4(&session, NULL, url, NULL, cbtable, NULL, config,
+                       pool));
+
+  /* The first query fills the cache, the second one is answered from it
+     with the same result. */
+  for (i = 0; i < 2; i++)
+    {
+      b.segments = apr_array_make(pool, 1, sizeof(svn_location_segment_t *));
+      b.pool = pool;
+
+      SVN_ERR(svn_ra_get_location_segments(session, "A", 1,
+                                           SVN_INVALID_REVNUM,
+                                           SVN_INVALID_REVNUM,
+                                           gls_receiver, &b, pool));
+
+      SVN_ERR(svn_io_get_dirents3(&dirents, cache_dir, TRUE, pool, pool));
+      SVN_TEST_ASSERT(apr_hash_count(dirents) == 1);
+
+      SVN_TEST_ASSERT(b.segments->nelts == 2);
+      seg = APR_ARRAY_IDX(b.segments, 0, svn_location_segment_t *);
+      SVN_TEST_STRING_ASSERT(seg->path, "A");
+      SVN_TEST_ASSERT(seg->range_start == 1);
+      SVN_TEST_ASSERT(seg->range_end == 1);
+      seg = APR_ARRAY_IDX(b.segments, 1, svn_location_segment_t *);
+      SVN_TEST_STRING_ASSERT(seg->path, "");
+      SVN_TEST_ASSERT(seg->range_start == 0);
+      SVN_TEST_ASSERT(seg->range_end == 0);
+    }
+
+  for (i = 0; i < 2; i++)
+    {
+      apr_array_header_t *iprops;
+      svn_prop_inherited_item_t *item;
+
+      SVN_ERR(svn_ra_get_inherited_props(session, &iprops, "A", 2,
+                                         pool, pool));
+
+      SVN_TEST_ASSERT(iprops->nelts == 1);
+      item = APR_ARRAY_IDX(iprops, 0, svn_prop_inherited_item_t *);
+      SVN_TEST_STRING_ASSERT(item->path_or_url, "");
+      SVN_TEST_ASSERT(apr_hash_count(item->prop_hash) == 1);
+      SVN_TEST_STRING_ASSERT(svn_prop_get_value(item->prop_hash, "p"), "v");
+    }
+
+  return SVN_NO_ERROR;
+}
+
 
 /* Test ra_svn tunnel callbacks. */
 
@@ -630,6 +723,46 @@ get_dir_test(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Test svn_ra_stat_many(). */
+static svn_error_t *
+stat_many_test(const svn_test_opts_t *opts,
+               apr_pool_t *pool)
+{
+  svn_ra_session_t *session;
+  apr_array_header_t *paths = apr_array_make(pool, 4, sizeof(const char *));
+  apr_hash_t *dirents;
+  svn_dirent_t *ent;
+
+  SVN_ERR(make_and_open_repos(&session, "test-stat-many", opts, pool));
+  SVN_ERR(commit_tree(session, pool));
+
+  APR_ARRAY_PUSH(paths, const char *) = "A";
+  APR_ARRAY_PUSH(paths, const char *) = "A/B/f";
+  APR_ARRAY_PUSH(paths, const char *) = "A/missing";
+  APR_ARRAY_PUSH(paths, const char *) = "A/BB/g";
+
+  SVN_ERR(svn_ra_stat_many(session, paths, 1, &dirents, pool));
+  SVN_TEST_INT_ASSERT(apr_hash_count(dirents), 3);
+
+  ent = svn_hash_gets(dirents, "A");
+  SVN_TEST_ASSERT(ent && ent->kind == svn_node_dir);
+  SVN_TEST_INT_ASSERT(ent->created_rev, 1);
+
+  ent = svn_hash_gets(dirents, "A/B/f");
+  SVN_TEST_ASSERT(ent && ent->kind == svn_node_file);
+
+  ent = svn_hash_gets(dirents, "A/BB/g");
+  SVN_TEST_ASSERT(ent && ent->kind == svn_node_file);
+
+  SVN_TEST_ASSERT(svn_hash_gets(dirents, "A/missing") == NULL);
+
+  /* The session must still be usable afterwards. */
+  SVN_ERR(svn_ra_stat(session, "A/B", 1, &ent, pool));
+  SVN_TEST_ASSERT(ent && ent->kind == svn_node_dir);
+
+  return SVN_NO_ERROR;
+}
+
 /* Implements svn_commit_callback2_t for commit_callback_failure() */
 static svn_error_t *
 commit_callback_with_failure(const svn_commit_info_t *info,
@@ -1716,6 +1849,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "verify checkout over a tunnel"),
     SVN_TEST_OPTS_PASS(commit_empty_last_change,
                        "check how last change applies to empty commit"),
+    SVN_TEST_OPTS_PASS(stat_many_test,
+                       "test ra_stat_many"),
+    SVN_TEST_OPTS_PASS(history_cache_test,
+                       "test the history cache"),
     SVN_TEST_NULL
   };
 
@@ -37,7 +37,10 @@
 #include "svn_props.h"
 #include "svn_sorts.h"
 #include "svn_version.h"
+#include "private/svn_cache.h"
+#include "private/svn_fspath.h"
 #include "private/svn_repos_private.h"
+#include "private/svn_sorts_private.h"
 #include "private/svn_dep_compat.h"
 
 /* be able to look into svn_config_t */
@@ -72,7 +75,7 @@ dir_deltas(const svn_test_opts_t *opts,
   svn_repos_t *repos;
   svn_fs_t *fs;
   svn_fs_txn_t *txn;
-  svn_fs_root_t *txn_root, *revision_root;
+  svn_fs_root_t *txn_root, *revision_root, *base_root;
   svn_revnum_t youngest_rev;
   void *edit_baton;
   const svn_delta_editor_t *editor;
@@ -346,7 +349,7 @@ dir_deltas(const svn_test_opts_t *opts,
 
           /* Here's the kicker...do the directory delta. */
           SVN_ERR(svn_fs_revision_root(&revision_root, fs, j, subpool));
-          SVN_ERR(svn_repos_dir_delta2(txn_root,
+          SVN_ERR(svn_repos_dir_delta3(txn_root,
                                        "",
                                        "",
                                        revision_root,
@@ -359,6 +362,7 @@ dir_deltas(const svn_test_opts_t *opts,
                                        svn_depth_infinity,
                                        FALSE,
                                        FALSE,
+                                       1,
                                        subpool));
 
           /* Hopefully at this point our transaction has been modified
@@ -373,6 +377,42 @@ dir_deltas(const svn_test_opts_t *opts,
              bad bad for society). */
           svn_error_clear(svn_fs_abort_txn(txn, subpool));
           svn_pool_clear(subpool);
+
+          /* Do it again, this time comparing revision roots, which
+             allows for comparing nodes on multiple threads. */
+          SVN_ERR(svn_fs_begin_txn(&txn, fs, i, subpool));
+          SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+          SVN_ERR(dir_delta_get_editor(&editor,
+                                       &edit_baton,
+                                       fs,
+                                       txn_root,
+                                       "",
+                                       subpool));
+
+          SVN_ERR(svn_fs_revision_root(&base_root, fs, i, subpool));
+          SVN_ERR(svn_fs_revision_root(&revision_root, fs, j, subpool));
+          SVN_ERR(svn_repos_dir_delta3(base_root,
+                                       "",
+                                       "",
+                                       revision_root,
+                                       "",
+                                       editor,
+                                       edit_baton,
+                                       NULL,
+                                       NULL,
+                                       TRUE,
+                                       svn_depth_infinity,
+                                       FALSE,
+                                       FALSE,
+                                       4,
+                                       subpool));
+
+          SVN_ERR(svn_test__validate_tree
+                  (txn_root, expected_trees[j].entries,
+                   expected_trees[j].num_entries, subpool));
+
+          svn_error_clear(svn_fs_abort_txn(txn, subpool));
+          svn_pool_clear(subpool);
         }
     }
 
@@ -1388,6 +1428,315 @@ authz(apr_pool_t *pool)
 
 
 /* Test in-repo authz paths */
+/* Test that the rules compiled per user and the memoized decisions give
+   consistent results, also with nested groups and aliases and once the
+   memo overflows. */
+static svn_error_t *
+authz_compiled_rules(apr_pool_t *pool)
+{
+  const char *contents;
+  svn_authz_t *authz_cfg;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  struct check_access_tests test_set[] = {
+    /* Group membership through sub-groups and aliases. */
+    { "/trunk", "greek", "alice", svn_authz_write, TRUE },
+    { "/trunk", "greek", "bob", svn_authz_write, TRUE },
+    { "/trunk", "greek", "carol", svn_authz_write, FALSE },
+    { "/trunk", "greek", "carol", svn_authz_read, TRUE },
+    { "/trunk", "greek", NULL, svn_authz_read, FALSE },
+    /* Inverted group rules. */
+    { "/trunk/secret", "greek", "alice", svn_authz_read, TRUE },
+    { "/trunk/secret", "greek", "carol", svn_authz_read, FALSE },
+    { "/trunk", "greek", "carol", svn_authz_read | svn_authz_recursive,
+      FALSE },
+    { "/trunk", "greek", "bob", svn_authz_write | svn_authz_recursive,
+      TRUE },
+    /* Repository-specific rules override global ones. */
+    { "/tags", "greek", "carol", svn_authz_write, TRUE },
+    { "/tags", "other", "carol", svn_authz_write, FALSE },
+    { NULL, "other", "carol", svn_authz_read, TRUE },
+    { NULL, "other", NULL, svn_authz_read, FALSE },
+    /* Sentinel */
+    { NULL, NULL, NULL, svn_authz_none, FALSE }
+  };
+
+  contents =
+    "[aliases]"                                                              NL
+    "a = alice"                                                              NL
+    ""                                                                       NL
+    "[groups]"                                                               NL
+    "devs = &a, @leads"                                                      NL
+    "leads = bob"                                                            NL
+    "staff = @devs, carol"                                                   NL
+    ""                                                                       NL
+    "[/]"                                                                    NL
+    "@staff = r"                                                             NL
+    ""                                                                       NL
+    "[greek:/trunk]"                                                         NL
+    "@devs = rw"                                                             NL
+    ""                                                                       NL
+    "[greek:/trunk/secret]"                                                  NL
+    "~@devs ="                                                               NL
+    ""                                                                       NL
+    "[greek:/tags]"                                                          NL
+    "carol = rw"                                                             NL;
+
+  SVN_ERR(authz_get_handle(&authz_cfg, contents, FALSE, pool));
+
+  /* Ask the same questions repeatedly, so answers come from the memo. */
+  for (i = 0; i < 3; i++)
+    SVN_ERR(authz_check_access(authz_cfg, test_set, pool));
+
+  /* Overflow the memo of a user and make sure the answers stay the same. */
+  for (i = 0; i < 3000; i++)
+    {
+      svn_boolean_t access_granted;
+      const char *path;
+
+      svn_pool_clear(iterpool);
+      path = apr_psprintf(iterpool, "/trunk/secret/file%d", i);
+
+      SVN_ERR(svn_repos_authz_check_access(authz_cfg, "greek", path,
+                                           "carol", svn_authz_read,
+                                           &access_granted, iterpool));
+      if (access_granted)
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "Unexpected read access to '%s'", path);
+
+      SVN_ERR(svn_repos_authz_check_access(authz_cfg, "greek", path,
+                                           "alice", svn_authz_write,
+                                           &access_granted, iterpool));
+      if (!access_granted)
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "Unexpected lack of write access to '%s'",
+                                 path);
+    }
+
+  SVN_ERR(authz_check_access(authz_cfg, test_set, pool));
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+authz_shared_rules(apr_pool_t *pool)
+{
+  const char *contents;
+  const char *authz_file_path;
+  svn_repos__config_pool_t *config_pool1, *config_pool2;
+  svn_repos__authz_pool_t *authz_pool1, *authz_pool2;
+  svn_authz_t *authz1, *authz2;
+  svn_cache__info_t *info;
+  apr_uint64_t hits;
+
+  struct check_access_tests test_set[] = {
+    { "/trunk", "greek", "alice", svn_authz_write, TRUE },
+    { "/trunk", "greek", "carol", svn_authz_write, FALSE },
+    { "/trunk", "greek", "carol", svn_authz_read, TRUE },
+    { "/trunk", "greek", NULL, svn_authz_read, FALSE },
+    { "/trunk", "other", "alice", svn_authz_write, FALSE },
+    { NULL, "greek", "alice", svn_authz_write, TRUE },
+    /* Sentinel */
+    { NULL, NULL, NULL, svn_authz_none, FALSE }
+  };
+
+  if (svn_cache__get_global_membuffer_cache() == NULL)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "Global membuffer cache is disabled");
+
+  contents =
+    "[groups]"                                                               NL
+    "devs = alice"                                                           NL
+    ""                                                                       NL
+    "[/]"                                                                    NL
+    "carol = r"                                                              NL
+    ""                                                                       NL
+    "[greek:/trunk]"                                                         NL
+    "@devs = rw"                                                             NL
+    "carol = r"                                                              NL;
+
+  SVN_ERR(svn_io_write_unique(&authz_file_path, NULL,
+                              contents, strlen(contents),
+                              svn_io_file_del_on_pool_cleanup, pool));
+
+  /* Independent pools, as two server processes would have them. */
+  SVN_ERR(svn_repos__config_pool_create(&config_pool1, FALSE, pool));
+  SVN_ERR(svn_repos__authz_pool_create(&authz_pool1, config_pool1, FALSE,
+                                       pool));
+  SVN_ERR(svn_repos__config_pool_create(&config_pool2, FALSE, pool));
+  SVN_ERR(svn_repos__authz_pool_create(&authz_pool2, config_pool2, FALSE,
+                                       pool));
+
+  SVN_ERR(svn_repos__authz_pool_get(&authz1, authz_pool1, authz_file_path,
+                                    NULL, TRUE, NULL, pool));
+  SVN_ERR(svn_repos__authz_pool_get(&authz2, authz_pool2, authz_file_path,
+                                    NULL, TRUE, NULL, pool));
+  SVN_TEST_ASSERT(authz1 != authz2);
+
+  /* Compile the rules once ... */
+  SVN_ERR(authz_check_access(authz1, test_set, pool));
+
+  /* ... and have the second instance pick them up from the cache. */
+  info = svn_cache__membuffer_get_global_info(pool);
+  hits = info->hits;
+  SVN_ERR(authz_check_access(authz2, test_set, pool));
+  info = svn_cache__membuffer_get_global_info(pool);
+  SVN_TEST_ASSERT(info->hits >= hits + 3);
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for the authz callbacks used by authz_batch. */
+typedef struct batch_authz_baton_t
+{
+  svn_authz_t *authz;
+  int single_calls;
+  int batch_calls;
+} batch_authz_baton_t;
+
+/* Implements svn_repos_authz_func_t for batch_authz_baton_t. */
+static svn_error_t *
+batch_test_read_func(svn_boolean_t *allowed,
+                     svn_fs_root_t *root,
+                     const char *path,
+                     void *baton,
+                     apr_pool_t *pool)
+{
+  batch_authz_baton_t *b = baton;
+
+  ++b->single_calls;
+  return svn_repos_authz_check_access(b->authz, "greek", path, "carol",
+                                      svn_authz_read, allowed, pool);
+}
+
+/* Implements svn_repos__authz_batch_func_t for batch_authz_baton_t. */
+static svn_error_t *
+batch_test_batch_func(svn_boolean_t *allowed,
+                      svn_fs_root_t *root,
+                      const apr_array_header_t *paths,
+                      void *baton,
+                      apr_pool_t *pool)
+{
+  batch_authz_baton_t *b = baton;
+  int i;
+
+  ++b->batch_calls;
+  for (i = 1; i < paths->nelts; ++i)
+    SVN_TEST_ASSERT(svn_path_compare_paths(
+                      APR_ARRAY_IDX(paths, i - 1, const char *),
+                      APR_ARRAY_IDX(paths, i, const char *)) <= 0);
+
+  return svn_repos_authz_check_access_batch(b->authz, "greek", paths,
+                                            "carol", svn_authz_read,
+                                            allowed, pool);
+}
+
+static svn_error_t *
+authz_batch(apr_pool_t *pool)
+{
+  const char *contents;
+  svn_authz_t *authz_cfg;
+  apr_array_header_t *paths;
+  svn_boolean_t *allowed;
+  batch_authz_baton_t baton = { 0 };
+  svn_repos_authz_func_t authz_func;
+  void *authz_baton;
+  int i;
+  apr_size_t j, k;
+
+  static const char *const test_paths[] = {
+    "/trunk/secret/b", "/", "/trunk", "/trunk/secret", "/trunk/a",
+    "/branches/x/secret", "/trunk/secret/deep/er", "/branches", "/tags"
+  };
+  static const svn_repos_authz_access_t required[] = {
+    svn_authz_read, svn_authz_write, svn_authz_read | svn_authz_recursive
+  };
+  static const char *const users[] = { "alice", "carol", NULL };
+
+  contents =
+    "[/]"                                                                    NL
+    "* = r"                                                                  NL
+    ""                                                                       NL
+    "[greek:/trunk]"                                                         NL
+    "carol = rw"                                                             NL
+    ""                                                                       NL
+    "[greek:/trunk/secret]"                                                  NL
+    "carol ="                                                                NL
+    ""                                                                       NL
+    "[greek:/trunk/secret/deep]"                                             NL
+    "carol = r"                                                              NL
+    ""                                                                       NL
+    "[greek:/branches/x]"                                                    NL
+    "alice = rw"                                                             NL;
+
+  SVN_ERR(authz_get_handle(&authz_cfg, contents, FALSE, pool));
+
+  paths = apr_array_make(pool, 16, sizeof(const char *));
+  for (j = 0; j < sizeof(test_paths) / sizeof(test_paths[0]); ++j)
+    APR_ARRAY_PUSH(paths, const char *) = test_paths[j];
+  allowed = apr_palloc(pool, paths->nelts * sizeof(*allowed));
+
+  /* Batched decisions must match the individual ones. */
+  for (k = 0; k < sizeof(users) / sizeof(users[0]); ++k)
+    {
+      apr_size_t r;
+      for (r = 0; r < sizeof(required) / sizeof(required[0]); ++r)
+        {
+          SVN_ERR(svn_repos_authz_check_access_batch(authz_cfg, "greek",
+                                                     paths, users[k],
+                                                     required[r], allowed,
+                                                     pool));
+          for (i = 0; i < paths->nelts; ++i)
+            {
+              svn_boolean_t expected;
+              const char *path = APR_ARRAY_IDX(paths, i, const char *);
+
+              SVN_ERR(svn_repos_authz_check_access(authz_cfg, "greek", path,
+                                                   users[k], required[r],
+                                                   &expected, pool));
+              if (allowed[i] != expected)
+                return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                         "Batched access check for '%s' by "
+                                         "'%s' returned %s",
+                                         path, users[k] ? users[k] : "",
+                                         allowed[i] ? "TRUE" : "FALSE");
+            }
+        }
+    }
+
+  /* Wrapped callbacks use the batch function on sorted paths and return
+     the results in the original order. */
+  baton.authz = authz_cfg;
+  svn_repos__authz_batch_wrap(&authz_func, &authz_baton,
+                              batch_test_read_func, batch_test_batch_func,
+                              &baton, pool);
+  SVN_ERR(svn_repos__authz_read_paths(allowed, NULL, paths, authz_func,
+                                      authz_baton, pool));
+  SVN_TEST_ASSERT(baton.batch_calls == 1 && baton.single_calls == 0);
+
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      svn_boolean_t expected;
+
+      SVN_ERR(authz_func(&expected, NULL,
+                         APR_ARRAY_IDX(paths, i, const char *),
+                         authz_baton, pool));
+      SVN_TEST_ASSERT(allowed[i] == expected);
+    }
+  SVN_TEST_ASSERT(baton.single_calls == paths->nelts);
+
+  /* Plain callbacks get called once per path. */
+  baton.single_calls = 0;
+  SVN_ERR(svn_repos__authz_read_paths(allowed, NULL, paths,
+                                      batch_test_read_func, &baton, pool));
+  SVN_TEST_ASSERT(baton.batch_calls == 1
+                  && baton.single_calls == paths->nelts);
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 in_repo_authz(const svn_test_opts_t *opts,
                                  apr_pool_t *pool)
@@ -2325,7 +2674,8 @@ nls_receiver(svn_location_segment_t *segment,
 /* Run a svn_repos_node_location_segments() query with REPOS, PATH, PEG_REV,
  * START_REV, END_REV.  Check that the result exactly matches the list of
  * segments EXPECTED_SEGMENTS, which is terminated by an entry with
- * 'range_end'==0.
+ * 'range_end'==0.  If USE_CACHE is set, run the query through the
+ * location segments cache instead.
  */
 static svn_error_t *
 check_location_segments(svn_repos_t *repos,
@@ -2334,6 +2684,7 @@ check_location_segments(svn_repos_t *repos,
                         svn_revnum_t start_rev,
                         svn_revnum_t end_rev,
                         const svn_location_segment_t *expected_segments,
+                        svn_boolean_t use_cache,
                         apr_pool_t *pool)
 {
   struct nls_receiver_baton b;
@@ -2343,9 +2694,16 @@ check_location_segments(svn_repos_t *repos,
      validates against EXPECTED_SEGMENTS.  */
   b.count = 0;
   b.expected_segments = expected_segments;
-  SVN_ERR(svn_repos_node_location_segments(repos, path, peg_rev,
-                                           start_rev, end_rev, nls_receiver,
-                                           &b, NULL, NULL, pool));
+  if (use_cache)
+    SVN_ERR(svn_repos__node_location_segments_cached(repos, path, peg_rev,
+                                                     start_rev, end_rev,
+                                                     nls_receiver, &b,
+                                                     NULL, NULL, pool));
+  else
+    SVN_ERR(svn_repos_node_location_segments(repos, path, peg_rev,
+                                             start_rev, end_rev,
+                                             nls_receiver, &b,
+                                             NULL, NULL, pool));
 
   /* Make sure we saw all of our expected segments.  (If the
      'range_end' member of our expected_segments is 0, it's our
@@ -2451,6 +2809,7 @@ node_location_segments(const svn_test_opts_t *opts,
     },
   };
   const location_segment_test_t *subtest;
+  int i;
 
   /* Bail (with success) on known-untestable scenarios */
   if ((strcmp(opts->fs_type, "bdb") == 0)
@@ -2531,9 +2890,19 @@ node_location_segments(const svn_test_opts_t *opts,
     {
       SVN_ERR(check_location_segments(repos, subtest->path, subtest->peg,
                                       subtest->start, subtest->end,
-                                      subtest->segments, pool));
+                                      subtest->segments, FALSE, pool));
     }
 
+  /* The location segments cache must not make a difference, neither
+     while being filled nor when being read. */
+  for (i = 0; i < 2; i++)
+    for (subtest = subtests; subtest->path; subtest++)
+      {
+        SVN_ERR(check_location_segments(repos, subtest->path, subtest->peg,
+                                        subtest->start, subtest->end,
+                                        subtest->segments, TRUE, pool));
+      }
+
   return SVN_NO_ERROR;
 }
 
@@ -2733,6 +3102,209 @@ reporter_depth_exclude(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Test that the reporter handles reports whose source directories are
+   the same node-revs as the target, i.e. where only the reported paths
+   may need any update. */
+static svn_error_t *
+reporter_unchanged_subtrees(const svn_test_opts_t *opts,
+                            apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  apr_pool_t *subpool = svn_pool_create(pool);
+  svn_revnum_t youngest_rev;
+  const svn_delta_editor_t *editor;
+  void *edit_baton, *report_baton;
+
+  SVN_ERR(svn_test__create_repos(&repos,
+                                 "test-repo-reporter-unchanged-subtrees",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* Revision 1: the greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+  svn_pool_clear(subpool);
+
+  /* Revision 2: change a file deep down in the tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/D/G/pi",
+                                      "Changed file 'pi'.\n", subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+  svn_pool_clear(subpool);
+
+  /* Build a "working copy" at r2 with A/D/G/pi still at r1 and iota
+     missing. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 2, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/D/G/pi",
+                                      "This is the file 'pi'.\n", subpool));
+  SVN_ERR(svn_fs_delete(txn_root, "iota", subpool));
+  SVN_ERR(dir_delta_get_editor(&editor, &edit_baton, fs,
+                               txn_root, "", subpool));
+
+  /* Update it to r2.  All directories are reported at their target
+     node-revs, so only the reported paths must be sent. */
+  SVN_ERR(svn_repos_begin_report3(&report_baton, 2, repos, "/", "", NULL,
+                                  TRUE, svn_depth_infinity, FALSE, FALSE,
+                                  editor, edit_baton, NULL, NULL, 0,
+                                  subpool));
+  SVN_ERR(svn_repos_set_path3(report_baton, "", 2,
+                              svn_depth_infinity,
+                              FALSE, NULL, subpool));
+  SVN_ERR(svn_repos_set_path3(report_baton, "A/D/G/pi", 1,
+                              svn_depth_infinity,
+                              FALSE, NULL, subpool));
+  SVN_ERR(svn_repos_delete_path(report_baton, "iota", subpool));
+  SVN_ERR(svn_repos_finish_report(report_baton, subpool));
+
+  /* The txn must now match r2. */
+  {
+    static svn_test__tree_entry_t entries[] = {
+      { "iota",        "This is the file 'iota'.\n" },
+      { "A",           0 },
+      { "A/mu",        "This is the file 'mu'.\n" },
+      { "A/B",         0 },
+      { "A/B/lambda",  "This is the file 'lambda'.\n" },
+      { "A/B/E",       0 },
+      { "A/B/E/alpha", "This is the file 'alpha'.\n" },
+      { "A/B/E/beta",  "This is the file 'beta'.\n" },
+      { "A/B/F",       0 },
+      { "A/C",         0 },
+      { "A/D",         0 },
+      { "A/D/gamma",   "This is the file 'gamma'.\n" },
+      { "A/D/G",       0 },
+      { "A/D/G/pi",    "Changed file 'pi'.\n" },
+      { "A/D/G/rho",   "This is the file 'rho'.\n" },
+      { "A/D/G/tau",   "This is the file 'tau'.\n" },
+      { "A/D/H",       0 },
+      { "A/D/H/chi",   "This is the file 'chi'.\n" },
+      { "A/D/H/psi",   "This is the file 'psi'.\n" },
+      { "A/D/H/omega", "This is the file 'omega'.\n" }
+    };
+    SVN_ERR(svn_test__validate_tree(txn_root,
+                                    entries,
+                                    sizeof(entries)/sizeof(entries[0]),
+                                    subpool));
+  }
+
+  svn_error_clear(svn_fs_abort_txn(txn, subpool));
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Test that computing text deltas ahead gives the same results as
+   computing them on demand. */
+static svn_error_t *
+reporter_prefetch_deltas(const svn_test_opts_t *opts,
+                         apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  apr_pool_t *subpool = svn_pool_create(pool);
+  svn_revnum_t youngest_rev;
+  svn_revnum_t base_rev;
+  const svn_delta_editor_t *editor;
+  void *edit_baton, *report_baton;
+  int i, fulltexts;
+
+  static svn_test__tree_entry_t entries[] = {
+    { "iota",        "Changed file 'iota'.\n" },
+    { "A",           0 },
+    { "A/mu",        "This is the file 'mu'.\n" },
+    { "A/B",         0 },
+    { "A/B/lambda",  "This is the file 'lambda'.\n" },
+    { "A/B/E",       0 },
+    { "A/B/E/alpha", "Changed file 'alpha'.\n" },
+    { "A/B/E/beta",  "This is the file 'beta'.\n" },
+    { "A/B/F",       0 },
+    { "A/C",         0 },
+    { "A/D",         0 },
+    { "A/D/gamma",   "This is the file 'gamma'.\n" },
+    { "A/D/G",       0 },
+    { "A/D/G/pi",    "Changed file 'pi'.\n" },
+    { "A/D/G/rho",   "Changed file 'rho'.\n" },
+    { "A/D/G/tau",   "This is the file 'tau'.\n" },
+    { "A/D/H",       0 },
+    { "A/D/H/chi",   "This is the file 'chi'.\n" },
+    { "A/D/H/psi",   "This is the file 'psi'.\n" },
+    { "A/D/H/omega", "This is the file 'omega'.\n" }
+  };
+
+  SVN_ERR(svn_test__create_repos(&repos,
+                                 "test-repo-reporter-prefetch-deltas",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* Revision 1: the greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+  svn_pool_clear(subpool);
+
+  /* Revision 2: change several files, some of them in the same dir. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota",
+                                      "Changed file 'iota'.\n", subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/B/E/alpha",
+                                      "Changed file 'alpha'.\n", subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/D/G/pi",
+                                      "Changed file 'pi'.\n", subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/D/G/rho",
+                                      "Changed file 'rho'.\n", subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+  svn_pool_clear(subpool);
+
+  /* Check out r2 and update r1 to r2 with different look-ahead limits,
+     with and without sending fulltexts.  The result must always match r2. */
+  for (i = 0; i < 3; ++i)
+    for (base_rev = 0; base_rev <= 1; ++base_rev)
+      for (fulltexts = 0; fulltexts <= 1; ++fulltexts)
+      {
+        SVN_ERR(svn_fs_begin_txn(&txn, fs, base_rev, subpool));
+        SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+        SVN_ERR(dir_delta_get_editor(&editor, &edit_baton, fs,
+                                     txn_root, "", subpool));
+
+        SVN_ERR(svn_repos_begin_report3(&report_baton, 2, repos, "/", "",
+                                        NULL, TRUE, svn_depth_infinity,
+                                        FALSE, FALSE, editor, edit_baton,
+                                        NULL, NULL, 0, subpool));
+        svn_repos__report_prefetch_deltas(report_baton, i * 2);
+        svn_repos__report_send_fulltexts(report_baton, fulltexts);
+        SVN_ERR(svn_repos_set_path3(report_baton, "", base_rev,
+                                    svn_depth_infinity, base_rev == 0,
+                                    NULL, subpool));
+        SVN_ERR(svn_repos_finish_report(report_baton, subpool));
+
+        SVN_ERR(svn_test__validate_tree(txn_root,
+                                        entries,
+                                        sizeof(entries)/sizeof(entries[0]),
+                                        subpool));
+
+        svn_error_clear(svn_fs_abort_txn(txn, subpool));
+        svn_pool_clear(subpool);
+      }
+
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
 
 
 /* Test if prop values received by the server are validated.
@@ -3923,10 +4495,411 @@ test_list(const svn_test_opts_t *opts,
   APR_ARRAY_PUSH(patterns, const char *) = "*a*";
   SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, pool));
   SVN_ERR(svn_repos_list(rev_root, "/A", patterns, svn_depth_infinity, FALSE,
-                         NULL, NULL, list_callback, &counter, NULL, NULL,
-                         pool));
+                         1, FALSE, NULL, NULL, list_callback, &counter,
+                         NULL, NULL, pool));
   SVN_TEST_ASSERT(counter == 6);
 
+  /* A '/' in a bracket expression doesn't rule out any name. */
+  counter = 0;
+  APR_ARRAY_IDX(patterns, 0, const char *) = "*[/a]*";
+  SVN_ERR(svn_repos_list(rev_root, "/A", patterns, svn_depth_infinity, FALSE,
+                         1, FALSE, NULL, NULL, list_callback, &counter,
+                         NULL, NULL, pool));
+  SVN_TEST_ASSERT(counter == 6);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos_dirent_receiver_t.  Append a copy of PATH to the
+   array of const char * in BATON. */
+static svn_error_t *
+list_collect_callback(const char *path,
+                      svn_dirent_t *dirent,
+                      void *baton,
+                      apr_pool_t *pool)
+{
+  apr_array_header_t *paths = baton;
+
+  APR_ARRAY_PUSH(paths, const char *) = apr_pstrdup(paths->pool, path);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos_authz_func_t.  Deny access to "/A/D/G". */
+static svn_error_t *
+list_authz_func(svn_boolean_t *allowed,
+                svn_fs_root_t *root,
+                const char *path,
+                void *baton,
+                apr_pool_t *pool)
+{
+  *allowed = strcmp(path, "/A/D/G") != 0;
+  return SVN_NO_ERROR;
+}
+
+/* Return the PATHS, an array of const char *, as a single string. */
+static const char *
+join_paths(apr_array_header_t *paths,
+           apr_pool_t *pool)
+{
+  return svn_cstring_join(paths, " ", pool);
+}
+
+static svn_error_t *
+test_list_parallel(const svn_test_opts_t *opts,
+                   apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t youngest_rev;
+  apr_array_header_t *patterns;
+  apr_array_header_t *expected, *actual;
+  int i, k;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-list-parallel", opts,
+                                 pool));
+  fs = svn_repos_fs(repos);
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, pool));
+
+  patterns = apr_array_make(pool, 0, sizeof(const char *));
+
+  /* The serial listing is our reference. */
+  expected = apr_array_make(pool, 0, sizeof(const char *));
+  SVN_ERR(svn_repos_list(rev_root, "/", patterns, svn_depth_infinity, FALSE,
+                         1, FALSE, list_authz_func, NULL,
+                         list_collect_callback, expected, NULL, NULL, pool));
+  SVN_TEST_ASSERT(expected->nelts == 17);
+
+  /* Parallel, ordered listings must produce the same sequence. */
+  actual = apr_array_make(pool, 0, sizeof(const char *));
+  SVN_ERR(svn_repos_list(rev_root, "/", patterns, svn_depth_infinity, FALSE,
+                         4, FALSE, list_authz_func, NULL,
+                         list_collect_callback, actual, NULL, NULL, pool));
+  SVN_TEST_STRING_ASSERT(join_paths(actual, pool),
+                         join_paths(expected, pool));
+
+  /* Unordered listings produce the same set, parents before children. */
+  actual = apr_array_make(pool, 0, sizeof(const char *));
+  SVN_ERR(svn_repos_list(rev_root, "/", patterns, svn_depth_infinity, TRUE,
+                         4, TRUE, list_authz_func, NULL,
+                         list_collect_callback, actual, NULL, NULL, pool));
+  SVN_TEST_ASSERT(actual->nelts == expected->nelts);
+  for (i = 0; i < actual->nelts; ++i)
+    {
+      const char *path = APR_ARRAY_IDX(actual, i, const char *);
+      const char *parent = svn_fspath__dirname(path, pool);
+
+      for (k = 0; k < i; ++k)
+        if (strcmp(APR_ARRAY_IDX(actual, k, const char *), parent) == 0)
+          break;
+
+      SVN_TEST_ASSERT(k < i || strcmp(path, "/") == 0);
+    }
+
+  svn_sort__array(actual, svn_sort_compare_paths);
+  svn_sort__array(expected, svn_sort_compare_paths);
+  SVN_TEST_STRING_ASSERT(join_paths(actual, pool),
+                         join_paths(expected, pool));
+
+  /* Patterns containing a '/' never match any entry. */
+  APR_ARRAY_PUSH(patterns, const char *) = "A/*";
+  actual = apr_array_make(pool, 0, sizeof(const char *));
+  SVN_ERR(svn_repos_list(rev_root, "/A", patterns, svn_depth_infinity, TRUE,
+                         4, FALSE, NULL, NULL,
+                         list_collect_callback, actual, NULL, NULL, pool));
+  SVN_TEST_ASSERT(actual->nelts == 0);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos_authz_func_t.  Deny access to the relpath BATON
+   and everything below it; allow everything, if BATON is NULL. */
+static svn_error_t *
+replay_cache_authz_func(svn_boolean_t *allowed,
+                        svn_fs_root_t *root,
+                        const char *path,
+                        void *baton,
+                        apr_pool_t *pool)
+{
+  const char *denied = baton;
+
+  if (path[0] == '/')
+    path++;
+
+  *allowed = !denied || !svn_relpath_skip_ancestor(denied, path);
+  return SVN_NO_ERROR;
+}
+
+/* Replay revision REV of REPOS through the replay cache into a txn
+   based on REV - 1, using AUTHZ_BATON for replay_cache_authz_func, and
+   compare the result with the NUM_ENTRIES ENTRIES. */
+static svn_error_t *
+check_cached_replay(svn_repos_t *repos,
+                    svn_revnum_t rev,
+                    const char *authz_baton,
+                    svn_test__tree_entry_t *entries,
+                    int num_entries,
+                    apr_pool_t *pool)
+{
+  svn_fs_t *fs = svn_repos_fs(repos);
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  const svn_delta_editor_t *editor;
+  void *edit_baton;
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev - 1, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, rev, pool));
+  SVN_ERR(dir_delta_get_editor(&editor, &edit_baton, fs,
+                               txn_root, "", pool));
+
+  SVN_ERR(svn_repos__replay_cached(repos, rev_root, "", SVN_INVALID_REVNUM,
+                                   TRUE, editor, edit_baton,
+                                   replay_cache_authz_func,
+                                   (void *)authz_baton, pool));
+  SVN_ERR(svn_test__validate_tree(txn_root, entries, num_entries, pool));
+
+  return svn_error_trace(svn_fs_abort_txn(txn, pool));
+}
+
+static svn_error_t *
+replay_cache(const svn_test_opts_t *opts,
+             apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t youngest_rev;
+  svn_node_kind_t kind;
+  const char *cache_file;
+  int i;
+
+  /* The r2 tree, i.e. the result of any full replay of r2. */
+  svn_test__tree_entry_t entries[] = {
+    { "iota",        "Changed file 'iota'.\n" },
+    { "A",           0 },
+    { "A/mu",        "This is the file 'mu'.\n" },
+    { "A/new",       "New file 'new'.\n" },
+    { "A/B",         0 },
+    { "A/B/lambda",  "This is the file 'lambda'.\n" },
+    { "A/B/E",       0 },
+    { "A/B/E/alpha", "This is the file 'alpha'.\n" },
+    { "A/B/E/beta",  "This is the file 'beta'.\n" },
+    { "A/B/F",       0 },
+    { "A/C",         0 },
+    { "A/D",         0 },
+    { "A/D/gamma",   "This is the file 'gamma'.\n" },
+    { "A/D/G",       0 },
+    { "A/D/G/pi",    "This is the file 'pi'.\n" },
+    { "A/D/G/rho",   "This is the file 'rho'.\n" },
+    { "A/D/G/tau",   "This is the file 'tau'.\n" },
+    { "A/G2",        0 },
+    { "A/G2/pi",     "This is the file 'pi'.\n" },
+    { "A/G2/rho",    "This is the file 'rho'.\n" },
+    { "A/G2/tau",    "This is the file 'tau'.\n" },
+    /* A/D/H and its children, only present if its deletion is hidden. */
+    { "A/D/H",       0 },
+    { "A/D/H/chi",   "This is the file 'chi'.\n" },
+    { "A/D/H/psi",   "This is the file 'psi'.\n" },
+    { "A/D/H/omega", "This is the file 'omega'.\n" }
+  };
+  const int num_r2_entries = sizeof(entries) / sizeof(entries[0]) - 4;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-replay-cache",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* Revision 1: the greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+
+  /* Revision 2: text and property changes, a copy, an add and a
+     deletion. */
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota",
+                                      "Changed file 'iota'.\n", pool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "A/B", "prop",
+                                  svn_string_create("value", pool), pool));
+  SVN_ERR(svn_fs_copy(rev_root, "A/D/G", txn_root, "A/G2", pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "A/new", pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/new",
+                                      "New file 'new'.\n", pool));
+  SVN_ERR(svn_fs_delete(txn_root, "A/D/H", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+
+  /* The first replay records the revision, the second one plays the
+     recording back. */
+  cache_file = svn_dirent_join_many(pool, svn_repos_path(repos, pool),
+                                    "replay-cache", "0", "2.d", SVN_VA_NULL);
+  for (i = 0; i < 2; ++i)
+    {
+      SVN_ERR(check_cached_replay(repos, youngest_rev, NULL,
+                                  entries, num_r2_entries, pool));
+      SVN_ERR(svn_io_check_path(cache_file, &kind, pool));
+      SVN_TEST_ASSERT(kind == svn_node_file);
+    }
+
+  /* Paths that the user cannot read don't get played back. */
+  SVN_ERR(check_cached_replay(repos, youngest_rev, "A/D/H",
+                              entries, sizeof(entries) / sizeof(entries[0]),
+                              pool));
+
+  /* A broken cache file gets replaced. */
+  SVN_ERR(svn_io_file_create(cache_file, "broken", pool));
+  SVN_ERR(check_cached_replay(repos, youngest_rev, NULL,
+                              entries, num_r2_entries, pool));
+  SVN_ERR(check_cached_replay(repos, youngest_rev, NULL,
+                              entries, num_r2_entries, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos_blame_receiver_t, appending "START:REVISION " to
+   the svn_stringbuf_t BATON. */
+static svn_error_t *
+blame_test_receiver(void *baton,
+                    apr_int64_t start_line,
+                    svn_revnum_t revision,
+                    apr_hash_t *rev_props,
+                    apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *result = baton;
+
+  /* Revisions in range come with their author. */
+  SVN_TEST_ASSERT(!SVN_IS_VALID_REVNUM(revision)
+                  || svn_hash_gets(rev_props, SVN_PROP_REVISION_AUTHOR));
+  svn_stringbuf_appendcstr(result,
+                           apr_psprintf(scratch_pool, "%d:%ld ",
+                                        (int)start_line, revision));
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos_authz_func_t, denying access to anything in the
+   revision pointed to by BATON. */
+static svn_error_t *
+blame_test_authz_func(svn_boolean_t *allowed,
+                      svn_fs_root_t *root,
+                      const char *path,
+                      void *baton,
+                      apr_pool_t *pool)
+{
+  const svn_revnum_t *denied_rev = baton;
+
+  *allowed = (svn_fs_revision_root_revision(root) != *denied_rev);
+  return SVN_NO_ERROR;
+}
+
+/* Blame PATH in REPOS from START to END, optionally using AUTHZ_BATON for
+   blame_test_authz_func, and compare the result with EXPECTED. */
+static svn_error_t *
+check_blame(svn_repos_t *repos,
+            const char *path,
+            svn_revnum_t start,
+            svn_revnum_t end,
+            svn_revnum_t *authz_baton,
+            const char *expected,
+            apr_pool_t *pool)
+{
+  svn_stringbuf_t *result = svn_stringbuf_create_empty(pool);
+
+  SVN_ERR(svn_repos_blame(repos, path, start, end, NULL,
+                          authz_baton ? blame_test_authz_func : NULL,
+                          authz_baton, blame_test_receiver, result,
+                          NULL, NULL, pool));
+  SVN_TEST_STRING_ASSERT(result->data, expected);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_blame(const svn_test_opts_t *opts,
+           apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev;
+  svn_revnum_t denied_rev = 1;
+  int i;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-blame", opts, pool));
+
+  /* r1: the greek tree. */
+  SVN_ERR(svn_repos_fs_begin_txn_for_commit(&txn, repos, 0, "jrandom",
+                                            NULL, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r2: add two lines to iota. */
+  SVN_ERR(svn_repos_fs_begin_txn_for_commit(&txn, repos, youngest_rev,
+                                            "jrandom", NULL, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota",
+                                      "This is the file 'iota'.\n"
+                                      "line 2\n"
+                                      "line 3\n", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r3: a property change only. */
+  SVN_ERR(svn_repos_fs_begin_txn_for_commit(&txn, repos, youngest_rev,
+                                            "jrandom", NULL, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "iota", "prop",
+                                  svn_string_create("value", pool), pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r4: change the middle line. */
+  SVN_ERR(svn_repos_fs_begin_txn_for_commit(&txn, repos, youngest_rev,
+                                            "jrandom", NULL, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota",
+                                      "This is the file 'iota'.\n"
+                                      "line 2 changed\n"
+                                      "line 3\n", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_TEST_ASSERT(youngest_rev == 4);
+
+  /* The second round gets the results from the cache. */
+  for (i = 0; i < 2; ++i)
+    {
+      SVN_ERR(check_blame(repos, "/iota", 0, 4, NULL,
+                          "0:1 1:4 2:2 ", pool));
+      SVN_ERR(check_blame(repos, "/iota", SVN_INVALID_REVNUM,
+                          SVN_INVALID_REVNUM, NULL, "0:1 1:4 2:2 ", pool));
+      SVN_ERR(check_blame(repos, "/iota", 0, 2, NULL, "0:1 1:2 ", pool));
+      SVN_ERR(check_blame(repos, "/iota", 3, 4, NULL,
+                          "0:-1 1:4 2:-1 ", pool));
+    }
+
+  /* Users who can't see r1 see iota being added in r2 - cached or not. */
+  SVN_ERR(check_blame(repos, "/iota", 0, 4, &denied_rev,
+                      "0:2 1:4 2:2 ", pool));
+
+  /* Without access to the last change, there is nothing to blame. */
+  denied_rev = 4;
+  SVN_TEST_ASSERT_ERROR(check_blame(repos, "/iota", 0, 4, &denied_rev,
+                                    "", pool),
+                        SVN_ERR_AUTHZ_UNREADABLE);
+
+  /* Directories can't be blamed. */
+  SVN_TEST_ASSERT_ERROR(check_blame(repos, "/A", 0, 4, NULL, "", pool),
+                        SVN_ERR_FS_NOT_FILE);
+
   return SVN_NO_ERROR;
 }
 
@@ -3938,7 +4911,7 @@ static struct svn_test_descriptor_t test_funcs[] =
   {
     SVN_TEST_NULL,
     SVN_TEST_OPTS_PASS(dir_deltas,
-                       "test svn_repos_dir_delta2"),
+                       "test svn_repos_dir_delta3"),
     SVN_TEST_OPTS_PASS(node_tree_delete_under_copy,
                        "test deletions under copies in node_tree code"),
     SVN_TEST_OPTS_PASS(revisions_changed,
@@ -3951,6 +4924,12 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test removal of defunct locks"),
     SVN_TEST_PASS2(authz,
                    "test authz access control"),
+    SVN_TEST_PASS2(authz_compiled_rules,
+                   "test authz rules compiled per user"),
+    SVN_TEST_PASS2(authz_shared_rules,
+                   "test authz rules shared between authz pools"),
+    SVN_TEST_PASS2(authz_batch,
+                   "test batched authz checks"),
     SVN_TEST_OPTS_PASS(in_repo_authz,
                        "test authz stored in the repo"),
     SVN_TEST_OPTS_PASS(in_repo_groups_authz,
@@ -3965,6 +4944,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test svn_repos_node_location_segments"),
     SVN_TEST_OPTS_PASS(reporter_depth_exclude,
                        "test reporter and svn_depth_exclude"),
+    SVN_TEST_OPTS_PASS(reporter_unchanged_subtrees,
+                       "test reporter on unchanged subtrees"),
     SVN_TEST_OPTS_PASS(prop_validation,
                        "test if revprops are validated by repos"),
     SVN_TEST_OPTS_PASS(get_logs,
@@ -3991,6 +4972,14 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test committing a previously aborted txn"),
     SVN_TEST_OPTS_PASS(test_list,
                        "test svn_repos_list"),
+    SVN_TEST_OPTS_PASS(replay_cache,
+                       "test svn_repos__replay_cached"),
+    SVN_TEST_OPTS_PASS(test_blame,
+                       "test svn_repos_blame"),
+    SVN_TEST_OPTS_PASS(test_list_parallel,
+                       "test parallel svn_repos_list"),
+    SVN_TEST_OPTS_PASS(reporter_prefetch_deltas,
+                       "test reporter computing deltas ahead"),
     SVN_TEST_NULL
   };
 
@@ -26,7 +26,10 @@
 #include <apr_general.h>
 #include <apr_lib.h>
 #include <apr_time.h>
+#include <apr_thread_proc.h>
 
+#include "svn_dirent_uri.h"
+#include "svn_io.h"
 #include "svn_pools.h"
 
 #include "private/svn_cache.h"
@@ -156,6 +159,33 @@ basic_cache_test(svn_cache__t *cache,
   return SVN_NO_ERROR;
 }
 
+/* Exercise svn_cache__get_multi and svn_cache__set_multi on CACHE, which
+ * must be able to hold at least two entries. */
+static svn_error_t *
+multi_cache_test(svn_cache__t *cache,
+                 apr_pool_t *pool)
+{
+  svn_revnum_t twenty = 20, thirty = 30;
+  const void *set_keys[3] = { "twenty", NULL, "thirty" };
+  void *set_values[3] = { &twenty, NULL, &thirty };
+  const void *get_keys[4] = { "thirty", "forty", NULL, "twenty" };
+  void *values[4];
+  svn_boolean_t found[4];
+
+  SVN_ERR(svn_cache__get_multi(values, found, cache, get_keys, 4, pool));
+  SVN_TEST_ASSERT(!found[0] && !found[1] && !found[2] && !found[3]);
+
+  SVN_ERR(svn_cache__set_multi(cache, set_keys, set_values, 3, pool));
+
+  SVN_ERR(svn_cache__get_multi(values, found, cache, get_keys, 4, pool));
+  SVN_TEST_ASSERT(found[0] && !found[1] && !found[2] && found[3]);
+  SVN_TEST_ASSERT(*(svn_revnum_t *)values[0] == 30);
+  SVN_TEST_ASSERT(values[1] == NULL && values[2] == NULL);
+  SVN_TEST_ASSERT(*(svn_revnum_t *)values[3] == 20);
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 test_inprocess_cache_basic(apr_pool_t *pool)
 {
@@ -203,6 +233,54 @@ test_memcache_basic(const svn_test_opts_t *opts,
   return basic_cache_test(cache, FALSE, pool);
 }
 
+static svn_error_t *
+test_memcache_multi(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+  svn_memcache_t *memcache = NULL;
+  const char *prefix = apr_psprintf(pool,
+                                    "test_memcache_multi-%" APR_TIME_T_FMT,
+                                    apr_time_now());
+
+  SVN_ERR(create_memcache(&memcache, opts, pool, pool));
+  if (! memcache)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "not configured to use memcached");
+
+  SVN_ERR(svn_cache__create_memcache(&cache,
+                                    memcache,
+                                    serialize_revnum,
+                                    deserialize_revnum,
+                                    APR_HASH_KEY_STRING,
+                                    prefix,
+                                    pool));
+
+  return multi_cache_test(cache, pool);
+}
+
+static svn_error_t *
+test_membuffer_cache_multi(apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+  svn_membuffer_t *membuffer;
+
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
+                                            TRUE, TRUE, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache,
+                                            membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            APR_HASH_KEY_STRING,
+                                            "cache:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE,
+                                            FALSE,
+                                            pool, pool));
+
+  return multi_cache_test(cache, pool);
+}
+
 static svn_error_t *
 test_membuffer_cache_basic(apr_pool_t *pool)
 {
@@ -590,7 +668,623 @@ test_membuffer_unaligned_fixed_keys(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Create a cache for revnums in MEMBUFFER, using either fixed-size keys
+ * (shared key prefix) or string keys (full keys), depending on
+ * FIXED_KEYS.  Return it in *CACHE_P, allocated in POOL. */
+static svn_error_t *
+create_snapshot_test_cache(svn_cache__t **cache_p,
+                           svn_membuffer_t *membuffer,
+                           svn_boolean_t fixed_keys,
+                           apr_pool_t *pool)
+{
+  SVN_ERR(svn_cache__create_membuffer_cache(
+            cache_p, membuffer, serialize_revnum, deserialize_revnum,
+            fixed_keys ? 8 : APR_HASH_KEY_STRING,
+            fixed_keys ? "fixed:" : "string:",
+            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY, FALSE, FALSE,
+            pool, pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_membuffer_snapshot(apr_pool_t *pool)
+{
+  svn_membuffer_t *membuffer;
+  svn_cache__t *fixed_cache, *string_cache;
+  svn_revnum_t valueA = 12345;
+  svn_revnum_t valueB = 67890;
+  svn_revnum_t *value;
+  svn_boolean_t found;
+  const char *sandbox;
+  const char *path;
+
+  SVN_ERR(svn_test_make_sandbox_dir(&sandbox, "cache-snapshot", pool));
+  path = svn_dirent_join(sandbox, "snapshot", pool);
+
+  /* Loading a non-existent snapshot is not an error. */
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
+                                            TRUE, TRUE, pool));
+  SVN_ERR(svn_cache__membuffer_load(membuffer, path, pool));
+
+  /* Populate a cache and write a snapshot of it. */
+  SVN_ERR(create_snapshot_test_cache(&fixed_cache, membuffer, TRUE, pool));
+  SVN_ERR(create_snapshot_test_cache(&string_cache, membuffer, FALSE, pool));
+  SVN_ERR(svn_cache__set(fixed_cache, "12345678", &valueA, pool));
+  SVN_ERR(svn_cache__set(string_cache, "key B", &valueB, pool));
+  SVN_ERR(svn_cache__membuffer_save(membuffer, path, pool));
+
+  /* A fresh cache will have the same contents after loading it. */
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
+                                            TRUE, TRUE, pool));
+  SVN_ERR(create_snapshot_test_cache(&fixed_cache, membuffer, TRUE, pool));
+  SVN_ERR(create_snapshot_test_cache(&string_cache, membuffer, FALSE, pool));
+
+  SVN_ERR(svn_cache__get((void **) &value, &found, fixed_cache, "12345678",
+                         pool));
+  SVN_TEST_ASSERT(!found);
+
+  SVN_ERR(svn_cache__membuffer_load(membuffer, path, pool));
+
+  SVN_ERR(svn_cache__get((void **) &value, &found, fixed_cache, "12345678",
+                         pool));
+  SVN_TEST_ASSERT(found);
+  SVN_TEST_ASSERT(*value == valueA);
+  SVN_ERR(svn_cache__get((void **) &value, &found, string_cache, "key B",
+                         pool));
+  SVN_TEST_ASSERT(found);
+  SVN_TEST_ASSERT(*value == valueB);
+
+  /* Keys are not mixed up between caches. */
+  SVN_ERR(svn_cache__get((void **) &value, &found, string_cache, "12345678",
+                         pool));
+  SVN_TEST_ASSERT(!found);
+
+  return SVN_NO_ERROR;
+}
+
+/* Parameters of the simulated access pattern used by
+ * test_membuffer_admission_filter. */
+#define HOT_KEY_COUNT 40
+#define SCAN_KEYS_PER_ROUND 100
+#define ADMISSION_TEST_ROUNDS 20
+
+/* Look up KEY in CACHE and put VALUE there if it is not cached, yet.
+ * Increment *HITS upon cache hits.  Use POOL for temporary allocations. */
+static svn_error_t *
+get_or_set(svn_cache__t *cache,
+           const char *key,
+           svn_stringbuf_t *value,
+           apr_uint64_t *hits,
+           apr_pool_t *pool)
+{
+  svn_stringbuf_t *cached;
+  svn_boolean_t found;
+
+  SVN_ERR(svn_cache__get((void **) &cached, &found, cache, key, pool));
+  if (found)
+    ++*hits;
+  else
+    SVN_ERR(svn_cache__set(cache, key, value, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Simulate a small, frequently used working set being accessed while a
+ * scan runs over lots of data that is never accessed again.  Use a small
+ * membuffer cache with the admission filter being enabled or disabled,
+ * depending on USE_FILTER.  Return the hit rate in percent for the
+ * working set in *HIT_RATE.  Use POOL for allocations. */
+static svn_error_t *
+run_scan_simulation(double *hit_rate,
+                    svn_boolean_t use_filter,
+                    apr_pool_t *pool)
+{
+  svn_membuffer_t *membuffer;
+  svn_cache__t *cache;
+  svn_stringbuf_t *value = svn_stringbuf_create_empty(pool);
+  apr_uint64_t hits = 0;
+  apr_uint64_t scan_hits = 0;
+  apr_uint64_t lookups = 0;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int round, i;
+
+  svn_stringbuf_appendfill(value, 'x', 1000);
+
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 128 * 1024,
+                                            16 * 1024, 1, FALSE, TRUE,
+                                            pool));
+  if (use_filter)
+    SVN_ERR(svn_cache__membuffer_enable_admission_filter(membuffer, pool));
+
+  SVN_ERR(svn_cache__create_membuffer_cache(
+            &cache, membuffer, NULL, NULL, APR_HASH_KEY_STRING, "scan:",
+            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY, FALSE, FALSE,
+            pool, pool));
+
+  for (round = 0; round < ADMISSION_TEST_ROUNDS; ++round)
+    {
+      svn_pool_clear(iterpool);
+
+      /* Don't count the warm-up round. */
+      if (round == 1)
+        hits = 0;
+
+      for (i = 0; i < HOT_KEY_COUNT; ++i)
+        SVN_ERR(get_or_set(cache, apr_psprintf(iterpool, "hot %d", i),
+                           value, &hits, iterpool));
+
+      if (round > 0)
+        lookups += HOT_KEY_COUNT;
+
+      for (i = 0; i < SCAN_KEYS_PER_ROUND; ++i)
+        SVN_ERR(get_or_set(cache,
+                           apr_psprintf(iterpool, "scan %d %d", round, i),
+                           value, &scan_hits, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  *hit_rate = 100.0 * (double)hits / (double)lookups;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_membuffer_admission_filter(const svn_test_opts_t *opts,
+                                apr_pool_t *pool)
+{
+  double hit_rate_without_filter;
+  double hit_rate_with_filter;
+
+  SVN_ERR(run_scan_simulation(&hit_rate_without_filter, FALSE, pool));
+  SVN_ERR(run_scan_simulation(&hit_rate_with_filter, TRUE, pool));
+
+  if (opts->verbose)
+    printf("working set hit rate during scans: %5.2f%% without, "
+           "%5.2f%% with admission filter\n",
+           hit_rate_without_filter, hit_rate_with_filter);
+
+  /* The filter should keep most of the working set in cache.  Directory
+   * conflicts are resolved randomly, so we can't expect a full hit rate. */
+  SVN_TEST_ASSERT(hit_rate_with_filter > 50.0);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_membuffer_prefix_info(apr_pool_t *pool)
+{
+  svn_membuffer_t *membuffer;
+  svn_cache__t *fixed_cache, *string_cache;
+  svn_revnum_t valueA = 12345;
+  svn_revnum_t valueB = 67890;
+  svn_revnum_t *value;
+  svn_boolean_t found;
+  apr_array_header_t *info;
+  const svn_cache__prefix_info_t *fixed_info, *string_info;
+  svn_string_t *text;
+
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
+                                            TRUE, TRUE, pool));
+  SVN_ERR(create_snapshot_test_cache(&fixed_cache, membuffer, TRUE, pool));
+  SVN_ERR(create_snapshot_test_cache(&string_cache, membuffer, FALSE, pool));
+
+  SVN_ERR(svn_cache__set(fixed_cache, "12345678", &valueA, pool));
+  SVN_ERR(svn_cache__set(string_cache, "key B", &valueB, pool));
+  SVN_ERR(svn_cache__get((void **) &value, &found, fixed_cache, "12345678",
+                         pool));
+  SVN_TEST_ASSERT(found);
+  SVN_ERR(svn_cache__get((void **) &value, &found, string_cache, "key C",
+                         pool));
+  SVN_TEST_ASSERT(!found);
+
+  /* Another instance with the same prefix shares the statistics. */
+  SVN_ERR(create_snapshot_test_cache(&fixed_cache, membuffer, TRUE, pool));
+  SVN_ERR(svn_cache__get((void **) &value, &found, fixed_cache, "12345678",
+                         pool));
+  SVN_TEST_ASSERT(found);
+
+  SVN_ERR(svn_cache__membuffer_get_prefix_info(&info, membuffer, pool,
+                                               pool));
+  SVN_TEST_ASSERT(info->nelts == 2);
+
+  fixed_info = APR_ARRAY_IDX(info, 0, const svn_cache__prefix_info_t *);
+  SVN_TEST_STRING_ASSERT(fixed_info->prefix, "fixed:");
+  SVN_TEST_ASSERT(fixed_info->gets == 2);
+  SVN_TEST_ASSERT(fixed_info->hits == 2);
+  SVN_TEST_ASSERT(fixed_info->sets == 1);
+  SVN_TEST_ASSERT(fixed_info->evictions == 0);
+  SVN_TEST_ASSERT(fixed_info->used_entries == 1);
+  SVN_TEST_ASSERT(fixed_info->used_size > 0);
+
+  string_info = APR_ARRAY_IDX(info, 1, const svn_cache__prefix_info_t *);
+  SVN_TEST_STRING_ASSERT(string_info->prefix, "string:");
+  SVN_TEST_ASSERT(string_info->gets == 1);
+  SVN_TEST_ASSERT(string_info->hits == 0);
+  SVN_TEST_ASSERT(string_info->sets == 1);
+  SVN_TEST_ASSERT(string_info->used_entries == 1);
+
+  text = svn_cache__format_prefix_info(info, pool);
+  SVN_TEST_ASSERT(strncmp(text->data, "prefix\tgets\t", 12) == 0);
+  SVN_TEST_ASSERT(strstr(text->data, "\nfixed:\t2\t2\t0\t1\t0\t1\t"));
+  SVN_TEST_ASSERT(strstr(text->data, "\nstring:\t1\t0\t1\t1\t0\t1\t"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set the keys 0 to COUNT-1 in the fixed-key CACHE and return in *CACHED
+ * how many of them can be read back afterwards. */
+static svn_error_t *
+fill_fixed_key_cache(int *cached,
+                     svn_cache__t *cache,
+                     int count,
+                     apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_revnum_t *value;
+  svn_boolean_t found;
+  int i;
+
+  for (i = 0; i < count; ++i)
+    {
+      svn_revnum_t rev = i;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_cache__set(cache, apr_psprintf(iterpool, "%08d", i),
+                             &rev, iterpool));
+    }
+
+  *cached = 0;
+  for (i = 0; i < count; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_cache__get((void **) &value, &found, cache,
+                             apr_psprintf(iterpool, "%08d", i), iterpool));
+      if (found)
+        ++*cached;
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_membuffer_resize_and_quota(apr_pool_t *pool)
+{
+  svn_membuffer_t *membuffer;
+  svn_cache__t *fixed_cache, *string_cache;
+  svn_cache__info_t info;
+  apr_uint64_t full_size;
+  svn_revnum_t valueA = 12345;
+  svn_revnum_t *value;
+  svn_boolean_t found;
+  apr_array_header_t *prefix_info;
+  const svn_cache__prefix_info_t *fixed_info;
+  int cached;
+
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 1024*1024, 64*1024,
+                                            1, TRUE, TRUE, pool));
+  SVN_ERR(create_snapshot_test_cache(&fixed_cache, membuffer, TRUE, pool));
+  SVN_ERR(create_snapshot_test_cache(&string_cache, membuffer, FALSE, pool));
+
+  SVN_ERR(svn_cache__get_info(fixed_cache, &info, FALSE, pool));
+  full_size = info.data_size;
+
+  /* Shrinking takes the difference from the data buffer and drops its
+   * contents. */
+  SVN_ERR(svn_cache__set(string_cache, "key A", &valueA, pool));
+  SVN_ERR(svn_cache__membuffer_resize(membuffer, 512*1024));
+  SVN_ERR(svn_cache__get_info(fixed_cache, &info, FALSE, pool));
+  SVN_TEST_ASSERT(info.data_size == full_size - 512*1024);
+  SVN_ERR(svn_cache__get((void **) &value, &found, string_cache, "key A",
+                         pool));
+  SVN_TEST_ASSERT(!found);
+
+  /* Resizing to the current size keeps the contents. */
+  SVN_ERR(svn_cache__set(string_cache, "key A", &valueA, pool));
+  SVN_ERR(svn_cache__membuffer_resize(membuffer, 512*1024));
+  SVN_ERR(svn_cache__get((void **) &value, &found, string_cache, "key A",
+                         pool));
+  SVN_TEST_ASSERT(found);
+
+  /* The cache can grow back but not beyond its original size. */
+  SVN_ERR(svn_cache__membuffer_resize(membuffer, 4*1024*1024));
+  SVN_ERR(svn_cache__get_info(fixed_cache, &info, FALSE, pool));
+  SVN_TEST_ASSERT(info.data_size == full_size);
+
+  /* With a quota, a busy prefix can only keep some of its data ... */
+  SVN_ERR(svn_cache__membuffer_set_prefix_quota(membuffer, 1024, pool));
+  SVN_ERR(fill_fixed_key_cache(&cached, fixed_cache, 1000, pool));
+  SVN_TEST_ASSERT(cached > 0 && cached < 1000);
+
+  SVN_ERR(svn_cache__membuffer_get_prefix_info(&prefix_info, membuffer,
+                                               pool, pool));
+  fixed_info = APR_ARRAY_IDX(prefix_info, 0,
+                             const svn_cache__prefix_info_t *);
+  SVN_TEST_STRING_ASSERT(fixed_info->prefix, "fixed:");
+  SVN_TEST_ASSERT(fixed_info->used_size <= 1024);
+
+  /* ... while other prefixes are not affected. */
+  SVN_ERR(svn_cache__set(string_cache, "key A", &valueA, pool));
+  SVN_ERR(svn_cache__get((void **) &value, &found, string_cache, "key A",
+                         pool));
+  SVN_TEST_ASSERT(found);
+
+  /* Lifting the quota lets the prefix grow again. */
+  SVN_ERR(svn_cache__membuffer_set_prefix_quota(membuffer, 0, pool));
+  SVN_ERR(fill_fixed_key_cache(&cached, fixed_cache, 1000, pool));
+  SVN_TEST_ASSERT(cached > 500);
+
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS
+
+/* Number of distinct keys and accesses per thread used by the membuffer
+ * contention benchmark. */
+#define CONTENTION_KEY_COUNT 1000
+#define CONTENTION_ITERATIONS 10000
+
+/* Baton type passed to contention_thread_func. */
+typedef struct contention_baton_t
+{
+  /* Cache to access. */
+  svn_cache__t *cache;
+
+  /* Seed for the random key selection. */
+  apr_uint32_t seed;
+
+  /* Result of the thread's cache accesses. */
+  svn_error_t *err;
+} contention_baton_t;
+
+/* Access BATON->CACHE CONTENTION_ITERATIONS times using random keys.
+ * 99% of these will be reads.  Use POOL for temporary allocations. */
+static svn_error_t *
+access_cache(contention_baton_t *baton,
+             apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  for (i = 0; i < CONTENTION_ITERATIONS; ++i)
+    {
+      svn_revnum_t key;
+      svn_revnum_t *value;
+      svn_boolean_t found;
+
+      svn_pool_clear(iterpool);
+      key = svn_test_rand(&baton->seed) % CONTENTION_KEY_COUNT;
+
+      if (i % 100 == 0)
+        {
+          SVN_ERR(svn_cache__set(baton->cache, &key, &key, iterpool));
+        }
+      else
+        {
+          SVN_ERR(svn_cache__get((void **) &value, &found, baton->cache,
+                                 &key, iterpool));
+          if (found && *value != key)
+            return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                     "expected %ld but found '%ld'",
+                                     key, *value);
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+static void *
+APR_THREAD_FUNC contention_thread_func(apr_thread_t *tid, void *data)
+{
+  contention_baton_t *baton = data;
+  apr_pool_t *pool = svn_pool_create_ex(NULL,
+                                        svn_pool_create_allocator(FALSE));
+
+  baton->err = access_cache(baton, pool);
+
+  svn_pool_destroy(pool);
+  apr_thread_exit(tid, APR_SUCCESS);
+
+  return NULL;
+}
+
+/* Let THREAD_COUNT threads access CACHE concurrently and return the
+ * wall clock time it took them in *DURATION.  Use POOL for allocations. */
+static svn_error_t *
+run_contention(apr_interval_time_t *duration,
+               svn_cache__t *cache,
+               int thread_count,
+               apr_pool_t *pool)
+{
+  apr_thread_t **threads = apr_pcalloc(pool, thread_count * sizeof(*threads));
+  contention_baton_t *batons = apr_pcalloc(pool,
+                                           thread_count * sizeof(*batons));
+  svn_error_t *err = SVN_NO_ERROR;
+  apr_time_t start = apr_time_now();
+  int i;
+
+  for (i = 0; i < thread_count; ++i)
+    {
+      apr_status_t status;
+
+      batons[i].cache = cache;
+      batons[i].seed = (apr_uint32_t)i;
+      status = apr_thread_create(&threads[i], NULL, contention_thread_func,
+                                 &batons[i], pool);
+      if (status)
+        return svn_error_wrap_apr(status, "Can't create thread");
+    }
+
+  for (i = 0; i < thread_count; ++i)
+    {
+      apr_status_t retval;
+      apr_status_t status = apr_thread_join(&retval, threads[i]);
+      if (status)
+        return svn_error_wrap_apr(status, "Can't join thread");
+
+      err = svn_error_compose_create(err, batons[i].err);
+    }
+
+  *duration = apr_time_now() - start;
+
+  return svn_error_trace(err);
+}
+
+#endif
+
+static svn_error_t *
+test_membuffer_read_contention(const svn_test_opts_t *opts,
+                               apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  static const int thread_counts[] = { 8, 32, 64 };
+  svn_membuffer_t *membuffer;
+  svn_cache__t *cache;
+  svn_revnum_t key;
+  apr_size_t i;
+
+  /* Use a single segment to provoke actual contention. */
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 1024*1024, 64*1024,
+                                            1, TRUE, TRUE, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(
+            &cache, membuffer, serialize_revnum, deserialize_revnum,
+            sizeof(svn_revnum_t), "cache:",
+            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY, TRUE, FALSE,
+            pool, pool));
+
+  for (key = 0; key < CONTENTION_KEY_COUNT; ++key)
+    SVN_ERR(svn_cache__set(cache, &key, &key, pool));
+
+  for (i = 0; i < sizeof(thread_counts) / sizeof(thread_counts[0]); ++i)
+    {
+      apr_interval_time_t locked, optimistic;
+
+      svn_cache__membuffer_set_optimistic_reads(membuffer, FALSE);
+      SVN_ERR(run_contention(&locked, cache, thread_counts[i], pool));
+
+      if (!svn_cache__membuffer_set_optimistic_reads(membuffer, TRUE))
+        {
+          if (opts->verbose)
+            printf("%2d threads: %8" APR_TIME_T_FMT " usec locked, "
+                   "lock-free reads not supported\n",
+                   thread_counts[i], locked);
+          continue;
+        }
+
+      SVN_ERR(run_contention(&optimistic, cache, thread_counts[i], pool));
+      if (opts->verbose)
+        printf("%2d threads: %8" APR_TIME_T_FMT " usec locked, "
+               "%8" APR_TIME_T_FMT " usec lock-free\n",
+               thread_counts[i], locked, optimistic);
+    }
+#endif
+
+  return SVN_NO_ERROR;
+}
+
 
+static svn_error_t *
+test_disk_tier_cache(apr_pool_t *pool)
+{
+  svn_membuffer_t *membuffer;
+  svn_cache__t *first, *cache;
+  svn_revnum_t valueA = 12345;
+  svn_revnum_t *value;
+  svn_stringbuf_t *text;
+  svn_boolean_t found;
+  const char *sandbox;
+  const char *path;
+  apr_hash_t *dirents;
+  int i;
+
+  SVN_ERR(svn_test_make_sandbox_dir(&sandbox, "cache-disk-tier", pool));
+  path = svn_dirent_join(sandbox, "tier", pool);
+
+  /* Items get written to both tiers. */
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
+                                            TRUE, TRUE, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(&first, membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            APR_HASH_KEY_STRING,
+                                            "disk-tier:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE, FALSE, pool, pool));
+  SVN_ERR(svn_cache__create_disk_tier(&cache, first, path, 1024 * 1024,
+                                      serialize_revnum, deserialize_revnum,
+                                      APR_HASH_KEY_STRING, "disk-tier:",
+                                      pool));
+  SVN_ERR(svn_cache__set(cache, "key A", &valueA, pool));
+
+  /* A fresh memory tier will not have it but the disk tier will provide
+   * it and copy it into the memory tier. */
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
+                                            TRUE, TRUE, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(&first, membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            APR_HASH_KEY_STRING,
+                                            "disk-tier:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE, FALSE, pool, pool));
+  SVN_ERR(svn_cache__create_disk_tier(&cache, first, path, 1024 * 1024,
+                                      serialize_revnum, deserialize_revnum,
+                                      APR_HASH_KEY_STRING, "disk-tier:",
+                                      pool));
+
+  SVN_ERR(svn_cache__has_key(&found, first, "key A", pool));
+  SVN_TEST_ASSERT(!found);
+  SVN_ERR(svn_cache__has_key(&found, cache, "key B", pool));
+  SVN_TEST_ASSERT(!found);
+
+  SVN_ERR(svn_cache__get((void **) &value, &found, cache, "key A", pool));
+  SVN_TEST_ASSERT(found);
+  SVN_TEST_ASSERT(*value == valueA);
+  SVN_ERR(svn_cache__has_key(&found, first, "key A", pool));
+  SVN_TEST_ASSERT(found);
+
+  /* Different prefixes don't see each other's data. */
+  SVN_ERR(svn_cache__create_disk_tier(&cache, first, path, 1024 * 1024,
+                                      serialize_revnum, deserialize_revnum,
+                                      APR_HASH_KEY_STRING, "other:",
+                                      pool));
+  SVN_ERR(svn_cache__has_key(&found, cache, "key A", pool));
+  SVN_TEST_ASSERT(!found);
+
+  /* The least recently used items get removed when the directory fills
+   * up.  Items larger than 1/16th of the total are not stored at all. */
+  path = svn_dirent_join(sandbox, "small", pool);
+  SVN_ERR(svn_cache__create_null(&first, "null", pool));
+  SVN_ERR(svn_cache__create_disk_tier(&cache, first, path, 16 * 1024,
+                                      NULL, NULL, APR_HASH_KEY_STRING,
+                                      "small:", pool));
+  SVN_TEST_ASSERT(svn_cache__is_cachable(cache, 1000));
+  SVN_TEST_ASSERT(!svn_cache__is_cachable(cache, 2000));
+
+  text = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_appendfill(text, 'x', 1000);
+  for (i = 0; i < 40; ++i)
+    SVN_ERR(svn_cache__set(cache, apr_psprintf(pool, "key %d", i), text,
+                           pool));
+
+  SVN_ERR(svn_cache__has_key(&found, cache, "key 0", pool));
+  SVN_TEST_ASSERT(!found);
+  SVN_ERR(svn_cache__has_key(&found, cache, "key 39", pool));
+  SVN_TEST_ASSERT(found);
+
+  SVN_ERR(svn_io_get_dirents3(&dirents, path, TRUE, pool, pool));
+  SVN_TEST_ASSERT(apr_hash_count(dirents) <= 16);
+
+  SVN_ERR(svn_cache__get((void **) &text, &found, cache, "key 39", pool));
+  SVN_TEST_ASSERT(found);
+  SVN_TEST_ASSERT(text->len == 1000);
+
+  return SVN_NO_ERROR;
+}
+
 /* The test table.  */
 
 static int max_threads = 1;
@@ -606,6 +1300,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "memcache svn_cache with very long keys"),
     SVN_TEST_PASS2(test_membuffer_cache_basic,
                    "basic membuffer svn_cache test"),
+    SVN_TEST_OPTS_PASS(test_memcache_multi,
+                       "memcache svn_cache multi-get and multi-set"),
+    SVN_TEST_PASS2(test_membuffer_cache_multi,
+                   "membuffer svn_cache multi-get and multi-set"),
     SVN_TEST_PASS2(test_membuffer_serializer_error_handling,
                    "test for error handling in membuffer svn_cache"),
     SVN_TEST_PASS2(test_membuffer_cache_clearing,
@@ -616,6 +1314,19 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test membuffer cache with unaligned string keys"),
     SVN_TEST_PASS2(test_membuffer_unaligned_fixed_keys,
                    "test membuffer cache with unaligned fixed keys"),
+    SVN_TEST_PASS2(test_membuffer_snapshot,
+                   "test membuffer cache snapshots"),
+    SVN_TEST_OPTS_PASS(test_membuffer_admission_filter,
+                       "test membuffer cache admission filter"),
+    SVN_TEST_PASS2(test_membuffer_prefix_info,
+                   "test membuffer cache per-prefix statistics"),
+    SVN_TEST_PASS2(test_membuffer_resize_and_quota,
+                   "test membuffer cache resizing and prefix quotas"),
+    SVN_TEST_OPTS_SKIP(test_membuffer_read_contention,
+                       ! APR_HAS_THREADS,
+                       "test membuffer cache under read contention"),
+    SVN_TEST_PASS2(test_disk_tier_cache,
+                   "test persistent disk tier below a cache"),
     SVN_TEST_NULL
   };
 
@@ -22,11 +22,15 @@
  */
 
 #include <apr_pools.h>
+#include <apr_md5.h>
+#include <apr_sha1.h>
 
 #include <zlib.h>
 
 #include "svn_error.h"
 #include "svn_io.h"
+#include "svn_sorts.h"
+#include "private/svn_subr_private.h"
 
 #include "../svn_test.h"
 
@@ -296,6 +300,101 @@ test_checksum_parse_all_zero(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Compare the MD5 and SHA-1 digests of the first LEN bytes of DATA as
+ * produced by svn_checksum(), the incremental checksum contexts fed in
+ * chunks of CHUNK bytes and the combined MD5+SHA-1 context against the
+ * reference implementations in APR-util.
+ */
+static svn_error_t *
+verify_md5_sha1(const unsigned char *data,
+                apr_size_t len,
+                apr_size_t chunk,
+                apr_pool_t *pool)
+{
+  unsigned char md5_ref[APR_MD5_DIGESTSIZE];
+  unsigned char sha1_ref[APR_SHA1_DIGESTSIZE];
+  apr_sha1_ctx_t sha1_ctx;
+  svn_checksum_t *md5;
+  svn_checksum_t *sha1;
+  svn_checksum_ctx_t *md5_svn_ctx;
+  svn_checksum_ctx_t *sha1_svn_ctx;
+  svn_checksum__md5_sha1_ctx_t *combined;
+  apr_size_t pos;
+
+  apr_md5(md5_ref, data, len);
+  apr_sha1_init(&sha1_ctx);
+  apr_sha1_update_binary(&sha1_ctx, data, (unsigned int)len);
+  apr_sha1_final(sha1_ref, &sha1_ctx);
+
+  /* One-shot API. */
+  SVN_ERR(svn_checksum(&md5, svn_checksum_md5, data, len, pool));
+  SVN_ERR(svn_checksum(&sha1, svn_checksum_sha1, data, len, pool));
+  SVN_TEST_ASSERT(memcmp(md5->digest, md5_ref, sizeof(md5_ref)) == 0);
+  SVN_TEST_ASSERT(memcmp(sha1->digest, sha1_ref, sizeof(sha1_ref)) == 0);
+
+  /* Incremental API. */
+  md5_svn_ctx = svn_checksum_ctx_create(svn_checksum_md5, pool);
+  sha1_svn_ctx = svn_checksum_ctx_create(svn_checksum_sha1, pool);
+  combined = svn_checksum__md5_sha1_ctx_create(pool);
+  for (pos = 0; pos < len; pos += chunk)
+    {
+      apr_size_t to_add = MIN(chunk, len - pos);
+      SVN_ERR(svn_checksum_update(md5_svn_ctx, data + pos, to_add));
+      SVN_ERR(svn_checksum_update(sha1_svn_ctx, data + pos, to_add));
+      SVN_ERR(svn_checksum__md5_sha1_update(combined, data + pos, to_add));
+    }
+
+  SVN_ERR(svn_checksum_final(&md5, md5_svn_ctx, pool));
+  SVN_ERR(svn_checksum_final(&sha1, sha1_svn_ctx, pool));
+  SVN_TEST_ASSERT(memcmp(md5->digest, md5_ref, sizeof(md5_ref)) == 0);
+  SVN_TEST_ASSERT(memcmp(sha1->digest, sha1_ref, sizeof(sha1_ref)) == 0);
+
+  SVN_ERR(svn_checksum__md5_sha1_final(&md5, &sha1, combined, pool));
+  SVN_TEST_ASSERT(memcmp(md5->digest, md5_ref, sizeof(md5_ref)) == 0);
+  SVN_TEST_ASSERT(memcmp(sha1->digest, sha1_ref, sizeof(sha1_ref)) == 0);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_md5_sha1_implementation(apr_pool_t *pool)
+{
+  /* Lengths around the 64 byte block size and the padding boundary. */
+  static const apr_size_t lengths[] =
+    { 0, 1, 55, 56, 63, 64, 65, 127, 128, 1000, 65537 };
+  static const apr_size_t chunks[] = { 1, 7, 64, 100, 0x10000 };
+  apr_size_t max_len = lengths[sizeof(lengths) / sizeof(lengths[0]) - 1];
+  unsigned char *data = apr_palloc(pool, max_len);
+  apr_uint32_t seed = 0x12345678;
+  apr_size_t i, k;
+
+  /* Simple LCG to get reproducible, non-trivial input. */
+  for (i = 0; i < max_len; ++i)
+    {
+      seed = seed * 1103515245 + 12345;
+      data[i] = (unsigned char)(seed >> 16);
+    }
+
+  for (i = 0; i < sizeof(lengths) / sizeof(lengths[0]); ++i)
+    for (k = 0; k < sizeof(chunks) / sizeof(chunks[0]); ++k)
+      SVN_ERR(verify_md5_sha1(data, lengths[i], chunks[k], pool));
+
+  /* Either output of the combined context may be omitted. */
+  {
+    svn_checksum__md5_sha1_ctx_t *ctx
+      = svn_checksum__md5_sha1_ctx_create(pool);
+    svn_checksum_t *sha1;
+    svn_checksum_t *expected;
+
+    SVN_ERR(svn_checksum__md5_sha1_update(ctx, data, 1000));
+    SVN_ERR(svn_checksum__md5_sha1_final(NULL, &sha1, ctx, pool));
+    SVN_ERR(svn_checksum(&expected, svn_checksum_sha1, data, 1000, pool));
+    SVN_TEST_ASSERT(svn_checksum_match(sha1, expected));
+  }
+
+  return SVN_NO_ERROR;
+}
+
 /* An array of all test functions */
 
 static int max_threads = 1;
@@ -317,6 +416,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "checksum (de-)serialization"),
     SVN_TEST_PASS2(test_checksum_parse_all_zero,
                    "checksum parse all zero"),
+    SVN_TEST_PASS2(test_md5_sha1_implementation,
+                   "MD5 and SHA-1 against APR reference"),
     SVN_TEST_NULL
   };
 
@@ -33,6 +33,7 @@
 #endif
 
 #include <apr_general.h>
+#include <apr_strings.h>
 
 #include "svn_pools.h"
 #include "svn_dirent_uri.h"
@@ -1018,6 +1019,73 @@ test_uri_canonicalize(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Check that separators are found at every offset of paths long enough
+   for the vectorized scans, and that canonical input comes back as an
+   equal copy. */
+static svn_error_t *
+test_canonicalize_long_paths(apr_pool_t *pool)
+{
+  const char *canonical = "trunk/subversion/libsvn_subr/dirent_uri.c";
+  apr_size_t len = strlen(canonical);
+  apr_size_t i;
+  const char *result;
+
+  result = svn_relpath_canonicalize(canonical, pool);
+  SVN_TEST_STRING_ASSERT(result, canonical);
+  SVN_TEST_ASSERT(result != canonical);
+
+  result = svn_dirent_canonicalize(canonical, pool);
+  SVN_TEST_STRING_ASSERT(result, canonical);
+  SVN_TEST_ASSERT(result != canonical);
+
+  result = svn_fspath__canonicalize(apr_pstrcat(pool, "/", canonical,
+                                                SVN_VA_NULL), pool);
+  SVN_TEST_STRING_ASSERT(result + 1, canonical);
+
+  result = svn_uri_canonicalize(apr_pstrcat(pool, "http://host/", canonical,
+                                            SVN_VA_NULL), pool);
+  SVN_TEST_STRING_ASSERT(result + 12, canonical);
+
+  /* Duplicate every separator in turn. */
+  for (i = 1; i < len; ++i)
+    {
+      const char *path;
+
+      if (canonical[i] != '/')
+        continue;
+
+      path = apr_pstrcat(pool, apr_pstrndup(pool, canonical, i), "/",
+                         canonical + i, SVN_VA_NULL);
+      SVN_TEST_ASSERT(!svn_relpath_is_canonical(path));
+      SVN_TEST_ASSERT(!svn_dirent_is_canonical(path, pool));
+      SVN_TEST_STRING_ASSERT(svn_relpath_canonicalize(path, pool), canonical);
+      SVN_TEST_STRING_ASSERT(svn_dirent_canonicalize(path, pool), canonical);
+
+      path = apr_pstrcat(pool, "http://host/", path, SVN_VA_NULL);
+      SVN_TEST_ASSERT(!svn_uri_is_canonical(path, pool));
+      SVN_TEST_STRING_ASSERT(svn_uri_canonicalize(path, pool) + 12,
+                             canonical);
+    }
+
+  /* Replace every other char with a separator, creating "//" wherever
+     it is next to an existing one. */
+  for (i = 1; i < len - 1; ++i)
+    {
+      char *path = apr_pstrdup(pool, canonical);
+      svn_boolean_t expected;
+
+      if (canonical[i] == '/' || canonical[i] == '.')
+        continue;
+
+      path[i] = '/';
+      expected = canonical[i - 1] != '/' && canonical[i + 1] != '/';
+      SVN_TEST_ASSERT(svn_relpath_is_canonical(path) == expected);
+      SVN_TEST_ASSERT(svn_dirent_is_canonical(path, pool) == expected);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Paths to test and the expected result, for is_canonical tests. */
 typedef struct testcase_is_canonical_t {
   const char *path;
@@ -2938,6 +3006,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test svn_relpath_canonicalize"),
     SVN_TEST_PASS2(test_uri_canonicalize,
                    "test svn_uri_canonicalize"),
+    SVN_TEST_PASS2(test_canonicalize_long_paths,
+                   "test canonicalization of long paths"),
     SVN_TEST_PASS2(test_dirent_is_canonical,
                    "test svn_dirent_is_canonical"),
     SVN_TEST_PASS2(test_relpath_is_canonical,
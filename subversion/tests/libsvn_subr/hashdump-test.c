@@ -36,6 +36,8 @@
 #include "svn_error.h"
 #include "svn_hash.h"
 
+#include "private/svn_subr_private.h"
+
 
 /* Our own global variables */
 static apr_hash_t *proplist, *new_proplist;
@@ -230,6 +232,68 @@ read_hash_buffered_test(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+parse_hash_buffer_test(apr_pool_t *pool)
+{
+  svn_stringbuf_t *serialized = svn_stringbuf_create_empty(pool);
+  apr_hash_t *ht = apr_hash_make(pool);
+  char *data;
+  const char *malformed[] =
+    {
+      "",
+      "K 3\nkey\nV 5\nvalue\n",
+      "K 3\nkey\nV 5\nval\nEND\n",
+      "K 3\nkeyV 5\nvalue\nEND\n",
+      "K x\nkey\nV 5\nvalue\nEND\n",
+      "K 99999999999999999999999\nkey\nEND\n",
+      "D 3\nkey\nEND\n",
+    };
+  svn_stringbuf_t *large = svn_stringbuf_create_ensure(100000, pool);
+  apr_size_t i;
+
+  /* Round-trip a hash with a large value through the serializer. */
+  svn_hash_sets(ht, "color", svn_string_create("red", pool));
+  svn_hash_sets(ht, "wine review", svn_string_create(review, pool));
+  svn_hash_sets(ht, "empty", svn_string_create_empty(pool));
+  memset(large->data, 'x', 100000);
+  large->len = 100000;
+  large->data[large->len] = '\0';
+  svn_hash_sets(ht, "large", svn_string_ncreate(large->data, large->len,
+                                                pool));
+  SVN_ERR(svn_hash_write2(ht, svn_stream_from_stringbuf(serialized, pool),
+                          SVN_HASH_TERMINATOR, pool));
+
+  ht = apr_hash_make(pool);
+  data = apr_pstrmemdup(pool, serialized->data, serialized->len);
+  SVN_ERR(svn_hash__parse(ht, data, serialized->len, SVN_HASH_TERMINATOR,
+                          pool));
+
+  SVN_TEST_ASSERT(apr_hash_count(ht) == 4);
+  SVN_TEST_STRING_ASSERT(hash_gets_stringt(ht, "color"), "red");
+  SVN_TEST_STRING_ASSERT(hash_gets_stringt(ht, "wine review"), review);
+  SVN_TEST_STRING_ASSERT(hash_gets_stringt(ht, "empty"), "");
+  SVN_TEST_ASSERT(((svn_string_t *)svn_hash_gets(ht, "large"))->len
+                  == 100000);
+
+  /* Without a terminator, the hash ends with the data. */
+  ht = apr_hash_make(pool);
+  data = apr_pstrdup(pool, "K 3\nkey\nV 5\nvalue\n");
+  SVN_ERR(svn_hash__parse(ht, data, strlen(data), NULL, pool));
+  SVN_TEST_STRING_ASSERT(hash_gets_stringt(ht, "key"), "value");
+
+  /* Broken data must be detected. */
+  for (i = 0; i < sizeof(malformed) / sizeof(malformed[0]); ++i)
+    {
+      ht = apr_hash_make(pool);
+      data = apr_pstrdup(pool, malformed[i]);
+      SVN_TEST_ASSERT_ERROR(svn_hash__parse(ht, data, strlen(data),
+                                            SVN_HASH_TERMINATOR, pool),
+                            SVN_ERR_MALFORMED_FILE);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 
 /*
    ====================================================================
@@ -252,6 +316,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "write hash out, read back in, compare"),
     SVN_TEST_PASS2(read_hash_buffered_test,
                    "read hash from buffered file"),
+    SVN_TEST_PASS2(parse_hash_buffer_test,
+                   "parse a hash from a buffer"),
     SVN_TEST_NULL
   };
 
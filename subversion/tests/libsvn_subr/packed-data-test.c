@@ -37,6 +37,7 @@
 #include "svn_error.h"
 #include "svn_string.h"   /* This includes <apr_*.h> */
 #include "private/svn_packed_data.h"
+#include "private/svn_subr_private.h"
 
 /* Take the WRITE_ROOT, serialize its contents, parse it again into a new
  * data root and return it in *READ_ROOT.  Allocate it in POOL.
@@ -191,6 +192,34 @@ test_int_stream(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_uint_runs(apr_pool_t *pool)
+{
+  /* Runs of single-byte numbers of various lengths, separated by larger
+   * numbers, such that the runs start and end at all sorts of offsets
+   * within the encoded data. */
+  enum { COUNT = 2000 };
+  apr_uint64_t *values = apr_palloc(pool, COUNT * sizeof(*values));
+  apr_size_t run = 0;
+  apr_size_t i;
+
+  for (i = 0; i < COUNT; ++i)
+    if (run > 0)
+      {
+        values[i] = i % 128;
+        --run;
+      }
+    else
+      {
+        values[i] = APR_UINT64_C(0x81) << (i % 57);
+        run = (i * 7) % 41;
+      }
+
+  SVN_ERR(verify_uint_stream(values, COUNT, FALSE, pool));
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 test_byte_stream(apr_pool_t *pool)
 {
@@ -553,6 +582,70 @@ test_full_structure(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_zstd_dictionary(apr_pool_t *pool)
+{
+  base_record_t *unpacked;
+  apr_size_t count;
+  apr_size_t samples_size = 0;
+  svn_stringbuf_t *dict_data;
+  svn__compress_dict_t *dict;
+  svn_packed__compression_t compression = { 0 };
+  svn_packed__data_root_t *root;
+  svn_stringbuf_t *stream_buffer = svn_stringbuf_create_empty(pool);
+  svn_stream_t *stream;
+  int i;
+
+  if (!svn_zstd__compiled_version())
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "zstd support not compiled in");
+
+  /* Collect samples from containers of various sizes. */
+  compression.samples = apr_array_make(pool, 16, sizeof(svn_stringbuf_t *));
+  compression.samples_size = &samples_size;
+  compression.max_samples_size = APR_SIZE_MAX;
+  for (i = 0; i < 200; ++i)
+    {
+      root = pack(test_data, i % BASE_RECORD_COUNT + 1, pool);
+      stream = svn_stream_empty(pool);
+      SVN_ERR(svn_packed__data_write2(stream, root, &compression, pool));
+    }
+
+  SVN_TEST_ASSERT(compression.samples->nelts > 0);
+  SVN_TEST_ASSERT(samples_size > 0);
+
+  /* ZDICT may refuse to train on too little data.  Fake a dictionary then;
+   * any content will do for a round-trip test. */
+  SVN_ERR(svn__compress_dict_train(&dict_data, compression.samples, 0x4000,
+                                   pool, pool));
+  if (!dict_data)
+    dict_data = svn_stringbuf_dup(APR_ARRAY_IDX(compression.samples, 0,
+                                                svn_stringbuf_t *), pool);
+
+  SVN_ERR(svn__compress_dict_create(&dict, dict_data->data, dict_data->len,
+                                    SVN__COMPRESSION_ZSTD_DEFAULT, pool));
+  SVN_TEST_ASSERT(svn__compress_dict_data(dict)->len == dict_data->len);
+
+  /* Round-trip with that dictionary. */
+  compression.samples = NULL;
+  compression.dict = dict;
+  root = pack(test_data, BASE_RECORD_COUNT, pool);
+
+  stream = svn_stream_from_stringbuf(stream_buffer, pool);
+  SVN_ERR(svn_packed__data_write2(stream, root, &compression, pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  stream = svn_stream_from_stringbuf(stream_buffer, pool);
+  SVN_ERR(svn_packed__data_read2(&root, stream, &compression, pool, pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  unpacked = unpack(&count, root, pool);
+  SVN_TEST_ASSERT(count == BASE_RECORD_COUNT);
+  SVN_ERR(compare(unpacked, test_data, count));
+
+  return SVN_NO_ERROR;
+}
+
 /* An array of all test functions */
 
 static int max_threads = 1;
@@ -566,12 +659,16 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test a single uint stream"),
     SVN_TEST_PASS2(test_int_stream,
                    "test a single int stream"),
+    SVN_TEST_PASS2(test_uint_runs,
+                   "test runs of small uints"),
     SVN_TEST_PASS2(test_byte_stream,
                    "test a single bytes stream"),
     SVN_TEST_PASS2(test_empty_structure,
                    "test empty, nested structure"),
     SVN_TEST_PASS2(test_full_structure,
                    "test nested structure"),
+    SVN_TEST_PASS2(test_zstd_dictionary,
+                   "test zstd compression with a dictionary"),
     SVN_TEST_NULL
   };
 
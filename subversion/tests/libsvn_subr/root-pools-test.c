@@ -82,6 +82,44 @@ test_root_pool(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_root_pool_profiling(apr_pool_t *pool)
+{
+  svn_root_pools__t *pools;
+  svn_root_pools__info_t info;
+  apr_pool_t *pool1, *pool2;
+
+  SVN_ERR(svn_root_pools__create(&pools));
+  svn_root_pools__enable_profiling(pools);
+
+  /* Two new pools.  One of them gets cached for this thread. */
+  pool1 = svn_root_pools__acquire_pool(pools);
+  pool2 = svn_root_pools__acquire_pool(pools);
+  svn_root_pools__release_pool(pool1, pools);
+  svn_root_pools__release_pool(pool2, pools);
+
+  /* Both get recycled. */
+  pool1 = svn_root_pools__acquire_pool(pools);
+  pool2 = svn_root_pools__acquire_pool(pools);
+  svn_root_pools__release_pool(pool2, pools);
+
+  SVN_ERR(svn_root_pools__get_info(&info, pools));
+  SVN_TEST_ASSERT(info.created == 2);
+  SVN_TEST_ASSERT(info.acquired == 4);
+#if APR_HAS_THREADS
+  SVN_TEST_ASSERT(info.thread_hits == 1);
+#endif
+  SVN_TEST_ASSERT(info.in_use == 1);
+  SVN_TEST_ASSERT(info.max_in_use == 2);
+  SVN_TEST_ASSERT(info.total_lifetime >= info.max_lifetime);
+
+  svn_root_pools__release_pool(pool1, pools);
+  SVN_ERR(svn_root_pools__get_info(&info, pools));
+  SVN_TEST_ASSERT(info.in_use == 0);
+
+  return SVN_NO_ERROR;
+}
+
 #define APR_ERR(expr)                           \
   do {                                          \
     apr_status_t status = (expr);               \
@@ -128,6 +166,8 @@ static struct svn_test_descriptor_t test_funcs[] =
     SVN_TEST_NULL,
     SVN_TEST_PASS2(test_root_pool,
                    "test root pool recycling"),
+    SVN_TEST_PASS2(test_root_pool_profiling,
+                   "test root pool statistics"),
     SVN_TEST_SKIP2(test_root_pool_concurrency,
                    ! APR_HAS_THREADS,
                    "test concurrent root pool recycling"),
@@ -170,6 +170,49 @@ test_sqlite_txn_commit_busy(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_sqlite_tune_wal(apr_pool_t *pool)
+{
+  svn_sqlite__db_t *sdb1;
+  svn_sqlite__db_t *sdb2;
+  const char *db_abspath;
+
+  static const char *const statements[] = {
+    "CREATE TABLE test (one TEXT NOT NULL PRIMARY KEY)",
+
+    "INSERT INTO test(one) VALUES ('foo')",
+
+    "SELECT one from test",
+
+    NULL
+  };
+
+  SVN_ERR(open_db(&sdb1, &db_abspath, "tune_wal", statements, 250, pool));
+  SVN_ERR(svn_sqlite__tune(sdb1, 1024, 0, TRUE, pool));
+  SVN_ERR(svn_sqlite__exec_statements(sdb1, 0));
+  SVN_ERR(svn_sqlite__close(sdb1));
+
+  /* Reopening keeps the database in WAL mode. */
+  SVN_ERR(svn_sqlite__open(&sdb1, db_abspath, svn_sqlite__mode_readwrite,
+                           statements, 0, NULL, 250, pool, pool));
+  SVN_ERR(svn_sqlite__open(&sdb2, db_abspath, svn_sqlite__mode_readwrite,
+                           statements, 0, NULL, 250, pool, pool));
+
+  /* Unlike in test_sqlite_txn_commit_busy(), a concurrent reader doesn't
+     block committing the write transaction. */
+  SVN_ERR(svn_sqlite__begin_transaction(sdb1));
+  SVN_ERR(svn_sqlite__exec_statements(sdb1, 1 /* INSERT */));
+  SVN_ERR(svn_sqlite__begin_transaction(sdb2));
+  SVN_ERR(svn_sqlite__exec_statements(sdb2, 2 /* SELECT */));
+  SVN_ERR(svn_sqlite__finish_transaction(sdb1, SVN_NO_ERROR));
+  SVN_ERR(svn_sqlite__finish_transaction(sdb2, SVN_NO_ERROR));
+
+  SVN_ERR(svn_sqlite__close(sdb2));
+  SVN_ERR(svn_sqlite__close(sdb1));
+
+  return SVN_NO_ERROR;
+}
+
 
 static int max_threads = 1;
 
@@ -180,6 +223,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "sqlite reset"),
     SVN_TEST_PASS2(test_sqlite_txn_commit_busy,
                    "sqlite busy on transaction commit"),
+    SVN_TEST_PASS2(test_sqlite_tune_wal,
+                   "sqlite write-ahead logging"),
     SVN_TEST_NULL
   };
 
@@ -27,6 +27,7 @@
 #include "svn_subst.h"
 #include "svn_base64.h"
 #include <apr_general.h>
+#include <apr_strings.h>
 
 #include "private/svn_io_private.h"
 
@@ -1000,6 +1001,214 @@ test_stream_readline_file_crlf(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_stream_read_ahead(apr_pool_t *pool)
+{
+  svn_stringbuf_t *original = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *line;
+  svn_stringbuf_t *rest;
+  svn_stream_t *stream;
+  svn_boolean_t eof;
+  int i;
+
+  /* Lines of varying length, so that they and their EOL markers
+     straddle the block boundaries in various ways. */
+  for (i = 0; i < 100; ++i)
+    {
+      svn_stringbuf_appendbytes(original, "0123456789abcdef", i % 17);
+      svn_stringbuf_appendcstr(original, "\r\n");
+    }
+
+  /* Copy everything through tiny read-ahead blocks. */
+  SVN_ERR(svn_stream__read_ahead(&stream,
+                                 svn_stream_from_stringbuf(original, pool),
+                                 7, 3, pool));
+  SVN_ERR(svn_stringbuf_from_stream(&rest, stream, 0, pool));
+  SVN_TEST_STRING_ASSERT(rest->data, original->data);
+  SVN_ERR(svn_stream_close(stream));
+
+  /* Mix line-based reading with plain reads. */
+  SVN_ERR(svn_stream__read_ahead(&stream,
+                                 svn_stream_from_stringbuf(original, pool),
+                                 5, 2, pool));
+  for (i = 0; i < 50; ++i)
+    {
+      SVN_ERR(svn_stream_readline(stream, &line, "\r\n", &eof, pool));
+      SVN_TEST_ASSERT(!eof);
+      SVN_TEST_ASSERT(line->len == i % 17);
+      SVN_TEST_ASSERT(memcmp(line->data, "0123456789abcdef", line->len) == 0);
+    }
+
+  SVN_ERR(svn_stringbuf_from_stream(&rest, stream, 0, pool));
+  SVN_TEST_STRING_ASSERT(rest->data,
+                         original->data + original->len - rest->len);
+
+  SVN_ERR(svn_stream_readline(stream, &line, "\r\n", &eof, pool));
+  SVN_TEST_ASSERT(eof);
+  SVN_TEST_ASSERT(line->len == 0);
+  SVN_ERR(svn_stream_close(stream));
+
+  /* Close the stream before all data got read. */
+  SVN_ERR(svn_stream__read_ahead(&stream,
+                                 svn_stream_from_stringbuf(original, pool),
+                                 3, 2, pool));
+  SVN_ERR(svn_stream_readline(stream, &line, "\r\n", &eof, pool));
+  SVN_TEST_ASSERT(!eof);
+  SVN_TEST_STRING_ASSERT(line->data, "");
+  SVN_ERR(svn_stream_close(stream));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_stream_copy_files(apr_pool_t *pool)
+{
+  svn_stringbuf_t *original = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *result;
+  const char *from_path, *to_path;
+  apr_file_t *from_file, *to_file;
+  svn_stream_t *from, *to;
+  char buffer[100];
+  apr_size_t len;
+  apr_off_t offset;
+  int i;
+
+  /* More than a single chunk of data. */
+  for (i = 0; i < 10000; ++i)
+    svn_stringbuf_appendcstr(original,
+                             apr_psprintf(pool, "line %d\n", i));
+
+  SVN_ERR(svn_io_open_unique_file3(&from_file, &from_path, NULL,
+                                   svn_io_file_del_on_pool_cleanup,
+                                   pool, pool));
+  SVN_ERR(svn_io_file_write_full(from_file, original->data, original->len,
+                                 NULL, pool));
+  SVN_ERR(svn_io_file_close(from_file, pool));
+
+  /* Copy from and to the middle of buffered files, as the kernel might do
+     the copy for us if the platform supports it. */
+  SVN_ERR(svn_io_file_open(&from_file, from_path, APR_READ | APR_BUFFERED,
+                           APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_open_unique_file3(NULL, &to_path, NULL,
+                                   svn_io_file_del_on_pool_cleanup,
+                                   pool, pool));
+  SVN_ERR(svn_io_file_open(&to_file, to_path,
+                           APR_WRITE | APR_TRUNCATE | APR_BUFFERED,
+                           APR_OS_DEFAULT, pool));
+
+  from = svn_stream_from_aprfile2(from_file, TRUE, pool);
+  to = svn_stream_from_aprfile2(to_file, TRUE, pool);
+
+  len = sizeof(buffer);
+  SVN_ERR(svn_stream_read_full(from, buffer, &len));
+  SVN_TEST_ASSERT(len == sizeof(buffer));
+  SVN_ERR(svn_stream_puts(to, "header\n"));
+
+  SVN_ERR(svn_stream_copy3(from, to, NULL, NULL, pool));
+
+  /* Both files must be positioned after the copied data. */
+  SVN_ERR(svn_io_file_get_offset(&offset, from_file, pool));
+  SVN_TEST_ASSERT(offset == original->len);
+  SVN_ERR(svn_io_file_get_offset(&offset, to_file, pool));
+  SVN_TEST_ASSERT(offset == original->len - sizeof(buffer) + 7);
+
+  SVN_ERR(svn_io_file_close(from_file, pool));
+  SVN_ERR(svn_io_file_close(to_file, pool));
+
+  SVN_ERR(svn_stringbuf_from_file2(&result, to_path, pool));
+  SVN_TEST_ASSERT(result->len == original->len - sizeof(buffer) + 7);
+  SVN_TEST_ASSERT(memcmp(result->data, "header\n", 7) == 0);
+  SVN_TEST_ASSERT(memcmp(result->data + 7, original->data + sizeof(buffer),
+                         original->len - sizeof(buffer)) == 0);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the base64 encoding of DATA, broken into lines of 76 chars if
+   BREAK_LINES is set, computed the most straightforward way. */
+static svn_stringbuf_t *
+reference_base64(const svn_string_t *data,
+                 svn_boolean_t break_lines,
+                 apr_pool_t *pool)
+{
+  static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                              "abcdefghijklmnopqrstuvwxyz0123456789+/";
+  svn_stringbuf_t *result = svn_stringbuf_create_empty(pool);
+  apr_size_t i, chars = 0;
+
+  for (i = 0; i < data->len; i += 3)
+    {
+      unsigned char group[3] = { 0 };
+      char out[4];
+      apr_size_t len = data->len - i < 3 ? data->len - i : 3;
+
+      memcpy(group, data->data + i, len);
+      out[0] = table[group[0] >> 2];
+      out[1] = table[((group[0] & 3) << 4) | (group[1] >> 4)];
+      out[2] = len > 1 ? table[((group[1] & 0xf) << 2) | (group[2] >> 6)]
+                       : '=';
+      out[3] = len > 2 ? table[group[2] & 0x3f] : '=';
+      svn_stringbuf_appendbytes(result, out, 4);
+
+      chars += 4;
+      if (break_lines && chars % 76 == 0)
+        svn_stringbuf_appendbyte(result, '\n');
+    }
+
+  if (break_lines && chars % 76)
+    svn_stringbuf_appendbyte(result, '\n');
+
+  return result;
+}
+
+static svn_error_t *
+test_base64_long_data(apr_pool_t *pool)
+{
+  svn_stringbuf_t *data = svn_stringbuf_create_empty(pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_uint32_t seed = 1234;
+  apr_size_t len;
+
+  /* Cover all byte values and many line lengths, so that the vectorized
+     code paths, if any, get exercised together with the scalar ones. */
+  for (len = 0; len < 1000; len += (len < 300 ? 1 : 37))
+    {
+      const svn_string_t *str, *encoded, *decoded;
+      svn_stringbuf_t *expected, *garbled;
+      int break_lines;
+
+      svn_pool_clear(iterpool);
+      while (data->len < len)
+        svn_stringbuf_appendbyte(data, (char)svn_test_rand(&seed));
+      str = svn_string_create_from_buf(data, iterpool);
+
+      for (break_lines = 0; break_lines < 2; ++break_lines)
+        {
+          expected = reference_base64(str, break_lines, iterpool);
+          encoded = svn_base64_encode_string2(str, break_lines, iterpool);
+          SVN_TEST_STRING_ASSERT(encoded->data, expected->data);
+
+          decoded = svn_base64_decode_string(encoded, iterpool);
+          SVN_TEST_ASSERT(svn_string_compare(decoded, str));
+        }
+
+      /* Chars outside the base64 alphabet are skipped, wherever they
+         appear within a line. */
+      garbled = svn_stringbuf_dup(expected, iterpool);
+      if (garbled->len > 1)
+        svn_stringbuf_insert(garbled,
+                             svn_test_rand(&seed) % (garbled->len - 1),
+                             "*\x80 ", 3);
+      decoded = svn_base64_decode_string(
+                  svn_string_create_from_buf(garbled, iterpool), iterpool);
+      SVN_TEST_ASSERT(svn_string_compare(decoded, str));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* The test table.  */
 
 static int max_threads = 1;
@@ -1027,6 +1236,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test base64 encoding/decoding streams"),
     SVN_TEST_PASS2(test_stream_base64_2,
                    "base64 decoding allocation problem"),
+    SVN_TEST_PASS2(test_base64_long_data,
+                   "base64 encoding and decoding of longer data"),
     SVN_TEST_PASS2(test_stringbuf_from_stream,
                    "test svn_stringbuf_from_stream"),
     SVN_TEST_PASS2(test_stream_compressed_read_full,
@@ -1037,6 +1248,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test reading LF-terminated lines from file"),
     SVN_TEST_PASS2(test_stream_readline_file_crlf,
                    "test reading CRLF-terminated lines from file"),
+    SVN_TEST_PASS2(test_stream_read_ahead,
+                   "test read-ahead streams"),
+    SVN_TEST_PASS2(test_stream_copy_files,
+                   "test svn_stream_copy3 between files"),
     SVN_TEST_NULL
   };
 
@@ -500,6 +500,93 @@ test_svn_subst_long_keywords(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Read all of STREAM in blocks of BLOCK_SIZE bytes and return the data
+   in *RESULT. */
+static svn_error_t *
+read_in_blocks(svn_stringbuf_t **result,
+               svn_stream_t *stream,
+               apr_size_t block_size,
+               apr_pool_t *pool)
+{
+  char *buffer = apr_palloc(pool, block_size);
+  apr_size_t len;
+
+  *result = svn_stringbuf_create_empty(pool);
+  do
+    {
+      len = block_size;
+      SVN_ERR(svn_stream_read_full(stream, buffer, &len));
+      svn_stringbuf_appendbytes(*result, buffer, len);
+    }
+  while (len == block_size);
+
+  return SVN_NO_ERROR;
+}
+
+/* Translated streams copy chunks without interesting characters straight
+   through.  Make sure that runs of such chunks mixed with EOLs and
+   keywords -- some of them spanning chunk boundaries -- are translated
+   correctly no matter how the data gets read or written. */
+static svn_error_t *
+test_svn_subst_translate_passthrough(apr_pool_t *pool)
+{
+  static const apr_size_t block_sizes[]
+    = { 1, 7, 1000, SVN__STREAM_CHUNK_SIZE, 3 * SVN__STREAM_CHUNK_SIZE };
+  svn_stringbuf_t *source = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *expected = svn_stringbuf_create_empty(pool);
+  apr_hash_t *keywords = apr_hash_make(pool);
+  apr_size_t i;
+
+  svn_hash_sets(keywords, "Rev", svn_string_create("42", pool));
+
+  /* Three chunks of boring data, then a keyword and an EOL straddling
+     the chunk boundaries, then another boring chunk. */
+  for (i = 0; i < 4; ++i)
+    {
+      svn_stringbuf_t *boring
+        = svn_stringbuf_create_ensure(SVN__STREAM_CHUNK_SIZE, pool);
+      while (boring->len < SVN__STREAM_CHUNK_SIZE - 3)
+        svn_stringbuf_appendbyte(boring, (char)('a' + boring->len % 26));
+
+      svn_stringbuf_appendstr(source, boring);
+      svn_stringbuf_appendstr(expected, boring);
+      if (i == 1)
+        {
+          svn_stringbuf_appendcstr(source, "$Rev$\n");
+          svn_stringbuf_appendcstr(expected, "$Rev: 42 $\r\n");
+        }
+      else if (i == 2)
+        {
+          svn_stringbuf_appendcstr(source, "xx\r\n");
+          svn_stringbuf_appendcstr(expected, "xx\r\n");
+        }
+    }
+
+  for (i = 0; i < ARRAY_LEN(block_sizes); ++i)
+    {
+      svn_stringbuf_t *result;
+      svn_stream_t *stream;
+
+      /* Read-side translation. */
+      stream = svn_subst_stream_translated(
+                 svn_stream_from_stringbuf(source, pool), "\r\n", FALSE,
+                 keywords, TRUE, pool);
+      SVN_ERR(read_in_blocks(&result, stream, block_sizes[i], pool));
+      SVN_TEST_ASSERT(svn_stringbuf_compare(result, expected));
+
+      /* Write-side translation. */
+      result = svn_stringbuf_create_empty(pool);
+      stream = svn_subst_stream_translated(
+                 svn_stream_from_stringbuf(result, pool), "\r\n", FALSE,
+                 keywords, TRUE, pool);
+      SVN_ERR(svn_stream_write(stream, source->data, &source->len));
+      SVN_ERR(svn_stream_close(stream));
+      SVN_TEST_ASSERT(svn_stringbuf_compare(result, expected));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 static int max_threads = 1;
 
 static struct svn_test_descriptor_t test_funcs[] =
@@ -519,6 +606,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test truncated keywords (issue 4349)"),
     SVN_TEST_PASS2(test_svn_subst_long_keywords,
                    "test long keywords (issue 4350)"),
+    SVN_TEST_PASS2(test_svn_subst_translate_passthrough,
+                   "test translation pass-through of boring chunks"),
     SVN_TEST_NULL
   };
 
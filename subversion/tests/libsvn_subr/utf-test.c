@@ -215,6 +215,130 @@ utf_validate2(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Write the UTF-8 encoding of a random, valid code point to BUF and
+   return its length, i.e. 1 to 4 bytes.  About half the characters
+   will be ASCII. */
+static apr_size_t
+random_utf8_char(char *buf)
+{
+  apr_uint32_t cp;
+
+  switch (range_rand(0, 7))
+    {
+      case 0: case 1: case 2: case 3:
+        buf[0] = (char)range_rand(1, 0x7F);
+        return 1;
+
+      case 4:
+        cp = range_rand(0x80, 0x7FF);
+        buf[0] = (char)(0xC0 | (cp >> 6));
+        buf[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+
+      case 5: case 6:
+        do
+          cp = range_rand(0x800, 0xFFFF);
+        while (cp >= 0xD800 && cp <= 0xDFFF);
+        buf[0] = (char)(0xE0 | (cp >> 12));
+        buf[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        buf[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+
+      default:
+        cp = range_rand(0x10000, 0x10FFFF);
+        buf[0] = (char)(0xF0 | (cp >> 18));
+        buf[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+        buf[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        buf[3] = (char)(0x80 | (cp & 0x3F));
+        return 4;
+    }
+}
+
+/* Fill BUF with LEN bytes of valid UTF-8 text, padded with ASCII. */
+static void
+random_utf8_string(char *buf, apr_size_t len)
+{
+  apr_size_t pos = 0;
+  while (pos + 4 <= len)
+    pos += random_utf8_char(buf + pos);
+  while (pos < len)
+    buf[pos++] = 'x';
+}
+
+/* Compare the (possibly vectorized) default implementation against the
+   table-less one on mostly valid strings that are long enough for the
+   vectorized code to kick in.  Errors are injected at random positions,
+   so that they hit all positions within and across vector blocks. */
+static svn_error_t *
+utf_validate3(apr_pool_t *pool)
+{
+  char str[1024];
+  int i;
+
+  seed_val();
+
+  for (i = 0; i < 20000; ++i)
+    {
+      apr_size_t len = range_rand(0, sizeof(str));
+      apr_size_t offset = range_rand(0, 31);
+      int errors = (int)range_rand(0, 3);
+      const char *start;
+
+      random_utf8_string(str, sizeof(str));
+      if (offset > len)
+        offset = len;
+
+      for (; errors > 0 && len > 0; --errors)
+        str[range_rand(0, (apr_uint32_t)len - 1)] = (char)range_rand(0, 255);
+
+      start = str + offset;
+      len -= offset;
+      if (svn_utf__last_valid(start, len) != svn_utf__last_valid2(start, len)
+          || svn_utf__is_valid(start, len)
+             != (svn_utf__last_valid2(start, len) == start + len))
+        return svn_error_createf
+          (SVN_ERR_TEST_FAILED, NULL, "is_valid3 test %d failed "
+           "(%s validator)", i, svn_utf__validator_implementation());
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Report the throughput of the default and the table-less validator on
+   valid UTF-8 data.  This is a benchmark rather than a test; it only
+   fails if the two implementations disagree. */
+static svn_error_t *
+utf_validate_throughput(const svn_test_opts_t *opts,
+                        apr_pool_t *pool)
+{
+  const apr_size_t len = 4 * 1024 * 1024;
+  const int repeats = 10;
+  char *str = apr_palloc(pool, len);
+  apr_time_t start, fast, reference;
+  int i;
+
+  seed_val();
+  random_utf8_string(str, len);
+
+  start = apr_time_now();
+  for (i = 0; i < repeats; ++i)
+    SVN_TEST_ASSERT(svn_utf__is_valid(str, len));
+  fast = apr_time_now() - start;
+
+  start = apr_time_now();
+  for (i = 0; i < repeats; ++i)
+    SVN_TEST_ASSERT(svn_utf__last_valid2(str, len) == str + len);
+  reference = apr_time_now() - start;
+
+  if (opts->verbose)
+    printf("%s validator: %.0f MB/s, table-less FSM: %.0f MB/s\n",
+           svn_utf__validator_implementation(),
+           (double)len * repeats / (fast ? fast : 1),
+           (double)len * repeats / (reference ? reference : 1));
+
+  return SVN_NO_ERROR;
+}
+
 /* Test conversion from different codepages to utf8. */
 static svn_error_t *
 test_utf_cstring_to_utf8_ex2(apr_pool_t *pool)
@@ -984,6 +1108,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test is_valid/last_valid"),
     SVN_TEST_PASS2(utf_validate2,
                    "test last_valid/last_valid2"),
+    SVN_TEST_PASS2(utf_validate3,
+                   "test vectorized utf-8 validation"),
+    SVN_TEST_OPTS_PASS(utf_validate_throughput,
+                       "utf-8 validation throughput"),
     SVN_TEST_PASS2(test_utf_cstring_to_utf8_ex2,
                    "test svn_utf_cstring_to_utf8_ex2"),
     SVN_TEST_PASS2(test_utf_cstring_from_utf8_ex2,
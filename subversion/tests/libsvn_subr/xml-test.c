@@ -21,6 +21,7 @@
  */
 
 #include <apr.h>
+#include <apr_strings.h>
 
 #include "svn_pools.h"
 #include "svn_string.h"
@@ -226,6 +227,58 @@ test_parser_free(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_xml_escape(apr_pool_t *pool)
+{
+  const char *padding = "0123456789abcdefghijklmnopqrstuvwxyz0123456789";
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  /* Put the special chars at all positions relative to the blocks that
+     the scanner may process at once. */
+  for (i = 0; i < 40; i++)
+    {
+      const char *prefix = apr_pstrndup(pool, padding, i);
+      const char *suffix = padding + i;
+      svn_stringbuf_t *escaped = NULL;
+
+      svn_pool_clear(iterpool);
+
+      svn_xml_escape_cdata_cstring(&escaped,
+                                   apr_pstrcat(iterpool, prefix,
+                                               "<a&b>\r\"'\n\t", suffix,
+                                               SVN_VA_NULL),
+                                   iterpool);
+      SVN_TEST_STRING_ASSERT(escaped->data,
+                             apr_pstrcat(iterpool, prefix,
+                                         "&lt;a&amp;b&gt;&#13;\"'\n\t",
+                                         suffix, SVN_VA_NULL));
+
+      escaped = NULL;
+      svn_xml_escape_attr_cstring(&escaped,
+                                  apr_pstrcat(iterpool, prefix,
+                                              "<a&b>\r\"'\n\t", suffix,
+                                              SVN_VA_NULL),
+                                  iterpool);
+      SVN_TEST_STRING_ASSERT(escaped->data,
+                             apr_pstrcat(iterpool, prefix,
+                                         "&lt;a&amp;b&gt;&#13;&quot;&apos;"
+                                         "&#10;&#9;", suffix, SVN_VA_NULL));
+
+      /* Nothing to escape; append to existing contents. */
+      escaped = svn_stringbuf_create("x", iterpool);
+      svn_xml_escape_attr_cstring(&escaped, suffix, iterpool);
+      svn_xml_escape_cdata_cstring(&escaped, prefix, iterpool);
+      SVN_TEST_STRING_ASSERT(escaped->data,
+                             apr_pstrcat(iterpool, "x", suffix, prefix,
+                                         SVN_VA_NULL));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* The test table.  */
 static int max_threads = 1;
 
@@ -242,6 +295,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test svn_xml_signal_bailout() for invalid XML"),
     SVN_TEST_PASS2(test_parser_free,
                    "test svn_xml_parser_free()"),
+    SVN_TEST_PASS2(test_xml_escape,
+                   "test XML escaping"),
     SVN_TEST_NULL
   };
 
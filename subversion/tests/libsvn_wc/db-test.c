@@ -34,7 +34,9 @@
 #define SVN_DEPRECATED
 #include "svn_io.h"
 
+#include "svn_config.h"
 #include "svn_dirent_uri.h"
+#include "svn_hash.h"
 #include "svn_pools.h"
 
 #include "private/svn_sqlite.h"
@@ -1525,6 +1527,215 @@ test_externals_store(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_node_cache(apr_pool_t *pool)
+{
+  svn_wc__db_t *db;
+  const char *local_abspath;
+  const char *f_abspath;
+  svn_config_t *config;
+  svn_wc__db_status_t status;
+  const char *repos_relpath;
+  const char *repos_root_url;
+  const char *changelist;
+  svn_error_t *err;
+
+  SVN_ERR(create_open(&db, &local_abspath, "test_node_cache", pool));
+  SVN_ERR(svn_wc__db_close(db));
+
+  SVN_ERR(svn_config_create2(&config, FALSE, FALSE, pool));
+  svn_config_set_bool(config, SVN_CONFIG_SECTION_WORKING_COPY,
+                      SVN_CONFIG_OPTION_NODE_CACHE, TRUE);
+  SVN_ERR(svn_wc__db_open(&db, config, FALSE, TRUE, pool, pool));
+
+  f_abspath = svn_dirent_join(local_abspath, "F", pool);
+
+  /* Read the same node twice; the second read is served from the cache. */
+  SVN_ERR(svn_wc__db_read_info(&status, NULL, NULL,
+                               &repos_relpath, &repos_root_url, NULL,
+                               NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL,
+                               &changelist, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL,
+                               db, f_abspath,
+                               pool, pool));
+  SVN_TEST_ASSERT(status == svn_wc__db_status_normal);
+  SVN_TEST_STRING_ASSERT(repos_relpath, "F");
+  SVN_TEST_STRING_ASSERT(repos_root_url, ROOT_ONE);
+  SVN_TEST_ASSERT(changelist == NULL);
+
+  SVN_ERR(svn_wc__db_read_info(&status, NULL, NULL,
+                               &repos_relpath, &repos_root_url, NULL,
+                               NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL,
+                               db, f_abspath,
+                               pool, pool));
+  SVN_TEST_ASSERT(status == svn_wc__db_status_normal);
+  SVN_TEST_STRING_ASSERT(repos_relpath, "F");
+  SVN_TEST_STRING_ASSERT(repos_root_url, ROOT_ONE);
+
+  /* Changes made through the same db must be visible immediately. */
+  SVN_ERR(svn_wc__db_global_relocate(db, local_abspath, ROOT_THREE, pool));
+  SVN_ERR(svn_wc__db_op_set_changelist(db, f_abspath, "my-list", NULL,
+                                       svn_depth_empty, NULL, NULL,
+                                       NULL, NULL, pool));
+
+  SVN_ERR(svn_wc__db_read_info(NULL, NULL, NULL,
+                               NULL, &repos_root_url, NULL,
+                               NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL,
+                               &changelist, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL,
+                               db, f_abspath,
+                               pool, pool));
+  SVN_TEST_STRING_ASSERT(repos_root_url, ROOT_THREE);
+  SVN_TEST_STRING_ASSERT(changelist, "my-list");
+
+  /* Lookup failures are not cached. */
+  err = svn_wc__db_read_info(NULL, NULL, NULL, NULL, NULL, NULL,
+                             NULL, NULL, NULL, NULL,
+                             NULL, NULL, NULL, NULL,
+                             NULL, NULL, NULL, NULL, NULL,
+                             NULL, NULL, NULL, NULL, NULL,
+                             NULL, NULL, NULL,
+                             db, svn_dirent_join(local_abspath, "missing",
+                                                 pool),
+                             pool, pool);
+  SVN_TEST_ASSERT_ERROR(err, SVN_ERR_WC_PATH_NOT_FOUND);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_read_descendants_info(apr_pool_t *pool)
+{
+  svn_wc__db_t *db;
+  const char *local_abspath;
+  apr_hash_t *nodes_by_dir;
+  apr_hash_t *conflicts_by_dir;
+  apr_hash_index_t *hi;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  SVN_ERR(create_open(&db, &local_abspath, "test_read_descendants_info",
+                      pool));
+
+  SVN_ERR(svn_wc__db_read_descendants_info(&nodes_by_dir, &conflicts_by_dir,
+                                           db, local_abspath, pool, pool));
+  SVN_TEST_ASSERT(svn_hash_gets(nodes_by_dir, local_abspath) != NULL);
+  SVN_TEST_ASSERT(svn_hash_gets(nodes_by_dir,
+                                svn_dirent_join(local_abspath, "I",
+                                                pool)) != NULL);
+
+  /* Every directory must look exactly like it does when read on its own. */
+  for (hi = apr_hash_first(pool, nodes_by_dir); hi; hi = apr_hash_next(hi))
+    {
+      const char *dir_abspath = apr_hash_this_key(hi);
+      apr_hash_t *dir_nodes = apr_hash_this_val(hi);
+      apr_hash_t *dir_conflicts = svn_hash_gets(conflicts_by_dir,
+                                                dir_abspath);
+      apr_hash_t *nodes;
+      apr_hash_t *conflicts;
+      apr_hash_index_t *hi2;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_wc__db_read_children_info(&nodes, &conflicts, db,
+                                            dir_abspath, FALSE,
+                                            iterpool, iterpool));
+
+      SVN_TEST_ASSERT(apr_hash_count(dir_nodes) == apr_hash_count(nodes));
+      SVN_TEST_ASSERT(apr_hash_count(dir_conflicts)
+                      == apr_hash_count(conflicts));
+
+      for (hi2 = apr_hash_first(iterpool, nodes); hi2;
+           hi2 = apr_hash_next(hi2))
+        {
+          const struct svn_wc__db_info_t *expected = apr_hash_this_val(hi2);
+          const struct svn_wc__db_info_t *info
+            = svn_hash_gets(dir_nodes, apr_hash_this_key(hi2));
+
+          SVN_TEST_ASSERT(info != NULL);
+          SVN_TEST_ASSERT(info->status == expected->status);
+          SVN_TEST_ASSERT(info->kind == expected->kind);
+          SVN_TEST_ASSERT(info->revnum == expected->revnum);
+          SVN_TEST_STRING_ASSERT(info->repos_relpath,
+                                 expected->repos_relpath);
+          SVN_TEST_ASSERT(info->op_root == expected->op_root);
+          SVN_TEST_ASSERT(info->have_base == expected->have_base);
+          SVN_TEST_ASSERT(info->have_more_work == expected->have_more_work);
+          SVN_TEST_ASSERT(info->conflicted == expected->conflicted);
+          SVN_TEST_ASSERT(info->has_descendants == expected->has_descendants);
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_base_get_descendants_info(apr_pool_t *pool)
+{
+  svn_wc__db_t *db;
+  const char *local_abspath;
+  apr_hash_t *nodes_by_dir;
+  apr_hash_index_t *hi;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  SVN_ERR(create_open(&db, &local_abspath, "test_base_get_descendants_info",
+                      pool));
+
+  SVN_ERR(svn_wc__db_base_get_descendants_info(&nodes_by_dir, db,
+                                               local_abspath, pool, pool));
+  SVN_TEST_ASSERT(svn_hash_gets(nodes_by_dir, local_abspath) != NULL);
+
+  /* Every directory must look exactly like it does when read on its own. */
+  for (hi = apr_hash_first(pool, nodes_by_dir); hi; hi = apr_hash_next(hi))
+    {
+      const char *dir_abspath = apr_hash_this_key(hi);
+      apr_hash_t *dir_nodes = apr_hash_this_val(hi);
+      apr_hash_t *nodes;
+      apr_hash_index_t *hi2;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_wc__db_base_get_children_info(&nodes, db, dir_abspath,
+                                                iterpool, iterpool));
+
+      SVN_TEST_ASSERT(apr_hash_count(dir_nodes) == apr_hash_count(nodes));
+
+      for (hi2 = apr_hash_first(iterpool, nodes); hi2;
+           hi2 = apr_hash_next(hi2))
+        {
+          const struct svn_wc__db_base_info_t *expected
+            = apr_hash_this_val(hi2);
+          const struct svn_wc__db_base_info_t *info
+            = svn_hash_gets(dir_nodes, apr_hash_this_key(hi2));
+
+          SVN_TEST_ASSERT(info != NULL);
+          SVN_TEST_ASSERT(info->status == expected->status);
+          SVN_TEST_ASSERT(info->kind == expected->kind);
+          SVN_TEST_ASSERT(info->revnum == expected->revnum);
+          SVN_TEST_ASSERT(info->depth == expected->depth);
+          SVN_TEST_ASSERT(info->update_root == expected->update_root);
+          SVN_TEST_ASSERT((info->lock == NULL) == (expected->lock == NULL));
+          SVN_TEST_STRING_ASSERT(info->repos_relpath,
+                                 expected->repos_relpath);
+          SVN_TEST_STRING_ASSERT(info->repos_root_url,
+                                 expected->repos_root_url);
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 static int max_threads = 2;
 
 static struct svn_test_descriptor_t test_funcs[] =
@@ -1550,6 +1761,12 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "work queue processing"),
     SVN_TEST_PASS2(test_externals_store,
                    "externals store"),
+    SVN_TEST_PASS2(test_node_cache,
+                   "caching node information"),
+    SVN_TEST_PASS2(test_read_descendants_info,
+                   "reading the children of a whole tree"),
+    SVN_TEST_PASS2(test_base_get_descendants_info,
+                   "reading the BASE children of a whole tree"),
     SVN_TEST_NULL
   };
 
@@ -34,6 +34,7 @@
 #define SVN_DEPRECATED
 #include "svn_io.h"
 
+#include "svn_config.h"
 #include "svn_dirent_uri.h"
 #include "svn_pools.h"
 #include "svn_repos.h"
@@ -306,6 +307,92 @@ reject_mismatching_text(const svn_test_opts_t *opts,
 #endif
 }
 
+/* Install, read and remove a pristine text stored compressed. */
+static svn_error_t *
+pristine_compressed(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_wc__db_t *db;
+  const char *wc_abspath;
+  svn_config_t *config;
+  svn_wc__db_install_data_t *install_data;
+  svn_stream_t *pristine_stream;
+  svn_checksum_t *data_sha1, *data_md5;
+  svn_stringbuf_t *data = svn_stringbuf_create_empty(pool);
+  apr_size_t sz;
+  int i;
+
+  SVN_ERR(create_repos_and_wc(&wc_abspath, &db,
+                              "pristine_compressed", opts, pool));
+
+  SVN_ERR(svn_config_create2(&config, FALSE, FALSE, pool));
+  svn_config_set_bool(config, SVN_CONFIG_SECTION_WORKING_COPY,
+                      SVN_CONFIG_OPTION_COMPRESS_PRISTINES, TRUE);
+  SVN_ERR(svn_wc__db_open(&db, config, FALSE, TRUE, pool, pool));
+
+  for (i = 0; i < 1000; i++)
+    svn_stringbuf_appendcstr(data, "A very compressible line of text.\n");
+
+  SVN_ERR(svn_wc__db_pristine_prepare_install(&pristine_stream,
+                                              &install_data,
+                                              &data_sha1, &data_md5,
+                                              db, wc_abspath,
+                                              pool, pool));
+  sz = data->len;
+  SVN_ERR(svn_stream_write(pristine_stream, data->data, &sz));
+  SVN_ERR(svn_stream_close(pristine_stream));
+  SVN_ERR(svn_wc__db_pristine_install(install_data,
+                                      data_sha1, data_md5, pool));
+
+  /* The store reports the size of the text, but the file is smaller. */
+  {
+    svn_boolean_t present;
+    svn_boolean_t compressed;
+    svn_filesize_t size;
+    svn_stream_t *data_read_back;
+    svn_boolean_t same;
+    const char *pristine_abspath;
+    apr_finfo_t finfo;
+
+    SVN_ERR(svn_wc__db_pristine_check(&present, db, wc_abspath, data_sha1,
+                                      pool));
+    SVN_TEST_ASSERT(present);
+
+    SVN_ERR(svn_wc__db_pristine_read(&data_read_back, &size, db, wc_abspath,
+                                     data_sha1, pool, pool));
+    SVN_TEST_ASSERT(size == data->len);
+    SVN_ERR(svn_stream_contents_same2(&same, data_read_back,
+                                      svn_stream_from_stringbuf(data, pool),
+                                      pool));
+    SVN_TEST_ASSERT(same);
+
+    SVN_ERR(svn_wc__db_pristine_get_file(&pristine_abspath, &compressed,
+                                         db, wc_abspath, data_sha1,
+                                         pool, pool));
+    SVN_TEST_ASSERT(compressed);
+    SVN_ERR(svn_io_stat(&finfo, pristine_abspath, APR_FINFO_SIZE, pool));
+    SVN_TEST_ASSERT(finfo.size < size);
+
+    /* Callers wanting a path get a decompressed copy. */
+    SVN_ERR(svn_wc__db_pristine_get_path(&pristine_abspath, db, wc_abspath,
+                                         data_sha1, pool, pool));
+    SVN_ERR(svn_io_stat(&finfo, pristine_abspath, APR_FINFO_SIZE, pool));
+    SVN_TEST_ASSERT(finfo.size == size);
+  }
+
+  /* Removing it removes the compressed file. */
+  {
+    svn_boolean_t present;
+
+    SVN_ERR(svn_wc__db_pristine_remove(db, wc_abspath, data_sha1, pool));
+    SVN_ERR(svn_wc__db_pristine_check(&present, db, wc_abspath, data_sha1,
+                                      pool));
+    SVN_TEST_ASSERT(! present);
+  }
+
+  return SVN_NO_ERROR;
+}
+
 
 static int max_threads = -1;
 
@@ -318,6 +405,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "pristine_delete_while_open"),
     SVN_TEST_OPTS_PASS(reject_mismatching_text,
                        "reject_mismatching_text"),
+    SVN_TEST_OPTS_PASS(pristine_compressed,
+                       "pristine_compressed"),
     SVN_TEST_NULL
   };
 
@@ -493,6 +493,111 @@ test_internal_file_modified(const svn_test_opts_t *opts, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_forget_racy_timestamps(const svn_test_opts_t *opts, apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  svn_boolean_t modified;
+  const char *iota_path;
+  const char *mu_path;
+  apr_time_t time;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "forget_racy_timestamps",
+                                   opts, pool));
+  SVN_ERR(sbox_add_and_commit_greek_tree(&b));
+
+  iota_path = sbox_wc_path(&b, "iota");
+  mu_path = sbox_wc_path(&b, "A/mu");
+
+  /* Modify 'iota' without changing its size or timestamp, as if it was
+     written again within the timestamp resolution of the filesystem. */
+  SVN_ERR(svn_io_file_affected_time(&time, iota_path, pool));
+  SVN_ERR(sbox_file_write(&b, "iota", "This is the file 'IOTA'.\n"));
+  SVN_ERR(svn_io_set_file_affected_time(time, iota_path, pool));
+  SVN_ERR(svn_wc__internal_file_modified_p(&modified, b.wc_ctx->db,
+                                           iota_path, FALSE, pool));
+  SVN_TEST_ASSERT(!modified);
+
+  /* Forgetting the timestamp makes the change visible, while files
+     written earlier keep theirs. */
+  SVN_ERR(svn_io_file_affected_time(&time, mu_path, pool));
+  SVN_ERR(svn_wc__db_global_record_fileinfo(b.wc_ctx->db, mu_path,
+                                            SVN_INVALID_FILESIZE,
+                                            time - apr_time_from_sec(10),
+                                            pool));
+  SVN_ERR(svn_wc__db_global_forget_racy_timestamps(
+            b.wc_ctx->db, b.wc_abspath, time - apr_time_from_sec(5),
+            pool));
+
+  SVN_ERR(svn_wc__internal_file_modified_p(&modified, b.wc_ctx->db,
+                                           iota_path, FALSE, pool));
+  SVN_TEST_ASSERT(modified);
+
+  {
+    apr_time_t recorded_time;
+
+    SVN_ERR(svn_wc__db_read_info(NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                                 NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                                 NULL, NULL, NULL, NULL, &recorded_time,
+                                 NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                                 NULL, b.wc_ctx->db, mu_path, pool, pool));
+    SVN_TEST_ASSERT(recorded_time == time - apr_time_from_sec(10));
+  }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_internal_children_modified(const svn_test_opts_t *opts,
+                                apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  const char *g_path, *pi_path;
+  apr_hash_t *children, *conflicts, *modified;
+  const svn_boolean_t *pi_modified, *rho_modified;
+  apr_time_t time, recorded_time;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "internal_children_modified",
+                                   opts, pool));
+  SVN_ERR(sbox_add_and_commit_greek_tree(&b));
+
+  g_path = sbox_wc_path(&b, "A/D/G");
+  pi_path = sbox_wc_path(&b, "A/D/G/pi");
+
+  /* Touch 'pi', change 'rho' without changing its size and leave 'tau'
+     alone. */
+  SVN_ERR(svn_io_file_affected_time(&time, pi_path, pool));
+  SVN_ERR(svn_io_set_file_affected_time(time + apr_time_from_sec(1),
+                                        pi_path, pool));
+  SVN_ERR(sbox_file_write(&b, "A/D/G/rho", "This is the file 'RHO'.\n"));
+
+  SVN_ERR(svn_wc__db_wclock_obtain(b.wc_ctx->db, b.wc_abspath, -1, FALSE,
+                                   pool));
+  SVN_ERR(svn_wc__db_read_children_info(&children, &conflicts,
+                                        b.wc_ctx->db, g_path, FALSE,
+                                        pool, pool));
+  SVN_ERR(svn_wc__internal_children_modified(&modified, b.wc_ctx->db,
+                                             g_path, children, NULL, FALSE,
+                                             NULL, NULL, pool, pool));
+  SVN_ERR(svn_wc__db_wclock_release(b.wc_ctx->db, b.wc_abspath, pool));
+
+  pi_modified = svn_hash_gets(modified, "pi");
+  rho_modified = svn_hash_gets(modified, "rho");
+  SVN_TEST_ASSERT(pi_modified && !*pi_modified);
+  SVN_TEST_ASSERT(rho_modified && *rho_modified);
+  SVN_TEST_ASSERT(svn_hash_gets(modified, "tau") == NULL);
+
+  /* The new timestamp of 'pi' got recorded. */
+  SVN_ERR(svn_wc__db_read_info(NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, &recorded_time,
+                               NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, b.wc_ctx->db, pi_path, pool, pool));
+  SVN_TEST_ASSERT(recorded_time == time + apr_time_from_sec(1));
+
+  return SVN_NO_ERROR;
+}
+
 /* ---------------------------------------------------------------------- */
 /* The list of test functions */
 
@@ -515,6 +620,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test legacy commit2"),
     SVN_TEST_OPTS_PASS(test_internal_file_modified,
                        "test internal_file_modified"),
+    SVN_TEST_OPTS_PASS(test_forget_racy_timestamps,
+                       "test forgetting racy timestamps"),
+    SVN_TEST_OPTS_PASS(test_internal_children_modified,
+                       "test internal_children_modified"),
     SVN_TEST_NULL
   };
 
@@ -0,0 +1,721 @@
+/* subr-bench.c -- throughput of frequently used libsvn_subr primitives
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* Run each benchmark a fixed number of times on deterministic input and
+ * print a JSON report with the time and the pool memory used per call.
+ * The report lists the benchmarks in a fixed order and only contains
+ * numbers that depend on the code being measured, so reports of
+ * different builds can be compared with simple tools.
+ *
+ * Pool memory can only be measured if APR has been built with pool
+ * debugging; it is reported as null otherwise.
+ */
+
+#include <string.h>
+
+#include <apr_pools.h>
+#include <apr_time.h>
+
+#include "svn_base64.h"
+#include "svn_checksum.h"
+#include "svn_cmdline.h"
+#include "svn_delta.h"
+#include "svn_hash.h"
+#include "svn_pools.h"
+#include "svn_string.h"
+#include "svn_subst.h"
+#include "svn_version.h"
+
+#include "private/svn_cache.h"
+#include "private/svn_packed_data.h"
+#include "private/svn_string_private.h"
+#include "private/svn_subr_private.h"
+#include "private/svn_temp_serializer.h"
+#include "private/svn_utf_private.h"
+
+#include "svn_private_config.h"
+
+/* Size of the text that most benchmarks process per call. */
+#define TEXT_SIZE 0x10000
+
+/* Number of entries in the cache and in the hash file. */
+#define KEY_COUNT 1024
+
+/* Size of each cache entry. */
+#define CACHE_ITEM_SIZE 1024
+
+/* Number of integers in the packed data. */
+#define PACKED_INT_COUNT 4096
+
+/* Each benchmark is run this many times and the fastest run is reported. */
+#define RUNS 5
+
+/* Default number of calls per run. */
+#define DEFAULT_ITERATIONS 1000
+
+/* A structure with some sub-structures, like the ones that the FS layers
+ * put into caches. */
+typedef struct bench_node_t
+{
+  const char *name;
+  apr_int64_t size;
+  struct bench_node_t *next;
+} bench_node_t;
+
+/* The inputs of all benchmarks. */
+typedef struct bench_data_t
+{
+  /* TEXT_SIZE bytes of UTF-8 text with LF line endings. */
+  svn_string_t *text;
+
+  /* TEXT in base64 and compressed. */
+  svn_string_t *base64;
+  svn_stringbuf_t *compressed;
+
+  /* A membuffer cache with KEY_COUNT entries named KEYS. */
+  svn_cache__t *cache;
+  const char *keys[KEY_COUNT];
+  svn_string_t *cache_item;
+
+  /* Counts the cache accesses, so they cycle through all keys. */
+  int cache_access;
+
+  /* PACKED_INT_COUNT integers and some byte sequences, packed. */
+  svn_stringbuf_t *packed;
+
+  /* A list of KEY_COUNT nodes and its serialized form. */
+  bench_node_t *nodes;
+  svn_stringbuf_t *serialized;
+
+  /* A hash with KEY_COUNT entries and its hash file representation. */
+  apr_hash_t *hash;
+  svn_stringbuf_t *hash_file;
+} bench_data_t;
+
+/* Do one operation on DATA.  Set *BYTES to the amount of input processed.
+ * Allocate everything in POOL. */
+typedef svn_error_t *(*bench_func_t)(apr_size_t *bytes,
+                                     bench_data_t *data,
+                                     apr_pool_t *pool);
+
+/* Return the next value of the pseudo-random sequence in *SEED. */
+static apr_uint32_t
+next_random(apr_uint32_t *seed)
+{
+  *seed = *seed * 1103515245 + 12345;
+  return *seed >> 8;
+}
+
+/* Implements svn_cache__serialize_func_t for svn_string_t. */
+static svn_error_t *
+serialize_string(void **data,
+                 apr_size_t *data_len,
+                 void *in,
+                 apr_pool_t *pool)
+{
+  const svn_string_t *value = in;
+
+  *data_len = value->len;
+  *data = apr_pmemdup(pool, value->data, value->len);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_cache__deserialize_func_t for svn_string_t. */
+static svn_error_t *
+deserialize_string(void **out,
+                   void *data,
+                   apr_size_t data_len,
+                   apr_pool_t *pool)
+{
+  svn_string_t *value = apr_palloc(pool, sizeof(*value));
+
+  value->data = data;
+  value->len = data_len;
+  *out = value;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the list of NODES serialized into a buffer allocated in POOL. */
+static svn_stringbuf_t *
+serialize_nodes(bench_node_t *nodes,
+                apr_pool_t *pool)
+{
+  svn_temp_serializer__context_t *context;
+  bench_node_t *node;
+  const bench_node_t * const *ref = (const bench_node_t * const *)&nodes;
+  int depth = 0;
+
+  context = svn_temp_serializer__init(NULL, 0, 32 * KEY_COUNT, pool);
+
+  /* Serialize the list recursively, as a chain of sub-structures. */
+  for (node = nodes; node; node = node->next)
+    {
+      svn_temp_serializer__push(context, (const void * const *)ref,
+                                sizeof(*node));
+      svn_temp_serializer__add_string(context, &node->name);
+      ref = (const bench_node_t * const *)&node->next;
+      depth++;
+    }
+
+  while (depth--)
+    svn_temp_serializer__pop(context);
+
+  return svn_temp_serializer__get(context);
+}
+
+/* Create the inputs of all benchmarks in POOL. */
+static svn_error_t *
+create_data(bench_data_t **data_p,
+            apr_pool_t *pool)
+{
+  bench_data_t *data = apr_pcalloc(pool, sizeof(*data));
+  svn_stringbuf_t *text = svn_stringbuf_create_ensure(TEXT_SIZE, pool);
+  svn_membuffer_t *membuffer;
+  svn_packed__data_root_t *root;
+  svn_packed__int_stream_t *ints;
+  svn_packed__byte_stream_t *bytes;
+  svn_stream_t *stream;
+  apr_uint32_t seed = 42;
+  int i;
+
+  /* Words of plain and non-ASCII characters in lines of varying length. */
+  while (text->len < TEXT_SIZE - 8)
+    {
+      apr_uint32_t value = next_random(&seed);
+
+      if (value % 11 == 0)
+        svn_stringbuf_appendbyte(text, '\n');
+      else if (value % 7 == 0)
+        svn_stringbuf_appendcstr(text, "\xc3\xa4");
+      else if (value % 5 == 0)
+        svn_stringbuf_appendbyte(text, ' ');
+      else
+        svn_stringbuf_appendbyte(text, (char)('a' + value % 26));
+    }
+  svn_stringbuf_appendbyte(text, '\n');
+  data->text = svn_stringbuf__morph_into_string(text);
+
+  data->base64 = svn_base64_encode_string2(data->text, TRUE, pool);
+
+  data->compressed = svn_stringbuf_create_empty(pool);
+  SVN_ERR(svn__compress(data->text->data, data->text->len,
+                        data->compressed,
+                        SVN_DELTA_COMPRESSION_LEVEL_DEFAULT));
+
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 0x1000000, 0x100000,
+                                            0, FALSE, TRUE, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(&data->cache, membuffer,
+                                            serialize_string,
+                                            deserialize_string,
+                                            APR_HASH_KEY_STRING, "bench:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE, FALSE, pool, pool));
+  data->cache_item = svn_string_ncreate(data->text->data, CACHE_ITEM_SIZE,
+                                        pool);
+  for (i = 0; i < KEY_COUNT; i++)
+    {
+      data->keys[i] = apr_psprintf(pool, "key-%d", i);
+      SVN_ERR(svn_cache__set(data->cache, data->keys[i], data->cache_item,
+                             pool));
+    }
+
+  root = svn_packed__data_create_root(pool);
+  ints = svn_packed__create_int_stream(root, TRUE, FALSE);
+  bytes = svn_packed__create_bytes_stream(root);
+  for (i = 0; i < PACKED_INT_COUNT; i++)
+    {
+      svn_packed__add_uint(ints, i * 4 + next_random(&seed) % 4);
+      if (i % 16 == 0)
+        svn_packed__add_bytes(bytes, data->text->data + i, 16);
+    }
+  data->packed = svn_stringbuf_create_empty(pool);
+  SVN_ERR(svn_packed__data_write(svn_stream_from_stringbuf(data->packed,
+                                                           pool),
+                                 root, pool));
+
+  for (i = KEY_COUNT - 1; i >= 0; i--)
+    {
+      bench_node_t *node = apr_pcalloc(pool, sizeof(*node));
+
+      node->name = data->keys[i];
+      node->size = next_random(&seed);
+      node->next = data->nodes;
+      data->nodes = node;
+    }
+  data->serialized = serialize_nodes(data->nodes, pool);
+
+  data->hash = apr_hash_make(pool);
+  for (i = 0; i < KEY_COUNT; i++)
+    svn_hash_sets(data->hash, data->keys[i],
+                  svn_string_ncreate(data->text->data + i, 32, pool));
+  data->hash_file = svn_stringbuf_create_empty(pool);
+  stream = svn_stream_from_stringbuf(data->hash_file, pool);
+  SVN_ERR(svn_hash_write2(data->hash, stream, SVN_HASH_TERMINATOR, pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  *data_p = data;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+bench_membuffer_set(apr_size_t *bytes,
+                    bench_data_t *data,
+                    apr_pool_t *pool)
+{
+  const char *key = data->keys[data->cache_access++ % KEY_COUNT];
+
+  SVN_ERR(svn_cache__set(data->cache, key, data->cache_item, pool));
+  *bytes = data->cache_item->len;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+bench_membuffer_get(apr_size_t *bytes,
+                    bench_data_t *data,
+                    apr_pool_t *pool)
+{
+  const char *key = data->keys[data->cache_access++ % KEY_COUNT];
+  void *value;
+  svn_boolean_t found;
+
+  SVN_ERR(svn_cache__get(&value, &found, data->cache, key, pool));
+  *bytes = found ? ((svn_string_t *)value)->len : 0;
+
+  return SVN_NO_ERROR;
+}
+
+/* Checksum the text with KIND. */
+static svn_error_t *
+bench_checksum(apr_size_t *bytes,
+               bench_data_t *data,
+               svn_checksum_kind_t kind,
+               apr_pool_t *pool)
+{
+  svn_checksum_t *checksum;
+
+  SVN_ERR(svn_checksum(&checksum, kind, data->text->data, data->text->len,
+                       pool));
+  *bytes = data->text->len;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+bench_checksum_md5(apr_size_t *bytes,
+                   bench_data_t *data,
+                   apr_pool_t *pool)
+{
+  return bench_checksum(bytes, data, svn_checksum_md5, pool);
+}
+
+static svn_error_t *
+bench_checksum_sha1(apr_size_t *bytes,
+                    bench_data_t *data,
+                    apr_pool_t *pool)
+{
+  return bench_checksum(bytes, data, svn_checksum_sha1, pool);
+}
+
+static svn_error_t *
+bench_checksum_fnv1a(apr_size_t *bytes,
+                     bench_data_t *data,
+                     apr_pool_t *pool)
+{
+  return bench_checksum(bytes, data, svn_checksum_fnv1a_32x4, pool);
+}
+
+static svn_error_t *
+bench_base64_encode(apr_size_t *bytes,
+                    bench_data_t *data,
+                    apr_pool_t *pool)
+{
+  svn_base64_encode_string2(data->text, TRUE, pool);
+  *bytes = data->text->len;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+bench_base64_decode(apr_size_t *bytes,
+                    bench_data_t *data,
+                    apr_pool_t *pool)
+{
+  svn_base64_decode_string(data->base64, pool);
+  *bytes = data->base64->len;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+bench_utf8_validate(apr_size_t *bytes,
+                    bench_data_t *data,
+                    apr_pool_t *pool)
+{
+  if (! svn_utf__is_valid(data->text->data, data->text->len))
+    return svn_error_create(SVN_ERR_UTF8_GLOB, NULL, NULL);
+  *bytes = data->text->len;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+bench_eol_translate(apr_size_t *bytes,
+                    bench_data_t *data,
+                    apr_pool_t *pool)
+{
+  const char *translated;
+
+  SVN_ERR(svn_subst_translate_cstring2(data->text->data, &translated,
+                                       "\r\n", FALSE, NULL, FALSE, pool));
+  *bytes = data->text->len;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+bench_compress(apr_size_t *bytes,
+               bench_data_t *data,
+               apr_pool_t *pool)
+{
+  svn_stringbuf_t *out = svn_stringbuf_create_ensure(data->text->len, pool);
+
+  SVN_ERR(svn__compress(data->text->data, data->text->len, out,
+                        SVN_DELTA_COMPRESSION_LEVEL_DEFAULT));
+  *bytes = data->text->len;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+bench_decompress(apr_size_t *bytes,
+                 bench_data_t *data,
+                 apr_pool_t *pool)
+{
+  svn_stringbuf_t *out = svn_stringbuf_create_ensure(data->text->len, pool);
+
+  SVN_ERR(svn__decompress(data->compressed->data, data->compressed->len,
+                          out, data->text->len));
+  *bytes = data->text->len;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+bench_packed_encode(apr_size_t *bytes,
+                    bench_data_t *data,
+                    apr_pool_t *pool)
+{
+  svn_packed__data_root_t *root = svn_packed__data_create_root(pool);
+  svn_packed__int_stream_t *ints
+    = svn_packed__create_int_stream(root, TRUE, FALSE);
+  svn_packed__byte_stream_t *byte_stream
+    = svn_packed__create_bytes_stream(root);
+  svn_stringbuf_t *out = svn_stringbuf_create_empty(pool);
+  int i;
+
+  for (i = 0; i < PACKED_INT_COUNT; i++)
+    {
+      svn_packed__add_uint(ints, i * 4);
+      if (i % 16 == 0)
+        svn_packed__add_bytes(byte_stream, data->text->data + i, 16);
+    }
+
+  SVN_ERR(svn_packed__data_write(svn_stream_from_stringbuf(out, pool),
+                                 root, pool));
+  *bytes = out->len;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+bench_packed_decode(apr_size_t *bytes,
+                    bench_data_t *data,
+                    apr_pool_t *pool)
+{
+  svn_packed__data_root_t *root;
+  svn_packed__int_stream_t *ints;
+  apr_size_t count;
+
+  SVN_ERR(svn_packed__data_read(&root,
+                                svn_stream_from_stringbuf(data->packed,
+                                                          pool),
+                                pool, pool));
+
+  ints = svn_packed__first_int_stream(root);
+  for (count = svn_packed__int_count(ints); count > 0; count--)
+    svn_packed__get_uint(ints);
+
+  *bytes = data->packed->len;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+bench_serialize(apr_size_t *bytes,
+                bench_data_t *data,
+                apr_pool_t *pool)
+{
+  *bytes = serialize_nodes(data->nodes, pool)->len;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+bench_deserialize(apr_size_t *bytes,
+                  bench_data_t *data,
+                  apr_pool_t *pool)
+{
+  bench_node_t *nodes = apr_pmemdup(pool, data->serialized->data,
+                                    data->serialized->len);
+  bench_node_t *node;
+
+  /* Pointers are stored relative to the structure that contains them. */
+  for (node = nodes; node; node = node->next)
+    {
+      svn_temp_deserializer__resolve(node, (void **)&node->name);
+      svn_temp_deserializer__resolve(node, (void **)&node->next);
+    }
+
+  *bytes = data->serialized->len;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+bench_hash_read(apr_size_t *bytes,
+                bench_data_t *data,
+                apr_pool_t *pool)
+{
+  apr_hash_t *hash = apr_hash_make(pool);
+
+  SVN_ERR(svn_hash_read2(hash, svn_stream_from_stringbuf(data->hash_file,
+                                                         pool),
+                         SVN_HASH_TERMINATOR, pool));
+  *bytes = data->hash_file->len;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+bench_hash_write(apr_size_t *bytes,
+                 bench_data_t *data,
+                 apr_pool_t *pool)
+{
+  svn_stringbuf_t *out = svn_stringbuf_create_empty(pool);
+
+  SVN_ERR(svn_hash_write2(data->hash, svn_stream_from_stringbuf(out, pool),
+                          SVN_HASH_TERMINATOR, pool));
+  *bytes = out->len;
+
+  return SVN_NO_ERROR;
+}
+
+/* All benchmarks, in the order of the report. */
+static const struct
+{
+  const char *name;
+  bench_func_t func;
+} benchmarks[] =
+{
+  { "membuffer-set", bench_membuffer_set },
+  { "membuffer-get", bench_membuffer_get },
+  { "checksum-md5", bench_checksum_md5 },
+  { "checksum-sha1", bench_checksum_sha1 },
+  { "checksum-fnv1a-32x4", bench_checksum_fnv1a },
+  { "base64-encode", bench_base64_encode },
+  { "base64-decode", bench_base64_decode },
+  { "utf8-validate", bench_utf8_validate },
+  { "eol-translate", bench_eol_translate },
+  { "compress", bench_compress },
+  { "decompress", bench_decompress },
+  { "packed-encode", bench_packed_encode },
+  { "packed-decode", bench_packed_decode },
+  { "serialize", bench_serialize },
+  { "deserialize", bench_deserialize },
+  { "hash-read", bench_hash_read },
+  { "hash-write", bench_hash_write },
+  { NULL, NULL }
+};
+
+/* Return the number of bytes allocated in POOL, if APR can tell. */
+static apr_size_t
+pool_bytes(apr_pool_t *pool)
+{
+#if APR_POOL_DEBUG
+  return apr_pool_num_bytes(pool, TRUE);
+#else
+  return 0;
+#endif
+}
+
+/* Run FUNC ITERATIONS times, RUNS times over, on DATA and print the
+ * result as JSON object called NAME.  Prefix it with a comma, unless it
+ * is the FIRST one. */
+static svn_error_t *
+run_benchmark(const char *name,
+              bench_func_t func,
+              bench_data_t *data,
+              int iterations,
+              svn_boolean_t first,
+              apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_time_t best = 0;
+  apr_size_t bytes = 0;
+  apr_size_t allocated = 0;
+  double ns_per_op;
+  int run, i;
+
+  /* Warm up the caches and measure the memory usage once. */
+  SVN_ERR(func(&bytes, data, iterpool));
+  allocated = pool_bytes(iterpool);
+
+  for (run = 0; run < RUNS; run++)
+    {
+      apr_time_t start = apr_time_now();
+      apr_time_t elapsed;
+
+      for (i = 0; i < iterations; i++)
+        {
+          svn_pool_clear(iterpool);
+          SVN_ERR(func(&bytes, data, iterpool));
+        }
+
+      elapsed = apr_time_now() - start;
+      if (run == 0 || elapsed < best)
+        best = elapsed;
+    }
+  svn_pool_destroy(iterpool);
+
+  ns_per_op = best * 1000.0 / iterations;
+  SVN_ERR(svn_cmdline_printf(pool,
+                             "%s    {\"name\": \"%s\", \"bytes-per-op\": %"
+                             APR_SIZE_T_FMT ", \"ns-per-op\": %.1f, "
+                             "\"mb-per-sec\": %.2f, \"pool-bytes-per-op\": %s}",
+                             first ? "" : ",\n",
+                             name, bytes, ns_per_op,
+                             ns_per_op > 0
+                               ? bytes * 1000.0 / ns_per_op
+                               : 0.0,
+                             APR_POOL_DEBUG
+                               ? apr_psprintf(pool, "%" APR_SIZE_T_FMT,
+                                              allocated)
+                               : "null"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Run all benchmarks, or those named in argv[FIRST_ARG...], with
+ * ITERATIONS calls per run. */
+static svn_error_t *
+run_benchmarks(int argc,
+               const char *argv[],
+               int first_arg,
+               int iterations,
+               apr_pool_t *pool)
+{
+  bench_data_t *data;
+  svn_boolean_t first = TRUE;
+  int i, k;
+
+  for (k = first_arg; k < argc; k++)
+    {
+      for (i = 0; benchmarks[i].name; i++)
+        if (strcmp(argv[k], benchmarks[i].name) == 0)
+          break;
+
+      if (!benchmarks[i].name)
+        return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                 _("Unknown benchmark '%s'"), argv[k]);
+    }
+
+  SVN_ERR(create_data(&data, pool));
+
+  SVN_ERR(svn_cmdline_printf(pool,
+                             "{\n"
+                             "  \"format\": 1,\n"
+                             "  \"version\": \"%s\",\n"
+                             "  \"iterations\": %d,\n"
+                             "  \"runs\": %d,\n"
+                             "  \"benchmarks\": [\n",
+                             SVN_VER_NUMBER, iterations, RUNS));
+
+  for (i = 0; benchmarks[i].name; i++)
+    {
+      svn_boolean_t selected = (first_arg == argc);
+
+      for (k = first_arg; k < argc && !selected; k++)
+        selected = (strcmp(argv[k], benchmarks[i].name) == 0);
+
+      if (selected)
+        {
+          SVN_ERR(run_benchmark(benchmarks[i].name, benchmarks[i].func,
+                                data, iterations, first, pool));
+          first = FALSE;
+        }
+    }
+
+  SVN_ERR(svn_cmdline_printf(pool, "\n  ]\n}\n"));
+
+  return SVN_NO_ERROR;
+}
+
+int main(int argc, const char *argv[])
+{
+  apr_pool_t *pool;
+  svn_error_t *err = SVN_NO_ERROR;
+  int iterations = DEFAULT_ITERATIONS;
+  int first_arg = 1;
+
+  if (svn_cmdline_init("subr-bench", stderr) != EXIT_SUCCESS)
+    return EXIT_FAILURE;
+
+  pool = svn_pool_create(NULL);
+
+  if (argc > 2 && strcmp(argv[1], "-n") == 0)
+    {
+      err = svn_cstring_atoi(&iterations, argv[2]);
+      if (!err && iterations < 1)
+        err = svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                               _("The number of iterations must be "
+                                 "positive"));
+      first_arg = 3;
+    }
+  else if (argc > 1 && argv[1][0] == '-')
+    err = svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                           _("Usage: subr-bench [-n ITERATIONS] "
+                             "[BENCHMARK...]"));
+
+  if (!err)
+    err = run_benchmarks(argc, argv, first_arg, iterations, pool);
+
+  if (err)
+    return svn_cmdline_handle_exit_error(err, pool, "subr-bench: ");
+
+  svn_pool_destroy(pool);
+
+  return EXIT_SUCCESS;
+}